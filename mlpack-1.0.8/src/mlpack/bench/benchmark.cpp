@@ -0,0 +1,180 @@
+/**
+ * @file benchmark.cpp
+ *
+ * Implementation of the State and Benchmark classes of mlpack_bench.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <sstream>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <time.h>
+  #include <sys/time.h>
+  #include <unistd.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::bench;
+
+namespace {
+
+//! Return the time in seconds from an arbitrary (fixed) point, with the most
+//! precise monotonic clock available.
+double Now()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER frequency, count;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&count);
+  return (double) count.QuadPart / (double) frequency.QuadPart;
+#elif defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#else
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+#endif
+}
+
+}; // anonymous namespace
+
+State::State(const std::vector<size_t>& args, const size_t iterations) :
+    args(args),
+    iterations(iterations),
+    iteration(0),
+    itemsProcessed(0),
+    seconds(0.0),
+    started(-1.0)
+{
+  // Nothing to do.
+}
+
+void State::PauseTiming()
+{
+  if (started >= 0.0)
+  {
+    seconds += Now() - started;
+    started = -1.0;
+  }
+}
+
+void State::ResumeTiming()
+{
+  if (started < 0.0)
+    started = Now();
+}
+
+Benchmark::Benchmark(const std::string& name, Function function) :
+    name(name),
+    function(function)
+{
+  // Nothing to do.
+}
+
+Benchmark* Benchmark::Args(const std::vector<size_t>& args)
+{
+  argSets.push_back(args);
+  return this;
+}
+
+Benchmark* Benchmark::Args(const size_t a)
+{
+  return Args(std::vector<size_t>(1, a));
+}
+
+Benchmark* Benchmark::Args(const size_t a, const size_t b)
+{
+  std::vector<size_t> args(1, a);
+  args.push_back(b);
+  return Args(args);
+}
+
+Benchmark* Benchmark::Args(const size_t a, const size_t b, const size_t c)
+{
+  std::vector<size_t> args(1, a);
+  args.push_back(b);
+  args.push_back(c);
+  return Args(args);
+}
+
+Benchmark* Benchmark::Args(const size_t a, const size_t b, const size_t c,
+                           const size_t d)
+{
+  std::vector<size_t> args(1, a);
+  args.push_back(b);
+  args.push_back(c);
+  args.push_back(d);
+  return Args(args);
+}
+
+Benchmark* Benchmark::Args(const size_t a, const size_t b, const size_t c,
+                           const size_t d, const size_t e)
+{
+  std::vector<size_t> args(1, a);
+  args.push_back(b);
+  args.push_back(c);
+  args.push_back(d);
+  args.push_back(e);
+  return Args(args);
+}
+
+Benchmark* Benchmark::ArgNames(const std::string& names)
+{
+  argNames.clear();
+  std::istringstream stream(names);
+  std::string argName;
+  while (std::getline(stream, argName, ','))
+    argNames.push_back(argName);
+
+  return this;
+}
+
+std::string Benchmark::RunName(const size_t argSet) const
+{
+  std::ostringstream runName;
+  runName << name;
+  for (size_t i = 0; i < argSets[argSet].size(); ++i)
+  {
+    runName << "/";
+    if (i < argNames.size())
+      runName << argNames[i] << "=";
+    runName << argSets[argSet][i];
+  }
+
+  return runName.str();
+}
+
+std::vector<Benchmark*>& mlpack::bench::Benchmarks()
+{
+  // The list is created on first use, so that benchmarks can be registered
+  // during static initialization in any translation unit.
+  static std::vector<Benchmark*> benchmarks;
+  return benchmarks;
+}
+
+Benchmark* mlpack::bench::RegisterBenchmark(const std::string& name,
+                                            Function function)
+{
+  Benchmark* benchmark = new Benchmark(name, function);
+  Benchmarks().push_back(benchmark);
+  return benchmark;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file benchmark.hpp
+ *
+ * A small benchmark framework, in the style of Google Benchmark, for the
+ * mlpack_bench program.  Benchmarks are functions which take a State, and are
+ * registered with a list of argument sets (such as the number of points, the
+ * dimensionality and the leaf size) with the MLPACK_BENCHMARK() macro.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_BENCH_BENCHMARK_HPP
+#define __MLPACK_BENCH_BENCHMARK_HPP
+
+#include <mlpack/core.hpp>
+
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace bench /** Benchmarks of mlpack methods. */ {
+
+/**
+ * The state of one run of a benchmark: its arguments, and the timing of its
+ * iterations.  Only the body of the KeepRunning() loop is timed, so the setup
+ * (such as generating the dataset) goes before the loop; work inside the loop
+ * which should not be timed is wrapped in PauseTiming() and ResumeTiming().
+ *
+ * @code
+ * void KMeansCluster(State& state)
+ * {
+ *   arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+ *   arma::Col<size_t> assignments;
+ *   while (state.KeepRunning())
+ *     KMeans<>().Cluster(data, state.Arg(2), assignments);
+ * }
+ * @endcode
+ */
+class State
+{
+ public:
+  /**
+   * Create the state of a run with the given arguments and number of
+   * iterations.
+   *
+   * @param args Arguments of the run.
+   * @param iterations Number of iterations of the KeepRunning() loop.
+   */
+  State(const std::vector<size_t>& args, const size_t iterations);
+
+  /**
+   * Return whether another iteration should be run.  The timer is started by
+   * the first call, and stopped by the call which returns false.
+   */
+  bool KeepRunning()
+  {
+    if (iteration == 0)
+      ResumeTiming();
+
+    if (iteration < iterations)
+    {
+      ++iteration;
+      return true;
+    }
+
+    PauseTiming();
+    return false;
+  }
+
+  //! Stop the timer (for work inside the loop which should not be timed).
+  void PauseTiming();
+  //! Restart the timer.
+  void ResumeTiming();
+
+  //! Get the given argument of the run.
+  size_t Arg(const size_t i) const { return args[i]; }
+  //! Get the number of arguments of the run.
+  size_t NumArgs() const { return args.size(); }
+  //! Get the number of iterations of the run.
+  size_t Iterations() const { return iterations; }
+
+  //! Set the number of items (such as points) processed by all iterations, to
+  //! report the throughput.
+  void SetItemsProcessed(const size_t items) { itemsProcessed = items; }
+  //! Get the number of items processed by all iterations.
+  size_t ItemsProcessed() const { return itemsProcessed; }
+
+  //! Set a label, which is reported with the results.
+  void SetLabel(const std::string& label) { this->label = label; }
+  //! Get the label.
+  const std::string& Label() const { return label; }
+
+  //! Get the time (in seconds) measured so far.
+  double Seconds() const { return seconds; }
+
+ private:
+  //! The arguments of the run.
+  std::vector<size_t> args;
+  //! The number of iterations to run.
+  size_t iterations;
+  //! The number of iterations started so far.
+  size_t iteration;
+  //! The number of items processed by all iterations.
+  size_t itemsProcessed;
+  //! The label of the run.
+  std::string label;
+  //! The time measured so far.
+  double seconds;
+  //! The time when the timer was last started, or a negative value if it is
+  //! stopped.
+  double started;
+};
+
+//! A benchmark function.
+typedef void (*Function)(State&);
+
+/**
+ * A registered benchmark: its name, its function, and the argument sets it
+ * runs with.  The methods which add argument sets return the benchmark, so
+ * that they can be chained after MLPACK_BENCHMARK().
+ */
+class Benchmark
+{
+ public:
+  //! Create the benchmark with the given name and function.
+  Benchmark(const std::string& name, Function function);
+
+  //! Run the benchmark with the given arguments.
+  Benchmark* Args(const std::vector<size_t>& args);
+  //! Run the benchmark with the given argument.
+  Benchmark* Args(const size_t a);
+  //! Run the benchmark with the given arguments.
+  Benchmark* Args(const size_t a, const size_t b);
+  //! Run the benchmark with the given arguments.
+  Benchmark* Args(const size_t a, const size_t b, const size_t c);
+  //! Run the benchmark with the given arguments.
+  Benchmark* Args(const size_t a, const size_t b, const size_t c,
+                  const size_t d);
+  //! Run the benchmark with the given arguments.
+  Benchmark* Args(const size_t a, const size_t b, const size_t c,
+                  const size_t d, const size_t e);
+
+  /**
+   * Name the arguments; they are reported as "name=value" in the name of each
+   * run (for instance, "KNN<kd>/n=10000/d=3/leaf=20/k=5").
+   *
+   * @param names Comma-separated names of the arguments.
+   */
+  Benchmark* ArgNames(const std::string& names);
+
+  //! Get the name of the benchmark.
+  const std::string& Name() const { return name; }
+  //! Get the function of the benchmark.
+  Function Run() const { return function; }
+  //! Get the argument sets of the benchmark.
+  const std::vector<std::vector<size_t> >& ArgSets() const { return argSets; }
+
+  //! Get the name of the run with the given argument set.
+  std::string RunName(const size_t argSet) const;
+
+ private:
+  //! The name of the benchmark.
+  std::string name;
+  //! The benchmark function.
+  Function function;
+  //! The argument sets to run with.
+  std::vector<std::vector<size_t> > argSets;
+  //! The names of the arguments.
+  std::vector<std::string> argNames;
+};
+
+/**
+ * Register a benchmark; it is owned by the list of benchmarks.
+ *
+ * @param name Name of the benchmark.
+ * @param function Benchmark function.
+ */
+Benchmark* RegisterBenchmark(const std::string& name, Function function);
+
+//! Get the list of registered benchmarks, in the order of registration.
+std::vector<Benchmark*>& Benchmarks();
+
+/**
+ * Register a benchmark function with the given name.  Argument sets are added
+ * by chaining calls, as in
+ *
+ * @code
+ * MLPACK_BENCHMARK("TreeBuild<kd>", TreeBuild<KDTree>)
+ *     ->ArgNames("n,d,leaf")->Args(10000, 3, 20)->Args(100000, 3, 20);
+ * @endcode
+ */
+#define MLPACK_BENCHMARK_CONCAT(a, b) a ## b
+#define MLPACK_BENCHMARK_VARIABLE(line) \
+    MLPACK_BENCHMARK_CONCAT(mlpackBenchmark, line)
+#define MLPACK_BENCHMARK(name, function) \
+    static ::mlpack::bench::Benchmark* MLPACK_BENCHMARK_VARIABLE(__LINE__) = \
+        ::mlpack::bench::RegisterBenchmark(name, function)
+
+/**
+ * Keep the compiler from optimizing away the computation of the given value,
+ * when it is not used otherwise.
+ */
+template<typename T>
+void DoNotOptimize(const T& value)
+{
+  static const void* volatile sink;
+  sink = &value;
+}
+
+}; // namespace bench
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file gmm_bench.cpp
+ *
+ * Benchmark of the EM algorithm for Gaussian mixture models.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/synthetic/gaussian_mixture_generator.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::gmm;
+
+namespace {
+
+/**
+ * Fit a Gaussian mixture model, with at most ten iterations of EM (including
+ * the initial k-means clustering), to points drawn from a random mixture of as
+ * many Gaussians.  Arguments: the number of points, the dimensionality, and the
+ * number of Gaussians.
+ */
+void GMMEstimate(State& state)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  synthetic::GaussianMixtureGenerator(state.Arg(1), state.Arg(2)).Generate(
+      state.Arg(0), data, labels);
+  EMFit<> fitter(10);
+
+  while (state.KeepRunning())
+  {
+    GMM<> gmm(state.Arg(2), state.Arg(1), fitter);
+    DoNotOptimize(gmm.Estimate(data));
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+}
+
+MLPACK_BENCHMARK("GMM/EM", GMMEstimate)
+    ->ArgNames("n,d,gaussians")
+    ->Args(10000, 3, 5)->Args(100000, 3, 5)->Args(10000, 10, 5)
+    ->Args(10000, 3, 20);
+
+}; // anonymous namespace
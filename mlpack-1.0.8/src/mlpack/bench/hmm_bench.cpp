@@ -0,0 +1,78 @@
+/**
+ * @file hmm_bench.cpp
+ *
+ * Benchmark of Baum-Welch training of hidden Markov models.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/synthetic/hmm_sequence_generator.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::distribution;
+using namespace mlpack::hmm;
+
+namespace {
+
+/**
+ * Train an HMM with Gaussian emissions with the Baum-Welch algorithm, starting
+ * each time from the same random model, on sequences drawn from another random
+ * HMM with as many states.  Arguments: the number of sequences, the length of
+ * each sequence, the dimensionality, and the number of states.
+ */
+void HMMTrain(State& state)
+{
+  const size_t dimensionality = state.Arg(2);
+  const size_t states = state.Arg(3);
+
+  synthetic::HMMSequenceGenerator generator(states, dimensionality);
+  std::vector<arma::mat> sequences(state.Arg(0));
+  arma::Col<size_t> stateSequence;
+  for (size_t i = 0; i < sequences.size(); ++i)
+    generator.Generate(state.Arg(1), sequences[i], stateSequence);
+
+  // The emissions must differ, or Baum-Welch would stop at once.
+  arma::mat transition = arma::randu<arma::mat>(states, states);
+  for (size_t i = 0; i < states; ++i)
+    transition.col(i) /= accu(transition.col(i));
+
+  std::vector<GaussianDistribution> emissions;
+  for (size_t i = 0; i < states; ++i)
+    emissions.push_back(GaussianDistribution(
+        arma::randu<arma::vec>(dimensionality),
+        arma::eye<arma::mat>(dimensionality, dimensionality)));
+
+  while (state.KeepRunning())
+  {
+    HMM<GaussianDistribution> hmm(transition, emissions);
+    hmm.Train(sequences);
+    DoNotOptimize(hmm.Transition());
+  }
+
+  state.SetItemsProcessed(state.Iterations() * sequences.size() *
+      state.Arg(1));
+}
+
+MLPACK_BENCHMARK("HMM/BaumWelch", HMMTrain)
+    ->ArgNames("sequences,length,d,states")
+    ->Args(10, 1000, 3, 5)->Args(100, 1000, 3, 5)->Args(10, 1000, 10, 5)
+    ->Args(10, 1000, 3, 20);
+
+}; // anonymous namespace
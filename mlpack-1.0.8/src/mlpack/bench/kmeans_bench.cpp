@@ -0,0 +1,69 @@
+/**
+ * @file kmeans_bench.cpp
+ *
+ * Benchmark of the iterations of k-means clustering.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/kmeans/dual_tree_assignment.hpp>
+#include <mlpack/methods/synthetic/gaussian_mixture_generator.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::kmeans;
+
+namespace {
+
+/**
+ * Run ten iterations of k-means (fewer if it converges before) on points drawn
+ * from a mixture of as many Gaussians as clusters.  Arguments: the number of
+ * points, the dimensionality, and the number of clusters.
+ */
+template<typename AssignmentPolicy>
+void KMeansCluster(State& state)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  synthetic::GaussianMixtureGenerator(state.Arg(1), state.Arg(2)).Generate(
+      state.Arg(0), data, labels);
+  const KMeans<metric::SquaredEuclideanDistance, RandomPartition,
+      MaxVarianceNewCluster, AssignmentPolicy> kmeans(10);
+
+  arma::Col<size_t> assignments;
+  while (state.KeepRunning())
+  {
+    kmeans.Cluster(data, state.Arg(2), assignments);
+    DoNotOptimize(assignments);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+}
+
+MLPACK_BENCHMARK("KMeans", KMeansCluster<NaiveAssignment>)
+    ->ArgNames("n,d,k")
+    ->Args(10000, 3, 10)->Args(100000, 3, 10)->Args(10000, 30, 10)
+    ->Args(10000, 3, 100)->Args(100000, 3, 1000);
+
+MLPACK_BENCHMARK("KMeans<dual_tree>", KMeansCluster<DualTreeAssignment>)
+    ->ArgNames("n,d,k")
+    ->Args(10000, 3, 10)->Args(10000, 3, 100)->Args(100000, 3, 1000)
+    ->Args(10000, 10, 100);
+
+}; // anonymous namespace
@@ -0,0 +1,60 @@
+/**
+ * @file lars_bench.cpp
+ *
+ * Benchmark of LARS and the LASSO.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lars/lars.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::regression;
+
+namespace {
+
+/**
+ * Solve the LASSO with LARS (using the Cholesky factorization) on a random
+ * linear model with noise.  Arguments: the number of points, the
+ * dimensionality, and the l1 penalty (in thousandths).
+ */
+void LARSRegress(State& state)
+{
+  const arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  const arma::vec responses = trans(data) * arma::randn<arma::vec>(
+      state.Arg(1)) + 0.1 * arma::randn<arma::vec>(state.Arg(0));
+  const double lambda1 = state.Arg(2) / 1000.0;
+
+  arma::vec beta;
+  while (state.KeepRunning())
+  {
+    LARS lars(true, lambda1);
+    lars.Regress(data, responses, beta);
+    DoNotOptimize(beta);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+}
+
+MLPACK_BENCHMARK("LARS", LARSRegress)
+    ->ArgNames("n,d,lambda1_x1000")
+    ->Args(10000, 10, 0)->Args(10000, 100, 0)->Args(10000, 100, 100)
+    ->Args(100000, 10, 0);
+
+}; // anonymous namespace
@@ -0,0 +1,78 @@
+/**
+ * @file load_bench.cpp
+ *
+ * Benchmarks of loading datasets in text and binary formats.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+
+#include <cstdio>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+
+namespace {
+
+//! The formats which are benchmarked.
+enum Format
+{
+  CSV,
+  ArmaBinary
+};
+
+/**
+ * Load a uniform random dataset from a file of the given format, which is
+ * written (in the current directory) before the timed loop and removed after.
+ * Arguments: the number of points, the dimensionality, and the number of
+ * threads used to parse text files.
+ */
+template<Format FormatType>
+void LoadDataset(State& state)
+{
+  const std::string filename = (FormatType == CSV) ? "mlpack_bench_load.csv" :
+      "mlpack_bench_load.bin";
+
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  if (!data::Save(filename, dataset))
+  {
+    Log::Warn << "Could not write '" << filename << "'." << std::endl;
+    return;
+  }
+
+  arma::mat loaded;
+  while (state.KeepRunning())
+  {
+    data::Load(filename, loaded, true, true, state.Arg(2));
+    DoNotOptimize(loaded);
+  }
+
+  std::remove(filename.c_str());
+  state.SetItemsProcessed(state.Iterations() * dataset.n_cols);
+}
+
+MLPACK_BENCHMARK("Load<csv>", LoadDataset<CSV>)
+    ->ArgNames("n,d,threads")
+    ->Args(100000, 10, 1)->Args(100000, 10, 0)->Args(1000000, 3, 1)
+    ->Args(1000000, 3, 0);
+
+MLPACK_BENCHMARK("Load<bin>", LoadDataset<ArmaBinary>)
+    ->ArgNames("n,d,threads")
+    ->Args(100000, 10, 1)->Args(1000000, 3, 1);
+
+}; // anonymous namespace
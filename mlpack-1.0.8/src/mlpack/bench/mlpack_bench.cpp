@@ -0,0 +1,309 @@
+/**
+ * @file mlpack_bench.cpp
+ *
+ * The mlpack_bench program, which runs the registered benchmarks and reports
+ * their timings as a table and, optionally, as JSON.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/version.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace std;
+
+PROGRAM_INFO("mlpack Benchmarks", "This program runs the benchmarks of mlpack "
+    "methods: the construction of kd-trees, ball trees, random projection trees"
+    " and cover trees; single-tree and dual-tree k-nearest-neighbor search and "
+    "range search; k-means iterations; EM for Gaussian mixture models; "
+    "Baum-Welch training of HMMs; LARS; PCA; and loading datasets.  Each benchmark "
+    "is run with several sets of arguments, such as the number of points (n), "
+    "the dimensionality (d) and the leaf size (leaf), which are part of the "
+    "name of the run (for instance, \"KNN<kd>/n=10000/d=3/leaf=20/k=5/"
+    "single=0\")."
+    "\n\n"
+    "Each run is first done once, to warm up and to choose the number of "
+    "iterations which takes at least --min_time seconds; then it is repeated "
+    "--repetitions times, and the mean, median, minimum and standard deviation "
+    "of the time of one iteration are reported.  The random seed is reset to "
+    "--seed before every run, so the datasets are the same from one invocation "
+    "to the next.  The --filter (-f) option runs only the runs whose names "
+    "contain the given string, and --list (-L) lists the runs without running "
+    "them."
+    "\n\n"
+    "The results are printed as a table, and are also saved as JSON to the file"
+    " given with --output_file (-o), for comparison between builds.  The JSON "
+    "output records whether Armadillo was built with an external BLAS and "
+    "LAPACK (such as the Accelerate framework on Mac OS X and iOS), which "
+    "matters most for the PCA, GMM and LARS runs.");
+
+PARAM_STRING("filter", "Run only the runs whose names contain this string.",
+    "f", "");
+PARAM_FLAG("list", "List the runs, without running them.", "L");
+PARAM_DOUBLE("min_time", "Smallest time (in seconds) of each repetition.", "t",
+    0.5);
+PARAM_INT("repetitions", "Number of repetitions of each run.", "R", 3);
+PARAM_INT("seed", "Random seed, reset before each run.", "s", 42);
+PARAM_STRING("output_file", "File to save the results to, as JSON.", "o", "");
+
+//! The results of one run.
+struct Result
+{
+  //! The name of the run.
+  string name;
+  //! The number of iterations of each repetition.
+  size_t iterations;
+  //! The mean time of one iteration, in seconds.
+  double mean;
+  //! The median time of one iteration, in seconds.
+  double median;
+  //! The shortest time of one iteration, in seconds.
+  double min;
+  //! The standard deviation of the time of one iteration, in seconds.
+  double stddev;
+  //! The number of items processed per second (0 if not reported).
+  double itemsPerSecond;
+  //! The label reported by the run.
+  string label;
+};
+
+/**
+ * Run the given benchmark with the given arguments, and return the results.
+ */
+Result Run(const Benchmark& benchmark,
+           const size_t argSet,
+           const double minTime,
+           const size_t repetitions,
+           const size_t seed)
+{
+  const vector<size_t> args = (argSet < benchmark.ArgSets().size()) ?
+      benchmark.ArgSets()[argSet] : vector<size_t>();
+
+  Result result;
+  result.name = (argSet < benchmark.ArgSets().size()) ?
+      benchmark.RunName(argSet) : benchmark.Name();
+
+  // The first run, with one iteration, is a warm-up, and estimates the number
+  // of iterations needed.
+  math::RandomSeed(seed);
+  State probe(args, 1);
+  benchmark.Run()(probe);
+  result.iterations = (probe.Seconds() > 0.0) ?
+      (size_t) max(1.0, ceil(minTime / probe.Seconds())) : 1;
+
+  vector<double> times;
+  double itemsPerSecond = 0.0;
+  for (size_t r = 0; r < repetitions; ++r)
+  {
+    math::RandomSeed(seed);
+    State state(args, result.iterations);
+    benchmark.Run()(state);
+
+    times.push_back(state.Seconds() / result.iterations);
+    if (state.Seconds() > 0.0)
+      itemsPerSecond += state.ItemsProcessed() / state.Seconds();
+    result.label = state.Label();
+  }
+
+  sort(times.begin(), times.end());
+  const arma::vec timesVec = arma::conv_to<arma::vec>::from(times);
+  result.mean = arma::mean(timesVec);
+  result.median = arma::median(timesVec);
+  result.min = times[0];
+  result.stddev = (times.size() > 1) ? arma::stddev(timesVec) : 0.0;
+  result.itemsPerSecond = itemsPerSecond / repetitions;
+
+  return result;
+}
+
+//! Return whether Armadillo calls an external BLAS for matrix products.
+bool UsesBLAS()
+{
+#ifdef ARMA_USE_BLAS
+  return true;
+#else
+  return false;
+#endif
+}
+
+//! Return whether Armadillo calls an external LAPACK for decompositions.
+bool UsesLAPACK()
+{
+#ifdef ARMA_USE_LAPACK
+  return true;
+#else
+  return false;
+#endif
+}
+
+//! Write the given string to a JSON stream, quoted and escaped.
+void WriteJSONString(ostream& stream, const string& str)
+{
+  stream << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"' || str[i] == '\\')
+      stream << '\\' << str[i];
+    else if (str[i] == '\n')
+      stream << "\\n";
+    else
+      stream << str[i];
+  }
+  stream << '"';
+}
+
+//! Write the results as JSON, in the layout of Google Benchmark.
+void WriteJSON(ostream& stream,
+               const vector<Result>& results,
+               const double minTime,
+               const size_t repetitions,
+               const size_t seed)
+{
+  char date[64];
+  const time_t now = time(NULL);
+  strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+  const size_t threads = Threads::Available();
+
+  stream << setprecision(10);
+  stream << "{" << endl;
+  stream << "  \"context\": {" << endl;
+  stream << "    \"date\": ";
+  WriteJSONString(stream, date);
+  stream << "," << endl << "    \"version\": ";
+  WriteJSONString(stream, util::GetVersion());
+  stream << "," << endl;
+  stream << "    \"seed\": " << seed << "," << endl;
+  stream << "    \"min_time\": " << minTime << "," << endl;
+  stream << "    \"repetitions\": " << repetitions << "," << endl;
+  stream << "    \"threads\": " << threads << "," << endl;
+  stream << "    \"blas\": " << (UsesBLAS() ? "true" : "false") << "," << endl;
+  stream << "    \"lapack\": " << (UsesLAPACK() ? "true" : "false") << endl;
+  stream << "  }," << endl;
+  stream << "  \"benchmarks\": [";
+
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    stream << ((i == 0) ? "" : ",") << endl << "    {" << endl;
+    stream << "      \"name\": ";
+    WriteJSONString(stream, results[i].name);
+    stream << "," << endl;
+    stream << "      \"iterations\": " << results[i].iterations << "," << endl;
+    stream << "      \"real_time_mean\": " << results[i].mean << "," << endl;
+    stream << "      \"real_time_median\": " << results[i].median << ","
+        << endl;
+    stream << "      \"real_time_min\": " << results[i].min << "," << endl;
+    stream << "      \"real_time_stddev\": " << results[i].stddev << ","
+        << endl;
+    stream << "      \"time_unit\": \"s\"," << endl;
+    stream << "      \"items_per_second\": " << results[i].itemsPerSecond
+        << "," << endl;
+    stream << "      \"label\": ";
+    WriteJSONString(stream, results[i].label);
+    stream << endl << "    }";
+  }
+
+  stream << endl << "  ]" << endl << "}" << endl;
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string filter = CLI::GetParam<string>("filter");
+  const double minTime = CLI::GetParam<double>("min_time");
+  const int repetitions = CLI::GetParam<int>("repetitions");
+  const int seed = CLI::GetParam<int>("seed");
+  const string outputFile = CLI::GetParam<string>("output_file");
+
+  if (minTime < 0.0)
+    Log::Fatal << "--min_time (-t) must be non-negative." << endl;
+  if (repetitions <= 0)
+    Log::Fatal << "--repetitions (-R) must be positive." << endl;
+  if (seed < 0)
+    Log::Fatal << "--seed (-s) must be non-negative." << endl;
+
+  // Collect the runs to do: a benchmark without arguments is run once.
+  vector<pair<Benchmark*, size_t> > runs;
+  const vector<Benchmark*>& benchmarks = Benchmarks();
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+  {
+    const size_t argSets = max((size_t) 1, benchmarks[i]->ArgSets().size());
+    for (size_t j = 0; j < argSets; ++j)
+    {
+      const string name = benchmarks[i]->ArgSets().empty() ?
+          benchmarks[i]->Name() : benchmarks[i]->RunName(j);
+      if (name.find(filter) != string::npos)
+        runs.push_back(make_pair(benchmarks[i], j));
+    }
+  }
+
+  if (CLI::HasParam("list"))
+  {
+    for (size_t i = 0; i < runs.size(); ++i)
+      cout << (runs[i].first->ArgSets().empty() ? runs[i].first->Name() :
+          runs[i].first->RunName(runs[i].second)) << endl;
+    return 0;
+  }
+
+  Log::Info << "Armadillo uses " << (UsesBLAS() ? "an external" : "no")
+      << " BLAS and " << (UsesLAPACK() ? "an external" : "no") << " LAPACK."
+      << endl;
+
+  if (runs.empty())
+    Log::Warn << "No runs match the filter '" << filter << "'." << endl;
+
+  cout << left << setw(50) << "Run" << right << setw(12) << "Iterations"
+      << setw(14) << "Median (s)" << setw(14) << "Min (s)" << setw(14)
+      << "Stddev (s)" << setw(14) << "Items/s" << endl;
+
+  vector<Result> results;
+  for (size_t i = 0; i < runs.size(); ++i)
+  {
+    results.push_back(Run(*runs[i].first, runs[i].second, minTime,
+        (size_t) repetitions, (size_t) seed));
+
+    const Result& r = results.back();
+    cout << left << setw(50) << r.name << right << setw(12) << r.iterations
+        << setprecision(4) << setw(14) << r.median << setw(14) << r.min
+        << setw(14) << r.stddev << setw(14) << r.itemsPerSecond;
+    if (r.label != "")
+      cout << " " << r.label;
+    cout << endl;
+  }
+
+  if (outputFile != "")
+  {
+    ofstream stream(outputFile.c_str());
+    if (!stream.is_open())
+      Log::Fatal << "Could not open '" << outputFile << "' for writing."
+          << endl;
+
+    WriteJSON(stream, results, minTime, (size_t) repetitions, (size_t) seed);
+  }
+
+  return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file neighbor_search_bench.cpp
+ *
+ * Benchmarks of single-tree and dual-tree k-nearest-neighbor search with
+ * kd-trees, ball trees and cover trees, of kNN graph construction, and of
+ * answering batches of queries with a QueryServer.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/query_server.hpp>
+#include <mlpack/methods/synthetic/clustered_embedding_generator.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::neighbor;
+using namespace mlpack::tree;
+
+namespace {
+
+typedef NeighborSearchStat<NearestNeighborSort> StatType;
+//! Cover trees need the base case cache of the statistic.
+typedef NeighborSearchStat<NearestNeighborSort, true> CoverStatType;
+
+typedef BinarySpaceTree<bound::HRectBound<2>, StatType> KDTree;
+typedef BinarySpaceTree<bound::BallBound<>, StatType> BallTree;
+typedef CoverTree<metric::EuclideanDistance, FirstPointIsRoot, CoverStatType>
+    EuclideanCoverTree;
+
+//! Build a tree on the given dataset with the given leaf size.
+template<typename TreeType>
+TreeType* BuildTree(arma::mat& data, const size_t leafSize)
+{
+  return new TreeType(data, leafSize);
+}
+
+//! Cover trees have no leaf size, so this ignores it.
+template<>
+EuclideanCoverTree* BuildTree(arma::mat& data, const size_t /* leafSize */)
+{
+  return new EuclideanCoverTree(data);
+}
+
+/**
+ * Find the k nearest neighbors of every point of the given dataset, with the
+ * dataset as both query and reference set.  Arguments: the number of points,
+ * the dimensionality, the leaf size, k, and whether single-tree search is
+ * used.  The tree is built before the timed loop.
+ */
+template<typename TreeType>
+void Search(State& state, arma::mat& data)
+{
+  TreeType* tree = BuildTree<TreeType>(data, state.Arg(2));
+
+  NeighborSearch<NearestNeighborSort, metric::EuclideanDistance, TreeType>
+      knn(tree, data, state.Arg(4) != 0);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  while (state.KeepRunning())
+  {
+    knn.Search(state.Arg(3), neighbors, distances);
+    DoNotOptimize(distances);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+  delete tree;
+}
+
+//! Search uniform random data.
+template<typename TreeType>
+void KNN(State& state)
+{
+  arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  Search<TreeType>(state, data);
+}
+
+/**
+ * Search normalized points near 10 clusters of the intrinsic dimensionality
+ * given as the last argument, like learned embeddings (see
+ * ClusteredEmbeddingGenerator).
+ */
+template<typename TreeType>
+void KNNEmbedding(State& state)
+{
+  synthetic::ClusteredEmbeddingGenerator generator(state.Arg(1), 10,
+      state.Arg(5));
+  arma::mat data;
+  arma::Col<size_t> labels;
+  generator.Generate(state.Arg(0), data, labels);
+  Search<TreeType>(state, data);
+}
+
+/**
+ * Build the symmetric kNN graph of uniform random data with
+ * NeighborSearch::Graph(), which compares each pair of leaves once.
+ * Arguments: the number of points, the dimensionality, the leaf size, and k.
+ */
+template<typename TreeType>
+void KNNGraphBuild(State& state)
+{
+  arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  TreeType* tree = BuildTree<TreeType>(data, state.Arg(2));
+
+  NeighborSearch<NearestNeighborSort, metric::EuclideanDistance, TreeType>
+      knn(tree, data);
+
+  arma::sp_mat graph;
+  while (state.KeepRunning())
+  {
+    knn.Graph(state.Arg(3), graph);
+    DoNotOptimize(graph);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+  delete tree;
+}
+
+/**
+ * Answer batches of queries against a reference tree built once, as the
+ * knn_server program does.  Arguments: the number of reference points, the
+ * dimensionality, the number of query points in each batch, and k.
+ */
+void KNNServerBatch(State& state)
+{
+  arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  QueryServer<KDTree> server(data);
+
+  const arma::mat queries = arma::randu<arma::mat>(state.Arg(1), state.Arg(2));
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  while (state.KeepRunning())
+  {
+    server.Search(queries, state.Arg(3), neighbors, distances);
+    DoNotOptimize(distances);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * queries.n_cols);
+}
+
+//! The arguments of the embedding benchmarks: 100000 points of dimensionality
+//! 64 with intrinsic dimensionality 5, and 10000 points of dimensionality 256
+//! with intrinsic dimensionality 10.
+const size_t embeddingArgs[] = { 100000, 64, 20, 10, 0, 5,
+                                 10000, 256, 20, 10, 0, 10 };
+
+MLPACK_BENCHMARK("KNN<kd>", KNN<KDTree>)
+    ->ArgNames("n,d,leaf,k,single")
+    ->Args(10000, 3, 20, 5, 0)->Args(10000, 3, 20, 5, 1)
+    ->Args(100000, 3, 20, 5, 0)->Args(100000, 3, 20, 5, 1)
+    ->Args(100000, 3, 5, 5, 0)->Args(100000, 3, 100, 5, 0)
+    ->Args(10000, 10, 20, 5, 0)->Args(10000, 3, 20, 50, 0);
+
+MLPACK_BENCHMARK("KNN<ball>", KNN<BallTree>)
+    ->ArgNames("n,d,leaf,k,single")
+    ->Args(10000, 3, 20, 5, 0)->Args(10000, 3, 20, 5, 1)
+    ->Args(100000, 3, 20, 5, 0)->Args(10000, 10, 20, 5, 0);
+
+MLPACK_BENCHMARK("KNN<cover>", KNN<EuclideanCoverTree>)
+    ->ArgNames("n,d,leaf,k,single")
+    ->Args(10000, 3, 0, 5, 0)->Args(10000, 3, 0, 5, 1)
+    ->Args(100000, 3, 0, 5, 0)->Args(10000, 10, 0, 5, 0);
+
+MLPACK_BENCHMARK("KNNGraph<kd>", KNNGraphBuild<KDTree>)
+    ->ArgNames("n,d,leaf,k")
+    ->Args(10000, 3, 20, 10)->Args(100000, 3, 20, 10)
+    ->Args(10000, 32, 20, 10);
+
+MLPACK_BENCHMARK("KNNServer<kd>", KNNServerBatch)
+    ->ArgNames("n,d,batch,k")
+    ->Args(100000, 3, 1, 10)->Args(100000, 3, 100, 10)
+    ->Args(100000, 3, 10000, 10);
+
+MLPACK_BENCHMARK("KNN<kd,embedding>", KNNEmbedding<KDTree>)
+    ->ArgNames("n,d,leaf,k,single,intrinsic")
+    ->Args(std::vector<size_t>(embeddingArgs, embeddingArgs + 6))
+    ->Args(std::vector<size_t>(embeddingArgs + 6, embeddingArgs + 12));
+
+MLPACK_BENCHMARK("KNN<ball,embedding>", KNNEmbedding<BallTree>)
+    ->ArgNames("n,d,leaf,k,single,intrinsic")
+    ->Args(std::vector<size_t>(embeddingArgs, embeddingArgs + 6))
+    ->Args(std::vector<size_t>(embeddingArgs + 6, embeddingArgs + 12));
+
+MLPACK_BENCHMARK("KNN<cover,embedding>", KNNEmbedding<EuclideanCoverTree>)
+    ->ArgNames("n,d,leaf,k,single,intrinsic")
+    ->Args(std::vector<size_t>(embeddingArgs, embeddingArgs + 6))
+    ->Args(std::vector<size_t>(embeddingArgs + 6, embeddingArgs + 12));
+
+}; // anonymous namespace
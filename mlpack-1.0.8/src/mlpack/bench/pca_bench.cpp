@@ -0,0 +1,67 @@
+/**
+ * @file pca_bench.cpp
+ *
+ * Benchmarks of principal components analysis, with exact and randomized
+ * decompositions.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/pca/pca.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::pca;
+
+namespace {
+
+/**
+ * Reduce random data with a low-rank structure to a smaller dimensionality
+ * with PCA.  Arguments: the number of points, the dimensionality, the new
+ * dimensionality, and the decomposition method (see PCA::DecompositionMethod).
+ * The exact method is dominated by the LAPACK singular value decomposition,
+ * and the randomized one by matrix products, so these runs show the effect of
+ * the BLAS and LAPACK that Armadillo is built with.
+ */
+void PCAReduce(State& state)
+{
+  const arma::mat dataset = arma::randn<arma::mat>(state.Arg(1), 20) *
+      arma::randn<arma::mat>(20, state.Arg(0)) +
+      0.1 * arma::randn<arma::mat>(state.Arg(1), state.Arg(0));
+  const PCA pca(false, (PCA::DecompositionMethod) state.Arg(3));
+
+  arma::mat data;
+  while (state.KeepRunning())
+  {
+    state.PauseTiming();
+    data = dataset;
+    state.ResumeTiming();
+
+    DoNotOptimize(pca.Apply(data, state.Arg(2)));
+  }
+
+  state.SetItemsProcessed(state.Iterations() * dataset.n_cols);
+}
+
+MLPACK_BENCHMARK("PCA", PCAReduce)
+    ->ArgNames("n,d,new_d,method")
+    ->Args(10000, 50, 10, PCA::EXACT)->Args(10000, 50, 10, PCA::RANDOMIZED)
+    ->Args(10000, 500, 10, PCA::EXACT)->Args(10000, 500, 10, PCA::RANDOMIZED)
+    ->Args(100000, 50, 10, PCA::EXACT);
+
+}; // anonymous namespace
@@ -0,0 +1,77 @@
+/**
+ * @file range_search_bench.cpp
+ *
+ * Benchmarks of single-tree and dual-tree range search with kd-trees and ball
+ * trees.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::range;
+using namespace mlpack::tree;
+
+namespace {
+
+typedef BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat> KDTree;
+typedef BinarySpaceTree<bound::BallBound<>, RangeSearchStat> BallTree;
+
+/**
+ * Find the points within a distance of every point of a uniform random
+ * dataset in the unit cube, with the dataset as both query and reference set.
+ * Arguments: the number of points, the dimensionality, the leaf size, the
+ * largest distance (in thousandths), and whether single-tree search is used.
+ * The tree is built before the timed loop.
+ */
+template<typename TreeType>
+void RangeSearchBench(State& state)
+{
+  arma::mat data = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  TreeType tree(data, state.Arg(2));
+
+  RangeSearch<metric::EuclideanDistance, TreeType> rangeSearch(&tree, data,
+      state.Arg(4) != 0);
+  const math::Range range(0.0, state.Arg(3) / 1000.0);
+
+  arma::Col<size_t> offsets;
+  arma::Col<size_t> neighbors;
+  arma::vec distances;
+  while (state.KeepRunning())
+  {
+    rangeSearch.Search(range, offsets, neighbors, distances);
+    DoNotOptimize(distances);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * data.n_cols);
+}
+
+MLPACK_BENCHMARK("RangeSearch<kd>", RangeSearchBench<KDTree>)
+    ->ArgNames("n,d,leaf,range_x1000,single")
+    ->Args(10000, 3, 20, 50, 0)->Args(10000, 3, 20, 50, 1)
+    ->Args(100000, 3, 20, 20, 0)->Args(100000, 3, 20, 20, 1)
+    ->Args(10000, 10, 20, 200, 0);
+
+MLPACK_BENCHMARK("RangeSearch<ball>", RangeSearchBench<BallTree>)
+    ->ArgNames("n,d,leaf,range_x1000,single")
+    ->Args(10000, 3, 20, 50, 0)->Args(10000, 3, 20, 50, 1)
+    ->Args(100000, 3, 20, 20, 0)->Args(10000, 10, 20, 200, 0);
+
+}; // anonymous namespace
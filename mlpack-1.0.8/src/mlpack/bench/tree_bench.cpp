@@ -0,0 +1,100 @@
+/**
+ * @file tree_bench.cpp
+ *
+ * Benchmarks of the construction of kd-trees, ball trees, random projection
+ * trees and cover trees.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::tree;
+
+namespace {
+
+typedef BinarySpaceTree<bound::HRectBound<2>, EmptyStatistic> KDTree;
+typedef BinarySpaceTree<bound::BallBound<>, EmptyStatistic> BallTree;
+typedef BinarySpaceTree<bound::BallBound<>, EmptyStatistic, arma::mat, RPSplit>
+    RPTree;
+typedef CoverTree<metric::EuclideanDistance, FirstPointIsRoot, EmptyStatistic>
+    EuclideanCoverTree;
+
+/**
+ * Build a BinarySpaceTree on uniform random data.  Arguments: the number of
+ * points, the dimensionality, and the leaf size.  The construction reorders
+ * the dataset, so a fresh copy (which is not timed) is used for each tree.
+ */
+template<typename TreeType>
+void TreeBuild(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  arma::mat data;
+  std::vector<size_t> oldFromNew;
+
+  while (state.KeepRunning())
+  {
+    state.PauseTiming();
+    data = dataset;
+    state.ResumeTiming();
+
+    TreeType tree(data, oldFromNew, state.Arg(2));
+    DoNotOptimize(tree);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * dataset.n_cols);
+}
+
+/**
+ * Build a cover tree on uniform random data.  Arguments: the number of points
+ * and the dimensionality.
+ */
+void CoverTreeBuild(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+
+  while (state.KeepRunning())
+  {
+    EuclideanCoverTree tree(dataset);
+    DoNotOptimize(tree);
+  }
+
+  state.SetItemsProcessed(state.Iterations() * dataset.n_cols);
+}
+
+MLPACK_BENCHMARK("TreeBuild<kd>", TreeBuild<KDTree>)
+    ->ArgNames("n,d,leaf")
+    ->Args(10000, 3, 20)->Args(100000, 3, 20)->Args(100000, 3, 1)
+    ->Args(100000, 3, 100)->Args(10000, 30, 20);
+
+MLPACK_BENCHMARK("TreeBuild<ball>", TreeBuild<BallTree>)
+    ->ArgNames("n,d,leaf")
+    ->Args(10000, 3, 20)->Args(100000, 3, 20)->Args(10000, 30, 20);
+
+MLPACK_BENCHMARK("TreeBuild<rp>", TreeBuild<RPTree>)
+    ->ArgNames("n,d,leaf")
+    ->Args(10000, 3, 20)->Args(100000, 3, 20)->Args(10000, 30, 20);
+
+MLPACK_BENCHMARK("TreeBuild<cover>", CoverTreeBuild)
+    ->ArgNames("n,d")
+    ->Args(10000, 3)->Args(100000, 3)->Args(10000, 30);
+
+}; // anonymous namespace
@@ -187,13 +187,22 @@
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/data/load.hpp>
 #include <mlpack/core/data/save.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
+#include <mlpack/core/data/chunk_writer.hpp>
 #include <mlpack/core/data/normalize_labels.hpp>
+#include <mlpack/core/data/space_filling_curve.hpp>
+#include <mlpack/core/math/accumulator.hpp>
 #include <mlpack/core/math/clamp.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/lin_alg.hpp>
+#include <mlpack/core/math/log_add.hpp>
 #include <mlpack/core/math/range.hpp>
 #include <mlpack/core/math/round.hpp>
+#include <mlpack/core/math/simd_kernels.hpp>
 #include <mlpack/core/util/save_restore_utility.hpp>
+#include <mlpack/core/util/progress_monitor.hpp>
+#include <mlpack/core/util/communicator.hpp>
 #include <mlpack/core/dists/discrete_distribution.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
 
@@ -18,6 +18,12 @@
 
 #include <armadillo.hpp>
 
+// The blocked ccov() uses one partial sum per thread.
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+#include <vector>
+
 namespace arma {
   // u64/s64
   #include "typedef.hpp"
@@ -35,6 +35,26 @@ ccov(const Base<typename T1::elem_type,T1>& X, const uword norm_type = 0)
 
 
 
+//! Like ccov(), but each column of X is read only once: the blocks of columns
+//! are centered on their own means and their statistics are merged.  This is
+//! useful when X is expensive to read (for instance, memory-mapped).
+template<typename eT>
+inline
+Mat<eT>
+ccov_onepass(const Mat<eT>& X, const uword norm_type = 0)
+  {
+  arma_extra_debug_sigprint();
+  
+  arma_debug_check( (norm_type > 1), "ccov_onepass(): norm_type must be 0 or 1");
+  
+  Mat<eT> out;
+  op_ccov::direct_ccov_onepass(out, X, norm_type);
+  
+  return out;
+  }
+
+
+
 template<typename T1, typename T2>
 inline
 const Glue<T1,T2,glue_ccov>
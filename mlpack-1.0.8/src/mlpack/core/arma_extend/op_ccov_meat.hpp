@@ -41,15 +41,206 @@ op_ccov::direct_ccov(Mat<eT>& out, const Mat<eT>& A, const uword norm_type)
     }
   else
     {
+    typedef typename ccov_accumulator<eT>::result acc_eT;
+
     const uword N = A.n_cols;
-    const eT norm_val = (norm_type == 0) ? ( (N > 1) ? eT(N-1) : eT(1) ) : eT(N);
+    const acc_eT norm_val = (norm_type == 0) ? ( (N > 1) ? acc_eT(N-1) : acc_eT(1) ) : acc_eT(N);
+    const uword n_blocks = (N + block_size - 1) / block_size;
 
-    const Col<eT> acc = sum(A, 1);
+    // First pass: the sums of the blocks are added up in the accumulator type.
+    Col<acc_eT> acc(A.n_rows);
+    acc.zeros();
+    for(uword first = 0; first < N; first += block_size)
+      {
+      const uword last = (std::min)(first + block_size, N) - 1;
 
-    out = A * trans(A);
-    out -= (acc * trans(acc)) / eT(N);
-    out /= norm_val;
+      acc += conv_to< Col<acc_eT> >::from( sum(A.cols(first, last), 1) );
+      }
+
+    const Col<eT> mean = conv_to< Col<eT> >::from( acc / acc_eT(N) );
+
+    // Second pass: center one block of columns at a time and add its outer
+    // product, so that no centered copy of A is made and the result does not
+    // suffer the cancellation of A * A' - N * mean * mean'.  Each thread sums
+    // its own blocks; the partial sums are added in thread order.
+
+    #ifdef _OPENMP
+      const uword n_threads = (n_blocks > 1) ? uword(omp_get_max_threads()) : uword(1);
+    #else
+      const uword n_threads = 1;
+    #endif
+
+    std::vector< Mat<acc_eT> > partial(n_threads);
+
+    #pragma omp parallel num_threads(n_threads) if(n_threads > 1)
+      {
+      #ifdef _OPENMP
+        Mat<acc_eT>& local = partial[omp_get_thread_num()];
+      #else
+        Mat<acc_eT>& local = partial[0];
+      #endif
+
+      local.zeros(A.n_rows, A.n_rows);
+      Mat<eT> block;
+
+      #pragma omp for schedule(static)
+      for(int b = 0; b < int(n_blocks); ++b)
+        {
+        const uword first = uword(b) * block_size;
+        const uword last  = (std::min)(first + block_size, N) - 1;
+
+        block = A.cols(first, last);
+        for(uword i = 0; i < block.n_cols; ++i)
+          {
+          block.col(i) -= mean;
+          }
+
+        op_ccov::syrk_accumulate(local, block);
+        }
+      }
+
+    // (A thread which was not started has no partial sum.)
+    Mat<acc_eT> scatter = partial[0];
+    for(uword t = 1; t < n_threads; ++t)
+      {
+      if(partial[t].n_elem > 0)
+        {
+        scatter += partial[t];
+        }
+      }
+
+    out = conv_to< Mat<eT> >::from( scatter / norm_val );
+    }
+  }
+
+
+
+template<typename eT>
+inline
+void
+op_ccov::direct_ccov_onepass(Mat<eT>& out, const Mat<eT>& A, const uword norm_type)
+  {
+  arma_extra_debug_sigprint();
+
+  typedef typename ccov_accumulator<eT>::result acc_eT;
+
+  const uword N = A.n_cols;
+  const uword n_blocks = (N + block_size - 1) / block_size;
+
+  #ifdef _OPENMP
+    const uword n_threads = (n_blocks > 1) ? uword(omp_get_max_threads()) : uword(1);
+  #else
+    const uword n_threads = 1;
+  #endif
+
+  // The count, mean and scatter matrix of the columns each thread has seen.
+  std::vector<uword>         counts(n_threads, 0);
+  std::vector< Col<acc_eT> > means(n_threads);
+  std::vector< Mat<acc_eT> > scatters(n_threads);
+
+  #pragma omp parallel num_threads(n_threads) if(n_threads > 1)
+    {
+    #ifdef _OPENMP
+      const uword t = uword(omp_get_thread_num());
+    #else
+      const uword t = 0;
+    #endif
+
+    means[t].zeros(A.n_rows);
+    scatters[t].zeros(A.n_rows, A.n_rows);
+    Mat<eT> block;
+
+    #pragma omp for schedule(static)
+    for(int b = 0; b < int(n_blocks); ++b)
+      {
+      const uword first = uword(b) * block_size;
+      const uword last  = (std::min)(first + block_size, N) - 1;
+
+      // Center the block on its own mean; the block is read only once.
+      block = A.cols(first, last);
+      const Col<eT> block_mean = sum(block, 1) / eT(block.n_cols);
+      for(uword i = 0; i < block.n_cols; ++i)
+        {
+        block.col(i) -= block_mean;
+        }
+
+      Mat<acc_eT> block_scatter(A.n_rows, A.n_rows);
+      block_scatter.zeros();
+      op_ccov::syrk_accumulate(block_scatter, block);
+
+      op_ccov::merge_moments(counts[t], means[t], scatters[t], block.n_cols, conv_to< Col<acc_eT> >::from(block_mean), block_scatter);
+      }
+    }
+
+  for(uword t = 1; t < n_threads; ++t)
+    {
+    op_ccov::merge_moments(counts[0], means[0], scatters[0], counts[t], means[t], scatters[t]);
+    }
+
+  const acc_eT norm_val = (norm_type == 0) ? ( (N > 1) ? acc_eT(N-1) : acc_eT(1) ) : acc_eT(N);
+
+  out = conv_to< Mat<eT> >::from( scatters[0] / norm_val );
+  }
+
+
+
+template<typename eT>
+inline
+void
+op_ccov::syrk_accumulate(Mat<eT>& out, const Mat<eT>& A)
+  {
+  arma_extra_debug_sigprint();
+
+  // Newer Armadillo versions expose the symmetric rank-k update, which only
+  // computes one triangle of A * A'.
+  #if (ARMA_VERSION_MAJOR >= 4)
+    syrk<false, false, true>::apply(out, A, eT(1), eT(1));
+  #else
+    out += A * trans(A);
+  #endif
+  }
+
+
+
+inline
+void
+op_ccov::syrk_accumulate(Mat<double>& out, const Mat<float>& A)
+  {
+  arma_extra_debug_sigprint();
+
+  // The outer products of one block are summed in single precision, and the
+  // sums of the blocks in double precision.
+  Mat<float> block_out(out.n_rows, out.n_cols);
+  block_out.zeros();
+  op_ccov::syrk_accumulate(block_out, A);
+
+  out += conv_to< Mat<double> >::from(block_out);
+  }
+
+
+
+template<typename eT>
+inline
+void
+op_ccov::merge_moments(uword& count, Col<eT>& mean, Mat<eT>& scatter, const uword other_count, const Col<eT>& other_mean, const Mat<eT>& other_scatter)
+  {
+  arma_extra_debug_sigprint();
+
+  if(other_count == 0)
+    {
+    return;
     }
+
+  const eT n     = eT(count);
+  const eT m     = eT(other_count);
+  const eT total = n + m;
+
+  // The pairwise update of Chan et al.
+  const Col<eT> delta = other_mean - mean;
+
+  scatter += other_scatter + (n * m / total) * (delta * trans(delta));
+  mean    += (m / total) * delta;
+  count   += other_count;
   }
 
 
@@ -21,6 +21,13 @@
 
 
 
+// the type in which the sums of the blocked implementations are accumulated;
+// single-precision matrices are summed in double precision
+template<typename eT> struct ccov_accumulator        { typedef eT     result; };
+template<>            struct ccov_accumulator<float> { typedef double result; };
+
+
+
 class op_ccov
   {
   public:
@@ -29,6 +36,17 @@ class op_ccov
   template<typename  T> inline static void direct_ccov(Mat< std::complex<T> >& out, const Mat< std::complex<T> >& X, const uword norm_type);
   
   template<typename T1> inline static void apply(Mat<typename T1::elem_type>& out, const Op<T1,op_ccov>& in);
+  
+  // one-pass variant (each column is read once), for real matrices
+  template<typename eT> inline static void direct_ccov_onepass(Mat<eT>& out, const Mat<eT>& X, const uword norm_type);
+  
+  // helpers for the blocked implementations
+  template<typename eT> inline static void syrk_accumulate(Mat<eT>& out, const Mat<eT>& A);
+                        inline static void syrk_accumulate(Mat<double>& out, const Mat<float>& A);
+  template<typename eT> inline static void merge_moments(uword& count, Col<eT>& mean, Mat<eT>& scatter, const uword other_count, const Col<eT>& other_mean, const Mat<eT>& other_scatter);
+  
+  // number of columns centered at a time
+  static const uword block_size = 1024;
   };
 
 
@@ -0,0 +1,226 @@
+/**
+ * @file chunk_reader.hpp
+ *
+ * A reader which yields a dataset one block of points at a time, so that it
+ * never has to be in memory all at once.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_READER_HPP
+#define __MLPACK_CORE_DATA_CHUNK_READER_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mapped_matrix.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Read a dataset one chunk (block of points) at a time, where each chunk is a
+ * matrix of at most ChunkSize() columns (points), in the same orientation as
+ * data::Load() gives.  Only one chunk is in memory at a time for:
+ *
+ *  - CSV and raw ASCII files (.csv, .txt), which are read line by line;
+ *  - Armadillo ASCII files (.txt with an ARMA_MAT_TXT header), likewise;
+ *  - Armadillo binary files (.bin with an ARMA_MAT_BIN header), which are read
+ *    with one seek for each dimension of each chunk;
+ *  - mlpack binary files (.mbin), which are memory-mapped (see MappedMatrix),
+ *    so the pages of finished chunks can be dropped from memory at any time.
+ *
+ * Any other file (HDF5, PGM, raw binary) is loaded entirely with data::Load(),
+ * and the chunks are then copied from it.
+ *
+ * The text formats follow the same rules as data::Load(): the data ends at
+ * the first empty line, missing CSV values are zero, and raw ASCII lines must
+ * all have the same number of values.  Since the file is not read in advance,
+ * the dimensionality is the number of values on the first line, and a later,
+ * longer line is an error.  Errors are fatal.
+ *
+ * @code
+ * ChunkReader<double> reader("huge.csv", 10000);
+ * arma::mat chunk;
+ * while (reader.NextChunk(chunk))
+ * {
+ *   // Use the at most 10000 points in chunk.
+ * }
+ * @endcode
+ *
+ * ForEach() calls a function on every chunk, and can read the next chunk on a
+ * second thread while the function is run on the current one.  Pipeline()
+ * also writes the results of the previous chunk on a third thread, for
+ * programs which stream their results out (such as searches of a query set
+ * too large for memory).
+ *
+ * @tparam eT Type of the elements of the matrix.
+ */
+template<typename eT>
+class ChunkReader
+{
+ public:
+  /**
+   * Open the given file to be read in chunks of the given number of points.
+   * If the file cannot be opened, a fatal error is given.
+   *
+   * @param filename Name of file to read.
+   * @param chunkSize Maximum number of points in a chunk.
+   */
+  ChunkReader(const std::string& filename, const size_t chunkSize);
+
+  /**
+   * Read the next chunk of points.  The chunk has ChunkSize() points, except
+   * possibly the last one; when every point has been read, false is returned
+   * and the chunk is emptied.
+   *
+   * @param chunk Matrix to store the points in.
+   * @return Whether any points were read.
+   */
+  bool NextChunk(arma::Mat<eT>& chunk);
+
+  //! Go back to the first point of the file.
+  void Reset();
+
+  /**
+   * Read the whole file, from its first point, calling
+   *
+   *  - function(const arma::Mat<eT>& chunk, const size_t firstPoint)
+   *
+   * on every chunk, where firstPoint is the index (in the file) of the first
+   * point of the chunk.  If prefetch is true and mlpack was built with OpenMP,
+   * the next chunk is read by a second thread while the function is running
+   * on the current chunk, so at most two chunks are in memory.  The function
+   * must not throw; nor must reading the file fail, since an exception cannot
+   * leave an OpenMP parallel region.
+   *
+   * @param function Function to call on each chunk.
+   * @param prefetch Whether to read the next chunk while the function runs.
+   * @return The number of points read.
+   */
+  template<typename FunctionType>
+  size_t ForEach(FunctionType& function, const bool prefetch = true);
+
+  /**
+   * Read the whole file, from its first point, in a pipeline of three stages,
+   * which must have the methods
+   *
+   *  - void Process(const arma::Mat<eT>& chunk, const size_t firstPoint,
+   *                 const size_t slot)
+   *  - void Output(const size_t slot)
+   *
+   * Process() computes the results of a chunk (firstPoint is the index of its
+   * first point in the file) and keeps them in the given slot, 0 or 1;
+   * Output() writes out the results kept in the given slot.  Every chunk is
+   * processed and then output, in order.  If overlap is true and mlpack was
+   * built with OpenMP, the next chunk is read, the current chunk is processed
+   * and the results of the previous chunk are output at the same time, on
+   * three threads, so at most two chunks and two sets of results are in
+   * memory.  Nested parallelism is enabled while the pipeline runs, so
+   * Process() may itself use several threads.  As with ForEach(), the stages
+   * must not throw.
+   *
+   * @param stages Stages to run on each chunk.
+   * @param overlap Whether to run the three stages at the same time.
+   * @return The number of points read.
+   */
+  template<typename StagesType>
+  size_t Pipeline(StagesType& stages, const bool overlap = true);
+
+  //! Get the maximum number of points in a chunk.
+  size_t ChunkSize() const { return chunkSize; }
+  //! Modify the maximum number of points in a chunk.
+  size_t& ChunkSize() { return chunkSize; }
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+
+  //! Get the number of points read so far.
+  size_t PointsRead() const { return pointsRead; }
+
+ private:
+  //! How the file is read.
+  enum Source
+  {
+    TEXT_SOURCE,        // A text file, read line by line.
+    ARMA_BINARY_SOURCE, // An Armadillo binary file, read with seeks.
+    MATRIX_SOURCE       // A matrix loaded (or mapped) into memory.
+  };
+
+  //! The name of the file.
+  std::string filename;
+  //! The maximum number of points in a chunk.
+  size_t chunkSize;
+  //! How the file is read.
+  Source source;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points read so far.
+  size_t pointsRead;
+
+  //! The file, for text and Armadillo binary files.
+  std::ifstream stream;
+  //! The position of the first point (or value) in the stream.
+  std::streampos dataStart;
+  //! Whether the values of a text file are separated by commas.
+  bool csv;
+  //! Whether the end of the data of a text file was reached.
+  bool finished;
+  //! The next line of a text file, if it was already read.
+  std::string line;
+  //! Whether line holds the next line.
+  bool lineReady;
+
+  //! The number of points in an Armadillo binary file.
+  size_t points;
+  //! A buffer for one dimension of a chunk of an Armadillo binary file.
+  std::vector<eT> values;
+
+  //! The matrix, for the other files (possibly memory-mapped).
+  MappedMatrix<eT> matrix;
+
+  //! Open a text file; header is the number of lines to skip.
+  void OpenText(const size_t header);
+  //! Open an Armadillo binary file.
+  void OpenArmaBinary();
+
+  //! Read the next line of a text file into line; return false at the end of
+  //! the data.
+  bool ReadLine();
+
+  //! Read the next chunk of a text file.
+  bool NextTextChunk(arma::Mat<eT>& chunk);
+  //! Read the next chunk of an Armadillo binary file.
+  bool NextArmaBinaryChunk(arma::Mat<eT>& chunk);
+
+  //! The Armadillo binary header of a matrix of eT.
+  static std::string ArmaBinaryHeader();
+
+  //! A ChunkReader cannot be copied.
+  ChunkReader(const ChunkReader& other);
+  //! A ChunkReader cannot be copied.
+  ChunkReader& operator=(const ChunkReader& other);
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "chunk_reader_impl.hpp"
+
+#endif
@@ -0,0 +1,410 @@
+/**
+ * @file chunk_reader_impl.hpp
+ *
+ * Implementation of ChunkReader.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+#define __MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunk_reader.hpp"
+
+#include "load_text.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+ChunkReader<eT>::ChunkReader(const std::string& filename,
+                             const size_t chunkSize) :
+    filename(filename),
+    chunkSize(chunkSize),
+    source(MATRIX_SOURCE),
+    dimensionality(0),
+    pointsRead(0),
+    csv(false),
+    finished(false),
+    lineReady(false),
+    points(0)
+{
+  if (chunkSize == 0)
+    Log::Fatal << "Invalid chunk size: 0.  Must be greater than 0."
+        << std::endl;
+
+  const size_t ext = filename.rfind('.');
+  std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  if ((extension == "csv") || (extension == "txt") || (extension == "bin"))
+  {
+    stream.open(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      Log::Fatal << "Cannot open file '" << filename << "'." << std::endl;
+
+    // Check for the Armadillo headers, as data::Load() does.
+    char rawHeader[13];
+    stream.read(rawHeader, 12);
+    rawHeader[stream.gcount()] = '\0';
+    stream.clear();
+    stream.seekg(0);
+
+    if (extension == "csv")
+    {
+      csv = true;
+      OpenText(0);
+    }
+    else if (extension == "txt")
+    {
+      // Armadillo ASCII files have two lines of header.
+      OpenText((std::string(rawHeader) == "ARMA_MAT_TXT") ? 2 : 0);
+    }
+    else if (std::string(rawHeader) == "ARMA_MAT_BIN")
+    {
+      OpenArmaBinary();
+    }
+    else
+    {
+      // Raw binary has no dimensions; let data::Load() deal with it.
+      stream.close();
+      matrix.Load(filename, true);
+      dimensionality = matrix.Matrix().n_rows;
+    }
+  }
+  else
+  {
+    matrix.Load(filename, true);
+    dimensionality = matrix.Matrix().n_rows;
+  }
+}
+
+template<typename eT>
+void ChunkReader<eT>::OpenText(const size_t header)
+{
+  source = TEXT_SOURCE;
+
+  std::string headerLine;
+  for (size_t i = 0; i < header; ++i)
+    std::getline(stream, headerLine);
+  dataStart = stream.tellg();
+
+  // The first line gives the dimensionality (and, for .txt files, whether the
+  // values are separated by commas).
+  if (ReadLine())
+  {
+    if (header == 0 && line.find(',') != std::string::npos)
+      csv = true;
+    dimensionality = CountTextValues(line.data(), line.data() + line.size(),
+        csv);
+    lineReady = true;
+  }
+}
+
+template<typename eT>
+void ChunkReader<eT>::OpenArmaBinary()
+{
+  source = ARMA_BINARY_SOURCE;
+
+  // The header is the type, then the number of rows and columns; each row of
+  // the file is a point.
+  std::string header;
+  stream >> header;
+  stream >> points;
+  stream >> dimensionality;
+  stream.get();
+
+  if (!stream.good())
+    Log::Fatal << "Cannot read the header of '" << filename << "'."
+        << std::endl;
+
+  if (header != ArmaBinaryHeader())
+    Log::Fatal << "The elements of '" << filename << "' are not of the "
+        << "requested type." << std::endl;
+
+  dataStart = stream.tellg();
+}
+
+template<typename eT>
+bool ChunkReader<eT>::NextChunk(arma::Mat<eT>& chunk)
+{
+  bool read;
+  if (source == TEXT_SOURCE)
+  {
+    read = NextTextChunk(chunk);
+  }
+  else if (source == ARMA_BINARY_SOURCE)
+  {
+    read = NextArmaBinaryChunk(chunk);
+  }
+  else
+  {
+    const arma::Mat<eT>& data = matrix.Matrix();
+    const size_t count = std::min(chunkSize, data.n_cols - pointsRead);
+    read = (count > 0);
+    if (read)
+      chunk = data.cols(pointsRead, pointsRead + count - 1);
+  }
+
+  if (!read)
+  {
+    chunk.reset();
+    return false;
+  }
+
+  pointsRead += chunk.n_cols;
+  return true;
+}
+
+template<typename eT>
+void ChunkReader<eT>::Reset()
+{
+  pointsRead = 0;
+  if (source != MATRIX_SOURCE)
+  {
+    stream.clear();
+    stream.seekg(dataStart);
+    finished = false;
+    lineReady = false;
+  }
+}
+
+template<typename eT>
+template<typename FunctionType>
+size_t ChunkReader<eT>::ForEach(FunctionType& function, const bool prefetch)
+{
+  Reset();
+
+  // The function runs on one buffer while the next chunk is read into the
+  // other.
+  arma::Mat<eT> chunks[2];
+  size_t current = 0;
+  size_t firstPoint = 0;
+  bool hasChunk = NextChunk(chunks[current]);
+  while (hasChunk)
+  {
+    const arma::Mat<eT>& chunk = chunks[current];
+    bool hasNext = false;
+    if (prefetch)
+    {
+      #pragma omp parallel sections num_threads(2)
+      {
+        #pragma omp section
+        function(chunk, firstPoint);
+
+        #pragma omp section
+        hasNext = NextChunk(chunks[1 - current]);
+      }
+    }
+    else
+    {
+      function(chunk, firstPoint);
+      hasNext = NextChunk(chunks[1 - current]);
+    }
+
+    firstPoint += chunk.n_cols;
+    current = 1 - current;
+    hasChunk = hasNext;
+  }
+
+  return firstPoint;
+}
+
+template<typename eT>
+template<typename StagesType>
+size_t ChunkReader<eT>::Pipeline(StagesType& stages, const bool overlap)
+{
+  Reset();
+
+  // Chunk i is processed into result slot i % 2 while chunk i + 1 is read into
+  // the other buffer and the results of chunk i - 1 (in the other slot) are
+  // output.
+#ifdef _OPENMP
+  const int nested = omp_get_nested();
+  if (overlap)
+    omp_set_nested(1);
+#endif
+
+  arma::Mat<eT> chunks[2];
+  size_t current = 0;
+  size_t firstPoint = 0;
+  size_t processed = 0;
+  bool hasChunk = NextChunk(chunks[current]);
+  while (hasChunk)
+  {
+    const arma::Mat<eT>& chunk = chunks[current];
+    const size_t slot = processed % 2;
+    bool hasNext = false;
+    if (overlap)
+    {
+      #pragma omp parallel sections num_threads(3)
+      {
+        #pragma omp section
+        stages.Process(chunk, firstPoint, slot);
+
+        #pragma omp section
+        hasNext = NextChunk(chunks[1 - current]);
+
+        #pragma omp section
+        {
+          if (processed > 0)
+            stages.Output(1 - slot);
+        }
+      }
+    }
+    else
+    {
+      if (processed > 0)
+        stages.Output(1 - slot);
+      stages.Process(chunk, firstPoint, slot);
+      hasNext = NextChunk(chunks[1 - current]);
+    }
+
+    firstPoint += chunk.n_cols;
+    ++processed;
+    current = 1 - current;
+    hasChunk = hasNext;
+  }
+
+  if (processed > 0)
+    stages.Output((processed - 1) % 2);
+
+#ifdef _OPENMP
+  omp_set_nested(nested);
+#endif
+
+  return firstPoint;
+}
+
+template<typename eT>
+bool ChunkReader<eT>::ReadLine()
+{
+  if (finished)
+    return false;
+
+  // As with data::Load(), the data ends at the first empty line.
+  if (!std::getline(stream, line))
+  {
+    finished = true;
+    return false;
+  }
+
+  if (!line.empty() && line[line.size() - 1] == '\r')
+    line.erase(line.size() - 1);
+
+  if (line.empty())
+  {
+    finished = true;
+    return false;
+  }
+
+  return true;
+}
+
+template<typename eT>
+bool ChunkReader<eT>::NextTextChunk(arma::Mat<eT>& chunk)
+{
+  if (dimensionality == 0)
+    return false;
+
+  chunk.set_size(dimensionality, chunkSize);
+  size_t count = 0;
+  while (count < chunkSize)
+  {
+    if (lineReady)
+      lineReady = false;
+    else if (!ReadLine())
+      break;
+
+    const char* begin = line.data();
+    const char* end = begin + line.size();
+    const size_t lineValues = CountTextValues(begin, end, csv);
+    if ((lineValues > dimensionality) ||
+        (!csv && lineValues != dimensionality))
+      Log::Fatal << "Point " << (pointsRead + count) << " of '" << filename
+          << "' has " << lineValues << " values, but the first point has "
+          << dimensionality << "." << std::endl;
+
+    if (!ParseTextLine(begin, end, csv, dimensionality, chunk.colptr(count),
+        1))
+      Log::Fatal << "Cannot parse point " << (pointsRead + count) << " of '"
+          << filename << "'." << std::endl;
+
+    ++count;
+  }
+
+  if (count == 0)
+    return false;
+
+  if (count < chunkSize)
+    chunk.shed_cols(count, chunkSize - 1);
+
+  return true;
+}
+
+template<typename eT>
+bool ChunkReader<eT>::NextArmaBinaryChunk(arma::Mat<eT>& chunk)
+{
+  const size_t count = std::min(chunkSize, points - pointsRead);
+  if (count == 0)
+    return false;
+
+  // The file is column-major with one row per point, so each dimension of the
+  // chunk is contiguous in the file.
+  chunk.set_size(dimensionality, count);
+  values.resize(count);
+  for (size_t j = 0; j < dimensionality; ++j)
+  {
+    stream.seekg(dataStart + std::streamoff((j * points + pointsRead) *
+        sizeof(eT)));
+    stream.read((char*) &values[0], count * sizeof(eT));
+    if (!stream.good())
+      Log::Fatal << "Cannot read from '" << filename << "'." << std::endl;
+
+    for (size_t i = 0; i < count; ++i)
+      chunk(j, i) = values[i];
+  }
+
+  return true;
+}
+
+template<typename eT>
+std::string ChunkReader<eT>::ArmaBinaryHeader()
+{
+  // This is the naming scheme of Armadillo: "FN" for floating-point numbers,
+  // "IS" and "IU" for signed and unsigned integers, and the size in bytes.
+  const char* kind = !std::numeric_limits<eT>::is_integer ? "FN" :
+      (std::numeric_limits<eT>::is_signed ? "IS" : "IU");
+
+  char header[32];
+  sprintf(header, "ARMA_MAT_BIN_%s%03d", kind, (int) sizeof(eT));
+  return std::string(header);
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file chunk_writer.hpp
+ *
+ * Definition of the ChunkWriter class, which writes a dataset one chunk of
+ * points at a time.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_WRITER_HPP
+#define __MLPACK_CORE_DATA_CHUNK_WRITER_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <fstream>
+#include <string>
+
+#include "mapped_matrix.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Write a dataset one chunk (block of points) at a time, where each chunk is a
+ * matrix whose columns are points, in the same orientation as data::Save()
+ * takes.  This is the counterpart of ChunkReader: only one chunk has to be in
+ * memory, so a dataset larger than memory can be generated and written.  The
+ * number of points does not have to be known in advance.  The file is one of:
+ *
+ *  - an mlpack binary file (.mbin), whose header is written again with the
+ *    number of points when the writer is closed;
+ *  - a CSV or raw ASCII file (.csv, .txt), with one point per line, in which
+ *    each value is formatted as data::Save() does, to be read back exactly.
+ *
+ * The file is the same as data::Save() would write for the concatenation of
+ * the chunks.  Errors are fatal.
+ *
+ * @code
+ * ChunkWriter<double> writer("huge.mbin", 10);
+ * for (size_t i = 0; i < 1000; ++i)
+ *   writer.Write(arma::randu<arma::mat>(10, 10000));
+ * writer.Close(); // Or let the destructor close it.
+ * @endcode
+ *
+ * @tparam eT Type of the elements of the matrix.
+ */
+template<typename eT>
+class ChunkWriter
+{
+ public:
+  /**
+   * Create the given file, to write points of the given dimensionality to.  If
+   * the file cannot be created, or its format cannot be written in chunks, a
+   * fatal error is given.
+   *
+   * @param filename Name of file to write.
+   * @param dimensionality Dimensionality of the points.
+   */
+  ChunkWriter(const std::string& filename, const size_t dimensionality);
+
+  //! Close the file, if it is still open.
+  ~ChunkWriter();
+
+  /**
+   * Append the given points (the columns of the chunk) to the file.
+   *
+   * @param chunk Points to write; it must have Dimensionality() rows.
+   */
+  void Write(const arma::Mat<eT>& chunk);
+
+  /**
+   * Finish the file: for an mlpack binary file, the number of points is
+   * written into the header.  Nothing can be written after this.
+   */
+  void Close();
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+
+  //! Get the number of points written so far.
+  size_t PointsWritten() const { return pointsWritten; }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points written so far.
+  size_t pointsWritten;
+
+  //! The file.
+  std::ofstream stream;
+  //! Whether the file is in the mlpack binary format (otherwise it is text).
+  bool binary;
+  //! Whether the values of a text file are separated by commas.
+  bool csv;
+
+  //! A ChunkWriter cannot be copied.
+  ChunkWriter(const ChunkWriter& other);
+  //! A ChunkWriter cannot be copied.
+  ChunkWriter& operator=(const ChunkWriter& other);
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "chunk_writer_impl.hpp"
+
+#endif
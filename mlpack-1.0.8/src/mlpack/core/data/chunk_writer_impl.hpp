@@ -0,0 +1,130 @@
+/**
+ * @file chunk_writer_impl.hpp
+ *
+ * Implementation of the ChunkWriter class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_WRITER_IMPL_HPP
+#define __MLPACK_CORE_DATA_CHUNK_WRITER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunk_writer.hpp"
+
+#include <algorithm>
+
+#include "save_text.hpp"
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+ChunkWriter<eT>::ChunkWriter(const std::string& filename,
+                             const size_t dimensionality) :
+    filename(filename),
+    dimensionality(dimensionality),
+    pointsWritten(0),
+    binary(false),
+    csv(false)
+{
+  const size_t ext = filename.rfind('.');
+  std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  if (extension == "mbin")
+    binary = true;
+  else if (extension == "csv")
+    csv = true;
+  else if (extension != "txt")
+    Log::Fatal << "Cannot write '" << filename << "' in chunks; only mlpack "
+        << "binary (.mbin), CSV (.csv) and raw ASCII (.txt) files can be "
+        << "written one chunk at a time." << std::endl;
+
+  stream.open(filename.c_str(), binary ? std::ios::binary : std::ios::out);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open file '" << filename << "' for writing."
+        << std::endl;
+
+  // The number of points is not known yet; it is set by Close().
+  if (binary)
+    MappedMatrix<eT>::WriteHeader(stream, dimensionality, 0);
+}
+
+template<typename eT>
+ChunkWriter<eT>::~ChunkWriter()
+{
+  Close();
+}
+
+template<typename eT>
+void ChunkWriter<eT>::Write(const arma::Mat<eT>& chunk)
+{
+  Log::Assert(chunk.n_rows == dimensionality);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot write to '" << filename << "' after it was closed."
+        << std::endl;
+
+  if (binary)
+  {
+    stream.write((const char*) chunk.memptr(), chunk.n_elem * sizeof(eT));
+  }
+  else
+  {
+    const char separator = csv ? ',' : ' ';
+    std::string text;
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      for (size_t j = 0; j < chunk.n_rows; ++j)
+      {
+        if (j > 0)
+          text += separator;
+        AppendTextNumber(chunk(j, i), text);
+      }
+      text += '\n';
+    }
+
+    stream.write(text.data(), text.size());
+  }
+
+  if (!stream.good())
+    Log::Fatal << "Cannot write to file '" << filename << "'." << std::endl;
+
+  pointsWritten += chunk.n_cols;
+}
+
+template<typename eT>
+void ChunkWriter<eT>::Close()
+{
+  if (!stream.is_open())
+    return;
+
+  if (binary)
+  {
+    stream.seekp(0);
+    MappedMatrix<eT>::WriteHeader(stream, dimensionality, pointsWritten);
+  }
+
+  stream.close();
+  if (stream.fail())
+    Log::Fatal << "Cannot write to file '" << filename << "'." << std::endl;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -46,6 +46,7 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5, denoted by .hdf, .hdf5, .h5, or .he5
+ *  - mlpack binary, denoted by .mbin (see MappedMatrix)
  *
  * If the file extension is not one of those types, an error will be given.
  * This is preferable to Armadillo's default behavior of loading an unknown
@@ -57,16 +58,76 @@ namespace data /** Functions to load and save matrices. */ {
  * because data is generally stored in a row-major format and MLPACK requires
  * column-major matrices, this should be left at its default value of 'true'.
  *
+ * CSV and raw ASCII files are memory-mapped and parsed in parallel by
+ * LoadText(), directly into the transposed matrix, with the given number of
+ * threads; if that parser does not understand the file, Armadillo's parser is
+ * used instead.
+ *
  * @param filename Name of file to load.
  * @param matrix Matrix to load contents of file into.
  * @param fatal If an error should be reported as fatal (default false).
  * @param transpose If true, transpose the matrix after loading.
+ * @param threads Number of threads to parse CSV and raw ASCII files with (0
+ *     means all available cores).
  * @return Boolean value indicating success or failure of load.
  */
 template<typename eT>
 bool Load(const std::string& filename,
           arma::Mat<eT>& matrix,
           bool fatal = false,
+          bool transpose = true,
+          const size_t threads = 1);
+
+/**
+ * Loads a sparse matrix from file, guessing the format from the extension.  As
+ * with dense matrices, each line (row) of the file is a point, so by default
+ * the matrix is transposed at load time.  The supported formats are:
+ *
+ *  - coordinate lists, denoted by .csv or .txt, where each line holds the
+ *    row, the column, and the value of one nonzero element, separated by
+ *    commas or whitespace; rows and columns start at 0, as with Armadillo's
+ *    coord_ascii
+ *  - MatrixMarket coordinate files (real, integer, or pattern; general,
+ *    symmetric, or skew-symmetric), denoted by .mtx
+ *  - svmlight (libsvm) files, denoted by .svm, .libsvm, or .svmlight, where
+ *    each line is one point: a label, followed by index:value pairs with
+ *    indices that start at 1 (the labels are discarded; see the overload
+ *    below)
+ *
+ * The file is read twice: first to count the nonzero elements of each column,
+ * then to place them into the compressed sparse column arrays of the matrix,
+ * so no list of triplets is ever held in memory.  Elements that appear more
+ * than once are added, and explicit zeros are dropped.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load contents of file into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          bool fatal = false,
+          bool transpose = true);
+
+/**
+ * Loads a sparse matrix and the labels of its points from an svmlight (libsvm)
+ * file (.svm, .libsvm, or .svmlight); see the overload above.  For other
+ * formats, the labels are empty.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load contents of file into.
+ * @param labels Vector to store the label of each point in.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          arma::vec& labels,
+          bool fatal = false,
           bool transpose = true);
 
 }; // namespace data
@@ -74,5 +135,6 @@ bool Load(const std::string& filename,
 
 // Include implementation.
 #include "load_impl.hpp"
+#include "load_sparse_impl.hpp"
 
 #endif
@@ -24,6 +24,8 @@
 
 // In case it hasn't already been included.
 #include "load.hpp"
+#include "load_text.hpp"
+#include "mapped_matrix.hpp"
 
 #include <algorithm>
 #include <mlpack/core/util/timers.hpp>
@@ -35,7 +37,8 @@ template<typename eT>
 bool Load(const std::string& filename,
           arma::Mat<eT>& matrix,
           bool fatal,
-          bool transpose)
+          bool transpose,
+          const size_t threads)
 {
   Timer::Start("loading_data");
 
@@ -76,6 +79,7 @@ bool Load(const std::string& filename,
   }
 
   bool unknownType = false;
+  bool mlpackBinary = false;
   arma::file_type loadType;
   std::string stringType;
 
@@ -146,6 +150,14 @@ bool Load(const std::string& filename,
 
     delete[] rawHeader;
   }
+  else if (extension == "mbin")
+  {
+    // The mlpack binary format is not an Armadillo format; loadType is not
+    // used.
+    mlpackBinary = true;
+    loadType = arma::raw_binary;
+    stringType = "mlpack binary formatted data";
+  }
   else if (extension == "pgm")
   {
     loadType = arma::pgm_binary;
@@ -193,14 +205,44 @@ bool Load(const std::string& filename,
   }
 
   // Try to load the file; but if it's raw_binary, it could be a problem.
-  if (loadType == arma::raw_binary)
+  if ((loadType == arma::raw_binary) && !mlpackBinary)
     Log::Warn << "Loading '" << filename << "' as " << stringType << "; "
         << "but this may not be the actual filetype!" << std::endl;
   else
     Log::Info << "Loading '" << filename << "' as " << stringType << ".  "
         << std::flush;
 
-  const bool success = matrix.load(stream, loadType);
+  bool success = false;
+  if (mlpackBinary)
+  {
+    // The file already holds the transposed matrix.  This copies it; use
+    // MappedMatrix to map it instead.
+    stream.close();
+    MappedMatrix<eT> mapped;
+    success = mapped.Load(filename, false);
+    if (success)
+      matrix = transpose ? mapped.Matrix() : trans(mapped.Matrix());
+  }
+  else if ((loadType == arma::csv_ascii) || (loadType == arma::raw_ascii))
+  {
+    // CSV and raw ASCII files are parsed by our own (parallel) parser, which
+    // writes them straight into the transposed matrix; anything it does not
+    // understand is left to Armadillo.
+    stream.close();
+    success = LoadText(filename, matrix, loadType == arma::csv_ascii,
+        transpose, threads);
+    if (!success)
+      stream.open(filename.c_str(), std::fstream::in);
+  }
+
+  if (!success && !mlpackBinary)
+  {
+    success = matrix.load(stream, loadType);
+
+    // Now transpose the matrix, if necessary.
+    if (transpose)
+      matrix = trans(matrix);
+  }
 
   if (!success)
   {
@@ -211,12 +253,8 @@ bool Load(const std::string& filename,
       Log::Warn << "Loading from '" << filename << "' failed." << std::endl;
   }
   else
-    Log::Info << "Size is " << (transpose ? matrix.n_cols : matrix.n_rows)
-        << " x " << (transpose ? matrix.n_rows : matrix.n_cols) << ".\n";
-
-  // Now transpose the matrix, if necessary.
-  if (transpose)
-    matrix = trans(matrix);
+    Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols
+        << ".\n";
 
   Timer::Stop("loading_data");
 
@@ -0,0 +1,550 @@
+/**
+ * @file load_sparse_impl.hpp
+ *
+ * Implementation of data::Load() for sparse matrices, in coordinate,
+ * MatrixMarket, and svmlight (libsvm) formats.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_LOAD_SPARSE_IMPL_HPP
+#define __MLPACK_CORE_DATA_LOAD_SPARSE_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "load.hpp"
+#include "load_text.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <mlpack/core/util/timers.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! The sparse formats data::Load() understands.
+enum SparseFormat
+{
+  COORDINATE_FORMAT,
+  MATRIX_MARKET_FORMAT,
+  SVMLIGHT_FORMAT
+};
+
+//! What the header of a sparse file says, and what the first pass found.
+struct SparseFileInfo
+{
+  //! The format of the file.
+  SparseFormat format;
+  //! Whether only one triangle of a (MatrixMarket) symmetric matrix is stored.
+  bool symmetric;
+  //! Whether the mirrored elements are negated (skew-symmetric).
+  bool skew;
+  //! Whether the file has no values (which are then 1).
+  bool pattern;
+  //! The number of rows of the file (points), if the header gives it.
+  size_t rows;
+  //! The number of columns of the file (dimensions), if the header gives it.
+  size_t cols;
+};
+
+//! Parse a nonnegative integer [begin, end); it may be written as a number
+//! with a fractional part of zero, such as "3.0000e+00".
+inline bool ParseSparseIndex(const char* begin, const char* end, size_t& index)
+{
+  double value;
+  if (!ParseTextNumber(begin, end, value) || !(value >= 0.0) ||
+      (value > 1e18) || (value != std::floor(value)))
+    return false;
+
+  index = (size_t) value;
+  return true;
+}
+
+//! Split the line [begin, end) into tokens separated by whitespace (and, if
+//! commas is true, commas).
+inline void SplitSparseLine(const char* begin,
+                            const char* end,
+                            const bool commas,
+                            std::vector<std::pair<const char*, const char*> >&
+                                tokens)
+{
+  tokens.clear();
+  const char* c = begin;
+  while (c != end)
+  {
+    while ((c != end) && (IsTextSpace(*c) || (commas && *c == ',')))
+      ++c;
+    if (c == end)
+      break;
+
+    const char* tokenEnd = c;
+    while ((tokenEnd != end) && !IsTextSpace(*tokenEnd) &&
+        !(commas && *tokenEnd == ','))
+      ++tokenEnd;
+
+    tokens.push_back(std::make_pair(c, tokenEnd));
+    c = tokenEnd;
+  }
+}
+
+/**
+ * Read the elements of a sparse file from the stream (positioned after any
+ * header), calling visitor.Element(row, col, value) for each element, in the
+ * orientation of the file (rows are points), and visitor.Point(label) for each
+ * point of an svmlight file.  Returns false (with a message) if the file is
+ * malformed.
+ */
+template<typename VisitorType>
+bool ReadSparseElements(std::istream& stream,
+                        const SparseFileInfo& info,
+                        VisitorType& visitor,
+                        std::string& error)
+{
+  std::string line;
+  std::vector<std::pair<const char*, const char*> > tokens;
+  size_t lineNumber = 0;
+  size_t point = 0;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+
+    // Comments: '%' starts a comment line in MatrixMarket files, and '#' starts
+    // a comment anywhere in svmlight files.
+    if ((info.format == MATRIX_MARKET_FORMAT) && !line.empty() &&
+        (line[0] == '%'))
+      continue;
+    size_t length = line.size();
+    if (info.format == SVMLIGHT_FORMAT)
+      length = std::min(length, line.find('#'));
+
+    const char* begin = line.data();
+    SplitSparseLine(begin, begin + length, info.format == COORDINATE_FORMAT,
+        tokens);
+
+    // Blank lines are skipped, except that in svmlight files they are points
+    // with no label; those are not allowed either.
+    if (tokens.empty())
+      continue;
+
+    if (info.format == SVMLIGHT_FORMAT)
+    {
+      double label;
+      if (!ParseTextNumber(tokens[0].first, tokens[0].second, label))
+      {
+        error = "invalid label";
+        break;
+      }
+      visitor.Point(label);
+
+      for (size_t t = 1; t < tokens.size(); ++t)
+      {
+        const char* colon = std::find(tokens[t].first, tokens[t].second, ':');
+        size_t index;
+        double value;
+        if ((colon == tokens[t].second) ||
+            !ParseTextNumber(colon + 1, tokens[t].second, value))
+        {
+          error = "invalid index:value pair";
+          break;
+        }
+
+        // Query ids are not features.
+        if (std::string(tokens[t].first, colon) == "qid")
+          continue;
+
+        if (!ParseSparseIndex(tokens[t].first, colon, index) || (index == 0))
+        {
+          error = "invalid index (indices start at 1)";
+          break;
+        }
+
+        visitor.Element(point, index - 1, value);
+      }
+
+      if (!error.empty())
+        break;
+
+      ++point;
+      continue;
+    }
+
+    // Coordinate and MatrixMarket elements: row, column, and (unless it is a
+    // pattern) value.
+    const size_t expected = info.pattern ? 2 : 3;
+    size_t row, col;
+    double value = 1.0;
+    if ((tokens.size() != expected) ||
+        !ParseSparseIndex(tokens[0].first, tokens[0].second, row) ||
+        !ParseSparseIndex(tokens[1].first, tokens[1].second, col) ||
+        (!info.pattern && !ParseTextNumber(tokens[2].first, tokens[2].second,
+        value)))
+    {
+      error = "invalid element";
+      break;
+    }
+
+    if (info.format == MATRIX_MARKET_FORMAT)
+    {
+      // MatrixMarket indices start at 1.
+      if ((row == 0) || (col == 0) || (row > info.rows) || (col > info.cols))
+      {
+        error = "index out of range";
+        break;
+      }
+      --row;
+      --col;
+    }
+
+    visitor.Element(row, col, value);
+    if (info.symmetric && (row != col))
+      visitor.Element(col, row, info.skew ? -value : value);
+  }
+
+  if (!error.empty())
+  {
+    std::ostringstream message;
+    message << error << " on line " << lineNumber;
+    error = message.str();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * The first pass over a sparse file: count the elements of each column of the
+ * matrix (after the transposition, if any) and find its size.
+ */
+class SparseCountVisitor
+{
+ public:
+  SparseCountVisitor(const bool transpose) :
+      transpose(transpose), rows(0), cols(0), points(0) { }
+
+  void Element(const size_t row, const size_t col, const double /* value */)
+  {
+    rows = std::max(rows, row + 1);
+    cols = std::max(cols, col + 1);
+
+    const size_t column = transpose ? row : col;
+    if (column >= counts.size())
+      counts.resize(std::max(2 * counts.size(), column + 1), 0);
+    ++counts[column];
+  }
+
+  void Point(const double /* label */) { ++points; }
+
+  //! Whether the matrix is transposed.
+  bool transpose;
+  //! The number of rows of the file.
+  size_t rows;
+  //! The number of columns of the file.
+  size_t cols;
+  //! The number of points (svmlight only).
+  size_t points;
+  //! The number of elements in each column of the matrix.
+  std::vector<size_t> counts;
+};
+
+/**
+ * The second pass over a sparse file: place each element into its column.
+ */
+template<typename eT>
+class SparseFillVisitor
+{
+ public:
+  SparseFillVisitor(const bool transpose,
+                    std::vector<size_t>& next,
+                    arma::uvec& rowIndices,
+                    arma::Col<eT>& values,
+                    arma::vec* labels) :
+      transpose(transpose),
+      next(next),
+      rowIndices(rowIndices),
+      values(values),
+      labels(labels),
+      point(0) { }
+
+  void Element(const size_t row, const size_t col, const double value)
+  {
+    const size_t column = transpose ? row : col;
+    const size_t position = next[column]++;
+    rowIndices[position] = transpose ? col : row;
+    values[position] = (eT) value;
+  }
+
+  void Point(const double label)
+  {
+    if (labels != NULL)
+      (*labels)[point] = label;
+    ++point;
+  }
+
+ private:
+  bool transpose;
+  std::vector<size_t>& next;
+  arma::uvec& rowIndices;
+  arma::Col<eT>& values;
+  arma::vec* labels;
+  size_t point;
+};
+
+//! Open a sparse file and read its header.  Returns false with a message on
+//! failure; the stream is left at the first element.
+inline bool OpenSparseFile(const std::string& filename,
+                           const std::string& extension,
+                           std::ifstream& stream,
+                           SparseFileInfo& info,
+                           std::string& error)
+{
+  info.symmetric = false;
+  info.skew = false;
+  info.pattern = false;
+  info.rows = 0;
+  info.cols = 0;
+
+  if ((extension == "csv") || (extension == "txt"))
+    info.format = COORDINATE_FORMAT;
+  else if (extension == "mtx")
+    info.format = MATRIX_MARKET_FORMAT;
+  else if ((extension == "svm") || (extension == "libsvm") ||
+           (extension == "svmlight"))
+    info.format = SVMLIGHT_FORMAT;
+  else
+  {
+    error = "unknown sparse format; incorrect extension?";
+    return false;
+  }
+
+  stream.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+  {
+    error = "cannot open file";
+    return false;
+  }
+
+  if (info.format != MATRIX_MARKET_FORMAT)
+    return true;
+
+  // "%%MatrixMarket matrix coordinate <field> <symmetry>", then comments, then
+  // the number of rows, columns, and elements.
+  std::string line;
+  std::getline(stream, line);
+  std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+  std::istringstream banner(line);
+  std::string word, object, layout, field, symmetry;
+  banner >> word >> object >> layout >> field >> symmetry;
+  if ((word != "%%matrixmarket") || (object != "matrix"))
+  {
+    error = "no MatrixMarket header";
+    return false;
+  }
+
+  if (layout != "coordinate")
+  {
+    error = "only MatrixMarket coordinate files are supported";
+    return false;
+  }
+
+  if (field == "pattern")
+    info.pattern = true;
+  else if ((field != "real") && (field != "integer") && (field != "double"))
+  {
+    error = "unsupported MatrixMarket field '" + field + "'";
+    return false;
+  }
+
+  if (symmetry == "symmetric")
+    info.symmetric = true;
+  else if (symmetry == "skew-symmetric")
+    info.symmetric = info.skew = true;
+  else if (symmetry != "general")
+  {
+    error = "unsupported MatrixMarket symmetry '" + symmetry + "'";
+    return false;
+  }
+
+  while (std::getline(stream, line))
+  {
+    if (line.empty() || (line[0] == '%'))
+      continue;
+
+    std::istringstream size(line);
+    size_t elements;
+    if (!(size >> info.rows >> info.cols >> elements))
+    {
+      error = "invalid MatrixMarket size line";
+      return false;
+    }
+
+    return true;
+  }
+
+  error = "no MatrixMarket size line";
+  return false;
+}
+
+//! Load a sparse matrix, and the labels if it is an svmlight file and labels
+//! is not NULL.
+template<typename eT>
+bool LoadSparse(const std::string& filename,
+                arma::SpMat<eT>& matrix,
+                arma::vec* labels,
+                const bool fatal,
+                const bool transpose)
+{
+  Timer::Start("loading_data");
+
+  const size_t ext = filename.rfind('.');
+  std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  SparseFileInfo info;
+  std::ifstream stream;
+  std::string error;
+  bool success = OpenSparseFile(filename, extension, stream, info, error);
+
+  std::streampos dataStart = 0;
+  SparseCountVisitor counter(transpose);
+  if (success)
+  {
+    Log::Info << "Loading '" << filename << "' as sparse data.  "
+        << std::flush;
+
+    // First pass: count the elements of each column.
+    dataStart = stream.tellg();
+    success = ReadSparseElements(stream, info, counter, error);
+  }
+
+  if (success)
+  {
+    // The size of the file is given by its header, or by the elements.
+    size_t fileRows = (info.format == MATRIX_MARKET_FORMAT) ? info.rows :
+        counter.rows;
+    const size_t fileCols = (info.format == MATRIX_MARKET_FORMAT) ?
+        info.cols : counter.cols;
+    if (info.format == SVMLIGHT_FORMAT)
+      fileRows = counter.points;
+
+    const size_t nRows = transpose ? fileCols : fileRows;
+    const size_t nCols = transpose ? fileRows : fileCols;
+
+    counter.counts.resize(nCols, 0);
+    arma::uvec colPtrs(nCols + 1);
+    colPtrs[0] = 0;
+    for (size_t c = 0; c < nCols; ++c)
+      colPtrs[c + 1] = colPtrs[c] + counter.counts[c];
+    const size_t elements = colPtrs[nCols];
+
+    // Second pass: place the elements into their columns.
+    arma::uvec rowIndices(elements);
+    arma::Col<eT> values(elements);
+    std::vector<size_t> next(colPtrs.memptr(), colPtrs.memptr() + nCols);
+    if (labels != NULL)
+      labels->set_size((info.format == SVMLIGHT_FORMAT) ? counter.points : 0);
+
+    stream.clear();
+    stream.seekg(dataStart);
+    SparseFillVisitor<eT> filler(transpose, next, rowIndices, values, labels);
+    success = ReadSparseElements(stream, info, filler, error);
+
+    if (success)
+    {
+      // Sort each column by row, adding duplicates and dropping zeros, and
+      // pack the columns together.
+      size_t packed = 0;
+      std::vector<std::pair<arma::uword, eT> > column;
+      for (size_t c = 0; c < nCols; ++c)
+      {
+        column.clear();
+        for (size_t i = colPtrs[c]; i < colPtrs[c + 1]; ++i)
+          column.push_back(std::make_pair(rowIndices[i], values[i]));
+        std::sort(column.begin(), column.end());
+
+        colPtrs[c] = packed;
+        for (size_t i = 0; i < column.size(); ++i)
+        {
+          eT value = column[i].second;
+          while ((i + 1 < column.size()) &&
+              (column[i + 1].first == column[i].first))
+            value += column[++i].second;
+
+          if (value != eT(0))
+          {
+            rowIndices[packed] = column[i].first;
+            values[packed] = value;
+            ++packed;
+          }
+        }
+      }
+      colPtrs[nCols] = packed;
+
+      if (packed < elements)
+      {
+        rowIndices.shed_rows(packed, elements - 1);
+        values.shed_rows(packed, elements - 1);
+      }
+
+      matrix = arma::SpMat<eT>(rowIndices, colPtrs, values, nRows, nCols);
+    }
+  }
+
+  if (!success)
+  {
+    Log::Info << std::endl;
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << error
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << error
+          << "." << std::endl;
+  }
+  else
+    Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols
+        << " with " << matrix.n_nonzero << " nonzero elements.\n";
+
+  Timer::Stop("loading_data");
+
+  return success;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          bool fatal,
+          bool transpose)
+{
+  return LoadSparse(filename, matrix, (arma::vec*) NULL, fatal, transpose);
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          arma::vec& labels,
+          bool fatal,
+          bool transpose)
+{
+  return LoadSparse(filename, matrix, &labels, fatal, transpose);
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
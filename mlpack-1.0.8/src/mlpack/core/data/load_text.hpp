@@ -0,0 +1,71 @@
+/**
+ * @file load_text.hpp
+ *
+ * Declaration of a fast, multithreaded parser for CSV and raw ASCII files,
+ * used by data::Load().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_LOAD_TEXT_HPP
+#define __MLPACK_CORE_DATA_LOAD_TEXT_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Load a CSV (csv_ascii) or raw ASCII (raw_ascii) file into a matrix.  The
+ * file is memory-mapped and split at line boundaries into one chunk per
+ * thread; each thread parses the numbers of its chunk and writes them straight
+ * into their final place in the matrix, so when the matrix is transposed (the
+ * default of data::Load()) each line of the file is written to one contiguous
+ * column and no separate transposition is needed.
+ *
+ * The layout rules are the same as Armadillo's: the data ends at the first
+ * empty line; for CSV files the number of columns is the length of the longest
+ * line, and missing or empty values are zero; for raw ASCII files every line
+ * must have the same number of values.
+ *
+ * This returns false, without printing anything, if the file cannot be mapped
+ * or contains anything that this parser does not understand (for instance, a
+ * value that is not a number); data::Load() then falls back to Armadillo's
+ * parser, which produces the error messages.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Matrix to load contents of file into.
+ * @param csv If true, the values are separated by commas; otherwise, by
+ *     whitespace.
+ * @param transpose If true, each line of the file is a column of the matrix.
+ * @param threads Number of threads to use (0 means all available cores).
+ * @return Whether the file was parsed.
+ */
+template<typename eT>
+bool LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool csv,
+              const bool transpose,
+              const size_t threads = 1);
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "load_text_impl.hpp"
+
+#endif
@@ -0,0 +1,479 @@
+/**
+ * @file load_text_impl.hpp
+ *
+ * Implementation of the fast, multithreaded CSV and raw ASCII parser.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_LOAD_TEXT_IMPL_HPP
+#define __MLPACK_CORE_DATA_LOAD_TEXT_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "load_text.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+//! The portion of a text file parsed by one thread.
+struct TextChunk
+{
+  //! The first character of the chunk (the start of a line).
+  const char* begin;
+  //! One past the last character of the chunk.
+  const char* end;
+  //! The number of lines in the chunk, up to the first empty line.
+  size_t lines;
+  //! The smallest number of values on one of those lines.
+  size_t minValues;
+  //! The largest number of values on one of those lines.
+  size_t maxValues;
+  //! Whether the chunk contains an empty line (which ends the data).
+  bool emptyLine;
+  //! Whether a value could not be parsed.
+  bool failed;
+};
+
+//! Whether the character separates raw ASCII values.
+inline bool IsTextSpace(const char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') ||
+      (c == '\f');
+}
+
+//! Return the end of the line starting at begin (without the newline and any
+//! carriage return).  next is set to the start of the following line.
+inline const char* TextLineEnd(const char* begin,
+                               const char* end,
+                               const char*& next)
+{
+  const char* lineEnd = (const char*) memchr(begin, '\n', end - begin);
+  if (lineEnd == NULL)
+  {
+    lineEnd = end;
+    next = end;
+  }
+  else
+  {
+    next = lineEnd + 1;
+  }
+
+  if ((lineEnd != begin) && (*(lineEnd - 1) == '\r'))
+    --lineEnd;
+
+  return lineEnd;
+}
+
+//! Count the values on the line [begin, end).
+inline size_t CountTextValues(const char* begin,
+                              const char* end,
+                              const bool csv)
+{
+  size_t values = 0;
+  if (csv)
+  {
+    values = 1;
+    for (const char* c = begin; c != end; ++c)
+      if (*c == ',')
+        ++values;
+  }
+  else
+  {
+    bool inValue = false;
+    for (const char* c = begin; c != end; ++c)
+    {
+      const bool space = IsTextSpace(*c);
+      if (!space && !inValue)
+        ++values;
+      inValue = !space;
+    }
+  }
+
+  return values;
+}
+
+//! Parse the number [begin, end) with strtod(), failing unless all of it is
+//! used.
+inline bool ParseTextNumberSlow(const char* begin,
+                                const char* end,
+                                double& value)
+{
+  const std::string token(begin, end);
+  char* parsedEnd;
+  value = strtod(token.c_str(), &parsedEnd);
+  return (!token.empty() && (parsedEnd == token.c_str() + token.size()));
+}
+
+/**
+ * Parse the number [begin, end).  Decimal numbers with at most 15 significant
+ * digits whose exponent (after moving the decimal point to the end) is at most
+ * 22 in magnitude are computed directly with one exactly rounded
+ * multiplication or division, since both operands are exact doubles; anything
+ * else (long mantissas, large exponents, "nan", "inf", ...) is handed to
+ * strtod().  Either way the result is the correctly rounded value.
+ */
+inline bool ParseTextNumber(const char* begin, const char* end, double& value)
+{
+  static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+      1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+
+  const char* c = begin;
+  bool negative = false;
+  if ((c != end) && ((*c == '-') || (*c == '+')))
+  {
+    negative = (*c == '-');
+    ++c;
+  }
+
+  uint64_t mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  for (; (c != end) && (*c >= '0') && (*c <= '9'); ++c)
+  {
+    mantissa = 10 * mantissa + (*c - '0');
+    if (mantissa != 0)
+      ++significantDigits;
+    anyDigits = true;
+    if (significantDigits > 15)
+      return ParseTextNumberSlow(begin, end, value);
+  }
+
+  if ((c != end) && (*c == '.'))
+  {
+    for (++c; (c != end) && (*c >= '0') && (*c <= '9'); ++c)
+    {
+      mantissa = 10 * mantissa + (*c - '0');
+      if (mantissa != 0)
+        ++significantDigits;
+      --exponent;
+      anyDigits = true;
+      if (significantDigits > 15)
+        return ParseTextNumberSlow(begin, end, value);
+    }
+  }
+
+  if (!anyDigits)
+    return ParseTextNumberSlow(begin, end, value);
+
+  if ((c != end) && ((*c == 'e') || (*c == 'E')))
+  {
+    ++c;
+    bool negativeExponent = false;
+    if ((c != end) && ((*c == '-') || (*c == '+')))
+    {
+      negativeExponent = (*c == '-');
+      ++c;
+    }
+
+    if ((c == end) || (*c < '0') || (*c > '9'))
+      return false;
+
+    int explicitExponent = 0;
+    for (; (c != end) && (*c >= '0') && (*c <= '9'); ++c)
+    {
+      explicitExponent = 10 * explicitExponent + (*c - '0');
+      if (explicitExponent > 1000)
+        return ParseTextNumberSlow(begin, end, value);
+    }
+
+    exponent += (negativeExponent ? -explicitExponent : explicitExponent);
+  }
+
+  if (c != end)
+    return false;
+
+  if (mantissa == 0)
+    value = 0.0;
+  else if ((exponent >= 0) && (exponent <= 22))
+    value = ((double) mantissa) * powersOfTen[exponent];
+  else if ((exponent < 0) && (exponent >= -22))
+    value = ((double) mantissa) / powersOfTen[-exponent];
+  else
+    return ParseTextNumberSlow(begin, end, value);
+
+  if (negative)
+    value = -value;
+
+  return true;
+}
+
+//! Parse and store the values of the line [begin, end), missing values
+//! (which can only happen for CSV files) being zero.
+template<typename eT>
+bool ParseTextLine(const char* begin,
+                   const char* end,
+                   const bool csv,
+                   const size_t values,
+                   eT* out,
+                   const size_t stride)
+{
+  size_t value = 0;
+  const char* c = begin;
+  double parsed;
+  if (csv)
+  {
+    while (true)
+    {
+      const char* tokenEnd = (const char*) memchr(c, ',', end - c);
+      if (tokenEnd == NULL)
+        tokenEnd = end;
+
+      // Surrounding whitespace is ignored, and an empty value is zero.
+      const char* tokenBegin = c;
+      while ((tokenBegin != tokenEnd) && IsTextSpace(*tokenBegin))
+        ++tokenBegin;
+      const char* trimmedEnd = tokenEnd;
+      while ((trimmedEnd != tokenBegin) && IsTextSpace(*(trimmedEnd - 1)))
+        --trimmedEnd;
+
+      if (tokenBegin == trimmedEnd)
+        parsed = 0.0;
+      else if (!ParseTextNumber(tokenBegin, trimmedEnd, parsed))
+        return false;
+
+      out[value * stride] = (eT) parsed;
+      ++value;
+
+      if (tokenEnd == end)
+        break;
+      c = tokenEnd + 1;
+    }
+  }
+  else
+  {
+    while (true)
+    {
+      while ((c != end) && IsTextSpace(*c))
+        ++c;
+      if (c == end)
+        break;
+
+      const char* tokenEnd = c;
+      while ((tokenEnd != end) && !IsTextSpace(*tokenEnd))
+        ++tokenEnd;
+
+      if (!ParseTextNumber(c, tokenEnd, parsed))
+        return false;
+
+      out[value * stride] = (eT) parsed;
+      ++value;
+      c = tokenEnd;
+    }
+  }
+
+  for (; value < values; ++value)
+    out[value * stride] = eT(0);
+
+  return true;
+}
+
+template<typename eT>
+bool LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool csv,
+              const bool transpose,
+              const size_t threads)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  const size_t bufferSize = (size_t) fileStat.st_size;
+
+  // Map the file read-only; the pages are read from disk by the threads that
+  // parse them.
+  void* map = (bufferSize == 0) ? MAP_FAILED : mmap(NULL, bufferSize,
+      PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  const char* buffer = (const char*) map;
+
+  size_t numThreads = Threads::Count(threads);
+
+  // Give each thread at least 64kB, and start each chunk on a new line.
+  const size_t minChunkSize = 65536;
+  size_t numChunks = std::min(numThreads, bufferSize / minChunkSize);
+  if (numChunks == 0)
+    numChunks = 1;
+
+  std::vector<TextChunk> chunks(numChunks);
+  for (size_t i = 0; i < numChunks; ++i)
+  {
+    const char* begin = (i == 0) ? buffer : chunks[i - 1].end;
+    const char* end = buffer + ((i + 1) * bufferSize) / numChunks;
+    if (end < begin)
+      end = begin;
+    if (i == numChunks - 1)
+    {
+      end = buffer + bufferSize;
+    }
+    else if (end != buffer + bufferSize)
+    {
+      const char* newline = (const char*) memchr(end, '\n',
+          buffer + bufferSize - end);
+      end = (newline == NULL) ? buffer + bufferSize : newline + 1;
+    }
+
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    chunks[i].lines = 0;
+    chunks[i].minValues = 0;
+    chunks[i].maxValues = 0;
+    chunks[i].emptyLine = false;
+    chunks[i].failed = false;
+  }
+
+  // First pass: count the lines and the values on each line.
+  #pragma omp parallel for num_threads(numThreads) schedule(static, 1)
+  for (int i = 0; i < (int) numChunks; ++i)
+  {
+    TextChunk& chunk = chunks[i];
+    const char* line = chunk.begin;
+    while (line != chunk.end)
+    {
+      const char* next;
+      const char* lineEnd = TextLineEnd(line, chunk.end, next);
+      if (lineEnd == line)
+      {
+        chunk.emptyLine = true;
+        break;
+      }
+
+      const size_t values = CountTextValues(line, lineEnd, csv);
+      if ((chunk.lines == 0) || (values < chunk.minValues))
+        chunk.minValues = values;
+      if (values > chunk.maxValues)
+        chunk.maxValues = values;
+      ++chunk.lines;
+
+      line = next;
+    }
+  }
+
+  // The data ends at the first empty line.
+  size_t usedChunks = 0;
+  size_t rows = 0;
+  size_t minValues = 0;
+  size_t maxValues = 0;
+  std::vector<size_t> firstRow(numChunks);
+  for (size_t i = 0; i < numChunks; ++i)
+  {
+    firstRow[i] = rows;
+    if (chunks[i].lines > 0)
+    {
+      if ((rows == 0) || (chunks[i].minValues < minValues))
+        minValues = chunks[i].minValues;
+      if (chunks[i].maxValues > maxValues)
+        maxValues = chunks[i].maxValues;
+    }
+    rows += chunks[i].lines;
+    ++usedChunks;
+
+    if (chunks[i].emptyLine)
+      break;
+  }
+
+  if ((rows == 0) || (maxValues == 0) || (!csv && (minValues != maxValues)))
+  {
+    munmap(map, bufferSize);
+    return false;
+  }
+
+  const size_t cols = maxValues;
+  if (transpose)
+    matrix.set_size(cols, rows);
+  else
+    matrix.set_size(rows, cols);
+
+  // Second pass: parse each line straight into its place in the matrix.  When
+  // transposing, the values of a line are contiguous.
+  eT* memory = matrix.memptr();
+  const size_t valueStride = transpose ? 1 : rows;
+  const size_t lineStride = transpose ? cols : 1;
+  #pragma omp parallel for num_threads(numThreads) schedule(static, 1)
+  for (int i = 0; i < (int) usedChunks; ++i)
+  {
+    TextChunk& chunk = chunks[i];
+    const char* line = chunk.begin;
+    for (size_t j = 0; j < chunk.lines; ++j)
+    {
+      const char* next;
+      const char* lineEnd = TextLineEnd(line, chunk.end, next);
+      if (!ParseTextLine(line, lineEnd, csv, cols,
+          memory + (firstRow[i] + j) * lineStride, valueStride))
+      {
+        chunk.failed = true;
+        break;
+      }
+
+      line = next;
+    }
+  }
+
+  munmap(map, bufferSize);
+
+  for (size_t i = 0; i < usedChunks; ++i)
+  {
+    if (chunks[i].failed)
+    {
+      matrix.reset();
+      return false;
+    }
+  }
+
+  return true;
+#else
+  // Without mmap(), Armadillo's parser is used.
+  (void) filename;
+  (void) matrix;
+  (void) csv;
+  (void) transpose;
+  (void) threads;
+  return false;
+#endif
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
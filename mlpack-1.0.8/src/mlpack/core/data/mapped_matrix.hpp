@@ -0,0 +1,172 @@
+/**
+ * @file mapped_matrix.hpp
+ *
+ * A matrix stored in the mlpack binary format (.mbin), which can be
+ * memory-mapped instead of read.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+#define __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <ostream>
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A matrix which is loaded from a file and, if the file is in the mlpack
+ * binary format (denoted by .mbin), memory-mapped instead of being read: the
+ * matrix refers directly to the pages of the file, so a multi-gigabyte dataset
+ * is usable at once, is only read from disk as it is used, and is shared
+ * through the page cache by every process that maps it.  Files in any other
+ * format are loaded with data::Load().
+ *
+ * The matrix may be modified; the modified pages are copied (copy-on-write),
+ * so the file itself is never changed.
+ *
+ * @code
+ * // Convert a dataset once.
+ * arma::mat dataset;
+ * data::Load("reference.csv", dataset, true);
+ * data::Save("reference.mbin", dataset, true);
+ *
+ * // Later, map it.
+ * data::MappedMatrix<double> reference("reference.mbin");
+ * const arma::mat& referenceData = reference.Matrix();
+ * @endcode
+ *
+ * The file stores, in host byte order: an 8-byte magic string; a header of
+ * 64-bit unsigned integers (the format version, the type and size of the
+ * elements, the number of rows and columns, the alignment of the data, and
+ * the offset of the data); and then the elements of the matrix in
+ * column-major order, starting at an offset that is a multiple of the
+ * alignment.  Like the other formats of data::Load() and data::Save(), a
+ * matrix is transposed when it is saved and loaded; since the file stores the
+ * transposed matrix in row-major order (one point after another), that is the
+ * layout of the loaded matrix and no transposition is done.
+ *
+ * @tparam eT Type of the elements of the matrix; it must match the type the
+ *     file was saved with.
+ */
+template<typename eT>
+class MappedMatrix
+{
+ public:
+  //! Create an empty matrix.
+  MappedMatrix();
+
+  /**
+   * Load the matrix from the given file, mapping it if it is in the mlpack
+   * binary format.  If the file cannot be loaded, a fatal error is given.
+   *
+   * @param filename Name of file to load.
+   */
+  MappedMatrix(const std::string& filename);
+
+  //! Unmap the file, if it was mapped.
+  ~MappedMatrix();
+
+  /**
+   * Load the matrix from the given file, mapping it if it is in the mlpack
+   * binary format (.mbin) and loading it with data::Load() otherwise.  Any
+   * matrix loaded before (and any reference to it) is no longer valid.
+   *
+   * @param filename Name of file to load.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @return Boolean value indicating success or failure of load.
+   */
+  bool Load(const std::string& filename, const bool fatal = false);
+
+  /**
+   * Save the given matrix in the mlpack binary format, as it is (without
+   * transposing it).  data::Save() uses this for .mbin files.
+   *
+   * @param filename Name of file to save to.
+   * @param matrix Matrix to save.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @return Boolean value indicating success or failure of save.
+   */
+  static bool Save(const std::string& filename,
+                   const arma::Mat<eT>& matrix,
+                   const bool fatal = false);
+
+  /**
+   * Write the magic string and the header of a file in the mlpack binary
+   * format for a matrix of the given size, followed by the padding up to the
+   * data; the elements are to be written next, in column-major order.  Writing
+   * the header again over the start of the file changes the size (this is how
+   * ChunkWriter sets the number of columns once they are all written).
+   *
+   * @param stream Stream to write to.
+   * @param rows Number of rows of the matrix.
+   * @param cols Number of columns of the matrix.
+   */
+  static void WriteHeader(std::ostream& stream,
+                          const size_t rows,
+                          const size_t cols);
+
+  //! Get the matrix.
+  const arma::Mat<eT>& Matrix() const { return *matrix; }
+  //! Modify the matrix.
+  arma::Mat<eT>& Matrix() { return *matrix; }
+
+  //! Return whether the matrix refers to a memory-mapped file.
+  bool Mapped() const { return mapped; }
+
+ private:
+  //! The matrix; if the file is mapped, it refers to the mapped memory.
+  arma::Mat<eT>* matrix;
+  //! The contents of the file in the mlpack binary format, if any were loaded.
+  char* buffer;
+  //! The size of the buffer, in bytes.
+  size_t bufferSize;
+  //! Whether the buffer is memory-mapped (otherwise it was allocated).
+  bool mapped;
+
+  //! Load a file in the mlpack binary format.
+  bool LoadBinary(const std::string& filename, const bool fatal);
+
+  //! Release the matrix and the buffer.
+  void Release();
+
+  //! Print the given error (as a fatal error, if requested) and return false.
+  static bool Error(const std::string& message, const bool fatal);
+
+  //! The type code of eT stored in the header.
+  static size_t ElementType();
+
+  //! A MappedMatrix cannot be copied.
+  MappedMatrix(const MappedMatrix& other);
+  //! A MappedMatrix cannot be copied.
+  MappedMatrix& operator=(const MappedMatrix& other);
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// data::Load() uses MappedMatrix for .mbin files and MappedMatrix uses
+// data::Load() for everything else; MappedMatrix is declared, so data::Load()
+// can be defined before the implementation here.
+#include "load.hpp"
+
+// Include implementation.
+#include "mapped_matrix_impl.hpp"
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file mapped_matrix_impl.hpp
+ *
+ * Implementation of MappedMatrix, which memory-maps matrices stored in the
+ * mlpack binary format.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_MAPPED_MATRIX_IMPL_HPP
+#define __MLPACK_CORE_DATA_MAPPED_MATRIX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mapped_matrix.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdint.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+// Layout of the header: an 8-byte magic string followed by these fields, each
+// a 64-bit unsigned integer.
+enum MappedMatrixHeaderField
+{
+  MAPPED_MATRIX_VERSION = 0,
+  MAPPED_MATRIX_ELEMENT_TYPE,
+  MAPPED_MATRIX_ELEMENT_SIZE,
+  MAPPED_MATRIX_ROWS,
+  MAPPED_MATRIX_COLS,
+  MAPPED_MATRIX_ALIGNMENT,
+  MAPPED_MATRIX_DATA_OFFSET,
+  MAPPED_MATRIX_HEADER_FIELDS
+};
+
+static const char mappedMatrixMagic[8] = { 'M', 'L', 'P', 'K', 'M', 'B', 'I',
+    'N' };
+
+// The data starts at a multiple of this many bytes (a cache line), so that it
+// is aligned for vector instructions.
+static const size_t mappedMatrixAlignment = 64;
+
+template<typename eT>
+MappedMatrix<eT>::MappedMatrix() :
+    matrix(new arma::Mat<eT>()),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+  // Nothing to do.
+}
+
+template<typename eT>
+MappedMatrix<eT>::MappedMatrix(const std::string& filename) :
+    matrix(new arma::Mat<eT>()),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+  Load(filename, true);
+}
+
+template<typename eT>
+MappedMatrix<eT>::~MappedMatrix()
+{
+  Release();
+  delete matrix;
+}
+
+template<typename eT>
+bool MappedMatrix<eT>::Load(const std::string& filename, const bool fatal)
+{
+  Release();
+  matrix = new arma::Mat<eT>();
+
+  // Anything that is not in the mlpack binary format is loaded normally.
+  const size_t ext = filename.rfind('.');
+  std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  if (extension != "mbin")
+    return data::Load(filename, *matrix, fatal);
+
+  const bool success = LoadBinary(filename, fatal);
+  if (!success)
+  {
+    Release();
+    matrix = new arma::Mat<eT>();
+  }
+
+  return success;
+}
+
+template<typename eT>
+bool MappedMatrix<eT>::LoadBinary(const std::string& filename,
+                                  const bool fatal)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return Error("Cannot open file '" + filename + "'.", fatal);
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    return Error("Cannot read size of file '" + filename + "'.", fatal);
+  }
+  bufferSize = (size_t) fileStat.st_size;
+
+  // Map the file privately: nothing is read from disk until it is used, and
+  // writes to the matrix are never written back to the file.
+  void* map = (bufferSize == 0) ? MAP_FAILED : mmap(NULL, bufferSize,
+      PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    bufferSize = 0;
+    return Error("Cannot map file '" + filename + "'.", fatal);
+  }
+
+  buffer = (char*) map;
+  mapped = true;
+#else
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+  if (!stream.is_open())
+    return Error("Cannot open file '" + filename + "'.", fatal);
+
+  bufferSize = (size_t) stream.tellg();
+  buffer = new char[bufferSize];
+  stream.seekg(0);
+  stream.read(buffer, bufferSize);
+  if (!stream.good())
+    return Error("Cannot read file '" + filename + "'.", fatal);
+#endif
+
+  // Check the header.
+  const size_t headerSize = sizeof(mappedMatrixMagic) +
+      MAPPED_MATRIX_HEADER_FIELDS * sizeof(uint64_t);
+  if ((bufferSize < headerSize) ||
+      (memcmp(buffer, mappedMatrixMagic, sizeof(mappedMatrixMagic)) != 0))
+    return Error("'" + filename + "' is not in the mlpack binary format.",
+        fatal);
+
+  uint64_t header[MAPPED_MATRIX_HEADER_FIELDS];
+  memcpy(header, buffer + sizeof(mappedMatrixMagic), sizeof(header));
+
+  if (header[MAPPED_MATRIX_VERSION] != 1)
+  {
+    std::ostringstream message;
+    message << "Unsupported mlpack binary format version "
+        << header[MAPPED_MATRIX_VERSION] << " in '" << filename << "'.";
+    return Error(message.str(), fatal);
+  }
+
+  if ((header[MAPPED_MATRIX_ELEMENT_TYPE] != ElementType()) ||
+      (header[MAPPED_MATRIX_ELEMENT_SIZE] != sizeof(eT)))
+    return Error("The elements of '" + filename + "' are not of the requested "
+        "type.", fatal);
+
+  const size_t rows = (size_t) header[MAPPED_MATRIX_ROWS];
+  const size_t cols = (size_t) header[MAPPED_MATRIX_COLS];
+  const size_t alignment = (size_t) header[MAPPED_MATRIX_ALIGNMENT];
+  const size_t dataOffset = (size_t) header[MAPPED_MATRIX_DATA_OFFSET];
+
+  if ((alignment == 0) || (dataOffset % alignment != 0) ||
+      (dataOffset % sizeof(eT) != 0) || (dataOffset < headerSize) ||
+      (cols != 0 && rows > (bufferSize / sizeof(eT)) / cols) ||
+      (bufferSize < dataOffset + rows * cols * sizeof(eT)))
+    return Error("'" + filename + "' is corrupt.", fatal);
+
+  // The matrix refers directly to the contents of the file.
+  delete matrix;
+  if (rows * cols == 0)
+    matrix = new arma::Mat<eT>(rows, cols);
+  else
+    matrix = new arma::Mat<eT>((eT*) (buffer + dataOffset), rows, cols, false,
+        true);
+
+  return true;
+}
+
+template<typename eT>
+bool MappedMatrix<eT>::Save(const std::string& filename,
+                            const arma::Mat<eT>& matrix,
+                            const bool fatal)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return Error("Cannot open file '" + filename + "' for writing.", fatal);
+
+  WriteHeader(stream, matrix.n_rows, matrix.n_cols);
+  stream.write((const char*) matrix.memptr(), matrix.n_elem * sizeof(eT));
+
+  if (!stream.good())
+    return Error("Cannot write to file '" + filename + "'.", fatal);
+
+  return true;
+}
+
+template<typename eT>
+void MappedMatrix<eT>::WriteHeader(std::ostream& stream,
+                                   const size_t rows,
+                                   const size_t cols)
+{
+  const size_t headerSize = sizeof(mappedMatrixMagic) +
+      MAPPED_MATRIX_HEADER_FIELDS * sizeof(uint64_t);
+  const size_t dataOffset = ((headerSize + mappedMatrixAlignment - 1) /
+      mappedMatrixAlignment) * mappedMatrixAlignment;
+
+  uint64_t header[MAPPED_MATRIX_HEADER_FIELDS];
+  header[MAPPED_MATRIX_VERSION] = 1;
+  header[MAPPED_MATRIX_ELEMENT_TYPE] = ElementType();
+  header[MAPPED_MATRIX_ELEMENT_SIZE] = sizeof(eT);
+  header[MAPPED_MATRIX_ROWS] = rows;
+  header[MAPPED_MATRIX_COLS] = cols;
+  header[MAPPED_MATRIX_ALIGNMENT] = mappedMatrixAlignment;
+  header[MAPPED_MATRIX_DATA_OFFSET] = dataOffset;
+
+  stream.write(mappedMatrixMagic, sizeof(mappedMatrixMagic));
+  stream.write((const char*) header, sizeof(header));
+  for (size_t i = headerSize; i < dataOffset; ++i)
+    stream.put('\0');
+}
+
+template<typename eT>
+void MappedMatrix<eT>::Release()
+{
+  // The matrix may refer to the buffer, so it goes first.
+  delete matrix;
+  matrix = NULL;
+
+#ifndef _WIN32
+  if (mapped)
+    munmap(buffer, bufferSize);
+  else
+    delete[] buffer;
+#else
+  delete[] buffer;
+#endif
+
+  buffer = NULL;
+  bufferSize = 0;
+  mapped = false;
+}
+
+template<typename eT>
+bool MappedMatrix<eT>::Error(const std::string& message, const bool fatal)
+{
+  if (fatal)
+    Log::Fatal << message << std::endl;
+  else
+    Log::Warn << message << std::endl;
+
+  return false;
+}
+
+template<typename eT>
+size_t MappedMatrix<eT>::ElementType()
+{
+  // Floating-point types are 0, signed integers 1, and unsigned integers 2; the
+  // size distinguishes the rest.
+  const size_t kind = !std::numeric_limits<eT>::is_integer ? 0 :
+      (std::numeric_limits<eT>::is_signed ? 1 : 2);
+
+  return 256 * kind + sizeof(eT);
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
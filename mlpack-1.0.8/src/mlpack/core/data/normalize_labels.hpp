@@ -25,15 +25,97 @@
 #define __MLPACK_CORE_DATA_NORMALIZE_LABELS_HPP
 
 #include <mlpack/core.hpp>
+#include <boost/unordered_map.hpp>
 
 namespace mlpack {
 namespace data {
 
+/**
+ * A mapping from labels of a particular datatype to unsigned labels in the
+ * range [0, n), where n is the number of different labels seen so far.  The
+ * labels are looked up in a hash table, so normalizing m labels takes O(m)
+ * time regardless of the number of different labels.  The same mapping can be
+ * applied to several batches of labels: labels seen before keep their value,
+ * and new labels are given the next unused values.
+ *
+ * @code
+ * data::LabelMapping<int> mapping;
+ * arma::Col<size_t> trainLabels, testLabels;
+ * mapping.Normalize(rawTrainLabels, trainLabels);
+ * mapping.Normalize(rawTestLabels, testLabels); // Same values for same labels.
+ * @endcode
+ *
+ * @tparam eT Type of the original labels.
+ */
+template<typename eT>
+class LabelMapping
+{
+ public:
+  //! Create an empty mapping.
+  LabelMapping() { }
+
+  /**
+   * Create a mapping from a reverse mapping (as given by NormalizeLabels()),
+   * so that label mapping[i] is normalized to i.
+   *
+   * @param mapping Reverse mapping from normalized labels to original labels.
+   */
+  LabelMapping(const arma::Col<eT>& mapping);
+
+  /**
+   * Normalize the given labels, adding any labels not seen before to the
+   * mapping.
+   *
+   * @param labelsIn Input labels of arbitrary datatype.
+   * @param labels Vector that unsigned labels will be stored in.
+   */
+  void Normalize(const arma::Col<eT>& labelsIn, arma::Col<size_t>& labels);
+
+  /**
+   * Normalize one label, adding it to the mapping if it has not been seen
+   * before.
+   *
+   * @param label Label to normalize.
+   * @return Normalized label.
+   */
+  size_t Normalize(const eT label);
+
+  /**
+   * Map the given normalized labels back to the original labels.
+   *
+   * @param labels Set of normalized labels to convert.
+   * @param labelsOut Vector to store original labels in.
+   */
+  void Revert(const arma::Col<size_t>& labels, arma::Col<eT>& labelsOut)
+      const;
+
+  //! Get the number of different labels.
+  size_t NumLabels() const { return values.size(); }
+
+  //! Get the original label of the given normalized label.
+  const eT& Value(const size_t label) const { return values[label]; }
+
+  /**
+   * Store the reverse mapping from normalized labels to original labels in the
+   * given vector (as given by NormalizeLabels()).
+   *
+   * @param mapping Vector to store reverse mapping in.
+   */
+  void Mapping(arma::Col<eT>& mapping) const;
+
+ private:
+  //! The normalized label of each original label.
+  boost::unordered_map<eT, size_t> labelMap;
+  //! The original label of each normalized label.
+  std::vector<eT> values;
+};
+
 /**
  * Given a set of labels of a particular datatype, convert them to unsigned
  * labels in the range [0, n) where n is the number of different labels.  Also,
  * a reverse mapping from the new label to the old value is stored in the
- * 'mapping' vector.
+ * 'mapping' vector.  The labels are numbered in the order they first appear.
+ * To apply the same normalization to other sets of labels, use LabelMapping.
  *
  * @param labelsIn Input labels of arbitrary datatype.
  * @param labels Vector that unsigned labels will be stored in.
@@ -28,6 +28,52 @@
 namespace mlpack {
 namespace data {
 
+template<typename eT>
+LabelMapping<eT>::LabelMapping(const arma::Col<eT>& mapping)
+{
+  for (size_t i = 0; i < mapping.n_elem; ++i)
+    Normalize(mapping[i]);
+}
+
+template<typename eT>
+size_t LabelMapping<eT>::Normalize(const eT label)
+{
+  // Is the label already in the list of labels we have seen?  If not, it gets
+  // the next label.
+  std::pair<typename boost::unordered_map<eT, size_t>::iterator, bool> result =
+      labelMap.insert(std::make_pair(label, values.size()));
+  if (result.second)
+    values.push_back(label);
+
+  return (*result.first).second;
+}
+
+template<typename eT>
+void LabelMapping<eT>::Normalize(const arma::Col<eT>& labelsIn,
+                                 arma::Col<size_t>& labels)
+{
+  labels.set_size(labelsIn.n_elem);
+  for (size_t i = 0; i < labelsIn.n_elem; ++i)
+    labels[i] = Normalize(labelsIn[i]);
+}
+
+template<typename eT>
+void LabelMapping<eT>::Revert(const arma::Col<size_t>& labels,
+                              arma::Col<eT>& labelsOut) const
+{
+  labelsOut.set_size(labels.n_elem);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    labelsOut[i] = values[labels[i]];
+}
+
+template<typename eT>
+void LabelMapping<eT>::Mapping(arma::Col<eT>& mapping) const
+{
+  mapping.set_size(values.size());
+  for (size_t i = 0; i < values.size(); ++i)
+    mapping[i] = values[i];
+}
+
 /**
  * Given a set of labels of a particular datatype, convert them to unsigned
  * labels in the range [0, n) where n is the number of different labels.  Also,
@@ -43,37 +89,11 @@ void NormalizeLabels(const arma::Col<eT>& labelsIn,
                      arma::Col<size_t>& labels,
                      arma::Col<eT>& mapping)
 {
-  // Loop over the input labels, and develop the mapping.  We'll first naively
-  // resize the mapping to the maximum possible size, and then when we fill it,
-  // we'll resize it back down to its actual size.
-  mapping.set_size(labelsIn.n_elem);
-  labels.set_size(labelsIn.n_elem);
-  size_t curLabel = 0;
-  for (size_t i = 0; i < labelsIn.n_elem; ++i)
-  {
-    bool found = false;
-    for (size_t j = 0; j < curLabel; ++j)
-    {
-      // Is the label already in the list of labels we have seen?
-      if (labelsIn[i] == mapping[j])
-      {
-        labels[i] = j;
-        found = true;
-        break;
-      }
-    }
-
-    // Do we need to add this new label?
-    if (!found)
-    {
-      mapping[curLabel] = labelsIn[i];
-      labels[i] = curLabel;
-      ++curLabel;
-    }
-  }
-
-  // Resize mapping back down to necessary size.
-  mapping.resize(curLabel);
+  // Look each label up in a hash table, instead of in the list of labels seen
+  // so far.
+  LabelMapping<eT> labelMapping;
+  labelMapping.Normalize(labelsIn, labels);
+  labelMapping.Mapping(mapping);
 }
 
 /**
@@ -46,6 +46,7 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5 (hdf5_binary), denoted by .hdf5, .hdf, .h5, or .he5
+ *  - mlpack binary, denoted by .mbin (see MappedMatrix)
  *
  * If the file extension is not one of those types, an error will be given.  If
  * the 'fatal' parameter is set to true, an error will cause the program to
@@ -54,16 +55,63 @@ namespace data /** Functions to load and save matrices. */ {
  * column-major format and most datasets are stored on disk as row-major, this
  * parameter should be left at its default value of 'true'.
  *
+ * CSV and raw ASCII files are written by SaveText(), which formats the matrix
+ * in parallel with the given number of threads and writes it on one more
+ * thread at the same time; each value is written with as many digits as it
+ * needs to be loaded back exactly.  For large outputs (such as the neighbors
+ * found by allknn), the binary formats are much faster still.
+ *
  * @param filename Name of file to save to.
  * @param matrix Matrix to save into file.
  * @param fatal If an error should be reported as fatal (default false).
  * @param transpose If true, transpose the matrix before saving.
+ * @param threads Number of threads to format CSV and raw ASCII files with (0
+ *     means all available cores).
  * @return Boolean value indicating success or failure of save.
  */
 template<typename eT>
 bool Save(const std::string& filename,
           const arma::Mat<eT>& matrix,
           bool fatal = false,
+          bool transpose = true,
+          const size_t threads = 1);
+
+/**
+ * Saves a sparse matrix to file, guessing the format from the extension; the
+ * formats are those of the sparse data::Load(): coordinate lists (.csv or
+ * .txt), MatrixMarket (.mtx), and svmlight (.svm, .libsvm, or .svmlight; each
+ * point is given the label 0).  As with dense matrices, the matrix is
+ * transposed before saving by default, so that each point is a line (row) of
+ * the file.
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Sparse matrix to save into file.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix before saving.
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          bool fatal = false,
+          bool transpose = true);
+
+/**
+ * Saves a sparse matrix and the labels of its points to an svmlight (libsvm)
+ * file (.svm, .libsvm, or .svmlight).
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Sparse matrix to save into file.
+ * @param labels Label of each point.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix before saving.
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const arma::vec& labels,
+          bool fatal = false,
           bool transpose = true);
 
 }; // namespace data
@@ -71,5 +119,6 @@ bool Save(const std::string& filename,
 
 // Include implementation.
 #include "save_impl.hpp"
+#include "save_sparse_impl.hpp"
 
 #endif
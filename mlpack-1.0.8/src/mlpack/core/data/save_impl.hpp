@@ -24,6 +24,8 @@
 
 // In case it hasn't already been included.
 #include "save.hpp"
+#include "mapped_matrix.hpp"
+#include "save_text.hpp"
 
 namespace mlpack {
 namespace data {
@@ -32,7 +34,8 @@ template<typename eT>
 bool Save(const std::string& filename,
           const arma::Mat<eT>& matrix,
           bool fatal,
-          bool transpose)
+          bool transpose,
+          const size_t threads)
 {
   Timer::Start("saving_data");
 
@@ -71,6 +74,7 @@ bool Save(const std::string& filename,
   }
 
   bool unknownType = false;
+  bool mlpackBinary = false;
   arma::file_type saveType;
   std::string stringType;
 
@@ -89,6 +93,13 @@ bool Save(const std::string& filename,
     saveType = arma::arma_binary;
     stringType = "Armadillo binary formatted data";
   }
+  else if (extension == "mbin")
+  {
+    // Not an Armadillo format; saveType is not used.
+    mlpackBinary = true;
+    saveType = arma::raw_binary;
+    stringType = "mlpack binary formatted data";
+  }
   else if (extension == "pgm")
   {
     saveType = arma::pgm_binary;
@@ -136,8 +147,52 @@ bool Save(const std::string& filename,
   Log::Info << "Saving " << stringType << " to '" << filename << "'."
       << std::endl;
 
+  // The mlpack binary format stores the transposed matrix, so that it can be
+  // mapped without transposing it.
+  if (mlpackBinary)
+  {
+    stream.close();
+    bool success;
+    if (transpose)
+    {
+      success = MappedMatrix<eT>::Save(filename, matrix, false);
+    }
+    else
+    {
+      arma::Mat<eT> tmp = trans(matrix);
+      success = MappedMatrix<eT>::Save(filename, tmp, false);
+    }
+
+    if (!success)
+    {
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+      Timer::Stop("saving_data");
+      return false;
+    }
+  }
+  // CSV and raw ASCII files are formatted in parallel, straight from the
+  // untransposed matrix.
+  else if ((saveType == arma::csv_ascii) || (saveType == arma::raw_ascii))
+  {
+    stream.close();
+    if (!SaveText(filename, matrix, saveType == arma::csv_ascii, transpose,
+        threads))
+    {
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+      Timer::Stop("saving_data");
+      return false;
+    }
+  }
   // Transpose the matrix.
-  if (transpose)
+  else if (transpose)
   {
     arma::Mat<eT> tmp = trans(matrix);
 
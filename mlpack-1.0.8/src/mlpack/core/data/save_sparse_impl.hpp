@@ -0,0 +1,188 @@
+/**
+ * @file save_sparse_impl.hpp
+ *
+ * Implementation of data::Save() for sparse matrices, in coordinate,
+ * MatrixMarket, and svmlight (libsvm) formats.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_SAVE_SPARSE_IMPL_HPP
+#define __MLPACK_CORE_DATA_SAVE_SPARSE_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "save.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mlpack/core/util/timers.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! Save a sparse matrix, with the given labels if it is an svmlight file and
+//! labels is not NULL.
+template<typename eT>
+bool SaveSparse(const std::string& filename,
+                const arma::SpMat<eT>& matrix,
+                const arma::vec* labels,
+                const bool fatal,
+                const bool transpose)
+{
+  Timer::Start("saving_data");
+
+  const size_t ext = filename.rfind('.');
+  std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+      ::tolower);
+
+  const bool coordinate = (extension == "csv") || (extension == "txt");
+  const bool matrixMarket = (extension == "mtx");
+  const bool svmlight = (extension == "svm") || (extension == "libsvm") ||
+      (extension == "svmlight");
+
+  if (!coordinate && !matrixMarket && !svmlight)
+  {
+    if (fatal)
+      Log::Fatal << "Unable to determine sparse format to save to from "
+          << "filename '" << filename << "'.  Save failed." << std::endl;
+    else
+      Log::Warn << "Unable to determine sparse format to save to from "
+          << "filename '" << filename << "'.  Save failed." << std::endl;
+
+    Timer::Stop("saving_data");
+    return false;
+  }
+
+  // The points are the lines of the file; in svmlight files all the elements
+  // of a point are on its line, so the points must be the columns we iterate
+  // over.
+  const size_t points = transpose ? matrix.n_cols : matrix.n_rows;
+  if (svmlight && (labels != NULL) && (labels->n_elem != points))
+  {
+    if (fatal)
+      Log::Fatal << "There are " << labels->n_elem << " labels for " << points
+          << " points.  Save to '" << filename << "' failed." << std::endl;
+    else
+      Log::Warn << "There are " << labels->n_elem << " labels for " << points
+          << " points.  Save to '" << filename << "' failed." << std::endl;
+
+    Timer::Stop("saving_data");
+    return false;
+  }
+
+  std::ofstream stream(filename.c_str());
+  if (!stream.is_open())
+  {
+    if (fatal)
+      Log::Fatal << "Cannot open file '" << filename << "' for writing. "
+          << "Save failed." << std::endl;
+    else
+      Log::Warn << "Cannot open file '" << filename << "' for writing; save "
+          << "failed." << std::endl;
+
+    Timer::Stop("saving_data");
+    return false;
+  }
+
+  Log::Info << "Saving sparse data to '" << filename << "'." << std::endl;
+
+  // Enough digits that the values are read back exactly.
+  stream.precision(std::numeric_limits<eT>::digits10 + 2);
+
+  if (svmlight)
+  {
+    arma::SpMat<eT> transposed;
+    if (!transpose)
+      transposed = trans(matrix);
+    const arma::SpMat<eT>& pointMatrix = transpose ? matrix : transposed;
+    for (size_t p = 0; p < pointMatrix.n_cols; ++p)
+    {
+      stream << ((labels != NULL) ? (*labels)[p] : 0.0);
+      for (size_t i = pointMatrix.col_ptrs[p]; i < pointMatrix.col_ptrs[p + 1];
+          ++i)
+        stream << ' ' << (pointMatrix.row_indices[i] + 1) << ':'
+            << pointMatrix.values[i];
+      stream << '\n';
+    }
+  }
+  else
+  {
+    if (matrixMarket)
+    {
+      stream << "%%MatrixMarket matrix coordinate "
+          << (std::numeric_limits<eT>::is_integer ? "integer" : "real")
+          << " general\n";
+      stream << (transpose ? matrix.n_cols : matrix.n_rows) << ' '
+          << (transpose ? matrix.n_rows : matrix.n_cols) << ' '
+          << matrix.n_nonzero << '\n';
+    }
+
+    // MatrixMarket indices start at 1, coordinate list indices at 0.
+    const size_t base = matrixMarket ? 1 : 0;
+    const char separator = (extension == "csv") ? ',' : ' ';
+    for (size_t c = 0; c < matrix.n_cols; ++c)
+    {
+      for (size_t i = matrix.col_ptrs[c]; i < matrix.col_ptrs[c + 1]; ++i)
+      {
+        const size_t r = matrix.row_indices[i];
+        stream << ((transpose ? c : r) + base) << separator
+            << ((transpose ? r : c) + base) << separator << matrix.values[i]
+            << '\n';
+      }
+    }
+  }
+
+  if (!stream.good())
+  {
+    if (fatal)
+      Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+    else
+      Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+    Timer::Stop("saving_data");
+    return false;
+  }
+
+  Timer::Stop("saving_data");
+  return true;
+}
+
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          bool fatal,
+          bool transpose)
+{
+  return SaveSparse(filename, matrix, (const arma::vec*) NULL, fatal,
+      transpose);
+}
+
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::SpMat<eT>& matrix,
+          const arma::vec& labels,
+          bool fatal,
+          bool transpose)
+{
+  return SaveSparse(filename, matrix, &labels, fatal, transpose);
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
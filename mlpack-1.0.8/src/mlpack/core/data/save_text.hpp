@@ -0,0 +1,76 @@
+/**
+ * @file save_text.hpp
+ *
+ * Fast, parallel saving of CSV and raw ASCII files.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_SAVE_TEXT_HPP
+#define __MLPACK_CORE_DATA_SAVE_TEXT_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Append the text form of the given number to a string.  Integers (and
+ * floating-point values which are integers) are formatted directly; any other
+ * floating-point value is written with the fewest significant digits that read
+ * back as exactly the same value, so nothing is lost when the file is loaded.
+ *
+ * @param value Number to format.
+ * @param out String to append the number to.
+ */
+template<typename eT>
+void AppendTextNumber(const eT value, std::string& out);
+
+/**
+ * Save a matrix to a CSV (csv_ascii) or raw ASCII (raw_ascii) file.  The lines
+ * of the file are split into chunks which are formatted in parallel into
+ * buffers; while one group of chunks is formatted, the previous group is
+ * written to the file by one extra thread, so formatting and writing overlap.
+ * When the matrix is transposed (the default of data::Save()), each line is
+ * one contiguous column of the matrix.
+ *
+ * Each number is formatted by AppendTextNumber(), so the values are read back
+ * exactly by data::Load().
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Matrix to save.
+ * @param csv If true, the values are separated by commas; otherwise, by
+ *     spaces.
+ * @param transpose If true, each column of the matrix is a line of the file.
+ * @param threads Number of threads to format with (0 means all available
+ *     cores).
+ * @return Whether the file was written.
+ */
+template<typename eT>
+bool SaveText(const std::string& filename,
+              const arma::Mat<eT>& matrix,
+              const bool csv,
+              const bool transpose,
+              const size_t threads = 1);
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "save_text_impl.hpp"
+
+#endif
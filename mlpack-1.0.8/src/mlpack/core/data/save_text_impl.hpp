@@ -0,0 +1,197 @@
+/**
+ * @file save_text_impl.hpp
+ *
+ * Implementation of SaveText() and the number formatting it uses.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_SAVE_TEXT_IMPL_HPP
+#define __MLPACK_CORE_DATA_SAVE_TEXT_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "save_text.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+//! Append an integer, given by its magnitude and sign, to a string.
+inline void AppendTextInteger(uint64_t magnitude,
+                              const bool negative,
+                              std::string& out)
+{
+  char buffer[24];
+  char* begin = buffer + sizeof(buffer);
+  do
+  {
+    *(--begin) = (char) ('0' + (magnitude % 10));
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (negative)
+    *(--begin) = '-';
+
+  out.append(begin, buffer + sizeof(buffer));
+}
+
+template<typename eT>
+void AppendTextNumber(const eT value, std::string& out)
+{
+  if (std::numeric_limits<eT>::is_integer)
+  {
+    const int64_t signedValue = (int64_t) value;
+    const bool negative = std::numeric_limits<eT>::is_signed &&
+        (signedValue < 0);
+    AppendTextInteger(negative ? (uint64_t) 0 - (uint64_t) signedValue :
+        (uint64_t) value, negative, out);
+    return;
+  }
+
+  const double x = (double) value;
+  if (x != x)
+  {
+    out.append("nan");
+    return;
+  }
+  else if (std::fabs(x) > std::numeric_limits<double>::max())
+  {
+    out.append((x < 0) ? "-inf" : "inf");
+    return;
+  }
+  else if ((std::fabs(x) < 1e15) && (x == std::floor(x)))
+  {
+    // Whole numbers (such as labels and indices) need no digits after the
+    // point.
+    AppendTextInteger((uint64_t) std::fabs(x), x < 0, out);
+    return;
+  }
+
+  // Use the shortest precision that reads back as the same value; that is at
+  // most digits10 + 3 significant digits (17 for doubles, 9 for floats).
+  char buffer[32];
+  const int digits = std::numeric_limits<eT>::digits10;
+  for (int precision = digits; precision <= digits + 3; ++precision)
+  {
+    sprintf(buffer, "%.*g", precision, x);
+    if ((eT) strtod(buffer, NULL) == value)
+      break;
+  }
+  out.append(buffer);
+}
+
+//! Format the given lines of the file (columns of the matrix, if transposing)
+//! into a buffer.
+template<typename eT>
+void FormatTextLines(const arma::Mat<eT>& matrix,
+                     const bool csv,
+                     const bool transpose,
+                     const size_t firstLine,
+                     const size_t lines,
+                     std::string& out)
+{
+  // The buffer keeps its capacity between groups of chunks.
+  out.clear();
+
+  const size_t values = transpose ? matrix.n_rows : matrix.n_cols;
+  const char separator = csv ? ',' : ' ';
+  for (size_t line = firstLine; line < firstLine + lines; ++line)
+  {
+    for (size_t j = 0; j < values; ++j)
+    {
+      if (j > 0)
+        out.push_back(separator);
+      AppendTextNumber(transpose ? matrix(j, line) : matrix(line, j), out);
+    }
+    out.push_back('\n');
+  }
+}
+
+template<typename eT>
+bool SaveText(const std::string& filename,
+              const arma::Mat<eT>& matrix,
+              const bool csv,
+              const bool transpose,
+              const size_t threads)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return false;
+
+  size_t numThreads = Threads::Count(threads);
+
+  // Give each chunk about 16384 values, and each formatting thread a few
+  // chunks of every group.
+  const size_t lines = transpose ? matrix.n_cols : matrix.n_rows;
+  const size_t values = transpose ? matrix.n_rows : matrix.n_cols;
+  const size_t linesPerChunk = std::max((size_t) 1,
+      (size_t) 16384 / std::max(values, (size_t) 1));
+  const size_t chunksPerGroup = 4 * numThreads;
+  const size_t numChunks = (lines + linesPerChunk - 1) / linesPerChunk;
+  const size_t numGroups = (numChunks + chunksPerGroup - 1) / chunksPerGroup;
+
+  std::vector<std::string> formatted(chunksPerGroup);
+  std::vector<std::string> written(chunksPerGroup);
+  size_t writtenChunks = 0;
+
+  // Each group is formatted while the previous one is written; one more pass
+  // writes the last group.
+  for (size_t group = 0; group <= numGroups; ++group)
+  {
+    const size_t firstChunk = group * chunksPerGroup;
+    const size_t groupChunks = (group == numGroups) ? 0 :
+        std::min(chunksPerGroup, numChunks - firstChunk);
+
+    // The thread that writes joins the formatting once it is done.
+    #pragma omp parallel num_threads(numThreads + 1)
+    {
+      #pragma omp single nowait
+      {
+        for (size_t i = 0; i < writtenChunks; ++i)
+          stream.write(written[i].data(), written[i].size());
+      }
+
+      #pragma omp for schedule(dynamic, 1)
+      for (int i = 0; i < (int) groupChunks; ++i)
+      {
+        const size_t firstLine = (firstChunk + i) * linesPerChunk;
+        FormatTextLines(matrix, csv, transpose, firstLine,
+            std::min(linesPerChunk, lines - firstLine), formatted[i]);
+      }
+    }
+
+    formatted.swap(written);
+    writtenChunks = groupChunks;
+  }
+
+  return stream.good();
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
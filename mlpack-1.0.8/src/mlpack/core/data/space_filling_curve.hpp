@@ -0,0 +1,174 @@
+/**
+ * @file space_filling_curve.hpp
+ *
+ * Orderings of points along space-filling curves (the Morton or Z-order curve,
+ * and the Hilbert curve), which put points that are close in space close in
+ * memory.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_SPACE_FILLING_CURVE_HPP
+#define __MLPACK_CORE_DATA_SPACE_FILLING_CURVE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace data {
+
+//! The space-filling curves that points can be ordered along.
+enum CurveType
+{
+  //! The Morton (Z-order) curve, which interleaves the bits of the coordinates.
+  MortonCurve,
+  //! The Hilbert curve, whose consecutive cells are always neighbors.
+  HilbertCurve
+};
+
+/**
+ * A space-filling curve over a box: each point is mapped to a 64-bit key, its
+ * position along the curve, so that sorting points by key puts points that are
+ * close in space close to each other.  The box is divided into a grid of
+ * 2^Bits() cells in each of the first Dimensions() dimensions (at most 64), so
+ * that a key holds Bits() bits of each coordinate; points outside the box are
+ * clamped to it.
+ *
+ * For a Morton key, the bits of the coordinates are interleaved, from the most
+ * significant bit of each coordinate to the least; so the points of any cell
+ * of the grid at any level are contiguous in Morton order, and the points of
+ * the lower half of a cell in the dimension of Dimension(bit) come before the
+ * points of its upper half (BinarySpaceTree uses this to build a kd-tree from
+ * Morton-ordered points; see tree::BuildOptions::MortonOrder()).
+ *
+ * @code
+ * data::SpaceFillingCurve curve(dataset, data::HilbertCurve);
+ * const uint64_t key = curve.Key(dataset.unsafe_col(0));
+ * @endcode
+ */
+class SpaceFillingCurve
+{
+ public:
+  /**
+   * Create a curve over the bounding box of the given points.
+   *
+   * @param data Points (one per column) to make the curve for.
+   * @param curve Type of the curve.
+   */
+  template<typename eT>
+  SpaceFillingCurve(const arma::Mat<eT>& data,
+                    const CurveType curve = HilbertCurve);
+
+  /**
+   * Create a curve over the given box.
+   *
+   * @param lo Lower limit of each dimension of the box.
+   * @param hi Upper limit of each dimension of the box.
+   * @param curve Type of the curve.
+   */
+  SpaceFillingCurve(const arma::vec& lo,
+                    const arma::vec& hi,
+                    const CurveType curve = HilbertCurve);
+
+  /**
+   * Get the key of the given point (its position along the curve).
+   *
+   * @param point Point to get the key of.
+   */
+  template<typename VecType>
+  uint64_t Key(const VecType& point) const;
+
+  /**
+   * Get the dimension that the given bit of a Morton key (counted from the
+   * least significant bit) holds a bit of.
+   *
+   * @param bit Bit of the key, less than Dimensions() * Bits().
+   */
+  size_t Dimension(const size_t bit) const
+  { return dimensions - 1 - (bit % dimensions); }
+
+  //! Get the type of the curve.
+  CurveType Curve() const { return curve; }
+  //! Get the number of dimensions that the keys are made from.
+  size_t Dimensions() const { return dimensions; }
+  //! Get the number of bits of each coordinate in a key.
+  size_t Bits() const { return bits; }
+
+ private:
+  //! The type of the curve.
+  CurveType curve;
+  //! The number of dimensions that the keys are made from.
+  size_t dimensions;
+  //! The number of bits of each coordinate.
+  size_t bits;
+  //! The lower limit of each dimension.
+  arma::vec lo;
+  //! The number of cells per unit in each dimension.
+  arma::vec scale;
+
+  //! Set up the grid for the given box.
+  void Initialize(const arma::vec& boxLo, const arma::vec& boxHi);
+};
+
+/**
+ * Find the order of the given points along a space-filling curve over their
+ * bounding box.  oldFromNew[i] is the index of the point which is i'th along
+ * the curve, as for the mappings of BinarySpaceTree; ties are broken by index,
+ * so the order does not depend on anything but the points.
+ *
+ * @param data Points (one per column) to order.
+ * @param oldFromNew Set to the index of the point at each position.
+ * @param curve Type of the curve.
+ */
+template<typename eT>
+void SpaceFillingCurveOrder(const arma::Mat<eT>& data,
+                            std::vector<size_t>& oldFromNew,
+                            const CurveType curve = HilbertCurve);
+
+/**
+ * Reorder the columns of the given matrix, so that column i becomes the
+ * column oldFromNew[i] of the original matrix.
+ *
+ * @code
+ * std::vector<size_t> oldFromNew;
+ * data::SpaceFillingCurveOrder(dataset, oldFromNew, data::HilbertCurve);
+ * data::ReorderColumns(dataset, oldFromNew);
+ * // ... cluster dataset ...
+ * data::RestoreColumns(dataset, oldFromNew);
+ * @endcode
+ *
+ * @param data Matrix to reorder.
+ * @param oldFromNew Index of the original column of each new column.
+ */
+template<typename eT>
+void ReorderColumns(arma::Mat<eT>& data, const std::vector<size_t>& oldFromNew);
+
+/**
+ * Undo ReorderColumns(): put column i back at column oldFromNew[i].  This can
+ * also be used to map results that were computed for the reordered points (one
+ * per column, such as labels) back to the original order.
+ *
+ * @param data Matrix to restore the order of.
+ * @param oldFromNew Index of the original column of each column.
+ */
+template<typename eT>
+void RestoreColumns(arma::Mat<eT>& data, const std::vector<size_t>& oldFromNew);
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "space_filling_curve_impl.hpp"
+
+#endif
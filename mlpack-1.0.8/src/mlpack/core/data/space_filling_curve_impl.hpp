@@ -0,0 +1,178 @@
+/**
+ * @file space_filling_curve_impl.hpp
+ *
+ * Implementation of the space-filling curve orderings.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_DATA_SPACE_FILLING_CURVE_IMPL_HPP
+#define __MLPACK_CORE_DATA_SPACE_FILLING_CURVE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "space_filling_curve.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+SpaceFillingCurve::SpaceFillingCurve(const arma::Mat<eT>& data,
+                                     const CurveType curve) :
+    curve(curve)
+{
+  if (data.n_cols == 0)
+  {
+    Initialize(arma::zeros<arma::vec>(data.n_rows),
+        arma::zeros<arma::vec>(data.n_rows));
+    return;
+  }
+
+  Initialize(arma::conv_to<arma::vec>::from(arma::min(data, 1)),
+      arma::conv_to<arma::vec>::from(arma::max(data, 1)));
+}
+
+inline SpaceFillingCurve::SpaceFillingCurve(const arma::vec& lo,
+                                            const arma::vec& hi,
+                                            const CurveType curve) :
+    curve(curve)
+{
+  Initialize(lo, hi);
+}
+
+inline void SpaceFillingCurve::Initialize(const arma::vec& boxLo,
+                                          const arma::vec& boxHi)
+{
+  // A key has 64 bits; in low dimensionality, each coordinate gets at most 32
+  // of them, which is finer than the precision of most data anyway.
+  dimensions = std::min((size_t) boxLo.n_elem, (size_t) 64);
+  bits = (dimensions == 0) ? 0 : std::min((size_t) 32, 64 / dimensions);
+
+  const double cells = (double) ((uint64_t(1) << bits) - 1);
+  lo = (dimensions == 0) ? arma::vec() : arma::vec(boxLo.subvec(0,
+      dimensions - 1));
+  scale.zeros(dimensions);
+  for (size_t d = 0; d < dimensions; ++d)
+  {
+    const double width = boxHi[d] - boxLo[d];
+    if (width > 0)
+      scale[d] = cells / width;
+  }
+}
+
+template<typename VecType>
+uint64_t SpaceFillingCurve::Key(const VecType& point) const
+{
+  // Find the cell of the point in each dimension.
+  const uint64_t maxCell = (uint64_t(1) << bits) - 1;
+  uint64_t x[64];
+  for (size_t d = 0; d < dimensions; ++d)
+  {
+    const double cell = (point[d] - lo[d]) * scale[d];
+    x[d] = (cell <= 0.0) ? 0 : (cell >= (double) maxCell) ? maxCell :
+        (uint64_t) cell;
+  }
+
+  if (curve == HilbertCurve && dimensions > 1)
+  {
+    // Transform the cells into the "transposed" Hilbert index (J. Skilling,
+    // "Programming the Hilbert curve", 2004), whose bits are then interleaved
+    // just like those of a Morton key.
+    for (uint64_t q = uint64_t(1) << (bits - 1); q > 1; q >>= 1)
+    {
+      const uint64_t p = q - 1;
+      for (size_t d = 0; d < dimensions; ++d)
+      {
+        if (x[d] & q)
+        {
+          x[0] ^= p; // Invert the low bits of the first coordinate.
+        }
+        else
+        {
+          // Exchange the low bits of the first coordinate and this one.
+          const uint64_t t = (x[0] ^ x[d]) & p;
+          x[0] ^= t;
+          x[d] ^= t;
+        }
+      }
+    }
+
+    // Gray encode.
+    for (size_t d = 1; d < dimensions; ++d)
+      x[d] ^= x[d - 1];
+    uint64_t t = 0;
+    for (uint64_t q = uint64_t(1) << (bits - 1); q > 1; q >>= 1)
+      if (x[dimensions - 1] & q)
+        t ^= q - 1;
+    for (size_t d = 0; d < dimensions; ++d)
+      x[d] ^= t;
+  }
+
+  // Interleave the bits, most significant first.
+  uint64_t key = 0;
+  for (size_t b = bits; b > 0; --b)
+    for (size_t d = 0; d < dimensions; ++d)
+      key = (key << 1) | ((x[d] >> (b - 1)) & 1);
+
+  return key;
+}
+
+template<typename eT>
+void SpaceFillingCurveOrder(const arma::Mat<eT>& data,
+                            std::vector<size_t>& oldFromNew,
+                            const CurveType curve)
+{
+  const SpaceFillingCurve spaceFillingCurve(data, curve);
+
+  std::vector<std::pair<uint64_t, size_t> > keys(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    keys[i] = std::make_pair(spaceFillingCurve.Key(data.unsafe_col(i)), i);
+
+  std::sort(keys.begin(), keys.end());
+
+  oldFromNew.resize(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    oldFromNew[i] = keys[i].second;
+}
+
+template<typename eT>
+void ReorderColumns(arma::Mat<eT>& data, const std::vector<size_t>& oldFromNew)
+{
+  Log::Assert(oldFromNew.size() == data.n_cols);
+
+  arma::Mat<eT> reordered(data.n_rows, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    reordered.col(i) = data.col(oldFromNew[i]);
+
+  data = reordered;
+}
+
+template<typename eT>
+void RestoreColumns(arma::Mat<eT>& data, const std::vector<size_t>& oldFromNew)
+{
+  Log::Assert(oldFromNew.size() == data.n_cols);
+
+  arma::Mat<eT> restored(data.n_rows, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    restored.col(oldFromNew[i]) = data.col(i);
+
+  data = restored;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -24,12 +24,181 @@
 using namespace mlpack;
 using namespace mlpack::distribution;
 
+namespace {
+
+//! Return whether every element off the diagonal of the matrix is zero.
+bool IsDiagonal(const arma::mat& matrix)
+{
+  if (!matrix.is_square())
+    return false;
+
+  for (size_t j = 0; j < matrix.n_cols; ++j)
+  {
+    const double* column = matrix.colptr(j);
+    for (size_t i = 0; i < matrix.n_rows; ++i)
+      if (i != j && column[i] != 0.0)
+        return false;
+  }
+
+  return true;
+}
+
+}; // anonymous namespace
+
 arma::vec GaussianDistribution::Random() const
 {
-  // Should we store chol(covariance) for easier calculation later?
+  FactorCovariance();
+  if (diagonal)
+    return sqrt(covariance.diag()) % arma::randn<arma::vec>(mean.n_elem) +
+        mean;
+
+  if (hasCholesky)
+    return covLower * arma::randn<arma::vec>(mean.n_elem) + mean;
+
   return trans(chol(covariance)) * arma::randn<arma::vec>(mean.n_elem) + mean;
 }
 
+/**
+ * Return the log-probability of the given observation.
+ */
+double GaussianDistribution::LogProbability(const arma::vec& observation) const
+{
+  FactorCovariance();
+
+  const arma::vec diff = observation - mean;
+
+  // The squared Mahalanobis distance, diff^T * cov^-1 * diff.
+  double mahalanobis;
+  if (diagonal)
+  {
+    mahalanobis = dot(diff % diff, invVariances);
+  }
+  else if (hasCholesky)
+  {
+    const arma::vec z = solve(trimatl(covLower), diff);
+    mahalanobis = dot(z, z);
+  }
+  else
+  {
+    mahalanobis = dot(diff, invCov * diff);
+  }
+
+  return -0.5 * (mean.n_elem * log(2 * M_PI) + logDetCov + mahalanobis);
+}
+
+/**
+ * Calculate the probability of each observation in the given matrix.
+ */
+void GaussianDistribution::Probability(const arma::mat& observations,
+                                       arma::vec& probabilities) const
+{
+  LogProbability(observations, probabilities);
+  probabilities = exp(probabilities);
+}
+
+/**
+ * Calculate the log-probability of each observation in the given matrix.
+ */
+void GaussianDistribution::LogProbability(const arma::mat& observations,
+                                          arma::vec& logProbabilities) const
+{
+  FactorCovariance();
+
+  // Column i of 'diffs' is the difference between observation i and the mean.
+  const arma::mat diffs = observations - (mean *
+      arma::ones<arma::rowvec>(observations.n_cols));
+
+  // We only need the diagonal of (diffs^T * cov^-1 * diffs).  With the Cholesky
+  // factor L, this is the squared norm of each column of L^-1 * diffs, which we
+  // get with one triangular solve over the whole block.
+  arma::vec mahalanobis;
+  if (diagonal)
+  {
+    // With a diagonal covariance, this is a weighted sum of the squared
+    // differences.
+    mahalanobis = trans(trans(invVariances) * (diffs % diffs));
+  }
+  else if (hasCholesky)
+  {
+    const arma::mat z = solve(trimatl(covLower), diffs);
+    mahalanobis = trans(arma::sum(z % z, 0));
+  }
+  else
+  {
+    mahalanobis = trans(arma::sum(diffs % (invCov * diffs), 0));
+  }
+
+  logProbabilities = -0.5 * (mahalanobis +
+      (mean.n_elem * log(2 * M_PI) + logDetCov));
+}
+
+/**
+ * Compute and cache the factorization of the covariance.
+ */
+void GaussianDistribution::FactorCovariance() const
+{
+  if (factorized)
+    return;
+
+  if (covariance.n_elem == 0)
+  {
+    covLower.reset();
+    invCov.reset();
+    invVariances.reset();
+    logDetCov = 0.0;
+    hasCholesky = true;
+    diagonal = false;
+    factorized = true;
+    return;
+  }
+
+  // A diagonal covariance needs no factorization, as long as its variances
+  // are positive.
+  if (IsDiagonal(covariance) && arma::min(covariance.diag()) > 0.0)
+  {
+    covLower.reset();
+    invCov.reset();
+    invVariances = 1.0 / covariance.diag();
+    logDetCov = arma::accu(log(covariance.diag()));
+    hasCholesky = false;
+    diagonal = true;
+    factorized = true;
+    return;
+  }
+
+  // The Cholesky decomposition only looks at one triangle of the matrix, so we
+  // can only use it if the covariance is actually symmetric.
+  const double scale = arma::max(arma::max(arma::abs(covariance)));
+  const bool symmetric = covariance.is_square() &&
+      (arma::max(arma::max(arma::abs(covariance - trans(covariance)))) <=
+      1e-10 * scale);
+
+  arma::mat covUpper;
+  if (symmetric && chol(covUpper, covariance))
+  {
+    covLower = trans(covUpper);
+    invCov.reset();
+    invVariances.reset();
+    logDetCov = 2.0 * arma::accu(log(covLower.diag()));
+    hasCholesky = true;
+  }
+  else
+  {
+    Log::Debug << "GaussianDistribution::FactorCovariance(): covariance is not "
+        << "symmetric positive definite; falling back to the inverse."
+        << std::endl;
+
+    covLower.reset();
+    invCov = inv(covariance);
+    invVariances.reset();
+    logDetCov = log(det(covariance));
+    hasCholesky = false;
+  }
+
+  diagonal = false;
+  factorized = true;
+}
+
 /**
  * Estimate the Gaussian distribution directly from the given observations.
  *
@@ -46,6 +215,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations)
   {
     mean.zeros(0);
     covariance.zeros(0);
+    factorized = false;
     return;
   }
 
@@ -80,6 +250,9 @@ void GaussianDistribution::Estimate(const arma::mat& observations)
       perturbation *= 10; // Slow, but we don't want to add too much.
     }
   }
+
+  // The cached factorization no longer matches the covariance.
+  factorized = false;
 }
 
 /**
@@ -99,6 +272,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
   {
     mean.zeros(0);
     covariance.zeros(0);
+    factorized = false;
     return;
   }
 
@@ -117,6 +291,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
     // Nothing in this Gaussian!  At least set the covariance so that it's
     // invertible.
     covariance.diag() += 1e-50;
+    factorized = false;
     return;
   }
 
@@ -146,6 +321,9 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
       perturbation *= 10; // Slow, but we don't want to add too much.
     }
   }
+
+  // The cached factorization no longer matches the covariance.
+  factorized = false;
 }
 
 /**
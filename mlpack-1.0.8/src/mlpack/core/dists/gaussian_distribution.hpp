@@ -31,6 +31,11 @@ namespace distribution {
 
 /**
  * A single multivariate Gaussian distribution.
+ *
+ * If the covariance is diagonal (for instance, when it was fit by EMFit with
+ * the DiagonalConstraint), only the inverses of the variances are cached, and
+ * log-probabilities take O(d) time per observation instead of a triangular
+ * solve.
  */
 class GaussianDistribution
 {
@@ -40,11 +45,26 @@ class GaussianDistribution
   //! Covariance of the distribution.
   arma::mat covariance;
 
+  //! Lower-triangular Cholesky factor of the covariance (cached).
+  mutable arma::mat covLower;
+  //! Inverse of the covariance; only used if there is no Cholesky factor.
+  mutable arma::mat invCov;
+  //! Inverses of the variances; only used if the covariance is diagonal.
+  mutable arma::vec invVariances;
+  //! Log-determinant of the covariance (cached).
+  mutable double logDetCov;
+  //! If true, covLower holds a valid Cholesky factor of the covariance.
+  mutable bool hasCholesky;
+  //! If true, the covariance is diagonal and invVariances is used.
+  mutable bool diagonal;
+  //! If true, the cached factorization reflects the current covariance.
+  mutable bool factorized;
+
  public:
   /**
    * Default constructor, which creates a Gaussian with zero dimension.
    */
-  GaussianDistribution() { /* nothing to do */ }
+  GaussianDistribution() : factorized(false) { /* nothing to do */ }
 
   /**
    * Create a Gaussian distribution with zero mean and identity covariance with
@@ -52,14 +72,16 @@ class GaussianDistribution
    */
   GaussianDistribution(const size_t dimension) :
       mean(arma::zeros<arma::vec>(dimension)),
-      covariance(arma::eye<arma::mat>(dimension, dimension))
+      covariance(arma::eye<arma::mat>(dimension, dimension)),
+      factorized(false)
   { /* Nothing to do. */ }
 
   /**
    * Create a Gaussian distribution with the given mean and covariance.
    */
   GaussianDistribution(const arma::vec& mean, const arma::mat& covariance) :
-      mean(mean), covariance(covariance) { /* Nothing to do. */ }
+      mean(mean), covariance(covariance), factorized(false)
+  { /* Nothing to do. */ }
 
   //! Return the dimensionality of this distribution.
   size_t Dimensionality() const { return mean.n_elem; }
@@ -69,9 +91,37 @@ class GaussianDistribution
    */
   double Probability(const arma::vec& observation) const
   {
-    return mlpack::gmm::phi(observation, mean, covariance);
+    return exp(LogProbability(observation));
   }
 
+  /**
+   * Return the log-probability of the given observation.  The Cholesky factor
+   * and log-determinant of the covariance are computed once and cached, so
+   * repeated calls do not refactorize the covariance.
+   */
+  double LogProbability(const arma::vec& observation) const;
+
+  /**
+   * Calculate the probability of each observation (column) in the given
+   * matrix.
+   *
+   * @param observations List of observations.
+   * @param probabilities Output probabilities for each input observation.
+   */
+  void Probability(const arma::mat& observations,
+                   arma::vec& probabilities) const;
+
+  /**
+   * Calculate the log-probability of each observation (column) in the given
+   * matrix.  The Mahalanobis distances of all observations are computed with a
+   * single triangular solve against the cached Cholesky factor.
+   *
+   * @param observations List of observations.
+   * @param logProbabilities Output log-probabilities for each observation.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -111,14 +161,29 @@ class GaussianDistribution
   const arma::mat& Covariance() const { return covariance; }
 
   /**
-   * Return a modifiable copy of the covariance.
+   * Return a modifiable copy of the covariance.  This invalidates the cached
+   * factorization of the covariance, which will be recomputed the next time it
+   * is needed.
    */
-  arma::mat& Covariance() { return covariance; }
+  arma::mat& Covariance() { factorized = false; return covariance; }
 
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
+
+  /**
+   * Compute the Cholesky factor and log-determinant of the covariance and
+   * cache them, if that has not already been done.  If the covariance is
+   * diagonal with positive variances, only the inverses of the variances are
+   * cached.  If the covariance has no Cholesky factor (i.e. it is not
+   * symmetric positive definite), the inverse is cached instead.
+   *
+   * This is called automatically when needed, but because it modifies the
+   * cache, it must be called before the distribution is shared between threads
+   * that call Probability() or LogProbability() concurrently.
+   */
+  void FactorCovariance() const;
 };
 
 }; // namespace distribution
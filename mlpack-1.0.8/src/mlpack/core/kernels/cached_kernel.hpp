@@ -0,0 +1,222 @@
+/**
+ * @file cached_kernel.hpp
+ *
+ * A wrapper around any kernel which caches the kernel values of pairs of
+ * points of given datasets in a bounded, sharded least-recently-used cache.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_CACHED_KERNEL_HPP
+#define __MLPACK_CORE_KERNELS_CACHED_KERNEL_HPP
+
+#include <list>
+#include <vector>
+#include <utility>
+
+#include <boost/unordered_map.hpp>
+
+#include <mlpack/core.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * A kernel which wraps another kernel, and caches its values for pairs of
+ * points of the datasets it is given, so that a pair which is evaluated again
+ * (in another step of a tree traversal, or in another search with the same
+ * kernel) is looked up instead of recomputed.  This is worthwhile for
+ * expensive kernels, such as the PSpectrumStringKernel or the GaussianKernel
+ * in high dimension; for cheap kernels, the lookup costs more than the
+ * evaluation.
+ *
+ * Points are identified by their memory: a vector which is a column of one of
+ * the datasets given to the constructor or to AddDataset() (such as
+ * dataset.unsafe_col(i), which is how the methods of MLPACK pass points to
+ * kernels) is identified by its dataset and column, and its pairs are cached.
+ * Any other vector (for instance, a centroid of a tree node) is evaluated with
+ * the wrapped kernel, without the cache.  So, the datasets must not be modified
+ * or moved while the CachedKernel is in use; in particular, a method which
+ * reorders a copy of the dataset (such as one using a kd-tree) will not hit
+ * the cache.  The kernel is assumed to be symmetric.
+ *
+ * The cache holds at most Capacity() pairs.  It is split into shards by the
+ * hash of the pair, each with its own least-recently-used list and (with
+ * OpenMP) its own lock, so that several threads evaluating the kernel at once
+ * rarely wait for each other.  The numbers of hits and misses are counted.
+ *
+ * CachedKernel<KernelType> has the same KernelTraits as KernelType, so it can
+ * be used by any method which is templated on the kernel type:
+ *
+ * @code
+ * CachedKernel<PSpectrumStringKernel> kernel(data, 1000000,
+ *     PSpectrumStringKernel(strings, 3));
+ * FastMKS<CachedKernel<PSpectrumStringKernel> > fastmks(data, kernel);
+ * fastmks.Search(k, indices, kernels);
+ * Log::Info << kernel.Hits() << " hits, " << kernel.Misses() << " misses.\n";
+ * @endcode
+ *
+ * A copy of a CachedKernel has the same kernel, datasets and capacity, but an
+ * empty cache of its own.
+ *
+ * @tparam KernelType Type of the kernel to cache.
+ */
+template<typename KernelType>
+class CachedKernel
+{
+ public:
+  /**
+   * Create the cached kernel for the points of the given dataset.
+   *
+   * @param dataset Dataset whose columns are cached.
+   * @param capacity Largest number of pairs the cache holds.
+   * @param kernel Instantiated kernel to wrap.
+   * @param shards Number of shards the cache is split into.
+   */
+  CachedKernel(const arma::mat& dataset,
+               const size_t capacity = 1000000,
+               const KernelType& kernel = KernelType(),
+               const size_t shards = 64);
+
+  //! Create a copy of the given cached kernel, with an empty cache.
+  CachedKernel(const CachedKernel& other);
+
+  //! Make this a copy of the given cached kernel, with an empty cache.
+  CachedKernel& operator=(const CachedKernel& other);
+
+  //! Destroy the cache.
+  ~CachedKernel();
+
+  /**
+   * Also cache the pairs involving the points of the given dataset (for
+   * instance, a query set).
+   *
+   * @param dataset Dataset whose columns are cached.
+   */
+  void AddDataset(const arma::mat& dataset);
+
+  /**
+   * Evaluate the kernel on the two given points, looking the pair up in the
+   * cache if both points are columns of the datasets.
+   *
+   * @param a First point.
+   * @param b Second point.
+   */
+  template<typename VecType>
+  double Evaluate(const VecType& a, const VecType& b) const;
+
+  //! Empty the cache, and reset the counters.
+  void Clear();
+
+  //! Get the wrapped kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the wrapped kernel.  The cache should be cleared afterwards if
+  //! the values of the kernel change.
+  KernelType& Kernel() { return kernel; }
+
+  //! Get the largest number of pairs the cache holds.
+  size_t Capacity() const { return capacity; }
+  //! Get the number of shards the cache is split into.
+  size_t Shards() const { return numShards; }
+
+  //! Get the number of pairs in the cache.
+  size_t Size() const;
+  //! Get the number of evaluations answered by the cache.
+  size_t Hits() const;
+  //! Get the number of evaluations of cached pairs which were not in the
+  //! cache (evaluations of points outside the datasets are not counted).
+  size_t Misses() const;
+
+ private:
+  //! A pair of points, as the indices of the points over all of the datasets;
+  //! the smaller index is first.
+  typedef std::pair<size_t, size_t> Key;
+  //! A pair of points and its kernel value.
+  typedef std::pair<Key, double> Entry;
+  //! The type of the least-recently-used lists.
+  typedef std::list<Entry> EntryList;
+
+  //! One shard of the cache.
+  struct Shard
+  {
+    //! The pairs of the shard, most recently used first.
+    EntryList entries;
+    //! The position in entries of each pair of the shard.
+    boost::unordered_map<Key, typename EntryList::iterator> index;
+    //! The number of hits in this shard.
+    size_t hits;
+    //! The number of misses in this shard.
+    size_t misses;
+#ifdef _OPENMP
+    //! The lock of the shard.
+    omp_lock_t lock;
+#endif
+  };
+
+  //! The wrapped kernel.
+  KernelType kernel;
+  //! The datasets whose points are cached.
+  std::vector<const arma::mat*> datasets;
+  //! The index of the first point of each dataset, over all of the datasets.
+  std::vector<size_t> offsets;
+  //! The largest number of pairs the cache holds.
+  size_t capacity;
+  //! The number of shards.
+  size_t numShards;
+  //! The shards (mutable, since Evaluate() is const like that of kernels).
+  mutable Shard* shards;
+
+  //! Allocate the shards, and initialize their locks.
+  void AllocateShards();
+  //! Free the shards, and destroy their locks.
+  void FreeShards();
+
+  /**
+   * Find the index of the given point over all of the datasets.  Return false
+   * if the point is not a column of one of the datasets.
+   */
+  bool Locate(const arma::vec& point, size_t& index) const;
+
+  //! Points which are not dense vectors are never cached.
+  template<typename VecType>
+  bool Locate(const VecType& /* point */, size_t& /* index */) const
+  { return false; }
+
+  //! Lock the given shard.
+  void Lock(Shard& shard) const;
+  //! Unlock the given shard.
+  void Unlock(Shard& shard) const;
+};
+
+//! The cached kernel has the traits of the kernel it wraps.
+template<typename KernelType>
+class KernelTraits<CachedKernel<KernelType> >
+{
+ public:
+  //! The cached kernel is normalized if the wrapped kernel is.
+  static const bool IsNormalized = KernelTraits<KernelType>::IsNormalized;
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+// Include implementation.
+#include "cached_kernel_impl.hpp"
+
+#endif
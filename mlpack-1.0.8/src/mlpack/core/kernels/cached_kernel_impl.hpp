@@ -0,0 +1,262 @@
+/**
+ * @file cached_kernel_impl.hpp
+ *
+ * Implementation of CachedKernel.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_CACHED_KERNEL_IMPL_HPP
+#define __MLPACK_CORE_KERNELS_CACHED_KERNEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "cached_kernel.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+template<typename KernelType>
+CachedKernel<KernelType>::CachedKernel(const arma::mat& dataset,
+                                       const size_t capacity,
+                                       const KernelType& kernel,
+                                       const size_t shards) :
+    kernel(kernel),
+    capacity(capacity),
+    numShards(std::max(shards, (size_t) 1)),
+    shards(NULL)
+{
+  AddDataset(dataset);
+  AllocateShards();
+}
+
+template<typename KernelType>
+CachedKernel<KernelType>::CachedKernel(const CachedKernel& other) :
+    kernel(other.kernel),
+    datasets(other.datasets),
+    offsets(other.offsets),
+    capacity(other.capacity),
+    numShards(other.numShards),
+    shards(NULL)
+{
+  AllocateShards();
+}
+
+template<typename KernelType>
+CachedKernel<KernelType>& CachedKernel<KernelType>::operator=(
+    const CachedKernel& other)
+{
+  if (this != &other)
+  {
+    FreeShards();
+
+    kernel = other.kernel;
+    datasets = other.datasets;
+    offsets = other.offsets;
+    capacity = other.capacity;
+    numShards = other.numShards;
+
+    AllocateShards();
+  }
+
+  return *this;
+}
+
+template<typename KernelType>
+CachedKernel<KernelType>::~CachedKernel()
+{
+  FreeShards();
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::AddDataset(const arma::mat& dataset)
+{
+  const size_t offset = datasets.empty() ? 0 :
+      offsets.back() + datasets.back()->n_cols;
+
+  datasets.push_back(&dataset);
+  offsets.push_back(offset);
+}
+
+template<typename KernelType>
+template<typename VecType>
+double CachedKernel<KernelType>::Evaluate(const VecType& a,
+                                          const VecType& b) const
+{
+  size_t indexA, indexB;
+  if (!Locate(a, indexA) || !Locate(b, indexB))
+    return kernel.Evaluate(a, b);
+
+  const Key key = (indexA < indexB) ? Key(indexA, indexB) :
+      Key(indexB, indexA);
+  Shard& shard = shards[boost::hash<Key>()(key) % numShards];
+
+  // Look the pair up, and move it to the front of the list if it is there.
+  Lock(shard);
+  typename boost::unordered_map<Key, typename EntryList::iterator>::iterator
+      it = shard.index.find(key);
+  if (it != shard.index.end())
+  {
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    const double value = it->second->second;
+    ++shard.hits;
+    Unlock(shard);
+    return value;
+  }
+  ++shard.misses;
+  Unlock(shard);
+
+  // The kernel is evaluated without holding the lock.
+  const double value = kernel.Evaluate(a, b);
+
+  // Another thread may have added the pair in the meantime.
+  const size_t shardCapacity = (capacity + numShards - 1) / numShards;
+  Lock(shard);
+  if (shardCapacity > 0 && shard.index.find(key) == shard.index.end())
+  {
+    shard.entries.push_front(Entry(key, value));
+    shard.index[key] = shard.entries.begin();
+
+    // Evict the least recently used pair, if the shard is full.
+    if (shard.entries.size() > shardCapacity)
+    {
+      shard.index.erase(shard.entries.back().first);
+      shard.entries.pop_back();
+    }
+  }
+  Unlock(shard);
+
+  return value;
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::Clear()
+{
+  for (size_t i = 0; i < numShards; ++i)
+  {
+    shards[i].entries.clear();
+    shards[i].index.clear();
+    shards[i].hits = 0;
+    shards[i].misses = 0;
+  }
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Size() const
+{
+  size_t size = 0;
+  for (size_t i = 0; i < numShards; ++i)
+    size += shards[i].index.size();
+
+  return size;
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Hits() const
+{
+  size_t hits = 0;
+  for (size_t i = 0; i < numShards; ++i)
+    hits += shards[i].hits;
+
+  return hits;
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Misses() const
+{
+  size_t misses = 0;
+  for (size_t i = 0; i < numShards; ++i)
+    misses += shards[i].misses;
+
+  return misses;
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::AllocateShards()
+{
+  shards = new Shard[numShards];
+  for (size_t i = 0; i < numShards; ++i)
+  {
+    shards[i].hits = 0;
+    shards[i].misses = 0;
+#ifdef _OPENMP
+    omp_init_lock(&shards[i].lock);
+#endif
+  }
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::FreeShards()
+{
+  if (shards == NULL)
+    return;
+
+#ifdef _OPENMP
+  for (size_t i = 0; i < numShards; ++i)
+    omp_destroy_lock(&shards[i].lock);
+#endif
+
+  delete[] shards;
+  shards = NULL;
+}
+
+template<typename KernelType>
+bool CachedKernel<KernelType>::Locate(const arma::vec& point,
+                                      size_t& index) const
+{
+  const double* memory = point.memptr();
+  for (size_t i = 0; i < datasets.size(); ++i)
+  {
+    const arma::mat& dataset = *datasets[i];
+    if (point.n_elem != dataset.n_rows || dataset.n_elem == 0 ||
+        memory < dataset.memptr() ||
+        memory >= dataset.memptr() + dataset.n_elem)
+      continue;
+
+    // The point must start at the start of a column.
+    const size_t position = memory - dataset.memptr();
+    if (position % dataset.n_rows != 0)
+      continue;
+
+    index = offsets[i] + position / dataset.n_rows;
+    return true;
+  }
+
+  return false;
+}
+
+template<typename KernelType>
+inline void CachedKernel<KernelType>::Lock(Shard& shard) const
+{
+#ifdef _OPENMP
+  omp_set_lock(&shard.lock);
+#else
+  (void) shard;
+#endif
+}
+
+template<typename KernelType>
+inline void CachedKernel<KernelType>::Unlock(Shard& shard) const
+{
+#ifdef _OPENMP
+  omp_unset_lock(&shard.lock);
+#else
+  (void) shard;
+#endif
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
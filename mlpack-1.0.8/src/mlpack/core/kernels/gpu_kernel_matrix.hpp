@@ -0,0 +1,218 @@
+/**
+ * @file gpu_kernel_matrix.hpp
+ *
+ * Computation of the kernel matrix of a dataset on the GPU (with Metal), for
+ * kernels which are functions of the inner product or of the distance.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_GPU_KERNEL_MATRIX_HPP
+#define __MLPACK_CORE_KERNELS_GPU_KERNEL_MATRIX_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metal/metal_engine.hpp>
+#include "kernel_block.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Turn the matrix of inner products of a dataset, computed on the GPU, into
+ * its kernel matrix.  Like KernelBlock, this is specialized for the kernels
+ * which are functions of the inner product or of the distance; for other
+ * kernels Supported is false, and GPUKernelMatrix() is not used.
+ *
+ * @tparam KernelType Type of kernel to evaluate.
+ */
+template<typename KernelType>
+class GPUKernelBlock
+{
+ public:
+  //! Whether the kernel matrix can be computed from the inner products.
+  static const bool Supported = false;
+
+  //! Turn the inner products of the data into kernel values (in place).
+  static void Transform(KernelType& /* kernel */,
+                        const arma::mat& /* data */,
+                        arma::mat& /* kernels */) { }
+};
+
+//! The linear kernel is the inner product itself.
+template<>
+class GPUKernelBlock<LinearKernel>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(LinearKernel& /* kernel */,
+                        const arma::mat& /* data */,
+                        arma::mat& /* kernels */) { }
+};
+
+//! The polynomial kernel is (x^T y + offset)^degree.
+template<>
+class GPUKernelBlock<PolynomialKernel>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(PolynomialKernel& kernel,
+                        const arma::mat& /* data */,
+                        arma::mat& kernels)
+  {
+    kernels = pow(kernels + kernel.Offset(), kernel.Degree());
+  }
+};
+
+//! The cosine similarity is x^T y / (|| x || || y ||), or 0 if either point is
+//! the origin.
+template<>
+class GPUKernelBlock<CosineDistance>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(CosineDistance& /* kernel */,
+                        const arma::mat& data,
+                        arma::mat& kernels)
+  {
+    arma::vec norms(data.n_cols);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      norms[i] = norm(data.unsafe_col(i), 2);
+
+    for (size_t j = 0; j < kernels.n_cols; ++j)
+    {
+      for (size_t i = 0; i < kernels.n_rows; ++i)
+      {
+        const double denominator = norms[i] * norms[j];
+        kernels(i, j) = (denominator == 0.0) ? 0.0 :
+            kernels(i, j) / denominator;
+      }
+    }
+  }
+};
+
+//! The hyperbolic tangent kernel is tanh(scale * x^T y + offset).
+template<>
+class GPUKernelBlock<HyperbolicTangentKernel>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(HyperbolicTangentKernel& kernel,
+                        const arma::mat& /* data */,
+                        arma::mat& kernels)
+  {
+    kernels = tanh(kernel.Scale() * kernels + kernel.Offset());
+  }
+};
+
+/**
+ * Turn the inner products of a dataset into squared Euclidean distances, as
+ * ||x||^2 + ||y||^2 - 2 x^T y, with the norms computed in double precision.
+ * Distances which come out negative because of roundoff are set to zero.
+ */
+inline void GPUSquaredDistances(const arma::mat& data, arma::mat& products)
+{
+  const arma::rowvec norms = arma::sum(arma::square(data), 0);
+
+  products *= -2.0;
+  products.each_col() += trans(norms);
+  products.each_row() += norms;
+  for (size_t i = 0; i < products.n_elem; ++i)
+    if (products[i] < 0.0)
+      products[i] = 0.0;
+}
+
+//! The Gaussian kernel is exp(gamma * ||x - y||^2).
+template<>
+class GPUKernelBlock<GaussianKernel>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(GaussianKernel& kernel,
+                        const arma::mat& data,
+                        arma::mat& kernels)
+  {
+    GPUSquaredDistances(data, kernels);
+    kernels = exp(kernel.Gamma() * kernels);
+  }
+};
+
+//! The Laplacian kernel is exp(-||x - y|| / bandwidth).
+template<>
+class GPUKernelBlock<LaplacianKernel>
+{
+ public:
+  static const bool Supported = true;
+
+  static void Transform(LaplacianKernel& kernel,
+                        const arma::mat& data,
+                        arma::mat& kernels)
+  {
+    GPUSquaredDistances(data, kernels);
+    kernels = exp(-sqrt(kernels) / kernel.Bandwidth());
+  }
+};
+
+/**
+ * Build the (symmetric) kernel matrix of a dataset on the GPU: the inner
+ * products of all pairs of points are computed in single precision with
+ * metal::InnerProducts(), and then turned into kernel values with
+ * GPUKernelBlock.  As with KernelMatrix(), the result is made exactly
+ * symmetric and the diagonal is evaluated with KernelType::Evaluate().
+ *
+ * If the kernel is not supported by GPUKernelBlock or no GPU is available,
+ * nothing is computed and false is returned, so that the caller can use
+ * KernelMatrix() instead.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param data Dataset (one point per column).
+ * @param kernelMatrix Matrix to store the kernel matrix in (n x n).
+ * @return Whether the kernel matrix was computed.
+ */
+template<typename KernelType>
+bool GPUKernelMatrix(KernelType& kernel,
+                     const arma::mat& data,
+                     arma::mat& kernelMatrix)
+{
+  if (!GPUKernelBlock<KernelType>::Supported || !metal::Available())
+    return false;
+
+  metal::InnerProducts(data, data, kernelMatrix);
+  GPUKernelBlock<KernelType>::Transform(kernel, data, kernelMatrix);
+
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    for (size_t i = j + 1; i < data.n_cols; ++i)
+    {
+      const double value = 0.5 * (kernelMatrix(i, j) + kernelMatrix(j, i));
+      kernelMatrix(i, j) = value;
+      kernelMatrix(j, i) = value;
+    }
+
+    kernelMatrix(j, j) = kernel.Evaluate(data.unsafe_col(j),
+        data.unsafe_col(j));
+  }
+
+  return true;
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
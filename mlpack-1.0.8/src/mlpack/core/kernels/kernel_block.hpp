@@ -0,0 +1,257 @@
+/**
+ * @file kernel_block.hpp
+ *
+ * Evaluation of a kernel between a block of query points and a block of
+ * reference points at once, which for kernels of the inner product is a single
+ * matrix multiplication.  This is used by FastMKS and by KernelMatrix().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_KERNEL_BLOCK_HPP
+#define __MLPACK_CORE_KERNELS_KERNEL_BLOCK_HPP
+
+#include <mlpack/core.hpp>
+#include "linear_kernel.hpp"
+#include "polynomial_kernel.hpp"
+#include "cosine_distance.hpp"
+#include "gaussian_kernel.hpp"
+#include "laplacian_kernel.hpp"
+#include "hyperbolic_tangent_kernel.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Evaluate a kernel between every point in a block of query points and every
+ * point in a block of reference points.  The general version calls
+ * KernelType::Evaluate() for each pair.  For kernels which are functions of
+ * the inner product (LinearKernel, PolynomialKernel, HyperbolicTangentKernel,
+ * and CosineDistance) or of the distance (GaussianKernel and LaplacianKernel,
+ * since ||x - y||^2 = ||x||^2 + ||y||^2 - 2 x^T y), there are specializations
+ * which compute all the inner products with one matrix multiplication; other
+ * such kernels can be added the same way.
+ *
+ * The results are stored in a matrix with one column for each query point and
+ * one row for each reference point, so the kernel values of a query point are
+ * contiguous.
+ *
+ * @tparam KernelType Type of kernel to evaluate.
+ */
+template<typename KernelType>
+class KernelBlock
+{
+ public:
+  /**
+   * Evaluate the kernel between the query points [queryBegin, queryBegin +
+   * queryCount) and the reference points [referenceBegin, referenceBegin +
+   * referenceCount).
+   *
+   * @param kernel Kernel to evaluate.
+   * @param querySet Set of query points.
+   * @param queryBegin Index of the first query point of the block.
+   * @param queryCount Number of query points in the block.
+   * @param referenceSet Set of reference points.
+   * @param referenceBegin Index of the first reference point of the block.
+   * @param referenceCount Number of reference points in the block.
+   * @param kernels Matrix to store the kernel values in (referenceCount x
+   *     queryCount).
+   */
+  static void Evaluate(KernelType& kernel,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels.set_size(referenceCount, queryCount);
+    for (size_t q = 0; q < queryCount; ++q)
+      for (size_t r = 0; r < referenceCount; ++r)
+        kernels(r, q) = kernel.Evaluate(querySet.unsafe_col(queryBegin + q),
+            referenceSet.unsafe_col(referenceBegin + r));
+  }
+};
+
+//! The linear kernel is the inner product itself.
+template<>
+class KernelBlock<LinearKernel>
+{
+ public:
+  static void Evaluate(LinearKernel& /* kernel */,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = trans(referenceSet.cols(referenceBegin,
+        referenceBegin + referenceCount - 1)) * querySet.cols(queryBegin,
+        queryBegin + queryCount - 1);
+  }
+};
+
+//! The polynomial kernel is (x^T y + offset)^degree.
+template<>
+class KernelBlock<PolynomialKernel>
+{
+ public:
+  static void Evaluate(PolynomialKernel& kernel,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = trans(referenceSet.cols(referenceBegin,
+        referenceBegin + referenceCount - 1)) * querySet.cols(queryBegin,
+        queryBegin + queryCount - 1);
+    kernels = pow(kernels + kernel.Offset(), kernel.Degree());
+  }
+};
+
+//! The cosine similarity is x^T y / (|| x || || y ||), or 0 if either point is
+//! the origin.
+template<>
+class KernelBlock<CosineDistance>
+{
+ public:
+  static void Evaluate(CosineDistance& /* kernel */,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = trans(referenceSet.cols(referenceBegin,
+        referenceBegin + referenceCount - 1)) * querySet.cols(queryBegin,
+        queryBegin + queryCount - 1);
+
+    arma::vec referenceNorms(referenceCount);
+    for (size_t r = 0; r < referenceCount; ++r)
+      referenceNorms[r] = norm(referenceSet.unsafe_col(referenceBegin + r), 2);
+
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+      const double queryNorm = norm(querySet.unsafe_col(queryBegin + q), 2);
+      for (size_t r = 0; r < referenceCount; ++r)
+      {
+        const double denominator = queryNorm * referenceNorms[r];
+        kernels(r, q) = (denominator == 0.0) ? 0.0 :
+            kernels(r, q) / denominator;
+      }
+    }
+  }
+};
+
+//! The hyperbolic tangent kernel is tanh(scale * x^T y + offset).
+template<>
+class KernelBlock<HyperbolicTangentKernel>
+{
+ public:
+  static void Evaluate(HyperbolicTangentKernel& kernel,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = trans(referenceSet.cols(referenceBegin,
+        referenceBegin + referenceCount - 1)) * querySet.cols(queryBegin,
+        queryBegin + queryCount - 1);
+    kernels = tanh(kernel.Scale() * kernels + kernel.Offset());
+  }
+};
+
+/**
+ * Compute the squared Euclidean distances between a block of query points and
+ * a block of reference points from their inner products, as ||x||^2 + ||y||^2
+ * - 2 x^T y.  Distances which come out slightly negative because of roundoff
+ * are set to zero.  This is used by the blocks of the distance-based kernels.
+ */
+inline void SquaredDistanceBlock(const arma::mat& querySet,
+                                 const size_t queryBegin,
+                                 const size_t queryCount,
+                                 const arma::mat& referenceSet,
+                                 const size_t referenceBegin,
+                                 const size_t referenceCount,
+                                 arma::mat& distances)
+{
+  const arma::mat queries = querySet.cols(queryBegin,
+      queryBegin + queryCount - 1);
+  const arma::mat references = referenceSet.cols(referenceBegin,
+      referenceBegin + referenceCount - 1);
+
+  distances = -2.0 * trans(references) * queries;
+  distances.each_col() += trans(arma::sum(arma::square(references), 0));
+  distances.each_row() += arma::sum(arma::square(queries), 0);
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    if (distances[i] < 0.0)
+      distances[i] = 0.0;
+}
+
+//! The Gaussian kernel is exp(gamma * ||x - y||^2).
+template<>
+class KernelBlock<GaussianKernel>
+{
+ public:
+  static void Evaluate(GaussianKernel& kernel,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    SquaredDistanceBlock(querySet, queryBegin, queryCount, referenceSet,
+        referenceBegin, referenceCount, kernels);
+    kernels = exp(kernel.Gamma() * kernels);
+  }
+};
+
+//! The Laplacian kernel is exp(-||x - y|| / bandwidth).
+template<>
+class KernelBlock<LaplacianKernel>
+{
+ public:
+  static void Evaluate(LaplacianKernel& kernel,
+                       const arma::mat& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const arma::mat& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    SquaredDistanceBlock(querySet, queryBegin, queryCount, referenceSet,
+        referenceBegin, referenceCount, kernels);
+    kernels = exp(-sqrt(kernels) / kernel.Bandwidth());
+  }
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
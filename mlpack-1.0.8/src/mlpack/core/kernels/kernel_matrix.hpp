@@ -0,0 +1,82 @@
+/**
+ * @file kernel_matrix.hpp
+ *
+ * Construction of the kernel matrix of a dataset, or between two datasets, in
+ * blocks which are computed in parallel.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_KERNEL_MATRIX_HPP
+#define __MLPACK_CORE_KERNELS_KERNEL_MATRIX_HPP
+
+#include <mlpack/core.hpp>
+#include "kernel_block.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Build the (symmetric) kernel matrix of a dataset, so that kernelMatrix(i, j)
+ * is the kernel evaluated between points i and j.  The matrix is split into
+ * square blocks, and only the blocks on and above the diagonal are computed
+ * (with KernelBlock, so for the kernels it is specialized for, each block is a
+ * single matrix multiplication); each block is then mirrored into the lower
+ * triangle.  The blocks are handed out to threads dynamically.  The result is
+ * exactly symmetric, and the diagonal is evaluated with KernelType::Evaluate().
+ *
+ * @code
+ * arma::mat kernelMatrix;
+ * KernelMatrix(kernel, data, kernelMatrix, 4); // Use four threads.
+ * @endcode
+ *
+ * @param kernel Kernel to evaluate.
+ * @param data Dataset (one point per column).
+ * @param kernelMatrix Matrix to store the kernel matrix in (n x n).
+ * @param threads Number of threads to use; 0 means all available cores.
+ */
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel,
+                  const arma::mat& data,
+                  arma::mat& kernelMatrix,
+                  const size_t threads = 1);
+
+/**
+ * Build the kernel matrix between two datasets, so that kernelMatrix(i, j) is
+ * the kernel evaluated between point i of the first set and point j of the
+ * second set.  The matrix is computed in blocks with KernelBlock, which are
+ * handed out to threads dynamically.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a First dataset (one point per column).
+ * @param b Second dataset (one point per column).
+ * @param kernelMatrix Matrix to store the kernel matrix in (a.n_cols x
+ *     b.n_cols).
+ * @param threads Number of threads to use; 0 means all available cores.
+ */
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel,
+                  const arma::mat& a,
+                  const arma::mat& b,
+                  arma::mat& kernelMatrix,
+                  const size_t threads = 1);
+
+}; // namespace kernel
+}; // namespace mlpack
+
+// Include implementation.
+#include "kernel_matrix_impl.hpp"
+
+#endif
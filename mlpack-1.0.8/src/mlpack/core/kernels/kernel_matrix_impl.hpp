@@ -0,0 +1,146 @@
+/**
+ * @file kernel_matrix_impl.hpp
+ *
+ * Implementation of KernelMatrix().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_KERNELS_KERNEL_MATRIX_IMPL_HPP
+#define __MLPACK_CORE_KERNELS_KERNEL_MATRIX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kernel_matrix.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kernel {
+
+//! The number of points along each side of a block of the kernel matrix.
+const size_t kernelMatrixBlockSize = 256;
+
+/**
+ * Get the number of threads to use for the given setting (0 means all
+ * available cores).
+ */
+inline size_t KernelMatrixThreads(const size_t threads)
+{
+  return Threads::Count(threads);
+}
+
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel,
+                  const arma::mat& data,
+                  arma::mat& kernelMatrix,
+                  const size_t threads)
+{
+  const size_t n = data.n_cols;
+  kernelMatrix.set_size(n, n);
+
+  // Number the blocks on and above the diagonal row by row.
+  const size_t blocks = (n + kernelMatrixBlockSize - 1) /
+      kernelMatrixBlockSize;
+  const size_t blockPairs = blocks * (blocks + 1) / 2;
+
+  #pragma omp parallel for num_threads(KernelMatrixThreads(threads)) \
+      schedule(dynamic, 1)
+  for (int pair = 0; pair < (int) blockPairs; ++pair)
+  {
+    // Find the block row and block column of this pair.
+    size_t blockRow = 0;
+    size_t offset = (size_t) pair;
+    while (offset >= blocks - blockRow)
+    {
+      offset -= blocks - blockRow;
+      ++blockRow;
+    }
+    const size_t blockCol = blockRow + offset;
+
+    const size_t rowBegin = blockRow * kernelMatrixBlockSize;
+    const size_t rowCount = std::min(kernelMatrixBlockSize, n - rowBegin);
+    const size_t colBegin = blockCol * kernelMatrixBlockSize;
+    const size_t colCount = std::min(kernelMatrixBlockSize, n - colBegin);
+
+    // KernelBlock gives one row for each of its reference points.
+    arma::mat block;
+    KernelBlock<KernelType>::Evaluate(kernel, data, colBegin, colCount, data,
+        rowBegin, rowCount, block);
+
+    kernelMatrix.submat(rowBegin, colBegin, rowBegin + rowCount - 1,
+        colBegin + colCount - 1) = block;
+
+    if (blockRow != blockCol)
+    {
+      kernelMatrix.submat(colBegin, rowBegin, colBegin + colCount - 1,
+          rowBegin + rowCount - 1) = trans(block);
+      continue;
+    }
+
+    // On the diagonal, mirror the upper triangle of the block so the result is
+    // exactly symmetric, and evaluate the diagonal itself directly, where
+    // roundoff in the distance-based blocks would be most visible.
+    for (size_t j = 0; j < colCount; ++j)
+    {
+      const size_t col = colBegin + j;
+      for (size_t i = j + 1; i < rowCount; ++i)
+        kernelMatrix(rowBegin + i, col) = kernelMatrix(col, rowBegin + i);
+
+      kernelMatrix(col, col) = kernel.Evaluate(data.unsafe_col(col),
+          data.unsafe_col(col));
+    }
+  }
+}
+
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel,
+                  const arma::mat& a,
+                  const arma::mat& b,
+                  arma::mat& kernelMatrix,
+                  const size_t threads)
+{
+  kernelMatrix.set_size(a.n_cols, b.n_cols);
+
+  const size_t rowBlocks = (a.n_cols + kernelMatrixBlockSize - 1) /
+      kernelMatrixBlockSize;
+  const size_t colBlocks = (b.n_cols + kernelMatrixBlockSize - 1) /
+      kernelMatrixBlockSize;
+
+  #pragma omp parallel for num_threads(KernelMatrixThreads(threads)) \
+      schedule(dynamic, 1)
+  for (int pair = 0; pair < (int) (rowBlocks * colBlocks); ++pair)
+  {
+    const size_t rowBegin = (pair % rowBlocks) * kernelMatrixBlockSize;
+    const size_t rowCount = std::min(kernelMatrixBlockSize,
+        (size_t) a.n_cols - rowBegin);
+    const size_t colBegin = (pair / rowBlocks) * kernelMatrixBlockSize;
+    const size_t colCount = std::min(kernelMatrixBlockSize,
+        (size_t) b.n_cols - colBegin);
+
+    arma::mat block;
+    KernelBlock<KernelType>::Evaluate(kernel, b, colBegin, colCount, a,
+        rowBegin, rowCount, block);
+
+    kernelMatrix.submat(rowBegin, colBegin, rowBegin + rowCount - 1,
+        colBegin + colCount - 1) = block;
+  }
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
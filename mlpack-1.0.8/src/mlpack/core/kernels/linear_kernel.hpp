@@ -62,6 +62,21 @@ class LinearKernel
   {
     return arma::dot(a, b);
   }
+
+  /**
+   * Evaluation of the dot product of dense vectors, with math::Dot() (which
+   * uses NEON on ARM targets).
+   */
+  static double Evaluate(const arma::vec& a, const arma::vec& b)
+  {
+    return math::Dot(a.memptr(), b.memptr(), a.n_elem);
+  }
+
+  //! Evaluation of the dot product of dense single-precision vectors.
+  static double Evaluate(const arma::fvec& a, const arma::fvec& b)
+  {
+    return math::Dot(a.memptr(), b.memptr(), a.n_elem);
+  }
 };
 
 }; // namespace kernel
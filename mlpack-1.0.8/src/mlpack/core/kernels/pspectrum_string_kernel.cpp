@@ -25,10 +25,40 @@
  */
 #include "pspectrum_string_kernel.hpp"
 
+#include <algorithm>
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::kernel;
 
+namespace {
+
+//! The code of each character in a substring identifier: 0-9 for digits and
+//! 10-35 for letters (in either case), or -1 for any other character.
+int CharacterCode(const char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'z')
+    return 10 + (c - 'a');
+  if (c >= 'A' && c <= 'Z')
+    return 10 + (c - 'A');
+  return -1;
+}
+
+//! Scramble the bits of a 64-bit integer (the SplitMix64 finalizer).
+uint64_t Mix(uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+//! Substrings of at most this length are numbered exactly in base 36.
+const size_t maxExactLength = 12;
+
+}; // anonymous namespace
+
 /**
  * Initialize the PSpectrumStringKernel with the given string datasets.  For
  * more information on this, see the general class documentation.
@@ -40,13 +70,112 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
     const std::vector<std::vector<std::string> >& datasets,
     const size_t p) :
     datasets(datasets),
+    countsBuilt(false),
     p(p)
 {
-  // We have to assemble the counts of substrings.  This is not a particularly
-  // fast operation, unfortunately, but it only needs to be done once.
-  Log::Info << "Assembling counts of substrings of length " << p << "."
+  // We have to assemble the spectra of the strings.  This only needs to be
+  // done once, and the strings are independent, so they are indexed in
+  // parallel.
+  Log::Info << "Assembling spectra of substrings of length " << p << "."
       << std::endl;
 
+  // Resize for number of datasets.
+  spectra.resize(datasets.size());
+
+  for (size_t dataset = 0; dataset < datasets.size(); ++dataset)
+  {
+    const std::vector<std::string>& set = datasets[dataset];
+
+    // Resize for number of strings in dataset.
+    spectra[dataset].resize(set.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int index = 0; index < (int) set.size(); ++index)
+      ComputeSpectrum(set[index], spectra[dataset][index]);
+  }
+
+  Log::Info << "Substring extraction complete." << std::endl;
+}
+
+void PSpectrumStringKernel::ComputeSpectrum(const std::string& str,
+                                            Spectrum& spectrum) const
+{
+  spectrum.clear();
+  if (p == 0 || str.length() < p)
+    return;
+
+  std::vector<uint64_t> ids;
+  ids.reserve(str.length() - p + 1);
+
+  if (p <= maxExactLength)
+  {
+    // Roll a base-36 number over the string; 'valid' is the number of
+    // alphanumeric characters at the end of the current window.
+    uint64_t top = 1;
+    for (size_t j = 1; j < p; ++j)
+      top *= 36;
+
+    uint64_t id = 0;
+    size_t valid = 0;
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+      const int code = CharacterCode(str[i]);
+      if (code < 0)
+      {
+        id = 0;
+        valid = 0;
+        continue;
+      }
+
+      if (valid == p)
+        id -= (uint64_t) CharacterCode(str[i - p]) * top;
+      else
+        ++valid;
+
+      id = 36 * id + (uint64_t) code;
+      if (valid == p)
+        ids.push_back(id);
+    }
+  }
+  else
+  {
+    // Longer substrings are hashed.
+    for (size_t start = 0; start + p <= str.length(); ++start)
+    {
+      uint64_t id = 0;
+      bool invalid = false;
+      for (size_t j = 0; j < p; ++j)
+      {
+        const int code = CharacterCode(str[start + j]);
+        if (code < 0)
+        {
+          invalid = true;
+          break; // Only consider substrings with alphanumerics.
+        }
+
+        id = Mix(id + (uint64_t) code + 1);
+      }
+
+      if (!invalid)
+        ids.push_back(id);
+    }
+  }
+
+  // Sort the identifiers and count each one.
+  std::sort(ids.begin(), ids.end());
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    if (spectrum.empty() || spectrum.back().first != ids[i])
+      spectrum.push_back(std::make_pair(ids[i], 0));
+    ++spectrum.back().second;
+  }
+}
+
+void PSpectrumStringKernel::BuildCounts() const
+{
+  if (countsBuilt)
+    return;
+
   // Resize for number of datasets.
   counts.resize(datasets.size());
 
@@ -73,7 +202,7 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
         bool invalid = false;
         for (size_t j = 0; j < p; ++j)
         {
-          if (!isalnum(sub[j]))
+          if (CharacterCode(sub[j]) < 0)
           {
             invalid = true;
             break; // Only consider substrings with alphanumerics.
@@ -94,5 +223,5 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
     }
   }
 
-  Log::Info << "Substring extraction complete." << std::endl;
+  countsBuilt = true;
 }
@@ -29,6 +29,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <utility>
 
 #include <mlpack/core.hpp>
 
@@ -70,6 +71,12 @@ namespace kernel {
  * the data according to the fake data matrix -- resulting in a meaningless
  * tree.  This kernel was originally written for the FastMKS method; so, at the
  * very least, it will work with that.
+ *
+ * When the kernel is created, the substrings of each string are turned into
+ * integer identifiers (exact for p <= 12, and a 64-bit hash for longer
+ * substrings) and stored with their counts as a sorted sparse vector (see
+ * Spectra()), so evaluating the kernel is a merge of two sorted arrays.  The
+ * strings are indexed in parallel when OpenMP is available.
  */
 class PSpectrumStringKernel
 {
@@ -98,12 +105,19 @@ class PSpectrumStringKernel
   template<typename VecType>
   double Evaluate(const VecType& a, const VecType& b) const;
 
-  //! Access the lists of substrings.
+  //! A string's substring identifiers and their counts, sorted by identifier.
+  typedef std::vector<std::pair<uint64_t, int> > Spectrum;
+
+  //! Access the substring spectra of each string of each dataset.
+  const std::vector<std::vector<Spectrum> >& Spectra() const { return spectra; }
+
+  //! Access the lists of substrings.  These are not used by Evaluate(); they
+  //! are built from the strings the first time they are accessed.
   const std::vector<std::vector<std::map<std::string, int> > >& Counts() const
-  { return counts; }
-  //! Modify the lists of substrings.
+  { BuildCounts(); return counts; }
+  //! Modify the lists of substrings.  Changing them does not change the kernel.
   std::vector<std::vector<std::map<std::string, int> > >& Counts()
-  { return counts; }
+  { BuildCounts(); return counts; }
 
   //! Access the value of p.
   size_t P() const { return p; }
@@ -114,12 +128,30 @@ class PSpectrumStringKernel
   //! The datasets.
   const std::vector<std::vector<std::string> >& datasets;
 
-  //! Mappings of the datasets to counts of substrings.  Such a huge structure
-  //! is not wonderful...
-  std::vector<std::vector<std::map<std::string, int> > > counts;
+  //! The substring spectrum of each string of each dataset.
+  std::vector<std::vector<Spectrum> > spectra;
+
+  //! Mappings of the datasets to counts of substrings, built on demand by
+  //! Counts().
+  mutable std::vector<std::vector<std::map<std::string, int> > > counts;
+  //! Whether the counts have been built.
+  mutable bool countsBuilt;
 
   //! The value of p to use in calculation.
   size_t p;
+
+  /**
+   * Compute the spectrum of the given string: the identifiers of its
+   * substrings of length p which contain only alphanumeric characters (in
+   * lowercase), with their counts, sorted by identifier.
+   *
+   * @param str String to index.
+   * @param spectrum Vector to store the spectrum in.
+   */
+  void ComputeSpectrum(const std::string& str, Spectrum& spectrum) const;
+
+  //! Build the maps of Counts() from the strings, if not done yet.
+  void BuildCounts() const;
 };
 
 }; // namespace kernel
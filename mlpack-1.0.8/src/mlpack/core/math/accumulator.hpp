@@ -0,0 +1,146 @@
+/**
+ * @file accumulator.hpp
+ *
+ * The types in which sums over datasets are accumulated.  Single-precision
+ * datasets are summed in double precision, so that long sums (centroids,
+ * moments) keep their accuracy while the data keeps the smaller storage.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_ACCUMULATOR_HPP
+#define __MLPACK_CORE_MATH_ACCUMULATOR_HPP
+
+#include <mlpack/core/arma_extend/arma_extend.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * The type in which sums of elements (or of columns of matrices) of type T are
+ * accumulated: T itself, except that float is widened to double and
+ * single-precision matrices and vectors to double-precision ones.
+ */
+template<typename T>
+struct AccumulatorType
+{
+  typedef T type;
+};
+
+//! Floats are summed in double precision.
+template<>
+struct AccumulatorType<float>
+{
+  typedef double type;
+};
+
+//! Single-precision matrices are summed in double precision.
+template<>
+struct AccumulatorType<arma::Mat<float> >
+{
+  typedef arma::mat type;
+};
+
+//! Single-precision vectors are summed in double precision.
+template<>
+struct AccumulatorType<arma::Col<float> >
+{
+  typedef arma::vec type;
+};
+
+/**
+ * Sparse matrices are summed into dense matrices, since sums of many sparse
+ * points (such as the centroids of k-means) are mostly nonzero; the elements
+ * are widened as above.
+ */
+template<typename eT>
+struct AccumulatorType<arma::SpMat<eT> >
+{
+  typedef arma::Mat<typename AccumulatorType<eT>::type> type;
+};
+
+/**
+ * Add column i of the given data to column j of the given sums.
+ *
+ * @param sums Sums, of the accumulator type of the data.
+ * @param j Column of the sums to add to.
+ * @param data Dataset.
+ * @param i Column of the dataset to add.
+ */
+template<typename SumType, typename MatType>
+inline void Accumulate(SumType& sums,
+                       const size_t j,
+                       const MatType& data,
+                       const size_t i)
+{
+  sums.col(j) += data.col(i);
+}
+
+//! Add a column of single-precision data to double-precision sums, widening
+//! each element.
+inline void Accumulate(arma::mat& sums,
+                       const size_t j,
+                       const arma::Mat<float>& data,
+                       const size_t i)
+{
+  double* sum = sums.colptr(j);
+  const float* point = data.colptr(i);
+  for (size_t k = 0; k < data.n_rows; ++k)
+    sum[k] += (double) point[k];
+}
+
+//! Add a column of sparse data to dense sums, visiting only its nonzero
+//! elements.
+template<typename SumElemType, typename eT>
+inline void Accumulate(arma::Mat<SumElemType>& sums,
+                       const size_t j,
+                       const arma::SpMat<eT>& data,
+                       const size_t i)
+{
+  SumElemType* sum = sums.colptr(j);
+  for (size_t k = data.col_ptrs[i]; k < data.col_ptrs[i + 1]; ++k)
+    sum[data.row_indices[k]] += (SumElemType) data.values[k];
+}
+
+/**
+ * Store accumulated values (such as means computed from sums) in a matrix of
+ * the type of the data, rounding them if the data has less precision.
+ *
+ * @param accumulated Values, of the accumulator type of the data.
+ * @param out Matrix to store the values in.
+ */
+template<typename MatType>
+inline void Narrow(const MatType& accumulated, MatType& out)
+{
+  out = accumulated;
+}
+
+//! Round double-precision values to single precision.
+inline void Narrow(const arma::mat& accumulated, arma::Mat<float>& out)
+{
+  out = arma::conv_to<arma::Mat<float> >::from(accumulated);
+}
+
+//! Store dense accumulated values in a sparse matrix of the type of the data.
+template<typename eT>
+inline void Narrow(const arma::mat& accumulated, arma::SpMat<eT>& out)
+{
+  out = arma::SpMat<eT>(arma::conv_to<arma::Mat<eT> >::from(accumulated));
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file covariance_accumulator.cpp
+ *
+ * Implementation of the CovarianceAccumulator class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "covariance_accumulator.hpp"
+
+using namespace mlpack;
+using namespace mlpack::math;
+
+CovarianceAccumulator::CovarianceAccumulator(const size_t dimensionality,
+                                             const size_t blockSize) :
+    count(0),
+    blockSize(blockSize)
+{
+  mean.zeros(dimensionality);
+  scatter.zeros(dimensionality, dimensionality);
+}
+
+void CovarianceAccumulator::Add(const arma::mat& points)
+{
+  if (points.n_cols == 0)
+    return;
+
+  if (count == 0 && mean.n_elem == 0)
+  {
+    mean.zeros(points.n_rows);
+    scatter.zeros(points.n_rows, points.n_rows);
+  }
+  else if (points.n_rows != mean.n_elem)
+  {
+    Log::Fatal << "CovarianceAccumulator::Add(): points have dimensionality "
+        << points.n_rows << ", but the accumulator has dimensionality "
+        << mean.n_elem << "." << std::endl;
+  }
+
+  const size_t step = std::max(blockSize, (size_t) 1);
+  arma::mat centered;
+  for (size_t begin = 0; begin < points.n_cols; begin += step)
+  {
+    const size_t end = std::min(begin + step, (size_t) points.n_cols) - 1;
+
+    // Center the block on its own mean, so that its scatter matrix is one
+    // product.
+    centered = points.cols(begin, end);
+    const arma::vec blockMean = arma::sum(centered, 1) / centered.n_cols;
+    for (size_t i = 0; i < centered.n_cols; ++i)
+      centered.col(i) -= blockMean;
+
+    Combine(centered.n_cols, blockMean, centered * trans(centered));
+  }
+}
+
+void CovarianceAccumulator::Merge(const CovarianceAccumulator& other)
+{
+  if (other.count == 0)
+    return;
+
+  if (count == 0)
+  {
+    count = other.count;
+    mean = other.mean;
+    scatter = other.scatter;
+    return;
+  }
+
+  if (other.mean.n_elem != mean.n_elem)
+    Log::Fatal << "CovarianceAccumulator::Merge(): cannot merge statistics of "
+        << "dimensionality " << other.mean.n_elem << " with statistics of "
+        << "dimensionality " << mean.n_elem << "." << std::endl;
+
+  Combine(other.count, other.mean, other.scatter);
+}
+
+void CovarianceAccumulator::Covariance(arma::mat& covariance) const
+{
+  if (count < 2)
+    covariance.zeros(mean.n_elem, mean.n_elem);
+  else
+    covariance = scatter / (double) (count - 1);
+}
+
+void CovarianceAccumulator::Reset()
+{
+  count = 0;
+  mean.zeros();
+  scatter.zeros();
+}
+
+void CovarianceAccumulator::Combine(const size_t otherCount,
+                                    const arma::vec& otherMean,
+                                    const arma::mat& otherScatter)
+{
+  const double n = (double) count;
+  const double m = (double) otherCount;
+  const double total = n + m;
+
+  // The scatter of the union is the sum of the scatters plus the scatter of
+  // the two means around the mean of the union.
+  const arma::vec delta = otherMean - mean;
+  scatter += otherScatter + (n * m / total) * (delta * trans(delta));
+  mean += (m / total) * delta;
+  count += otherCount;
+}
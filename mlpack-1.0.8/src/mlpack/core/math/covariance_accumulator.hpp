@@ -0,0 +1,127 @@
+/**
+ * @file covariance_accumulator.hpp
+ *
+ * Definition of the CovarianceAccumulator class, which computes the mean and
+ * covariance of a set of points which is given a block at a time.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_COVARIANCE_ACCUMULATOR_HPP
+#define __MLPACK_CORE_MATH_COVARIANCE_ACCUMULATOR_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Accumulate the mean and covariance of a set of points (one per column) which
+ * is given a block of columns at a time, so that no centered copy of the whole
+ * set is needed (as it is for ccov()).  Each block is centered on its own mean
+ * and its scatter matrix is computed with one matrix product; the statistics
+ * of the blocks are then combined with the pairwise update of Chan et al.,
+ * which is as accurate as centering the whole set at once.  Accumulators which
+ * have seen different parts of a set (for instance, in different threads) can
+ * be combined with Merge().
+ *
+ * @code
+ * CovarianceAccumulator accumulator;
+ * while (reader.ReadChunk(chunk))
+ *   accumulator.Add(chunk);
+ *
+ * arma::mat covariance;
+ * accumulator.Covariance(covariance);
+ * @endcode
+ */
+class CovarianceAccumulator
+{
+ public:
+  /**
+   * Create an empty accumulator.
+   *
+   * @param dimensionality Dimensionality of the points; if 0, it is taken
+   *     from the first points given to Add().
+   * @param blockSize Number of columns which are centered at a time; this
+   *     bounds the temporary memory used by Add().
+   */
+  CovarianceAccumulator(const size_t dimensionality = 0,
+                        const size_t blockSize = 4096);
+
+  /**
+   * Add the given points (one per column) to the statistics.
+   *
+   * @param points Points to add.
+   */
+  void Add(const arma::mat& points);
+
+  /**
+   * Add the statistics of another accumulator to this one, as if its points
+   * had been given to Add().
+   *
+   * @param other Accumulator to merge.
+   */
+  void Merge(const CovarianceAccumulator& other);
+
+  /**
+   * Compute the covariance of the points added so far, normalized by N - 1 as
+   * ccov() is (or zeros if fewer than two points were added).
+   *
+   * @param covariance Matrix to store the covariance in.
+   */
+  void Covariance(arma::mat& covariance) const;
+
+  //! Forget all the points added so far.
+  void Reset();
+
+  //! Get the number of points added so far.
+  size_t Count() const { return count; }
+  //! Get the mean of the points added so far.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the scatter matrix (the sum of the outer products of the centered
+  //! points) of the points added so far.
+  const arma::mat& Scatter() const { return scatter; }
+
+  //! Get the number of columns which are centered at a time.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of columns which are centered at a time.
+  size_t& BlockSize() { return blockSize; }
+
+ private:
+  //! The number of points added so far.
+  size_t count;
+  //! The mean of the points added so far.
+  arma::vec mean;
+  //! The scatter matrix of the points added so far.
+  arma::mat scatter;
+  //! The number of columns which are centered at a time.
+  size_t blockSize;
+
+  /**
+   * Combine the statistics of a set of points with the statistics so far.
+   *
+   * @param otherCount Number of points in the set.
+   * @param otherMean Mean of the set.
+   * @param otherScatter Scatter matrix of the set.
+   */
+  void Combine(const size_t otherCount,
+               const arma::vec& otherMean,
+               const arma::mat& otherScatter);
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
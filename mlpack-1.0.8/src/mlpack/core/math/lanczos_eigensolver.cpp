@@ -0,0 +1,61 @@
+/**
+ * @file lanczos_eigensolver.cpp
+ *
+ * Implementation of the non-template parts of LanczosEigensolver.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "lanczos_eigensolver.hpp"
+
+using namespace mlpack;
+using namespace mlpack::math;
+
+LanczosEigensolver::LanczosEigensolver(const double tolerance,
+                                       const size_t maxRestarts,
+                                       const size_t subspaceSize) :
+    tolerance(tolerance),
+    maxRestarts(maxRestarts),
+    subspaceSize(subspaceSize),
+    restarts(0),
+    products(0)
+{ /* Nothing to do. */ }
+
+bool LanczosEigensolver::Solve(const arma::mat& matrix,
+                               const size_t k,
+                               arma::vec& eigval,
+                               arma::mat& eigvec)
+{
+  if (matrix.n_rows != matrix.n_cols)
+    Log::Fatal << "LanczosEigensolver::Solve(): the matrix must be square."
+        << std::endl;
+
+  MatrixOperator op(matrix);
+  return Solve(op, k, eigval, eigvec);
+}
+
+arma::vec LanczosEigensolver::Orthogonalize(const arma::mat& basis,
+                                            const size_t columns,
+                                            arma::vec& vector)
+{
+  const arma::mat span = basis.cols(0, columns - 1);
+  arma::vec projections = trans(span) * vector;
+  vector -= span * projections;
+
+  const arma::vec correction = trans(span) * vector;
+  vector -= span * correction;
+
+  return projections + correction;
+}
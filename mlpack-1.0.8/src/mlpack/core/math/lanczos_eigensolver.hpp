@@ -0,0 +1,172 @@
+/**
+ * @file lanczos_eigensolver.hpp
+ *
+ * Find the largest eigenvalues of a symmetric matrix, or of an operator given
+ * only by its products with vectors, with the thick-restart Lanczos method.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_LANCZOS_EIGENSOLVER_HPP
+#define __MLPACK_CORE_MATH_LANCZOS_EIGENSOLVER_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * The operator of a dense symmetric matrix, for LanczosEigensolver.  Other
+ * operators (a kernel matrix whose entries are computed on the fly, for
+ * instance) need the same two methods.
+ */
+class MatrixOperator
+{
+ public:
+  //! Wrap the given matrix, which must outlive the operator.
+  MatrixOperator(const arma::mat& matrix) : matrix(matrix) { }
+
+  //! Get the number of rows (and columns) of the operator.
+  size_t Size() const { return matrix.n_rows; }
+
+  //! Compute y = A x.
+  void Apply(const arma::vec& x, arma::vec& y) const { y = matrix * x; }
+
+ private:
+  //! The matrix.
+  const arma::mat& matrix;
+};
+
+/**
+ * Find the k largest eigenvalues, and their eigenvectors, of a symmetric
+ * matrix or operator with the thick-restart Lanczos method (Wu and Simon,
+ * 2000), which is equivalent to the implicitly restarted Lanczos method but
+ * simpler.  Only products of the operator with vectors are needed, so when k is
+ * much smaller than the size n of the operator, this is much faster than a
+ * full eigendecomposition (arma::eig_sym() takes O(n^3) time): each restart
+ * takes about SubspaceSize() products and O(n SubspaceSize()^2) time.
+ *
+ * The Krylov basis is fully reorthogonalized, so it holds SubspaceSize()
+ * vectors of size n.  At each restart, the Ritz vectors of the largest
+ * half of the Ritz values are kept, and the search converges when the residual
+ * ||A x - lambda x|| of each of the k wanted pairs is at most Tolerance()
+ * times the largest Ritz value (in magnitude).
+ *
+ * An operator must have the methods
+ *
+ * @code
+ * size_t Size() const;                                 // n
+ * void Apply(const arma::vec& x, arma::vec& y) const;  // y = A x
+ * @endcode
+ *
+ * @code
+ * LanczosEigensolver solver;
+ * arma::vec eigval;
+ * arma::mat eigvec;
+ * if (!solver.Solve(kernelMatrix, 10, eigval, eigvec))
+ *   Log::Warn << "Lanczos did not converge." << std::endl;
+ * @endcode
+ */
+class LanczosEigensolver
+{
+ public:
+  /**
+   * Create the solver.
+   *
+   * @param tolerance Largest relative residual of the eigenpairs found.
+   * @param maxRestarts Largest number of restarts.
+   * @param subspaceSize Number of vectors in the Krylov basis; if 0, the
+   *     larger of 2k + 1 and k + 20 is used (at most n).
+   */
+  LanczosEigensolver(const double tolerance = 1e-10,
+                     const size_t maxRestarts = 1000,
+                     const size_t subspaceSize = 0);
+
+  /**
+   * Find the k largest eigenvalues of the given symmetric operator, and their
+   * eigenvectors.  If the search does not converge within MaxRestarts()
+   * restarts, the best approximations found are given and false is returned.
+   *
+   * @param op Symmetric operator.
+   * @param k Number of eigenvalues to find (at most op.Size()).
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   * @param eigvec Matrix to store the (orthonormal) eigenvectors in, one per
+   *     column.
+   * @return Whether the search converged.
+   */
+  template<typename OperatorType>
+  bool Solve(const OperatorType& op,
+             const size_t k,
+             arma::vec& eigval,
+             arma::mat& eigvec);
+
+  /**
+   * Find the k largest eigenvalues of the given symmetric matrix, and their
+   * eigenvectors (see the other overload).
+   */
+  bool Solve(const arma::mat& matrix,
+             const size_t k,
+             arma::vec& eigval,
+             arma::mat& eigvec);
+
+  //! Get the largest relative residual of the eigenpairs found.
+  double Tolerance() const { return tolerance; }
+  //! Modify the largest relative residual of the eigenpairs found.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the largest number of restarts.
+  size_t MaxRestarts() const { return maxRestarts; }
+  //! Modify the largest number of restarts.
+  size_t& MaxRestarts() { return maxRestarts; }
+
+  //! Get the number of vectors in the Krylov basis (0 chooses it from k).
+  size_t SubspaceSize() const { return subspaceSize; }
+  //! Modify the number of vectors in the Krylov basis (0 chooses it from k).
+  size_t& SubspaceSize() { return subspaceSize; }
+
+  //! Get the number of restarts of the last Solve().
+  size_t Restarts() const { return restarts; }
+  //! Get the number of products with the operator of the last Solve().
+  size_t Products() const { return products; }
+
+ private:
+  //! The largest relative residual of the eigenpairs found.
+  double tolerance;
+  //! The largest number of restarts.
+  size_t maxRestarts;
+  //! The number of vectors in the Krylov basis.
+  size_t subspaceSize;
+  //! The number of restarts of the last Solve().
+  size_t restarts;
+  //! The number of products with the operator of the last Solve().
+  size_t products;
+
+  /**
+   * Orthogonalize the vector against the first columns of the basis, twice
+   * (which is enough for full working precision), and return the projections
+   * removed.
+   */
+  static arma::vec Orthogonalize(const arma::mat& basis,
+                                 const size_t columns,
+                                 arma::vec& vector);
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+// Include implementation.
+#include "lanczos_eigensolver_impl.hpp"
+
+#endif
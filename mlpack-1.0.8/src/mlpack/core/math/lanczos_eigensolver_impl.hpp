@@ -0,0 +1,138 @@
+/**
+ * @file lanczos_eigensolver_impl.hpp
+ *
+ * Implementation of LanczosEigensolver::Solve().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_LANCZOS_EIGENSOLVER_IMPL_HPP
+#define __MLPACK_CORE_MATH_LANCZOS_EIGENSOLVER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lanczos_eigensolver.hpp"
+
+namespace mlpack {
+namespace math {
+
+template<typename OperatorType>
+bool LanczosEigensolver::Solve(const OperatorType& op,
+                               const size_t k,
+                               arma::vec& eigval,
+                               arma::mat& eigvec)
+{
+  const size_t n = op.Size();
+  if (k == 0 || k > n)
+    Log::Fatal << "LanczosEigensolver::Solve(): cannot find " << k
+        << " eigenvalues of an operator of size " << n << "." << std::endl;
+
+  size_t m = (subspaceSize == 0) ? std::max(2 * k + 1, k + 20) : subspaceSize;
+  m = std::min(std::max(m, k + 1), n);
+
+  // The Krylov basis, with one more column for the next vector, and the
+  // projection of the operator onto the basis.
+  arma::mat basis(n, m + 1);
+  arma::mat projected = arma::zeros<arma::mat>(m, m);
+
+  arma::vec start = arma::randn<arma::vec>(n);
+  basis.col(0) = start / norm(start, 2);
+
+  arma::vec ritzValues;
+  arma::mat ritzVectors;
+  arma::vec current;
+  arma::vec next;
+  double beta = 0.0;
+  size_t kept = 0;
+  bool converged = false;
+  restarts = 0;
+  products = 0;
+  while (true)
+  {
+    // Extend the basis from the kept Ritz vectors and the residual.  The
+    // projections on the kept vectors give the couplings of the restart.
+    for (size_t j = kept; j < m; ++j)
+    {
+      current = basis.col(j);
+      op.Apply(current, next);
+      ++products;
+
+      const arma::vec h = Orthogonalize(basis, j + 1, next);
+      for (size_t i = 0; i <= j; ++i)
+      {
+        projected(i, j) = h[i];
+        projected(j, i) = h[i];
+      }
+
+      // If the basis spans an invariant subspace, continue with any vector
+      // orthogonal to it; the residual of the basis is then 0.
+      beta = norm(next, 2);
+      if (beta <= 1e-12 * norm(h, 2))
+      {
+        beta = 0.0;
+        if (j + 1 == m)
+          break;
+
+        next = arma::randn<arma::vec>(n);
+        Orthogonalize(basis, j + 1, next);
+        basis.col(j + 1) = next / norm(next, 2);
+      }
+      else
+      {
+        basis.col(j + 1) = next / beta;
+      }
+    }
+
+    // The residual of each Ritz pair is beta times the last element of its
+    // vector.
+    arma::eig_sym(ritzValues, ritzVectors, projected);
+    const double scale = std::max(std::abs(ritzValues[0]),
+        std::abs(ritzValues[m - 1]));
+
+    converged = true;
+    for (size_t i = m - k; i < m; ++i)
+      if (beta * std::abs(ritzVectors(m - 1, i)) > tolerance * scale)
+        converged = false;
+
+    if (converged || restarts == maxRestarts)
+      break;
+
+    // Restart with the Ritz vectors of the largest Ritz values, and the
+    // residual as the next vector.
+    ++restarts;
+    kept = std::min(k + (m - k) / 2, m - 1);
+    const arma::mat keptVectors = basis.cols(0, m - 1) *
+        ritzVectors.cols(m - kept, m - 1);
+    basis.cols(0, kept - 1) = keptVectors;
+    basis.col(kept) = basis.col(m);
+
+    projected.zeros();
+    for (size_t i = 0; i < kept; ++i)
+      projected(i, i) = ritzValues[m - kept + i];
+  }
+
+  Log::Debug << "Lanczos: " << restarts << " restarts, " << products
+      << " products." << std::endl;
+
+  // The largest eigenvalues come first.
+  eigval = arma::flipud(ritzValues.subvec(m - k, m - 1));
+  eigvec = basis.cols(0, m - 1) * arma::fliplr(ritzVectors.cols(m - k, m - 1));
+
+  return converged;
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -52,10 +52,32 @@ void mlpack::math::VectorPower(arma::vec& vec, double power)
  */
 void mlpack::math::Center(const arma::mat& x, arma::mat& xCentered)
 {
+  // The copy is the only full-size matrix made; then center it in place.
+  if (&xCentered != &x)
+    xCentered = x;
+
+  Center(xCentered);
+}
+
+/**
+ * Centers a matrix in place, by subtracting the mean of the columns from each
+ * column.
+ */
+void mlpack::math::Center(arma::mat& x)
+{
+  if (x.n_cols == 0)
+    return;
+
   // Get the mean of the elements in each row.
-  arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
+  const arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
 
-  xCentered = x - arma::repmat(rowMean, 1, x.n_cols);
+  #pragma omp parallel for if (x.n_elem > 65536)
+  for (int i = 0; i < (int) x.n_cols; ++i)
+  {
+    double* column = x.colptr(i);
+    for (size_t j = 0; j < x.n_rows; ++j)
+      column[j] -= rowMean[j];
+  }
 }
 
 /**
@@ -67,35 +89,70 @@ void mlpack::math::WhitenUsingSVD(const arma::mat& x,
                                   arma::mat& xWhitened,
                                   arma::mat& whiteningMatrix)
 {
-  arma::mat covX, u, v, invSMatrix, temp1;
-  arma::vec sVector;
+  CovarianceAccumulator accumulator;
+  accumulator.Add(x);
 
-  covX = ccov(x);
+  arma::mat covX;
+  accumulator.Covariance(covX);
+  WhiteningMatrixUsingSVD(covX, whiteningMatrix);
 
-  svd(u, sVector, v, covX);
+  if (&xWhitened == &x)
+    ApplyWhitening(whiteningMatrix, xWhitened);
+  else
+    xWhitened = whiteningMatrix * x;
+}
+
+/**
+ * Whitens a matrix using the eigendecomposition of the covariance matrix.
+ * Whitening means the covariance matrix of the result is the identity matrix.
+ */
+void mlpack::math::WhitenUsingEig(const arma::mat& x,
+                                  arma::mat& xWhitened,
+                                  arma::mat& whiteningMatrix)
+{
+  CovarianceAccumulator accumulator;
+  accumulator.Add(x);
+
+  arma::mat covX;
+  accumulator.Covariance(covX);
+  WhiteningMatrixUsingEig(covX, whiteningMatrix);
+
+  // Now apply the whitening matrix.
+  if (&xWhitened == &x)
+    ApplyWhitening(whiteningMatrix, xWhitened);
+  else
+    xWhitened = whiteningMatrix * x;
+}
+
+/**
+ * Computes the whitening matrix of WhitenUsingSVD() from a covariance matrix.
+ */
+void mlpack::math::WhiteningMatrixUsingSVD(const arma::mat& covariance,
+                                           arma::mat& whiteningMatrix)
+{
+  arma::mat u, v, invSMatrix;
+  arma::vec sVector;
+
+  svd(u, sVector, v, covariance);
 
   size_t d = sVector.n_elem;
   invSMatrix.zeros(d, d);
   invSMatrix.diag() = 1 / sqrt(sVector);
 
   whiteningMatrix = v * invSMatrix * trans(u);
-
-  xWhitened = whiteningMatrix * x;
 }
 
 /**
- * Whitens a matrix using the eigendecomposition of the covariance matrix.
- * Whitening means the covariance matrix of the result is the identity matrix.
+ * Computes the whitening matrix of WhitenUsingEig() from a covariance matrix.
  */
-void mlpack::math::WhitenUsingEig(const arma::mat& x,
-                                  arma::mat& xWhitened,
-                                  arma::mat& whiteningMatrix)
+void mlpack::math::WhiteningMatrixUsingEig(const arma::mat& covariance,
+                                           arma::mat& whiteningMatrix)
 {
   arma::mat diag, eigenvectors;
   arma::vec eigenvalues;
 
-  // Get eigenvectors of covariance of input matrix.
-  eig_sym(eigenvalues, eigenvectors, ccov(x));
+  // Get eigenvectors of the covariance matrix.
+  eig_sym(eigenvalues, eigenvectors, covariance);
 
   // Generate diagonal matrix using 1 / sqrt(eigenvalues) for each value.
   VectorPower(eigenvalues, -0.5);
@@ -104,9 +161,31 @@ void mlpack::math::WhitenUsingEig(const arma::mat& x,
 
   // Our whitening matrix is diag(1 / sqrt(eigenvectors)) * eigenvalues.
   whiteningMatrix = diag * trans(eigenvectors);
+}
 
-  // Now apply the whitening matrix.
-  xWhitened = whiteningMatrix * x;
+/**
+ * Applies a whitening matrix to the columns of x in place, a block of columns
+ * at a time.
+ */
+void mlpack::math::ApplyWhitening(const arma::mat& whiteningMatrix,
+                                  arma::mat& x,
+                                  const size_t blockSize)
+{
+  if (whiteningMatrix.n_rows != x.n_rows ||
+      whiteningMatrix.n_cols != x.n_rows)
+    Log::Fatal << "ApplyWhitening(): whitening matrix is "
+        << whiteningMatrix.n_rows << "x" << whiteningMatrix.n_cols
+        << ", but the data has dimensionality " << x.n_rows << "."
+        << std::endl;
+
+  const size_t step = std::max(blockSize, (size_t) 1);
+  arma::mat block;
+  for (size_t begin = 0; begin < x.n_cols; begin += step)
+  {
+    const size_t end = std::min(begin + step, (size_t) x.n_cols) - 1;
+    block = whiteningMatrix * x.cols(begin, end);
+    x.cols(begin, end) = block;
+  }
 }
 
 /**
@@ -23,6 +23,7 @@
 #define __MLPACK_CORE_MATH_LIN_ALG_HPP
 
 #include <mlpack/core.hpp>
+#include "covariance_accumulator.hpp"
 
 /**
  * Linear algebra utility functions, generally performed on matrices or vectors.
@@ -40,16 +41,27 @@ void VectorPower(arma::vec& vec, double power);
 /**
  * Creates a centered matrix, where centering is done by subtracting
  * the sum over the columns (a column vector) from each column of the matrix.
+ * If x and xCentered are the same matrix, it is centered in place.
  *
  * @param x Input matrix
  * @param xCentered Matrix to write centered output into
  */
 void Center(const arma::mat& x, arma::mat& xCentered);
 
+/**
+ * Centers a matrix in place, by subtracting the mean of the columns from each
+ * column.  No temporary matrix of the size of x is made.
+ *
+ * @param x Matrix to center.
+ */
+void Center(arma::mat& x);
+
 /**
  * Whitens a matrix using the singular value decomposition of the covariance
  * matrix. Whitening means the covariance matrix of the result is the identity
- * matrix.
+ * matrix.  The covariance is accumulated a block of columns at a time (see
+ * CovarianceAccumulator), and if x and xWhitened are the same matrix, it is
+ * whitened in place.
  */
 void WhitenUsingSVD(const arma::mat& x,
                     arma::mat& xWhitened,
@@ -58,11 +70,49 @@ void WhitenUsingSVD(const arma::mat& x,
 /**
  * Whitens a matrix using the eigendecomposition of the covariance matrix.
  * Whitening means the covariance matrix of the result is the identity matrix.
+ * The covariance is accumulated a block of columns at a time (see
+ * CovarianceAccumulator), and if x and xWhitened are the same matrix, it is
+ * whitened in place.
  */
 void WhitenUsingEig(const arma::mat& x,
                     arma::mat& xWhitened,
                     arma::mat& whiteningMatrix);
 
+/**
+ * Computes the whitening matrix of WhitenUsingSVD() from a covariance matrix,
+ * for instance one from a CovarianceAccumulator which has seen the data a block
+ * at a time.  The whitening matrix can then be applied to any data with
+ * ApplyWhitening().
+ *
+ * @param covariance Covariance matrix of the data.
+ * @param whiteningMatrix Matrix to store the whitening matrix in.
+ */
+void WhiteningMatrixUsingSVD(const arma::mat& covariance,
+                             arma::mat& whiteningMatrix);
+
+/**
+ * Computes the whitening matrix of WhitenUsingEig() from a covariance matrix.
+ * The whitening matrix can then be applied to any data with ApplyWhitening().
+ *
+ * @param covariance Covariance matrix of the data.
+ * @param whiteningMatrix Matrix to store the whitening matrix in.
+ */
+void WhiteningMatrixUsingEig(const arma::mat& covariance,
+                             arma::mat& whiteningMatrix);
+
+/**
+ * Applies a whitening matrix to the columns of x in place, a block of columns
+ * at a time, so that only a block-sized temporary matrix is needed.
+ *
+ * @param whiteningMatrix Whitening matrix, from WhitenUsingSVD(),
+ *     WhitenUsingEig(), or one of the WhiteningMatrix functions.
+ * @param x Matrix to whiten.
+ * @param blockSize Number of columns transformed at a time.
+ */
+void ApplyWhitening(const arma::mat& whiteningMatrix,
+                    arma::mat& x,
+                    const size_t blockSize = 4096);
+
 /**
  * Overwrites a dimension-N vector to a random vector on the unit sphere in R^N.
  */
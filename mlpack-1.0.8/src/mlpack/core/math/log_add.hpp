@@ -0,0 +1,77 @@
+/**
+ * @file log_add.hpp
+ *
+ * Routines for adding numbers that are stored in log-space, without leaving
+ * log-space (and thus without underflowing).
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_LOG_ADD_HPP
+#define __MLPACK_CORE_MATH_LOG_ADD_HPP
+
+#include <mlpack/core/arma_extend/arma_extend.hpp>
+#include <math.h>
+#include <limits>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Internal log-addition: given log(x) and log(y), return log(x + y).  This is
+ * done without underflowing for very small x and y.  If both x and y are zero
+ * (their logs are -inf), -inf is returned.
+ *
+ * @param x Log of the first number.
+ * @param y Log of the second number.
+ * @return log(exp(x) + exp(y)).
+ */
+inline double LogAdd(const double x, const double y)
+{
+  const double larger = (x > y) ? x : y;
+  const double smaller = (x > y) ? y : x;
+
+  if (larger == -std::numeric_limits<double>::infinity())
+    return larger;
+
+  return larger + log1p(exp(smaller - larger));
+}
+
+/**
+ * Compute the log-sum-exp of each row of the given matrix; that is,
+ * y(i) = log(sum_j exp(x(i, j))).  The largest element of each row is factored
+ * out before exponentiating, so this does not underflow.  Rows where every
+ * element is -inf give -inf.
+ *
+ * @param x Matrix of log-values.
+ * @param y Vector to store the log-sum-exp of each row in.
+ */
+inline void LogSumExp(const arma::mat& x, arma::vec& y)
+{
+  // The largest element in each row; rows that are entirely -inf are shifted
+  // by zero instead so that we do not compute -inf - -inf.
+  arma::vec maxs = arma::max(x, 1);
+  for (size_t i = 0; i < maxs.n_elem; ++i)
+    if (maxs[i] == -std::numeric_limits<double>::infinity())
+      maxs[i] = 0.0;
+
+  y = log(arma::sum(exp(x - maxs * arma::ones<arma::rowvec>(x.n_cols)), 1)) +
+      maxs;
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
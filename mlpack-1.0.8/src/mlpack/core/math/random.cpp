@@ -1,7 +1,8 @@
 /**
  * @file random.cpp
  *
- * Declarations of global Boost random number generators.
+ * Declarations of global Boost random number generators, and the random
+ * streams of each thread.
  *
  * This file is part of MLPACK 1.0.8.
  *
@@ -18,8 +19,7 @@
  * You should have received a copy of the GNU General Public License along with
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <boost/random.hpp>
-#include <boost/version.hpp>
+#include "random.hpp"
 
 namespace mlpack {
 namespace math {
@@ -47,5 +47,136 @@ namespace math {
   boost::normal_distribution<> randNormalDist;
 #endif
 
+namespace {
+
+//! The last seed given to RandomSeed().
+size_t streamSeed = 0;
+//! How many times RandomSeed() has been called, so that threads can tell when
+//! their streams are out of date.
+size_t streamGeneration = 0;
+
+#ifdef _OPENMP
+//! The stream of the calling thread.  These are never freed, so that they may
+//! be used until the program exits.
+RandomStream* threadStream = NULL;
+//! The generation and thread number the stream of the calling thread was
+//! seeded for.
+size_t threadStreamGeneration = 0;
+size_t threadStreamIndex = 0;
+#pragma omp threadprivate(threadStream, threadStreamGeneration, \
+    threadStreamIndex)
+#endif
+
+//! The number of elements filled from each stream by Random(arma::mat&) and
+//! RandNormal(arma::mat&).
+const size_t fillBlockSize = 16384;
+
+//! Draw a seed from the generator of the calling thread.
+uint64_t DrawSeed()
+{
+  if (UseThreadStream())
+    return ThreadStream().RandBits();
+
+  const uint64_t high = (uint64_t) randGen();
+  return (high << 32) | (uint64_t) randGen();
+}
+
+#ifdef _OPENMP
+//! The number of the calling thread in the innermost parallel region with more
+//! than one thread, so that a nested region with one thread (as methods called
+//! from a parallel region run) keeps drawing from the stream of its thread.
+size_t StreamIndex()
+{
+  int level = omp_get_level();
+  while (level > 1 && omp_get_team_size(level) == 1)
+    --level;
+
+  return (size_t) omp_get_ancestor_thread_num(level);
+}
+#endif
+
+}; // anonymous namespace
+
+void RandomSeed(const size_t seed)
+{
+  randGen.seed((uint32_t) seed);
+  srand((unsigned int) seed);
+
+  streamSeed = seed;
+  ++streamGeneration;
+}
+
+RandomStream DrawStream()
+{
+  return RandomStream((size_t) DrawSeed());
+}
+
+RandomStream& ThreadStream()
+{
+#ifdef _OPENMP
+  const size_t index = StreamIndex();
+  if (threadStream == NULL)
+  {
+    threadStream = new RandomStream(streamSeed, index + 1);
+    threadStreamGeneration = streamGeneration;
+    threadStreamIndex = index;
+  }
+  else if (threadStreamGeneration != streamGeneration ||
+           threadStreamIndex != index)
+  {
+    threadStream->Seed(streamSeed, index + 1);
+    threadStreamGeneration = streamGeneration;
+    threadStreamIndex = index;
+  }
+
+  return *threadStream;
+#else
+  // Without OpenMP there is only one thread, and it has one stream.
+  static RandomStream stream;
+  static size_t generation = 0;
+  if (generation != streamGeneration)
+  {
+    stream.Seed(streamSeed, 1);
+    generation = streamGeneration;
+  }
+
+  return stream;
+#endif
+}
+
+void Random(arma::mat& matrix)
+{
+  const RandomStream base((size_t) DrawSeed());
+  const int numBlocks = (int) ((matrix.n_elem + fillBlockSize - 1) /
+      fillBlockSize);
+
+  #pragma omp parallel for if (numBlocks > 1 && !UseThreadStream())
+  for (int b = 0; b < numBlocks; ++b)
+  {
+    RandomStream stream = base.Split((size_t) b);
+    const size_t end = std::min((size_t) (b + 1) * fillBlockSize,
+        (size_t) matrix.n_elem);
+    for (size_t i = (size_t) b * fillBlockSize; i < end; ++i)
+      matrix[i] = stream.Random();
+  }
+}
+
+void RandNormal(arma::mat& matrix)
+{
+  const RandomStream base((size_t) DrawSeed());
+  const int numBlocks = (int) ((matrix.n_elem + fillBlockSize - 1) /
+      fillBlockSize);
+
+  #pragma omp parallel for if (numBlocks > 1 && !UseThreadStream())
+  for (int b = 0; b < numBlocks; ++b)
+  {
+    RandomStream stream = base.Split((size_t) b);
+    const size_t end = std::min((size_t) (b + 1) * fillBlockSize,
+        (size_t) matrix.n_elem);
+    for (size_t i = (size_t) b * fillBlockSize; i < end; ++i)
+      matrix[i] = stream.RandNormal();
+  }
+}
+
 }; // namespace math
 }; // namespace mlpack
@@ -24,8 +24,14 @@
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
+#include <stdint.h>
 
 #include <boost/random.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace math /** Miscellaneous math routines. */ {
@@ -57,23 +63,249 @@ namespace math /** Miscellaneous math routines. */ {
 #endif
 
 /**
- * Set the random seed used by the random functions (Random() and RandInt()).
- * The seed is casted to a 32-bit integer before being given to the random
- * number generator, but a size_t is taken as a parameter for API consistency.
+ * An independent random number generator, for code which draws random numbers
+ * from several threads.  A stream is determined by a seed and a stream index,
+ * and Split() derives any number of further streams from a stream, so the
+ * numbers drawn by parallel code can be made to depend only on the seed and on
+ * how the work is divided, not on the thread which does it.
  *
- * @param seed Seed for the random number generator.
+ * The functions of this file (Random(), RandInt(), RandNormal()) use one of
+ * these streams for each thread in a parallel region (see ThreadStream()), and
+ * the global generator otherwise.
+ *
+ * @code
+ * RandomStream stream(42);
+ * #pragma omp parallel for
+ * for (int i = 0; i < (int) data.n_cols; ++i)
+ * {
+ *   // The numbers for column i do not depend on the thread it is given to.
+ *   RandomStream columnStream = stream.Split(i);
+ *   for (size_t j = 0; j < data.n_rows; ++j)
+ *     data(j, i) = columnStream.RandNormal();
+ * }
+ * @endcode
  */
-inline void RandomSeed(const size_t seed)
+class RandomStream
 {
-  randGen.seed((uint32_t) seed);
-  srand((unsigned int) seed);
+ public:
+  /**
+   * Create a stream from the given seed and stream index.  Streams with the
+   * same seed and different indices are independent.
+   *
+   * @param seed Seed of the stream.
+   * @param stream Index of the stream.
+   */
+  RandomStream(const size_t seed = 0, const size_t stream = 0)
+  {
+    Seed(seed, stream);
+  }
+
+  /**
+   * Restart the stream from the given seed and stream index.
+   *
+   * @param seed Seed of the stream.
+   * @param stream Index of the stream.
+   */
+  void Seed(const size_t seed, const size_t stream = 0)
+  {
+    Key(Mix(Mix((uint64_t) seed) + (uint64_t) stream));
+  }
+
+  /**
+   * Derive a new stream from this one.  The new stream depends only on the
+   * seed of this stream (not on how many numbers have been drawn from it) and
+   * on the given index.
+   *
+   * @param stream Index of the new stream.
+   */
+  RandomStream Split(const size_t stream) const
+  {
+    RandomStream split;
+    split.Key(Mix(key + Mix((uint64_t) stream + 1)));
+    return split;
+  }
+
+  //! Generate a uniform random number in [0, 1).
+  double Random() { return (double) generator() * (1.0 / 4294967296.0); }
+
+  //! Generate a uniform random number in [lo, hi).
+  double Random(const double lo, const double hi)
+  {
+    return lo + (hi - lo) * Random();
+  }
+
+  //! Generate a uniform random integer in [0, hiExclusive).
+  int RandInt(const int hiExclusive)
+  {
+    return (int) std::floor((double) hiExclusive * Random());
+  }
+
+  //! Generate a uniform random integer in [lo, hiExclusive).
+  int RandInt(const int lo, const int hiExclusive)
+  {
+    return lo + (int) std::floor((double) (hiExclusive - lo) * Random());
+  }
+
+  //! Generate a normally distributed random number with mean 0 and variance 1.
+  double RandNormal()
+  {
+    // The Box-Muller transform gives two numbers at a time.
+    if (hasNormal)
+    {
+      hasNormal = false;
+      return nextNormal;
+    }
+
+    const double radius = std::sqrt(-2.0 * std::log(1.0 - Random()));
+    const double angle = 2.0 * M_PI * Random();
+    nextNormal = radius * std::sin(angle);
+    hasNormal = true;
+    return radius * std::cos(angle);
+  }
+
+  //! Generate a normally distributed random number with the given mean and
+  //! variance.
+  double RandNormal(const double mean, const double variance)
+  {
+    return variance * RandNormal() + mean;
+  }
+
+  //! Fill the given matrix with uniform random numbers in [0, 1).
+  void Random(arma::mat& matrix)
+  {
+    for (size_t i = 0; i < matrix.n_elem; ++i)
+      matrix[i] = Random();
+  }
+
+  //! Fill the given matrix with normally distributed random numbers with mean
+  //! 0 and variance 1.
+  void RandNormal(arma::mat& matrix)
+  {
+    for (size_t i = 0; i < matrix.n_elem; ++i)
+      matrix[i] = RandNormal();
+  }
+
+  //! Generate 64 random bits, for instance to seed other streams with.
+  uint64_t RandBits()
+  {
+    const uint64_t high = (uint64_t) generator();
+    return (high << 32) | (uint64_t) generator();
+  }
+
+ private:
+  //! The generator of the stream.
+  boost::mt19937 generator;
+  //! The key the generator was seeded from.
+  uint64_t key;
+  //! Whether nextNormal holds the second number of a Box-Muller pair.
+  bool hasNormal;
+  //! The second number of the last Box-Muller pair.
+  double nextNormal;
+
+  //! Seed the generator from the given key.
+  void Key(const uint64_t newKey)
+  {
+    key = newKey;
+    generator.seed((uint32_t) (key ^ (key >> 32)));
+    hasNormal = false;
+  }
+
+  //! Scramble the bits of a 64-bit integer (the SplitMix64 finalizer).
+  static uint64_t Mix(uint64_t x)
+  {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+};
+
+/**
+ * Get the random stream of the calling thread, for use in a parallel region.
+ * The stream of thread t (as given by omp_get_thread_num()) is
+ * RandomStream(seed, t + 1), where seed is the last seed given to
+ * RandomSeed(), so a parallel region run with the same number of threads and
+ * a static schedule draws the same numbers after the same call to
+ * RandomSeed().  Each thread keeps drawing from its stream in later parallel
+ * regions, until RandomSeed() is called again (which must not be done in a
+ * parallel region).  A nested parallel region with only one thread (as a
+ * method called from a parallel region opens) keeps the stream of the thread
+ * which opened it.
+ */
+RandomStream& ThreadStream();
+
+/**
+ * While an object of this class exists, the calling thread draws from the
+ * given stream in parallel regions, instead of from its own ThreadStream();
+ * the stream of the thread is restored when the object is destroyed.  This
+ * gives each item of work of a parallel loop (each trial of GMM::Estimate(),
+ * for instance) its own stream, so the numbers it draws do not depend on the
+ * thread which runs it.
+ *
+ * @code
+ * const RandomStream base = DrawStream();
+ * #pragma omp parallel for schedule(dynamic, 1)
+ * for (int trial = 0; trial < trials; ++trial)
+ * {
+ *   ScopedThreadStream stream(base.Split(trial));
+ *   ... // Random() draws from the stream of the trial.
+ * }
+ * @endcode
+ */
+class ScopedThreadStream
+{
+ public:
+  //! Draw from the given stream until this object is destroyed.
+  ScopedThreadStream(const RandomStream& stream) : saved(ThreadStream())
+  {
+    ThreadStream() = stream;
+  }
+
+  //! Go back to the stream of the thread.
+  ~ScopedThreadStream() { ThreadStream() = saved; }
+
+ private:
+  //! The stream of the thread, to restore.
+  RandomStream saved;
+};
+
+/**
+ * Whether the calling thread draws from its own stream (ThreadStream())
+ * instead of the global generator; that is the case in parallel regions.
+ */
+inline bool UseThreadStream()
+{
+#ifdef _OPENMP
+  return (omp_in_parallel() != 0);
+#else
+  return false;
+#endif
 }
 
+/**
+ * Set the random seed used by the random functions (Random() and RandInt()),
+ * and the seed of the streams of each thread (see ThreadStream()).  The seed
+ * is casted to a 32-bit integer before being given to the global random number
+ * generator, but a size_t is taken as a parameter for API consistency.
+ *
+ * @param seed Seed for the random number generator.
+ */
+void RandomSeed(const size_t seed);
+
+/**
+ * Create a new stream, seeded from the generator of the calling thread (so it
+ * depends on the seed given to RandomSeed()).  Parallel code can Split() it for
+ * each item of work.
+ */
+RandomStream DrawStream();
+
 /**
  * Generates a uniform random number between 0 and 1.
  */
 inline double Random()
 {
+  if (UseThreadStream())
+    return ThreadStream().Random();
+
 #if BOOST_VERSION >= 103900
   return randUniformDist(randGen);
 #else
@@ -88,6 +320,9 @@ inline double Random()
  */
 inline double Random(const double lo, const double hi)
 {
+  if (UseThreadStream())
+    return ThreadStream().Random(lo, hi);
+
 #if BOOST_VERSION >= 103900
   return lo + (hi - lo) * randUniformDist(randGen);
 #else
@@ -102,6 +337,9 @@ inline double Random(const double lo, const double hi)
  */
 inline int RandInt(const int hiExclusive)
 {
+  if (UseThreadStream())
+    return ThreadStream().RandInt(hiExclusive);
+
 #if BOOST_VERSION >= 103900
   return (int) std::floor((double) hiExclusive * randUniformDist(randGen));
 #else
@@ -116,6 +354,9 @@ inline int RandInt(const int hiExclusive)
  */
 inline int RandInt(const int lo, const int hiExclusive)
 {
+  if (UseThreadStream())
+    return ThreadStream().RandInt(lo, hiExclusive);
+
 #if BOOST_VERSION >= 103900
   return lo + (int) std::floor((double) (hiExclusive - lo)
                                * randUniformDist(randGen));
@@ -133,6 +374,9 @@ inline int RandInt(const int lo, const int hiExclusive)
  */
 inline double RandNormal()
 {
+  if (UseThreadStream())
+    return ThreadStream().RandNormal();
+
   return randNormalDist(randGen);
 }
 
@@ -145,9 +389,32 @@ inline double RandNormal()
  */
 inline double RandNormal(const double mean, const double variance)
 {
+  if (UseThreadStream())
+    return ThreadStream().RandNormal(mean, variance);
+
   return variance * randNormalDist(randGen) + mean;
 }
 
+/**
+ * Fill the given matrix with uniform random numbers in [0, 1).  The matrix is
+ * filled in blocks, in parallel, from streams split from one seed drawn from
+ * the generator of the calling thread; so the result depends on the seed given
+ * to RandomSeed() but not on the number of threads.  (It is not the same as
+ * calling Random() for each element.)
+ *
+ * @param matrix Matrix to fill.
+ */
+void Random(arma::mat& matrix);
+
+/**
+ * Fill the given matrix with normally distributed random numbers with mean 0
+ * and variance 1.  As with Random(arma::mat&), the matrix is filled in
+ * parallel, and the result does not depend on the number of threads.
+ *
+ * @param matrix Matrix to fill.
+ */
+void RandNormal(arma::mat& matrix);
+
 }; // namespace math
 }; // namespace mlpack
 
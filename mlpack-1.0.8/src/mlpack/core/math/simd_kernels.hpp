@@ -0,0 +1,368 @@
+/**
+ * @file simd_kernels.hpp
+ *
+ * Kernels for squared Euclidean distances, dot products and distances between
+ * boxes, with NEON intrinsics on ARM targets.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_MATH_SIMD_KERNELS_HPP
+#define __MLPACK_CORE_MATH_SIMD_KERNELS_HPP
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// NEON is used when the compiler targets it (armv7 with -mfpu=neon, or arm64),
+// unless MLPACK_NO_NEON is defined.  Double-precision NEON only exists on
+// arm64; on armv7, only the single-precision kernels use it.
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(MLPACK_NO_NEON)
+  #define MLPACK_USE_NEON
+  #include <arm_neon.h>
+
+  #if defined(__aarch64__)
+    #define MLPACK_USE_NEON_DOUBLE
+  #endif
+#endif
+
+namespace mlpack {
+namespace math {
+
+#ifdef MLPACK_USE_NEON
+//! Add the four lanes of a NEON vector.
+inline float HorizontalSum(const float32x4_t v)
+{
+#if defined(__aarch64__)
+  return vaddvq_f32(v);
+#else
+  const float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+//! Compute a + b * c on each lane, fused on arm64.
+inline float32x4_t MultiplyAdd(const float32x4_t a,
+                               const float32x4_t b,
+                               const float32x4_t c)
+{
+#if defined(__aarch64__)
+  return vfmaq_f32(a, b, c);
+#else
+  return vmlaq_f32(a, b, c);
+#endif
+}
+#endif
+
+//! Single-precision sums are accumulated over blocks of this many elements,
+//! and the sums of the blocks in double precision, so that the rounding error
+//! does not grow with the length beyond that of one block.
+const size_t FloatBlockSize = 64;
+
+//! Compute the squared Euclidean distance between two single-precision blocks
+//! of at most FloatBlockSize elements, in single precision.
+inline float BlockSquaredDistance(const float* a,
+                                  const float* b,
+                                  const size_t n)
+{
+  size_t i = 0;
+#ifdef MLPACK_USE_NEON
+  float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+  for (; i + 8 <= n; i += 8)
+  {
+    const float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    const float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4),
+        vld1q_f32(b + i + 4));
+    s0 = MultiplyAdd(s0, d0, d0);
+    s1 = MultiplyAdd(s1, d1, d1);
+  }
+  float sum = HorizontalSum(vaddq_f32(s0, s1));
+#else
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const float d0 = a[i] - b[i];
+    const float d1 = a[i + 1] - b[i + 1];
+    const float d2 = a[i + 2] - b[i + 2];
+    const float d3 = a[i + 3] - b[i + 3];
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+    s2 += d2 * d2;
+    s3 += d3 * d3;
+  }
+  float sum = (s0 + s1) + (s2 + s3);
+#endif
+  for (; i < n; ++i)
+  {
+    const float d = a[i] - b[i];
+    sum += d * d;
+  }
+
+  return sum;
+}
+
+/**
+ * Compute the squared Euclidean distance between two points of dimensionality
+ * n stored contiguously in memory.  The blocks of FloatBlockSize elements are
+ * summed in single precision and added up in double precision.
+ */
+inline double SquaredDistance(const float* a, const float* b, const size_t n)
+{
+  double sum = 0.0;
+  for (size_t i = 0; i < n; i += FloatBlockSize)
+    sum += BlockSquaredDistance(a + i, b + i,
+        (n - i < FloatBlockSize) ? n - i : FloatBlockSize);
+
+  return sum;
+}
+
+/**
+ * Compute the squared Euclidean distance between two points of dimensionality
+ * n stored contiguously in memory.
+ */
+inline double SquaredDistance(const double* a, const double* b, const size_t n)
+{
+  size_t i = 0;
+#ifdef MLPACK_USE_NEON_DOUBLE
+  float64x2_t s0 = vdupq_n_f64(0.0), s1 = vdupq_n_f64(0.0);
+  for (; i + 4 <= n; i += 4)
+  {
+    const float64x2_t d0 = vsubq_f64(vld1q_f64(a + i), vld1q_f64(b + i));
+    const float64x2_t d1 = vsubq_f64(vld1q_f64(a + i + 2),
+        vld1q_f64(b + i + 2));
+    s0 = vfmaq_f64(s0, d0, d0);
+    s1 = vfmaq_f64(s1, d1, d1);
+  }
+  double sum = vaddvq_f64(vaddq_f64(s0, s1));
+#else
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const double d0 = a[i] - b[i];
+    const double d1 = a[i + 1] - b[i + 1];
+    const double d2 = a[i + 2] - b[i + 2];
+    const double d3 = a[i + 3] - b[i + 3];
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+    s2 += d2 * d2;
+    s3 += d3 * d3;
+  }
+  double sum = (s0 + s1) + (s2 + s3);
+#endif
+  for (; i < n; ++i)
+  {
+    const double d = a[i] - b[i];
+    sum += d * d;
+  }
+
+  return sum;
+}
+
+//! Compute the dot product of two single-precision blocks of at most
+//! FloatBlockSize elements, in single precision.
+inline float BlockDot(const float* a, const float* b, const size_t n)
+{
+  size_t i = 0;
+#ifdef MLPACK_USE_NEON
+  float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+  for (; i + 8 <= n; i += 8)
+  {
+    s0 = MultiplyAdd(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+    s1 = MultiplyAdd(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  float sum = HorizontalSum(vaddq_f32(s0, s1));
+#else
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  float sum = (s0 + s1) + (s2 + s3);
+#endif
+  for (; i < n; ++i)
+    sum += a[i] * b[i];
+
+  return sum;
+}
+
+/**
+ * Compute the dot product of two vectors of length n stored contiguously in
+ * memory.  The blocks of FloatBlockSize elements are summed in single
+ * precision and added up in double precision.
+ */
+inline double Dot(const float* a, const float* b, const size_t n)
+{
+  double sum = 0.0;
+  for (size_t i = 0; i < n; i += FloatBlockSize)
+    sum += BlockDot(a + i, b + i,
+        (n - i < FloatBlockSize) ? n - i : FloatBlockSize);
+
+  return sum;
+}
+
+/**
+ * Compute the dot product of two vectors of length n stored contiguously in
+ * memory.
+ */
+inline double Dot(const double* a, const double* b, const size_t n)
+{
+  size_t i = 0;
+#ifdef MLPACK_USE_NEON_DOUBLE
+  float64x2_t s0 = vdupq_n_f64(0.0), s1 = vdupq_n_f64(0.0);
+  for (; i + 4 <= n; i += 4)
+  {
+    s0 = vfmaq_f64(s0, vld1q_f64(a + i), vld1q_f64(b + i));
+    s1 = vfmaq_f64(s1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+  }
+  double sum = vaddvq_f64(vaddq_f64(s0, s1));
+#else
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  double sum = (s0 + s1) + (s2 + s3);
+#endif
+  for (; i < n; ++i)
+    sum += a[i] * b[i];
+
+  return sum;
+}
+
+/**
+ * Compute the smallest squared Euclidean distance between two boxes of
+ * dimensionality n, each given by its lower and upper limits.  A point is a
+ * box whose lower and upper limits are both the point.
+ *
+ * @param lo Lower limits of the first box.
+ * @param hi Upper limits of the first box.
+ * @param otherLo Lower limits of the second box.
+ * @param otherHi Upper limits of the second box.
+ * @param n Dimensionality of the boxes.
+ */
+inline double BoxMinSquaredDistance(const double* lo,
+                                    const double* hi,
+                                    const double* otherLo,
+                                    const double* otherHi,
+                                    const size_t n)
+{
+  size_t i = 0;
+  double sum = 0;
+#ifdef MLPACK_USE_NEON_DOUBLE
+  // In each dimension, at most one of the gaps is positive.
+  const float64x2_t zero = vdupq_n_f64(0.0);
+  float64x2_t s = zero;
+  for (; i + 2 <= n; i += 2)
+  {
+    const float64x2_t lower = vsubq_f64(vld1q_f64(otherLo + i),
+        vld1q_f64(hi + i));
+    const float64x2_t higher = vsubq_f64(vld1q_f64(lo + i),
+        vld1q_f64(otherHi + i));
+    const float64x2_t gap = vaddq_f64(vmaxq_f64(lower, zero),
+        vmaxq_f64(higher, zero));
+    s = vfmaq_f64(s, gap, gap);
+  }
+  sum = vaddvq_f64(s);
+#endif
+  for (; i < n; ++i)
+  {
+    const double lower = otherLo[i] - hi[i];
+    const double higher = lo[i] - otherHi[i];
+    const double gap = (lower > 0 ? lower : 0) + (higher > 0 ? higher : 0);
+    sum += gap * gap;
+  }
+
+  return sum;
+}
+
+/**
+ * Compute the largest squared Euclidean distance between two boxes of
+ * dimensionality n, each given by its lower and upper limits.  A point is a
+ * box whose lower and upper limits are both the point.
+ *
+ * @param lo Lower limits of the first box.
+ * @param hi Upper limits of the first box.
+ * @param otherLo Lower limits of the second box.
+ * @param otherHi Upper limits of the second box.
+ * @param n Dimensionality of the boxes.
+ */
+inline double BoxMaxSquaredDistance(const double* lo,
+                                    const double* hi,
+                                    const double* otherLo,
+                                    const double* otherHi,
+                                    const size_t n)
+{
+  size_t i = 0;
+  double sum = 0;
+#ifdef MLPACK_USE_NEON_DOUBLE
+  float64x2_t s = vdupq_n_f64(0.0);
+  for (; i + 2 <= n; i += 2)
+  {
+    const float64x2_t span = vmaxq_f64(
+        vabsq_f64(vsubq_f64(vld1q_f64(otherHi + i), vld1q_f64(lo + i))),
+        vabsq_f64(vsubq_f64(vld1q_f64(hi + i), vld1q_f64(otherLo + i))));
+    s = vfmaq_f64(s, span, span);
+  }
+  sum = vaddvq_f64(s);
+#endif
+  for (; i < n; ++i)
+  {
+    const double a = fabs(otherHi[i] - lo[i]);
+    const double b = fabs(hi[i] - otherLo[i]);
+    const double span = (a > b) ? a : b;
+    sum += span * span;
+  }
+
+  return sum;
+}
+
+//! Count the bits which are set in the given word.  The compiler builtin is a
+//! single instruction on targets which have one (such as x86 with popcnt).
+inline size_t PopCount(const uint64_t word)
+{
+#if defined(__GNUC__)
+  return (size_t) __builtin_popcountll(word);
+#else
+  uint64_t v = word - ((word >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (size_t) ((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * Compute the Hamming distance between two bit strings of n 64-bit words
+ * stored contiguously in memory.
+ */
+inline size_t HammingDistance(const uint64_t* a, const uint64_t* b,
+                              const size_t n)
+{
+  size_t distance = 0;
+  for (size_t i = 0; i < n; ++i)
+    distance += PopCount(a[i] ^ b[i]);
+
+  return distance;
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file metal_engine.cpp
+ *
+ * The GPU routines for builds without Metal: they are never available.  With
+ * MLPACK_USE_METAL, metal_engine.mm is compiled instead.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "metal_engine.hpp"
+
+#ifndef MLPACK_USE_METAL
+
+using namespace mlpack;
+
+bool metal::Available()
+{
+  return false;
+}
+
+void metal::NearestCandidates(const arma::mat& /* querySet */,
+                              const arma::mat& /* referenceSet */,
+                              const size_t /* candidates */,
+                              const bool /* excludeSelf */,
+                              arma::Mat<size_t>& /* neighbors */)
+{
+  Log::Fatal << "metal::NearestCandidates(): MLPACK was built without Metal."
+      << std::endl;
+}
+
+void metal::NearestCandidates(const arma::fmat& /* querySet */,
+                              const arma::fmat& /* referenceSet */,
+                              const size_t /* candidates */,
+                              const bool /* excludeSelf */,
+                              arma::Mat<size_t>& /* neighbors */)
+{
+  Log::Fatal << "metal::NearestCandidates(): MLPACK was built without Metal."
+      << std::endl;
+}
+
+void metal::InnerProducts(const arma::mat& /* a */,
+                          const arma::mat& /* b */,
+                          arma::mat& /* products */)
+{
+  Log::Fatal << "metal::InnerProducts(): MLPACK was built without Metal."
+      << std::endl;
+}
+
+#endif
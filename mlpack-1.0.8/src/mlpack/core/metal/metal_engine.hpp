@@ -0,0 +1,90 @@
+/**
+ * @file metal_engine.hpp
+ *
+ * Brute-force nearest neighbor candidates and inner product matrices computed
+ * on the GPU with Metal, on Mac OS X and iOS.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_METAL_METAL_ENGINE_HPP
+#define __MLPACK_CORE_METAL_METAL_ENGINE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace metal /** GPU computation with Metal. */ {
+
+/**
+ * The largest number of nearest neighbor candidates NearestCandidates() can
+ * find for each query point.
+ */
+const size_t MaxCandidates = 64;
+
+/**
+ * Return whether the GPU routines can be used: MLPACK was built with
+ * MLPACK_USE_METAL (the USE_METAL CMake option, or the iOS project), and a
+ * Metal device is present.  The device and the compiled kernels are set up on
+ * the first call.  When this is false, the other routines give a fatal error.
+ */
+bool Available();
+
+/**
+ * Find, for each query point, the given number of nearest reference points in
+ * Euclidean distance, by brute force on the GPU.  The distances are computed
+ * in single precision, so points at nearly the same distance may be out of
+ * order; callers which need exact results should ask for more candidates than
+ * they need and rank them again with exact distances (as NeighborSearch does).
+ *
+ * @param querySet Set of query points.
+ * @param referenceSet Set of reference points.
+ * @param candidates Number of candidates to find for each query point; at most
+ *     MaxCandidates, and at most the number of reference points (less one if
+ *     excludeSelf is true).
+ * @param excludeSelf If true, the query set is the reference set, and each
+ *     point is not a candidate for itself.
+ * @param neighbors Matrix to store the indices of the candidates in
+ *     (candidates x number of query points), nearest first.
+ */
+void NearestCandidates(const arma::mat& querySet,
+                       const arma::mat& referenceSet,
+                       const size_t candidates,
+                       const bool excludeSelf,
+                       arma::Mat<size_t>& neighbors);
+
+//! Find nearest neighbor candidates for single-precision datasets.
+void NearestCandidates(const arma::fmat& querySet,
+                       const arma::fmat& referenceSet,
+                       const size_t candidates,
+                       const bool excludeSelf,
+                       arma::Mat<size_t>& neighbors);
+
+/**
+ * Compute the inner products trans(a) * b on the GPU, in single precision.
+ * Large results are computed in several passes, so that each GPU buffer stays
+ * small.
+ *
+ * @param a First set of points (one per column).
+ * @param b Second set of points (one per column), of the same dimensionality.
+ * @param products Matrix to store the inner products in (a.n_cols x b.n_cols).
+ */
+void InnerProducts(const arma::mat& a,
+                   const arma::mat& b,
+                   arma::mat& products);
+
+}; // namespace metal
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,377 @@
+/**
+ * @file metal_engine.mm
+ *
+ * The Metal implementation of the GPU routines (Objective-C++, compiled only
+ * with MLPACK_USE_METAL).  The compute kernels are compiled from source when
+ * the device is first set up, so no separate Metal library has to be built.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "metal_engine.hpp"
+
+#ifdef MLPACK_USE_METAL
+
+#import <Foundation/Foundation.h>
+#import <Metal/Metal.h>
+
+#include <algorithm>
+
+using namespace mlpack;
+
+namespace {
+
+//! The source of the compute kernels.  nearest_candidates uses one thread per
+//! query point, which keeps its candidates sorted by insertion;
+//! inner_products uses one thread per entry of the result.
+const char* kernelSource =
+    "#include <metal_stdlib>\n"
+    "using namespace metal;\n"
+    "\n"
+    "struct CandidateParams\n"
+    "{\n"
+    "  uint dimensionality;\n"
+    "  uint queryBegin;\n"
+    "  uint queries;\n"
+    "  uint references;\n"
+    "  uint candidates;\n"
+    "  uint excludeSelf;\n"
+    "};\n"
+    "\n"
+    "kernel void nearest_candidates(\n"
+    "    device const float* querySet [[buffer(0)]],\n"
+    "    device const float* referenceSet [[buffer(1)]],\n"
+    "    device uint* neighbors [[buffer(2)]],\n"
+    "    constant CandidateParams& params [[buffer(3)]],\n"
+    "    uint id [[thread_position_in_grid]])\n"
+    "{\n"
+    "  if (id >= params.queries)\n"
+    "    return;\n"
+    "  const uint q = params.queryBegin + id;\n"
+    "  const uint d = params.dimensionality;\n"
+    "  const uint last = params.candidates - 1;\n"
+    "\n"
+    "  float bestDistances[64];\n"
+    "  uint bestNeighbors[64];\n"
+    "  for (uint i = 0; i < params.candidates; ++i)\n"
+    "  {\n"
+    "    bestDistances[i] = INFINITY;\n"
+    "    bestNeighbors[i] = 0xFFFFFFFF;\n"
+    "  }\n"
+    "\n"
+    "  device const float* query = querySet + q * d;\n"
+    "  for (uint r = 0; r < params.references; ++r)\n"
+    "  {\n"
+    "    if (params.excludeSelf != 0 && r == q)\n"
+    "      continue;\n"
+    "\n"
+    "    device const float* reference = referenceSet + r * d;\n"
+    "    float distance = 0.0f;\n"
+    "    for (uint i = 0; i < d; ++i)\n"
+    "    {\n"
+    "      const float diff = query[i] - reference[i];\n"
+    "      distance = fma(diff, diff, distance);\n"
+    "    }\n"
+    "\n"
+    "    if (distance < bestDistances[last])\n"
+    "    {\n"
+    "      uint j = last;\n"
+    "      for (; j > 0 && bestDistances[j - 1] > distance; --j)\n"
+    "      {\n"
+    "        bestDistances[j] = bestDistances[j - 1];\n"
+    "        bestNeighbors[j] = bestNeighbors[j - 1];\n"
+    "      }\n"
+    "      bestDistances[j] = distance;\n"
+    "      bestNeighbors[j] = r;\n"
+    "    }\n"
+    "  }\n"
+    "\n"
+    "  for (uint i = 0; i < params.candidates; ++i)\n"
+    "    neighbors[id * params.candidates + i] = bestNeighbors[i];\n"
+    "}\n"
+    "\n"
+    "struct ProductParams\n"
+    "{\n"
+    "  uint dimensionality;\n"
+    "  uint aCols;\n"
+    "  uint bCols;\n"
+    "};\n"
+    "\n"
+    "kernel void inner_products(\n"
+    "    device const float* a [[buffer(0)]],\n"
+    "    device const float* b [[buffer(1)]],\n"
+    "    device float* products [[buffer(2)]],\n"
+    "    constant ProductParams& params [[buffer(3)]],\n"
+    "    uint2 id [[thread_position_in_grid]])\n"
+    "{\n"
+    "  if (id.x >= params.aCols || id.y >= params.bCols)\n"
+    "    return;\n"
+    "\n"
+    "  const uint d = params.dimensionality;\n"
+    "  device const float* x = a + id.x * d;\n"
+    "  device const float* y = b + id.y * d;\n"
+    "  float sum = 0.0f;\n"
+    "  for (uint i = 0; i < d; ++i)\n"
+    "    sum = fma(x[i], y[i], sum);\n"
+    "\n"
+    "  products[id.y * params.aCols + id.x] = sum;\n"
+    "}\n";
+
+//! The parameters of nearest_candidates (as in the kernel source).
+struct CandidateParams
+{
+  uint32_t dimensionality;
+  uint32_t queryBegin;
+  uint32_t queries;
+  uint32_t references;
+  uint32_t candidates;
+  uint32_t excludeSelf;
+};
+
+//! The parameters of inner_products (as in the kernel source).
+struct ProductParams
+{
+  uint32_t dimensionality;
+  uint32_t aCols;
+  uint32_t bCols;
+};
+
+//! The number of query points handled by one command buffer, so that no
+//! single GPU command runs long enough to be stopped by the system.
+const size_t QueryBatch = 4096;
+
+//! The largest number of entries of an inner product matrix computed in one
+//! pass (64 MB of floats).
+const size_t MaxProducts = 16 * 1024 * 1024;
+
+//! The Metal device, its command queue, and the compiled kernels.
+struct Context
+{
+  id<MTLDevice> device;
+  id<MTLCommandQueue> queue;
+  id<MTLComputePipelineState> nearestCandidates;
+  id<MTLComputePipelineState> innerProducts;
+};
+
+//! Set up the device and compile the kernels, once; return NULL if there is
+//! no device or the kernels could not be compiled.
+Context* GetContext()
+{
+  static Context* context = NULL;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    id<MTLDevice> device = MTLCreateSystemDefaultDevice();
+    if (device == nil)
+      return;
+
+    NSError* error = nil;
+    id<MTLLibrary> library = [device
+        newLibraryWithSource:[NSString stringWithUTF8String:kernelSource]
+                     options:nil
+                       error:&error];
+    if (library == nil)
+    {
+      Log::Warn << "Could not compile the Metal kernels: "
+          << [[error localizedDescription] UTF8String] << std::endl;
+      return;
+    }
+
+    id<MTLComputePipelineState> nearestCandidates = [device
+        newComputePipelineStateWithFunction:
+            [library newFunctionWithName:@"nearest_candidates"]
+                                      error:&error];
+    id<MTLComputePipelineState> innerProducts = [device
+        newComputePipelineStateWithFunction:
+            [library newFunctionWithName:@"inner_products"]
+                                      error:&error];
+    if (nearestCandidates == nil || innerProducts == nil)
+    {
+      Log::Warn << "Could not create the Metal pipelines: "
+          << [[error localizedDescription] UTF8String] << std::endl;
+      return;
+    }
+
+    context = new Context;
+    context->device = device;
+    context->queue = [device newCommandQueue];
+    context->nearestCandidates = nearestCandidates;
+    context->innerProducts = innerProducts;
+  });
+
+  return context;
+}
+
+//! Copy a single-precision matrix into a new shared GPU buffer.
+id<MTLBuffer> NewBuffer(Context* context, const arma::fmat& matrix)
+{
+  // Metal does not allow empty buffers.
+  return [context->device
+      newBufferWithBytes:matrix.memptr()
+                  length:std::max(matrix.n_elem, (arma::uword) 1) *
+                      sizeof(float)
+                 options:MTLResourceStorageModeShared];
+}
+
+//! Find the candidates for single-precision data.
+void FloatNearestCandidates(const arma::fmat& querySet,
+                            const arma::fmat& referenceSet,
+                            const size_t candidates,
+                            const bool excludeSelf,
+                            arma::Mat<size_t>& neighbors)
+{
+  Context* context = GetContext();
+  if (context == NULL)
+    Log::Fatal << "metal::NearestCandidates(): no Metal device is available."
+        << std::endl;
+  if (candidates == 0 || candidates > metal::MaxCandidates ||
+      candidates + (excludeSelf ? 1 : 0) > referenceSet.n_cols)
+    Log::Fatal << "metal::NearestCandidates(): invalid number of candidates ("
+        << candidates << ")." << std::endl;
+
+  neighbors.set_size(candidates, querySet.n_cols);
+  if (querySet.n_cols == 0)
+    return;
+
+  id<MTLBuffer> queryBuffer = NewBuffer(context, querySet);
+  id<MTLBuffer> referenceBuffer = NewBuffer(context, referenceSet);
+  id<MTLBuffer> neighborBuffer = [context->device
+      newBufferWithLength:candidates * std::min(QueryBatch,
+          (size_t) querySet.n_cols) * sizeof(uint32_t)
+                  options:MTLResourceStorageModeShared];
+
+  const NSUInteger width = context->nearestCandidates.threadExecutionWidth;
+  for (size_t begin = 0; begin < querySet.n_cols; begin += QueryBatch)
+  {
+    const size_t count = std::min(QueryBatch,
+        (size_t) querySet.n_cols - begin);
+
+    CandidateParams params;
+    params.dimensionality = (uint32_t) querySet.n_rows;
+    params.queryBegin = (uint32_t) begin;
+    params.queries = (uint32_t) count;
+    params.references = (uint32_t) referenceSet.n_cols;
+    params.candidates = (uint32_t) candidates;
+    params.excludeSelf = excludeSelf ? 1 : 0;
+
+    id<MTLCommandBuffer> commandBuffer = [context->queue commandBuffer];
+    id<MTLComputeCommandEncoder> encoder = [commandBuffer
+        computeCommandEncoder];
+    [encoder setComputePipelineState:context->nearestCandidates];
+    [encoder setBuffer:queryBuffer offset:0 atIndex:0];
+    [encoder setBuffer:referenceBuffer offset:0 atIndex:1];
+    [encoder setBuffer:neighborBuffer offset:0 atIndex:2];
+    [encoder setBytes:&params length:sizeof(params) atIndex:3];
+    [encoder dispatchThreadgroups:MTLSizeMake((count + width - 1) / width, 1,
+                                              1)
+            threadsPerThreadgroup:MTLSizeMake(width, 1, 1)];
+    [encoder endEncoding];
+    [commandBuffer commit];
+    [commandBuffer waitUntilCompleted];
+
+    const uint32_t* result = (const uint32_t*) [neighborBuffer contents];
+    for (size_t i = 0; i < count; ++i)
+      for (size_t j = 0; j < candidates; ++j)
+        neighbors(j, begin + i) = result[i * candidates + j];
+  }
+}
+
+}; // anonymous namespace
+
+bool metal::Available()
+{
+  return (GetContext() != NULL);
+}
+
+void metal::NearestCandidates(const arma::mat& querySet,
+                              const arma::mat& referenceSet,
+                              const size_t candidates,
+                              const bool excludeSelf,
+                              arma::Mat<size_t>& neighbors)
+{
+  FloatNearestCandidates(arma::conv_to<arma::fmat>::from(querySet),
+      arma::conv_to<arma::fmat>::from(referenceSet), candidates, excludeSelf,
+      neighbors);
+}
+
+void metal::NearestCandidates(const arma::fmat& querySet,
+                              const arma::fmat& referenceSet,
+                              const size_t candidates,
+                              const bool excludeSelf,
+                              arma::Mat<size_t>& neighbors)
+{
+  FloatNearestCandidates(querySet, referenceSet, candidates, excludeSelf,
+      neighbors);
+}
+
+void metal::InnerProducts(const arma::mat& a,
+                          const arma::mat& b,
+                          arma::mat& products)
+{
+  Context* context = GetContext();
+  if (context == NULL)
+    Log::Fatal << "metal::InnerProducts(): no Metal device is available."
+        << std::endl;
+  if (a.n_rows != b.n_rows)
+    Log::Fatal << "metal::InnerProducts(): the points have different "
+        << "dimensionalities (" << a.n_rows << " and " << b.n_rows << ")."
+        << std::endl;
+
+  products.set_size(a.n_cols, b.n_cols);
+  if (a.n_cols == 0 || b.n_cols == 0)
+    return;
+
+  const arma::fmat fa = arma::conv_to<arma::fmat>::from(a);
+  id<MTLBuffer> aBuffer = NewBuffer(context, fa);
+
+  // Each pass computes the products with a block of columns of b.
+  const size_t blockCols = std::max((size_t) 1, MaxProducts / a.n_cols);
+  for (size_t begin = 0; begin < b.n_cols; begin += blockCols)
+  {
+    const size_t count = std::min(blockCols, (size_t) b.n_cols - begin);
+    const arma::fmat fb = arma::conv_to<arma::fmat>::from(b.cols(begin,
+        begin + count - 1));
+    id<MTLBuffer> bBuffer = NewBuffer(context, fb);
+    id<MTLBuffer> productBuffer = [context->device
+        newBufferWithLength:a.n_cols * count * sizeof(float)
+                    options:MTLResourceStorageModeShared];
+
+    ProductParams params;
+    params.dimensionality = (uint32_t) a.n_rows;
+    params.aCols = (uint32_t) a.n_cols;
+    params.bCols = (uint32_t) count;
+
+    id<MTLCommandBuffer> commandBuffer = [context->queue commandBuffer];
+    id<MTLComputeCommandEncoder> encoder = [commandBuffer
+        computeCommandEncoder];
+    [encoder setComputePipelineState:context->innerProducts];
+    [encoder setBuffer:aBuffer offset:0 atIndex:0];
+    [encoder setBuffer:bBuffer offset:0 atIndex:1];
+    [encoder setBuffer:productBuffer offset:0 atIndex:2];
+    [encoder setBytes:&params length:sizeof(params) atIndex:3];
+    [encoder dispatchThreadgroups:MTLSizeMake((a.n_cols + 15) / 16,
+                                              (count + 15) / 16, 1)
+            threadsPerThreadgroup:MTLSizeMake(16, 16, 1)];
+    [encoder endEncoding];
+    [commandBuffer commit];
+    [commandBuffer waitUntilCompleted];
+
+    // The products are column-major, like the result.
+    const float* result = (const float*) [productBuffer contents];
+    for (size_t i = 0; i < a.n_cols * count; ++i)
+      products[begin * a.n_cols + i] = result[i];
+  }
+}
+
+#endif
@@ -26,6 +26,7 @@
 #define __MLPACK_CORE_METRICS_LMETRIC_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/math/simd_kernels.hpp>
 
 namespace mlpack {
 namespace metric {
@@ -68,8 +69,12 @@ namespace metric {
  * @tparam TakeRoot If true, the Power'th root of the result is taken before it
  *    is returned.  Setting this to false causes the metric to not satisfy the
  *    Triangle Inequality (be careful!).
+ * @tparam FixedDim If nonzero, the dimensionality of every point, known at
+ *    compile time; the loops over the dimensions are then unrolled, which is
+ *    much faster for 2-D and 3-D data (see also bound::HRectBound).  0 means
+ *    the dimensionality is only known at run time.
  */
-template<int Power, bool TakeRoot = true>
+template<int Power, bool TakeRoot = true, size_t FixedDim = 0>
 class LMetric
 {
  public:
@@ -84,6 +89,63 @@ class LMetric
    */
   template<typename VecType1, typename VecType2>
   static double Evaluate(const VecType1& a, const VecType2& b);
+
+  /**
+   * Computes the distance between two points stored as dense double-precision
+   * vectors.  This overload is chosen over the generic one for arma::vec (and
+   * the columns returned by unsafe_col()), and calls the kernel below
+   * directly instead of building an Armadillo expression.
+   */
+  static double Evaluate(const arma::vec& a, const arma::vec& b);
+
+  /**
+   * Computes the distance between two points stored as dense single-precision
+   * vectors.
+   */
+  static double Evaluate(const arma::fvec& a, const arma::fvec& b);
+
+  /**
+   * Computes the distance between two points stored contiguously in memory.
+   * The loops for the Manhattan, Euclidean and Chebyshev distances are
+   * written so that the compiler can vectorize them (with SSE, AVX or NEON,
+   * depending on the target), and the Euclidean one uses NEON intrinsics on
+   * ARM targets (see math::SquaredDistance()); other powers use pow().  eT
+   * should be double or float; single-precision points are summed in double
+   * precision (the Euclidean distance over blocks of math::FloatBlockSize
+   * elements), so long vectors lose no accuracy.
+   *
+   * @param a Pointer to the first point.
+   * @param b Pointer to the second point.
+   * @param n Dimensionality of the points.
+   */
+  template<typename eT>
+  static double Evaluate(const eT* a, const eT* b, const size_t n);
+
+  /**
+   * Computes the distances between one point and the points in the columns
+   * [begin, begin + count) of the given matrix, such as the points held in a
+   * leaf of a BinarySpaceTree.  The point is read once per column from the
+   * cache and the columns are read sequentially.
+   *
+   * @param point Point to compute distances from.
+   * @param points Matrix of points.
+   * @param begin Index of the first column of points.
+   * @param count Number of columns of points.
+   * @param distances Vector to store the count distances in; it is resized if
+   *     necessary.
+   */
+  template<typename eT>
+  static void Evaluate(const arma::Col<eT>& point,
+                       const arma::Mat<eT>& points,
+                       const size_t begin,
+                       const size_t count,
+                       arma::Col<eT>& distances);
+
+ private:
+  //! Compute the distance between two points of dimensionality FixedDim
+  //! (anything indexable with [], such as pointers and vectors).
+  template<typename VecType1, typename VecType2>
+  static double FixedEvaluate(const VecType1& a, const VecType2& b);
 };
 
 // Convenience typedefs.
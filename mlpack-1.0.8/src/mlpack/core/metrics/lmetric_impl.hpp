@@ -29,11 +29,14 @@ namespace mlpack {
 namespace metric {
 
 // Unspecialized implementation.  This should almost never be used...
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename VecType1, typename VecType2>
-double LMetric<Power, TakeRoot>::Evaluate(const VecType1& a,
-                                             const VecType2& b)
+double LMetric<Power, TakeRoot, FixedDim>::Evaluate(const VecType1& a,
+                                                    const VecType2& b)
 {
+  if (FixedDim != 0)
+    return FixedEvaluate(a, b);
+
   double sum = 0;
   for (size_t i = 0; i < a.n_elem; i++)
     sum += pow(fabs(a[i] - b[i]), Power);
@@ -101,6 +104,159 @@ double LMetric<INT_MAX, false>::Evaluate(const VecType1& a, const VecType2& b)
   return arma::as_scalar(max(abs(a - b)));
 }
 
+// Unspecialized kernel.
+template<int Power, bool TakeRoot, size_t FixedDim>
+template<typename eT>
+double LMetric<Power, TakeRoot, FixedDim>::Evaluate(const eT* a,
+                                                    const eT* b,
+                                                    const size_t n)
+{
+  if (FixedDim != 0)
+    return FixedEvaluate(a, b);
+
+  double sum = 0;
+  for (size_t i = 0; i < n; i++)
+    sum += pow(fabs(double(a[i] - b[i])), Power);
+
+  if (!TakeRoot)
+    return sum;
+
+  return pow(sum, (1.0 / Power));
+}
+
+// The kernels below keep four independent accumulators, so that the additions
+// do not all depend on each other and the compiler is free to put them in SIMD
+// registers.
+
+// L1-metric kernels.  The differences are taken in the precision of the data
+// and summed in double precision.
+template<>
+template<typename eT>
+double LMetric<1, false>::Evaluate(const eT* a, const eT* b, const size_t n)
+{
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    s0 += double(std::abs(a[i] - b[i]));
+    s1 += double(std::abs(a[i + 1] - b[i + 1]));
+    s2 += double(std::abs(a[i + 2] - b[i + 2]));
+    s3 += double(std::abs(a[i + 3] - b[i + 3]));
+  }
+  for (; i < n; i++)
+    s0 += double(std::abs(a[i] - b[i]));
+
+  return (s0 + s1) + (s2 + s3);
+}
+
+template<>
+template<typename eT>
+double LMetric<1, true>::Evaluate(const eT* a, const eT* b, const size_t n)
+{
+  return LMetric<1, false>::Evaluate(a, b, n);
+}
+
+// L2-metric kernels.  These use math::SquaredDistance(), which uses NEON on
+// ARM targets.
+template<>
+template<typename eT>
+double LMetric<2, false>::Evaluate(const eT* a, const eT* b, const size_t n)
+{
+  return math::SquaredDistance(a, b, n);
+}
+
+template<>
+template<typename eT>
+double LMetric<2, true>::Evaluate(const eT* a, const eT* b, const size_t n)
+{
+  return sqrt(LMetric<2, false>::Evaluate(a, b, n));
+}
+
+// L-infinity (Chebyshev distance) kernel.
+template<>
+template<typename eT>
+double LMetric<INT_MAX, false>::Evaluate(const eT* a,
+                                         const eT* b,
+                                         const size_t n)
+{
+  eT m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    m0 = std::max(m0, eT(std::abs(a[i] - b[i])));
+    m1 = std::max(m1, eT(std::abs(a[i + 1] - b[i + 1])));
+    m2 = std::max(m2, eT(std::abs(a[i + 2] - b[i + 2])));
+    m3 = std::max(m3, eT(std::abs(a[i + 3] - b[i + 3])));
+  }
+  for (; i < n; i++)
+    m0 = std::max(m0, eT(std::abs(a[i] - b[i])));
+
+  return double(std::max(std::max(m0, m1), std::max(m2, m3)));
+}
+
+// Dense vectors go straight to the kernels.
+template<int Power, bool TakeRoot, size_t FixedDim>
+double LMetric<Power, TakeRoot, FixedDim>::Evaluate(const arma::vec& a,
+                                                    const arma::vec& b)
+{
+  return Evaluate(a.memptr(), b.memptr(), a.n_elem);
+}
+
+template<int Power, bool TakeRoot, size_t FixedDim>
+double LMetric<Power, TakeRoot, FixedDim>::Evaluate(const arma::fvec& a,
+                                                    const arma::fvec& b)
+{
+  return Evaluate(a.memptr(), b.memptr(), a.n_elem);
+}
+
+// Point-to-block distances.
+template<int Power, bool TakeRoot, size_t FixedDim>
+template<typename eT>
+void LMetric<Power, TakeRoot, FixedDim>::Evaluate(
+    const arma::Col<eT>& point,
+    const arma::Mat<eT>& points,
+    const size_t begin,
+    const size_t count,
+    arma::Col<eT>& distances)
+{
+  if (distances.n_elem != count)
+    distances.set_size(count);
+
+  const eT* pointMem = point.memptr();
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = eT(Evaluate(pointMem, points.colptr(begin + i),
+        point.n_elem));
+}
+
+// Fixed dimensionality.  The loop has a constant trip count and the power is
+// known at compile time, so the compiler unrolls it and removes the branches.
+template<int Power, bool TakeRoot, size_t FixedDim>
+template<typename VecType1, typename VecType2>
+double LMetric<Power, TakeRoot, FixedDim>::FixedEvaluate(const VecType1& a,
+                                                         const VecType2& b)
+{
+  double sum = 0;
+  for (size_t i = 0; i < FixedDim; ++i)
+  {
+    const double diff = fabs(double(a[i]) - double(b[i]));
+    if (Power == 1)
+      sum += diff;
+    else if (Power == 2)
+      sum += diff * diff;
+    else if (Power == INT_MAX)
+      sum = std::max(sum, diff);
+    else
+      sum += pow(diff, Power);
+  }
+
+  if (!TakeRoot || Power == 1 || Power == INT_MAX)
+    return sum;
+  else if (Power == 2)
+    return sqrt(sum);
+  else
+    return pow(sum, 1.0 / Power);
+}
+
 }; // namespace metric
 }; // namespace mlpack
 
@@ -42,8 +42,23 @@ namespace metric {
  *
  * Because each evaluation multiplies (x_1 - x_2) by the covariance matrix, it
  * may be much quicker to use an LMetric and simply stretch the actual dataset
- * itself before performing any evaluations.  However, this class is provided
- * for convenience.
+ * itself before performing any evaluations.  Transform() does that: it
+ * factorizes Q = R^T R (Cholesky) once and multiplies the points by R, so that
+ * the Euclidean distance between transformed points is the Mahalanobis
+ * distance between the original points; the transformed data can then be
+ * searched with trees and metric::EuclideanDistance (or
+ * SquaredEuclideanDistance, when t_take_root is false).  For instance, with the
+ * transformation matrix L learned by NCA (for which Q = L^T L):
+ *
+ * @code
+ * MahalanobisDistance<true> distance(trans(L) * L);
+ * arma::mat transformed;
+ * distance.Transform(data, transformed);
+ * AllkNN allknn(transformed); // Euclidean search on transformed data.
+ * @endcode
+ *
+ * (Of course, if L is known, data can also be multiplied by L directly.)
+ * There is also a batched Evaluate() for the distances from one point to many.
  *
  * Similar to the LMetric class, this offers a template parameter t_take_root
  * which, when set to false, will instead evaluate the distance
@@ -96,6 +111,34 @@ class MahalanobisDistance
   template<typename VecType1, typename VecType2>
   double Evaluate(const VecType1& a, const VecType2& b);
 
+  /**
+   * Evaluate the distances between the given point and each column of the
+   * given matrix, with two matrix products instead of one evaluation per point.
+   *
+   * @param a Point to evaluate distances from.
+   * @param points Points to evaluate distances to (one per column).
+   * @param distances Vector to store the distances in.
+   */
+  template<typename VecType>
+  void Evaluate(const VecType& a, const arma::mat& points, arma::vec& distances);
+
+  /**
+   * Compute the Cholesky factor R of the covariance matrix (Q = R^T R), if it
+   * has not been computed since the covariance matrix was last set.  The
+   * covariance matrix must be positive definite.
+   */
+  void Factorize();
+
+  /**
+   * Transform the given points so that the Euclidean distance between
+   * transformed points is this distance between the original points; the
+   * points are multiplied by the Cholesky factor of the covariance matrix.
+   *
+   * @param data Points to transform (one per column).
+   * @param transformed Matrix to store the transformed points in.
+   */
+  void Transform(const arma::mat& data, arma::mat& transformed);
+
   /**
    * Access the covariance matrix.
    *
@@ -104,15 +147,21 @@ class MahalanobisDistance
   const arma::mat& Covariance() const { return covariance; }
 
   /**
-   * Modify the covariance matrix.
+   * Modify the covariance matrix.  This forgets the Cholesky factor.
    *
    * @return Reference to the covariance matrix.
    */
-  arma::mat& Covariance() { return covariance; }
+  arma::mat& Covariance() { factor.reset(); return covariance; }
+
+  //! Get the Cholesky factor of the covariance matrix (empty if Factorize()
+  //! has not been called since the covariance matrix was last set).
+  const arma::mat& Factor() const { return factor; }
 
  private:
   //! The covariance matrix associated with this distance.
   arma::mat covariance;
+  //! The upper triangular Cholesky factor R of the covariance (Q = R^T R).
+  arma::mat factor;
 };
 
 }; // namespace distance
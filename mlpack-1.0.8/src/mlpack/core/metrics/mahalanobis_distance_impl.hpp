@@ -58,6 +58,50 @@ double MahalanobisDistance<true>::Evaluate(const VecType1& a,
   return sqrt(out[0]);
 }
 
+template<bool t_take_root>
+template<typename VecType>
+void MahalanobisDistance<t_take_root>::Evaluate(const VecType& a,
+                                                const arma::mat& points,
+                                                arma::vec& distances)
+{
+  // Check if covariance matrix has been initialized.
+  if (covariance.n_rows == 0)
+    covariance = arma::eye<arma::mat>(a.n_elem, a.n_elem);
+
+  arma::mat differences = points;
+  for (size_t i = 0; i < differences.n_cols; ++i)
+    differences.col(i) -= a;
+
+  // The distances are the column sums of (Q * D) % D.
+  distances = trans(arma::sum((covariance * differences) % differences, 0));
+  if (t_take_root)
+    distances = arma::sqrt(distances);
+}
+
+template<bool t_take_root>
+void MahalanobisDistance<t_take_root>::Factorize()
+{
+  if (factor.n_rows == covariance.n_rows && factor.n_rows > 0)
+    return;
+
+  if (!arma::chol(factor, covariance))
+  {
+    factor.reset();
+    Log::Fatal << "MahalanobisDistance::Factorize(): the covariance matrix is "
+        << "not positive definite." << std::endl;
+  }
+}
+
+template<bool t_take_root>
+void MahalanobisDistance<t_take_root>::Transform(const arma::mat& data,
+                                                 arma::mat& transformed)
+{
+  Factorize();
+
+  // ||R a - R b||^2 = (a - b)^T R^T R (a - b) = (a - b)^T Q (a - b).
+  transformed = factor * data;
+}
+
 }; // namespace metric
 }; // namespace mlpack
 
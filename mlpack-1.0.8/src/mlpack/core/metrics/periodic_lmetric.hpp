@@ -0,0 +1,111 @@
+/**
+ * @file periodic_lmetric.hpp
+ *
+ * Definition of the PeriodicLMetric class, the L_p metric in a space with
+ * periodic boundaries.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_METRICS_PERIODIC_LMETRIC_HPP
+#define __MLPACK_CORE_METRICS_PERIODIC_LMETRIC_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace metric {
+
+/**
+ * The L_p metric in a box with periodic boundaries (a torus), such as the
+ * simulation box of a particle simulation.  The size of the box in each
+ * dimension is @f$ L_i @f$, and the distance between two points uses the
+ * nearest periodic image of each coordinate difference:
+ *
+ * @f[
+ * d(x, y) = \left( \sum_{i = 1}^{n} \min(|x_i - y_i| \bmod L_i,
+ *     L_i - |x_i - y_i| \bmod L_i)^p \right)^{\frac{1}{p}}.
+ * @f]
+ *
+ * A dimension with a box size of 0 is not periodic, and an empty box gives the
+ * usual LMetric.  The points do not need to lie inside the box.  As with
+ * LMetric, setting TakeRoot to false gives a faster distance which does not
+ * satisfy the triangle inequality.
+ *
+ * Use this metric with the PeriodicHRectBound of the same template parameters
+ * and the same box (see bound::SetPeriodicBox()).
+ *
+ * @tparam Power Power of metric; i.e. Power = 1 gives the L1-norm.
+ * @tparam TakeRoot If true, the Power'th root of the result is taken before it
+ *    is returned.
+ */
+template<int Power, bool TakeRoot = true>
+class PeriodicLMetric
+{
+ public:
+  //! Create the metric with no periodic dimensions.
+  PeriodicLMetric() { }
+
+  /**
+   * Create the metric for the given box.
+   *
+   * @param box Size of the box in each dimension (0 for a dimension which is
+   *     not periodic).
+   */
+  PeriodicLMetric(const arma::vec& box) : box(box) { }
+
+  /**
+   * Computes the distance between two points, using the nearest periodic image
+   * in each dimension.
+   */
+  template<typename VecType1, typename VecType2>
+  double Evaluate(const VecType1& a, const VecType2& b) const;
+
+  /**
+   * Return the distance between two coordinates which differ by the given
+   * amount, in a dimension of the given box size (the distance to the nearest
+   * periodic image).
+   *
+   * @param difference Difference of the coordinates.
+   * @param size Size of the box in the dimension (0 if it is not periodic).
+   */
+  static double MinimumImage(const double difference, const double size)
+  {
+    if (size <= 0.0)
+      return fabs(difference);
+
+    const double d = fmod(fabs(difference), size);
+    return std::min(d, size - d);
+  }
+
+  //! Get the size of the box.
+  const arma::vec& Box() const { return box; }
+  //! Modify the size of the box.
+  arma::vec& Box() { return box; }
+
+ private:
+  //! The size of the box in each dimension.
+  arma::vec box;
+};
+
+//! The Euclidean (L2) distance in a periodic box.
+typedef PeriodicLMetric<2, true> PeriodicEuclideanDistance;
+
+}; // namespace metric
+}; // namespace mlpack
+
+// Include implementation.
+#include "periodic_lmetric_impl.hpp"
+
+#endif
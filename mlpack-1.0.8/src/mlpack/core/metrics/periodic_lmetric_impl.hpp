@@ -0,0 +1,60 @@
+/**
+ * @file periodic_lmetric_impl.hpp
+ *
+ * Implementation of the PeriodicLMetric class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_METRICS_PERIODIC_LMETRIC_IMPL_HPP
+#define __MLPACK_CORE_METRICS_PERIODIC_LMETRIC_IMPL_HPP
+
+// In case it hasn't been included.
+#include "periodic_lmetric.hpp"
+
+namespace mlpack {
+namespace metric {
+
+template<int Power, bool TakeRoot>
+template<typename VecType1, typename VecType2>
+double PeriodicLMetric<Power, TakeRoot>::Evaluate(const VecType1& a,
+                                                  const VecType2& b) const
+{
+  double sum = 0;
+  for (size_t i = 0; i < a.n_elem; ++i)
+  {
+    const double size = (i < box.n_elem) ? box[i] : 0.0;
+    const double d = MinimumImage(a[i] - b[i], size);
+
+    if (Power == 1)
+      sum += d;
+    else if (Power == 2)
+      sum += d * d;
+    else
+      sum += pow(d, (double) Power);
+  }
+
+  if (!TakeRoot || Power == 1)
+    return sum;
+  else if (Power == 2)
+    return sqrt(sum);
+  else
+    return pow(sum, 1.0 / (double) Power);
+}
+
+}; // namespace metric
+}; // namespace mlpack
+
+#endif
@@ -53,6 +53,18 @@ namespace optimization {
  * the given coordinates.  Evaluate() should provide the objective function
  * value for the given coordinates.
  *
+ * The function may also implement
+ *
+ * - void EvaluateConstraints(const arma::mat& coordinates,
+ *        arma::vec& constraints);
+ *
+ * which evaluates all the constraints at once; if it does, it is used instead
+ * of EvaluateConstraint() whenever every constraint is needed.
+ *
+ * To keep the L-BFGS history (and so its approximation of the Hessian)
+ * between the outer iterations, instead of starting each inner optimization
+ * fresh, set LBFGS().WarmStart() to true.
+ *
  * @tparam LagrangianFunction Function which can be optimized by this class.
  */
 template<typename LagrangianFunction>
@@ -23,6 +23,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_AUG_LAGRANGIAN_AUG_LAGRANGIAN_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -86,6 +87,36 @@ class AugLagrangianFunction
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the objective function and the gradient of the Augmented
+   * Lagrangian function at the same time.  Each constraint is only evaluated
+   * once, instead of once for Evaluate() and once for Gradient(); this is used
+   * by L-BFGS.
+   *
+   * @param coordinates Coordinates to evaluate at.
+   * @param gradient Matrix to store gradient into.
+   * @return Objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate every constraint at the given coordinates.  If the
+   * LagrangianFunction implements
+   *
+   *  - void EvaluateConstraints(const arma::mat& coordinates,
+   *                             arma::vec& constraints);
+   *
+   * (as LRSDP does) it is used, since evaluating all the constraints at once
+   * is usually much cheaper; otherwise EvaluateConstraint() is called for each
+   * constraint.
+   *
+   * @param coordinates Coordinates to evaluate the constraints at.
+   * @param constraints Vector to store the value of each constraint in.
+   */
+  void EvaluateConstraints(const arma::mat& coordinates,
+                           arma::vec& constraints) const;
+
   /**
    * Get the initial point of the optimization (supplied by the
    * LagrangianFunction).
@@ -117,6 +148,36 @@ class AugLagrangianFunction
   arma::vec lambda;
   //! The penalty parameter.
   double sigma;
+
+  HAS_MEM_FUNC(EvaluateConstraints, HasEvaluateConstraintsSignature)
+
+  //! Whether FunctionType has an EvaluateConstraints() method (either const or
+  //! not).
+  template<typename FunctionType>
+  struct HasEvaluateConstraints
+  {
+    static const bool value =
+        HasEvaluateConstraintsSignature<FunctionType,
+            void(FunctionType::*)(const arma::mat&, arma::vec&)>::value ||
+        HasEvaluateConstraintsSignature<FunctionType,
+            void(FunctionType::*)(const arma::mat&, arma::vec&) const>::value;
+  };
+
+  //! Evaluate the constraints with one call to the function.
+  template<typename FunctionType>
+  static void EvaluateConstraints(FunctionType& function,
+      const arma::mat& coordinates,
+      arma::vec& constraints,
+      typename boost::enable_if<HasEvaluateConstraints<FunctionType> >::type*
+          = 0);
+
+  //! Evaluate the constraints one at a time.
+  template<typename FunctionType>
+  static void EvaluateConstraints(FunctionType& function,
+      const arma::mat& coordinates,
+      arma::vec& constraints,
+      typename boost::disable_if<HasEvaluateConstraints<FunctionType> >::type*
+          = 0);
 };
 
 }; // namespace optimization
@@ -66,16 +66,12 @@ double AugLagrangianFunction<LagrangianFunction>::Evaluate(
   // First get the function's objective value.
   double objective = function.Evaluate(coordinates);
 
-  // Now loop for each constraint.
-  for (size_t i = 0; i < function.NumConstraints(); ++i)
-  {
-    double constraint = function.EvaluateConstraint(i, coordinates);
+  // Now add the terms of each constraint.
+  arma::vec constraints;
+  EvaluateConstraints(coordinates, constraints);
 
-    objective += (-lambda[i] * constraint) +
-        sigma * std::pow(constraint, 2) / 2;
-  }
-
-  return objective;
+  return objective - dot(lambda, constraints) +
+      sigma * dot(constraints, constraints) / 2;
 }
 
 // Evaluate the gradient of the AugLagrangianFunction at the given coordinates.
@@ -89,17 +85,77 @@ void AugLagrangianFunction<LagrangianFunction>::Gradient(
   gradient.zeros();
   function.Gradient(coordinates, gradient);
 
+  arma::vec constraints;
+  EvaluateConstraints(coordinates, constraints);
+
   arma::mat constraintGradient; // Temporary for constraint gradients.
   for (size_t i = 0; i < function.NumConstraints(); i++)
   {
     function.GradientConstraint(i, coordinates, constraintGradient);
 
     // Now calculate scaling factor and add to existing gradient.
-    arma::mat tmpGradient;
-    tmpGradient = (-lambda[i] + sigma *
-        function.EvaluateConstraint(i, coordinates)) * constraintGradient;
-    gradient += tmpGradient;
+    gradient += (-lambda[i] + sigma * constraints[i]) * constraintGradient;
+  }
+}
+
+// Evaluate the AugLagrangianFunction and its gradient at the given coordinates.
+template<typename LagrangianFunction>
+double AugLagrangianFunction<LagrangianFunction>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  // This is Evaluate() and Gradient() together, so that each constraint is
+  // only evaluated once.
+  double objective = function.Evaluate(coordinates);
+  gradient.zeros();
+  function.Gradient(coordinates, gradient);
+
+  arma::vec constraints;
+  EvaluateConstraints(coordinates, constraints);
+  objective += -dot(lambda, constraints) +
+      sigma * dot(constraints, constraints) / 2;
+
+  arma::mat constraintGradient; // Temporary for constraint gradients.
+  for (size_t i = 0; i < function.NumConstraints(); ++i)
+  {
+    function.GradientConstraint(i, coordinates, constraintGradient);
+    gradient += (-lambda[i] + sigma * constraints[i]) * constraintGradient;
   }
+
+  return objective;
+}
+
+// Evaluate all of the constraints at the given coordinates.
+template<typename LagrangianFunction>
+void AugLagrangianFunction<LagrangianFunction>::EvaluateConstraints(
+    const arma::mat& coordinates,
+    arma::vec& constraints) const
+{
+  EvaluateConstraints(function, coordinates, constraints);
+}
+
+template<typename LagrangianFunction>
+template<typename FunctionType>
+void AugLagrangianFunction<LagrangianFunction>::EvaluateConstraints(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    arma::vec& constraints,
+    typename boost::enable_if<HasEvaluateConstraints<FunctionType> >::type*)
+{
+  function.EvaluateConstraints(coordinates, constraints);
+}
+
+template<typename LagrangianFunction>
+template<typename FunctionType>
+void AugLagrangianFunction<LagrangianFunction>::EvaluateConstraints(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    arma::vec& constraints,
+    typename boost::disable_if<HasEvaluateConstraints<FunctionType> >::type*)
+{
+  constraints.set_size(function.NumConstraints());
+  for (size_t i = 0; i < function.NumConstraints(); ++i)
+    constraints[i] = function.EvaluateConstraint(i, coordinates);
 }
 
 // Get the initial point.
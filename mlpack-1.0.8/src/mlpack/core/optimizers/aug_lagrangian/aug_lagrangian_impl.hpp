@@ -74,10 +74,16 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
   // Track the last objective to compare for convergence.
   double lastObjective = function.Evaluate(coordinates);
 
-  // Then, calculate the current penalty.
-  double penalty = 0;
-  for (size_t i = 0; i < function.NumConstraints(); i++)
-    penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
+  // Then, calculate the current penalty.  All the constraints are evaluated
+  // at once, which can be much faster than one at a time (see
+  // AugLagrangianFunction::EvaluateConstraints()).
+  arma::vec constraints;
+  augfunc.EvaluateConstraints(coordinates, constraints);
+  double penalty = dot(constraints, constraints);
+
+  // If the L-BFGS history is kept between calls (lbfgs.WarmStart()), it is
+  // kept between the iterations of this optimization only.
+  lbfgs.ResetHistory();
 
   Log::Debug << "Penalty is " << penalty << " (threshold " << penaltyThreshold
       << ")." << std::endl;
@@ -100,24 +106,20 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
 
     // Check if we are done with the entire optimization (the threshold we are
     // comparing with is arbitrary).
-    if (std::abs(lastObjective - function.Evaluate(coordinates)) < 1e-10 &&
+    const double objective = function.Evaluate(coordinates);
+    if (std::abs(lastObjective - objective) < 1e-10 &&
         augfunc.Sigma() > 500000)
       return true;
 
-    lastObjective = function.Evaluate(coordinates);
+    lastObjective = objective;
 
     // Assuming that the optimization has converged to a new set of coordinates,
     // we now update either lambda or sigma.  We update sigma if the penalty
     // term is too high, and we update lambda otherwise.
 
     // First, calculate the current penalty.
-    double penalty = 0;
-    for (size_t i = 0; i < function.NumConstraints(); i++)
-    {
-      penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
-//      Log::Debug << "Constraint " << i << " is " <<
-//          function.EvaluateConstraint(i, coordinates) << std::endl;
-    }
+    augfunc.EvaluateConstraints(coordinates, constraints);
+    penalty = dot(constraints, constraints);
 
     Log::Warn << "Penalty is " << penalty << " (threshold "
         << penaltyThreshold << ")." << std::endl;
@@ -133,10 +135,8 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
     if (penalty < penaltyThreshold) // We update lambda.
     {
       // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates),
-      // but we have to write a loop to do this for each constraint.
-      for (size_t i = 0; i < function.NumConstraints(); i++)
-        augfunc.Lambda()[i] -= augfunc.Sigma() *
-            function.EvaluateConstraint(i, coordinates);
+      // with the constraints computed above.
+      augfunc.Lambda() -= augfunc.Sigma() * constraints;
 
       // We also update the penalty threshold to be a factor of the current
       // penalty.  TODO: this factor should be a parameter (from CLI).  The
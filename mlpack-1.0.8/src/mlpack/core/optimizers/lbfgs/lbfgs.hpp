@@ -24,6 +24,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_LBFGS_LBFGS_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -39,6 +40,16 @@ namespace optimization {
  *  - double Evaluate(const arma::mat& coordinates);
  *  - void Gradient(const arma::mat& coordinates, arma::mat& gradient);
  *  - arma::mat& GetInitialPoint();
+ *
+ * If the function also implements
+ *
+ *  - double EvaluateWithGradient(const arma::mat& coordinates,
+ *                                arma::mat& gradient);
+ *
+ * which returns the objective and stores the gradient at the same time, that
+ * is used instead of separate calls to Evaluate() and Gradient(), so that work
+ * shared between the two (such as the predictions of a model) is only done
+ * once for each point of the line search.
  */
 template<typename FunctionType>
 class L_BFGS
@@ -154,12 +165,40 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
+  //! Get whether the history (the s and y matrices) is kept between calls to
+  //! Optimize().
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether the history (the s and y matrices) is kept between calls
+  //! to Optimize().  This helps when a sequence of similar functions is
+  //! optimized, as by AugLagrangian.
+  bool& WarmStart() { return warmStart; }
+
+  //! Forget the history, so that the next call to Optimize() starts fresh even
+  //! if WarmStart() is set.
+  void ResetHistory() { historySize = 0; }
+
  private:
   //! Internal reference to the function we are optimizing.
   FunctionType& function;
 
+  // The workspace of the optimization.  These are kept between iterations and
+  // between calls to Optimize(), so that they are only allocated once for
+  // each size of the problem.
+
   //! Position of the new iterate.
   arma::mat newIterateTmp;
+  //! Position of the iterate before the last step.
+  arma::mat oldIterateTmp;
+  //! The gradient at the current iterate.
+  arma::mat gradientTmp;
+  //! The gradient at the iterate before the last step.
+  arma::mat oldGradientTmp;
+  //! The search direction.
+  arma::mat searchDirectionTmp;
+  //! The rho values of the two-loop recursion in SearchDirection().
+  arma::vec rhoTmp;
+  //! The alpha values of the two-loop recursion in SearchDirection().
+  arma::vec alphaTmp;
   //! Stores all the s matrices in memory.
   arma::cube s;
   //! Stores all the y matrices in memory.
@@ -181,6 +220,11 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! Whether to keep the history between calls to Optimize().
+  bool warmStart;
+  //! The number of (s, y) pairs stored so far (if warmStart is set, this is
+  //! kept between calls to Optimize()).
+  size_t historySize;
 
   //! Best point found so far.
   std::pair<arma::mat, double> minPointIterate;
@@ -193,6 +237,47 @@ class L_BFGS
    */
   double Evaluate(const arma::mat& iterate);
 
+  /**
+   * Evaluate the function and its gradient at the given iterate point, and
+   * store the result if it is a new minimum.
+   *
+   * @return The value of the function.
+   */
+  double EvaluateWithGradient(const arma::mat& iterate, arma::mat& gradient);
+
+  HAS_MEM_FUNC(EvaluateWithGradient, HasEvaluateWithGradientSignature)
+
+  //! Whether EvaluateFunctionType has an EvaluateWithGradient() method (either
+  //! const or not).
+  template<typename EvaluateFunctionType>
+  struct HasEvaluateWithGradient
+  {
+    static const bool value =
+        HasEvaluateWithGradientSignature<EvaluateFunctionType,
+            double(EvaluateFunctionType::*)(const arma::mat&,
+            arma::mat&)>::value ||
+        HasEvaluateWithGradientSignature<EvaluateFunctionType,
+            double(EvaluateFunctionType::*)(const arma::mat&,
+            arma::mat&) const>::value;
+  };
+
+  //! Evaluate the objective and gradient with one call to the function.
+  template<typename EvaluateFunctionType>
+  static double EvaluateWithGradient(EvaluateFunctionType& function,
+      const arma::mat& iterate,
+      arma::mat& gradient,
+      typename boost::enable_if<HasEvaluateWithGradient<
+          EvaluateFunctionType> >::type* = 0);
+
+  //! Evaluate the objective and gradient with separate calls to Evaluate() and
+  //! Gradient().
+  template<typename EvaluateFunctionType>
+  static double EvaluateWithGradient(EvaluateFunctionType& function,
+      const arma::mat& iterate,
+      arma::mat& gradient,
+      typename boost::disable_if<HasEvaluateWithGradient<
+          EvaluateFunctionType> >::type* = 0);
+
   /**
    * Calculate the scaling factor, gamma, which is used to scale the Hessian
    * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal
@@ -60,7 +60,9 @@ L_BFGS<FunctionType>::L_BFGS(FunctionType& function,
     minGradientNorm(minGradientNorm),
     maxLineSearchTrials(maxLineSearchTrials),
     minStep(minStep),
-    maxStep(maxStep)
+    maxStep(maxStep),
+    warmStart(false),
+    historySize(0)
 {
   // Get the dimensions of the coordinates of the function; GetInitialPoint()
   // might return an arma::vec, but that's okay because then n_cols will simply
@@ -99,6 +101,52 @@ double L_BFGS<FunctionType>::Evaluate(const arma::mat& iterate)
   return functionValue;
 }
 
+/**
+ * Evaluate the function and its gradient at the given iterate point and store
+ * the result if it is a new minimum.
+ *
+ * @return The value of the function
+ */
+template<typename FunctionType>
+double L_BFGS<FunctionType>::EvaluateWithGradient(const arma::mat& iterate,
+                                                  arma::mat& gradient)
+{
+  double functionValue = EvaluateWithGradient(function, iterate, gradient);
+
+  if (functionValue < minPointIterate.second)
+  {
+    minPointIterate.first = iterate;
+    minPointIterate.second = functionValue;
+  }
+
+  return functionValue;
+}
+
+template<typename FunctionType>
+template<typename EvaluateFunctionType>
+double L_BFGS<FunctionType>::EvaluateWithGradient(
+    EvaluateFunctionType& function,
+    const arma::mat& iterate,
+    arma::mat& gradient,
+    typename boost::enable_if<HasEvaluateWithGradient<
+        EvaluateFunctionType> >::type*)
+{
+  return function.EvaluateWithGradient(iterate, gradient);
+}
+
+template<typename FunctionType>
+template<typename EvaluateFunctionType>
+double L_BFGS<FunctionType>::EvaluateWithGradient(
+    EvaluateFunctionType& function,
+    const arma::mat& iterate,
+    arma::mat& gradient,
+    typename boost::disable_if<HasEvaluateWithGradient<
+        EvaluateFunctionType> >::type*)
+{
+  function.Gradient(iterate, gradient);
+  return function.Evaluate(iterate);
+}
+
 /**
  * Calculate the scaling factor gamma which is used to scale the Hessian
  * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal (1989).
@@ -193,10 +241,8 @@ bool L_BFGS<FunctionType>::LineSearch(double& functionValue,
   {
     // Perform a step and evaluate the gradient and the function values at that
     // point.
-    newIterateTmp = iterate;
-    newIterateTmp += stepSize * searchDirection;
-    functionValue = Evaluate(newIterateTmp);
-    function.Gradient(newIterateTmp, gradient);
+    newIterateTmp = iterate + stepSize * searchDirection;
+    functionValue = EvaluateWithGradient(newIterateTmp, gradient);
     numIterations++;
 
     if (functionValue > initialFunctionValue + stepSize *
@@ -265,9 +311,11 @@ void L_BFGS<FunctionType>::SearchDirection(const arma::mat& gradient,
   // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
   // matrices with limited storage" (Nocedal, 1980).
 
-  // Temporary variables.
-  arma::vec rho(numBasis);
-  arma::vec alpha(numBasis);
+  // Temporary variables (kept in the workspace).
+  rhoTmp.set_size(numBasis);
+  alphaTmp.set_size(numBasis);
+  arma::vec& rho = rhoTmp;
+  arma::vec& alpha = alphaTmp;
 
   size_t limit = (numBasis > iterationNum) ? 0 : (iterationNum - numBasis);
   for (size_t i = iterationNum; i != limit; i--)
@@ -357,39 +405,44 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   const size_t rows = function.GetInitialPoint().n_rows;
   const size_t cols = function.GetInitialPoint().n_cols;
 
+  // The history can only be reused if it has the right size.
+  if (!warmStart || (s.n_rows != rows) || (s.n_cols != cols) ||
+      (s.n_slices != numBasis))
+    historySize = 0;
+
   s.set_size(rows, cols, numBasis);
   y.set_size(rows, cols, numBasis);
   minPointIterate.second = std::numeric_limits<double>::max();
 
-  // The old iterate to be saved.
-  arma::mat oldIterate;
-  oldIterate.zeros(iterate.n_rows, iterate.n_cols);
+  // The old iterate to be saved, the gradient (current and old), and the
+  // search direction all live in the workspace; set_size() does nothing if
+  // they are already the right size.
+  arma::mat& oldIterate = oldIterateTmp;
+  arma::mat& gradient = gradientTmp;
+  arma::mat& oldGradient = oldGradientTmp;
+  arma::mat& searchDirection = searchDirectionTmp;
+  oldIterate.set_size(iterate.n_rows, iterate.n_cols);
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+  oldGradient.set_size(iterate.n_rows, iterate.n_cols);
+  searchDirection.set_size(iterate.n_rows, iterate.n_cols);
+  newIterateTmp.set_size(iterate.n_rows, iterate.n_cols);
 
   // Whether to optimize until convergence.
   bool optimizeUntilConvergence = (maxIterations == 0);
 
-  // The initial function value.
-  double functionValue = Evaluate(iterate);
-
-  // The gradient: the current and the old.
-  arma::mat gradient;
-  arma::mat oldGradient;
-  gradient.zeros(iterate.n_rows, iterate.n_cols);
-  oldGradient.zeros(iterate.n_rows, iterate.n_cols);
-
-  // The search direction.
-  arma::mat searchDirection;
-  searchDirection.zeros(iterate.n_rows, iterate.n_cols);
+  // The initial function value and gradient.
+  double functionValue = EvaluateWithGradient(iterate, gradient);
 
-  // The initial gradient value.
-  function.Gradient(iterate, gradient);
+  // Whether functionValue is the objective at the final iterate; it is not if
+  // the line search failed.
+  bool functionValueCurrent = true;
 
   // The main optimization loop.
   for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
        ++itNum)
   {
     Log::Debug << "L-BFGS iteration " << itNum << "; objective " <<
-        function.Evaluate(iterate) << "." << std::endl;
+        functionValue << "." << std::endl;
 
     // Break when the norm of the gradient becomes too small.
     if (GradientNormTooSmall(gradient))
@@ -399,12 +452,13 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
       break;
     }
 
-    // Choose the scaling factor.
-    double scalingFactor = ChooseScalingFactor(itNum, gradient);
+    // Choose the scaling factor.  The history may go back further than this
+    // call, so it is indexed by the number of pairs stored.
+    double scalingFactor = ChooseScalingFactor(historySize, gradient);
 
     // Build an approximation to the Hessian and choose the search
     // direction for the current iteration.
-    SearchDirection(gradient, itNum, scalingFactor, searchDirection);
+    SearchDirection(gradient, historySize, scalingFactor, searchDirection);
 
     // Save the old iterate and the gradient before stepping.
     oldIterate = iterate;
@@ -414,12 +468,15 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
     if (!LineSearch(functionValue, iterate, gradient, searchDirection))
     {
       Log::Debug << "Line search failed.  Stopping optimization." << std::endl;
+      functionValueCurrent = false;
       break; // The line search failed; nothing else to try.
     }
 
     // It is possible that the difference between the two coordinates is zero.
-    // In this case we terminate successfully.
-    if (accu(iterate != oldIterate) == 0)
+    // In this case we terminate successfully.  (This is checked without
+    // allocating a temporary.)
+    if (std::equal(iterate.memptr(), iterate.memptr() + iterate.n_elem,
+        oldIterate.memptr()))
     {
       Log::Debug << "L-BFGS step size of 0 (terminating successfully)."
           << std::endl;
@@ -427,11 +484,14 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
     }
 
     // Overwrite an old basis set.
-    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient);
+    UpdateBasisSet(historySize, iterate, oldIterate, gradient, oldGradient);
+    ++historySize;
 
   } // End of the optimization loop.
 
-  return function.Evaluate(iterate);
+  // If every line search succeeded, the objective at the final iterate is
+  // already known.
+  return functionValueCurrent ? functionValue : function.Evaluate(iterate);
 }
 
 }; // namespace optimization
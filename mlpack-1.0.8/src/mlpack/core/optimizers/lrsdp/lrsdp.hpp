@@ -29,6 +29,25 @@
 namespace mlpack {
 namespace optimization {
 
+/**
+ * A low-rank semidefinite program, solved with the method of Monteiro and
+ * Burer: minimize Tr(C R R^T) subject to Tr(A_i R R^T) = b_i for each
+ * constraint i, over matrices R of size (rows) x (rank).  The matrix R R^T is
+ * never formed, so the cost of each iteration depends on the sizes of C and
+ * the A_i's as they are stored rather than on rows^2.
+ *
+ * The objective matrix is C() + SparseC(); either may be left empty.  Each
+ * constraint i is stored in one of four ways, given by AModes()[i]:
+ *
+ *  - 0: A_i is the dense matrix A()[i].
+ *  - 1: A()[i] is a 3 x k matrix of entries of A_i; each column holds a row,
+ *       a column, and a value.
+ *  - 2: A_i is the sparse matrix SparseA()[i].
+ *  - 3: A_i is the low-rank matrix U()[i] * trans(V()[i]).
+ *
+ * Constraint matrices are assumed to be symmetric except for low-rank ones, for
+ * which the gradient of the (nonsymmetric) constraint is used exactly.
+ */
 class LRSDP
 {
  public:
@@ -77,12 +96,36 @@ class LRSDP
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the gradient of Tr(C R R^T) - sum_i y_i Tr(A_i R R^T) at the given
+   * coordinates R; this is the gradient of the augmented Lagrangian for the
+   * right choice of y.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param y Weight of each constraint.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates,
+                const arma::vec& y,
+                arma::mat& gradient) const;
+
   /**
    * Evaluate a particular constraint of the LRSDP at the given coordinates.
    */
   double EvaluateConstraint(const size_t index,
                             const arma::mat& coordinates) const;
 
+  /**
+   * Evaluate every constraint of the LRSDP at the given coordinates.  This is
+   * cheaper than calling EvaluateConstraint() for each constraint, and the
+   * constraints are evaluated in parallel if Threads() is not 1.
+   *
+   * @param coordinates Coordinates to evaluate the constraints at.
+   * @param constraints Vector to store Tr(A_i R R^T) - b_i in, for each i.
+   */
+  void EvaluateConstraints(const arma::mat& coordinates,
+                           arma::vec& constraints) const;
+
   /**
    * Evaluate the gradient of a particular constraint of the LRSDP at the given
    * coordinates.
@@ -102,11 +145,31 @@ class LRSDP
   //! Modify the objective function matrix (C).
   arma::mat& C() { return c; }
 
+  //! Return the sparse part of the objective function matrix.
+  const arma::sp_mat& SparseC() const { return sparseC; }
+  //! Modify the sparse part of the objective function matrix.
+  arma::sp_mat& SparseC() { return sparseC; }
+
   //! Return the vector of A matrices (which correspond to the constraints).
   const std::vector<arma::mat>& A() const { return a; }
   //! Modify the veector of A matrices (which correspond to the constraints).
   std::vector<arma::mat>& A() { return a; }
 
+  //! Return the vector of sparse A matrices (used with mode 2).
+  const std::vector<arma::sp_mat>& SparseA() const { return sparseA; }
+  //! Modify the vector of sparse A matrices (used with mode 2).
+  std::vector<arma::sp_mat>& SparseA() { return sparseA; }
+
+  //! Return the vector of U factors of low-rank A matrices (used with mode 3).
+  const std::vector<arma::mat>& U() const { return u; }
+  //! Modify the vector of U factors of low-rank A matrices (used with mode 3).
+  std::vector<arma::mat>& U() { return u; }
+
+  //! Return the vector of V factors of low-rank A matrices (used with mode 3).
+  const std::vector<arma::mat>& V() const { return v; }
+  //! Modify the vector of V factors of low-rank A matrices (used with mode 3).
+  std::vector<arma::mat>& V() { return v; }
+
   //! Return the vector of modes for the A matrices.
   const arma::uvec& AModes() const { return aModes; }
   //! Modify the vector of modes for the A matrices.
@@ -117,24 +180,40 @@ class LRSDP
   //! Modify the vector of B values.
   arma::vec& B() { return b; }
 
+  //! Get the number of threads used to evaluate the constraints (0 means all
+  //! available cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to evaluate the constraints (0 means
+  //! all available cores).
+  size_t& Threads() { return threads; }
+
   //! Return the augmented Lagrangian object.
   const AugLagrangian<LRSDP>& AugLag() const { return augLag; }
   //! Modify the augmented Lagrangian object.
   AugLagrangian<LRSDP>& AugLag() { return augLag; }
 
  private:
-  // Should probably use sparse matrices for some of these.
-
   //! For objective function.
   arma::mat c;
-  //! A_i for each constraint.
+  //! Sparse part of the objective function.
+  arma::sp_mat sparseC;
+  //! A_i for each dense constraint, or its entries.
   std::vector<arma::mat> a;
+  //! A_i for each sparse constraint.
+  std::vector<arma::sp_mat> sparseA;
+  //! U_i for each low-rank constraint.
+  std::vector<arma::mat> u;
+  //! V_i for each low-rank constraint.
+  std::vector<arma::mat> v;
   //! b_i for each constraint.
   arma::vec b;
 
-  //! 1 if entries in matrix, 0 for normal.
+  //! How each A_i is stored (see the class documentation).
   arma::uvec aModes;
 
+  //! Number of threads used to evaluate the constraints.
+  size_t threads;
+
   //! Initial point.
   arma::mat initialPoint;
 
@@ -143,6 +222,31 @@ class LRSDP
 
   //! The AugLagrangian object which will be used for optimization.
   AugLagrangian<LRSDP>& augLag;
+
+  //! Return Tr(A_i R R^T), given R and its transpose (which may be empty).
+  double ConstraintTrace(const size_t index,
+                         const arma::mat& coordinates,
+                         const arma::mat& coordinatesT) const;
+
+  /**
+   * Add weight times the gradient of Tr(A_i R R^T) to the gradient.  Parts of
+   * it are added to the transpose of the gradient (gradientT), and dense
+   * constraints are added to s (allocated if empty) which must be multiplied
+   * by 2 R afterwards; see FinishGradient().
+   */
+  void AddConstraintGradient(const size_t index,
+                             const double weight,
+                             const arma::mat& coordinates,
+                             const arma::mat& coordinatesT,
+                             arma::mat& gradient,
+                             arma::mat& gradientT,
+                             arma::mat& s) const;
+
+  //! Add the parts accumulated by AddConstraintGradient() to the gradient.
+  void FinishGradient(const arma::mat& coordinates,
+                      const arma::mat& gradientT,
+                      const arma::mat& s,
+                      arma::mat& gradient) const;
 };
 
 }; // namespace optimization
@@ -26,29 +26,45 @@
 // In case it hasn't already been included.
 #include "lrsdp.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace optimization {
 
 LRSDP::LRSDP(const size_t numConstraints,
              const arma::mat& initialPoint) :
     a(numConstraints),
+    sparseA(numConstraints),
+    u(numConstraints),
+    v(numConstraints),
     b(numConstraints),
     aModes(numConstraints),
+    threads(1),
     initialPoint(initialPoint),
     augLagInternal(*this),
     augLag(augLagInternal)
-{ }
+{
+  aModes.zeros();
+}
 
 LRSDP::LRSDP(const size_t numConstraints,
              const arma::mat& initialPoint,
              AugLagrangian<LRSDP>& augLag) :
     a(numConstraints),
+    sparseA(numConstraints),
+    u(numConstraints),
+    v(numConstraints),
     b(numConstraints),
     aModes(numConstraints),
+    threads(1),
     initialPoint(initialPoint),
     augLagInternal(*this),
     augLag(augLag)
-{ }
+{
+  aModes.zeros();
+}
 
 double LRSDP::Optimize(arma::mat& coordinates)
 {
@@ -60,36 +76,92 @@ double LRSDP::Optimize(arma::mat& coordinates)
 
 double LRSDP::Evaluate(const arma::mat& coordinates) const
 {
-  return -accu(coordinates * trans(coordinates));
+  // Tr(C R R^T) = sum((C R) % R), which does not need R R^T.
+  double objective = 0.0;
+  if (c.n_elem > 0)
+    objective += accu((c * coordinates) % coordinates);
+  if (sparseC.n_nonzero > 0)
+    objective += accu((sparseC * coordinates) % coordinates);
+
+  return objective;
 }
 
-void LRSDP::Gradient(const arma::mat& /*coordinates*/,
-                     arma::mat& /*gradient*/) const
+void LRSDP::Gradient(const arma::mat& coordinates, arma::mat& gradient) const
 {
-  Log::Fatal << "LRSDP::Gradient() called!  Uh-oh..." << std::endl;
+  // The gradient of Tr(C R R^T) is 2 * C * R.
+  arma::mat gradientT, s;
+  gradientT.zeros(coordinates.n_cols, coordinates.n_rows);
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  if (c.n_elem > 0)
+    s = c;
+  if (sparseC.n_nonzero > 0)
+    gradient += 2 * (sparseC * coordinates);
+
+  FinishGradient(coordinates, gradientT, s, gradient);
+}
+
+void LRSDP::Gradient(const arma::mat& coordinates,
+                     const arma::vec& y,
+                     arma::mat& gradient) const
+{
+  // The gradient is 2 * S * R, with S = C - sum_{i = 1}^{m} y_i A_i, but S is
+  // only formed for the dense matrices.
+  const arma::mat coordinatesT = trans(coordinates);
+  arma::mat gradientT, s;
+  gradientT.zeros(coordinates.n_cols, coordinates.n_rows);
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  if (c.n_elem > 0)
+    s = c;
+  if (sparseC.n_nonzero > 0)
+    gradient += 2 * (sparseC * coordinates);
+
+  for (size_t i = 0; i < b.n_elem; ++i)
+    AddConstraintGradient(i, -y[i], coordinates, coordinatesT, gradient,
+        gradientT, s);
+
+  FinishGradient(coordinates, gradientT, s, gradient);
 }
 
 double LRSDP::EvaluateConstraint(const size_t index,
                                  const arma::mat& coordinates) const
 {
-  arma::mat rrt = coordinates * trans(coordinates);
-  if (aModes[index] == 0)
-    return trace(a[index] * rrt) - b[index];
-  else
-  {
-    double value = -b[index];
-    for (size_t i = 0; i < a[index].n_cols; ++i)
-      value += a[index](2, i) * rrt(a[index](0, i), a[index](1, i));
+  // This is called for each constraint, so R^T is not computed.
+  return ConstraintTrace(index, coordinates, arma::mat()) - b[index];
+}
 
-    return value;
-  }
+void LRSDP::EvaluateConstraints(const arma::mat& coordinates,
+                                arma::vec& constraints) const
+{
+  const arma::mat coordinatesT = trans(coordinates);
+
+  // Check the modes first, so that no error is given inside the parallel loop.
+  for (size_t i = 0; i < aModes.n_elem; ++i)
+    if (aModes[i] > 3)
+      Log::Fatal << "Unknown mode " << aModes[i] << " of LRSDP constraint "
+          << i << "." << std::endl;
+
+  size_t numThreads = Threads::Count(threads);
+
+  // The constraints are independent, and each one only reads the coordinates.
+  constraints.set_size(b.n_elem);
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+  for (int i = 0; i < (int) b.n_elem; ++i)
+    constraints[i] = ConstraintTrace(i, coordinates, coordinatesT) - b[i];
 }
 
-void LRSDP::GradientConstraint(const size_t /*index*/,
-                               const arma::mat& /*coordinates*/,
-                               arma::mat& /*gradient*/) const
+void LRSDP::GradientConstraint(const size_t index,
+                               const arma::mat& coordinates,
+                               arma::mat& gradient) const
 {
-  Log::Fatal << "LRSDP::GradientConstraint() called!  Uh-oh..." << std::endl;
+  arma::mat gradientT, s;
+  gradientT.zeros(coordinates.n_cols, coordinates.n_rows);
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  AddConstraintGradient(index, 1.0, coordinates, trans(coordinates), gradient,
+      gradientT, s);
+  FinishGradient(coordinates, gradientT, s, gradient);
 }
 
 const arma::mat& LRSDP::GetInitialPoint()
@@ -97,45 +169,117 @@ const arma::mat& LRSDP::GetInitialPoint()
   return initialPoint;
 }
 
-// Custom specializations of the AugmentedLagrangianFunction for the LRSDP case.
-template<>
-double AugLagrangianFunction<LRSDP>::Evaluate(const arma::mat& coordinates)
-    const
+double LRSDP::ConstraintTrace(const size_t index,
+                              const arma::mat& coordinates,
+                              const arma::mat& coordinatesT) const
 {
-  // We can calculate the entire objective in a smart way.
-  // L(R, y, s) = Tr(C * (R R^T)) -
-  //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
-  //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
-
-  // Let's start with the objective: Tr(C * (R R^T)).
-  // Simple, possibly slow solution.
-  arma::mat rrt = coordinates * trans(coordinates);
-  double objective = trace(function.C() * rrt);
-
-  // Now each constraint.
-  for (size_t i = 0; i < function.B().n_elem; ++i)
+  switch (aModes[index])
   {
-    // Take the trace subtracted by the b_i.
-    double constraint = -function.B()[i];
+    case 0:
+      // Tr(A R R^T) = sum((A R) % R).
+      return accu((a[index] * coordinates) % coordinates);
 
-    if (function.AModes()[i] == 0)
+    case 1:
     {
-      constraint += trace(function.A()[i] * rrt);
-    }
-    else
-    {
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
+      // Each entry contributes A_pq * (R R^T)_pq; the rows of R are the
+      // (contiguous) columns of R^T, if it was given.
+      const arma::mat& entries = a[index];
+      double value = 0.0;
+      for (size_t i = 0; i < entries.n_cols; ++i)
       {
-        constraint += function.A()[i](2, j) *
-            rrt(function.A()[i](0, j), function.A()[i](1, j));
+        const size_t p = (size_t) entries(0, i);
+        const size_t q = (size_t) entries(1, i);
+        if (coordinatesT.n_elem > 0)
+          value += entries(2, i) * dot(coordinatesT.col(p),
+              coordinatesT.col(q));
+        else
+          value += entries(2, i) * dot(coordinates.row(p), coordinates.row(q));
       }
+
+      return value;
     }
 
-    objective -= (lambda[i] * constraint);
-    objective += (sigma / 2) * std::pow(constraint, 2.0);
+    case 2:
+      return accu((sparseA[index] * coordinates) % coordinates);
+
+    case 3:
+      // Tr(U V^T R R^T) = sum((R^T U) % (R^T V)).
+      return accu((trans(coordinates) * u[index]) %
+          (trans(coordinates) * v[index]));
+
+    default:
+      Log::Fatal << "Unknown mode " << aModes[index] << " of LRSDP constraint "
+          << index << "." << std::endl;
+      return 0.0;
   }
+}
 
-  return objective;
+void LRSDP::AddConstraintGradient(const size_t index,
+                                  const double weight,
+                                  const arma::mat& coordinates,
+                                  const arma::mat& coordinatesT,
+                                  arma::mat& gradient,
+                                  arma::mat& gradientT,
+                                  arma::mat& s) const
+{
+  switch (aModes[index])
+  {
+    case 0:
+      if (s.n_elem == 0)
+        s.zeros(coordinates.n_rows, coordinates.n_rows);
+      s += weight * a[index];
+      break;
+
+    case 1:
+    {
+      // Row p of the gradient gets 2 * A_pq * (row q of R).
+      const arma::mat& entries = a[index];
+      for (size_t i = 0; i < entries.n_cols; ++i)
+        gradientT.col((size_t) entries(0, i)) += (2 * weight * entries(2, i)) *
+            coordinatesT.col((size_t) entries(1, i));
+      break;
+    }
+
+    case 2:
+      gradient += (2 * weight) * (sparseA[index] * coordinates);
+      break;
+
+    case 3:
+      // The gradient of v^T R R^T u is (u v^T + v u^T) R.
+      gradient += weight * (u[index] * (trans(v[index]) * coordinates) +
+          v[index] * (trans(u[index]) * coordinates));
+      break;
+
+    default:
+      Log::Fatal << "Unknown mode " << aModes[index] << " of LRSDP constraint "
+          << index << "." << std::endl;
+  }
+}
+
+void LRSDP::FinishGradient(const arma::mat& coordinates,
+                           const arma::mat& gradientT,
+                           const arma::mat& s,
+                           arma::mat& gradient) const
+{
+  if (s.n_elem > 0)
+    gradient += 2 * s * coordinates;
+  gradient += trans(gradientT);
+}
+
+// Custom specializations of the AugmentedLagrangianFunction for the LRSDP case.
+template<>
+double AugLagrangianFunction<LRSDP>::Evaluate(const arma::mat& coordinates)
+    const
+{
+  // We can calculate the entire objective in a smart way.
+  // L(R, y, s) = Tr(C * (R R^T)) -
+  //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
+  //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
+  arma::vec constraints;
+  function.EvaluateConstraints(coordinates, constraints);
+
+  return function.Evaluate(coordinates) - dot(lambda, constraints) +
+      (sigma / 2) * dot(constraints, constraints);
 }
 
 template<>
@@ -147,43 +291,27 @@ void AugLagrangianFunction<LRSDP>::Gradient(const arma::mat& coordinates,
   //   with
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
-  arma::mat rrt = coordinates * trans(coordinates);
-  arma::mat s = function.C();
+  arma::vec constraints;
+  function.EvaluateConstraints(coordinates, constraints);
 
-  for (size_t i = 0; i < function.B().n_elem; ++i)
-  {
-    double constraint = -function.B()[i];
-
-    if (function.AModes()[i] == 0)
-    {
-      constraint += trace(function.A()[i] * rrt);
-    }
-    else
-    {
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
-      {
-        constraint += function.A()[i](2, j) *
-            rrt(function.A()[i](0, j), function.A()[i](1, j));
-      }
-    }
+  const arma::vec y = lambda - sigma * constraints;
+  function.Gradient(coordinates, y, gradient);
+}
 
-    double y = lambda[i] - sigma * constraint;
+template<>
+double AugLagrangianFunction<LRSDP>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  // Both of the above, with the constraints only evaluated once.
+  arma::vec constraints;
+  function.EvaluateConstraints(coordinates, constraints);
 
-    if (function.AModes()[i] == 0)
-    {
-      s -= (y * function.A()[i]);
-    }
-    else
-    {
-      // We only need to subtract the entries which could be modified.
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
-      {
-        s(function.A()[i](0, j), function.A()[i](1, j)) -= y;
-      }
-    }
-  }
+  const arma::vec y = lambda - sigma * constraints;
+  function.Gradient(coordinates, y, gradient);
 
-  gradient = 2 * s * coordinates;
+  return function.Evaluate(coordinates) - dot(lambda, constraints) +
+      (sigma / 2) * dot(constraints, constraints);
 }
 
 }; // namespace optimization
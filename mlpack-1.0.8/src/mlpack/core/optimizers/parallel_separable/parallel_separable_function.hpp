@@ -0,0 +1,156 @@
+/**
+ * @file parallel_separable_function.hpp
+ *
+ * An adapter which evaluates the objective and gradient of a separable
+ * function as a parallel sum over its separable functions, for full-batch
+ * optimizers such as L-BFGS.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SEPARABLE_FUNCTION_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SEPARABLE_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * An adapter which turns a separable function, which is a sum
+ *
+ * \f[
+ * f(A) = \sum_{i = 0}^{n} f_i(A),
+ * \f]
+ *
+ * into a function whose full objective and gradient are evaluated in
+ * parallel, so that full-batch optimizers (L_BFGS, or the inner optimizer of
+ * AugLagrangian) use every core without the function implementing its own
+ * threading.  The separable functions are split into one contiguous block per
+ * thread; each thread sums the objectives and gradients of its block into its
+ * own buffer, and the blocks are then summed in a fixed order, so the result
+ * only depends on the number of threads.
+ *
+ * FunctionType must implement the separable interface used by SGD, and its
+ * separable overloads must be safe to call from several threads at once:
+ *
+ *  - size_t NumFunctions() const;
+ *  - double Evaluate(const arma::mat& coordinates, const size_t i) const;
+ *  - void Gradient(const arma::mat& coordinates, const size_t i,
+ *        arma::mat& gradient) const;
+ *  - const arma::mat& GetInitialPoint() const;
+ *
+ * For example, to train logistic regression with L-BFGS on four threads:
+ *
+ * @code
+ * LogisticRegressionFunction lrf(predictors, responses);
+ * ParallelSeparableFunction<LogisticRegressionFunction> plrf(lrf, 4);
+ * L_BFGS<ParallelSeparableFunction<LogisticRegressionFunction> > lbfgs(plrf);
+ *
+ * arma::mat parameters(lrf.GetInitialPoint());
+ * lbfgs.Optimize(parameters);
+ * @endcode
+ *
+ * Only the separable overloads of the function are used; its own full-batch
+ * Evaluate() and Gradient() (and any workspace they keep) are not.
+ *
+ * @tparam FunctionType Separable function to evaluate.
+ */
+template<typename FunctionType>
+class ParallelSeparableFunction
+{
+ public:
+  /**
+   * Wrap the given function, evaluating it with the given number of threads.
+   * The function is not copied, so it must outlive this object.
+   *
+   * @param function Separable function to evaluate.
+   * @param threads Number of threads to use; 0 means all available cores.
+   */
+  ParallelSeparableFunction(FunctionType& function, const size_t threads = 0);
+
+  /**
+   * Evaluate the objective function, as the sum of the separable objectives.
+   *
+   * @param coordinates Point at which to evaluate the function.
+   */
+  double Evaluate(const arma::mat& coordinates) const;
+
+  /**
+   * Evaluate the gradient, as the sum of the separable gradients.
+   *
+   * @param coordinates Point at which to evaluate the gradient.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
+
+  /**
+   * Evaluate the objective function and its gradient in one pass over the
+   * separable functions; this is what L_BFGS calls.
+   *
+   * @param coordinates Point at which to evaluate the function.
+   * @param gradient Matrix to store the gradient in.
+   * @return The value of the objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
+  //! Evaluate the separable objective of the given index.
+  double Evaluate(const arma::mat& coordinates, const size_t i) const
+  { return function.Evaluate(coordinates, i); }
+
+  //! Evaluate the separable gradient of the given index.
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient) const
+  { function.Gradient(coordinates, i, gradient); }
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Return the initial point of the wrapped function.
+  const arma::mat& GetInitialPoint() const
+  { return function.GetInitialPoint(); }
+
+  //! Get the wrapped function.
+  const FunctionType& Function() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& Function() { return function; }
+
+  //! Get the number of threads (0 means all available cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 means all available cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The wrapped function.
+  FunctionType& function;
+  //! The number of threads to use.
+  size_t threads;
+
+  /**
+   * Sum the separable objectives and, if gradient is not NULL, the separable
+   * gradients, over one block of indices per thread.
+   */
+  double Sum(const arma::mat& coordinates, arma::mat* gradient) const;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+// Include implementation.
+#include "parallel_separable_function_impl.hpp"
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file parallel_separable_function_impl.hpp
+ *
+ * Implementation of ParallelSeparableFunction.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SEPARABLE_FUNCTION_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SEPARABLE_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_separable_function.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename FunctionType>
+ParallelSeparableFunction<FunctionType>::ParallelSeparableFunction(
+    FunctionType& function,
+    const size_t threads) :
+    function(function),
+    threads(threads)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType>
+double ParallelSeparableFunction<FunctionType>::Evaluate(
+    const arma::mat& coordinates) const
+{
+  return Sum(coordinates, NULL);
+}
+
+template<typename FunctionType>
+void ParallelSeparableFunction<FunctionType>::Gradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  Sum(coordinates, &gradient);
+}
+
+template<typename FunctionType>
+double ParallelSeparableFunction<FunctionType>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return Sum(coordinates, &gradient);
+}
+
+template<typename FunctionType>
+double ParallelSeparableFunction<FunctionType>::Sum(
+    const arma::mat& coordinates,
+    arma::mat* gradient) const
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t blocks = std::max(std::min(Threads::Count(threads),
+      numFunctions), (size_t) 1);
+
+  // Each block has its own sum and gradient buffer.
+  arma::vec blockObjective(blocks);
+  blockObjective.zeros();
+  std::vector<arma::mat> blockGradient((gradient == NULL) ? 0 : blocks);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static)
+  for (int b = 0; b < (int) blocks; ++b)
+  {
+    const size_t begin = b * numFunctions / blocks;
+    const size_t end = (b + 1) * numFunctions / blocks;
+
+    arma::mat pointGradient;
+    if (gradient != NULL)
+      blockGradient[b].zeros(coordinates.n_rows, coordinates.n_cols);
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      blockObjective[b] += function.Evaluate(coordinates, i);
+      if (gradient != NULL)
+      {
+        function.Gradient(coordinates, i, pointGradient);
+        blockGradient[b] += pointGradient;
+      }
+    }
+  }
+
+  // Sum the blocks, always in the same order.
+  double objective = 0.0;
+  if (gradient != NULL)
+    gradient->zeros(coordinates.n_rows, coordinates.n_cols);
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    objective += blockObjective[b];
+    if (gradient != NULL)
+      *gradient += blockGradient[b];
+  }
+
+  return objective;
+}
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -22,6 +22,9 @@
 #ifndef __MLPACK_CORE_OPTIMIZERS_SGD_SGD_HPP
 #define __MLPACK_CORE_OPTIMIZERS_SGD_SGD_HPP
 
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
 namespace mlpack {
 namespace optimization {
 
@@ -77,6 +80,66 @@ namespace optimization {
  * objective function on the first point in the dataset (presumably, the dataset
  * is held internally in the DecomposableFunctionType).
  *
+ * With BatchSize() greater than 1, each step sums the gradients of a batch of
+ * consecutive functions (mini-batch SGD), and one iteration is one batch.  If
+ * DecomposableFunctionType also implements
+ *
+ *   double Evaluate(const arma::mat& coordinates,
+ *                   const size_t begin,
+ *                   const size_t batchSize);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t begin,
+ *                 const size_t batchSize,
+ *                 arma::mat& gradient);
+ *
+ * those are used to evaluate the sum over the functions [begin, begin +
+ * batchSize) at once, which can be much faster (for instance, NCA shares its
+ * precomputation between the points of a batch); otherwise, the functions of
+ * the batch are evaluated one by one.  In that case, the functions of a batch
+ * can be split between several threads (see Threads()), each of which sums
+ * into its own gradient; then the separable Evaluate() and Gradient() must be
+ * safe to call from several threads at once.
+ *
+ * Optionally, momentum can be used (see Momentum()): the step taken is then
+ * \f[
+ * v_{j + 1} = \mu v_j + \alpha \nabla f_i(A_j), \qquad A_{j + 1} = A_j -
+ * v_{j + 1}
+ * \f]
+ * where \f$ \mu \f$ is the momentum; with a momentum of 0, this is the update
+ * above.
+ *
+ * For functions with sparse gradients (such as logistic regression on sparse
+ * data), Hogwild steps can be taken instead (see Hogwild()): the functions of
+ * each pass are split between threads, which step the shared iterate without
+ * any locking, each only changing the coordinates its gradient is nonzero on.
+ * Each coordinate is updated atomically, but the gradients may be computed
+ * from an iterate that other threads are updating at the same time; when the
+ * gradients are sparse, these collisions are rare and do not hurt convergence
+ * much.  This requires the function to implement
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient);
+ *
+ * Hogwild steps do not use BatchSize() or Momentum().
+ *
+ * By default, each pass visits every function (or batch) once, in an order
+ * which is shuffled in place at the start of the pass (see Shuffle()).  With
+ * SampleWithReplacement(), each step instead draws its function (or batch)
+ * uniformly at random, so there is no shuffling at all, and a pass is as many
+ * steps as there are functions (or batches).
+ *
+ * @code
+ * @inproceedings{recht2011hogwild,
+ *   title={Hogwild!: A lock-free approach to parallelizing stochastic gradient
+ *       descent},
+ *   author={Recht, B. and Re, C. and Wright, S. and Niu, F.},
+ *   booktitle={Advances in Neural Information Processing Systems 24},
+ *   pages={693--701},
+ *   year={2011}
+ * }
+ * @endcode
+ *
  * @tparam DecomposableFunctionType Decomposable objective function type to be
  *     minimized.
  */
@@ -92,14 +155,19 @@ class SGD
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
-   * @param shuffle If true, the function order is shuffled; otherwise, each
-   *     function is visited in linear order.
+   * @param shuffle If true, the order of the functions (or batches) is
+   *     shuffled at each pass; otherwise, they are visited in linear order.
+   * @param batchSize Number of functions whose gradients are summed for each
+   *     step.
+   * @param momentum Momentum of the steps (0 means no momentum).
    */
   SGD(DecomposableFunctionType& function,
       const double stepSize = 0.01,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
-      const bool shuffle = true);
+      const bool shuffle = true,
+      const size_t batchSize = 1,
+      const double momentum = 0.0);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
@@ -136,7 +204,132 @@ class SGD
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the number of functions in each batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of functions in each batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the momentum.
+  double Momentum() const { return momentum; }
+  //! Modify the momentum (0 means no momentum).
+  double& Momentum() { return momentum; }
+
+  //! Get the number of threads used to evaluate the functions of a batch.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to evaluate the functions of a batch,
+  //! when the function has no batch overloads, or to take Hogwild steps (0
+  //! means all available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get whether or not Hogwild (lock-free parallel) steps are taken.
+  bool Hogwild() const { return hogwild; }
+  //! Modify whether or not Hogwild (lock-free parallel) steps are taken; this
+  //! requires sparse gradients from the function.
+  bool& Hogwild() { return hogwild; }
+
+  //! Get whether the functions (or batches) are sampled with replacement.
+  bool SampleWithReplacement() const { return sampleWithReplacement; }
+  //! Modify whether the functions (or batches) are sampled with replacement
+  //! instead of being visited once per pass; Shuffle() is then ignored.
+  bool& SampleWithReplacement() { return sampleWithReplacement; }
+
  private:
+  HAS_MEM_FUNC(Evaluate, HasEvaluate)
+  HAS_MEM_FUNC(Gradient, HasGradient)
+
+  //! Whether FunctionType has a batch overload of Evaluate() (either const or
+  //! not).
+  template<typename FunctionType>
+  struct HasBatchEvaluate
+  {
+    static const bool value =
+        HasEvaluate<FunctionType, double(FunctionType::*)(const arma::mat&,
+            const size_t, const size_t)>::value ||
+        HasEvaluate<FunctionType, double(FunctionType::*)(const arma::mat&,
+            const size_t, const size_t) const>::value;
+  };
+
+  //! Whether FunctionType has a batch overload of Gradient() (either const or
+  //! not).
+  template<typename FunctionType>
+  struct HasBatchGradient
+  {
+    static const bool value =
+        HasGradient<FunctionType, void(FunctionType::*)(const arma::mat&,
+            const size_t, const size_t, arma::mat&)>::value ||
+        HasGradient<FunctionType, void(FunctionType::*)(const arma::mat&,
+            const size_t, const size_t, arma::mat&) const>::value;
+  };
+
+  //! Whether FunctionType has a separable Gradient() which gives a sparse
+  //! gradient (either const or not).
+  template<typename FunctionType>
+  struct HasSparseGradient
+  {
+    static const bool value =
+        HasGradient<FunctionType, void(FunctionType::*)(const arma::mat&,
+            const size_t, arma::sp_mat&)>::value ||
+        HasGradient<FunctionType, void(FunctionType::*)(const arma::mat&,
+            const size_t, arma::sp_mat&) const>::value;
+  };
+
+  //! Evaluate the sum of the functions of a batch with the batch overload of
+  //! Evaluate().
+  template<typename FunctionType>
+  double EvaluateBatch(FunctionType& function,
+      const arma::mat& iterate,
+      const size_t begin,
+      const size_t batchSize,
+      typename boost::enable_if<HasBatchEvaluate<FunctionType> >::type* = 0)
+      const;
+
+  //! Evaluate the sum of the functions of a batch one function at a time.
+  template<typename FunctionType>
+  double EvaluateBatch(FunctionType& function,
+      const arma::mat& iterate,
+      const size_t begin,
+      const size_t batchSize,
+      typename boost::disable_if<HasBatchEvaluate<FunctionType> >::type* = 0)
+      const;
+
+  //! Evaluate the sum of the gradients of a batch with the batch overload of
+  //! Gradient().
+  template<typename FunctionType>
+  void GradientBatch(FunctionType& function,
+      const arma::mat& iterate,
+      const size_t begin,
+      const size_t batchSize,
+      arma::mat& gradient,
+      typename boost::enable_if<HasBatchGradient<FunctionType> >::type* = 0)
+      const;
+
+  //! Evaluate the sum of the gradients of a batch one function at a time.
+  template<typename FunctionType>
+  void GradientBatch(FunctionType& function,
+      const arma::mat& iterate,
+      const size_t begin,
+      const size_t batchSize,
+      arma::mat& gradient,
+      typename boost::disable_if<HasBatchGradient<FunctionType> >::type* = 0)
+      const;
+
+  //! Shuffle the given visitation order in place.
+  void ShuffleOrder(std::vector<size_t>& order) const;
+
+  //! Optimize with Hogwild updates, using the sparse gradients of the
+  //! function.
+  template<typename FunctionType>
+  double OptimizeHogwild(FunctionType& function,
+      arma::mat& iterate,
+      typename boost::enable_if<HasSparseGradient<FunctionType> >::type* = 0);
+
+  //! Hogwild updates are not available for functions without sparse
+  //! gradients; this gives a fatal error.
+  template<typename FunctionType>
+  double OptimizeHogwild(FunctionType& function,
+      arma::mat& iterate,
+      typename boost::disable_if<HasSparseGradient<FunctionType> >::type* = 0);
+
   //! The instantiated function.
   DecomposableFunctionType& function;
 
@@ -152,6 +345,24 @@ class SGD
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The number of functions in each batch.
+  size_t batchSize;
+
+  //! The momentum of the steps.
+  double momentum;
+
+  //! The number of threads used to evaluate the functions of a batch.
+  size_t threads;
+
+  //! Whether or not Hogwild steps are taken.
+  bool hogwild;
+
+  //! Whether the functions (or batches) are sampled with replacement.
+  bool sampleWithReplacement;
+
+  //! Return the number of threads to use.
+  size_t NumThreads() const;
 };
 
 }; // namespace optimization
@@ -25,6 +25,10 @@
 // In case it hasn't been included yet.
 #include "sgd.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace optimization {
 
@@ -33,43 +37,74 @@ SGD<DecomposableFunctionType>::SGD(DecomposableFunctionType& function,
                                    const double stepSize,
                                    const size_t maxIterations,
                                    const double tolerance,
-                                   const bool shuffle) :
+                                   const bool shuffle,
+                                   const size_t batchSize,
+                                   const double momentum) :
     function(function),
     stepSize(stepSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    batchSize(batchSize),
+    momentum(momentum),
+    threads(1),
+    hogwild(false),
+    sampleWithReplacement(false)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
 template<typename DecomposableFunctionType>
 double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
 {
+  if (hogwild)
+    return OptimizeHogwild(function, iterate);
+
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
-  // This is used only if shuffle is true.
-  arma::vec visitationOrder;
-  if (shuffle)
-    visitationOrder = arma::shuffle(arma::linspace(0, (numFunctions - 1),
-        numFunctions));
+  if (batchSize == 0)
+    Log::Fatal << "SGD: batch size must be greater than 0." << std::endl;
+
+  // The functions are visited in batches of consecutive functions (the last
+  // batch may be smaller), so that the batch overloads of the function can be
+  // used; it is the order of the batches which is shuffled.
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  std::vector<size_t> visitationOrder(numBatches);
+  for (size_t i = 0; i < numBatches; ++i)
+    visitationOrder[i] = i;
 
   // To keep track of where we are and how things are going.
-  size_t currentFunction = 0;
+  size_t currentBatch = 0;
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
   // Calculate the first objective function.
-  for (size_t i = 0; i < numFunctions; ++i)
-    overallObjective += function.Evaluate(iterate, i);
+  if (batchSize == 1)
+  {
+    for (size_t i = 0; i < numFunctions; ++i)
+      overallObjective += function.Evaluate(iterate, i);
+  }
+  else
+  {
+    overallObjective = EvaluateBatch(function, iterate, 0, numFunctions);
+  }
 
-  // Now iterate!
+  // Now iterate!  Each iteration takes one step, over the functions
+  // [currentFunction, currentFunction + currentBatchSize) of one batch.
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  for (size_t i = 1; i != maxIterations; ++i, ++currentFunction)
+  arma::mat velocity;
+  if (momentum != 0.0)
+    velocity.zeros(iterate.n_rows, iterate.n_cols);
+  for (size_t i = 1; i != maxIterations; ++i, ++currentBatch)
   {
     // Is this iteration the start of a sequence?
-    if ((currentFunction % numFunctions) == 0)
+    if ((currentBatch % numBatches) == 0)
     {
+      // Random draws do not cover every function, so when sampling with
+      // replacement the objective is evaluated over all of them instead.
+      if (sampleWithReplacement && i > 1)
+        overallObjective = EvaluateBatch(function, iterate, 0, numFunctions);
+
       // Output current objective function.
       Log::Info << "SGD: iteration " << i << ", objective " << overallObjective
           << "." << std::endl;
@@ -91,20 +126,215 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       // Reset the counter variables.
       lastObjective = overallObjective;
       overallObjective = 0;
-      currentFunction = 0;
+      currentBatch = 0;
 
-      if (shuffle) // Determine order of visitation.
-        visitationOrder = arma::shuffle(visitationOrder);
+      if (shuffle && !sampleWithReplacement) // Determine order of visitation.
+        ShuffleOrder(visitationOrder);
     }
 
+    // When sampling with replacement, each batch is drawn independently, and a
+    // sequence is as many draws as there are batches.
+    const size_t batch = sampleWithReplacement ?
+        (size_t) math::RandInt((int) numBatches) :
+        visitationOrder[currentBatch];
+    const size_t currentFunction = batch * batchSize;
+    const size_t currentBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+
     // Evaluate the gradient for this iteration.
-    function.Gradient(iterate, currentFunction, gradient);
+    if (currentBatchSize == 1)
+      function.Gradient(iterate, currentFunction, gradient);
+    else
+      GradientBatch(function, iterate, currentFunction, currentBatchSize,
+          gradient);
 
     // And update the iterate.
-    iterate -= stepSize * gradient;
+    if (momentum == 0.0)
+    {
+      iterate -= stepSize * gradient;
+    }
+    else
+    {
+      velocity = momentum * velocity + stepSize * gradient;
+      iterate -= velocity;
+    }
 
     // Now add that to the overall objective function.
-    overallObjective += function.Evaluate(iterate, currentFunction);
+    if (sampleWithReplacement)
+      continue; // It is evaluated at the start of the next sequence.
+    if (currentBatchSize == 1)
+      overallObjective += function.Evaluate(iterate, currentFunction);
+    else
+      overallObjective += EvaluateBatch(function, iterate, currentFunction,
+          currentBatchSize);
+  }
+
+  Log::Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+  return overallObjective;
+}
+
+//! Shuffle the given order in place (Fisher-Yates).
+template<typename DecomposableFunctionType>
+void SGD<DecomposableFunctionType>::ShuffleOrder(std::vector<size_t>& order)
+    const
+{
+  for (size_t i = order.size(); i > 1; --i)
+    std::swap(order[i - 1], order[math::RandInt((int) i)]);
+}
+
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+double SGD<DecomposableFunctionType>::EvaluateBatch(
+    FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    typename boost::enable_if<HasBatchEvaluate<FunctionType> >::type*) const
+{
+  return function.Evaluate(iterate, begin, batchSize);
+}
+
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+double SGD<DecomposableFunctionType>::EvaluateBatch(
+    FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    typename boost::disable_if<HasBatchEvaluate<FunctionType> >::type*) const
+{
+  double objective = 0;
+  #pragma omp parallel for num_threads(NumThreads()) schedule(static) \
+      reduction(+:objective)
+  for (int i = 0; i < (int) batchSize; ++i)
+    objective += function.Evaluate(iterate, begin + i);
+
+  return objective;
+}
+
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+void SGD<DecomposableFunctionType>::GradientBatch(
+    FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient,
+    typename boost::enable_if<HasBatchGradient<FunctionType> >::type*) const
+{
+  function.Gradient(iterate, begin, batchSize, gradient);
+}
+
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+void SGD<DecomposableFunctionType>::GradientBatch(
+    FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient,
+    typename boost::disable_if<HasBatchGradient<FunctionType> >::type*) const
+{
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+
+  // Each thread sums the gradients of its functions into its own matrix, so
+  // that only one addition per thread has to be synchronized.
+  #pragma omp parallel num_threads(NumThreads())
+  {
+    arma::mat threadGradient;
+    threadGradient.zeros(iterate.n_rows, iterate.n_cols);
+    arma::mat functionGradient;
+
+    #pragma omp for schedule(static)
+    for (int i = 0; i < (int) batchSize; ++i)
+    {
+      function.Gradient(iterate, begin + i, functionGradient);
+      threadGradient += functionGradient;
+    }
+
+    #pragma omp critical
+    gradient += threadGradient;
+  }
+}
+
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+double SGD<DecomposableFunctionType>::OptimizeHogwild(
+    FunctionType& function,
+    arma::mat& iterate,
+    typename boost::enable_if<HasSparseGradient<FunctionType> >::type*)
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  std::vector<size_t> visitationOrder(sampleWithReplacement ? 0 :
+      numFunctions);
+  for (size_t i = 0; i < visitationOrder.size(); ++i)
+    visitationOrder[i] = i;
+
+  double overallObjective = EvaluateBatch(function, iterate, 0, numFunctions);
+  double lastObjective = DBL_MAX;
+
+  // The threads write straight into the memory of the iterate.
+  double* coordinates = iterate.memptr();
+  const size_t rows = iterate.n_rows;
+
+  size_t iterations = 0;
+  while ((maxIterations == 0) || (iterations < maxIterations))
+  {
+    Log::Info << "SGD: iteration " << iterations << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (overallObjective != overallObjective)
+    {
+      Log::Warn << "SGD: converged to " << overallObjective << "; terminating"
+          << " with failure.  Try a smaller step size?" << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Log::Info << "SGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    lastObjective = overallObjective;
+    if (shuffle && !sampleWithReplacement)
+      ShuffleOrder(visitationOrder);
+
+    // Take one pass over the functions (or what is left of the iterations),
+    // with no synchronization between the threads other than the atomic
+    // update of each coordinate.
+    const size_t steps = (maxIterations == 0) ? numFunctions :
+        std::min(numFunctions, maxIterations - iterations);
+
+    #pragma omp parallel num_threads(NumThreads())
+    {
+      arma::sp_mat gradient;
+
+      #pragma omp for schedule(static)
+      for (int j = 0; j < (int) steps; ++j)
+      {
+        // Each thread draws from its own random stream.
+        const size_t i = sampleWithReplacement ?
+            (size_t) math::RandInt((int) numFunctions) : visitationOrder[j];
+        function.Gradient(iterate, i, gradient);
+
+        for (arma::sp_mat::const_iterator it = gradient.begin();
+            it != gradient.end(); ++it)
+        {
+          const double step = stepSize * (*it);
+          double& coordinate = coordinates[it.row() + it.col() * rows];
+
+          #pragma omp atomic
+          coordinate -= step;
+        }
+      }
+    }
+
+    iterations += steps;
+    overallObjective = EvaluateBatch(function, iterate, 0, numFunctions);
   }
 
   Log::Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
@@ -112,6 +342,26 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
   return overallObjective;
 }
 
+template<typename DecomposableFunctionType>
+template<typename FunctionType>
+double SGD<DecomposableFunctionType>::OptimizeHogwild(
+    FunctionType& /* function */,
+    arma::mat& /* iterate */,
+    typename boost::disable_if<HasSparseGradient<FunctionType> >::type*)
+{
+  Log::Fatal << "SGD: Hogwild steps require the function to give sparse "
+      << "gradients." << std::endl;
+  return DBL_MAX;
+}
+
+template<typename DecomposableFunctionType>
+size_t SGD<DecomposableFunctionType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
+
 }; // namespace optimization
 }; // namespace mlpack
 
@@ -30,29 +30,43 @@ namespace mlpack {
 namespace bound {
 
 /**
- * Ball bound that works in the regular Euclidean metric space.
+ * Ball bound which works in any metric space, for use as the bound of a
+ * BinarySpaceTree (which is then a ball tree).  The ball is centered on the
+ * mean of the points it is expanded to hold, and its radius is the largest
+ * distance from the center to any of those points.
+ *
+ * An empty ball (as constructed, before any points are added) has a negative
+ * radius, and is infinitely far from everything.
  *
  * @tparam VecType Type of vector (arma::vec or arma::spvec).
+ * @tparam TMetricType Metric under which the ball is defined; the default is
+ *     the Euclidean distance.
  */
-template<typename VecType = arma::vec>
+template<typename VecType = arma::vec,
+         typename TMetricType = metric::LMetric<2, true> >
 class BallBound
 {
  public:
   typedef VecType Vec;
+  //! The metric under which the ball is defined.
+  typedef TMetricType MetricType;
 
  private:
+  //! The radius of the ball (negative if the ball is empty).
   double radius;
+  //! The center of the ball.
   VecType center;
 
  public:
-  BallBound() : radius(0) { }
+  //! Create an empty ball bound.
+  BallBound() : radius(-1) { }
 
   /**
-   * Create the ball bound with the specified dimensionality.
+   * Create an empty ball bound with the specified dimensionality.
    *
    * @param dimension Dimensionality of ball bound.
    */
-  BallBound(const size_t dimension) : radius(0), center(dimension) { }
+  BallBound(const size_t dimension) : radius(-1), center(dimension) { }
 
   /**
    * Create the ball bound with the specified radius and center.
@@ -73,13 +87,25 @@ class BallBound
   //! Modify the center point of the ball.
   VecType& Center() { return center; }
 
-  // Get the range in a certain dimension.
+  //! Get the dimensionality of the ball.
+  size_t Dim() const { return center.n_elem; }
+
+  //! Get the range in a certain dimension.  Every range has width Diameter(),
+  //! so these are not a tight bound of the points in the ball.
   math::Range operator[](const size_t i) const;
 
   /**
    * Determines if a point is within this bound.
    */
-  bool Contains(const VecType& point) const;
+  template<typename OtherVecType>
+  bool Contains(const OtherVecType& point) const;
+
+  /**
+   * Place the center of the ball in the given vector.
+   *
+   * @param centroid Vector which the centroid will be written to.
+   */
+  void Centroid(arma::vec& centroid) const { centroid = center; }
 
   /**
    * Gets the center.
@@ -91,19 +117,21 @@ class BallBound
   void CalculateMidpoint(VecType& centroid) const;
 
   /**
-   * Calculates minimum bound-to-point squared distance.
+   * Calculates minimum bound-to-point distance.
    */
-  double MinDistance(const VecType& point) const;
+  template<typename OtherVecType>
+  double MinDistance(const OtherVecType& point) const;
 
   /**
-   * Calculates minimum bound-to-bound squared distance.
+   * Calculates minimum bound-to-bound distance.
    */
   double MinDistance(const BallBound& other) const;
 
   /**
    * Computes maximum distance.
    */
-  double MaxDistance(const VecType& point) const;
+  template<typename OtherVecType>
+  double MaxDistance(const OtherVecType& point) const;
 
   /**
    * Computes maximum distance.
@@ -113,7 +141,8 @@ class BallBound
   /**
    * Calculates minimum and maximum bound-to-point distance.
    */
-  math::Range RangeDistance(const VecType& other) const;
+  template<typename OtherVecType>
+  math::Range RangeDistance(const OtherVecType& other) const;
 
   /**
    * Calculates minimum and maximum bound-to-bound distance.
@@ -123,13 +152,14 @@ class BallBound
   math::Range RangeDistance(const BallBound& other) const;
 
   /**
-   * Expand the bound to include the given node.
+   * Expand the bound to include the given bound.  The center is not moved.
    */
   const BallBound& operator|=(const BallBound& other);
 
   /**
-   * Expand the bound to include the given point.  The centroid is recalculated
-   * to be the center of all of the given points.
+   * Expand the bound to include the given points.  If the ball is empty, it is
+   * centered on the mean of the points; otherwise the center is not moved, and
+   * the radius grows to reach the points.
    *
    * @tparam MatType Type of matrix; could be arma::mat, arma::spmat, or a
    *     vector.
@@ -138,6 +168,15 @@ class BallBound
   template<typename MatType>
   const BallBound& operator|=(const MatType& data);
 
+  //! Returns the diameter of the ball.
+  double Diameter() const { return (radius < 0) ? 0 : 2 * radius; }
+
+  /**
+   * Return the metric associated with this bound.  It is an LMetric (or
+   * another metric without state) by default, so it can be made on the fly.
+   */
+  static MetricType Metric() { return MetricType(); }
+
   /**
    * Returns a string representation of this object.
    */
@@ -33,8 +33,8 @@ namespace mlpack {
 namespace bound {
 
 //! Get the range in a certain dimension.
-template<typename VecType>
-math::Range BallBound<VecType>::operator[](const size_t i) const
+template<typename VecType, typename TMetricType>
+math::Range BallBound<VecType, TMetricType>::operator[](const size_t i) const
 {
   if (radius < 0)
     return math::Range();
@@ -45,13 +45,14 @@ math::Range BallBound<VecType>::operator[](const size_t i) const
 /**
  * Determines if a point is within the bound.
  */
-template<typename VecType>
-bool BallBound<VecType>::Contains(const VecType& point) const
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+bool BallBound<VecType, TMetricType>::Contains(const OtherVecType& point) const
 {
   if (radius < 0)
     return false;
   else
-    return metric::EuclideanDistance::Evaluate(center, point) <= radius;
+    return MetricType::Evaluate(center, point) <= radius;
 }
 
 /**
@@ -61,37 +62,40 @@ bool BallBound<VecType>::Contains(const VecType& point) const
  * with DHrectBound, so it can plug in more directly if a "centroid"
  * is needed.
  */
-template<typename VecType>
-void BallBound<VecType>::CalculateMidpoint(VecType& centroid) const
+template<typename VecType, typename TMetricType>
+void BallBound<VecType, TMetricType>::CalculateMidpoint(VecType& centroid) const
 {
   centroid = center;
 }
 
 /**
- * Calculates minimum bound-to-point squared distance.
+ * Calculates minimum bound-to-point distance.
  */
-template<typename VecType>
-double BallBound<VecType>::MinDistance(const VecType& point) const
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+double BallBound<VecType, TMetricType>::MinDistance(const OtherVecType& point)
+    const
 {
   if (radius < 0)
     return DBL_MAX;
   else
-    return math::ClampNonNegative(metric::EuclideanDistance::Evaluate(point,
-        center) - radius);
+    return math::ClampNonNegative(MetricType::Evaluate(point, center) -
+        radius);
 }
 
 /**
- * Calculates minimum bound-to-bound squared distance.
+ * Calculates minimum bound-to-bound distance.
  */
-template<typename VecType>
-double BallBound<VecType>::MinDistance(const BallBound& other) const
+template<typename VecType, typename TMetricType>
+double BallBound<VecType, TMetricType>::MinDistance(const BallBound& other)
+    const
 {
-  if (radius < 0)
+  if (radius < 0 || other.radius < 0)
     return DBL_MAX;
   else
   {
-    double delta = metric::EuclideanDistance::Evaluate(center, other.center)
-        - radius - other.radius;
+    double delta = MetricType::Evaluate(center, other.center) - radius -
+        other.radius;
     return math::ClampNonNegative(delta);
   }
 }
@@ -99,56 +103,60 @@ double BallBound<VecType>::MinDistance(const BallBound& other) const
 /**
  * Computes maximum distance.
  */
-template<typename VecType>
-double BallBound<VecType>::MaxDistance(const VecType& point) const
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+double BallBound<VecType, TMetricType>::MaxDistance(const OtherVecType& point)
+    const
 {
   if (radius < 0)
     return DBL_MAX;
   else
-    return metric::EuclideanDistance::Evaluate(point, center) + radius;
+    return MetricType::Evaluate(point, center) + radius;
 }
 
 /**
  * Computes maximum distance.
  */
-template<typename VecType>
-double BallBound<VecType>::MaxDistance(const BallBound& other) const
+template<typename VecType, typename TMetricType>
+double BallBound<VecType, TMetricType>::MaxDistance(const BallBound& other)
+    const
 {
-  if (radius < 0)
+  if (radius < 0 || other.radius < 0)
     return DBL_MAX;
   else
-    return metric::EuclideanDistance::Evaluate(other.center, center) + radius
-        + other.radius;
+    return MetricType::Evaluate(other.center, center) + radius + other.radius;
 }
 
 /**
- * Calculates minimum and maximum bound-to-bound squared distance.
- *
- * Example: bound1.MinDistanceSq(other) for minimum squared distance.
+ * Calculates minimum and maximum bound-to-point distance.
  */
-template<typename VecType>
-math::Range BallBound<VecType>::RangeDistance(const VecType& point)
-    const
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+math::Range BallBound<VecType, TMetricType>::RangeDistance(
+    const OtherVecType& point) const
 {
   if (radius < 0)
     return math::Range(DBL_MAX, DBL_MAX);
   else
   {
-    double dist = metric::EuclideanDistance::Evaluate(center, point);
+    double dist = MetricType::Evaluate(center, point);
     return math::Range(math::ClampNonNegative(dist - radius),
                                               dist + radius);
   }
 }
 
-template<typename VecType>
-math::Range BallBound<VecType>::RangeDistance(
+/**
+ * Calculates minimum and maximum bound-to-bound distance.
+ */
+template<typename VecType, typename TMetricType>
+math::Range BallBound<VecType, TMetricType>::RangeDistance(
     const BallBound& other) const
 {
-  if (radius < 0)
+  if (radius < 0 || other.radius < 0)
     return math::Range(DBL_MAX, DBL_MAX);
   else
   {
-    double dist = metric::EuclideanDistance::Evaluate(center, other.center);
+    double dist = MetricType::Evaluate(center, other.center);
     double sumradius = radius + other.radius;
     return math::Range(math::ClampNonNegative(dist - sumradius),
                                               dist + sumradius);
@@ -157,59 +165,64 @@ math::Range BallBound<VecType>::RangeDistance(
 
 /**
  * Expand the bound to include the given bound.
- *
-template<typename VecType>
-const BallBound<VecType>&
-BallBound<VecType>::operator|=(
-    const BallBound<VecType>& other)
+ */
+template<typename VecType, typename TMetricType>
+const BallBound<VecType, TMetricType>&
+BallBound<VecType, TMetricType>::operator|=(const BallBound& other)
 {
-  double dist = metric::EuclideanDistance::Evaluate(center, other);
+  if (other.radius < 0)
+    return *this;
+
+  if (radius < 0)
+  {
+    center = other.center;
+    radius = other.radius;
+    return *this;
+  }
 
-  // Now expand the radius as necessary.
+  // The farthest point of the other ball is its radius beyond its center.
+  const double dist = MetricType::Evaluate(center, other.center) +
+      other.radius;
   if (dist > radius)
     radius = dist;
 
   return *this;
-}*/
+}
 
 /**
- * Expand the bound to include the given point.
+ * Expand the bound to include the given points.
  */
-template<typename VecType>
+template<typename VecType, typename TMetricType>
 template<typename MatType>
-const BallBound<VecType>&
-BallBound<VecType>::operator|=(const MatType& data)
+const BallBound<VecType, TMetricType>&
+BallBound<VecType, TMetricType>::operator|=(const MatType& data)
 {
+  if (data.n_cols == 0)
+    return *this;
+
+  // An empty ball is centered on the mean of the points, which gives a much
+  // smaller ball than growing it one point at a time.
   if (radius < 0)
   {
-    center = data.col(0);
+    center = arma::mean(data, 1);
     radius = 0;
   }
 
-  // Now iteratively add points.  There is probably a closed-form solution to
-  // find the minimum bounding circle, and it is probably faster.
-  for (size_t i = 1; i < data.n_cols; ++i)
+  for (size_t i = 0; i < data.n_cols; ++i)
   {
-    double dist = metric::EuclideanDistance::Evaluate(center, (VecType)
-        data.col(i)) - radius;
-
-    if (dist > 0)
-    {
-      // Move (dist / 2) towards the new point and increase radius by
-      // (dist / 2).
-      arma::vec diff = data.col(i) - center;
-      center += 0.5 * diff;
-      radius += 0.5 * dist;
-    }
+    const double dist = MetricType::Evaluate(center, data.col(i));
+    if (dist > radius)
+      radius = dist;
   }
 
   return *this;
 }
+
 /**
  * Returns a string representation of this object.
  */
-template<typename VecType>
-std::string BallBound<VecType>::ToString() const
+template<typename VecType, typename TMetricType>
+std::string BallBound<VecType, TMetricType>::ToString() const
 {
   std::ostringstream convert;
   convert << "BallBound [" << this << "]" << std::endl;
@@ -0,0 +1,145 @@
+/**
+ * @file best_first_traverser.hpp
+ *
+ * A single-tree traverser which visits the nodes in order of their score,
+ * optionally stopping after a given number of leaves.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A single-tree traverser which expands the reference nodes in order of their
+ * score (the best first) from a priority queue, instead of depth-first as
+ * TreeType::SingleTreeTraverser does.  For nearest neighbor search, the
+ * closest leaves are searched first wherever they are in the tree, so the
+ * bound on the k'th neighbor distance tightens quickly, even for clustered
+ * data.  Each node is rescored (with RuleType::Rescore()) when it is taken
+ * from the queue, and pruned if it cannot improve the results any more.
+ *
+ * If MaxLeaves() is nonzero, the traversal stops after that many leaves have
+ * been visited, which bounds the time taken by each query; the results are
+ * then approximate (the best candidates found in those leaves).
+ *
+ * The base cases are calculated for the points held by the leaves, so this
+ * can only be used with trees whose points are held by exactly one leaf, such
+ * as BinarySpaceTree, and not with trees whose children share points with
+ * their parents (TreeTraits::HasSelfChildren), such as the cover tree.  The
+ * interface is the same as TreeType::SingleTreeTraverser:
+ *
+ * @code
+ * BestFirstTraverser<TreeType, RuleType> traverser(rules, 10);
+ * traverser.Traverse(queryIndex, *referenceTree);
+ * @endcode
+ *
+ * @tparam TreeType Type of tree to traverse.
+ * @tparam RuleType Type of rules to traverse with.
+ */
+template<typename TreeType, typename RuleType>
+class BestFirstTraverser
+{
+ public:
+  /**
+   * Instantiate the best-first traverser with the given rule set.
+   *
+   * @param rule Rules to traverse with.
+   * @param maxLeaves Largest number of leaves visited by each traversal (0
+   *     means there is no limit).
+   */
+  BestFirstTraverser(RuleType& rule, const size_t maxLeaves = 0);
+
+  /**
+   * Traverse the tree with the given point.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, TreeType& referenceNode);
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the largest number of leaves visited by each traversal (0 means
+  //! there is no limit).
+  size_t MaxLeaves() const { return maxLeaves; }
+  //! Modify the largest number of leaves visited by each traversal.
+  size_t& MaxLeaves() { return maxLeaves; }
+
+  //! Get the number of leaves visited by the last traversal.
+  size_t LeavesVisited() const { return leavesVisited; }
+
+ private:
+  //! A node waiting in the queue, with its score.
+  struct QueueEntry
+  {
+    //! The score of the node.
+    double score;
+    //! The order in which the node was queued, to break ties.
+    size_t order;
+    //! The node.
+    TreeType* node;
+
+    //! The entry with the lowest score (then the one queued first) is on top
+    //! of the heap.
+    bool operator<(const QueueEntry& other) const
+    {
+      return (score > other.score) ||
+          ((score == other.score) && (order > other.order));
+    }
+  };
+
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The largest number of leaves visited by each traversal.
+  size_t maxLeaves;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+
+  //! The number of leaves visited by the last traversal.
+  size_t leavesVisited;
+
+  //! The queue of nodes to expand, as a heap; its storage is kept between
+  //! traversals.
+  std::vector<QueueEntry> queue;
+
+  //! The number of nodes queued by the current traversal.
+  size_t queued;
+
+  //! Calculate the base cases of a leaf, or score and queue the children of
+  //! any other node.
+  void Expand(const size_t queryIndex, TreeType& node);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "best_first_traverser_impl.hpp"
+
+#endif
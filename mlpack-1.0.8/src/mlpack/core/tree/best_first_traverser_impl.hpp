@@ -0,0 +1,108 @@
+/**
+ * @file best_first_traverser_impl.hpp
+ *
+ * Implementation of BestFirstTraverser.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "best_first_traverser.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType>
+BestFirstTraverser<TreeType, RuleType>::BestFirstTraverser(
+    RuleType& rule,
+    const size_t maxLeaves) :
+    rule(rule),
+    maxLeaves(maxLeaves),
+    numPrunes(0),
+    leavesVisited(0),
+    queued(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType>
+void BestFirstTraverser<TreeType, RuleType>::Traverse(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  queue.clear();
+  queued = 0;
+  leavesVisited = 0;
+
+  // The root is not scored, as in the depth-first traversers.
+  Expand(queryIndex, referenceNode);
+
+  while (!queue.empty())
+  {
+    if ((maxLeaves != 0) && (leavesVisited >= maxLeaves))
+      break;
+
+    std::pop_heap(queue.begin(), queue.end());
+    const QueueEntry entry = queue.back();
+    queue.pop_back();
+
+    // Other nodes may have tightened the bound since this one was scored.
+    if (rule.Rescore(queryIndex, *entry.node, entry.score) == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    Expand(queryIndex, *entry.node);
+  }
+}
+
+template<typename TreeType, typename RuleType>
+void BestFirstTraverser<TreeType, RuleType>::Expand(const size_t queryIndex,
+                                                    TreeType& node)
+{
+  if (node.NumChildren() == 0)
+  {
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      rule.BaseCase(queryIndex, node.Point(i));
+
+    ++leavesVisited;
+    return;
+  }
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    QueueEntry entry;
+    entry.score = rule.Score(queryIndex, node.Child(i));
+    if (entry.score == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    entry.order = queued++;
+    entry.node = &node.Child(i);
+    queue.push_back(entry);
+    std::push_heap(queue.begin(), queue.end());
+  }
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -27,5 +27,6 @@
 #include "binary_space_tree/single_tree_traverser.hpp"
 #include "binary_space_tree/dual_tree_traverser.hpp"
 #include "binary_space_tree/traits.hpp"
+#include "binary_space_tree/rp_split.hpp"
 
 #endif
@@ -23,7 +23,10 @@
 
 #include <mlpack/core.hpp>
 
+#include "../bound_traits.hpp"
 #include "../statistic.hpp"
+#include "build_options.hpp"
+#include "midpoint_split.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
@@ -45,10 +48,14 @@ namespace tree /** Trees and tree-building procedures. */ {
  *     bounds/.
  * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
  *     for the necessary skeleton interface.
+ * @tparam MatType Type of dataset.
+ * @tparam SplitType The rule used to split each node: MidpointSplit (the
+ *     default) gives a kd-tree, and RPSplit gives a random projection tree.
  */
 template<typename BoundType,
          typename StatisticType = EmptyStatistic,
-         typename MatType = arma::mat>
+         typename MatType = arma::mat,
+         typename SplitType = MidpointSplit>
 class BinarySpaceTree
 {
  private:
@@ -76,6 +83,12 @@ class BinarySpaceTree
   double furthestDescendantDistance;
   //! The dataset.
   MatType& dataset;
+  //! If this is the root of a flattened tree, the array holding all of its
+  //! descendants (otherwise NULL).
+  BinarySpaceTree* nodeArray;
+  //! Whether or not this node is part of a flattened tree, in which case its
+  //! children are not deleted individually.
+  bool flat;
 
  public:
   //! So other classes can use TreeType::Mat.
@@ -131,6 +144,33 @@ class BinarySpaceTree
                   std::vector<size_t>& newFromOld,
                   const size_t leafSize = 20);
 
+  /**
+   * Construct this as the root node of a binary space tree using the given
+   * dataset and build options, which allow a parallel build and median splits
+   * (see BuildOptions).  This will modify the ordering of the points in the
+   * dataset!
+   *
+   * @param data Dataset to create tree from.  This will be modified!
+   * @param options Options for building the tree.
+   */
+  BinarySpaceTree(MatType& data, const BuildOptions& options);
+
+  /**
+   * Construct this as the root node of a binary space tree using the given
+   * dataset and build options, which allow a parallel build and median splits
+   * (see BuildOptions).  This will modify the ordering of points in the
+   * dataset!  A mapping of the old point indices to the new point indices is
+   * filled.
+   *
+   * @param data Dataset to create tree from.  This will be modified!
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *     each new point.
+   * @param options Options for building the tree.
+   */
+  BinarySpaceTree(MatType& data,
+                  std::vector<size_t>& oldFromNew,
+                  const BuildOptions& options);
+
   /**
    * Construct this node on a subset of the given matrix, starting at column
    * begin and using count points.  The ordering of that subset of points
@@ -202,6 +242,29 @@ class BinarySpaceTree
                   BinarySpaceTree* parent = NULL,
                   const size_t leafSize = 20);
 
+  /**
+   * Construct a single node from a bound that has already been computed,
+   * without looking at or reordering the dataset.  No children are created;
+   * they can be attached afterwards with Left() and Right(), and then the
+   * statistic should be set with Stat() = StatisticType(node).  This is used to
+   * restore saved trees (see TreeIndex).
+   *
+   * @param data Dataset the tree was built on (already reordered).
+   * @param begin Index of the first point in the node.
+   * @param count Number of points in the node.
+   * @param bound Bound of the points in the node.
+   * @param splitDimension Dimension the node is split on, if it has children.
+   * @param parent Parent of the node.
+   * @param leafSize Size of each leaf in the tree.
+   */
+  BinarySpaceTree(MatType& data,
+                  const size_t begin,
+                  const size_t count,
+                  const BoundType& bound,
+                  const size_t splitDimension,
+                  BinarySpaceTree* parent = NULL,
+                  const size_t leafSize = 20);
+
   /**
    * Create a binary space tree by copying the other tree.  Be careful!  This
    * can take a long time and use a lot of memory.
@@ -254,6 +317,14 @@ class BinarySpaceTree
   //! Return the statistic object for this node.
   StatisticType& Stat() { return stat; }
 
+  /**
+   * Rebuild the statistic of this node and all of its descendants, as they are
+   * built during construction (children first).  This is much cheaper than
+   * building the tree again, and it clears anything a search has left in the
+   * statistics, so the tree can be used for another search.
+   */
+  void ResetStatistics();
+
   //! Return whether or not this node is a leaf (true if it has no children).
   bool IsLeaf() const;
 
@@ -265,6 +336,27 @@ class BinarySpaceTree
   //! Fills the tree to the specified level.
   size_t ExtendTree(const size_t level);
 
+  /**
+   * Move all the descendants of this node into a single contiguous array,
+   * ordered depth-first, so that each node is followed by the nodes of its
+   * left subtree and then its right subtree.  Traversals then walk through
+   * memory mostly in order instead of chasing pointers across the heap.  The
+   * tree is otherwise unchanged and is used exactly as before; pointers to
+   * the old descendants become invalid.  The statistics are rebuilt as they
+   * are during construction, so this should be called right after the tree is
+   * built.  A flattened tree cannot be extended with ExtendTree().
+   *
+   * With a bound that keeps its limits in the node (such as HRectBound with a
+   * nonzero FixedDim), the bounds are then contiguous too, and since the
+   * points of each leaf are contiguous in the reordered dataset, a traversal
+   * reads two mostly sequential streams; the traversers also prefetch the
+   * children they are about to score (see PrefetchNode()).
+   */
+  void Flatten();
+
+  //! Return whether or not this node is part of a flattened tree.
+  bool IsFlat() const { return flat; }
+
   //! Gets the left child of this node.
   BinarySpaceTree* Left() const { return left; }
   //! Modify the left child of this node.
@@ -286,9 +378,9 @@ class BinarySpaceTree
   size_t& SplitDimension() { return splitDimension; }
 
   //! Get the dataset which the tree is built on.
-  const arma::mat& Dataset() const { return dataset; }
+  const MatType& Dataset() const { return dataset; }
   //! Modify the dataset which the tree is built on.  Be careful!
-  arma::mat& Dataset() { return dataset; }
+  MatType& Dataset() { return dataset; }
 
   //! Get the metric which the tree uses.
   typename BoundType::MetricType Metric() const { return bound.Metric(); }
@@ -370,19 +462,22 @@ class BinarySpaceTree
   }
 
   //! Return the minimum distance to another point.
-  double MinDistance(const arma::vec& point) const
+  template<typename VecType>
+  double MinDistance(const VecType& point) const
   {
     return bound.MinDistance(point);
   }
 
   //! Return the maximum distance to another point.
-  double MaxDistance(const arma::vec& point) const
+  template<typename VecType>
+  double MaxDistance(const VecType& point) const
   {
     return bound.MaxDistance(point);
   }
 
   //! Return the minimum and maximum distance to another point.
-  math::Range RangeDistance(const arma::vec& point) const
+  template<typename VecType>
+  math::Range RangeDistance(const VecType& point) const
   {
     return bound.RangeDistance(point);
   }
@@ -437,13 +532,29 @@ class BinarySpaceTree
       count(count),
       bound(bound),
       stat(stat),
-      leafSize(leafSize) { }
+      leafSize(leafSize),
+      nodeArray(NULL),
+      flat(false) { }
 
   BinarySpaceTree* CopyMe()
   {
     return new BinarySpaceTree(begin, count, bound, stat, leafSize);
   }
 
+  /**
+   * Copy the given node and its descendants into the given array, in
+   * depth-first order, starting at the given position; this is used by
+   * Flatten().
+   *
+   * @param node Node to copy.
+   * @param array Array to place nodes in.
+   * @param next Position of the next free slot in the array.
+   * @return The copy of the node.
+   */
+  static BinarySpaceTree* FlattenNode(const BinarySpaceTree& node,
+                                      BinarySpaceTree* array,
+                                      size_t& next);
+
   /**
    * Splits the current node, assigning its left and right children recursively.
    *
@@ -460,6 +571,143 @@ class BinarySpaceTree
    */
   void SplitNode(MatType& data, std::vector<size_t>& oldFromNew);
 
+  /**
+   * Construct a child node with the given build options; this is used for
+   * recursive tree-building by the constructors that take BuildOptions.
+   *
+   * @param data Dataset to create tree from.  This will be modified!
+   * @param begin Index of point to start tree construction with.
+   * @param count Number of points to use to construct tree.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   * @param parent Parent of the node.
+   * @param options Options for building the tree.
+   */
+  BinarySpaceTree(MatType& data,
+                  const size_t begin,
+                  const size_t count,
+                  std::vector<size_t>* oldFromNew,
+                  BinarySpaceTree* parent,
+                  const BuildOptions& options);
+
+  /**
+   * Build the tree below the root with the given options, starting the
+   * threads for a parallel build if needed.
+   *
+   * @param data Dataset which we are using.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   * @param options Options for building the tree.
+   */
+  void BuildRoot(MatType& data,
+                 std::vector<size_t>* oldFromNew,
+                 const BuildOptions& options);
+
+  /**
+   * Splits the current node with the given build options, assigning its left
+   * and right children recursively (as OpenMP tasks for large nodes in a
+   * parallel build).
+   *
+   * @param data Dataset which we are using.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   * @param options Options for building the tree.
+   */
+  void SplitNode(MatType& data,
+                 std::vector<size_t>* oldFromNew,
+                 const BuildOptions& options);
+
+  /**
+   * Get the Morton curve over the bound of the root, which BuildOptions::
+   * MortonOrder() builds the tree with.
+   */
+  data::SpaceFillingCurve RootCurve() const;
+
+  /**
+   * Sort the points of this node (the root) along RootCurve(), reordering
+   * oldFromNew (if it is given) the same way.  The bound must have been
+   * expanded.
+   *
+   * @param data Dataset which we are using.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   */
+  template<typename eT>
+  void MortonSort(arma::Mat<eT>& data, std::vector<size_t>* oldFromNew);
+
+  //! Sparse matrices are not sorted.
+  template<typename OtherMatType>
+  void MortonSort(OtherMatType& /* data */,
+                  std::vector<size_t>* /* oldFromNew */) { }
+
+  /**
+   * Split the Morton-ordered points of this node where their keys first
+   * differ, without moving them.
+   *
+   * @param data Dataset which we are using.
+   * @return The index of the first point of the right child, or begin if all
+   *     the points are in the same cell of the grid.
+   */
+  template<typename eT>
+  size_t MortonSplit(const arma::Mat<eT>& data);
+
+  //! Sparse matrices are split as usual.
+  template<typename OtherMatType>
+  size_t MortonSplit(const OtherMatType& /* data */) { return begin; }
+
+  /**
+   * Split the points of this node along the widest dimension: reorder them (and
+   * oldFromNew, if it is given) so that the points of the left child come
+   * first.  This must be called after the bound has been expanded.
+   *
+   * @param data Dataset which we are using.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   * @param medianSamples If nonzero, split near the median of this many points
+   *     instead of at the middle of the dimension.
+   * @return The index of the first point of the right child, or begin if the
+   *     node cannot be split.
+   */
+  size_t PerformSplit(MatType& data,
+                      std::vector<size_t>* oldFromNew,
+                      const size_t medianSamples,
+                      const MidpointSplit& /* split */);
+
+  /**
+   * Split the points of this node with another split rule, which reorders them
+   * itself (see RPSplit).
+   */
+  template<typename OtherSplitType>
+  size_t PerformSplit(MatType& data,
+                      std::vector<size_t>* oldFromNew,
+                      const size_t /* medianSamples */,
+                      const OtherSplitType& /* split */)
+  {
+    return OtherSplitType::PerformSplit(data, begin, count, oldFromNew);
+  }
+
+  /**
+   * Find the dimension in which the points of this node have the largest
+   * range.  The ranges are taken from the bound if it is tight (see
+   * BoundTraits); otherwise (for instance, for a ball) they are computed from
+   * the points.  This must be called after the bound has been expanded.
+   *
+   * @param data Dataset which we are using.
+   * @param splitDim Set to the dimension with the largest range.
+   * @param splitVal Set to the middle of the range in that dimension.
+   * @return The width of the range in that dimension.
+   */
+  double WidestDimension(const MatType& data,
+                         size_t& splitDim,
+                         double& splitVal) const;
+
+  /**
+   * Estimate the median of the points of this node in the given dimension from
+   * the given number of points, taken at evenly spaced positions.
+   *
+   * @param data Dataset which we are using.
+   * @param splitDim Dimension to find the median in.
+   * @param samples Number of points to use.
+   */
+  double SampleMedian(const MatType& data,
+                      const size_t splitDim,
+                      const size_t samples) const;
+
   /**
    * Find the index to split on for this node, given that we are splitting in
    * the given split dimension on the specified split value.
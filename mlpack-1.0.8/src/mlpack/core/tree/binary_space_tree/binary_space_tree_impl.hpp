@@ -28,13 +28,23 @@
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/string_util.hpp>
 
+#include <new>
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace tree {
 
 // Each of these overloads is kept as a separate function to keep the overhead
 // from the two std::vectors out, if possible.
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     const size_t leafSize) :
     left(NULL),
@@ -44,7 +54,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(data.n_cols), /* and spans all of the dataset. */
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Do the actual splitting of this node.
   SplitNode(data);
@@ -53,8 +65,11 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
   stat = StatisticType(*this);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     std::vector<size_t>& oldFromNew,
     const size_t leafSize) :
@@ -65,7 +80,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(data.n_cols),
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(data.n_cols);
@@ -79,8 +96,11 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
   stat = StatisticType(*this);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     std::vector<size_t>& oldFromNew,
     std::vector<size_t>& newFromOld,
@@ -92,7 +112,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(data.n_cols),
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(data.n_cols);
@@ -111,8 +133,67 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     newFromOld[oldFromNew[i]] = i;
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
+    MatType& data,
+    const BuildOptions& options) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    begin(0),
+    count(data.n_cols),
+    leafSize(options.LeafSize()),
+    bound(data.n_rows),
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
+{
+  // Do the actual splitting of this node.
+  BuildRoot(data, NULL, options);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
+    MatType& data,
+    std::vector<size_t>& oldFromNew,
+    const BuildOptions& options) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    begin(0),
+    count(data.n_cols),
+    leafSize(options.LeafSize()),
+    bound(data.n_rows),
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
+{
+  // Initialize oldFromNew correctly.
+  oldFromNew.resize(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; i++)
+    oldFromNew[i] = i; // Fill with unharmed indices.
+
+  // Now do the actual splitting.
+  BuildRoot(data, &oldFromNew, options);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     const size_t begin,
     const size_t count,
@@ -125,7 +206,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(count),
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Perform the actual splitting.
   SplitNode(data);
@@ -134,8 +217,11 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
   stat = StatisticType(*this);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     const size_t begin,
     const size_t count,
@@ -149,7 +235,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(count),
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -162,8 +250,11 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
   stat = StatisticType(*this);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     MatType& data,
     const size_t begin,
     const size_t count,
@@ -178,7 +269,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     count(count),
     leafSize(leafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -196,9 +289,70 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     newFromOld[oldFromNew[i]] = i;
 }
 
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    std::vector<size_t>* oldFromNew,
+    BinarySpaceTree* parent,
+    const BuildOptions& options) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    begin(begin),
+    count(count),
+    leafSize(options.LeafSize()),
+    bound(data.n_rows),
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
+{
+  // Perform the actual splitting.
+  SplitNode(data, oldFromNew, options);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    const BoundType& bound,
+    const size_t splitDimension,
+    BinarySpaceTree* parent,
+    const size_t leafSize) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    begin(begin),
+    count(count),
+    leafSize(leafSize),
+    bound(bound),
+    splitDimension(splitDimension),
+    furthestDescendantDistance(0.5 * bound.Diameter()),
+    dataset(data),
+    nodeArray(NULL),
+    flat(false)
+{
+  // Nothing to do; the caller attaches children and sets the statistic.
+}
+
 /*
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree() :
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    BinarySpaceTree() :
     left(NULL),
     right(NULL),
     parent(NULL),
@@ -215,8 +369,11 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree() :
  * Create a binary space tree by copying the other tree.  Be careful!  This can
  * take a long time and use a lot of memory.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     const BinarySpaceTree& other) :
     left(NULL),
     right(NULL),
@@ -228,7 +385,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
     stat(other.stat),
     splitDimension(other.splitDimension),
     furthestDescendantDistance(other.furthestDescendantDistance),
-    dataset(other.dataset)
+    dataset(other.dataset),
+    nodeArray(NULL),
+    flat(false)
 {
   // Create left and right children (if any).
   if (other.Left())
@@ -249,13 +408,113 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::BinarySpaceTree(
  * destructors in turn.  This will invalidate any pointers or references to any
  * nodes which are children of this one.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::~BinarySpaceTree()
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    ~BinarySpaceTree()
+{
+  if (nodeArray)
+  {
+    // This is the root of a flattened tree, so all the descendants live in one
+    // array.
+    const size_t nodes = TreeSize() - 1;
+    for (size_t i = 0; i < nodes; ++i)
+      nodeArray[i].~BinarySpaceTree();
+    ::operator delete(nodeArray);
+  }
+  else if (!flat)
+  {
+    if (left)
+      delete left;
+    if (right)
+      delete right;
+  }
+}
+
+/**
+ * Move all descendants of this node into one contiguous array, in depth-first
+ * order.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::Flatten()
+{
+  // Nothing to do if we are already flat, or if there are no descendants.
+  if (flat || IsLeaf())
+    return;
+
+  const size_t nodes = TreeSize() - 1;
+  BinarySpaceTree* array = (BinarySpaceTree*)
+      ::operator new(nodes * sizeof(BinarySpaceTree));
+
+  size_t next = 0;
+  BinarySpaceTree* oldLeft = left;
+  BinarySpaceTree* oldRight = right;
+  left = FlattenNode(*oldLeft, array, next);
+  left->parent = this;
+  right = FlattenNode(*oldRight, array, next);
+  right->parent = this;
+
+  delete oldLeft;
+  delete oldRight;
+
+  nodeArray = array;
+  flat = true;
+
+  // Rebuild the statistic now that the children have moved.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>*
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::FlattenNode(
+    const BinarySpaceTree& node,
+    BinarySpaceTree* array,
+    size_t& next)
+{
+  // The children will be attached to the copy, and they will point at the copy
+  // as their parent.
+  BinarySpaceTree* copy = new (array + next++) BinarySpaceTree(node.dataset,
+      node.begin, node.count, node.bound, node.splitDimension, NULL,
+      node.leafSize);
+  copy->furthestDescendantDistance = node.furthestDescendantDistance;
+  copy->flat = true;
+
+  if (node.left)
+  {
+    copy->left = FlattenNode(*node.left, array, next);
+    copy->left->parent = copy;
+    copy->right = FlattenNode(*node.right, array, next);
+    copy->right->parent = copy;
+  }
+
+  // As during construction, the statistic is built once the children exist.
+  copy->stat = StatisticType(*copy);
+
+  return copy;
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    ResetStatistics()
 {
   if (left)
-    delete left;
-  if (right)
-    delete right;
+  {
+    left->ResetStatistics();
+    right->ResetStatistics();
+  }
+
+  stat = StatisticType(*this);
 }
 
 /**
@@ -269,9 +528,12 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::~BinarySpaceTree()
  * @param queryCount The Count() of the node to find.
  * @return The found node, or NULL if nothing is found.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-const BinarySpaceTree<BoundType, StatisticType, MatType>*
-BinarySpaceTree<BoundType, StatisticType, MatType>::FindByBeginCount(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+const BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>*
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::FindByBeginCount(
     size_t queryBegin,
     size_t queryCount) const
 {
@@ -299,9 +561,12 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::FindByBeginCount(
  * @param queryCount the Count() of the node to find
  * @return the found node, or NULL
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-BinarySpaceTree<BoundType, StatisticType, MatType>*
-BinarySpaceTree<BoundType, StatisticType, MatType>::FindByBeginCount(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>*
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::FindByBeginCount(
     const size_t queryBegin,
     const size_t queryCount)
 {
@@ -320,10 +585,18 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::FindByBeginCount(
     return NULL;
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-size_t BinarySpaceTree<BoundType, StatisticType, MatType>::ExtendTree(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    ExtendTree(
     size_t level)
 {
+  if (flat)
+    Log::Fatal << "BinarySpaceTree::ExtendTree(): cannot extend a flattened "
+        << "tree!" << std::endl;
+
   --level;
   // Return the number of nodes duplicated.
   size_t nodesDuplicated = 0;
@@ -351,16 +624,24 @@ size_t BinarySpaceTree<BoundType, StatisticType, MatType>::ExtendTree(
  *     to avoid exceeding the stack limit
  */
 
-template<typename BoundType, typename StatisticType, typename MatType>
-size_t BinarySpaceTree<BoundType, StatisticType, MatType>::TreeSize() const
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    TreeSize() const
 {
   // Recursively count the nodes on each side of the tree.  The plus one is
   // because we have to count this node, too.
   return 1 + (left ? left->TreeSize() : 0) + (right ? right->TreeSize() : 0);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-size_t BinarySpaceTree<BoundType, StatisticType, MatType>::TreeDepth() const
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    TreeDepth() const
 {
   // Recursively count the depth on each side of the tree.  The plus one is
   // because we have to count this node, too.
@@ -368,8 +649,12 @@ size_t BinarySpaceTree<BoundType, StatisticType, MatType>::TreeDepth() const
                       (right ? right->TreeDepth() : 0));
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-inline bool BinarySpaceTree<BoundType, StatisticType, MatType>::IsLeaf() const
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+inline bool BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    IsLeaf() const
 {
   return !left;
 }
@@ -377,9 +662,13 @@ inline bool BinarySpaceTree<BoundType, StatisticType, MatType>::IsLeaf() const
 /**
  * Returns the number of children in this node.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 inline size_t
-    BinarySpaceTree<BoundType, StatisticType, MatType>::NumChildren() const
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+        NumChildren() const
 {
   if (left && right)
     return 2;
@@ -393,8 +682,11 @@ inline size_t
  * Return a bound on the furthest point in the node from the centroid.  This
  * returns 0 unless the node is a leaf.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-inline double BinarySpaceTree<BoundType, StatisticType, MatType>::
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+inline double BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
     FurthestPointDistance() const
 {
   if (IsLeaf())
@@ -412,8 +704,11 @@ inline double BinarySpaceTree<BoundType, StatisticType, MatType>::
  * furthest descendant distance may be less than what this method returns (but
  * it will never be greater than this).
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-inline double BinarySpaceTree<BoundType, StatisticType, MatType>::
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+inline double BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
     FurthestDescendantDistance() const
 {
   return furthestDescendantDistance;
@@ -422,9 +717,12 @@ inline double BinarySpaceTree<BoundType, StatisticType, MatType>::
 /**
  * Return the specified child.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-inline BinarySpaceTree<BoundType, StatisticType, MatType>&
-    BinarySpaceTree<BoundType, StatisticType, MatType>::Child(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+inline BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>&
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::Child(
     const size_t child) const
 {
   if (child == 0)
@@ -436,9 +734,12 @@ inline BinarySpaceTree<BoundType, StatisticType, MatType>&
 /**
  * Return the number of points contained in this node.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 inline size_t
-BinarySpaceTree<BoundType, StatisticType, MatType>::NumPoints() const
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::NumPoints() const
 {
   if (left)
     return 0;
@@ -449,9 +750,13 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::NumPoints() const
 /**
  * Return the number of descendants contained in the node.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 inline size_t
-BinarySpaceTree<BoundType, StatisticType, MatType>::NumDescendants() const
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    NumDescendants() const
 {
   return count;
 }
@@ -459,9 +764,12 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::NumDescendants() const
 /**
  * Return the index of a particular descendant contained in this node.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 inline size_t
-BinarySpaceTree<BoundType, StatisticType, MatType>::Descendant(
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::Descendant(
     const size_t index) const
 {
   return (begin + index);
@@ -470,9 +778,13 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::Descendant(
 /**
  * Return the index of a particular point contained in this node.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 inline size_t
-BinarySpaceTree<BoundType, StatisticType, MatType>::Point(const size_t index)
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    Point(const size_t index)
     const
 {
   return (begin + index);
@@ -481,15 +793,22 @@ BinarySpaceTree<BoundType, StatisticType, MatType>::Point(const size_t index)
 /**
  * Gets the index one beyond the last index in the series.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-inline size_t BinarySpaceTree<BoundType, StatisticType, MatType>::End() const
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+inline size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    End() const
 {
   return begin + count;
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-void
-    BinarySpaceTree<BoundType, StatisticType, MatType>::SplitNode(MatType& data)
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
+    MatType& data)
 {
   // We need to expand the bounds of this node properly.
   bound |= data.cols(begin, begin + count - 1);
@@ -501,49 +820,28 @@ void
   if (count <= leafSize)
     return; // We can't split this.
 
-  // Figure out which dimension to split on.
-  size_t splitDim = data.n_rows; // Indicate invalid by maxDim + 1.
-  double maxWidth = -1;
-
-  // Find the split dimension.
-  for (size_t d = 0; d < data.n_rows; d++)
-  {
-    double width = bound[d].Width();
-
-    if (width > maxWidth)
-    {
-      maxWidth = width;
-      splitDim = d;
-    }
-  }
-  splitDimension = splitDim;
-
-  // Split in the middle of that dimension.
-  double splitVal = bound[splitDim].Mid();
-
-  if (maxWidth == 0) // All these points are the same.  We can't split.
+  // Perform the actual splitting.  This will order the dataset such that the
+  // points of the left child are on the left of splitCol.
+  const size_t splitCol = PerformSplit(data, NULL, 0, SplitType());
+  if (splitCol == begin) // All these points are the same.  We can't split.
     return;
 
-  // Perform the actual splitting.  This will order the dataset such that points
-  // with value in dimension split_dim less than or equal to splitVal are on
-  // the left of splitCol, and points with value in dimension splitDim greater
-  // than splitVal are on the right side of splitCol.
-  size_t splitCol = GetSplitIndex(data, splitDim, splitVal);
-
   // Now that we know the split column, we will recursively split the children
   // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, begin,
+  left = new BinarySpaceTree(data, begin,
       splitCol - begin, this, leafSize);
-  right = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, splitCol,
+  right = new BinarySpaceTree(data, splitCol,
       begin + count - splitCol, this, leafSize);
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-void BinarySpaceTree<BoundType, StatisticType, MatType>::SplitNode(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
     MatType& data,
     std::vector<size_t>& oldFromNew)
 {
-  // This should be a single function for Bound.
   // We need to expand the bounds of this node properly.
   bound |= data.cols(begin, begin + count - 1);
 
@@ -554,45 +852,333 @@ void BinarySpaceTree<BoundType, StatisticType, MatType>::SplitNode(
   if (count <= leafSize)
     return; // We can't split this.
 
+  // Perform the actual splitting.  This will order the dataset (and
+  // oldFromNew) such that the points of the left child are on the left of
+  // splitCol.
+  const size_t splitCol = PerformSplit(data, &oldFromNew, 0, SplitType());
+  if (splitCol == begin) // All these points are the same.  We can't split.
+    return;
+
+  // Now that we know the split column, we will recursively split the children
+  // by calling their constructors (which perform this splitting process).
+  left = new BinarySpaceTree(data, begin,
+      splitCol - begin, oldFromNew, this, leafSize);
+  right = new BinarySpaceTree(data, splitCol,
+      begin + count - splitCol, oldFromNew, this, leafSize);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BuildRoot(
+    MatType& data,
+    std::vector<size_t>* oldFromNew,
+    const BuildOptions& options)
+{
+  // Sort the points along the Morton curve over their bounding box, which is
+  // the bound of the root.
+  if (options.MortonOrder() && count > 0)
+  {
+    bound |= data.cols(begin, begin + count - 1);
+    MortonSort(data, oldFromNew);
+  }
+
+  size_t numThreads = Threads::Count(options.Threads());
+
+  // Columns of a sparse matrix cannot be swapped from more than one thread.
+  if (arma::is_SpMat<MatType>::value)
+    numThreads = 1;
+
+  if (numThreads == 1)
+  {
+    // Any tasks will simply be run by this thread.
+    SplitNode(data, oldFromNew, options);
+    return;
+  }
+
+  // One thread starts the build; the others pick up the tasks it creates.
+  #pragma omp parallel num_threads(numThreads)
+  {
+    #pragma omp single
+    SplitNode(data, oldFromNew, options);
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
+    MatType& data,
+    std::vector<size_t>* oldFromNew,
+    const BuildOptions& options)
+{
+  // We need to expand the bounds of this node properly.
+  bound |= data.cols(begin, begin + count - 1);
+
+  // Calculate the furthest descendant distance.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  // Now, check if we need to split at all.
+  if (count <= leafSize)
+    return; // We can't split this.
+
+  // The points of a Morton-ordered node are split where their keys first
+  // differ.  If they are all in the same cell of the grid, the node is split as
+  // usual.
+  size_t splitCol = options.MortonOrder() ? MortonSplit(data) : begin;
+  if (splitCol == begin)
+    splitCol = PerformSplit(data, oldFromNew, options.MedianSamples(),
+        SplitType());
+  if (splitCol == begin) // All these points are the same.  We can't split.
+    return;
+
+  const size_t leftCount = splitCol - begin;
+  const size_t rightCount = begin + count - splitCol;
+
+  // In a parallel build, the left child of a large node is built as a separate
+  // task.  The children reorder disjoint columns of the dataset (and disjoint
+  // elements of oldFromNew), so nothing else needs to be synchronized.
+  if (options.Threads() != 1 && count >= 10000)
+  {
+    MatType* dataPtr = &data;
+    const BuildOptions* optionsPtr = &options;
+
+    #pragma omp task
+    left = new BinarySpaceTree(*dataPtr, begin, leftCount, oldFromNew, this,
+        *optionsPtr);
+
+    right = new BinarySpaceTree(data, splitCol, rightCount, oldFromNew, this,
+        options);
+
+    #pragma omp taskwait
+  }
+  else
+  {
+    left = new BinarySpaceTree(data, begin, leftCount, oldFromNew, this,
+        options);
+    right = new BinarySpaceTree(data, splitCol, rightCount, oldFromNew, this,
+        options);
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+data::SpaceFillingCurve
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::RootCurve()
+    const
+{
+  const BinarySpaceTree* root = this;
+  while (root->parent != NULL)
+    root = root->parent;
+
+  arma::vec lo(dataset.n_rows), hi(dataset.n_rows);
+  for (size_t d = 0; d < dataset.n_rows; ++d)
+  {
+    const math::Range range = root->bound[d];
+    lo[d] = range.Lo();
+    hi[d] = range.Hi();
+  }
+
+  return data::SpaceFillingCurve(lo, hi, data::MortonCurve);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename eT>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::MortonSort(
+    arma::Mat<eT>& data,
+    std::vector<size_t>* oldFromNew)
+{
+  // The keys are those MortonSplit() uses.  Ties are broken by index, so the
+  // order does not depend on anything but the points.
+  const data::SpaceFillingCurve curve = RootCurve();
+  std::vector<std::pair<uint64_t, size_t> > keys(count);
+  for (size_t i = 0; i < count; ++i)
+    keys[i] = std::make_pair(curve.Key(data.unsafe_col(begin + i)), begin + i);
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<size_t> order(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    order[i] = i;
+  for (size_t i = 0; i < count; ++i)
+    order[begin + i] = keys[i].second;
+  data::ReorderColumns(data, order);
+
+  if (oldFromNew != NULL)
+  {
+    const std::vector<size_t> oldOrder(*oldFromNew);
+    for (size_t i = 0; i < order.size(); ++i)
+      (*oldFromNew)[i] = oldOrder[order[i]];
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename eT>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    MortonSplit(const arma::Mat<eT>& data)
+{
+  const data::SpaceFillingCurve curve = RootCurve();
+  const uint64_t firstKey = curve.Key(data.unsafe_col(begin));
+  const uint64_t lastKey = curve.Key(data.unsafe_col(begin + count - 1));
+  if (firstKey == lastKey)
+    return begin;
+
+  // Find the most significant bit where the keys differ; the points are in
+  // order of that bit, so the right child starts at the first point with it
+  // set.
+  size_t bit = 63;
+  while (((firstKey ^ lastKey) >> bit) == 0)
+    --bit;
+  splitDimension = curve.Dimension(bit);
+
+  size_t lo = begin + 1;
+  size_t hi = begin + count - 1;
+  while (lo < hi)
+  {
+    const size_t mid = lo + (hi - lo) / 2;
+    if ((curve.Key(data.unsafe_col(mid)) >> bit) & 1)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    PerformSplit(MatType& data,
+                 std::vector<size_t>* oldFromNew,
+                 const size_t medianSamples,
+                 const MidpointSplit& /* split */)
+{
   // Figure out which dimension to split on.
-  size_t splitDim = data.n_rows; // Indicate invalid by max_dim + 1.
+  size_t splitDim;
+  double midVal;
+  const double maxWidth = WidestDimension(data, splitDim, midVal);
+  splitDimension = splitDim;
+
+  if (maxWidth == 0) // All these points are the same.  We can't split.
+    return begin;
+
+  // Try the median first, if we were asked to.
+  size_t splitCol = begin;
+  if (medianSamples > 0)
+  {
+    const double splitVal = SampleMedian(data, splitDim, medianSamples);
+    splitCol = (oldFromNew == NULL) ? GetSplitIndex(data, splitDim, splitVal)
+        : GetSplitIndex(data, splitDim, splitVal, *oldFromNew);
+  }
+
+  // Split in the middle of the dimension, which always leaves points on both
+  // sides.
+  if (splitCol == begin || splitCol == begin + count)
+  {
+    splitCol = (oldFromNew == NULL) ? GetSplitIndex(data, splitDim, midVal)
+        : GetSplitIndex(data, splitDim, midVal, *oldFromNew);
+  }
+
+  return splitCol;
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+double BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    WidestDimension(
+    const MatType& data,
+    size_t& splitDim,
+    double& splitVal) const
+{
+  splitDim = 0;
   double maxWidth = -1;
 
-  // Find the split dimension.
+  if (bound::BoundTraits<BoundType>::HasTightBounds)
+  {
+    for (size_t d = 0; d < data.n_rows; d++)
+    {
+      const double width = bound[d].Width();
+      if (width > maxWidth)
+      {
+        maxWidth = width;
+        splitDim = d;
+      }
+    }
+
+    splitVal = bound[splitDim].Mid();
+    return maxWidth;
+  }
+
+  // The bound says little about the range in each dimension, so find the
+  // ranges of the points themselves.
+  double lo = 0, hi = 0;
   for (size_t d = 0; d < data.n_rows; d++)
   {
-    double width = bound[d].Width();
+    double dimLo = DBL_MAX;
+    double dimHi = -DBL_MAX;
+    for (size_t i = begin; i < begin + count; ++i)
+    {
+      const double value = data(d, i);
+      if (value < dimLo)
+        dimLo = value;
+      if (value > dimHi)
+        dimHi = value;
+    }
 
-    if (width > maxWidth)
+    if (dimHi - dimLo > maxWidth)
     {
-      maxWidth = width;
+      maxWidth = dimHi - dimLo;
       splitDim = d;
+      lo = dimLo;
+      hi = dimHi;
     }
   }
-  splitDimension = splitDim;
 
-  // Split in the middle of that dimension.
-  double splitVal = bound[splitDim].Mid();
+  splitVal = lo + 0.5 * (hi - lo);
+  return maxWidth;
+}
 
-  if (maxWidth == 0) // All these points are the same.  We can't split.
-    return;
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+double BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    SampleMedian(
+    const MatType& data,
+    const size_t splitDim,
+    const size_t samples) const
+{
+  const size_t n = std::min(samples, count);
 
-  // Perform the actual splitting.  This will order the dataset such that points
-  // with value in dimension split_dim less than or equal to splitVal are on
-  // the left of splitCol, and points with value in dimension splitDim greater
-  // than splitVal are on the right side of splitCol.
-  size_t splitCol = GetSplitIndex(data, splitDim, splitVal, oldFromNew);
+  // The positions are computed in floating point so that (i * count) cannot
+  // overflow.
+  std::vector<double> values(n);
+  for (size_t i = 0; i < n; ++i)
+    values[i] = data(splitDim, begin + (size_t) ((i + 0.5) * count / n));
 
-  // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, begin,
-      splitCol - begin, oldFromNew, this, leafSize);
-  right = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, splitCol,
-      begin + count - splitCol, oldFromNew, this, leafSize);
+  std::nth_element(values.begin(), values.begin() + n / 2, values.end());
+  return values[n / 2];
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-size_t BinarySpaceTree<BoundType, StatisticType, MatType>::GetSplitIndex(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    GetSplitIndex(
     MatType& data,
     int splitDim,
     double splitVal)
@@ -635,8 +1221,12 @@ size_t BinarySpaceTree<BoundType, StatisticType, MatType>::GetSplitIndex(
   return left;
 }
 
-template<typename BoundType, typename StatisticType, typename MatType>
-size_t BinarySpaceTree<BoundType, StatisticType, MatType>::GetSplitIndex(
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    GetSplitIndex(
     MatType& data,
     int splitDim,
     double splitVal,
@@ -688,8 +1278,12 @@ size_t BinarySpaceTree<BoundType, StatisticType, MatType>::GetSplitIndex(
 /**
  * Returns a string representation of this object.
  */
-template<typename BoundType, typename StatisticType, typename MatType>
-std::string BinarySpaceTree<BoundType, StatisticType, MatType>::ToString() const
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+std::string BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    ToString() const
 {
   std::ostringstream convert;
   convert << "BinarySpaceTree [" << this << "]" << std::endl;
@@ -0,0 +1,123 @@
+/**
+ * @file build_options.hpp
+ *
+ * Options for building a BinarySpaceTree: the leaf size, the number of threads
+ * and the split rule.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_BUILD_OPTIONS_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_BUILD_OPTIONS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Options for building a BinarySpaceTree.  By default, the tree is built as by
+ * the other constructors: on one thread, splitting each node at the middle of
+ * its widest dimension.
+ *
+ * If Threads() is not 1 (and MLPACK was compiled with OpenMP), the two children
+ * of each large node are built as separate OpenMP tasks once the node has been
+ * split.  The tree that is built does not depend on the number of threads.
+ * Trees on sparse matrices are always built on one thread.
+ *
+ * If MedianSamples() is not 0, each node is instead split at the median of
+ * that many points of the node (taken at evenly spaced positions), in its
+ * widest dimension.  This keeps the tree balanced when the data is clustered
+ * or skewed, at the price of some looser bounds.  If the median does not split
+ * the points (because many of them have the same value), the middle of the
+ * dimension is used.
+ *
+ * If MortonOrder() is true, the points are instead sorted along a Morton curve
+ * over the bounding box of the data (see data::SpaceFillingCurve) before the
+ * tree is built, and each node is split where the Morton keys of its points
+ * first differ: the points of each child are then already contiguous, so
+ * building the tree moves no data after the sort, and the points of each leaf
+ * are close to those of the neighboring leaves in memory.  The splits are at
+ * the middle of cells of a grid, so they are like midpoint splits; this
+ * replaces the split rule of the tree (and MedianSamples()).  Trees on sparse
+ * matrices ignore this option.
+ *
+ * @code
+ * // Build with 8 threads, splitting at the median of 100 points per node.
+ * BinarySpaceTree<HRectBound<2> > tree(data, oldFromNew,
+ *     BuildOptions(20, 8, 100));
+ *
+ * // Bulk-load the tree from a Morton ordering of the points.
+ * BinarySpaceTree<HRectBound<2> > mortonTree(data, oldFromNew,
+ *     BuildOptions(20, 1, 0, true));
+ * @endcode
+ */
+class BuildOptions
+{
+ public:
+  /**
+   * Create the options.
+   *
+   * @param leafSize Size of each leaf in the tree.
+   * @param threads Number of threads to use (1 is serial, 0 is all cores).
+   * @param medianSamples Number of points to estimate the median split value
+   *     from (0 splits at the middle of the dimension).
+   * @param mortonOrder Whether to build the tree from a Morton ordering of the
+   *     points.
+   */
+  BuildOptions(const size_t leafSize = 20,
+               const size_t threads = 1,
+               const size_t medianSamples = 0,
+               const bool mortonOrder = false) :
+      leafSize(leafSize), threads(threads), medianSamples(medianSamples),
+      mortonOrder(mortonOrder) { }
+
+  //! Get the leaf size.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the number of threads (1 is serial, 0 is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (1 is serial, 0 is all cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of points the median is estimated from (0 for midpoint
+  //! splits).
+  size_t MedianSamples() const { return medianSamples; }
+  //! Modify the number of points the median is estimated from (0 for midpoint
+  //! splits).
+  size_t& MedianSamples() { return medianSamples; }
+
+  //! Get whether the tree is built from a Morton ordering of the points.
+  bool MortonOrder() const { return mortonOrder; }
+  //! Modify whether the tree is built from a Morton ordering of the points.
+  bool& MortonOrder() { return mortonOrder; }
+
+ private:
+  //! The leaf size.
+  size_t leafSize;
+  //! The number of threads.
+  size_t threads;
+  //! The number of points the median is estimated from.
+  size_t medianSamples;
+  //! Whether the tree is built from a Morton ordering of the points.
+  bool mortonOrder;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -26,15 +26,20 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include "binary_space_tree.hpp"
 
 namespace mlpack {
 namespace tree {
 
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 template<typename RuleType>
-class BinarySpaceTree<BoundType, StatisticType, MatType>::DualTreeTraverser
+class BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    DualTreeTraverser
 {
  public:
   /**
@@ -71,6 +76,33 @@ class BinarySpaceTree<BoundType, StatisticType, MatType>::DualTreeTraverser
   size_t& NumBaseCases() { return numBaseCases; }
 
  private:
+  HAS_MEM_FUNC(BaseCaseBlock, HasBaseCaseBlockSignature)
+
+  //! Whether the rules can calculate all the base cases between two leaves at
+  //! once, with size_t BaseCaseBlock(queryNode, referenceNode) (which returns
+  //! the number of base cases it calculated).
+  template<typename Rules>
+  struct HasBaseCaseBlock
+  {
+    static const bool value = HasBaseCaseBlockSignature<Rules,
+        size_t(Rules::*)(BinarySpaceTree&, BinarySpaceTree&)>::value;
+  };
+
+  //! Calculate the base cases between two leaves with
+  //! RuleType::BaseCaseBlock().
+  template<typename Rules>
+  void LeafBaseCases(BinarySpaceTree& queryNode,
+                     BinarySpaceTree& referenceNode,
+                     typename boost::enable_if<HasBaseCaseBlock<Rules> >::type*
+                         = 0);
+
+  //! Calculate the base cases between two leaves one pair at a time.
+  template<typename Rules>
+  void LeafBaseCases(BinarySpaceTree& queryNode,
+                     BinarySpaceTree& referenceNode,
+                     typename boost::disable_if<HasBaseCaseBlock<Rules> >::type*
+                         = 0);
+
   //! Reference to the rules with which the trees will be traversed.
   RuleType& rule;
 
@@ -26,13 +26,17 @@
 
 // In case it hasn't been included yet.
 #include "dual_tree_traverser.hpp"
+#include "../prefetch.hpp"
 
 namespace mlpack {
 namespace tree {
 
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 template<typename RuleType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
 DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
     rule(rule),
     numPrunes(0),
@@ -41,12 +45,15 @@ DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
     numBaseCases(0)
 { /* Nothing to do. */ }
 
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 template<typename RuleType>
-void BinarySpaceTree<BoundType, StatisticType, MatType>::
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
 DualTreeTraverser<RuleType>::Traverse(
-    BinarySpaceTree<BoundType, StatisticType, MatType>& queryNode,
-    BinarySpaceTree<BoundType, StatisticType, MatType>& referenceNode)
+    BinarySpaceTree& queryNode,
+    BinarySpaceTree& referenceNode)
 {
   // Increment the visit counter.
   ++numVisited;
@@ -54,26 +61,16 @@ DualTreeTraverser<RuleType>::Traverse(
   // If both are leaves, we must evaluate the base case.
   if (queryNode.IsLeaf() && referenceNode.IsLeaf())
   {
-    // Loop through each of the points in each node.
-    for (size_t query = queryNode.Begin(); query < queryNode.End(); ++query)
-    {
-      // See if we need to investigate this point (this function should be
-      // implemented for the single-tree recursion too).
-      const double score = rule.Score(query, referenceNode);
-
-      if (score == DBL_MAX)
-        continue; // We can't improve this particular point.
-
-      for (size_t ref = referenceNode.Begin(); ref < referenceNode.End(); ++ref)
-        rule.BaseCase(query, ref);
-
-      numBaseCases += referenceNode.Count();
-    }
+    LeafBaseCases<RuleType>(queryNode, referenceNode);
   }
   else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
   {
     // We have to recurse down the query node.  In this case the recursion order
-    // does not matter.
+    // does not matter.  Both children are loaded ahead of scoring them, so that
+    // the loads overlap.
+    PrefetchNode(*queryNode.Left());
+    PrefetchNode(*queryNode.Right());
+
     double leftScore = rule.Score(*queryNode.Left(), referenceNode);
     ++numScores;
 
@@ -94,6 +91,9 @@ DualTreeTraverser<RuleType>::Traverse(
   {
     // We have to recurse down the reference node.  In this case the recursion
     // order does matter.
+    PrefetchNode(*referenceNode.Left());
+    PrefetchNode(*referenceNode.Right());
+
     double leftScore = rule.Score(queryNode, *referenceNode.Left());
     double rightScore = rule.Score(queryNode, *referenceNode.Right());
     numScores += 2;
@@ -150,6 +150,11 @@ DualTreeTraverser<RuleType>::Traverse(
     // We have to recurse down both query and reference nodes.  Because the
     // query descent order does not matter, we will go to the left query child
     // first.
+    PrefetchNode(*queryNode.Left());
+    PrefetchNode(*queryNode.Right());
+    PrefetchNode(*referenceNode.Left());
+    PrefetchNode(*referenceNode.Right());
+
     double leftScore = rule.Score(*queryNode.Left(), *referenceNode.Left());
     double rightScore = rule.Score(*queryNode.Left(), *referenceNode.Right());
     numScores += 2;
@@ -261,6 +266,50 @@ DualTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+template<typename Rules>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+DualTreeTraverser<RuleType>::LeafBaseCases(
+    BinarySpaceTree& queryNode,
+    BinarySpaceTree& referenceNode,
+    typename boost::enable_if<HasBaseCaseBlock<Rules> >::type*)
+{
+  numBaseCases += rule.BaseCaseBlock(queryNode, referenceNode);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+template<typename Rules>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+DualTreeTraverser<RuleType>::LeafBaseCases(
+    BinarySpaceTree& queryNode,
+    BinarySpaceTree& referenceNode,
+    typename boost::disable_if<HasBaseCaseBlock<Rules> >::type*)
+{
+  // Loop through each of the points in each node.
+  for (size_t query = queryNode.Begin(); query < queryNode.End(); ++query)
+  {
+    // See if we need to investigate this point (this function should be
+    // implemented for the single-tree recursion too).
+    const double score = rule.Score(query, referenceNode);
+
+    if (score == DBL_MAX)
+      continue; // We can't improve this particular point.
+
+    for (size_t ref = referenceNode.Begin(); ref < referenceNode.End(); ++ref)
+      rule.BaseCase(query, ref);
+
+    numBaseCases += referenceNode.Count();
+  }
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
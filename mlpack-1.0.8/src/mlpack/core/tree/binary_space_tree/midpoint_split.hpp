@@ -0,0 +1,49 @@
+/**
+ * @file midpoint_split.hpp
+ *
+ * The default split rule of BinarySpaceTree, which splits each node along the
+ * dimension with the largest range.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MIDPOINT_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MIDPOINT_SPLIT_HPP
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The default split rule of BinarySpaceTree: each node is split with a
+ * hyperplane perpendicular to the dimension in which its points have the
+ * largest range, either at the middle of that range or (if
+ * BuildOptions::MedianSamples() is nonzero) near the median of the points.
+ * This gives a kd-tree with HRectBound.
+ *
+ * The split is done by the tree itself; this class only selects it.  Other
+ * split rules (like RPSplit) provide a static PerformSplit() function which
+ * the tree calls instead.
+ */
+class MidpointSplit
+{
+ public:
+  //! The splitting hyperplanes are perpendicular to one dimension.
+  static const bool AxisAligned = true;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file rp_split.hpp
+ *
+ * A split rule for BinarySpaceTree which splits each node along a random
+ * direction, giving a random projection tree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A split rule for BinarySpaceTree which gives a random projection tree (RP
+ * tree).  Each node is split with a hyperplane perpendicular to the direction
+ * from a random point of the node to the point of the node furthest from it,
+ * at the median of the projections of the points onto that direction.  Unlike
+ * the splits of a kd-tree, these adapt to the intrinsic dimension of the data,
+ * so an RP tree stays useful for high-dimensional data (such as embeddings
+ * with hundreds of dimensions) which lies near a low-dimensional subspace.
+ *
+ * The children of a node are not separated along any dimension, so an RP tree
+ * should be used with BallBound; hyperrectangles would overlap a lot.
+ *
+ * @code
+ * typedef BinarySpaceTree<bound::BallBound<>,
+ *     NeighborSearchStat<NearestNeighborSort>, arma::mat, RPSplit> RPTreeType;
+ * NeighborSearch<NearestNeighborSort, metric::EuclideanDistance, RPTreeType>
+ *     search(referenceData);
+ * @endcode
+ *
+ * @code
+ * @inproceedings{dasgupta2008random,
+ *   title={Random projection trees and low dimensional manifolds},
+ *   author={Dasgupta, S. and Freund, Y.},
+ *   booktitle={Proceedings of the 40th Annual ACM Symposium on Theory of
+ *       Computing (STOC '08)},
+ *   pages={537--546},
+ *   year={2008}
+ * }
+ * @endcode
+ */
+class RPSplit
+{
+ public:
+  //! The splitting hyperplanes are not perpendicular to one dimension.
+  static const bool AxisAligned = false;
+
+  /**
+   * Split the points [begin, begin + count) of the dataset: reorder them (and
+   * oldFromNew, if it is given) so that the points of the left child come
+   * first.
+   *
+   * @param data Dataset which is being split.
+   * @param begin Index of the first point of the node.
+   * @param count Number of points in the node.
+   * @param oldFromNew Vector holding permuted indices (may be NULL).
+   * @return The index of the first point of the right child, or begin if the
+   *     points cannot be split (because they are all the same).
+   */
+  template<typename MatType>
+  static size_t PerformSplit(MatType& data,
+                             const size_t begin,
+                             const size_t count,
+                             std::vector<size_t>* oldFromNew)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    // Pick a random point of the node (math::RandInt() is safe to call from
+    // the tasks of a parallel build).
+    const size_t start = begin + (size_t) math::RandInt((int) count);
+
+    // Find the point furthest from it.
+    const arma::Col<ElemType> startPoint(data.col(start));
+    size_t end = start;
+    double furthest = 0.0;
+    for (size_t i = begin; i < begin + count; ++i)
+    {
+      const double distance = arma::accu(arma::square(data.col(i) -
+          startPoint));
+      if (distance > furthest)
+      {
+        furthest = distance;
+        end = i;
+      }
+    }
+
+    if (furthest == 0.0)
+      return begin; // All the points are the same.
+
+    // Project the points onto the direction between the two points.
+    const arma::Col<ElemType> direction = data.col(end) - startPoint;
+    std::vector<double> projections(count);
+    for (size_t i = 0; i < count; ++i)
+      projections[i] = arma::dot(data.col(begin + i), direction);
+
+    std::vector<double> sorted(projections);
+    std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.end());
+    double splitVal = sorted[count / 2];
+
+    // The median may be the smallest projection (if many points share it); then
+    // split at the middle of the range, which always leaves points on both
+    // sides, since the projection of the end point is larger than that of the
+    // start point.
+    const double minVal = *std::min_element(sorted.begin(), sorted.end());
+    if (splitVal <= minVal)
+    {
+      const double maxVal = *std::max_element(sorted.begin(), sorted.end());
+      splitVal = minVal + 0.5 * (maxVal - minVal);
+    }
+
+    // Move the points with projections less than the split value to the left.
+    size_t left = 0;
+    size_t right = count;
+    while (true)
+    {
+      while (left < right && projections[left] < splitVal)
+        ++left;
+      while (left < right && projections[right - 1] >= splitVal)
+        --right;
+      if (left >= right)
+        break;
+
+      data.swap_cols(begin + left, begin + right - 1);
+      std::swap(projections[left], projections[right - 1]);
+      if (oldFromNew != NULL)
+        std::swap((*oldFromNew)[begin + left],
+                  (*oldFromNew)[begin + right - 1]);
+    }
+
+    return begin + left;
+  }
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -26,26 +26,33 @@
 
 // In case it hasn't been included yet.
 #include "single_tree_traverser.hpp"
+#include "../prefetch.hpp"
 
 #include <stack>
 
 namespace mlpack {
 namespace tree {
 
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 template<typename RuleType>
-BinarySpaceTree<BoundType, StatisticType, MatType>::
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
 SingleTreeTraverser<RuleType>::SingleTreeTraverser(RuleType& rule) :
     rule(rule),
     numPrunes(0)
 { /* Nothing to do. */ }
 
-template<typename BoundType, typename StatisticType, typename MatType>
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
 template<typename RuleType>
-void BinarySpaceTree<BoundType, StatisticType, MatType>::
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
 SingleTreeTraverser<RuleType>::Traverse(
     const size_t queryIndex,
-    BinarySpaceTree<BoundType, StatisticType, MatType>& referenceNode)
+    BinarySpaceTree& referenceNode)
 {
   // If we are a leaf, run the base case as necessary.
   if (referenceNode.IsLeaf())
@@ -55,6 +62,11 @@ SingleTreeTraverser<RuleType>::Traverse(
   }
   else
   {
+    // Start loading both children (and the points of leaves) before scoring
+    // them, so that the two loads overlap.
+    PrefetchNode(*referenceNode.Left());
+    PrefetchNode(*referenceNode.Right());
+
     // If either score is DBL_MAX, we do not recurse into that node.
     double leftScore = rule.Score(queryIndex, *referenceNode.Left());
     double rightScore = rule.Score(queryIndex, *referenceNode.Right());
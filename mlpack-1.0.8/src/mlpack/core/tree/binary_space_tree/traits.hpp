@@ -23,6 +23,7 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_TRAITS_HPP
 
 #include <mlpack/core/tree/tree_traits.hpp>
+#include <mlpack/core/tree/ballbound.hpp>
 
 namespace mlpack {
 namespace tree {
@@ -35,8 +36,9 @@ namespace tree {
  */
 template<typename BoundType,
          typename StatisticType,
-         typename MatType>
-class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType> >
+         typename MatType,
+         typename SplitType>
+class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType, SplitType> >
 {
  public:
   /**
@@ -47,10 +49,11 @@ class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType> >
 
   /**
    * Each binary space tree node has two children which represent
-   * non-overlapping subsets of the space which the node represents.  Therefore,
-   * children are not overlapping.
+   * non-overlapping subsets of the space which the node represents, if the
+   * node is split along one dimension (as with MidpointSplit).  The children
+   * of a random projection tree (RPSplit) may overlap.
    */
-  static const bool HasOverlappingChildren = false;
+  static const bool HasOverlappingChildren = !SplitType::AxisAligned;
 
   /**
    * There is no guarantee that the first point in a node is its centroid.
@@ -63,6 +66,35 @@ class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType> >
   static const bool HasSelfChildren = false;
 };
 
+/**
+ * A binary space tree with ball bounds (a ball tree) splits the points of each
+ * node with a hyperplane, but the balls of the two children may overlap.
+ * Everything else is the same as for the other bounds.
+ */
+template<typename VecType,
+         typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+class TreeTraits<BinarySpaceTree<bound::BallBound<VecType, MetricType>,
+                                 StatisticType,
+                                 MatType,
+                                 SplitType> >
+{
+ public:
+  //! The distance from a node to its parent is not known.
+  static const bool HasParentDistance = false;
+
+  //! The balls of the children of a node may overlap.
+  static const bool HasOverlappingChildren = true;
+
+  //! There is no guarantee that the first point in a node is its centroid.
+  static const bool FirstPointIsCentroid = false;
+
+  //! Points are not contained at multiple levels of the tree.
+  static const bool HasSelfChildren = false;
+};
+
 }; // namespace tree
 }; // namespace mlpack
 
@@ -0,0 +1,49 @@
+/**
+ * @file bound_traits.hpp
+ *
+ * The BoundTraits class, which provides compile-time information about the
+ * bounds used by trees.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_BOUND_TRAITS_HPP
+#define __MLPACK_CORE_TREE_BOUND_TRAITS_HPP
+
+namespace mlpack {
+namespace bound {
+
+/**
+ * The BoundTraits class provides compile-time information about a bound type,
+ * in the same way TreeTraits does for trees.  The unspecialized class makes as
+ * few assumptions about the bound as possible; specialize it for a bound which
+ * has any of these properties.
+ */
+template<typename BoundType>
+struct BoundTraits
+{
+  /**
+   * This is true if, once the bound has been expanded to hold a set of points,
+   * bound[d] is exactly the range of the points in dimension d.  Trees use
+   * these ranges to choose how to split a node; when the bound is not tight
+   * (like a ball), the ranges are computed from the points instead.
+   */
+  static const bool HasTightBounds = false;
+};
+
+}; // namespace bound
+}; // namespace mlpack
+
+#endif
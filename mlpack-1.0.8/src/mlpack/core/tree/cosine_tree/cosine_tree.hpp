@@ -19,7 +19,6 @@
  * You should have received a copy of the GNU General Public License along with
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
- 
 #ifndef __MLPACK_CORE_TREE_COSINE_TREE_COSINE_TREE_HPP
 #define __MLPACK_CORE_TREE_COSINE_TREE_COSINE_TREE_HPP
 
@@ -28,38 +27,66 @@
 namespace mlpack {
 namespace tree /** Cosine Trees and building procedures. */ {
 
+/**
+ * A node of a cosine tree.  Like BinarySpaceTree, a node does not hold any
+ * points itself: it refers to the contiguous range [begin, begin + count) of
+ * columns of one dataset, which CosineTreeBuilder permutes in place when it
+ * splits a node, so that the points of each child are contiguous too.  Nodes
+ * are split on demand (as in QUIC-SVD), so the tree can be grown only where the
+ * low-rank approximation needs it.
+ *
+ * @code
+ * CosineTreeBuilder builder;
+ * CosineTree root(dataset); // The dataset will be permuted.
+ * builder.CTNode(root);
+ * builder.CTNodeSplit(root);
+ * @endcode
+ */
 class CosineTree
 {
  private:
-  //! Data. 
-  arma::mat data;
+  //! The dataset (shared by every node of the tree).
+  arma::mat* dataset;
+  //! Index of the first point of this node.
+  size_t begin;
+  //! Number of points in the node.
+  size_t count;
   //! Centroid.
-  arma::rowvec centroid;
+  arma::vec centroid;
   //! Sampling Probabilities
   arma::vec probabilities;
+  //! Squared Frobenius norm of the points of this node.
+  double frobNormSquared;
+  //! The parent node (NULL for the root).
+  CosineTree* parent;
   //! The left child node.
   CosineTree* left;
   //! The right child node.
   CosineTree* right;
-  //! Number of points in the node.
-  size_t numPoints;
-  
+
  public:
-  //! So other classes can use TreeType::Mat.
-  //typedef MatType Mat;
   /**
-   * Constructor 
-   * 
-   * @param data Dataset to create tree from. 
-   * @param centroid Centroid of the matrix.
-   * @param probabilities Sampling probabilities
+   * Create the root node of a tree on the given dataset (one point per
+   * column).  The dataset is not copied, but it will be permuted when nodes
+   * are split; it must stay alive as long as the tree does.  The centroid and
+   * sampling probabilities are computed by CosineTreeBuilder::CTNode().
+   *
+   * @param dataset Dataset to create tree from.
    */
-  CosineTree(arma::mat data, arma::rowvec centroid, arma::vec probabilities);
+  CosineTree(arma::mat& dataset);
 
   /**
-   * Create an empty tree node.
+   * Create a node which holds the given range of points of the dataset.
+   *
+   * @param dataset Dataset the tree is built on.
+   * @param begin Index of the first point of the node.
+   * @param count Number of points in the node.
+   * @param parent Parent of the node.
    */
-  CosineTree();
+  CosineTree(arma::mat& dataset,
+             const size_t begin,
+             const size_t count,
+             CosineTree* parent = NULL);
 
   /**
    * Deletes this node, deallocating the memory for the children and calling
@@ -69,16 +96,17 @@ class CosineTree
   ~CosineTree();
 
   //! Gets the left child of this node.
-  CosineTree* Left() const;
-  
-  //!Sets the Left child of this node.
-  void Left(CosineTree* child);
+  CosineTree* Left() const { return left; }
+  //! Sets the left child of this node.
+  void Left(CosineTree* child) { left = child; }
 
   //! Gets the right child of this node.
-  CosineTree* Right() const;
+  CosineTree* Right() const { return right; }
+  //! Sets the right child of this node.
+  void Right(CosineTree* child) { right = child; }
 
-  //!Sets the Right child of this node.
-  void Right(CosineTree* child);
+  //! Gets the parent of this node (NULL for the root).
+  CosineTree* Parent() const { return parent; }
 
   /**
    * Return the specified child (0 will be left, 1 will be right).  If the index
@@ -86,29 +114,47 @@ class CosineTree
    *
    * @param child Index of child to return.
    */
-  CosineTree& Child(const size_t child) const;
-
-  //! Return the number of points in this node (0 if not a leaf).
-  size_t NumPoints() const;
-
-  //! Returns a reference to the data
-  arma::mat Data();
-  
-  //! Sets a reference to the data
-  void Data(arma::mat& d);
-  
-  //! Returns a reference to Sample Probabilites
-  arma::vec Probabilities();
-  
-  //! Sets a reference to Sample Probabilites
-  void Probabilities(arma::vec& prob);
-  
-  //! Returns a reference to the centroid
-  arma::rowvec Centroid();  
-  
-  //! Sets the centroid
-  void Centroid(arma::rowvec& centr);  
-   
+  CosineTree& Child(const size_t child) const
+  { return (child == 0) ? *left : *right; }
+
+  //! Return whether this node has no children.
+  bool IsLeaf() const { return (left == NULL) && (right == NULL); }
+
+  //! Return the number of points in this node.
+  size_t NumPoints() const { return count; }
+  //! Return the index of the first point of this node in the dataset.
+  size_t Begin() const { return begin; }
+  //! Return the number of points in this node.
+  size_t Count() const { return count; }
+
+  //! Return the index in the dataset of the given point of this node.
+  size_t Point(const size_t index) const { return begin + index; }
+
+  //! Returns a reference to the dataset the tree is built on.
+  const arma::mat& Dataset() const { return *dataset; }
+  //! Modify the dataset the tree is built on (don't reorder it!).
+  arma::mat& Dataset() { return *dataset; }
+
+  //! Returns a reference to the sampling probabilities (one per point).
+  const arma::vec& Probabilities() const { return probabilities; }
+  //! Modify the sampling probabilities.
+  arma::vec& Probabilities() { return probabilities; }
+
+  //! Returns a reference to the centroid.
+  const arma::vec& Centroid() const { return centroid; }
+  //! Modify the centroid.
+  arma::vec& Centroid() { return centroid; }
+
+  //! Returns the squared Frobenius norm of the points of this node.
+  double FrobNormSquared() const { return frobNormSquared; }
+  //! Modify the squared Frobenius norm of the points of this node.
+  double& FrobNormSquared() { return frobNormSquared; }
+
+ private:
+  //! Copying would share the children; don't allow it.
+  CosineTree(const CosineTree& other);
+  //! Copying would share the children; don't allow it.
+  CosineTree& operator=(const CosineTree& other);
 };
 
 }; // namespace tree
@@ -30,66 +30,80 @@ using namespace mlpack::tree;
 namespace mlpack {
 namespace tree /** tree-building procedures. */ {
 
+/**
+ * Compute the statistics of cosine tree nodes and split them.  Every node
+ * refers to a range of columns of the dataset, so nothing is copied: the
+ * statistics are computed on the columns of the range, and a split reorders
+ * the columns of the range so that the points of each child are contiguous.
+ */
 class CosineTreeBuilder
 {
  private:
   /**
-   * Length Square Sampling method for sampling rows
-   * of the matrix
+   * Length Square Sampling method for sampling points of the node: the
+   * probability of each point is its norm divided by the Frobenius norm of the
+   * node.
    *
-   * @param A Matrix for which probabilities are calculated
+   * @param node Node for which probabilities are calculated
    * @param prob Reference to the probability vector
    */
-  void LSSampling(arma::mat A, arma::vec& prob);
+  void LSSampling(CosineTree& node, arma::vec& prob) const;
 
   /**
-   * Calculates the centroid of the matrix
+   * Calculates the centroid of the points of the node
    *
-   * @param A Matrix for which the centroid has to be calculated
+   * @param node Node for which the centroid has to be calculated
+   * @param centroid Vector to store the centroid in
    */
-  arma::rowvec CalculateCentroid(arma::mat A) const;
+  void CalculateCentroid(const CosineTree& node, arma::vec& centroid) const;
 
   /**
-   * Calculates the Pivot for splitting
+   * Calculates the Pivot for splitting (the point with the largest sampling
+   * probability)
    *
    * @param prob Probability for a point to act as the pivot
    */
-  size_t GetPivot(arma::vec prob);
+  size_t GetPivot(const arma::vec& prob) const;
 
   /**
-   * Splits the points into the root node into children nodes
+   * Reorders the points of the node so that the points which are more similar
+   * to the pivot come first, and returns the number of those points.
    *
-   * @param c Array of Cosin Similarities
-   * @param ALeft Matrix for storing the points in Left Node
-   * @param ARight Matrix for storing the points in Right Node
-   * @param A All points
+   * @param node Node to be split
+   * @param c Array of Cosine Similarities (reordered with the points)
+   * @param oldFromNew Mapping from new to old point indices to update, or NULL
    */
-  void SplitData(std::vector<double> c, arma::mat& ALeft,
-                 arma::mat& Aright, arma::mat A);
+  size_t SplitData(CosineTree& node,
+                   std::vector<double>& c,
+                   std::vector<size_t>* oldFromNew) const;
 
   /**
    * Creates Cosine Similarity Array
    *
+   * @param node Node whose points are compared to the pivot
+   * @param pivot pivot point (index within the node)
    * @param c Array of Cosine Similarity
-   * @param A All points
-   * @param pivot pivot point
    */
-  void CreateCosineSimilarityArray(std::vector<double>& c,
-                                   arma::mat A, size_t pivot);
+  void CreateCosineSimilarityArray(const CosineTree& node,
+                                   const size_t pivot,
+                                   std::vector<double>& c) const;
 
   /**
    * Calculates Maximum Cosine Similarity
    *
    * @param c Array of Cosine Similarities
    */
-  double GetMaxSimilarity(std::vector<double> c);
+  double GetMaxSimilarity(const std::vector<double>& c) const;
 
   /**
-   * Calculates Maximum Cosine Similarity
+   * Calculates Minimum Cosine Similarity
    *
    * @param c Array of Cosine Similarities
    */
-  double GetMinSimilarity(std::vector<double> c);
+  double GetMinSimilarity(const std::vector<double>& c) const;
+
+  //! Split the node, updating oldFromNew if it is not NULL.
+  void Split(CosineTree& node, std::vector<size_t>* oldFromNew) const;
 
  public:
   //! Empty Constructor
@@ -98,21 +112,31 @@ class CosineTreeBuilder
   ~CosineTreeBuilder();
 
   /**
-   * Creates a new cosine tree node
+   * Computes the centroid, sampling probabilities and Frobenius norm of the
+   * points of a cosine tree node
+   *
+   * @param node Node to compute the statistics of
+   */
+  void CTNode(CosineTree& node) const;
+
+  /**
+   * Splits a cosine tree node: the points of the node are reordered, and two
+   * children (whose statistics are computed with CTNode()) are created.  If all
+   * the points would go to the same child, the node is left as a leaf.
    *
-   * @param A Data for constructing the node
-   * @param root Reference to the constructed node
+   * @param node Node to be split
    */
-  void CTNode(arma::mat A, CosineTree& root);
+  void CTNodeSplit(CosineTree& node) const;
 
   /**
-   * Splits a cosine tree node
+   * Splits a cosine tree node as above, and keeps track of where the points
+   * of the dataset go.
    *
-   * @param root Node to be split
-   * @param right reference to the right child
-   * @param left reference to the left child
+   * @param node Node to be split
+   * @param oldFromNew Mapping from the current index of each point of the
+   *     dataset to its original index (initialize it to 0, 1, 2, ...)
    */
-  void CTNodeSplit(CosineTree& root, CosineTree& left, CosineTree& right);
+  void CTNodeSplit(CosineTree& node, std::vector<size_t>& oldFromNew) const;
 };
 }; // namespace tree
 }; // namespace mlpack
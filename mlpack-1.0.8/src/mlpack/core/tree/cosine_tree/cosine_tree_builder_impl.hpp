@@ -30,158 +30,191 @@ namespace mlpack {
 namespace tree {
 
 // Empty Constructor
-CosineTreeBuilder::CosineTreeBuilder()
-{
-  Log::Info<<"Constructor"<<std::endl;
-}
+inline CosineTreeBuilder::CosineTreeBuilder() { }
 
 // Destructor
-CosineTreeBuilder::~CosineTreeBuilder() {}
+inline CosineTreeBuilder::~CosineTreeBuilder() { }
 
-void CosineTreeBuilder::LSSampling(arma::mat A, arma::vec& probability)
+inline void CosineTreeBuilder::LSSampling(CosineTree& node,
+                                          arma::vec& probability) const
 {
-  Log::Info<<"LSSampling"<<std::endl;
-  //Saving the frobenious norm of the matrix
-  double normA = arma::norm(A,"fro");
-  //Calculating probability of each point to be sampled
-  for (size_t i=0;i<A.n_rows;i++)
-    probability(i) = arma::norm(A.row(i),"fro")/normA;
+  const arma::mat& dataset = node.Dataset();
+
+  // Calculating the squared norm of each point, and the squared Frobenius norm
+  // of the node.
+  probability.set_size(node.NumPoints());
+  double frobNormSquared = 0;
+  for (size_t i = 0; i < node.NumPoints(); i++)
+  {
+    const double* point = dataset.colptr(node.Point(i));
+    double normSquared = 0;
+    for (size_t d = 0; d < dataset.n_rows; d++)
+      normSquared += point[d] * point[d];
+
+    probability[i] = normSquared;
+    frobNormSquared += normSquared;
+  }
+  node.FrobNormSquared() = frobNormSquared;
+
+  // Calculating probability of each point to be sampled.
+  if (frobNormSquared == 0.0)
+    probability.zeros();
+  else
+    probability = arma::sqrt(probability / frobNormSquared);
 }
 
-arma::rowvec CosineTreeBuilder::CalculateCentroid(arma::mat A) const
+inline void CosineTreeBuilder::CalculateCentroid(const CosineTree& node,
+                                                 arma::vec& centroid) const
 {
-  Log::Info<<"CalculateCentroid"<<std::endl;
-  //Summing over all coloumns
-  arma::rowvec colsum = arma::sum(A,0);
-  //Averaging
-  double k = 1.0/A.n_rows;
-  return k*colsum;
+  const arma::mat& dataset = node.Dataset();
+
+  // Summing over all points of the node, in place.
+  centroid.zeros(dataset.n_rows);
+  for (size_t i = 0; i < node.NumPoints(); i++)
+    centroid += dataset.unsafe_col(node.Point(i));
+
+  // Averaging
+  if (node.NumPoints() > 0)
+    centroid /= (double) node.NumPoints();
 }
 
-void CosineTreeBuilder::CTNode(arma::mat A, CosineTree& root)
+inline void CosineTreeBuilder::CTNode(CosineTree& node) const
 {
-  A = A.t();
-  Log::Info<<"CTNode"<<std::endl;
-  //Calculating Centroid
-  arma::rowvec centroid = CalculateCentroid(A);
-  //Calculating sampling probabilities
-  arma::vec probabilities = arma::zeros<arma::vec>(A.n_rows,1);
-  LSSampling(A,probabilities);
-  //Setting Values
-  root.Probabilities(probabilities);
-  root.Data(A);
-  root.Centroid(centroid);
+  // Calculating Centroid
+  CalculateCentroid(node, node.Centroid());
+  // Calculating sampling probabilities
+  LSSampling(node, node.Probabilities());
 }
 
-size_t CosineTreeBuilder::GetPivot(arma::vec prob)
+inline size_t CosineTreeBuilder::GetPivot(const arma::vec& prob) const
 {
-  Log::Info<<"GetPivot"<<std::endl;
-  //Setting firtst value as the pivot
-  double maxPivot=prob(0,0);
-  size_t pivot=0;
+  // Setting first value as the pivot
+  double maxPivot = prob[0];
+  size_t pivot = 0;
 
-  //Searching for the pivot poitn
-  for (size_t i=0;i<prob.n_rows;i++)
+  // Searching for the pivot point
+  for (size_t i = 1; i < prob.n_elem; i++)
   {
-    if(prob(i,0) > maxPivot)
+    if (prob[i] > maxPivot)
     {
-      maxPivot = prob(i,0);
+      maxPivot = prob[i];
       pivot = i;
     }
   }
   return pivot;
 }
 
-void CosineTreeBuilder::SplitData(std::vector<double> c, arma::mat& ALeft,
-                                  arma::mat& ARight,arma::mat A)
+inline size_t CosineTreeBuilder::SplitData(
+    CosineTree& node,
+    std::vector<double>& c,
+    std::vector<size_t>* oldFromNew) const
 {
-  Log::Info<<"SplitData"<<std::endl;
-  double cMax,cMin;
-  //Calculating the lower and the Upper Limit
-  cMin = GetMaxSimilarity(c);
-  cMax = GetMinSimilarity(c);
-  //Couter for left and right
-  size_t lft, rgt;
-  lft = 0;
-  rgt = 0;
-  //Splitting on the basis of nearness to the the high or low value
-  for(size_t i=0;i<A.n_rows;i++)
+  arma::mat& dataset = node.Dataset();
+
+  // Calculating the lower and the upper limit.
+  const double cMax = GetMaxSimilarity(c);
+  const double cMin = GetMinSimilarity(c);
+
+  // Splitting on the basis of nearness to the high or low value: points nearer
+  // the high value are swapped to the front of the node, like
+  // BinarySpaceTree::SplitNode() does.
+  size_t left = 0;
+  size_t right = node.NumPoints();
+  while (left < right)
   {
-    if ((cMax - c[i])<=(c[i] - cMin))
+    if ((cMax - c[left]) <= (c[left] - cMin))
     {
-      ALeft.insert_rows(lft,A.row(i));
-      lft ++;
+      left++;
     }
     else
     {
-      ARight.insert_rows(rgt,A.row(i));
-      rgt ++;
+      --right;
+      dataset.swap_cols(node.Point(left), node.Point(right));
+      std::swap(c[left], c[right]);
+      if (oldFromNew != NULL)
+        std::swap((*oldFromNew)[node.Point(left)],
+                  (*oldFromNew)[node.Point(right)]);
     }
   }
+
+  return left;
 }
 
-void CosineTreeBuilder::CreateCosineSimilarityArray(std::vector<double>& c,
-                                                    arma::mat A, size_t pivot)
+inline void CosineTreeBuilder::CreateCosineSimilarityArray(
+    const CosineTree& node,
+    const size_t pivot,
+    std::vector<double>& c) const
 {
-  Log::Info<<"CreateCosineSimilarityArray"<<std::endl;
-  for (size_t i = 0; i < A.n_rows; i++)
-  {
-    const double similarity =
-        kernel::CosineDistance::Evaluate(A.row(pivot), A.row(i));
-    c.push_back(similarity);
-  }
+  const arma::mat& dataset = node.Dataset();
+  const arma::vec pivotPoint = dataset.unsafe_col(node.Point(pivot));
+
+  c.resize(node.NumPoints());
+  for (size_t i = 0; i < node.NumPoints(); i++)
+    c[i] = kernel::CosineDistance::Evaluate(pivotPoint,
+        dataset.unsafe_col(node.Point(i)));
 }
-double CosineTreeBuilder::GetMinSimilarity(std::vector<double> c)
+
+inline double CosineTreeBuilder::GetMinSimilarity(
+    const std::vector<double>& c) const
 {
-  Log::Info<<"GetMinSimilarity"<<std::endl;
   double cMin = c[0];
-  for(size_t i=1;i<c.size();i++)
-    if(cMin<c[i])
+  for (size_t i = 1; i < c.size(); i++)
+    if (c[i] < cMin)
       cMin = c[i];
   return cMin;
 }
-double CosineTreeBuilder::GetMaxSimilarity(std::vector<double> c)
+
+inline double CosineTreeBuilder::GetMaxSimilarity(
+    const std::vector<double>& c) const
 {
-  Log::Info<<"GetMaxSimilarity"<<std::endl;
   double cMax = c[0];
-  for(size_t i=1;i<c.size();i++)
-    if(cMax<c[i])
+  for (size_t i = 1; i < c.size(); i++)
+    if (c[i] > cMax)
       cMax = c[i];
   return cMax;
 }
-void CosineTreeBuilder::CTNodeSplit(CosineTree& root, CosineTree& left,
-                                    CosineTree& right)
+
+inline void CosineTreeBuilder::Split(CosineTree& node,
+                                     std::vector<size_t>* oldFromNew) const
 {
-  //Extracting points from the root
-  arma::mat A = root.Data();
-  //Cosine Similarity Array
+  if (node.NumPoints() < 2 || !node.IsLeaf())
+    return;
+
+  // The sampling probabilities are needed for the pivot.
+  if (node.Probabilities().n_elem != node.NumPoints())
+    CTNode(node);
+
+  // Cosine Similarity Array
   std::vector<double> c;
-  //Matrices holding points for the left and the right node
-  arma::mat ALeft, ARight;
-  //Sampling probabilities
-  arma::vec prob = root.Probabilities();
-  //Pivot
-  size_t pivot = GetPivot(prob);
-  //Creating Array
-  CreateCosineSimilarityArray(c,A,pivot);
-  //Splitting data points
-  SplitData(c,ALeft,ARight,A);
-  //Creating Nodes
-  if(ALeft.n_rows > 0)
-  {
-    CTNode(ALeft.t(),left);
-    //TODO: Traversal is not required, still fix this
-    //root.Left(left);
-  }
-  if(ARight.n_rows > 0)
-  {
-    CTNode(ARight.t(),right);
-    //TODO: Traversal is not required, still fix this
-    //root.Right(right);
-  }
+  const size_t pivot = GetPivot(node.Probabilities());
+  CreateCosineSimilarityArray(node, pivot, c);
+
+  // Splitting data points
+  const size_t leftCount = SplitData(node, c, oldFromNew);
+  if (leftCount == 0 || leftCount == node.NumPoints())
+    return;
+
+  // Creating Nodes
+  node.Left(new CosineTree(node.Dataset(), node.Begin(), leftCount, &node));
+  node.Right(new CosineTree(node.Dataset(), node.Begin() + leftCount,
+      node.NumPoints() - leftCount, &node));
+  CTNode(*node.Left());
+  CTNode(*node.Right());
+}
+
+inline void CosineTreeBuilder::CTNodeSplit(CosineTree& node) const
+{
+  Split(node, NULL);
+}
+
+inline void CosineTreeBuilder::CTNodeSplit(
+    CosineTree& node,
+    std::vector<size_t>& oldFromNew) const
+{
+  Split(node, &oldFromNew);
 }
 
-}; // namespace cosinetreebuilder
+}; // namespace tree
 }; // namespace mlpack
 
 #endif
@@ -27,25 +27,34 @@
 namespace mlpack {
 namespace tree {
 
-CosineTree::CosineTree(arma::mat data, arma::rowvec centroid, arma::vec probabilities) : 
-    data(data.t()),
-    centroid(centroid),
-    probabilities(probabilities),
+inline CosineTree::CosineTree(arma::mat& dataset) :
+    dataset(&dataset),
+    begin(0),
+    count(dataset.n_cols),
+    frobNormSquared(0),
+    parent(NULL),
     left(NULL),
-    right(NULL),
-    numPoints(data.n_cols)
-{ 
+    right(NULL)
+{
   // Nothing to do
 }
 
-CosineTree::CosineTree() : 
+inline CosineTree::CosineTree(arma::mat& dataset,
+                              const size_t begin,
+                              const size_t count,
+                              CosineTree* parent) :
+    dataset(&dataset),
+    begin(begin),
+    count(count),
+    frobNormSquared(0),
+    parent(parent),
     left(NULL),
     right(NULL)
-{   
+{
   // Nothing to do
 }
 
-CosineTree::~CosineTree()
+inline CosineTree::~CosineTree()
 {
   if (left)
     delete left;
@@ -53,70 +62,6 @@ CosineTree::~CosineTree()
     delete right;
 }
 
-CosineTree* CosineTree::Right() const
-{
-  return right;
-}
-
-void CosineTree::Right(CosineTree* child)
-{
-  right = child;
-}
-
-CosineTree* CosineTree::Left() const
-{
-  return left;
-}
-
-void CosineTree::Left(CosineTree* child)
-{
-  left = child;
-}
-
-CosineTree& CosineTree::Child(const size_t child) const
-{
-  if (child == 0)
-    return *left;
-  else
-    return *right;
-}
-
-size_t CosineTree::NumPoints() const
-{
-  return numPoints;
-}
-
-arma::mat CosineTree::Data()
-{
-  return data;
-}
-
-void CosineTree::Data(arma::mat& d)
-{
-    data = d;
-    numPoints = d.n_rows;
-}
-
-arma::vec CosineTree::Probabilities() 
-{
-  return probabilities;
-}
-
-void CosineTree::Probabilities(arma::vec& prob)
-{
-  probabilities = prob; 
-}
-
-arma::rowvec CosineTree::Centroid()
-{
-  return centroid;
-}
-
-void CosineTree::Centroid(arma::rowvec& centr)
-{
-    centroid = centr;
-}
-
 }; // namespace tree
 }; // namespace mlpack
 
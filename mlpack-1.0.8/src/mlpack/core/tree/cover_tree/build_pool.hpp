@@ -0,0 +1,151 @@
+/**
+ * @file build_pool.hpp
+ *
+ * Scratch memory and settings shared by the nodes of a cover tree while it is
+ * built.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_COVER_TREE_BUILD_POOL_HPP
+#define __MLPACK_CORE_TREE_COVER_TREE_BUILD_POOL_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The scratch memory used while a CoverTree is built.  Every node that creates
+ * children needs index and distance arrays for the point set of each child;
+ * these only live while the child is built, so they can be taken from a stack
+ * instead of being allocated one by one.  Memory is kept in large blocks that
+ * are reused when arrays are freed, so after the first few nodes, building a
+ * tree allocates (almost) no memory.  Arrays must be freed in the reverse order
+ * of their allocation.
+ *
+ * The pool also holds the number of threads used to compute the distances from
+ * each new node to its point set.
+ */
+class BuildPool
+{
+ public:
+  /**
+   * Create an empty pool.
+   *
+   * @param threads Number of threads to compute distances with (1 is serial,
+   *     0 is all cores).
+   */
+  BuildPool(const size_t threads = 1) : threads(Threads::Count(threads)) { }
+
+  //! Allocate an array of the given number of indices.
+  size_t* AllocateIndices(const size_t size) { return indices.Allocate(size); }
+  //! Free the most recently allocated array of indices.
+  void FreeIndices() { indices.Free(); }
+
+  //! Allocate an array of the given number of distances.
+  double* AllocateDistances(const size_t size)
+  { return distances.Allocate(size); }
+  //! Free the most recently allocated array of distances.
+  void FreeDistances() { distances.Free(); }
+
+  //! Get the number of threads to compute distances with (at least 1).
+  size_t Threads() const { return threads; }
+
+ private:
+  /**
+   * A stack of arrays, kept in blocks which are never moved; blocks which
+   * become unused are kept for the next allocations.
+   */
+  template<typename eT>
+  class Stack
+  {
+   public:
+    Stack() : current(0) { }
+
+    ~Stack()
+    {
+      for (size_t i = 0; i < blocks.size(); ++i)
+        delete[] blocks[i];
+    }
+
+    eT* Allocate(const size_t size)
+    {
+      if (blocks.empty() || capacities[current] - used[current] < size)
+      {
+        // Move on to the next block, replacing it if it is too small.
+        if (!blocks.empty() && used[current] > 0)
+          ++current;
+
+        if (current == blocks.size())
+        {
+          blocks.push_back(NULL);
+          capacities.push_back(0);
+          used.push_back(0);
+        }
+
+        if (capacities[current] < size)
+        {
+          const size_t previous = (current > 0) ? capacities[current - 1] : 0;
+          const size_t capacity = std::max(size, std::max((size_t) 65536,
+              2 * previous));
+
+          delete[] blocks[current];
+          blocks[current] = new eT[capacity];
+          capacities[current] = capacity;
+        }
+      }
+
+      eT* array = blocks[current] + used[current];
+      used[current] += size;
+      allocations.push_back(std::make_pair(current, size));
+      return array;
+    }
+
+    void Free()
+    {
+      const std::pair<size_t, size_t> last = allocations.back();
+      allocations.pop_back();
+      used[last.first] -= last.second;
+
+      // The next allocation goes after the most recent remaining one.
+      current = allocations.empty() ? 0 : allocations.back().first;
+    }
+
+   private:
+    //! The blocks of memory.
+    std::vector<eT*> blocks;
+    //! The size of each block.
+    std::vector<size_t> capacities;
+    //! The number of elements in use in each block.
+    std::vector<size_t> used;
+    //! The block and size of each allocation that has not been freed.
+    std::vector<std::pair<size_t, size_t> > allocations;
+    //! The block the most recent allocation is in.
+    size_t current;
+  };
+
+  //! The index arrays.
+  Stack<size_t> indices;
+  //! The distance arrays.
+  Stack<double> distances;
+  //! The number of threads.
+  size_t threads;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -25,6 +25,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "first_point_is_root.hpp"
+#include "build_pool.hpp"
 #include "../statistic.hpp"
 
 namespace mlpack {
@@ -54,8 +55,12 @@ namespace tree {
  * The theoretical structure of the tree contains many 'implicit' nodes which
  * only have a "self-child" (a child referencing the same point, but at a lower
  * scale level).  This practical implementation only constructs explicit nodes
- * -- non-leaf nodes with more than one child.  A leaf node has no children, and
- * its scale level is INT_MIN.
+ * -- non-leaf nodes with more than one child -- and the scale of each node
+ * records how many implicit levels were skipped, so a tree has fewer than two
+ * nodes per point.  A leaf node has no children, and its scale level is
+ * INT_MIN.  Once built, the nodes below the root are moved into one contiguous
+ * block in breadth-first order (see Compact()), so the children of every node
+ * are adjacent in memory.
  *
  * For more information on cover trees, see
  *
@@ -110,14 +115,21 @@ class CoverTree
    * The dataset will not be modified during the building procedure (unlike
    * BinarySpaceTree).
    *
-   * The last argument will be removed in mlpack 1.1.0 (see #274 and #273).
+   * The metric argument will be removed in mlpack 1.1.0 (see #274 and #273).
+   *
+   * If threads is not 1, the distances from each new node to its point set
+   * are computed in parallel (when the point set is large enough).  The tree
+   * that is built does not depend on the number of threads.
    *
    * @param dataset Reference to the dataset to build a tree on.
    * @param base Base to use during tree building (default 2.0).
+   * @param metric Instantiated metric to use (NULL creates one).
+   * @param threads Number of threads to use (1 is serial, 0 is all cores).
    */
   CoverTree(const arma::mat& dataset,
             const double base = 2.0,
-            MetricType* metric = NULL);
+            MetricType* metric = NULL,
+            const size_t threads = 1);
 
   /**
    * Create the cover tree with the given dataset and the given instantiated
@@ -127,10 +139,12 @@ class CoverTree
    * @param dataset Reference to the dataset to build a tree on.
    * @param metric Instantiated metric to use during tree building.
    * @param base Base to use during tree building (default 2.0).
+   * @param threads Number of threads to use (1 is serial, 0 is all cores).
    */
   CoverTree(const arma::mat& dataset,
             MetricType& metric,
-            const double base = 2.0);
+            const double base = 2.0,
+            const size_t threads = 1);
 
   /**
    * Construct a child cover tree node.  This constructor is not meant to be
@@ -162,6 +176,9 @@ class CoverTree
    * @param farSetSize Size of the far set; may be modified (if this node uses
    *     any points in the far set).
    * @param usedSetSize The number of points used will be added to this number.
+   * @param metric Instantiated metric to use during tree building.
+   * @param pool Scratch memory for building the descendants of this node (NULL
+   *     uses a new pool).
    */
   CoverTree(const arma::mat& dataset,
             const double base,
@@ -174,7 +191,8 @@ class CoverTree
             size_t nearSetSize,
             size_t& farSetSize,
             size_t& usedSetSize,
-            MetricType& metric = NULL);
+            MetricType& metric = NULL,
+            BuildPool* pool = NULL);
 
   /**
    * Manually construct a cover tree node; no tree assembly is done in this
@@ -201,6 +219,33 @@ class CoverTree
             const double furthestDescendantDistance,
             MetricType* metric = NULL);
 
+  /**
+   * Manually construct a cover tree node with the given statistic, instead of
+   * building the statistic for the node.  This is useful when the statistics
+   * were saved along with the tree, and building them again would be
+   * expensive.  Otherwise, this is the same as the constructor above.
+   *
+   * @param dataset Reference to the dataset this node is a part of.
+   * @param base Base that was used for tree building.
+   * @param pointIndex Index of the point in the dataset which this node refers
+   *      to.
+   * @param scale Scale of this node's level in the tree.
+   * @param parent Parent node (NULL indicates no parent).
+   * @param parentDistance Distance to parent node point.
+   * @param furthestDescendantDistance Distance to furthest descendant point.
+   * @param metric Instantiated metric (NULL creates one).
+   * @param stat Statistic of the node.
+   */
+  CoverTree(const arma::mat& dataset,
+            const double base,
+            const size_t pointIndex,
+            const int scale,
+            CoverTree* parent,
+            const double parentDistance,
+            const double furthestDescendantDistance,
+            MetricType* metric,
+            const StatisticType& stat);
+
   /**
    * Create a cover tree from another tree.  Be careful!  This may use a lot of
    * memory and take a lot of time.
@@ -223,6 +268,48 @@ class CoverTree
   template<typename RuleType>
   class DualTreeTraverser;
 
+  /**
+   * Insert the given point of the dataset into the tree.  The point may have
+   * been added to the dataset after the tree was built: the tree only holds a
+   * reference to the matrix, so columns can be appended to it (for instance,
+   * with insert_cols()).  The point must not already be in the tree.  This
+   * must be called on the root node.
+   *
+   * The new point is passed down to the closest child that is close enough to
+   * cover it, raising the scale of that child if necessary.  The covering and
+   * nesting invariants and the bounds used by the traversers are kept exactly,
+   * but separation is only kept between siblings, so a tree that has had many
+   * points inserted may be slower to search than a rebuilt one.  The
+   * statistics of the nodes on the path to the new point are rebuilt.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   */
+  void Insert(const size_t pointIndex);
+
+  /**
+   * Remove the given point from the tree (the dataset is not modified, so the
+   * indices of the other points do not change).  The node holding the point at
+   * the highest scale is removed along with its subtree, and the other points
+   * of the subtree are inserted again with Insert(); removing the point of the
+   * root node therefore inserts every other point again.  The last point of a
+   * tree cannot be removed.  This must be called on the root node.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   */
+  void Remove(const size_t pointIndex);
+
+  /**
+   * Move the nodes below this one into one contiguous block, in breadth-first
+   * order, so the children of each node are adjacent in memory, and trim the
+   * child lists to their size.  This saves the allocator overhead of each node
+   * and makes traversals touch fewer cache lines.  Trees built from a dataset
+   * are compacted when they are built; trees assembled by hand (or changed
+   * with Insert() and Remove()) can be compacted again with this.  Pointers to
+   * the old nodes below this one are invalidated.  This must be called on the
+   * root node.
+   */
+  void Compact();
+
   //! Get a reference to the dataset.
   const arma::mat& Dataset() const { return dataset; }
 
@@ -249,6 +336,8 @@ class CoverTree
 
   //! Get the number of descendant points.
   size_t NumDescendants() const;
+  //! Modify the number of descendant points (for nodes constructed manually).
+  size_t& NumDescendants() { return numDescendants; }
 
   //! Get the index of a particular descendant point.
   size_t Descendant(const size_t index) const;
@@ -268,6 +357,14 @@ class CoverTree
   //! Modify the statistic for this node.
   StatisticType& Stat() { return stat; }
 
+  /**
+   * Rebuild the statistic of this node and all of its descendants, as they are
+   * built during construction (children first).  This is much cheaper than
+   * building the tree again, and it clears anything a search has left in the
+   * statistics, so the tree can be used for another search.
+   */
+  void ResetStatistics();
+
   //! Return the minimum distance to another node.
   double MinDistance(const CoverTree* other) const;
 
@@ -378,14 +475,32 @@ class CoverTree
   //! The metric used for this tree.
   MetricType* metric;
 
+  //! The contiguous block holding the nodes below this one, if this is a
+  //! compacted root (NULL otherwise).
+  CoverTree* nodes;
+
+  //! Whether this node lives in the block of its root (see Compact()).  Such
+  //! a node is destroyed in place instead of deleted.
+  bool inBlock;
+
+  //! Delete the given node, or destroy it in place if it is in a block.
+  static void DeleteNode(CoverTree* node);
+
   /**
-   * Create the children for this node.
+   * Build the tree below the root node, using the given pool.
+   */
+  void BuildRoot(BuildPool& pool);
+
+  /**
+   * Create the children for this node.  The point sets of the children are
+   * taken from the given pool.
    */
   void CreateChildren(arma::Col<size_t>& indices,
                       arma::vec& distances,
                       size_t nearSetSize,
                       size_t& farSetSize,
-                      size_t& usedSetSize);
+                      size_t& usedSetSize,
+                      BuildPool& pool);
 
   /**
    * Fill the vector of distances with the distances between the point specified
@@ -397,11 +512,13 @@ class CoverTree
    * @param indices List of indices to compute distances for.
    * @param distances Vector to store calculated distances in.
    * @param pointSetSize Number of points in arrays to calculate distances for.
+   * @param threads Number of threads to calculate the distances with.
    */
   void ComputeDistances(const size_t pointIndex,
                         const arma::Col<size_t>& indices,
                         arma::vec& distances,
-                        const size_t pointSetSize);
+                        const size_t pointSetSize,
+                        const size_t threads = 1);
   /**
    * Split the given indices and distances into a near and a far set, returning
    * the number of points in the near set.  The distances must already be
@@ -439,12 +556,14 @@ class CoverTree
    * @param childFarSetSize Number of points in child far set (childFarSet).
    * @param childUsedSetSize Number of points in child used set (childUsedSet).
    * @param farSetSize Number of points in far set (farSet).
+   * @param pool Pool to take the temporary buffers from.
    */
   size_t SortPointSet(arma::Col<size_t>& indices,
                       arma::vec& distances,
                       const size_t childFarSetSize,
                       const size_t childUsedSetSize,
-                      const size_t farSetSize);
+                      const size_t farSetSize,
+                      BuildPool& pool);
 
   void MoveToUsedSet(arma::Col<size_t>& indices,
                      arma::vec& distances,
@@ -466,6 +585,52 @@ class CoverTree
    */
   void RemoveNewImplicitNodes();
 
+  /**
+   * Insert the given point below this node, which must cover it.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   * @param distance Distance between the point of this node and the point.
+   */
+  void InsertBelow(const size_t pointIndex, const double distance);
+
+  /**
+   * Create a leaf holding the given point, as a child of this node.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   * @param distance Distance between the point of this node and the point.
+   */
+  CoverTree* NewLeaf(const size_t pointIndex, const double distance);
+
+  /**
+   * Return the smallest scale whose covering distance (base to the power of
+   * the scale) is at least the given distance, which must be positive.
+   */
+  int CoveringScale(const double distance) const;
+
+  /**
+   * Find the node with the highest scale below this one which holds the given
+   * point, or NULL if the point is not below this node.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   * @param distance Distance between the point of this node and the point.
+   */
+  CoverTree* FindTopNode(const size_t pointIndex, const double distance);
+
+  /**
+   * Add the points of all the leaves below the given node, except the given
+   * point, to the vector.
+   */
+  static void CollectPoints(const CoverTree& node,
+                            const size_t except,
+                            std::vector<size_t>& points);
+
+  /**
+   * If the given node has only one child left (its self-child), replace the
+   * node with that child; the root instead takes over the children of the
+   * child.  Returns the node that is now in the place of the given one.
+   */
+  static CoverTree* RemoveImplicitNode(CoverTree* node);
+
  public:
   /**
    * Returns a string representation of this object.
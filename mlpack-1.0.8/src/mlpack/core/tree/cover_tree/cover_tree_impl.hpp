@@ -26,6 +26,7 @@
 #include "cover_tree.hpp"
 
 #include <mlpack/core/util/string_util.hpp>
+#include <new>
 #include <string>
 
 namespace mlpack {
@@ -36,7 +37,8 @@ template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     const arma::mat& dataset,
     const double base,
-    MetricType* metric) :
+    MetricType* metric,
+    const size_t threads) :
     dataset(dataset),
     point(RootPointPolicy::ChooseRoot(dataset)),
     scale(INT_MAX),
@@ -47,6 +49,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(metric == NULL),
     metric(metric),
+    nodes(NULL),
+    inBlock(false),
     distanceComps(0)
 {
   // If we need to create a metric, do that.  We'll just do it on the heap.
@@ -57,67 +61,16 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
   if (dataset.n_cols == 1)
     return;
 
-  // Kick off the building.  Create the indices array and the distances array.
-  arma::Col<size_t> indices = arma::linspace<arma::Col<size_t> >(1,
-      dataset.n_cols - 1, dataset.n_cols - 1);
-  // This is now [1 2 3 4 ... n].  We must be sure that our point does not
-  // occur.
-  if (point != 0)
-    indices[point - 1] = 0; // Put 0 back into the set; remove what was there.
-
-  arma::vec distances(dataset.n_cols - 1);
-
-  // Build the initial distances.
-  ComputeDistances(point, indices, distances, dataset.n_cols - 1);
-
-  // Create the children.
-  size_t farSetSize = 0;
-  size_t usedSetSize = 0;
-  CreateChildren(indices, distances, dataset.n_cols - 1, farSetSize,
-      usedSetSize);
-
-  // If we ended up creating only one child, remove the implicit node.
-  while (children.size() == 1)
-  {
-    // Prepare to delete the implicit child node.
-    CoverTree* old = children[0];
-
-    // Now take its children and set their parent correctly.
-    children.erase(children.begin());
-    for (size_t i = 0; i < old->NumChildren(); ++i)
-    {
-      children.push_back(&(old->Child(i)));
-
-      // Set its parent correctly.
-      old->Child(i).Parent() = this;
-    }
-
-    // Remove all the children so they don't get erased.
-    old->Children().clear();
-
-    // Reduce our own scale.
-    scale = old->Scale();
-
-    // Now delete it.
-    delete old;
-  }
-
-  // Use the furthest descendant distance to determine the scale of the root
-  // node.
-  scale = (int) ceil(log(furthestDescendantDistance) / log(base));
-
-  // Initialize statistic.
-  stat = StatisticType(*this);
-
-  Log::Info << distanceComps << " distance computations during tree "
-      << "construction." << std::endl;
+  BuildPool pool(threads);
+  BuildRoot(pool);
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     const arma::mat& dataset,
     MetricType& metric,
-    const double base) :
+    const double base,
+    const size_t threads) :
     dataset(dataset),
     point(RootPointPolicy::ChooseRoot(dataset)),
     scale(INT_MAX),
@@ -128,12 +81,22 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(false),
     metric(&metric),
+    nodes(NULL),
+    inBlock(false),
     distanceComps(0)
 {
   // If there is only one point in the dataset, uh, we're done.
   if (dataset.n_cols == 1)
     return;
 
+  BuildPool pool(threads);
+  BuildRoot(pool);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::BuildRoot(
+    BuildPool& pool)
+{
   // Kick off the building.  Create the indices array and the distances array.
   arma::Col<size_t> indices = arma::linspace<arma::Col<size_t> >(1,
       dataset.n_cols - 1, dataset.n_cols - 1);
@@ -145,13 +108,14 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
   arma::vec distances(dataset.n_cols - 1);
 
   // Build the initial distances.
-  ComputeDistances(point, indices, distances, dataset.n_cols - 1);
+  ComputeDistances(point, indices, distances, dataset.n_cols - 1,
+      pool.Threads());
 
   // Create the children.
   size_t farSetSize = 0;
   size_t usedSetSize = 0;
   CreateChildren(indices, distances, dataset.n_cols - 1, farSetSize,
-      usedSetSize);
+      usedSetSize, pool);
 
   // If we ended up creating only one child, remove the implicit node.
   while (children.size() == 1)
@@ -188,6 +152,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
 
   Log::Info << distanceComps << " distance computations during tree "
       << "construction." << std::endl;
+
+  Compact();
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
@@ -203,7 +169,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     size_t nearSetSize,
     size_t& farSetSize,
     size_t& usedSetSize,
-    MetricType& metric) :
+    MetricType& metric,
+    BuildPool* pool) :
     dataset(dataset),
     point(pointIndex),
     scale(scale),
@@ -214,6 +181,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(false),
     metric(&metric),
+    nodes(NULL),
+    inBlock(false),
     distanceComps(0)
 {
   // If the size of the near set is 0, this is a leaf.
@@ -226,7 +195,17 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
   }
 
   // Otherwise, create the children.
-  CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize);
+  if (pool == NULL)
+  {
+    BuildPool localPool;
+    CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize,
+        localPool);
+  }
+  else
+  {
+    CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize,
+        *pool);
+  }
 
   // Initialize statistic.
   stat = StatisticType(*this);
@@ -253,6 +232,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(furthestDescendantDistance),
     localMetric(metric == NULL),
     metric(metric),
+    nodes(NULL),
+    inBlock(false),
     distanceComps(0)
 {
   // If necessary, create a local metric.
@@ -263,6 +244,38 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
   stat = StatisticType(*this);
 }
 
+// Manually create a cover tree node with a given statistic.
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
+    const arma::mat& dataset,
+    const double base,
+    const size_t pointIndex,
+    const int scale,
+    CoverTree* parent,
+    const double parentDistance,
+    const double furthestDescendantDistance,
+    MetricType* metric,
+    const StatisticType& stat) :
+    dataset(dataset),
+    point(pointIndex),
+    scale(scale),
+    base(base),
+    stat(stat),
+    numDescendants(0),
+    parent(parent),
+    parentDistance(parentDistance),
+    furthestDescendantDistance(furthestDescendantDistance),
+    localMetric(metric == NULL),
+    metric(metric),
+    nodes(NULL),
+    inBlock(false),
+    distanceComps(0)
+{
+  // If necessary, create a local metric.
+  if (localMetric)
+    this->metric = new MetricType();
+}
+
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     const CoverTree& other) :
@@ -277,6 +290,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(other.furthestDescendantDistance),
     localMetric(false),
     metric(other.metric),
+    nodes(NULL),
+    inBlock(false),
     distanceComps(0)
 {
   // Copy each child by hand.
@@ -292,13 +307,27 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::~CoverTree()
 {
   // Delete each child.
   for (size_t i = 0; i < children.size(); ++i)
-    delete children[i];
+    DeleteNode(children[i]);
+
+  // The nodes of the block are all destroyed now.
+  if (nodes != NULL)
+    ::operator delete(nodes);
 
   // Delete the local metric, if necessary.
   if (localMetric)
     delete metric;
 }
 
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+inline void CoverTree<MetricType, RootPointPolicy, StatisticType>::DeleteNode(
+    CoverTree* node)
+{
+  if (node->inBlock)
+    node->~CoverTree();
+  else
+    delete node;
+}
+
 //! Return the number of descendant points.
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 inline size_t
@@ -468,7 +497,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     arma::vec& distances,
     size_t nearSetSize,
     size_t& farSetSize,
-    size_t& usedSetSize)
+    size_t& usedSetSize,
+    BuildPool& pool)
 {
   // Determine the next scale level.  This should be the first level where there
   // are any points in the far set.  So, if we know the maximum distance in the
@@ -486,7 +516,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     // This should not modify farSetSize or usedSetSize.
     size_t tempSize = 0;
     children.push_back(new CoverTree(dataset, base, point, INT_MIN, this, 0,
-        indices, distances, 0, tempSize, usedSetSize, *metric));
+        indices, distances, 0, tempSize, usedSetSize, *metric, &pool));
     distanceComps += children.back()->DistanceComps();
 
     // Every point in the near set should be a leaf.
@@ -495,7 +525,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
       // farSetSize and usedSetSize will not be modified.
       children.push_back(new CoverTree(dataset, base, indices[i],
           INT_MIN, this, distances[i], indices, distances, 0, tempSize,
-          usedSetSize, *metric));
+          usedSetSize, *metric, &pool));
       distanceComps += children.back()->DistanceComps();
       usedSetSize++;
     }
@@ -508,7 +538,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     // [ used | far | other used ]
     // and we want
     // [ far | all used ].
-    SortPointSet(indices, distances, 0, usedSetSize, farSetSize);
+    SortPointSet(indices, distances, 0, usedSetSize, farSetSize, pool);
 
     return;
   }
@@ -527,7 +557,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
   size_t childUsedSetSize = 0;
   children.push_back(new CoverTree(dataset, base, point, nextScale, this, 0,
       indices, distances, childNearSetSize, childFarSetSize, childUsedSetSize,
-      *metric));
+      *metric, &pool));
   // Don't double-count the self-child (so, subtract one).
   numDescendants += children[0]->NumDescendants();
 
@@ -548,7 +578,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
   // [ near | far | childUsed + used ]
   // is what we are trying to make.
   SortPointSet(indices, distances, childFarSetSize, childUsedSetSize,
-      farSetSize);
+      farSetSize, pool);
 
   // Update size of near set and used set.
   nearSetSize -= childUsedSetSize;
@@ -585,7 +615,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
       size_t childNearSetSize = 0;
       children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
           this, distances[0], indices, distances, childNearSetSize, farSetSize,
-          usedSetSize, *metric));
+          usedSetSize, *metric, &pool));
       distanceComps += children.back()->DistanceComps();
       numDescendants += children.back()->NumDescendants();
 
@@ -598,16 +628,19 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
       break;
     }
 
-    // Create the near and far set indices and distance vectors.  We don't fill
-    // in the self-point, yet.
-    arma::Col<size_t> childIndices(nearSetSize + farSetSize);
+    // Create the near and far set indices and distance vectors, in memory from
+    // the pool.  We don't fill in the self-point, yet.
+    const size_t childSetSize = nearSetSize + farSetSize;
+    arma::Col<size_t> childIndices(pool.AllocateIndices(childSetSize),
+        childSetSize, false, true);
     childIndices.rows(0, (nearSetSize + farSetSize - 2)) = indices.rows(1,
         nearSetSize + farSetSize - 1);
-    arma::vec childDistances(nearSetSize + farSetSize);
+    arma::vec childDistances(pool.AllocateDistances(childSetSize),
+        childSetSize, false, true);
 
     // Build distances for the child.
     ComputeDistances(indices[0], childIndices, childDistances, nearSetSize
-        + farSetSize - 1);
+        + farSetSize - 1, pool.Threads());
 
     // Split into near and far sets for this point.
     childNearSetSize = SplitNearFar(childIndices, childDistances, bound,
@@ -627,7 +660,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     childUsedSetSize = 1; // Mark self point as used.
     children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
         this, distances[0], childIndices, childDistances, childNearSetSize,
-        childFarSetSize, childUsedSetSize, *metric));
+        childFarSetSize, childUsedSetSize, *metric, &pool));
     numDescendants += children.back()->NumDescendants();
 
     // Remove any implicit nodes.
@@ -642,6 +675,10 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     // set in our own vector.
     MoveToUsedSet(indices, distances, nearSetSize, farSetSize, usedSetSize,
         childIndices, childFarSetSize, childUsedSetSize);
+
+    // The child's point set is not needed anymore.
+    pool.FreeDistances();
+    pool.FreeIndices();
   }
 
   // Calculate furthest descendant.
@@ -709,12 +746,15 @@ void CoverTree<MetricType, RootPointPolicy, StatisticType>::ComputeDistances(
     const size_t pointIndex,
     const arma::Col<size_t>& indices,
     arma::vec& distances,
-    const size_t pointSetSize)
+    const size_t pointSetSize,
+    const size_t threads)
 {
   // For each point, rebuild the distances.  The indices do not need to be
-  // modified.
+  // modified.  Only large point sets are worth splitting between threads.
   distanceComps += pointSetSize;
-  for (size_t i = 0; i < pointSetSize; ++i)
+  #pragma omp parallel for num_threads(threads) schedule(static) \
+      if ((threads > 1) && (pointSetSize >= 1000))
+  for (int i = 0; i < (int) pointSetSize; ++i)
   {
     distances[i] = metric->Evaluate(dataset.unsafe_col(pointIndex),
         dataset.unsafe_col(indices[i]));
@@ -727,7 +767,8 @@ size_t CoverTree<MetricType, RootPointPolicy, StatisticType>::SortPointSet(
     arma::vec& distances,
     const size_t childFarSetSize,
     const size_t childUsedSetSize,
-    const size_t farSetSize)
+    const size_t farSetSize,
+    BuildPool& pool)
 {
   // We'll use low-level memcpy calls ourselves, just to ensure it's done
   // quickly and the way we want it to be.  Unfortunately this takes up more
@@ -740,8 +781,8 @@ size_t CoverTree<MetricType, RootPointPolicy, StatisticType>::SortPointSet(
   if (bufferSize == 0)
     return (childFarSetSize + farSetSize);
 
-  size_t* indicesBuffer = new size_t[bufferSize];
-  double* distancesBuffer = new double[bufferSize];
+  size_t* indicesBuffer = pool.AllocateIndices(bufferSize);
+  double* distancesBuffer = pool.AllocateDistances(bufferSize);
 
   // The start of the memory region to copy to the buffer.
   const size_t bufferFromLocation = ((bufferSize == farSetSize) ?
@@ -774,8 +815,8 @@ size_t CoverTree<MetricType, RootPointPolicy, StatisticType>::SortPointSet(
   memcpy(distances.memptr() + bufferToLocation, distancesBuffer,
       sizeof(double) * bufferSize);
 
-  delete[] indicesBuffer;
-  delete[] distancesBuffer;
+  pool.FreeDistances();
+  pool.FreeIndices();
 
   // This returns the complete size of the far set.
   return (childFarSetSize + farSetSize);
@@ -990,6 +1031,394 @@ inline void CoverTree<MetricType, RootPointPolicy, StatisticType>::
   }
 }
 
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::ResetStatistics()
+{
+  for (size_t i = 0; i < children.size(); ++i)
+    children[i]->ResetStatistics();
+
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::Insert(
+    const size_t pointIndex)
+{
+  if (parent != NULL)
+    Log::Fatal << "CoverTree::Insert() must be called on the root node."
+        << std::endl;
+  if (pointIndex >= dataset.n_cols)
+    Log::Fatal << "CoverTree::Insert(): point " << pointIndex << " is not in "
+        << "the dataset (" << dataset.n_cols << " points)." << std::endl;
+
+  const double distance = metric->Evaluate(dataset.unsafe_col(point),
+      dataset.unsafe_col(pointIndex));
+  ++distanceComps;
+
+  if (children.empty())
+  {
+    // The tree holds only one point, so the root gets its self-child and the
+    // new point as children.
+    children.push_back(NewLeaf(point, 0.0));
+    children.push_back(NewLeaf(pointIndex, distance));
+    scale = (distance > 0.0) ? CoveringScale(distance) : 0;
+    numDescendants = 2;
+    furthestDescendantDistance = distance;
+  }
+  else if (distance > pow(base, scale))
+  {
+    // The root does not cover the point.  The old root becomes the self-child
+    // of a root with a higher scale, which is far enough from every other point
+    // to have the new point as a child too.
+    CoverTree* self = new CoverTree(dataset, base, point, scale, this, 0.0,
+        furthestDescendantDistance, metric);
+    self->children.swap(children);
+    for (size_t i = 0; i < self->children.size(); ++i)
+      self->children[i]->parent = self;
+    self->numDescendants = numDescendants;
+    self->stat = StatisticType(*self);
+
+    children.push_back(self);
+    children.push_back(NewLeaf(pointIndex, distance));
+    scale = CoveringScale(distance);
+    ++numDescendants;
+    furthestDescendantDistance = std::max(furthestDescendantDistance,
+        distance);
+  }
+  else
+  {
+    InsertBelow(pointIndex, distance);
+    return;
+  }
+
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::Remove(
+    const size_t pointIndex)
+{
+  if (parent != NULL)
+    Log::Fatal << "CoverTree::Remove() must be called on the root node."
+        << std::endl;
+  if (pointIndex >= dataset.n_cols)
+    Log::Fatal << "CoverTree::Remove(): point " << pointIndex << " is not in "
+        << "the dataset (" << dataset.n_cols << " points)." << std::endl;
+
+  const double distance = metric->Evaluate(dataset.unsafe_col(point),
+      dataset.unsafe_col(pointIndex));
+  ++distanceComps;
+
+  CoverTree* node = FindTopNode(pointIndex, distance);
+  if (node == NULL)
+    Log::Fatal << "CoverTree::Remove(): point " << pointIndex << " is not in "
+        << "the tree." << std::endl;
+
+  // These points have to be inserted again.
+  std::vector<size_t> points;
+  CollectPoints(*node, pointIndex, points);
+
+  if (node == this)
+  {
+    if (points.empty())
+      Log::Fatal << "CoverTree::Remove(): cannot remove the last point of a "
+          << "tree." << std::endl;
+
+    // Start again from one of the other points.
+    for (size_t i = 0; i < children.size(); ++i)
+      DeleteNode(children[i]);
+    children.clear();
+
+    point = points[0];
+    scale = INT_MIN;
+    numDescendants = 1;
+    furthestDescendantDistance = 0.0;
+    stat = StatisticType(*this);
+
+    for (size_t i = 1; i < points.size(); ++i)
+      Insert(points[i]);
+
+    return;
+  }
+
+  // Detach the subtree from its parent.  The furthest descendant distances of
+  // the ancestors are still valid bounds.
+  CoverTree* nodeParent = node->parent;
+  for (size_t i = 0; i < nodeParent->children.size(); ++i)
+  {
+    if (nodeParent->children[i] == node)
+    {
+      nodeParent->children.erase(nodeParent->children.begin() + i);
+      break;
+    }
+  }
+
+  for (CoverTree* ancestor = nodeParent; ancestor != NULL;
+       ancestor = ancestor->parent)
+    ancestor->numDescendants -= node->numDescendants;
+
+  DeleteNode(node);
+
+  // The parent may now have only its self-child left.
+  for (CoverTree* ancestor = RemoveImplicitNode(nodeParent); ancestor != NULL;
+       ancestor = ancestor->parent)
+    ancestor->stat = StatisticType(*ancestor);
+
+  for (size_t i = 0; i < points.size(); ++i)
+    Insert(points[i]);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::Compact()
+{
+  if (parent != NULL)
+    Log::Fatal << "CoverTree::Compact() must be called on the root node."
+        << std::endl;
+
+  // List the nodes below the root in breadth-first order, so that the children
+  // of each node are consecutive.
+  std::vector<CoverTree*> old(children.begin(), children.end());
+  for (size_t i = 0; i < old.size(); ++i)
+    old.insert(old.end(), old[i]->children.begin(), old[i]->children.end());
+
+  CoverTree* block = NULL;
+  if (!old.empty())
+    block = static_cast<CoverTree*>(::operator new(old.size() *
+        sizeof(CoverTree)));
+
+  // Copy each node into its place; the children of the ith node start right
+  // after the children of the nodes before it.
+  size_t next = children.size();
+  for (size_t i = 0; i < old.size(); ++i)
+  {
+    CoverTree& node = *old[i];
+    CoverTree* copy = new (block + i) CoverTree(dataset, base, node.point,
+        node.scale, NULL, node.parentDistance, node.furthestDescendantDistance,
+        node.metric, node.stat);
+    copy->numDescendants = node.numDescendants;
+    copy->distanceComps = node.distanceComps;
+    copy->inBlock = true;
+
+    // A node assembled by hand may own its metric.
+    copy->localMetric = node.localMetric;
+    node.localMetric = false;
+
+    copy->children.reserve(node.children.size());
+    for (size_t j = 0; j < node.children.size(); ++j)
+      copy->children.push_back(block + next + j);
+    next += node.children.size();
+  }
+
+  // Now that every node is in place, link the children to their parents.
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    children[i] = block + i;
+    children[i]->parent = this;
+  }
+  for (size_t i = 0; i < old.size(); ++i)
+    for (size_t j = 0; j < block[i].children.size(); ++j)
+      block[i].children[j]->parent = block + i;
+
+  std::vector<CoverTree*>(children).swap(children);
+
+  // The old nodes no longer own their children.
+  for (size_t i = 0; i < old.size(); ++i)
+  {
+    old[i]->children.clear();
+    DeleteNode(old[i]);
+  }
+
+  if (nodes != NULL)
+    ::operator delete(nodes);
+  nodes = block;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::InsertBelow(
+    const size_t pointIndex,
+    const double distance)
+{
+  ++numDescendants;
+  furthestDescendantDistance = std::max(furthestDescendantDistance, distance);
+
+  // Find the closest child which is too close to the point to be its sibling.
+  const double bound = pow(base, scale - 1);
+  size_t closest = children.size();
+  double closestDistance = DBL_MAX;
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    double childDistance = distance; // The self-child has the same point.
+    if (children[i]->point != point)
+    {
+      childDistance = metric->Evaluate(dataset.unsafe_col(children[i]->point),
+          dataset.unsafe_col(pointIndex));
+      ++distanceComps;
+    }
+
+    if ((childDistance <= bound) && (childDistance < closestDistance))
+    {
+      closest = i;
+      closestDistance = childDistance;
+    }
+  }
+
+  if (closest == children.size() || (closestDistance == 0.0 &&
+      children[closest]->IsLeaf()))
+  {
+    // The point is far enough from every child to be a new child.  Duplicates
+    // of a leaf are kept as its siblings, as when the tree is built.
+    children.push_back(NewLeaf(pointIndex, distance));
+  }
+  else if (!children[closest]->IsLeaf())
+  {
+    // The child takes the point; if it does not cover it, its scale can be
+    // raised to do so (and stay below the scale of this node).
+    CoverTree* child = children[closest];
+    if (closestDistance > pow(base, child->scale))
+      child->scale = CoveringScale(closestDistance);
+
+    child->InsertBelow(pointIndex, closestDistance);
+  }
+  else
+  {
+    // The point is too close to a leaf to be its sibling, so the leaf becomes a
+    // node holding both points.
+    CoverTree* leaf = children[closest];
+    CoverTree* node = new CoverTree(dataset, base, leaf->point,
+        CoveringScale(closestDistance), this, leaf->parentDistance,
+        closestDistance, metric);
+
+    leaf->parent = node;
+    leaf->parentDistance = 0.0;
+    node->children.push_back(leaf);
+    node->children.push_back(node->NewLeaf(pointIndex, closestDistance));
+    node->numDescendants = 2;
+    node->stat = StatisticType(*node);
+
+    children[closest] = node;
+  }
+
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::NewLeaf(
+    const size_t pointIndex,
+    const double distance)
+{
+  CoverTree* leaf = new CoverTree(dataset, base, pointIndex, INT_MIN, this,
+      distance, 0.0, metric);
+  leaf->numDescendants = 1;
+  leaf->stat = StatisticType(*leaf);
+
+  return leaf;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+int CoverTree<MetricType, RootPointPolicy, StatisticType>::CoveringScale(
+    const double distance) const
+{
+  // Correct for any rounding in the logarithms.
+  int coveringScale = (int) ceil(log(distance) / log(base));
+  while (pow(base, coveringScale) < distance)
+    ++coveringScale;
+  while (pow(base, coveringScale - 1) >= distance)
+    --coveringScale;
+
+  return coveringScale;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::FindTopNode(
+    const size_t pointIndex,
+    const double distance)
+{
+  if (point == pointIndex)
+    return this;
+
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    double childDistance = distance; // The self-child has the same point.
+    if (children[i]->point != point)
+    {
+      childDistance = metric->Evaluate(dataset.unsafe_col(children[i]->point),
+          dataset.unsafe_col(pointIndex));
+      ++distanceComps;
+    }
+
+    // Every descendant of the child is within its furthest descendant
+    // distance.
+    if (childDistance > children[i]->furthestDescendantDistance)
+      continue;
+
+    CoverTree* found = children[i]->FindTopNode(pointIndex, childDistance);
+    if (found != NULL)
+      return found;
+  }
+
+  return NULL;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::CollectPoints(
+    const CoverTree& node,
+    const size_t except,
+    std::vector<size_t>& points)
+{
+  // Every point is held by exactly one leaf.
+  if (node.IsLeaf())
+  {
+    if (node.point != except)
+      points.push_back(node.point);
+    return;
+  }
+
+  for (size_t i = 0; i < node.children.size(); ++i)
+    CollectPoints(*node.children[i], except, points);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::RemoveImplicitNode(
+    CoverTree* node)
+{
+  if (node->children.size() != 1)
+    return node;
+
+  CoverTree* child = node->children[0];
+  if (node->parent == NULL)
+  {
+    // The root keeps its place and takes over the children of its self-child.
+    node->children.swap(child->children);
+    for (size_t i = 0; i < node->children.size(); ++i)
+      node->children[i]->parent = node;
+    node->scale = child->scale;
+    if (node->children.empty())
+    {
+      node->numDescendants = 1;
+      node->furthestDescendantDistance = 0.0;
+    }
+
+    DeleteNode(child);
+    return node;
+  }
+
+  // Otherwise, the self-child takes the place of the node.
+  CoverTree* nodeParent = node->parent;
+  for (size_t i = 0; i < nodeParent->children.size(); ++i)
+    if (nodeParent->children[i] == node)
+      nodeParent->children[i] = child;
+
+  child->parent = nodeParent;
+  child->parentDistance = node->parentDistance;
+
+  node->children.clear();
+  DeleteNode(node);
+  return child;
+}
+
 /**
  * Returns a string representation of this object.
  */
@@ -28,9 +28,21 @@
 namespace mlpack {
 namespace tree {
 
-//! Forward declaration of struct to be used for traversal.
+//! The object placed in the reference sets for tree traversal.
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
-struct DualCoverTreeMapEntry;
+struct DualCoverTreeMapEntry
+{
+  //! The node this entry refers to.
+  CoverTree<MetricType, RootPointPolicy, StatisticType>* referenceNode;
+  //! The score of the node.
+  double score;
+
+  //! Comparison operator, for sorting within the map.
+  bool operator<(const DualCoverTreeMapEntry& other) const
+  {
+    return (score < other.score);
+  }
+};
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 template<typename RuleType>
@@ -42,6 +54,11 @@ class CoverTree<MetricType, RootPointPolicy, StatisticType>::DualTreeTraverser
    */
   DualTreeTraverser(RuleType& rule);
 
+  /**
+   * Free the memory kept for reference sets.
+   */
+  ~DualTreeTraverser();
+
   /**
    * Traverse the two specified trees.
    *
@@ -50,14 +67,6 @@ class CoverTree<MetricType, RootPointPolicy, StatisticType>::DualTreeTraverser
    */
   void Traverse(CoverTree& queryNode, CoverTree& referenceNode);
 
-  /**
-   * Helper function for traversal of the two trees.
-   */
-  void Traverse(CoverTree& queryNode,
-                std::map<int, std::vector<DualCoverTreeMapEntry<
-                    MetricType, RootPointPolicy, StatisticType> > >&
-                    referenceMap);
-
   //! Get the number of pruned nodes.
   size_t NumPrunes() const { return numPrunes; }
   //! Modify the number of pruned nodes.
@@ -70,24 +79,93 @@ class CoverTree<MetricType, RootPointPolicy, StatisticType>::DualTreeTraverser
   size_t NumBaseCases() const { return 0; }
 
  private:
+  //! Convenience typedef.
+  typedef DualCoverTreeMapEntry<MetricType, RootPointPolicy, StatisticType>
+      MapEntryType;
+
+  /**
+   * The reference nodes of one scale of a reference set.  The bucket made by
+   * PruneMap() for the children of a query node is shared by all of them, and
+   * they only read it: the entries are sorted by score once, into
+   * sortedEntries, for all the children, and a child which has to add entries
+   * to the bucket copies it first.  Other buckets belong to one reference set,
+   * and are sorted in place.
+   */
+  struct ScaleBucket
+  {
+    //! The entries, in the order they were added (unless sorted in place).
+    std::vector<MapEntryType> entries;
+    //! The entries sorted by score, for a shared bucket.
+    std::vector<MapEntryType> sortedEntries;
+    //! Whether the bucket is shared by the children of a query node.
+    bool shared;
+    //! Whether the entries have been sorted.
+    bool sorted;
+  };
+
+  //! A scale of a reference set and the bucket of its reference nodes.
+  struct ScaleEntry
+  {
+    //! The scale.
+    int scale;
+    //! The reference nodes of this scale.
+    ScaleBucket* bucket;
+  };
+
+  /**
+   * A set of reference nodes to recurse into, by scale: this replaces a
+   * std::map from the scale to the nodes, so that the set of a query node can
+   * be handed to each of its children without copying the nodes.  The scales
+   * are in increasing order.
+   */
+  typedef std::vector<ScaleEntry> ReferenceSet;
+
   //! The instantiated rule set for pruning branches.
   RuleType& rule;
 
   //! The number of pruned nodes.
   size_t numPrunes;
 
+  /**
+   * The buckets used by the traversal; the first usedBuckets are in use.  They
+   * are taken and given back in stack order, and their memory is kept, so
+   * after the first few query nodes the traversal allocates (almost) no
+   * memory.
+   */
+  std::vector<ScaleBucket*> buckets;
+  //! The number of buckets in use.
+  size_t usedBuckets;
+  //! The reference sets used by the traversal, kept like the buckets.
+  std::vector<ReferenceSet*> sets;
+  //! The number of reference sets in use.
+  size_t usedSets;
+
+  /**
+   * Helper function for traversal of the two trees.  The buckets and sets
+   * taken during the traversal are not given back; the caller does that.
+   */
+  void Traverse(CoverTree& queryNode, ReferenceSet& referenceSet);
+
   //! Prepare map for recursion.
   void PruneMap(CoverTree& queryNode,
-                std::map<int, std::vector<DualCoverTreeMapEntry<
-                    MetricType, RootPointPolicy, StatisticType> > >&
-                    referenceMap,
-                std::map<int, std::vector<DualCoverTreeMapEntry<
-                    MetricType, RootPointPolicy, StatisticType> > >& childMap);
-
-  void ReferenceRecursion(CoverTree& queryNode,
-                          std::map<int, std::vector<DualCoverTreeMapEntry<
-                              MetricType, RootPointPolicy, StatisticType> > >&
-                              referenceMap);
+                ReferenceSet& referenceSet,
+                ReferenceSet& childSet);
+
+  void ReferenceRecursion(CoverTree& queryNode, ReferenceSet& referenceSet);
+
+  //! Take an empty bucket which belongs to one reference set.
+  ScaleBucket* NewBucket();
+  //! Take an empty reference set.
+  ReferenceSet& NewSet();
+
+  //! Get the entries of the given bucket, sorted by score.
+  std::vector<MapEntryType>& SortedEntries(ScaleBucket& bucket);
+
+  //! Add the given entry to the given scale of the given reference set, copying
+  //! the bucket of that scale first if it is shared.
+  void AddEntry(ReferenceSet& referenceSet,
+                const int scale,
+                const MapEntryType& entry);
 };
 
 }; // namespace tree
@@ -23,35 +23,33 @@
 #define __MLPACK_CORE_TREE_COVER_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
 
 #include <mlpack/core.hpp>
+#include <algorithm>
 #include <queue>
 
 namespace mlpack {
 namespace tree {
 
-//! The object placed in the map for tree traversal.
-template<typename MetricType, typename RootPointPolicy, typename StatisticType>
-struct DualCoverTreeMapEntry
-{
-  //! The node this entry refers to.
-  CoverTree<MetricType, RootPointPolicy, StatisticType>* referenceNode;
-  //! The score of the node.
-  double score;
-
-  //! Comparison operator, for sorting within the map.
-  bool operator<(const DualCoverTreeMapEntry& other) const
-  {
-    return (score < other.score);
-  }
-};
-
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 template<typename RuleType>
 CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
     rule(rule),
-    numPrunes(0)
+    numPrunes(0),
+    usedBuckets(0),
+    usedSets(0)
 { /* Nothing to do. */ }
 
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::~DualTreeTraverser()
+{
+  for (size_t i = 0; i < buckets.size(); ++i)
+    delete buckets[i];
+  for (size_t i = 0; i < sets.size(); ++i)
+    delete sets[i];
+}
+
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
 template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
@@ -59,20 +57,24 @@ DualTreeTraverser<RuleType>::Traverse(
     CoverTree<MetricType, RootPointPolicy, StatisticType>& queryNode,
     CoverTree<MetricType, RootPointPolicy, StatisticType>& referenceNode)
 {
-  typedef DualCoverTreeMapEntry<MetricType, RootPointPolicy, StatisticType>
-      MapEntryType;
+  const size_t bucketMark = usedBuckets;
+  const size_t setMark = usedSets;
 
-  // Start by creating a map and adding the reference root node to it.
-  std::map<int, std::vector<MapEntryType> > refMap;
+  // Start by creating a reference set and adding the reference root node to
+  // it.
+  ReferenceSet& refSet = NewSet();
 
   MapEntryType rootRefEntry;
 
   rootRefEntry.referenceNode = &referenceNode;
   rootRefEntry.score = 0.0; // Must recurse into.
 
-  refMap[referenceNode.Scale()].push_back(rootRefEntry);
+  AddEntry(refSet, referenceNode.Scale(), rootRefEntry);
 
-  Traverse(queryNode, refMap);
+  Traverse(queryNode, refSet);
+
+  usedBuckets = bucketMark;
+  usedSets = setMark;
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
@@ -80,40 +82,43 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::Traverse(
     CoverTree<MetricType, RootPointPolicy, StatisticType>& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry<MetricType, RootPointPolicy,
-        StatisticType> > >& referenceMap)
+    ReferenceSet& referenceSet)
 {
-  // Convenience typedef.
-  typedef DualCoverTreeMapEntry<MetricType, RootPointPolicy, StatisticType>
-      MapEntryType;
-
-  if (referenceMap.size() == 0)
+  if (referenceSet.size() == 0)
     return; // Nothing to do!
 
   // First recurse down the reference nodes as necessary.
-  ReferenceRecursion(queryNode, referenceMap);
+  ReferenceRecursion(queryNode, referenceSet);
 
   // Did the map get emptied?
-  if (referenceMap.size() == 0)
+  if (referenceSet.size() == 0)
     return; // Nothing to do!
 
   // Now, reduce the scale of the query node by recursing.  But we can't recurse
   // if the query node is a leaf node.
   if ((queryNode.Scale() != INT_MIN) &&
-      (queryNode.Scale() >= (*referenceMap.rbegin()).first))
+      (queryNode.Scale() >= referenceSet.back().scale))
   {
     // Recurse into the non-self-children first.  The recursion order cannot
     // affect the runtime of the algorithm, because each query child recursion's
     // results are separate and independent.  I don't think this is true in
     // every case, and we may have to modify this section to consider scores in
     // the future.
-    std::map<int, std::vector<MapEntryType> > childMap;
-    PruneMap(queryNode, referenceMap, childMap);
+    ReferenceSet& childSet = NewSet();
+    PruneMap(queryNode, referenceSet, childSet);
     for (size_t i = 0; i < queryNode.NumChildren(); ++i)
     {
-      // We need a copy of the map for this child.
-      std::map<int, std::vector<MapEntryType> > thisChildMap = childMap;
-      Traverse(queryNode.Child(i), thisChildMap);
+      // Each child gets its own list of scales, but the buckets are shared
+      // until the child has to change them.
+      const size_t bucketMark = usedBuckets;
+      const size_t setMark = usedSets;
+
+      ReferenceSet& thisChildSet = NewSet();
+      thisChildSet = childSet;
+      Traverse(queryNode.Child(i), thisChildSet);
+
+      usedBuckets = bucketMark;
+      usedSets = setMark;
     }
   }
 
@@ -121,10 +126,11 @@ DualTreeTraverser<RuleType>::Traverse(
     return; // No need to evaluate base cases at this level.  It's all done.
 
   // If we have made it this far, all we have is a bunch of base case
-  // evaluations to do.
-  Log::Assert((*referenceMap.begin()).first == INT_MIN);
+  // evaluations to do.  This bucket has not been sorted, so the entries are in
+  // the order they were added.
+  Log::Assert(referenceSet.front().scale == INT_MIN);
   Log::Assert(queryNode.Scale() == INT_MIN);
-  std::vector<MapEntryType>& pointVector = (*referenceMap.begin()).second;
+  std::vector<MapEntryType>& pointVector = referenceSet.front().bucket->entries;
 
   for (size_t i = 0; i < pointVector.size(); ++i)
   {
@@ -162,30 +168,26 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::PruneMap(
     CoverTree& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry<MetricType,
-        RootPointPolicy, StatisticType> > >& referenceMap,
-    std::map<int, std::vector<DualCoverTreeMapEntry<MetricType,
-        RootPointPolicy, StatisticType> > >& childMap)
+    ReferenceSet& referenceSet,
+    ReferenceSet& childSet)
 {
-  typedef DualCoverTreeMapEntry<MetricType, RootPointPolicy, StatisticType>
-      MapEntryType;
-
-  if (referenceMap.empty())
+  if (referenceSet.empty())
     return; // Nothing to do.
-  typename std::map<int, std::vector<MapEntryType> >::reverse_iterator it =
-      referenceMap.rbegin();
 
-  while ((it != referenceMap.rend()))
+  // The scales are visited from the largest down, so the child set is built in
+  // that order and reversed at the end.
+  for (size_t i = referenceSet.size(); i > 0; --i)
   {
-    // Get a reference to the vector representing the entries at this scale.
-    std::vector<MapEntryType>& scaleVector = (*it).second;
-
-    // Before traversing all the points in this scale, sort by score.
-    std::sort(scaleVector.begin(), scaleVector.end());
+    // Get the entries at this scale, sorted by score.
+    const int thisScale = referenceSet[i - 1].scale;
+    std::vector<MapEntryType>& scaleVector =
+        SortedEntries(*referenceSet[i - 1].bucket);
 
-    const int thisScale = (*it).first;
-    childMap[thisScale].reserve(scaleVector.size());
-    std::vector<MapEntryType>& newScaleVector = childMap[thisScale];
+    // The new bucket is shared by all the children of the query node.
+    ScaleBucket* newBucket = NewBucket();
+    newBucket->shared = true;
+    std::vector<MapEntryType>& newScaleVector = newBucket->entries;
+    newScaleVector.reserve(scaleVector.size());
 
     // Loop over each entry in the vector.
     for (size_t j = 0; j < scaleVector.size(); ++j)
@@ -214,12 +216,21 @@ DualTreeTraverser<RuleType>::PruneMap(
       newScaleVector.back().score = score;
     }
 
-    // If we didn't add anything, then strike this vector from the map.
+    // If we didn't add anything, then strike this scale from the child set.
+    // The bucket is the most recent one, so it can be given back.
     if (newScaleVector.size() == 0)
-      childMap.erase((*it).first);
+    {
+      --usedBuckets;
+      continue;
+    }
 
-    ++it; // Advance to next scale.
+    ScaleEntry scaleEntry;
+    scaleEntry.scale = thisScale;
+    scaleEntry.bucket = newBucket;
+    childSet.push_back(scaleEntry);
   }
+
+  std::reverse(childSet.begin(), childSet.end());
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
@@ -227,34 +238,30 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::ReferenceRecursion(
     CoverTree& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry<MetricType, RootPointPolicy,
-        StatisticType> > >& referenceMap)
+    ReferenceSet& referenceSet)
 {
-  typedef DualCoverTreeMapEntry<MetricType, RootPointPolicy, StatisticType>
-      MapEntryType;
-
   // First, reduce the maximum scale in the reference map down to the scale of
   // the query node.
-  while (!referenceMap.empty() &&
-      ((*referenceMap.rbegin()).first > queryNode.Scale()))
+  while (!referenceSet.empty() &&
+      (referenceSet.back().scale > queryNode.Scale()))
   {
     // If the query node's scale is INT_MIN and the reference map's maximum
     // scale is INT_MIN, don't try to recurse...
     if ((queryNode.Scale() == INT_MIN) &&
-       ((*referenceMap.rbegin()).first == INT_MIN))
+       (referenceSet.back().scale == INT_MIN))
       break;
 
-    // Get a reference to the current largest scale.
-    std::vector<MapEntryType>& scaleVector = (*referenceMap.rbegin()).second;
-
-    // Before traversing all the points in this scale, sort by score.
-    std::sort(scaleVector.begin(), scaleVector.end());
+    // Get the entries at the current largest scale, sorted by score.  The
+    // children of these nodes have smaller scales, so this bucket does not
+    // change while the children are added.
+    std::vector<MapEntryType>& scaleVector =
+        SortedEntries(*referenceSet.back().bucket);
 
     // Now loop over each element.
     for (size_t i = 0; i < scaleVector.size(); ++i)
     {
       // Get a reference to the current element.
-      const MapEntryType& frame = scaleVector.at(i);
+      const MapEntryType& frame = scaleVector[i];
 
       CoverTree<MetricType, RootPointPolicy, StatisticType>* refNode =
           frame.referenceNode;
@@ -276,20 +283,111 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
       // Add the children.
       for (size_t j = 0; j < refNode->NumChildren(); ++j)
       {
-//        const size_t queryIndex = queryNode.Point();
-//        const size_t refIndex = refNode->Child(j).Point();
-
         MapEntryType newFrame;
         newFrame.referenceNode = &refNode->Child(j);
         newFrame.score = score; // Use the score of the parent.
 
-        referenceMap[newFrame.referenceNode->Scale()].push_back(newFrame);
+        AddEntry(referenceSet, newFrame.referenceNode->Scale(), newFrame);
       }
     }
 
-    // Now clear the memory for this scale; it isn't needed anymore.
-    referenceMap.erase((*referenceMap.rbegin()).first);
+    // Now drop this scale; it isn't needed anymore.
+    referenceSet.pop_back();
+  }
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+typename CoverTree<MetricType, RootPointPolicy, StatisticType>::
+template DualTreeTraverser<RuleType>::ScaleBucket*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::NewBucket()
+{
+  if (usedBuckets == buckets.size())
+    buckets.push_back(new ScaleBucket());
+
+  ScaleBucket* bucket = buckets[usedBuckets++];
+  bucket->entries.clear();
+  bucket->sortedEntries.clear();
+  bucket->shared = false;
+  bucket->sorted = false;
+
+  return bucket;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+typename CoverTree<MetricType, RootPointPolicy, StatisticType>::
+template DualTreeTraverser<RuleType>::ReferenceSet&
+CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::NewSet()
+{
+  if (usedSets == sets.size())
+    sets.push_back(new ReferenceSet());
+
+  ReferenceSet& referenceSet = *sets[usedSets++];
+  referenceSet.clear();
+
+  return referenceSet;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+std::vector<DualCoverTreeMapEntry<MetricType, RootPointPolicy,
+    StatisticType> >&
+CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::SortedEntries(ScaleBucket& bucket)
+{
+  // A shared bucket is sorted into a copy, because the children of the query
+  // node may still need the entries in the order they were added.  Each child
+  // would sort the same entries the same way, so this is done once.
+  std::vector<MapEntryType>& sortedVector = bucket.shared ?
+      bucket.sortedEntries : bucket.entries;
+  if (!bucket.sorted)
+  {
+    if (bucket.shared)
+      sortedVector = bucket.entries;
+    std::sort(sortedVector.begin(), sortedVector.end());
+    bucket.sorted = true;
+  }
+
+  return sortedVector;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::AddEntry(
+    ReferenceSet& referenceSet,
+    const int scale,
+    const MapEntryType& entry)
+{
+  // Find the scale, which is usually near the end.
+  size_t index = referenceSet.size();
+  while (index > 0 && referenceSet[index - 1].scale > scale)
+    --index;
+
+  if (index == 0 || referenceSet[index - 1].scale != scale)
+  {
+    ScaleEntry scaleEntry;
+    scaleEntry.scale = scale;
+    scaleEntry.bucket = NewBucket();
+    referenceSet.insert(referenceSet.begin() + index, scaleEntry);
+  }
+  else
+  {
+    --index;
+    if (referenceSet[index].bucket->shared)
+    {
+      // Copy the shared bucket before changing it.
+      ScaleBucket* bucket = NewBucket();
+      bucket->entries = referenceSet[index].bucket->entries;
+      referenceSet[index].bucket = bucket;
+    }
   }
+
+  referenceSet[index].bucket->entries.push_back(entry);
+  referenceSet[index].bucket->sorted = false;
 }
 
 }; // namespace tree
@@ -26,29 +26,126 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/math/range.hpp>
+#include <mlpack/core/math/simd_kernels.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include "bound_traits.hpp"
 
 namespace mlpack {
 namespace bound {
 
+/**
+ * The limits of an HRectBound whose dimensionality is fixed at compile time.
+ * They are kept inside the bound itself, so there is no allocation.
+ */
+template<size_t FixedDim>
+class HRectBoundStorage
+{
+ protected:
+  //! Get the memory for the lower limits followed by the upper limits.
+  double* Local() { return values; }
+
+ private:
+  //! The lower limits followed by the upper limits.
+  double values[2 * FixedDim];
+};
+
+//! The limits of a bound whose dimensionality is known only at run time are
+//! allocated by the bound.
+template<>
+class HRectBoundStorage<0>
+{
+ protected:
+  //! There is no local memory.
+  double* Local() { return NULL; }
+};
+
 /**
  * Hyper-rectangle bound for an L-metric.  This should be used in conjunction
  * with the LMetric class.  Be sure to use the same template parameters for
  * LMetric as you do for HRectBound -- otherwise odd results may occur.
  *
+ * The lower and upper limits of the dimensions are stored in two separate
+ * arrays, and the distance calculations have no branches and no calls to pow()
+ * for the L1 and L2 metrics, so that the compiler can vectorize them (these
+ * are evaluated for every Score() of a kd-tree traversal).
+ *
  * @tparam Power The metric to use; use 2 for Euclidean (L2).
  * @tparam TakeRoot Whether or not the root should be taken (see LMetric
  *     documentation).
+ * @tparam FixedDim If nonzero, the dimensionality of the bound, known at
+ *     compile time: the limits are then stored in the bound instead of on the
+ *     heap, and the distance loops are unrolled instead of going through the
+ *     kernels of math::BoxMinSquaredDistance() and friends.  This is much
+ *     faster for 2-D and 3-D data; use it with LMetric<Power, TakeRoot,
+ *     FixedDim> (MetricType) for the point-to-point distances too.  Building a
+ *     bound of another dimensionality is a fatal error.
  */
-template<int Power = 2, bool TakeRoot = true>
-class HRectBound
+template<int Power = 2, bool TakeRoot = true, size_t FixedDim = 0>
+class HRectBound : private HRectBoundStorage<FixedDim>
 {
  public:
   //! This is the metric type that this bound is using.
-  typedef metric::LMetric<Power, TakeRoot> MetricType;
+  typedef metric::LMetric<Power, TakeRoot, FixedDim> MetricType;
+
+  /**
+   * A reference to the range of one dimension of the bound, which can be used
+   * (and assigned to) as a math::Range.
+   */
+  class RangeReference
+  {
+   public:
+    //! Refer to the given limits.
+    RangeReference(double& lo, double& hi) : lo(lo), hi(hi) { }
+
+    //! Set the range.
+    RangeReference& operator=(const math::Range& range)
+    {
+      lo = range.Lo();
+      hi = range.Hi();
+      return *this;
+    }
+
+    //! Set the range to the range of another dimension.
+    RangeReference& operator=(const RangeReference& other)
+    {
+      return (*this = math::Range(other));
+    }
+
+    //! Expand the range to include the given range.
+    RangeReference& operator|=(const math::Range& range)
+    {
+      return (*this = (math::Range(*this) | range));
+    }
+
+    //! Get the range.
+    operator math::Range() const { return math::Range(lo, hi); }
+
+    //! Get the lower limit.
+    double Lo() const { return lo; }
+    //! Modify the lower limit.
+    double& Lo() { return lo; }
+    //! Get the upper limit.
+    double Hi() const { return hi; }
+    //! Modify the upper limit.
+    double& Hi() { return hi; }
+
+    //! Get the width of the range (see math::Range::Width()).
+    double Width() const { return math::Range(lo, hi).Width(); }
+    //! Get the midpoint of the range.
+    double Mid() const { return (hi + lo) / 2; }
+    //! Determine if the range contains the given value.
+    bool Contains(const double d) const { return (lo <= d) && (hi >= d); }
+
+   private:
+    //! The lower limit.
+    double& lo;
+    //! The upper limit.
+    double& hi;
+  };
 
   /**
-   * Empty constructor; creates a bound of dimensionality 0.
+   * Empty constructor; creates a bound of dimensionality 0 (or FixedDim, with
+   * each dimension the empty set).
    */
   HRectBound();
 
@@ -73,12 +170,19 @@ class HRectBound
   void Clear();
 
   //! Gets the dimensionality.
-  size_t Dim() const { return dim; }
+  size_t Dim() const { return (FixedDim == 0) ? dim : FixedDim; }
 
-  //! Get the range for a particular dimension.  No bounds checking.
-  math::Range& operator[](const size_t i) { return bounds[i]; }
   //! Modify the range for a particular dimension.  No bounds checking.
-  const math::Range& operator[](const size_t i) const { return bounds[i]; }
+  RangeReference operator[](const size_t i)
+  { return RangeReference(lo[i], hi[i]); }
+  //! Get the range for a particular dimension.  No bounds checking.
+  math::Range operator[](const size_t i) const
+  { return math::Range(lo[i], hi[i]); }
+
+  //! Get the lower limits of the dimensions.
+  const double* Lo() const { return lo; }
+  //! Get the upper limits of the dimensions.
+  const double* Hi() const { return hi; }
 
   /**
    * Calculates the centroid of the range, placing it into the given vector.
@@ -138,7 +242,7 @@ class HRectBound
    * Expands this region to include new points.
    *
    * @tparam MatType Type of matrix; could be Mat, SpMat, a subview, or just a
-   *   vector.
+   *   vector, of any element type (such as arma::fmat).
    * @param data Data points to expand this region to include.
    */
   template<typename MatType>
@@ -170,13 +274,42 @@ class HRectBound
    * cannot store state, so we can make it on the fly.  It is also static
    * because the metric is only dependent on the template arguments.
    */
-  static MetricType Metric() { return metric::LMetric<Power, TakeRoot>(); }
+  static MetricType Metric() { return MetricType(); }
 
  private:
   //! The dimensionality of the bound.
   size_t dim;
-  //! The bounds for each dimension.
-  math::Range* bounds;
+  //! The lower limit of each dimension, followed by the upper limits (in
+  //! HRectBoundStorage if the dimensionality is fixed).
+  double* lo;
+  //! The upper limit of each dimension (in the same allocation as lo).
+  double* hi;
+
+  //! Get the memory for the limits of a bound of the given dimensionality.
+  double* Allocate(const size_t dimension);
+
+  //! Raise a nonnegative value to the power Power.
+  static double Pow(const double x);
+  //! Take the Power'th root of a nonnegative value.
+  static double Root(const double x);
+
+  //! Get the elements of a dense point, for the Euclidean kernels.
+  static const double* PointMemory(const arma::vec& point)
+  { return point.memptr(); }
+  //! Other vector types may not be contiguous, so they use the generic loops.
+  template<typename VecType>
+  static const double* PointMemory(const VecType& /* point */) { return NULL; }
+
+  //! Finish a squared Euclidean distance from the kernels.
+  static double FromSquared(const double sum)
+  { return TakeRoot ? sqrt(sum) : sum; }
+};
+
+//! The ranges of a hyperrectangle bound are exactly the ranges of its points.
+template<int Power, bool TakeRoot, size_t FixedDim>
+struct BoundTraits<HRectBound<Power, TakeRoot, FixedDim> >
+{
+  static const bool HasTightBounds = true;
 };
 
 }; // namespace bound
@@ -25,6 +25,8 @@
 #define __MLPACK_CORE_TREE_HRECTBOUND_IMPL_HPP
 
 #include <math.h>
+#include <float.h>
+#include <algorithm>
 
 // In case it has not been included yet.
 #include "hrectbound.hpp"
@@ -35,55 +37,63 @@ namespace bound {
 /**
  * Empty constructor.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>::HRectBound() :
-    dim(0),
-    bounds(NULL)
-{ /* Nothing to do. */ }
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>::HRectBound() :
+    dim(FixedDim),
+    lo(this->Local()),
+    hi(lo + FixedDim)
+{
+  // Only a bound of fixed dimensionality has anything to clear.
+  Clear();
+}
 
 /**
  * Initializes to specified dimensionality with each dimension the empty
  * set.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>::HRectBound(const size_t dimension) :
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>::HRectBound(const size_t dimension) :
     dim(dimension),
-    bounds(new math::Range[dim])
-{ /* Nothing to do. */ }
+    lo(Allocate(dimension)),
+    hi(lo + dim)
+{
+  Clear();
+}
 
 /***
  * Copy constructor necessary to prevent memory leaks.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>::HRectBound(const HRectBound& other) :
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>::HRectBound(const HRectBound& other) :
     dim(other.Dim()),
-    bounds(new math::Range[dim])
+    lo(Allocate(dim)),
+    hi(lo + dim)
 {
   // Copy other bounds over.
-  for (size_t i = 0; i < dim; i++)
-    bounds[i] = other[i];
+  std::copy(other.lo, other.lo + 2 * dim, lo);
 }
 
 /***
  * Same as the copy constructor.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator=(
-    const HRectBound& other)
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>&
+HRectBound<Power, TakeRoot, FixedDim>::operator=(const HRectBound& other)
 {
   if (dim != other.Dim())
   {
-    // Reallocation is necessary.
-    if (bounds)
-      delete[] bounds;
+    // Reallocation is necessary (this never happens for a bound of fixed
+    // dimensionality).
+    if (lo)
+      delete[] lo;
 
     dim = other.Dim();
-    bounds = new math::Range[dim];
+    lo = new double[2 * dim];
+    hi = lo + dim;
   }
 
   // Now copy each of the bound values.
-  for (size_t i = 0; i < dim; i++)
-    bounds[i] = other[i];
+  std::copy(other.lo, other.lo + 2 * dim, lo);
 
   return *this;
 }
@@ -91,21 +101,38 @@ HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator=(
 /**
  * Destructor: clean up memory.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>::~HRectBound()
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>::~HRectBound()
+{
+  if (FixedDim == 0 && lo)
+    delete[] lo;
+}
+
+/**
+ * Get the memory for the limits of a bound of the given dimensionality.
+ */
+template<int Power, bool TakeRoot, size_t FixedDim>
+double* HRectBound<Power, TakeRoot, FixedDim>::Allocate(const size_t dimension)
 {
-  if (bounds)
-    delete[] bounds;
+  if (FixedDim == 0)
+    return new double[2 * dimension];
+
+  if (dimension != FixedDim)
+    Log::Fatal << "HRectBound of fixed dimensionality " << FixedDim
+        << " cannot have dimensionality " << dimension << "." << std::endl;
+
+  return this->Local();
 }
 
 /**
  * Resets all dimensions to the empty set.
  */
-template<int Power, bool TakeRoot>
-void HRectBound<Power, TakeRoot>::Clear()
+template<int Power, bool TakeRoot, size_t FixedDim>
+void HRectBound<Power, TakeRoot, FixedDim>::Clear()
 {
-  for (size_t i = 0; i < dim; i++)
-    bounds[i] = math::Range();
+  // This is the same as math::Range().
+  std::fill(lo, lo + Dim(), DBL_MAX);
+  std::fill(hi, hi + Dim(), -DBL_MAX);
 }
 
 /***
@@ -113,38 +140,43 @@ void HRectBound<Power, TakeRoot>::Clear()
  *
  * @param centroid Vector which the centroid will be written to.
  */
-template<int Power, bool TakeRoot>
-void HRectBound<Power, TakeRoot>::Centroid(arma::vec& centroid) const
+template<int Power, bool TakeRoot, size_t FixedDim>
+void HRectBound<Power, TakeRoot, FixedDim>::Centroid(arma::vec& centroid) const
 {
   // Set size correctly if necessary.
-  if (!(centroid.n_elem == dim))
-    centroid.set_size(dim);
+  if (!(centroid.n_elem == Dim()))
+    centroid.set_size(Dim());
 
-  for (size_t i = 0; i < dim; i++)
-    centroid(i) = bounds[i].Mid();
+  for (size_t i = 0; i < Dim(); i++)
+    centroid(i) = (hi[i] + lo[i]) / 2;
 }
 
 /**
  * Calculates minimum bound-to-point squared distance.
  */
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename VecType>
-double HRectBound<Power, TakeRoot>::MinDistance(const VecType& point) const
+double HRectBound<Power, TakeRoot, FixedDim>::MinDistance(
+    const VecType& point) const
 {
   Log::Assert(point.n_elem == dim);
 
-  double sum = 0;
+  // The Euclidean case uses the kernel, which is vectorized on some targets.
+  // With a fixed dimensionality, the loop below is unrolled instead.
+  const double* p = PointMemory(point);
+  if (Power == 2 && FixedDim == 0 && p != NULL)
+    return FromSquared(math::BoxMinSquaredDistance(lo, hi, p, p, dim));
 
-  double lower, higher;
-  for (size_t d = 0; d < dim; d++)
+  double sum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    lower = bounds[d].Lo() - point[d];
-    higher = point[d] - bounds[d].Hi();
+    const double lower = lo[d] - point[d];
+    const double higher = point[d] - hi[d];
 
     // Since only one of 'lower' or 'higher' is negative, if we add each's
     // absolute value to itself and then sum those two, our result is the
     // nonnegative half of the equation times two; then we raise to power Power.
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)), (double) Power);
+    sum += Pow((lower + fabs(lower)) + (higher + fabs(higher)));
   }
 
   // Now take the Power'th root (but make sure our result is squared if it needs
@@ -152,66 +184,66 @@ double HRectBound<Power, TakeRoot>::MinDistance(const VecType& point) const
   // that was introduced earlier.  The compiler should optimize out the if
   // statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power) / 2.0;
+    return Root(sum) / 2.0;
   else
-    return sum / pow(2.0, Power);
+    return sum / Pow(2.0);
 }
 
 /**
  * Calculates minimum bound-to-bound squared distance.
  */
-template<int Power, bool TakeRoot>
-double HRectBound<Power, TakeRoot>::MinDistance(const HRectBound& other) const
+template<int Power, bool TakeRoot, size_t FixedDim>
+double HRectBound<Power, TakeRoot, FixedDim>::MinDistance(
+    const HRectBound& other) const
 {
   Log::Assert(dim == other.dim);
 
-  double sum = 0;
-  const math::Range* mbound = bounds;
-  const math::Range* obound = other.bounds;
+  if (Power == 2 && FixedDim == 0)
+    return FromSquared(math::BoxMinSquaredDistance(lo, hi, other.lo, other.hi,
+        dim));
 
-  double lower, higher;
-  for (size_t d = 0; d < dim; d++)
+  double sum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    lower = obound->Lo() - mbound->Hi();
-    higher = mbound->Lo() - obound->Hi();
+    const double lower = other.lo[d] - hi[d];
+    const double higher = lo[d] - other.hi[d];
     // We invoke the following:
     //   x + fabs(x) = max(x * 2, 0)
     //   (x * 2)^2 / 4 = x^2
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)), (double) Power);
-
-    // Move bound pointers.
-    mbound++;
-    obound++;
+    sum += Pow((lower + fabs(lower)) + (higher + fabs(higher)));
   }
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power) / 2.0;
+    return Root(sum) / 2.0;
   else
-    return sum / pow(2.0, Power);
+    return sum / Pow(2.0);
 }
 
 /**
  * Calculates maximum bound-to-point squared distance.
  */
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename VecType>
-double HRectBound<Power, TakeRoot>::MaxDistance(const VecType& point) const
+double HRectBound<Power, TakeRoot, FixedDim>::MaxDistance(
+    const VecType& point) const
 {
-  double sum = 0;
-
   Log::Assert(point.n_elem == dim);
 
-  for (size_t d = 0; d < dim; d++)
+  const double* p = PointMemory(point);
+  if (Power == 2 && FixedDim == 0 && p != NULL)
+    return FromSquared(math::BoxMaxSquaredDistance(lo, hi, p, p, dim));
+
+  double sum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    double v = std::max(fabs(point[d] - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - point[d]));
-    sum += pow(v, (double) Power);
+    const double v = std::max(fabs(point[d] - lo[d]), fabs(hi[d] - point[d]));
+    sum += Pow(v);
   }
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power);
+    return Root(sum);
   else
     return sum;
 }
@@ -219,24 +251,27 @@ double HRectBound<Power, TakeRoot>::MaxDistance(const VecType& point) const
 /**
  * Computes maximum distance.
  */
-template<int Power, bool TakeRoot>
-double HRectBound<Power, TakeRoot>::MaxDistance(const HRectBound& other) const
+template<int Power, bool TakeRoot, size_t FixedDim>
+double HRectBound<Power, TakeRoot, FixedDim>::MaxDistance(
+    const HRectBound& other) const
 {
-  double sum = 0;
-
   Log::Assert(dim == other.dim);
 
-  double v;
-  for (size_t d = 0; d < dim; d++)
+  if (Power == 2 && FixedDim == 0)
+    return FromSquared(math::BoxMaxSquaredDistance(lo, hi, other.lo, other.hi,
+        dim));
+
+  double sum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    v = std::max(fabs(other.bounds[d].Hi() - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - other.bounds[d].Lo()));
-    sum += pow(v, (double) Power); // v is non-negative.
+    const double v = std::max(fabs(other.hi[d] - lo[d]),
+        fabs(hi[d] - other.lo[d]));
+    sum += Pow(v); // v is non-negative.
   }
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power);
+    return Root(sum);
   else
     return sum;
 }
@@ -244,39 +279,27 @@ double HRectBound<Power, TakeRoot>::MaxDistance(const HRectBound& other) const
 /**
  * Calculates minimum and maximum bound-to-bound squared distance.
  */
-template<int Power, bool TakeRoot>
-math::Range HRectBound<Power, TakeRoot>::RangeDistance(const HRectBound& other)
-    const
+template<int Power, bool TakeRoot, size_t FixedDim>
+math::Range HRectBound<Power, TakeRoot, FixedDim>::RangeDistance(
+    const HRectBound& other) const
 {
-  double loSum = 0;
-  double hiSum = 0;
-
   Log::Assert(dim == other.dim);
 
-  double v1, v2, vLo, vHi;
-  for (size_t d = 0; d < dim; d++)
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    v1 = other.bounds[d].Lo() - bounds[d].Hi();
-    v2 = bounds[d].Lo() - other.bounds[d].Hi();
-    // One of v1 or v2 is negative.
-    if (v1 >= v2)
-    {
-      vHi = -v2; // Make it nonnegative.
-      vLo = (v1 > 0) ? v1 : 0; // Force to be 0 if negative.
-    }
-    else
-    {
-      vHi = -v1; // Make it nonnegative.
-      vLo = (v2 > 0) ? v2 : 0; // Force to be 0 if negative.
-    }
-
-    loSum += pow(vLo, (double) Power);
-    hiSum += pow(vHi, (double) Power);
+    // One of v1 or v2 is negative; the other (if positive) is the minimum
+    // distance, and the negated smaller one is the maximum distance.
+    const double v1 = other.lo[d] - hi[d];
+    const double v2 = lo[d] - other.hi[d];
+
+    loSum += Pow(std::max(std::max(v1, v2), 0.0));
+    hiSum += Pow(-std::min(v1, v2));
   }
 
   if (TakeRoot)
-    return math::Range(pow(loSum, 1.0 / (double) Power),
-                       pow(hiSum, 1.0 / (double) Power));
+    return math::Range(Root(loSum), Root(hiSum));
   else
     return math::Range(loSum, hiSum);
 }
@@ -284,48 +307,28 @@ math::Range HRectBound<Power, TakeRoot>::RangeDistance(const HRectBound& other)
 /**
  * Calculates minimum and maximum bound-to-point squared distance.
  */
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename VecType>
-math::Range HRectBound<Power, TakeRoot>::RangeDistance(const VecType& point)
-    const
+math::Range HRectBound<Power, TakeRoot, FixedDim>::RangeDistance(
+    const VecType& point) const
 {
-  double loSum = 0;
-  double hiSum = 0;
-
   Log::Assert(point.n_elem == dim);
 
-  double v1, v2, vLo, vHi;
-  for (size_t d = 0; d < dim; d++)
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t d = 0; d < Dim(); d++)
   {
-    v1 = bounds[d].Lo() - point[d]; // Negative if point[d] > lo.
-    v2 = point[d] - bounds[d].Hi(); // Negative if point[d] < hi.
-    // One of v1 or v2 (or both) is negative.
-    if (v1 >= 0) // point[d] <= bounds_[d].Lo().
-    {
-      vHi = -v2; // v2 will be larger but must be negated.
-      vLo = v1;
-    }
-    else // point[d] is between lo and hi, or greater than hi.
-    {
-      if (v2 >= 0)
-      {
-        vHi = -v1; // v1 will be larger, but must be negated.
-        vLo = v2;
-      }
-      else
-      {
-        vHi = -std::min(v1, v2); // Both are negative, but we need the larger.
-        vLo = 0;
-      }
-    }
-
-    loSum += pow(vLo, (double) Power);
-    hiSum += pow(vHi, (double) Power);
+    const double v1 = lo[d] - point[d]; // Negative if point[d] > lo.
+    const double v2 = point[d] - hi[d]; // Negative if point[d] < hi.
+
+    // At most one of v1 or v2 is positive, and then it is the minimum
+    // distance; the negated smaller one is the maximum distance.
+    loSum += Pow(std::max(std::max(v1, v2), 0.0));
+    hiSum += Pow(-std::min(v1, v2));
   }
 
   if (TakeRoot)
-    return math::Range(pow(loSum, 1.0 / (double) Power),
-                       pow(hiSum, 1.0 / (double) Power));
+    return math::Range(Root(loSum), Root(hiSum));
   else
     return math::Range(loSum, hiSum);
 }
@@ -333,18 +336,24 @@ math::Range HRectBound<Power, TakeRoot>::RangeDistance(const VecType& point)
 /**
  * Expands this region to include a new point.
  */
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename MatType>
-HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
-    const MatType& data)
+HRectBound<Power, TakeRoot, FixedDim>&
+HRectBound<Power, TakeRoot, FixedDim>::operator|=(const MatType& data)
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::vec mins(min(data, 1));
-  arma::vec maxs(max(data, 1));
+  // The limits are kept in double precision whatever the element type of the
+  // data is; every float is exactly representable as a double.
+  typedef typename MatType::elem_type ElemType;
+  arma::Col<ElemType> mins(min(data, 1));
+  arma::Col<ElemType> maxs(max(data, 1));
 
-  for (size_t i = 0; i < dim; i++)
-    bounds[i] |= math::Range(mins[i], maxs[i]);
+  for (size_t i = 0; i < Dim(); i++)
+  {
+    lo[i] = std::min(lo[i], (double) mins[i]);
+    hi[i] = std::max(hi[i], (double) maxs[i]);
+  }
 
   return *this;
 }
@@ -352,14 +361,17 @@ HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
 /**
  * Expands this region to encompass another bound.
  */
-template<int Power, bool TakeRoot>
-HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
-    const HRectBound& other)
+template<int Power, bool TakeRoot, size_t FixedDim>
+HRectBound<Power, TakeRoot, FixedDim>&
+HRectBound<Power, TakeRoot, FixedDim>::operator|=(const HRectBound& other)
 {
   assert(other.dim == dim);
 
-  for (size_t i = 0; i < dim; i++)
-    bounds[i] |= other.bounds[i];
+  for (size_t i = 0; i < Dim(); i++)
+  {
+    lo[i] = std::min(lo[i], other.lo[i]);
+    hi[i] = std::max(hi[i], other.hi[i]);
+  }
 
   return *this;
 }
@@ -367,13 +379,13 @@ HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
 /**
  * Determines if a point is within this bound.
  */
-template<int Power, bool TakeRoot>
+template<int Power, bool TakeRoot, size_t FixedDim>
 template<typename VecType>
-bool HRectBound<Power, TakeRoot>::Contains(const VecType& point) const
+bool HRectBound<Power, TakeRoot, FixedDim>::Contains(const VecType& point) const
 {
   for (size_t i = 0; i < point.n_elem; i++)
   {
-    if (!bounds[i].Contains(point(i)))
+    if (!(lo[i] <= point(i) && hi[i] >= point(i)))
       return false;
   }
 
@@ -383,15 +395,15 @@ bool HRectBound<Power, TakeRoot>::Contains(const VecType& point) const
 /**
  * Returns the diameter of the hyperrectangle (that is, the longest diagonal).
  */
-template<int Power, bool TakeRoot>
-double HRectBound<Power, TakeRoot>::Diameter() const
+template<int Power, bool TakeRoot, size_t FixedDim>
+double HRectBound<Power, TakeRoot, FixedDim>::Diameter() const
 {
   double d = 0;
-  for (size_t i = 0; i < dim; ++i)
-    d += std::pow(bounds[i].Hi() - bounds[i].Lo(), (double) Power);
+  for (size_t i = 0; i < Dim(); ++i)
+    d += Pow(hi[i] - lo[i]);
 
   if (TakeRoot)
-    return std::pow(d, 1.0 / (double) Power);
+    return Root(d);
   else
     return d;
 }
@@ -399,19 +411,42 @@ double HRectBound<Power, TakeRoot>::Diameter() const
 /**
  * Returns a string representation of this object.
  */
-template<int Power, bool TakeRoot>
-std::string HRectBound<Power, TakeRoot>::ToString() const
+template<int Power, bool TakeRoot, size_t FixedDim>
+std::string HRectBound<Power, TakeRoot, FixedDim>::ToString() const
 {
   std::ostringstream convert;
   convert << "HRectBound [" << this << "]" << std::endl;
-  convert << "dim: " << dim << std::endl;
+  convert << "dim: " << Dim() << std::endl;
   convert << "bounds: " << std::endl;
-  for (size_t i = 0; i < dim; ++i)
-    convert << util::Indent(bounds[i].ToString()) << std::endl;
+  for (size_t i = 0; i < Dim(); ++i)
+    convert << util::Indent((*this)[i].ToString()) << std::endl;
 
   return convert.str();
 }
 
+// The compiler should optimize out these if statements entirely.
+template<int Power, bool TakeRoot, size_t FixedDim>
+inline double HRectBound<Power, TakeRoot, FixedDim>::Pow(const double x)
+{
+  if (Power == 1)
+    return x;
+  else if (Power == 2)
+    return x * x;
+  else
+    return pow(x, (double) Power);
+}
+
+template<int Power, bool TakeRoot, size_t FixedDim>
+inline double HRectBound<Power, TakeRoot, FixedDim>::Root(const double x)
+{
+  if (Power == 1)
+    return x;
+  else if (Power == 2)
+    return sqrt(x);
+  else
+    return pow(x, 1.0 / (double) Power);
+}
+
 }; // namespace bound
 }; // namespace mlpack
 
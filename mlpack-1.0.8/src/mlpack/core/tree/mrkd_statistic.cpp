@@ -30,7 +30,10 @@ MRKDStatistic::MRKDStatistic() :
     count(0),
     leftStat(NULL),
     rightStat(NULL),
-    parentStat(NULL)
+    parentStat(NULL),
+    sumOfSquaredNorms(0.0),
+    dominatingCentroid(0),
+    isWhitelistValid(false)
 { }
 
 /**
@@ -59,17 +59,24 @@ class MRKDStatistic
   //! Modify the number of items in the dataset.
   size_t& Count() { return count; }
 
-  //! Get the center of mass.
+  //! Get the (unnormalized) center of mass; this is the sum of the points, so
+  //! divide by Count() to get the actual center of mass.
   const arma::colvec& CenterOfMass() const { return centerOfMass; }
-  //! Modify the center of mass.
+  //! Modify the (unnormalized) center of mass.
   arma::colvec& CenterOfMass() { return centerOfMass; }
 
+  //! Get the sum of the squared Euclidean norms of the points.
+  double SumOfSquaredNorms() const { return sumOfSquaredNorms; }
+  //! Modify the sum of the squared Euclidean norms of the points.
+  double& SumOfSquaredNorms() { return sumOfSquaredNorms; }
+
   //! Get the index of the dominating centroid.
   size_t DominatingCentroid() const { return dominatingCentroid; }
   //! Modify the index of the dominating centroid.
   size_t& DominatingCentroid() { return dominatingCentroid; }
 
-  //! Access the whitelist.
+  //! Access the whitelist (the indices of the centroids which may still own
+  //! points in this node).
   const std::vector<size_t>& Whitelist() const { return whitelist; }
   //! Modify the whitelist.
   std::vector<size_t>& Whitelist() { return whitelist; }
@@ -89,7 +96,7 @@ class MRKDStatistic
   const MRKDStatistic* parentStat;
 
   // Computed statistics.
-  //! The center of mass for this dataset.
+  //! The (unnormalized) center of mass for this dataset.
   arma::colvec centerOfMass;
   //! The sum of the squared Euclidean norms for this dataset.
   double sumOfSquaredNorms;
@@ -98,7 +105,7 @@ class MRKDStatistic
   //! The index of the dominating centroid of the associated hyperrectangle.
   size_t dominatingCentroid;
 
-  //! The list of centroids that cannot own this hyperrectangle.
+  //! The list of centroids that may own points in this hyperrectangle.
   std::vector<size_t> whitelist;
   //! Whether or not the whitelist is valid.
   bool isWhitelistValid;
@@ -28,15 +28,45 @@
 namespace mlpack {
 namespace tree {
 
+/**
+ * This constructor is called when a node is finished initializing, after its
+ * children (if any) have been built.  For a leaf, the statistics are calculated
+ * from the points; otherwise, they are combined from the statistics of the
+ * children.
+ */
 template<typename TreeType>
-MRKDStatistic::MRKDStatistic(const TreeType& /* node */) :
-    dataset(NULL),
-    begin(0),
-    count(0),
+MRKDStatistic::MRKDStatistic(const TreeType& node) :
+    dataset(&node.Dataset()),
+    begin(node.Begin()),
+    count(node.Count()),
     leftStat(NULL),
     rightStat(NULL),
-    parentStat(NULL)
-{ }
+    parentStat(NULL),
+    sumOfSquaredNorms(0.0),
+    dominatingCentroid(0),
+    isWhitelistValid(false)
+{
+  centerOfMass.zeros(node.Dataset().n_rows);
+
+  if (node.NumChildren() == 0)
+  {
+    for (size_t i = begin; i < begin + count; ++i)
+    {
+      centerOfMass += node.Dataset().col(i);
+      sumOfSquaredNorms += arma::dot(node.Dataset().col(i),
+          node.Dataset().col(i));
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      const MRKDStatistic& childStat = node.Child(i).Stat();
+      centerOfMass += childStat.centerOfMass;
+      sumOfSquaredNorms += childStat.sumOfSquaredNorms;
+    }
+  }
+}
 
 /**
  * This constructor is called when a leaf is created.
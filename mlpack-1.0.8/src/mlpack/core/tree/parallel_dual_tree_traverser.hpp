@@ -0,0 +1,171 @@
+/**
+ * @file parallel_dual_tree_traverser.hpp
+ *
+ * A dual-tree traverser which splits the query tree into independent subtrees
+ * and traverses them in parallel with OpenMP.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include "tree_traits.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A parallel wrapper around the dual-tree traverser of a tree type.  The top
+ * levels of the query tree are split into a set of disjoint subtrees (several
+ * per thread, splitting the largest subtree first), and each subtree is
+ * traversed against the whole reference tree by its own
+ * TreeType::DualTreeTraverser and its own copy of the rules.  The subtrees are
+ * handed out to threads dynamically, so threads that finish early pick up the
+ * remaining work.
+ *
+ * This gives the same results as a serial traversal as long as the rules only
+ * modify state that belongs to the query points and query nodes they are
+ * given, which is the case for NeighborSearchRules and RangeSearchRules with
+ * BinarySpaceTree.  Therefore, RuleType must be copy-constructible, and the
+ * copies must share their output (for instance, by holding references to the
+ * result matrices).
+ *
+ * Trees whose children share points with their parents
+ * (TreeTraits::HasSelfChildren) or whose rules cache base cases in reference
+ * nodes (TreeTraits::FirstPointIsCentroid), such as the cover tree, cannot be
+ * split this way; for those, the traversal is done serially.  The traversal is
+ * also serial if MLPACK was not compiled with OpenMP.
+ *
+ * If a ProgressMonitor is given, the query tree is split into at least
+ * MonitorBatches subtrees even for one thread, and the monitor is called after
+ * each subtree with the number of subtrees traversed and the fraction of the
+ * query points they hold.  Once it returns false, the remaining subtrees are
+ * not traversed.  (Trees which cannot be split are traversed in one piece.)
+ *
+ * The interface is the same as TreeType::DualTreeTraverser, so it can be used
+ * in its place:
+ *
+ * @code
+ * ParallelDualTreeTraverser<TreeType, RuleType> traverser(rules);
+ * traverser.Traverse(*queryTree, *referenceTree);
+ * @endcode
+ *
+ * @tparam TreeType Type of tree to traverse.
+ * @tparam RuleType Type of rules to traverse with.
+ */
+template<typename TreeType, typename RuleType>
+class ParallelDualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the parallel dual-tree traverser with the given rule set and
+   * number of threads.
+   *
+   * @param rule Rules to traverse with; each query subtree uses a copy.
+   * @param threads Number of threads to use; 0 means all available cores.
+   * @param monitor Monitor of the progress of the traversal (may be NULL).
+   * @param task Name of the traversal given to the monitor.
+   */
+  ParallelDualTreeTraverser(RuleType& rule,
+                            const size_t threads = 0,
+                            ProgressMonitor* monitor = NULL,
+                            const std::string& task = "dual-tree traversal");
+
+  //! The number of subtrees the query tree is split into when there is a
+  //! monitor.
+  static const size_t MonitorBatches = 64;
+
+  /**
+   * Traverse the two trees.  This does not reset the number of prunes.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(TreeType& queryNode, TreeType& referenceNode);
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 means all available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of visited combinations.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of visited combinations.
+  size_t& NumVisited() { return numVisited; }
+
+  //! Get the number of times a node combination was scored.
+  size_t NumScores() const { return numScores; }
+  //! Modify the number of times a node combination was scored.
+  size_t& NumScores() { return numScores; }
+
+  //! Get the number of times a base case was calculated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of times a base case was calculated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+  /**
+   * Split the query tree into disjoint subtrees which together hold every
+   * query point.  The largest subtree is split until there are at least the
+   * given number of subtrees, or until only leaves are left.
+   *
+   * @param queryNode Root of the query tree.
+   * @param minSubtrees Number of subtrees to aim for.
+   * @param subtrees Vector to store the subtrees in.
+   */
+  static void SplitQueryTree(TreeType& queryNode,
+                             const size_t minSubtrees,
+                             std::vector<TreeType*>& subtrees);
+
+ private:
+
+  //! Reference to the rules with which the trees will be traversed.
+  RuleType& rule;
+
+  //! The number of threads to use.
+  size_t threads;
+
+  //! The monitor of the progress of the traversal (may be NULL).
+  ProgressMonitor* monitor;
+
+  //! The name of the traversal given to the monitor.
+  std::string task;
+
+  //! The number of prunes.
+  size_t numPrunes;
+
+  //! The number of node combinations that have been visited during traversal.
+  size_t numVisited;
+
+  //! The number of times a node combination was scored.
+  size_t numScores;
+
+  //! The number of times a base case was calculated.
+  size_t numBaseCases;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "parallel_dual_tree_traverser_impl.hpp"
+
+#endif // __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_HPP
@@ -0,0 +1,185 @@
+/**
+ * @file parallel_dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the ParallelDualTreeTraverser class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_dual_tree_traverser.hpp"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType>
+ParallelDualTreeTraverser<TreeType, RuleType>::ParallelDualTreeTraverser(
+    RuleType& rule,
+    const size_t threads,
+    ProgressMonitor* monitor,
+    const std::string& task) :
+    rule(rule),
+    threads(threads),
+    monitor(monitor),
+    task(task),
+    numPrunes(0),
+    numVisited(0),
+    numScores(0),
+    numBaseCases(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType>
+void ParallelDualTreeTraverser<TreeType, RuleType>::Traverse(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  size_t numThreads = Threads::Count(threads);
+
+  // Query subtrees can only be traversed independently if they do not share
+  // points, and if the rules do not cache anything in the reference tree.
+  if (TreeTraits<TreeType>::HasSelfChildren ||
+      TreeTraits<TreeType>::FirstPointIsCentroid)
+    numThreads = 1;
+
+  // A few subtrees per thread, so that the load can be balanced; with a
+  // monitor, enough subtrees that it is called regularly.
+  size_t minSubtrees = (numThreads == 1) ? 1 : 8 * numThreads;
+  if (monitor && !TreeTraits<TreeType>::HasSelfChildren)
+    minSubtrees = std::max(minSubtrees, (size_t) MonitorBatches);
+
+  std::vector<TreeType*> subtrees;
+  SplitQueryTree(queryNode, minSubtrees, subtrees);
+
+  if (subtrees.size() == 1)
+  {
+    // Nothing to parallelize.
+    typename TreeType::template DualTreeTraverser<RuleType> traverser(rule);
+    traverser.Traverse(queryNode, referenceNode);
+
+    numPrunes += traverser.NumPrunes();
+    numVisited += traverser.NumVisited();
+    numScores += traverser.NumScores();
+    numBaseCases += traverser.NumBaseCases();
+
+    if (monitor)
+      monitor->Continue(task, 1, 1.0);
+    return;
+  }
+
+  size_t prunes = 0;
+  size_t visited = 0;
+  size_t scores = 0;
+  size_t baseCases = 0;
+
+  // The progress reported to the monitor.
+  size_t subtreesDone = 0;
+  size_t pointsDone = 0;
+
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1) \
+      reduction(+:prunes, visited, scores, baseCases)
+  for (int i = 0; i < (int) subtrees.size(); ++i)
+  {
+    // Once the monitor has stopped the traversal, skip the other subtrees.
+    if (monitor)
+    {
+      bool stopped;
+      #pragma omp critical(progress_monitor)
+      stopped = monitor->Stopped();
+      if (stopped)
+        continue;
+    }
+
+    // Each subtree gets its own rules, so any cached state in the rules is not
+    // shared between threads.
+    RuleType subtreeRule(rule);
+    typename TreeType::template DualTreeTraverser<RuleType>
+        traverser(subtreeRule);
+    traverser.Traverse(*subtrees[i], referenceNode);
+
+    prunes += traverser.NumPrunes();
+    visited += traverser.NumVisited();
+    scores += traverser.NumScores();
+    baseCases += traverser.NumBaseCases();
+
+    if (monitor)
+    {
+      #pragma omp critical(progress_monitor)
+      {
+        ++subtreesDone;
+        pointsDone += subtrees[i]->NumDescendants();
+        monitor->Continue(task, subtreesDone,
+            (double) pointsDone / queryNode.NumDescendants());
+      }
+    }
+  }
+
+  numPrunes += prunes;
+  numVisited += visited;
+  numScores += scores;
+  numBaseCases += baseCases;
+}
+
+template<typename TreeType, typename RuleType>
+void ParallelDualTreeTraverser<TreeType, RuleType>::SplitQueryTree(
+    TreeType& queryNode,
+    const size_t minSubtrees,
+    std::vector<TreeType*>& subtrees)
+{
+  subtrees.clear();
+  subtrees.push_back(&queryNode);
+
+  while (subtrees.size() < minSubtrees)
+  {
+    // Find the largest subtree that can still be split.
+    size_t largest = subtrees.size();
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (subtrees[i]->NumChildren() == 0)
+        continue;
+
+      if ((largest == subtrees.size()) || (subtrees[i]->NumDescendants() >
+          subtrees[largest]->NumDescendants()))
+        largest = i;
+    }
+
+    // Only leaves are left.
+    if (largest == subtrees.size())
+      break;
+
+    // Replace the subtree with its children.  The node itself may not hold any
+    // points of its own, or they would be lost.
+    TreeType* node = subtrees[largest];
+    if (node->NumPoints() != 0)
+      break;
+
+    subtrees[largest] = &node->Child(0);
+    for (size_t i = 1; i < node->NumChildren(); ++i)
+      subtrees.push_back(&node->Child(i));
+  }
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_PARALLEL_DUAL_TREE_TRAVERSER_IMPL_HPP
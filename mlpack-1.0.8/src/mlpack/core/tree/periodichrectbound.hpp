@@ -19,35 +19,59 @@
  * details (LICENSE.txt).
  *
  * You should have received a copy of the GNU General Public License along with
- * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
- */
 #ifndef __MLPACK_CORE_TREE_PERIODICHRECTBOUND_HPP
 #define __MLPACK_CORE_TREE_PERIODICHRECTBOUND_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/metrics/periodic_lmetric.hpp>
+
+#include "bound_traits.hpp"
 
 namespace mlpack {
 namespace bound {
 
 /**
- * Hyper-rectangle bound for an L-metric.
+ * Hyper-rectangle bound for an L-metric in a box with periodic boundaries.  It
+ * should be used in conjunction with the PeriodicLMetric class, with the same
+ * template parameters and the same box.
+ *
+ * The ranges of the dimensions are not wrapped into the box (so the bound of a
+ * set of points is the same as the HRectBound of the points), but the distances
+ * to other bounds and to points are the distances to their nearest periodic
+ * images.  A dimension with a box size of 0 is not periodic.
  *
- * Template parameter t_pow is the metric to use; use 2 for Euclidean (L2).
+ * Trees create the bounds of their nodes from the dimensionality of the data
+ * only, so the box of every node of a tree is set with SetPeriodicBox() (or
+ * SetTreeMetric()) once the tree is built; NeighborSearch and RangeSearch do
+ * this for the trees they build.
+ *
+ * @tparam Power The metric to use; use 2 for Euclidean (L2).
+ * @tparam TakeRoot Whether or not the root should be taken (see LMetric
+ *     documentation).
  */
-template<int t_pow = 2>
+template<int Power = 2, bool TakeRoot = true>
 class PeriodicHRectBound
 {
  public:
+  //! This is the metric type that this bound is using.
+  typedef metric::PeriodicLMetric<Power, TakeRoot> MetricType;
+
   /**
-   * Empty constructor.
+   * Empty constructor; creates a bound of dimensionality 0.
    */
   PeriodicHRectBound();
 
+  /**
+   * Initializes to the specified dimensionality with each dimension the empty
+   * set; no dimension is periodic until the box is set with SetBoxSize().
+   */
+  PeriodicHRectBound(const size_t dimension);
+
   /**
    * Specifies the box size.  The dimensionality is set to the same of the box
    * size, and the bounds are initialized to be empty.
    */
-  PeriodicHRectBound(arma::vec box);
+  PeriodicHRectBound(const arma::vec& box);
 
   /***
    * Copy constructor and copy operator.  These are necessary because we do our
@@ -62,9 +86,10 @@ class PeriodicHRectBound
   ~PeriodicHRectBound();
 
   /**
-   * Modifies the box to the desired dimenstions.
+   * Modifies the box to the desired dimensions.  The box must have the same
+   * dimensionality as the bound.
    */
-  void SetBoxSize(arma::vec box);
+  void SetBoxSize(const arma::vec& box);
 
   /**
    * Returns the box vector.
@@ -82,8 +107,8 @@ class PeriodicHRectBound
   /**
    * Sets and gets the range for a particular dimension.
    */
-  math::Range& operator[](size_t i);
-  const math::Range operator[](size_t i) const;
+  math::Range& operator[](const size_t i) { return bounds[i]; }
+  math::Range operator[](const size_t i) const { return bounds[i]; }
 
   /***
    * Calculates the centroid of the range.  This does not factor in periodic
@@ -94,47 +119,62 @@ class PeriodicHRectBound
   void Centroid(arma::vec& centroid) const;
 
   /**
-   * Calculates minimum bound-to-point squared distance in the periodic bound
-   * case.
+   * Calculates minimum bound-to-point distance in the periodic bound case.
+   *
+   * @param point Point to which the minimum distance is requested.
    */
-  double MinDistance(const arma::vec& point) const;
+  template<typename VecType>
+  double MinDistance(const VecType& point) const;
 
   /**
-   * Calculates minimum bound-to-bound squared distance in the periodic bound
-   * case.
+   * Calculates minimum bound-to-bound distance in the periodic bound case.
    *
-   * Example: bound1.MinDistance(other) for minimum squared distance.
+   * @param other Bound to which the minimum distance is requested.
    */
   double MinDistance(const PeriodicHRectBound& other) const;
 
   /**
-   * Calculates maximum bound-to-point squared distance in the periodic bound
-   * case.
+   * Calculates maximum bound-to-point distance in the periodic bound case.
+   *
+   * @param point Point to which the maximum distance is requested.
    */
-  double MaxDistance(const arma::vec& point) const;
+  template<typename VecType>
+  double MaxDistance(const VecType& point) const;
 
   /**
-   * Computes maximum bound-to-bound squared distance in the periodic bound
-   * case.
+   * Computes maximum bound-to-bound distance in the periodic bound case.
+   *
+   * @param other Bound to which the maximum distance is requested.
    */
   double MaxDistance(const PeriodicHRectBound& other) const;
 
   /**
-   * Calculates minimum and maximum bound-to-point squared distance in the
-   * periodic bound case.
+   * Calculates minimum and maximum bound-to-point distance in the periodic
+   * bound case.
+   *
+   * @param point Point to which the minimum and maximum distances are
+   *     requested.
    */
-  math::Range RangeDistance(const arma::vec& point) const;
+  template<typename VecType>
+  math::Range RangeDistance(const VecType& point) const;
 
   /**
-   * Calculates minimum and maximum bound-to-bound squared distance in the
-   * periodic bound case.
+   * Calculates minimum and maximum bound-to-bound distance in the periodic
+   * bound case.
+   *
+   * @param other Bound to which the minimum and maximum distances are
+   *     requested.
    */
   math::Range RangeDistance(const PeriodicHRectBound& other) const;
 
   /**
-   * Expands this region to include a new point.
+   * Expands this region to include new points.
+   *
+   * @tparam MatType Type of matrix; could be Mat, a subview, or just a vector.
+   * @param data Data points to expand this region to include.
    */
-  PeriodicHRectBound& operator|=(const arma::vec& vector);
+  template<typename MatType>
+  PeriodicHRectBound& operator|=(const MatType& data);
 
   /**
    * Expands this region to encompass another bound.
@@ -144,19 +184,91 @@ class PeriodicHRectBound
   /**
    * Determines if a point is within this bound.
    */
-  bool Contains(const arma::vec& point) const;
+  template<typename VecType>
+  bool Contains(const VecType& point) const;
+
+  /**
+   * Returns the diameter of the hyperrectangle (that is, the longest diagonal),
+   * where no dimension is counted as longer than the box.
+   */
+  double Diameter() const;
 
   /**
    * Returns a string representation of an object.
    */
   std::string ToString() const;
 
+  /**
+   * Return the metric associated with this bound; it uses the same box.
+   */
+  MetricType Metric() const { return MetricType(box); }
+
  private:
   math::Range *bounds;
   size_t dim;
   arma::vec box;
+
+  /**
+   * Return the smallest and largest distance (to the nearest periodic image)
+   * between two coordinates whose difference lies in the given interval.
+   *
+   * @param lo Smallest difference.
+   * @param hi Largest difference.
+   * @param size Size of the box in the dimension (0 if it is not periodic).
+   */
+  static math::Range DifferenceRange(const double lo,
+                                     const double hi,
+                                     const double size);
+
+  //! Raise a nonnegative value to the power Power.
+  static double Pow(const double x);
+  //! Take the Power'th root of a nonnegative value.
+  static double Root(const double x);
 };
 
+//! The ranges of a hyperrectangle bound are exactly the ranges of its points.
+template<int Power, bool TakeRoot>
+struct BoundTraits<PeriodicHRectBound<Power, TakeRoot> >
+{
+  static const bool HasTightBounds = true;
+};
+
+/**
+ * Set the box of the PeriodicHRectBound of every node of the given tree (and
+ * so the box used by the tree's distance calculations).
+ *
+ * @param node Root of the tree.
+ * @param box Size of the box in each dimension (0 for a dimension which is not
+ *     periodic).
+ */
+template<typename TreeType>
+void SetPeriodicBox(TreeType& node, const arma::vec& box)
+{
+  node.Bound().SetBoxSize(box);
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    SetPeriodicBox(node.Child(i), box);
+}
+
+/**
+ * Prepare the bounds of a tree for search with the given metric.  Only the
+ * bounds of a tree for a periodic metric need anything (the box of the
+ * metric), so for any other metric this does nothing.  Searches which build
+ * their own trees call this once the trees are built.
+ *
+ * @param tree Root of the tree.
+ * @param metric Metric which the tree will be searched with.
+ */
+template<typename TreeType, typename MetricType>
+void SetTreeMetric(TreeType& /* tree */, const MetricType& /* metric */) { }
+
+//! The bounds of a tree for a periodic metric take the box of the metric.
+template<typename TreeType, int Power, bool TakeRoot>
+void SetTreeMetric(TreeType& tree,
+                   const metric::PeriodicLMetric<Power, TakeRoot>& metric)
+{
+  SetPeriodicBox(tree, metric.Box());
+}
+
 }; // namespace bound
 }; // namespace mlpack
 
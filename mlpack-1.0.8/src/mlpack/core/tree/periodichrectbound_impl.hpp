@@ -2,7 +2,7 @@
  * @file periodichrectbound_impl.hpp
  *
  * Implementation of periodic hyper-rectangle bound policy class.
- * Template parameter t_pow is the metric to use; use 2 for Euclidian (L2).
+ * Template parameter Power is the metric to use; use 2 for Euclidean (L2).
  *
  * This file is part of MLPACK 1.0.8.
  *
@@ -33,44 +33,70 @@ namespace bound {
 /**
  * Empty constructor
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>::PeriodicHRectBound() :
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>::PeriodicHRectBound() :
       bounds(NULL),
       dim(0),
       box(/* empty */)
 { /* nothing to do */ }
 
 /**
- * Specifies the box size, but not dimensionality.
+ * Initializes to the specified dimensionality, with no periodic dimensions.
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>::PeriodicHRectBound(arma::vec box) :
-      bounds(new math::Range[box.n_rows]),
-      dim(box.n_rows),
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>::PeriodicHRectBound(
+    const size_t dimension) :
+      bounds(new math::Range[dimension]),
+      dim(dimension),
+      box(arma::zeros<arma::vec>(dimension))
+{ /* nothing to do */ }
+
+/**
+ * Specifies the box size, and the dimensionality with it.
+ */
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>::PeriodicHRectBound(const arma::vec& box) :
+      bounds(new math::Range[box.n_elem]),
+      dim(box.n_elem),
       box(box)
 { /* nothing to do */ }
 
 /***
  * Copy constructor.
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>::PeriodicHRectBound(const PeriodicHRectBound& other) :
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>::PeriodicHRectBound(
+    const PeriodicHRectBound& other) :
+      bounds(new math::Range[other.Dim()]),
       dim(other.Dim()),
       box(other.Box())
 {
-  bounds = new math::Range[other.Dim()];
   for (size_t i = 0; i < dim; i++)
-    bounds[i] |= other[i];
+    bounds[i] = other.bounds[i];
 }
 
 /***
  * Copy operator.
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator=(
-    const PeriodicHRectBound& other)
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>&
+PeriodicHRectBound<Power, TakeRoot>::operator=(const PeriodicHRectBound& other)
 {
-  // not done yet
+  if (this == &other)
+    return *this;
+
+  if (dim != other.Dim())
+  {
+    if (bounds)
+      delete[] bounds;
+
+    dim = other.Dim();
+    bounds = new math::Range[dim];
+  }
+
+  for (size_t i = 0; i < dim; i++)
+    bounds[i] = other.bounds[i];
+  box = other.Box();
 
   return *this;
 }
@@ -78,53 +104,37 @@ PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator=(
 /**
  * Destructor: clean up memory
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>::~PeriodicHRectBound()
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>::~PeriodicHRectBound()
 {
   if (bounds)
     delete[] bounds;
 }
 
 /**
- * Modifies the box to the desired dimenstions.
+ * Modifies the box to the desired dimensions.
  */
-template<int t_pow>
-void PeriodicHRectBound<t_pow>::SetBoxSize(arma::vec box)
+template<int Power, bool TakeRoot>
+void PeriodicHRectBound<Power, TakeRoot>::SetBoxSize(const arma::vec& box)
 {
-  box = box;
+  Log::Assert(box.n_elem == dim);
+
+  this->box = box;
 }
 
 /**
  * Resets all dimensions to the empty set.
  */
-template<int t_pow>
-void PeriodicHRectBound<t_pow>::Clear()
+template<int Power, bool TakeRoot>
+void PeriodicHRectBound<Power, TakeRoot>::Clear()
 {
   for (size_t i = 0; i < dim; i++)
     bounds[i] = math::Range();
 }
 
-/**
- * Gets the range for a particular dimension.
- */
-template<int t_pow>
-const math::Range PeriodicHRectBound<t_pow>::operator[](size_t i) const
-{
-  return bounds[i];
-}
-
-/**
- * Sets the range for the given dimension.
- */
-template<int t_pow>
-math::Range& PeriodicHRectBound<t_pow>::operator[](size_t i)
-{
-  return bounds[i];
-}
-
 /** Calculates the midpoint of the range */
-template<int t_pow>
-void PeriodicHRectBound<t_pow>::Centroid(arma::vec& centroid) const
+template<int Power, bool TakeRoot>
+void PeriodicHRectBound<Power, TakeRoot>::Centroid(arma::vec& centroid) const
 {
   // set size correctly if necessary
   if (!(centroid.n_elem == dim))
@@ -135,419 +145,143 @@ void PeriodicHRectBound<t_pow>::Centroid(arma::vec& centroid) const
 }
 
 /**
- * Calculates minimum bound-to-point squared distance.
- *
+ * Calculates minimum bound-to-point distance.
  */
-
-template<int t_pow>
-double PeriodicHRectBound<t_pow>::MinDistance(const arma::vec& point) const
+template<int Power, bool TakeRoot>
+template<typename VecType>
+double PeriodicHRectBound<Power, TakeRoot>::MinDistance(
+    const VecType& point) const
 {
-  arma::vec point2 = point;
-  double totalMin = 0;
-  // Create the mirrored images. The minimum distance from the bound to a
-  // mirrored point is the minimum periodic distance.
-  arma::vec box = box;
-  for (int i = 0; i < dim; i++)
-  {
-    point2 = point;
-    double min = 100000000;
-    // Mod the point within the box.
-
-    if (box[i] < 0)
-    {
-      box[i] = abs(box[i]);
-    }
-    if (box[i] != 0)
-    {
-      if (abs(point[i]) > box[i])
-      {
-        point2[i] = fmod(point2[i],box[i]);
-      }
-    }
-
-    for (int k = 0; k < 3; k++)
-    {
-      arma::vec point3 = point2;
-
-      if (k == 1)
-        point3[i] += box[i];
-      else if (k == 2)
-        point3[i] -= box[i];
-
-      double tempMin;
-      double sum = 0;
-
-      double lower, higher;
-      lower = bounds[i].Lo() - point3[i];
-      higher = point3[i] - bounds[i].Hi();
-
-      sum += pow((lower + fabs(lower)) +
-          (higher + fabs(higher)), (double) t_pow);
-      tempMin = pow(sum, 2.0 / (double) t_pow) / 4.0;
-
-      if (tempMin < min)
-        min = tempMin;
-    }
-
-    totalMin += min;
-  }
-  return totalMin;
+  Log::Assert(point.n_elem == dim);
 
+  double sum = 0;
+  for (size_t i = 0; i < dim; i++)
+    sum += Pow(DifferenceRange(bounds[i].Lo() - point[i],
+        bounds[i].Hi() - point[i], box[i]).Lo());
+
+  return TakeRoot ? Root(sum) : sum;
 }
 
 /**
- * Calculates minimum bound-to-bound squared distance.
- *
- * Example: bound1.MinDistance(other) for minimum squared distance.
+ * Calculates minimum bound-to-bound distance.
  */
-template<int t_pow>
-double PeriodicHRectBound<t_pow>::MinDistance(
+template<int Power, bool TakeRoot>
+double PeriodicHRectBound<Power, TakeRoot>::MinDistance(
     const PeriodicHRectBound& other) const
 {
-  double totalMin = 0;
-  // Create the mirrored images. The minimum distance from the bound to a
-  // mirrored point is the minimum periodic distance.
-  arma::vec box = box;
-  PeriodicHRectBound<2> a(other);
+  Log::Assert(dim == other.dim);
 
-  for (int i = 0; i < dim; i++)
-  {
-    double min = DBL_MAX;
-    if (box[i] < 0)
-      box[i] = abs(box[i]);
-
-    if (box[i] != 0)
-    {
-      if (abs(other[i].Lo()) > box[i])
-        a[i].Lo() = fmod(a[i].Lo(),box[i]);
-
-      if (abs(other[i].Hi()) > box[i])
-        a[i].Hi() = fmod(a[i].Hi(),box[i]);
-    }
-
-    for (int k = 0; k < 3; k++)
-    {
-      PeriodicHRectBound<2> b = a;
-      if (k == 1)
-      {
-        b[i].Lo() += box[i];
-        b[i].Hi() += box[i];
-      }
-      else if (k == 2)
-      {
-        b[i].Lo() -= box[i];
-        b[i].Hi() -= box[i];
-      }
-
-      double sum = 0;
-      double tempMin;
-      double sumLower = 0;
-      double sumHigher = 0;
-
-      double lower, higher, lowerLower, lowerHigher, higherLower,
-              higherHigher;
-
-      // If the bound crosses over the box, split ito two seperate bounds and
-      // find the minimum distance between them.
-      if (b[i].Hi() < b[i].Lo())
-      {
-        PeriodicHRectBound<2> d(b);
-        PeriodicHRectBound<2> c(b);
-        d[i].Lo() = 0;
-        c[i].Hi() = box[i];
-
-        if (k == 1)
-        {
-          d[i].Lo() += box[i];
-          c[i].Hi() += box[i];
-        }
-        else if (k == 2)
-        {
-          d[i].Lo() -= box[i];
-          c[i].Hi() -= box[i];
-        }
-
-        d[i].Hi() = b[i].Hi();
-        c[i].Lo() = b[i].Lo();
-
-        lowerLower = d[i].Lo() - bounds[i].Hi();
-        higherLower = bounds[i].Lo() - d[i].Hi();
-
-        lowerHigher = c[i].Lo() - bounds[i].Hi();
-        higherHigher = bounds[i].Lo() - c[i].Hi();
-
-        sumLower += pow((lowerLower + fabs(lowerLower)) +
-                         (higherLower + fabs(higherLower)), (double) t_pow);
-
-        sumHigher += pow((lowerHigher + fabs(lowerHigher)) +
-                          (higherHigher + fabs(higherHigher)), (double) t_pow);
-
-        if (sumLower > sumHigher)
-          tempMin = pow(sumHigher, 2.0 / (double) t_pow) / 4.0;
-        else
-          tempMin = pow(sumLower, 2.0 / (double) t_pow) / 4.0;
-      }
-      else
-      {
-        lower = b[i].Lo() - bounds[i].Hi();
-        higher = bounds[i].Lo() - b[i].Hi();
-        // We invoke the following:
-        //   x + fabs(x) = max(x * 2, 0)
-        //   (x * 2)^2 / 4 = x^2
-        sum += pow((lower + fabs(lower)) +
-            (higher + fabs(higher)), (double) t_pow);
-        tempMin = pow(sum, 2.0 / (double) t_pow) / 4.0;
-      }
-
-      if (tempMin < min)
-        min = tempMin;
-    }
-    totalMin += min;
-  }
-  return totalMin;
-}
+  double sum = 0;
+  for (size_t i = 0; i < dim; i++)
+    sum += Pow(DifferenceRange(other.bounds[i].Lo() - bounds[i].Hi(),
+        other.bounds[i].Hi() - bounds[i].Lo(), box[i]).Lo());
 
+  return TakeRoot ? Root(sum) : sum;
+}
 
 /**
- * Calculates maximum bound-to-point squared distance.
+ * Calculates maximum bound-to-point distance.
  */
-template<int t_pow>
-double PeriodicHRectBound<t_pow>::MaxDistance(const arma::vec& point) const
+template<int Power, bool TakeRoot>
+template<typename VecType>
+double PeriodicHRectBound<Power, TakeRoot>::MaxDistance(
+    const VecType& point) const
 {
-  arma::vec point2 = point;
-  double totalMax = 0;
-  //Create the mirrored images. The minimum distance from the bound to a
-  //mirrored point is the minimum periodic distance.
-  arma::vec box = box;
-  for (int i = 0; i < dim; i++)
-  {
-    point2 = point;
-    double max = 0;
-    // Mod the point within the box.
-
-    if (box[i] < 0)
-      box[i] = abs(box[i]);
-
-    if (box[i] != 0)
-      if (abs(point[i]) > box[i])
-        point2[i] = fmod(point2[i],box[i]);
-
-    for (int k = 0; k < 3; k++)
-    {
-      arma::vec point3 = point2;
-
-      if (k == 1)
-        point3[i] += box[i];
-      else if (k == 2)
-        point3[i] -= box[i];
-
-      double tempMax;
-      double sum = 0;
-
-      double v = std::max(fabs(point3[i] - bounds[i].Lo()),
-          fabs(bounds[i].Hi() - point3[i]));
-      sum += pow(v, (double) t_pow);
-
-      tempMax = pow(sum, 2.0 / (double) t_pow) / 4.0;
-
-      if (tempMax > max)
-        max = tempMax;
-    }
+  Log::Assert(point.n_elem == dim);
 
-    totalMax += max;
-  }
-  return totalMax;
+  double sum = 0;
+  for (size_t i = 0; i < dim; i++)
+    sum += Pow(DifferenceRange(bounds[i].Lo() - point[i],
+        bounds[i].Hi() - point[i], box[i]).Hi());
 
+  return TakeRoot ? Root(sum) : sum;
 }
 
 /**
- * Computes maximum distance.
+ * Computes maximum bound-to-bound distance.
  */
-template<int t_pow>
-double PeriodicHRectBound<t_pow>::MaxDistance(
+template<int Power, bool TakeRoot>
+double PeriodicHRectBound<Power, TakeRoot>::MaxDistance(
     const PeriodicHRectBound& other) const
 {
-  double totalMax = 0;
-  //Create the mirrored images. The minimum distance from the bound to a
-  //mirrored point is the minimum periodic distance.
-  arma::vec box = box;
-  PeriodicHRectBound<2> a(other);
+  Log::Assert(dim == other.dim);
 
+  double sum = 0;
+  for (size_t i = 0; i < dim; i++)
+    sum += Pow(DifferenceRange(other.bounds[i].Lo() - bounds[i].Hi(),
+        other.bounds[i].Hi() - bounds[i].Lo(), box[i]).Hi());
 
-  for (int i = 0; i < dim; i++)
-  {
-    double max = 0;
-    if (box[i] < 0)
-      box[i] = abs(box[i]);
-
-    if (box[i] != 0)
-    {
-      if (abs(other[i].Lo()) > box[i])
-        a[i].Lo() = fmod(a[i].Lo(),box[i]);
-
-      if (abs(other[i].Hi()) > box[i])
-        a[i].Hi() = fmod(a[i].Hi(),box[i]);
-    }
-
-    for (int k = 0; k < 3; k++)
-    {
-      PeriodicHRectBound<2> b = a;
-      if (k == 1)
-      {
-        b[i].Lo() += box[i];
-        b[i].Hi() += box[i];
-      }
-      else if (k == 2)
-      {
-        b[i].Lo() -= box[i];
-        b[i].Hi() -= box[i];
-      }
-
-      double sum = 0;
-      double tempMax;
-
-      double sumLower = 0, sumHigher = 0;
-
-
-      // If the bound corsses over the box, split ito two seperate bounds and
-      // find thhe minimum distance between them.
-      if (b[i].Hi() < b[i].Lo())
-      {
-        PeriodicHRectBound<2> d(b);
-        PeriodicHRectBound<2> c(b);
-        a[i].Lo() = 0;
-        c[i].Hi() = box[i];
-
-        if (k == 1)
-        {
-          d[i].Lo() += box[i];
-          c[i].Hi() += box[i];
-        }
-        else if (k == 2)
-        {
-          d[i].Lo() -= box[i];
-          c[i].Hi() -= box[i];
-        }
-
-        d[i].Hi() = b[i].Hi();
-        c[i].Lo() = b[i].Lo();
-
-        double vLower = std::max(fabs(d.bounds[i].Hi() - bounds[i].Lo()),
-            fabs(bounds[i].Hi() - d.bounds[i].Lo()));
-
-        double vHigher = std::max(fabs(c.bounds[i].Hi() - bounds[i].Lo()),
-            fabs(bounds[i].Hi() - c.bounds[i].Lo()));
-
-        sumLower += pow(vLower, (double) t_pow);
-        sumHigher += pow(vHigher, (double) t_pow);
-
-        if (sumLower > sumHigher)
-          tempMax = pow(sumHigher, 2.0 / (double) t_pow) / 4.0;
-        else
-          tempMax = pow(sumLower, 2.0 / (double) t_pow) / 4.0;
-      }
-      else
-      {
-        double v = std::max(fabs(b.bounds[i].Hi() - bounds[i].Lo()),
-            fabs(bounds[i].Hi() - b.bounds[i].Lo()));
-        sum += pow(v, (double) t_pow); // v is non-negative.
-        tempMax = pow(sum, 2.0 / (double) t_pow);
-      }
-
-
-      if (tempMax > max)
-        max = tempMax;
-    }
-    totalMax += max;
-  }
-  return totalMax;
+  return TakeRoot ? Root(sum) : sum;
 }
 
 /**
- * Calculates minimum and maximum bound-to-point squared distance.
+ * Calculates minimum and maximum bound-to-point distance.
  */
-template<int t_pow>
-math::Range PeriodicHRectBound<t_pow>::RangeDistance(
-    const arma::vec& point) const
+template<int Power, bool TakeRoot>
+template<typename VecType>
+math::Range PeriodicHRectBound<Power, TakeRoot>::RangeDistance(
+    const VecType& point) const
 {
-  double sum_lo = 0;
-  double sum_hi = 0;
-
   Log::Assert(point.n_elem == dim);
 
-  double v1, v2, v_lo, v_hi;
-  for (size_t d = 0; d < dim; d++)
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t i = 0; i < dim; i++)
   {
-    v1 = bounds[d].Lo() - point[d];
-    v2 = point[d] - bounds[d].Hi();
-    // One of v1 or v2 is negative.
-    if (v1 >= 0)
-    {
-      v_hi = -v2;
-      v_lo = v1;
-    }
-    else
-    {
-      v_hi = -v1;
-      v_lo = v2;
-    }
-
-    sum_lo += pow(v_lo, (double) t_pow);
-    sum_hi += pow(v_hi, (double) t_pow);
+    const math::Range range = DifferenceRange(bounds[i].Lo() - point[i],
+        bounds[i].Hi() - point[i], box[i]);
+    loSum += Pow(range.Lo());
+    hiSum += Pow(range.Hi());
   }
 
-  return math::Range(pow(sum_lo, 2.0 / (double) t_pow),
-      pow(sum_hi, 2.0 / (double) t_pow));
+  if (TakeRoot)
+    return math::Range(Root(loSum), Root(hiSum));
+  else
+    return math::Range(loSum, hiSum);
 }
 
 /**
- * Calculates minimum and maximum bound-to-bound squared distance.
+ * Calculates minimum and maximum bound-to-bound distance.
  */
-template<int t_pow>
-math::Range PeriodicHRectBound<t_pow>::RangeDistance(
+template<int Power, bool TakeRoot>
+math::Range PeriodicHRectBound<Power, TakeRoot>::RangeDistance(
     const PeriodicHRectBound& other) const
 {
-  double sum_lo = 0;
-  double sum_hi = 0;
-
   Log::Assert(dim == other.dim);
 
-  double v1, v2, v_lo, v_hi;
-  for (size_t d = 0; d < dim; d++)
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t i = 0; i < dim; i++)
   {
-    v1 = other.bounds[d].Lo() - bounds[d].Hi();
-    v2 = bounds[d].Lo() - other.bounds[d].Hi();
-    // One of v1 or v2 is negative.
-    if (v1 >= v2)
-    {
-      v_hi = -v2; // Make it nonnegative.
-      v_lo = (v1 > 0) ? v1 : 0; // Force to be 0 if negative.
-    }
-    else
-    {
-      v_hi = -v1; // Make it nonnegative.
-      v_lo = (v2 > 0) ? v2 : 0; // Force to be 0 if negative.
-    }
-
-    sum_lo += pow(v_lo, (double) t_pow);
-    sum_hi += pow(v_hi, (double) t_pow);
+    const math::Range range = DifferenceRange(
+        other.bounds[i].Lo() - bounds[i].Hi(),
+        other.bounds[i].Hi() - bounds[i].Lo(), box[i]);
+    loSum += Pow(range.Lo());
+    hiSum += Pow(range.Hi());
   }
 
-  return math::Range(pow(sum_lo, 2.0 / (double) t_pow),
-      pow(sum_hi, 2.0 / (double) t_pow));
+  if (TakeRoot)
+    return math::Range(Root(loSum), Root(hiSum));
+  else
+    return math::Range(loSum, hiSum);
 }
 
 /**
- * Expands this region to include a new point.
+ * Expands this region to include new points.
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator|=(
-    const arma::vec& vector)
+template<int Power, bool TakeRoot>
+template<typename MatType>
+PeriodicHRectBound<Power, TakeRoot>&
+PeriodicHRectBound<Power, TakeRoot>::operator|=(const MatType& data)
 {
-  Log::Assert(vector.n_elem == dim);
+  Log::Assert(data.n_rows == dim);
+
+  typedef typename MatType::elem_type ElemType;
+  arma::Col<ElemType> mins(min(data, 1));
+  arma::Col<ElemType> maxs(max(data, 1));
 
   for (size_t i = 0; i < dim; i++)
-    bounds[i] |= vector[i];
+    bounds[i] |= math::Range((double) mins[i], (double) maxs[i]);
 
   return *this;
 }
@@ -555,9 +289,9 @@ PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator|=(
 /**
  * Expands this region to encompass another bound.
  */
-template<int t_pow>
-PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator|=(
-    const PeriodicHRectBound& other)
+template<int Power, bool TakeRoot>
+PeriodicHRectBound<Power, TakeRoot>&
+PeriodicHRectBound<Power, TakeRoot>::operator|=(const PeriodicHRectBound& other)
 {
   Log::Assert(other.dim == dim);
 
@@ -570,8 +304,9 @@ PeriodicHRectBound<t_pow>& PeriodicHRectBound<t_pow>::operator|=(
 /**
  * Determines if a point is within this bound.
  */
-template<int t_pow>
-bool PeriodicHRectBound<t_pow>::Contains(const arma::vec& point) const
+template<int Power, bool TakeRoot>
+template<typename VecType>
+bool PeriodicHRectBound<Power, TakeRoot>::Contains(const VecType& point) const
 {
   for (size_t i = 0; i < point.n_elem; i++)
     if (!bounds[i].Contains(point(i)))
@@ -580,20 +315,102 @@ bool PeriodicHRectBound<t_pow>::Contains(const arma::vec& point) const
   return true;
 }
 
+/**
+ * Returns the diameter of the hyperrectangle.  No two points are further apart
+ * than the box in a periodic dimension.
+ */
+template<int Power, bool TakeRoot>
+double PeriodicHRectBound<Power, TakeRoot>::Diameter() const
+{
+  double d = 0;
+  for (size_t i = 0; i < dim; ++i)
+  {
+    const double width = bounds[i].Width();
+    d += Pow((box[i] > 0.0) ? std::min(width, box[i]) : width);
+  }
+
+  return TakeRoot ? Root(d) : d;
+}
+
 /**
  * Returns a string representation of this object.
  */
-template<int t_pow>
-std::string PeriodicHRectBound<t_pow>::ToString() const
+template<int Power, bool TakeRoot>
+std::string PeriodicHRectBound<Power, TakeRoot>::ToString() const
 {
   std::ostringstream convert;
   convert << "PeriodicHRectBound [" << this << "]" << std::endl;
-  convert << "bounds: " << bounds->ToString() << std::endl;
   convert << "dim: " << dim << std::endl;
+  convert << "bounds: " << std::endl;
+  for (size_t i = 0; i < dim; ++i)
+    convert << util::Indent(bounds[i].ToString()) << std::endl;
   convert << "box: " << box;
   return convert.str();
 }
 
+/**
+ * The distance between two coordinates is a triangle wave of their difference
+ * (0 at every multiple of the box size, and half the box size halfway between),
+ * so over an interval of differences it is smallest at a multiple of the box
+ * size or an end of the interval, and largest halfway between two multiples or
+ * at an end of the interval.
+ */
+template<int Power, bool TakeRoot>
+math::Range PeriodicHRectBound<Power, TakeRoot>::DifferenceRange(
+    const double lo,
+    const double hi,
+    const double size)
+{
+  if (size <= 0.0)
+  {
+    const double minimum = (lo > 0.0) ? lo : ((hi < 0.0) ? -hi : 0.0);
+    return math::Range(minimum, std::max(fabs(lo), fabs(hi)));
+  }
+
+  const double half = size / 2.0;
+  if (hi - lo >= size)
+    return math::Range(0.0, half);
+
+  // Shift the interval so that it starts in [0, size); it then ends before
+  // 2 * size.
+  const double start = lo - size * floor(lo / size);
+  const double end = start + (hi - lo);
+
+  const double atLo = metric::PeriodicLMetric<Power, TakeRoot>::MinimumImage(lo,
+      size);
+  const double atHi = metric::PeriodicLMetric<Power, TakeRoot>::MinimumImage(hi,
+      size);
+
+  const double minimum = (start <= 0.0 || end >= size) ? 0.0 :
+      std::min(atLo, atHi);
+  const double maximum = ((start <= half && end >= half) || end >= 3 * half) ?
+      half : std::max(atLo, atHi);
+
+  return math::Range(minimum, maximum);
+}
+
+template<int Power, bool TakeRoot>
+inline double PeriodicHRectBound<Power, TakeRoot>::Pow(const double x)
+{
+  if (Power == 1)
+    return x;
+  else if (Power == 2)
+    return x * x;
+  else
+    return pow(x, (double) Power);
+}
+
+template<int Power, bool TakeRoot>
+inline double PeriodicHRectBound<Power, TakeRoot>::Root(const double x)
+{
+  if (Power == 1)
+    return x;
+  else if (Power == 2)
+    return sqrt(x);
+  else
+    return pow(x, 1.0 / (double) Power);
+}
+
 }; // namespace bound
 }; // namespace mlpack
 
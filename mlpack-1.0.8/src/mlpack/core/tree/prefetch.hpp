@@ -0,0 +1,122 @@
+/**
+ * @file prefetch.hpp
+ *
+ * Software prefetching of tree nodes: a traversal can ask the processor to
+ * start loading the bounds and the first points of the nodes it is about to
+ * score, so that those loads overlap instead of stalling one after another.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_PREFETCH_HPP
+#define __MLPACK_CORE_TREE_PREFETCH_HPP
+
+#include <mlpack/core.hpp>
+#include "bounds.hpp"
+
+namespace mlpack {
+namespace tree {
+
+//! The largest number of bytes prefetched from one array (the bound limits or
+//! the points of a leaf); only the start of a large array is prefetched.
+const size_t maxPrefetchBytes = 256;
+
+/**
+ * Ask the processor to start loading the cache line holding the given address.
+ * This is only a hint: it never faults, even on invalid addresses, and it does
+ * nothing on compilers without a prefetch intrinsic.
+ */
+inline void Prefetch(const void* address)
+{
+#if defined(__GNUC__)
+  __builtin_prefetch(address, 0, 3);
+#else
+  (void) address;
+#endif
+}
+
+//! Prefetch the given number of bytes starting at the given address (at most
+//! maxPrefetchBytes), one cache line at a time.
+inline void Prefetch(const void* address, const size_t bytes)
+{
+  const char* start = (const char*) address;
+  const size_t end = std::min(bytes, maxPrefetchBytes);
+  for (size_t offset = 0; offset < end; offset += 64)
+    Prefetch(start + offset);
+}
+
+//! Most bounds are held entirely in the node, so there is nothing else to
+//! prefetch.
+template<typename BoundType>
+inline void PrefetchBound(const BoundType& /* bound */) { }
+
+//! Prefetch the limits of a hyperrectangle bound, which may be on the heap.
+template<int Power, bool TakeRoot, size_t FixedDim>
+inline void PrefetchBound(
+    const bound::HRectBound<Power, TakeRoot, FixedDim>& bound)
+{
+  if (FixedDim == 0)
+  {
+    Prefetch(bound.Lo(), bound.Dim() * sizeof(double));
+    Prefetch(bound.Hi(), bound.Dim() * sizeof(double));
+  }
+}
+
+//! Prefetch the center of a ball bound.
+template<typename VecType, typename MetricType>
+inline void PrefetchBound(const bound::BallBound<VecType, MetricType>& bound)
+{
+  Prefetch(bound.Center().memptr(),
+      bound.Center().n_elem * sizeof(typename VecType::elem_type));
+}
+
+//! Prefetch the first points of the given contiguous range of columns.
+template<typename eT>
+inline void PrefetchPoints(const arma::Mat<eT>& data,
+                           const size_t begin,
+                           const size_t count)
+{
+  if (count > 0)
+    Prefetch(data.colptr(begin), count * data.n_rows * sizeof(eT));
+}
+
+//! The points of a sparse matrix are not stored by column, so they are not
+//! prefetched.
+template<typename eT>
+inline void PrefetchPoints(const arma::SpMat<eT>& /* data */,
+                           const size_t /* begin */,
+                           const size_t /* count */) { }
+
+/**
+ * Prefetch the given node of a BinarySpaceTree ahead of a traversal scoring
+ * it: the node itself, the memory of its bound, and, if it is a leaf, the first
+ * cache lines of its points (which the base cases will read next).  Prefetching
+ * all the children a traversal is about to score lets their loads overlap.
+ *
+ * @param node Node to prefetch.
+ */
+template<typename TreeType>
+inline void PrefetchNode(const TreeType& node)
+{
+  Prefetch(&node, sizeof(TreeType));
+  PrefetchBound(node.Bound());
+  if (node.IsLeaf())
+    PrefetchPoints(node.Dataset(), node.Begin(), node.Count());
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
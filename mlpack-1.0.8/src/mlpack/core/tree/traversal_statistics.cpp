@@ -0,0 +1,233 @@
+/**
+ * @file traversal_statistics.cpp
+ *
+ * Implementation of the per-thread traversal counters.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "traversal_statistics.hpp"
+
+#if defined(MLPACK_PERF_COUNTERS) && defined(__linux__)
+  #include <cstring>
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #define MLPACK_USE_PERF_EVENTS
+#endif
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+namespace {
+
+//! The counters of one thread.
+struct ThreadCounts
+{
+  ThreadCounts()
+  {
+    counts.baseCases = counts.scores = counts.rescores = counts.prunes = 0;
+    counts.cycles = counts.cacheMisses = 0;
+    cyclesFd = cacheMissesFd = -1;
+    cyclesStart = cacheMissesStart = 0;
+  }
+
+  //! The counts of the thread.
+  TraversalCounts counts;
+  //! The perf_event_open() descriptors of the thread (-1 if unused).
+  int cyclesFd, cacheMissesFd;
+  //! The hardware counters when the current traversal was started.
+  uint64_t cyclesStart, cacheMissesStart;
+};
+
+/**
+ * The counters of every thread that has counted anything.  These are never
+ * freed, so that they may be used until the program exits.
+ */
+std::vector<ThreadCounts*>& AllCounts()
+{
+  static std::vector<ThreadCounts*>* allCounts =
+      new std::vector<ThreadCounts*>();
+  return *allCounts;
+}
+
+#ifdef MLPACK_USE_PERF_EVENTS
+//! Open a hardware counter for the calling thread.
+int OpenCounter(const uint64_t config)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+//! Read a hardware counter (0 if it is not open).
+uint64_t ReadCounter(const int fd)
+{
+  uint64_t value = 0;
+  if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value))
+    return 0;
+  return value;
+}
+#endif
+
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+//! The counters of the calling thread.
+ThreadCounts* localCounts = NULL;
+#pragma omp threadprivate(localCounts)
+#endif
+
+}; // anonymous namespace
+
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+TraversalCounts& TraversalStatistics::Local()
+{
+  if (localCounts == NULL)
+  {
+    localCounts = new ThreadCounts();
+#ifdef MLPACK_USE_PERF_EVENTS
+    // The counters start at zero, so a thread which first counts during a
+    // traversal is measured from then on.
+    localCounts->cyclesFd = OpenCounter(PERF_COUNT_HW_CPU_CYCLES);
+    localCounts->cacheMissesFd = OpenCounter(PERF_COUNT_HW_CACHE_MISSES);
+#endif
+
+    #pragma omp critical(mlpack_traversal_statistics)
+    AllCounts().push_back(localCounts);
+  }
+
+  return localCounts->counts;
+}
+
+void TraversalStatistics::Score(const size_t level)
+{
+  TraversalCounts& counts = Local();
+  ++counts.scores;
+  if (level >= counts.visitsPerLevel.size())
+    counts.visitsPerLevel.resize(level + 1, 0);
+  ++counts.visitsPerLevel[level];
+}
+
+void TraversalStatistics::Start()
+{
+  Reset();
+
+  // Make sure the calling thread is counted, then remember where the hardware
+  // counters of each thread were.
+  Local();
+#ifdef MLPACK_USE_PERF_EVENTS
+  #pragma omp critical(mlpack_traversal_statistics)
+  {
+    std::vector<ThreadCounts*>& allCounts = AllCounts();
+    for (size_t i = 0; i < allCounts.size(); ++i)
+    {
+      allCounts[i]->cyclesStart = ReadCounter(allCounts[i]->cyclesFd);
+      allCounts[i]->cacheMissesStart =
+          ReadCounter(allCounts[i]->cacheMissesFd);
+    }
+  }
+#endif
+}
+
+void TraversalStatistics::Stop()
+{
+#ifdef MLPACK_USE_PERF_EVENTS
+  #pragma omp critical(mlpack_traversal_statistics)
+  {
+    std::vector<ThreadCounts*>& allCounts = AllCounts();
+    for (size_t i = 0; i < allCounts.size(); ++i)
+    {
+      ThreadCounts& t = *allCounts[i];
+      t.counts.cycles += ReadCounter(t.cyclesFd) - t.cyclesStart;
+      t.counts.cacheMisses += ReadCounter(t.cacheMissesFd) -
+          t.cacheMissesStart;
+      t.cyclesStart = ReadCounter(t.cyclesFd);
+      t.cacheMissesStart = ReadCounter(t.cacheMissesFd);
+    }
+  }
+#endif
+
+  Print(Get());
+}
+#endif
+
+TraversalCounts TraversalStatistics::Get()
+{
+  TraversalCounts total;
+  total.baseCases = total.scores = total.rescores = total.prunes = 0;
+  total.cycles = total.cacheMisses = 0;
+
+  #pragma omp critical(mlpack_traversal_statistics)
+  {
+    std::vector<ThreadCounts*>& allCounts = AllCounts();
+    for (size_t i = 0; i < allCounts.size(); ++i)
+    {
+      const TraversalCounts& counts = allCounts[i]->counts;
+      total.baseCases += counts.baseCases;
+      total.scores += counts.scores;
+      total.rescores += counts.rescores;
+      total.prunes += counts.prunes;
+      total.cycles += counts.cycles;
+      total.cacheMisses += counts.cacheMisses;
+
+      if (counts.visitsPerLevel.size() > total.visitsPerLevel.size())
+        total.visitsPerLevel.resize(counts.visitsPerLevel.size(), 0);
+      for (size_t j = 0; j < counts.visitsPerLevel.size(); ++j)
+        total.visitsPerLevel[j] += counts.visitsPerLevel[j];
+    }
+  }
+
+  return total;
+}
+
+void TraversalStatistics::Reset()
+{
+  #pragma omp critical(mlpack_traversal_statistics)
+  {
+    std::vector<ThreadCounts*>& allCounts = AllCounts();
+    for (size_t i = 0; i < allCounts.size(); ++i)
+    {
+      TraversalCounts& counts = allCounts[i]->counts;
+      counts.baseCases = counts.scores = counts.rescores = counts.prunes = 0;
+      counts.cycles = counts.cacheMisses = 0;
+      counts.visitsPerLevel.clear();
+    }
+  }
+}
+
+void TraversalStatistics::Print(const TraversalCounts& counts)
+{
+  Log::Info << "Traversal statistics: " << counts.baseCases << " base cases, "
+      << counts.scores << " scores, " << counts.rescores << " rescores, "
+      << counts.prunes << " prunes." << std::endl;
+
+  if (!counts.visitsPerLevel.empty())
+  {
+    Log::Info << "Reference nodes scored at each depth:";
+    for (size_t i = 0; i < counts.visitsPerLevel.size(); ++i)
+      Log::Info << " " << counts.visitsPerLevel[i];
+    Log::Info << "." << std::endl;
+  }
+
+#ifdef MLPACK_USE_PERF_EVENTS
+  Log::Info << "Hardware counters: " << counts.cycles << " cycles, "
+      << counts.cacheMisses << " cache misses." << std::endl;
+#endif
+}
@@ -0,0 +1,223 @@
+/**
+ * @file traversal_statistics.hpp
+ *
+ * Opt-in counting of the work done by tree traversals.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+#define __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+#include <stdint.h>
+
+namespace mlpack {
+namespace tree {
+
+//! The work done by tree traversals, summed over all threads.
+struct TraversalCounts
+{
+  //! The number of base cases calculated.
+  uint64_t baseCases;
+  //! The number of times a node (or node combination) was scored.
+  uint64_t scores;
+  //! The number of times a score was re-evaluated.
+  uint64_t rescores;
+  //! The number of scores and rescores that pruned a node.
+  uint64_t prunes;
+  //! The number of reference nodes scored at each depth (0 is the root).
+  std::vector<uint64_t> visitsPerLevel;
+  //! CPU cycles spent in traversals (only counted with MLPACK_PERF_COUNTERS).
+  uint64_t cycles;
+  //! Cache misses in traversals (only counted with MLPACK_PERF_COUNTERS).
+  uint64_t cacheMisses;
+};
+
+/**
+ * Counters of the work done by the tree traversals of NeighborSearch,
+ * RangeSearch, RASearch, FastMKS, and DualTreeBoruvka, for tuning leaf sizes
+ * and tree types.  Counting is enabled at compile time with
+ * MLPACK_TRAVERSAL_STATISTICS (the TRAVERSAL_STATISTICS CMake option); without
+ * it, every function here is empty and the rules of each method are used
+ * directly, so there is no cost at all.  With MLPACK_PERF_COUNTERS as well
+ * (the PERF_COUNTERS CMake option; Linux only), the CPU cycles and cache
+ * misses of each thread during traversals are also counted, with
+ * perf_event_open().
+ *
+ * Each thread counts into its own counters, which are summed by Get(); the
+ * rules are wrapped in InstrumentedRules, which does the counting, and each
+ * method calls Start() and Stop() around its traversal (Stop() also prints the
+ * counts of that traversal with Log::Info).
+ */
+class TraversalStatistics
+{
+ public:
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+  //! Whether traversals are counted.
+  static const bool Enabled = true;
+
+  //! Count a base case.
+  static void BaseCase() { ++Local().baseCases; }
+  //! Count a score of a reference node at the given depth.
+  static void Score(const size_t level);
+  //! Count a rescore.
+  static void Rescore() { ++Local().rescores; }
+  //! Count a prune.
+  static void Prune() { ++Local().prunes; }
+
+  //! Reset the counts, and start counting a traversal (and its hardware
+  //! counters).
+  static void Start();
+  //! Stop counting a traversal, and print what it did with Log::Info.
+  static void Stop();
+#else
+  //! Whether traversals are counted.
+  static const bool Enabled = false;
+
+  static void BaseCase() { }
+  static void Score(const size_t /* level */) { }
+  static void Rescore() { }
+  static void Prune() { }
+  static void Start() { }
+  static void Stop() { }
+#endif
+
+  //! Get the counts since the last Start() or Reset(), summed over all
+  //! threads.  This should not be called during a traversal.
+  static TraversalCounts Get();
+
+  //! Reset all the counts to zero.
+  static void Reset();
+
+  //! Print the given counts with Log::Info.
+  static void Print(const TraversalCounts& counts);
+
+ private:
+  //! Get the counts of the calling thread.
+  static TraversalCounts& Local();
+};
+
+/**
+ * A wrapper around a RuleType which counts each base case, score, rescore,
+ * and prune in TraversalStatistics before handing the call to the rules.
+ * Everything else the rules provide is inherited.
+ */
+template<typename RuleType>
+class InstrumentedRules : public RuleType
+{
+ public:
+  //! Wrap a copy of the given rules.
+  InstrumentedRules(const RuleType& rules) : RuleType(rules) { }
+
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex)
+  {
+    TraversalStatistics::BaseCase();
+    return RuleType::BaseCase(queryIndex, referenceIndex);
+  }
+
+  template<typename TreeType>
+  double Score(const size_t queryIndex, TreeType& referenceNode)
+  {
+    return Count(RuleType::Score(queryIndex, referenceNode), referenceNode);
+  }
+
+  template<typename TreeType>
+  double Score(const size_t queryIndex,
+               TreeType& referenceNode,
+               const double baseCaseResult)
+  {
+    return Count(RuleType::Score(queryIndex, referenceNode, baseCaseResult),
+        referenceNode);
+  }
+
+  template<typename TreeType>
+  double Score(TreeType& queryNode, TreeType& referenceNode)
+  {
+    return Count(RuleType::Score(queryNode, referenceNode), referenceNode);
+  }
+
+  template<typename TreeType>
+  double Score(TreeType& queryNode,
+               TreeType& referenceNode,
+               const double baseCaseResult)
+  {
+    return Count(RuleType::Score(queryNode, referenceNode, baseCaseResult),
+        referenceNode);
+  }
+
+  template<typename TreeType>
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    return CountRescore(RuleType::Rescore(queryIndex, referenceNode,
+        oldScore));
+  }
+
+  template<typename TreeType>
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    return CountRescore(RuleType::Rescore(queryNode, referenceNode,
+        oldScore));
+  }
+
+ private:
+  //! Count a score of the given reference node.
+  template<typename TreeType>
+  static double Count(const double score, const TreeType& referenceNode)
+  {
+    size_t level = 0;
+    for (const TreeType* node = referenceNode.Parent(); node != NULL;
+         node = node->Parent())
+      ++level;
+
+    TraversalStatistics::Score(level);
+    if (score == DBL_MAX)
+      TraversalStatistics::Prune();
+    return score;
+  }
+
+  //! Count a rescore.
+  static double CountRescore(const double score)
+  {
+    TraversalStatistics::Rescore();
+    if (score == DBL_MAX)
+      TraversalStatistics::Prune();
+    return score;
+  }
+};
+
+/**
+ * The rules a method should traverse with: InstrumentedRules<RuleType> if
+ * traversals are counted, and RuleType itself otherwise.
+ */
+template<typename RuleType>
+struct TraversalRules
+{
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+  typedef InstrumentedRules<RuleType> Type;
+#else
+  typedef RuleType Type;
+#endif
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
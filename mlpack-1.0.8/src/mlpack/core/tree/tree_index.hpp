@@ -0,0 +1,179 @@
+/**
+ * @file tree_index.hpp
+ *
+ * Definition of the TreeIndex class, which saves a built BinarySpaceTree and
+ * its dataset to a binary file that can later be memory-mapped.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_TREE_INDEX_HPP
+#define __MLPACK_CORE_TREE_TREE_INDEX_HPP
+
+#include <mlpack/core.hpp>
+#include "binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A tree together with the (reordered) dataset it was built on and the mapping
+ * from new point indices to old point indices.  A TreeIndex can be saved to a
+ * binary file once and loaded again later much faster than the tree can be
+ * rebuilt: the node bounds are stored, so loading does not look at the points
+ * at all, and on POSIX systems the dataset is memory-mapped read-only instead
+ * of being read.
+ *
+ * @code
+ * // Build once and save.
+ * TreeIndex<TreeType> index(referenceData, 20);
+ * index.Save("reference.idx");
+ *
+ * // Later, load and search.
+ * TreeIndex<TreeType> loaded("reference.idx");
+ * AllkNN allknn(&loaded.Tree(), loaded.Dataset());
+ * allknn.Search(k, neighbors, distances);
+ *
+ * // Neighbor indices refer to the reordered dataset; map them back with
+ * // loaded.OldFromNew() (see neighbor::Unmap()).
+ * @endcode
+ *
+ * The file stores, in host byte order: a header, the dataset (column-major),
+ * the old-from-new mapping, and one record for each node in depth-first order
+ * (begin, count, split dimension, whether the node has children, and the
+ * bound).  The dataset of a loaded index must not be modified.  Statistics are
+ * not stored, but constructed again when the index is loaded.
+ *
+ * Currently TreeType must be a BinarySpaceTree with an HRectBound.
+ *
+ * @tparam TreeType Type of tree to index.
+ */
+template<typename TreeType>
+class TreeIndex
+{
+ public:
+  /**
+   * Build a tree on the given dataset.  The dataset is reordered in place and
+   * must outlive the index.  A leaf size can be given in place of the build
+   * options.
+   *
+   * @param data Dataset to build the tree on.  This will be modified!
+   * @param options Options for building the tree (see BuildOptions).
+   */
+  TreeIndex(typename TreeType::Mat& data,
+            const BuildOptions& options = BuildOptions());
+
+  /**
+   * Load an index that was saved with Save().  If the file cannot be opened or
+   * is not a valid index, a fatal error is given.
+   *
+   * @param filename File to load.
+   */
+  TreeIndex(const std::string& filename);
+
+  /**
+   * Delete the tree, and unmap the file if the index was loaded.
+   */
+  ~TreeIndex();
+
+  /**
+   * Save the index to the given file.  If the file cannot be written, a fatal
+   * error is given.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
+
+  //! Get the root of the tree.
+  const TreeType& Tree() const { return *tree; }
+  //! Modify the root of the tree.
+  TreeType& Tree() { return *tree; }
+
+  //! Get the (reordered) dataset the tree is built on.
+  const typename TreeType::Mat& Dataset() const { return *dataset; }
+
+  //! Get the mapping from point indices in Dataset() to the indices in the
+  //! original dataset.
+  const std::vector<size_t>& OldFromNew() const { return oldFromNew; }
+
+ private:
+  //! The dataset; either given by the user or aliasing the loaded file.
+  typename TreeType::Mat* dataset;
+  //! Whether or not we allocated the dataset object.
+  bool ownsDataset;
+  //! The mapping from new point indices to old point indices.
+  std::vector<size_t> oldFromNew;
+  //! The root of the tree.
+  TreeType* tree;
+
+  //! The contents of the loaded file (NULL if the index was built).
+  char* buffer;
+  //! The size of the loaded file.
+  size_t bufferSize;
+  //! Whether or not buffer was memory-mapped (as opposed to allocated).
+  bool mapped;
+
+  /**
+   * Recursively write the records of the given node and its descendants.
+   */
+  void SaveNode(std::ostream& stream, const TreeType& node) const;
+
+  /**
+   * Recursively create a node and its descendants from the records, starting
+   * at the given one.
+   *
+   * @param records Start of the node records.
+   * @param recordSize Size of each node record, in bytes.
+   * @param numRecords Total number of records.
+   * @param next Index of the record to read; incremented for each node read.
+   * @param parent Parent of the node.
+   * @param leafSize Leaf size of the tree.
+   */
+  TreeType* LoadNode(const char* records,
+                     const size_t recordSize,
+                     const size_t numRecords,
+                     size_t& next,
+                     TreeType* parent,
+                     const size_t leafSize);
+
+  /**
+   * Create a node (without children) from its saved range of points and
+   * bound.  The template parameters are deduced from the parent pointer.
+   */
+  template<typename BoundType, typename StatisticType, typename MatType>
+  static BinarySpaceTree<BoundType, StatisticType, MatType>* NewNode(
+      MatType& data,
+      const size_t begin,
+      const size_t count,
+      const arma::mat& ranges,
+      const size_t splitDimension,
+      BinarySpaceTree<BoundType, StatisticType, MatType>* parent,
+      const size_t leafSize);
+
+  /**
+   * Build the statistic of a node whose children have been attached.
+   */
+  template<typename BoundType, typename StatisticType, typename MatType>
+  static void BuildStatistic(
+      BinarySpaceTree<BoundType, StatisticType, MatType>& node);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "tree_index_impl.hpp"
+
+#endif
@@ -0,0 +1,339 @@
+/**
+ * @file tree_index_impl.hpp
+ *
+ * Implementation of the TreeIndex class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_TREE_INDEX_IMPL_HPP
+#define __MLPACK_CORE_TREE_TREE_INDEX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "tree_index.hpp"
+
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace tree {
+
+// Layout of the header: an 8-byte magic string followed by these fields, each
+// a 64-bit unsigned integer.
+enum TreeIndexHeaderField
+{
+  TREE_INDEX_VERSION = 0,
+  TREE_INDEX_DIMENSIONALITY,
+  TREE_INDEX_POINTS,
+  TREE_INDEX_NODES,
+  TREE_INDEX_LEAF_SIZE,
+  TREE_INDEX_DATA_OFFSET,
+  TREE_INDEX_MAPPING_OFFSET,
+  TREE_INDEX_NODE_OFFSET,
+  TREE_INDEX_RECORD_SIZE,
+  TREE_INDEX_HEADER_FIELDS
+};
+
+static const char treeIndexMagic[8] = { 'M', 'L', 'P', 'K', 'T', 'I', 'D',
+    'X' };
+
+template<typename TreeType>
+TreeIndex<TreeType>::TreeIndex(typename TreeType::Mat& data,
+                               const BuildOptions& options) :
+    dataset(&data),
+    ownsDataset(false),
+    tree(NULL),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+  tree = new TreeType(data, oldFromNew, options);
+}
+
+template<typename TreeType>
+TreeIndex<TreeType>::TreeIndex(const std::string& filename) :
+    dataset(NULL),
+    ownsDataset(true),
+    tree(NULL),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    Log::Fatal << "Cannot open tree index '" << filename << "'." << std::endl;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot read size of tree index '" << filename << "'."
+        << std::endl;
+  }
+  bufferSize = (size_t) fileStat.st_size;
+
+  // Map the file read-only; nothing is read from disk until it is used.
+  void* map = (bufferSize == 0) ? MAP_FAILED : mmap(NULL, bufferSize,
+      PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    Log::Fatal << "Cannot map tree index '" << filename << "'." << std::endl;
+
+  buffer = (char*) map;
+  mapped = true;
+#else
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open tree index '" << filename << "'." << std::endl;
+
+  bufferSize = (size_t) stream.tellg();
+  buffer = new char[bufferSize];
+  stream.seekg(0);
+  stream.read(buffer, bufferSize);
+  if (!stream.good())
+    Log::Fatal << "Cannot read tree index '" << filename << "'." << std::endl;
+#endif
+
+  // Check the header.
+  const size_t headerSize = sizeof(treeIndexMagic) + TREE_INDEX_HEADER_FIELDS *
+      sizeof(uint64_t);
+  if ((bufferSize < headerSize) ||
+      (memcmp(buffer, treeIndexMagic, sizeof(treeIndexMagic)) != 0))
+    Log::Fatal << "'" << filename << "' is not a tree index." << std::endl;
+
+  uint64_t header[TREE_INDEX_HEADER_FIELDS];
+  memcpy(header, buffer + sizeof(treeIndexMagic), sizeof(header));
+
+  if (header[TREE_INDEX_VERSION] != 1)
+    Log::Fatal << "Unsupported tree index version "
+        << header[TREE_INDEX_VERSION] << " in '" << filename << "'."
+        << std::endl;
+
+  const size_t dimensionality = (size_t) header[TREE_INDEX_DIMENSIONALITY];
+  const size_t points = (size_t) header[TREE_INDEX_POINTS];
+  const size_t nodes = (size_t) header[TREE_INDEX_NODES];
+  const size_t dataOffset = (size_t) header[TREE_INDEX_DATA_OFFSET];
+  const size_t mappingOffset = (size_t) header[TREE_INDEX_MAPPING_OFFSET];
+  const size_t nodeOffset = (size_t) header[TREE_INDEX_NODE_OFFSET];
+  const size_t recordSize = (size_t) header[TREE_INDEX_RECORD_SIZE];
+
+  if ((recordSize != 4 * sizeof(uint64_t) + 2 * dimensionality *
+      sizeof(double)) || (dataOffset % sizeof(double) != 0) ||
+      (mappingOffset < dataOffset + dimensionality * points * sizeof(double)) ||
+      (nodeOffset < mappingOffset + points * sizeof(uint64_t)) ||
+      (nodes == 0) || (bufferSize < nodeOffset + nodes * recordSize))
+    Log::Fatal << "Tree index '" << filename << "' is corrupt." << std::endl;
+
+  // The dataset refers directly to the contents of the file.
+  dataset = new typename TreeType::Mat((double*) (buffer + dataOffset),
+      dimensionality, points, false, true);
+
+  oldFromNew.resize(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    uint64_t index;
+    memcpy(&index, buffer + mappingOffset + i * sizeof(uint64_t),
+        sizeof(uint64_t));
+    oldFromNew[i] = (size_t) index;
+  }
+
+  size_t next = 0;
+  tree = LoadNode(buffer + nodeOffset, recordSize, nodes, next, NULL,
+      (size_t) header[TREE_INDEX_LEAF_SIZE]);
+  if (next != nodes)
+    Log::Fatal << "Tree index '" << filename << "' is corrupt." << std::endl;
+
+  Log::Info << "Loaded tree index '" << filename << "' (" << nodes
+      << " nodes, " << dimensionality << " x " << points << " points)."
+      << std::endl;
+}
+
+template<typename TreeType>
+TreeIndex<TreeType>::~TreeIndex()
+{
+  // The tree refers to the dataset, which refers to the buffer, so they must be
+  // deleted in this order.
+  if (tree)
+    delete tree;
+  if (ownsDataset && dataset)
+    delete dataset;
+
+  if (buffer)
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(buffer, bufferSize);
+    else
+      delete[] buffer;
+#else
+    delete[] buffer;
+#endif
+  }
+}
+
+template<typename TreeType>
+void TreeIndex<TreeType>::Save(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open '" << filename << "' to save tree index."
+        << std::endl;
+
+  const size_t dimensionality = dataset->n_rows;
+  const size_t points = dataset->n_cols;
+
+  // The dataset starts on a page boundary, so the mapped matrix is aligned.
+  uint64_t header[TREE_INDEX_HEADER_FIELDS];
+  header[TREE_INDEX_VERSION] = 1;
+  header[TREE_INDEX_DIMENSIONALITY] = dimensionality;
+  header[TREE_INDEX_POINTS] = points;
+  header[TREE_INDEX_NODES] = tree->TreeSize();
+  header[TREE_INDEX_LEAF_SIZE] = tree->LeafSize();
+  header[TREE_INDEX_DATA_OFFSET] = 4096;
+  header[TREE_INDEX_MAPPING_OFFSET] = header[TREE_INDEX_DATA_OFFSET] +
+      dimensionality * points * sizeof(double);
+  header[TREE_INDEX_NODE_OFFSET] = header[TREE_INDEX_MAPPING_OFFSET] +
+      points * sizeof(uint64_t);
+  header[TREE_INDEX_RECORD_SIZE] = 4 * sizeof(uint64_t) + 2 * dimensionality *
+      sizeof(double);
+
+  stream.write(treeIndexMagic, sizeof(treeIndexMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  // Pad up to the dataset.
+  const std::vector<char> padding(header[TREE_INDEX_DATA_OFFSET] -
+      sizeof(treeIndexMagic) - sizeof(header), 0);
+  stream.write(&padding[0], padding.size());
+
+  stream.write((const char*) dataset->memptr(),
+      dimensionality * points * sizeof(double));
+
+  for (size_t i = 0; i < points; ++i)
+  {
+    const uint64_t index = oldFromNew[i];
+    stream.write((const char*) &index, sizeof(uint64_t));
+  }
+
+  SaveNode(stream, *tree);
+
+  if (!stream.good())
+    Log::Fatal << "Error writing tree index to '" << filename << "'."
+        << std::endl;
+}
+
+template<typename TreeType>
+void TreeIndex<TreeType>::SaveNode(std::ostream& stream,
+                                   const TreeType& node) const
+{
+  uint64_t fields[4];
+  fields[0] = node.Begin();
+  fields[1] = node.Count();
+  fields[2] = node.IsLeaf() ? 0 : node.SplitDimension();
+  fields[3] = node.IsLeaf() ? 0 : 1;
+  stream.write((const char*) fields, sizeof(fields));
+
+  for (size_t d = 0; d < dataset->n_rows; ++d)
+  {
+    const double range[2] = { node.Bound()[d].Lo(), node.Bound()[d].Hi() };
+    stream.write((const char*) range, sizeof(range));
+  }
+
+  if (!node.IsLeaf())
+  {
+    SaveNode(stream, *node.Left());
+    SaveNode(stream, *node.Right());
+  }
+}
+
+template<typename TreeType>
+TreeType* TreeIndex<TreeType>::LoadNode(const char* records,
+                                        const size_t recordSize,
+                                        const size_t numRecords,
+                                        size_t& next,
+                                        TreeType* parent,
+                                        const size_t leafSize)
+{
+  if (next >= numRecords)
+    Log::Fatal << "Tree index is corrupt: too few nodes." << std::endl;
+
+  const char* record = records + (next++) * recordSize;
+
+  uint64_t fields[4];
+  memcpy(fields, record, sizeof(fields));
+  if (fields[0] + fields[1] > dataset->n_cols)
+    Log::Fatal << "Tree index is corrupt: node out of range." << std::endl;
+
+  // Each column holds the low and high end of the bound in one dimension.
+  arma::mat ranges(2, dataset->n_rows);
+  memcpy(ranges.memptr(), record + sizeof(fields), ranges.n_elem *
+      sizeof(double));
+
+  TreeType* node = NewNode(*dataset, (size_t) fields[0], (size_t) fields[1],
+      ranges, (size_t) fields[2], parent, leafSize);
+
+  if (fields[3] != 0)
+  {
+    node->Left() = LoadNode(records, recordSize, numRecords, next, node,
+        leafSize);
+    node->Right() = LoadNode(records, recordSize, numRecords, next, node,
+        leafSize);
+  }
+
+  // The statistic may depend on the children, so it is built last.
+  BuildStatistic(*node);
+
+  return node;
+}
+
+template<typename TreeType>
+template<typename BoundType, typename StatisticType, typename MatType>
+BinarySpaceTree<BoundType, StatisticType, MatType>*
+TreeIndex<TreeType>::NewNode(
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    const arma::mat& ranges,
+    const size_t splitDimension,
+    BinarySpaceTree<BoundType, StatisticType, MatType>* parent,
+    const size_t leafSize)
+{
+  BoundType bound(data.n_rows);
+  for (size_t d = 0; d < data.n_rows; ++d)
+    bound[d] = math::Range(ranges(0, d), ranges(1, d));
+
+  return new BinarySpaceTree<BoundType, StatisticType, MatType>(data, begin,
+      count, bound, splitDimension, parent, leafSize);
+}
+
+template<typename TreeType>
+template<typename BoundType, typename StatisticType, typename MatType>
+void TreeIndex<TreeType>::BuildStatistic(
+    BinarySpaceTree<BoundType, StatisticType, MatType>& node)
+{
+  node.Stat() = StatisticType(node);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file tree_tuner.cpp
+ *
+ * Implementation of the non-template parts of TreeTuner.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tree_tuner.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+TreeTuner::TreeTuner(const size_t samples, const bool coverTrees) :
+    samples(samples),
+    coverTrees(coverTrees),
+    dimension(0.0)
+{ /* Nothing to do. */ }
+
+double TreeTuner::IntrinsicDimension(const arma::mat& points, const size_t k)
+{
+  if (k < 2 || points.n_cols <= k)
+    return 0.0;
+
+  // All the squared distances at once: |x|^2 + |y|^2 - 2 x^T y.
+  const arma::rowvec norms = arma::sum(arma::square(points));
+  arma::mat distances = -2.0 * arma::trans(points) * points;
+  distances.each_col() += arma::trans(norms);
+  distances.each_row() += norms;
+
+  // Average the inverse of the estimate of each point, then invert.
+  double inverseSum = 0.0;
+  size_t used = 0;
+  std::vector<double> neighbors;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    neighbors.clear();
+    for (size_t j = 0; j < points.n_cols; ++j)
+      if (j != i && distances(j, i) > 0.0)
+        neighbors.push_back(std::sqrt(distances(j, i)));
+
+    if (neighbors.size() < k)
+      continue;
+
+    std::partial_sort(neighbors.begin(), neighbors.begin() + k,
+        neighbors.end());
+
+    double logRatios = 0.0;
+    for (size_t j = 0; j < k - 1; ++j)
+      logRatios += std::log(neighbors[k - 1] / neighbors[j]);
+
+    inverseSum += logRatios / (k - 1);
+    ++used;
+  }
+
+  if (used == 0 || inverseSum <= 0.0)
+    return 0.0;
+
+  return used / inverseSum;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file tree_tuner.hpp
+ *
+ * Choose the tree type and leaf size of a tree-based search from a quick
+ * profile of the data.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_TREE_TUNER_HPP
+#define __MLPACK_CORE_TREE_TREE_TUNER_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The trees a search runs with: kd-trees with the given leaf size, or cover
+ * trees (which have no leaf size).
+ */
+struct TreeConfiguration
+{
+  //! Create the configuration.
+  TreeConfiguration(const bool coverTree = false, const size_t leafSize = 20) :
+      coverTree(coverTree), leafSize(leafSize) { }
+
+  //! Whether cover trees are used.
+  bool coverTree;
+  //! The leaf size of the kd-trees.
+  size_t leafSize;
+};
+
+/**
+ * The TreeTuner chooses the trees a search runs fastest with, instead of
+ * leaving the user to pick a tree type and a leaf size by hand.  It samples
+ * the points, estimates the intrinsic dimensionality of the sample (see
+ * IntrinsicDimension()), and times short probe searches on the sample with
+ * kd-trees of a few leaf sizes, and with cover trees.  The larger leaf sizes
+ * are only tried when the intrinsic dimensionality is high, where pruning is
+ * weak and larger leaves cost less than deeper trees.
+ *
+ * The probe is given by the search: it must have a method
+ *
+ * @code
+ * void operator()(arma::mat& sample, const TreeConfiguration& configuration);
+ * @endcode
+ *
+ * which builds the trees on the sample (a copy, which it may modify) with the
+ * given configuration and runs the search with the sample as both query and
+ * reference set.  Each configuration is timed twice, and the faster run
+ * counts.
+ *
+ * @code
+ * TreeTuner tuner;
+ * KNNProbe probe(k);
+ * const TreeConfiguration best = tuner.Tune(data, probe);
+ * @endcode
+ */
+class TreeTuner
+{
+ public:
+  /**
+   * Create the tuner.
+   *
+   * @param samples Number of points the probes are run on.
+   * @param coverTrees Whether cover trees are tried.
+   */
+  TreeTuner(const size_t samples = 2000, const bool coverTrees = true);
+
+  /**
+   * Choose the configuration the probe runs fastest with on a sample of the
+   * given points.
+   *
+   * @param data Points to sample (one per column).
+   * @param probe Search to time.
+   * @return The fastest configuration.
+   */
+  template<typename ProbeType>
+  TreeConfiguration Tune(const arma::mat& data, ProbeType& probe);
+
+  /**
+   * Estimate the intrinsic dimensionality of the given points with the
+   * maximum likelihood estimator of Levina and Bickel (2004), averaged over
+   * the points as MacKay and Ghahramani suggest, from the distances of each
+   * point to its k nearest neighbors (found by brute force).  Neighbors at
+   * distance 0 are ignored.  This returns 0 if there are too few points.
+   *
+   * @param points Points to estimate the dimensionality of (one per column).
+   * @param k Number of neighbors of each point to use.
+   */
+  static double IntrinsicDimension(const arma::mat& points,
+                                   const size_t k = 10);
+
+  //! Get the number of points the probes are run on.
+  size_t Samples() const { return samples; }
+  //! Modify the number of points the probes are run on.
+  size_t& Samples() { return samples; }
+
+  //! Get whether cover trees are tried.
+  bool CoverTrees() const { return coverTrees; }
+  //! Modify whether cover trees are tried.
+  bool& CoverTrees() { return coverTrees; }
+
+  //! Get the intrinsic dimensionality estimated by the last Tune().
+  double Dimension() const { return dimension; }
+
+  //! Get the configurations tried by the last Tune().
+  const std::vector<TreeConfiguration>& Configurations() const
+  { return configurations; }
+  //! Get the time each configuration of the last Tune() took, in seconds.
+  const std::vector<double>& Times() const { return times; }
+
+ private:
+  //! Number of points the probes are run on.
+  size_t samples;
+  //! Whether cover trees are tried.
+  bool coverTrees;
+  //! Intrinsic dimensionality estimated by the last Tune().
+  double dimension;
+  //! Configurations tried by the last Tune().
+  std::vector<TreeConfiguration> configurations;
+  //! Time of each configuration of the last Tune(), in seconds.
+  std::vector<double> times;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "tree_tuner_impl.hpp"
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file tree_tuner_impl.hpp
+ *
+ * Implementation of TreeTuner::Tune().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_TREE_TREE_TUNER_IMPL_HPP
+#define __MLPACK_CORE_TREE_TREE_TUNER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "tree_tuner.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename ProbeType>
+TreeConfiguration TreeTuner::Tune(const arma::mat& data, ProbeType& probe)
+{
+  // Sample the points without replacement.
+  arma::mat sample;
+  if (data.n_cols <= samples)
+  {
+    sample = data;
+  }
+  else
+  {
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        data.n_cols - 1, data.n_cols));
+    sample.set_size(data.n_rows, samples);
+    for (size_t i = 0; i < samples; ++i)
+      sample.col(i) = data.col(order[i]);
+  }
+
+  // The dimensionality is estimated on at most 1000 points, so that the brute
+  // force neighbor search stays cheap in many dimensions.
+  dimension = IntrinsicDimension(sample.cols(0,
+      std::min((size_t) sample.n_cols, (size_t) 1000) - 1));
+  Log::Info << "Estimated intrinsic dimensionality: " << dimension << "."
+      << std::endl;
+
+  configurations.clear();
+  const size_t leafSizes[] = { 10, 20, 40, 80, 160, 320 };
+  const size_t tried = (dimension > 10.0) ? 6 : 4;
+  for (size_t i = 0; i < tried; ++i)
+    if (leafSizes[i] < sample.n_cols || i == 0)
+      configurations.push_back(TreeConfiguration(false, leafSizes[i]));
+  if (coverTrees)
+    configurations.push_back(TreeConfiguration(true, 0));
+
+  times.assign(configurations.size(), std::numeric_limits<double>::max());
+  size_t best = 0;
+  for (size_t i = 0; i < configurations.size(); ++i)
+  {
+    for (size_t trial = 0; trial < 2; ++trial)
+    {
+      arma::mat probeSample(sample);
+      const uint64_t start = Timer::Now();
+      probe(probeSample, configurations[i]);
+      times[i] = std::min(times[i], (Timer::Now() - start) / 1e9);
+    }
+
+    if (configurations[i].coverTree)
+      Log::Info << "Cover trees: " << times[i] << "s." << std::endl;
+    else
+      Log::Info << "Leaf size " << configurations[i].leafSize << ": "
+          << times[i] << "s." << std::endl;
+
+    if (times[i] < times[best])
+      best = i;
+  }
+
+  return configurations[best];
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file batch_predict.hpp
+ *
+ * A common batched inference path for models with a Predict() or Classify()
+ * method: the points are processed in blocks on several threads, and the
+ * results are written into memory the caller provides.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_BATCH_PREDICT_HPP
+#define __MLPACK_CORE_UTIL_BATCH_PREDICT_HPP
+
+#include <mlpack/core.hpp>
+#include "threads.hpp"
+
+namespace mlpack {
+namespace util {
+
+//! Models which predict values are run with Predict().
+template<typename ModelType>
+void PredictBlock(const ModelType& model,
+                  const arma::mat& block,
+                  double* output)
+{
+  arma::vec predictions(output, block.n_cols, false, true);
+  model.Predict(block, predictions);
+}
+
+//! Models which predict labels are run with Classify().
+template<typename ModelType>
+void PredictBlock(const ModelType& model,
+                  const arma::mat& block,
+                  size_t* output)
+{
+  arma::Col<size_t> labels(output, block.n_cols, false, true);
+  model.Classify(block, labels);
+}
+
+//! Run the model on the given columns of a dense matrix of doubles, which are
+//! aliased instead of copied.
+template<typename ModelType, typename OutputType>
+void PredictColumns(const ModelType& model,
+                    const arma::mat& points,
+                    const size_t begin,
+                    const size_t count,
+                    OutputType* output)
+{
+  const arma::mat block(const_cast<double*>(points.colptr(begin)),
+      points.n_rows, count, false, true);
+  PredictBlock(model, block, output + begin);
+}
+
+//! Run the model on the given columns of a matrix of another element type
+//! (such as float), which are converted to doubles one block at a time.
+template<typename ModelType, typename eT, typename OutputType>
+void PredictColumns(const ModelType& model,
+                    const arma::Mat<eT>& points,
+                    const size_t begin,
+                    const size_t count,
+                    OutputType* output)
+{
+  const arma::mat block = arma::conv_to<arma::mat>::from(
+      points.cols(begin, begin + count - 1));
+  PredictBlock(model, block, output + begin);
+}
+
+}; // namespace util
+
+/**
+ * Run a model on every column of the given points, in blocks processed on up to
+ * the given number of threads, and write the results into the given memory,
+ * which must hold points.n_cols elements.  Nothing is allocated for the
+ * results, so a serving loop can reuse one buffer for every batch.
+ *
+ * With double output, the model must have a method
+ * Predict(const arma::mat&, arma::vec&) const (LogisticRegression,
+ * LinearRegression, det::DTree); with size_t output, it must have a method
+ * Classify(const arma::mat&, arma::Col<size_t>&) const
+ * (NaiveBayesClassifier, GMM).  These are called once for each block, with a
+ * vector aliasing the block's part of the output, so they must not resize it.
+ * Each point is predicted on its own, so the results do not depend on the
+ * blocks or the number of threads.  Points of another element type than double
+ * (such as float) are converted one block at a time.
+ *
+ * @code
+ * arma::fmat points; // Single-precision points to classify.
+ * std::vector<size_t> labels(points.n_cols);
+ * BatchPredict(gmm, points, &labels[0]);
+ *
+ * arma::vec predictions(points.n_cols);
+ * BatchPredict(lr, points, predictions.memptr(), 4);
+ * @endcode
+ *
+ * @param model Model to run.
+ * @param points Points to run the model on (one per column).
+ * @param output Memory for the results (points.n_cols elements).
+ * @param threads Number of threads (1 is serial, 0 is all cores).
+ * @param blockSize Number of points in each block.
+ */
+template<typename ModelType, typename eT, typename OutputType>
+void BatchPredict(const ModelType& model,
+                  const arma::Mat<eT>& points,
+                  OutputType* output,
+                  const size_t threads = 0,
+                  const size_t blockSize = 1024)
+{
+  const size_t n = points.n_cols;
+  if (n == 0)
+    return;
+
+  const size_t workers = std::max(std::min(Threads::Count(threads), n),
+      (size_t) 1);
+  const size_t blockColumns = std::max(blockSize, (size_t) 1);
+  const size_t blocks = std::max(workers,
+      (n + blockColumns - 1) / blockColumns);
+
+  #pragma omp parallel for num_threads(workers) schedule(dynamic, 1)
+  for (int b = 0; b < (int) blocks; ++b)
+  {
+    const size_t begin = (size_t) b * n / blocks;
+    const size_t end = ((size_t) b + 1) * n / blocks;
+    if (end > begin)
+      util::PredictColumns(model, points, begin, end - begin, output);
+  }
+}
+
+}; // namespace mlpack
+
+#endif
@@ -20,6 +20,7 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <list>
+#include <vector>
 #include <boost/program_options.hpp>
 #include <boost/any.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -42,9 +43,25 @@ namespace po = boost::program_options;
 // Fake ProgramDoc in case none is supplied.
 static ProgramDoc emptyProgramDoc = ProgramDoc("", "");
 
+// The ProgramDoc given with PROGRAM_INFO(), if any.  This is a plain pointer so
+// that it is set before any dynamic initialization happens.
+static ProgramDoc* programDoc = NULL;
+
+/**
+ * The options registered before the singleton exists; they are added to it
+ * when it is created.  The list is created on first use, so that options can
+ * be registered during static initialization in any translation unit.
+ */
+static std::vector<PendingOption>& PendingOptions()
+{
+  static std::vector<PendingOption> options;
+  return options;
+}
+
 /* Constructors, Destructors, Copy */
 /* Make the constructor private, to preclude unauthorized instances */
-CLI::CLI() : desc("Allowed Options") , didParse(false), doc(&emptyProgramDoc)
+CLI::CLI() : desc("Allowed Options") , didParse(false),
+    doc((programDoc != NULL) ? programDoc : &emptyProgramDoc)
 {
   return;
 }
@@ -80,16 +97,42 @@ CLI::~CLI()
     Print();
 
     Log::Info << "Program timers:" << std::endl;
-    std::map<std::string, timeval>::iterator it;
-    for (it = timer.GetAllTimers().begin(); it != timer.GetAllTimers().end();
-        ++it)
+    Timers& timers = Timer::GetTimers();
+    const std::map<std::string, timeval> allTimers = timers.GetAllTimers();
+    std::map<std::string, timeval>::const_iterator it;
+    for (it = allTimers.begin(); it != allTimers.end(); ++it)
     {
       std::string i = (*it).first;
       Log::Info << "  " << i << ": ";
-      timer.PrintTimer((*it).first);
+      timers.PrintTimer((*it).first);
+    }
+
+    // If memory was tracked, print what each phase used.
+    if (MemoryUsage::Enabled())
+    {
+      Log::Info << "Program memory (peak resident "
+          << MemoryBudget::Format(MemoryUsage::PeakResident()) << "):"
+          << std::endl;
+      for (it = allTimers.begin(); it != allTimers.end(); ++it)
+      {
+        if (timers.GetPhaseMemory((*it).first).runs == 0)
+          continue;
+
+        Log::Info << "  " << (*it).first << ": ";
+        timers.PrintPhaseMemory((*it).first);
+      }
     }
   }
 
+  // Write the profile, if the user asked for it.
+  if (HasParam("profile_file") && !HasParam("help") && !HasParam("info"))
+  {
+    const std::string profileFile = GetParam<std::string>("profile_file");
+    if (!Profiler::WriteJSON(profileFile))
+      Log::Warn << "Cannot write profile to '" << profileFile << "'."
+          << std::endl;
+  }
+
   // Notify the user if we are debugging, but only if we actually parsed the
   // options.  This way this output doesn't show up inexplicably for someone who
   // may not have wanted it there (i.e. in Boost unit tests).
@@ -143,6 +186,20 @@ void CLI::Add(const std::string& path,
   return;
 }
 
+/**
+ * Adds a parameter when the singleton is first used, or right away if it
+ * already exists.
+ *
+ * @param option The option to add.
+ */
+void CLI::AddLazily(const PendingOption& option)
+{
+  if (singleton != NULL)
+    option.add(option);
+  else
+    PendingOptions().push_back(option);
+}
+
 /*
  * Adds an alias mapping for a given parameter.
  *
@@ -239,6 +296,32 @@ void CLI::DefaultMessages()
     Log::Info.ignoreInput = false;
   }
 
+  // Set the memory budget (given in megabytes), if there is one.
+  const int budget = GetParam<int>("memory_budget");
+  if (budget < 0)
+    Log::Fatal << "--memory_budget must be non-negative." << std::endl;
+  if (budget > 0)
+  {
+    MemoryBudget::SetLimit((size_t) budget * 1024 * 1024);
+    Log::Info << "Memory budget: " << MemoryBudget::Format(
+        MemoryBudget::Limit()) << "." << std::endl;
+  }
+
+  // Record the memory used by each timed phase, if the user asked for it.
+  if (HasParam("track_memory"))
+    MemoryUsage::Enable();
+
+  // Set the limit on the number of threads, if there is one.
+  const int maxThreads = GetParam<int>("max_threads");
+  if (maxThreads < 0)
+    Log::Fatal << "--max_threads must be non-negative." << std::endl;
+  if (maxThreads > 0)
+  {
+    Threads::SetLimit((size_t) maxThreads);
+    Log::Info << "Using at most " << Threads::Limit() << " threads."
+        << std::endl;
+  }
+
   // Notify the user if we are debugging.  This is not done in the constructor
   // because the output streams may not be set up yet.  We also don't want this
   // message twice if the user just asked for help or information.
@@ -379,8 +462,17 @@ std::string CLI::GetDescription(const std::string& identifier)
 CLI& CLI::GetSingleton()
 {
   if (singleton == NULL)
+  {
     singleton = new CLI();
 
+    // Now add the options which were registered before.  The singleton must
+    // exist while this is done, since adding an option uses it.
+    std::vector<PendingOption> options;
+    options.swap(PendingOptions());
+    for (size_t i = 0; i < options.size(); ++i)
+      options[i].add(options[i]);
+  }
+
   return *singleton;
 }
 
@@ -702,8 +794,13 @@ void CLI::RegisterProgramDoc(ProgramDoc* doc)
 {
   // Only register the doc if it is not the dummy object we created at the
   // beginning of the file (as a default value in case this is never called).
+  // This does not create the singleton, which will pick the doc up.
   if (doc != &emptyProgramDoc)
-    GetSingleton().doc = doc;
+  {
+    programDoc = doc;
+    if (singleton != NULL)
+      singleton->doc = doc;
+  }
 }
 
 /**
@@ -757,3 +854,14 @@ PARAM_STRING("info", "Get help on a specific module or option.", "", "");
 PARAM_FLAG("verbose", "Display informational messages and the full list of "
     "parameters and timers at the end of execution.", "v");
 PARAM_FLAG("version", "Display the version of mlpack.", "V");
+PARAM_INT("memory_budget", "If nonzero, the working memory (in megabytes) "
+    "that methods should try to stay within, choosing algorithms which use "
+    "less memory when needed (see mlpack::MemoryBudget).", "", 0);
+PARAM_INT("max_threads", "If nonzero, the most threads that any method may "
+    "use at once, whatever its own --threads option asks for (see "
+    "mlpack::Threads).", "", 0);
+PARAM_FLAG("track_memory", "Record the peak resident memory and the heap "
+    "growth during each timer, and print them with the timers with --verbose "
+    "(see mlpack::MemoryUsage).", "");
+PARAM_STRING("profile_file", "If specified, write the statistics of the "
+    "profiler timers (see mlpack::Profiler) to this file as JSON.", "", "");
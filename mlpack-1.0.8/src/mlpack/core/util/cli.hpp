@@ -33,6 +33,10 @@
 #include <boost/program_options.hpp>
 
 #include "timers.hpp"
+#include "memory_budget.hpp"
+#include "memory_usage.hpp"
+#include "profiler.hpp"
+#include "threads.hpp"
 #include "cli_deleter.hpp" // To make sure we can delete the singleton.
 #include "version.hpp"
 
@@ -381,6 +385,10 @@ namespace util {
 // program being run.
 class ProgramDoc;
 
+// Externally defined in option.hpp, this holds an option registered before
+// the CLI singleton exists.
+struct PendingOption;
+
 }; // namespace util
 
 /**
@@ -564,6 +572,15 @@ class CLI
                   const std::string& alias = "",
                   bool required = false);
 
+  /**
+   * Adds a parameter to the hierarchy when the CLI singleton is first used, or
+   * right away if it already exists; this is what the PARAM_*() macros do.
+   * Library users which never call CLI thus never create the singleton.
+   *
+   * @param option The option to add.
+   */
+  static void AddLazily(const util::PendingOption& option);
+
   /**
    * Adds a flag parameter to the hierarchy; use PARAM_FLAG() instead of this.
    *
@@ -613,7 +630,8 @@ class CLI
    *
    * In this case, the singleton is used to store data for the static methods,
    * as there is no point in defining static methods only to have users call
-   * private instance methods.
+   * private instance methods.  The singleton is created on first use, and the
+   * options declared with the PARAM_*() macros are added to it then.
    *
    * @return The singleton instance for use in the static methods.
    */
@@ -708,12 +726,6 @@ class CLI
   //! Hold the name of the program for --version.
   std::string programName;
 
-  //! Holds the timer objects.
-  Timers timer;
-
-  //! So that Timer::Start() and Timer::Stop() can access the timer variable.
-  friend class Timer;
-
  public:
   //! Pointer to the ProgramDoc object.
   util::ProgramDoc *doc;
@@ -0,0 +1,81 @@
+/**
+ * @file communicator.hpp
+ *
+ * An interface to the processes among which a dataset is distributed, which
+ * lets methods sum their statistics over all of the processes.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_COMMUNICATOR_HPP
+#define __MLPACK_CORE_UTIL_COMMUNICATOR_HPP
+
+#include <stddef.h>
+
+namespace mlpack {
+
+/**
+ * A Communicator connects the processes (ranks) among which a dataset is
+ * split, one shard per rank.  Methods which accept a communicator (through
+ * their Comm() accessor) run on the shard of each rank, and make their
+ * statistics global by summing them over all ranks with Sum() once per
+ * iteration, so that every rank ends with the same model.  When no
+ * communicator is given (the default), the methods run on one process.
+ *
+ * Sum() is collective: every rank must call it, in the same order and with the
+ * same number of values.  The methods which accept a communicator, with what
+ * they sum:
+ *
+ *  - kmeans::KMeans::Cluster(): the sums and counts of the points of each
+ *    cluster, and the number of changed assignments;
+ *  - gmm::EMFit::Estimate(): the responsibility-weighted sums and outer
+ *    products of each component, the sums of the responsibilities, and the
+ *    log-likelihood.
+ *
+ * MPICommunicator (in mpi_communicator.hpp, which needs MPI) is a
+ * communicator for MPI programs; other transports only need to implement
+ * Rank(), Ranks() and Sum().
+ *
+ * @code
+ * MPICommunicator communicator(MPI_COMM_WORLD);
+ * kmeans::KMeans<> k;
+ * k.Comm() = &communicator;
+ * k.Cluster(localShard, 10, localAssignments, centroids);
+ * @endcode
+ */
+class Communicator
+{
+ public:
+  //! Destroy the communicator.
+  virtual ~Communicator() { }
+
+  //! Return the rank of this process (from 0).
+  virtual size_t Rank() const = 0;
+
+  //! Return the number of ranks.
+  virtual size_t Ranks() const = 0;
+
+  /**
+   * Replace the given values, on every rank, with their sums over all ranks.
+   *
+   * @param values Values to sum.
+   * @param count Number of values; the same on every rank.
+   */
+  virtual void Sum(double* values, const size_t count) = 0;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_COMMUNICATOR_HPP
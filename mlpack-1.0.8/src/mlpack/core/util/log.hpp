@@ -58,7 +58,20 @@ namespace mlpack {
  *
  * Any messages sent to Log::Debug will not be shown when compiling in non-debug
  * mode.  Messages to Log::Info will only be shown when the --verbose flag is
- * given to the program (or rather, the CLI class).
+ * given to the program (or rather, the CLI class).  Output which is not shown
+ * is not formatted, but its operands are still evaluated; in code where that
+ * matters (such as the inner loops of an algorithm), MLPACK_LOG_DEBUG and
+ * MLPACK_LOG_INFO can be used in place of Log::Debug and Log::Info.  These
+ * skip the whole expression: at compile time for Log::Debug in non-debug mode
+ * (and for Log::Info if MLPACK_NO_LOG_INFO is defined), and otherwise when
+ * Log::Info is not shown.
+ *
+ * @code
+ * MLPACK_LOG_DEBUG << "Objective: " << function.Evaluate(x) << std::endl;
+ * @endcode
+ *
+ * Each of the streams may be used from several OpenMP threads at once; lines
+ * given by different threads are not mixed (see PrefixedOutStream).
  *
  * @see PrefixedOutStream, NullOutStream, CLI
  */
@@ -100,4 +113,18 @@ class Log
 
 }; //namespace mlpack
 
+// The empty if () branch keeps an else after the macro with its own if ().
+#ifdef DEBUG
+  #define MLPACK_LOG_DEBUG mlpack::Log::Debug
+#else
+  #define MLPACK_LOG_DEBUG if (true) { } else mlpack::Log::Debug
+#endif
+
+#ifdef MLPACK_NO_LOG_INFO
+  #define MLPACK_LOG_INFO if (true) { } else mlpack::Log::Info
+#else
+  #define MLPACK_LOG_INFO \
+      if (mlpack::Log::Info.ignoreInput) { } else mlpack::Log::Info
+#endif
+
 #endif
@@ -0,0 +1,76 @@
+/**
+ * @file memory_budget.cpp
+ *
+ * Implementation of MemoryBudget.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "memory_budget.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace mlpack;
+
+size_t MemoryBudget::limit = 0;
+
+void MemoryBudget::SetLimit(const size_t bytes)
+{
+  limit = bytes;
+}
+
+size_t MemoryBudget::Limit()
+{
+  return limit;
+}
+
+bool MemoryBudget::Fits(const size_t bytes)
+{
+  return (limit == 0 || bytes <= limit);
+}
+
+size_t MemoryBudget::BlockColumns(const size_t bytesPerColumn,
+                                  const size_t columns,
+                                  const size_t fixedBytes)
+{
+  if (limit == 0 || bytesPerColumn == 0)
+    return std::max(columns, (size_t) 1);
+
+  const size_t available = (fixedBytes < limit) ? limit - fixedBytes : 0;
+  return std::max(std::min(available / bytesPerColumn, columns), (size_t) 1);
+}
+
+std::string MemoryBudget::Format(const size_t bytes)
+{
+  const char* units[] = { "B", "kB", "MB", "GB", "TB" };
+
+  double size = (double) bytes;
+  size_t unit = 0;
+  while (size >= 1024.0 && unit < 4)
+  {
+    size /= 1024.0;
+    ++unit;
+  }
+
+  std::ostringstream stream;
+  if (unit == 0)
+    stream << bytes << units[0];
+  else
+    stream << std::fixed << std::setprecision(1) << size << units[unit];
+
+  return stream.str();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file memory_budget.hpp
+ *
+ * A process-wide limit on the working memory of methods, which they consult to
+ * choose between a fast algorithm and one that uses less memory.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_MEMORY_BUDGET_HPP
+#define __MLPACK_CORE_UTIL_MEMORY_BUDGET_HPP
+
+#include <string>
+#include <stddef.h>
+
+namespace mlpack {
+
+/**
+ * The MemoryBudget is a limit on the working memory that methods may allocate
+ * in addition to their inputs and outputs (copies of datasets, trees,
+ * temporary matrices).  By default there is no budget.  When a budget is set,
+ * methods which have a choice use it to pick a way of running that fits: for
+ * instance, PCA computes the covariance matrix blockwise instead of
+ * decomposing a centered copy of the data, EMFit processes the observations in
+ * blocks, and KMeans::FastCluster() falls back to Cluster() when a copy of the
+ * dataset does not fit.  Methods also report the memory they expect to need
+ * (see PCA::PeakMemory(), EMFit::PeakMemory(), KMeans::PeakMemory() and
+ * NeighborSearch::PeakMemory()), so a caller can check before running.
+ *
+ * The budget is a guide, not a hard limit: allocations are not tracked, and
+ * methods which cannot fit in the budget still run (with a warning).
+ *
+ * @code
+ * // Allow 64MB of working memory.
+ * MemoryBudget::SetLimit(64 * 1024 * 1024);
+ *
+ * pca::PCA pca;
+ * if (!MemoryBudget::Fits(pca.PeakMemory(data.n_rows, data.n_cols, 10)))
+ *   ...
+ * @endcode
+ *
+ * Every program also sets the budget with the --memory_budget option (in MB).
+ */
+class MemoryBudget
+{
+ public:
+  /**
+   * Set the budget, in bytes.  A limit of 0 means there is no budget.
+   *
+   * @param bytes New budget, in bytes.
+   */
+  static void SetLimit(const size_t bytes);
+
+  //! Get the budget, in bytes (0 if there is no budget).
+  static size_t Limit();
+
+  //! Return whether there is a budget.
+  static bool Limited() { return (Limit() != 0); }
+
+  /**
+   * Return whether the given amount of working memory fits in the budget.
+   * Everything fits when there is no budget.
+   *
+   * @param bytes Amount of memory, in bytes.
+   */
+  static bool Fits(const size_t bytes);
+
+  /**
+   * Return how many columns may be processed at once when each column needs
+   * the given amount of working memory, in addition to the given fixed amount.
+   * This is at least 1, and at most the given number of columns; with no
+   * budget, it is the given number of columns.
+   *
+   * @param bytesPerColumn Working memory needed for each column, in bytes.
+   * @param columns Number of columns to process.
+   * @param fixedBytes Working memory needed regardless of the block size.
+   */
+  static size_t BlockColumns(const size_t bytesPerColumn,
+                             const size_t columns,
+                             const size_t fixedBytes = 0);
+
+  //! Return the size of a dense matrix of the given element type, in bytes.
+  template<typename eT>
+  static size_t MatrixBytes(const size_t rows, const size_t cols)
+  {
+    return rows * cols * sizeof(eT);
+  }
+
+  //! Format the given amount of memory for messages (for instance, "12.5MB").
+  static std::string Format(const size_t bytes);
+
+ private:
+  //! The budget, in bytes (0 if there is no budget).
+  static size_t limit;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_MEMORY_BUDGET_HPP
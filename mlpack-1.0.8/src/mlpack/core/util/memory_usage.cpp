@@ -0,0 +1,121 @@
+/**
+ * @file memory_usage.cpp
+ *
+ * Implementation of MemoryUsage.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "memory_usage.hpp"
+
+#include <cstdio>
+
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__MACH__) && defined(__APPLE__))
+  #include <sys/resource.h> // getrusage()
+  #include <unistd.h>       // sysconf()
+#endif
+
+#if defined(__MACH__) && defined(__APPLE__)
+  #include <mach/mach.h>       // task_info()
+  #include <malloc/malloc.h>   // malloc_zone_statistics()
+#endif
+
+#if defined(__GLIBC__)
+  #include <malloc.h> // mallinfo()
+#endif
+
+using namespace mlpack;
+
+bool MemoryUsage::enabled = false;
+
+void MemoryUsage::Enable(const bool enable)
+{
+  enabled = enable;
+}
+
+bool MemoryUsage::Enabled()
+{
+  return enabled;
+}
+
+size_t MemoryUsage::Resident()
+{
+#if defined(__linux__)
+  // The second field of statm is the number of resident pages.
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == NULL)
+    return 0;
+
+  unsigned long size = 0, resident = 0;
+  const int read = fscanf(statm, "%lu %lu", &size, &resident);
+  fclose(statm);
+  if (read != 2)
+    return 0;
+
+  return (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+#elif defined(__MACH__) && defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info,
+      &count) != KERN_SUCCESS)
+    return 0;
+
+  return (size_t) info.resident_size;
+#else
+  return 0;
+#endif
+}
+
+size_t MemoryUsage::PeakResident()
+{
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__MACH__) && defined(__APPLE__))
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  // ru_maxrss is in bytes on OS X, and in kilobytes elsewhere.
+  #if defined(__MACH__) && defined(__APPLE__)
+  return (size_t) usage.ru_maxrss;
+  #else
+  return (size_t) usage.ru_maxrss * 1024;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+size_t MemoryUsage::HeapInUse()
+{
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+  // uordblks counts the allocated chunks of the arenas, and hblkhd the large
+  // blocks allocated with mmap() (such as most Armadillo matrices).
+  const struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+  // The fields of mallinfo() are ints, which wrap above 2GB.
+  const struct mallinfo info = mallinfo();
+  return (size_t) (unsigned int) info.uordblks +
+      (size_t) (unsigned int) info.hblkhd;
+#elif defined(__MACH__) && defined(__APPLE__)
+  malloc_statistics_t statistics;
+  malloc_zone_statistics(NULL, &statistics);
+  return statistics.size_in_use;
+#else
+  return 0;
+#endif
+}
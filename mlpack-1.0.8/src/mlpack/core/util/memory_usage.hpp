@@ -0,0 +1,90 @@
+/**
+ * @file memory_usage.hpp
+ *
+ * Measurement of the memory used by the process, for the memory statistics of
+ * the timers.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_MEMORY_USAGE_HPP
+#define __MLPACK_CORE_UTIL_MEMORY_USAGE_HPP
+
+#include <stddef.h>
+
+namespace mlpack {
+
+/**
+ * The memory used by the process, as seen by the timers: while a timer runs,
+ * how much the peak resident memory of the process grew, and how much the
+ * heap grew.  The growth of the peak resident memory shows the temporary
+ * allocations of a phase even when they are freed before it ends; the heap
+ * growth shows what the phase left allocated.
+ */
+struct PhaseMemory
+{
+  //! The peak resident memory of the process when the phase last stopped.
+  size_t peakResident;
+  //! How much the peak resident memory grew while the phase ran (summed over
+  //! all of its runs).
+  size_t peakGrowth;
+  //! How much the heap in use grew while the phase ran (summed over all of its
+  //! runs; negative if it shrank).
+  double heapGrowth;
+  //! How many times the phase ran.
+  size_t runs;
+};
+
+/**
+ * MemoryUsage measures the memory used by the process: its resident memory,
+ * its peak resident memory, and the bytes of the heap in use.  Armadillo
+ * allocates the memory of its matrices with malloc(), so the heap in use
+ * counts them; it is read from the statistics of the allocator (mallinfo2()
+ * with glibc), as Armadillo allocations cannot be hooked.  Where a value is
+ * not available, it is 0.
+ *
+ * When tracking is enabled (with Enable(), or the --track_memory option of
+ * every program), each Timer also records the memory used during its phase
+ * (see PhaseMemory and Timers::GetPhaseMemory()), and --verbose prints it with
+ * the timers.  Tracking is off by default, because reading the allocator
+ * statistics walks its arenas.
+ */
+class MemoryUsage
+{
+ public:
+  //! Turn the memory statistics of the timers on or off.
+  static void Enable(const bool enable = true);
+
+  //! Return whether the timers record memory statistics.
+  static bool Enabled();
+
+  //! Return the resident memory of the process, in bytes.
+  static size_t Resident();
+
+  //! Return the peak resident memory of the process so far, in bytes.
+  static size_t PeakResident();
+
+  //! Return the bytes of the heap in use (including large blocks allocated
+  //! with mmap()).
+  static size_t HeapInUse();
+
+ private:
+  //! Whether the timers record memory statistics.
+  static bool enabled;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_MEMORY_USAGE_HPP
@@ -0,0 +1,86 @@
+/**
+ * @file mpi_communicator.hpp
+ *
+ * A Communicator for the ranks of an MPI communicator.  This header needs MPI,
+ * and is not included by core.hpp.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_MPI_COMMUNICATOR_HPP
+#define __MLPACK_CORE_UTIL_MPI_COMMUNICATOR_HPP
+
+#include <mpi.h>
+
+#include <algorithm>
+
+#include "communicator.hpp"
+
+namespace mlpack {
+
+/**
+ * A Communicator which sums with MPI_Allreduce() over the ranks of an MPI
+ * communicator.  The sums are taken in chunks, so that counts larger than an
+ * int can be summed.
+ */
+class MPICommunicator : public Communicator
+{
+ public:
+  /**
+   * Use the given MPI communicator, which must stay valid while this object is
+   * used.
+   *
+   * @param communicator The MPI communicator.
+   */
+  MPICommunicator(MPI_Comm communicator = MPI_COMM_WORLD) :
+      communicator(communicator)
+  {
+    int value;
+    MPI_Comm_rank(communicator, &value);
+    rank = (size_t) value;
+    MPI_Comm_size(communicator, &value);
+    ranks = (size_t) value;
+  }
+
+  //! Return the rank of this process.
+  size_t Rank() const { return rank; }
+
+  //! Return the number of ranks.
+  size_t Ranks() const { return ranks; }
+
+  //! Replace the given values with their sums over all ranks.
+  void Sum(double* values, const size_t count)
+  {
+    const size_t chunk = 1 << 28;
+    for (size_t begin = 0; begin < count; begin += chunk)
+    {
+      const size_t length = std::min(chunk, count - begin);
+      MPI_Allreduce(MPI_IN_PLACE, values + begin, (int) length, MPI_DOUBLE,
+          MPI_SUM, communicator);
+    }
+  }
+
+ private:
+  //! The MPI communicator.
+  MPI_Comm communicator;
+  //! The rank of this process.
+  size_t rank;
+  //! The number of ranks.
+  size_t ranks;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_MPI_COMMUNICATOR_HPP
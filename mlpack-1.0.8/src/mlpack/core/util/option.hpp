@@ -31,10 +31,33 @@ namespace mlpack {
 namespace util {
 
 /**
- * A static object whose constructor registers a parameter with the CLI class.
- * This should not be used outside of CLI itself, and you should use the
- * PARAM_FLAG(), PARAM_DOUBLE(), PARAM_INT(), PARAM_STRING(), or other similar
- * macros to declare these objects instead of declaring them directly.
+ * The registration of an option, as recorded by the Option constructor.  The
+ * CLI singleton is only created when a program first uses it, so registrations
+ * made during static initialization are kept in this form until then; library
+ * users who never use CLI thus never pay for boost::program_options.
+ */
+struct PendingOption
+{
+  //! The name of the option.
+  std::string identifier;
+  //! A short string describing the option.
+  std::string description;
+  //! The alias of the option (or an empty string).
+  std::string alias;
+  //! Whether or not the option is required at runtime.
+  bool required;
+  //! The default value of the option, if it has a type.
+  boost::any defaultValue;
+  //! The function which adds this option to the CLI singleton.
+  void (*add)(const PendingOption& option);
+};
+
+/**
+ * A static object whose constructor registers a parameter with the CLI class
+ * (lazily; see PendingOption).  This should not be used outside of CLI itself,
+ * and you should use the PARAM_FLAG(), PARAM_DOUBLE(), PARAM_INT(),
+ * PARAM_STRING(), or other similar macros to declare these objects instead of
+ * declaring them directly.
  *
  * @see core/io/cli.hpp, mlpack::CLI
  */
@@ -77,6 +100,14 @@ class Option
   Option(const std::string& identifier,
          const std::string& description,
          const std::string& parent = std::string(""));
+
+ private:
+  //! Add an option of type N, and set its default value.
+  static void AddTyped(const PendingOption& option);
+  //! Add an option whose type does not matter.
+  static void AddUntyped(const PendingOption& option);
+  //! Add a flag.
+  static void AddFlag(const PendingOption& option);
 };
 
 /**
@@ -29,7 +29,8 @@ namespace mlpack {
 namespace util {
 
 /**
- * Registers a parameter with CLI.
+ * Registers a parameter with CLI.  The registration is deferred until the CLI
+ * singleton is first used.
  */
 template<typename N>
 Option<N>::Option(bool ignoreTemplate,
@@ -39,27 +40,65 @@ Option<N>::Option(bool ignoreTemplate,
                   const std::string& alias,
                   bool required)
 {
+  PendingOption option;
+  option.identifier = identifier;
+  option.description = description;
+  option.alias = alias;
+  option.required = required;
+
   if (ignoreTemplate)
   {
-    CLI::Add(identifier, description, alias, required);
+    option.add = &Option<N>::AddUntyped;
   }
   else
   {
-    CLI::Add<N>(identifier, description, alias, required);
-    CLI::GetParam<N>(identifier) = defaultValue;
+    option.defaultValue = boost::any(defaultValue);
+    option.add = &Option<N>::AddTyped;
   }
+
+  CLI::AddLazily(option);
 }
 
 
 /**
- * Registers a flag parameter with CLI.
+ * Registers a flag parameter with CLI.  The registration is deferred until the
+ * CLI singleton is first used.
  */
 template<typename N>
 Option<N>::Option(const std::string& identifier,
                   const std::string& description,
                   const std::string& alias)
 {
-  CLI::AddFlag(identifier, description, alias);
+  PendingOption option;
+  option.identifier = identifier;
+  option.description = description;
+  option.alias = alias;
+  option.required = false;
+  option.add = &Option<N>::AddFlag;
+
+  CLI::AddLazily(option);
+}
+
+template<typename N>
+void Option<N>::AddTyped(const PendingOption& option)
+{
+  CLI::Add<N>(option.identifier, option.description, option.alias,
+      option.required);
+  CLI::GetParam<N>(option.identifier) =
+      boost::any_cast<N>(option.defaultValue);
+}
+
+template<typename N>
+void Option<N>::AddUntyped(const PendingOption& option)
+{
+  CLI::Add(option.identifier, option.description, option.alias,
+      option.required);
+}
+
+template<typename N>
+void Option<N>::AddFlag(const PendingOption& option)
+{
+  CLI::AddFlag(option.identifier, option.description, option.alias);
 }
 
 }; // namespace util
@@ -26,10 +26,46 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <map>
+
 #include "prefixedoutstream.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack::util;
 
+namespace {
+
+//! What one thread has given to a stream in a parallel region.
+struct ThreadLine
+{
+  ThreadLine() : lineStart(true) { }
+
+  //! The unfinished line, with its prefix.
+  std::string pending;
+  //! Whether the next output starts a line.
+  bool lineStart;
+};
+
+#ifdef _OPENMP
+//! The lines of the calling thread, by stream identifier.  These are never
+//! freed, so that they may be used until the program exits.
+std::map<size_t, ThreadLine>* threadLines = NULL;
+#pragma omp threadprivate(threadLines)
+
+//! Get the line the calling thread is giving to the given stream.
+ThreadLine& GetThreadLine(const size_t id)
+{
+  if (threadLines == NULL)
+    threadLines = new std::map<size_t, ThreadLine>();
+  return (*threadLines)[id];
+}
+#endif
+
+}; // anonymous namespace
+
 /**
  * These are all necessary because gcc's template mechanism does not seem smart
  * enough to figure out what I want to pass into operator<< without these.  That
@@ -140,3 +176,91 @@ PrefixedOutStream& PrefixedOutStream::operator<<(
   BaseLogic<std::ios_base& (*)(std::ios_base&)>(pf);
   return *this;
 }
+
+void PrefixedOutStream::Append(const std::string& text)
+{
+  bool& lineStart = LineStart();
+
+  // Put the prefix at the start of each line.
+  std::string out;
+  bool newlined = false;
+  size_t nl;
+  size_t pos = 0;
+  while ((nl = text.find('\n', pos)) != std::string::npos)
+  {
+    if (lineStart)
+      out += prefix;
+    out.append(text, pos, nl - pos + 1);
+
+    lineStart = true;
+    newlined = true;
+    pos = nl + 1;
+  }
+
+  if (pos != text.length()) // We need to display the rest.
+  {
+    if (lineStart)
+      out += prefix;
+    out.append(text, pos, std::string::npos);
+    lineStart = false;
+  }
+
+  Write(out);
+
+  // If we displayed a newline and we need to terminate afterwards, do that.
+  if (fatal && newlined)
+    exit(1);
+}
+
+bool& PrefixedOutStream::LineStart()
+{
+#ifdef _OPENMP
+  if (omp_in_parallel())
+    return GetThreadLine(id).lineStart;
+#endif
+
+  return carriageReturned;
+}
+
+void PrefixedOutStream::Write(const std::string& text)
+{
+#ifdef _OPENMP
+  if (omp_in_parallel())
+  {
+    // Only write the lines which are done, all at once.
+    ThreadLine& line = GetThreadLine(id);
+    line.pending += text;
+
+    const size_t end = line.pending.rfind('\n');
+    if (end == std::string::npos)
+      return;
+
+    #pragma omp critical(mlpack_prefixed_out_stream)
+    {
+      destination.write(line.pending.data(), end + 1);
+      destination.flush();
+    }
+
+    line.pending.erase(0, end + 1);
+    return;
+  }
+#endif
+
+  #pragma omp critical(mlpack_prefixed_out_stream)
+  {
+    destination << text;
+    if (text.find('\n') != std::string::npos)
+      destination.flush();
+  }
+}
+
+size_t PrefixedOutStream::NextId()
+{
+  static size_t nextId = 0;
+
+  size_t id;
+  #pragma omp critical(mlpack_prefixed_out_stream_id)
+  id = nextId++;
+
+  return id;
+}
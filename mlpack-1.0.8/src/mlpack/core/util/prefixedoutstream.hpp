@@ -62,6 +62,14 @@ namespace util {
  *
  * These objects are used for the mlpack::Log levels (DEBUG, INFO, WARN, and
  * FATAL).
+ *
+ * Output is safe to give from several OpenMP threads at once.  Outside of a
+ * parallel region, everything is written to the destination immediately; inside
+ * one, each thread collects its own lines and writes each complete line (with
+ * its prefix) at once, so lines from different threads are never mixed.  A
+ * line that a thread has not finished is written when it is.
+ *
+ * If ignoreInput is set, nothing is formatted at all.
  */
 class PrefixedOutStream
 {
@@ -82,7 +90,8 @@ class PrefixedOutStream
       // We want the first call to operator<< to prefix the prefix so we set
       // carriageReturned to true.
       carriageReturned(true),
-      fatal(fatal)
+      fatal(fatal),
+      id(NextId())
     { /* nothing to do */ }
 
   //! Write a bool to the stream.
@@ -171,20 +180,44 @@ class PrefixedOutStream
   void BaseLogic(const T& val);
 
   /**
-   * Output the prefix, but only if we need to and if we are allowed to.
+   * Add the prefix to the start of each line of the given (converted) output
+   * and write it, or, in a parallel region, keep it until the line is done.
+   * Terminates the program afterwards if this is a fatal stream and a line
+   * was ended.
+   *
+   * @param text The output to write.
+   */
+  void Append(const std::string& text);
+
+  //! Return whether the next output of the calling thread starts a line (and
+  //! needs a prefix).  In a parallel region, each thread has its own.
+  bool& LineStart();
+
+  /**
+   * Write the given output to the destination, or, in a parallel region, add
+   * it to the unfinished line of the calling thread and write the lines which
+   * are done.
+   *
+   * @param text The output, with prefixes.
    */
-  inline void PrefixIfNeeded();
+  void Write(const std::string& text);
+
+  //! Return a new identifier for the lines a thread keeps for a stream.
+  static size_t NextId();
 
   //! Contains the prefix we must prepend to each line.
   std::string prefix;
 
   //! If true, the previous call to operator<< encountered a CR, and a prefix
-  //! will be necessary.
+  //! will be necessary (outside of parallel regions).
   bool carriageReturned;
 
   //! If true, the application will terminate with an error code when a CR is
   //! encountered.
   bool fatal;
+
+  //! The identifier of the lines kept for this stream by each thread.
+  size_t id;
 };
 
 }; // namespace util
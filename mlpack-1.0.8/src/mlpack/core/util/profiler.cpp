@@ -0,0 +1,372 @@
+/**
+ * @file profiler.cpp
+ *
+ * Implementation of the Profiler.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "profiler.hpp"
+#include "timers.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+using namespace mlpack;
+
+const Profiler::Handle Profiler::Root = (Profiler::Handle) -1;
+
+namespace {
+
+/**
+ * Durations are counted in a histogram with four buckets for each power of
+ * two ticks (nanoseconds, or cycles): durations below 4 ticks have a bucket
+ * each, and a duration d with highest bit b (b >= 2) goes into bucket
+ * 4 * (b - 1) + (the two bits of d below the highest bit).
+ */
+const size_t numBuckets = 4 * 63;
+
+//! The bucket of the given duration (in ticks).
+size_t Bucket(const uint64_t duration)
+{
+  if (duration < 4)
+    return (size_t) duration;
+
+  size_t bit = 2;
+  while ((duration >> (bit + 1)) != 0)
+    ++bit;
+
+  return 4 * (bit - 1) + (size_t) ((duration >> (bit - 2)) & 3);
+}
+
+//! The smallest duration (in ticks) that falls after the given bucket.
+uint64_t BucketEnd(const size_t bucket)
+{
+  if (bucket < 4)
+    return bucket + 1;
+
+  const size_t bit = bucket / 4 + 1;
+  const uint64_t top = (bucket % 4) + 5;
+  return (bit == 63 && top == 8) ? std::numeric_limits<uint64_t>::max() :
+      (top << (bit - 2));
+}
+
+//! Whether durations are measured with the cycle counter (see
+//! Profiler::UseCycleCounter()).
+bool useCycles = false;
+
+//! The current time, in ticks of the clock in use: nanoseconds, or cycles.
+uint64_t Now()
+{
+  return useCycles ? Timer::Cycles() : Timer::Now();
+}
+
+//! The times of one timer, recorded by one thread.
+struct ThreadTimer
+{
+  ThreadTimer() :
+      start(0),
+      calls(0),
+      total(0),
+      min(std::numeric_limits<uint64_t>::max()),
+      max(0),
+      buckets(numBuckets, 0)
+  { }
+
+  //! When the timer was last started.
+  uint64_t start;
+  //! The number of times the timer was stopped.
+  uint64_t calls;
+  //! The total duration.
+  uint64_t total;
+  //! The shortest duration.
+  uint64_t min;
+  //! The longest duration.
+  uint64_t max;
+  //! The number of durations in each bucket of the histogram.
+  std::vector<uint64_t> buckets;
+};
+
+//! The name and parent of a registered timer.
+struct TimerInfo
+{
+  std::string name;
+  Profiler::Handle parent;
+};
+
+/**
+ * The registered timers, and the times recorded by each thread.  These are
+ * never freed, so that they may be used (for instance, by the CLI destructor)
+ * until the program exits.
+ */
+std::vector<TimerInfo>& Registry()
+{
+  static std::vector<TimerInfo>* registry = new std::vector<TimerInfo>();
+  return *registry;
+}
+
+std::vector<std::vector<ThreadTimer>*>& ThreadTimers()
+{
+  static std::vector<std::vector<ThreadTimer>*>* threadTimers =
+      new std::vector<std::vector<ThreadTimer>*>();
+  return *threadTimers;
+}
+
+//! The times recorded by the calling thread.
+std::vector<ThreadTimer>* localTimers = NULL;
+#pragma omp threadprivate(localTimers)
+
+//! Return the given timer of the calling thread.
+ThreadTimer& LocalTimer(const Profiler::Handle timer)
+{
+  if (localTimers == NULL)
+  {
+    localTimers = new std::vector<ThreadTimer>();
+    #pragma omp critical(mlpack_profiler)
+    ThreadTimers().push_back(localTimers);
+  }
+
+  if (timer >= localTimers->size())
+    localTimers->resize(timer + 1);
+
+  return (*localTimers)[timer];
+}
+
+//! Convert ticks of the clock in use to seconds.
+double Seconds(const uint64_t ticks)
+{
+  return (double) ticks * (useCycles ? Timer::SecondsPerCycle() : 1e-9);
+}
+
+//! Write the given string to a JSON stream, quoted and escaped.
+void WriteJSONString(std::ostream& stream, const std::string& str)
+{
+  stream << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"' || str[i] == '\\')
+      stream << '\\' << str[i];
+    else if (str[i] == '\n')
+      stream << "\\n";
+    else
+      stream << str[i];
+  }
+  stream << '"';
+}
+
+//! Write the given timer and its children to a JSON stream.
+void WriteJSONTimer(std::ostream& stream,
+                    const Profiler::Handle timer,
+                    const size_t indent)
+{
+  const Profiler::Statistics stats = Profiler::Get(timer);
+  const std::string pad(indent, ' ');
+
+  stream << pad << "{ \"name\": ";
+  WriteJSONString(stream, stats.name);
+  stream << ", \"calls\": " << stats.calls << ", \"total\": " << stats.total
+      << ", \"min\": " << stats.min << ", \"mean\": " << stats.mean
+      << ", \"max\": " << stats.max << ", \"p99\": " << stats.p99
+      << ", \"children\": [";
+
+  bool first = true;
+  for (size_t i = 0; i < Registry().size(); ++i)
+  {
+    if (Registry()[i].parent != timer)
+      continue;
+
+    stream << (first ? "\n" : ",\n");
+    WriteJSONTimer(stream, i, indent + 2);
+    first = false;
+  }
+
+  if (!first)
+    stream << "\n" << pad;
+  stream << "] }";
+}
+
+}; // anonymous namespace
+
+Profiler::Handle Profiler::Register(const std::string& name,
+                                    const Handle parent)
+{
+  Handle timer = Root;
+  #pragma omp critical(mlpack_profiler)
+  {
+    for (size_t i = 0; i < Registry().size(); ++i)
+    {
+      if (Registry()[i].name == name && Registry()[i].parent == parent)
+      {
+        timer = i;
+        break;
+      }
+    }
+
+    if (timer == Root)
+    {
+      TimerInfo info;
+      info.name = name;
+      info.parent = parent;
+      Registry().push_back(info);
+      timer = Registry().size() - 1;
+    }
+  }
+
+  return timer;
+}
+
+void Profiler::Start(const Handle timer)
+{
+  ThreadTimer& t = LocalTimer(timer);
+  t.start = Now();
+}
+
+void Profiler::Stop(const Handle timer)
+{
+  const uint64_t now = Now();
+  ThreadTimer& t = LocalTimer(timer);
+  const uint64_t duration = (now > t.start) ? now - t.start : 0;
+
+  ++t.calls;
+  t.total += duration;
+  t.min = std::min(t.min, duration);
+  t.max = std::max(t.max, duration);
+  ++t.buckets[Bucket(duration)];
+}
+
+size_t Profiler::NumTimers()
+{
+  size_t numTimers;
+  #pragma omp critical(mlpack_profiler)
+  numTimers = Registry().size();
+
+  return numTimers;
+}
+
+Profiler::Statistics Profiler::Get(const Handle timer)
+{
+  ThreadTimer merged;
+  Statistics stats;
+
+  #pragma omp critical(mlpack_profiler)
+  {
+    stats.name = Registry()[timer].name;
+    stats.parent = Registry()[timer].parent;
+
+    for (size_t i = 0; i < ThreadTimers().size(); ++i)
+    {
+      if (timer >= ThreadTimers()[i]->size())
+        continue;
+
+      const ThreadTimer& t = (*ThreadTimers()[i])[timer];
+      merged.calls += t.calls;
+      merged.total += t.total;
+      merged.min = std::min(merged.min, t.min);
+      merged.max = std::max(merged.max, t.max);
+      for (size_t b = 0; b < numBuckets; ++b)
+        merged.buckets[b] += t.buckets[b];
+    }
+  }
+
+  stats.calls = merged.calls;
+  stats.total = Seconds(merged.total);
+  if (merged.calls == 0)
+  {
+    stats.min = stats.mean = stats.max = stats.p99 = 0.0;
+    return stats;
+  }
+
+  stats.min = Seconds(merged.min);
+  stats.mean = stats.total / merged.calls;
+  stats.max = Seconds(merged.max);
+
+  // The 99th percentile is in the first bucket where 99% of the durations
+  // have been counted; take the end of that bucket, within [min, max].
+  const uint64_t rank = merged.calls - merged.calls / 100;
+  uint64_t count = 0;
+  size_t bucket = 0;
+  for (; bucket < numBuckets - 1; ++bucket)
+  {
+    count += merged.buckets[bucket];
+    if (count >= rank)
+      break;
+  }
+
+  const uint64_t p99 = std::max(merged.min,
+      std::min(merged.max, BucketEnd(bucket) - 1));
+  stats.p99 = Seconds(p99);
+
+  return stats;
+}
+
+void Profiler::WriteJSON(std::ostream& stream)
+{
+  // No timers are registered while the statistics are requested (see the
+  // documentation of the class), so the registry is read without the lock.
+  stream << "{ \"timers\": [";
+  bool first = true;
+  const size_t numTimers = NumTimers();
+  for (size_t i = 0; i < numTimers; ++i)
+  {
+    if (Registry()[i].parent != Root)
+      continue;
+
+    stream << (first ? "\n" : ",\n");
+    WriteJSONTimer(stream, i, 2);
+    first = false;
+  }
+
+  if (!first)
+    stream << "\n";
+  stream << "] }" << std::endl;
+}
+
+bool Profiler::WriteJSON(const std::string& filename)
+{
+  std::ofstream stream(filename.c_str());
+  if (!stream.is_open())
+    return false;
+
+  WriteJSON(stream);
+  return stream.good();
+}
+
+void Profiler::UseCycleCounter(const bool enabled)
+{
+  // Measure the cycle duration now rather than when the statistics are read.
+  if (enabled)
+    (void) Timer::SecondsPerCycle();
+
+  useCycles = enabled;
+}
+
+bool Profiler::UsesCycleCounter()
+{
+  return useCycles;
+}
+
+void Profiler::Reset()
+{
+  #pragma omp critical(mlpack_profiler)
+  {
+    for (size_t i = 0; i < ThreadTimers().size(); ++i)
+    {
+      std::vector<ThreadTimer>& timers = *ThreadTimers()[i];
+      for (size_t j = 0; j < timers.size(); ++j)
+        timers[j] = ThreadTimer();
+    }
+  }
+}
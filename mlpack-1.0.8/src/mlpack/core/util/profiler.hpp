@@ -0,0 +1,185 @@
+/**
+ * @file profiler.hpp
+ *
+ * A low-overhead, thread-safe profiler with hierarchical timers.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_PROFILER_HPP
+#define __MLPACK_CORE_UTIL_PROFILER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace mlpack {
+
+/**
+ * The Profiler times sections of code with less overhead than Timer, and may
+ * be used from several threads at once.  Each timer is registered once, which
+ * gives a handle; starting and stopping a timer with its handle does no string
+ * lookups and takes no locks, because each thread accumulates its own times.
+ * When the statistics are requested, the times of all threads are merged.
+ *
+ * Timers are organized in a hierarchy: each timer may be registered as the
+ * child of another, and the JSON output nests the children in their parents.
+ * For every timer, the number of calls and the total, minimum, mean, maximum,
+ * and 99th percentile durations are kept; the percentile is estimated from a
+ * logarithmic histogram of the durations, with an error of at most 25%.
+ *
+ * @code
+ * static const Profiler::Handle traversal = Profiler::Register("traversal");
+ * static const Profiler::Handle baseCase = Profiler::Register("base_case",
+ *     traversal);
+ *
+ * #pragma omp parallel for
+ * for (int i = 0; i < n; ++i)
+ * {
+ *   Profiler::Scope scope(baseCase); // Stopped when the scope ends.
+ *   ...
+ * }
+ *
+ * Profiler::WriteJSON("profile.json");
+ * @endcode
+ *
+ * Every program can also write the profile with the --profile_file option.
+ *
+ * @note As with Timer, a timer must not be started twice by the same thread
+ *     without being stopped in between.  The statistics should be requested
+ *     when no timers are running.
+ */
+class Profiler
+{
+ public:
+  //! The handle of a registered timer.
+  typedef size_t Handle;
+
+  //! The parent of the timers at the top of the hierarchy.
+  static const Handle Root;
+
+  //! The statistics of a timer, merged over all threads.
+  struct Statistics
+  {
+    //! The name of the timer.
+    std::string name;
+    //! The parent of the timer (Root if it has none).
+    Handle parent;
+    //! The number of times the timer was stopped.
+    uint64_t calls;
+    //! The total duration, in seconds.
+    double total;
+    //! The shortest duration, in seconds.
+    double min;
+    //! The mean duration, in seconds.
+    double mean;
+    //! The longest duration, in seconds.
+    double max;
+    //! The (estimated) 99th percentile of the durations, in seconds.
+    double p99;
+  };
+
+  /**
+   * Register a timer, and return its handle.  If a timer with the same name
+   * and parent is already registered, its handle is returned.  This is
+   * thread-safe, but is slower than starting and stopping timers, so it should
+   * be done once for each timer (for instance, in a static variable).
+   *
+   * @param name Name of the timer.
+   * @param parent Handle of the parent timer (Root if it has none).
+   */
+  static Handle Register(const std::string& name, const Handle parent = Root);
+
+  /**
+   * Start the given timer on the calling thread.
+   *
+   * @param timer Handle of the timer.
+   */
+  static void Start(const Handle timer);
+
+  /**
+   * Stop the given timer on the calling thread, and record the duration since
+   * it was started.
+   *
+   * @param timer Handle of the timer.
+   */
+  static void Stop(const Handle timer);
+
+  /**
+   * Times the scope it is declared in: the timer is started when the Scope is
+   * created and stopped when it is destroyed.
+   */
+  class Scope
+  {
+   public:
+    //! Start the given timer.
+    Scope(const Handle timer) : timer(timer) { Profiler::Start(timer); }
+    //! Stop the timer.
+    ~Scope() { Profiler::Stop(timer); }
+
+   private:
+    //! The timer that is running.
+    Handle timer;
+  };
+
+  //! Return the number of registered timers.
+  static size_t NumTimers();
+
+  /**
+   * Return the statistics of the given timer, merged over all threads.
+   *
+   * @param timer Handle of the timer.
+   */
+  static Statistics Get(const Handle timer);
+
+  /**
+   * Write the statistics of all the timers to the given stream as JSON, with
+   * the children of each timer nested in it.
+   *
+   * @param stream Stream to write to.
+   */
+  static void WriteJSON(std::ostream& stream);
+
+  /**
+   * Write the statistics of all the timers to the given file as JSON.
+   *
+   * @param filename Name of the file to write to.
+   * @return Whether the file was written.
+   */
+  static bool WriteJSON(const std::string& filename);
+
+  //! Clear the recorded times of every timer (the timers stay registered).
+  static void Reset();
+
+  /**
+   * Measure durations with the cycle counter of the processor (see
+   * Timer::Cycles()) instead of the monotonic clock, which makes starting and
+   * stopping timers cheaper in hot paths; the statistics are still given in
+   * seconds.  This should only be changed when no timers are running, and
+   * followed by Reset(), since the times recorded so far are in the units of
+   * the previous clock.
+   *
+   * @param enabled Whether to use the cycle counter.
+   */
+  static void UseCycleCounter(const bool enabled);
+
+  //! Return whether durations are measured with the cycle counter.
+  static bool UsesCycleCounter();
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_PROFILER_HPP
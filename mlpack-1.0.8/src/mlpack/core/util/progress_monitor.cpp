@@ -0,0 +1,74 @@
+/**
+ * @file progress_monitor.cpp
+ *
+ * Implementation of ProgressMonitor.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "progress_monitor.hpp"
+
+#include "timers.hpp"
+
+using namespace mlpack;
+
+namespace {
+
+//! Return the time in seconds from an arbitrary (fixed) point, with a monotonic
+//! clock (see Timer::Now()).
+double Now()
+{
+  return 1e-9 * (double) Timer::Now();
+}
+
+}; // anonymous namespace
+
+ProgressMonitor::ProgressMonitor(const double timeLimit) :
+    timeLimit(timeLimit),
+    start(Now()),
+    cancelled(false),
+    stopped(false)
+{
+  // Nothing to do.
+}
+
+bool ProgressMonitor::Continue(const std::string& task,
+                               const size_t step,
+                               const double value)
+{
+  if (!stopped)
+  {
+    if (cancelled)
+      stopped = true;
+    else if (timeLimit > 0.0 && Elapsed() >= timeLimit)
+      stopped = true;
+    else if (!Report(task, step, value))
+      stopped = true;
+  }
+
+  return !stopped;
+}
+
+double ProgressMonitor::Elapsed() const
+{
+  return Now() - start;
+}
+
+void ProgressMonitor::Reset()
+{
+  start = Now();
+  cancelled = false;
+  stopped = false;
+}
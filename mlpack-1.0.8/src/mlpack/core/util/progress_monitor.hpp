@@ -0,0 +1,139 @@
+/**
+ * @file progress_monitor.hpp
+ *
+ * A monitor which observes the progress of long-running methods and can stop
+ * them.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_PROGRESS_MONITOR_HPP
+#define __MLPACK_CORE_UTIL_PROGRESS_MONITOR_HPP
+
+#include <string>
+#include <stddef.h>
+
+namespace mlpack {
+
+/**
+ * A ProgressMonitor observes the progress of a long-running method and can
+ * stop it early.  Methods which accept a monitor (through their Monitor()
+ * accessor) call Continue() once per iteration, or once per batch of query
+ * points for the tree searches, and stop as soon as it returns false, keeping
+ * the result of the last finished iteration.  Methods are stopped when:
+ *
+ *  - Cancel() has been called (possibly from another thread);
+ *  - the time limit given to the constructor has passed; or
+ *  - Report(), which a subclass may override, returns false.
+ *
+ * Once a monitor has stopped a method, Stopped() is true and Continue() keeps
+ * returning false, until Reset() is called.  When no monitor is given (the
+ * default), the methods only test a NULL pointer once per iteration.
+ *
+ * The methods which accept a monitor, with the step and value they report:
+ *
+ *  - kmeans::KMeans::Cluster() and FastCluster(): the iteration, and the
+ *    number of changed assignments;
+ *  - gmm::EMFit::Estimate(): the iteration, and the log-likelihood (and
+ *    gmm::GMM::Estimate() runs no further trials once EM is stopped);
+ *  - hmm::HMM::Train(): the iteration, and the log-likelihood;
+ *  - nmf::NMF::Apply(): the iteration, and the residue;
+ *  - neighbor::NeighborSearch::Search() and range::RangeSearch::Search(): the
+ *    number of batches of query points searched, and the fraction of query
+ *    points searched.  The results of the query points which were not
+ *    searched are left at their initial values.
+ *
+ * For instance, to stop EM after 200 milliseconds with the best model so far:
+ *
+ * @code
+ * ProgressMonitor monitor(0.2);
+ * gmm::GMM<> gmm(gaussians, dimensionality);
+ * gmm.Fitter().Monitor() = &monitor;
+ * gmm.Estimate(data);
+ * if (monitor.Stopped())
+ *   ...
+ * @endcode
+ */
+class ProgressMonitor
+{
+ public:
+  /**
+   * Create the monitor and start its clock.
+   *
+   * @param timeLimit Time (in seconds) after which methods are stopped; 0
+   *      means there is no limit.
+   */
+  ProgressMonitor(const double timeLimit = 0.0);
+
+  //! Destroy the monitor.
+  virtual ~ProgressMonitor() { }
+
+  /**
+   * Called by methods at each step; return whether the method should go on.
+   * Methods call this from one thread at a time.
+   *
+   * @param task Name of the method (for instance, "EMFit::Estimate()").
+   * @param step Number of the step which was just finished (from 1).
+   * @param value Measure of progress of the method (see above).
+   */
+  bool Continue(const std::string& task, const size_t step, const double value);
+
+  //! Stop the method at its next step.  This may be called from any thread.
+  void Cancel() { cancelled = true; }
+
+  //! Return whether a method was stopped by this monitor.
+  bool Stopped() const { return stopped; }
+
+  //! Return the time (in seconds) since the monitor was created or reset.
+  double Elapsed() const;
+
+  //! Restart the clock, and clear the cancellation and the stopped state.
+  void Reset();
+
+  //! Get the time limit (in seconds; 0 means there is no limit).
+  double TimeLimit() const { return timeLimit; }
+  //! Modify the time limit (in seconds; 0 means there is no limit).
+  double& TimeLimit() { return timeLimit; }
+
+ protected:
+  /**
+   * Report the progress of a method; return false to stop it.  The default
+   * implementation does nothing and returns true.
+   *
+   * @param task Name of the method.
+   * @param step Number of the step which was just finished (from 1).
+   * @param value Measure of progress of the method.
+   */
+  virtual bool Report(const std::string& /* task */,
+                      const size_t /* step */,
+                      const double /* value */)
+  {
+    return true;
+  }
+
+ private:
+  //! The time limit, in seconds (0 if there is no limit).
+  double timeLimit;
+  //! The time at which the clock was started, in seconds.
+  double start;
+  //! Whether Cancel() was called.
+  volatile bool cancelled;
+  //! Whether a method was stopped.
+  bool stopped;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_PROGRESS_MONITOR_HPP
@@ -3,7 +3,8 @@
  * @author Neil Slagle
  *
  * The SaveRestoreUtility provides helper functions in saving and
- *   restoring models.  The current output file type is XML.
+ *   restoring models.  Models are written either as XML or as a versioned
+ *   binary archive.
  *
  * This file is part of MLPACK 1.0.8.
  *
@@ -22,11 +23,201 @@
  */
 #include "save_restore_utility.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::util;
 
+/**
+ * The binary archive is laid out as follows; every integer is a little-endian
+ * uint64, and every string is its length followed by its characters.
+ *
+ *  - the magic string "MLPKPARM" (8 bytes);
+ *  - the version of the format;
+ *  - the number of string parameters, followed by the name and value of each;
+ *  - the number of matrices, followed by, for each matrix, its name, number of
+ *    rows and number of columns, padding up to a multiple of 8 bytes, and its
+ *    elements as little-endian doubles in column-major order.
+ */
+namespace {
+
+const char archiveMagic[] = "MLPKPARM";
+const size_t archiveMagicLength = 8;
+const uint64_t archiveVersion = 1;
+
+//! Whether this machine stores numbers little-endian.
+bool LittleEndian()
+{
+  const uint16_t one = 1;
+  return (*((const unsigned char*) &one) == 1);
+}
+
+//! Reverse the bytes of every element of the given array (of 8-byte values).
+void SwapBytes(char* data, const size_t elements)
+{
+  for (size_t i = 0; i < elements; ++i)
+    std::reverse(data + 8 * i, data + 8 * (i + 1));
+}
+
+void WriteUint64(std::ofstream& stream, const uint64_t value)
+{
+  unsigned char bytes[8];
+  for (size_t i = 0; i < 8; ++i)
+    bytes[i] = (unsigned char) (value >> (8 * i));
+  stream.write((const char*) bytes, 8);
+}
+
+void WriteString(std::ofstream& stream, const std::string& str)
+{
+  WriteUint64(stream, str.size());
+  stream.write(str.data(), str.size());
+}
+
+//! Write the given matrix as text, as stored in the XML tree.
+std::string MatrixToString(const arma::mat& mat)
+{
+  std::ostringstream output;
+  size_t columns = mat.n_cols;
+  size_t rows = mat.n_rows;
+  for (size_t r = 0; r < rows; ++r)
+  {
+    for (size_t c = 0; c < columns - 1; ++c)
+    {
+      output << mat(r,c) << ",";
+    }
+    output << mat(r,columns - 1) << std::endl;
+  }
+  return output.str();
+}
+
+}; // anonymous namespace
+
+/**
+ * The contents of a binary archive: the file is memory-mapped if possible, and
+ * otherwise read into memory.
+ */
+class SaveRestoreUtility::ArchiveFile
+{
+ public:
+  ArchiveFile() : data(NULL), size(0), mapped(false) { }
+
+  ~ArchiveFile()
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(data, size);
+#endif
+  }
+
+  //! Map (or read) the given file.
+  bool Open(const std::string& filename)
+  {
+#ifndef _WIN32
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+      struct stat fileStat;
+      if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+      {
+        void* map = mmap(NULL, (size_t) fileStat.st_size, PROT_READ,
+            MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+          data = (char*) map;
+          size = (size_t) fileStat.st_size;
+          mapped = true;
+        }
+      }
+      close(fd);
+      if (mapped)
+        return true;
+    }
+#endif
+
+    std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (!stream.is_open())
+      return false;
+
+    buffer.resize((size_t) stream.tellg());
+    stream.seekg(0);
+    if (!buffer.empty())
+      stream.read(&buffer[0], buffer.size());
+    data = buffer.empty() ? NULL : &buffer[0];
+    size = buffer.size();
+    return !stream.fail();
+  }
+
+  //! Read a uint64 at the given offset, which is advanced past it.
+  bool ReadUint64(size_t& offset, uint64_t& value) const
+  {
+    if (offset + 8 > size)
+      return false;
+
+    value = 0;
+    for (size_t i = 0; i < 8; ++i)
+      value |= ((uint64_t) (unsigned char) data[offset + i]) << (8 * i);
+    offset += 8;
+    return true;
+  }
+
+  //! Read a string at the given offset, which is advanced past it.
+  bool ReadString(size_t& offset, std::string& str) const
+  {
+    uint64_t length;
+    if (!ReadUint64(offset, length) || length > size - offset)
+      return false;
+
+    str.assign(data + offset, (size_t) length);
+    offset += (size_t) length;
+    return true;
+  }
+
+  //! Get the contents of the file.
+  const char* Data() const { return data; }
+  //! Get the size of the file.
+  size_t Size() const { return size; }
+
+ private:
+  //! The contents of the file.
+  char* data;
+  //! The size of the file.
+  size_t size;
+  //! If true, data is mapped and must be unmapped.
+  bool mapped;
+  //! The contents of the file, if it could not be mapped.
+  std::vector<char> buffer;
+
+  // Copying would unmap the file twice.
+  ArchiveFile(const ArchiveFile&);
+  ArchiveFile& operator=(const ArchiveFile&);
+};
+
 bool SaveRestoreUtility::ReadFile(const std::string& filename)
 {
+  parameters.clear();
+  matrices.clear();
+  archiveMatrices.clear();
+  archive.reset();
+
+  // Binary archives are recognized by their magic string.
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    char magic[archiveMagicLength];
+    if (stream.read(magic, archiveMagicLength) &&
+        memcmp(magic, archiveMagic, archiveMagicLength) == 0)
+      return ReadBinaryFile(filename);
+  }
+
   xmlDocPtr xmlDocTree = NULL;
   if (NULL == (xmlDocTree = xmlReadFile(filename.c_str(), NULL, 0)))
   {
@@ -34,7 +225,6 @@ bool SaveRestoreUtility::ReadFile(const std::string& filename)
   }
 
   xmlNodePtr root = xmlDocGetRootElement(xmlDocTree);
-  parameters.clear();
 
   RecurseOnNodes(root->children);
   xmlFreeDoc(xmlDocTree);
@@ -56,16 +246,165 @@ void SaveRestoreUtility::RecurseOnNodes(xmlNode* n)
   }
 }
 
+bool SaveRestoreUtility::ReadBinaryFile(const std::string& filename)
+{
+  archive.reset(new ArchiveFile());
+  if (!archive->Open(filename))
+  {
+    archive.reset();
+    Log::Fatal << "Could not read binary file '" << filename << "'!"
+        << std::endl;
+    return false;
+  }
+
+  size_t offset = archiveMagicLength;
+  uint64_t version, count;
+  bool valid = archive->ReadUint64(offset, version) &&
+      (version == archiveVersion) && archive->ReadUint64(offset, count);
+
+  for (uint64_t i = 0; valid && i < count; ++i)
+  {
+    std::string name, value;
+    valid = archive->ReadString(offset, name) &&
+        archive->ReadString(offset, value);
+    if (valid)
+      parameters[name] = value;
+  }
+
+  valid = valid && archive->ReadUint64(offset, count);
+  for (uint64_t i = 0; valid && i < count; ++i)
+  {
+    std::string name;
+    uint64_t rows, cols;
+    valid = archive->ReadString(offset, name) &&
+        archive->ReadUint64(offset, rows) && archive->ReadUint64(offset, cols);
+    if (!valid)
+      break;
+
+    // The elements are aligned to 8 bytes, and are not read yet.
+    offset = (offset + 7) & ~((size_t) 7);
+    const uint64_t elements = rows * cols;
+    if (offset > archive->Size() || (cols != 0 && elements / cols != rows) ||
+        elements > (archive->Size() - offset) / sizeof(double))
+    {
+      valid = false;
+      break;
+    }
+
+    MatrixRecord& record = archiveMatrices[name];
+    record.rows = (size_t) rows;
+    record.cols = (size_t) cols;
+    record.offset = offset;
+    offset += (size_t) elements * sizeof(double);
+  }
+
+  if (!valid)
+  {
+    parameters.clear();
+    archiveMatrices.clear();
+    archive.reset();
+    Log::Fatal << "Binary file '" << filename << "' is corrupt or of an "
+        << "unsupported version!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool SaveRestoreUtility::WriteBinaryFile(const std::string& filename)
+{
+  // Every matrix, including those still in an archive, is written.
+  std::map<std::string, arma::mat> allMatrices;
+  for (std::map<std::string, MatrixRecord>::iterator it =
+       archiveMatrices.begin(); it != archiveMatrices.end(); ++it)
+    LoadParameter(allMatrices[(*it).first], (*it).first);
+  for (std::map<std::string, arma::mat>::iterator it = matrices.begin();
+       it != matrices.end(); ++it)
+    allMatrices[(*it).first] = (*it).second;
+
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return false;
+
+  stream.write(archiveMagic, archiveMagicLength);
+  WriteUint64(stream, archiveVersion);
+
+  WriteUint64(stream, parameters.size());
+  for (std::map<std::string, std::string>::iterator it = parameters.begin();
+       it != parameters.end(); ++it)
+  {
+    WriteString(stream, (*it).first);
+    WriteString(stream, (*it).second);
+  }
+
+  WriteUint64(stream, allMatrices.size());
+  size_t offset = (size_t) stream.tellp();
+  for (std::map<std::string, arma::mat>::iterator it = allMatrices.begin();
+       it != allMatrices.end(); ++it)
+  {
+    const arma::mat& matrix = (*it).second;
+    WriteString(stream, (*it).first);
+    WriteUint64(stream, matrix.n_rows);
+    WriteUint64(stream, matrix.n_cols);
+    offset += 8 * 3 + (*it).first.size();
+
+    const char padding[8] = { 0 };
+    const size_t paddingLength = ((offset + 7) & ~((size_t) 7)) - offset;
+    stream.write(padding, paddingLength);
+    offset += paddingLength;
+
+    if (LittleEndian())
+    {
+      stream.write((const char*) matrix.memptr(),
+          matrix.n_elem * sizeof(double));
+    }
+    else
+    {
+      arma::mat swapped(matrix);
+      SwapBytes((char*) swapped.memptr(), swapped.n_elem);
+      stream.write((const char*) swapped.memptr(),
+          swapped.n_elem * sizeof(double));
+    }
+    offset += matrix.n_elem * sizeof(double);
+  }
+
+  return stream.good();
+}
+
 bool SaveRestoreUtility::WriteFile(const std::string& filename)
 {
+  const size_t ext = filename.rfind('.');
+  if (ext != std::string::npos)
+  {
+    std::string extension = filename.substr(ext + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        ::tolower);
+    if (extension == "bin")
+      return WriteBinaryFile(filename);
+  }
+
+  // Matrices are stored as text in the XML tree.
+  std::map<std::string, std::string> allParameters(parameters);
+  for (std::map<std::string, MatrixRecord>::iterator it =
+       archiveMatrices.begin(); it != archiveMatrices.end(); ++it)
+  {
+    arma::mat matrix;
+    allParameters[(*it).first] =
+        MatrixToString(LoadParameter(matrix, (*it).first));
+  }
+  for (std::map<std::string, arma::mat>::iterator it = matrices.begin();
+       it != matrices.end(); ++it)
+    allParameters[(*it).first] = MatrixToString((*it).second);
+
   bool success = false;
   xmlDocPtr xmlDocTree = xmlNewDoc(BAD_CAST "1.0");
   xmlNodePtr root = xmlNewNode(NULL, BAD_CAST "root");
 
   xmlDocSetRootElement(xmlDocTree, root);
 
-  for (std::map<std::string, std::string>::iterator it = parameters.begin();
-       it != parameters.end();
+  for (std::map<std::string, std::string>::iterator it =
+       allParameters.begin();
+       it != allParameters.end();
        ++it)
   {
     xmlNewChild(root, NULL, BAD_CAST(*it).first.c_str(),
@@ -84,6 +423,27 @@ bool SaveRestoreUtility::WriteFile(const std::string& filename)
 arma::mat& SaveRestoreUtility::LoadParameter(arma::mat& matrix,
                                              const std::string& name)
 {
+  std::map<std::string, arma::mat>::iterator matrixIt = matrices.find(name);
+  if (matrixIt != matrices.end())
+    return matrix = (*matrixIt).second;
+
+  // Matrices in a binary archive are copied out of the file now.
+  std::map<std::string, MatrixRecord>::iterator recordIt =
+      archiveMatrices.find(name);
+  if (recordIt != archiveMatrices.end())
+  {
+    const MatrixRecord& record = (*recordIt).second;
+    matrix.set_size(record.rows, record.cols);
+    if (matrix.n_elem > 0)
+    {
+      memcpy(matrix.memptr(), archive->Data() + record.offset,
+          matrix.n_elem * sizeof(double));
+      if (!LittleEndian())
+        SwapBytes((char*) matrix.memptr(), matrix.n_elem);
+    }
+    return matrix;
+  }
+
   std::map<std::string, std::string>::iterator it = parameters.find(name);
   if (it != parameters.end())
   {
@@ -184,18 +544,10 @@ void SaveRestoreUtility::SaveParameter(const char c, const std::string& name)
 void SaveRestoreUtility::SaveParameter(const arma::mat& mat,
                                        const std::string& name)
 {
-  std::ostringstream output;
-  size_t columns = mat.n_cols;
-  size_t rows = mat.n_rows;
-  for (size_t r = 0; r < rows; ++r)
-  {
-    for (size_t c = 0; c < columns - 1; ++c)
-    {
-      output << mat(r,c) << ",";
-    }
-    output << mat(r,columns - 1) << std::endl;
-  }
-  parameters[name] = output.str();
+  // The matrix is only converted to text if it is written to an XML tree.
+  parameters.erase(name);
+  archiveMatrices.erase(name);
+  matrices[name] = mat;
 }
 
 // Special template specializations for vectors.
@@ -33,12 +33,30 @@
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/tokenizer.hpp>
 #include <mlpack/core.hpp>
 
 namespace mlpack {
 namespace util {
 
+/**
+ * The SaveRestoreUtility stores named parameters of a model and writes them to
+ * (or reads them from) a file.  Two file formats are supported:
+ *
+ *  - XML, where every parameter (matrices included) is stored as text; this is
+ *    the format used unless the filename has the extension ".bin".
+ *
+ *  - A versioned binary archive, used when the filename has the extension
+ *    ".bin".  Other parameters are stored as length-prefixed strings, but
+ *    matrices are stored as raw little-endian doubles, so they are saved and
+ *    loaded without any text conversion or loss of precision.  When such a
+ *    file is read, it is memory-mapped (where possible) and a matrix is only
+ *    copied out of the file when LoadParameter() is called for it.
+ *
+ * ReadFile() detects the format from the contents of the file, not from its
+ * name.
+ */
 class SaveRestoreUtility
 {
  private:
@@ -47,22 +65,58 @@ class SaveRestoreUtility
    */
   std::map<std::string, std::string> parameters;
 
+  /**
+   * matrices contains the matrices given to SaveParameter().
+   */
+  std::map<std::string, arma::mat> matrices;
+
+  //! The location of a matrix in a binary archive that has been read.
+  struct MatrixRecord
+  {
+    //! Number of rows of the matrix.
+    size_t rows;
+    //! Number of columns of the matrix.
+    size_t cols;
+    //! Offset of the elements of the matrix in the file.
+    size_t offset;
+  };
+
+  /**
+   * archiveMatrices contains the matrices of the binary archive last read,
+   * which are not copied out of the file until they are loaded.
+   */
+  std::map<std::string, MatrixRecord> archiveMatrices;
+
+  //! The contents of a binary archive (defined in the .cpp file).
+  class ArchiveFile;
+
+  //! The binary archive last read, shared between copies of this object.
+  boost::shared_ptr<ArchiveFile> archive;
+
   /**
    * RecurseOnNodes performs a depth first search of the XML tree.
    */
   void RecurseOnNodes(xmlNode* n);
 
+  //! Read a binary archive, after its magic string has been checked.
+  bool ReadBinaryFile(const std::string& filename);
+
+  //! Write the parameters and matrices to a binary archive.
+  bool WriteBinaryFile(const std::string& filename);
+
  public:
   SaveRestoreUtility() {}
   ~SaveRestoreUtility() { parameters.clear(); }
 
   /**
-   * ReadFile reads an XML tree from a file.
+   * ReadFile reads a previously written XML tree or binary archive from a
+   * file.
    */
   bool ReadFile(const std::string& filename);
 
   /**
-   * WriteFile writes the XML tree to a file.
+   * WriteFile writes the parameters to a file: a binary archive if the
+   * extension of the file is ".bin", and an XML tree otherwise.
    */
   bool WriteFile(const std::string& filename);
 
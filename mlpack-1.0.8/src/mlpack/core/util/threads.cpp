@@ -0,0 +1,64 @@
+/**
+ * @file threads.cpp
+ *
+ * Implementation of the Threads class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "threads.hpp"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+
+size_t Threads::limit = 0;
+
+void Threads::SetLimit(const size_t threads)
+{
+  limit = threads;
+}
+
+size_t Threads::Limit()
+{
+  return limit;
+}
+
+size_t Threads::Available()
+{
+  return Count(0);
+}
+
+size_t Threads::Count(const size_t requested)
+{
+#ifdef _OPENMP
+  if (omp_in_parallel())
+    return 1;
+
+  size_t threads = (requested == 0) ? (size_t) omp_get_max_threads() :
+      requested;
+  if (limit != 0)
+    threads = std::min(threads, limit);
+
+  return std::max(threads, (size_t) 1);
+#else
+  (void) requested;
+  return 1;
+#endif
+}
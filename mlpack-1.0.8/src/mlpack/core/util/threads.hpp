@@ -0,0 +1,96 @@
+/**
+ * @file threads.hpp
+ *
+ * The Threads class, which decides how many threads each parallel part of
+ * MLPACK runs with, under a limit shared by all methods.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_CORE_UTIL_THREADS_HPP
+#define __MLPACK_CORE_UTIL_THREADS_HPP
+
+#include <stddef.h>
+
+namespace mlpack {
+
+/**
+ * The Threads class decides how many threads each parallel part of MLPACK
+ * (tree building and traversal, the E-step of EM, the coding step of sparse
+ * coding, loading text files, and so on) runs with.  Every method which takes
+ * a number of threads, where 0 means "all available cores", passes it through
+ * Count(), so that:
+ *
+ *  - 0 means the number of threads OpenMP would use (omp_get_max_threads(),
+ *    which follows OMP_NUM_THREADS);
+ *  - no method uses more threads than the limit, if one is set, so that
+ *    several parallel parts do not together oversubscribe the machine;
+ *  - inside a parallel region (for instance, when the jobs of mlpack_batch or
+ *    the folds of cross-validation run in parallel), the nested method runs
+ *    with one thread;
+ *  - without OpenMP, everything runs with one thread.
+ *
+ * @code
+ * // Use at most 4 threads, whatever the methods are asked for.
+ * Threads::SetLimit(4);
+ *
+ * const size_t numThreads = Threads::Count(threads);
+ * #pragma omp parallel num_threads(numThreads)
+ * ...
+ * @endcode
+ *
+ * Every program also sets the limit with the --max_threads option.
+ */
+class Threads
+{
+ public:
+  /**
+   * Set the most threads any method may use at once.  A limit of 0 means
+   * there is no limit.
+   *
+   * @param threads New limit on the number of threads.
+   */
+  static void SetLimit(const size_t threads);
+
+  //! Get the limit on the number of threads (0 if there is no limit).
+  static size_t Limit();
+
+  //! Return whether there is a limit on the number of threads.
+  static bool Limited() { return (Limit() != 0); }
+
+  /**
+   * Return the number of threads "all available cores" stands for: the number
+   * of threads OpenMP would use, under the limit.  This is 1 inside a
+   * parallel region, and without OpenMP.
+   */
+  static size_t Available();
+
+  /**
+   * Return the number of threads to run with when the given number was asked
+   * for: Available() if it is 0, or else the given number under the limit.
+   * This is 1 inside a parallel region, and without OpenMP.
+   *
+   * @param requested Number of threads asked for (0 means all available).
+   */
+  static size_t Count(const size_t requested);
+
+ private:
+  //! The limit on the number of threads (0 if there is no limit).
+  static size_t limit;
+};
+
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_UTIL_THREADS_HPP
@@ -21,34 +21,37 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "timers.hpp"
-#include "cli.hpp"
 #include "log.hpp"
+#include "memory_budget.hpp"
 
+#include <cmath>
+#include <iomanip>
 #include <map>
 #include <string>
 
 using namespace mlpack;
 
-// On Windows machines, we need to define timersub.
-#ifdef _WIN32
-inline void timersub(const timeval* tvp, const timeval* uvp, timeval* vvp)
+namespace {
+
+//! Convert a number of nanoseconds to a timeval.
+timeval ToTimeval(const uint64_t nanoseconds)
 {
-  vvp->tv_sec = tvp->tv_sec - uvp->tv_sec;
-  vvp->tv_usec = tvp->tv_usec - uvp->tv_usec;
-  if (vvp->tv_usec < 0)
-  {
-     --vvp->tv_sec;
-     vvp->tv_usec += 1000000;
-  }
+  timeval tv;
+  tv.tv_sec = (long) (nanoseconds / 1000000000);
+  tv.tv_usec = (long) ((nanoseconds % 1000000000) / 1000);
+  return tv;
 }
-#endif
+
+}; // anonymous namespace
 
 /**
  * Start the given timer.
  */
 void Timer::Start(const std::string& name)
 {
-  CLI::GetSingleton().timer.StartTimer(name);
+  // Methods may be run from several threads at once (see mlpack_batch).
+  #pragma omp critical(mlpack_timers)
+  GetTimers().StartTimer(name);
 }
 
 /**
@@ -56,7 +59,9 @@ void Timer::Start(const std::string& name)
  */
 void Timer::Stop(const std::string& name)
 {
-  CLI::GetSingleton().timer.StopTimer(name);
+  // Methods may be run from several threads at once (see mlpack_batch).
+  #pragma omp critical(mlpack_timers)
+  GetTimers().StopTimer(name);
 }
 
 /**
@@ -64,25 +69,112 @@ void Timer::Stop(const std::string& name)
  */
 timeval Timer::Get(const std::string& name)
 {
-  return CLI::GetSingleton().timer.GetTimer(name);
+  return ToTimeval(GetNanoseconds(name));
+}
+
+/**
+ * Get the given timer in nanoseconds.
+ */
+uint64_t Timer::GetNanoseconds(const std::string& name)
+{
+  uint64_t value;
+  #pragma omp critical(mlpack_timers)
+  value = GetTimers().GetTimerNanoseconds(name);
+  return value;
+}
+
+/**
+ * Get all of the timers.
+ */
+Timers& Timer::GetTimers()
+{
+  // This is never deleted, because the CLI singleton prints the timers when it
+  // is destroyed at exit, possibly after function-local statics are gone.
+  static Timers* timers = new Timers();
+  return *timers;
+}
+
+uint64_t Timer::Now()
+{
+#if defined(__MACH__) && defined(__APPLE__)
+  static mach_timebase_info_data_t info;
+  if (info.denom == 0)
+    (void) mach_timebase_info(&info);
+
+  // Split the conversion so that the multiplication does not overflow.
+  const uint64_t ticks = mach_absolute_time();
+  return (ticks / info.denom) * info.numer +
+      (ticks % info.denom) * info.numer / info.denom;
+#elif defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (uint64_t) ((double) counter.QuadPart * 1e9 /
+      (double) frequency.QuadPart);
+#elif defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+#else
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint64_t) tv.tv_sec * 1000000000 + (uint64_t) tv.tv_usec * 1000;
+#endif
+}
+
+double Timer::SecondsPerCycle()
+{
+  static double secondsPerCycle = 0.0;
+
+  #pragma omp critical(mlpack_cycles)
+  {
+    if (secondsPerCycle == 0.0)
+    {
+      // Count the cycles over about 10 milliseconds of the monotonic clock.
+      const uint64_t startTime = Now();
+      const uint64_t startCycles = Cycles();
+      uint64_t time = startTime;
+      while (time - startTime < 10000000)
+        time = Now();
+      const uint64_t cycles = Cycles() - startCycles;
+
+      secondsPerCycle = (cycles == 0) ? 1e-9 :
+          1e-9 * (double) (time - startTime) / (double) cycles;
+    }
+  }
+
+  return secondsPerCycle;
 }
 
-std::map<std::string, timeval>& Timers::GetAllTimers()
+std::map<std::string, timeval> Timers::GetAllTimers()
 {
-  return timers;
+  std::map<std::string, timeval> values;
+  std::map<std::string, uint64_t>::const_iterator it;
+  for (it = timers.begin(); it != timers.end(); ++it)
+    values[it->first] = ToTimeval(it->second);
+
+  return values;
 }
 
 timeval Timers::GetTimer(const std::string& timerName)
 {
-  std::string name(timerName);
-  return timers[name];
+  return ToTimeval(GetTimerNanoseconds(timerName));
+}
+
+uint64_t Timers::GetTimerNanoseconds(const std::string& timerName)
+{
+  return timers[timerName];
 }
 
 void Timers::PrintTimer(const std::string& timerName)
 {
-  timeval& t = timers[timerName];
-  Log::Info << t.tv_sec << "." << std::setw(6) << std::setfill('0')
-      << t.tv_usec << "s";
+  const uint64_t nanoseconds = timers[timerName];
+  const timeval t = ToTimeval(nanoseconds);
+  Log::Info << t.tv_sec << "." << std::setw(9) << std::setfill('0')
+      << (nanoseconds % 1000000000) << "s";
 
   // Also output convenient day/hr/min/sec.
   int days = t.tv_sec / 86400; // Integer division rounds down.
@@ -133,140 +225,68 @@ void Timers::PrintTimer(const std::string& timerName)
   Log::Info << std::endl;
 }
 
-void Timers::GetTime(timeval* tv)
+void Timers::StartTimer(const std::string& timerName)
 {
-#if defined(__MACH__) && defined(__APPLE__)
-  
-  static mach_timebase_info_data_t info;
-  
-  // If this is the first time we've run, get the timebase.
-  // We can use denom == 0 to indicate that sTimebaseInfo is
-  // uninitialised.
-  if (info.denom == 0) {
-    (void) mach_timebase_info(&info);
-  }
-  
-  // Hope that the multiplication doesn't overflow.
-  uint64_t nsecs = mach_absolute_time() * info.numer / info.denom;  
-  tv->tv_sec = nsecs / 1e9;
-  tv->tv_usec = (nsecs / 1e3) - (tv->tv_sec * 1e6);
-  
-#elif defined(_POSIX_VERSION)
-#if defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0)
-
-  // Get the right clock_id.
-#if defined(CLOCK_MONOTONIC_PRECISE)
-  static const clockid_t id = CLOCK_MONOTONIC_PRECISE;
-#elif defined(CLOCK_MONOTONIC_RAW)
-  static const clockid_t id = CLOCK_MONOTONIC_RAW;
-#elif defined(CLOCK_MONOTONIC)
-  static const clockid_t id = CLOCK_MONOTONIC;
-#elif defined(CLOCK_REALTIME)
-  static const clockid_t id = CLOCK_REALTIME;
-#else
-  static const clockid_t id = ((clockid_t) - 1);
-#endif // CLOCK
-  
-  struct timespec ts;
-  
-  // Returns the current value tp for the specified clock_id.
-  if (clock_gettime(id, &ts) != -1 && id != ((clockid_t) - 1))
-  {
-    tv->tv_sec = ts.tv_sec;
-    tv->tv_usec = ts.tv_nsec / 1e3;
-  }
-  
-  // Fallback for the clock_gettime function.
-  gettimeofday(tv, NULL);
-  
-#endif  // _POSIX_TIMERS
-#elif defined(_WIN32)
-   
-  static double frequency = 0.0;
-  static LARGE_INTEGER offset;
-  
-  // If this is the first time we've run, get the frequency.
-  // We use frequency == 0.0 to indicate that
-  // QueryPerformanceFrequency is uninitialised.
-  if (frequency == 0.0)
-  {
-    LARGE_INTEGER pF;
-    if (!QueryPerformanceFrequency(&pF))
-    {
-      // Fallback for the QueryPerformanceCounter function.
-      FileTimeToTimeVal(tv);
-    }
-    else
-    {
-      QueryPerformanceCounter(&offset);
-      frequency = (double)pF.QuadPart / 1000000.0;
-    }
-  }
-  
-  if (frequency != 0.0)
+  // If the timer already exists, its value is subtracted from the start time,
+  // so that stopping it adds the new run to the old value.
+  timers[timerName] = Timer::Now() - timers[timerName];
+
+  if (MemoryUsage::Enabled())
   {
-    LARGE_INTEGER pC;
-    // Get the current performance-counter value.
-    QueryPerformanceCounter(&pC);
-    
-    pC.QuadPart -= offset.QuadPart;
-    double microseconds = (double)pC.QuadPart / frequency;
-    pC.QuadPart = microseconds;
-    tv->tv_sec = (long)pC.QuadPart / 1000000;
-    tv->tv_usec = (long)(pC.QuadPart % 1000000);
+    memoryStarts[timerName] = std::make_pair(MemoryUsage::PeakResident(),
+        MemoryUsage::HeapInUse());
   }
-  
-#endif
 }
 
-void Timers::StartTimer(const std::string& timerName)
+void Timers::StopTimer(const std::string& timerName)
 {
-  timeval tmp;
-  tmp.tv_sec = 0;
-  tmp.tv_usec = 0;
-
-  GetTime(&tmp);
-  
-  // Check to see if the timer already exists.  If it does, we'll subtract the
-  // old value.  
-  if (timers.count(timerName) == 1)
+  timers[timerName] = Timer::Now() - timers[timerName];
+
+  // The memory is only known if tracking was enabled when the timer started.
+  std::map<std::string, std::pair<size_t, size_t> >::iterator start =
+      memoryStarts.find(timerName);
+  if (start == memoryStarts.end())
+    return;
+
+  const size_t peakResident = MemoryUsage::PeakResident();
+  const size_t heapInUse = MemoryUsage::HeapInUse();
+
+  std::map<std::string, PhaseMemory>::iterator it = memory.find(timerName);
+  if (it == memory.end())
   {
-    timeval tmpDelta;
-    
-    timersub(&tmp, &timers[timerName], &tmpDelta);
-    
-    tmp = tmpDelta;
+    const PhaseMemory empty = { 0, 0, 0.0, 0 };
+    it = memory.insert(std::make_pair(timerName, empty)).first;
   }
-  
-  timers[timerName] = tmp;
+
+  PhaseMemory& phase = it->second;
+  phase.peakResident = peakResident;
+  phase.peakGrowth += peakResident - start->second.first;
+  phase.heapGrowth += (double) heapInUse - (double) start->second.second;
+  ++phase.runs;
+
+  memoryStarts.erase(start);
 }
 
-#ifdef _WIN32
-void Timers::FileTimeToTimeVal(timeval* tv)
+PhaseMemory Timers::GetPhaseMemory(const std::string& timerName)
 {
-  FILETIME ftime;
-  uint64_t ptime = 0;
-  // Acquire the file time.
-  GetSystemTimeAsFileTime(&ftime);
-  // Now convert FILETIME to timeval.
-  ptime |= ftime.dwHighDateTime;
-  ptime = ptime << 32;
-  ptime |= ftime.dwLowDateTime;
-  ptime /= 10;
-  ptime -= DELTA_EPOCH_IN_MICROSECS;
-
-  tv->tv_sec = (long) (ptime / 1000000UL);
-  tv->tv_usec = (long) (ptime % 1000000UL);
+  std::map<std::string, PhaseMemory>::const_iterator it =
+      memory.find(timerName);
+  if (it == memory.end())
+  {
+    const PhaseMemory empty = { 0, 0, 0.0, 0 };
+    return empty;
+  }
+
+  return it->second;
 }
-#endif // _WIN32
 
-void Timers::StopTimer(const std::string& timerName)
+void Timers::PrintPhaseMemory(const std::string& timerName)
 {
-  timeval delta, b, a = timers[timerName];
-  
-  GetTime(&b);
+  const PhaseMemory phase = GetPhaseMemory(timerName);
+  const size_t heapGrowth = (size_t) std::abs(phase.heapGrowth);
 
-  // Calculate the delta time.
-  timersub(&b, &a, &delta);
-  timers[timerName] = delta;
+  Log::Info << "peak resident " << MemoryBudget::Format(phase.peakResident)
+      << " (+" << MemoryBudget::Format(phase.peakGrowth) << "), heap "
+      << ((phase.heapGrowth < 0) ? "-" : "+")
+      << MemoryBudget::Format(heapGrowth) << std::endl;
 }
@@ -25,6 +25,9 @@
 
 #include <map>
 #include <string>
+#include <stdint.h>
+
+#include "memory_usage.hpp"
 
 #if defined(__unix__) || defined(__unix)
   #include <time.h>       // clock_gettime()
@@ -33,42 +36,34 @@
 #elif defined(__MACH__) && defined(__APPLE__)
   #include <mach/mach_time.h>   // mach_timebase_info,
                                 // mach_absolute_time()
-
-  // TEMPORARY
-  #include <time.h>       // clock_gettime()
-  #include <sys/time.h>   // timeval, gettimeofday()
-  #include <unistd.h>     // flags like  _POSIX_VERSION
+  #include <sys/time.h>   // timeval
 #elif defined(_WIN32)
-  #include <windows.h>  //GetSystemTimeAsFileTime(),
-                        // QueryPerformanceFrequency(),
+  #include <windows.h>  // QueryPerformanceFrequency(),
                         // QueryPerformanceCounter()
   #include <winsock.h>  //timeval on windows
-
-  // uint64_t isn't defined on every windows.
-  #if !defined(HAVE_UINT64_T)
-    #if SIZEOF_UNSIGNED_LONG == 8
-      typedef unsigned long uint64_t;
-    #else
-      typedef unsigned long long  uint64_t;
-    #endif  // SIZEOF_UNSIGNED_LONG
-  #endif  // HAVE_UINT64_T
-
-  //gettimeofday has no equivalent will need to write extra code for that.
-  #if defined(_MSC_VER) || defined(_MSC_EXTENSIONS)
-    #define DELTA_EPOCH_IN_MICROSECS 11644473600000000Ui64
-  #else
-    #define DELTA_EPOCH_IN_MICROSECS 11644473600000000ULL
-  #endif // _MSC_VER, _MSC_EXTENSIONS
 #else
   #error "unknown OS"
 #endif
 
 namespace mlpack {
 
+class Timers;
+
 /**
  * The timer class provides a way for MLPACK methods to be timed.  The three
  * methods contained in this class allow a named timer to be started and
- * stopped, and its value to be obtained.
+ * stopped, and its value to be obtained.  They may be called from several
+ * threads at once, although a timer used by several threads at once does not
+ * give a meaningful value; use Profiler for per-thread timing.
+ *
+ * Timers use a monotonic clock (clock_gettime(CLOCK_MONOTONIC) on POSIX
+ * systems, mach_absolute_time() on OS X and iOS, and the performance counter
+ * on Windows), so they are not affected by changes of the wall clock, and
+ * they count nanoseconds.  A ScopedTimer times the scope it is declared in.
+ * For hot paths, Now() and Cycles() read the clock (or the cycle counter of
+ * the processor) directly, without any lookup or lock.  If MemoryUsage is
+ * enabled, each timer also records the memory used while it runs (see
+ * Timers::GetPhaseMemory()).
  */
 class Timer
 {
@@ -95,11 +90,84 @@ class Timer
   static void Stop(const std::string& name);
 
   /**
-   * Get the value of the given timer.
+   * Get the value of the given timer (rounded down to microseconds).
    *
    * @param name Name of timer to return value of.
    */
   static timeval Get(const std::string& name);
+
+  /**
+   * Get the value of the given timer, in nanoseconds.
+   *
+   * @param name Name of timer to return value of.
+   */
+  static uint64_t GetNanoseconds(const std::string& name);
+
+  /**
+   * Get all of the timers.  They are created on first use and do not depend
+   * on CLI, so methods can be timed when mlpack is used as a library.
+   */
+  static Timers& GetTimers();
+
+  /**
+   * Return the time, in nanoseconds since an arbitrary (fixed) point, from a
+   * monotonic clock.
+   */
+  static uint64_t Now();
+
+  /**
+   * Return the cycle counter of the processor (the time-stamp counter on x86,
+   * the virtual counter on arm64), which is cheaper to read than Now(); on
+   * other targets, this is Now().  Differences of cycle counts are converted
+   * to seconds with SecondsPerCycle().  Counters of different cores may not
+   * be synchronized, so a duration should be measured on one thread.
+   */
+  static uint64_t Cycles()
+  {
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+    uint32_t low, high;
+    __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+    return ((uint64_t) high << 32) | (uint64_t) low;
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    uint64_t value;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (value));
+    return value;
+#else
+    return Now();
+#endif
+  }
+
+  /**
+   * Return the duration of one increment of Cycles(), in seconds.  It is
+   * measured against Now() (for about 10 milliseconds) the first time it is
+   * called.
+   */
+  static double SecondsPerCycle();
+};
+
+/**
+ * Times the scope it is declared in with the given named timer: the timer is
+ * started when the ScopedTimer is created and stopped when it is destroyed.
+ *
+ * @code
+ * {
+ *   ScopedTimer timer("tree_building");
+ *   ...
+ * } // The timer is stopped here.
+ * @endcode
+ */
+class ScopedTimer
+{
+ public:
+  //! Start the given timer.
+  ScopedTimer(const std::string& name) : name(name) { Timer::Start(name); }
+  //! Stop the timer.
+  ~ScopedTimer() { Timer::Stop(name); }
+
+ private:
+  //! The name of the timer that is running.
+  std::string name;
 };
 
 class Timers
@@ -111,7 +179,7 @@ class Timers
   /**
    * Returns a copy of all the timers used via this interface.
    */
-  std::map<std::string, timeval>& GetAllTimers();
+  std::map<std::string, timeval> GetAllTimers();
 
   /**
    * Returns a copy of the timer specified.
@@ -120,6 +188,13 @@ class Timers
    */
   timeval GetTimer(const std::string& timerName);
 
+  /**
+   * Returns the value of the timer specified, in nanoseconds.
+   *
+   * @param timerName The name of the timer in question.
+   */
+  uint64_t GetTimerNanoseconds(const std::string& timerName);
+
   /**
    * Prints the specified timer.  If it took longer than a minute to complete
    * the timer will be displayed in days, hours, and minutes as well.
@@ -129,28 +204,50 @@ class Timers
   void PrintTimer(const std::string& timerName);
 
   /**
-   * Initializes a timer, available like a normal value specified on
-   * the command line.  Timers are of type timeval.  If a timer is started, then
-   * stopped, then re-started, then stopped, the final timer value will be the
-   * length of both runs of the timer.
-   *
-   * @param timerName The name of the timer in question.
-   */
+   * Initializes a timer, available like a normal value specified on
+   * the command line.  If a timer is started, then stopped, then re-started,
+   * then stopped, the final timer value will be the length of both runs of
+   * the timer.
+   *
+   * @param timerName The name of the timer in question.
+   */
   void StartTimer(const std::string& timerName);
 
   /**
-   * Halts the timer, and replaces it's value with
-   * the delta time from it's start
-   *
-   * @param timerName The name of the timer in question.
-   */
+   * Halts the timer, and replaces it's value with
+   * the delta time from it's start
+   *
+   * @param timerName The name of the timer in question.
+   */
   void StopTimer(const std::string& timerName);
 
- private:
-  std::map<std::string, timeval> timers;
+  /**
+   * Returns the memory used while the timer specified ran.  This is only
+   * recorded while MemoryUsage is enabled; otherwise every field is 0.
+   *
+   * @param timerName The name of the timer in question.
+   */
+  PhaseMemory GetPhaseMemory(const std::string& timerName);
 
-  void FileTimeToTimeVal(timeval* tv);
-  void GetTime(timeval* tv);
+  /**
+   * Prints the memory used while the specified timer ran: the peak resident
+   * memory of the process at its end, how much the phase raised it, and how
+   * much the heap grew.
+   *
+   * @param timerName The name of the timer in question.
+   */
+  void PrintPhaseMemory(const std::string& timerName);
+
+ private:
+  //! The value of each timer in nanoseconds; while a timer runs, this is the
+  //! time it was started at minus its value so far.
+  std::map<std::string, uint64_t> timers;
+
+  //! The memory used while each timer ran, if MemoryUsage is enabled.
+  std::map<std::string, PhaseMemory> memory;
+  //! The peak resident memory and the heap in use when each running timer
+  //! started, if MemoryUsage is enabled.
+  std::map<std::string, std::pair<size_t, size_t> > memoryStarts;
 };
 
 }; // namespace mlpack
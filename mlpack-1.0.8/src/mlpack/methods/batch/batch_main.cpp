@@ -0,0 +1,395 @@
+/**
+ * @file batch_main.cpp
+ *
+ * The mlpack_batch program, which runs the jobs of a job list (k-nearest-
+ * neighbor searches, k-means clusterings and GMM fits) in one process, sharing
+ * the loaded datasets and the reference trees between jobs.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/query_server.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include "dataset_cache.hpp"
+#include "job.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::batch;
+using namespace mlpack::gmm;
+using namespace mlpack::kmeans;
+using namespace mlpack::neighbor;
+using namespace mlpack::tree;
+using namespace std;
+
+PROGRAM_INFO("Batch Driver", "This program runs the jobs of a job list in one "
+    "process, so that a pipeline which runs many small jobs pays for starting a"
+    " program, loading each dataset and building each reference tree only "
+    "once.  Each dataset used by the jobs is loaded once, the jobs which search"
+    " the same reference dataset with the same leaf size share one kd-tree, and"
+    " independent jobs run in parallel on --threads (-j) threads."
+    "\n\n"
+    "The job list, given with --job_file (-f), has one job per line: the name "
+    "of the method, followed by parameters of the form key=value separated by "
+    "spaces (values cannot contain spaces).  Blank lines and lines starting "
+    "with '#' are ignored.  The methods and their parameters are:"
+    "\n\n"
+    "  allknn  reference_file, k, query_file (optional), leaf_size (20), "
+    "neighbors_file, distances_file\n"
+    "  kmeans  input_file, clusters, max_iterations (1000), seed, output_file "
+    "(labels), centroid_file\n"
+    "  gmm     input_file, output_file, gaussians (1), trials (10), "
+    "max_iterations (250), tolerance (1e-10), seed"
+    "\n\n"
+    "The parameters have the same meaning as the options of the allknn, kmeans"
+    " and gmm programs.  allknn jobs with a query_file use single-tree search "
+    "on the shared tree; the others use dual-tree search.  Random seeds only "
+    "give reproducible results with --threads 1, since the jobs share the "
+    "random number generator."
+    "\n\n"
+    "The whole job list is checked before any job runs, and a malformed job "
+    "stops the program.  A job whose datasets cannot be loaded or do not fit "
+    "its parameters (for instance, a query set of another dimensionality) is "
+    "skipped without stopping the other jobs; the skipped jobs are reported "
+    "at the end, and the program then exits with status 1.");
+
+PARAM_STRING_REQ("job_file", "File containing the job list.", "f");
+PARAM_INT("threads", "Number of jobs to run at once (0 uses all available "
+    "cores).  This only has an effect if MLPACK was built with OpenMP.", "j",
+    0);
+
+//! The trees shared by the allknn jobs, by reference file and leaf size.
+typedef map<pair<string, size_t>, QueryServer<>*> ServerMap;
+
+//! Return whether the given job is an allknn job which searches a shared tree.
+bool UsesServer(const Job& job)
+{
+  return (job.Method() == "allknn") && job.Has("query_file");
+}
+
+//! Get the value of the given parameter, which must be positive.
+size_t GetPositive(const Job& job, const string& key, const int defaultValue)
+{
+  const int value = job.GetInt(key, defaultValue);
+  if (value <= 0)
+    Log::Fatal << "Line " << job.LineNumber() << ": " << key << " must be "
+        << "positive; " << value << " given." << endl;
+
+  return (size_t) value;
+}
+
+//! Get the value of the given parameter, which must be non-negative.
+size_t GetNonNegative(const Job& job,
+                      const string& key,
+                      const int defaultValue)
+{
+  const int value = job.GetInt(key, defaultValue);
+  if (value < 0)
+    Log::Fatal << "Line " << job.LineNumber() << ": " << key << " must be "
+        << "non-negative; " << value << " given." << endl;
+
+  return (size_t) value;
+}
+
+/**
+ * Check the parameters of the given job, and add the files it uses to the given
+ * list.  A fatal error is given if the method is unknown or a parameter is
+ * missing or malformed; parameters which the method does not use give a
+ * warning.
+ */
+void CheckJob(const Job& job, vector<string>& files)
+{
+  if (job.Method() == "allknn")
+  {
+    files.push_back(job.GetRequired("reference_file"));
+    if (job.Has("query_file"))
+      files.push_back(job.Get("query_file"));
+    GetPositive(job, "k", 0);
+    GetPositive(job, "leaf_size", 20);
+    job.Get("neighbors_file");
+    job.Get("distances_file");
+  }
+  else if (job.Method() == "kmeans")
+  {
+    files.push_back(job.GetRequired("input_file"));
+    GetPositive(job, "clusters", 0);
+    GetNonNegative(job, "max_iterations", 1000);
+    job.GetInt("seed", 0);
+    job.Get("output_file");
+    job.Get("centroid_file");
+  }
+  else if (job.Method() == "gmm")
+  {
+    files.push_back(job.GetRequired("input_file"));
+    job.GetRequired("output_file");
+    GetPositive(job, "gaussians", 1);
+    GetPositive(job, "trials", 10);
+    GetNonNegative(job, "max_iterations", 250);
+    job.GetDouble("tolerance", 1e-10);
+    job.GetInt("seed", 0);
+  }
+  else
+  {
+    Log::Fatal << "Line " << job.LineNumber() << ": unknown method '"
+        << job.Method() << "'." << endl;
+  }
+
+  const vector<string> unused = job.Unused();
+  for (size_t i = 0; i < unused.size(); ++i)
+    Log::Warn << "Line " << job.LineNumber() << ": parameter '" << unused[i]
+        << "' is not used by " << job.Method() << "." << endl;
+}
+
+/**
+ * Return why the given job cannot be run with the loaded datasets, or an empty
+ * string if it can be run.  The jobs are run in parallel, and a fatal error
+ * would stop all of them, so these problems are found before.
+ */
+string Problem(const Job& job, const DatasetCache& cache)
+{
+  ostringstream problem;
+  const string file = job.Get((job.Method() == "allknn") ? "reference_file" :
+      "input_file");
+  if (!cache.Contains(file))
+  {
+    problem << "'" << file << "' could not be loaded";
+    return problem.str();
+  }
+
+  const arma::mat& data = cache.Dataset(file);
+  if (job.Method() == "allknn")
+  {
+    const size_t k = (size_t) job.GetInt("k", 0);
+    if (job.Has("query_file"))
+    {
+      const string queryFile = job.Get("query_file");
+      if (!cache.Contains(queryFile))
+        problem << "'" << queryFile << "' could not be loaded";
+      else if (cache.Dataset(queryFile).n_rows != data.n_rows)
+        problem << "the query points have dimensionality "
+            << cache.Dataset(queryFile).n_rows << ", but the reference points "
+            << "have dimensionality " << data.n_rows;
+      else if (k > data.n_cols)
+        problem << "k (" << k << ") is greater than the number of reference "
+            << "points (" << data.n_cols << ")";
+    }
+    else if (k >= data.n_cols)
+    {
+      // Each point is not its own neighbor.
+      problem << "k (" << k << ") is not less than the number of reference "
+          << "points (" << data.n_cols << ")";
+    }
+  }
+  else
+  {
+    const string key = (job.Method() == "kmeans") ? "clusters" : "gaussians";
+    const size_t clusters = (size_t) job.GetInt(key, 1);
+    if (clusters > data.n_cols)
+      problem << key << " (" << clusters << ") is greater than the number of "
+          << "points (" << data.n_cols << ")";
+  }
+
+  return problem.str();
+}
+
+//! Set the random seed, if the job gives one.
+void SetSeed(const Job& job)
+{
+  const int seed = job.GetInt("seed", 0);
+  if (seed != 0)
+    math::RandomSeed((size_t) seed);
+}
+
+//! Run an allknn job.
+void RunAllkNN(const Job& job,
+               const DatasetCache& cache,
+               const ServerMap& servers,
+               const bool parallelJobs)
+{
+  const string referenceFile = job.Get("reference_file");
+  const size_t k = (size_t) job.GetInt("k", 0);
+  const size_t leafSize = (size_t) job.GetInt("leaf_size", 20);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  if (UsesServer(job))
+  {
+    QueryServer<>* server = servers.find(make_pair(referenceFile,
+        leafSize))->second;
+    server->Search(cache.Dataset(job.Get("query_file")), k, neighbors,
+        distances);
+  }
+  else
+  {
+    // The reference set is also the query set, so the dual-tree search, which
+    // skips each point itself, is used.
+    AllkNN allknn(cache.Dataset(referenceFile), false, false, leafSize);
+    allknn.Threads() = parallelJobs ? 1 : 0;
+    allknn.Search(k, neighbors, distances);
+  }
+
+  if (job.Has("neighbors_file"))
+    data::Save(job.Get("neighbors_file"), neighbors);
+  if (job.Has("distances_file"))
+    data::Save(job.Get("distances_file"), distances);
+}
+
+//! Run a kmeans job.
+void RunKMeans(const Job& job, const DatasetCache& cache)
+{
+  const arma::mat& data = cache.Dataset(job.Get("input_file"));
+  SetSeed(job);
+
+  KMeans<> kmeans((size_t) job.GetInt("max_iterations", 1000));
+  arma::Col<size_t> assignments;
+  arma::mat centroids;
+  kmeans.Cluster(data, (size_t) job.GetInt("clusters", 0), assignments,
+      centroids);
+
+  if (job.Has("output_file"))
+  {
+    arma::Mat<size_t> output = trans(assignments);
+    data::Save(job.Get("output_file"), output);
+  }
+  if (job.Has("centroid_file"))
+    data::Save(job.Get("centroid_file"), centroids);
+}
+
+//! Run a gmm job.
+void RunGMM(const Job& job, const DatasetCache& cache)
+{
+  const arma::mat& data = cache.Dataset(job.Get("input_file"));
+  SetSeed(job);
+
+  EMFit<> em((size_t) job.GetInt("max_iterations", 250),
+      job.GetDouble("tolerance", 1e-10));
+  GMM<> gmm((size_t) job.GetInt("gaussians", 1), data.n_rows, em);
+  gmm.Estimate(data, (size_t) job.GetInt("trials", 10));
+  gmm.Save(job.Get("output_file"));
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string jobFile = CLI::GetParam<string>("job_file");
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads (" << threads << "); must be "
+        << "greater than or equal to 0." << endl;
+
+  ifstream stream(jobFile.c_str());
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open job file '" << jobFile << "'." << endl;
+
+  vector<Job> jobs;
+  Job::Read(stream, jobs);
+
+  // Check all the jobs before doing anything, so that a typo in the job list
+  // does not show up only after hours of work.
+  vector<string> files;
+  for (size_t i = 0; i < jobs.size(); ++i)
+    CheckJob(jobs[i], files);
+
+  const int numThreads = (int) Threads::Count((size_t) threads);
+  const bool parallelJobs = (numThreads > 1);
+
+  Timer::Start("loading_data");
+  DatasetCache cache;
+  cache.Load(files, (size_t) numThreads);
+  Timer::Stop("loading_data");
+  Log::Info << "Loaded " << cache.Size() << " datasets for " << jobs.size()
+      << " jobs." << endl;
+
+  // Find the jobs which cannot be run, and the trees to build.
+  vector<string> problems(jobs.size());
+  ServerMap servers;
+  vector<pair<string, size_t> > serverKeys;
+  for (size_t i = 0; i < jobs.size(); ++i)
+  {
+    problems[i] = Problem(jobs[i], cache);
+    if (problems[i] != "" || !UsesServer(jobs[i]))
+      continue;
+
+    const pair<string, size_t> key(jobs[i].Get("reference_file"),
+        (size_t) jobs[i].GetInt("leaf_size", 20));
+    if (!servers.count(key))
+    {
+      servers[key] = NULL;
+      serverKeys.push_back(key);
+    }
+  }
+
+  // Build the shared trees, in parallel.
+  Timer::Start("tree_building");
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int i = 0; i < (int) serverKeys.size(); ++i)
+  {
+    QueryServer<>* server = new QueryServer<>(
+        cache.Dataset(serverKeys[i].first), BuildOptions(serverKeys[i].second));
+    server->Threads() = parallelJobs ? 1 : 0;
+
+    #pragma omp critical(batch_servers)
+    servers[serverKeys[i]] = server;
+  }
+  Timer::Stop("tree_building");
+  Log::Info << "Built " << servers.size() << " shared trees." << endl;
+
+  // Now run the jobs.
+  Timer::Start("jobs");
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int i = 0; i < (int) jobs.size(); ++i)
+  {
+    if (problems[i] != "")
+      continue;
+
+    if (jobs[i].Method() == "allknn")
+      RunAllkNN(jobs[i], cache, servers, parallelJobs);
+    else if (jobs[i].Method() == "kmeans")
+      RunKMeans(jobs[i], cache);
+    else
+      RunGMM(jobs[i], cache);
+  }
+  Timer::Stop("jobs");
+
+  for (ServerMap::iterator it = servers.begin(); it != servers.end(); ++it)
+    delete it->second;
+
+  size_t skipped = 0;
+  for (size_t i = 0; i < jobs.size(); ++i)
+  {
+    if (problems[i] != "")
+    {
+      Log::Warn << "Line " << jobs[i].LineNumber() << " (" << jobs[i].Method()
+          << ") skipped: " << problems[i] << "." << endl;
+      ++skipped;
+    }
+  }
+
+  Log::Info << (jobs.size() - skipped) << " of " << jobs.size() << " jobs "
+      << "run." << endl;
+
+  return (skipped == 0) ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file dataset_cache.cpp
+ *
+ * Implementation of DatasetCache.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "dataset_cache.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::batch;
+
+size_t DatasetCache::Load(const std::vector<std::string>& filenames,
+                          const size_t threads)
+{
+  // Make the entries of the new files first, so that the map is not modified
+  // while the files are loaded in parallel.
+  std::vector<std::string> newFiles;
+  std::vector<arma::mat*> matrices;
+  for (size_t i = 0; i < filenames.size(); ++i)
+  {
+    if (datasets.count(filenames[i]))
+      continue;
+
+    matrices.push_back(&datasets[filenames[i]]);
+    newFiles.push_back(filenames[i]);
+  }
+
+  std::vector<char> loaded(newFiles.size(), 0);
+
+#ifdef _OPENMP
+  const int numThreads = (int) Threads::Count(threads);
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+#endif
+  for (int i = 0; i < (int) newFiles.size(); ++i)
+    loaded[i] = data::Load(newFiles[i], *matrices[i], false) ? 1 : 0;
+
+  size_t failures = 0;
+  for (size_t i = 0; i < newFiles.size(); ++i)
+  {
+    if (!loaded[i])
+    {
+      Log::Warn << "Could not load '" << newFiles[i] << "'." << std::endl;
+      datasets.erase(newFiles[i]);
+      ++failures;
+    }
+  }
+
+  return failures;
+}
+
+const arma::mat& DatasetCache::Dataset(const std::string& filename) const
+{
+  std::map<std::string, arma::mat>::const_iterator it = datasets.find(filename);
+  if (it == datasets.end())
+    Log::Fatal << "DatasetCache::Dataset(): '" << filename << "' is not "
+        << "loaded." << std::endl;
+
+  return it->second;
+}
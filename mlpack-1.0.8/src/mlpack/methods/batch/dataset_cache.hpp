@@ -0,0 +1,85 @@
+/**
+ * @file dataset_cache.hpp
+ *
+ * A cache of datasets, so that each file used by the jobs of a job list is
+ * loaded only once.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_BATCH_DATASET_CACHE_HPP
+#define __MLPACK_METHODS_BATCH_DATASET_CACHE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace batch {
+
+/**
+ * A DatasetCache loads each of a set of files once (in parallel, if OpenMP is
+ * available), and then hands out the loaded datasets to any number of jobs.
+ * After Load() returns, the cache is only read, so Dataset() may be called from
+ * several threads at once.
+ *
+ * @code
+ * DatasetCache cache;
+ * cache.Load(filenames);
+ * const arma::mat& data = cache.Dataset("data.csv");
+ * @endcode
+ */
+class DatasetCache
+{
+ public:
+  //! Create an empty cache.
+  DatasetCache() { }
+
+  /**
+   * Load the given files, skipping files which are already in the cache and
+   * repeated files.  Files which cannot be loaded give a warning and are left
+   * out of the cache.
+   *
+   * @param filenames Names of the files to load.
+   * @param threads Number of files to load at once (0 uses all cores).
+   * @return The number of files which could not be loaded.
+   */
+  size_t Load(const std::vector<std::string>& filenames,
+              const size_t threads = 0);
+
+  //! Return whether the given file is in the cache.
+  bool Contains(const std::string& filename) const
+  { return (datasets.count(filename) != 0); }
+
+  /**
+   * Get the dataset loaded from the given file.  A fatal error is given if the
+   * file is not in the cache.
+   */
+  const arma::mat& Dataset(const std::string& filename) const;
+
+  //! Get the number of datasets in the cache.
+  size_t Size() const { return datasets.size(); }
+
+ private:
+  //! The loaded datasets, by file name.
+  std::map<std::string, arma::mat> datasets;
+};
+
+}; // namespace batch
+}; // namespace mlpack
+
+#endif
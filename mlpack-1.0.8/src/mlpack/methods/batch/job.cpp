@@ -0,0 +1,134 @@
+/**
+ * @file job.cpp
+ *
+ * Implementation of Job, which parses the lines of a job list.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "job.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+using namespace mlpack;
+using namespace mlpack::batch;
+
+Job::Job(const std::string& line, const size_t lineNumber) :
+    lineNumber(lineNumber)
+{
+  std::istringstream stream(line);
+  if (!(stream >> method))
+    Log::Fatal << "Line " << lineNumber << ": no method given." << std::endl;
+
+  std::string token;
+  while (stream >> token)
+  {
+    const size_t equals = token.find('=');
+    const std::string key = token.substr(0, equals);
+    if (key.empty())
+      Log::Fatal << "Line " << lineNumber << ": parameter '" << token
+          << "' has no name." << std::endl;
+    if (parameters.count(key))
+      Log::Fatal << "Line " << lineNumber << ": parameter '" << key
+          << "' is given more than once." << std::endl;
+
+    parameters[key] = (equals == std::string::npos) ? "true" :
+        token.substr(equals + 1);
+  }
+}
+
+void Job::Read(std::istream& stream, std::vector<Job>& jobs)
+{
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+
+    // Skip blank lines and comments.
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+
+    jobs.push_back(Job(line, lineNumber));
+  }
+}
+
+bool Job::Has(const std::string& key) const
+{
+  used.insert(key);
+  return (parameters.count(key) != 0);
+}
+
+std::string Job::Get(const std::string& key,
+                     const std::string& defaultValue) const
+{
+  used.insert(key);
+  std::map<std::string, std::string>::const_iterator it = parameters.find(key);
+  return (it == parameters.end()) ? defaultValue : it->second;
+}
+
+std::string Job::GetRequired(const std::string& key) const
+{
+  if (!Has(key))
+    Log::Fatal << "Line " << lineNumber << ": " << method << " requires the "
+        << "parameter '" << key << "'." << std::endl;
+
+  return Get(key);
+}
+
+int Job::GetInt(const std::string& key, const int defaultValue) const
+{
+  if (!Has(key))
+    return defaultValue;
+
+  const std::string value = Get(key);
+  char* end;
+  errno = 0;
+  const long result = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || errno != 0 || result != (int) result)
+    Log::Fatal << "Line " << lineNumber << ": parameter '" << key << "' must "
+        << "be an integer; '" << value << "' given." << std::endl;
+
+  return (int) result;
+}
+
+double Job::GetDouble(const std::string& key, const double defaultValue) const
+{
+  if (!Has(key))
+    return defaultValue;
+
+  const std::string value = Get(key);
+  char* end;
+  const double result = std::strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0')
+    Log::Fatal << "Line " << lineNumber << ": parameter '" << key << "' must "
+        << "be a number; '" << value << "' given." << std::endl;
+
+  return result;
+}
+
+std::vector<std::string> Job::Unused() const
+{
+  std::vector<std::string> unused;
+  std::map<std::string, std::string>::const_iterator it;
+  for (it = parameters.begin(); it != parameters.end(); ++it)
+    if (!used.count(it->first))
+      unused.push_back(it->first);
+
+  return unused;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file job.hpp
+ *
+ * A job of the mlpack_batch program: the method to run and its parameters, as
+ * read from one line of a job list.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_BATCH_JOB_HPP
+#define __MLPACK_METHODS_BATCH_JOB_HPP
+
+#include <mlpack/core.hpp>
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace batch {
+
+/**
+ * A job of a job list: the name of a method and its parameters.  A job list
+ * has one job on each line, written as the name of the method followed by
+ * parameters of the form key=value, separated by spaces; a parameter without a
+ * value (a flag) is given the value "true".  Blank lines and lines starting
+ * with '#' are ignored.  For instance:
+ *
+ * @code
+ * # Two searches which share the reference dataset and its tree.
+ * allknn reference_file=ref.csv query_file=q1.csv k=5 neighbors_file=n1.csv
+ * allknn reference_file=ref.csv query_file=q2.csv k=5 neighbors_file=n2.csv
+ * kmeans input_file=ref.csv clusters=10 output_file=labels.csv
+ * @endcode
+ *
+ * Values cannot contain spaces.  The job keeps track of which parameters were
+ * asked for, so that misspelled parameters can be reported (see Unused()).
+ * Malformed lines and parameters give a fatal error which names the line.
+ */
+class Job
+{
+ public:
+  /**
+   * Parse a job from the given line of a job list.
+   *
+   * @param line The line, which must not be blank or a comment.
+   * @param lineNumber The number of the line, for error messages.
+   */
+  Job(const std::string& line, const size_t lineNumber = 0);
+
+  /**
+   * Read all of the jobs of the job list in the given stream.
+   *
+   * @param stream Stream to read the job list from.
+   * @param jobs Vector to append the jobs to.
+   */
+  static void Read(std::istream& stream, std::vector<Job>& jobs);
+
+  //! Get the name of the method to run.
+  const std::string& Method() const { return method; }
+  //! Get the number of the line the job was read from.
+  size_t LineNumber() const { return lineNumber; }
+
+  //! Return whether the given parameter was given.
+  bool Has(const std::string& key) const;
+
+  /**
+   * Get the value of the given parameter, or the given default value if it was
+   * not given.
+   */
+  std::string Get(const std::string& key,
+                  const std::string& defaultValue = "") const;
+
+  //! Get the value of the given parameter; a fatal error is given if it was
+  //! not given.
+  std::string GetRequired(const std::string& key) const;
+
+  //! Get the value of the given integer parameter, or the given default value.
+  int GetInt(const std::string& key, const int defaultValue) const;
+
+  //! Get the value of the given floating-point parameter, or the given default
+  //! value.
+  double GetDouble(const std::string& key, const double defaultValue) const;
+
+  //! Get the parameters which were given but never asked for.
+  std::vector<std::string> Unused() const;
+
+ private:
+  //! The name of the method.
+  std::string method;
+  //! The number of the line the job was read from.
+  size_t lineNumber;
+  //! The values of the parameters.
+  std::map<std::string, std::string> parameters;
+  //! The parameters which were asked for.
+  mutable std::set<std::string> used;
+};
+
+}; // namespace batch
+}; // namespace mlpack
+
+#endif
@@ -24,20 +24,46 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "cf.hpp"
-#include <mlpack/methods/nmf/nmf.hpp>
-#include <mlpack/methods/nmf/als_update_rules.hpp>
 
-using namespace mlpack::nmf;
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 
 namespace mlpack {
 namespace cf {
 
+// Layout of the header of a saved model: an 8-byte magic string followed by
+// these fields, each a 64-bit unsigned integer.  The header is followed by W,
+// H, the neighborhoods, and the ratings in compressed sparse column form.
+enum CFModelHeaderField
+{
+  CF_MODEL_VERSION = 0,
+  CF_MODEL_ITEMS,
+  CF_MODEL_USERS,
+  CF_MODEL_RANK,
+  CF_MODEL_NEIGHBORS,
+  CF_MODEL_RATINGS,
+  CF_MODEL_HEADER_FIELDS
+};
+
+static const char cfModelMagic[8] = { 'M', 'L', 'P', 'K', 'C', 'F', 'M', 'D' };
+
 /**
  * Construct the CF object.
  */
 CF::CF(arma::mat& data) :
-     data(data)
+     data(data),
+     factorizer(100, 1e-5, 0.1, 1.0),
+     method(WEIGHTED_ALS),
+     relativeError(0.01),
+     threads(1)
 {
   Log::Info<<"Constructor (param: input data, default: numRecs;neighbourhood)"<<endl;
   this->numRecs = 5;
@@ -47,7 +73,11 @@ CF::CF(arma::mat& data) :
 }
 
 CF::CF(const size_t numRecs,arma::mat& data) :
-     data(data)
+     data(data),
+     factorizer(100, 1e-5, 0.1, 1.0),
+     method(WEIGHTED_ALS),
+     relativeError(0.01),
+     threads(1)
 {
   // Validate number of recommendation factor.
   if (numRecs < 1)
@@ -66,7 +96,11 @@ CF::CF(const size_t numRecs,arma::mat& data) :
 
 CF::CF(const size_t numRecs, const size_t numUsersForSimilarity,
      arma::mat& data) :
-     data(data)
+     data(data),
+     factorizer(100, 1e-5, 0.1, 1.0),
+     method(WEIGHTED_ALS),
+     relativeError(0.01),
+     threads(1)
 {
   // Validate number of recommendation factor.
   if (numRecs < 1)
@@ -92,6 +126,29 @@ CF::CF(const size_t numRecs, const size_t numUsersForSimilarity,
   CleanData();
 }
 
+CF::CF(const arma::sp_mat& cleanedData) :
+     numRecs(5),
+     numUsersForSimilarity(5),
+     cleanedData(cleanedData),
+     factorizer(100, 1e-5, 0.1, 1.0),
+     method(WEIGHTED_ALS),
+     relativeError(0.01),
+     threads(1)
+{
+  // Nothing to do.
+}
+
+CF::CF(const std::string& filename) :
+     numRecs(5),
+     factorizer(100, 1e-5, 0.1, 1.0),
+     method(WEIGHTED_ALS),
+     relativeError(0.01),
+     threads(1)
+{
+  Load(filename);
+  numUsersForSimilarity = neighborhood.n_rows;
+}
+
 void CF::GetRecommendations(arma::Mat<size_t>& recommendations)
 {
   // Used to save user IDs.
@@ -105,97 +162,157 @@ void CF::GetRecommendations(arma::Mat<size_t>& recommendations)
   GetRecommendations(recommendations, users);
 }
 
-void CF::GetRecommendations(arma::Mat<size_t>& recommendations,
-                            arma::Col<size_t>& users)
+void CF::Factorize()
 {
-  // Base function for calculating recommendations.
-
-  // Operations independent of the query:
   // Decompose the sparse data matrix to user and data matrices.
   // Should this rank be parameterizable?
   size_t rank = 2;
 
-  // Presently only ALS (via NMF) is supported as an optimizer.  This should be
-  // converted to a template when more optimizers are available.
-  NMF<RandomInitialization, WAlternatingLeastSquaresRule,
-      HAlternatingLeastSquaresRule> als(10000, 1e-5);
-  als.Apply(cleanedData, rank, w, h);
-
-  // Generate new table by multiplying approximate values.
-  rating = w * h;
-
-  // Now, we will use the decomposed w and h matrices to estimate what the user
-  // would have rated items as, and then pick the best items.
-
-  // Temporarily store feature vector of queried users.
-  arma::mat query(rating.n_rows, users.n_elem);
-
-  // Select feature vectors of queried users.
-  for (size_t i = 0; i < users.n_elem; i++)
-    query.col(i) = rating.col(users(i) - 1);
+  Timer::Start("cf_factorization");
+  if (method == QUIC_SVD)
+  {
+    // QUIC-SVD works on the dense rating matrix; the rank is the smallest
+    // that reaches the relative error (but at least the default rank).
+    arma::mat u, v;
+    arma::vec sigma;
+    svd::QUICSVD quicSVD(relativeError, rank);
+    quicSVD.Apply(arma::mat(cleanedData), u, sigma, v);
+
+    w = u * arma::diagmat(sigma);
+    h = trans(v);
+  }
+  else
+  {
+    // The factorization only visits the observed ratings; see WeightedALS.
+    factorizer.Apply(cleanedData, rank, w, h);
+  }
+  Timer::Stop("cf_factorization");
 
-  // Temporary storage for neighborhood of the queried users.
-  arma::Mat<size_t> neighborhood;
+  ComputeNeighborhoods();
+}
 
-  // Calculate the neighborhood of the queried users.
+void CF::ComputeNeighborhoods()
+{
+  // We will use the decomposed w and h matrices to estimate what the user would
+  // have rated items as.  The dense rating matrix w * h is never formed,
+  // because it has an entry for every possible (item, user) pair.
+
+  // The distance between two columns of w * h is ||w (h_i - h_j)||, so if
+  // w^T w = V D V^T, it is the same as the distance between the columns i and
+  // j of D^(1/2) V^T h.  This lets us search for neighbors in the
+  // rank-dimensional user space instead.
+  arma::vec eigval;
+  arma::mat eigvec;
+  arma::eig_sym(eigval, eigvec, trans(w) * w);
+  for (size_t i = 0; i < eigval.n_elem; ++i)
+    eigval[i] = (eigval[i] > 0.0) ? std::sqrt(eigval[i]) : 0.0;
+  arma::mat userSpace = diagmat(eigval) * trans(eigvec) * h;
+
+  // Calculate the neighborhood of every user.  Each user is its own nearest
+  // neighbor, and is part of its own neighborhood.
   // This should be a templatized option.
-  AllkNN a(rating, query);
+  AllkNN a(userSpace, userSpace);
   arma::mat resultingDistances; // Temporary storage.
   a.Search(numUsersForSimilarity, neighborhood, resultingDistances);
+}
+
+void CF::GetRecommendations(arma::Mat<size_t>& recommendations,
+                            arma::Col<size_t>& users)
+{
+  // Base function for calculating recommendations.
 
-  // Temporary storage for storing the average rating for each user in their
-  // neighborhood.
-  arma::mat averages = arma::zeros<arma::mat>(rating.n_rows, query.n_cols);
+  // Operations independent of the query are only done once: the factorization
+  // and the neighborhoods of all users.  The neighborhoods are only computed
+  // again if their size was changed.
+  if (w.n_elem == 0)
+    Factorize();
+  else if (neighborhood.n_rows != numUsersForSimilarity)
+    ComputeNeighborhoods();
 
-  // Iterate over each query user.
-  for (size_t i = 0; i < neighborhood.n_cols; ++i)
+  for (size_t i = 0; i < users.n_elem; i++)
   {
-    // Iterate over each neighbor of the query user.
-    for (size_t j = 0; j < neighborhood.n_rows; ++j)
-      averages.col(i) += rating.col(neighborhood(j, i));
-    // Normalize average.
-    averages.col(i) /= neighborhood.n_rows;
+    if (users(i) < 1 || users(i) > h.n_cols)
+      Log::Fatal << "Invalid user " << users(i) << "; users must be between 1 "
+          << "and " << h.n_cols << "." << endl;
   }
 
   // Generate recommendations for each query user by finding the maximum numRecs
-  // elements in the averages matrix.
+  // estimated ratings of the items the user has not rated.  The queried users
+  // are independent, so they are handled in parallel.
   recommendations.set_size(numRecs, users.n_elem);
-  recommendations.fill(cleanedData.n_rows + 1); // Invalid item number.
-  arma::mat values(numRecs, users.n_elem);
-  values.fill(-DBL_MAX); // The smallest possible value.
-  for (size_t i = 0; i < users.n_elem; i++)
+  recommendations.fill(w.n_rows + 1); // Invalid item number.
+  std::vector<char> incomplete(users.n_elem, 0);
+
+  #pragma omp parallel num_threads(NumThreads())
   {
-    // Look through the averages column corresponding to the current user.
-    for (size_t j = 0; j < averages.n_rows; ++j)
+    arma::vec average(h.n_rows);
+    arma::vec ratings(w.n_rows);
+
+    // The best candidates so far, as a heap with the worst one on top.
+    std::vector<std::pair<double, size_t> > candidates;
+    candidates.reserve(numRecs);
+
+    #pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < (int) users.n_elem; i++)
     {
-      // Ensure that the user hasn't already rated the item.
-      if (cleanedData(j, users(i) - 1) != 0.0)
-        continue; // The user already rated the item.
+      const size_t user = users(i) - 1;
+
+      // The average rating of the neighborhood is w times the average of the
+      // neighbors' columns of h.
+      average.zeros();
+      for (size_t j = 0; j < neighborhood.n_rows; ++j)
+        average += h.col(neighborhood(j, user));
+      average /= neighborhood.n_rows;
 
-      // Is the estimated value better than the worst candidate?
-      const double value = averages(j, i);
-      if (value > values(values.n_rows - 1, i))
+      ratings = w * average;
+
+      // The items the user rated are the (sorted) nonzero rows of the user's
+      // column, so they are skipped by walking along it.
+      size_t rated = cleanedData.col_ptrs[user];
+      const size_t ratedEnd = cleanedData.col_ptrs[user + 1];
+
+      candidates.clear();
+      for (size_t j = 0; j < ratings.n_elem; ++j)
       {
-        // It should be inserted.  Which position?
-        size_t insertPosition = values.n_rows - 1;
-        while (insertPosition > 0)
+        while (rated < ratedEnd && cleanedData.row_indices[rated] < j)
+          ++rated;
+        if (rated < ratedEnd && cleanedData.row_indices[rated] == j)
+          continue; // The user already rated the item.
+
+        // Insert item (j + 1), not item j, because everything is offset.
+        if (candidates.size() < numRecs)
         {
-          if (value <= values(insertPosition - 1, i))
-            break; // The current value is the right one.
-          insertPosition--;
+          candidates.push_back(std::make_pair(ratings[j], j + 1));
+          std::push_heap(candidates.begin(), candidates.end(),
+              std::greater<std::pair<double, size_t> >());
+        }
+        else if (ratings[j] > candidates.front().first)
+        {
+          std::pop_heap(candidates.begin(), candidates.end(),
+              std::greater<std::pair<double, size_t> >());
+          candidates.back() = std::make_pair(ratings[j], j + 1);
+          std::push_heap(candidates.begin(), candidates.end(),
+              std::greater<std::pair<double, size_t> >());
         }
-
-        // Now insert it into the list, but insert item (j + 1), not item j,
-        // because everything is offset.
-        InsertNeighbor(i, insertPosition, j + 1, value, recommendations,
-            values);
       }
+
+      // Sort the candidates from best to worst.
+      std::sort_heap(candidates.begin(), candidates.end(),
+          std::greater<std::pair<double, size_t> >());
+      for (size_t j = 0; j < candidates.size(); ++j)
+        recommendations(j, i) = candidates[j].second;
+
+      if (candidates.size() < numRecs)
+        incomplete[i] = 1;
     }
+  }
 
-    // If we were not able to come up with enough recommendations, issue a
-    // warning.
-    if (recommendations(values.n_rows - 1, i) == cleanedData.n_rows + 1)
-      Log::Warn << "Could not provide " << values.n_rows << " recommendations "
+  // If we were not able to come up with enough recommendations, issue a
+  // warning.
+  for (size_t i = 0; i < users.n_elem; i++)
+  {
+    if (incomplete[i])
+      Log::Warn << "Could not provide " << numRecs << " recommendations "
           << "for user " << users(i) << " (not enough un-rated items)!" << endl;
   }
 }
@@ -243,38 +360,133 @@ void CF::CleanData()
   cleanedData = arma::sp_mat(locations, values, maxItemID, maxUserID);
 }
 
-/**
- * Helper function to insert a point into the recommendation matrices.
- *
- * @param queryIndex Index of point whose recommendations we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of item being inserted as a recommendation.
- * @param value Value of recommendation.
- */
-void CF::InsertNeighbor(const size_t queryIndex,
-                        const size_t pos,
-                        const size_t neighbor,
-                        const double value,
-                        arma::Mat<size_t>& recommendations,
-                        arma::mat& values) const
+void CF::Save(const std::string& filename) const
+{
+  if (w.n_elem == 0)
+    Log::Fatal << "CF::Save(): the ratings have not been factorized yet; call "
+        << "Factorize() first." << endl;
+
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open '" << filename << "' to save CF model." << endl;
+
+  uint64_t header[CF_MODEL_HEADER_FIELDS];
+  header[CF_MODEL_VERSION] = 1;
+  header[CF_MODEL_ITEMS] = w.n_rows;
+  header[CF_MODEL_USERS] = h.n_cols;
+  header[CF_MODEL_RANK] = w.n_cols;
+  header[CF_MODEL_NEIGHBORS] = neighborhood.n_rows;
+  header[CF_MODEL_RATINGS] = cleanedData.n_nonzero;
+
+  stream.write(cfModelMagic, sizeof(cfModelMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  stream.write((const char*) w.memptr(), w.n_elem * sizeof(double));
+  stream.write((const char*) h.memptr(), h.n_elem * sizeof(double));
+
+  // Indices are always stored as 64-bit integers.
+  std::vector<uint64_t> indices(neighborhood.begin(), neighborhood.end());
+  if (indices.size() > 0)
+    stream.write((const char*) &indices[0], indices.size() * sizeof(uint64_t));
+
+  indices.assign(cleanedData.col_ptrs, cleanedData.col_ptrs +
+      cleanedData.n_cols + 1);
+  stream.write((const char*) &indices[0], indices.size() * sizeof(uint64_t));
+  indices.assign(cleanedData.row_indices, cleanedData.row_indices +
+      cleanedData.n_nonzero);
+  if (indices.size() > 0)
+    stream.write((const char*) &indices[0], indices.size() * sizeof(uint64_t));
+  stream.write((const char*) cleanedData.values, cleanedData.n_nonzero *
+      sizeof(double));
+
+  if (!stream.good())
+    Log::Fatal << "Error writing CF model to '" << filename << "'." << endl;
+}
+
+void CF::Load(const std::string& filename)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (recommendations.n_rows - 1))
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open CF model '" << filename << "'." << endl;
+
+  char magic[sizeof(cfModelMagic)];
+  uint64_t header[CF_MODEL_HEADER_FIELDS];
+  stream.read(magic, sizeof(magic));
+  stream.read((char*) header, sizeof(header));
+  if (!stream.good() || memcmp(magic, cfModelMagic, sizeof(magic)) != 0)
+    Log::Fatal << "'" << filename << "' is not a CF model." << endl;
+
+  if (header[CF_MODEL_VERSION] != 1)
+    Log::Fatal << "Unsupported CF model version " << header[CF_MODEL_VERSION]
+        << " in '" << filename << "'." << endl;
+
+  const size_t items = (size_t) header[CF_MODEL_ITEMS];
+  const size_t users = (size_t) header[CF_MODEL_USERS];
+  const size_t rank = (size_t) header[CF_MODEL_RANK];
+  const size_t neighbors = (size_t) header[CF_MODEL_NEIGHBORS];
+  const size_t ratings = (size_t) header[CF_MODEL_RATINGS];
+  if (rank == 0 || neighbors == 0 || neighbors > users)
+    Log::Fatal << "CF model '" << filename << "' is corrupt." << endl;
+
+  w.set_size(items, rank);
+  h.set_size(rank, users);
+  stream.read((char*) w.memptr(), w.n_elem * sizeof(double));
+  stream.read((char*) h.memptr(), h.n_elem * sizeof(double));
+
+  std::vector<uint64_t> indices(neighbors * users);
+  if (indices.size() > 0)
+    stream.read((char*) &indices[0], indices.size() * sizeof(uint64_t));
+  neighborhood.set_size(neighbors, users);
+  for (size_t i = 0; i < indices.size(); ++i)
+    neighborhood[i] = (size_t) indices[i];
+
+  // The ratings are read as (item, user) locations for the batch insert
+  // constructor.
+  std::vector<uint64_t> colPtrs(users + 1);
+  stream.read((char*) &colPtrs[0], colPtrs.size() * sizeof(uint64_t));
+  indices.resize(ratings);
+  if (ratings > 0)
+    stream.read((char*) &indices[0], ratings * sizeof(uint64_t));
+  arma::vec values(ratings);
+  stream.read((char*) values.memptr(), ratings * sizeof(double));
+
+  if (!stream.good() || colPtrs[users] != ratings)
+    Log::Fatal << "CF model '" << filename << "' is corrupt." << endl;
+
+  arma::umat locations(2, ratings);
+  for (size_t j = 0; j < users; ++j)
+  {
+    if (colPtrs[j] > colPtrs[j + 1] || colPtrs[j + 1] > ratings)
+      Log::Fatal << "CF model '" << filename << "' is corrupt." << endl;
+
+    for (size_t k = (size_t) colPtrs[j]; k < (size_t) colPtrs[j + 1]; ++k)
+    {
+      if (indices[k] >= items)
+        Log::Fatal << "CF model '" << filename << "' is corrupt." << endl;
+
+      locations(0, k) = (arma::uword) indices[k];
+      locations(1, k) = j;
+    }
+  }
+
+  for (size_t i = 0; i < neighborhood.n_elem; ++i)
   {
-    const int len = (values.n_rows - 1) - pos;
-    memmove(values.colptr(queryIndex) + (pos + 1),
-        values.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(recommendations.colptr(queryIndex) + (pos + 1),
-        recommendations.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    if (neighborhood[i] >= users)
+      Log::Fatal << "CF model '" << filename << "' is corrupt." << endl;
   }
 
-  // Now put the new information in the right index.
-  values(pos, queryIndex) = value;
-  recommendations(pos, queryIndex) = neighbor;
+  cleanedData = arma::sp_mat(locations, values, items, users);
+
+  Log::Info << "Loaded CF model '" << filename << "' (" << items << " items, "
+      << users << " users, rank " << rank << ")." << endl;
 }
 
+size_t CF::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
 
 }; // namespace mlpack
 }; // namespace cf
@@ -27,6 +27,8 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/quic_svd/quic_svd.hpp>
+#include "weighted_als.hpp"
 #include <set>
 #include <map>
 #include <iostream>
@@ -64,10 +66,48 @@ namespace cf /** Collaborative filtering. */{
  * should have three rows.  The first represents the user; the second represents
  * the item; and the third represents the rating.  The user and item, while they
  * are in a matrix that holds doubles, should hold integer (or size_t) values.
+ *
+ * The dense (item, user) rating matrix W * H is never formed: the neighborhood
+ * of each user is found in the low-rank user space, and the estimated ratings
+ * are computed from W for one user at a time.  So, the memory used is
+ * proportional to (users + items) * rank, not users * items.
+ *
+ * The factorization and the neighborhoods of all users are computed once, by
+ * Factorize() or by the first call to GetRecommendations(), and can be saved
+ * with Save() and loaded again later, so that recommendations for any batch of
+ * users can be served without factorizing the ratings again:
+ *
+ * @code
+ * CF cf(data);
+ * cf.Factorize();
+ * cf.Save("model.bin");
+ *
+ * // Later, possibly in another process.
+ * CF loaded("model.bin");
+ * loaded.Threads() = 0; // Use all cores.
+ * loaded.GetRecommendations(recommendations, users);
+ * @endcode
+ *
+ * The ratings are factorized with WeightedALS, treating them as implicit
+ * feedback (with alpha = 1) by default; the factorizer can be configured with
+ * Factorizer() before GetRecommendations() is called.  Alternatively, with
+ * Method() set to QUIC_SVD, the rating matrix (with zeros for the missing
+ * ratings) is decomposed with QUIC-SVD to the relative error RelativeError();
+ * the rank is then as small as that error allows.  This forms the dense
+ * (item, user) matrix, so it is only suitable when that fits in memory.
  */
 class CF
 {
  public:
+  //! The ways to factorize the rating matrix.
+  enum FactorizationMethod
+  {
+    //! Alternating least squares over the observed ratings (WeightedALS).
+    WEIGHTED_ALS,
+    //! QUIC-SVD of the dense rating matrix, to a given relative error.
+    QUIC_SVD
+  };
+
   /**
    * Create a CF object and (optionally) set the parameters with which
    * collaborative filtering will be run.
@@ -96,6 +136,39 @@ class CF
    */
   CF(arma::mat& data);
 
+  /**
+   * Create a CF object from ratings which are already a sparse matrix with one
+   * row for each item and one column for each user (like CleanedData()), for
+   * instance loaded directly with the sparse data::Load().  Data() is empty.
+   *
+   * @param cleanedData Sparse (item, user) matrix of ratings.
+   */
+  CF(const arma::sp_mat& cleanedData);
+
+  /**
+   * Load a CF model that was saved with Save().  The number of users for
+   * similarity is the size of the saved neighborhoods, and Data() is empty.  If
+   * the file cannot be opened or is not a valid model, a fatal error is given.
+   *
+   * @param filename File to load.
+   */
+  CF(const std::string& filename);
+
+  /**
+   * Factorize the ratings and compute the neighborhood of every user.  This is
+   * done by the first call to GetRecommendations() if it has not been done yet.
+   */
+  void Factorize();
+
+  /**
+   * Save the factorization, the neighborhoods, and the ratings to the given
+   * file.  The ratings must have been factorized.  If the file cannot be
+   * written, a fatal error is given.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
+
   //! Sets number of Recommendations.
   void NumRecs(size_t recs)
   {
@@ -136,12 +209,32 @@ class CF
   const arma::mat& W() const { return w; }
   //! Get the Item Matrix.
   const arma::mat& H() const { return h; }
-  //! Get the Rating Matrix.
-  const arma::mat& Rating() const { return rating; }
   //! Get the data matrix.
   const arma::mat& Data() const { return data; }
   //! Get the cleaned data matrix.
   const arma::sp_mat& CleanedData() const { return cleanedData; }
+  //! Get the neighborhoods of all users (one column for each user).
+  const arma::Mat<size_t>& Neighborhoods() const { return neighborhood; }
+  //! Get the factorizer.
+  const WeightedALS& Factorizer() const { return factorizer; }
+  //! Modify the factorizer (for instance, its number of threads).
+  WeightedALS& Factorizer() { return factorizer; }
+
+  //! Get how the rating matrix is factorized.
+  FactorizationMethod Method() const { return method; }
+  //! Modify how the rating matrix is factorized.
+  FactorizationMethod& Method() { return method; }
+
+  //! Get the largest relative error of the QUIC-SVD factorization.
+  double RelativeError() const { return relativeError; }
+  //! Modify the largest relative error of the QUIC-SVD factorization.
+  double& RelativeError() { return relativeError; }
+
+  //! Get the number of threads used to generate recommendations.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to generate recommendations (1 is
+  //! serial, 0 uses all cores).
+  size_t& Threads() { return threads; }
 
   /**
    * Generates default number of recommendations for all users.
@@ -191,30 +284,32 @@ class CF
   arma::mat w;
   //! Item matrix.
   arma::mat h;
-  //! Rating matrix.
-  arma::mat rating;
   //! Initial data matrix.
   arma::mat data;
   //! Cleaned data matrix.
   arma::sp_mat cleanedData;
+  //! Factorizes the cleaned data matrix.
+  WeightedALS factorizer;
+  //! How the cleaned data matrix is factorized.
+  FactorizationMethod method;
+  //! The largest relative error of the QUIC-SVD factorization.
+  double relativeError;
+  //! Neighborhoods of all users.
+  arma::Mat<size_t> neighborhood;
+  //! The number of threads used to generate recommendations.
+  size_t threads;
+
   //! Converts the User, Item, Value Matrix to User-Item Table
   void CleanData();
 
-  /**
-   * Helper function to insert a point into the recommendation matrices.
-   *
-   * @param queryIndex Index of point whose recommendations we are inserting
-   *     into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of item being inserted as a recommendation.
-   * @param value Value of recommendation.
-   */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double value,
-                      arma::Mat<size_t>& recommendations,
-                      arma::mat& values) const;
+  //! Compute the neighborhood of every user from the factorization.
+  void ComputeNeighborhoods();
+
+  //! Load a model saved with Save().
+  void Load(const std::string& filename);
+
+  //! Return the number of threads to use.
+  size_t NumThreads() const;
 
 }; // class CF
 
@@ -40,13 +40,37 @@ PROGRAM_INFO("Collaborating Filtering", "This program performs collaborative "
     "generating recommendations can be specified with the --neighborhood (-n) "
     "option."
     "\n\n"
+    "The ratings are factorized with alternating least squares over the "
+    "observed ratings only.  By default they are treated as implicit feedback "
+    "with a confidence of 1 + alpha * rating (--alpha (-A)); an alpha of 0 "
+    "instead minimizes the squared error of the observed ratings.  The "
+    "regularization can be set with --lambda (-L), and the number of threads "
+    "used for the factorization with --threads (-j); 0 uses all cores."
+    "\n\n"
+    "Alternatively, with --algorithm (-a) 'quic_svd', the rating matrix is "
+    "decomposed with QUIC-SVD until at most --relative_error (-e) of its "
+    "squared Frobenius norm is left out; this forms the dense (item, user) "
+    "matrix."
+    "\n\n"
     "The input file should contain a 3-column matrix of ratings, where the "
     "first column is the user, the second column is the item, and the third "
     "column is that user's rating of that item.  Both the users and items "
-    "should be numeric indices, not names.");
+    "should be numeric indices (starting at 1), not names.  The ratings may "
+    "also be given as a MatrixMarket (.mtx) or svmlight (.svm) file with one "
+    "row for each user and one column for each item.  The ratings are read "
+    "straight into a sparse matrix."
+    "\n\n"
+    "The factorization and the neighborhoods of all users can be saved with "
+    "--save_model (-M), and loaded again with --model_file (-m) in place of "
+    "--input_file, so that recommendations can be generated without "
+    "factorizing the ratings again.");
 
 // Parameters for program.
-PARAM_STRING_REQ("input_file", "Input dataset to perform CF on.", "i");
+PARAM_STRING("input_file", "Input dataset to perform CF on.", "i", "");
+PARAM_STRING("model_file", "File containing a CF model saved with "
+    "--save_model, to use instead of --input_file.", "m", "");
+PARAM_STRING("save_model", "If specified, save the CF model to this file.",
+    "M", "");
 PARAM_STRING("query_file", "List of users for which recommendations are to "
     "be generated (if unspecified, then recommendations are generated for all "
     "users).", "q", "");
@@ -54,9 +78,12 @@ PARAM_STRING("query_file", "List of users for which recommendations are to "
 PARAM_STRING("output_file","File to save output recommendations to.", "o",
     "recommendations.csv");
 
+PARAM_STRING("algorithm", "Algorithm used to factorize the ratings ('als' or "
+    "'quic_svd').", "a", "als");
+PARAM_DOUBLE("relative_error", "Largest relative error of the QUIC-SVD "
+    "factorization.", "e", 0.01);
+
 // These features are not yet available in the CF code.
-//PARAM_STRING("algorithm", "Algorithm used for CF ('als' or 'svd').", "a",
-//    "als");
 //PARAM_STRING("nearest_neighbor_algorithm", "Similarity search procedure to "
 //    "be used for generating recommendations.", "s", "knn");
 
@@ -65,15 +92,23 @@ PARAM_INT("recommendations", "Number of recommendations to generate for each "
 PARAM_INT("neighborhood", "Size of the neighborhood of similar users to "
     "consider for each query user.", "n", 5);
 
+PARAM_DOUBLE("alpha", "Confidence scaling of the observed ratings (0 for "
+    "explicit feedback).", "A", 1.0);
+PARAM_DOUBLE("lambda", "Regularization parameter of the factorization.", "L",
+    0.1);
+PARAM_INT("threads", "Number of threads to use for the factorization and the "
+    "recommendations (0 uses all available cores).", "j", 1);
+
 int main(int argc, char** argv)
 {
   // Parse command line options.
   CLI::ParseCommandLine(argc, argv);
 
-  // Read from the input file.
   const string inputFile = CLI::GetParam<string>("input_file");
-  arma::mat dataset;
-  data::Load(inputFile, dataset, true);
+  const string modelFile = CLI::GetParam<string>("model_file");
+  if ((inputFile == "") == (modelFile == ""))
+    Log::Fatal << "Exactly one of --input_file and --model_file must be "
+        << "specified." << endl;
 
   // Recommendation matrix.
   arma::Mat<size_t> recommendations;
@@ -81,12 +116,78 @@ int main(int argc, char** argv)
   // Get parameters.
   const size_t numRecs = (size_t) CLI::GetParam<int>("recommendations");
   const size_t neighborhood = (size_t) CLI::GetParam<int>("neighborhood");
+  const double alpha = CLI::GetParam<double>("alpha");
+  const double lambda = CLI::GetParam<double>("lambda");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (alpha < 0.0)
+    Log::Fatal << "Invalid alpha: " << alpha << ".  Must be greater than or "
+        << "equal to 0." << endl;
+  if (lambda < 0.0)
+    Log::Fatal << "Invalid lambda: " << lambda << ".  Must be greater than or "
+        << "equal to 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  CF* c;
+  if (modelFile != "")
+  {
+    if (CLI::HasParam("alpha") || CLI::HasParam("lambda"))
+      Log::Warn << "--alpha and --lambda are ignored because the model is "
+          << "loaded from '" << modelFile << "'." << endl;
+
+    Timer::Start("model_loading");
+    c = new CF(modelFile);
+    Timer::Stop("model_loading");
+
+    // The saved neighborhoods are used unless another size is given.
+    if (CLI::HasParam("neighborhood"))
+      c->NumUsersForSimilarity(neighborhood);
+  }
+  else
+  {
+    // Read the ratings from the input file straight into a sparse (item,
+    // user) matrix.
+    arma::sp_mat ratings;
+    data::Load(inputFile, ratings, true);
+
+    // The users and items of (user, item, rating) triplets start at 1, but
+    // coordinate lists start at 0, so the first row and column are empty.
+    const string extension = inputFile.substr(inputFile.rfind('.') + 1);
+    if (((extension == "csv") || (extension == "txt")) &&
+        (ratings.n_rows > 0) && (ratings.n_cols > 0))
+    {
+      const arma::sp_mat oneBased(ratings.submat(1, 1, ratings.n_rows - 1,
+          ratings.n_cols - 1));
+      ratings = oneBased;
+    }
+
+    // Perform decomposition to prepare for recommendations.
+    Log::Info << "Performing CF matrix decomposition on dataset..." << endl;
+    c = new CF(ratings);
+    c->NumUsersForSimilarity(neighborhood);
+    c->Factorizer().Alpha() = alpha;
+    c->Factorizer().Lambda() = lambda;
+    c->Factorizer().Threads() = (size_t) threads;
+    c->RelativeError() = CLI::GetParam<double>("relative_error");
 
-  // Perform decomposition to prepare for recommendations.
-  Log::Info << "Performing CF matrix decomposition on dataset..." << endl;
-  CF c(dataset);
-  c.NumRecs(numRecs);
-  c.NumUsersForSimilarity(neighborhood);
+    const string algorithm = CLI::GetParam<string>("algorithm");
+    if (algorithm == "quic_svd")
+      c->Method() = CF::QUIC_SVD;
+    else if (algorithm != "als")
+      Log::Fatal << "Invalid algorithm '" << algorithm << "'; must be 'als' "
+          << "or 'quic_svd'." << endl;
+
+    c->Factorize();
+  }
+
+  c->NumRecs(numRecs);
+  c->Threads() = (size_t) threads;
+
+  const string saveModel = CLI::GetParam<string>("save_model");
+  if (saveModel != "")
+    c->Save(saveModel);
 
   // Reading users.
   const string queryFile = CLI::GetParam<string>("query_file");
@@ -100,14 +201,16 @@ int main(int argc, char** argv)
 
     Log::Info << "Generating recommendations for " << users.n_elem << " users "
         << "in '" << queryFile << "'." << endl;
-    c.GetRecommendations(recommendations, users);
+    c->GetRecommendations(recommendations, users);
   }
   else
   {
     Log::Info << "Generating recommendations for all users." << endl;
-    c.GetRecommendations(recommendations);
+    c->GetRecommendations(recommendations);
   }
 
   const string outputFile = CLI::GetParam<string>("output_file");
   data::Save(outputFile, recommendations);
+
+  delete c;
 }
@@ -0,0 +1,315 @@
+/**
+ * @file weighted_als.cpp
+ *
+ * Implementation of the WeightedALS class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "weighted_als.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::cf;
+
+WeightedALS::WeightedALS(const size_t maxIterations,
+                         const double minResidue,
+                         const double lambda,
+                         const double alpha) :
+    maxIterations(maxIterations),
+    minResidue(minResidue),
+    lambda(lambda),
+    alpha(alpha),
+    threads(1),
+    comm(NULL)
+{
+  if (minResidue < 0.0)
+  {
+    Log::Warn << "WeightedALS::WeightedALS(): minResidue must be a positive "
+        << "value (" << minResidue << " given). Setting to the default value "
+        << "of 1e-5.\n";
+    this->minResidue = 1e-5;
+  }
+
+  if (lambda < 0.0)
+  {
+    Log::Warn << "WeightedALS::WeightedALS(): lambda must be a positive value ("
+        << lambda << " given). Setting to the default value of 0.1.\n";
+    this->lambda = 0.1;
+  }
+
+  if (alpha < 0.0)
+  {
+    Log::Warn << "WeightedALS::WeightedALS(): alpha must be a positive value ("
+        << alpha << " given). Setting to 0 (explicit feedback).\n";
+    this->alpha = 0.0;
+  }
+}
+
+void WeightedALS::Apply(const arma::sp_mat& V,
+                        const size_t r,
+                        arma::mat& W,
+                        arma::mat& H) const
+{
+  // The items are solved for from the columns of the transpose, so that the
+  // ratings of each item are contiguous.
+  const arma::sp_mat Vt = trans(V);
+
+  // Only H needs to be initialized, because W is solved for first.
+  arma::mat Wt(r, V.n_rows);
+  H.randu(r, V.n_cols);
+
+  Log::Info << "Initialized W and H." << std::endl;
+
+  size_t iteration = 1;
+  double residue = minResidue;
+  double objectiveOld = 0.0;
+
+  while (residue >= minResidue && iteration != maxIterations)
+  {
+    Solve(Vt, H, Wt);
+    Solve(V, Wt, H);
+
+    const double objective = Objective(V, Wt, H);
+    if (iteration > 1)
+    {
+      residue = (objectiveOld == 0.0) ? 0.0 :
+          fabs(objectiveOld - objective) / objectiveOld;
+    }
+
+    objectiveOld = objective;
+
+    iteration++;
+  }
+
+  W = trans(Wt);
+
+  Log::Info << "Weighted ALS converged to residue of " << residue << " in "
+      << iteration << " iterations." << std::endl;
+}
+
+void WeightedALS::Apply(const arma::sp_mat& userRatings,
+                        const arma::sp_mat& itemRatings,
+                        const size_t r,
+                        arma::mat& W,
+                        arma::mat& H) const
+{
+  size_t users, items;
+  const size_t userOffset = Offset(userRatings.n_cols, users);
+  const size_t itemOffset = Offset(itemRatings.n_cols, items);
+
+  if (userRatings.n_rows != items || itemRatings.n_rows != users)
+    Log::Fatal << "WeightedALS::Apply(): the user ratings must have a row for "
+        << "each of the " << items << " items, and the item ratings a row for "
+        << "each of the " << users << " users!" << std::endl;
+
+  // The initial factor of each user is drawn from its own stream, split from
+  // a seed given by the first rank, so it does not depend on the partition.
+  double seed = (comm == NULL || comm->Rank() == 0) ?
+      (double) math::RandInt(1 << 30) : 0.0;
+  if (comm != NULL)
+    comm->Sum(&seed, 1);
+
+  const math::RandomStream stream((size_t) seed);
+  arma::mat localH(r, userRatings.n_cols);
+  for (size_t j = 0; j < localH.n_cols; ++j)
+  {
+    math::RandomStream userStream = stream.Split(userOffset + j);
+    for (size_t i = 0; i < r; ++i)
+      localH(i, j) = userStream.Random();
+  }
+  Exchange(localH, userOffset, users, H);
+
+  Log::Info << "Initialized W and H." << std::endl;
+
+  arma::mat localWt, Wt;
+  size_t iteration = 1;
+  double residue = minResidue;
+  double objectiveOld = 0.0;
+
+  while (residue >= minResidue && iteration != maxIterations)
+  {
+    Solve(itemRatings, H, localWt);
+    Exchange(localWt, itemOffset, items, Wt);
+    Solve(userRatings, Wt, localH);
+    Exchange(localH, userOffset, users, H);
+
+    double objective = UserObjective(userRatings, Wt, localH);
+    if (comm != NULL)
+      comm->Sum(&objective, 1);
+    objective += lambda * accu(Wt % Wt);
+
+    if (iteration > 1)
+    {
+      residue = (objectiveOld == 0.0) ? 0.0 :
+          fabs(objectiveOld - objective) / objectiveOld;
+    }
+
+    objectiveOld = objective;
+
+    iteration++;
+  }
+
+  W = trans(Wt);
+
+  Log::Info << "Weighted ALS converged to residue of " << residue << " in "
+      << iteration << " iterations." << std::endl;
+}
+
+void WeightedALS::Solve(const arma::sp_mat& V,
+                        const arma::mat& fixed,
+                        arma::mat& factors) const
+{
+  const size_t r = fixed.n_rows;
+
+  // With implicit feedback every entry contributes to the normal equations; the
+  // unobserved ones all with a confidence of 1, which is the Gram matrix of the
+  // fixed factors.  The observed entries only add the extra confidence.
+  arma::mat base = lambda * arma::eye<arma::mat>(r, r);
+  if (alpha > 0.0)
+    base += fixed * trans(fixed);
+
+  factors.set_size(r, V.n_cols);
+
+  #pragma omp parallel num_threads(NumThreads())
+  {
+    arma::mat A(r, r);
+    arma::vec b(r);
+    arma::vec x(r);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (int j = 0; j < (int) V.n_cols; ++j)
+    {
+      A = base;
+      b.zeros();
+
+      for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+      {
+        const double* f = fixed.colptr(V.row_indices[k]);
+        const double value = V.values[k];
+
+        // Weight of f f^T, and weight of f in the right-hand side.
+        const double weight = (alpha > 0.0) ? alpha * value : 1.0;
+        const double target = (alpha > 0.0) ? 1.0 + alpha * value : value;
+
+        for (size_t c = 0; c < r; ++c)
+        {
+          for (size_t d = 0; d < r; ++d)
+            A(d, c) += weight * f[d] * f[c];
+          b[c] += target * f[c];
+        }
+      }
+
+      // The system can only be singular if lambda is 0 and nothing was rated.
+      if (V.col_ptrs[j] == V.col_ptrs[j + 1] && alpha == 0.0)
+        x.zeros();
+      else if (!arma::solve(x, A, b))
+        x.zeros();
+
+      factors.col(j) = x;
+    }
+  }
+}
+
+double WeightedALS::Objective(const arma::sp_mat& V,
+                              const arma::mat& Wt,
+                              const arma::mat& H) const
+{
+  return lambda * accu(Wt % Wt) + UserObjective(V, Wt, H);
+}
+
+double WeightedALS::UserObjective(const arma::sp_mat& V,
+                                  const arma::mat& Wt,
+                                  const arma::mat& H) const
+{
+  const size_t r = H.n_rows;
+
+  // With implicit feedback, the sum of the squared predictions over all entries
+  // is computed from the Gram matrices, and the observed entries correct it.
+  // The Gram matrix of H is the sum of those of any partition of the users.
+  double objective = lambda * accu(H % H);
+  if (alpha > 0.0)
+    objective += accu((Wt * trans(Wt)) % (H * trans(H)));
+
+  double observed = 0.0;
+
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic, 64) \
+      reduction(+:observed)
+  for (int j = 0; j < (int) V.n_cols; ++j)
+  {
+    const double* h = H.colptr(j);
+    for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+    {
+      const double* w = Wt.colptr(V.row_indices[k]);
+      double prediction = 0.0;
+      for (size_t c = 0; c < r; ++c)
+        prediction += w[c] * h[c];
+
+      const double value = V.values[k];
+      if (alpha > 0.0)
+      {
+        observed += (1.0 + alpha * value) * (1.0 - prediction) *
+            (1.0 - prediction) - prediction * prediction;
+      }
+      else
+      {
+        observed += (value - prediction) * (value - prediction);
+      }
+    }
+  }
+
+  return objective + observed;
+}
+
+void WeightedALS::Exchange(const arma::mat& local,
+                           const size_t offset,
+                           const size_t columns,
+                           arma::mat& global) const
+{
+  // The blocks of the ranks do not overlap, so summing them gathers them.
+  global.zeros(local.n_rows, columns);
+  if (local.n_cols > 0)
+    global.cols(offset, offset + local.n_cols - 1) = local;
+
+  if (comm != NULL)
+    comm->Sum(global.memptr(), global.n_elem);
+}
+
+size_t WeightedALS::Offset(const size_t localColumns, size_t& columns) const
+{
+  if (comm == NULL)
+  {
+    columns = localColumns;
+    return 0;
+  }
+
+  arma::vec counts(comm->Ranks());
+  counts.zeros();
+  counts[comm->Rank()] = (double) localColumns;
+  comm->Sum(counts.memptr(), counts.n_elem);
+
+  columns = (size_t) accu(counts);
+  return (size_t) accu(counts.subvec(0, comm->Rank())) - localColumns;
+}
+
+size_t WeightedALS::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
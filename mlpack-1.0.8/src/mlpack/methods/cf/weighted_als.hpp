@@ -0,0 +1,256 @@
+/**
+ * @file weighted_als.hpp
+ *
+ * Definition of the WeightedALS class, which factorizes a sparse rating matrix
+ * with alternating least squares over the observed ratings only.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_CF_WEIGHTED_ALS_HPP
+#define __MLPACK_METHODS_CF_WEIGHTED_ALS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace cf {
+
+/**
+ * This class factorizes a sparse (item, user) rating matrix V into W * H with
+ * alternating least squares, where W is n x r and H is r x m.  Unlike NMF with
+ * the ALS update rules, the missing entries of V are not treated as zero
+ * ratings.  Each column of H (each user) is the solution of an r x r system of
+ * normal equations built from the items that user rated, and each row of W
+ * (each item) is found the same way from the users that rated it.  The dense
+ * product W * H is never formed, and the users (or items) are solved for in
+ * parallel.
+ *
+ * Two objectives are available.  If alpha is 0, the squared error over the
+ * observed ratings is minimized (explicit feedback):
+ *
+ * \f[
+ * \sum_{(i, u) \in V} (v_{iu} - w_i h_u)^2 + \lambda (\|W\|^2 + \|H\|^2).
+ * \f]
+ *
+ * If alpha is greater than 0, every entry is a preference (1 if the user rated
+ * the item and 0 otherwise) with a confidence of 1 + alpha v_{iu}, which is 1
+ * for the entries that were not observed (implicit feedback).  The unobserved
+ * entries all share the same confidence, so they are accounted for with a
+ * single r x r Gram matrix on each iteration, and the cost of an iteration is
+ * still linear in the number of observed ratings.  For more information, see
+ * the following paper:
+ *
+ * @code
+ * @inproceedings{hu2008collaborative,
+ *   title = {Collaborative Filtering for Implicit Feedback Datasets},
+ *   author = {Hu, Yifan and Koren, Yehuda and Volinsky, Chris},
+ *   booktitle = {Proceedings of the 8th IEEE International Conference on Data
+ *       Mining (ICDM '08)},
+ *   pages = {263--272},
+ *   year = {2008}
+ * }
+ * @endcode
+ *
+ * The iteration stops once the relative change of the objective, which is also
+ * computed over the observed ratings only, falls below the minimum residue.
+ *
+ * Ratings too large for one machine can be factorized by the ranks of a
+ * Communicator (see Comm() and the sharded overload of Apply()).  The users and
+ * the items are both partitioned between the ranks, and the ratings are stored
+ * twice: each rank holds the ratings of its users, and those of its items.  In
+ * each half-iteration every rank solves for the factors of its own users (or
+ * items) in parallel, with the same per-column solver as the single-process
+ * factorization, and the blocks of factors are then exchanged so that every
+ * rank has the whole factor matrix for the next half-iteration.
+ *
+ * @code
+ * extern arma::sp_mat V; // (item, user) ratings.
+ * arma::mat W, H;
+ *
+ * WeightedALS als(100, 1e-5, 0.1); // Explicit feedback.
+ * als.Apply(V, 10, W, H);
+ * @endcode
+ */
+class WeightedALS
+{
+ public:
+  /**
+   * Create the WeightedALS object and set the parameters the factorization
+   * will be run with.
+   *
+   * @param maxIterations Maximum number of iterations allowed before giving up.
+   *     A value of 0 indicates no limit.
+   * @param minResidue The minimum relative change of the objective before the
+   *     algorithm terminates.
+   * @param lambda Regularization parameter.
+   * @param alpha Confidence scaling of the observed ratings; 0 minimizes the
+   *     squared error of the observed ratings only.
+   */
+  WeightedALS(const size_t maxIterations = 100,
+              const double minResidue = 1e-5,
+              const double lambda = 0.1,
+              const double alpha = 0.0);
+
+  /**
+   * Factorize the given sparse matrix.
+   *
+   * @param V Input matrix to be factorized; items are rows and users are
+   *     columns.
+   * @param r Rank r of the factorization.
+   * @param W Item matrix to be output (n x r).
+   * @param H User matrix to be output (r x m).
+   */
+  void Apply(const arma::sp_mat& V,
+             const size_t r,
+             arma::mat& W,
+             arma::mat& H) const;
+
+  /**
+   * Factorize a rating matrix whose users and items are partitioned between
+   * the ranks of Comm(): the users of each rank are a contiguous block of the
+   * users (numbered in rank order), and so are its items.  Every rank must
+   * call this at once, with the same rank r, and gets the whole factorization.
+   * The initial factors, and so the result, do not depend on how the users
+   * are partitioned, only on the state of the random number generator of the
+   * first rank.  Without a communicator, userRatings is the whole rating
+   * matrix, and itemRatings its transpose.
+   *
+   * Each iteration exchanges the factors of all users and all items (by
+   * summing blocks which are zero outside of each rank), so every rank needs
+   * the memory for W and H, as well as for its two shards of ratings.
+   *
+   * @param userRatings Ratings of the users of this rank (items are rows, and
+   *     the users of this rank are columns).
+   * @param itemRatings Ratings of the items of this rank, transposed (users are
+   *     rows, and the items of this rank are columns).
+   * @param r Rank r of the factorization.
+   * @param W Item matrix to be output (n x r, for all items).
+   * @param H User matrix to be output (r x m, for all users).
+   */
+  void Apply(const arma::sp_mat& userRatings,
+             const arma::sp_mat& itemRatings,
+             const size_t r,
+             arma::mat& W,
+             arma::mat& H) const;
+
+  //! Access the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+  //! Access the minimum residue before termination.
+  double MinResidue() const { return minResidue; }
+  //! Modify the minimum residue before termination.
+  double& MinResidue() { return minResidue; }
+  //! Access the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+  //! Access the confidence scaling (0 for explicit feedback).
+  double Alpha() const { return alpha; }
+  //! Modify the confidence scaling (0 for explicit feedback).
+  double& Alpha() { return alpha; }
+  //! Get the number of threads used.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used (1 is serial, 0 uses all cores).
+  size_t& Threads() { return threads; }
+  //! Get the communicator of the ranks the ratings are sharded over (NULL if
+  //! the factorization runs on one process).
+  Communicator* Comm() const { return comm; }
+  //! Modify the communicator of the ranks the ratings are sharded over; it is
+  //! used by the sharded overload of Apply().
+  Communicator*& Comm() { return comm; }
+
+ private:
+  //! The maximum number of iterations allowed before giving up.
+  size_t maxIterations;
+  //! The minimum residue, below which iteration is considered converged.
+  double minResidue;
+  //! The regularization parameter.
+  double lambda;
+  //! The confidence scaling of observed ratings.
+  double alpha;
+  //! The number of threads to use.
+  size_t threads;
+  //! The communicator of the ranks the ratings are sharded over (may be NULL).
+  Communicator* comm;
+
+  /**
+   * Solve for each column of the given factors while holding the other factor
+   * matrix fixed.  Column j of factors is computed from the nonzero entries of
+   * column j of V, where row i of V corresponds to column i of fixed.
+   *
+   * @param V Ratings, with one column for each column of factors.
+   * @param fixed Factor matrix held fixed (r x V.n_rows).
+   * @param factors Factor matrix to solve for (r x V.n_cols).
+   */
+  void Solve(const arma::sp_mat& V,
+             const arma::mat& fixed,
+             arma::mat& factors) const;
+
+  /**
+   * Compute the objective of the given factorization.  Only the observed
+   * ratings are visited.
+   *
+   * @param V Ratings.
+   * @param Wt Transposed item matrix (r x n).
+   * @param H User matrix (r x m).
+   */
+  double Objective(const arma::sp_mat& V,
+                   const arma::mat& Wt,
+                   const arma::mat& H) const;
+
+  /**
+   * Compute the part of the objective which depends on the given users: the
+   * error of their observed ratings (and, with implicit feedback, of their
+   * unobserved ones) and the regularization of their factors.  The objective
+   * is the sum of this over all users, plus the regularization of Wt.
+   *
+   * @param V Ratings of the users (one column for each column of H).
+   * @param Wt Transposed item matrix (r x n).
+   * @param H Factors of the users.
+   */
+  double UserObjective(const arma::sp_mat& V,
+                       const arma::mat& Wt,
+                       const arma::mat& H) const;
+
+  /**
+   * Assemble the factors of all ranks: each rank gives the factors of its own
+   * block of columns, and every rank gets all columns.  Without a
+   * communicator, this copies the factors.
+   *
+   * @param local Factors of the columns of this rank.
+   * @param offset Index of the first column of this rank.
+   * @param columns Total number of columns.
+   * @param global Matrix to store the factors of all columns in.
+   */
+  void Exchange(const arma::mat& local,
+                const size_t offset,
+                const size_t columns,
+                arma::mat& global) const;
+
+  /**
+   * Return the index of the first column of this rank, given the number of
+   * columns of this rank, and store the total number of columns.
+   */
+  size_t Offset(const size_t localColumns, size_t& columns) const;
+
+  //! Return the number of threads to use.
+  size_t NumThreads() const;
+};
+
+}; // namespace cf
+}; // namespace mlpack
+
+#endif
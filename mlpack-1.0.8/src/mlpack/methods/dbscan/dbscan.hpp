@@ -0,0 +1,180 @@
+/**
+ * @file dbscan.hpp
+ *
+ * Defines the DBSCAN class, which performs density-based clustering with
+ * tree-based range queries.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/emst/concurrent_union_find.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+
+namespace mlpack {
+namespace dbscan /** Density-based clustering. */ {
+
+/**
+ * The DBSCAN class performs density-based clustering (Ester et al., 1996).  A
+ * point is a core point if at least MinPoints() points (including itself) lie
+ * within Epsilon() of it.  Core points within Epsilon() of each other are in
+ * the same cluster; a point which is not a core point but lies within
+ * Epsilon() of one (a border point) joins the cluster of one of them; and the
+ * other points are noise.
+ *
+ * Only one tree is built on the dataset, and the neighborhoods are never
+ * stored: the core points are found with RangeSearch::Count(), and then a
+ * second range search hands each pair of points within Epsilon() to a
+ * visitor, which merges the clusters of pairs of core points in an
+ * emst::ConcurrentUnionFind.  So the memory used is linear in the number of
+ * points, however dense the data is.
+ *
+ * @code
+ * @inproceedings{ester1996density,
+ *   title={A Density-Based Algorithm for Discovering Clusters in Large Spatial
+ *       Databases with Noise},
+ *   author={Ester, M. and Kriegel, H.-P. and Sander, J. and Xu, X.},
+ *   booktitle={Proceedings of the Second International Conference on
+ *       Knowledge Discovery and Data Mining (KDD '96)},
+ *   pages={226--231},
+ *   year={1996}
+ * }
+ * @endcode
+ *
+ * @tparam MetricType Metric to use.
+ * @tparam TreeType Type of tree to use for the range searches.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+                                                   range::RangeSearchStat> >
+class DBSCAN
+{
+ public:
+  //! The assignment of the noise points.
+  static const size_t Noise = (size_t) -1;
+
+  /**
+   * Set the parameters of the clustering.
+   *
+   * @param epsilon Radius of the neighborhood of each point.
+   * @param minPoints Number of points (including the point itself) in the
+   *     neighborhood of a core point.
+   * @param leafSize Leaf size of the tree.
+   * @param metric Instantiated distance metric.
+   */
+  DBSCAN(const double epsilon,
+         const size_t minPoints,
+         const size_t leafSize = 20,
+         const MetricType metric = MetricType());
+
+  /**
+   * Cluster the given dataset.  Clusters are numbered from 0, in order of the
+   * smallest point index they contain; noise points are assigned Noise.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store the cluster of each point in.
+   * @return The number of clusters.
+   */
+  size_t Cluster(const typename TreeType::Mat& data,
+                 arma::Col<size_t>& assignments);
+
+  //! Get the radius of the neighborhoods.
+  double Epsilon() const { return epsilon; }
+  //! Modify the radius of the neighborhoods.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the number of points in the neighborhood of a core point.
+  size_t MinPoints() const { return minPoints; }
+  //! Modify the number of points in the neighborhood of a core point.
+  size_t& MinPoints() { return minPoints; }
+
+  //! Get the leaf size of the tree.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size of the tree.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the number of threads used for the range searches.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the range searches (1 is serial, 0
+  //! means all available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of core points found by the last call to Cluster().
+  size_t NumCorePoints() const { return numCorePoints; }
+
+ private:
+  /**
+   * The visitor of the pairs of points within epsilon: it merges the clusters
+   * of pairs of core points, and gives each border point a core point to join.
+   * Each query point is searched by one thread only, and the union-find
+   * structure is safe to use concurrently, so several threads can use it at
+   * once.
+   */
+  class MergeVisitor
+  {
+   public:
+    //! Construct the visitor.
+    MergeVisitor(const std::vector<char>& core,
+                 emst::ConcurrentUnionFind& components,
+                 std::vector<size_t>& borderCore) :
+        core(core), components(components), borderCore(borderCore) { }
+
+    //! Handle a pair of points within epsilon.
+    void operator()(const size_t queryIndex,
+                    const size_t referenceIndex,
+                    const double /* distance */)
+    {
+      if (!core[referenceIndex])
+        return;
+
+      if (core[queryIndex])
+        components.Union(queryIndex, referenceIndex);
+      else if (borderCore[queryIndex] == Noise)
+        borderCore[queryIndex] = referenceIndex;
+    }
+
+   private:
+    //! Whether each point is a core point.
+    const std::vector<char>& core;
+    //! The components of the core points.
+    emst::ConcurrentUnionFind& components;
+    //! A core point within epsilon of each border point (Noise otherwise).
+    std::vector<size_t>& borderCore;
+  };
+
+  //! The radius of the neighborhoods.
+  double epsilon;
+  //! The number of points in the neighborhood of a core point.
+  size_t minPoints;
+  //! The leaf size of the tree.
+  size_t leafSize;
+  //! The number of threads.
+  size_t threads;
+  //! The instantiated metric.
+  MetricType metric;
+  //! The number of core points found by the last clustering.
+  size_t numCorePoints;
+};
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+// Include implementation.
+#include "dbscan_impl.hpp"
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file dbscan_impl.hpp
+ *
+ * Implementation of the DBSCAN class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_IMPL_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dbscan.hpp"
+
+namespace mlpack {
+namespace dbscan {
+
+// The definition of the static member.
+template<typename MetricType, typename TreeType>
+const size_t DBSCAN<MetricType, TreeType>::Noise;
+
+template<typename MetricType, typename TreeType>
+DBSCAN<MetricType, TreeType>::DBSCAN(const double epsilon,
+                                     const size_t minPoints,
+                                     const size_t leafSize,
+                                     const MetricType metric) :
+    epsilon(epsilon),
+    minPoints(minPoints),
+    leafSize(leafSize),
+    threads(1),
+    metric(metric),
+    numCorePoints(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+size_t DBSCAN<MetricType, TreeType>::Cluster(
+    const typename TreeType::Mat& data,
+    arma::Col<size_t>& assignments)
+{
+  if (epsilon < 0.0)
+    Log::Fatal << "DBSCAN::Cluster(): epsilon (" << epsilon << ") must be "
+        << "non-negative." << std::endl;
+
+  // Single-tree search, so that only one tree is built.  The results of the
+  // searches are mapped back to the original indices of the points.
+  range::RangeSearch<MetricType, TreeType> rangeSearch(data, false, true,
+      leafSize, metric);
+  rangeSearch.Threads() = threads;
+  const math::Range range(0.0, epsilon);
+
+  // Find the core points; the counts do not include the points themselves.
+  Timer::Start("dbscan/core_points");
+  arma::Col<size_t> counts;
+  rangeSearch.Count(range, counts);
+
+  std::vector<char> core(data.n_cols, 0);
+  numCorePoints = 0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    if (counts[i] + 1 >= minPoints)
+    {
+      core[i] = 1;
+      ++numCorePoints;
+    }
+  }
+  Timer::Stop("dbscan/core_points");
+
+  // Merge the neighborhoods of the core points, and find a core point for
+  // each border point.
+  Timer::Start("dbscan/merging");
+  emst::ConcurrentUnionFind components(data.n_cols);
+  std::vector<size_t> borderCore(data.n_cols, Noise);
+  MergeVisitor visitor(core, components, borderCore);
+  rangeSearch.Search(range, visitor);
+  Timer::Stop("dbscan/merging");
+
+  // Number the clusters in order of their smallest point.
+  std::vector<size_t> labels(data.n_cols, Noise);
+  size_t numClusters = 0;
+  assignments.set_size(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    // Border points join the cluster of their core point.
+    const size_t corePoint = core[i] ? i : borderCore[i];
+    if (corePoint == Noise)
+    {
+      assignments[i] = Noise;
+      continue;
+    }
+
+    const size_t component = components.Find(corePoint);
+    if (labels[component] == Noise)
+      labels[component] = numClusters++;
+    assignments[i] = labels[component];
+  }
+
+  Log::Info << numClusters << " clusters found; " << numCorePoints << " core "
+      << "points." << std::endl;
+
+  return numClusters;
+}
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file dbscan_main.cpp
+ *
+ * Executable for DBSCAN clustering.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+
+#include "dbscan.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::dbscan;
+
+PROGRAM_INFO("DBSCAN clustering",
+    "This program clusters the given dataset with DBSCAN.  A point is a core "
+    "point if at least --min_size (-m) points, including itself, lie within "
+    "--epsilon (-e) of it.  Core points within --epsilon of each other are in "
+    "the same cluster, points within --epsilon of a core point join its "
+    "cluster, and the other points are noise."
+    "\n\n"
+    "One kd-tree is built on the dataset, and the neighborhoods of the points "
+    "are never stored, so the memory used does not grow with the density of "
+    "the data."
+    "\n\n"
+    "The cluster of each point is saved to --output_file (-o), one line for "
+    "each point; clusters are numbered from 0, and noise points are given "
+    "-1.");
+
+PARAM_STRING_REQ("input_file", "File containing the dataset to cluster.", "i");
+PARAM_STRING("output_file", "File to save the cluster of each point to.", "o",
+    "assignments.csv");
+PARAM_DOUBLE("epsilon", "Radius of the neighborhood of each point.", "e", 1.0);
+PARAM_INT("min_size", "Number of points in the neighborhood of a core point.",
+    "m", 5);
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_INT("threads", "Number of threads to use for the range searches (0 "
+    "means all available cores).", "j", 1);
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string inputFile = CLI::GetParam<string>("input_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  const int minSize = CLI::GetParam<int>("min_size");
+  const int leafSize = CLI::GetParam<int>("leaf_size");
+  const int threads = CLI::GetParam<int>("threads");
+
+  // Sanity check the parameters.
+  if (epsilon < 0.0)
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be greater than "
+        << "or equal to 0." << endl;
+  if (minSize <= 0)
+    Log::Fatal << "Invalid minimum size: " << minSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (leafSize <= 0)
+    Log::Fatal << "Invalid leaf size: " << leafSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  arma::mat data;
+  data::Load(inputFile, data, true);
+  Log::Info << "Loaded data from '" << inputFile << "' (" << data.n_rows
+      << " x " << data.n_cols << ")." << endl;
+
+  DBSCAN<> dbscan(epsilon, (size_t) minSize, (size_t) leafSize);
+  dbscan.Threads() = (size_t) threads;
+
+  arma::Col<size_t> assignments;
+  const size_t clusters = dbscan.Cluster(data, assignments);
+
+  size_t noise = 0;
+  arma::rowvec output(assignments.n_elem);
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+  {
+    if (assignments[i] == DBSCAN<>::Noise)
+    {
+      output[i] = -1;
+      ++noise;
+    }
+    else
+    {
+      output[i] = assignments[i];
+    }
+  }
+
+  Log::Info << clusters << " clusters; " << noise << " noise points."
+      << endl;
+
+  // Save the assignments as a row, so that each point takes one line.
+  data::Save(outputFile, output, true);
+}
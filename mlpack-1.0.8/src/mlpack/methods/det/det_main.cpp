@@ -22,6 +22,7 @@
 
 #include <mlpack/core.hpp>
 #include "dt_utils.hpp"
+#include "flat_dtree.hpp"
 
 using namespace mlpack;
 using namespace mlpack::det;
@@ -64,6 +65,9 @@ PARAM_STRING("tree_file", "The file in which to print the final optimally "
     "pruned tree.", "r", "");
 PARAM_STRING("vi_file", "The file to output the variable importance values "
     "for each feature.", "i", "");
+PARAM_STRING("flat_tree_file", "The file in which to save the final optimally "
+    "pruned tree as a flattened binary tree, for fast density queries.", "F",
+    "");
 
 // Parameters for the algorithm.
 PARAM_INT("folds", "The number of folds of cross-validation to perform for the "
@@ -72,6 +76,12 @@ PARAM_INT("min_leaf_size", "The minimum size of a leaf in the unpruned, fully "
     "grown DET.", "N", 5);
 PARAM_INT("max_leaf_size", "The maximum size of a leaf in the unpruned, fully "
     "grown DET.", "M", 10);
+PARAM_INT("threads", "Number of threads to use for cross-validation and tree "
+    "growing (0 uses all available cores); only used if mlpack was built with "
+    "OpenMP.", "j", 1);
+PARAM_INT("histogram_bins", "If nonzero, the splits of large nodes are only "
+    "searched for at the edges of this many bins of equal width, which is "
+    "approximate but faster.", "B", 0);
 /*
 PARAM_FLAG("volume_regularization", "This flag gives the used the option to use"
     "a form of regularization similar to the usual alpha-pruning in decision "
@@ -113,11 +123,22 @@ int main(int argc, char *argv[])
 //  const bool regularization = CLI::HasParam("volume_regularization");
   const int maxLeafSize = CLI::GetParam<int>("max_leaf_size");
   const int minLeafSize = CLI::GetParam<int>("min_leaf_size");
+  const int threads = CLI::GetParam<int>("threads");
+  const int histogramBins = CLI::GetParam<int>("histogram_bins");
+
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (histogramBins < 0)
+    Log::Fatal << "Invalid number of histogram bins: " << histogramBins
+        << ".  Must be greater than or equal to 0." << endl;
 
   // Obtain the optimal tree.
   Timer::Start("det_training");
   DTree *dtreeOpt = Trainer(trainingData, folds, regularization, maxLeafSize,
-      minLeafSize, unprunedTreeEstimateFile);
+      minLeafSize, unprunedTreeEstimateFile, (size_t) threads,
+      (size_t) histogramBins);
   Timer::Stop("det_training");
 
   // Compute densities for the training points in the optimal tree.
@@ -151,15 +172,27 @@ int main(int argc, char *argv[])
     {
       fp = fopen(CLI::GetParam<string>("test_set_estimates_file").c_str(), "w");
 
+      // The flattened tree is much faster for many queries.
       Timer::Start("det_test_set_estimation");
-      for (size_t i = 0; i < testData.n_cols; i++)
-        fprintf(fp, "%lg\n", dtreeOpt->ComputeValue(testData.unsafe_col(i)));
+      const FlatDTree flatTree(*dtreeOpt);
+      arma::vec testDensities;
+      flatTree.ComputeValue(testData, testDensities);
       Timer::Stop("det_test_set_estimation");
 
+      for (size_t i = 0; i < testData.n_cols; i++)
+        fprintf(fp, "%lg\n", testDensities[i]);
+
       fclose(fp);
     }
   }
 
+  // Save the flattened tree.
+  if (CLI::GetParam<string>("flat_tree_file") != "")
+  {
+    const FlatDTree flatTree(*dtreeOpt);
+    flatTree.Save(CLI::GetParam<string>("flat_tree_file"));
+  }
+
   // Print the final tree.
   if (CLI::HasParam("print_tree"))
   {
@@ -22,6 +22,10 @@
  */
 #include "dt_utils.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace det;
 
@@ -116,8 +120,12 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
                             const bool useVolumeReg,
                             const size_t maxLeafSize,
                             const size_t minLeafSize,
-                            const std::string unprunedTreeOutput)
+                            const std::string unprunedTreeOutput,
+                            const size_t threads,
+                            const size_t histogramBins)
 {
+  size_t numThreads = Threads::Count(threads);
+
   // Initialize the tree.
   DTree* dtree = new DTree(dataset);
 
@@ -132,7 +140,7 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   // Growing the tree
   double oldAlpha = 0.0;
   double alpha = dtree->Grow(newDataset, oldFromNew, useVolumeReg, maxLeafSize,
-      minLeafSize);
+      minLeafSize, numThreads, histogramBins);
 
   Log::Info << dtree->SubtreeLeaves() << " leaf nodes in the tree using full "
       << "dataset; minimum alpha: " << alpha << "." << std::endl;
@@ -188,11 +196,16 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   arma::mat cvData(dataset);
   size_t testSize = dataset.n_cols / folds;
 
-  std::vector<double> regularizationConstants;
-  regularizationConstants.resize(prunedSequence.size(), 0);
+  // The folds are independent, so they can be cross-validated in parallel.
+  // Each fold stores its own contributions to the regularization constants,
+  // which are summed in order afterwards, so the result does not depend on the
+  // number of threads.
+  arma::mat foldConstants(prunedSequence.size(), folds);
+  foldConstants.zeros();
 
   // Go through each fold.
-  for (size_t fold = 0; fold < folds; fold++)
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int fold = 0; fold < (int) folds; fold++)
   {
     // Break up data into train and test sets.
     size_t start = fold * testSize;
@@ -223,10 +236,9 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
     for (size_t i = 0; i < cvOldFromNew.n_elem; i++)
       cvOldFromNew[i] = i;
 
-    // Grow the tree.
-    oldAlpha = 0.0;
-    alpha = cvDTree->Grow(train, cvOldFromNew, useVolumeReg, maxLeafSize,
-        minLeafSize);
+    // Grow the tree (serially, since the folds are already parallel).
+    cvDTree->Grow(train, cvOldFromNew, useVolumeReg, maxLeafSize, minLeafSize,
+        1, histogramBins);
 
     // Sequentially prune with all the values of available alphas and adding
     // values for test values.
@@ -241,12 +253,12 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
       }
 
       // Update the cv regularization constant.
-      regularizationConstants[i] += 2.0 * cvVal / (double) dataset.n_cols;
+      foldConstants(i, fold) = 2.0 * cvVal / (double) dataset.n_cols;
 
       // Determine the new alpha value and prune accordingly.
-      oldAlpha = 0.5 * (prunedSequence[i + 1].first +
+      const double cvAlpha = 0.5 * (prunedSequence[i + 1].first +
           prunedSequence[i + 2].first);
-      alpha = cvDTree->PruneAndUpdate(oldAlpha, train.n_cols, useVolumeReg);
+      cvDTree->PruneAndUpdate(cvAlpha, train.n_cols, useVolumeReg);
     }
 
     // Compute test values for this state of the tree.
@@ -257,13 +269,19 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
       cvVal += cvDTree->ComputeValue(testPoint);
     }
 
-    regularizationConstants[prunedSequence.size() - 2] += 2.0 * cvVal /
+    foldConstants(prunedSequence.size() - 2, fold) = 2.0 * cvVal /
         (double) dataset.n_cols;
 
     test.reset();
     delete cvDTree;
   }
 
+  std::vector<double> regularizationConstants;
+  regularizationConstants.resize(prunedSequence.size(), 0);
+  for (size_t fold = 0; fold < folds; ++fold)
+    for (size_t i = 0; i < prunedSequence.size(); ++i)
+      regularizationConstants[i] += foldConstants(i, fold);
+
   double optimalAlpha = -1.0;
   long double cvBestError = -std::numeric_limits<long double>::max();
 
@@ -296,7 +314,7 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   // Grow the tree.
   oldAlpha = -DBL_MAX;
   alpha = dtreeOpt->Grow(newDataset, oldFromNew, useVolumeReg, maxLeafSize,
-      minLeafSize);
+      minLeafSize, numThreads, histogramBins);
 
   // Prune with optimal alpha.
   while ((oldAlpha < optimalAlpha) && (dtreeOpt->SubtreeLeaves() > 1))
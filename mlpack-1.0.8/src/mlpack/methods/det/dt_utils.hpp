@@ -62,19 +62,28 @@ void PrintVariableImportance(const DTree* dtree,
  * of folds.  Optionally, give a filename to print the unpruned tree to.  This
  * initializes a tree on the heap, so you are responsible for deleting it.
  *
+ * The folds are cross-validated in parallel and the full tree is grown in
+ * parallel if more than one thread is used; the returned tree does not depend
+ * on the number of threads.
+ *
  * @param dataset Dataset for the tree to use.
  * @param folds Number of folds to use for cross-validation.
  * @param useVolumeReg If true, use volume regularization.
  * @param maxLeafSize Maximum number of points allowed in a leaf.
  * @param minLeafSize Minimum number of points allowed in a leaf.
  * @param unprunedTreeOutput Filename to print unpruned tree to (optional).
+ * @param threads Number of threads to use (0 means all available cores).
+ * @param histogramBins Number of bins to search for splits of large nodes with
+ *     (0 means splits are always exact; see DTree::Grow()).
  */
 DTree* Trainer(arma::mat& dataset,
                const size_t folds,
                const bool useVolumeReg = false,
                const size_t maxLeafSize = 10,
                const size_t minLeafSize = 5,
-               const std::string unprunedTreeOutput = "");
+               const std::string unprunedTreeOutput = "",
+               const size_t threads = 1,
+               const size_t histogramBins = 0);
 
 }; // namespace det
 }; // namespace mlpack
@@ -23,6 +23,11 @@
  */
 #include "dtree.hpp"
 #include <stack>
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 using namespace mlpack;
 using namespace det;
@@ -153,11 +158,37 @@ bool DTree::FindSplit(const arma::mat& data,
   assert(data.n_rows == maxVals.n_elem);
   assert(data.n_rows == minVals.n_elem);
 
+  // Sort the values of each dimension in ascending order.
+  arma::mat sortedValues(end - start, data.n_rows);
+  for (size_t dim = 0; dim < data.n_rows; ++dim)
+    sortedValues.col(dim) =
+        arma::sort(data.row(dim).subvec(start, end - 1).t());
+
+  return FindSortedSplit(sortedValues, 0, data.n_cols, splitDim, splitValue,
+      leftError, rightError, maxLeafSize, minLeafSize, 0);
+}
+
+// The split search itself, on values that are already sorted.
+bool DTree::FindSortedSplit(const arma::mat& sortedValues,
+                            const size_t offset,
+                            const size_t totalPoints,
+                            size_t& splitDim,
+                            double& splitValue,
+                            double& leftError,
+                            double& rightError,
+                            const size_t maxLeafSize,
+                            const size_t minLeafSize,
+                            const size_t histogramBins) const
+{
   const size_t points = end - start;
 
   double minError = logNegError;
   bool splitFound = false;
 
+  // Large nodes may only be split at the edges of the histogram bins.
+  const bool useHistogram = (histogramBins > 0) &&
+      (points > 10 * histogramBins);
+
   // Loop through each dimension.
   for (size_t dim = 0; dim < maxVals.n_elem; dim++)
   {
@@ -181,57 +212,89 @@ bool DTree::FindSplit(const arma::mat& data,
     // Find the log volume of all the other dimensions.
     double volumeWithoutDim = logVolume - std::log(max - min);
 
-    // Get the values for the dimension.
-    arma::rowvec dimVec = data.row(dim).subvec(start, end - 1);
-
-    // Sort the values in ascending order.
-    dimVec = arma::sort(dimVec);
+    // The sorted values for the dimension.
+    const double* dimVec = sortedValues.colptr(dim) + offset;
 
     // Get ready to go through the sorted list and compute error.
-    assert(dimVec.n_elem > maxLeafSize);
+    assert(points > maxLeafSize);
 
-    // Find the best split for this dimension.  We need to figure out why
-    // there are spikes if this minLeafSize is enforced here...
-    for (size_t i = minLeafSize - 1; i < dimVec.n_elem - minLeafSize; ++i)
+    if (useHistogram)
     {
-      // This makes sense for real continuous data.  This kinda corrupts the
-      // data and estimation if the data is ordinal.
-      const double split = (dimVec[i] + dimVec[i + 1]) / 2.0;
+      // Try the edges of the bins; the number of points left of each edge is
+      // found by binary search in the sorted values.
+      for (size_t b = 1; b < histogramBins; ++b)
+      {
+        const double split = min + (max - min) * b / histogramBins;
+        const size_t leftPoints = std::upper_bound(dimVec, dimVec + points,
+            split) - dimVec;
 
-      if (split == dimVec[i])
-        continue; // We can't split here (two points are the same).
+        if ((leftPoints < minLeafSize) || (points - leftPoints < minLeafSize))
+          continue;
 
-      // Another way of picking split is using this:
-      //   split = leftsplit;
-      if ((split - min > 0.0) && (max - split > 0.0))
+        if ((split - min > 0.0) && (max - split > 0.0))
+        {
+          // See below for the condition.
+          double negLeftError = std::pow(leftPoints, 2.0) / (split - min);
+          double negRightError = std::pow(points - leftPoints, 2.0) /
+              (max - split);
+
+          if ((negLeftError + negRightError) >= minDimError)
+          {
+            minDimError = negLeftError + negRightError;
+            dimLeftError = negLeftError;
+            dimRightError = negRightError;
+            dimSplitValue = split;
+            dimSplitFound = true;
+          }
+        }
+      }
+    }
+    else
+    {
+      // Find the best split for this dimension.  We need to figure out why
+      // there are spikes if this minLeafSize is enforced here...
+      for (size_t i = minLeafSize - 1; i < points - minLeafSize; ++i)
       {
-        // Ensure that the right node will have at least the minimum number of
-        // points.
-        Log::Assert((points - i - 1) >= minLeafSize);
-
-        // Now we have to see if the error will be reduced.  Simple manipulation
-        // of the error function gives us the condition we must satisfy:
-        //   |t_l|^2 / V_l + |t_r|^2 / V_r  >= |t|^2 / (V_l + V_r)
-        // and because the volume is only dependent on the dimension we are
-        // splitting, we can assume V_l is just the range of the left and V_r is
-        // just the range of the right.
-        double negLeftError = std::pow(i + 1, 2.0) / (split - min);
-        double negRightError = std::pow(points - i - 1, 2.0) / (max - split);
-
-        // If this is better, take it.
-        if ((negLeftError + negRightError) >= minDimError)
+        // This makes sense for real continuous data.  This kinda corrupts the
+        // data and estimation if the data is ordinal.
+        const double split = (dimVec[i] + dimVec[i + 1]) / 2.0;
+
+        if (split == dimVec[i])
+          continue; // We can't split here (two points are the same).
+
+        // Another way of picking split is using this:
+        //   split = leftsplit;
+        if ((split - min > 0.0) && (max - split > 0.0))
         {
-          minDimError = negLeftError + negRightError;
-          dimLeftError = negLeftError;
-          dimRightError = negRightError;
-          dimSplitValue = split;
-          dimSplitFound = true;
+          // Ensure that the right node will have at least the minimum number
+          // of points.
+          Log::Assert((points - i - 1) >= minLeafSize);
+
+          // Now we have to see if the error will be reduced.  Simple
+          // manipulation of the error function gives us the condition we must
+          // satisfy:
+          //   |t_l|^2 / V_l + |t_r|^2 / V_r  >= |t|^2 / (V_l + V_r)
+          // and because the volume is only dependent on the dimension we are
+          // splitting, we can assume V_l is just the range of the left and V_r
+          // is just the range of the right.
+          double negLeftError = std::pow(i + 1, 2.0) / (split - min);
+          double negRightError = std::pow(points - i - 1, 2.0) / (max - split);
+
+          // If this is better, take it.
+          if ((negLeftError + negRightError) >= minDimError)
+          {
+            minDimError = negLeftError + negRightError;
+            dimLeftError = negLeftError;
+            dimRightError = negRightError;
+            dimSplitValue = split;
+            dimSplitFound = true;
+          }
         }
       }
     }
 
     double actualMinDimError = std::log(minDimError)
-        - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
+        - 2 * std::log((double) totalPoints) - volumeWithoutDim;
 
     if ((actualMinDimError > minError) && dimSplitFound)
     {
@@ -240,9 +303,9 @@ bool DTree::FindSplit(const arma::mat& data,
       minError = actualMinDimError;
       splitDim = dim;
       splitValue = dimSplitValue;
-      leftError = std::log(dimLeftError) - 2 * std::log((double) data.n_cols)
+      leftError = std::log(dimLeftError) - 2 * std::log((double) totalPoints)
           - volumeWithoutDim;
-      rightError = std::log(dimRightError) - 2 * std::log((double) data.n_cols)
+      rightError = std::log(dimRightError) - 2 * std::log((double) totalPoints)
           - volumeWithoutDim;
       splitFound = true;
     } // end if better split found in this dimension.
@@ -284,12 +347,110 @@ size_t DTree::SplitData(arma::mat& data,
   return left;
 }
 
+void DTree::SplitSorted(SortedPoints& sorted,
+                        const size_t splitDim,
+                        const size_t splitIndex) const
+{
+  // The values of the split dimension are sorted, so the points of the left
+  // child come first.
+  const size_t* splitIds = sorted.ids.colptr(splitDim);
+  for (size_t i = start; i < end; ++i)
+    sorted.goesLeft[splitIds[i]] = (i < splitIndex);
+
+  // Stably partition the other dimensions; the left points are moved down in
+  // place and the right points are buffered, then copied after them.
+  for (size_t dim = 0; dim < sorted.values.n_cols; ++dim)
+  {
+    if (dim == splitDim)
+      continue;
+
+    double* values = sorted.values.colptr(dim);
+    size_t* ids = sorted.ids.colptr(dim);
+    size_t leftPos = start;
+    size_t rightPos = start;
+    for (size_t i = start; i < end; ++i)
+    {
+      if (sorted.goesLeft[ids[i]])
+      {
+        values[leftPos] = values[i];
+        ids[leftPos] = ids[i];
+        ++leftPos;
+      }
+      else
+      {
+        sorted.valueBuffer[rightPos] = values[i];
+        sorted.idBuffer[rightPos] = ids[i];
+        ++rightPos;
+      }
+    }
+
+    Log::Assert(leftPos == splitIndex);
+    for (size_t i = start; i < rightPos; ++i)
+    {
+      values[leftPos + i - start] = sorted.valueBuffer[i];
+      ids[leftPos + i - start] = sorted.idBuffer[i];
+    }
+  }
+}
+
 // Greedily expand the tree
 double DTree::Grow(arma::mat& data,
                    arma::Col<size_t>& oldFromNew,
                    const bool useVolReg,
                    const size_t maxLeafSize,
-                   const size_t minLeafSize)
+                   const size_t minLeafSize,
+                   const size_t threads,
+                   const size_t histogramBins)
+{
+  // Sort the values of each dimension once; the ids of the points are their
+  // columns now.
+  SortedPoints sorted;
+  sorted.values.set_size(data.n_cols, data.n_rows);
+  sorted.ids.set_size(data.n_cols, data.n_rows);
+  sorted.valueBuffer.set_size(data.n_cols);
+  sorted.idBuffer.set_size(data.n_cols);
+  sorted.goesLeft.resize(data.n_cols);
+  for (size_t dim = 0; dim < data.n_rows; ++dim)
+  {
+    const arma::uvec order =
+        arma::sort_index(data.row(dim).subvec(start, end - 1));
+    for (size_t i = 0; i < order.n_elem; ++i)
+    {
+      sorted.ids(start + i, dim) = start + order[i];
+      sorted.values(start + i, dim) = data(dim, start + order[i]);
+    }
+  }
+
+  // Inside a parallel region (when cross-validating, for instance), this is
+  // 1, and the tree is grown serially.
+  const size_t numThreads = Threads::Count(threads);
+#ifdef _OPENMP
+  if (numThreads > 1)
+  {
+    double g;
+    #pragma omp parallel num_threads(numThreads)
+    {
+      #pragma omp single
+      g = GrowNode(data, oldFromNew, sorted, useVolReg, maxLeafSize,
+          minLeafSize, histogramBins, true);
+    }
+
+    return g;
+  }
+#endif
+
+  return GrowNode(data, oldFromNew, sorted, useVolReg, maxLeafSize,
+      minLeafSize, histogramBins, false);
+}
+
+double DTree::GrowNode(arma::mat& data,
+                       arma::Col<size_t>& oldFromNew,
+                       SortedPoints& sorted,
+                       const bool useVolReg,
+                       const size_t maxLeafSize,
+                       const size_t minLeafSize,
+                       const size_t histogramBins,
+                       const bool parallel)
 {
   Log::Assert(data.n_rows == maxVals.n_elem);
   Log::Assert(data.n_rows == minVals.n_elem);
@@ -312,12 +473,14 @@ double DTree::Grow(arma::mat& data,
     size_t dim;
     double splitValueTmp;
     double leftError, rightError;
-    if (FindSplit(data, dim, splitValueTmp, leftError, rightError, maxLeafSize,
-        minLeafSize))
+    if (FindSortedSplit(sorted.values, start, data.n_cols, dim, splitValueTmp,
+        leftError, rightError, maxLeafSize, minLeafSize, histogramBins))
     {
       // Move the data around for the children to have points in a node lie
-      // contiguously (to increase efficiency during the training).
+      // contiguously (to increase efficiency during the training), and keep
+      // the sorted values sorted within each child.
       const size_t splitIndex = SplitData(data, dim, splitValueTmp, oldFromNew);
+      SplitSorted(sorted, dim, splitIndex);
 
       // Make max and min vals for the children.
       arma::vec maxValsL(maxVals);
@@ -336,10 +499,33 @@ double DTree::Grow(arma::mat& data,
       left = new DTree(maxValsL, minValsL, start, splitIndex, leftError);
       right = new DTree(maxValsR, minValsR, splitIndex, end, rightError);
 
-      leftG = left->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
-      rightG = right->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
+      // The children reorder disjoint parts of the dataset, so the left child
+      // can be grown in another task if the node is large enough to be worth
+      // it.  The task gets pointers, so that everything it writes is shared.
+      if (parallel && (end - start) >= 10000)
+      {
+        DTree* leftPtr = left;
+        arma::mat* dataPtr = &data;
+        arma::Col<size_t>* oldFromNewPtr = &oldFromNew;
+        SortedPoints* sortedPtr = &sorted;
+        double* leftGPtr = &leftG;
+
+        #pragma omp task
+        *leftGPtr = leftPtr->GrowNode(*dataPtr, *oldFromNewPtr, *sortedPtr,
+            useVolReg, maxLeafSize, minLeafSize, histogramBins, true);
+
+        rightG = right->GrowNode(data, oldFromNew, sorted, useVolReg,
+            maxLeafSize, minLeafSize, histogramBins, true);
+
+        #pragma omp taskwait
+      }
+      else
+      {
+        leftG = left->GrowNode(data, oldFromNew, sorted, useVolReg,
+            maxLeafSize, minLeafSize, histogramBins, parallel);
+        rightG = right->GrowNode(data, oldFromNew, sorted, useVolReg,
+            maxLeafSize, minLeafSize, histogramBins, parallel);
+      }
 
       // Store values of R(T~) and |T~|.
       subtreeLeaves = left->SubtreeLeaves() + right->SubtreeLeaves();
@@ -589,6 +775,12 @@ double DTree::ComputeValue(const arma::vec& query) const
   return 0.0;
 }
 
+void DTree::Predict(const arma::mat& points, arma::vec& densities) const
+{
+  densities.set_size(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    densities[i] = ComputeValue(points.unsafe_col(i));
+}
 
 void DTree::WriteTree(FILE *fp, const size_t level) const
 {
@@ -123,17 +123,33 @@ class DTree
    * Greedily expand the tree.  The points in the dataset will be reordered
    * during tree growth.
    *
+   * The values of each dimension are sorted once, at the root, and are kept
+   * sorted within each node as the points are split, so splits are found
+   * without sorting.  If histogramBins is nonzero, the splits of nodes with
+   * more than ten times that many points are only searched for at the edges of
+   * histogramBins bins of equal width, which is approximate but much faster.
+   *
+   * The children of large nodes are grown in parallel, as separate OpenMP
+   * tasks, if more than one thread is used; the children reorder disjoint
+   * parts of the dataset, so the tree is the same for any number of threads.
+   *
    * @param data Dataset to build tree on.
    * @param oldFromNew Mappings from old points to new points.
    * @param useVolReg If true, volume regularization is used.
    * @param maxLeafSize Maximum size of a leaf.
    * @param minLeafSize Minimum size of a leaf.
+   * @param threads Number of threads to grow with (0 means all available
+   *     cores).
+   * @param histogramBins Number of bins to search for splits of large nodes
+   *     with (0 means splits are always exact).
    */
   double Grow(arma::mat& data,
               arma::Col<size_t>& oldFromNew,
               const bool useVolReg = false,
               const size_t maxLeafSize = 10,
-              const size_t minLeafSize = 5);
+              const size_t minLeafSize = 5,
+              const size_t threads = 1,
+              const size_t histogramBins = 0);
 
   /**
    * Perform alpha pruning on a tree.  Returns the new value of alpha.
@@ -154,6 +170,15 @@ class DTree
    */
   double ComputeValue(const arma::vec& query) const;
 
+  /**
+   * Compute the density estimate of each of the given points, as
+   * ComputeValue() does.  This is the Predict() method of BatchPredict().
+   *
+   * @param points Points to estimate the density of (one per column).
+   * @param densities Vector to store the density estimates in.
+   */
+  void Predict(const arma::mat& points, arma::vec& densities) const;
+
   /**
    * Print the tree in a depth-first manner (this function is called
    * recursively).
@@ -308,6 +333,42 @@ class DTree
                  const size_t maxLeafSize = 10,
                  const size_t minLeafSize = 5) const;
 
+  /**
+   * The values of the points in each dimension, sorted once at the root and
+   * kept sorted within each node as the points are split.
+   */
+  struct SortedPoints
+  {
+    //! Column d holds the values of dimension d; the values of the points of a
+    //! node are sorted, in rows [start, end) of the node.
+    arma::mat values;
+    //! The ids (the columns of the points at the root) of the sorted values.
+    arma::Mat<size_t> ids;
+    //! Buffer of values for partitioning.
+    arma::vec valueBuffer;
+    //! Buffer of ids for partitioning.
+    arma::Col<size_t> idBuffer;
+    //! Whether each point, by id, goes left in the split being made.
+    std::vector<char> goesLeft;
+  };
+
+  /**
+   * Find the dimension to split on, given the sorted values of the points of
+   * this node in rows [offset, offset + end - start) of sortedValues (one
+   * column for each dimension).  If histogramBins is nonzero and the node is
+   * large, only the edges of histogramBins bins of equal width are tried.
+   */
+  bool FindSortedSplit(const arma::mat& sortedValues,
+                       const size_t offset,
+                       const size_t totalPoints,
+                       size_t& splitDim,
+                       double& splitValue,
+                       double& leftError,
+                       double& rightError,
+                       const size_t maxLeafSize,
+                       const size_t minLeafSize,
+                       const size_t histogramBins) const;
+
   /**
    * Split the data, returning the number of points left of the split.
    */
@@ -316,6 +377,28 @@ class DTree
                    const double splitValue,
                    arma::Col<size_t>& oldFromNew) const;
 
+  /**
+   * Stably partition the sorted values of every dimension for the split of
+   * this node on splitDim, so that they stay sorted within each child.
+   */
+  void SplitSorted(SortedPoints& sorted,
+                   const size_t splitDim,
+                   const size_t splitIndex) const;
+
+  /**
+   * Recursively grow the tree (this is the body of Grow()).  If parallel is
+   * true, this is called from inside a parallel region, and the left children
+   * of large nodes are grown as OpenMP tasks.
+   */
+  double GrowNode(arma::mat& data,
+                  arma::Col<size_t>& oldFromNew,
+                  SortedPoints& sorted,
+                  const bool useVolReg,
+                  const size_t maxLeafSize,
+                  const size_t minLeafSize,
+                  const size_t histogramBins,
+                  const bool parallel);
+
 };
 
 }; // namespace det
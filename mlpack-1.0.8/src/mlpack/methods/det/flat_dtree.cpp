@@ -0,0 +1,206 @@
+/**
+ * @file flat_dtree.cpp
+ *
+ * Implementation of FlatDTree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "flat_dtree.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <queue>
+#include <stack>
+
+using namespace mlpack;
+using namespace mlpack::det;
+
+// The file is an 8-byte magic string, the version, the dimensionality and the
+// number of nodes, each a 64-bit unsigned integer, the bounding box, and then
+// the nodes (value, dimension, child), all in host byte order.
+static const char flatDTreeMagic[8] = { 'M', 'L', 'P', 'K', 'F', 'D', 'E',
+    'T' };
+
+FlatDTree::FlatDTree()
+{
+  // A single leaf with no density.
+  Node leaf;
+  leaf.value = 0.0;
+  leaf.dim = 0;
+  leaf.child = 0;
+  nodes.push_back(leaf);
+}
+
+FlatDTree::FlatDTree(const DTree& tree) :
+    minVals(tree.MinVals()),
+    maxVals(tree.MaxVals())
+{
+  nodes.reserve(2 * tree.SubtreeLeaves() - 1);
+
+  // Lay the tree out in breadth-first order, giving the children of each node
+  // the next two free indices.
+  std::queue<const DTree*> queue;
+  queue.push(&tree);
+  nodes.resize(1);
+  for (size_t i = 0; !queue.empty(); ++i)
+  {
+    const DTree* node = queue.front();
+    queue.pop();
+
+    if (node->SubtreeLeaves() == 1)
+    {
+      nodes[i].value = std::exp(std::log(node->Ratio()) - node->LogVolume());
+      nodes[i].dim = 0;
+      nodes[i].child = 0;
+    }
+    else
+    {
+      nodes[i].value = node->SplitValue();
+      nodes[i].dim = node->SplitDim();
+      nodes[i].child = nodes.size();
+
+      nodes.resize(nodes.size() + 2);
+      queue.push(node->Left());
+      queue.push(node->Right());
+    }
+  }
+
+  // Tag the leaves from left to right, as DTree::TagTree() does.
+  int tag = 0;
+  std::stack<size_t> stack;
+  stack.push(0);
+  while (!stack.empty())
+  {
+    const size_t i = stack.top();
+    stack.pop();
+
+    if (nodes[i].child == 0)
+    {
+      nodes[i].dim = tag++;
+    }
+    else
+    {
+      stack.push(nodes[i].child + 1);
+      stack.push(nodes[i].child);
+    }
+  }
+}
+
+FlatDTree::FlatDTree(const std::string& filename)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open flat density estimation tree '" << filename
+        << "'." << std::endl;
+
+  char magic[8];
+  uint64_t header[3];
+  stream.read(magic, sizeof(magic));
+  stream.read((char*) header, sizeof(header));
+  if (!stream.good() || (memcmp(magic, flatDTreeMagic, sizeof(magic)) != 0))
+    Log::Fatal << "'" << filename << "' is not a flat density estimation "
+        << "tree." << std::endl;
+
+  if (header[0] != 1)
+    Log::Fatal << "Unsupported flat density estimation tree version "
+        << header[0] << " in '" << filename << "'." << std::endl;
+
+  const size_t dimensionality = (size_t) header[1];
+  const size_t numNodes = (size_t) header[2];
+
+  minVals.set_size(dimensionality);
+  maxVals.set_size(dimensionality);
+  stream.read((char*) minVals.memptr(), dimensionality * sizeof(double));
+  stream.read((char*) maxVals.memptr(), dimensionality * sizeof(double));
+
+  nodes.resize(numNodes);
+  for (size_t i = 0; i < numNodes; ++i)
+  {
+    uint64_t fields[2];
+    stream.read((char*) &nodes[i].value, sizeof(double));
+    stream.read((char*) fields, sizeof(fields));
+    nodes[i].dim = (size_t) fields[0];
+    nodes[i].child = (size_t) fields[1];
+
+    // Children always come after their parents, and internal nodes split on
+    // a real dimension.
+    if ((nodes[i].child != 0) && ((nodes[i].child <= i) ||
+        (nodes[i].child + 1 >= numNodes) || (nodes[i].dim >= dimensionality)))
+      Log::Fatal << "Flat density estimation tree '" << filename << "' is "
+          << "corrupt." << std::endl;
+  }
+
+  if (!stream.good() || (numNodes == 0))
+    Log::Fatal << "Cannot read flat density estimation tree '" << filename
+        << "'." << std::endl;
+}
+
+void FlatDTree::Save(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open '" << filename << "' to save flat density "
+        << "estimation tree." << std::endl;
+
+  uint64_t header[3];
+  header[0] = 1;
+  header[1] = minVals.n_elem;
+  header[2] = nodes.size();
+
+  stream.write(flatDTreeMagic, sizeof(flatDTreeMagic));
+  stream.write((const char*) header, sizeof(header));
+  stream.write((const char*) minVals.memptr(), minVals.n_elem *
+      sizeof(double));
+  stream.write((const char*) maxVals.memptr(), maxVals.n_elem *
+      sizeof(double));
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const uint64_t fields[2] = { nodes[i].dim, nodes[i].child };
+    stream.write((const char*) &nodes[i].value, sizeof(double));
+    stream.write((const char*) fields, sizeof(fields));
+  }
+
+  if (!stream.good())
+    Log::Fatal << "Error writing flat density estimation tree to '" << filename
+        << "'." << std::endl;
+}
+
+void FlatDTree::ComputeValue(const arma::mat& queries, arma::vec& values) const
+{
+  Log::Assert(queries.n_rows == minVals.n_elem);
+
+  values.set_size(queries.n_cols);
+  for (size_t i = 0; i < queries.n_cols; ++i)
+    values[i] = ComputeValue(queries.colptr(i));
+}
+
+int FlatDTree::FindBucket(const arma::vec& query) const
+{
+  Log::Assert(query.n_elem == minVals.n_elem);
+
+  return (int) nodes[FindLeaf(query.memptr())].dim;
+}
+
+double FlatDTree::ComputeValue(const double* query) const
+{
+  // Points outside of the bounding box have no density.
+  for (size_t i = 0; i < minVals.n_elem; ++i)
+    if ((query[i] < minVals[i]) || (query[i] > maxVals[i]))
+      return 0.0;
+
+  return nodes[FindLeaf(query)].value;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file flat_dtree.hpp
+ *
+ * A flattened, array-based copy of a trained density estimation tree, for fast
+ * (and batched) density queries.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+#define __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+
+#include <mlpack/core.hpp>
+#include "dtree.hpp"
+
+namespace mlpack {
+namespace det {
+
+/**
+ * A read-only copy of a trained DTree, stored as a single array of small
+ * nodes in breadth-first order instead of as linked nodes.  The two children
+ * of a node are adjacent in the array and the top levels of the tree are
+ * packed together, so queries touch few cache lines and no pointers; this
+ * makes it much faster than the DTree for scoring many points.  The density
+ * estimates are exactly those of the DTree it was created from.
+ *
+ * @code
+ * DTree* tree = Trainer(data, 10);
+ * FlatDTree flatTree(*tree);
+ * flatTree.Save("det.bin");
+ *
+ * // Later...
+ * FlatDTree loaded("det.bin");
+ * arma::vec densities;
+ * loaded.ComputeValue(queries, densities);
+ * @endcode
+ */
+class FlatDTree
+{
+ public:
+  /**
+   * Create an empty tree (which estimates a density of 0 everywhere).
+   */
+  FlatDTree();
+
+  /**
+   * Flatten the given trained tree.  The leaves are tagged in the same order
+   * as DTree::TagTree() tags them.
+   *
+   * @param tree Tree to flatten.
+   */
+  FlatDTree(const DTree& tree);
+
+  /**
+   * Load a tree saved with Save().  If the file cannot be read or is not a
+   * saved tree, a fatal error is given.
+   *
+   * @param filename File to load.
+   */
+  FlatDTree(const std::string& filename);
+
+  /**
+   * Save the tree to the given binary file.  If the file cannot be written, a
+   * fatal error is given.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
+
+  /**
+   * Compute the density estimate of the given query (0 if the query is
+   * outside the bounding box of the training data).
+   *
+   * @param query Point to estimate the density of.
+   */
+  double ComputeValue(const arma::vec& query) const
+  {
+    Log::Assert(query.n_elem == minVals.n_elem);
+    return ComputeValue(query.memptr());
+  }
+
+  /**
+   * Compute the density estimates of each of the given queries (one for each
+   * column).
+   *
+   * @param queries Points to estimate the density of.
+   * @param values Vector to store the density estimates in.
+   */
+  void ComputeValue(const arma::mat& queries, arma::vec& values) const;
+
+  /**
+   * Return the tag of the leaf containing the query, like DTree::FindBucket().
+   *
+   * @param query Query to search for.
+   */
+  int FindBucket(const arma::vec& query) const;
+
+  //! Return the number of nodes in the tree.
+  size_t NumNodes() const { return nodes.size(); }
+  //! Return the number of leaves in the tree.
+  size_t NumLeaves() const { return (nodes.size() + 1) / 2; }
+  //! Return the dimensionality of the tree.
+  size_t Dimensionality() const { return minVals.n_elem; }
+
+ private:
+  /**
+   * A node of the flattened tree.  A node with child == 0 is a leaf (the root
+   * is nobody's child).
+   */
+  struct Node
+  {
+    //! The split value of an internal node, or the density of a leaf.
+    double value;
+    //! The split dimension of an internal node, or the tag of a leaf.
+    size_t dim;
+    //! The index of the left child; the right child comes after it.
+    size_t child;
+  };
+
+  //! The nodes, in breadth-first order.
+  std::vector<Node> nodes;
+  //! The lower bound of the bounding box of the training data.
+  arma::vec minVals;
+  //! The upper bound of the bounding box of the training data.
+  arma::vec maxVals;
+
+  //! Return the index of the leaf containing the given point.
+  size_t FindLeaf(const double* query) const
+  {
+    size_t i = 0;
+    while (nodes[i].child != 0)
+      i = nodes[i].child + (query[nodes[i].dim] > nodes[i].value ? 1 : 0);
+
+    return i;
+  }
+
+  //! Compute the density estimate of the given point.
+  double ComputeValue(const double* query) const;
+};
+
+}; // namespace det
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_DET_FLAT_DTREE_HPP
@@ -0,0 +1,191 @@
+/**
+ * @file approximate_mst.cpp
+ *
+ * Implementation of ApproximateMST.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "approximate_mst.hpp"
+#include "dtb.hpp"
+
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace mlpack;
+using namespace mlpack::emst;
+
+ApproximateMST::ApproximateMST(const arma::mat& dataset,
+                               const size_t k,
+                               const size_t leafSize) :
+    dataset(dataset),
+    k(k),
+    leafSize(leafSize),
+    threads(1),
+    graphComponents(0)
+{ /* Nothing to do. */ }
+
+void ApproximateMST::ComputeMST(arma::mat& results)
+{
+  if (k == 0)
+    Log::Fatal << "ApproximateMST::ComputeMST(): k must be greater than 0."
+        << std::endl;
+
+  const size_t n = dataset.n_cols;
+  if (n < 2)
+  {
+    results.set_size(3, 0);
+    graphComponents = n;
+    return;
+  }
+
+  std::vector<EdgePair> edges;
+  KNNEdges(edges);
+  Log::Info << "The kNN graph has " << edges.size() << " edges." << std::endl;
+
+  Timer::Start("emst/kruskal");
+
+  ConcurrentUnionFind components(n);
+  std::vector<EdgePair> forest;
+  forest.reserve(n - 1);
+  FilterKruskal(edges, 0, edges.size(), components, forest);
+  std::vector<EdgePair>().swap(edges);
+
+  Timer::Stop("emst/kruskal");
+
+  // Kruskal adds the edges in order of length.
+  results.set_size(3, forest.size());
+  for (size_t i = 0; i < forest.size(); ++i)
+  {
+    results(0, i) = forest[i].Lesser();
+    results(1, i) = forest[i].Greater();
+    results(2, i) = forest[i].Distance();
+  }
+
+  graphComponents = n - forest.size();
+  Log::Info << "The kNN graph has " << graphComponents << " components."
+      << std::endl;
+  if (graphComponents == 1)
+    return;
+
+  // Join the components with Boruvka rounds.
+  const arma::mat graphForest(results);
+  DualTreeBoruvka<> dtb(dataset, false, leafSize);
+  dtb.Threads() = threads;
+  dtb.ComputeMST(results, graphForest);
+}
+
+void ApproximateMST::KNNEdges(std::vector<EdgePair>& edges) const
+{
+  const size_t n = dataset.n_cols;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  {
+    neighbor::NeighborSearch<neighbor::NearestNeighborSort,
+        metric::EuclideanDistance> knn(dataset, false, false, leafSize);
+    knn.Threads() = threads;
+    knn.Search(std::min(k, n - 1), neighbors, distances);
+  }
+
+  // The edge between i and j is found from both ends if each is a neighbor of
+  // the other; it is then only kept from the lesser index.
+  edges.clear();
+  edges.reserve(neighbors.n_elem);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t r = 0; r < neighbors.n_rows; ++r)
+    {
+      const size_t j = neighbors(r, i);
+      if (j < i)
+      {
+        bool found = false;
+        for (size_t s = 0; s < neighbors.n_rows && !found; ++s)
+          found = (neighbors(s, j) == i);
+        if (found)
+          continue;
+      }
+
+      edges.push_back(EdgePair(std::min(i, j), std::max(i, j),
+          distances(r, i)));
+    }
+  }
+}
+
+void ApproximateMST::FilterKruskal(std::vector<EdgePair>& edges,
+                                   const size_t begin,
+                                   const size_t end,
+                                   ConcurrentUnionFind& components,
+                                   std::vector<EdgePair>& forest) const
+{
+  if (begin == end || forest.size() == dataset.n_cols - 1)
+    return;
+
+  if (end - begin > KruskalEdges)
+  {
+    // Split around the median length of a sample of about 1000 edges.  If
+    // many edges have that length, they all go to the shorter half.
+    std::vector<double> sample;
+    const size_t step = (end - begin) / 1000;
+    for (size_t i = begin; i < end; i += step)
+      sample.push_back(edges[i].Distance());
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2,
+        sample.end());
+    const double pivot = sample[sample.size() / 2];
+
+    size_t middle = std::partition(edges.begin() + begin,
+        edges.begin() + end, ShorterThan(pivot, false)) - edges.begin();
+    if (middle == begin)
+      middle = std::partition(edges.begin() + begin, edges.begin() + end,
+          ShorterThan(pivot, true)) - edges.begin();
+
+    // If all the edges have the same length, they are simply sorted.
+    if (middle < end)
+    {
+      FilterKruskal(edges, begin, middle, components, forest);
+      const size_t kept = Filter(edges, middle, end, components);
+      FilterKruskal(edges, middle, kept, components, forest);
+      return;
+    }
+  }
+
+  std::sort(edges.begin() + begin, edges.begin() + end, EdgeOrder());
+  for (size_t i = begin; i < end && forest.size() < dataset.n_cols - 1; ++i)
+    if (components.Union(edges[i].Lesser(), edges[i].Greater()))
+      forest.push_back(edges[i]);
+}
+
+size_t ApproximateMST::Filter(std::vector<EdgePair>& edges,
+                              const size_t begin,
+                              const size_t end,
+                              ConcurrentUnionFind& components) const
+{
+  // Find() may be called from several threads at once.
+  std::vector<char> keep(end - begin);
+  #pragma omp parallel for num_threads(Threads::Count(threads)) \
+      schedule(static)
+  for (int i = 0; i < (int) (end - begin); ++i)
+  {
+    const EdgePair& edge = edges[begin + i];
+    keep[i] = (components.Find(edge.Lesser()) !=
+        components.Find(edge.Greater()));
+  }
+
+  size_t kept = begin;
+  for (size_t i = begin; i < end; ++i)
+    if (keep[i - begin])
+      edges[kept++] = edges[i];
+
+  return kept;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file approximate_mst.hpp
+ *
+ * An approximate Euclidean minimum spanning tree for very large datasets,
+ * built from the k-nearest-neighbor graph of the points.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_EMST_APPROXIMATE_MST_HPP
+#define __MLPACK_METHODS_EMST_APPROXIMATE_MST_HPP
+
+#include <mlpack/core.hpp>
+
+#include "concurrent_union_find.hpp"
+#include "edge_pair.hpp"
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * Compute an approximate Euclidean minimum spanning tree from the k-nearest-
+ * neighbor graph of the dataset, for datasets too large for DualTreeBoruvka.
+ * Most edges of the MST join points which are among each other's nearest
+ * neighbors, so:
+ *
+ *  1. the k nearest neighbors of every point are found with dual-tree search
+ *     (see neighbor::NeighborSearch);
+ *  2. the minimum spanning forest of the kNN graph is found with Filter-Kruskal
+ *     (Osipov, Sanders and Singler, 2009), which only sorts the edges which
+ *     may be in the forest; the edges which join points already connected are
+ *     filtered out in parallel;
+ *  3. if the kNN graph is not connected, its components are joined with
+ *     Boruvka rounds, as DualTreeBoruvka::ComputeMST() does, each of which
+ *     joins each component to its nearest point in another component.
+ *
+ * Every edge of the result is then an edge of the kNN graph, or the shortest
+ * edge out of a component of it.  The result is the exact MST if the kNN graph
+ * contains it; otherwise some of the edges between components are longer than
+ * needed.  A larger k gives a better approximation, but takes more time and
+ * memory (the graph has up to N k edges).
+ *
+ * @code
+ * ApproximateMST mst(data, 10);
+ * mst.Threads() = 0;
+ * arma::mat results;
+ * mst.ComputeMST(results);
+ * @endcode
+ */
+class ApproximateMST
+{
+ public:
+  /**
+   * Create the object for the given dataset, which must stay valid while
+   * ComputeMST() is called.
+   *
+   * @param dataset Dataset to find the spanning tree of.
+   * @param k Number of neighbors of each point in the kNN graph.
+   * @param leafSize Leaf size of the trees.
+   */
+  ApproximateMST(const arma::mat& dataset,
+                 const size_t k = 10,
+                 const size_t leafSize = 20);
+
+  /**
+   * Compute the approximate spanning tree.  The results have the layout of
+   * DualTreeBoruvka::ComputeMST(): a 3 x (N - 1) matrix, with one edge per
+   * column (the lesser index, the greater index, and the distance), in order
+   * of length.
+   *
+   * @param results Matrix to store the edges in.
+   */
+  void ComputeMST(arma::mat& results);
+
+  //! Get the number of neighbors of each point in the kNN graph.
+  size_t K() const { return k; }
+  //! Modify the number of neighbors of each point in the kNN graph.
+  size_t& K() { return k; }
+
+  //! Get the leaf size of the trees.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size of the trees.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the number of threads used.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the neighbor search, the filtering
+  //! of edges and the Boruvka rounds (1 is serial, 0 uses all available
+  //! cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of components of the kNN graph in the last call to
+  //! ComputeMST().
+  size_t GraphComponents() const { return graphComponents; }
+
+  //! The largest number of edges which are sorted at once by Filter-Kruskal.
+  static const size_t KruskalEdges = 65536;
+
+ private:
+  //! The dataset.
+  const arma::mat& dataset;
+  //! The number of neighbors of each point in the kNN graph.
+  size_t k;
+  //! The leaf size of the trees.
+  size_t leafSize;
+  //! The number of threads used.
+  size_t threads;
+  //! The number of components of the kNN graph.
+  size_t graphComponents;
+
+  //! For ordering edges by length.
+  struct EdgeOrder
+  {
+    bool operator()(const EdgePair& a, const EdgePair& b) const
+    {
+      return (a.Distance() < b.Distance());
+    }
+  };
+
+  //! For partitioning edges around a length.
+  struct ShorterThan
+  {
+    ShorterThan(const double length, const bool inclusive) :
+        length(length), inclusive(inclusive) { }
+
+    bool operator()(const EdgePair& edge) const
+    {
+      return inclusive ? (edge.Distance() <= length) :
+          (edge.Distance() < length);
+    }
+
+    double length;
+    bool inclusive;
+  };
+
+  /**
+   * Find the edges of the kNN graph, each only once.
+   *
+   * @param edges Vector to store the edges in.
+   */
+  void KNNEdges(std::vector<EdgePair>& edges) const;
+
+  /**
+   * Add the edges of the minimum spanning forest of the given range of edges
+   * to the forest, in order of length, with Filter-Kruskal: ranges larger
+   * than KruskalEdges are split around an estimate of their median length,
+   * the shorter half is processed first, and the edges of the longer half
+   * which join points already connected are dropped before it is processed.
+   *
+   * @param edges Edges of the graph (they are reordered).
+   * @param begin First edge of the range.
+   * @param end One past the last edge of the range.
+   * @param components Components of the forest so far.
+   * @param forest Vector to add the edges of the forest to.
+   */
+  void FilterKruskal(std::vector<EdgePair>& edges,
+                     const size_t begin,
+                     const size_t end,
+                     ConcurrentUnionFind& components,
+                     std::vector<EdgePair>& forest) const;
+
+  /**
+   * Drop the edges of the given range which join points in the same component,
+   * in parallel, keeping the order of the others.
+   *
+   * @return One past the last edge kept.
+   */
+  size_t Filter(std::vector<EdgePair>& edges,
+                const size_t begin,
+                const size_t end,
+                ConcurrentUnionFind& components) const;
+};
+
+}; // namespace emst
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_EMST_APPROXIMATE_MST_HPP
@@ -0,0 +1,227 @@
+/**
+ * @file concurrent_union_find.hpp
+ *
+ * Implementation of a lock-free Union-Find data structure that can be used
+ * from several threads at once.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
+#define __MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * A Union-Find data structure whose Find() and Union() may be called from
+ * several threads at the same time, without locks.  It tracks the same
+ * information as UnionFind: each point is initially in its own component,
+ * Union(x, y) unites the components containing x and y, and Find(x) returns the
+ * index of the component containing x.
+ *
+ * The parent index and the rank of each element are packed into one 64-bit
+ * word, so that a root can be linked under another root with a single
+ * compare-and-swap that fails if the root was linked or its rank changed in the
+ * meantime.  Roots are linked by rank, with ties broken by index; this order
+ * can only grow along a path, so concurrent unions can never form a cycle (see
+ * Anderson and Woll, "Wait-free Parallel Algorithms for the Union-Find
+ * Problem", STOC 1991).  Find() uses path halving, which also only needs a
+ * compare-and-swap per step and never makes a path longer.
+ *
+ * While unions are in progress, the index returned by Find() may already be out
+ * of date; once all threads are done, Find() gives the same components a serial
+ * UnionFind would have.  Which element becomes the root of a component may
+ * differ between runs.
+ *
+ * With GCC or clang, the atomic builtins are used.  With other compilers, each
+ * atomic operation is done inside an OpenMP critical section instead (which is
+ * correct, but not lock-free).
+ *
+ * @code
+ * ConcurrentUnionFind components(n);
+ *
+ * #pragma omp parallel for
+ * for (int i = 0; i < (int) edges.n_cols; ++i)
+ *   components.Union(edges(0, i), edges(1, i));
+ * @endcode
+ */
+class ConcurrentUnionFind
+{
+ public:
+  //! Construct the object with the given size.
+  ConcurrentUnionFind(const size_t size) : size(size), elements(size)
+  {
+    Log::Assert((uint64_t) size <= (uint64_t(1) << (64 - rankBits)),
+        "ConcurrentUnionFind::ConcurrentUnionFind(): too many elements.");
+
+    for (size_t i = 0; i < size; ++i)
+      elements[i] = Pack(i, 0);
+  }
+
+  //! Destroy the object (nothing to do).
+  ~ConcurrentUnionFind() { }
+
+  //! Get the number of elements.
+  size_t Size() const { return size; }
+
+  /**
+   * Returns the component containing an element.  Each step of the search
+   * points the element at its grandparent (path halving).
+   *
+   * @param x the component to be found
+   * @return The index of the component containing x
+   */
+  size_t Find(size_t x)
+  {
+    while (true)
+    {
+      const uint64_t word = Load(x);
+      const size_t parent = Parent(word);
+      if (parent == x)
+        return x;
+
+      const size_t grandparent = Parent(Load(parent));
+      if (grandparent == parent)
+        return parent;
+
+      // If another thread changed the parent in the meantime, this does
+      // nothing; either way we move on to a node closer to the root.
+      CompareAndSwap(x, word, Pack(grandparent, Rank(word)));
+      x = grandparent;
+    }
+  }
+
+  /**
+   * Union the components containing x and y.
+   *
+   * @param x one component
+   * @param y the other component
+   * @return true if the components were different and have been united, false
+   *     if x and y were already in the same component.  Even with concurrent
+   *     calls, the number of calls that return true is the number of merges,
+   *     so an edge belongs in a spanning forest if Union() returns true.
+   */
+  bool Union(size_t x, size_t y)
+  {
+    while (true)
+    {
+      x = Find(x);
+      y = Find(y);
+      if (x == y)
+        return false;
+
+      const uint64_t xWord = Load(x);
+      const uint64_t yWord = Load(y);
+
+      // One of the roots has been linked by another thread; start over.
+      if ((Parent(xWord) != x) || (Parent(yWord) != y))
+        continue;
+
+      const size_t xRank = Rank(xWord);
+      const size_t yRank = Rank(yWord);
+
+      // Link the lower root under the higher one.
+      if ((xRank > yRank) || ((xRank == yRank) && (x > y)))
+      {
+        if (!CompareAndSwap(y, yWord, Pack(x, yRank)))
+          continue;
+
+        if (xRank == yRank)
+          CompareAndSwap(x, xWord, Pack(x, xRank + 1));
+      }
+      else
+      {
+        if (!CompareAndSwap(x, xWord, Pack(y, xRank)))
+          continue;
+
+        if (xRank == yRank)
+          CompareAndSwap(y, yWord, Pack(y, yRank + 1));
+      }
+
+      // If the rank could not be increased because the root changed, the rank
+      // is only a little too low, which does not affect correctness.
+      return true;
+    }
+  }
+
+ private:
+  //! The number of low bits of each word that hold the rank.
+  static const size_t rankBits = 8;
+
+  //! The number of elements.
+  size_t size;
+  //! The parent and rank of each element, packed by Pack().
+  std::vector<uint64_t> elements;
+
+  //! Pack a parent index and a rank into one word.
+  static uint64_t Pack(const size_t parent, const size_t rank)
+  {
+    return ((uint64_t) parent << rankBits) | (uint64_t) rank;
+  }
+
+  //! Get the parent index from a word.
+  static size_t Parent(const uint64_t word)
+  {
+    return (size_t) (word >> rankBits);
+  }
+
+  //! Get the rank from a word.
+  static size_t Rank(const uint64_t word)
+  {
+    return (size_t) (word & ((uint64_t(1) << rankBits) - 1));
+  }
+
+  //! Atomically read the word of the given element.
+  uint64_t Load(const size_t x)
+  {
+#if defined(__GNUC__)
+    return __atomic_load_n(&elements[x], __ATOMIC_ACQUIRE);
+#else
+    uint64_t word;
+    #pragma omp critical(concurrentUnionFind)
+    word = elements[x];
+    return word;
+#endif
+  }
+
+  //! Atomically replace the word of the given element if it is still equal to
+  //! the expected word, and return whether it was replaced.
+  bool CompareAndSwap(const size_t x, uint64_t expected, const uint64_t desired)
+  {
+#if defined(__GNUC__)
+    return __atomic_compare_exchange_n(&elements[x], &expected, desired, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    bool swapped = false;
+    #pragma omp critical(concurrentUnionFind)
+    {
+      if (elements[x] == expected)
+      {
+        elements[x] = desired;
+        swapped = true;
+      }
+    }
+    return swapped;
+#endif
+  }
+}; // class ConcurrentUnionFind
+
+}; // namespace emst
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_EMST_CONCURRENT_UNION_FIND_HPP
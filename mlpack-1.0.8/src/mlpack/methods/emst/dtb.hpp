@@ -42,6 +42,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/parallel_dual_tree_traverser.hpp>
 
 namespace mlpack {
 namespace emst /** Euclidean Minimum Spanning Trees. */ {
@@ -78,6 +79,11 @@ namespace emst /** Euclidean Minimum Spanning Trees. */ {
  * More advanced usage of the class can use different types of trees, pass in an
  * already-built tree, or compute the MST using the O(n^2) naive algorithm.
  *
+ * The search for the nearest neighbor of each component in a Boruvka round can
+ * be split over several threads (see Threads()).  The resulting spanning tree
+ * does not depend on the number of threads: of several equally short candidate
+ * edges for a component, the one with the smallest point indices is taken.
+ *
  * @tparam MetricType The metric to use.  IMPORTANT: this hasn't really been
  * tested with anything other than the L2 metric, so user beware. Note that the
  * tree type needs to compute bounds using the same metric as the type
@@ -122,6 +128,9 @@ class DualTreeBoruvka
   //! Total distance of the tree.
   double totalDist;
 
+  //! The number of threads to use for each Boruvka round.
+  size_t threads;
+
   //! The instantiated metric.
   MetricType metric;
 
@@ -134,6 +143,19 @@ class DualTreeBoruvka
     }
   } SortFun;
 
+  //! For ordering the candidate edges of a round: by distance, then by index.
+  struct CandidateOrderHelper
+  {
+    bool operator()(const EdgePair& pairA, const EdgePair& pairB)
+    {
+      if (pairA.Distance() != pairB.Distance())
+        return (pairA.Distance() < pairB.Distance());
+      if (pairA.Lesser() != pairB.Lesser())
+        return (pairA.Lesser() < pairB.Lesser());
+      return (pairA.Greater() < pairB.Greater());
+    }
+  } CandidateOrder;
+
  public:
   /**
    * Create the tree from the given dataset.  This copies the dataset to an
@@ -184,6 +206,27 @@ class DualTreeBoruvka
    */
   void ComputeMST(arma::mat& results);
 
+  /**
+   * Complete the given spanning forest into a spanning tree: the components of
+   * the forest are merged by Boruvka rounds, each of which joins every
+   * component to the nearest point outside of it.  If the forest is a subset
+   * of the minimum spanning tree, so is the result; in any case, only about
+   * log2(c) rounds are needed for c components, instead of about log2(N).  The
+   * forest has the layout of the results, with the indices of the original
+   * dataset; edges which would close a cycle are ignored.
+   *
+   * @param results Matrix which results will be stored in.
+   * @param forest Edges of the spanning forest (3 x number of edges).
+   */
+  void ComputeMST(arma::mat& results, const arma::mat& forest);
+
+  //! Get the number of threads used for each Boruvka round.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for each Boruvka round (1 is serial, 0
+  //! uses all available cores).  The query tree is split into subtrees which
+  //! are traversed in parallel; see tree::ParallelDualTreeTraverser.
+  size_t& Threads() { return threads; }
+
  private:
   /**
    * Adds a single edge to the edge list
@@ -191,7 +234,10 @@ class DualTreeBoruvka
   void AddEdge(const size_t e1, const size_t e2, const double distance);
 
   /**
-   * Adds all the edges found in one iteration to the list of neighbors.
+   * Adds all the edges found in one iteration to the list of neighbors.  The
+   * candidate edges of all components are collected first and then merged in
+   * order of length, so the result does not depend on the order in which the
+   * candidates were found.
    */
   void AddAllEdges();
 
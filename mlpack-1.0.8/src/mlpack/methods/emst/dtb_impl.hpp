@@ -23,6 +23,7 @@
 #define __MLPACK_METHODS_EMST_DTB_IMPL_HPP
 
 #include "dtb_rules.hpp"
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 namespace mlpack {
 namespace emst {
@@ -73,6 +74,7 @@ DualTreeBoruvka<MetricType, TreeType>::DualTreeBoruvka(
     naive(naive),
     connections(data.n_cols),
     totalDist(0.0),
+    threads(1),
     metric(metric)
 {
   Timer::Start("emst/tree_building");
@@ -110,6 +112,7 @@ DualTreeBoruvka<MetricType, TreeType>::DualTreeBoruvka(
     naive(false),
     connections(data.n_cols),
     totalDist(0.0),
+    threads(1),
     metric(metric)
 {
   edges.reserve(data.n_cols - 1); // fill with EdgePairs
@@ -133,20 +136,61 @@ DualTreeBoruvka<MetricType, TreeType>::~DualTreeBoruvka()
  */
 template<typename MetricType, typename TreeType>
 void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results)
+{
+  ComputeMST(results, arma::mat());
+}
+
+/**
+ * Merge the components of the given forest until the MST is complete.
+ */
+template<typename MetricType, typename TreeType>
+void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results,
+                                                       const arma::mat& forest)
 {
   Timer::Start("emst/mst_computation");
 
   totalDist = 0; // Reset distance.
 
-  typedef DTBRules<MetricType, TreeType> RuleType;
-  RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
-                 neighborsOutComponent, metric);
+  if (forest.n_cols > 0)
+  {
+    // The edges of the forest are given in the original order of the points.
+    std::vector<size_t> newFromOld(data.n_cols);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      newFromOld[(!naive && ownTree) ? oldFromNew[i] : i] = i;
+
+    for (size_t i = 0; i < forest.n_cols; ++i)
+    {
+      const size_t a = newFromOld[(size_t) forest(0, i)];
+      const size_t b = newFromOld[(size_t) forest(1, i)];
+      if (connections.Find(a) != connections.Find(b))
+      {
+        totalDist += forest(2, i);
+        AddEdge(a, b, forest(2, i));
+        connections.Union(a, b);
+      }
+    }
+
+    // Mark the nodes which are already inside one component.
+    Cleanup();
+
+    Log::Info << edges.size() << " edges given by the forest." << std::endl;
+  }
+
+  typedef DTBRules<MetricType, TreeType> BaseRuleType;
+  typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+  RuleType rules(BaseRuleType(data, connections, neighborsDistances,
+      neighborsInComponent, neighborsOutComponent, metric));
 
   while (edges.size() < (data.n_cols - 1))
   {
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    // Query subtrees are independent within a round, because the components do
+    // not change until AddAllEdges().
+    tree::ParallelDualTreeTraverser<TreeType, RuleType> traverser(rules,
+        threads);
 
+    tree::TraversalStatistics::Start();
     traverser.Traverse(*tree, *tree);
+    tree::TraversalStatistics::Stop();
 
     AddAllEdges();
 
@@ -186,17 +230,35 @@ void DualTreeBoruvka<MetricType, TreeType>::AddEdge(const size_t e1,
 template<typename MetricType, typename TreeType>
 void DualTreeBoruvka<MetricType, TreeType>::AddAllEdges()
 {
+  // Collect the candidate edge of each component.  After Cleanup(), every
+  // point's parent is the root of its component.
+  std::vector<EdgePair> candidates;
   for (size_t i = 0; i < data.n_cols; i++)
   {
-    size_t component = connections.Find(i);
-    size_t inEdge = neighborsInComponent[component];
-    size_t outEdge = neighborsOutComponent[component];
+    if (connections.Find(i) != i || neighborsDistances[i] == DBL_MAX)
+      continue;
+
+    const size_t inEdge = neighborsInComponent[i];
+    const size_t outEdge = neighborsOutComponent[i];
+    candidates.push_back(EdgePair(std::min(inEdge, outEdge),
+        std::max(inEdge, outEdge), neighborsDistances[i]));
+  }
+
+  // Two components may have found the same edge, and ties in length must be
+  // broken the same way every time, so merge the shortest edges first, in
+  // order of their indices.
+  std::sort(candidates.begin(), candidates.end(), CandidateOrder);
+
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    const size_t inEdge = candidates[i].Lesser();
+    const size_t outEdge = candidates[i].Greater();
     if (connections.Find(inEdge) != connections.Find(outEdge))
     {
       //totalDist = totalDist + dist;
       // changed to make this agree with the cover tree code
-      totalDist += neighborsDistances[component];
-      AddEdge(inEdge, outEdge, neighborsDistances[component]);
+      totalDist += candidates[i].Distance();
+      AddEdge(inEdge, outEdge, candidates[i].Distance());
       connections.Union(inEdge, outEdge);
     }
   }
@@ -301,6 +363,10 @@ void DualTreeBoruvka<MetricType, TreeType>::Cleanup()
   for (size_t i = 0; i < data.n_cols; i++)
   {
     neighborsDistances[i] = DBL_MAX;
+
+    // Compress every path, so that Find() does not modify the structure
+    // during the next round, when it may be called from several threads.
+    connections.Find(i);
   }
 
   if (!naive)
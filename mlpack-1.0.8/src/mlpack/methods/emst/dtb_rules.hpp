@@ -144,6 +144,15 @@ class DTBRules
    */
   inline double CalculateBound(TreeType& queryNode) const;
 
+  /**
+   * Return whether the given edge should replace the current candidate edge
+   * of the component.  This must be called inside the critical section.
+   */
+  inline bool IsBetterCandidate(const size_t component,
+                                const size_t queryIndex,
+                                const size_t referenceIndex,
+                                const double distance) const;
+
 }; // class DTBRules
 
 } // emst namespace
@@ -64,13 +64,25 @@ double DTBRules<MetricType, TreeType>::BaseCase(const size_t queryIndex,
     double distance = metric.Evaluate(dataSet.col(queryIndex),
                                       dataSet.col(referenceIndex));
 
-    if (distance < neighborsDistances[queryComponentIndex])
+    // A component can span several query subtrees which are traversed in
+    // parallel, so its candidate is only replaced inside a critical section.
+    // The check outside of it avoids the lock for most base cases; reading a
+    // candidate distance while it is being improved can only give a larger
+    // value, which is still a valid bound.
+    if (distance <= neighborsDistances[queryComponentIndex])
     {
       Log::Assert(queryIndex != referenceIndex);
 
-      neighborsDistances[queryComponentIndex] = distance;
-      neighborsInComponent[queryComponentIndex] = queryIndex;
-      neighborsOutComponent[queryComponentIndex] = referenceIndex;
+      #pragma omp critical(dtbCandidate)
+      {
+        if (IsBetterCandidate(queryComponentIndex, queryIndex, referenceIndex,
+            distance))
+        {
+          neighborsDistances[queryComponentIndex] = distance;
+          neighborsInComponent[queryComponentIndex] = queryIndex;
+          neighborsOutComponent[queryComponentIndex] = referenceIndex;
+        }
+      }
     }
   }
 
@@ -188,6 +200,24 @@ double DTBRules<MetricType, TreeType>::Rescore(TreeType& queryNode,
   return (oldScore > bound) ? DBL_MAX : oldScore;
 }
 
+// Ties in distance are broken by the point indices, so that the candidate of a
+// component does not depend on the order in which base cases are computed.
+template<typename MetricType, typename TreeType>
+inline bool DTBRules<MetricType, TreeType>::IsBetterCandidate(
+    const size_t component,
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance) const
+{
+  if (distance != neighborsDistances[component])
+    return (distance < neighborsDistances[component]);
+
+  if (queryIndex != neighborsInComponent[component])
+    return (queryIndex < neighborsInComponent[component]);
+
+  return (referenceIndex < neighborsOutComponent[component]);
+}
+
 // Calculate the bound for a given query node in its current state and update
 // it.
 template<typename MetricType, typename TreeType>
@@ -36,6 +36,8 @@
  */
 
 #include "dtb.hpp"
+#include "approximate_mst.hpp"
+#include "single_linkage.hpp"
 
 #include <mlpack/core.hpp>
 
@@ -46,7 +48,23 @@ PROGRAM_INFO("Fast Euclidean Minimum Spanning Tree", "This program can compute "
     "The output is saved in a three-column matrix, where each row indicates an "
     "edge.  The first column corresponds to the lesser index of the edge; the "
     "second column corresponds to the greater index of the edge; and the third "
-    "column corresponds to the distance between the two points.");
+    "column corresponds to the distance between the two points."
+    "\n\n"
+    "The single-linkage dendrogram of the points can be saved at the same "
+    "time with --dendrogram_file (-d).  It has one row for each merge, in "
+    "order: the lesser and greater index of the merged clusters (the points "
+    "themselves are clusters 0 to N - 1, and the cluster made by merge i is "
+    "N + i), the height of the merge, and the size of the new cluster.  Flat "
+    "clusters can be saved with --clusters_file (-c); points are in the same "
+    "cluster if they are connected by edges no longer than "
+    "--cluster_threshold (-t)."
+    "\n\n"
+    "For very large datasets, --approximate (-a) computes an approximate "
+    "spanning tree instead: the minimum spanning forest of the graph joining "
+    "each point to its --neighbors (-k) nearest neighbors, whose components "
+    "are then joined by their shortest edges.  The result is exact if the kNN "
+    "graph contains the minimum spanning tree.  With --approximate, the "
+    "default leaf size is 20.");
 
 PARAM_STRING_REQ("input_file", "Data input file.", "i");
 PARAM_STRING("output_file", "Data output file.  Stored as an edge list.", "o",
@@ -55,6 +73,20 @@ PARAM_FLAG("naive", "Compute the MST using O(n^2) naive algorithm.", "n");
 PARAM_INT("leaf_size", "Leaf size in the kd-tree.  One-element leaves give the "
     "empirically best performance, but at the cost of greater memory "
     "requirements.", "l", 1);
+PARAM_STRING("dendrogram_file", "If specified, the single-linkage dendrogram "
+    "will be saved to this file.", "d", "");
+PARAM_STRING("clusters_file", "If specified, the flat cluster of each point "
+    "(at the height given by --cluster_threshold) will be saved to this file.",
+    "c", "");
+PARAM_DOUBLE("cluster_threshold", "Largest edge length to merge clusters over "
+    "when computing flat clusters.", "t", 0.0);
+PARAM_INT("threads", "Number of threads to use for each Boruvka round (0 uses "
+    "all available cores).  This only has an effect if MLPACK was built with "
+    "OpenMP.", "j", 1);
+PARAM_FLAG("approximate", "If set, compute an approximate spanning tree from "
+    "the k-nearest-neighbor graph of the points.", "a");
+PARAM_INT("neighbors", "Number of neighbors of each point in the "
+    "k-nearest-neighbor graph, for --approximate.", "k", 10);
 
 using namespace mlpack;
 using namespace mlpack::emst;
@@ -70,19 +102,28 @@ int main(int argc, char* argv[])
   arma::mat dataPoints;
   data::Load(dataFilename, dataPoints, true);
 
+  const string dendrogramFilename = CLI::GetParam<string>("dendrogram_file");
+  const string clustersFilename = CLI::GetParam<string>("clusters_file");
+  if (CLI::HasParam("cluster_threshold") && clustersFilename == "")
+    Log::Warn << "--cluster_threshold ignored because --clusters_file is not "
+        << "specified." << endl;
+
+  const bool approximate = CLI::HasParam("approximate");
+  if (approximate && CLI::HasParam("naive"))
+    Log::Fatal << "--approximate and --naive cannot both be given." << endl;
+  if (!approximate && CLI::HasParam("neighbors"))
+    Log::Warn << "--neighbors ignored because --approximate is not specified."
+        << endl;
+
+  arma::mat results;
+
   // Do naive computation if necessary.
   if (CLI::GetParam<bool>("naive"))
   {
     Log::Info << "Running naive algorithm." << endl;
 
     DualTreeBoruvka<> naive(dataPoints, true);
-
-    arma::mat naiveResults;
-    naive.ComputeMST(naiveResults);
-
-    const string outputFilename = CLI::GetParam<string>("output_file");
-
-    data::Save(outputFilename, naiveResults, true);
+    naive.ComputeMST(results);
   }
   else
   {
@@ -95,18 +136,67 @@ int main(int argc, char* argv[])
           << ")!  Must be greater than or equal to 1." << std::endl;
     }
 
-    // Initialize the tree and get ready to compute the MST.
-    const size_t leafSize = (size_t) CLI::GetParam<int>("leaf_size");
-    DualTreeBoruvka<> dtb(dataPoints, false, leafSize);
+    const int threads = CLI::GetParam<int>("threads");
+    if (threads < 0)
+    {
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "greater than or equal to 0." << std::endl;
+    }
+
+    // The neighbor search of the approximate algorithm is faster with larger
+    // leaves.
+    const size_t leafSize = (approximate && !CLI::HasParam("leaf_size")) ?
+        20 : (size_t) CLI::GetParam<int>("leaf_size");
 
-    // Run the DTB algorithm.
-    Log::Info << "Calculating minimum spanning tree." << endl;
-    arma::mat results;
-    dtb.ComputeMST(results);
+    if (approximate)
+    {
+      const int k = CLI::GetParam<int>("neighbors");
+      if (k <= 0)
+        Log::Fatal << "Invalid number of neighbors: " << k << ".  Must be "
+            << "greater than 0." << endl;
+
+      ApproximateMST mst(dataPoints, (size_t) k, leafSize);
+      mst.Threads() = (size_t) threads;
+
+      Log::Info << "Calculating approximate spanning tree." << endl;
+      mst.ComputeMST(results);
+      Log::Info << "The " << k << "-nearest-neighbor graph had "
+          << mst.GraphComponents() << " components." << endl;
+    }
+    else
+    {
+      // Initialize the tree and get ready to compute the MST.
+      DualTreeBoruvka<> dtb(dataPoints, false, leafSize);
+      dtb.Threads() = (size_t) threads;
+
+      // Run the DTB algorithm.
+      Log::Info << "Calculating minimum spanning tree." << endl;
+      dtb.ComputeMST(results);
+    }
+  }
 
-    // Output the results.
-    const string outputFilename = CLI::GetParam<string>("output_file");
+  // Output the results.
+  const string outputFilename = CLI::GetParam<string>("output_file");
 
-    data::Save(outputFilename, results, true);
+  data::Save(outputFilename, results, true);
+
+  if (dendrogramFilename != "")
+  {
+    arma::mat dendrogram;
+    SingleLinkage(results, dendrogram);
+    data::Save(dendrogramFilename, dendrogram, true);
+  }
+
+  if (clustersFilename != "")
+  {
+    arma::Col<size_t> assignments;
+    const size_t clusters = FlatClusters(results,
+        CLI::GetParam<double>("cluster_threshold"), assignments);
+    Log::Info << clusters << " clusters at height "
+        << CLI::GetParam<double>("cluster_threshold") << "." << endl;
+
+    // Save the assignments as a row, so that each point takes one line.
+    arma::Mat<size_t> output = trans(assignments);
+    data::Save(clustersFilename, output, true);
   }
 }
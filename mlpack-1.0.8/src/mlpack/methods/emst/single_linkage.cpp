@@ -0,0 +1,129 @@
+/**
+ * @file single_linkage.cpp
+ *
+ * Implementation of single-linkage clustering from a minimum spanning tree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "single_linkage.hpp"
+#include "union_find.hpp"
+
+using namespace mlpack;
+using namespace mlpack::emst;
+
+// For sorting edge indices by edge length.
+struct EdgeLengthOrder
+{
+  EdgeLengthOrder(const arma::mat& mst) : mst(mst) { }
+
+  bool operator()(const size_t a, const size_t b) const
+  {
+    return (mst(2, a) < mst(2, b));
+  }
+
+  const arma::mat& mst;
+};
+
+// Make sure the MST has the layout given by ComputeMST().
+static void CheckMST(const arma::mat& mst)
+{
+  if (mst.n_rows != 3 && mst.n_elem != 0)
+  {
+    Log::Fatal << "Minimum spanning tree must have 3 rows (lesser index, "
+        << "greater index, distance), but it has " << mst.n_rows << "!"
+        << std::endl;
+  }
+}
+
+void mlpack::emst::SingleLinkage(const arma::mat& mst, arma::mat& dendrogram)
+{
+  CheckMST(mst);
+
+  const size_t points = mst.n_cols + 1;
+  dendrogram.set_size(4, mst.n_cols);
+  if (mst.n_cols == 0)
+    return;
+
+  // The edges are usually already sorted, but the order of edges of equal
+  // length must not depend on the sort.
+  std::vector<size_t> order(mst.n_cols);
+  for (size_t i = 0; i < mst.n_cols; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), EdgeLengthOrder(mst));
+
+  // The cluster index and size of each component, indexed by its root.
+  UnionFind components(points);
+  arma::Col<size_t> cluster(points);
+  arma::Col<size_t> clusterSize(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    cluster[i] = i;
+    clusterSize[i] = 1;
+  }
+
+  for (size_t i = 0; i < mst.n_cols; ++i)
+  {
+    const size_t edge = order[i];
+    const size_t a = components.Find((size_t) mst(0, edge));
+    const size_t b = components.Find((size_t) mst(1, edge));
+    if (a == b)
+    {
+      Log::Fatal << "SingleLinkage(): edge " << edge << " forms a cycle; the "
+          << "input is not a spanning tree!" << std::endl;
+    }
+
+    dendrogram(0, i) = std::min(cluster[a], cluster[b]);
+    dendrogram(1, i) = std::max(cluster[a], cluster[b]);
+    dendrogram(2, i) = mst(2, edge);
+    dendrogram(3, i) = clusterSize[a] + clusterSize[b];
+
+    components.Union(a, b);
+    const size_t root = components.Find(a);
+    cluster[root] = points + i;
+    clusterSize[root] = (size_t) dendrogram(3, i);
+  }
+}
+
+size_t mlpack::emst::FlatClusters(const arma::mat& mst,
+                                  const double threshold,
+                                  arma::Col<size_t>& assignments)
+{
+  CheckMST(mst);
+
+  const size_t points = mst.n_cols + 1;
+  UnionFind components(points);
+  for (size_t i = 0; i < mst.n_cols; ++i)
+    if (mst(2, i) <= threshold)
+      components.Union((size_t) mst(0, i), (size_t) mst(1, i));
+
+  // Number the clusters in order of their first point.
+  const size_t unassigned = points;
+  arma::Col<size_t> label(points);
+  label.fill(unassigned);
+
+  size_t clusters = 0;
+  assignments.set_size(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    const size_t root = components.Find(i);
+    if (label[root] == unassigned)
+      label[root] = clusters++;
+
+    assignments[i] = label[root];
+  }
+
+  return clusters;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file single_linkage.hpp
+ *
+ * Functions to build a single-linkage clustering from a minimum spanning tree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_EMST_SINGLE_LINKAGE_HPP
+#define __MLPACK_METHODS_EMST_SINGLE_LINKAGE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * Build the single-linkage dendrogram of a dataset from its minimum spanning
+ * tree, as computed by DualTreeBoruvka::ComputeMST().  Merging the clusters in
+ * order of increasing MST edge length gives exactly the single-linkage
+ * hierarchy, so no distances need to be computed.
+ *
+ * The initial clusters are the points, numbered 0 to (n - 1); the cluster
+ * created by merge i is numbered (n + i).  The dendrogram has one column for
+ * each merge, in order of height:
+ *
+ *  - row 0: the lesser index of the two merged clusters;
+ *  - row 1: the greater index of the two merged clusters;
+ *  - row 2: the height of the merge (the length of the MST edge);
+ *  - row 3: the number of points in the new cluster.
+ *
+ * This is the same layout as the linkage matrix of SciPy, transposed.
+ *
+ * @param mst Minimum spanning tree of n points (3 x (n - 1); see ComputeMST()).
+ * @param dendrogram Matrix to store the dendrogram in (4 x (n - 1)).
+ */
+void SingleLinkage(const arma::mat& mst, arma::mat& dendrogram);
+
+/**
+ * Cut the single-linkage hierarchy at the given height: points connected by
+ * a path of MST edges no longer than the threshold are put in the same
+ * cluster.  Clusters are numbered from 0, in order of the smallest point index
+ * they contain.
+ *
+ * @param mst Minimum spanning tree of n points (3 x (n - 1); see ComputeMST()).
+ * @param threshold Largest edge length to merge clusters over.
+ * @param assignments Vector to store the cluster of each point in (length n).
+ * @return The number of clusters.
+ */
+size_t FlatClusters(const arma::mat& mst,
+                    const double threshold,
+                    arma::Col<size_t>& assignments);
+
+}; // namespace emst
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_EMST_SINGLE_LINKAGE_HPP
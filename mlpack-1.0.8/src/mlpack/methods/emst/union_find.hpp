@@ -72,9 +72,13 @@ class UnionFind
     }
     else
     {
-      // This ensures that the tree has a small depth
-      parent[x] = Find(parent[x]);
-      return parent[x];
+      // This ensures that the tree has a small depth.  If the path is already
+      // compressed, nothing is written, so that concurrent calls to Find() on a
+      // compressed structure are safe.
+      const size_t root = Find(parent[x]);
+      if (parent[x] != root)
+        parent[x] = root;
+      return root;
     }
   }
 
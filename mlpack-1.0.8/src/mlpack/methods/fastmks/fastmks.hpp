@@ -189,6 +189,24 @@ class FastMKS
               arma::Mat<size_t>& indices,
               arma::mat& products);
 
+  //! Get the number of threads used for search.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for search (1 is serial, 0 uses all
+  //! available cores).  Naive and single-tree search split the query points
+  //! between threads; each thread of a single-tree search traverses its own
+  //! copy of the reference tree, because the rules cache kernel values in the
+  //! tree.  Dual-tree search is always serial.
+  size_t& Threads() { return threads; }
+
+  //! Get the relative error allowed in the results of tree search.
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative error allowed in the results of tree search.  With
+  //! epsilon > 0, nodes whose kernel bound is within a factor (1 + epsilon) of
+  //! the current kth best kernel are pruned, so each positive kernel found is
+  //! at least 1 / (1 + epsilon) times the true kth maximum kernel.  Naive
+  //! search is always exact.
+  double& Epsilon() { return epsilon; }
+
   //! Get the inner-product metric induced by the given kernel.
   const metric::IPMetric<KernelType>& Metric() const { return metric; }
   //! Modify the inner-product metric induced by the given kernel.
@@ -214,9 +232,17 @@ class FastMKS
   //! If true, naive (brute-force) search is used.
   bool naive;
 
+  //! The number of threads to use for search.
+  size_t threads;
+  //! The relative error allowed in the results of tree search.
+  double epsilon;
+
   //! The instantiated inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType> metric;
 
+  //! Return the number of threads the search will use.
+  size_t NumThreads() const;
+
   //! Utility function.  Copied too many times from too many places.
   void InsertNeighbor(arma::Mat<size_t>& indices,
                       arma::mat& products,
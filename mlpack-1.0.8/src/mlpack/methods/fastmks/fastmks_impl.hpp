@@ -26,10 +26,16 @@
 #include "fastmks.hpp"
 
 #include "fastmks_rules.hpp"
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/core/kernels/kernel_block.hpp>
 
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <queue>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace fastmks {
 
@@ -44,7 +50,9 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     queryTree(NULL),
     treeOwner(true),
     single(single),
-    naive(naive)
+    naive(naive),
+    threads(1),
+    epsilon(0.0)
 {
   Timer::Start("tree_building");
 
@@ -69,7 +77,9 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     queryTree(NULL),
     treeOwner(true),
     single(single),
-    naive(naive)
+    naive(naive),
+    threads(1),
+    epsilon(0.0)
 {
   Timer::Start("tree_building");
 
@@ -96,6 +106,8 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(true),
     single(single),
     naive(naive),
+    threads(1),
+    epsilon(0.0),
     metric(kernel)
 {
   Timer::Start("tree_building");
@@ -124,6 +136,8 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(true),
     single(single),
     naive(naive),
+    threads(1),
+    epsilon(0.0),
     metric(kernel)
 {
   Timer::Start("tree_building");
@@ -151,6 +165,8 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(false),
     single(single),
     naive(naive),
+    threads(1),
+    epsilon(0.0),
     metric(referenceTree->Metric())
 {
   // The query tree cannot be the same as the reference tree.
@@ -173,6 +189,8 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(false),
     single(single),
     naive(naive),
+    threads(1),
+    epsilon(0.0),
     metric(referenceTree->Metric())
 {
   // Nothing to do.
@@ -209,28 +227,58 @@ void FastMKS<KernelType, TreeType>::Search(const size_t k,
 
   Timer::Start("computing_products");
 
+  const size_t numThreads = NumThreads();
+
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
+    // Evaluate the kernel between blocks of queries and blocks of references
+    // at once (see KernelBlock), and hand out query blocks to threads.  The
+    // references are still considered in order for each query, so ties are
+    // broken the same way as by a simple double loop.
+    const size_t queryBlockSize = 64;
+    const size_t referenceBlockSize = 1024;
+    const size_t queryBlocks = (querySet.n_cols + queryBlockSize - 1) /
+        queryBlockSize;
+
+    #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+    for (int block = 0; block < (int) queryBlocks; ++block)
     {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
+      const size_t queryBegin = block * queryBlockSize;
+      const size_t queryCount = std::min(queryBlockSize,
+          (size_t) querySet.n_cols - queryBegin);
+
+      arma::mat kernels;
+      for (size_t referenceBegin = 0; referenceBegin < referenceSet.n_cols;
+          referenceBegin += referenceBlockSize)
       {
-        if ((&querySet == &referenceSet) && (q == r))
-          continue;
+        const size_t referenceCount = std::min(referenceBlockSize,
+            (size_t) referenceSet.n_cols - referenceBegin);
+        kernel::KernelBlock<KernelType>::Evaluate(metric.Kernel(), querySet,
+            queryBegin, queryCount, referenceSet, referenceBegin,
+            referenceCount, kernels);
 
-        const double eval = metric.Kernel().Evaluate(querySet.unsafe_col(q),
-            referenceSet.unsafe_col(r));
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+          const size_t q = queryBegin + i;
+          for (size_t j = 0; j < referenceCount; ++j)
+          {
+            const size_t r = referenceBegin + j;
+            if ((&querySet == &referenceSet) && (q == r))
+              continue;
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > products(insertPosition, q))
-            break;
+            const double eval = kernels(j, i);
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, products, q, insertPosition, r, eval);
+            size_t insertPosition;
+            for (insertPosition = 0; insertPosition < indices.n_rows;
+                ++insertPosition)
+              if (eval > products(insertPosition, q))
+                break;
+
+            if (insertPosition < indices.n_rows)
+              InsertNeighbor(indices, products, q, insertPosition, r, eval);
+          }
+        }
       }
     }
 
@@ -244,33 +292,82 @@ void FastMKS<KernelType, TreeType>::Search(const size_t k,
   {
     // Create rules object (this will store the results).  This constructor
     // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, indices, products, metric.Kernel());
+    typedef FastMKSRules<KernelType, TreeType> BaseRuleType;
+    typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+    RuleType rules(BaseRuleType(referenceSet, querySet, indices, products,
+        metric.Kernel(), epsilon));
+
+    size_t numPrunes = 0;
+    size_t baseCases = 0;
+    size_t scores = 0;
+    tree::TraversalStatistics::Start();
+
+    if (numThreads == 1)
+    {
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(rules);
+
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
 
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
+      numPrunes = traverser.NumPrunes();
+      baseCases = rules.BaseCases();
+      scores = rules.Scores();
+    }
+    else
+    {
+      #pragma omp parallel num_threads(numThreads) \
+          reduction(+:numPrunes, baseCases, scores)
+      {
+        // The rules cache the last kernel evaluation of each reference node in
+        // its statistic, so every thread needs its own copy of the tree.  The
+        // copies of the rules share the results.
+        TreeType threadTree(*referenceTree);
+        RuleType threadRules(rules);
+        typename TreeType::template SingleTreeTraverser<RuleType>
+            traverser(threadRules);
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < (int) querySet.n_cols; ++i)
+          traverser.Traverse(i, threadTree);
+
+        numPrunes += traverser.NumPrunes();
+        baseCases += threadRules.BaseCases();
+        scores += threadRules.Scores();
+      }
+    }
 
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    tree::TraversalStatistics::Stop();
 
-    // Save the number of pruned nodes.
-    const size_t numPrunes = traverser.NumPrunes();
+    // For large k the rules kept the candidates as heaps, which are sorted
+    // now.
+    neighbor::CandidateHeap<neighbor::FurthestNeighborSort>::Sort(products,
+        indices);
 
     Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
 
-    Log::Info << rules.BaseCases() << " base cases." << std::endl;
-    Log::Info << rules.Scores() << " scores." << std::endl;
+    Log::Info << baseCases << " base cases." << std::endl;
+    Log::Info << scores << " scores." << std::endl;
 
     Timer::Stop("computing_products");
     return;
   }
 
   // Dual-tree implementation.
-  typedef FastMKSRules<KernelType, TreeType> RuleType;
-  RuleType rules(referenceSet, querySet, indices, products, metric.Kernel());
+  typedef FastMKSRules<KernelType, TreeType> BaseRuleType;
+  typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+  RuleType rules(BaseRuleType(referenceSet, querySet, indices, products,
+      metric.Kernel(), epsilon));
 
   typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
 
+  tree::TraversalStatistics::Start();
   traverser.Traverse(*queryTree, *referenceTree);
+  tree::TraversalStatistics::Stop();
+
+  // For large k the rules kept the candidates as heaps, which are sorted now.
+  neighbor::CandidateHeap<neighbor::FurthestNeighborSort>::Sort(products,
+      indices);
 
   const size_t numPrunes = traverser.NumPrunes();
 
@@ -282,6 +379,19 @@ void FastMKS<KernelType, TreeType>::Search(const size_t k,
   return;
 }
 
+template<typename KernelType, typename TreeType>
+size_t FastMKS<KernelType, TreeType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  // The dual-tree rules cache kernel values in both trees, so the query tree
+  // cannot be split between threads (see tree::ParallelDualTreeTraverser).
+  if (!naive && !single)
+    numThreads = 1;
+
+  return numThreads;
+}
+
 /**
  * Helper function to insert a point into the neighbors and distances matrices.
  *
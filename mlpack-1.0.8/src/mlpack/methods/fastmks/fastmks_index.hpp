@@ -0,0 +1,163 @@
+/**
+ * @file fastmks_index.hpp
+ *
+ * Definition of the FastMKSIndex class, which saves a cover tree built for
+ * FastMKS, its dataset, and the self-kernels of its nodes to a binary file that
+ * can later be memory-mapped.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_FASTMKS_INDEX_HPP
+#define __MLPACK_METHODS_FASTMKS_FASTMKS_INDEX_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/ip_metric.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include "fastmks_stat.hpp"
+
+namespace mlpack {
+namespace fastmks {
+
+/**
+ * A cover tree for FastMKS together with the dataset it was built on.  This is
+ * the counterpart of tree::TreeIndex for the trees FastMKS uses: a FastMKSIndex
+ * can be saved to a binary file once and loaded again much faster than the
+ * tree can be rebuilt.  The self-kernel of each node (see
+ * FastMKSStat::SelfKernel()) is stored too, so loading evaluates the kernel
+ * only once, to check that the index is used with the kernel it was built
+ * with.  On POSIX systems the dataset is memory-mapped read-only instead of
+ * being read.
+ *
+ * @code
+ * // Build once and save.
+ * PolynomialKernel pk(2.0, 1.0);
+ * FastMKSIndex<PolynomialKernel> index(referenceData, pk);
+ * index.Save("reference.fmks");
+ *
+ * // Later, load and search.
+ * FastMKSIndex<PolynomialKernel> loaded("reference.fmks", pk);
+ * FastMKS<PolynomialKernel> fastmks(loaded.Dataset(), &loaded.Tree(), true);
+ * fastmks.Search(k, indices, products);
+ * @endcode
+ *
+ * The cover tree does not reorder the dataset, so the indices found with a
+ * loaded index refer to the original points.
+ *
+ * The file stores, in host byte order: a header (including the base of the
+ * tree), the dataset (column-major), and one record for each node in
+ * depth-first order (point, scale, number of children and descendants, parent
+ * distance, furthest descendant distance, and self-kernel).  The dataset of a
+ * loaded index must not be modified.  The kernel parameters are not stored.
+ *
+ * @tparam KernelType Type of kernel the tree is built for.
+ */
+template<typename KernelType>
+class FastMKSIndex
+{
+ public:
+  //! The type of tree FastMKS uses by default.
+  typedef tree::CoverTree<metric::IPMetric<KernelType>, tree::FirstPointIsRoot,
+      FastMKSStat> TreeType;
+
+  /**
+   * Build a cover tree on the given dataset.  The dataset is not modified, but
+   * it must outlive the index.
+   *
+   * @param data Dataset to build the tree on.
+   * @param kernel Kernel to build the tree for.
+   * @param base Base to use during cover tree construction.
+   */
+  FastMKSIndex(const arma::mat& data,
+               KernelType& kernel,
+               const double base = 2.0);
+
+  /**
+   * Load an index that was saved with Save().  If the file cannot be opened, is
+   * not a valid index, or was saved with a different kernel, a fatal error is
+   * given.
+   *
+   * @param filename File to load.
+   * @param kernel Kernel the index was built for.
+   */
+  FastMKSIndex(const std::string& filename, KernelType& kernel);
+
+  /**
+   * Delete the tree, and unmap the file if the index was loaded.
+   */
+  ~FastMKSIndex();
+
+  /**
+   * Save the index to the given file.  If the file cannot be written, a fatal
+   * error is given.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
+
+  //! Get the root of the tree.
+  const TreeType& Tree() const { return *tree; }
+  //! Modify the root of the tree.
+  TreeType& Tree() { return *tree; }
+
+  //! Get the dataset the tree is built on.
+  const arma::mat& Dataset() const { return *dataset; }
+
+ private:
+  //! The dataset; either given by the user or aliasing the loaded file.
+  const arma::mat* dataset;
+  //! Whether or not we allocated the dataset object.
+  bool ownsDataset;
+  //! The inner-product metric induced by the kernel.
+  metric::IPMetric<KernelType> metric;
+  //! The root of the tree.
+  TreeType* tree;
+
+  //! The contents of the loaded file (NULL if the index was built).
+  char* buffer;
+  //! The size of the loaded file.
+  size_t bufferSize;
+  //! Whether or not buffer was memory-mapped (as opposed to allocated).
+  bool mapped;
+
+  /**
+   * Recursively write the records of the given node and its descendants.
+   */
+  void SaveNode(std::ostream& stream, const TreeType& node) const;
+
+  /**
+   * Recursively create a node and its descendants from the records, starting
+   * at the given one.
+   *
+   * @param records Start of the node records.
+   * @param numRecords Total number of records.
+   * @param next Index of the record to read; incremented for each node read.
+   * @param parent Parent of the node.
+   * @param base Base of the tree.
+   */
+  TreeType* LoadNode(const char* records,
+                     const size_t numRecords,
+                     size_t& next,
+                     TreeType* parent,
+                     const double base);
+};
+
+}; // namespace fastmks
+}; // namespace mlpack
+
+// Include implementation.
+#include "fastmks_index_impl.hpp"
+
+#endif
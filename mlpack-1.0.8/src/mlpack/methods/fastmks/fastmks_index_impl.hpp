@@ -0,0 +1,318 @@
+/**
+ * @file fastmks_index_impl.hpp
+ *
+ * Implementation of the FastMKSIndex class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_FASTMKS_INDEX_IMPL_HPP
+#define __MLPACK_METHODS_FASTMKS_FASTMKS_INDEX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "fastmks_index.hpp"
+
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace fastmks {
+
+// Layout of the header: an 8-byte magic string followed by these fields, each
+// 64 bits wide.  The base is stored as a double; the rest are unsigned
+// integers.
+enum FastMKSIndexHeaderField
+{
+  FASTMKS_INDEX_VERSION = 0,
+  FASTMKS_INDEX_DIMENSIONALITY,
+  FASTMKS_INDEX_POINTS,
+  FASTMKS_INDEX_NODES,
+  FASTMKS_INDEX_BASE,
+  FASTMKS_INDEX_DATA_OFFSET,
+  FASTMKS_INDEX_NODE_OFFSET,
+  FASTMKS_INDEX_HEADER_FIELDS
+};
+
+// Layout of a node record: point, scale, number of children, and number of
+// descendants (64-bit integers; the scale is signed), then parent distance,
+// furthest descendant distance, and self-kernel (doubles).
+static const size_t fastMKSIndexRecordSize = 4 * sizeof(uint64_t) +
+    3 * sizeof(double);
+
+static const char fastMKSIndexMagic[8] = { 'M', 'L', 'P', 'K', 'F', 'M', 'K',
+    'S' };
+
+template<typename KernelType>
+FastMKSIndex<KernelType>::FastMKSIndex(const arma::mat& data,
+                                       KernelType& kernel,
+                                       const double base) :
+    dataset(&data),
+    ownsDataset(false),
+    metric(kernel),
+    tree(NULL),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+  tree = new TreeType(data, metric, base);
+}
+
+template<typename KernelType>
+FastMKSIndex<KernelType>::FastMKSIndex(const std::string& filename,
+                                       KernelType& kernel) :
+    dataset(NULL),
+    ownsDataset(true),
+    metric(kernel),
+    tree(NULL),
+    buffer(NULL),
+    bufferSize(0),
+    mapped(false)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    Log::Fatal << "Cannot open FastMKS index '" << filename << "'."
+        << std::endl;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot read size of FastMKS index '" << filename << "'."
+        << std::endl;
+  }
+  bufferSize = (size_t) fileStat.st_size;
+
+  // Map the file read-only; nothing is read from disk until it is used.
+  void* map = (bufferSize == 0) ? MAP_FAILED : mmap(NULL, bufferSize,
+      PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    Log::Fatal << "Cannot map FastMKS index '" << filename << "'."
+        << std::endl;
+
+  buffer = (char*) map;
+  mapped = true;
+#else
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open FastMKS index '" << filename << "'."
+        << std::endl;
+
+  bufferSize = (size_t) stream.tellg();
+  buffer = new char[bufferSize];
+  stream.seekg(0);
+  stream.read(buffer, bufferSize);
+  if (!stream.good())
+    Log::Fatal << "Cannot read FastMKS index '" << filename << "'."
+        << std::endl;
+#endif
+
+  // Check the header.
+  const size_t headerSize = sizeof(fastMKSIndexMagic) +
+      FASTMKS_INDEX_HEADER_FIELDS * sizeof(uint64_t);
+  if ((bufferSize < headerSize) ||
+      (memcmp(buffer, fastMKSIndexMagic, sizeof(fastMKSIndexMagic)) != 0))
+    Log::Fatal << "'" << filename << "' is not a FastMKS index." << std::endl;
+
+  uint64_t header[FASTMKS_INDEX_HEADER_FIELDS];
+  memcpy(header, buffer + sizeof(fastMKSIndexMagic), sizeof(header));
+
+  if (header[FASTMKS_INDEX_VERSION] != 1)
+    Log::Fatal << "Unsupported FastMKS index version "
+        << header[FASTMKS_INDEX_VERSION] << " in '" << filename << "'."
+        << std::endl;
+
+  const size_t dimensionality = (size_t) header[FASTMKS_INDEX_DIMENSIONALITY];
+  const size_t points = (size_t) header[FASTMKS_INDEX_POINTS];
+  const size_t nodes = (size_t) header[FASTMKS_INDEX_NODES];
+  const size_t dataOffset = (size_t) header[FASTMKS_INDEX_DATA_OFFSET];
+  const size_t nodeOffset = (size_t) header[FASTMKS_INDEX_NODE_OFFSET];
+  double base;
+  memcpy(&base, &header[FASTMKS_INDEX_BASE], sizeof(double));
+
+  if ((dataOffset % sizeof(double) != 0) || (points == 0) ||
+      (nodeOffset < dataOffset + dimensionality * points * sizeof(double)) ||
+      (nodes == 0) || (bufferSize < nodeOffset + nodes *
+      fastMKSIndexRecordSize))
+    Log::Fatal << "FastMKS index '" << filename << "' is corrupt."
+        << std::endl;
+
+  // The dataset refers directly to the contents of the file.
+  dataset = new arma::mat((double*) (buffer + dataOffset), dimensionality,
+      points, false, true);
+
+  size_t next = 0;
+  tree = LoadNode(buffer + nodeOffset, nodes, next, NULL, base);
+  if (next != nodes)
+    Log::Fatal << "FastMKS index '" << filename << "' is corrupt."
+        << std::endl;
+
+  // Lay the nodes out contiguously, as they are in a tree that was built.
+  tree->Compact();
+
+  // The kernel parameters are not stored, so check the self-kernel of the root
+  // against the given kernel.
+  const double selfKernel = sqrt(metric.Kernel().Evaluate(
+      dataset->unsafe_col(tree->Point()), dataset->unsafe_col(tree->Point())));
+  if (std::abs(selfKernel - tree->Stat().SelfKernel()) >
+      1e-10 * std::max(1.0, std::abs(selfKernel)))
+    Log::Fatal << "FastMKS index '" << filename << "' was built with a "
+        << "different kernel." << std::endl;
+
+  Log::Info << "Loaded FastMKS index '" << filename << "' (" << nodes
+      << " nodes, " << dimensionality << " x " << points << " points)."
+      << std::endl;
+}
+
+template<typename KernelType>
+FastMKSIndex<KernelType>::~FastMKSIndex()
+{
+  // The tree refers to the dataset, which refers to the buffer, so they must be
+  // deleted in this order.
+  if (tree)
+    delete tree;
+  if (ownsDataset && dataset)
+    delete dataset;
+
+  if (buffer)
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(buffer, bufferSize);
+    else
+      delete[] buffer;
+#else
+    delete[] buffer;
+#endif
+  }
+}
+
+template<typename KernelType>
+void FastMKSIndex<KernelType>::Save(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open '" << filename << "' to save FastMKS index."
+        << std::endl;
+
+  const size_t dimensionality = dataset->n_rows;
+  const size_t points = dataset->n_cols;
+  const double base = tree->Base();
+
+  // The dataset starts on a page boundary, so the mapped matrix is aligned.
+  uint64_t header[FASTMKS_INDEX_HEADER_FIELDS];
+  header[FASTMKS_INDEX_VERSION] = 1;
+  header[FASTMKS_INDEX_DIMENSIONALITY] = dimensionality;
+  header[FASTMKS_INDEX_POINTS] = points;
+  header[FASTMKS_INDEX_NODES] = 0;
+  memcpy(&header[FASTMKS_INDEX_BASE], &base, sizeof(double));
+  header[FASTMKS_INDEX_DATA_OFFSET] = 4096;
+  header[FASTMKS_INDEX_NODE_OFFSET] = header[FASTMKS_INDEX_DATA_OFFSET] +
+      dimensionality * points * sizeof(double);
+
+  // The number of nodes is not known until they are written, so the header is
+  // written again at the end.
+  stream.write(fastMKSIndexMagic, sizeof(fastMKSIndexMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  // Pad up to the dataset.
+  const std::vector<char> padding(header[FASTMKS_INDEX_DATA_OFFSET] -
+      sizeof(fastMKSIndexMagic) - sizeof(header), 0);
+  stream.write(&padding[0], padding.size());
+
+  stream.write((const char*) dataset->memptr(),
+      dimensionality * points * sizeof(double));
+
+  const std::streampos nodeStart = stream.tellp();
+  SaveNode(stream, *tree);
+  header[FASTMKS_INDEX_NODES] = (stream.tellp() - nodeStart) /
+      fastMKSIndexRecordSize;
+
+  stream.seekp(sizeof(fastMKSIndexMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  if (!stream.good())
+    Log::Fatal << "Error writing FastMKS index to '" << filename << "'."
+        << std::endl;
+}
+
+template<typename KernelType>
+void FastMKSIndex<KernelType>::SaveNode(std::ostream& stream,
+                                        const TreeType& node) const
+{
+  uint64_t fields[4];
+  fields[0] = node.Point();
+  fields[1] = (uint64_t) (int64_t) node.Scale();
+  fields[2] = node.NumChildren();
+  fields[3] = node.NumDescendants();
+  stream.write((const char*) fields, sizeof(fields));
+
+  const double values[3] = { node.ParentDistance(),
+      node.FurthestDescendantDistance(), node.Stat().SelfKernel() };
+  stream.write((const char*) values, sizeof(values));
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    SaveNode(stream, node.Child(i));
+}
+
+template<typename KernelType>
+typename FastMKSIndex<KernelType>::TreeType*
+FastMKSIndex<KernelType>::LoadNode(const char* records,
+                                   const size_t numRecords,
+                                   size_t& next,
+                                   TreeType* parent,
+                                   const double base)
+{
+  if (next >= numRecords)
+    Log::Fatal << "FastMKS index is corrupt: too few nodes." << std::endl;
+
+  const char* record = records + (next++) * fastMKSIndexRecordSize;
+
+  uint64_t fields[4];
+  memcpy(fields, record, sizeof(fields));
+  double values[3];
+  memcpy(values, record + sizeof(fields), sizeof(values));
+
+  if ((fields[0] >= dataset->n_cols) || (fields[2] > numRecords) ||
+      (fields[3] > dataset->n_cols))
+    Log::Fatal << "FastMKS index is corrupt: node out of range." << std::endl;
+
+  // The saved self-kernel is used instead of evaluating the kernel again.
+  FastMKSStat stat;
+  stat.SelfKernel() = values[2];
+
+  TreeType* node = new TreeType(*dataset, base, (size_t) fields[0],
+      (int) (int64_t) fields[1], parent, values[0], values[1], &metric, stat);
+  node->NumDescendants() = (size_t) fields[3];
+
+  for (size_t i = 0; i < (size_t) fields[2]; ++i)
+    node->Children().push_back(LoadNode(records, numRecords, next, node,
+        base));
+
+  return node;
+}
+
+}; // namespace fastmks
+}; // namespace mlpack
+
+#endif
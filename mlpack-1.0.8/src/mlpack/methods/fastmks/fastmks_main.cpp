@@ -29,6 +29,8 @@
 #include <mlpack/core/kernels/epanechnikov_kernel.hpp>
 
 #include "fastmks.hpp"
+#include "fastmks_index.hpp"
+#include "recall.hpp"
 
 using namespace std;
 using namespace mlpack;
@@ -59,11 +61,26 @@ PROGRAM_INFO("FastMKS (Fast Max-Kernel Search)",
     "to the kernel evaluation between those two points."
     "\n\n"
     "This executable performs FastMKS using a cover tree.  The base used to "
-    "build the cover tree can be specified with the --base option.");
+    "build the cover tree can be specified with the --base option.  The "
+    "reference set and its cover tree can be saved with --save_index and "
+    "loaded again with --index_file, which is much faster than building the "
+    "tree."
+    "\n\n"
+    "With --epsilon, approximate search is performed: tree nodes whose kernel "
+    "bound is within a factor (1 + epsilon) of the current kth best kernel are "
+    "pruned, which is much faster in high dimensions.  The recall of the "
+    "results can be measured by passing the indices found by exact search with "
+    "--exact_indices_file."
+    "\n\n"
+    "For query sets too large for memory, --query_chunk (-C) reads the query "
+    "set in chunks of the given number of points: each chunk is searched while "
+    "the next is read and the results of the previous one are written, so only "
+    "two chunks of queries and results are in memory at a time.  The output "
+    "files must then be .csv, .txt or .mbin files.");
 
 // Define our input parameters.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset.  Either "
+    "this or --index_file must be given.", "r", "");
 PARAM_STRING("query_file", "File containing the query dataset.", "q", "");
 
 PARAM_INT_REQ("k", "Number of maximum inner products to find.", "k");
@@ -78,9 +95,25 @@ PARAM_STRING("kernel", "Kernel type to use: 'linear', 'polynomial', 'cosine', "
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single", "If true, single-tree search is used (as opposed to "
     "dual-tree search.", "S");
-
-// Cover tree parameter.
+PARAM_INT("threads", "Number of threads to use for naive or single-tree search "
+    "(0 uses all available cores).  This only has an effect if MLPACK was "
+    "built with OpenMP.", "j", 1);
+PARAM_DOUBLE("epsilon", "Relative error allowed in the maximum kernels found "
+    "by tree search (0 is exact search).", "e", 0.0);
+PARAM_STRING("exact_indices_file", "File containing the indices found by exact "
+    "search; if given, the recall of the results is printed.", "E", "");
+
+// Cover tree parameters.
 PARAM_DOUBLE("base", "Base to use during cover tree construction.", "b", 2.0);
+PARAM_STRING("index_file", "Load the reference dataset and its cover tree from "
+    "this FastMKS index (see --save_index), instead of building the tree from "
+    "--reference_file.  The kernel options must be the same as when the index "
+    "was saved.", "I", "");
+PARAM_STRING("save_index", "If specified, save the reference dataset and its "
+    "cover tree to this file, for later use with --index_file.", "x", "");
+PARAM_INT("query_chunk", "If nonzero, read and search the query set in chunks "
+    "of this many points, overlapping reading, searching and writing.", "C",
+    0);
 
 // Kernel parameters.
 PARAM_DOUBLE("degree", "Degree of polynomial kernel.", "d", 2.0);
@@ -90,28 +123,73 @@ PARAM_DOUBLE("bandwidth", "Bandwidth (for Gaussian, Epanechnikov, and "
     "triangular kernels).", "w", 1.0);
 PARAM_DOUBLE("scale", "Scale of kernel (for hyptan kernel).", "s", 1.0);
 
+//! Load the reference index, or build it on the reference data, and save it if
+//! requested.
+template<typename KernelType>
+FastMKSIndex<KernelType>* GetIndex(const arma::mat& referenceData,
+                                   const double base,
+                                   const size_t k,
+                                   KernelType& kernel)
+{
+  const string indexFile = CLI::GetParam<string>("index_file");
+  const string saveIndexFile = CLI::GetParam<string>("save_index");
+
+  FastMKSIndex<KernelType>* index;
+  if (indexFile != "")
+  {
+    Timer::Start("loading_index");
+    index = new FastMKSIndex<KernelType>(indexFile, kernel);
+    Timer::Stop("loading_index");
+  }
+  else
+  {
+    index = new FastMKSIndex<KernelType>(referenceData, kernel, base);
+  }
+
+  // Sanity check on k value.
+  if (k > index->Dataset().n_cols)
+  {
+    Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
+    Log::Fatal << "than or equal to the number of reference points (";
+    Log::Fatal << index->Dataset().n_cols << ")." << endl;
+  }
+
+  if (saveIndexFile != "")
+  {
+    Log::Info << "Saving FastMKS index to '" << saveIndexFile << "'..." << endl;
+    index->Save(saveIndexFile);
+  }
+
+  return index;
+}
+
 //! Run FastMKS on a single dataset for the given kernel type.
 template<typename KernelType>
 void RunFastMKS(const arma::mat& referenceData,
                 const bool single,
                 const bool naive,
+                const size_t threads,
                 const double base,
                 const size_t k,
                 arma::Mat<size_t>& indices,
                 arma::mat& products,
                 KernelType& kernel)
 {
-  // Create the tree with the specified base.
-  typedef CoverTree<IPMetric<KernelType>, FirstPointIsRoot, FastMKSStat>
-      TreeType;
-  IPMetric<KernelType> metric(kernel);
-  TreeType tree(referenceData, metric, base);
+  // Build or load the tree with the specified base.
+  FastMKSIndex<KernelType>* index = GetIndex(referenceData, base, k, kernel);
 
   // Create FastMKS object.
-  FastMKS<KernelType> fastmks(referenceData, &tree, (single && !naive), naive);
+  {
+    FastMKS<KernelType> fastmks(index->Dataset(), &index->Tree(),
+        (single && !naive), naive);
+    fastmks.Threads() = threads;
+    fastmks.Epsilon() = CLI::GetParam<double>("epsilon");
 
-  // Now search with it.
-  fastmks.Search(k, indices, products);
+    // Now search with it.
+    fastmks.Search(k, indices, products);
+  }
+
+  delete index;
 }
 
 //! Run FastMKS for a given query and reference set using the given kernel type.
@@ -120,25 +198,173 @@ void RunFastMKS(const arma::mat& referenceData,
                 const arma::mat& queryData,
                 const bool single,
                 const bool naive,
+                const size_t threads,
                 const double base,
                 const size_t k,
                 arma::Mat<size_t>& indices,
                 arma::mat& products,
                 KernelType& kernel)
 {
-  // Create the tree with the specified base.
-  typedef CoverTree<IPMetric<KernelType>, FirstPointIsRoot, FastMKSStat>
-      TreeType;
+  // Build or load the reference tree with the specified base.
+  FastMKSIndex<KernelType>* index = GetIndex(referenceData, base, k, kernel);
+  typedef typename FastMKSIndex<KernelType>::TreeType TreeType;
   IPMetric<KernelType> metric(kernel);
-  TreeType referenceTree(referenceData, metric, base);
   TreeType queryTree(queryData, metric, base);
 
   // Create FastMKS object.
-  FastMKS<KernelType> fastmks(referenceData, &referenceTree, queryData,
-      &queryTree, (single && !naive), naive);
+  {
+    FastMKS<KernelType> fastmks(index->Dataset(), &index->Tree(), queryData,
+        &queryTree, (single && !naive), naive);
+    fastmks.Threads() = threads;
+    fastmks.Epsilon() = CLI::GetParam<double>("epsilon");
+
+    // Now search with it.
+    fastmks.Search(k, indices, products);
+  }
+
+  delete index;
+}
+
+/**
+ * The stages of the search of a query set read in chunks (see
+ * data::ChunkReader::Pipeline()): each chunk of queries is searched against the
+ * reference tree, and its indices and products are appended to the output
+ * files.
+ */
+template<typename KernelType>
+class FastMKSChunkSearch
+{
+ public:
+  typedef typename FastMKSIndex<KernelType>::TreeType TreeType;
+
+  FastMKSChunkSearch(FastMKSIndex<KernelType>& index,
+                     KernelType& kernel,
+                     const bool single,
+                     const bool naive,
+                     const size_t threads,
+                     const double base,
+                     const size_t k,
+                     data::ChunkWriter<size_t>* indicesWriter,
+                     data::ChunkWriter<double>* productsWriter) :
+      index(index),
+      metric(kernel),
+      single(single),
+      naive(naive),
+      threads(threads),
+      base(base),
+      k(k),
+      epsilon(CLI::GetParam<double>("epsilon")),
+      indicesWriter(indicesWriter),
+      productsWriter(productsWriter)
+  { }
+
+  //! Search the given chunk of queries, keeping the results in the slot.
+  void Process(const arma::mat& chunk,
+               const size_t /* firstPoint */,
+               const size_t slot)
+  {
+    // Only dual-tree search needs a query tree.
+    TreeType* queryTree = (single || naive) ? NULL :
+        new TreeType(chunk, metric, base);
+
+    FastMKS<KernelType> fastmks(index.Dataset(), &index.Tree(), chunk,
+        queryTree, (single && !naive), naive);
+    fastmks.Threads() = threads;
+    fastmks.Epsilon() = epsilon;
+    fastmks.Search(k, indices[slot], products[slot]);
+
+    delete queryTree;
+  }
+
+  //! Append the results in the slot to the output files.
+  void Output(const size_t slot)
+  {
+    if (indicesWriter)
+      indicesWriter->Write(indices[slot]);
+    if (productsWriter)
+      productsWriter->Write(products[slot]);
+  }
 
-  // Now search with it.
-  fastmks.Search(k, indices, products);
+ private:
+  FastMKSIndex<KernelType>& index;
+  IPMetric<KernelType> metric;
+  bool single;
+  bool naive;
+  size_t threads;
+  double base;
+  size_t k;
+  double epsilon;
+  data::ChunkWriter<size_t>* indicesWriter;
+  data::ChunkWriter<double>* productsWriter;
+
+  //! The results of the chunk being searched and of the chunk being written.
+  arma::Mat<size_t> indices[2];
+  arma::mat products[2];
+};
+
+//! Run FastMKS for the query set in the given file, read in chunks of the given
+//! number of points, and write the results to the output files.
+template<typename KernelType>
+void RunChunkedFastMKS(const arma::mat& referenceData,
+                       const string& queryFile,
+                       const size_t queryChunk,
+                       const bool single,
+                       const bool naive,
+                       const size_t threads,
+                       const double base,
+                       const size_t k,
+                       KernelType& kernel)
+{
+  FastMKSIndex<KernelType>* index = GetIndex(referenceData, base, k, kernel);
+
+  const string indicesFile = CLI::GetParam<string>("indices_file");
+  const string productsFile = CLI::GetParam<string>("products_file");
+  data::ChunkWriter<size_t>* indicesWriter = (indicesFile == "") ? NULL :
+      new data::ChunkWriter<size_t>(indicesFile, k);
+  data::ChunkWriter<double>* productsWriter = (productsFile == "") ? NULL :
+      new data::ChunkWriter<double>(productsFile, k);
+
+  Log::Info << "Searching the queries in chunks of " << queryChunk
+      << " points..." << endl;
+  FastMKSChunkSearch<KernelType> stages(*index, kernel, single, naive, threads,
+      base, k, indicesWriter, productsWriter);
+  data::ChunkReader<double> reader(queryFile, queryChunk);
+  const size_t queries = reader.Pipeline(stages);
+  Log::Info << "Searched " << queries << " queries." << endl;
+
+  delete indicesWriter;
+  delete productsWriter;
+  delete index;
+}
+
+/**
+ * Run FastMKS with the given kernel: on the query set in chunks, if
+ * queryChunk is nonzero; otherwise on the query set, or, if it is empty, on
+ * the reference set.
+ */
+template<typename KernelType>
+void Search(KernelType& kernel,
+            const arma::mat& referenceData,
+            const arma::mat& queryData,
+            const size_t queryChunk,
+            const bool single,
+            const bool naive,
+            const size_t threads,
+            const double base,
+            const size_t k,
+            arma::Mat<size_t>& indices,
+            arma::mat& products)
+{
+  if (queryChunk > 0)
+    RunChunkedFastMKS<KernelType>(referenceData,
+        CLI::GetParam<string>("query_file"), queryChunk, single, naive,
+        threads, base, k, kernel);
+  else if (queryData.n_elem == 0)
+    RunFastMKS<KernelType>(referenceData, single, naive, threads, base, k,
+        indices, products, kernel);
+  else
+    RunFastMKS<KernelType>(referenceData, queryData, single, naive, threads,
+        base, k, indices, products, kernel);
 }
 
 int main(int argc, char** argv)
@@ -154,6 +380,7 @@ int main(int argc, char** argv)
   // Runtime parameters.
   const bool naive = CLI::HasParam("naive");
   const bool single = CLI::HasParam("single");
+  const int threads = CLI::GetParam<int>("threads");
 
   // For cover tree construction.
   const double base = CLI::GetParam<double>("base");
@@ -165,22 +392,27 @@ int main(int argc, char** argv)
   const double bandwidth = CLI::GetParam<double>("bandwidth");
   const double scale = CLI::GetParam<double>("scale");
 
-  // The datasets.  The query matrix may never be used.
-  arma::mat referenceData;
-  arma::mat queryData;
+  const int queryChunk = CLI::GetParam<int>("query_chunk");
 
-  data::Load(referenceFile, referenceData, true);
+  // The datasets.  The query matrix may never be used.  A reference set in the
+  // mlpack binary format (.mbin) is memory-mapped instead of being read.
+  data::MappedMatrix<double> reference;
+  arma::mat queryData;
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+  const string indexFile = CLI::GetParam<string>("index_file");
+  if ((referenceFile == "") == (indexFile == ""))
+    Log::Fatal << "Exactly one of --reference_file and --index_file must be "
+        << "given." << endl;
 
-  // Sanity check on k value.
-  if (k > referenceData.n_cols)
+  if (referenceFile != "")
   {
-    Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
-    Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
+    reference.Load(referenceFile, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << reference.Matrix().n_rows << " x " << reference.Matrix().n_cols
+        << ")." << endl;
   }
+  const arma::mat& referenceData = reference.Matrix();
 
   // Check on kernel type.
   if ((kernelType != "linear") && (kernelType != "polynomial") &&
@@ -193,8 +425,24 @@ int main(int argc, char** argv)
     Log::Fatal << "'linear' or 'polynomial'." << endl;
   }
 
-  // Load the query matrix, if we can.
-  if (CLI::HasParam("query_file"))
+  if (queryChunk < 0)
+    Log::Fatal << "Invalid query chunk size: " << queryChunk << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (queryChunk > 0 && !CLI::HasParam("query_file"))
+    Log::Fatal << "--query_chunk requires --query_file." << endl;
+
+  if (queryChunk > 0 && CLI::HasParam("exact_indices_file"))
+    Log::Fatal << "--query_chunk cannot be used with --exact_indices_file."
+        << endl;
+
+  // Load the query matrix, if we can (and it is not read in chunks).
+  if (queryChunk > 0)
+  {
+    Log::Info << "Reading query data from '"
+        << CLI::GetParam<string>("query_file") << "' in chunks." << endl;
+  }
+  else if (CLI::HasParam("query_file"))
   {
     const string queryFile = CLI::GetParam<string>("query_file");
     data::Load(queryFile, queryData, true);
@@ -208,6 +456,18 @@ int main(int argc, char** argv)
         << "specified)." << endl;
   }
 
+  if (CLI::GetParam<double>("epsilon") < 0.0)
+  {
+    Log::Fatal << "Invalid epsilon: " << CLI::GetParam<double>("epsilon")
+        << ".  Must be greater than or equal to 0." << endl;
+  }
+
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Naive mode overrides single mode.
   if (naive && single)
   {
@@ -218,97 +478,62 @@ int main(int argc, char** argv)
   arma::Mat<size_t> indices;
   arma::mat products;
 
-  // Construct FastMKS object.
-  if (queryData.n_elem == 0)
+  // Run FastMKS with the requested kernel.
+  if (kernelType == "linear")
   {
-    if (kernelType == "linear")
-    {
-      LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, single, naive, base, k, indices,
-          products, lk);
-    }
-    else if (kernelType == "polynomial")
-    {
-
-      PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, single, naive, base, k,
-          indices, products, pk);
-    }
-    else if (kernelType == "cosine")
-    {
-      CosineDistance cd;
-      RunFastMKS<CosineDistance>(referenceData, single, naive, base, k, indices,
-          products, cd);
-    }
-    else if (kernelType == "gaussian")
-    {
-      GaussianKernel gk(bandwidth);
-      RunFastMKS<GaussianKernel>(referenceData, single, naive, base, k, indices,
-          products, gk);
-    }
-    else if (kernelType == "epanechnikov")
-    {
-      EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, single, naive, base, k,
-          indices, products, ek);
-    }
-    else if (kernelType == "triangular")
-    {
-      TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, single, naive, base, k,
-          indices, products, tk);
-    }
-    else if (kernelType == "hyptan")
-    {
-      HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, single, naive, base, k,
-          indices, products, htk);
-    }
+    LinearKernel lk;
+    Search(lk, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
   }
-  else
+  else if (kernelType == "polynomial")
   {
-    if (kernelType == "linear")
-    {
-      LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, queryData, single, naive, base, k,
-          indices, products, lk);
-    }
-    else if (kernelType == "polynomial")
-    {
-      PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, pk);
-    }
-    else if (kernelType == "cosine")
-    {
-      CosineDistance cd;
-      RunFastMKS<CosineDistance>(referenceData, queryData, single, naive, base,
-          k, indices, products, cd);
-    }
-    else if (kernelType == "gaussian")
-    {
-      GaussianKernel gk(bandwidth);
-      RunFastMKS<GaussianKernel>(referenceData, queryData, single, naive, base,
-          k, indices, products, gk);
-    }
-    else if (kernelType == "epanechnikov")
-    {
-      EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, ek);
-    }
-    else if (kernelType == "triangular")
-    {
-      TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, tk);
-    }
-    else if (kernelType == "hyptan")
-    {
-      HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, queryData, single,
-          naive, base, k, indices, products, htk);
-    }
+    PolynomialKernel pk(degree, offset);
+    Search(pk, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+  else if (kernelType == "cosine")
+  {
+    CosineDistance cd;
+    Search(cd, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+  else if (kernelType == "gaussian")
+  {
+    GaussianKernel gk(bandwidth);
+    Search(gk, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+  else if (kernelType == "epanechnikov")
+  {
+    EpanechnikovKernel ek(bandwidth);
+    Search(ek, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+  else if (kernelType == "triangular")
+  {
+    TriangularKernel tk(bandwidth);
+    Search(tk, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+  else if (kernelType == "hyptan")
+  {
+    HyperbolicTangentKernel htk(scale, offset);
+    Search(htk, referenceData, queryData, (size_t) queryChunk, single, naive,
+        (size_t) threads, base, k, indices, products);
+  }
+
+  // The results of a chunked search have already been written.
+  if (queryChunk > 0)
+    return 0;
+
+  // Compare with the exact results, if we were asked to.
+  if (CLI::HasParam("exact_indices_file"))
+  {
+    const string exactFile = CLI::GetParam<string>("exact_indices_file");
+    arma::Mat<size_t> exactIndices;
+    data::Load(exactFile, exactIndices, true);
+
+    Log::Info << "Recall: " << Recall(indices, exactIndices) << "." << endl;
   }
 
   // Save output, if we were asked to.
@@ -24,6 +24,8 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
+#include <mlpack/methods/neighbor_search/sort_policies/furthest_neighbor_sort.hpp>
 
 namespace mlpack {
 namespace fastmks {
@@ -35,11 +37,25 @@ template<typename KernelType, typename TreeType>
 class FastMKSRules
 {
  public:
+  /**
+   * Construct the rules.  With a positive epsilon the search is approximate: a
+   * node is pruned when its kernel bound is at most (1 + epsilon) times the
+   * current kth best kernel, so each returned positive kernel is at least
+   * 1 / (1 + epsilon) times the true one.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param indices Matrix to store resulting indices in.
+   * @param products Matrix to store resulting kernel values in.
+   * @param kernel Kernel to use.
+   * @param epsilon Relative error allowed in the results (0 is exact).
+   */
   FastMKSRules(const arma::mat& referenceSet,
                const arma::mat& querySet,
                arma::Mat<size_t>& indices,
                arma::mat& products,
-               KernelType& kernel);
+               KernelType& kernel,
+               const double epsilon = 0.0);
 
   //! Compute the base case (kernel value) between two points.
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
@@ -104,6 +120,9 @@ class FastMKSRules
   //! Modify the number of times Score() was called.
   size_t& Scores() { return scores; }
 
+  //! Get the relative error allowed in the results.
+  double Epsilon() const { return epsilon; }
+
  private:
   //! The reference dataset.
   const arma::mat& referenceSet;
@@ -115,6 +134,15 @@ class FastMKSRules
   //! The maximum kernels.
   arma::mat& products;
 
+  //! The candidates are kept as heaps for large k; larger kernel values are
+  //! better, as larger distances are for FurthestNeighborSort.
+  typedef neighbor::CandidateHeap<neighbor::FurthestNeighborSort>
+      CandidateHeapType;
+  //! Whether the candidates are kept as heaps.
+  bool heap;
+  //! The row of the worst candidate of each query point.
+  size_t worstRow;
+
   //! Cached query set self-kernels (|| q || for each q).
   arma::vec queryKernels;
   //! Cached reference set self-kernels (|| r || for each r).
@@ -123,6 +151,9 @@ class FastMKSRules
   //! The instantiated kernel.
   KernelType& kernel;
 
+  //! The relative error allowed in the results.
+  double epsilon;
+
   //! The last query index BaseCase() was called with.
   size_t lastQueryIndex;
   //! The last reference index BaseCase() was called with.
@@ -133,6 +164,11 @@ class FastMKSRules
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
+  //! Loosen a pruning bound by the factor (1 + epsilon).  Nonpositive bounds
+  //! are returned unchanged, so that they are never tightened.
+  double Relax(const double bound) const
+  { return (bound > 0.0) ? (1.0 + epsilon) * bound : bound; }
+
   //! Utility function to insert neighbor into list of results.
   void InsertNeighbor(const size_t queryIndex,
                       const size_t pos,
@@ -33,12 +33,16 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(const arma::mat& referenceSet,
                                                  const arma::mat& querySet,
                                                  arma::Mat<size_t>& indices,
                                                  arma::mat& products,
-                                                 KernelType& kernel) :
+                                                 KernelType& kernel,
+                                                 const double epsilon) :
     referenceSet(referenceSet),
     querySet(querySet),
     indices(indices),
     products(products),
+    heap(CandidateHeapType::Use(products.n_rows)),
+    worstRow(CandidateHeapType::WorstRow(products.n_rows)),
     kernel(kernel),
+    epsilon(epsilon),
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
@@ -92,7 +96,16 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
   if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
     return kernelEval;
 
-  // If this is a better candidate, insert it into the list.
+  // If this is a better candidate, insert it into the list.  With many
+  // candidates, they are kept as a heap (see neighbor::CandidateHeap).
+  if (heap)
+  {
+    CandidateHeapType::Insert(products.colptr(queryIndex),
+        indices.colptr(queryIndex), products.n_rows, kernelEval,
+        referenceIndex);
+    return kernelEval;
+  }
+
   if (kernelEval < products(products.n_rows - 1, queryIndex))
     return kernelEval;
 
@@ -110,8 +123,8 @@ template<typename KernelType, typename TreeType>
 double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
-  // Compare with the current best.
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  // Compare with the current best, loosened for approximate search.
+  const double bestKernel = Relax(products(worstRow, queryIndex));
 
   // See if we can perform a parent-child prune.
   const double furthestDist = referenceNode.FurthestDescendantDistance();
@@ -207,7 +220,7 @@ double FastMKSRules<KernelType, TreeType>::Score(TreeType& queryNode,
 {
   // Update and get the query node's bound.
   queryNode.Stat().Bound() = CalculateBound(queryNode);
-  const double bestKernel = queryNode.Stat().Bound();
+  const double bestKernel = Relax(queryNode.Stat().Bound());
 
   // First, see if we can make a parent-child or parent-parent prune.  These
   // four bounds on the maximum kernel value are looser than the bound normally
@@ -424,7 +437,7 @@ double FastMKSRules<KernelType, TreeType>::Rescore(const size_t queryIndex,
                                                    TreeType& /*referenceNode*/,
                                                    const double oldScore) const
 {
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  const double bestKernel = Relax(products(worstRow, queryIndex));
 
   return ((1.0 / oldScore) > bestKernel) ? oldScore : DBL_MAX;
 }
@@ -435,7 +448,7 @@ double FastMKSRules<KernelType, TreeType>::Rescore(TreeType& queryNode,
                                                    const double oldScore) const
 {
   queryNode.Stat().Bound() = CalculateBound(queryNode);
-  const double bestKernel = queryNode.Stat().Bound();
+  const double bestKernel = Relax(queryNode.Stat().Bound());
 
   return ((1.0 / oldScore) > bestKernel) ? oldScore : DBL_MAX;
 }
@@ -469,17 +482,17 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
     const size_t point = queryNode.Point(i);
-    if (products(products.n_rows - 1, point) < worstPointKernel)
-      worstPointKernel = products(products.n_rows - 1, point);
+    if (products(worstRow, point) < worstPointKernel)
+      worstPointKernel = products(worstRow, point);
 
-    if (products(products.n_rows - 1, point) == -DBL_MAX)
+    if (products(worstRow, point) == -DBL_MAX)
       continue; // Avoid underflow.
 
     // This should be (queryDescendantDistance + centroidDistance) for any tree
     // but it works for cover trees since centroidDistance = 0 for cover trees.
-    const double candidateKernel = products(products.n_rows - 1, point) -
+    const double candidateKernel = products(worstRow, point) -
         queryDescendantDistance *
-        referenceKernels[indices(indices.n_rows - 1, point)];
+        referenceKernels[indices(worstRow, point)];
 
     if (candidateKernel > bestAdjustedPointKernel)
       bestAdjustedPointKernel = candidateKernel;
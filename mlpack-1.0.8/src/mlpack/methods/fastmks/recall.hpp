@@ -0,0 +1,79 @@
+/**
+ * @file recall.hpp
+ *
+ * Evaluation of the recall of approximate max-kernel search results.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_RECALL_HPP
+#define __MLPACK_METHODS_FASTMKS_RECALL_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace fastmks {
+
+/**
+ * Compute the recall of approximate search results against the exact results:
+ * the fraction of the exact indices of each query point which also appear in
+ * the approximate indices of that point, averaged over all query points.  Both
+ * matrices hold the results of one query point in each column, as returned by
+ * FastMKS::Search() (or NeighborSearch::Search()); the order within a column
+ * does not matter.
+ *
+ * @param approximate Indices found by approximate search.
+ * @param exact Indices found by exact search.
+ * @return Recall, between 0 and 1.
+ */
+inline double Recall(const arma::Mat<size_t>& approximate,
+                     const arma::Mat<size_t>& exact)
+{
+  if ((approximate.n_rows != exact.n_rows) ||
+      (approximate.n_cols != exact.n_cols))
+  {
+    Log::Fatal << "Recall(): approximate results (" << approximate.n_rows
+        << " x " << approximate.n_cols << ") and exact results ("
+        << exact.n_rows << " x " << exact.n_cols << ") differ in size."
+        << std::endl;
+  }
+
+  if (exact.n_elem == 0)
+    return 1.0;
+
+  size_t found = 0;
+  for (size_t q = 0; q < exact.n_cols; ++q)
+  {
+    // k is small, so a linear scan of the column is fastest.
+    for (size_t i = 0; i < exact.n_rows; ++i)
+    {
+      for (size_t j = 0; j < approximate.n_rows; ++j)
+      {
+        if (approximate(j, q) == exact(i, q))
+        {
+          ++found;
+          break;
+        }
+      }
+    }
+  }
+
+  return double(found) / double(exact.n_elem);
+}
+
+}; // namespace fastmks
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file constraint_traits.hpp
+ *
+ * ConstraintTraits, which gives compile-time information about a covariance
+ * constraint policy of EMFit.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_GMM_CONSTRAINT_TRAITS_HPP
+#define __MLPACK_METHODS_GMM_CONSTRAINT_TRAITS_HPP
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * The ConstraintTraits class provides compile-time information about a
+ * covariance constraint policy, in the same way BoundTraits does for bounds.
+ * The unspecialized class makes no assumptions about the constraint; specialize
+ * it for a constraint which has any of these properties.
+ */
+template<typename CovarianceConstraintPolicy>
+struct ConstraintTraits
+{
+  /**
+   * This is true if the constraint keeps only the diagonal of the covariance.
+   * EMFit then only computes the variances, so that the M-step takes O(d) time
+   * per point and component instead of O(d^2), and the E-step evaluates each
+   * Gaussian in O(d) (see GaussianDistribution).
+   */
+  static const bool IsDiagonal = false;
+};
+
+}; // namespace gmm
+}; // namespace mlpack
+
+#endif
@@ -23,6 +23,7 @@
 #define __MLPACK_METHODS_GMM_DIAGONAL_CONSTRAINT_HPP
 
 #include <mlpack/core.hpp>
+#include "constraint_traits.hpp"
 
 namespace mlpack {
 namespace gmm {
@@ -42,6 +43,13 @@ class DiagonalConstraint
   }
 };
 
+//! EMFit only needs the variances when the covariance is kept diagonal.
+template<>
+struct ConstraintTraits<DiagonalConstraint>
+{
+  static const bool IsDiagonal = true;
+};
+
 }; // namespace gmm
 }; // namespace mlpack
 
@@ -29,6 +29,10 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 // Default covariance matrix constraint.
 #include "positive_definite_constraint.hpp"
+#include "constraint_traits.hpp"
+// Statistic of the kd-tree used by the tree-based E-step.
+#include "em_statistic.hpp"
+#include <mlpack/core/tree/binary_space_tree.hpp>
 
 namespace mlpack {
 namespace gmm {
@@ -45,6 +49,53 @@ namespace gmm {
  *
  * This method should create 'clusters' clusters, and return the assignment of
  * each point to a cluster.
+ *
+ * By default, EM runs serially.  If Threads() is set to something other than 1,
+ * the observations are partitioned into that many blocks (0 means one block
+ * per available core), the E-step runs on each block in parallel (this
+ * requires MLPACK to be built with OpenMP), and the per-block sufficient
+ * statistics for the M-step are merged in block order.  The result therefore
+ * depends only on the number of blocks, not on how the blocks were scheduled.
+ *
+ * The serial E-step keeps an n x k matrix of responsibilities and two
+ * temporaries the size of the data.  When a MemoryBudget is set and these do
+ * not fit in it, the blockwise E-step is used instead (even with one thread),
+ * with blocks small enough that the working memory of the blocks processed at
+ * once fits in the budget.  PeakMemory() estimates the working memory.
+ *
+ * If the CovarianceConstraintPolicy keeps only the diagonal of the covariance
+ * (see ConstraintTraits), only the variances are computed in the M-step, and
+ * only they are kept in the statistics of the blocks, so each iteration takes
+ * O(d) time and memory per point and component instead of O(d^2).  The
+ * covariances are still returned as (diagonal) matrices.
+ *
+ * For large, low-dimensional datasets, UseTree() runs the E-step of the
+ * unweighted Estimate() on a kd-tree of the observations, as in Moore's
+ * multiresolution kd-tree EM (the mrkd-trees which KMeans::FastCluster() also
+ * uses).  For each node, the log-density of each component over the bounding
+ * box of the node is bounded, which bounds the responsibilities of the
+ * components for every point of the node.  Components whose responsibility is
+ * at most TreeTolerance() are dropped from the node, and when every remaining
+ * responsibility is known to within TreeTolerance(), the whole node is
+ * assigned the responsibilities of its centroid and its cached statistics (see
+ * EMStatistic) are added to the M-step at once.  Only the other leaves are
+ * evaluated exactly.  A TreeTolerance() of 0 gives the exact E-step.  The tree
+ * E-step runs serially, and the log-likelihood it reports is approximate too.
+ *
+ * If a Monitor() is set, it is called after each iteration with the
+ * log-likelihood of the model, and may stop EM early; the model is then that
+ * of the last finished iteration, which is the best one so far.
+ *
+ * If a Comm() is set, the observations given to Estimate() are only the shard
+ * of this rank, and the E-step is blockwise: the sufficient statistics of the
+ * M-step and the log-likelihood of each shard are summed over all ranks in
+ * each iteration, so every rank fits the same model to the whole dataset.  The
+ * initial model must be the same on every rank: either give it with
+ * useInitialModel, or use a clusterer which clusters distributed data (such
+ * as a KMeans with the same communicator, whose Comm() is then set); the
+ * initial Gaussians are computed from the global clusters.  Every rank must
+ * call Estimate() at once, so GMM::Estimate() should then be run with one
+ * trial.
  */
 template<typename InitialClusteringType = kmeans::KMeans<>,
          typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
@@ -138,6 +189,51 @@ class EMFit
   //! Modify the tolerance for the convergence of the EM algorithm.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of iterations the last call to Estimate() ran.
+  size_t Iterations() const { return iterations; }
+
+  /**
+   * Return the working memory (in bytes, beyond the observations and the
+   * model) that Estimate() is expected to need for the given problem size
+   * under the current MemoryBudget.
+   *
+   * @param points Number of observations.
+   * @param dimensionality Dimensionality of the observations.
+   * @param gaussians Number of components.
+   */
+  size_t PeakMemory(const size_t points,
+                    const size_t dimensionality,
+                    const size_t gaussians) const;
+
+  //! Get the number of threads used for EM (1 is serial, 0 is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for EM (1 is serial, 0 is all cores).
+  size_t& Threads() { return threads; }
+
+  //! Get whether the E-step of the unweighted Estimate() runs on a kd-tree.
+  bool UseTree() const { return useTree; }
+  //! Modify whether the E-step of the unweighted Estimate() runs on a kd-tree.
+  bool& UseTree() { return useTree; }
+
+  //! Get the largest error of the responsibilities allowed by the tree E-step.
+  double TreeTolerance() const { return treeTolerance; }
+  //! Modify the largest error of the responsibilities allowed by the tree
+  //! E-step.
+  double& TreeTolerance() { return treeTolerance; }
+
+  //! Get the monitor which observes Estimate() (NULL if there is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes Estimate() (see ProgressMonitor).
+  ProgressMonitor*& Monitor() { return monitor; }
+
+  //! Get the communicator of the ranks the observations are distributed over
+  //! (NULL if EM runs on one process).
+  Communicator* Comm() const { return comm; }
+  //! Modify the communicator of the ranks the observations are distributed
+  //! over; each rank then gives its own shard to Estimate(), and the
+  //! statistics of the M-step are summed over all ranks.
+  Communicator*& Comm() { return comm; }
+
  private:
   /**
    * Run the clusterer, and then turn the cluster assignments into Gaussians.
@@ -169,6 +265,229 @@ class EMFit
                        const std::vector<arma::mat>& covariances,
                        const arma::vec& weights) const;
 
+  /**
+   * Compute the log of the weighted probability of each observation under each
+   * component, log(w_i) + log(p_i(x_j)), for all observations and components.
+   * Each component is evaluated against the whole observation matrix at once
+   * (one triangular solve per component).
+   *
+   * @param observations List of observations.
+   * @param means Vector of means.
+   * @param covariances Vector of covariance matrices.
+   * @param weights Vector of a priori weights.
+   * @param logProb Matrix to store log-probabilities in (one row per
+   *     observation, one column per component).
+   */
+  void ComponentLogProbabilities(const arma::mat& observations,
+                                 const std::vector<arma::vec>& means,
+                                 const std::vector<arma::mat>& covariances,
+                                 const arma::vec& weights,
+                                 arma::mat& logProb) const;
+
+  /**
+   * Perform the E-step: compute the responsibility of each component for each
+   * observation.  This is done in log-space with log-sum-exp normalization, so
+   * it does not underflow for high-dimensional data.  The log-likelihood of
+   * the model is a byproduct of the normalization, so it is returned.
+   *
+   * @param observations List of observations.
+   * @param means Vector of means.
+   * @param covariances Vector of covariance matrices.
+   * @param weights Vector of a priori weights.
+   * @param condProb Matrix to store responsibilities in (one row per
+   *     observation, one column per component).
+   * @return Log-likelihood of the observations under the model.
+   */
+  double ExpectationStep(const arma::mat& observations,
+                         const std::vector<arma::vec>& means,
+                         const std::vector<arma::mat>& covariances,
+                         const arma::vec& weights,
+                         arma::mat& condProb) const;
+
+  /**
+   * Return whether the E-step should be done blockwise: when Threads() is not
+   * 1, when there is a Comm(), or when the serial E-step does not fit in the
+   * MemoryBudget.
+   */
+  bool UseBlocks(const size_t points,
+                 const size_t dimensionality,
+                 const size_t gaussians) const;
+
+  //! Return the number of threads to process blocks with (at least 1).
+  size_t NumWorkers(const size_t points) const;
+
+  /**
+   * Return the number of blocks to split the observations into: one for each
+   * worker, or more if the blocks would not fit in the MemoryBudget.
+   */
+  size_t NumBlocks(const size_t points,
+                   const size_t dimensionality,
+                   const size_t gaussians) const;
+
+  /**
+   * Sum the given sufficient statistics and log-likelihood over all ranks of
+   * Comm(), in place.  This does nothing if there is no communicator.
+   *
+   * @param probSums Sum of the responsibilities of each component.
+   * @param sums Responsibility-weighted sum of (x - mean) for each component.
+   * @param outerProducts Responsibility-weighted outer products of each
+   *     component.
+   * @param logLikelihood Log-likelihood of the observations.
+   */
+  void Reduce(arma::vec& probSums,
+              std::vector<arma::vec>& sums,
+              std::vector<arma::mat>& outerProducts,
+              double& logLikelihood) const;
+
+  //! The kd-tree of the tree E-step.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>, EMStatistic> TreeType;
+
+  /**
+   * Run EM with the sufficient statistics of the M-step accumulated by
+   * ParallelExpectationStep(), with the observations partitioned into blocks
+   * that are processed in parallel, or, if a tree is given, by
+   * TreeExpectationStep().  This is only called when UseBlocks() or
+   * UseTree() is true.  The initial model must already be set.
+   *
+   * @param observations List of observations to train on (the dataset of the
+   *     tree, if there is one).
+   * @param probabilities Probability of each point being from this model.
+   * @param means Vector to store trained means in.
+   * @param covariances Vector to store trained covariances in.
+   * @param weights Vector to store a priori weights in.
+   * @param tree The kd-tree of the observations, or NULL.
+   */
+  void ParallelEstimate(const arma::mat& observations,
+                        const arma::vec& probabilities,
+                        std::vector<arma::vec>& means,
+                        std::vector<arma::mat>& covariances,
+                        arma::vec& weights,
+                        const TreeType* tree = NULL);
+
+  /**
+   * Perform the E-step on each block of observations in parallel (NumWorkers()
+   * blocks at a time), and accumulate the sufficient statistics needed for the
+   * M-step.  The weighted
+   * sums and outer products are taken about the current mean of each
+   * component, which keeps the covariance update numerically stable.
+   *
+   * @param observations List of observations.
+   * @param probabilities Probability of each point being from this model.
+   * @param means Vector of means.
+   * @param covariances Vector of covariance matrices.
+   * @param weights Vector of a priori weights.
+   * @param probSums Sum of the responsibilities of each component.
+   * @param sums Responsibility-weighted sum of (x - mean) for each component.
+   * @param outerProducts Responsibility-weighted sum of
+   *     (x - mean) * (x - mean)^T for each component (see Scatter()).
+   * @return Log-likelihood of the observations under the model.
+   */
+  double ParallelExpectationStep(const arma::mat& observations,
+                                 const arma::vec& probabilities,
+                                 const std::vector<arma::vec>& means,
+                                 const std::vector<arma::mat>& covariances,
+                                 const arma::vec& weights,
+                                 arma::vec& probSums,
+                                 std::vector<arma::vec>& sums,
+                                 std::vector<arma::mat>& outerProducts) const;
+
+  //! What the tree E-step needs to know about each component.
+  struct TreeComponent
+  {
+    //! The Gaussian, with its covariance factorized.
+    distribution::GaussianDistribution gaussian;
+    //! The log of the a priori weight of the component.
+    double logWeight;
+    //! log(weight) - (d log(2 pi) + log det(covariance)) / 2.
+    double logConstant;
+    //! False if the covariance is not positive definite; the log-density is
+    //! then not bounded over nodes.
+    bool bounded;
+    //! The inverse of the covariance.
+    arma::mat invCovariance;
+    //! The scale of each dimension in the bounds of the Mahalanobis distance:
+    //! the inverse variances for a diagonal covariance.
+    arma::vec scales;
+    //! The smallest eigenvalue of the inverse of a covariance which is not
+    //! diagonal.
+    double minScale;
+    //! The largest eigenvalue of the inverse of a covariance which is not
+    //! diagonal.
+    double maxScale;
+  };
+
+  /**
+   * Perform the E-step on the kd-tree of the observations, and accumulate the
+   * sufficient statistics needed for the M-step, as ParallelExpectationStep()
+   * does.  The responsibilities are only exact to within TreeTolerance().
+   *
+   * @param tree The kd-tree of the observations.
+   * @param means Vector of means.
+   * @param covariances Vector of covariance matrices.
+   * @param weights Vector of a priori weights.
+   * @param probSums Sum of the responsibilities of each component.
+   * @param sums Responsibility-weighted sum of (x - mean) for each component.
+   * @param outerProducts Responsibility-weighted sum of
+   *     (x - mean) * (x - mean)^T for each component (see Scatter()).
+   * @return Approximate log-likelihood of the observations under the model.
+   */
+  double TreeExpectationStep(const TreeType& tree,
+                             const std::vector<arma::vec>& means,
+                             const std::vector<arma::mat>& covariances,
+                             const arma::vec& weights,
+                             arma::vec& probSums,
+                             std::vector<arma::vec>& sums,
+                             std::vector<arma::mat>& outerProducts) const;
+
+  /**
+   * Recurse into the given node for TreeExpectationStep(), with the given
+   * components, which are the only ones that may have a responsibility of
+   * more than TreeTolerance() for the points of the node.
+   *
+   * @return Approximate log-likelihood of the points of the node.
+   */
+  double TreeExpectationStep(const TreeType& node,
+                             const std::vector<TreeComponent>& components,
+                             const std::vector<size_t>& active,
+                             arma::vec& probSums,
+                             std::vector<arma::vec>& sums,
+                             std::vector<arma::mat>& outerProducts) const;
+
+  /**
+   * Bound log(w_i) + log(p_i(x)) over the given bounding box, for the given
+   * component i.
+   *
+   * @param bound Bounding box of a node.
+   * @param component The component.
+   * @param lower Lower bound of the log-density.
+   * @param upper Upper bound of the log-density.
+   */
+  static void LogDensityBounds(const bound::HRectBound<2>& bound,
+                               const TreeComponent& component,
+                               double& lower,
+                               double& upper);
+
+  /**
+   * Compute the weighted scatter of the given centered observations, the sum
+   * of weights[j] * x_j * x_j^T.  If the constraint keeps only the diagonal of
+   * the covariance, only the diagonal of the scatter is computed (as a single
+   * column), in O(d) time per observation.
+   *
+   * @param centered Observations, less the mean.
+   * @param weights Weight of each observation.
+   * @param scatter Matrix to store the scatter (or its diagonal) in.
+   */
+  static void Scatter(const arma::mat& centered,
+                      const arma::vec& weights,
+                      arma::mat& scatter);
+
+  //! Return the number of columns of the scatter computed by Scatter().
+  static size_t ScatterColumns(const size_t dimensionality);
+
+  //! Set the covariance from the given scatter, as computed by Scatter() and
+  //! normalized.
+  static void SetCovariance(const arma::mat& scatter, arma::mat& covariance);
+
   //! Maximum iterations of EM algorithm.
   size_t maxIterations;
   //! Tolerance for convergence of EM.
@@ -177,6 +496,19 @@ class EMFit
   InitialClusteringType clusterer;
   //! Object which applies constraints to the covariance matrix.
   CovarianceConstraintPolicy constraint;
+  //! Number of threads (blocks) to use; 1 is serial, 0 is all cores.
+  size_t threads;
+  //! If true, the E-step of the unweighted Estimate() runs on a kd-tree.
+  bool useTree;
+  //! The largest error of the responsibilities allowed by the tree E-step.
+  double treeTolerance;
+  //! Monitor of the progress of EM (may be NULL).
+  ProgressMonitor* monitor;
+  //! Communicator of the ranks the observations are distributed over (may be
+  //! NULL).
+  Communicator* comm;
+  //! The number of iterations the last call to Estimate() ran.
+  size_t iterations;
 };
 
 }; // namespace gmm
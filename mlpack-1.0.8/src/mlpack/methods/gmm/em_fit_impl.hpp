@@ -28,6 +28,10 @@
 // Definition of phi().
 #include "phi.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace gmm {
 
@@ -41,7 +45,13 @@ EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
     maxIterations(maxIterations),
     tolerance(tolerance),
     clusterer(clusterer),
-    constraint(constraint)
+    constraint(constraint),
+    threads(1),
+    useTree(false),
+    treeTolerance(1e-3),
+    monitor(NULL),
+    comm(NULL),
+    iterations(0)
 { /* Nothing to do. */ }
 
 template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
@@ -56,13 +66,37 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   if (!useInitialModel)
     InitialClustering(observations, means, covariances, weights);
 
-  double l = LogLikelihood(observations, means, covariances, weights);
+  // The tree is built on a copy of the observations, because it reorders them;
+  // the order of the observations does not change the model.
+  if (useTree && observations.n_cols > 0)
+  {
+    arma::mat treeObservations(observations);
+    TreeType tree(treeObservations);
+
+    ParallelEstimate(treeObservations, arma::ones<arma::vec>(
+        observations.n_cols), means, covariances, weights, &tree);
+    return;
+  }
+
+  // In parallel (or blockwise) mode, every point is fully from this mixture.
+  if (UseBlocks(observations.n_cols, observations.n_rows, means.size()))
+  {
+    ParallelEstimate(observations, arma::ones<arma::vec>(observations.n_cols),
+        means, covariances, weights);
+    return;
+  }
+
+  // Calculate the conditional probabilities of choosing a particular Gaussian
+  // given the observations and the present theta value.  The log-likelihood of
+  // the model comes out of the E-step for free.
+  arma::mat condProb;
+  double l = ExpectationStep(observations, means, covariances, weights,
+      condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, means.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
@@ -71,27 +105,6 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
     Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
         << "log-likelihood " << l << "." << std::endl;
 
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < means.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      phi(observations, means[i], covariances[i], condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
     // Store the sum of the probability of each state over all the observations.
     arma::vec probRowSums = trans(arma::sum(condProb, 0 /* columnwise */));
 
@@ -107,12 +120,14 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
       // conditional probabilities and the updated means.
       arma::mat tmp = observations - (means[i] *
           arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i)));
 
       // Don't update if there's no probability of the Gaussian having points.
       if (probRowSums[i] != 0.0)
-        covariances[i] = (tmp * trans(tmpB)) / probRowSums[i];
+      {
+        arma::mat scatter;
+        Scatter(tmp, condProb.col(i), scatter);
+        SetCovariance(scatter / probRowSums[i], covariances[i]);
+      }
 
       // Apply covariance constraint.
       constraint.ApplyConstraint(covariances[i]);
@@ -122,12 +137,19 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
     // probabilities.
     weights = probRowSums / observations.n_cols;
 
-    // Update values of l; calculate new log-likelihood.
+    // Update values of l; calculate new log-likelihood and the conditional
+    // probabilities for the next iteration.
     lOld = l;
-    l = LogLikelihood(observations, means, covariances, weights);
+    l = ExpectationStep(observations, means, covariances, weights, condProb);
 
     iteration++;
+
+    // The monitor may stop EM after any iteration, keeping the current model.
+    if (monitor && !monitor->Continue("EMFit::Estimate()", iteration - 1, l))
+      break;
   }
+
+  iterations = iteration - 1;
 }
 
 template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
@@ -142,39 +164,28 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   if (!useInitialModel)
     InitialClustering(observations, means, covariances, weights);
 
-  double l = LogLikelihood(observations, means, covariances, weights);
+  if (UseBlocks(observations.n_cols, observations.n_rows, means.size()))
+  {
+    ParallelEstimate(observations, probabilities, means, covariances, weights);
+    return;
+  }
+
+  // Calculate the conditional probabilities of choosing a particular Gaussian
+  // given the observations and the present theta value, along with the
+  // log-likelihood of the model.
+  arma::mat condProb;
+  double l = ExpectationStep(observations, means, covariances, weights,
+      condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, means.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < means.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      phi(observations, means[i], covariances[i], condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
     // This will store the sum of probabilities of each state over all the
     // observations.
     arma::vec probRowSums(means.size());
@@ -196,10 +207,10 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
       // conditional probabilities and the updated means.
       arma::mat tmp = observations - (means[i] *
           arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i) % probabilities));
 
-      covariances[i] = (tmp * trans(tmpB)) / probRowSums[i];
+      arma::mat scatter;
+      Scatter(tmp, condProb.col(i) % probabilities, scatter);
+      SetCovariance(scatter / probRowSums[i], covariances[i]);
 
       // Apply covariance constraint.
       constraint.ApplyConstraint(covariances[i]);
@@ -209,12 +220,19 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
     // probabilities.
     weights = probRowSums / accu(probabilities);
 
-    // Update values of l; calculate new log-likelihood.
+    // Update values of l; calculate new log-likelihood and the conditional
+    // probabilities for the next iteration.
     lOld = l;
-    l = LogLikelihood(observations, means, covariances, weights);
+    l = ExpectationStep(observations, means, covariances, weights, condProb);
 
     iteration++;
+
+    // The monitor may stop EM after any iteration, keeping the current model.
+    if (monitor && !monitor->Continue("EMFit::Estimate()", iteration - 1, l))
+      break;
   }
+
+  iterations = iteration - 1;
 }
 
 template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
@@ -253,6 +271,14 @@ InitialClustering(const arma::mat& observations,
     weights[cluster]++;
   }
 
+  // On distributed observations, the clusters are global.
+  if (comm != NULL)
+  {
+    for (size_t i = 0; i < means.size(); ++i)
+      comm->Sum(means[i].memptr(), means[i].n_elem);
+    comm->Sum(weights.memptr(), weights.n_elem);
+  }
+
   // Now normalize the mean and covariance.
   for (size_t i = 0; i < means.size(); ++i)
   {
@@ -266,9 +292,16 @@ InitialClustering(const arma::mat& observations,
   {
     const size_t cluster = assignments[i];
     const arma::vec normObs = observations.col(i) - means[cluster];
-    covariances[cluster] += normObs * normObs.t();
+    if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+      covariances[cluster].diag() += normObs % normObs;
+    else
+      covariances[cluster] += normObs * normObs.t();
   }
 
+  if (comm != NULL)
+    for (size_t i = 0; i < means.size(); ++i)
+      comm->Sum(covariances[i].memptr(), covariances[i].n_elem);
+
   for (size_t i = 0; i < means.size(); ++i)
   {
     covariances[i] /= (weights[i] > 1) ? weights[i] : 1;
@@ -288,28 +321,734 @@ double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::LogLikelihood(
     const std::vector<arma::mat>& covariances,
     const arma::vec& weights) const
 {
-  double logLikelihood = 0;
+  arma::mat logProb;
+  ComponentLogProbabilities(observations, means, covariances, weights,
+      logProb);
+
+  // Sum over every component in log-space, then over every point.
+  arma::vec logLikelihoods;
+  math::LogSumExp(logProb, logLikelihoods);
+
+  return accu(logLikelihoods);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ComponentLogProbabilities(const arma::mat& observations,
+                          const std::vector<arma::vec>& means,
+                          const std::vector<arma::mat>& covariances,
+                          const arma::vec& weights,
+                          arma::mat& logProb) const
+{
+  logProb.set_size(observations.n_cols, means.size());
 
-  arma::vec phis;
-  arma::mat likelihoods(means.size(), observations.n_cols);
   for (size_t i = 0; i < means.size(); ++i)
   {
-    phi(observations, means[i], covariances[i], phis);
-    likelihoods.row(i) = weights(i) * trans(phis);
+    // Store log-probabilities into the logProb matrix for each Gaussian.  The
+    // whole observation matrix is evaluated at once.
+    arma::vec logProbAlias = logProb.unsafe_col(i);
+    distribution::GaussianDistribution(means[i], covariances[i]).
+        LogProbability(observations, logProbAlias);
+    logProbAlias += log(weights[i]);
   }
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ExpectationStep(const arma::mat& observations,
+                const std::vector<arma::vec>& means,
+                const std::vector<arma::mat>& covariances,
+                const arma::vec& weights,
+                arma::mat& condProb) const
+{
+  ComponentLogProbabilities(observations, means, covariances, weights,
+      condProb);
+
+  // Normalize row-wise, in log-space.  The normalizing constant of each row is
+  // the log-likelihood of that point.
+  arma::vec logLikelihoods;
+  math::LogSumExp(condProb, logLikelihoods);
+
+  condProb = exp(condProb - logLikelihoods *
+      arma::ones<arma::rowvec>(condProb.n_cols));
 
-  // Now sum over every point.
-  for (size_t j = 0; j < observations.n_cols; ++j)
+  // Avoid dividing by zero; if the probability for everything is 0, we don't
+  // want to make it NaN.
+  for (size_t j = 0; j < condProb.n_rows; ++j)
   {
-    if (accu(likelihoods.col(j)) == 0)
+    if (logLikelihoods[j] == -std::numeric_limits<double>::infinity())
+    {
       Log::Info << "Likelihood of point " << j << " is 0!  It is probably an "
           << "outlier." << std::endl;
-    logLikelihood += log(accu(likelihoods.col(j)));
+      condProb.row(j).zeros();
+    }
+  }
+
+  return accu(logLikelihoods);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+size_t EMFit<InitialClusteringType, CovarianceConstraintPolicy>::PeakMemory(
+    const size_t points,
+    const size_t dimensionality,
+    const size_t gaussians) const
+{
+  // The tree E-step keeps a copy of the observations, and the bound,
+  // centroid and scatter of each node (with leaves of 20 points, there are
+  // fewer than points / 10 nodes).
+  if (useTree)
+    return MemoryBudget::MatrixBytes<double>(dimensionality, points) +
+        (points / 10 + 1) * MemoryBudget::MatrixBytes<double>(dimensionality,
+        dimensionality + 3);
+
+  // The serial E-step and M-step keep the responsibilities (and their
+  // logarithms), and the centered and weighted observations.
+  if (!UseBlocks(points, dimensionality, gaussians))
+    return MemoryBudget::MatrixBytes<double>(points,
+        2 * gaussians + 3 * dimensionality);
+
+  // Each block being processed keeps its responsibilities, its centered
+  // observations and a temporary of the same size, and its statistics.
+  const size_t workers = NumWorkers(points);
+  const size_t blocks = NumBlocks(points, dimensionality, gaussians);
+  const size_t blockPoints = (points + blocks - 1) / blocks;
+  return workers * MemoryBudget::MatrixBytes<double>(blockPoints,
+      gaussians + 3 * dimensionality + 2) + (workers + 1) * gaussians *
+      MemoryBudget::MatrixBytes<double>(dimensionality + 1,
+      ScatterColumns(dimensionality));
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+bool EMFit<InitialClusteringType, CovarianceConstraintPolicy>::UseBlocks(
+    const size_t points,
+    const size_t dimensionality,
+    const size_t gaussians) const
+{
+  if (threads != 1 || comm != NULL)
+    return true;
+
+  return !MemoryBudget::Fits(MemoryBudget::MatrixBytes<double>(points,
+      2 * gaussians + 3 * dimensionality));
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+size_t EMFit<InitialClusteringType, CovarianceConstraintPolicy>::NumWorkers(
+    const size_t points) const
+{
+  const size_t workers = Threads::Count(threads);
+  return std::max(std::min(workers, points), (size_t) 1);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+size_t EMFit<InitialClusteringType, CovarianceConstraintPolicy>::NumBlocks(
+    const size_t points,
+    const size_t dimensionality,
+    const size_t gaussians) const
+{
+  const size_t workers = NumWorkers(points);
+
+  // The statistics of every block of a round (and the merged ones) are kept,
+  // whatever the size of the blocks.
+  const size_t statistics = (workers + 1) * gaussians *
+      MemoryBudget::MatrixBytes<double>(dimensionality + 1,
+      ScatterColumns(dimensionality));
+  const size_t blockPoints = MemoryBudget::BlockColumns(workers *
+      MemoryBudget::MatrixBytes<double>(gaussians + 3 * dimensionality + 2, 1),
+      points, statistics);
+
+  return std::max(workers, (points + blockPoints - 1) / blockPoints);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ParallelEstimate(const arma::mat& observations,
+                 const arma::vec& probabilities,
+                 std::vector<arma::vec>& means,
+                 std::vector<arma::mat>& covariances,
+                 arma::vec& weights,
+                 const TreeType* tree)
+{
+  // Sufficient statistics for the M-step, filled by the E-step.
+  arma::vec probSums;
+  std::vector<arma::vec> sums;
+  std::vector<arma::mat> outerProducts;
+
+  double l = (tree != NULL) ?
+      TreeExpectationStep(*tree, means, covariances, weights, probSums, sums,
+          outerProducts) :
+      ParallelExpectationStep(observations, probabilities, means, covariances,
+          weights, probSums, sums, outerProducts);
+  Reduce(probSums, sums, outerProducts, l);
+
+  // The total probability of the observations (on every rank).
+  double totalProbability = accu(probabilities);
+  if (comm != NULL)
+    comm->Sum(&totalProbability, 1);
+
+  Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
+      << l << std::endl;
+
+  double lOld = -DBL_MAX;
+
+  // Iterate to update the model until no more improvement is found.
+  size_t iteration = 1;
+  while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
+  {
+    Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
+        << "log-likelihood " << l << "." << std::endl;
+
+    for (size_t i = 0; i < means.size(); i++)
+    {
+      // Don't update if there's no probability of the Gaussian having points.
+      if (probSums[i] != 0.0)
+      {
+        // The statistics are relative to the old mean.
+        const arma::vec meanShift = sums[i] / probSums[i];
+        means[i] += meanShift;
+
+        if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+        {
+          SetCovariance(outerProducts[i] / probSums[i] -
+              meanShift % meanShift, covariances[i]);
+        }
+        else
+        {
+          covariances[i] = outerProducts[i] / probSums[i] -
+              meanShift * trans(meanShift);
+          covariances[i] = 0.5 * (covariances[i] + trans(covariances[i]));
+        }
+      }
+
+      // Apply covariance constraint.
+      constraint.ApplyConstraint(covariances[i]);
+    }
+
+    // Calculate the new values for omega using the updated conditional
+    // probabilities.
+    weights = probSums / totalProbability;
+
+    // Update values of l; calculate new log-likelihood and the statistics for
+    // the next iteration.
+    lOld = l;
+    l = (tree != NULL) ?
+        TreeExpectationStep(*tree, means, covariances, weights, probSums, sums,
+            outerProducts) :
+        ParallelExpectationStep(observations, probabilities, means,
+            covariances, weights, probSums, sums, outerProducts);
+    Reduce(probSums, sums, outerProducts, l);
+
+    iteration++;
+
+    // The monitor may stop EM after any iteration, keeping the current model.
+    if (monitor && !monitor->Continue("EMFit::Estimate()", iteration - 1, l))
+      break;
+  }
+
+  iterations = iteration - 1;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Reduce(
+    arma::vec& probSums,
+    std::vector<arma::vec>& sums,
+    std::vector<arma::mat>& outerProducts,
+    double& logLikelihood) const
+{
+  if (comm == NULL)
+    return;
+
+  // Pack everything into one buffer, so there is one collective call for each
+  // iteration.
+  size_t size = probSums.n_elem + 1;
+  for (size_t i = 0; i < sums.size(); ++i)
+    size += sums[i].n_elem + outerProducts[i].n_elem;
+
+  arma::vec buffer(size);
+  size_t position = 0;
+  buffer[position++] = logLikelihood;
+  for (size_t j = 0; j < probSums.n_elem; ++j)
+    buffer[position++] = probSums[j];
+  for (size_t i = 0; i < sums.size(); ++i)
+  {
+    std::copy(sums[i].begin(), sums[i].end(), buffer.begin() + position);
+    position += sums[i].n_elem;
+    std::copy(outerProducts[i].begin(), outerProducts[i].end(),
+        buffer.begin() + position);
+    position += outerProducts[i].n_elem;
+  }
+
+  comm->Sum(buffer.memptr(), buffer.n_elem);
+
+  position = 0;
+  logLikelihood = buffer[position++];
+  for (size_t j = 0; j < probSums.n_elem; ++j)
+    probSums[j] = buffer[position++];
+  for (size_t i = 0; i < sums.size(); ++i)
+  {
+    std::copy(buffer.begin() + position, buffer.begin() + position +
+        sums[i].n_elem, sums[i].begin());
+    position += sums[i].n_elem;
+    std::copy(buffer.begin() + position, buffer.begin() + position +
+        outerProducts[i].n_elem, outerProducts[i].begin());
+    position += outerProducts[i].n_elem;
+  }
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ParallelExpectationStep(const arma::mat& observations,
+                        const arma::vec& probabilities,
+                        const std::vector<arma::vec>& means,
+                        const std::vector<arma::mat>& covariances,
+                        const arma::vec& weights,
+                        arma::vec& probSums,
+                        std::vector<arma::vec>& sums,
+                        std::vector<arma::mat>& outerProducts) const
+{
+  const size_t gaussians = means.size();
+  const size_t dimension = observations.n_rows;
+
+  // Decide how many blocks to split the observations into.  This does not
+  // depend on whether OpenMP is available, so the result is the same either
+  // way.
+  const size_t workers = NumWorkers(observations.n_cols);
+  const size_t blocks = NumBlocks(observations.n_cols, dimension, gaussians);
+
+  // Build each Gaussian and factorize its covariance now, before the
+  // distributions are shared between threads.
+  std::vector<distribution::GaussianDistribution> dists;
+  dists.reserve(gaussians);
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    dists.push_back(distribution::GaussianDistribution(means[i],
+        covariances[i]));
+    dists[i].FactorCovariance();
+  }
+  const arma::vec logWeights = log(weights);
+
+  // The merged statistics.
+  probSums.zeros(gaussians);
+  sums.assign(gaussians, arma::zeros<arma::vec>(dimension));
+  outerProducts.assign(gaussians, arma::zeros<arma::mat>(dimension,
+      ScatterColumns(dimension)));
+  double logLikelihood = 0;
+
+  // Per-block results of one round of blocks.  These are merged in block order
+  // after each round, so the result does not depend on the number of workers.
+  arma::vec blockLogLikelihoods(workers);
+  arma::mat blockProbSums(gaussians, workers);
+  std::vector<std::vector<arma::vec> > blockSums(workers);
+  std::vector<std::vector<arma::mat> > blockOuterProducts(workers);
+
+  for (size_t first = 0; first < blocks; first += workers)
+  {
+    const size_t roundBlocks = std::min(workers, blocks - first);
+
+    #pragma omp parallel for num_threads(roundBlocks) schedule(static)
+    for (int r = 0; r < (int) roundBlocks; ++r)
+    {
+      const size_t b = first + (size_t) r;
+      const size_t begin = b * observations.n_cols / blocks;
+      const size_t end = (b + 1) * observations.n_cols / blocks;
+      const size_t count = end - begin;
+
+      // Alias the block of observations (and their probabilities) so that we
+      // don't copy them.
+      const arma::mat block(const_cast<double*>(observations.colptr(begin)),
+          dimension, count, false, true);
+      const arma::vec blockProbabilities(const_cast<double*>(
+          probabilities.memptr() + begin), count, false, true);
+
+      // E-step on this block, in log-space.
+      arma::mat condProb(count, gaussians);
+      for (size_t i = 0; i < gaussians; ++i)
+      {
+        arma::vec condProbAlias = condProb.unsafe_col(i);
+        dists[i].LogProbability(block, condProbAlias);
+        condProbAlias += logWeights[i];
+      }
+
+      arma::vec logLikelihoods;
+      math::LogSumExp(condProb, logLikelihoods);
+
+      condProb = exp(condProb - logLikelihoods *
+          arma::ones<arma::rowvec>(gaussians));
+
+      // Points with zero probability under every Gaussian don't contribute.
+      for (size_t j = 0; j < count; ++j)
+        if (logLikelihoods[j] == -std::numeric_limits<double>::infinity())
+          condProb.row(j).zeros();
+
+      blockLogLikelihoods[r] = accu(logLikelihoods);
+
+      // Take into account the probability of each point being from this
+      // mixture.
+      condProb %= blockProbabilities * arma::ones<arma::rowvec>(gaussians);
+      blockProbSums.col(r) = trans(arma::sum(condProb, 0 /* columnwise */));
+
+      // Accumulate the weighted sums and outer products about the current
+      // means.
+      blockSums[r].resize(gaussians);
+      blockOuterProducts[r].resize(gaussians);
+      for (size_t i = 0; i < gaussians; ++i)
+      {
+        const arma::mat centered = block - (means[i] *
+            arma::ones<arma::rowvec>(count));
+
+        blockSums[r][i] = centered * condProb.col(i);
+        Scatter(centered, condProb.col(i), blockOuterProducts[r][i]);
+      }
+    }
+
+    // Merge the statistics of this round, always in the same order.
+    for (size_t r = 0; r < roundBlocks; ++r)
+    {
+      logLikelihood += blockLogLikelihoods[r];
+      probSums += blockProbSums.col(r);
+
+      for (size_t i = 0; i < gaussians; ++i)
+      {
+        sums[i] += blockSums[r][i];
+        outerProducts[i] += blockOuterProducts[r][i];
+      }
+    }
   }
 
   return logLikelihood;
 }
 
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+TreeExpectationStep(const TreeType& tree,
+                    const std::vector<arma::vec>& means,
+                    const std::vector<arma::mat>& covariances,
+                    const arma::vec& weights,
+                    arma::vec& probSums,
+                    std::vector<arma::vec>& sums,
+                    std::vector<arma::mat>& outerProducts) const
+{
+  const size_t gaussians = means.size();
+  const size_t dimension = tree.Dataset().n_rows;
+
+  // Factorize each Gaussian, and find what is needed to bound its density over
+  // the nodes of the tree.
+  std::vector<TreeComponent> components(gaussians);
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    TreeComponent& component = components[i];
+    component.gaussian = distribution::GaussianDistribution(means[i],
+        covariances[i]);
+    component.gaussian.FactorCovariance();
+    component.logWeight = log(weights[i]);
+
+    double logDet = 0.0;
+    if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+    {
+      const arma::vec variances = covariances[i].diag();
+      component.bounded = (arma::min(variances) > 0.0);
+      if (component.bounded)
+      {
+        component.scales = 1.0 / variances;
+        logDet = arma::accu(log(variances));
+      }
+    }
+    else
+    {
+      // The Mahalanobis distance to a box is bounded by the Euclidean distance
+      // scaled by the extreme eigenvalues of the inverse covariance.
+      arma::vec eigenvalues;
+      arma::mat eigenvectors;
+      component.bounded = arma::eig_sym(eigenvalues, eigenvectors,
+          covariances[i]) && (arma::min(eigenvalues) > 0.0);
+      if (component.bounded)
+      {
+        component.minScale = 1.0 / arma::max(eigenvalues);
+        component.maxScale = 1.0 / arma::min(eigenvalues);
+        component.invCovariance = eigenvectors * arma::diagmat(1.0 /
+            eigenvalues) * trans(eigenvectors);
+        logDet = arma::accu(log(eigenvalues));
+      }
+    }
+
+    component.logConstant = component.logWeight - 0.5 * (dimension *
+        log(2 * M_PI) + logDet);
+  }
+
+  probSums.zeros(gaussians);
+  sums.assign(gaussians, arma::zeros<arma::vec>(dimension));
+  outerProducts.assign(gaussians, arma::zeros<arma::mat>(dimension,
+      ScatterColumns(dimension)));
+
+  // Every component may own points of the root.
+  std::vector<size_t> active(gaussians);
+  for (size_t i = 0; i < gaussians; ++i)
+    active[i] = i;
+
+  return TreeExpectationStep(tree, components, active, probSums, sums,
+      outerProducts);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+TreeExpectationStep(const TreeType& node,
+                    const std::vector<TreeComponent>& components,
+                    const std::vector<size_t>& active,
+                    arma::vec& probSums,
+                    std::vector<arma::vec>& sums,
+                    std::vector<arma::mat>& outerProducts) const
+{
+  if (node.Count() == 0)
+    return 0.0;
+
+  // The components whose responsibility for some point of the node may be
+  // more than the tolerance, and the largest error of the responsibilities if
+  // the node is approximated.
+  std::vector<size_t> owners;
+  double error = 1.0;
+
+  bool bounded = true;
+  for (size_t a = 0; a < active.size(); ++a)
+    bounded &= components[active[a]].bounded;
+
+  if (bounded)
+  {
+    arma::vec lower(active.size());
+    arma::vec upper(active.size());
+    for (size_t a = 0; a < active.size(); ++a)
+      LogDensityBounds(node.Bound(), components[active[a]], lower[a],
+          upper[a]);
+
+    // The responsibility of a component is smallest when its density is as
+    // small as possible and every other density is as large as possible (and
+    // conversely).
+    arma::vec minResponsibility(active.size());
+    arma::vec maxResponsibility(active.size());
+    for (size_t a = 0; a < active.size(); ++a)
+    {
+      double othersUpper = -std::numeric_limits<double>::infinity();
+      double othersLower = -std::numeric_limits<double>::infinity();
+      for (size_t b = 0; b < active.size(); ++b)
+      {
+        if (b != a)
+        {
+          othersUpper = math::LogAdd(othersUpper, upper[b]);
+          othersLower = math::LogAdd(othersLower, lower[b]);
+        }
+      }
+
+      minResponsibility[a] = exp(lower[a] - math::LogAdd(lower[a],
+          othersUpper));
+      maxResponsibility[a] = exp(upper[a] - math::LogAdd(upper[a],
+          othersLower));
+    }
+
+    // Drop the components which own (nearly) nothing here, but keep at least
+    // the most likely one.
+    error = 0.0;
+    for (size_t a = 0; a < active.size(); ++a)
+    {
+      if (maxResponsibility[a] > treeTolerance)
+      {
+        owners.push_back(active[a]);
+        error = std::max(error, maxResponsibility[a] - minResponsibility[a]);
+      }
+    }
+
+    if (owners.empty())
+    {
+      arma::uword best;
+      maxResponsibility.max(best);
+      owners.push_back(active[best]);
+    }
+  }
+  else
+  {
+    owners = active;
+  }
+
+  const size_t dimension = node.Dataset().n_rows;
+  const size_t count = node.Count();
+
+  if (error <= treeTolerance)
+  {
+    // Every point of the node gets the responsibilities of the centroid, so
+    // the node is added to the statistics at once.
+    const arma::vec& centroid = node.Stat().Centroid();
+    const arma::mat& scatter = node.Stat().Scatter();
+
+    arma::vec logProbs(owners.size());
+    for (size_t a = 0; a < owners.size(); ++a)
+      logProbs[a] = components[owners[a]].logWeight +
+          components[owners[a]].gaussian.LogProbability(centroid);
+
+    double logSum = -std::numeric_limits<double>::infinity();
+    for (size_t a = 0; a < owners.size(); ++a)
+      logSum = math::LogAdd(logSum, logProbs[a]);
+
+    double logLikelihood = 0.0;
+    for (size_t a = 0; a < owners.size(); ++a)
+    {
+      const size_t i = owners[a];
+      const double responsibility = exp(logProbs[a] - logSum);
+      if (responsibility == 0.0)
+        continue;
+
+      const arma::vec shift = centroid - components[i].gaussian.Mean();
+      probSums[i] += responsibility * count;
+      sums[i] += (responsibility * count) * shift;
+
+      // The sum of the squared Mahalanobis distances of the points is
+      // tr(covariance^-1 * scatter) plus count times that of the centroid.
+      double spread;
+      if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+      {
+        outerProducts[i] += responsibility * (scatter.diag() + count *
+            (shift % shift));
+        spread = arma::dot(components[i].scales, scatter.diag());
+      }
+      else
+      {
+        outerProducts[i] += responsibility * (scatter + count *
+            (shift * trans(shift)));
+        spread = arma::accu(components[i].invCovariance % scatter);
+      }
+
+      // log p(x) = log(w_i p_i(x)) - log(r_i(x)) for every component i, so it
+      // is also their average weighted by the responsibilities.
+      logLikelihood += responsibility * (count * (logProbs[a] -
+          log(responsibility)) - 0.5 * spread);
+    }
+
+    return logLikelihood;
+  }
+
+  if (!node.IsLeaf())
+    return TreeExpectationStep(*node.Left(), components, owners, probSums,
+        sums, outerProducts) + TreeExpectationStep(*node.Right(), components,
+        owners, probSums, sums, outerProducts);
+
+  // Evaluate the points of the leaf exactly, under the remaining components.
+  const arma::mat block(const_cast<double*>(node.Dataset().colptr(
+      node.Begin())), dimension, count, false, true);
+
+  arma::mat condProb(count, owners.size());
+  for (size_t a = 0; a < owners.size(); ++a)
+  {
+    arma::vec condProbAlias = condProb.unsafe_col(a);
+    components[owners[a]].gaussian.LogProbability(block, condProbAlias);
+    condProbAlias += components[owners[a]].logWeight;
+  }
+
+  arma::vec logLikelihoods;
+  math::LogSumExp(condProb, logLikelihoods);
+
+  condProb = exp(condProb - logLikelihoods *
+      arma::ones<arma::rowvec>(owners.size()));
+
+  // Points with zero probability under every Gaussian don't contribute.
+  for (size_t j = 0; j < count; ++j)
+    if (logLikelihoods[j] == -std::numeric_limits<double>::infinity())
+      condProb.row(j).zeros();
+
+  for (size_t a = 0; a < owners.size(); ++a)
+  {
+    const size_t i = owners[a];
+    const arma::mat centered = block - (components[i].gaussian.Mean() *
+        arma::ones<arma::rowvec>(count));
+
+    arma::mat scatter;
+    Scatter(centered, condProb.col(a), scatter);
+
+    probSums[i] += arma::accu(condProb.col(a));
+    sums[i] += centered * condProb.col(a);
+    outerProducts[i] += scatter;
+  }
+
+  return arma::accu(logLikelihoods);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+LogDensityBounds(const bound::HRectBound<2>& bound,
+                 const TreeComponent& component,
+                 double& lower,
+                 double& upper)
+{
+  const arma::vec& mean = component.gaussian.Mean();
+
+  // Bound the squared Mahalanobis distance from the mean to the box, one
+  // dimension at a time.
+  double minDistance = 0.0;
+  double maxDistance = 0.0;
+  for (size_t j = 0; j < mean.n_elem; ++j)
+  {
+    const double below = bound.Lo()[j] - mean[j];
+    const double above = bound.Hi()[j] - mean[j];
+
+    // The mean may be inside the range of the box in this dimension.
+    const double nearest = (below > 0.0) ? below * below :
+        ((above < 0.0) ? above * above : 0.0);
+    const double farthest = std::max(below * below, above * above);
+
+    if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+    {
+      minDistance += component.scales[j] * nearest;
+      maxDistance += component.scales[j] * farthest;
+    }
+    else
+    {
+      minDistance += nearest;
+      maxDistance += farthest;
+    }
+  }
+
+  if (!ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+  {
+    minDistance *= component.minScale;
+    maxDistance *= component.maxScale;
+  }
+
+  lower = component.logConstant - 0.5 * maxDistance;
+  upper = component.logConstant - 0.5 * minDistance;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Scatter(
+    const arma::mat& centered,
+    const arma::vec& weights,
+    arma::mat& scatter)
+{
+  if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+    scatter = (centered % centered) * weights;
+  else
+    scatter = (centered % (arma::ones<arma::vec>(centered.n_rows) *
+        trans(weights))) * trans(centered);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+size_t EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ScatterColumns(const size_t dimensionality)
+{
+  return ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal ? 1 :
+      dimensionality;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::SetCovariance(
+    const arma::mat& scatter,
+    arma::mat& covariance)
+{
+  if (ConstraintTraits<CovarianceConstraintPolicy>::IsDiagonal)
+  {
+    const arma::vec variances = scatter.col(0);
+    covariance = arma::diagmat(variances);
+  }
+  else
+  {
+    covariance = scatter;
+  }
+}
+
 }; // namespace gmm
 }; // namespace mlpack
 
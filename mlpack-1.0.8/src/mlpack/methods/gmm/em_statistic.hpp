@@ -0,0 +1,111 @@
+/**
+ * @file em_statistic.hpp
+ *
+ * The statistic of the kd-tree nodes used by the tree-based E-step of EMFit:
+ * the centroid and the scatter of the points of each node.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_GMM_EM_STATISTIC_HPP
+#define __MLPACK_METHODS_GMM_EM_STATISTIC_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * Statistic for the kd-tree of EMFit::UseTree(), which, like MRKDStatistic for
+ * k-means, caches the sufficient statistics of the points of each node: their
+ * centroid, and their scatter about it, sum_j (x_j - c) * (x_j - c)^T.  With
+ * these, the contribution of a node to the M-step can be computed at once when
+ * the responsibilities of all its points are (nearly) the same.
+ */
+class EMStatistic
+{
+ public:
+  //! Initialize an empty statistic.
+  EMStatistic() { }
+
+  /**
+   * This constructor is called when a node is finished initializing, after its
+   * children (if any) have been built.  For a leaf, the statistics are
+   * calculated from the points; otherwise, they are combined from the
+   * statistics of the children.
+   *
+   * @param node The node that has been finished.
+   */
+  template<typename TreeType>
+  EMStatistic(const TreeType& node);
+
+  //! Get the centroid of the points of the node.
+  const arma::vec& Centroid() const { return centroid; }
+  //! Modify the centroid of the points of the node.
+  arma::vec& Centroid() { return centroid; }
+
+  //! Get the scatter of the points of the node about their centroid.
+  const arma::mat& Scatter() const { return scatter; }
+  //! Modify the scatter of the points of the node about their centroid.
+  arma::mat& Scatter() { return scatter; }
+
+ private:
+  //! The centroid of the points.
+  arma::vec centroid;
+  //! The scatter of the points about the centroid.
+  arma::mat scatter;
+};
+
+template<typename TreeType>
+EMStatistic::EMStatistic(const TreeType& node)
+{
+  const size_t dimension = node.Dataset().n_rows;
+  centroid.zeros(dimension);
+  scatter.zeros(dimension, dimension);
+
+  if (node.Count() == 0)
+    return;
+
+  if (node.NumChildren() == 0)
+  {
+    const arma::mat points = node.Dataset().cols(node.Begin(),
+        node.Begin() + node.Count() - 1);
+    centroid = arma::mean(points, 1);
+
+    const arma::mat centered = points - (centroid *
+        arma::ones<arma::rowvec>(node.Count()));
+    scatter = centered * trans(centered);
+  }
+  else
+  {
+    // The scatter of the union is the sum of the scatters of the children,
+    // each moved to the new centroid.
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+      centroid += node.Child(i).Count() * node.Child(i).Stat().Centroid();
+    centroid /= node.Count();
+
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      const arma::vec shift = node.Child(i).Stat().Centroid() - centroid;
+      scatter += node.Child(i).Stat().Scatter() + node.Child(i).Count() *
+          (shift * trans(shift));
+    }
+  }
+}
+
+}; // namespace gmm
+}; // namespace mlpack
+
+#endif
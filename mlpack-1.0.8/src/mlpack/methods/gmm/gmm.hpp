@@ -99,6 +99,9 @@ class GMM
   std::vector<arma::mat> covariances;
   //! Vector of a priori weights for each Gaussian.
   arma::vec weights;
+  //! Number of trials of Estimate() to run at once; 1 is serial, 0 is all
+  //! cores.
+  size_t threads;
 
  public:
   /**
@@ -107,6 +110,7 @@ class GMM
   GMM() :
       gaussians(0),
       dimensionality(0),
+      threads(1),
       localFitter(FittingType()),
       fitter(localFitter)
   {
@@ -130,6 +134,7 @@ class GMM
       means(gaussians, arma::vec(dimensionality)),
       covariances(gaussians, arma::mat(dimensionality, dimensionality)),
       weights(gaussians),
+      threads(1),
       localFitter(FittingType()),
       fitter(localFitter) { /* Nothing to do. */ }
 
@@ -151,6 +156,7 @@ class GMM
       means(gaussians, arma::vec(dimensionality)),
       covariances(gaussians, arma::mat(dimensionality, dimensionality)),
       weights(gaussians),
+      threads(1),
       fitter(fitter) { /* Nothing to do. */ }
 
   /**
@@ -168,6 +174,7 @@ class GMM
       means(means),
       covariances(covariances),
       weights(weights),
+      threads(1),
       localFitter(FittingType()),
       fitter(localFitter) { /* Nothing to do. */ }
 
@@ -189,6 +196,7 @@ class GMM
       means(means),
       covariances(covariances),
       weights(weights),
+      threads(1),
       fitter(fitter) { /* Nothing to do. */ }
 
   /**
@@ -216,17 +224,18 @@ class GMM
   GMM& operator=(const GMM& other);
 
   /**
-   * Load a GMM from an XML file.  The format of the XML file should be the same
-   * as is generated by the Save() method.
+   * Load a GMM from an XML or binary file.  The format of the file should be
+   * the same as is generated by the Save() method.
    *
-   * @param filename Name of XML file containing model to be loaded.
+   * @param filename Name of file containing model to be loaded.
    */
   void Load(const std::string& filename);
 
   /**
-   * Save a GMM to an XML file.
+   * Save a GMM to an XML file, or to a binary file if the extension of the
+   * filename is ".bin" (see util::SaveRestoreUtility).
    *
-   * @param filename Name of XML file to write to.
+   * @param filename Name of file to write to.
    */
   void Save(const std::string& filename) const;
 
@@ -257,6 +266,15 @@ class GMM
   //! Return a reference to the a priori weights of each Gaussian.
   arma::vec& Weights() { return weights; }
 
+  //! Get the number of trials of Estimate(), or of blocks of observations
+  //! scored by Classify() and LogLikelihood(), run at once (1 is serial, 0 is
+  //! all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of trials of Estimate(), or of blocks of observations
+  //! scored by Classify() and LogLikelihood(), run at once (1 is serial, 0 is
+  //! all cores).
+  size_t& Threads() { return threads; }
+
   //! Return a const reference to the fitting type.
   const FittingType& Fitter() const { return fitter; }
   //! Return a reference to the fitting type.
@@ -280,6 +298,28 @@ class GMM
   double Probability(const arma::vec& observation,
                      const size_t component) const;
 
+  /**
+   * Calculate the probability of each observation (column) in the given
+   * matrix being from this distribution.  The observations are scored in
+   * blocks, as with LogLikelihood().
+   *
+   * @param observations List of observations.
+   * @param probabilities Output probabilities for each input observation.
+   */
+  void Probability(const arma::mat& observations,
+                   arma::vec& probabilities) const;
+
+  /**
+   * Return the log-likelihood of the given observations under this model.  The
+   * covariance of each Gaussian is factorized once; then the observations are
+   * scored in blocks, up to Threads() of them at once (this requires MLPACK to
+   * be built with OpenMP), with blocks small enough that the log-densities of
+   * the blocks processed at once fit in the MemoryBudget.
+   *
+   * @param observations List of observations.
+   */
+  double LogLikelihood(const arma::mat& observations) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -301,6 +341,16 @@ class GMM
    * is deterministic after the initial position is given, then 'trials' should
    * be set to 1.
    *
+   * The trials are independent: up to Threads() of them are run at once,
+   * each with its own copy of the fitter (which then runs serially), and each
+   * draws its random numbers from its own stream (see
+   * math::ScopedThreadStream).  If two trials give the same log-likelihood,
+   * the first is kept.
+   *
+   * If the fitter has a ProgressMonitor (see EMFit::Monitor()), the trials are
+   * run one after another; if the monitor stops a trial, no further trials are
+   * run, and the best model so far is kept.
+   *
    * @tparam FittingType The type of fitting method which should be used
    *     (EMFit<> is suggested).
    * @param observations Observations of the model.
@@ -329,6 +379,8 @@ class GMM
    * is deterministic after the initial position is given, then 'trials' should
    * be set to 1.
    *
+   * The trials are run as with the other overload of Estimate().
+   *
    * @param observations Observations of the model.
    * @param probabilities Probability of each observation being from this
    *     distribution.
@@ -356,6 +408,8 @@ class GMM
    * double priorWeight = gmm.Weights()[2];
    * @endcode
    *
+   * The observations are scored in blocks, as with LogLikelihood().
+   *
    * @param observations List of observations to classify.
    * @param labels Object which will be filled with labels.
    */
@@ -377,6 +431,86 @@ class GMM
                        const std::vector<arma::mat>& covars,
                        const arma::vec& weights) const;
 
+  /**
+   * Score the given observations under the given model, one block of
+   * observations at a time, with up to Threads() blocks at once.  For each
+   * block, log(w_i) + log(p_i(x_j)) is computed for every component i (see
+   * GaussianDistribution::LogProbability()), and reduced to the
+   * log-likelihood and the most likely component of each observation.
+   *
+   * @param dataPoints Observations to score.
+   * @param means Means of the given mixture model.
+   * @param covars Covariances of the given mixture model.
+   * @param weights Weights of the given mixture model.
+   * @param logLikelihoods If not NULL, filled with the log-likelihood of each
+   *     observation.
+   * @param labels If not NULL, filled with the most likely component of each
+   *     observation.
+   */
+  void Score(const arma::mat& dataPoints,
+             const std::vector<arma::vec>& means,
+             const std::vector<arma::mat>& covars,
+             const arma::vec& weights,
+             arma::vec* logLikelihoods,
+             arma::Col<size_t>* labels) const;
+
+  /**
+   * Run the trials of Estimate(), weighting the observations by the given
+   * probabilities if they are not NULL, and keep the best model.
+   *
+   * @param observations Observations of the model.
+   * @param probabilities Probability of each observation (may be NULL).
+   * @param trials Number of trials to perform.
+   * @param useExistingModel If true, each trial starts from the existing
+   *     model.
+   * @return The log-likelihood of the best fit.
+   */
+  double EstimateTrials(const arma::mat& observations,
+                        const arma::vec* probabilities,
+                        const size_t trials,
+                        const bool useExistingModel);
+
+  /**
+   * Fit the given model with the given fitter, weighting the observations by
+   * the given probabilities if they are not NULL, and return the
+   * log-likelihood of the fitted model.
+   */
+  double Fit(FittingType& trialFitter,
+             const arma::mat& observations,
+             const arma::vec* probabilities,
+             std::vector<arma::vec>& means,
+             std::vector<arma::mat>& covariances,
+             arma::vec& weights,
+             const bool useExistingModel) const;
+
+  HAS_MEM_FUNC(Monitor, HasMonitorSignature)
+
+  //! Return the ProgressMonitor of the fitter, for fitters with a Monitor()
+  //! (such as EMFit).
+  template<typename T>
+  static ProgressMonitor* FitterMonitor(const T& fitter,
+      typename boost::enable_if_c<HasMonitorSignature<T,
+          ProgressMonitor*(T::*)() const>::value>::type* = 0)
+  {
+    return fitter.Monitor();
+  }
+
+  //! Fitters without a Monitor() have no monitor.
+  template<typename T>
+  static ProgressMonitor* FitterMonitor(const T& /* fitter */,
+      typename boost::disable_if_c<HasMonitorSignature<T,
+          ProgressMonitor*(T::*)() const>::value>::type* = 0)
+  {
+    return NULL;
+  }
+
+  //! Return whether the fitter was stopped by its ProgressMonitor.
+  template<typename T>
+  static bool FitterStopped(const T& fitter)
+  {
+    return (FitterMonitor(fitter) != NULL) && FitterMonitor(fitter)->Stopped();
+  }
+
   //! Locally-stored fitting object; in case the user did not pass one.
   FittingType localFitter;
 
@@ -40,6 +40,7 @@ GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
     means(other.Means()),
     covariances(other.Covariances()),
     weights(other.Weights()),
+    threads(other.Threads()),
     localFitter(FittingType()),
     fitter(localFitter) { /* Nothing to do. */ }
 
@@ -51,6 +52,7 @@ GMM<FittingType>::GMM(const GMM<FittingType>& other) :
     means(other.Means()),
     covariances(other.Covariances()),
     weights(other.Weights()),
+    threads(other.Threads()),
     localFitter(other.Fitter()),
     fitter(localFitter) { /* Nothing to do. */ }
 
@@ -64,6 +66,7 @@ GMM<FittingType>& GMM<FittingType>::operator=(
   means = other.Means();
   covariances = other.Covariances();
   weights = other.Weights();
+  threads = other.Threads();
 
   return *this;
 }
@@ -76,6 +79,7 @@ GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
   means = other.Means();
   covariances = other.Covariances();
   weights = other.Weights();
+  threads = other.Threads();
   localFitter = other.Fitter();
 
   return *this;
@@ -152,7 +156,7 @@ double GMM<FittingType>::Probability(const arma::vec& observation) const
   // multiply by the prior for each Gaussian too).
   double sum = 0;
   for (size_t i = 0; i < gaussians; i++)
-    sum += weights[i] * phi(observation, means[i], covariances[i]);
+    sum += Probability(observation, i);
 
   return sum;
 }
@@ -165,10 +169,31 @@ template<typename FittingType>
 double GMM<FittingType>::Probability(const arma::vec& observation,
                                      const size_t component) const
 {
-  // We are only considering one Gaussian component -- so we only need to call
-  // phi() once.  We do consider the prior probability!
-  return weights[component] *
-      phi(observation, means[component], covariances[component]);
+  // We are only considering one Gaussian component.  We do consider the prior
+  // probability!  GaussianDistribution evaluates diagonal covariances in O(d).
+  return weights[component] * distribution::GaussianDistribution(
+      means[component], covariances[component]).Probability(observation);
+}
+
+/**
+ * Return the probability of each of the given observations being from this
+ * GMM.
+ */
+template<typename FittingType>
+void GMM<FittingType>::Probability(const arma::mat& observations,
+                                   arma::vec& probabilities) const
+{
+  Score(observations, means, covariances, weights, &probabilities, NULL);
+  probabilities = exp(probabilities);
+}
+
+/**
+ * Return the log-likelihood of the given observations under this GMM.
+ */
+template<typename FittingType>
+double GMM<FittingType>::LogLikelihood(const arma::mat& observations) const
+{
+  return LogLikelihood(observations, means, covariances, weights);
 }
 
 /**
@@ -193,8 +218,8 @@ arma::vec GMM<FittingType>::Random() const
     }
   }
 
-  return trans(chol(covariances[gaussian])) *
-      arma::randn<arma::vec>(dimensionality) + means[gaussian];
+  return distribution::GaussianDistribution(means[gaussian],
+      covariances[gaussian]).Random();
 }
 
 /**
@@ -205,85 +230,7 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
                                   const size_t trials,
                                   const bool useExistingModel)
 {
-  double bestLikelihood; // This will be reported later.
-
-  // We don't need to store temporary models if we are only doing one trial.
-  if (trials == 1)
-  {
-    // Train the model.  The user will have been warned earlier if the GMM was
-    // initialized with no parameters (0 gaussians, dimensionality of 0).
-    fitter.Estimate(observations, means, covariances, weights,
-        useExistingModel);
-
-    bestLikelihood = LogLikelihood(observations, means, covariances, weights);
-  }
-  else
-  {
-    if (trials == 0)
-      return -DBL_MAX; // It's what they asked for...
-
-    // If each trial must start from the same initial location, we must save it.
-    std::vector<arma::vec> meansOrig;
-    std::vector<arma::mat> covariancesOrig;
-    arma::vec weightsOrig;
-    if (useExistingModel)
-    {
-      meansOrig = means;
-      covariancesOrig = covariances;
-      weightsOrig = weights;
-    }
-
-    // We need to keep temporary copies.  We'll do the first training into the
-    // actual model position, so that if it's the best we don't need to copy it.
-    fitter.Estimate(observations, means, covariances, weights,
-        useExistingModel);
-
-    bestLikelihood = LogLikelihood(observations, means, covariances, weights);
-
-    Log::Info << "GMM::Estimate(): Log-likelihood of trial 0 is "
-        << bestLikelihood << "." << std::endl;
-
-    // Now the temporary model.
-    std::vector<arma::vec> meansTrial(gaussians, arma::vec(dimensionality));
-    std::vector<arma::mat> covariancesTrial(gaussians,
-        arma::mat(dimensionality, dimensionality));
-    arma::vec weightsTrial(gaussians);
-
-    for (size_t trial = 1; trial < trials; ++trial)
-    {
-      if (useExistingModel)
-      {
-        meansTrial = meansOrig;
-        covariancesTrial = covariancesOrig;
-        weightsTrial = weightsOrig;
-      }
-
-      fitter.Estimate(observations, meansTrial, covariancesTrial, weightsTrial,
-          useExistingModel);
-
-      // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, meansTrial,
-          covariancesTrial, weightsTrial);
-
-      Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial
-          << " is " << newLikelihood << "." << std::endl;
-
-      if (newLikelihood > bestLikelihood)
-      {
-        // Save new likelihood and copy new model.
-        bestLikelihood = newLikelihood;
-
-        means = meansTrial;
-        covariances = covariancesTrial;
-        weights = weightsTrial;
-      }
-    }
-  }
-
-  // Report final log-likelihood and return it.
-  Log::Info << "GMM::Estimate(): log-likelihood of trained GMM is "
-      << bestLikelihood << "." << std::endl;
-  return bestLikelihood;
+  return EstimateTrials(observations, NULL, trials, useExistingModel);
 }
 
 /**
@@ -296,23 +243,73 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
                                   const size_t trials,
                                   const bool useExistingModel)
 {
+  return EstimateTrials(observations, &probabilities, trials,
+      useExistingModel);
+}
+
+template<typename FittingType>
+double GMM<FittingType>::EstimateTrials(const arma::mat& observations,
+                                        const arma::vec* probabilities,
+                                        const size_t trials,
+                                        const bool useExistingModel)
+{
+  if (trials == 0)
+    return -DBL_MAX; // It's what they asked for...
+
+  // A monitor observes one fit at a time, so with a monitor the trials are run
+  // one after another.
+  const size_t numThreads = (FitterMonitor(fitter) == NULL) ?
+      std::min(Threads::Count(threads), trials) : 1;
+
   double bestLikelihood; // This will be reported later.
 
-  // We don't need to store temporary models if we are only doing one trial.
   if (trials == 1)
   {
     // Train the model.  The user will have been warned earlier if the GMM was
     // initialized with no parameters (0 gaussians, dimensionality of 0).
-    fitter.Estimate(observations, probabilities, means, covariances, weights,
-        useExistingModel);
+    bestLikelihood = Fit(fitter, observations, probabilities, means,
+        covariances, weights, useExistingModel);
+  }
+  else if (numThreads > 1)
+  {
+    // Each trial starts from a copy of the model (which is only used if
+    // useExistingModel is true) and keeps its result until all are done.
+    std::vector<std::vector<arma::vec> > meansTrial(trials, means);
+    std::vector<std::vector<arma::mat> > covariancesTrial(trials,
+        covariances);
+    std::vector<arma::vec> weightsTrial(trials, weights);
+    arma::vec likelihoods(trials);
+
+    const math::RandomStream base = math::DrawStream();
+    #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+    for (int trial = 0; trial < (int) trials; ++trial)
+    {
+      math::ScopedThreadStream stream(base.Split((size_t) trial));
+      FittingType trialFitter(fitter);
+      likelihoods[trial] = Fit(trialFitter, observations, probabilities,
+          meansTrial[trial], covariancesTrial[trial], weightsTrial[trial],
+          useExistingModel);
+    }
 
-    bestLikelihood = LogLikelihood(observations, means, covariances, weights);
+    // If two trials are equally good, the first is kept, as when the trials
+    // are run one after another.
+    size_t best = 0;
+    for (size_t trial = 0; trial < trials; ++trial)
+    {
+      Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial
+          << " is " << likelihoods[trial] << "." << std::endl;
+
+      if (likelihoods[trial] > likelihoods[best])
+        best = trial;
+    }
+
+    bestLikelihood = likelihoods[best];
+    means = meansTrial[best];
+    covariances = covariancesTrial[best];
+    weights = weightsTrial[best];
   }
   else
   {
-    if (trials == 0)
-      return -DBL_MAX; // It's what they asked for...
-
     // If each trial must start from the same initial location, we must save it.
     std::vector<arma::vec> meansOrig;
     std::vector<arma::mat> covariancesOrig;
@@ -326,12 +323,10 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
 
     // We need to keep temporary copies.  We'll do the first training into the
     // actual model position, so that if it's the best we don't need to copy it.
-    fitter.Estimate(observations, probabilities, means, covariances, weights,
-        useExistingModel);
+    bestLikelihood = Fit(fitter, observations, probabilities, means,
+        covariances, weights, useExistingModel);
 
-    bestLikelihood = LogLikelihood(observations, means, covariances, weights);
-
-    Log::Debug << "GMM::Estimate(): Log-likelihood of trial 0 is "
+    Log::Info << "GMM::Estimate(): Log-likelihood of trial 0 is "
         << bestLikelihood << "." << std::endl;
 
     // Now the temporary model.
@@ -340,7 +335,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         arma::mat(dimensionality, dimensionality));
     arma::vec weightsTrial(gaussians);
 
-    for (size_t trial = 1; trial < trials; ++trial)
+    // Once the monitor of the fitter has stopped it, no more trials are run.
+    for (size_t trial = 1; trial < trials && !FitterStopped(fitter); ++trial)
     {
       if (useExistingModel)
       {
@@ -349,14 +345,11 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         weightsTrial = weightsOrig;
       }
 
-      fitter.Estimate(observations, meansTrial, covariancesTrial, weightsTrial,
-          useExistingModel);
-
       // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, meansTrial,
-          covariancesTrial, weightsTrial);
+      const double newLikelihood = Fit(fitter, observations, probabilities,
+          meansTrial, covariancesTrial, weightsTrial, useExistingModel);
 
-      Log::Debug << "GMM::Estimate(): Log-likelihood of trial " << trial
+      Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial
           << " is " << newLikelihood << "." << std::endl;
 
       if (newLikelihood > bestLikelihood)
@@ -377,6 +370,25 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
   return bestLikelihood;
 }
 
+template<typename FittingType>
+double GMM<FittingType>::Fit(FittingType& trialFitter,
+                             const arma::mat& observations,
+                             const arma::vec* probabilities,
+                             std::vector<arma::vec>& means,
+                             std::vector<arma::mat>& covariances,
+                             arma::vec& weights,
+                             const bool useExistingModel) const
+{
+  if (probabilities == NULL)
+    trialFitter.Estimate(observations, means, covariances, weights,
+        useExistingModel);
+  else
+    trialFitter.Estimate(observations, *probabilities, means, covariances,
+        weights, useExistingModel);
+
+  return LogLikelihood(observations, means, covariances, weights);
+}
+
 /**
  * Classify the given observations as being from an individual component in this
  * GMM.
@@ -385,25 +397,7 @@ template<typename FittingType>
 void GMM<FittingType>::Classify(const arma::mat& observations,
                                 arma::Col<size_t>& labels) const
 {
-  // This is not the best way to do this!
-
-  // We should not have to fill this with values, because each one should be
-  // overwritten.
-  labels.set_size(observations.n_cols);
-  for (size_t i = 0; i < observations.n_cols; ++i)
-  {
-    // Find maximum probability component.
-    double probability = 0;
-    for (size_t j = 0; j < gaussians; ++j)
-    {
-      double newProb = Probability(observations.unsafe_col(i), j);
-      if (newProb >= probability)
-      {
-        probability = newProb;
-        labels[i] = j;
-      }
-    }
-  }
+  Score(observations, means, covariances, weights, NULL, &labels);
 }
 
 /**
@@ -416,21 +410,104 @@ double GMM<FittingType>::LogLikelihood(
     const std::vector<arma::mat>& covariancesL,
     const arma::vec& weightsL) const
 {
-  double loglikelihood = 0;
+  arma::vec logLikelihoods;
+  Score(data, meansL, covariancesL, weightsL, &logLikelihoods, NULL);
 
-  arma::vec phis;
-  arma::mat likelihoods(gaussians, data.n_cols);
-  for (size_t i = 0; i < gaussians; i++)
+  return accu(logLikelihoods);
+}
+
+/**
+ * Score the observations one block at a time.
+ */
+template<typename FittingType>
+void GMM<FittingType>::Score(const arma::mat& data,
+                             const std::vector<arma::vec>& meansL,
+                             const std::vector<arma::mat>& covariancesL,
+                             const arma::vec& weightsL,
+                             arma::vec* logLikelihoods,
+                             arma::Col<size_t>* labels) const
+{
+  const size_t points = data.n_cols;
+  const size_t components = meansL.size();
+
+  if (logLikelihoods)
+    logLikelihoods->set_size(points);
+  if (labels)
+    labels->set_size(points);
+  if (points == 0)
+    return;
+
+  // Factorize each covariance now, before the Gaussians are shared between
+  // threads.  GaussianDistribution evaluates diagonal covariances in O(d).
+  std::vector<distribution::GaussianDistribution> dists;
+  dists.reserve(components);
+  for (size_t i = 0; i < components; ++i)
   {
-    phi(data, meansL[i], covariancesL[i], phis);
-    likelihoods.row(i) = weightsL(i) * trans(phis);
+    dists.push_back(distribution::GaussianDistribution(meansL[i],
+        covariancesL[i]));
+    dists[i].FactorCovariance();
   }
+  const arma::vec logWeights = log(weightsL);
+
+  // Each observation of a block needs its log-densities, and its difference
+  // to a mean (and a temporary of the same size).
+  const size_t workers = std::max(std::min(Threads::Count(threads), points),
+      (size_t) 1);
+  const size_t blockPoints = MemoryBudget::BlockColumns(workers *
+      MemoryBudget::MatrixBytes<double>(components + 2 * data.n_rows, 1),
+      points);
+  const size_t blocks = std::max(workers,
+      (points + blockPoints - 1) / blockPoints);
+
+  // Each observation is scored on its own, so the results do not depend on
+  // the blocks.
+  #pragma omp parallel for num_threads(workers) schedule(dynamic, 1)
+  for (int b = 0; b < (int) blocks; ++b)
+  {
+    const size_t begin = (size_t) b * points / blocks;
+    const size_t end = ((size_t) b + 1) * points / blocks;
+    const size_t count = end - begin;
+    if (count == 0)
+      continue;
+
+    // Alias the block of observations so that we don't copy it.
+    const arma::mat block(const_cast<double*>(data.colptr(begin)),
+        data.n_rows, count, false, true);
+
+    arma::mat logProb(count, components);
+    for (size_t i = 0; i < components; ++i)
+    {
+      arma::vec logProbAlias = logProb.unsafe_col(i);
+      dists[i].LogProbability(block, logProbAlias);
+      logProbAlias += logWeights[i];
+    }
 
-  // Now sum over every point.
-  for (size_t j = 0; j < data.n_cols; j++)
-    loglikelihood += log(accu(likelihoods.col(j)));
+    // Sum over every component in log-space.
+    if (logLikelihoods)
+    {
+      arma::vec blockLogLikelihoods;
+      math::LogSumExp(logProb, blockLogLikelihoods);
+      logLikelihoods->subvec(begin, end - 1) = blockLogLikelihoods;
+    }
 
-  return loglikelihood;
+    // Find the maximum probability component; ties go to the last one.
+    if (labels)
+    {
+      for (size_t j = 0; j < count; ++j)
+      {
+        double logProbability = -std::numeric_limits<double>::infinity();
+        (*labels)[begin + j] = 0;
+        for (size_t i = 0; i < components; ++i)
+        {
+          if (logProb(j, i) >= logProbability)
+          {
+            logProbability = logProb(j, i);
+            (*labels)[begin + j] = i;
+          }
+        }
+      }
+    }
+  }
 }
 
 }; // namespace gmm
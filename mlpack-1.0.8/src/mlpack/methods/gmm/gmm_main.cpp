@@ -23,6 +23,7 @@
 
 #include "gmm.hpp"
 #include "no_constraint.hpp"
+#include "diagonal_constraint.hpp"
 
 #include <mlpack/methods/kmeans/refined_start.hpp>
 
@@ -36,7 +37,8 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "This program takes a parametric estimate of a Gaussian mixture model (GMM)"
     " using the EM algorithm to find the maximum likelihood estimate.  The "
     "model is saved to an XML file, which contains information about each "
-    "Gaussian."
+    "Gaussian; if the output file has the extension '.bin', a binary file is "
+    "written instead, which is smaller and faster to load."
     "\n\n"
     "If GMM training fails with an error indicating that a covariance matrix "
     "could not be inverted, be sure that the 'no_force_positive' flag was not "
@@ -49,13 +51,23 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "iteration of the EM algorithm which ensure that the covariance matrices "
     "are positive definite.  Specifying the flag can cause faster runtime, "
     "but may also cause non-positive definite covariance matrices, which will "
-    "cause the program to crash.");
+    "cause the program to crash."
+    "\n\n"
+    "The 'diagonal_covariance' flag, if set, fits Gaussians with diagonal "
+    "covariance matrices.  Only the variances are then estimated, so each "
+    "iteration of EM takes time linear in the dimensionality of the data "
+    "instead of quadratic; this is much faster for high-dimensional data."
+    "\n\n"
+    "The 'use_tree' flag, if set, runs the E-step of EM on a kd-tree of the "
+    "data, which is much faster for large, low-dimensional datasets.  Whole "
+    "nodes of the tree are then given the same responsibilities when these are "
+    "known to within --tree_tolerance, so the fit is approximate.");
 
 PARAM_STRING_REQ("input_file", "File containing the data on which the model "
     "will be fit.", "i");
 PARAM_INT("gaussians", "Number of Gaussians in the GMM.", "g", 1);
 PARAM_STRING("output_file", "The file to write the trained GMM parameters into "
-    "(as XML).", "o", "gmm.xml");
+    "(as XML, or binary if the extension is '.bin').", "o", "gmm.xml");
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_INT("trials", "Number of trials to perform in training GMM.", "t", 10);
 
@@ -63,8 +75,18 @@ PARAM_INT("trials", "Number of trials to perform in training GMM.", "t", 10);
 PARAM_DOUBLE("tolerance", "Tolerance for convergence of EM.", "T", 1e-10);
 PARAM_FLAG("no_force_positive", "Do not force the covariance matrices to be "
     "positive definite.", "P");
+PARAM_FLAG("diagonal_covariance", "Fit Gaussians with diagonal covariance "
+    "matrices.", "d");
+PARAM_FLAG("use_tree", "Run the E-step of EM on a kd-tree of the data.", "u");
+PARAM_DOUBLE("tree_tolerance", "If using --use_tree, the largest error allowed "
+    "in the responsibilities of the Gaussians for each point (0 is exact).",
+    "e", 1e-3);
 PARAM_INT("max_iterations", "Maximum number of iterations of EM algorithm "
     "(passing 0 will run until convergence).", "n", 250);
+PARAM_INT("threads", "Number of threads to use for the trials, which are run "
+    "at once, or for the EM algorithm when there is one trial (0 uses all "
+    "available cores).  This only has an effect if MLPACK was built with "
+    "OpenMP.", "j", 1);
 
 // Parameters for dataset modification.
 PARAM_DOUBLE("noise", "Variance of zero-mean Gaussian noise to add to data.",
@@ -79,6 +101,35 @@ PARAM_DOUBLE("percentage", "If using --refined_start, specify the percentage of"
     " the dataset used for each sampling (should be between 0.0 and 1.0).",
     "p", 0.02);
 
+/**
+ * Fit a GMM with the given EM object to the data, save it, and return its
+ * log-likelihood.
+ */
+template<typename FitterType>
+double Train(FitterType& em,
+             const arma::mat& dataPoints,
+             const size_t gaussians,
+             const size_t threads)
+{
+  em.Threads() = threads;
+  em.UseTree() = CLI::HasParam("use_tree");
+  em.TreeTolerance() = CLI::GetParam<double>("tree_tolerance");
+
+  GMM<FitterType> gmm(gaussians, dataPoints.n_rows, em);
+  gmm.Threads() = threads;
+
+  // Compute the parameters of the model using the EM algorithm.
+  Timer::Start("em");
+  const double likelihood = gmm.Estimate(dataPoints,
+      CLI::GetParam<int>("trials"));
+  Timer::Stop("em");
+
+  // Save results.
+  gmm.Save(CLI::GetParam<string>("output_file"));
+
+  return likelihood;
+}
+
 int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
@@ -115,6 +166,17 @@ int main(int argc, char* argv[])
   const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const double tolerance = CLI::GetParam<double>("tolerance");
   const bool forcePositive = !CLI::HasParam("no_force_positive");
+  const bool diagonal = CLI::HasParam("diagonal_covariance");
+
+  if (CLI::GetParam<double>("tree_tolerance") < 0.0)
+    Log::Fatal << "Invalid tree tolerance (" << CLI::GetParam<double>(
+        "tree_tolerance") << "); must be greater than or equal to 0."
+        << std::endl;
+
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads (" << threads << "); must be "
+        << "greater than or equal to 0." << std::endl;
 
   // This gets a bit weird because we need different types depending on whether
   // --refined_start is specified.
@@ -138,72 +200,44 @@ int main(int argc, char* argv[])
     KMeansType k(1000, 1.0, metric::SquaredEuclideanDistance(),
         RefinedStart(samplings, percentage));
 
-    // Depending on the value of 'forcePositive', we have to use different
-    // types.
-    if (forcePositive)
+    // Depending on the values of 'diagonal' and 'forcePositive', we have to
+    // use different types.
+    if (diagonal)
+    {
+      EMFit<KMeansType, DiagonalConstraint> em(maxIterations, tolerance, k);
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
+    }
+    else if (forcePositive)
     {
       EMFit<KMeansType> em(maxIterations, tolerance, k);
-
-      GMM<EMFit<KMeansType> > gmm(size_t(gaussians), dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
     }
     else
     {
       EMFit<KMeansType, NoConstraint> em(maxIterations, tolerance, k);
-
-      GMM<EMFit<KMeansType, NoConstraint> > gmm(size_t(gaussians),
-          dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
     }
   }
   else
   {
-    // Depending on the value of forcePositive, we have to use different types.
-    if (forcePositive)
+    // Depending on the values of 'diagonal' and 'forcePositive', we have to
+    // use different types.
+    if (diagonal)
+    {
+      // Only estimate the variances.
+      EMFit<KMeans<>, DiagonalConstraint> em(maxIterations, tolerance);
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
+    }
+    else if (forcePositive)
     {
       EMFit<> em(maxIterations, tolerance);
-
-      // Calculate mixture of Gaussians.
-      GMM<> gmm(size_t(gaussians), dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
     }
     else
     {
       // Use no constraints on the covariance matrix.
       EMFit<KMeans<>, NoConstraint> em(maxIterations, tolerance);
-
-      // Calculate mixture of Gaussians.
-      GMM<EMFit<KMeans<>, NoConstraint> > gmm(size_t(gaussians),
-          dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      likelihood = Train(em, dataPoints, size_t(gaussians), size_t(threads));
     }
   }
 
@@ -156,6 +156,15 @@ class HMM
    * log-likelihood of the model between iterations is less than the tolerance,
    * the Baum-Welch algorithm terminates.
    *
+   * If Threads() is not 1, the E-step (the Forward-Backward algorithm) is run
+   * on the sequences in parallel, and the expected transition counts of each
+   * thread are summed in a fixed order afterwards.  The emission distributions
+   * of the states are then re-estimated in parallel too.
+   *
+   * If a Monitor() is set, it is called after each iteration with the
+   * log-likelihood of the sequences, and may stop training early, leaving the
+   * model of the last finished iteration.
+   *
    * @note
    * Train() can be called multiple times with different sequences; each time it
    * is called, it uses the current parameters of the HMM as a starting point
@@ -247,7 +256,11 @@ class HMM
   /**
    * Compute the most probable hidden state sequence for the given data
    * sequence, using the Viterbi algorithm, returning the log-likelihood of the
-   * most likely state sequence.
+   * most likely state sequence.  The algorithm runs in log-space on the
+   * emission probabilities of the whole sequence, which are computed once.  If
+   * BeamWidth() is not 0, only that many of the most probable states at each
+   * time step are extended to the next one; this is faster for models with
+   * many states, but the returned sequence may not be the most probable one.
    *
    * @param dataSeq Sequence of observations.
    * @param stateSeq Vector in which the most probable state sequence will be
@@ -265,6 +278,33 @@ class HMM
    */
   double LogLikelihood(const arma::mat& dataSeq) const;
 
+  /**
+   * Compute the most probable hidden state sequence for each of the given data
+   * sequences, using the Viterbi algorithm.  The sequences are independent, so
+   * if Threads() is not 1 they are processed in parallel (this requires MLPACK
+   * to be built with OpenMP).
+   *
+   * @param dataSeq Vector of observation sequences.
+   * @param stateSeq Vector in which the most probable state sequence of each
+   *    data sequence will be stored.
+   * @param logLikelihoods Vector in which the log-likelihood of each most
+   *    probable state sequence will be stored.
+   */
+  void Predict(const std::vector<arma::mat>& dataSeq,
+               std::vector<arma::Col<size_t> >& stateSeq,
+               arma::vec& logLikelihoods) const;
+
+  /**
+   * Compute the log-likelihood of each of the given data sequences.  If
+   * Threads() is not 1, the sequences are processed in parallel.
+   *
+   * @param dataSeq Vector of observation sequences.
+   * @param logLikelihoods Vector in which the log-likelihood of each sequence
+   *    will be stored.
+   */
+  void LogLikelihood(const std::vector<arma::mat>& dataSeq,
+                     arma::vec& logLikelihoods) const;
+
   //! Return the transition matrix.
   const arma::mat& Transition() const { return transition; }
   //! Return a modifiable transition matrix reference.
@@ -285,20 +325,83 @@ class HMM
   //! Modify the tolerance of the Baum-Welch algorithm.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of threads used for multiple sequences (1 is serial, 0 is
+  //! all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for multiple sequences (1 is serial, 0
+  //! is all cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of states kept at each step of Viterbi decoding in
+  //! Predict() (0 keeps every state).
+  size_t BeamWidth() const { return beamWidth; }
+  //! Modify the number of states kept at each step of Viterbi decoding in
+  //! Predict() (0 keeps every state).
+  size_t& BeamWidth() { return beamWidth; }
+
+  //! Get the monitor which observes Train() (NULL if there is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes Train() (see ProgressMonitor).
+  ProgressMonitor*& Monitor() { return monitor; }
+
  private:
   // Helper functions.
 
+  /**
+   * Compute the probability of each observation in the given data sequence
+   * under each state's emission distribution.  The returned matrix has rows
+   * equal to the number of hidden states and columns equal to the number of
+   * observations.  Each emission density is evaluated only once per
+   * observation, and the result is shared by Forward(), Backward(), and the
+   * transition update in Train().  For discrete emissions, this is specialized
+   * to copy columns of a table of the emission probabilities of each state.
+   *
+   * @param dataSeq Data sequence to compute probabilities for.
+   * @param emissionProb Matrix in which emission probabilities will be saved.
+   */
+  void EmissionProbability(const arma::mat& dataSeq,
+                           arma::mat& emissionProb) const;
+
+  /**
+   * Re-estimate the emission distributions in the M-step of the Baum-Welch
+   * algorithm, given the probability of each observation coming from each
+   * state.  The states are estimated in parallel (each from its own random
+   * stream).  Discrete emissions have a specialization which counts symbols
+   * directly.
+   *
+   * @param observations Observations of all the data sequences.
+   * @param stateProb Probability of each observation coming from each state.
+   */
+  void EstimateEmission(const arma::mat& observations,
+                        const std::vector<arma::vec>& stateProb);
+
+  /**
+   * The Viterbi algorithm, in log-space; this is the body of Predict().  The
+   * logarithm of the transition matrix is given so that it can be shared
+   * between sequences.
+   *
+   * @param dataSeq Sequence of observations.
+   * @param logTransition Logarithm of the transition matrix.
+   * @param stateSeq Vector in which the most probable state sequence will be
+   *    stored.
+   * @return Log-likelihood of most probable state sequence.
+   */
+  double Viterbi(const arma::mat& dataSeq,
+                 const arma::mat& logTransition,
+                 arma::Col<size_t>& stateSeq) const;
+
   /**
    * The Forward algorithm (part of the Forward-Backward algorithm).  Computes
    * forward probabilities for each state for each observation in the given data
    * sequence.  The returned matrix has rows equal to the number of hidden
    * states and columns equal to the number of observations.
    *
-   * @param dataSeq Data sequence to compute probabilities for.
+   * @param emissionProb Emission probabilities of the data sequence, as
+   *     computed by EmissionProbability().
    * @param scales Vector in which scaling factors will be saved.
    * @param forwardProb Matrix in which forward probabilities will be saved.
    */
-  void Forward(const arma::mat& dataSeq,
+  void Forward(const arma::mat& emissionProb,
                arma::vec& scales,
                arma::mat& forwardProb) const;
 
@@ -309,14 +412,44 @@ class HMM
    * The returned matrix has rows equal to the number of hidden states and
    * columns equal to the number of observations.
    *
-   * @param dataSeq Data sequence to compute probabilities for.
+   * @param emissionProb Emission probabilities of the data sequence, as
+   *     computed by EmissionProbability().
    * @param scales Vector of scaling factors.
    * @param backwardProb Matrix in which backward probabilities will be saved.
    */
-  void Backward(const arma::mat& dataSeq,
+  void Backward(const arma::mat& emissionProb,
                 const arma::vec& scales,
                 arma::mat& backwardProb) const;
 
+  /**
+   * Run the Forward-Backward algorithm on a data sequence whose emission
+   * probabilities have already been computed.  This is the body of
+   * Estimate().
+   *
+   * @param emissionProb Emission probabilities of the data sequence.
+   * @param stateProb Matrix in which the probabilities of each state at each
+   *    time interval will be stored.
+   * @param forwardProb Matrix in which the forward probabilities of each state
+   *    at each time interval will be stored.
+   * @param backwardProb Matrix in which the backward probabilities of each
+   *    state at each time interval will be stored.
+   * @param scales Vector in which the scaling factors at each time interval
+   *    will be stored.
+   * @return Log-likelihood of the data sequence.
+   */
+  double EstimateFromEmission(const arma::mat& emissionProb,
+                              arma::mat& stateProb,
+                              arma::mat& forwardProb,
+                              arma::mat& backwardProb,
+                              arma::vec& scales) const;
+
+  /**
+   * Return the number of threads that should be used for work spread across
+   * multiple sequences (this resolves a setting of 0 to the number of
+   * available cores).
+   */
+  size_t NumThreads() const;
+
   //! Transition probability matrix.
   arma::mat transition;
 
@@ -328,6 +461,16 @@ class HMM
 
   //! Tolerance of Baum-Welch algorithm.
   double tolerance;
+
+  //! Number of threads to use for multiple sequences; 1 is serial, 0 is all
+  //! cores.
+  size_t threads;
+
+  //! Number of states kept at each step of Viterbi decoding; 0 keeps all.
+  size_t beamWidth;
+
+  //! Monitor of the progress of training (may be NULL).
+  ProgressMonitor* monitor;
 };
 
 }; // namespace hmm
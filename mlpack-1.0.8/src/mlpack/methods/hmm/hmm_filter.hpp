@@ -0,0 +1,167 @@
+/**
+ * @file hmm_filter.hpp
+ *
+ * Definition of the HMMFilter class, which runs the forward algorithm and a
+ * fixed-lag Viterbi decoder over a stream of observations.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_HMM_HMM_FILTER_HPP
+#define __MLPACK_METHODS_HMM_HMM_FILTER_HPP
+
+#include <mlpack/core.hpp>
+#include "hmm.hpp"
+
+namespace mlpack {
+namespace hmm {
+
+/**
+ * An online filter for a trained HMM.  Instead of requiring the entire
+ * observation sequence up front (as HMM::LogLikelihood() and HMM::Predict()
+ * do), observations are given one at a time with Update().  After each update,
+ * the log-likelihood of the stream so far and the posterior distribution of
+ * the current hidden state are available.  Only O(states) state is kept for
+ * the forward algorithm, so memory use does not grow with the length of the
+ * stream.
+ *
+ * The filter also runs a fixed-lag Viterbi decoder: once Update() has been
+ * called (lag + 1) times, each further call decides the hidden state of the
+ * observation that was given 'lag' steps earlier, using the most probable path
+ * through the current observation.  A lag of 0 gives the most probable current
+ * state; larger lags give results closer to full Viterbi decoding at the cost
+ * of latency and O(states * lag) memory.  When the stream ends, Flush() decodes
+ * the states that are still pending.
+ *
+ * @code
+ * HMMFilter<GaussianDistribution> filter(hmm, 10);
+ * while (NextObservation(observation))
+ * {
+ *   if (filter.Update(observation))
+ *     Process(filter.DecodedTime(), filter.DecodedState());
+ * }
+ *
+ * arma::Col<size_t> remaining;
+ * filter.Flush(remaining);
+ * @endcode
+ *
+ * As with HMM::Forward(), the hidden state before the first observation is
+ * assumed to be state 0.  The filter keeps a reference to the HMM; if the
+ * model is modified, Reset() must be called before the filter is used again.
+ *
+ * @tparam Distribution Type of emission distribution of the HMM.
+ */
+template<typename Distribution = distribution::DiscreteDistribution>
+class HMMFilter
+{
+ public:
+  /**
+   * Create a filter for the given HMM, with the given decoding lag.
+   *
+   * @param hmm Trained HMM to filter observations with.
+   * @param lag Number of observations to wait before deciding the hidden state
+   *     of an observation.
+   */
+  HMMFilter(const HMM<Distribution>& hmm, const size_t lag = 0);
+
+  /**
+   * Forget all observations seen so far and start a new stream.  This must
+   * also be called if the underlying HMM has been changed.
+   */
+  void Reset();
+
+  /**
+   * Process the next observation in the stream.  This updates the
+   * log-likelihood and the state posterior, and returns true if a hidden state
+   * has been decoded (that is, if at least lag + 1 observations have been
+   * seen).  In that case the state is given by DecodedState() and the index of
+   * the observation it belongs to by DecodedTime().
+   *
+   * @param observation Next observation.
+   * @return Whether or not a new hidden state was decoded.
+   */
+  bool Update(const arma::vec& observation);
+
+  /**
+   * Decode the hidden states of the observations that have been given to
+   * Update() but not yet decoded (at most 'lag' of them), using the most
+   * probable path through the last observation.  This should be called when
+   * the stream ends; it does not reset the filter.
+   *
+   * @param stateSeq Vector to store the remaining hidden states in, in order.
+   */
+  void Flush(arma::Col<size_t>& stateSeq) const;
+
+  //! Get the HMM being filtered.
+  const HMM<Distribution>& Model() const { return hmm; }
+
+  //! Get the decoding lag.
+  size_t Lag() const { return lag; }
+
+  //! Get the number of observations seen since the last Reset().
+  size_t Steps() const { return steps; }
+
+  //! Get the log-likelihood of the observations seen so far.
+  double LogLikelihood() const { return logLikelihood; }
+
+  //! Get the posterior probability of each hidden state given the
+  //! observations seen so far.
+  const arma::vec& Posterior() const { return forward; }
+
+  //! Get the most recently decoded hidden state.
+  size_t DecodedState() const { return decodedState; }
+
+  //! Get the index of the observation that the most recently decoded hidden
+  //! state belongs to.
+  size_t DecodedTime() const { return steps - 1 - lag; }
+
+ private:
+  //! The HMM being filtered.
+  const HMM<Distribution>& hmm;
+
+  //! Logs of the transposed transition matrix.
+  arma::mat logTransition;
+
+  //! Decoding lag.
+  size_t lag;
+
+  //! Number of observations seen.
+  size_t steps;
+
+  //! Scaled forward probabilities of the current observation.
+  arma::vec forward;
+
+  //! Log-likelihood of the observations seen so far.
+  double logLikelihood;
+
+  //! Log-probability of the most probable path ending in each state, shifted
+  //! so that the largest is zero.
+  arma::vec logPathProb;
+
+  //! Circular buffer of the most probable previous state of each state, for
+  //! the last 'lag' observations.
+  arma::Mat<size_t> backpointers;
+
+  //! The most recently decoded state.
+  size_t decodedState;
+};
+
+}; // namespace hmm
+}; // namespace mlpack
+
+// Include implementation.
+#include "hmm_filter_impl.hpp"
+
+#endif
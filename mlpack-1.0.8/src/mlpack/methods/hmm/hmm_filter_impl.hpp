@@ -0,0 +1,139 @@
+/**
+ * @file hmm_filter_impl.hpp
+ *
+ * Implementation of the HMMFilter class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_HMM_HMM_FILTER_IMPL_HPP
+#define __MLPACK_METHODS_HMM_HMM_FILTER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "hmm_filter.hpp"
+
+namespace mlpack {
+namespace hmm {
+
+template<typename Distribution>
+HMMFilter<Distribution>::HMMFilter(const HMM<Distribution>& hmm,
+                                   const size_t lag) :
+    hmm(hmm),
+    lag(lag)
+{
+  Reset();
+}
+
+template<typename Distribution>
+void HMMFilter<Distribution>::Reset()
+{
+  const size_t states = hmm.Transition().n_rows;
+
+  // We use the columns of the transposed transition matrix.
+  logTransition = log(trans(hmm.Transition()));
+
+  steps = 0;
+  logLikelihood = 0.0;
+  decodedState = 0;
+  forward.zeros(states);
+  logPathProb.zeros(states);
+  backpointers.zeros(states, lag);
+}
+
+template<typename Distribution>
+bool HMMFilter<Distribution>::Update(const arma::vec& observation)
+{
+  const arma::mat& transition = hmm.Transition();
+  const size_t states = transition.n_rows;
+
+  arma::vec emissionProb(states);
+  for (size_t state = 0; state < states; state++)
+    emissionProb[state] = hmm.Emission()[state].Probability(observation);
+
+  if (steps == 0)
+  {
+    // Starting state (at t = -1) is assumed to be state 0, as in
+    // HMM::Forward() and HMM::Predict().
+    forward = transition.col(0) % emissionProb;
+    logPathProb = log(transition.col(0)) + log(emissionProb);
+  }
+  else
+  {
+    forward = (transition * forward) % emissionProb;
+
+    // Extend the most probable path into each state, remembering where it came
+    // from.
+    const arma::vec logEmissionProb = log(emissionProb);
+    arma::vec newLogPathProb(states);
+    for (size_t state = 0; state < states; state++)
+    {
+      arma::uword index;
+      newLogPathProb[state] = (logPathProb +
+          logTransition.unsafe_col(state)).max(index) + logEmissionProb[state];
+
+      if (lag > 0)
+        backpointers(state, steps % lag) = index;
+    }
+
+    logPathProb = newLogPathProb;
+  }
+
+  // Normalize the forward probabilities; the normalizing constant is the
+  // probability of this observation given all previous ones.
+  const double scale = accu(forward);
+  forward /= scale;
+  logLikelihood += log(scale);
+
+  // Only the differences between path probabilities matter, so keep them from
+  // drifting towards -inf.
+  const double maxLogPathProb = logPathProb.max();
+  if (maxLogPathProb != -std::numeric_limits<double>::infinity())
+    logPathProb -= maxLogPathProb;
+
+  ++steps;
+  if (steps <= lag)
+    return false;
+
+  // Follow the most probable path back 'lag' steps.
+  arma::uword index;
+  logPathProb.max(index);
+  size_t state = (size_t) index;
+  for (size_t i = 0; i < lag; i++)
+    state = backpointers(state, (steps - 1 - i) % lag);
+
+  decodedState = state;
+  return true;
+}
+
+template<typename Distribution>
+void HMMFilter<Distribution>::Flush(arma::Col<size_t>& stateSeq) const
+{
+  const size_t pending = std::min(lag, steps);
+  stateSeq.set_size(pending);
+  if (pending == 0)
+    return;
+
+  arma::uword index;
+  logPathProb.max(index);
+  stateSeq[pending - 1] = (size_t) index;
+  for (size_t i = 1; i < pending; i++)
+    stateSeq[pending - 1 - i] = backpointers(stateSeq[pending - i],
+        (steps - i) % lag);
+}
+
+}; // namespace hmm
+}; // namespace mlpack
+
+#endif
@@ -26,9 +26,28 @@
 // Just in case...
 #include "hmm.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace hmm {
 
+/**
+ * Some emission distributions cache state lazily the first time they are
+ * evaluated.  Before a distribution is evaluated from several threads at once,
+ * that state has to be computed.  Most distributions have no such state.
+ */
+template<typename Distribution>
+inline void PrepareEmission(const Distribution& /* emission */)
+{ /* Nothing to do. */ }
+
+//! GaussianDistribution caches the factorization of its covariance.
+inline void PrepareEmission(const distribution::GaussianDistribution& emission)
+{
+  emission.FactorCovariance();
+}
+
 /**
  * Create the Hidden Markov Model with the given number of hidden states and the
  * given number of emission states.
@@ -40,7 +59,10 @@ HMM<Distribution>::HMM(const size_t states,
     transition(arma::ones<arma::mat>(states, states) / (double) states),
     emission(states, /* default distribution */ emissions),
     dimensionality(emissions.Dimensionality()),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    threads(1),
+    beamWidth(0),
+    monitor(NULL)
 { /* nothing to do */ }
 
 /**
@@ -53,7 +75,10 @@ HMM<Distribution>::HMM(const arma::mat& transition,
                        const double tolerance) :
     transition(transition),
     emission(emission),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    threads(1),
+    beamWidth(0),
+    monitor(NULL)
 {
   // Set the dimensionality, if we can.
   if (emission.size() > 0)
@@ -105,64 +130,118 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   }
 
   // These are used later for training of each distribution.  We initialize it
-  // all now so we don't have to do any allocation later on.
+  // all now so we don't have to do any allocation later on.  The list of
+  // observations doesn't change between iterations, so we only fill it once.
+  // A single sequence is used as the list directly, without a copy.  We also
+  // store where each sequence starts in that list.
   std::vector<arma::vec> emissionProb(transition.n_cols,
       arma::vec(totalLength));
-  arma::mat emissionList(dimensionality, totalLength);
+  arma::mat gatheredList;
+  if (dataSeq.size() > 1)
+    gatheredList.set_size(dimensionality, totalLength);
+  std::vector<size_t> offsets(dataSeq.size());
+  size_t sumTime = 0;
+  for (size_t seq = 0; seq < dataSeq.size(); seq++)
+  {
+    offsets[seq] = sumTime;
+    if (dataSeq.size() > 1 && dataSeq[seq].n_cols > 0)
+      gatheredList.cols(sumTime, sumTime + dataSeq[seq].n_cols - 1) =
+          dataSeq[seq];
+    sumTime += dataSeq[seq].n_cols;
+  }
+  const arma::mat& emissionList = (dataSeq.size() == 1) ? dataSeq[0] :
+      gatheredList;
+
+  // Split the sequences into contiguous blocks of roughly equal total length;
+  // each block is handled by one thread.  The blocks only depend on the number
+  // of threads, so the result does not depend on scheduling.
+  const size_t blocks = std::max(std::min(NumThreads(), dataSeq.size()),
+      (size_t) 1);
+  std::vector<size_t> blockStart(blocks + 1, dataSeq.size());
+  for (size_t b = 0, seq = 0; b < blocks; b++)
+  {
+    while (seq < dataSeq.size() && offsets[seq] < b * totalLength / blocks)
+      seq++;
+    blockStart[b] = seq;
+  }
 
   // This should be the Baum-Welch algorithm (EM for HMM estimation). This
   // follows the procedure outlined in Elliot, Aggoun, and Moore's book "Hidden
   // Markov Models: Estimation and Control", pp. 36-40.
   for (size_t iter = 0; iter < iterations; iter++)
   {
-    // Clear new transition matrix and emission probabilities.
-    arma::mat newTransition(transition.n_rows, transition.n_cols);
-    newTransition.zeros();
-
-    // Reset log likelihood.
-    loglik = 0;
+    // Clear new transition matrix and emission probabilities.  Each block
+    // accumulates its own part of the new transition matrix.
+    std::vector<arma::mat> blockTransition(blocks,
+        arma::zeros<arma::mat>(transition.n_rows, transition.n_cols));
+    arma::vec blockLoglik(blocks);
+    blockLoglik.zeros();
 
-    // Sum over time.
-    size_t sumTime = 0;
+    for (size_t state = 0; state < emission.size(); state++)
+      PrepareEmission(emission[state]);
 
     // Loop over each sequence.
-    for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    #pragma omp parallel for num_threads(blocks) schedule(static)
+    for (int b = 0; b < (int) blocks; b++)
     {
-      arma::mat stateProb;
-      arma::mat forward;
-      arma::mat backward;
-      arma::vec scales;
-
-      // Add the log-likelihood of this sequence.  This is the E-step.
-      loglik += Estimate(dataSeq[seq], stateProb, forward, backward, scales);
-
-      // Now re-estimate the parameters.  This is the M-step.
-      //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t]) b(i,
-      //           t + 1)))
-      //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t) b(i, t)
-      // We store the new estimates in a different matrix.
-      for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
+      for (size_t seq = blockStart[b]; seq < blockStart[b + 1]; seq++)
       {
-        for (size_t j = 0; j < transition.n_cols; j++)
+        const size_t length = dataSeq[seq].n_cols;
+        if (length == 0)
+          continue;
+
+        arma::mat stateProb;
+        arma::mat forward;
+        arma::mat backward;
+        arma::vec scales;
+
+        // Evaluate each emission distribution on each observation once; this
+        // is shared by the forward and backward passes and the transition
+        // update.
+        arma::mat emissionSeqProb;
+        EmissionProbability(dataSeq[seq], emissionSeqProb);
+
+        // Add the log-likelihood of this sequence.  This is the E-step.
+        blockLoglik[b] += EstimateFromEmission(emissionSeqProb, stateProb,
+            forward, backward, scales);
+
+        // Now re-estimate the parameters.  This is the M-step.
+        //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(j, t) T_ij
+        //           E_i(seq[d][t + 1]) b(i, t + 1)))
+        //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t)
+        //           b(i, t)
+        // We store the new estimates in a different matrix.  The sum over t of
+        // the transition estimate is a matrix product, and we postpone
+        // multiplication of the old T_ij until later.
+        if (length > 1)
         {
-          if (t < dataSeq[seq].n_cols - 1)
-          {
-            // Estimate of T_ij (probability of transition from state j to state
-            // i).  We postpone multiplication of the old T_ij until later.
-            for (size_t i = 0; i < transition.n_rows; i++)
-              newTransition(i, j) += forward(j, t) * backward(i, t + 1) *
-                  emission[i].Probability(dataSeq[seq].unsafe_col(t + 1)) /
-                  scales[t + 1];
-          }
-
-          // Add to list of emission observations, for Distribution::Estimate().
-          emissionList.col(sumTime) = dataSeq[seq].col(t);
-          emissionProb[j][sumTime] = stateProb(j, t);
+          arma::mat weightedBackward = backward.cols(1, length - 1) %
+              emissionSeqProb.cols(1, length - 1);
+          for (size_t t = 0; t < weightedBackward.n_cols; t++)
+            weightedBackward.col(t) /= scales[t + 1];
+
+          blockTransition[b] += weightedBackward *
+              trans(forward.cols(0, length - 2));
         }
-        sumTime++;
+
+        // Add to list of emission probabilities, for Distribution::Estimate().
+        // Each sequence has its own range in the list.
+        for (size_t j = 0; j < transition.n_cols; j++)
+          emissionProb[j].subvec(offsets[seq], offsets[seq] + length - 1) =
+              trans(stateProb.row(j));
       }
     }
 
+    // Sum the results of each block, always in the same order.
+    arma::mat newTransition = arma::zeros<arma::mat>(transition.n_rows,
+        transition.n_cols);
+    loglik = 0;
+    for (size_t b = 0; b < blocks; b++)
+    {
+      newTransition += blockTransition[b];
+      loglik += blockLoglik[b];
+    }
+
     // Assign the new transition matrix.  We use %= (element-wise
     // multiplication) because every element of the new transition matrix must
     // still be multiplied by the old elements (this is the multiplication we
@@ -174,19 +253,24 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
       transition.col(i) /= accu(transition.col(i));
 
     // Now estimate emission probabilities.
-    for (size_t state = 0; state < transition.n_cols; state++)
-      emission[state].Estimate(emissionList, emissionProb[state]);
+    EstimateEmission(emissionList, emissionProb);
 
-    Log::Debug << "Iteration " << iter << ": log-likelihood " << loglik
+    MLPACK_LOG_DEBUG << "Iteration " << iter << ": log-likelihood " << loglik
         << std::endl;
 
     if (std::abs(oldLoglik - loglik) < tolerance)
     {
-      Log::Debug << "Converged after " << iter << " iterations." << std::endl;
+      MLPACK_LOG_DEBUG << "Converged after " << iter << " iterations."
+          << std::endl;
       break;
     }
 
     oldLoglik = loglik;
+
+    // The monitor may stop training after any iteration, keeping the current
+    // model.
+    if (monitor && !monitor->Continue("HMM::Train()", iter + 1, loglik))
+      break;
   }
 }
 
@@ -281,10 +365,28 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
                                    arma::mat& forwardProb,
                                    arma::mat& backwardProb,
                                    arma::vec& scales) const
+{
+  arma::mat emissionProb;
+  EmissionProbability(dataSeq, emissionProb);
+
+  return EstimateFromEmission(emissionProb, stateProb, forwardProb,
+      backwardProb, scales);
+}
+
+/**
+ * Run the forward-backward algorithm given precomputed emission
+ * probabilities.
+ */
+template<typename Distribution>
+double HMM<Distribution>::EstimateFromEmission(const arma::mat& emissionProb,
+                                               arma::mat& stateProb,
+                                               arma::mat& forwardProb,
+                                               arma::mat& backwardProb,
+                                               arma::vec& scales) const
 {
   // First run the forward-backward algorithm.
-  Forward(dataSeq, scales, forwardProb);
-  Backward(dataSeq, scales, backwardProb);
+  Forward(emissionProb, scales, forwardProb);
+  Backward(emissionProb, scales, backwardProb);
 
   // Now assemble the state probability matrix based on the forward and backward
   // probabilities.
@@ -367,48 +469,79 @@ template<typename Distribution>
 double HMM<Distribution>::Predict(const arma::mat& dataSeq,
                                   arma::Col<size_t>& stateSeq) const
 {
-  // This is an implementation of the Viterbi algorithm for finding the most
-  // probable sequence of states to produce the observed data sequence.  We
-  // don't use log-likelihoods to save that little bit of time, but we'll
-  // calculate the log-likelihood at the end of it all.
-  stateSeq.set_size(dataSeq.n_cols);
-  arma::mat logStateProb(transition.n_rows, dataSeq.n_cols);
-
-  // Store the logs of the transposed transition matrix.  This is because we
-  // will be using the rows of the transition matrix.
-  arma::mat logTrans(log(trans(transition)));
-
-  // The calculation of the first state is slightly different; the probability
-  // of the first state being state j is the maximum probability that the state
-  // came to be j from another state.
-  logStateProb.col(0).zeros();
-  for (size_t state = 0; state < transition.n_rows; state++)
-    logStateProb[state] = log(transition(state, 0) *
-        emission[state].Probability(dataSeq.unsafe_col(0)));
+  return Viterbi(dataSeq, arma::mat(log(transition)), stateSeq);
+}
 
-  // Store the best first state.
-  arma::uword index;
-  logStateProb.unsafe_col(0).max(index);
-  stateSeq[0] = index;
+/**
+ * The Viterbi algorithm, in log-space, with the logarithm of the transition
+ * matrix already computed.
+ */
+template<typename Distribution>
+double HMM<Distribution>::Viterbi(const arma::mat& dataSeq,
+                                  const arma::mat& logTransition,
+                                  arma::Col<size_t>& stateSeq) const
+{
+  const size_t states = transition.n_rows;
+  stateSeq.set_size(dataSeq.n_cols);
+  if (dataSeq.n_cols == 0)
+    return 0.0;
+
+  // Evaluate the emission distributions on every observation up front.
+  arma::mat logEmissionProb;
+  EmissionProbability(dataSeq, logEmissionProb);
+  logEmissionProb = log(logEmissionProb);
+
+  // logPathProb(j, t) is the log-probability of the most probable path which
+  // ends in state j at time t, and backPointer(j, t) is the state it was in at
+  // time t - 1.  The sequence always starts from state 0.
+  arma::mat logPathProb(states, dataSeq.n_cols);
+  arma::Mat<size_t> backPointer(states, dataSeq.n_cols);
+  logPathProb.col(0) = logTransition.col(0) + logEmissionProb.col(0);
+
+  const size_t beam = (beamWidth == 0 || beamWidth > states) ? states :
+      beamWidth;
+  arma::uvec active = arma::linspace<arma::uvec>(0, states - 1, states);
+  arma::vec best(states);
 
   for (size_t t = 1; t < dataSeq.n_cols; t++)
   {
-    // Assemble the state probability for this element.
-    // Given that we are in state j, we state with the highest probability of
-    // being the previous state.
-    for (size_t j = 0; j < transition.n_rows; j++)
+    // With a beam, only the most probable states at time t - 1 are extended.
+    if (beam < states)
     {
-      arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
-      logStateProb(j, t) = prob.max() +
-          log(emission[j].Probability(dataSeq.unsafe_col(t)));
+      const arma::uvec order = arma::sort_index(-logPathProb.col(t - 1));
+      active = order.rows(0, beam - 1);
     }
 
-    // Store the best state.
-    logStateProb.unsafe_col(t).max(index);
-    stateSeq[t] = index;
+    // Take the maximum over the previous states one column of the log
+    // transition matrix at a time, so every pass is contiguous.
+    best.fill(-std::numeric_limits<double>::infinity());
+    backPointer.col(t).fill(active[0]);
+    for (size_t k = 0; k < active.n_elem; k++)
+    {
+      const size_t previous = active[k];
+      const double logPrevious = logPathProb(previous, t - 1);
+      const double* logTrans = logTransition.colptr(previous);
+      for (size_t j = 0; j < states; j++)
+      {
+        if (logPrevious + logTrans[j] > best[j])
+        {
+          best[j] = logPrevious + logTrans[j];
+          backPointer(j, t) = previous;
+        }
+      }
+    }
+
+    logPathProb.col(t) = best + logEmissionProb.col(t);
   }
 
-  return logStateProb(stateSeq(dataSeq.n_cols - 1), dataSeq.n_cols - 1);
+  // Trace the most probable path back from its last state.
+  arma::uword index;
+  const double logLikelihood = logPathProb.col(dataSeq.n_cols - 1).max(index);
+  stateSeq[dataSeq.n_cols - 1] = index;
+  for (size_t t = dataSeq.n_cols - 1; t > 0; t--)
+    stateSeq[t - 1] = backPointer(stateSeq[t], t);
+
+  return logLikelihood;
 }
 
 /**
@@ -417,50 +550,133 @@ double HMM<Distribution>::Predict(const arma::mat& dataSeq,
 template<typename Distribution>
 double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
 {
+  arma::mat emissionProb;
   arma::mat forward;
   arma::vec scales;
 
-  Forward(dataSeq, scales, forward);
+  EmissionProbability(dataSeq, emissionProb);
+  Forward(emissionProb, scales, forward);
 
   // The log-likelihood is the log of the scales for each time step.
   return accu(log(scales));
 }
 
+/**
+ * Compute the emission probability of each observation under each state.
+ */
+template<typename Distribution>
+void HMM<Distribution>::EmissionProbability(const arma::mat& dataSeq,
+                                            arma::mat& emissionProb) const
+{
+  emissionProb.set_size(transition.n_rows, dataSeq.n_cols);
+
+  for (size_t t = 0; t < dataSeq.n_cols; t++)
+    for (size_t state = 0; state < transition.n_rows; state++)
+      emissionProb(state, t) = emission[state].Probability(
+          dataSeq.unsafe_col(t));
+}
+
+/**
+ * Re-estimate each emission distribution from the observations, weighted by
+ * the probability of each observation coming from that state.
+ */
+template<typename Distribution>
+void HMM<Distribution>::EstimateEmission(
+    const arma::mat& observations,
+    const std::vector<arma::vec>& stateProb)
+{
+  // The distributions are independent, so they are estimated at once (for a
+  // GMM, each is a whole EM fit).  Each state draws from its own random stream,
+  // so the result does not depend on which thread estimates it.
+  const math::RandomStream base = math::DrawStream();
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic, 1)
+  for (int state = 0; state < (int) emission.size(); state++)
+  {
+    math::ScopedThreadStream stream(base.Split((size_t) state));
+    emission[state].Estimate(observations, stateProb[state]);
+  }
+}
+
+/**
+ * Compute the most probable hidden state sequence of each of the given data
+ * sequences.
+ */
+template<typename Distribution>
+void HMM<Distribution>::Predict(const std::vector<arma::mat>& dataSeq,
+                                std::vector<arma::Col<size_t> >& stateSeq,
+                                arma::vec& logLikelihoods) const
+{
+  stateSeq.resize(dataSeq.size());
+  logLikelihoods.set_size(dataSeq.size());
+
+  for (size_t state = 0; state < emission.size(); state++)
+    PrepareEmission(emission[state]);
+
+  // The log transition matrix is shared by every sequence.
+  const arma::mat logTransition(log(transition));
+
+  // Each sequence is independent, and writes only to its own results.
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic)
+  for (int seq = 0; seq < (int) dataSeq.size(); seq++)
+    logLikelihoods[seq] = Viterbi(dataSeq[seq], logTransition, stateSeq[seq]);
+}
+
+/**
+ * Compute the log-likelihood of each of the given data sequences.
+ */
+template<typename Distribution>
+void HMM<Distribution>::LogLikelihood(const std::vector<arma::mat>& dataSeq,
+                                      arma::vec& logLikelihoods) const
+{
+  logLikelihoods.set_size(dataSeq.size());
+
+  for (size_t state = 0; state < emission.size(); state++)
+    PrepareEmission(emission[state]);
+
+  // Each sequence is independent, and writes only to its own result.
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic)
+  for (int seq = 0; seq < (int) dataSeq.size(); seq++)
+    logLikelihoods[seq] = LogLikelihood(dataSeq[seq]);
+}
+
+/**
+ * Resolve the number of threads to use.
+ */
+template<typename Distribution>
+size_t HMM<Distribution>::NumThreads() const
+{
+  return Threads::Count(threads);
+}
+
 /**
  * The Forward procedure (part of the Forward-Backward algorithm).
  */
 template<typename Distribution>
-void HMM<Distribution>::Forward(const arma::mat& dataSeq,
+void HMM<Distribution>::Forward(const arma::mat& emissionProb,
                                 arma::vec& scales,
                                 arma::mat& forwardProb) const
 {
   // Our goal is to calculate the forward probabilities:
   //  P(X_k | o_{1:k}) for all possible states X_k, for each time point k.
-  forwardProb.zeros(transition.n_rows, dataSeq.n_cols);
-  scales.zeros(dataSeq.n_cols);
+  forwardProb.zeros(transition.n_rows, emissionProb.n_cols);
+  scales.zeros(emissionProb.n_cols);
 
   // Starting state (at t = -1) is assumed to be state 0.  This is what MATLAB
   // does in their hmmdecode() function, so we will emulate that behavior.
-  for (size_t state = 0; state < transition.n_rows; state++)
-    forwardProb(state, 0) = transition(state, 0) *
-        emission[state].Probability(dataSeq.unsafe_col(0));
+  forwardProb.col(0) = transition.col(0) % emissionProb.col(0);
 
   // Then normalize the column.
   scales[0] = accu(forwardProb.col(0));
   forwardProb.col(0) /= scales[0];
 
   // Now compute the probabilities for each successive observation.
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  for (size_t t = 1; t < emissionProb.n_cols; t++)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The forward probability of state j at time t is the sum over all states
-      // of the probability of the previous state transitioning to the current
-      // state and emitting the given observation.
-      forwardProb(j, t) = accu(forwardProb.col(t - 1) %
-          trans(transition.row(j))) *
-          emission[j].Probability(dataSeq.unsafe_col(t));
-    }
+    // The forward probability of state j at time t is the sum over all states
+    // of the probability of the previous state transitioning to the current
+    // state and emitting the given observation.
+    forwardProb.col(t) = (transition * forwardProb.col(t - 1)) %
+        emissionProb.col(t);
 
     // Normalize probability.
     scales[t] = accu(forwardProb.col(t));
@@ -469,33 +685,119 @@ void HMM<Distribution>::Forward(const arma::mat& dataSeq,
 }
 
 template<typename Distribution>
-void HMM<Distribution>::Backward(const arma::mat& dataSeq,
+void HMM<Distribution>::Backward(const arma::mat& emissionProb,
                                  const arma::vec& scales,
                                  arma::mat& backwardProb) const
 {
   // Our goal is to calculate the backward probabilities:
   //  P(X_k | o_{k + 1:T}) for all possible states X_k, for each time point k.
-  backwardProb.zeros(transition.n_rows, dataSeq.n_cols);
+  backwardProb.zeros(transition.n_rows, emissionProb.n_cols);
 
   // The last element probability is 1.
-  backwardProb.col(dataSeq.n_cols - 1).fill(1);
+  backwardProb.col(emissionProb.n_cols - 1).fill(1);
+
+  // We will be using the columns of the transposed transition matrix.
+  const arma::mat transTransition = trans(transition);
 
   // Now step backwards through all other observations.
-  for (size_t t = dataSeq.n_cols - 2; t + 1 > 0; t--)
+  for (size_t t = emissionProb.n_cols - 2; t + 1 > 0; t--)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The backward probability of state j at time t is the sum over all state
-      // of the probability of the next state having been a transition from the
-      // current state multiplied by the probability of each of those states
-      // emitting the given observation.
-      for (size_t state = 0; state < transition.n_rows; state++)
-        backwardProb(j, t) += transition(state, j) * backwardProb(state, t + 1)
-            * emission[state].Probability(dataSeq.unsafe_col(t + 1));
-
-      // Normalize by the weights from the forward algorithm.
-      backwardProb(j, t) /= scales[t + 1];
-    }
+    // The backward probability of state j at time t is the sum over all states
+    // of the probability of the next state having been a transition from the
+    // current state multiplied by the probability of each of those states
+    // emitting the given observation.  Then we normalize by the weights from
+    // the forward algorithm.
+    backwardProb.col(t) = transTransition * (backwardProb.col(t + 1) %
+        emissionProb.col(t + 1)) / scales[t + 1];
+  }
+}
+
+/**
+ * Return the symbol of each observation of a discrete HMM, rounding as
+ * DiscreteDistribution does, and check that every symbol is below the given
+ * number of symbols.
+ */
+inline void DiscreteSymbols(const arma::mat& dataSeq,
+                            const size_t numSymbols,
+                            std::vector<size_t>& symbols)
+{
+  symbols.resize(dataSeq.n_cols);
+  for (size_t t = 0; t < dataSeq.n_cols; t++)
+  {
+    symbols[t] = size_t(dataSeq(0, t) + 0.5);
+    if (symbols[t] >= numSymbols)
+      Log::Fatal << "HMM: observation " << t << " (" << symbols[t] << ") is "
+          << "invalid; observations must be in [0, " << numSymbols << ")."
+          << std::endl;
+  }
+}
+
+/**
+ * For discrete emissions, the emission probabilities of an observation are a
+ * column of the table of the emission probabilities of each state, so the
+ * table is assembled once and each observation is a column copy.
+ */
+template<>
+inline void HMM<distribution::DiscreteDistribution>::EmissionProbability(
+    const arma::mat& dataSeq,
+    arma::mat& emissionProb) const
+{
+  // table(j, s) is the probability of symbol s in state j.  States may have
+  // different numbers of symbols; the missing ones have probability 0.
+  size_t numSymbols = 0;
+  for (size_t state = 0; state < emission.size(); state++)
+    numSymbols = std::max(numSymbols,
+        (size_t) emission[state].Probabilities().n_elem);
+
+  arma::mat table = arma::zeros<arma::mat>(emission.size(), numSymbols);
+  for (size_t state = 0; state < emission.size(); state++)
+  {
+    const arma::vec& probabilities = emission[state].Probabilities();
+    for (size_t s = 0; s < probabilities.n_elem; s++)
+      table(state, s) = probabilities[s];
+  }
+
+  std::vector<size_t> symbols;
+  DiscreteSymbols(dataSeq, numSymbols, symbols);
+
+  emissionProb.set_size(emission.size(), dataSeq.n_cols);
+  for (size_t t = 0; t < dataSeq.n_cols; t++)
+    emissionProb.unsafe_col(t) = table.unsafe_col(symbols[t]);
+}
+
+/**
+ * For discrete emissions, the Baum-Welch update of each state is a weighted
+ * count of the symbols, so the observations are turned into symbols once for
+ * all states.
+ */
+template<>
+inline void HMM<distribution::DiscreteDistribution>::EstimateEmission(
+    const arma::mat& observations,
+    const std::vector<arma::vec>& stateProb)
+{
+  size_t numSymbols = 0;
+  for (size_t state = 0; state < emission.size(); state++)
+    numSymbols = std::max(numSymbols,
+        (size_t) emission[state].Probabilities().n_elem);
+
+  std::vector<size_t> symbols;
+  DiscreteSymbols(observations, numSymbols, symbols);
+
+  for (size_t state = 0; state < emission.size(); state++)
+  {
+    arma::vec& probabilities = emission[state].Probabilities();
+    probabilities.zeros();
+
+    const double* weights = stateProb[state].memptr();
+    for (size_t i = 0; i < symbols.size(); i++)
+      if (symbols[i] < probabilities.n_elem)
+        probabilities[symbols[i]] += weights[i];
+
+    const double sum = accu(probabilities);
+    if (sum > 0)
+      probabilities /= sum;
+    else
+      probabilities.fill(1.0 / probabilities.n_elem);
   }
 }
 
@@ -58,10 +58,14 @@ PARAM_INT("gaussians", "Number of gaussians in each GMM (necessary when type is"
 PARAM_STRING("model_file", "Pre-existing HMM model (optional).", "m", "");
 PARAM_STRING("labels_file", "Optional file of hidden states, used for "
     "labeled training.", "l", "");
-PARAM_STRING("output_file", "File to save trained HMM to (XML).", "o",
+PARAM_STRING("output_file", "File to save trained HMM to (XML, or binary if "
+    "the extension is '.bin').", "o",
     "output_hmm.xml");
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_DOUBLE("tolerance", "Tolerance of the Baum-Welch algorithm.", "T", 1e-5);
+PARAM_INT("threads", "Number of threads to use for Baum-Welch training over "
+    "multiple sequences (0 uses all available cores).  This only has an effect "
+    "if MLPACK was built with OpenMP.", "j", 1);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -92,6 +96,7 @@ int main(int argc, char** argv)
   const int states = CLI::GetParam<int>("states");
   const bool batch = CLI::HasParam("batch");
   const double tolerance = CLI::GetParam<double>("tolerance");
+  const int threads = CLI::GetParam<int>("threads");
 
   // Validate number of states.
   if (states == 0 && modelFile == "")
@@ -106,6 +111,12 @@ int main(int argc, char** argv)
         << " than or equal to 1." << endl;
   }
 
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads (" << threads << "); must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Load the dataset(s) and labels.
   vector<mat> trainSeq;
   vector<arma::Col<size_t> > labelSeq; // May be empty.
@@ -257,6 +268,8 @@ int main(int argc, char** argv)
           DiscreteDistribution(maxEmission), tolerance);
     }
 
+    hmm.Threads() = (size_t) threads;
+
     // Do we have labels?
     if (labelsFile == "")
       hmm.Train(trainSeq); // Unsupervised training.
@@ -301,6 +314,7 @@ int main(int argc, char** argv)
             << dimensionality << ")!" << endl;
 
     // Now run the training.
+    hmm.Threads() = (size_t) threads;
     if (labelsFile == "")
       hmm.Train(trainSeq); // Unsupervised training.
     else
@@ -354,6 +368,7 @@ int main(int argc, char** argv)
             << dimensionality << ")!" << endl;
 
     // Now run the training.
+    hmm.Threads() = (size_t) threads;
     if (labelsFile == "")
     {
       Log::Warn << "Unlabeled training of GMM HMMs is almost certainly not "
@@ -31,12 +31,20 @@ PROGRAM_INFO("Hidden Markov Model (HMM) Viterbi State Prediction", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "most probably hidden state sequence of a given sequence of observations "
     "(--input_file), using the Viterbi algorithm.  The computed state sequence "
-    "is saved to the specified output file (--output_file).");
+    "is saved to the specified output file (--output_file)."
+    "\n\n"
+    "For models with many states, --beam_width (-b) keeps only the given "
+    "number of most probable states at each step of the algorithm; this is "
+    "faster, but may not find the most probable state sequence.  A beam width "
+    "of 0 (the default) keeps every state.");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
-PARAM_STRING_REQ("model_file", "File containing HMM (XML).", "m");
+PARAM_STRING_REQ("model_file", "File containing HMM (XML or binary).",
+    "m");
 PARAM_STRING("output_file", "File to save predicted state sequence to.", "o",
     "output.csv");
+PARAM_INT("beam_width", "Number of states kept at each step of the Viterbi "
+    "algorithm (0 keeps every state).", "b", 0);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -55,6 +63,10 @@ int main(int argc, char** argv)
   const string inputFile = CLI::GetParam<string>("input_file");
   const string modelFile = CLI::GetParam<string>("model_file");
 
+  const int beamWidth = CLI::GetParam<int>("beam_width");
+  if (beamWidth < 0)
+    Log::Fatal << "--beam_width (-b) must be non-negative." << endl;
+
   mat dataSeq;
   data::Load(inputFile, dataSeq, true);
 
@@ -70,6 +82,7 @@ int main(int argc, char** argv)
     HMM<DiscreteDistribution> hmm(1, DiscreteDistribution(1));
 
     LoadHMM(hmm, sr);
+    hmm.BeamWidth() = (size_t) beamWidth;
 
     // Verify only one row in observations.
     if (dataSeq.n_cols == 1)
@@ -86,6 +99,7 @@ int main(int argc, char** argv)
     HMM<GaussianDistribution> hmm(1, GaussianDistribution(1));
 
     LoadHMM(hmm, sr);
+    hmm.BeamWidth() = (size_t) beamWidth;
 
     // Verify correct dimensionality.
     if (dataSeq.n_rows != hmm.Emission()[0].Mean().n_elem)
@@ -100,6 +114,7 @@ int main(int argc, char** argv)
     HMM<GMM<> > hmm(1, GMM<>(1, 1));
 
     LoadHMM(hmm, sr);
+    hmm.BeamWidth() = (size_t) beamWidth;
 
     // Verify correct dimensionality.
     if (dataSeq.n_rows != hmm.Emission()[0].Dimensionality())
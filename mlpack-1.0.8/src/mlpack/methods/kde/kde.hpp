@@ -0,0 +1,206 @@
+/**
+ * @file kde.hpp
+ *
+ * Defines the KDE class, which performs kernel density estimation with
+ * dual-tree or single-tree algorithms.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_HPP
+#define __MLPACK_METHODS_KDE_KDE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/parallel_dual_tree_traverser.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde /** Kernel density estimation. */ {
+
+/**
+ * The KDE class performs kernel density estimation: for each query point q, it
+ * estimates
+ *
+ *   f(q) = (1 / N) sum_{i = 1}^{N} K(d(q, r_i))
+ *
+ * where r_1, ..., r_N are the reference points, d is the metric and K is the
+ * kernel.  (The estimates are not divided by the normalizer of the kernel,
+ * which depends on the dimensionality; see the kde program.)  When the query
+ * set is the reference set, each point contributes to its own estimate.
+ *
+ * Computing the estimates exactly takes O(N^2) kernel evaluations.  Instead,
+ * trees are built on both datasets, and a reference node whose kernel values
+ * with a query node are all close enough is accounted for at once (see
+ * KDERules); each estimate is then within RelativeError() of the true estimate
+ * plus AbsoluteError().  The algorithm is that of
+ *
+ * @code
+ * @inproceedings{gray2003nonparametric,
+ *   title={Nonparametric Density Estimation: Toward Computational
+ *       Tractability},
+ *   author={Gray, A.G. and Moore, A.W.},
+ *   booktitle={Proceedings of the 2003 SIAM International Conference on Data
+ *       Mining},
+ *   pages={203--211},
+ *   year={2003}
+ * }
+ * @endcode
+ *
+ * @tparam KernelType Kernel to use; it must provide Evaluate(distance), and
+ *     not increase with the distance.
+ * @tparam MetricType Metric to use.
+ * @tparam TreeType Type of tree to use; the base cases must not be calculated
+ *     in Score() (TreeTraits::FirstPointIsCentroid), so cover trees cannot be
+ *     used.
+ */
+template<typename KernelType = kernel::GaussianKernel,
+         typename MetricType = metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+                                                   tree::EmptyStatistic> >
+class KDE
+{
+ public:
+  /**
+   * Initialize the KDE object with a reference set and a query set, and build
+   * the trees on copies of them.  Optionally, perform the computation in naive
+   * mode or single-tree mode, and set the leaf size used for tree-building.
+   *
+   * @param referenceSet Reference dataset.
+   * @param querySet Query dataset.
+   * @param kernel Instantiated kernel.
+   * @param naive Whether the computation should be done in O(n^2) naive mode.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param leafSize The leaf size to be used during tree construction.
+   * @param metric Instantiated distance metric.
+   */
+  KDE(const typename TreeType::Mat& referenceSet,
+      const typename TreeType::Mat& querySet,
+      const KernelType kernel = KernelType(),
+      const bool naive = false,
+      const bool singleMode = false,
+      const size_t leafSize = 20,
+      const MetricType metric = MetricType());
+
+  /**
+   * Initialize the KDE object with only a reference set, which will also be
+   * used as the query set, and build the tree on a copy of it.
+   *
+   * @param referenceSet Reference dataset.
+   * @param kernel Instantiated kernel.
+   * @param naive Whether the computation should be done in O(n^2) naive mode.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param leafSize The leaf size to be used during tree construction.
+   * @param metric Instantiated distance metric.
+   */
+  KDE(const typename TreeType::Mat& referenceSet,
+      const KernelType kernel = KernelType(),
+      const bool naive = false,
+      const bool singleMode = false,
+      const size_t leafSize = 20,
+      const MetricType metric = MetricType());
+
+  /**
+   * Destroy the KDE object and the trees.
+   */
+  ~KDE();
+
+  /**
+   * Estimate the density at each query point.
+   *
+   * @param estimates Will be set to the density estimate of each query point,
+   *     in the original order of the query points.
+   */
+  void Evaluate(arma::vec& estimates);
+
+  //! Get the relative error allowed for each estimate.
+  double RelativeError() const { return relativeError; }
+  //! Modify the relative error allowed for each estimate (default 0.05).
+  double& RelativeError() { return relativeError; }
+
+  //! Get the absolute error allowed for each estimate.
+  double AbsoluteError() const { return absoluteError; }
+  //! Modify the absolute error allowed for each estimate (default 0).
+  double& AbsoluteError() { return absoluteError; }
+
+  //! Get the number of threads used for tree-based estimation.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for tree-based estimation (1 is
+  //! serial, 0 means all available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the kernel.
+  KernelType& Kernel() { return kernel; }
+
+ private:
+  //! Copy of reference matrix, which the reference tree is built on.
+  typename TreeType::Mat referenceCopy;
+  //! Copy of query matrix, which the query tree is built on.
+  typename TreeType::Mat queryCopy;
+
+  //! Reference set (data should be accessed using this).
+  const typename TreeType::Mat& referenceSet;
+  //! Query set (data should be accessed using this).
+  const typename TreeType::Mat& querySet;
+
+  //! Reference tree.
+  TreeType* referenceTree;
+  //! Query tree (NULL in single-tree mode with one dataset).
+  TreeType* queryTree;
+
+  //! Mappings to old reference indices.
+  std::vector<size_t> oldFromNewReferences;
+  //! Mappings to old query indices.
+  std::vector<size_t> oldFromNewQueries;
+
+  //! If true, a query set was passed; if false, the query set is the reference
+  //! set.
+  bool hasQuerySet;
+  //! If true, O(n^2) naive computation is used.
+  bool naive;
+  //! If true, single-tree computation is used.
+  bool singleMode;
+
+  //! Instantiated kernel.
+  KernelType kernel;
+  //! Instantiated distance metric.
+  MetricType metric;
+
+  //! The relative error allowed for each estimate.
+  double relativeError;
+  //! The absolute error allowed for each estimate.
+  double absoluteError;
+
+  //! Number of threads to use for tree-based estimation.
+  size_t threads;
+};
+
+}; // namespace kde
+}; // namespace mlpack
+
+// Include implementation.
+#include "kde_impl.hpp"
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file kde_impl.hpp
+ *
+ * Implementation of the KDE class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+
+// Just in case it hasn't been included.
+#include "kde.hpp"
+
+namespace mlpack {
+namespace kde {
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::KDE(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const KernelType kernel,
+    const bool naive,
+    const bool singleMode,
+    const size_t leafSize,
+    const MetricType metric) :
+    referenceCopy(referenceSet),
+    queryCopy(querySet),
+    referenceSet(referenceCopy),
+    querySet(queryCopy),
+    hasQuerySet(true),
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    kernel(kernel),
+    metric(metric),
+    relativeError(0.05),
+    absoluteError(0.0),
+    threads(1)
+{
+  Timer::Start("kde/tree_building");
+
+  // Naive sets the leaf size such that the entire tree is one node.
+  referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
+      (naive ? referenceCopy.n_cols : leafSize));
+  queryTree = new TreeType(queryCopy, oldFromNewQueries,
+      (naive ? queryCopy.n_cols : leafSize));
+
+  Timer::Stop("kde/tree_building");
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::KDE(
+    const typename TreeType::Mat& referenceSet,
+    const KernelType kernel,
+    const bool naive,
+    const bool singleMode,
+    const size_t leafSize,
+    const MetricType metric) :
+    referenceCopy(referenceSet),
+    referenceSet(referenceCopy),
+    querySet(referenceCopy),
+    queryTree(NULL),
+    hasQuerySet(false),
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    kernel(kernel),
+    metric(metric),
+    relativeError(0.05),
+    absoluteError(0.0),
+    threads(1)
+{
+  Timer::Start("kde/tree_building");
+
+  referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
+      (naive ? referenceCopy.n_cols : leafSize));
+
+  // Dual-tree estimation needs a second tree.
+  if (!this->singleMode)
+    queryTree = new TreeType(*referenceTree);
+
+  Timer::Stop("kde/tree_building");
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::~KDE()
+{
+  delete referenceTree;
+  if (queryTree)
+    delete queryTree;
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+void KDE<KernelType, MetricType, TreeType>::Evaluate(arma::vec& estimates)
+{
+  if (relativeError < 0.0 || absoluteError < 0.0)
+    Log::Fatal << "KDE::Evaluate(): the relative error (" << relativeError
+        << ") and the absolute error (" << absoluteError << ") must be "
+        << "non-negative." << std::endl;
+
+  Timer::Start("kde/computing_estimates");
+
+  // Each query point has its own estimate, so threads working on different
+  // query points do not interfere.  Naive estimation is exact.
+  arma::vec treeEstimates;
+  treeEstimates.zeros(querySet.n_cols);
+  typedef KDERules<MetricType, KernelType, TreeType> BaseRuleType;
+  typename tree::TraversalRules<BaseRuleType>::Type rules(BaseRuleType(
+      referenceSet, querySet, treeEstimates, (naive ? 0.0 : relativeError),
+      (naive ? 0.0 : absoluteError), metric, kernel));
+
+  const size_t numThreads = mlpack::Threads::Count(threads);
+  size_t numPrunes = 0;
+
+  tree::TraversalStatistics::Start();
+
+  if (singleMode)
+  {
+    #pragma omp parallel num_threads(numThreads) reduction(+:numPrunes)
+    {
+      typename tree::TraversalRules<BaseRuleType>::Type threadRules(rules);
+      typename TreeType::template SingleTreeTraverser<
+          typename tree::TraversalRules<BaseRuleType>::Type>
+          traverser(threadRules);
+
+      #pragma omp for schedule(dynamic, 64)
+      for (int i = 0; i < (int) querySet.n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
+
+      numPrunes += traverser.NumPrunes();
+    }
+  }
+  else
+  {
+    tree::ParallelDualTreeTraverser<TreeType,
+        typename tree::TraversalRules<BaseRuleType>::Type> traverser(rules,
+        numThreads);
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    numPrunes = traverser.NumPrunes();
+  }
+
+  tree::TraversalStatistics::Stop();
+
+  Timer::Stop("kde/computing_estimates");
+
+  Log::Info << "Number of pruned nodes during computation: " << numPrunes
+      << "." << std::endl;
+
+  // Average the kernel values, and map the estimates back to the original
+  // order of the query points.
+  treeEstimates /= referenceSet.n_cols;
+  const std::vector<size_t>& queryMap = hasQuerySet ? oldFromNewQueries :
+      oldFromNewReferences;
+  estimates.set_size(querySet.n_cols);
+  for (size_t i = 0; i < treeEstimates.n_elem; ++i)
+    estimates[queryMap[i]] = treeEstimates[i];
+}
+
+}; // namespace kde
+}; // namespace mlpack
+
+#endif
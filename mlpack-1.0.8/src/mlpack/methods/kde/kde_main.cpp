@@ -0,0 +1,192 @@
+/**
+ * @file kde_main.cpp
+ *
+ * Executable for kernel density estimation.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+
+#include "kde.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+
+PROGRAM_INFO("Kernel Density Estimation",
+    "This program estimates the density of the points of the reference file "
+    "at each point of the query file (or at each reference point, if no query "
+    "file is given), with the given kernel and bandwidth:"
+    "\n\n"
+    "  f(q) = (1 / N) sum_i K(|| q - r_i ||)"
+    "\n\n"
+    "The kernels that are supported are 'gaussian', 'epanechnikov', "
+    "'laplacian' and 'triangular'.  The estimates of the 'gaussian' and "
+    "'epanechnikov' kernels are divided by the normalizer of the kernel, so "
+    "they are densities; those of the other kernels are not."
+    "\n\n"
+    "Instead of evaluating the kernel between every pair of points, kd-trees "
+    "are built on the datasets, and the contribution of a whole node of "
+    "reference points to a node of query points is approximated when it is "
+    "known to within the allowed error.  Each estimate is within "
+    "--relative_error (-e) of the true estimate plus --absolute_error (-a).  "
+    "The --naive (-N) option computes the exact estimates, and --single_mode "
+    "(-S) uses single-tree instead of dual-tree estimation."
+    "\n\n"
+    "The estimates are saved to --output_file (-o), one line for each query "
+    "point.");
+
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
+    "r");
+PARAM_STRING("query_file", "File containing the query points (optional).",
+    "q", "");
+PARAM_STRING("output_file", "File to save the estimates to.", "o",
+    "estimates.csv");
+
+PARAM_STRING("kernel", "Kernel to use: 'gaussian', 'epanechnikov', "
+    "'laplacian' or 'triangular'.", "k", "gaussian");
+PARAM_DOUBLE("bandwidth", "Bandwidth of the kernel.", "b", 1.0);
+PARAM_DOUBLE("relative_error", "Relative error allowed for each estimate.",
+    "e", 0.05);
+PARAM_DOUBLE("absolute_error", "Absolute error allowed for each estimate.",
+    "a", 0.0);
+
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_FLAG("naive", "If true, the exact estimates are computed in O(n^2) "
+    "time.", "N");
+PARAM_FLAG("single_mode", "If true, single-tree estimation is used (as opposed "
+    "to dual-tree estimation).", "S");
+PARAM_INT("threads", "Number of threads to use for tree-based estimation (0 "
+    "means all available cores).", "j", 1);
+
+// Only some kernels can be normalized to integrate to one.
+template<typename KernelType>
+double Normalizer(KernelType& /* kernel */, const size_t /* dimension */)
+{
+  return 1.0;
+}
+
+double Normalizer(GaussianKernel& kernel, const size_t dimension)
+{
+  return kernel.Normalizer(dimension);
+}
+
+double Normalizer(EpanechnikovKernel& kernel, const size_t dimension)
+{
+  return kernel.Normalizer(dimension);
+}
+
+// Estimate the densities with the given kernel.
+template<typename KernelType>
+void RunKDE(KernelType kernel,
+            const arma::mat& referenceData,
+            const arma::mat& queryData,
+            const size_t leafSize,
+            const size_t threads,
+            arma::vec& estimates)
+{
+  const bool naive = CLI::HasParam("naive");
+  const bool singleMode = CLI::HasParam("single_mode");
+
+  KDE<KernelType>* kde;
+  if (queryData.n_cols > 0)
+    kde = new KDE<KernelType>(referenceData, queryData, kernel, naive,
+        singleMode, leafSize);
+  else
+    kde = new KDE<KernelType>(referenceData, kernel, naive, singleMode,
+        leafSize);
+
+  kde->RelativeError() = CLI::GetParam<double>("relative_error");
+  kde->AbsoluteError() = CLI::GetParam<double>("absolute_error");
+  kde->Threads() = threads;
+  kde->Evaluate(estimates);
+  delete kde;
+
+  estimates /= Normalizer(kernel, referenceData.n_rows);
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string queryFile = CLI::GetParam<string>("query_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string kernelType = CLI::GetParam<string>("kernel");
+  const double bandwidth = CLI::GetParam<double>("bandwidth");
+  const int leafSize = CLI::GetParam<int>("leaf_size");
+  const int threads = CLI::GetParam<int>("threads");
+
+  // Sanity check the parameters.
+  if (bandwidth <= 0.0)
+    Log::Fatal << "Invalid bandwidth: " << bandwidth << ".  Must be greater "
+        << "than 0." << endl;
+  if (leafSize <= 0)
+    Log::Fatal << "Invalid leaf size: " << leafSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  if (CLI::GetParam<double>("relative_error") < 0.0 ||
+      CLI::GetParam<double>("absolute_error") < 0.0)
+    Log::Fatal << "--relative_error (-e) and --absolute_error (-a) must be "
+        << "non-negative." << endl;
+  if (CLI::HasParam("naive") && CLI::HasParam("single_mode"))
+    Log::Warn << "--single_mode ignored because --naive is present." << endl;
+
+  arma::mat referenceData;
+  data::Load(referenceFile, referenceData, true);
+  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+
+  arma::mat queryData;
+  if (queryFile != "")
+  {
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "' ("
+        << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+
+    if (queryData.n_rows != referenceData.n_rows)
+      Log::Fatal << "The query data has dimensionality " << queryData.n_rows
+          << ", but the reference data has dimensionality "
+          << referenceData.n_rows << "." << endl;
+  }
+
+  arma::vec estimates;
+  if (kernelType == "gaussian")
+    RunKDE(GaussianKernel(bandwidth), referenceData, queryData,
+        (size_t) leafSize, (size_t) threads, estimates);
+  else if (kernelType == "epanechnikov")
+    RunKDE(EpanechnikovKernel(bandwidth), referenceData, queryData,
+        (size_t) leafSize, (size_t) threads, estimates);
+  else if (kernelType == "laplacian")
+    RunKDE(LaplacianKernel(bandwidth), referenceData, queryData,
+        (size_t) leafSize, (size_t) threads, estimates);
+  else if (kernelType == "triangular")
+    RunKDE(TriangularKernel(bandwidth), referenceData, queryData,
+        (size_t) leafSize, (size_t) threads, estimates);
+  else
+    Log::Fatal << "Invalid kernel '" << kernelType << "'; valid choices are "
+        << "'gaussian', 'epanechnikov', 'laplacian' and 'triangular'." << endl;
+
+  // The estimates are saved as a column, one line for each query point.
+  data::Save(outputFile, estimates, true, false);
+}
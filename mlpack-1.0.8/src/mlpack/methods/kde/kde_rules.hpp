@@ -0,0 +1,172 @@
+/**
+ * @file kde_rules.hpp
+ *
+ * Rules for dual-tree and single-tree kernel density estimation, which bound
+ * the contribution of a reference node with the distance to it and prune when
+ * the bound is tight enough.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * The rules for kernel density estimation.  The kernel must be a
+ * non-increasing function of the distance (as the Gaussian, Epanechnikov,
+ * triangular, Laplacian and spherical kernels are), so the kernel values
+ * between a query node and a reference node lie between the kernel of the
+ * largest and of the smallest distance between the nodes.  When the half-width
+ * of that interval is at most
+ *
+ *   relativeError * (kernel of the largest distance) + absoluteError,
+ *
+ * the reference node is pruned, and the middle of the interval is added for
+ * each of its points to the estimate of each query point in the query node.
+ * Each pruned pair is then within relativeError of its true kernel value plus
+ * absoluteError, so the estimates (the averages of the kernel values) are
+ * within relativeError of the true estimates plus absoluteError.
+ *
+ * The estimates are sums of kernel values, which KDE divides by the number of
+ * reference points.  The rules only modify the estimates of the query points
+ * they are given, so copies of them can be used by the threads of
+ * tree::ParallelDualTreeTraverser.
+ *
+ * @tparam MetricType Metric to use.
+ * @tparam KernelType Kernel to use; it must provide Evaluate(distance).
+ * @tparam TreeType Type of tree to traverse; the base cases must not be
+ *     calculated in Score(), as they are for cover trees
+ *     (TreeTraits::FirstPointIsCentroid).
+ */
+template<typename MetricType, typename KernelType, typename TreeType>
+class KDERules
+{
+ public:
+  /**
+   * Construct the rules.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param estimates Sums of the kernel values of each query point (these are
+   *     added to).
+   * @param relativeError Relative error allowed for each pruned pair.
+   * @param absoluteError Absolute error allowed for each pruned pair.
+   * @param metric Instantiated metric.
+   * @param kernel Instantiated kernel.
+   */
+  KDERules(const arma::mat& referenceSet,
+           const arma::mat& querySet,
+           arma::vec& estimates,
+           const double relativeError,
+           const double absoluteError,
+           MetricType& metric,
+           KernelType& kernel);
+
+  /**
+   * Compute the base case between the given query point and reference point,
+   * and add its kernel value to the estimate of the query point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order; the reference node is pruned (DBL_MAX
+   * is returned) if its contribution to the query point can be approximated.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  The contributions do not
+   * change, so this returns the old score.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  /**
+   * Get the score for recursion order; the combination is pruned (DBL_MAX is
+   * returned) if the contribution of the reference node to all the query
+   * points in the query node can be approximated.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  The contributions do not
+   * change, so this returns the old score.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+ private:
+  //! The reference set.
+  const arma::mat& referenceSet;
+
+  //! The query set.
+  const arma::mat& querySet;
+
+  //! The sums of kernel values of each query point.
+  arma::vec& estimates;
+
+  //! The relative error allowed for each pruned pair.
+  double relativeError;
+  //! The absolute error allowed for each pruned pair.
+  double absoluteError;
+
+  //! The instantiated metric.
+  MetricType& metric;
+  //! The instantiated kernel.
+  KernelType& kernel;
+
+  //! The last query index.
+  size_t lastQueryIndex;
+  //! The last reference index.
+  size_t lastReferenceIndex;
+
+  /**
+   * Return whether the kernel values between the given distances are close
+   * enough to be approximated, and if so set the approximation of one value.
+   */
+  bool Approximate(const math::Range& distances, double& value) const;
+};
+
+}; // namespace kde
+}; // namespace mlpack
+
+// Include implementation.
+#include "kde_rules_impl.hpp"
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file kde_rules_impl.hpp
+ *
+ * Implementation of KDERules.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde {
+
+template<typename MetricType, typename KernelType, typename TreeType>
+KDERules<MetricType, KernelType, TreeType>::KDERules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    arma::vec& estimates,
+    const double relativeError,
+    const double absoluteError,
+    MetricType& metric,
+    KernelType& kernel) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    estimates(estimates),
+    relativeError(relativeError),
+    absoluteError(absoluteError),
+    metric(metric),
+    kernel(kernel),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+inline force_inline
+double KDERules<MetricType, KernelType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  // If we have just performed this base case, don't do it again.
+  if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
+    return 0.0;
+
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceSet.unsafe_col(referenceIndex));
+
+  lastQueryIndex = queryIndex;
+  lastReferenceIndex = referenceIndex;
+
+  estimates[queryIndex] += kernel.Evaluate(distance);
+
+  return distance;
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  const math::Range distances =
+      referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+
+  double value;
+  if (Approximate(distances, value))
+  {
+    estimates[queryIndex] += referenceNode.NumDescendants() * value;
+    return DBL_MAX;
+  }
+
+  // Nearer nodes are visited first; the order does not change the result.
+  return distances.Lo();
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  return oldScore;
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  const math::Range distances = referenceNode.RangeDistance(&queryNode);
+
+  double value;
+  if (Approximate(distances, value))
+  {
+    const double contribution = referenceNode.NumDescendants() * value;
+    for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+      estimates[queryNode.Descendant(i)] += contribution;
+    return DBL_MAX;
+  }
+
+  return distances.Lo();
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  return oldScore;
+}
+
+template<typename MetricType, typename KernelType, typename TreeType>
+inline bool KDERules<MetricType, KernelType, TreeType>::Approximate(
+    const math::Range& distances,
+    double& value) const
+{
+  // The kernel does not increase with the distance.
+  const double maxKernel = kernel.Evaluate(distances.Lo());
+  const double minKernel = kernel.Evaluate(distances.Hi());
+
+  if ((maxKernel - minKernel) / 2.0 >
+      relativeError * minKernel + absoluteError)
+    return false;
+
+  value = (maxKernel + minKernel) / 2.0;
+  return true;
+}
+
+}; // namespace kde
+}; // namespace mlpack
+
+#endif
@@ -25,6 +25,9 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/kernels/linear_kernel.hpp>
+#include "kernel_rules/naive_method.hpp"
+#include "kernel_rules/nystroem_method.hpp"
+#include "kernel_rules/random_fourier_method.hpp"
 
 namespace mlpack {
 namespace kpca {
@@ -41,8 +44,41 @@ namespace kpca {
  * There are numerous available kernels in the mlpack::kernel namespace (see
  * files in mlpack/core/kernels/) and it is easy to write your own; see other
  * implementations for examples.
+ *
+ * How the kernel matrix is formed and decomposed is given by the KernelRule.
+ * The default, NaiveKernelRule, uses the exact n x n kernel matrix, which does
+ * not scale beyond a few tens of thousands of points.  NystroemKernelRule
+ * (landmark points) and RandomFourierKernelRule (random features, for the
+ * Gaussian and Laplacian kernels) approximate the kernel matrix with an
+ * m-dimensional feature map, so they take O(n m) memory and O(n m^2) time:
+ *
+ * @code
+ * KernelPCA<GaussianKernel, NystroemKernelRule> kpca(GaussianKernel(0.5),
+ *     false, NystroemKernelRule(1000));
+ * kpca.Apply(data, 2);
+ * @endcode
+ *
+ * Apply() only transforms the data it is given.  To project other points onto
+ * the same components later (one batch at a time, for instance), use Fit() and
+ * then Transform().  Fit() keeps only what the projection needs: the data for
+ * NaiveKernelRule, the landmarks for NystroemKernelRule, and the random
+ * frequencies for RandomFourierKernelRule, and the projection onto the
+ * components is only newDimension x m.  Each call to Transform() then takes
+ * one kernel evaluation between each point and each kept point:
+ *
+ * @code
+ * KernelPCA<GaussianKernel, NystroemKernelRule> kpca(GaussianKernel(0.5),
+ *     false, NystroemKernelRule(1000));
+ * arma::mat transformedData;
+ * arma::vec eigval;
+ * kpca.Fit(data, transformedData, eigval, 10);
+ * kpca.Transform(batch, transformedBatch);
+ * @endcode
+ *
+ * @tparam KernelType Kernel to use.
+ * @tparam KernelRule How to compute the kernel principal components.
  */
-template <typename KernelType>
+template <typename KernelType, typename KernelRule = NaiveKernelRule>
 class KernelPCA
 {
  public:
@@ -53,9 +89,13 @@ class KernelPCA
    * much).
    *
    * @param kernel Kernel to be used for computation.
+   * @param centerTransformedData Whether or not to center the transformed
+   *     data.
+   * @param rule Instantiated kernel rule (for its parameters).
    */
   KernelPCA(const KernelType kernel = KernelType(),
-            const bool centerTransformedData = false);
+            const bool centerTransformedData = false,
+            const KernelRule rule = KernelRule());
 
   /**
    * Apply Kernel Principal Components Analysis to the provided data set.
@@ -96,6 +136,33 @@ class KernelPCA
    */
   void Apply(arma::mat& data, const size_t newDimension);
 
+  /**
+   * Find the kernel principal components of the provided data set, keeping
+   * the first newDimension of them (all of them if newDimension is 0), and
+   * keep what is needed to project other points onto them with Transform().
+   * The data is transformed as Apply() does.
+   *
+   * @param data Data matrix.
+   * @param transformedData Matrix to output results into.
+   * @param eigval KPCA eigenvalues will be written to this vector.
+   * @param newDimension Number of components to keep (0 for all).
+   */
+  void Fit(const arma::mat& data,
+           arma::mat& transformedData,
+           arma::vec& eigval,
+           const size_t newDimension = 0);
+
+  /**
+   * Project the given points onto the kernel principal components found by the
+   * last call to Fit(), without decomposing the kernel matrix again.  If the
+   * transformed data was centered by Fit(), the points are shifted by the same
+   * amount.
+   *
+   * @param points Points to project (one per column).
+   * @param transformedPoints Matrix to output the projected points into.
+   */
+  void Transform(const arma::mat& points, arma::mat& transformedPoints);
+
   //! Get the kernel.
   const KernelType& Kernel() const { return kernel; }
   //! Modify the kernel.
@@ -106,20 +173,19 @@ class KernelPCA
   //! Return whether or not the transformed data is centered.
   bool& CenterTransformedData() { return centerTransformedData; }
 
+  //! Get the kernel rule.
+  const KernelRule& Rule() const { return rule; }
+  //! Modify the kernel rule.
+  KernelRule& Rule() { return rule; }
+
  private:
   //! The instantiated kernel.
   KernelType kernel;
   //! If true, the data will be scaled (by standard deviation) when Apply() is
   //! run.
   bool centerTransformedData;
-
-  /**
-   * Construct the kernel matrix.
-   *
-   * @param data Input data points.
-   * @param kernelMatrix Matrix to store the constructed kernel matrix in.
-   */
-  void GetKernelMatrix(const arma::mat& data, arma::mat& kernelMatrix);
+  //! The instantiated kernel rule.
+  KernelRule rule;
 
 }; // class KernelPCA
 
@@ -32,49 +32,27 @@
 namespace mlpack {
 namespace kpca {
 
-template <typename KernelType>
-arma::mat GetKernelMatrix(KernelType kernel, arma::mat transData);
-
-template <typename KernelType>
-KernelPCA<KernelType>::KernelPCA(const KernelType kernel,
-                                 const bool centerTransformedData) :
+template <typename KernelType, typename KernelRule>
+KernelPCA<KernelType, KernelRule>::KernelPCA(const KernelType kernel,
+                                             const bool centerTransformedData,
+                                             const KernelRule rule) :
       kernel(kernel),
-      centerTransformedData(centerTransformedData)
+      centerTransformedData(centerTransformedData),
+      rule(rule)
 { }
 
 //! Apply Kernel Principal Component Analysis to the provided data set.
-template <typename KernelType>
-void KernelPCA<KernelType>::Apply(const arma::mat& data,
-                                  arma::mat& transformedData,
-                                  arma::vec& eigval,
-                                  arma::mat& eigvec)
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Apply(const arma::mat& data,
+                                              arma::mat& transformedData,
+                                              arma::vec& eigval,
+                                              arma::mat& eigvec)
 {
-  // Construct the kernel matrix.
-  arma::mat kernelMatrix;
-  GetKernelMatrix(data, kernelMatrix);
-
-  // For PCA the data has to be centered, even if the data is centered.  But it
-  // is not guaranteed that the data, when mapped to the kernel space, is also
-  // centered. Since we actually never work in the feature space we cannot
-  // center the data. So, we perform a "psuedo-centering" using the kernel
-  // matrix.
-  arma::rowvec rowMean = arma::sum(kernelMatrix, 0) / kernelMatrix.n_cols;
-  kernelMatrix.each_row() -= rowMean;
-  kernelMatrix.each_col() -= arma::sum(kernelMatrix, 1) / kernelMatrix.n_cols;
-  kernelMatrix += arma::sum(rowMean) / kernelMatrix.n_cols;
-
-  // Eigendecompose the centered kernel matrix.
-  arma::eig_sym(eigval, eigvec, kernelMatrix);
-
-  // Swap the eigenvalues since they are ordered backwards (we need largest to
-  // smallest).
-  for (size_t i = 0; i < floor(eigval.n_elem / 2.0); ++i)
-    eigval.swap_rows(i, (eigval.n_elem - 1) - i);
-
-  // Flip the coefficients to produce the same effect.
-  eigvec = arma::fliplr(eigvec);
-
-  transformedData = eigvec.t() * kernelMatrix;
+  // The exact rule forms the n x n kernel matrix, so this is the phase to
+  // watch with --track_memory.
+  Timer::Start("kernel_pca");
+  rule.ApplyKernelMatrix(data, kernel, transformedData, eigval, eigvec);
+  Timer::Stop("kernel_pca");
 
   // Center the transformed data, if the user asked for it.
   if (centerTransformedData)
@@ -86,53 +64,69 @@ void KernelPCA<KernelType>::Apply(const arma::mat& data,
 }
 
 //! Apply Kernel Principal Component Analysis to the provided data set.
-template <typename KernelType>
-void KernelPCA<KernelType>::Apply(const arma::mat& data,
-                                  arma::mat& transformedData,
-                                  arma::vec& eigVal)
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Apply(const arma::mat& data,
+                                              arma::mat& transformedData,
+                                              arma::vec& eigVal)
 {
   arma::mat coeffs;
   Apply(data, transformedData, eigVal, coeffs);
 }
 
 //! Use KPCA for dimensionality reduction.
-template <typename KernelType>
-void KernelPCA<KernelType>::Apply(arma::mat& data, const size_t newDimension)
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Apply(arma::mat& data,
+                                              const size_t newDimension)
 {
   arma::mat coeffs;
   arma::vec eigVal;
 
   Apply(data, data, eigVal, coeffs);
 
-  if (newDimension < coeffs.n_rows && newDimension > 0)
+  // The approximate kernel rules may give fewer components than points.
+  if (newDimension < data.n_rows && newDimension > 0)
     data.shed_rows(newDimension, data.n_rows - 1);
 }
 
-//! Construct the kernel matrix.
-template <typename KernelType>
-void KernelPCA<KernelType>::GetKernelMatrix(const arma::mat& data,
-                                            arma::mat& kernelMatrix)
+//! Find the kernel principal components, and keep them for Transform().
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Fit(const arma::mat& data,
+                                            arma::mat& transformedData,
+                                            arma::vec& eigval,
+                                            const size_t newDimension)
 {
-  // Resize the kernel matrix to the right size.
-  kernelMatrix.set_size(data.n_cols, data.n_cols);
+  Timer::Start("kernel_pca");
+  rule.Fit(data, kernel, transformedData, eigval);
+  Timer::Stop("kernel_pca");
 
-  // Note that we only need to calculate the upper triangular part of the kernel
-  // matrix, since it is symmetric.  This helps minimize the number of kernel
-  // evaluations.
-  for (size_t i = 0; i < data.n_cols; ++i)
+  // Only the first components are kept, in the data and in the projection.
+  if (newDimension > 0 && newDimension < transformedData.n_rows)
   {
-    for (size_t j = i; j < data.n_cols; ++j)
-    {
-      // Evaluate the kernel on these two points.
-      kernelMatrix(i, j) = kernel.Evaluate(data.unsafe_col(i),
-                                           data.unsafe_col(j));
-    }
+    transformedData.shed_rows(newDimension, transformedData.n_rows - 1);
+    rule.Projection().shed_rows(newDimension, rule.Projection().n_rows - 1);
+    rule.Offset().shed_rows(newDimension, rule.Offset().n_elem - 1);
   }
 
-  // Copy to the lower triangular part of the matrix.
-  for (size_t i = 1; i < data.n_cols; ++i)
-    for (size_t j = 0; j < i; ++j)
-      kernelMatrix(i, j) = kernelMatrix(j, i);
+  // Center the transformed data, if the user asked for it; other points are
+  // shifted by the same amount.
+  if (centerTransformedData)
+  {
+    const arma::vec transformedDataMean = arma::mean(transformedData, 1);
+    transformedData.each_col() -= transformedDataMean;
+    rule.Offset() -= transformedDataMean;
+  }
+}
+
+//! Project points onto the kernel principal components found by Fit().
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Transform(const arma::mat& points,
+                                                  arma::mat& transformedPoints)
+{
+  if (rule.Projection().n_elem == 0)
+    Log::Fatal << "KernelPCA::Transform(): Fit() must be called first."
+        << std::endl;
+
+  rule.Transform(points, kernel, transformedPoints);
 }
 
 }; // namespace mlpack
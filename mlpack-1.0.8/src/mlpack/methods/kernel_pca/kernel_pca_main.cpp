@@ -64,7 +64,26 @@ PROGRAM_INFO("Kernel Principal Components Analysis",
     "\n"
     "The parameters for each of the kernels should be specified with the "
     "options --bandwidth, --kernel_scale, --offset, or --degree (or a "
-    "combination of those options).\n");
+    "combination of those options)."
+    "\n\n"
+    "By default, the exact kernel matrix is used, which takes memory and time "
+    "quadratic and cubic in the number of points.  For large datasets, the "
+    "kernel matrix can be approximated with --approximation (-a): 'nystroem' "
+    "samples --rank (-r) landmark points, and 'fourier' uses --rank random "
+    "Fourier features (only for the 'gaussian' and 'laplacian' kernels).  "
+    "With the exact kernel matrix, if --new_dimensionality is less than a "
+    "quarter of the number of points, only that many eigenvectors are found, "
+    "with the Lanczos method, which takes time quadratic in the number of "
+    "points."
+    "\n\n"
+    "On Mac OS X and iOS devices, --gpu (-G) computes the exact kernel matrix "
+    "on the GPU with Metal, in single precision, for all the kernels except "
+    "'epanechnikov'."
+    "\n\n"
+    "If --transform_file (-t) is given, the points in that file are projected "
+    "onto the kernel principal components of the input dataset (without "
+    "decomposing the kernel matrix again), and saved to the file given with "
+    "--transform_output_file (-T).\n");
 
 PARAM_STRING_REQ("input_file", "Input dataset to perform KPCA on.", "i");
 PARAM_STRING_REQ("output_file", "File to save modified dataset to.", "o");
@@ -86,6 +105,130 @@ PARAM_DOUBLE("bandwidth", "Bandwidth, for 'gaussian' and 'laplacian' kernels.",
 PARAM_DOUBLE("degree", "Degree of polynomial, for 'polynomial' kernel.", "D",
     1.0);
 
+PARAM_STRING("approximation", "Approximation of the kernel matrix to use; "
+    "'none', 'nystroem', or 'fourier'.", "a", "none");
+PARAM_INT("rank", "Number of landmarks (for 'nystroem') or random features "
+    "(for 'fourier') of the approximation.", "r", 100);
+PARAM_INT("threads", "Number of threads to use to compute the kernel matrix "
+    "(0 means all available cores).", "j", 1);
+PARAM_FLAG("gpu", "If true, compute the exact kernel matrix on the GPU (with "
+    "Metal; only if MLPACK was built with USE_METAL).", "G");
+
+PARAM_STRING("transform_file", "File containing points to project onto the "
+    "kernel principal components of the input dataset.", "t", "");
+PARAM_STRING("transform_output_file", "File to save the projected points of "
+    "--transform_file to.", "T", "");
+
+// Transform the dataset with the given KPCA object; if the user gave points to
+// project, keep the components and project them too.
+template<typename KPCAType>
+void ApplyKPCA(KPCAType& kpca, mat& dataset, const size_t newDim)
+{
+  const string transformFile = CLI::GetParam<string>("transform_file");
+  if (transformFile == "")
+  {
+    kpca.Apply(dataset, newDim);
+    return;
+  }
+
+  mat points;
+  data::Load(transformFile, points, true); // Fatal on failure.
+  if (points.n_rows != dataset.n_rows)
+    Log::Fatal << "The points to transform have dimensionality "
+        << points.n_rows << ", but the input dataset has dimensionality "
+        << dataset.n_rows << "." << endl;
+
+  mat transformedData;
+  vec eigval;
+  kpca.Fit(dataset, transformedData, eigval, newDim);
+  dataset = transformedData;
+
+  mat transformedPoints;
+  kpca.Transform(points, transformedPoints);
+  data::Save(CLI::GetParam<string>("transform_output_file"),
+      transformedPoints, true); // Fatal on failure.
+}
+
+// Random Fourier features are only defined for shift-invariant kernels.
+template<typename KernelType>
+void RunFourierKPCA(const KernelType& /* kernel */,
+                    const bool /* centerTransformedData */,
+                    const size_t /* rank */,
+                    mat& /* dataset */,
+                    const size_t /* newDim */)
+{
+  Log::Fatal << "The 'fourier' approximation is only available for the "
+      << "'gaussian' and 'laplacian' kernels." << endl;
+}
+
+void RunFourierKPCA(const GaussianKernel& kernel,
+                    const bool centerTransformedData,
+                    const size_t rank,
+                    mat& dataset,
+                    const size_t newDim)
+{
+  KernelPCA<GaussianKernel, RandomFourierKernelRule> kpca(kernel,
+      centerTransformedData, RandomFourierKernelRule(rank));
+  ApplyKPCA(kpca, dataset, newDim);
+}
+
+void RunFourierKPCA(const LaplacianKernel& kernel,
+                    const bool centerTransformedData,
+                    const size_t rank,
+                    mat& dataset,
+                    const size_t newDim)
+{
+  KernelPCA<LaplacianKernel, RandomFourierKernelRule> kpca(kernel,
+      centerTransformedData, RandomFourierKernelRule(rank));
+  ApplyKPCA(kpca, dataset, newDim);
+}
+
+// Run KPCA with the given kernel and the approximation given by the user.
+template<typename KernelType>
+void RunKPCA(const KernelType& kernel,
+             const bool centerTransformedData,
+             mat& dataset,
+             const size_t newDim)
+{
+  const string approximation = CLI::GetParam<string>("approximation");
+  const int rank = CLI::GetParam<int>("rank");
+  if (approximation != "none" && rank <= 0)
+    Log::Fatal << "Invalid rank: " << rank << ".  Must be greater than 0."
+        << endl;
+
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (approximation != "none" && CLI::HasParam("gpu"))
+    Log::Warn << "--gpu ignored because --approximation is given." << endl;
+
+  if (approximation == "none")
+  {
+    KernelPCA<KernelType> kpca(kernel, centerTransformedData,
+        NaiveKernelRule((size_t) threads, CLI::HasParam("gpu"), newDim));
+    ApplyKPCA(kpca, dataset, newDim);
+  }
+  else if (approximation == "nystroem")
+  {
+    KernelPCA<KernelType, NystroemKernelRule> kpca(kernel,
+        centerTransformedData, NystroemKernelRule((size_t) rank,
+        (size_t) threads));
+    ApplyKPCA(kpca, dataset, newDim);
+  }
+  else if (approximation == "fourier")
+  {
+    RunFourierKPCA(kernel, centerTransformedData, (size_t) rank, dataset,
+        newDim);
+  }
+  else
+  {
+    Log::Fatal << "Invalid approximation ('" << approximation << "'); valid "
+        << "choices are 'none', 'nystroem', and 'fourier'." << endl;
+  }
+}
+
 int main(int argc, char** argv)
 {
   // Parse command line options.
@@ -110,6 +253,11 @@ int main(int argc, char** argv)
     }
   }
 
+  if (CLI::HasParam("transform_file") &&
+      !CLI::HasParam("transform_output_file"))
+    Log::Fatal << "--transform_output_file must be given with "
+        << "--transform_file." << endl;
+
   // Get the kernel type and make sure it is valid.
   const string kernelType = CLI::GetParam<string>("kernel");
 
@@ -117,16 +265,14 @@ int main(int argc, char** argv)
 
   if (kernelType == "linear")
   {
-    KernelPCA<LinearKernel> kpca(LinearKernel(), centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(LinearKernel(), centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "gaussian")
   {
     const double bandwidth = CLI::GetParam<double>("bandwidth");
 
     GaussianKernel kernel(bandwidth);
-    KernelPCA<GaussianKernel> kpca(kernel, centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(kernel, centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "polynomial")
   {
@@ -134,8 +280,7 @@ int main(int argc, char** argv)
     const double offset = CLI::GetParam<double>("offset");
 
     PolynomialKernel kernel(degree, offset);
-    KernelPCA<PolynomialKernel> kpca(kernel, centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(kernel, centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "hyptan")
   {
@@ -143,29 +288,25 @@ int main(int argc, char** argv)
     const double offset = CLI::GetParam<double>("offset");
 
     HyperbolicTangentKernel kernel(scale, offset);
-    KernelPCA<HyperbolicTangentKernel> kpca(kernel, centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(kernel, centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "laplacian")
   {
     const double bandwidth = CLI::GetParam<double>("bandwidth");
 
     LaplacianKernel kernel(bandwidth);
-    KernelPCA<LaplacianKernel> kpca(kernel, centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(kernel, centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "epanechnikov")
   {
     const double bandwidth = CLI::GetParam<double>("bandwidth");
 
     EpanechnikovKernel kernel(bandwidth);
-    KernelPCA<EpanechnikovKernel> kpca(kernel, centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(kernel, centerTransformedData, dataset, newDim);
   }
   else if (kernelType == "cosine")
   {
-    KernelPCA<CosineDistance> kpca(CosineDistance(), centerTransformedData);
-    kpca.Apply(dataset, newDim);
+    RunKPCA(CosineDistance(), centerTransformedData, dataset, newDim);
   }
   else
   {
@@ -0,0 +1,96 @@
+/**
+ * @file feature_map_pca.hpp
+ *
+ * Kernel PCA on an explicit (approximate) feature map of the data, shared by
+ * the NystroemKernelRule and RandomFourierKernelRule.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_FEATURE_MAP_PCA_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_FEATURE_MAP_PCA_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * Run kernel PCA given an m-dimensional feature map of the data, such that the
+ * kernel matrix is approximated by trans(features) * features.  Centering the
+ * features is centering in feature space, and the centered kernel matrix has
+ * the same nonzero eigenvalues as the m x m matrix features * trans(features),
+ * whose eigenvectors give the eigenvectors of the kernel matrix; so only an
+ * m x m matrix is eigendecomposed.
+ *
+ * The results have the same form as those of NaiveKernelRule, except that
+ * there are only m eigenvalues and eigenvectors.  If projection and offset are
+ * given, the affine map from the (uncentered) features of a point to its
+ * components is stored in them, so that other points can be projected.
+ *
+ * @param features Feature map of the data (one column per point); this is
+ *     centered in place.
+ * @param transformedData Matrix to store the transformed data in.
+ * @param eigval Vector to store the eigenvalues in (largest first).
+ * @param eigvec Matrix to store the eigenvectors (of the kernel matrix) in.
+ * @param projection If not NULL, matrix to store the projection of the
+ *     features onto the components in.
+ * @param offset If not NULL, vector to store the offset of the components in.
+ */
+inline void FeatureMapPCA(arma::mat& features,
+                          arma::mat& transformedData,
+                          arma::vec& eigval,
+                          arma::mat& eigvec,
+                          arma::mat* projection = NULL,
+                          arma::vec* offset = NULL)
+{
+  // Center the features.
+  const arma::vec featureMean = arma::sum(features, 1) / features.n_cols;
+  features.each_col() -= featureMean;
+
+  // Eigendecompose the m x m scatter matrix of the features, and order the
+  // eigenvalues from largest to smallest.
+  arma::mat featureEigvec;
+  arma::eig_sym(eigval, featureEigvec, features * trans(features));
+  eigval = arma::flipud(eigval);
+  featureEigvec = arma::fliplr(featureEigvec);
+
+  // If u is an eigenvector of features * trans(features) with eigenvalue l,
+  // then trans(features) * u / sqrt(l) is a unit eigenvector v of the kernel
+  // matrix, and v^T K = sqrt(l) u^T features.
+  arma::vec scale(eigval.n_elem);
+  for (size_t i = 0; i < eigval.n_elem; ++i)
+  {
+    if (eigval[i] <= 0)
+      eigval[i] = 0;
+    scale[i] = std::sqrt(eigval[i]);
+  }
+
+  transformedData = diagmat(scale) * trans(featureEigvec) * features;
+
+  if (projection != NULL)
+    *projection = diagmat(scale) * trans(featureEigvec);
+  if (offset != NULL)
+    *offset = -(diagmat(scale) * trans(featureEigvec) * featureMean);
+
+  for (size_t i = 0; i < scale.n_elem; ++i)
+    scale[i] = (scale[i] > 0) ? (1.0 / scale[i]) : 0.0;
+  eigvec = trans(features) * featureEigvec * diagmat(scale);
+}
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file naive_method.hpp
+ *
+ * The default rule for KernelPCA, which eigendecomposes the full (centered)
+ * kernel matrix.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_NAIVE_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_NAIVE_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/kernel_matrix.hpp>
+#include <mlpack/core/kernels/gpu_kernel_matrix.hpp>
+#include <mlpack/core/math/lanczos_eigensolver.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The exact kernel rule for KernelPCA: the n x n kernel matrix of the data is
+ * built, centered in feature space, and eigendecomposed.  This takes O(n^2)
+ * memory and O(n^3) time; for large datasets, see NystroemKernelRule and
+ * RandomFourierKernelRule.
+ *
+ * If only the first few components are needed, give their number to the
+ * constructor: when it is less than a quarter of n, only those eigenvectors
+ * are found, with math::LanczosEigensolver, in O(n^2) time per product with
+ * the kernel matrix instead of O(n^3) time.  Then the transformed data has
+ * only that many dimensions.
+ */
+class NaiveKernelRule
+{
+ public:
+  /**
+   * Create the rule, building the kernel matrix with the given number of
+   * threads, or on the GPU.
+   *
+   * @param threads Number of threads to use; 0 means all available cores.
+   * @param gpu If true, build the kernel matrix on the GPU when possible (see
+   *     kernel::GPUKernelMatrix()).
+   * @param components Number of components to find; 0 means all of them.
+   */
+  NaiveKernelRule(const size_t threads = 1,
+                  const bool gpu = false,
+                  const size_t components = 0) :
+      threads(threads), gpu(gpu), components(components) { }
+
+  /**
+   * Run kernel PCA on the given data with the given kernel.  transformedData
+   * may alias data.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use.
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   * @param eigvec Matrix to store the eigenvectors in.
+   */
+  template<typename KernelType>
+  void ApplyKernelMatrix(const arma::mat& data,
+                         KernelType& kernel,
+                         arma::mat& transformedData,
+                         arma::vec& eigval,
+                         arma::mat& eigvec) const
+  {
+    arma::rowvec kernelMean;
+    Decompose(data, kernel, transformedData, eigval, eigvec, kernelMean);
+  }
+
+  /**
+   * Run kernel PCA on the given data with the given kernel, as
+   * ApplyKernelMatrix() does, and keep what is needed to project other points
+   * with Transform(): the data itself, and an affine map (Projection() and
+   * Offset()) from the kernel evaluations of a point to its components.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use.
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   */
+  template<typename KernelType>
+  void Fit(const arma::mat& data,
+           KernelType& kernel,
+           arma::mat& transformedData,
+           arma::vec& eigval)
+  {
+    arma::mat eigvec;
+    arma::rowvec kernelMean;
+    Decompose(data, kernel, transformedData, eigval, eigvec, kernelMean);
+    points = data;
+
+    // The kernel evaluations k of a point are centered like a column of the
+    // training kernel matrix: the mean of k and kernelMean are subtracted,
+    // and twice the mean of kernelMean is added.  Both are folded into the
+    // projection onto the eigenvectors.
+    const size_t n = data.n_cols;
+    const arma::vec eigvecSum = trans(arma::sum(eigvec, 0));
+    projection = trans(eigvec) - eigvecSum * arma::ones<arma::rowvec>(n) / n;
+    offset = 2 * arma::mean(kernelMean) * eigvecSum -
+        trans(eigvec) * trans(kernelMean);
+  }
+
+  /**
+   * Project the given points onto the kernel principal components found by
+   * Fit().  This takes one kernel evaluation between each point and each
+   * point of the data given to Fit().
+   *
+   * @param newPoints Points to project (one per column).
+   * @param kernel Kernel to use (the one given to Fit()).
+   * @param transformedPoints Matrix to store the projected points in.
+   */
+  template<typename KernelType>
+  void Transform(const arma::mat& newPoints,
+                 KernelType& kernel,
+                 arma::mat& transformedPoints) const
+  {
+    arma::mat pointKernel;
+    kernel::KernelMatrix(kernel, points, newPoints, pointKernel, threads);
+    transformedPoints = projection * pointKernel;
+    transformedPoints.each_col() += offset;
+  }
+
+  //! Get the projection from kernel evaluations to components (after Fit()).
+  const arma::mat& Projection() const { return projection; }
+  //! Modify the projection from kernel evaluations to components.
+  arma::mat& Projection() { return projection; }
+
+  //! Get the offset of the components (after Fit()).
+  const arma::vec& Offset() const { return offset; }
+  //! Modify the offset of the components.
+  arma::vec& Offset() { return offset; }
+
+  //! Get the number of threads used to build the kernel matrix.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to build the kernel matrix (0 means
+  //! all available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get whether the kernel matrix is built on the GPU.
+  bool GPU() const { return gpu; }
+  //! Modify whether the kernel matrix is built on the GPU (in single
+  //! precision; if the kernel is not supported or there is no GPU, the CPU is
+  //! used).
+  bool& GPU() { return gpu; }
+
+  //! Get the number of components to find (0 means all of them).
+  size_t Components() const { return components; }
+  //! Modify the number of components to find (0 means all of them).
+  size_t& Components() { return components; }
+
+ private:
+  //! The number of threads used to build the kernel matrix.
+  size_t threads;
+  //! Whether the kernel matrix is built on the GPU.
+  bool gpu;
+  //! The number of components to find.
+  size_t components;
+
+  //! The points given to Fit().
+  arma::mat points;
+  //! The projection from kernel evaluations to components.
+  arma::mat projection;
+  //! The offset of the components.
+  arma::vec offset;
+
+  /**
+   * Build the kernel matrix of the data, center it in feature space and
+   * eigendecompose it.  The mean of each column of the kernel matrix, before
+   * centering, is stored in kernelMean.
+   */
+  template<typename KernelType>
+  void Decompose(const arma::mat& data,
+                 KernelType& kernel,
+                 arma::mat& transformedData,
+                 arma::vec& eigval,
+                 arma::mat& eigvec,
+                 arma::rowvec& kernelMean) const
+  {
+    // Construct the kernel matrix.  Only the blocks on and above the diagonal
+    // are computed, since it is symmetric.
+    arma::mat kernelMatrix;
+    if (!gpu || !kernel::GPUKernelMatrix(kernel, data, kernelMatrix))
+    {
+      if (gpu)
+        Log::Warn << "The kernel matrix cannot be built on the GPU; using the "
+            << "CPU." << std::endl;
+      kernel::KernelMatrix(kernel, data, kernelMatrix, threads);
+    }
+
+    // For PCA the data has to be centered, even if the data is centered.  But
+    // it is not guaranteed that the data, when mapped to the kernel space, is
+    // also centered. Since we actually never work in the feature space we
+    // cannot center the data. So, we perform a "psuedo-centering" using the
+    // kernel matrix.
+    kernelMean = arma::sum(kernelMatrix, 0) / kernelMatrix.n_cols;
+    kernelMatrix.each_row() -= kernelMean;
+    kernelMatrix.each_col() -= arma::sum(kernelMatrix, 1) / kernelMatrix.n_cols;
+    kernelMatrix += arma::sum(kernelMean) / kernelMatrix.n_cols;
+
+    // If few components are wanted, find only those.
+    if (components > 0 && 4 * components < kernelMatrix.n_rows)
+    {
+      math::LanczosEigensolver solver;
+      if (!solver.Solve(kernelMatrix, components, eigval, eigvec))
+        Log::Warn << "The eigenvectors of the kernel matrix did not converge "
+            << "in " << solver.Restarts() << " restarts." << std::endl;
+
+      transformedData = eigvec.t() * kernelMatrix;
+      return;
+    }
+
+    // Eigendecompose the centered kernel matrix.
+    arma::eig_sym(eigval, eigvec, kernelMatrix);
+
+    // Swap the eigenvalues since they are ordered backwards (we need largest
+    // to smallest).
+    for (size_t i = 0; i < floor(eigval.n_elem / 2.0); ++i)
+      eigval.swap_rows(i, (eigval.n_elem - 1) - i);
+
+    // Flip the coefficients to produce the same effect.
+    eigvec = arma::fliplr(eigvec);
+
+    transformedData = eigvec.t() * kernelMatrix;
+  }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
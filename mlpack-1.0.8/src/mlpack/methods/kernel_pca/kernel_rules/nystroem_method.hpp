@@ -0,0 +1,248 @@
+/**
+ * @file nystroem_method.hpp
+ *
+ * A kernel rule for KernelPCA which approximates the kernel matrix with the
+ * Nystroem method, using a random sample of the points as landmarks.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_NYSTROEM_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_NYSTROEM_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/kernel_matrix.hpp>
+#include "feature_map_pca.hpp"
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The Nystroem kernel rule for KernelPCA.  A random sample of m points (the
+ * landmarks) is drawn from the data, and the kernel matrix is approximated by
+ * K_nm K_mm^+ K_mn, where K_mm is the kernel matrix of the landmarks and K_nm
+ * holds the kernel evaluations between the points and the landmarks.  This is
+ * the kernel matrix of the m-dimensional feature map K_mm^{-1/2} K_mn, on
+ * which kernel PCA is run (see FeatureMapPCA()).  Only n * m kernel
+ * evaluations are made, and the memory used is O(n m) instead of O(n^2).
+ *
+ * @code
+ * @inproceedings{williams2001using,
+ *   title={Using the {N}ystr{\"o}m method to speed up kernel machines},
+ *   author={Williams, C. and Seeger, M.},
+ *   booktitle={Advances in Neural Information Processing Systems 13},
+ *   pages={682--688},
+ *   year={2001}
+ * }
+ * @endcode
+ */
+class NystroemKernelRule
+{
+ public:
+  /**
+   * Create the rule with the given number of landmarks.  If the dataset has
+   * fewer points, every point is a landmark.
+   *
+   * @param landmarks Number of landmarks to sample.
+   * @param threads Number of threads to use for the kernel evaluations; 0
+   *     means all available cores.
+   */
+  NystroemKernelRule(const size_t landmarks = 100, const size_t threads = 1) :
+      landmarks(landmarks),
+      threads(threads)
+  { }
+
+  /**
+   * Run approximate kernel PCA on the given data with the given kernel.
+   * transformedData may alias data.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use.
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   * @param eigvec Matrix to store the eigenvectors in.
+   */
+  template<typename KernelType>
+  void ApplyKernelMatrix(const arma::mat& data,
+                         KernelType& kernel,
+                         arma::mat& transformedData,
+                         arma::vec& eigval,
+                         arma::mat& eigvec) const
+  {
+    arma::mat sample;
+    arma::mat landmarkMap;
+    SampleLandmarks(data, kernel, sample, landmarkMap);
+
+    arma::mat features;
+    FeatureMap(data, kernel, sample, landmarkMap, features);
+    FeatureMapPCA(features, transformedData, eigval, eigvec);
+  }
+
+  /**
+   * Run approximate kernel PCA on the given data with the given kernel, as
+   * ApplyKernelMatrix() does, and keep what is needed to project other points
+   * with Transform(): the landmarks, and an affine map (Projection() and
+   * Offset()) from the kernel evaluations of a point against the landmarks to
+   * its components.  Only the landmarks are kept, not the data.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use.
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   */
+  template<typename KernelType>
+  void Fit(const arma::mat& data,
+           KernelType& kernel,
+           arma::mat& transformedData,
+           arma::vec& eigval)
+  {
+    arma::mat landmarkMap;
+    SampleLandmarks(data, kernel, landmarkPoints, landmarkMap);
+
+    arma::mat features;
+    FeatureMap(data, kernel, landmarkPoints, landmarkMap, features);
+    arma::mat eigvec;
+    FeatureMapPCA(features, transformedData, eigval, eigvec, &projection,
+        &offset);
+    projection *= landmarkMap;
+  }
+
+  /**
+   * Project the given points onto the kernel principal components found by
+   * Fit().  This takes one kernel evaluation between each point and each
+   * landmark.
+   *
+   * @param newPoints Points to project (one per column).
+   * @param kernel Kernel to use (the one given to Fit()).
+   * @param transformedPoints Matrix to store the projected points in.
+   */
+  template<typename KernelType>
+  void Transform(const arma::mat& newPoints,
+                 KernelType& kernel,
+                 arma::mat& transformedPoints) const
+  {
+    arma::mat pointKernel;
+    kernel::KernelMatrix(kernel, landmarkPoints, newPoints, pointKernel,
+        threads);
+    transformedPoints = projection * pointKernel;
+    transformedPoints.each_col() += offset;
+  }
+
+  //! Get the number of landmarks.
+  size_t Landmarks() const { return landmarks; }
+  //! Modify the number of landmarks.
+  size_t& Landmarks() { return landmarks; }
+
+  //! Get the number of threads used for the kernel evaluations.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the kernel evaluations (0 means all
+  //! available cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the landmarks sampled by Fit().
+  const arma::mat& LandmarkPoints() const { return landmarkPoints; }
+
+  //! Get the projection from kernel evaluations to components (after Fit()).
+  const arma::mat& Projection() const { return projection; }
+  //! Modify the projection from kernel evaluations to components.
+  arma::mat& Projection() { return projection; }
+
+  //! Get the offset of the components (after Fit()).
+  const arma::vec& Offset() const { return offset; }
+  //! Modify the offset of the components.
+  arma::vec& Offset() { return offset; }
+
+ private:
+  //! The number of landmarks to sample.
+  size_t landmarks;
+  //! The number of threads used for the kernel evaluations.
+  size_t threads;
+
+  //! The landmarks sampled by Fit().
+  arma::mat landmarkPoints;
+  //! The projection from kernel evaluations to components.
+  arma::mat projection;
+  //! The offset of the components.
+  arma::vec offset;
+
+  /**
+   * Sample the landmarks from the data, and compute the map K_mm^{-1/2} from
+   * the kernel evaluations of a point against the landmarks to its features,
+   * ignoring the directions in which K_mm is (numerically) singular.
+   */
+  template<typename KernelType>
+  void SampleLandmarks(const arma::mat& data,
+                       KernelType& kernel,
+                       arma::mat& sample,
+                       arma::mat& landmarkMap) const
+  {
+    const size_t m = std::min(landmarks, (size_t) data.n_cols);
+
+    // Sample the landmarks without replacement, with a partial Fisher-Yates
+    // shuffle.
+    std::vector<size_t> indices(data.n_cols);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      indices[i] = i;
+    for (size_t i = 0; i < m; ++i)
+      std::swap(indices[i], indices[i + math::RandInt(data.n_cols - i)]);
+
+    sample.set_size(data.n_rows, m);
+    for (size_t i = 0; i < m; ++i)
+      sample.col(i) = data.col(indices[i]);
+
+    // Kernel matrix of the landmarks, and its eigendecomposition.
+    arma::mat landmarkKernel;
+    kernel::KernelMatrix(kernel, sample, landmarkKernel, threads);
+    arma::vec landmarkEigval;
+    arma::mat landmarkEigvec;
+    arma::eig_sym(landmarkEigval, landmarkEigvec, landmarkKernel);
+
+    const double threshold = 1e-10 * std::max(landmarkEigval.max(), 0.0);
+    size_t rank = 0;
+    for (size_t i = 0; i < m; ++i)
+      if (landmarkEigval[i] > threshold)
+        ++rank;
+
+    landmarkMap.set_size(rank, m);
+    size_t row = 0;
+    for (size_t i = 0; i < m; ++i)
+    {
+      if (landmarkEigval[i] <= threshold)
+        continue;
+
+      landmarkMap.row(row++) = trans(landmarkEigvec.col(i)) /
+          std::sqrt(landmarkEigval[i]);
+    }
+  }
+
+  //! Compute the features of the data: the landmark map applied to the kernel
+  //! evaluations between the landmarks and every point.
+  template<typename KernelType>
+  void FeatureMap(const arma::mat& data,
+                  KernelType& kernel,
+                  const arma::mat& sample,
+                  const arma::mat& landmarkMap,
+                  arma::mat& features) const
+  {
+    arma::mat pointKernel;
+    kernel::KernelMatrix(kernel, sample, data, pointKernel, threads);
+    features = landmarkMap * pointKernel;
+  }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file random_fourier_method.hpp
+ *
+ * A kernel rule for KernelPCA which approximates shift-invariant kernels with
+ * random Fourier features.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_RANDOM_FOURIER_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_KERNEL_RULES_RANDOM_FOURIER_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
+#include "feature_map_pca.hpp"
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The random Fourier feature kernel rule for KernelPCA.  A shift-invariant
+ * kernel k(x - y) is the expectation of cos(w^T (x - y)) over frequencies w
+ * drawn from its Fourier transform, so it is approximated by the kernel matrix
+ * of the D-dimensional feature map sqrt(2 / D) cos(W^T x + b), where the
+ * columns of W are sampled frequencies and b is uniform on [0, 2 pi]; kernel
+ * PCA is run on that feature map (see FeatureMapPCA()).  No kernel evaluations
+ * are made at all, and the memory used is O(n D).
+ *
+ * This is only available for the GaussianKernel (whose frequencies are normal)
+ * and the LaplacianKernel (whose frequencies are multivariate Cauchy).
+ *
+ * @code
+ * @inproceedings{rahimi2007random,
+ *   title={Random features for large-scale kernel machines},
+ *   author={Rahimi, A. and Recht, B.},
+ *   booktitle={Advances in Neural Information Processing Systems 20},
+ *   pages={1177--1184},
+ *   year={2007}
+ * }
+ * @endcode
+ */
+class RandomFourierKernelRule
+{
+ public:
+  /**
+   * Create the rule with the given number of random features.
+   *
+   * @param features Number of random features (D).
+   */
+  RandomFourierKernelRule(const size_t features = 500) : features(features) { }
+
+  /**
+   * Run approximate kernel PCA on the given data with the given kernel.
+   * transformedData may alias data.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use (GaussianKernel or LaplacianKernel).
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   * @param eigvec Matrix to store the eigenvectors in.
+   */
+  template<typename KernelType>
+  void ApplyKernelMatrix(const arma::mat& data,
+                         KernelType& kernel,
+                         arma::mat& transformedData,
+                         arma::vec& eigval,
+                         arma::mat& eigvec) const
+  {
+    arma::mat sampledFrequencies;
+    SampleFrequencies(kernel, data.n_rows, sampledFrequencies);
+    const arma::vec sampledPhases = 2 * M_PI * arma::randu<arma::vec>(features);
+
+    arma::mat featureMap;
+    FeatureMap(data, sampledFrequencies, sampledPhases, featureMap);
+    FeatureMapPCA(featureMap, transformedData, eigval, eigvec);
+  }
+
+  /**
+   * Run approximate kernel PCA on the given data with the given kernel, as
+   * ApplyKernelMatrix() does, and keep what is needed to project other points
+   * with Transform(): the random frequencies and phases, and an affine map
+   * (Projection() and Offset()) from the random features of a point to its
+   * components.  No points are kept.
+   *
+   * @param data Input data points (one per column).
+   * @param kernel Kernel to use (GaussianKernel or LaplacianKernel).
+   * @param transformedData Matrix to store the transformed data in.
+   * @param eigval Vector to store the eigenvalues in (largest first).
+   */
+  template<typename KernelType>
+  void Fit(const arma::mat& data,
+           KernelType& kernel,
+           arma::mat& transformedData,
+           arma::vec& eigval)
+  {
+    SampleFrequencies(kernel, data.n_rows, frequencies);
+    phases = 2 * M_PI * arma::randu<arma::vec>(features);
+
+    arma::mat featureMap;
+    FeatureMap(data, frequencies, phases, featureMap);
+    arma::mat eigvec;
+    FeatureMapPCA(featureMap, transformedData, eigval, eigvec, &projection,
+        &offset);
+  }
+
+  /**
+   * Project the given points onto the kernel principal components found by
+   * Fit().  No kernel evaluations are made.
+   *
+   * @param newPoints Points to project (one per column).
+   * @param kernel Kernel given to Fit() (unused; the frequencies depend on
+   *     it).
+   * @param transformedPoints Matrix to store the projected points in.
+   */
+  template<typename KernelType>
+  void Transform(const arma::mat& newPoints,
+                 KernelType& /* kernel */,
+                 arma::mat& transformedPoints) const
+  {
+    arma::mat featureMap;
+    FeatureMap(newPoints, frequencies, phases, featureMap);
+    transformedPoints = projection * featureMap;
+    transformedPoints.each_col() += offset;
+  }
+
+  //! Get the number of random features.
+  size_t Features() const { return features; }
+  //! Modify the number of random features.
+  size_t& Features() { return features; }
+
+  //! Get the projection from random features to components (after Fit()).
+  const arma::mat& Projection() const { return projection; }
+  //! Modify the projection from random features to components.
+  arma::mat& Projection() { return projection; }
+
+  //! Get the offset of the components (after Fit()).
+  const arma::vec& Offset() const { return offset; }
+  //! Modify the offset of the components.
+  arma::vec& Offset() { return offset; }
+
+ private:
+  //! The number of random features.
+  size_t features;
+
+  //! The frequencies sampled by Fit() (one per column).
+  arma::mat frequencies;
+  //! The phases sampled by Fit().
+  arma::vec phases;
+  //! The projection from random features to components.
+  arma::mat projection;
+  //! The offset of the components.
+  arma::vec offset;
+
+  //! Compute the random features sqrt(2 / D) cos(W^T x + b) of the data.
+  void FeatureMap(const arma::mat& data,
+                  const arma::mat& sampledFrequencies,
+                  const arma::vec& sampledPhases,
+                  arma::mat& featureMap) const
+  {
+    featureMap = trans(sampledFrequencies) * data;
+    featureMap.each_col() += sampledPhases;
+    featureMap = std::sqrt(2.0 / features) * arma::cos(featureMap);
+  }
+
+  //! Sample frequencies for the Gaussian kernel exp(-|d|^2 / (2 sigma^2)),
+  //! which are N(0, sigma^-2 I).
+  void SampleFrequencies(const kernel::GaussianKernel& kernel,
+                         const size_t dimensionality,
+                         arma::mat& sampledFrequencies) const
+  {
+    sampledFrequencies = arma::randn<arma::mat>(dimensionality, features) /
+        kernel.Bandwidth();
+  }
+
+  //! Sample frequencies for the Laplacian kernel exp(-|d| / sigma), which are
+  //! multivariate Cauchy with scale 1 / sigma: a normal vector divided by the
+  //! absolute value of an independent normal.
+  void SampleFrequencies(const kernel::LaplacianKernel& kernel,
+                         const size_t dimensionality,
+                         arma::mat& sampledFrequencies) const
+  {
+    sampledFrequencies = arma::randn<arma::mat>(dimensionality, features);
+    for (size_t j = 0; j < features; ++j)
+      sampledFrequencies.col(j) /= kernel.Bandwidth() *
+          std::abs(math::RandNormal());
+  }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file dual_tree_assignment.hpp
+ *
+ * An assignment step for K-Means which finds the nearest centroid of all the
+ * points at once with a dual-tree traversal of a kd-tree on the points and a
+ * kd-tree on the centroids.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_ASSIGNMENT_HPP
+#define __MLPACK_METHODS_KMEANS_DUAL_TREE_ASSIGNMENT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include "dual_tree_kmeans_stat.hpp"
+#include "dual_tree_kmeans_rules.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An AssignmentPolicy for KMeans which gives the same assignments as
+ * NaiveAssignment, but finds them all at once in Update(), with
+ * BinarySpaceTree::DualTreeTraverser and DualTreeKMeansRules.  A kd-tree is
+ * built on the points once, in Initialize(), and a kd-tree is built on the
+ * centroids in each iteration; pairs of nodes which cannot hold the nearest
+ * centroid of any of the points are pruned, and whole nodes of points which
+ * provably belong to one centroid are assigned without any distance
+ * calculations.  This is much faster than NaiveAssignment when there are many
+ * clusters (hundreds or thousands) and the dimensionality is low, since the
+ * cost of each iteration grows much more slowly than the number of clusters.
+ *
+ * Only the Euclidean and squared Euclidean distances are supported (the
+ * nearest centroid is the same for both), and only dense data.
+ *
+ * @code
+ * extern arma::mat data;
+ * arma::Col<size_t> assignments;
+ *
+ * KMeans<metric::SquaredEuclideanDistance, RandomPartition,
+ *     MaxVarianceNewCluster, DualTreeAssignment> k;
+ * k.Cluster(data, 2000, assignments);
+ * @endcode
+ */
+class DualTreeAssignment
+{
+ public:
+  //! The type of the trees on the points and on the centroids.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>, DualTreeKMeansStat>
+      TreeType;
+
+  /**
+   * Create the assignment policy, with the given leaf size for the tree on the
+   * points.  The tree on the centroids has a leaf size of 1, so that nodes of
+   * points can be owned by single centroids.
+   *
+   * @param leafSize Leaf size of the tree on the points.
+   */
+  DualTreeAssignment(const size_t leafSize = 20) :
+      leafSize(leafSize),
+      tree(NULL) { }
+
+  //! Copy the assignment policy; the tree is not copied, since Initialize()
+  //! builds a new one.
+  DualTreeAssignment(const DualTreeAssignment& other) :
+      leafSize(other.leafSize),
+      tree(NULL) { }
+
+  //! Copy the leaf size of the given assignment policy; the tree is not copied.
+  DualTreeAssignment& operator=(const DualTreeAssignment& other);
+
+  //! Delete the tree on the points.
+  ~DualTreeAssignment() { delete tree; }
+
+  /**
+   * Build the tree on the points of the given dataset.
+   *
+   * @param data Dataset to be clustered.
+   * @param clusters Number of clusters.
+   */
+  void Initialize(const arma::mat& data, const size_t clusters);
+
+  //! Sparse data cannot be clustered with this policy.
+  template<typename MatType>
+  void Initialize(const MatType& data, const size_t clusters);
+
+  /**
+   * Build a tree on the centroids, and find the nearest centroid of every
+   * point with a dual-tree traversal.
+   *
+   * @param metric Distance metric (Euclidean or squared Euclidean).
+   * @param centroids Centroids of each cluster (one per column).
+   */
+  template<bool TakeRoot>
+  void Update(const metric::LMetric<2, TakeRoot>& metric,
+              const arma::mat& centroids);
+
+  //! Other metrics cannot be used with this policy.
+  template<typename MetricType, typename MatType>
+  void Update(const MetricType& metric, const MatType& centroids);
+
+  /**
+   * Return the nearest centroid of the given point, which was found in the
+   * last call to Update().
+   *
+   * @tparam MetricType Type of distance metric.
+   * @tparam MatType Type of data.
+   * @param metric Distance metric.
+   * @param data Dataset being clustered.
+   * @param centroids Centroids of each cluster (one per column).
+   * @param point Index of the point to assign.
+   * @param assignment Current assignment of the point.
+   * @return Index of the closest centroid.
+   */
+  template<typename MetricType, typename MatType>
+  size_t Assign(const MetricType& /* metric */,
+                const MatType& /* data */,
+                const MatType& /* centroids */,
+                const size_t point,
+                const size_t /* assignment */)
+  {
+    return assignments[point];
+  }
+
+  //! Get the leaf size of the tree on the points.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size of the tree on the points.
+  size_t& LeafSize() { return leafSize; }
+
+ private:
+  //! The leaf size of the tree on the points.
+  size_t leafSize;
+  //! The points, reordered by the tree.
+  arma::mat dataset;
+  //! The tree on the points.
+  TreeType* tree;
+  //! Mappings from the indices of the points in the tree to the original
+  //! indices.
+  std::vector<size_t> oldFromNew;
+  //! The nearest centroid of each point (in the original order).
+  arma::Col<size_t> assignments;
+
+  //! Reset the statistics of the given node and its descendants.
+  static void ResetStatistics(TreeType& node);
+
+  //! Assign the points of the given node (and its descendants) from their
+  //! owners or from the nearest centroids found for them.
+  void CollectAssignments(const TreeType& node,
+                          const arma::Col<size_t>& treeAssignments,
+                          const std::vector<size_t>& centroidOldFromNew);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "dual_tree_assignment_impl.hpp"
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file dual_tree_assignment_impl.hpp
+ *
+ * Implementation of the DualTreeAssignment class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_ASSIGNMENT_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_DUAL_TREE_ASSIGNMENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dual_tree_assignment.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+inline DualTreeAssignment& DualTreeAssignment::operator=(
+    const DualTreeAssignment& other)
+{
+  if (this != &other)
+  {
+    leafSize = other.leafSize;
+    delete tree;
+    tree = NULL;
+    dataset.reset();
+    oldFromNew.clear();
+    assignments.reset();
+  }
+
+  return *this;
+}
+
+inline void DualTreeAssignment::Initialize(const arma::mat& data,
+                                           const size_t /* clusters */)
+{
+  // The tree reorders the points, so it is built on a copy.
+  delete tree;
+  dataset = data;
+  oldFromNew.clear();
+  tree = new TreeType(dataset, oldFromNew, leafSize);
+
+  assignments.zeros(data.n_cols);
+}
+
+template<typename MatType>
+void DualTreeAssignment::Initialize(const MatType& /* data */,
+                                    const size_t /* clusters */)
+{
+  Log::Fatal << "DualTreeAssignment::Initialize(): only dense data "
+      << "(arma::mat) can be clustered." << std::endl;
+}
+
+template<bool TakeRoot>
+void DualTreeAssignment::Update(
+    const metric::LMetric<2, TakeRoot>& /* metric */,
+    const arma::mat& centroids)
+{
+  const size_t clusters = centroids.n_cols;
+
+  // Find the distance from each centroid to the nearest other centroid.  A
+  // node of points closer to its centroid than half of that distance belongs
+  // to the centroid.
+  arma::vec separation(clusters);
+  separation.fill(DBL_MAX);
+  if (clusters > 1)
+  {
+    neighbor::AllkNN allknn(centroids);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(1, neighbors, distances);
+    separation = 0.5 * trans(distances.row(0));
+  }
+
+  // Build a tree on the centroids, with one centroid in each leaf (unless some
+  // centroids are identical).
+  arma::mat treeCentroids(centroids);
+  std::vector<size_t> centroidOldFromNew;
+  TreeType centroidTree(treeCentroids, centroidOldFromNew, 1);
+
+  arma::vec halfSeparation(clusters);
+  for (size_t i = 0; i < clusters; ++i)
+    halfSeparation[i] = separation[centroidOldFromNew[i]];
+
+  // Now find the nearest centroid of each point.
+  ResetStatistics(*tree);
+  arma::Col<size_t> treeAssignments(dataset.n_cols);
+  treeAssignments.fill(clusters);
+  arma::vec distances(dataset.n_cols);
+  distances.fill(DBL_MAX);
+
+  typedef DualTreeKMeansRules<TreeType> RuleType;
+  RuleType rules(dataset, treeCentroids, halfSeparation, treeAssignments,
+      distances);
+  TreeType::DualTreeTraverser<RuleType> traverser(rules);
+  traverser.Traverse(*tree, centroidTree);
+
+  Log::Debug << "DualTreeAssignment::Update(): " << traverser.NumPrunes()
+      << " pruned node combinations, " << traverser.NumBaseCases()
+      << " base cases." << std::endl;
+
+  CollectAssignments(*tree, treeAssignments, centroidOldFromNew);
+}
+
+template<typename MetricType, typename MatType>
+void DualTreeAssignment::Update(const MetricType& /* metric */,
+                                const MatType& /* centroids */)
+{
+  Log::Fatal << "DualTreeAssignment::Update(): only the Euclidean and squared "
+      << "Euclidean distances can be used." << std::endl;
+}
+
+inline void DualTreeAssignment::ResetStatistics(TreeType& node)
+{
+  node.Stat().Reset();
+
+  if (!node.IsLeaf())
+  {
+    ResetStatistics(*node.Left());
+    ResetStatistics(*node.Right());
+  }
+}
+
+inline void DualTreeAssignment::CollectAssignments(
+    const TreeType& node,
+    const arma::Col<size_t>& treeAssignments,
+    const std::vector<size_t>& centroidOldFromNew)
+{
+  if (node.Stat().Owner() != size_t(-1))
+  {
+    // The whole node belongs to one centroid.
+    const size_t owner = centroidOldFromNew[node.Stat().Owner()];
+    for (size_t i = node.Begin(); i < node.End(); ++i)
+      assignments[oldFromNew[i]] = owner;
+  }
+  else if (node.IsLeaf())
+  {
+    for (size_t i = node.Begin(); i < node.End(); ++i)
+      assignments[oldFromNew[i]] = centroidOldFromNew[treeAssignments[i]];
+  }
+  else
+  {
+    CollectAssignments(*node.Left(), treeAssignments, centroidOldFromNew);
+    CollectAssignments(*node.Right(), treeAssignments, centroidOldFromNew);
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
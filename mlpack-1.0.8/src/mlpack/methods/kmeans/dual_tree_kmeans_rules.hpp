@@ -0,0 +1,127 @@
+/**
+ * @file dual_tree_kmeans_rules.hpp
+ *
+ * The rules for the dual-tree traversal of DualTreeAssignment, which finds the
+ * nearest centroid of each point with a tree on the points and a tree on the
+ * centroids.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_HPP
+#define __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The rules of a dual-tree traversal which finds the nearest centroid (in
+ * Euclidean distance) of every point, with the points as the query set and the
+ * centroids as the reference set.  The query tree must use DualTreeKMeansStat.
+ *
+ * Besides the usual pruning of a pair of nodes when the reference node is
+ * further than the upper bound of the query node, a whole query node is
+ * assigned to a centroid c without any base cases when
+ *
+ *   d(center, c) + furthest descendant distance < s(c),
+ *
+ * where s(c) is half the distance from c to its nearest other centroid: every
+ * point of the node is then closer to c than to any other centroid.  The owner
+ * is stored in the statistic of the node, and every later pair with that node
+ * (or its descendants) is pruned.
+ *
+ * @tparam TreeType Type of tree (the same for the points and the centroids).
+ */
+template<typename TreeType>
+class DualTreeKMeansRules
+{
+ public:
+  /**
+   * Construct the rules.  The assignments must be filled with an invalid index
+   * and the distances with DBL_MAX before the traversal.
+   *
+   * @param dataset Points, in the order of the query tree.
+   * @param centroids Centroids, in the order of the reference tree.
+   * @param halfSeparation Half the distance from each centroid to its nearest
+   *     other centroid, in the order of the reference tree.
+   * @param assignments Nearest centroid found for each point.
+   * @param distances Distance from each point to its nearest centroid found.
+   */
+  DualTreeKMeansRules(const arma::mat& dataset,
+                      const arma::mat& centroids,
+                      const arma::vec& halfSeparation,
+                      arma::Col<size_t>& assignments,
+                      arma::vec& distances);
+
+  //! Compare a point with a centroid.
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for the recursion of a point into a reference node; DBL_MAX
+   * means the node can be pruned.
+   *
+   * @param queryIndex Index of the query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode) const;
+
+  /**
+   * Get the score for the recursion of a query node into a reference node;
+   * DBL_MAX means the pair can be pruned.  This also tightens the upper bound
+   * of the query node and checks whether the reference node owns it.
+   *
+   * @param queryNode Candidate query node.
+   * @param referenceNode Candidate reference node.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score of a pair of nodes which was scored before, since
+   * the bound or the owner of the query node may have changed since.
+   *
+   * @param queryNode Candidate query node.
+   * @param referenceNode Candidate reference node.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore);
+
+ private:
+  //! The points.
+  const arma::mat& dataset;
+  //! The centroids.
+  const arma::mat& centroids;
+  //! Half the distance from each centroid to its nearest other centroid.
+  const arma::vec& halfSeparation;
+  //! The nearest centroid found for each point.
+  arma::Col<size_t>& assignments;
+  //! The distance from each point to its nearest centroid found.
+  arma::vec& distances;
+
+  //! Take the owner and the bound of the parent of the query node, which also
+  //! hold for the node itself, and, for a leaf, the bound given by its points.
+  void UpdateBound(TreeType& queryNode);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "dual_tree_kmeans_rules_impl.hpp"
+
+#endif
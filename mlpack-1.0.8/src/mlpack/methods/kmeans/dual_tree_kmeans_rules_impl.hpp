@@ -0,0 +1,151 @@
+/**
+ * @file dual_tree_kmeans_rules_impl.hpp
+ *
+ * Implementation of the DualTreeKMeansRules class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dual_tree_kmeans_rules.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename TreeType>
+DualTreeKMeansRules<TreeType>::DualTreeKMeansRules(
+    const arma::mat& dataset,
+    const arma::mat& centroids,
+    const arma::vec& halfSeparation,
+    arma::Col<size_t>& assignments,
+    arma::vec& distances) :
+    dataset(dataset),
+    centroids(centroids),
+    halfSeparation(halfSeparation),
+    assignments(assignments),
+    distances(distances)
+{
+  // Nothing to do.
+}
+
+template<typename TreeType>
+inline
+double DualTreeKMeansRules<TreeType>::BaseCase(const size_t queryIndex,
+                                               const size_t referenceIndex)
+{
+  const double distance = metric::EuclideanDistance::Evaluate(
+      dataset.unsafe_col(queryIndex), centroids.unsafe_col(referenceIndex));
+
+  if (distance < distances[queryIndex])
+  {
+    distances[queryIndex] = distance;
+    assignments[queryIndex] = referenceIndex;
+  }
+
+  return distance;
+}
+
+template<typename TreeType>
+inline double DualTreeKMeansRules<TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode) const
+{
+  const double distance = referenceNode.MinDistance(
+      dataset.unsafe_col(queryIndex));
+
+  return (distance > distances[queryIndex]) ? DBL_MAX : distance;
+}
+
+template<typename TreeType>
+inline double DualTreeKMeansRules<TreeType>::Score(TreeType& queryNode,
+                                                   TreeType& referenceNode)
+{
+  UpdateBound(queryNode);
+
+  if (queryNode.Stat().Owner() != size_t(-1))
+    return DBL_MAX; // Every point of the node is assigned already.
+
+  const double distance = queryNode.MinDistance(&referenceNode);
+  if (distance > queryNode.Stat().UpperBound())
+    return DBL_MAX;
+
+  // A reference node holding a single centroid gives an upper bound for every
+  // point of the query node, and may own the whole query node.
+  if (referenceNode.IsLeaf() && referenceNode.Count() == 1)
+  {
+    const size_t centroid = referenceNode.Begin();
+
+    const double maxDistance = queryNode.MaxDistance(&referenceNode);
+    if (maxDistance < queryNode.Stat().UpperBound())
+      queryNode.Stat().UpperBound() = maxDistance;
+
+    if (metric::EuclideanDistance::Evaluate(queryNode.Stat().Center(),
+        centroids.unsafe_col(centroid)) +
+        queryNode.FurthestDescendantDistance() < halfSeparation[centroid])
+    {
+      queryNode.Stat().Owner() = centroid;
+      return DBL_MAX;
+    }
+  }
+
+  return distance;
+}
+
+template<typename TreeType>
+inline double DualTreeKMeansRules<TreeType>::Rescore(
+    TreeType& queryNode,
+    TreeType& /* referenceNode */,
+    const double oldScore)
+{
+  if (oldScore == DBL_MAX)
+    return oldScore;
+
+  UpdateBound(queryNode);
+
+  if (queryNode.Stat().Owner() != size_t(-1))
+    return DBL_MAX;
+
+  return (oldScore > queryNode.Stat().UpperBound()) ? DBL_MAX : oldScore;
+}
+
+template<typename TreeType>
+void DualTreeKMeansRules<TreeType>::UpdateBound(TreeType& queryNode)
+{
+  if (queryNode.Parent() != NULL)
+  {
+    const TreeType& parent = *queryNode.Parent();
+    if (queryNode.Stat().Owner() == size_t(-1))
+      queryNode.Stat().Owner() = parent.Stat().Owner();
+    if (parent.Stat().UpperBound() < queryNode.Stat().UpperBound())
+      queryNode.Stat().UpperBound() = parent.Stat().UpperBound();
+  }
+
+  // The distances of the points of a leaf give a bound of their own.
+  if (queryNode.IsLeaf() && queryNode.Count() > 0)
+  {
+    const double leafBound = arma::max(distances.subvec(queryNode.Begin(),
+        queryNode.End() - 1));
+    if (leafBound < queryNode.Stat().UpperBound())
+      queryNode.Stat().UpperBound() = leafBound;
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
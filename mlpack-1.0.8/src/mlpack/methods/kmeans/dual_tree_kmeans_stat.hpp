@@ -0,0 +1,87 @@
+/**
+ * @file dual_tree_kmeans_stat.hpp
+ *
+ * The statistic of the point tree of DualTreeAssignment, which holds a bound on
+ * the distance from the points of a node to their nearest centroid, and the
+ * centroid which owns the node (if any).
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_STAT_HPP
+#define __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_STAT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Extra data for each node of the point tree of DualTreeAssignment: an upper
+ * bound on the distance from any point in the node to its nearest centroid,
+ * and the centroid which is known to be the nearest centroid of every point in
+ * the node, if one has been found.  The centre of the bound of the node is
+ * cached too, for the ownership test of DualTreeKMeansRules.
+ */
+class DualTreeKMeansStat
+{
+ public:
+  //! Initialize the statistic for an empty node.
+  DualTreeKMeansStat() :
+      upperBound(DBL_MAX),
+      owner(size_t(-1)) { }
+
+  //! Initialize the statistic for a fully built node.
+  template<typename TreeType>
+  DualTreeKMeansStat(TreeType& node) :
+      upperBound(DBL_MAX),
+      owner(size_t(-1))
+  {
+    node.Centroid(center);
+  }
+
+  //! Forget the bound and the owner, before a new assignment step.
+  void Reset()
+  {
+    upperBound = DBL_MAX;
+    owner = size_t(-1);
+  }
+
+  //! Get the upper bound on the distance to the nearest centroid.
+  double UpperBound() const { return upperBound; }
+  //! Modify the upper bound on the distance to the nearest centroid.
+  double& UpperBound() { return upperBound; }
+  //! Get the owner of the node (size_t(-1) if there is none).
+  size_t Owner() const { return owner; }
+  //! Modify the owner of the node (size_t(-1) if there is none).
+  size_t& Owner() { return owner; }
+  //! Get the centre of the bound of the node.
+  const arma::vec& Center() const { return center; }
+
+ private:
+  //! Upper bound on the distance from any point in the node to its nearest
+  //! centroid.
+  double upperBound;
+  //! The centroid that is the nearest centroid of every point in the node, or
+  //! size_t(-1) if none is known.
+  size_t owner;
+  //! The centre of the bound of the node.
+  arma::vec center;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
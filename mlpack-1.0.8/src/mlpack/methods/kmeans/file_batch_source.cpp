@@ -0,0 +1,113 @@
+/**
+ * @file file_batch_source.cpp
+ *
+ * Implementation of the FileBatchSource class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "file_batch_source.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kmeans;
+
+FileBatchSource::FileBatchSource(const std::string& filename,
+                                 const bool wrap) :
+    filename(filename),
+    stream(filename.c_str()),
+    dimensionality(0),
+    wrap(wrap),
+    line(0)
+{
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open file '" << filename << "' for reading!"
+        << std::endl;
+
+  // The first point tells us the dimensionality.
+  std::vector<double> values;
+  if (!ReadLine(values))
+    Log::Fatal << "File '" << filename << "' does not contain any points!"
+        << std::endl;
+
+  dimensionality = values.size();
+  Reset();
+}
+
+size_t FileBatchSource::NextBatch(arma::mat& batch, const size_t batchSize)
+{
+  batch.set_size(dimensionality, batchSize);
+
+  std::vector<double> values;
+  size_t points = 0;
+  while (points < batchSize)
+  {
+    if (!ReadLine(values))
+    {
+      if (!wrap)
+        break;
+
+      Reset();
+      continue;
+    }
+
+    if (values.size() != dimensionality)
+      Log::Fatal << "Line " << line << " of '" << filename << "' has "
+          << values.size() << " values, but " << dimensionality
+          << " were expected!" << std::endl;
+
+    for (size_t i = 0; i < dimensionality; ++i)
+      batch(i, points) = values[i];
+    ++points;
+  }
+
+  if (points < batchSize)
+    batch.resize(dimensionality, points);
+
+  return points;
+}
+
+void FileBatchSource::Reset()
+{
+  stream.clear();
+  stream.seekg(0, std::ios::beg);
+  line = 0;
+}
+
+bool FileBatchSource::ReadLine(std::vector<double>& values)
+{
+  values.clear();
+
+  std::string text;
+  while (values.empty() && std::getline(stream, text))
+  {
+    ++line;
+
+    // Commas and tabs separate values just like spaces.
+    for (size_t i = 0; i < text.size(); ++i)
+      if (text[i] == ',' || text[i] == '\t')
+        text[i] = ' ';
+
+    std::istringstream lineStream(text);
+    double value;
+    while (lineStream >> value)
+      values.push_back(value);
+
+    if (!lineStream.eof())
+      Log::Fatal << "Line " << line << " of '" << filename << "' could not be "
+          << "parsed!" << std::endl;
+  }
+
+  return !values.empty();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file file_batch_source.hpp
+ *
+ * A batch source for MiniBatchKMeans which reads points from a text file, so
+ * that the dataset never has to be held in memory.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_FILE_BATCH_SOURCE_HPP
+#define __MLPACK_METHODS_KMEANS_FILE_BATCH_SOURCE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <fstream>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * A source of batches of points for MiniBatchKMeans, which reads the points
+ * from a text file one batch at a time.  The file has one point per line, with
+ * the values separated by commas, tabs or spaces (as in the CSV files that
+ * data::Load() reads).  Only the current batch is held in memory.
+ *
+ * The points are read in the order they appear in the file, so if the file is
+ * sorted in some way, it should be shuffled first.  When the end of the file
+ * is reached, reading starts again at the beginning, unless Wrap() is false; in
+ * that case, the last batch may be smaller than requested, and after it all
+ * batches are empty.  Reset() goes back to the beginning of the file.
+ */
+class FileBatchSource
+{
+ public:
+  /**
+   * Open the given file and find the dimensionality of the points in it.  If
+   * the file cannot be opened or holds no points, a fatal error is given.
+   *
+   * @param filename Name of the file to read points from.
+   * @param wrap Whether to start again at the beginning of the file when the
+   *     end is reached.
+   */
+  FileBatchSource(const std::string& filename, const bool wrap = true);
+
+  /**
+   * Read the next batch of points from the file.  If a line with the wrong
+   * number of values is found, a fatal error is given.
+   *
+   * @param batch Matrix to store the points in (one per column).
+   * @param batchSize Number of points to read.
+   * @return The number of points read.
+   */
+  size_t NextBatch(arma::mat& batch, const size_t batchSize);
+
+  //! Go back to the beginning of the file.
+  void Reset();
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+
+  //! Get whether reading starts again at the beginning of the file.
+  bool Wrap() const { return wrap; }
+  //! Modify whether reading starts again at the beginning of the file.
+  bool& Wrap() { return wrap; }
+
+ private:
+  /**
+   * Read the values on the next non-empty line of the file.  Returns false if
+   * the end of the file was reached.
+   */
+  bool ReadLine(std::vector<double>& values);
+
+  //! Name of the file.
+  std::string filename;
+  //! The open file.
+  std::ifstream stream;
+  //! Dimensionality of the points.
+  size_t dimensionality;
+  //! Whether to start again at the beginning of the file.
+  bool wrap;
+  //! The number of the last line read (for error messages).
+  size_t line;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file hamerly_assignment.hpp
+ *
+ * An accelerated assignment step for K-Means, which uses Hamerly's bounds to
+ * avoid most distance calculations.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_HAMERLY_ASSIGNMENT_HPP
+#define __MLPACK_METHODS_KMEANS_HAMERLY_ASSIGNMENT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An AssignmentPolicy for KMeans which gives the same assignments as
+ * NaiveAssignment, but skips distance calculations that cannot change the
+ * assignment of a point.  This is the algorithm from the following paper:
+ *
+ * @code
+ * @inproceedings{hamerly2010making,
+ *   title={Making k-means even faster},
+ *   author={Hamerly, G.},
+ *   booktitle={Proceedings of the 2010 SIAM International Conference on Data
+ *       Mining (SDM 10)},
+ *   pages={130--140},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * For each point, an upper bound on the distance to its assigned centroid and a
+ * lower bound on the distance to every other centroid are kept.  After each
+ * iteration, the bounds are loosened by how far the centroids moved.  A point
+ * keeps its assignment without any distance calculations if its upper bound is
+ * less than its lower bound, or less than half the distance from its centroid
+ * to the nearest other centroid.  Once most points have stopped moving, this
+ * avoids almost all of the distance calculations.
+ *
+ * The bounds rely on the triangle inequality, so the metric must be a true
+ * metric.  The exception is an LMetric which does not take the root (such as
+ * the default SquaredEuclideanDistance); the root is taken here before the
+ * bounds are used.  Two doubles and one size_t are stored for each point.
+ */
+class HamerlyAssignment
+{
+ public:
+  //! Empty constructor, required by the AssignmentPolicy policy.
+  HamerlyAssignment() { }
+
+  /**
+   * Prepare to cluster the given dataset; no bounds are known yet.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to be clustered.
+   * @param clusters Number of clusters.
+   */
+  template<typename MatType>
+  void Initialize(const MatType& data, const size_t clusters);
+
+  /**
+   * Calculate how far each centroid has moved since the last iteration, and
+   * the distance from each centroid to the nearest other centroid.
+   *
+   * @tparam MetricType Type of distance metric.
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param metric Distance metric.
+   * @param centroids Centroids of each cluster (one per column).
+   */
+  template<typename MetricType, typename MatType>
+  void Update(const MetricType& metric, const MatType& centroids);
+
+  /**
+   * Find the closest centroid to the given point, using the bounds of the point
+   * to avoid distance calculations where possible.
+   *
+   * @tparam MetricType Type of distance metric.
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param metric Distance metric.
+   * @param data Dataset being clustered.
+   * @param centroids Centroids of each cluster (one per column).
+   * @param point Index of the point to assign.
+   * @param assignment Current assignment of the point.
+   * @return Index of the closest centroid.
+   */
+  template<typename MetricType, typename MatType>
+  size_t Assign(const MetricType& metric,
+                const MatType& data,
+                const MatType& centroids,
+                const size_t point,
+                const size_t assignment);
+
+ private:
+  //! Upper bound on the distance from each point to its assigned centroid.
+  arma::vec upperBounds;
+  //! Lower bound on the distance from each point to any other centroid.
+  arma::vec lowerBounds;
+  //! The assignment of each point that its bounds refer to.
+  arma::Col<size_t> boundAssignments;
+
+  //! Centroids of the previous iteration.
+  arma::mat oldCentroids;
+  //! Distance each centroid moved in the last iteration.
+  arma::vec movement;
+  //! Half the distance from each centroid to the nearest other centroid.
+  arma::vec halfSeparation;
+  //! The centroid which moved the furthest in the last iteration.
+  size_t maxMovementCluster;
+  //! The distance the centroid that moved the furthest moved.
+  double maxMovement;
+  //! The largest distance moved by any other centroid.
+  double secondMaxMovement;
+
+  //! Evaluate the distance between two points with the given metric.
+  template<typename MetricType, typename VecType1, typename VecType2>
+  static double Distance(const MetricType& metric,
+                         const VecType1& a,
+                         const VecType2& b);
+
+  //! Evaluate the distance between two points with an LMetric that does not
+  //! take the root, and take the root so the triangle inequality holds.
+  template<int Power, typename VecType1, typename VecType2>
+  static double Distance(const metric::LMetric<Power, false>& metric,
+                         const VecType1& a,
+                         const VecType2& b);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "hamerly_assignment_impl.hpp"
+
+#endif
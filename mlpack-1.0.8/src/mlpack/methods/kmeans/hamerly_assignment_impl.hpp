@@ -0,0 +1,187 @@
+/**
+ * @file hamerly_assignment_impl.hpp
+ *
+ * Implementation of the HamerlyAssignment class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_HAMERLY_ASSIGNMENT_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_HAMERLY_ASSIGNMENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "hamerly_assignment.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void HamerlyAssignment::Initialize(const MatType& data, const size_t clusters)
+{
+  // No point has any bounds yet; an invalid bound assignment forces each point
+  // to be checked in the first iteration.
+  upperBounds.set_size(data.n_cols);
+  upperBounds.fill(std::numeric_limits<double>::infinity());
+  lowerBounds.zeros(data.n_cols);
+  boundAssignments.set_size(data.n_cols);
+  boundAssignments.fill(clusters);
+
+  oldCentroids.reset();
+  movement.zeros(clusters);
+  halfSeparation.zeros(clusters);
+  maxMovementCluster = 0;
+  maxMovement = 0.0;
+  secondMaxMovement = 0.0;
+}
+
+template<typename MetricType, typename MatType>
+void HamerlyAssignment::Update(const MetricType& metric,
+                               const MatType& centroids)
+{
+  const arma::mat newCentroids(centroids);
+  const size_t clusters = newCentroids.n_cols;
+
+  // Find how far each centroid moved.  On the first iteration, the bounds are
+  // not set yet, so the movement does not matter.
+  movement.zeros(clusters);
+  maxMovementCluster = 0;
+  maxMovement = 0.0;
+  secondMaxMovement = 0.0;
+  if (oldCentroids.n_cols == clusters)
+  {
+    for (size_t j = 0; j < clusters; ++j)
+    {
+      movement[j] = Distance(metric, oldCentroids.col(j),
+          newCentroids.col(j));
+
+      if (movement[j] > maxMovement)
+      {
+        secondMaxMovement = maxMovement;
+        maxMovement = movement[j];
+        maxMovementCluster = j;
+      }
+      else if (movement[j] > secondMaxMovement)
+      {
+        secondMaxMovement = movement[j];
+      }
+    }
+  }
+
+  // Find the distance from each centroid to the nearest other centroid.  A
+  // point closer to its centroid than half of that distance cannot be closer
+  // to any other centroid.
+  halfSeparation.fill(std::numeric_limits<double>::infinity());
+  for (size_t i = 0; i < clusters; ++i)
+  {
+    for (size_t j = i + 1; j < clusters; ++j)
+    {
+      const double distance = 0.5 * Distance(metric, newCentroids.col(i),
+          newCentroids.col(j));
+
+      if (distance < halfSeparation[i])
+        halfSeparation[i] = distance;
+      if (distance < halfSeparation[j])
+        halfSeparation[j] = distance;
+    }
+  }
+
+  oldCentroids = newCentroids;
+}
+
+template<typename MetricType, typename MatType>
+size_t HamerlyAssignment::Assign(const MetricType& metric,
+                                 const MatType& data,
+                                 const MatType& centroids,
+                                 const size_t point,
+                                 const size_t assignment)
+{
+  double& upperBound = upperBounds[point];
+  double& lowerBound = lowerBounds[point];
+
+  if (assignment != boundAssignments[point])
+  {
+    // The point was moved since its bounds were set (or the bounds were never
+    // set at all), so nothing is known.
+    upperBound = std::numeric_limits<double>::infinity();
+    lowerBound = 0.0;
+  }
+  else
+  {
+    // Loosen the bounds by how far the centroids moved.
+    upperBound += movement[assignment];
+    lowerBound -= (assignment == maxMovementCluster) ? secondMaxMovement :
+        maxMovement;
+  }
+
+  const double bound = std::max(halfSeparation[assignment], lowerBound);
+  if (upperBound <= bound)
+    return assignment;
+
+  // Tighten the upper bound and try again.
+  upperBound = Distance(metric, data.col(point), centroids.col(assignment));
+  if (upperBound <= bound)
+  {
+    boundAssignments[point] = assignment;
+    return assignment;
+  }
+
+  // We have to look at every centroid, keeping the closest two.
+  double minDistance = std::numeric_limits<double>::infinity();
+  double secondMinDistance = std::numeric_limits<double>::infinity();
+  size_t closestCluster = centroids.n_cols; // Invalid value.
+  for (size_t j = 0; j < centroids.n_cols; ++j)
+  {
+    const double distance = (j == assignment) ? upperBound :
+        Distance(metric, data.col(point), centroids.col(j));
+
+    if (distance < minDistance)
+    {
+      secondMinDistance = minDistance;
+      minDistance = distance;
+      closestCluster = j;
+    }
+    else if (distance < secondMinDistance)
+    {
+      secondMinDistance = distance;
+    }
+  }
+
+  upperBound = minDistance;
+  lowerBound = secondMinDistance;
+  boundAssignments[point] = closestCluster;
+
+  return closestCluster;
+}
+
+template<typename MetricType, typename VecType1, typename VecType2>
+double HamerlyAssignment::Distance(const MetricType& metric,
+                                   const VecType1& a,
+                                   const VecType2& b)
+{
+  return metric.Evaluate(a, b);
+}
+
+template<int Power, typename VecType1, typename VecType2>
+double HamerlyAssignment::Distance(const metric::LMetric<Power, false>& metric,
+                                   const VecType1& a,
+                                   const VecType2& b)
+{
+  return pow(metric.Evaluate(a, b), 1.0 / Power);
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
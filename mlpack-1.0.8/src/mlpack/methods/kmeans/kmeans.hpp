@@ -27,6 +27,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "random_partition.hpp"
 #include "max_variance_new_cluster.hpp"
+#include "naive_assignment.hpp"
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
 
@@ -39,9 +40,10 @@ namespace kmeans /** K-Means clustering. */ {
  * found; then, those clusters will be merged together to produce the desired
  * number of clusters.
  *
- * Two template parameters can (optionally) be supplied: the policy for how to
- * find the initial partition of the data, and the actions to be taken when an
- * empty cluster is encountered, as well as the distance metric to be used.
+ * Three template parameters can (optionally) be supplied: the policy for how to
+ * find the initial partition of the data, the actions to be taken when an
+ * empty cluster is encountered, and how each point is assigned to its closest
+ * centroid, as well as the distance metric to be used.
  *
  * A simple example of how to run K-Means clustering is shown below.
  *
@@ -56,6 +58,11 @@ namespace kmeans /** K-Means clustering. */ {
  * // overclustering factor of 4.0.
  * KMeans<metric::ManhattanDistance> k(100, 4.0);
  * k.Cluster(data, 6, assignments); // 6 clusters.
+ *
+ * // Use Hamerly's bounds to avoid most distance calculations.
+ * KMeans<metric::SquaredEuclideanDistance, RandomPartition,
+ *     MaxVarianceNewCluster, HamerlyAssignment> k;
+ * k.Cluster(data, 3, assignments);
  * @endcode
  *
  * @tparam MetricType The distance metric to use for this KMeans; see
@@ -66,12 +73,18 @@ namespace kmeans /** K-Means clustering. */ {
  * @tparam EmptyClusterPolicy Policy for what to do on an empty cluster; must
  *     implement a default constructor and 'void EmptyCluster(const arma::mat&,
  *     arma::Col<size_t&)'.
+ * @tparam AssignmentPolicy Policy for finding the closest centroid to each
+ *     point in the assignment step; see NaiveAssignment for the methods it
+ *     must implement.
  *
- * @see RandomPartition, RefinedStart, AllowEmptyClusters, MaxVarianceNewCluster
+ * @see RandomPartition, RefinedStart, AllowEmptyClusters,
+ *     MaxVarianceNewCluster, NaiveAssignment, HamerlyAssignment,
+ *     DualTreeAssignment
  */
 template<typename MetricType = metric::SquaredEuclideanDistance,
          typename InitialPartitionPolicy = RandomPartition,
-         typename EmptyClusterPolicy = MaxVarianceNewCluster>
+         typename EmptyClusterPolicy = MaxVarianceNewCluster,
+         typename AssignmentPolicy = NaiveAssignment>
 class KMeans
 {
  public:
@@ -96,12 +109,15 @@ class KMeans
    *     specially initialized partitioning policy is required.
    * @param emptyClusterAction Optional EmptyClusterPolicy object; for when a
    *     specially initialized empty cluster policy is required.
+   * @param assigner Optional AssignmentPolicy object; each call to Cluster()
+   *     starts from a copy of it.
    */
   KMeans(const size_t maxIterations = 1000,
          const double overclusteringFactor = 1.0,
          const MetricType metric = MetricType(),
          const InitialPartitionPolicy partitioner = InitialPartitionPolicy(),
-         const EmptyClusterPolicy emptyClusterAction = EmptyClusterPolicy());
+         const EmptyClusterPolicy emptyClusterAction = EmptyClusterPolicy(),
+         const AssignmentPolicy assigner = AssignmentPolicy());
 
 
   /**
@@ -139,6 +155,40 @@ class KMeans
    * should have the same number of rows as the data matrix, and number of
    * columns equal to 'clusters'.
    *
+   * If Threads() is not 1, the points are split into one block per thread for
+   * the assignment step; each block accumulates its own centroid sums and
+   * counts, and these are merged in a fixed order at the end of each
+   * iteration.
+   *
+   * Single-precision data (arma::fmat) is summed in double precision, so the
+   * centroids (stored as arma::fmat) lose no accuracy on large datasets.
+   * Sparse data (arma::sp_mat) is summed into dense matrices, visiting only
+   * the nonzero elements of each point.  For clustering sparse data by cosine
+   * similarity, see SphericalKMeans.
+   *
+   * If a Monitor() is set and stops the clustering early, the assignments and
+   * centroids are those of the last finished iteration.
+   *
+   * If Restarts() is more than 1 and no initial guess is given, the clustering
+   * is run that many times from different initial assignments, and the one
+   * with the lowest cost (the sum of the distances from each point to its
+   * centroid, as given by MetricType) is kept.  The restarts are independent:
+   * up to Threads() of them run at once (each of them then runs its
+   * assignment step serially), and each draws its random numbers from its own
+   * stream (see math::ScopedThreadStream).  With a Monitor(), the restarts run
+   * one after another, and no more are started once it stops the clustering.
+   *
+   * If a Comm() is set, the data is only the shard of this rank, and the sums
+   * and counts of the clusters (and the number of changed assignments) are
+   * summed over all ranks in each iteration, so every rank finds the same
+   * centroids, and the assignments of the points of its shard.  The initial
+   * centroids must then be the same on every rank: either give the same
+   * initialCentroidGuess on each rank, or let the InitialPartitionPolicy
+   * assign the points of each shard (the initial centroids are the means of
+   * the global clusters).  Restarts() is not used, and the EmptyClusterPolicy
+   * is not either, since it would only see one shard: an empty cluster keeps
+   * its centroid.  Every rank must call Cluster() at once.
+   *
    * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
    * @param data Dataset to cluster.
    * @param clusters Number of clusters to compute.
@@ -158,14 +208,85 @@ class KMeans
                const bool initialCentroidGuess = false) const;
 
   /**
-   * An implementation of k-means using the Pelleg-Moore algorithm; this is
-   * known to not work -- do not use it!  (Fixing it is TODO, of course; see
-   * #251.)
+   * Perform k-means clustering on the data with the Pelleg-Moore algorithm,
+   * returning a list of cluster assignments.  See the other overload of
+   * FastCluster() for details.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param initialGuess If true, then it is assumed that assignments has a list
+   *      of initial cluster assignments.
    */
-  template<typename MatType>
-  void FastCluster(MatType& data,
+  void FastCluster(const arma::mat& data,
+                   const size_t clusters,
+                   arma::Col<size_t>& assignments,
+                   const bool initialGuess = false) const;
+
+  /**
+   * Perform k-means clustering on the data with the Pelleg-Moore algorithm,
+   * returning a list of cluster assignments and also the centroids of each
+   * cluster.  The parameters are the same as for Cluster(), and so is the
+   * resulting clustering; only the assignment step is different.
+   *
+   * An mrkd-tree is built on (a copy of) the dataset once.  In each iteration,
+   * the tree is traversed with a list of candidate centroids.  At each node,
+   * every candidate which is further than some other candidate from every
+   * point in the hyperrectangle of the node is removed from the list.  When
+   * only one candidate is left, all of the points in the node are assigned to
+   * it at once, using the cached sum and count of the points of the node.
+   * This is the algorithm from the following paper:
+   *
+   * @code
+   * @inproceedings{pelleg1999accelerating,
+   *   title={Accelerating exact k-means algorithms with geometric reasoning},
+   *   author={Pelleg, D. and Moore, A.},
+   *   booktitle={Proceedings of the Fifth ACM SIGKDD International Conference
+   *       on Knowledge Discovery and Data Mining (KDD '99)},
+   *   pages={277--281},
+   *   year={1999}
+   * }
+   * @endcode
+   *
+   * This works best on low-dimensional data.  The Euclidean distance is always
+   * used, regardless of MetricType, and AssignmentPolicy is not used.
+   * Threads() is only used to run Restarts() at once, as with Cluster().
+   *
+   * If a MemoryBudget is set and the copy of the dataset and the tree do not
+   * fit in it (see PeakMemory()), or if a Comm() is set, Cluster() is used
+   * instead.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialAssignmentGuess If true, then it is assumed that assignments
+   *      has a list of initial cluster assignments.
+   * @param initialCentroidGuess If true, then it is assumed that centroids
+   *      contains the initial centroids of each cluster.
+   */
+  void FastCluster(const arma::mat& data,
                    const size_t clusters,
-                   arma::Col<size_t>& assignments) const;
+                   arma::Col<size_t>& assignments,
+                   arma::mat& centroids,
+                   const bool initialAssignmentGuess = false,
+                   const bool initialCentroidGuess = false) const;
+
+  /**
+   * Return the working memory (in bytes, beyond the dataset, assignments and
+   * centroids) that Cluster() or (if fast is true) FastCluster() is expected
+   * to need for the given problem size.  For Cluster(), this does not include
+   * the state kept by the AssignmentPolicy.
+   *
+   * @param points Number of points in the dataset.
+   * @param dimensionality Dimensionality of the dataset.
+   * @param clusters Number of clusters to compute.
+   * @param fast Whether the estimate is for FastCluster().
+   */
+  size_t PeakMemory(const size_t points,
+                    const size_t dimensionality,
+                    const size_t clusters,
+                    const bool fast = false) const;
 
   //! Return the overclustering factor.
   double OverclusteringFactor() const { return overclusteringFactor; }
@@ -177,6 +298,36 @@ class KMeans
   //! Set the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of threads used for the assignment step (1 is serial, 0
+  //! is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the assignment step (1 is serial, 0
+  //! is all cores).
+  size_t& Threads() { return threads; }
+
+  //! Get the number of times the clustering is run from different initial
+  //! assignments, keeping the best (1 is a single run).
+  size_t Restarts() const { return restarts; }
+  //! Modify the number of times the clustering is run from different initial
+  //! assignments, keeping the best (1 is a single run).
+  size_t& Restarts() { return restarts; }
+
+  //! Get the monitor which observes Cluster() and FastCluster() (NULL if there
+  //! is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes Cluster() and FastCluster(); it is
+  //! called after each iteration with the number of changed assignments, and
+  //! can stop the clustering early (see ProgressMonitor).
+  ProgressMonitor*& Monitor() { return monitor; }
+
+  //! Get the communicator of the ranks the data is distributed over (NULL if
+  //! the clustering runs on one process).
+  Communicator* Comm() const { return comm; }
+  //! Modify the communicator of the ranks the data is distributed over; each
+  //! rank then clusters its own shard, and the statistics of the clusters are
+  //! summed over all ranks (see Cluster()).
+  Communicator*& Comm() { return comm; }
+
   //! Get the distance metric.
   const MetricType& Metric() const { return metric; }
   //! Modify the distance metric.
@@ -193,17 +344,156 @@ class KMeans
   //! Modify the empty cluster policy.
   EmptyClusterPolicy& EmptyClusterAction() { return emptyClusterAction; }
 
+  //! Get the assignment policy.
+  const AssignmentPolicy& Assigner() const { return assigner; }
+  //! Modify the assignment policy.
+  AssignmentPolicy& Assigner() { return assigner; }
+
  private:
+  /**
+   * Check the initial guesses given to Cluster() or FastCluster(), or use the
+   * partitioner to find initial assignments if no guess was given.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters requested.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Initial centroids, if initialCentroidGuess is true.
+   * @param initialAssignmentGuess Whether assignments holds a guess.
+   * @param initialCentroidGuess Whether centroids holds a guess.
+   * @return The number of clusters to find, including overclustering.
+   */
+  template<typename MatType>
+  size_t InitialAssignments(const MatType& data,
+                            const size_t clusters,
+                            arma::Col<size_t>& assignments,
+                            const MatType& centroids,
+                            const bool initialAssignmentGuess,
+                            const bool initialCentroidGuess) const;
+
+  /**
+   * Merge the nearest clusters together until only the requested number of
+   * clusters is left.  This does nothing if no overclustering was done.
+   *
+   * @param clusters Number of clusters requested.
+   * @param actualClusters Number of clusters found.
+   * @param assignments Cluster assignments of each point.
+   * @param centroids Centroids of each cluster.
+   * @param counts Number of points in each cluster.
+   */
+  template<typename MatType>
+  void MergeClusters(const size_t clusters,
+                     const size_t actualClusters,
+                     arma::Col<size_t>& assignments,
+                     MatType& centroids,
+                     arma::Col<size_t>& counts) const;
+
+  /**
+   * Compute the sum of the points in each cluster and the number of points in
+   * each cluster, given the assignments of each point.
+   *
+   * @param data Dataset being clustered.
+   * @param assignments Cluster assignments of each point.
+   * @param sums Matrix to store the sum of the points in each cluster in (of
+   *     the accumulator type of the data; see math::AccumulatorType).
+   * @param counts Vector to store the number of points in each cluster in.
+   */
+  template<typename MatType, typename SumType>
+  void ClusterSums(const MatType& data,
+                   const arma::Col<size_t>& assignments,
+                   SumType& sums,
+                   arma::Col<size_t>& counts) const;
+
+  /**
+   * Set each centroid to the mean of the points in its cluster, given their
+   * sums and counts.  If a Comm() is set, an empty cluster keeps its centroid.
+   *
+   * @param sums Sum of the points in each cluster.
+   * @param counts Number of points in each cluster.
+   * @param centroids Centroids of each cluster.
+   */
+  template<typename SumType, typename MatType>
+  void UpdateCentroids(const SumType& sums,
+                       const arma::Col<size_t>& counts,
+                       MatType& centroids) const;
+
+  /**
+   * Run Cluster() (or FastCluster(), if fast is true) Restarts() times without
+   * initial guesses, and keep the clustering with the lowest cost.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored.
+   * @param fast Whether FastCluster() is used.
+   */
+  template<typename MatType>
+  void Restart(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               MatType& centroids,
+               const bool fast) const;
+
+  //! Run one restart with the given KMeans object: FastCluster() if fast is
+  //! true, and Cluster() otherwise.
+  static void SingleRun(const KMeans& single,
+                        const arma::mat& data,
+                        const size_t clusters,
+                        arma::Col<size_t>& assignments,
+                        arma::mat& centroids,
+                        const bool fast);
+
+  //! Run one restart with the given KMeans object; FastCluster() only takes
+  //! dense matrices, so this always uses Cluster().
+  template<typename MatType>
+  static void SingleRun(const KMeans& single,
+                        const MatType& data,
+                        const size_t clusters,
+                        arma::Col<size_t>& assignments,
+                        MatType& centroids,
+                        const bool fast);
+
+  //! Return the sum of the distances from each point to its centroid.
+  template<typename MatType>
+  double Cost(const MatType& data,
+              const arma::Col<size_t>& assignments,
+              const MatType& centroids) const;
+
+  /**
+   * Sum the sums and counts of the clusters and the number of changed
+   * assignments over all ranks of Comm().  This does nothing if there is no
+   * communicator.
+   */
+  template<typename MatType>
+  void Reduce(MatType& sums,
+              arma::Col<size_t>& counts,
+              size_t& changedAssignments) const;
+
+  /**
+   * Return the number of threads that should be used (this resolves a setting
+   * of 0 to the number of available cores).
+   */
+  size_t NumThreads() const;
+
   //! Factor controlling how many clusters are actually found.
   double overclusteringFactor;
   //! Maximum number of iterations before giving up.
   size_t maxIterations;
+  //! Number of threads to use; 1 is serial, 0 is all cores.
+  size_t threads;
+  //! Number of times the clustering is run, keeping the best.
+  size_t restarts;
+  //! Monitor of the progress of the clustering (may be NULL).
+  ProgressMonitor* monitor;
+  //! Communicator of the ranks the data is distributed over (may be NULL).
+  Communicator* comm;
   //! Instantiated distance metric.
   MetricType metric;
   //! Instantiated initial partitioning policy.
   InitialPartitionPolicy partitioner;
   //! Instantiated empty cluster policy.
   EmptyClusterPolicy emptyClusterAction;
+  //! Instantiated assignment policy.
+  AssignmentPolicy assigner;
 };
 
 }; // namespace kmeans
@@ -28,6 +28,10 @@
 #include <stack>
 #include <limits>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -36,20 +40,28 @@ namespace kmeans {
  */
 template<typename MetricType,
          typename InitialPartitionPolicy,
-         typename EmptyClusterPolicy>
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
 KMeans<
     MetricType,
     InitialPartitionPolicy,
-    EmptyClusterPolicy>::
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
 KMeans(const size_t maxIterations,
        const double overclusteringFactor,
        const MetricType metric,
        const InitialPartitionPolicy partitioner,
-       const EmptyClusterPolicy emptyClusterAction) :
+       const EmptyClusterPolicy emptyClusterAction,
+       const AssignmentPolicy assigner) :
     maxIterations(maxIterations),
+    threads(1),
+    restarts(1),
+    monitor(NULL),
+    comm(NULL),
     metric(metric),
     partitioner(partitioner),
-    emptyClusterAction(emptyClusterAction)
+    emptyClusterAction(emptyClusterAction),
+    assigner(assigner)
 {
   // Validate overclustering factor.
   if (overclusteringFactor < 1.0)
@@ -64,480 +76,519 @@ KMeans(const size_t maxIterations,
   }
 }
 
+/**
+ * Perform k-means clustering on the data, returning a list of cluster
+ * assignments.  This just forward to the other function, which returns the
+ * centroids too.  If this is properly inlined, there shouldn't be any
+ * performance penalty whatsoever.
+ */
 template<typename MetricType,
          typename InitialPartitionPolicy,
-         typename EmptyClusterPolicy>
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+inline void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+Cluster(const MatType& data,
+        const size_t clusters,
+        arma::Col<size_t>& assignments,
+        const bool initialGuess) const
+{
+  MatType centroids(data.n_rows, clusters);
+  Cluster(data, clusters, assignments, centroids, initialGuess);
+}
+
+/**
+ * Perform k-means clustering on the data, returning a list of cluster
+ * assignments and the centroids of each cluster.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
 template<typename MatType>
 void KMeans<
     MetricType,
     InitialPartitionPolicy,
-    EmptyClusterPolicy>::
-FastCluster(MatType& data,
-            const size_t clusters,
-            arma::Col<size_t>& assignments) const
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+Cluster(const MatType& data,
+        const size_t clusters,
+        arma::Col<size_t>& assignments,
+        MatType& centroids,
+        const bool initialAssignmentGuess,
+        const bool initialCentroidGuess) const
 {
-  size_t actualClusters = size_t(overclusteringFactor * clusters);
-  if (actualClusters > data.n_cols)
+  // Restarts compare local costs, so they are not run on distributed data.
+  if (restarts > 1 && !initialAssignmentGuess && !initialCentroidGuess &&
+      comm == NULL)
   {
-    Log::Warn << "KMeans::Cluster(): overclustering factor is too large.  No "
-        << "overclustering will be done." << std::endl;
-    actualClusters = clusters;
+    Restart(data, clusters, assignments, centroids, false);
+    return;
   }
 
-  size_t dimensionality = data.n_rows;
-
-  // Centroids of each cluster.  Each column corresponds to a centroid.
-  MatType centroids(dimensionality, actualClusters);
-  centroids.zeros();
+  const size_t actualClusters = InitialAssignments(data, clusters, assignments,
+      centroids, initialAssignmentGuess, initialCentroidGuess);
 
   // Counts of points in each cluster.
   arma::Col<size_t> counts(actualClusters);
-  counts.zeros();
 
-  // Build the mrkd-tree on this dataset.
-  tree::BinarySpaceTree<typename bound::HRectBound<2>, tree::MRKDStatistic>
-      tree(data, 1);
-  Log::Debug << "Tree Built." << std::endl;
-  // A pointer for traversing the mrkd-tree.
-  tree::BinarySpaceTree<typename bound::HRectBound<2>, tree::MRKDStatistic>*
-      node;
-
-  // Now, the initial assignments.  First determine if they are necessary.
-  if (assignments.n_elem != data.n_cols)
-  {
-    // Use the partitioner to come up with the partition assignments.
-    partitioner.Cluster(data, actualClusters, assignments);
-  }
-
-  // Set counts correctly.
-  for (size_t i = 0; i < assignments.n_elem; i++)
-    counts[assignments[i]]++;
-
-  // Sum the points for each centroid
-  for (size_t i = 0; i < data.n_cols; i++)
-    centroids.col(assignments[i]) += data.col(i);
-
-  // Then divide the sums by the count to get the center of mass for this
-  // centroids assigned points
-  for (size_t i = 0; i < actualClusters; i++)
-    centroids.col(i) /= counts[i];
-
-  // Instead of retraversing the tree after an iteration, we will update
-  // centroid positions in this matrix, which also prevents clobbering our
-  // centroids from the previous iteration.
-  MatType newCentroids(dimensionality, centroids.n_cols);
-
-  // Create a stack for traversing the mrkd-tree.
-  std::stack<typename tree::BinarySpaceTree<typename bound::HRectBound<2>,
-                                            tree::MRKDStatistic>* > stack;
+  // Resize to correct size.  On distributed data, a cluster which is empty
+  // keeps its centroid, so the centroids start at zero unless a guess was
+  // given.
+  if (comm != NULL && (initialAssignmentGuess || !initialCentroidGuess))
+    centroids.zeros(data.n_rows, actualClusters);
+  else
+    centroids.set_size(data.n_rows, actualClusters);
 
-  // A variable to keep track of how many kmeans iterations we have made.
-  size_t iteration = 0;
+  // Sums of the points in each cluster, from which the centroids are
+  // calculated.  Single-precision data is summed in double precision.
+  typedef typename math::AccumulatorType<MatType>::type SumType;
+  SumType sums;
+  ClusterSums(data, assignments, sums, counts);
 
-  // A variable to keep track of how many nodes assignments have changed in
-  // each kmeans iteration.
   size_t changedAssignments = 0;
+  Reduce(sums, counts, changedAssignments);
 
-  // A variable to keep track of the number of times something is skipped due
-  // to the blacklist.
-  size_t skip = 0;
+  // For the assignment step, the points are split into one contiguous block
+  // for each thread, and each block accumulates its own sums and counts.
+  const size_t blocks = std::max(std::min(NumThreads(), (size_t) data.n_cols),
+      (size_t) 1);
+  std::vector<SumType> blockSums(blocks);
+  std::vector<arma::Col<size_t> > blockCounts(blocks);
+  arma::Col<size_t> blockChanged(blocks);
 
-  // A variable to keep track of the number of distances calculated.
-  size_t comps = 0;
+  // The assignment policy may keep state for each point between iterations.
+  AssignmentPolicy assignment(assigner);
+  assignment.Initialize(data, actualClusters);
 
-  // A variable to keep track of how often we stop at a parent node.
-  size_t dominations = 0;
+  size_t iteration = 0;
   do
   {
-    // Keep track of what iteration we are on.
-    ++iteration;
-    changedAssignments = 0;
+    // Update step.
+    // Calculate centroids based on the sums of the points assigned to them.
+    UpdateCentroids(sums, counts, centroids);
 
-    // Reset the newCentroids so that we can store the newly calculated ones
-    // here.
-    newCentroids.zeros();
+    assignment.Update(metric, centroids);
 
-    // Reset the counts.
-    counts.zeros();
+    // Assignment step.
+    // Find the closest centroid to each point.  We will keep track of how many
+    // assignments change.  When no assignments change, we are done.
+    #pragma omp parallel for num_threads(blocks) schedule(static)
+    for (int b = 0; b < (int) blocks; b++)
+    {
+      blockSums[b].zeros(data.n_rows, actualClusters);
+      blockCounts[b].zeros(actualClusters);
+      blockChanged[b] = 0;
 
-    // Add the root node of the tree to the stack.
-    stack.push(&tree);
-    // Set the top level whitelist.
-    tree.Stat().Whitelist().resize(centroids.n_cols, true);
+      const size_t begin = (size_t) b * data.n_cols / blocks;
+      const size_t end = (size_t) (b + 1) * data.n_cols / blocks;
+      for (size_t i = begin; i < end; i++)
+      {
+        // Find the closest centroid to this point.
+        const size_t closestCluster = assignment.Assign(metric, data,
+            centroids, i, assignments[i]);
 
-    // Traverse the tree.
-    while (!stack.empty())
+        // Reassign this point to the closest cluster.
+        if (assignments[i] != closestCluster)
+        {
+          assignments[i] = closestCluster;
+          blockChanged[b]++;
+        }
+
+        // Add the point to the sums for the next update step.
+        math::Accumulate(blockSums[b], closestCluster, data, i);
+        blockCounts[b][closestCluster]++;
+      }
+    }
+
+    // Merge the blocks, always in the same order.
+    sums = blockSums[0];
+    counts = blockCounts[0];
+    changedAssignments = blockChanged[0];
+    for (size_t b = 1; b < blocks; b++)
     {
-      // Get the next node in the tree.
-      node = stack.top();
-      // Remove the node from the stack.
-      stack.pop();
+      sums += blockSums[b];
+      counts += blockCounts[b];
+      changedAssignments += blockChanged[b];
+    }
 
-      // Get a reference to the mrkd statistic for this hyperrectangle.
-      tree::MRKDStatistic& mrkd = node->Stat();
+    Reduce(sums, counts, changedAssignments);
 
-      // We use this to store the index of the centroid with the minimum
-      // distance from this hyperrectangle or point.
-      size_t minIndex = 0;
+    // If we are not allowing empty clusters, then check that all of our
+    // clusters have points.  The policy only sees the local shard, so it is
+    // not used on distributed data.
+    size_t emptyClusterChanges = 0;
+    for (size_t i = 0; (i < actualClusters) && (comm == NULL); i++)
+      if (counts[i] == 0)
+        emptyClusterChanges += emptyClusterAction.EmptyCluster(data, i,
+            centroids, counts, assignments);
 
-      // If this node is a leaf, then we calculate the distance from
-      // the centroids to every point the node contains.
-      if (node->IsLeaf())
-      {
-        for (size_t i = mrkd.Begin(); i < mrkd.Count() + mrkd.Begin(); ++i)
-        {
-          // Initialize minDistance to be nonzero.
-          double minDistance = metric.Evaluate(data.col(i), centroids.col(0));
+    // If points were moved to fill empty clusters, the sums are out of date.
+    if (emptyClusterChanges > 0)
+    {
+      ClusterSums(data, assignments, sums, counts);
+      changedAssignments += emptyClusterChanges;
+    }
 
-          // Find the minimal distance centroid for this point.
-          for (size_t j = 1; j < centroids.n_cols; ++j)
-          {
-            // If this centroid is not in the whitelist, skip it.
-            if (!mrkd.Whitelist()[j])
-            {
-              ++skip;
-              continue;
-            }
+    iteration++;
 
-            ++comps;
-            double distance = metric.Evaluate(data.col(i), centroids.col(j));
-            if (minDistance > distance)
-            {
-              minIndex = j;
-              minDistance = distance;
-            }
-          }
+    // The monitor may stop the clustering after any iteration.
+    if (monitor && changedAssignments > 0 &&
+        !monitor->Continue("KMeans::Cluster()", iteration, changedAssignments))
+      break;
 
-          // Add this point to the undivided center of mass summation for its
-          // assigned centroid.
-          newCentroids.col(minIndex) += data.col(i);
+  } while (changedAssignments > 0 && iteration != maxIterations);
 
-          // Increment the count for the minimum distance centroid.
-          ++counts(minIndex);
+  if (changedAssignments == 0)
+  {
+    MLPACK_LOG_DEBUG << "KMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    MLPACK_LOG_DEBUG << "KMeans::Cluster(): terminated after "
+        << iteration << " iterations." << std::endl;
 
-          // If we actually changed assignments, increment changedAssignments
-          // and modify the assignment vector for this point.
-          if (assignments(i) != minIndex)
-          {
-            ++changedAssignments;
-            assignments(i) = minIndex;
-          }
-        }
-      }
-      // If this node is not a leaf, then we continue trying to find dominant
-      // centroids.
-      else
-      {
-        bound::HRectBound<2>& bound = node->Bound();
+    // Recalculate final clusters.
+    UpdateCentroids(sums, counts, centroids);
+  }
 
-        // A flag to keep track of if we find a single centroid that is closer
-        // to all points in this hyperrectangle than any other centroid.
-        bool noDomination = false;
+  // If we have overclustered, we need to merge the nearest clusters.
+  MergeClusters(clusters, actualClusters, assignments, centroids, counts);
+}
 
-        // Calculate the center of mass of this hyperrectangle.
-        arma::vec center = mrkd.CenterOfMass() / mrkd.Count();
+/**
+ * Perform k-means clustering on the data with the Pelleg-Moore algorithm,
+ * returning a list of cluster assignments.  This just forwards to the other
+ * function, which returns the centroids too.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+inline void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+FastCluster(const arma::mat& data,
+            const size_t clusters,
+            arma::Col<size_t>& assignments,
+            const bool initialGuess) const
+{
+  arma::mat centroids(data.n_rows, clusters);
+  FastCluster(data, clusters, assignments, centroids, initialGuess);
+}
 
-        // Set the minDistance to the maximum value of a double so any value
-        // must be smaller than this.
-        double minDistance = std::numeric_limits<double>::max();
+/**
+ * Perform k-means clustering on the data with the Pelleg-Moore algorithm,
+ * returning a list of cluster assignments and the centroids of each cluster.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+FastCluster(const arma::mat& data,
+            const size_t clusters,
+            arma::Col<size_t>& assignments,
+            arma::mat& centroids,
+            const bool initialAssignmentGuess,
+            const bool initialCentroidGuess) const
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>, tree::MRKDStatistic>
+      TreeType;
 
-        // The candidate distance we calculate for each centroid.
-        double distance = 0.0;
+  // The mrkd-tree only holds the local shard of distributed data.
+  if (comm != NULL)
+  {
+    Cluster(data, clusters, assignments, centroids, initialAssignmentGuess,
+        initialCentroidGuess);
+    return;
+  }
 
-        // How many points are inside this hyperrectangle, we stop if we
-        // see more than 1.
-        size_t contains = 0;
+  if (restarts > 1 && !initialAssignmentGuess && !initialCentroidGuess)
+  {
+    Restart(data, clusters, assignments, centroids, true);
+    return;
+  }
 
-        // Find the "owner" of this hyperrectangle, if one exists.
-        for (size_t i = 0; i < centroids.n_cols; ++i)
-        {
-          // If this centroid is not in the whitelist, skip it.
-          if (!mrkd.Whitelist()[i])
-          {
-            ++skip;
-            continue;
-          }
+  // The tree is built on a copy of the dataset; if that does not fit in the
+  // memory budget, use the naive algorithm, which needs no copy.
+  const size_t fastMemory = PeakMemory(data.n_cols, data.n_rows, clusters,
+      true);
+  if (!MemoryBudget::Fits(fastMemory))
+  {
+    Log::Info << "KMeans::FastCluster(): the mrkd-tree needs about "
+        << MemoryBudget::Format(fastMemory) << ", more than the memory budget;"
+        << " using Cluster() instead." << std::endl;
+    Cluster(data, clusters, assignments, centroids, initialAssignmentGuess,
+        initialCentroidGuess);
+    return;
+  }
 
-          // Incrememnt the number of distance calculations for what we are
-          // about to do.
-          comps += 2;
+  const size_t actualClusters = InitialAssignments(data, clusters, assignments,
+      centroids, initialAssignmentGuess, initialCentroidGuess);
+  const size_t dimensionality = data.n_rows;
 
-          // Reinitialize the distance so += works right.
-          distance = 0.0;
+  // Build the mrkd-tree.  This reorders the points, so it is built on a copy of
+  // the dataset, and the assignments are reordered to match.
+  arma::mat treeData(data);
+  std::vector<size_t> oldFromNew;
+  TreeType tree(treeData, oldFromNew);
+  MLPACK_LOG_DEBUG << "KMeans::FastCluster(): tree built." << std::endl;
 
-          // We keep track of how many dimensions have nonzero distance,
-          // if this is 0 then the distance is 0.
-          size_t nonZero = 0;
+  arma::Col<size_t> treeAssignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    treeAssignments[i] = assignments[oldFromNew[i]];
 
-          /*
-            Compute the distance to the hyperrectangle for this centroid.
-            We do this by finding the furthest point from the centroid inside
-            the hyperrectangle. This is a corner of the hyperrectangle.
+  // Counts of points in each cluster.
+  arma::Col<size_t> counts(actualClusters);
 
-            In order to do this faster, we calculate both the distance and the
-            furthest point simultaneously.
+  // Resize to correct size.
+  centroids.set_size(dimensionality, actualClusters);
 
-            This following code is equivalent to, but faster than:
+  // Sums of the points in each cluster, from which the centroids are
+  // calculated.
+  arma::mat sums;
+  ClusterSums(treeData, treeAssignments, sums, counts);
 
-            arma::vec p;
-            p.zeros(dimensionality);
+  // Create a stack for traversing the mrkd-tree.
+  std::stack<TreeType*> stack;
 
-            for (size_t j = 0; j < dimensionality; ++j)
-            {
-              if (centroids(j,i) < bound[j].Lo())
-                p(j) = bound[j].Lo();
-              else
-                p(j) = bound[j].Hi();
-            }
+  size_t changedAssignments = 0;
+  size_t iteration = 0;
 
-            distance = metric.Evaluate(p.col(0), centroids.col(i));
-          */
-          for (size_t j = 0; j < dimensionality; ++j)
-          {
-            double ij = centroids(j,i);
-            double lo = bound[j].Lo();
+  // Keep track of the number of distances calculated, and of how often a
+  // whole node is assigned to one centroid.
+  size_t distanceCalculations = 0;
+  size_t dominations = 0;
+  do
+  {
+    // Update step.
+    // Calculate centroids based on the sums of the points assigned to them.
+    centroids = sums;
+    for (size_t i = 0; i < actualClusters; i++)
+      centroids.col(i) /= counts[i];
 
-            if (ij < lo)
-            {
-              // (ij - lo)^2
-              ij -= lo;
-              ij *= ij;
+    // Assignment step.
+    // Every centroid is a candidate to own points in the root node, except for
+    // those of empty clusters, which have no position.
+    tree.Stat().Whitelist().clear();
+    for (size_t i = 0; i < actualClusters; ++i)
+      if (counts[i] > 0)
+        tree.Stat().Whitelist().push_back(i);
+
+    sums.zeros();
+    counts.zeros();
+    changedAssignments = 0;
+    stack.push(&tree);
 
-              distance += ij;
-              ++nonZero;
-            }
-            else
-            {
-              double hi = bound[j].Hi();
-              if (ij > hi)
-              {
-                // (ij - hi)^2
-                ij -= hi;
-                ij *= ij;
-
-                distance += ij;
-                ++nonZero;
-              }
-            }
-          }
+    while (!stack.empty())
+    {
+      TreeType* node = stack.top();
+      stack.pop();
 
-          // The centroid is inside the hyperrectangle.
-          if (nonZero == 0)
-          {
-            ++contains;
-            minDistance = 0.0;
-            minIndex = i;
-
-            // If more than two points are within this hyperrectangle, then
-            // there can be no dominating centroid, so we should continue
-            // to the children nodes.
-            if (contains > 1)
-            {
-              noDomination = true;
-              break;
-            }
-          }
+      tree::MRKDStatistic& mrkd = node->Stat();
+      std::vector<size_t>& candidates = mrkd.Whitelist();
+      const bound::HRectBound<2>& bound = node->Bound();
 
-          if (fabs(distance - minDistance) <= 1e-10)
+      if (candidates.size() > 1)
+      {
+        // Find the candidate closest to the center of the hyperrectangle.
+        size_t minIndex = 0;
+        double minDistance = std::numeric_limits<double>::infinity();
+        for (size_t c = 0; c < candidates.size(); ++c)
+        {
+          double distance = 0.0;
+          for (size_t j = 0; j < dimensionality; ++j)
           {
-            noDomination = true;
-            break;
+            const double diff = centroids(j, candidates[c]) - bound[j].Mid();
+            distance += diff * diff;
           }
-          else if (distance < minDistance)
+
+          if (distance < minDistance)
           {
-            minIndex = i;
             minDistance = distance;
+            minIndex = candidates[c];
           }
         }
-
-        distance = minDistance;
-        // Determine if the owner dominates this centroid only if there was
-        // exactly one owner.
-        if (!noDomination)
+        distanceCalculations += candidates.size();
+
+        // Now remove every other candidate which is further than that one from
+        // every point in the hyperrectangle.  If the corner of the
+        // hyperrectangle furthest in the direction of c_i - c_min is closer to
+        // c_min, then so is every other point in it; see the Pelleg and Moore
+        // paper.
+        size_t kept = 0;
+        for (size_t c = 0; c < candidates.size(); ++c)
         {
-          for (size_t i = 0; i < centroids.n_cols; ++i)
+          const size_t i = candidates[c];
+          if (i != minIndex)
           {
-            if (i == minIndex)
-              continue;
-            // If this centroid is blacklisted for this hyperrectangle, then
-            // we skip it.
-            if (!mrkd.Whitelist()[i])
-            {
-              ++skip;
-              continue;
-            }
-            /*
-              Compute the dominating centroid for this hyperrectangle, if one
-              exists. We do this by calculating the point which is furthest
-              from the min'th centroid in the direction of c_k - c_min. We do
-              this as outlined in the Pelleg and Moore paper.
-
-              This following code is equivalent to, but faster than:
-
-              arma::vec p;
-              p.zeros(dimensionality);
-
-              for (size_t k = 0; k < dimensionality; ++k)
-              {
-                p(k) = (centroids(k,i) > centroids(k,minIndex)) ?
-                  bound[k].Hi() : bound[k].Lo();
-              }
-
-              double distancei = metric.Evaluate(p.col(0), centroids.col(i));
-              double distanceMin = metric.Evaluate(p.col(0),
-                  centroids.col(minIndex));
-            */
-
-            comps += 1;
             double distancei = 0.0;
             double distanceMin = 0.0;
             for (size_t k = 0; k < dimensionality; ++k)
             {
-              double ci = centroids(k, i);
-              double cm = centroids(k, minIndex);
-              if (ci > cm)
-              {
-                double hi = bound[k].Hi();
-
-                ci -= hi;
-                cm -= hi;
-
-                ci *= ci;
-                cm *= cm;
-
-                distancei += ci;
-                distanceMin += cm;
-              }
-              else
-              {
-                double lo = bound[k].Lo();
-
-                ci -= lo;
-                cm -= lo;
-
-                ci *= ci;
-                cm *= cm;
-
-                distancei += ci;
-                distanceMin += cm;
-              }
-            }
+              const double ci = centroids(k, i);
+              const double cm = centroids(k, minIndex);
+              const double corner = (ci > cm) ? bound[k].Hi() : bound[k].Lo();
 
-            if (distanceMin >= distancei)
-            {
-              noDomination = true;
-              break;
-            }
-            else
-            {
-              mrkd.Whitelist()[i] = false;
+              distancei += (ci - corner) * (ci - corner);
+              distanceMin += (cm - corner) * (cm - corner);
             }
+            ++distanceCalculations;
+
+            if (distanceMin < distancei)
+              continue;
           }
-        }
 
-        // If did found a centroid that was closer to every point in the
-        // hyperrectangle than every other centroid, then update that centroid.
-        if (!noDomination)
-        {
-          // Adjust the new centroid sum for the min distance point to this
-          // hyperrectangle by the center of mass of this hyperrectangle.
-          newCentroids.col(minIndex) += mrkd.CenterOfMass();
+          candidates[kept++] = i;
+        }
+        candidates.resize(kept);
+      }
 
-          // Increment the counts for this centroid.
-          counts(minIndex) += mrkd.Count();
+      if (candidates.size() == 1)
+      {
+        // One centroid owns the whole hyperrectangle, so we can use the cached
+        // sum of its points.
+        const size_t owner = candidates[0];
+        sums.col(owner) += mrkd.CenterOfMass();
+        counts[owner] += node->Count();
 
-          // Update all assignments for this node.
-          const size_t begin = node->Begin();
-          const size_t end = node->End();
+        for (size_t j = node->Begin(); j < node->End(); ++j)
+        {
+          if (treeAssignments[j] != owner)
+          {
+            treeAssignments[j] = owner;
+            ++changedAssignments;
+          }
+        }
 
-          // TODO: Do this outside of the kmeans iterations.
-          for (size_t j = begin; j < end; ++j)
+        mrkd.DominatingCentroid() = owner;
+        ++dominations;
+      }
+      else if (node->IsLeaf())
+      {
+        // Compare each point with the centroids that are left.
+        for (size_t j = node->Begin(); j < node->End(); ++j)
+        {
+          size_t closestCluster = candidates[0];
+          double minDistance = metric::SquaredEuclideanDistance::Evaluate(
+              treeData.col(j), centroids.col(closestCluster));
+          for (size_t c = 1; c < candidates.size(); ++c)
           {
-            if (assignments(j) != minIndex)
+            const double distance = metric::SquaredEuclideanDistance::Evaluate(
+                treeData.col(j), centroids.col(candidates[c]));
+            if (distance < minDistance)
             {
-              ++changedAssignments;
-              assignments(j) = minIndex;
+              minDistance = distance;
+              closestCluster = candidates[c];
             }
           }
-          mrkd.DominatingCentroid() = minIndex;
-
-          // Keep track of the number of times we found a dominating centroid.
-          ++dominations;
-        }
+          distanceCalculations += candidates.size();
 
-        // If we did not find a dominating centroid then we fall through to the
-        // default case, where we add the children of this node to the stack.
-        else
-        {
-          // Add this hyperrectangle's children to our stack.
-          stack.push(node->Left());
-          stack.push(node->Right());
+          sums.col(closestCluster) += treeData.col(j);
+          ++counts[closestCluster];
 
-          // (Re)Initialize the whiteList for the children.
-          node->Left()->Stat().Whitelist() = mrkd.Whitelist();
-          node->Right()->Stat().Whitelist() = mrkd.Whitelist();
+          if (treeAssignments[j] != closestCluster)
+          {
+            treeAssignments[j] = closestCluster;
+            ++changedAssignments;
+          }
         }
       }
+      else
+      {
+        // Pass the remaining candidates on to the children.
+        node->Left()->Stat().Whitelist() = candidates;
+        node->Right()->Stat().Whitelist() = candidates;
+        stack.push(node->Left());
+        stack.push(node->Right());
+      }
+    }
+
+    // If we are not allowing empty clusters, then check that all of our
+    // clusters have points.
+    size_t emptyClusterChanges = 0;
+    for (size_t i = 0; i < actualClusters; i++)
+      if (counts[i] == 0)
+        emptyClusterChanges += emptyClusterAction.EmptyCluster(treeData, i,
+            centroids, counts, treeAssignments);
 
+    // If points were moved to fill empty clusters, the sums are out of date.
+    if (emptyClusterChanges > 0)
+    {
+      ClusterSums(treeData, treeAssignments, sums, counts);
+      changedAssignments += emptyClusterChanges;
     }
 
-    // Divide by the number of points assigned to the centroids so that we
-    // have the actual center of mass and update centroids' positions.
-    for (size_t i = 0; i < centroids.n_cols; ++i)
-      if (counts(i))
-        centroids.col(i) = newCentroids.col(i) / counts(i);
+    iteration++;
+
+    // The monitor may stop the clustering after any iteration.
+    if (monitor && changedAssignments > 0 &&
+        !monitor->Continue("KMeans::FastCluster()", iteration,
+        changedAssignments))
+      break;
 
-    // Stop when we reach max iterations or we changed no assignments
-    // assignments.
   } while (changedAssignments > 0 && iteration != maxIterations);
 
-  Log::Info << "Iterations: " << iteration << std::endl
-      << "Skips: " << skip << std::endl
-      << "Comparisons: " << comps << std::endl
-      << "Dominations: " << dominations << std::endl;
-}
+  if (changedAssignments == 0)
+  {
+    MLPACK_LOG_DEBUG << "KMeans::FastCluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    MLPACK_LOG_DEBUG << "KMeans::FastCluster(): terminated after "
+        << iteration << " iterations." << std::endl;
 
-/**
- * Perform k-means clustering on the data, returning a list of cluster
- * assignments.  This just forward to the other function, which returns the
- * centroids too.  If this is properly inlined, there shouldn't be any
- * performance penalty whatsoever.
- */
-template<typename MetricType,
-         typename InitialPartitionPolicy,
-         typename EmptyClusterPolicy>
-template<typename MatType>
-inline void KMeans<
-    MetricType,
-    InitialPartitionPolicy,
-    EmptyClusterPolicy>::
-Cluster(const MatType& data,
-        const size_t clusters,
-        arma::Col<size_t>& assignments,
-        const bool initialGuess) const
-{
-  MatType centroids(data.n_rows, clusters);
-  Cluster(data, clusters, assignments, centroids, initialGuess);
+    // Recalculate final clusters.
+    centroids = sums;
+    for (size_t i = 0; i < actualClusters; i++)
+      centroids.col(i) /= counts[i];
+  }
+
+  MLPACK_LOG_DEBUG << "KMeans::FastCluster(): " << distanceCalculations
+      << " distance calculations; " << dominations << " nodes assigned to a "
+      << "single centroid." << std::endl;
+
+  // Map the assignments back to the original order of the points.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[oldFromNew[i]] = treeAssignments[i];
+
+  // If we have overclustered, we need to merge the nearest clusters.
+  MergeClusters(clusters, actualClusters, assignments, centroids, counts);
 }
 
 /**
- * Perform k-means clustering on the data, returning a list of cluster
- * assignments and the centroids of each cluster.
+ * Check the given initial guesses (or use the partitioner to come up with
+ * initial assignments), and return the number of clusters to actually find.
  */
 template<typename MetricType,
          typename InitialPartitionPolicy,
-         typename EmptyClusterPolicy>
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
 template<typename MatType>
-void KMeans<
+size_t KMeans<
     MetricType,
     InitialPartitionPolicy,
-    EmptyClusterPolicy>::
-Cluster(const MatType& data,
-        const size_t clusters,
-        arma::Col<size_t>& assignments,
-        MatType& centroids,
-        const bool initialAssignmentGuess,
-        const bool initialCentroidGuess) const
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+InitialAssignments(const MatType& data,
+                   const size_t clusters,
+                   arma::Col<size_t>& assignments,
+                   const MatType& centroids,
+                   const bool initialAssignmentGuess,
+                   const bool initialCentroidGuess) const
 {
   // Make sure we have more points than clusters.
   if (clusters > data.n_cols)
@@ -603,220 +654,446 @@ Cluster(const MatType& data,
     partitioner.Cluster(data, actualClusters, assignments);
   }
 
-  // Counts of points in each cluster.
-  arma::Col<size_t> counts(actualClusters);
-  counts.zeros();
-
-  // Resize to correct size.
-  centroids.set_size(data.n_rows, actualClusters);
+  return actualClusters;
+}
 
-  // Set counts correctly.
-  for (size_t i = 0; i < assignments.n_elem; i++)
-    counts[assignments[i]]++;
+/**
+ * Merge the nearest clusters found by overclustering, until only the requested
+ * number of clusters is left.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+MergeClusters(const size_t clusters,
+              const size_t actualClusters,
+              arma::Col<size_t>& assignments,
+              MatType& centroids,
+              arma::Col<size_t>& counts) const
+{
+  // Nothing to do if we have not overclustered.
+  if (actualClusters == clusters)
+    return;
+
+  // Generate a list of all the clusters' distances from each other.  This
+  // list will become mangled and unused as the number of clusters decreases.
+  size_t numDistances = ((actualClusters - 1) * actualClusters) / 2;
+  size_t clustersLeft = actualClusters;
+  arma::vec distances(numDistances);
+  arma::Col<size_t> firstCluster(numDistances);
+  arma::Col<size_t> secondCluster(numDistances);
+
+  // Keep the mappings of clusters that we are changing.
+  arma::Col<size_t> mappings = arma::linspace<arma::Col<size_t> >(0,
+      actualClusters - 1, actualClusters);
+
+  size_t i = 0;
+  for (size_t first = 0; first < actualClusters; first++)
+  {
+    for (size_t second = first + 1; second < actualClusters; second++)
+    {
+      distances(i) = metric.Evaluate(centroids.col(first),
+                                     centroids.col(second));
+      firstCluster(i) = first;
+      secondCluster(i) = second;
+      i++;
+    }
+  }
 
-  size_t changedAssignments = 0;
-  size_t iteration = 0;
-  do
+  while (clustersLeft != clusters)
   {
-    // Update step.
-    // Calculate centroids based on given assignments.
-    centroids.zeros();
+    arma::uword minIndex;
+    distances.min(minIndex);
 
-    for (size_t i = 0; i < data.n_cols; i++)
-      centroids.col(assignments[i]) += data.col(i);
+    // Now we merge the clusters which that distance belongs to.
+    size_t first = firstCluster(minIndex);
+    size_t second = secondCluster(minIndex);
+    for (size_t j = 0; j < assignments.n_elem; j++)
+      if (assignments(j) == second)
+        assignments(j) = first;
 
-    for (size_t i = 0; i < actualClusters; i++)
-      centroids.col(i) /= counts[i];
+    // Now merge the centroids.
+    centroids.col(first) *= counts[first];
+    centroids.col(first) += (counts[second] * centroids.col(second));
+    centroids.col(first) /= (counts[first] + counts[second]);
 
-    // Assignment step.
-    // Find the closest centroid to each point.  We will keep track of how many
-    // assignments change.  When no assignments change, we are done.
-    changedAssignments = 0;
-    for (size_t i = 0; i < data.n_cols; i++)
-    {
-      // Find the closest centroid to this point.
-      double minDistance = std::numeric_limits<double>::infinity();
-      size_t closestCluster = actualClusters; // Invalid value.
+    // Update the counts.
+    counts[first] += counts[second];
+    counts[second] = 0;
 
-      for (size_t j = 0; j < actualClusters; j++)
+    // Now update all the relevant distances.
+    // First the distances where either cluster is the second cluster.
+    for (size_t cluster = 0; cluster < second; cluster++)
+    {
+      // The offset is sum^n i - sum^(n - m) i, where n is actualClusters and
+      // m is the cluster we are trying to offset to.
+      size_t offset = (size_t) (((actualClusters - 1) * cluster)
+          + (cluster - pow(cluster, 2.0)) / 2) - 1;
+
+      // See if we need to update the distance from this cluster to the first
+      // cluster.
+      if (cluster < first)
       {
-        double distance = metric.Evaluate(data.col(i), centroids.col(j));
-
-        if (distance < minDistance)
-        {
-          minDistance = distance;
-          closestCluster = j;
-        }
+        // Make sure it isn't already DBL_MAX.
+        if (distances(offset + (first - cluster)) != DBL_MAX)
+          distances(offset + (first - cluster)) = metric.Evaluate(
+              centroids.col(first), centroids.col(cluster));
       }
 
-      // Reassign this point to the closest cluster.
-      if (assignments[i] != closestCluster)
+      distances(offset + (second - cluster)) = DBL_MAX;
+    }
+
+    // Now the distances where the first cluster is the first cluster.
+    size_t offset = (size_t) (((actualClusters - 1) * first)
+        + (first - pow(first, 2.0)) / 2) - 1;
+    for (size_t cluster = first + 1; cluster < actualClusters; cluster++)
+    {
+      // Make sure it isn't already DBL_MAX.
+      if (distances(offset + (cluster - first)) != DBL_MAX)
       {
-        // Update counts.
-        counts[assignments[i]]--;
-        counts[closestCluster]++;
-        // Update assignment.
-        assignments[i] = closestCluster;
-        changedAssignments++;
+        distances(offset + (cluster - first)) = metric.Evaluate(
+            centroids.col(first), centroids.col(cluster));
       }
     }
 
-    // If we are not allowing empty clusters, then check that all of our
-    // clusters have points.
-    for (size_t i = 0; i < actualClusters; i++)
-      if (counts[i] == 0)
-        changedAssignments += emptyClusterAction.EmptyCluster(data, i,
-            centroids, counts, assignments);
+    // Max the distance between the first and second clusters.
+    distances(offset + (second - first)) = DBL_MAX;
 
-    iteration++;
+    // Now max the distances for the second cluster (which no longer has
+    // anything in it).
+    offset = (size_t) (((actualClusters - 1) * second)
+        + (second - pow(second, 2.0)) / 2) - 1;
+    for (size_t cluster = second + 1; cluster < actualClusters; cluster++)
+      distances(offset + (cluster - second)) = DBL_MAX;
 
-  } while (changedAssignments > 0 && iteration != maxIterations);
+    clustersLeft--;
 
-  if (iteration != maxIterations)
-  {
-    Log::Debug << "KMeans::Cluster(): converged after " << iteration
-        << " iterations." << std::endl;
+    // Update the cluster mappings.
+    mappings(second) = first;
+    // Also update any mappings that were pointed at the previous cluster.
+    for (size_t cluster = 0; cluster < actualClusters; cluster++)
+      if (mappings(cluster) == second)
+        mappings(cluster) = first;
   }
-  else
+
+  // Now remap the mappings down to the smallest possible numbers.
+  // Could this process be sped up?
+  arma::Col<size_t> remappings(actualClusters);
+  remappings.fill(actualClusters);
+  size_t remap = 0; // Counter variable.
+  for (size_t cluster = 0; cluster < actualClusters; cluster++)
   {
-    Log::Debug << "KMeans::Cluster(): terminated after limit of " << iteration
-        << " iterations." << std::endl;
+    // If the mapping of the current cluster has not been assigned a value
+    // yet, we will assign it a cluster number.
+    if (remappings(mappings(cluster)) == actualClusters)
+    {
+      remappings(mappings(cluster)) = remap;
+      remap++;
+    }
+  }
 
-    // Recalculate final clusters.
-    centroids.zeros();
+  // Fix the assignments using the mappings we created.
+  for (size_t j = 0; j < assignments.n_elem; j++)
+    assignments(j) = remappings(mappings(assignments(j)));
+}
 
-    for (size_t i = 0; i < data.n_cols; i++)
-      centroids.col(assignments[i]) += data.col(i);
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType, typename SumType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+ClusterSums(const MatType& data,
+            const arma::Col<size_t>& assignments,
+            SumType& sums,
+            arma::Col<size_t>& counts) const
+{
+  const size_t clusters = counts.n_elem;
+  const size_t blocks = std::max(std::min(NumThreads(), (size_t) data.n_cols),
+      (size_t) 1);
+  std::vector<SumType> blockSums(blocks);
+  std::vector<arma::Col<size_t> > blockCounts(blocks);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static)
+  for (int b = 0; b < (int) blocks; b++)
+  {
+    blockSums[b].zeros(data.n_rows, clusters);
+    blockCounts[b].zeros(clusters);
 
-    for (size_t i = 0; i < actualClusters; i++)
-      centroids.col(i) /= counts[i];
+    const size_t begin = (size_t) b * data.n_cols / blocks;
+    const size_t end = (size_t) (b + 1) * data.n_cols / blocks;
+    for (size_t i = begin; i < end; i++)
+    {
+      math::Accumulate(blockSums[b], assignments[i], data, i);
+      blockCounts[b][assignments[i]]++;
+    }
   }
 
-  // If we have overclustered, we need to merge the nearest clusters.
-  if (actualClusters != clusters)
+  sums = blockSums[0];
+  counts = blockCounts[0];
+  for (size_t b = 1; b < blocks; b++)
   {
-    // Generate a list of all the clusters' distances from each other.  This
-    // list will become mangled and unused as the number of clusters decreases.
-    size_t numDistances = ((actualClusters - 1) * actualClusters) / 2;
-    size_t clustersLeft = actualClusters;
-    arma::vec distances(numDistances);
-    arma::Col<size_t> firstCluster(numDistances);
-    arma::Col<size_t> secondCluster(numDistances);
-
-    // Keep the mappings of clusters that we are changing.
-    arma::Col<size_t> mappings = arma::linspace<arma::Col<size_t> >(0,
-        actualClusters - 1, actualClusters);
-
-    size_t i = 0;
-    for (size_t first = 0; first < actualClusters; first++)
-    {
-      for (size_t second = first + 1; second < actualClusters; second++)
-      {
-        distances(i) = metric.Evaluate(centroids.col(first),
-                                       centroids.col(second));
-        firstCluster(i) = first;
-        secondCluster(i) = second;
-        i++;
-      }
-    }
+    sums += blockSums[b];
+    counts += blockCounts[b];
+  }
+}
 
-    while (clustersLeft != clusters)
-    {
-      arma::uword minIndex;
-      distances.min(minIndex);
-
-      // Now we merge the clusters which that distance belongs to.
-      size_t first = firstCluster(minIndex);
-      size_t second = secondCluster(minIndex);
-      for (size_t j = 0; j < assignments.n_elem; j++)
-        if (assignments(j) == second)
-          assignments(j) = first;
-
-      // Now merge the centroids.
-      centroids.col(first) *= counts[first];
-      centroids.col(first) += (counts[second] * centroids.col(second));
-      centroids.col(first) /= (counts[first] + counts[second]);
-
-      // Update the counts.
-      counts[first] += counts[second];
-      counts[second] = 0;
-
-      // Now update all the relevant distances.
-      // First the distances where either cluster is the second cluster.
-      for (size_t cluster = 0; cluster < second; cluster++)
-      {
-        // The offset is sum^n i - sum^(n - m) i, where n is actualClusters and
-        // m is the cluster we are trying to offset to.
-        size_t offset = (size_t) (((actualClusters - 1) * cluster)
-            + (cluster - pow(cluster, 2.0)) / 2) - 1;
-
-        // See if we need to update the distance from this cluster to the first
-        // cluster.
-        if (cluster < first)
-        {
-          // Make sure it isn't already DBL_MAX.
-          if (distances(offset + (first - cluster)) != DBL_MAX)
-            distances(offset + (first - cluster)) = metric.Evaluate(
-                centroids.col(first), centroids.col(cluster));
-        }
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename SumType, typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+UpdateCentroids(const SumType& sums,
+                const arma::Col<size_t>& counts,
+                MatType& centroids) const
+{
+  // The means are taken in the precision of the sums, and only then stored in
+  // the type of the data.
+  SumType means(sums);
+  for (size_t i = 0; i < counts.n_elem; i++)
+    if (comm == NULL || counts[i] > 0)
+      means.col(i) /= counts[i];
+
+  if (comm == NULL)
+  {
+    math::Narrow(means, centroids);
+    return;
+  }
 
-        distances(offset + (second - cluster)) = DBL_MAX;
-      }
+  // On distributed data, an empty cluster keeps its centroid.
+  MatType newCentroids;
+  math::Narrow(means, newCentroids);
+  for (size_t i = 0; i < counts.n_elem; i++)
+    if (counts[i] > 0)
+      centroids.col(i) = newCentroids.col(i);
+}
 
-      // Now the distances where the first cluster is the first cluster.
-      size_t offset = (size_t) (((actualClusters - 1) * first)
-          + (first - pow(first, 2.0)) / 2) - 1;
-      for (size_t cluster = first + 1; cluster < actualClusters; cluster++)
-      {
-        // Make sure it isn't already DBL_MAX.
-        if (distances(offset + (cluster - first)) != DBL_MAX)
-        {
-          distances(offset + (cluster - first)) = metric.Evaluate(
-              centroids.col(first), centroids.col(cluster));
-        }
-      }
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+size_t KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+PeakMemory(const size_t points,
+           const size_t dimensionality,
+           const size_t clusters,
+           const bool fast) const
+{
+  const size_t actualClusters = (size_t) (overclusteringFactor * clusters);
 
-      // Max the distance between the first and second clusters.
-      distances(offset + (second - first)) = DBL_MAX;
+  if (fast)
+  {
+    typedef tree::BinarySpaceTree<bound::HRectBound<2>, tree::MRKDStatistic>
+        TreeType;
+
+    // The copy of the dataset, the reordered assignments and the mapping, and
+    // the nodes of the tree (about two for each leaf of 20 points), each with
+    // its bound and its statistic (which holds a centroid, and a sum of
+    // points).
+    const size_t nodes = 2 * (points / 20 + 1);
+    return MemoryBudget::MatrixBytes<double>(dimensionality, points) +
+        2 * points * sizeof(size_t) + nodes * (sizeof(TreeType) +
+        MemoryBudget::MatrixBytes<double>(dimensionality, 4)) +
+        MemoryBudget::MatrixBytes<double>(dimensionality, 2 * actualClusters);
+  }
 
-      // Now max the distances for the second cluster (which no longer has
-      // anything in it).
-      offset = (size_t) (((actualClusters - 1) * second)
-          + (second - pow(second, 2.0)) / 2) - 1;
-      for (size_t cluster = second + 1; cluster < actualClusters; cluster++)
-        distances(offset + (cluster - second)) = DBL_MAX;
+  // The sums of the points in each cluster, for each block and merged, and the
+  // counts.
+  const size_t blocks = std::max(std::min(NumThreads(), points), (size_t) 1);
+  return (blocks + 1) * (MemoryBudget::MatrixBytes<double>(dimensionality,
+      actualClusters) + actualClusters * sizeof(size_t));
+}
 
-      clustersLeft--;
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+size_t KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+NumThreads() const
+{
+  return Threads::Count(threads);
+}
 
-      // Update the cluster mappings.
-      mappings(second) = first;
-      // Also update any mappings that were pointed at the previous cluster.
-      for (size_t cluster = 0; cluster < actualClusters; cluster++)
-        if (mappings(cluster) == second)
-          mappings(cluster) = first;
-    }
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+Reduce(MatType& sums,
+       arma::Col<size_t>& counts,
+       size_t& changedAssignments) const
+{
+  if (comm == NULL)
+    return;
+
+  // The statistics are sent as one dense buffer: the sums, then the counts,
+  // then the number of changed assignments.  Counts are exact as doubles.
+  const size_t sumElements = sums.n_rows * sums.n_cols;
+  arma::vec buffer(sumElements + counts.n_elem + 1);
+  arma::mat denseSums(sums);
+  std::copy(denseSums.begin(), denseSums.end(), buffer.begin());
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    buffer[sumElements + i] = (double) counts[i];
+  buffer[buffer.n_elem - 1] = (double) changedAssignments;
+
+  comm->Sum(buffer.memptr(), buffer.n_elem);
+
+  std::copy(buffer.begin(), buffer.begin() + sumElements, denseSums.begin());
+  sums = MatType(denseSums);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    counts[i] = (size_t) buffer[sumElements + i];
+  changedAssignments = (size_t) buffer[buffer.n_elem - 1];
+}
 
-    // Now remap the mappings down to the smallest possible numbers.
-    // Could this process be sped up?
-    arma::Col<size_t> remappings(actualClusters);
-    remappings.fill(actualClusters);
-    size_t remap = 0; // Counter variable.
-    for (size_t cluster = 0; cluster < actualClusters; cluster++)
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+Restart(const MatType& data,
+        const size_t clusters,
+        arma::Col<size_t>& assignments,
+        MatType& centroids,
+        const bool fast) const
+{
+  // A monitor observes one clustering at a time, so with a monitor the
+  // restarts are run one after another.
+  const size_t numThreads = (monitor == NULL) ?
+      std::min(NumThreads(), restarts) : 1;
+
+  double bestCost = std::numeric_limits<double>::max();
+  size_t bestRestart = restarts;
+
+  const math::RandomStream base = math::DrawStream();
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int r = 0; r < (int) restarts; ++r)
+  {
+    // Once the monitor has stopped the clustering, no more restarts are run.
+    if (monitor && monitor->Stopped())
+      continue;
+
+    // Each restart is run by a copy of this object which clusters once.
+    KMeans single(*this);
+    single.restarts = 1;
+
+    math::ScopedThreadStream stream(base.Split((size_t) r));
+    arma::Col<size_t> restartAssignments;
+    MatType restartCentroids;
+    SingleRun(single, data, clusters, restartAssignments, restartCentroids,
+        fast);
+    const double cost = Cost(data, restartAssignments, restartCentroids);
+
+    MLPACK_LOG_DEBUG << "KMeans::Cluster(): cost of restart " << r << " is "
+        << cost << "." << std::endl;
+
+    // Ties go to the first restart, so the result does not depend on the order
+    // in which the restarts finish.
+    #pragma omp critical(kmeans_restart)
+    if (bestRestart == restarts || cost < bestCost ||
+        (cost == bestCost && (size_t) r < bestRestart))
     {
-      // If the mapping of the current cluster has not been assigned a value
-      // yet, we will assign it a cluster number.
-      if (remappings(mappings(cluster)) == actualClusters)
-      {
-        remappings(mappings(cluster)) = remap;
-        remap++;
-      }
+      bestCost = cost;
+      bestRestart = (size_t) r;
+      assignments = restartAssignments;
+      centroids = restartCentroids;
     }
-
-    // Fix the assignments using the mappings we created.
-    for (size_t j = 0; j < assignments.n_elem; j++)
-      assignments(j) = remappings(mappings(assignments(j)));
   }
 }
 
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+SingleRun(const KMeans& single,
+          const arma::mat& data,
+          const size_t clusters,
+          arma::Col<size_t>& assignments,
+          arma::mat& centroids,
+          const bool fast)
+{
+  if (fast)
+    single.FastCluster(data, clusters, assignments, centroids);
+  else
+    single.Cluster(data, clusters, assignments, centroids);
+}
+
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+SingleRun(const KMeans& single,
+          const MatType& data,
+          const size_t clusters,
+          arma::Col<size_t>& assignments,
+          MatType& centroids,
+          const bool /* fast */)
+{
+  single.Cluster(data, clusters, assignments, centroids);
+}
+
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+template<typename MatType>
+double KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    AssignmentPolicy>::
+Cost(const MatType& data,
+     const arma::Col<size_t>& assignments,
+     const MatType& centroids) const
+{
+  double cost = 0.0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+    cost += metric.Evaluate(data.col(i), centroids.col(assignments[i]));
+
+  return cost;
+}
+
 }; // namespace kmeans
 }; // namespace mlpack
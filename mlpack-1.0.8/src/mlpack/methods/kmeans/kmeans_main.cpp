@@ -24,6 +24,12 @@
 #include "kmeans.hpp"
 #include "allow_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_plus_plus.hpp"
+#include "kmeans_parallel_start.hpp"
+#include "hamerly_assignment.hpp"
+#include "dual_tree_assignment.hpp"
+#include "mini_batch_kmeans.hpp"
+#include "spherical_kmeans.hpp"
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -43,7 +49,56 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     " random samples of the dataset; to specify the number of samples, the "
     "--samples parameter is used, and to specify the percentage of the dataset "
     "to be used in each sample, the --percentage parameter is used (it should "
-    "be a value between 0.0 and 1.0).\n");
+    "be a value between 0.0 and 1.0)."
+    "\n\n"
+    "Initial centroids can also be chosen with k-means++ (\"k-means++: The "
+    "advantages of careful seeding\", 2007) with the --kmeans_plus_plus (-K) "
+    "option, or with k-means|| (\"Scalable k-means++\", 2012) with the "
+    "--kmeans_parallel (-L) option.  k-means|| needs only --rounds passes over "
+    "the dataset, in each of which about (--oversampling * clusters) candidate "
+    "points are chosen; the candidates are then reduced to the initial "
+    "centroids with k-means++.  Both use the --threads option."
+    "\n\n"
+    "The --hamerly (-H) option gives the same clustering, but uses Hamerly's "
+    "bounds on the distances between points and centroids to avoid most "
+    "distance calculations once points stop changing clusters.  The "
+    "--fast_kmeans (-f) option also gives the same clustering, but uses the "
+    "algorithm of Pelleg and Moore, which assigns whole nodes of a kd-tree to a"
+    " centroid at once; this is fastest for low-dimensional data.  The "
+    "--dual_tree (-D) option gives the same clustering too: it builds a "
+    "kd-tree on the centroids in each iteration, and finds the nearest "
+    "centroid of every point with a dual-tree traversal of the two trees, "
+    "assigning whole nodes of points at once where possible; this is fastest "
+    "with many clusters (hundreds or thousands) in low dimensions."
+    "\n\n"
+    "With --restarts (-R), the clustering is run that many times from "
+    "different initial points, and the clustering with the lowest sum of "
+    "squared distances from each point to its centroid is kept.  Up to "
+    "--threads restarts are run at once.  Restarts are not done when "
+    "--initial_centroids is given."
+    "\n\n"
+    "With the --mini_batch (-b) option, mini-batch K-Means is run instead: the "
+    "dataset is read from the input file in batches of --batch_size points, "
+    "and is never loaded into memory as a whole.  Clustering stops when no "
+    "centroid moves by more than --tolerance in one batch, or after "
+    "--max_iterations batches.  Because the dataset is not loaded, only the "
+    "labels are written to the output file (as with --labels_only), and "
+    "--in_place cannot be used.  The result is an approximation, so the points "
+    "in the input file should be in random order."
+    "\n\n"
+    "The --curve_order option ('morton' or 'hilbert') sorts the points along a "
+    "space-filling curve before clustering, so that points which are near each "
+    "other are also near each other in memory; this speeds up the tree-based "
+    "assignment steps on large datasets.  The output is in the original order "
+    "of the points.  It is ignored with --mini_batch."
+    "\n\n"
+    "With the --spherical (-a) option, spherical k-means is run instead: the "
+    "points are clustered by cosine similarity, and the centroids are unit "
+    "vectors.  With --sparse (-x), the input file is loaded as a sparse matrix "
+    "(for instance, TF-IDF vectors in an svmlight file), which is never made "
+    "dense; --sparse can only be used with --spherical.  Only the labels are "
+    "written to the output file (as with --labels_only), and the initial "
+    "centroids are random points unless --initial_centroids is given.\n");
 
 // Required options.
 PARAM_STRING_REQ("inputFile", "Input dataset to perform clustering on.", "i");
@@ -69,10 +124,30 @@ PARAM_INT("max_iterations", "Maximum number of iterations before K-Means "
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_STRING("initial_centroids", "Start with the specified initial centroids.",
              "I", "");
-
-// This is known to not work (#251).
-//PARAM_FLAG("fast_kmeans", "Use the experimental fast k-means algorithm by "
-//    "Pelleg and Moore.", "f");
+PARAM_FLAG("hamerly", "Use Hamerly's accelerated assignment step.", "H");
+PARAM_FLAG("dual_tree", "Use the dual-tree assignment step.", "D");
+PARAM_INT("threads", "Number of threads to use for the assignment step (0 uses "
+    "all available cores).  This only has an effect if MLPACK was built with "
+    "OpenMP.", "j", 1);
+PARAM_INT("restarts", "Number of times to run the clustering from different "
+    "initial points, keeping the best clustering.", "R", 1);
+
+PARAM_FLAG("fast_kmeans", "Use the mrkd-tree based algorithm of Pelleg and "
+    "Moore for the assignment step.", "f");
+
+// Parameters for mini-batch k-means.
+PARAM_FLAG("mini_batch", "Use mini-batch K-Means, reading the input file in "
+    "batches.", "b");
+PARAM_INT("batch_size", "Number of points in each batch (use when --mini_batch "
+    "is specified).", "B", 1000);
+PARAM_DOUBLE("tolerance", "Stop when no centroid moves by more than this in one"
+    " batch (use when --mini_batch is specified).", "t", 1e-5);
+
+// Parameters for spherical k-means.
+PARAM_FLAG("spherical", "Use spherical k-means, which clusters by cosine "
+    "similarity.", "a");
+PARAM_FLAG("sparse", "Load the input file as a sparse matrix (use when "
+    "--spherical is specified).", "x");
 
 // Parameters for "refined start" k-means.
 PARAM_FLAG("refined_start", "Use the refined initial point strategy by Bradley "
@@ -82,6 +157,190 @@ PARAM_INT("samplings", "Number of samplings to perform for refined start (use "
 PARAM_DOUBLE("percentage", "Percentage of dataset to use for each refined start"
     " sampling (use when --refined_start is specified).", "p", 0.02);
 
+// Parameters for k-means++ and k-means|| initialization.
+PARAM_FLAG("kmeans_plus_plus", "Use k-means++ to choose initial points.", "K");
+PARAM_FLAG("kmeans_parallel", "Use k-means|| to choose initial points.", "L");
+PARAM_DOUBLE("oversampling", "Expected number of candidates chosen in each "
+    "k-means|| round, as a multiple of the number of clusters (use when "
+    "--kmeans_parallel is specified).", "", 2.0);
+PARAM_INT("rounds", "Number of k-means|| rounds (use when --kmeans_parallel "
+    "is specified).", "", 5);
+
+// Memory layout options.
+PARAM_STRING("curve_order", "Sort the points along a space-filling curve "
+    "before clustering: 'morton' or 'hilbert' (empty for no sorting).", "", "");
+
+// Run K-Means with the given policies and the options given on the command
+// line.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename AssignmentPolicy>
+void RunKMeans(const InitialPartitionPolicy& partitioner,
+               const arma::mat& dataset,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               arma::mat& centroids,
+               const bool initialCentroidGuess)
+{
+  KMeans<metric::SquaredEuclideanDistance, InitialPartitionPolicy,
+      EmptyClusterPolicy, AssignmentPolicy> k(
+      (size_t) CLI::GetParam<int>("max_iterations"),
+      CLI::GetParam<double>("overclustering"),
+      metric::SquaredEuclideanDistance(), partitioner);
+  k.Threads() = (size_t) CLI::GetParam<int>("threads");
+  k.Restarts() = (size_t) CLI::GetParam<int>("restarts");
+
+  Timer::Start("clustering");
+  if (CLI::HasParam("fast_kmeans"))
+    k.FastCluster(dataset, clusters, assignments, centroids, false,
+        initialCentroidGuess);
+  else
+    k.Cluster(dataset, clusters, assignments, centroids, false,
+        initialCentroidGuess);
+  Timer::Stop("clustering");
+}
+
+// Choose the assignment policy, then run K-Means.
+template<typename InitialPartitionPolicy, typename EmptyClusterPolicy>
+void FindAssignmentPolicy(const InitialPartitionPolicy& partitioner,
+                          const arma::mat& dataset,
+                          const size_t clusters,
+                          arma::Col<size_t>& assignments,
+                          arma::mat& centroids,
+                          const bool initialCentroidGuess)
+{
+  if (CLI::HasParam("hamerly"))
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyAssignment>(
+        partitioner, dataset, clusters, assignments, centroids,
+        initialCentroidGuess);
+  else if (CLI::HasParam("dual_tree"))
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, DualTreeAssignment>(
+        partitioner, dataset, clusters, assignments, centroids,
+        initialCentroidGuess);
+  else
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveAssignment>(
+        partitioner, dataset, clusters, assignments, centroids,
+        initialCentroidGuess);
+}
+
+// Choose the empty cluster policy, then the assignment policy.
+template<typename InitialPartitionPolicy>
+void FindEmptyClusterPolicy(const InitialPartitionPolicy& partitioner,
+                            const arma::mat& dataset,
+                            const size_t clusters,
+                            arma::Col<size_t>& assignments,
+                            arma::mat& centroids,
+                            const bool initialCentroidGuess)
+{
+  if (CLI::HasParam("allow_empty_clusters"))
+    FindAssignmentPolicy<InitialPartitionPolicy, AllowEmptyClusters>(
+        partitioner, dataset, clusters, assignments, centroids,
+        initialCentroidGuess);
+  else
+    FindAssignmentPolicy<InitialPartitionPolicy, MaxVarianceNewCluster>(
+        partitioner, dataset, clusters, assignments, centroids,
+        initialCentroidGuess);
+}
+// Run mini-batch K-Means on the input file without loading it, then label the
+// points in a second pass over the file.
+void RunMiniBatchKMeans(const string& inputFile, const size_t clusters)
+{
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  if (batchSize < 1)
+    Log::Fatal << "Invalid batch size (" << batchSize << ")! Must be greater "
+        << "than or equal to 1." << endl;
+
+  if (CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place cannot be used with --mini_batch." << endl;
+
+  if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel") || CLI::HasParam("fast_kmeans") ||
+      CLI::HasParam("hamerly") || CLI::HasParam("dual_tree") ||
+      CLI::HasParam("allow_empty_clusters") ||
+      CLI::GetParam<double>("overclustering") != 1.0 ||
+      CLI::GetParam<int>("restarts") != 1)
+    Log::Warn << "--refined_start, --kmeans_plus_plus, --kmeans_parallel, "
+        << "--fast_kmeans, --hamerly, --dual_tree, --allow_empty_clusters, "
+        << "--overclustering and --restarts are ignored with --mini_batch."
+        << endl;
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+
+  MiniBatchKMeans<> k((size_t) batchSize,
+      (size_t) CLI::GetParam<int>("max_iterations"),
+      CLI::GetParam<double>("tolerance"));
+
+  Timer::Start("clustering");
+  FileBatchSource source(inputFile);
+  k.Cluster(source, clusters, centroids, initialCentroidGuess);
+  Timer::Stop("clustering");
+
+  // Now label the points, one batch at a time.
+  const string outputFile = CLI::GetParam<string>("output_file");
+  ofstream output(outputFile.c_str());
+  if (!output.is_open())
+    Log::Fatal << "Cannot open file '" << outputFile << "' for writing!"
+        << endl;
+
+  FileBatchSource labelSource(inputFile, false);
+  arma::mat batch;
+  arma::Col<size_t> assignments;
+  while (labelSource.NextBatch(batch, (size_t) batchSize) > 0)
+  {
+    k.Assign(batch, centroids, assignments);
+    for (size_t i = 0; i < assignments.n_elem; ++i)
+      output << assignments[i] << "\n";
+  }
+
+  if (CLI::HasParam("centroid_file"))
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
+
+// Run spherical k-means on the dense or sparse input file, and write the labels
+// of the points.
+template<typename MatType>
+void RunSphericalKMeans(const string& inputFile, const size_t clusters)
+{
+  if (CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place cannot be used with --spherical." << endl;
+
+  if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel") || CLI::HasParam("fast_kmeans") ||
+      CLI::HasParam("hamerly") || CLI::HasParam("dual_tree") ||
+      CLI::HasParam("allow_empty_clusters") ||
+      CLI::HasParam("curve_order") ||
+      CLI::GetParam<double>("overclustering") != 1.0 ||
+      CLI::GetParam<int>("restarts") != 1)
+    Log::Warn << "--refined_start, --kmeans_plus_plus, --kmeans_parallel, "
+        << "--fast_kmeans, --hamerly, --dual_tree, --allow_empty_clusters, "
+        << "--curve_order, --overclustering and --restarts are ignored with "
+        << "--spherical." << endl;
+
+  MatType dataset;
+  data::Load(inputFile, dataset, true); // Fatal upon failure.
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+
+  SphericalKMeans k((size_t) CLI::GetParam<int>("max_iterations"),
+      (size_t) CLI::GetParam<int>("threads"));
+
+  arma::Col<size_t> assignments;
+  Timer::Start("clustering");
+  k.Cluster(dataset, clusters, assignments, centroids, initialCentroidGuess);
+  Timer::Stop("clustering");
+
+  arma::Mat<size_t> output = trans(assignments);
+  data::Save(CLI::GetParam<string>("output_file"), output);
+
+  if (CLI::HasParam("centroid_file"))
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
 
 int main(int argc, char** argv)
 {
@@ -116,6 +375,35 @@ int main(int argc, char** argv)
         ")! Must be greater than or equal to 1." << endl;
   }
 
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads (" << threads << ")! Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
+  const int restarts = CLI::GetParam<int>("restarts");
+  if (restarts < 1)
+  {
+    Log::Fatal << "Invalid number of restarts (" << restarts << ")! Must be "
+        << "greater than or equal to 1." << endl;
+  }
+
+  if ((CLI::HasParam("refined_start") ? 1 : 0) +
+      (CLI::HasParam("kmeans_plus_plus") ? 1 : 0) +
+      (CLI::HasParam("kmeans_parallel") ? 1 : 0) > 1)
+    Log::Fatal << "Only one of --refined_start, --kmeans_plus_plus and "
+        << "--kmeans_parallel may be specified." << endl;
+
+  if (CLI::HasParam("hamerly") && CLI::HasParam("dual_tree"))
+    Log::Fatal << "Only one of --hamerly and --dual_tree may be specified."
+        << endl;
+
+  if (CLI::HasParam("fast_kmeans") && (CLI::HasParam("hamerly") ||
+      CLI::HasParam("dual_tree")))
+    Log::Warn << "--hamerly and --dual_tree ignored because --fast_kmeans is "
+        << "specified." << endl;
+
   // Make sure we have an output file if we're not doing the work in-place.
   if (!CLI::HasParam("in_place") && !CLI::HasParam("output_file"))
   {
@@ -123,12 +411,47 @@ int main(int argc, char** argv)
         << endl;
   }
 
+  if (CLI::HasParam("sparse") && !CLI::HasParam("spherical"))
+    Log::Fatal << "--sparse can only be used with --spherical." << endl;
+
+  if (CLI::HasParam("spherical"))
+  {
+    if (CLI::HasParam("mini_batch"))
+      Log::Fatal << "Only one of --spherical and --mini_batch may be "
+          << "specified." << endl;
+
+    if (CLI::HasParam("sparse"))
+      RunSphericalKMeans<arma::sp_mat>(inputFile, (size_t) clusters);
+    else
+      RunSphericalKMeans<arma::mat>(inputFile, (size_t) clusters);
+    return 0;
+  }
+
+  if (CLI::HasParam("mini_batch"))
+  {
+    RunMiniBatchKMeans(inputFile, (size_t) clusters);
+    return 0;
+  }
+
   // Load our dataset.
   arma::mat dataset;
   data::Load(inputFile, dataset, true); // Fatal upon failure.
 
-  // Now create the KMeans object.  Because we could be using different types,
-  // it gets a little weird...
+  // Sort the points along a space-filling curve, if requested; the mapping is
+  // kept so the results can be given in the original order.
+  const string curveOrder = CLI::GetParam<string>("curve_order");
+  std::vector<size_t> oldFromNew;
+  if (curveOrder != "")
+  {
+    if (curveOrder != "morton" && curveOrder != "hilbert")
+      Log::Fatal << "Invalid curve order '" << curveOrder << "'; must be "
+          << "'morton' or 'hilbert'." << endl;
+
+    data::SpaceFillingCurveOrder(dataset, oldFromNew, (curveOrder == "morton")
+        ? data::MortonCurve : data::HilbertCurve);
+    data::ReorderColumns(dataset, oldFromNew);
+  }
+
   arma::Col<size_t> assignments;
   arma::mat centroids;
 
@@ -139,90 +462,70 @@ int main(int argc, char** argv)
     string initialCentroidsFile = CLI::GetParam<string>("initial_centroids");
     data::Load(initialCentroidsFile, centroids, true);
 
-    if (CLI::HasParam("refined_start"))
+    if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+        CLI::HasParam("kmeans_parallel"))
       Log::Warn << "Initial centroids are specified, but will be ignored "
-          << "because --refined_start is also specified!" << endl;
+          << "because an initial point strategy is also specified!" << endl;
+    else if (restarts > 1)
+      Log::Warn << "--restarts is ignored because initial centroids are "
+          << "specified." << endl;
     else
       Log::Info << "Using initial centroid guesses from '" <<
           initialCentroidsFile << "'." << endl;
   }
 
-  if (CLI::HasParam("allow_empty_clusters"))
+  // Now run K-Means.  Because we could be using different types, it gets a
+  // little weird...
+  if (CLI::HasParam("refined_start"))
   {
-    if (CLI::HasParam("refined_start"))
-    {
-      const int samplings = CLI::GetParam<int>("samplings");
-      const double percentage = CLI::GetParam<int>("percentage");
-
-      if (samplings < 0)
-        Log::Fatal << "Number of samplings (" << samplings << ") must be "
-            << "greater than 0!" << endl;
-      if (percentage <= 0.0 || percentage > 1.0)
-        Log::Fatal << "Percentage for sampling (" << percentage << ") must be "
-            << "greater than 0.0 and less than or equal to 1.0!" << endl;
-
-      KMeans<metric::SquaredEuclideanDistance, RefinedStart, AllowEmptyClusters>
-          k(maxIterations, overclustering, metric::SquaredEuclideanDistance(),
-          RefinedStart(samplings, percentage));
-
-      Timer::Start("clustering");
-//      if (CLI::HasParam("fast_kmeans"))
-//        k.FastCluster(dataset, clusters, assignments);
-//      else
-      k.Cluster(dataset, clusters, assignments, centroids);
-      Timer::Stop("clustering");
-    }
-    else
-    {
-      KMeans<metric::SquaredEuclideanDistance, RandomPartition,
-          AllowEmptyClusters> k(maxIterations, overclustering);
-
-      Timer::Start("clustering");
-//      if (CLI::HasParam("fast_kmeans"))
-//        k.FastCluster(dataset, clusters, assignments);
-//      else
-      k.Cluster(dataset, clusters, assignments, centroids, false,
-          initialCentroidGuess);
-      Timer::Stop("clustering");
-    }
+    const int samplings = CLI::GetParam<int>("samplings");
+    const double percentage = CLI::GetParam<double>("percentage");
+
+    if (samplings < 0)
+      Log::Fatal << "Number of samplings (" << samplings << ") must be "
+          << "greater than 0!" << endl;
+    if (percentage <= 0.0 || percentage > 1.0)
+      Log::Fatal << "Percentage for sampling (" << percentage << ") must be "
+          << "greater than 0.0 and less than or equal to 1.0!" << endl;
+
+    FindEmptyClusterPolicy(RefinedStart(samplings, percentage), dataset,
+        (size_t) clusters, assignments, centroids, false);
+  }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const double oversampling = CLI::GetParam<double>("oversampling");
+    const int rounds = CLI::GetParam<int>("rounds");
+
+    if (oversampling <= 0.0)
+      Log::Fatal << "Oversampling factor (" << oversampling << ") must be "
+          << "greater than 0.0!" << endl;
+    if (rounds < 0)
+      Log::Fatal << "Number of rounds (" << rounds << ") must be greater "
+          << "than or equal to 0!" << endl;
+
+    FindEmptyClusterPolicy(KMeansParallelStart(oversampling, (size_t) rounds,
+        (size_t) threads), dataset, (size_t) clusters, assignments, centroids,
+        false);
+  }
+  else if (CLI::HasParam("kmeans_plus_plus"))
+  {
+    FindEmptyClusterPolicy(KMeansPlusPlus((size_t) threads), dataset,
+        (size_t) clusters, assignments, centroids, false);
   }
   else
   {
-    if (CLI::HasParam("refined_start"))
-    {
-      const int samplings = CLI::GetParam<int>("samplings");
-      const double percentage = CLI::GetParam<int>("percentage");
-
-      if (samplings < 0)
-        Log::Fatal << "Number of samplings (" << samplings << ") must be "
-            << "greater than 0!" << endl;
-      if (percentage <= 0.0 || percentage > 1.0)
-        Log::Fatal << "Percentage for sampling (" << percentage << ") must be "
-            << "greater than 0.0 and less than or equal to 1.0!" << endl;
-
-      KMeans<metric::SquaredEuclideanDistance, RefinedStart, AllowEmptyClusters>
-          k(maxIterations, overclustering, metric::SquaredEuclideanDistance(),
-          RefinedStart(samplings, percentage));
-
-      Timer::Start("clustering");
-//      if (CLI::HasParam("fast_kmeans"))
-//        k.FastCluster(dataset, clusters, assignments);
-//      else
-        k.Cluster(dataset, clusters, assignments, centroids);
-      Timer::Stop("clustering");
-    }
-    else
-    {
-      KMeans<> k(maxIterations, overclustering);
-
-      Timer::Start("clustering");
-//      if (CLI::HasParam("fast_kmeans"))
-//        k.FastCluster(dataset, clusters, assignments);
-//      else
-        k.Cluster(dataset, clusters, assignments, centroids, false,
-            initialCentroidGuess);
-      Timer::Stop("clustering");
-    }
+    FindEmptyClusterPolicy(RandomPartition(), dataset, (size_t) clusters,
+        assignments, centroids, initialCentroidGuess);
+  }
+
+  // Put the points and their assignments back in their original order.
+  if (!oldFromNew.empty())
+  {
+    data::RestoreColumns(dataset, oldFromNew);
+    arma::Col<size_t> unmapped(assignments.n_elem);
+    for (size_t i = 0; i < assignments.n_elem; ++i)
+      unmapped[oldFromNew[i]] = assignments[i];
+    assignments = unmapped;
   }
 
   // Now figure out what to do with our results.
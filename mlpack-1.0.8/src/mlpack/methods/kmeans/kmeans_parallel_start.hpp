@@ -0,0 +1,139 @@
+/**
+ * @file kmeans_parallel_start.hpp
+ *
+ * The k-means|| ("scalable k-means++") initial partitioning policy for K-Means.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_START_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_START_HPP
+
+#include <mlpack/core.hpp>
+#include "kmeans_plus_plus.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An initial partitioning policy which chooses the initial centroids with the
+ * k-means|| algorithm, and assigns each point to the closest of them.  Instead
+ * of one pass over the data for each centroid, as in k-means++, a few rounds
+ * are done in which every point becomes a candidate on its own with probability
+ * proportional to its squared distance to the closest candidate so far (about
+ * oversampling * clusters points are chosen in each round).  The candidates are
+ * weighted by the number of points closest to them and reclustered with
+ * weighted k-means++ (see KMeansPlusPlus) to obtain the centroids.  This is
+ * described in the following paper:
+ *
+ * @code
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, B. and Moseley, B. and Vattani, A. and Kumar, R. and
+ *       Vassilvitskii, S.},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ * @endcode
+ *
+ * The distances of each round are calculated in parallel if Threads() is not
+ * 1.  The squared Euclidean distance is always used.
+ */
+class KMeansParallelStart
+{
+ public:
+  /**
+   * Create the k-means|| partitioner.
+   *
+   * @param oversampling Expected number of candidates chosen in each round,
+   *     as a multiple of the number of clusters.
+   * @param rounds Number of rounds of sampling.
+   * @param threads Number of threads to use (1 is serial, 0 is all cores).
+   */
+  KMeansParallelStart(const double oversampling = 2.0,
+                      const size_t rounds = 5,
+                      const size_t threads = 1) :
+      oversampling(oversampling), rounds(rounds), threads(threads) { }
+
+  /**
+   * Partition the given dataset into the given number of clusters, around
+   * centroids chosen with k-means||.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  //! Get the oversampling factor.
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor.
+  double& Oversampling() { return oversampling; }
+
+  //! Get the number of rounds of sampling.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of rounds of sampling.
+  size_t& Rounds() { return rounds; }
+
+  //! Get the number of threads (1 is serial, 0 is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (1 is serial, 0 is all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! Expected number of candidates per round, as a multiple of the clusters.
+  double oversampling;
+  //! Number of rounds of sampling.
+  size_t rounds;
+  //! Number of threads to use.
+  size_t threads;
+
+  /**
+   * Update the distance of each point to its closest candidate, and the index
+   * of that candidate, with the candidates starting at the given index.
+   *
+   * @param data Dataset.
+   * @param candidates Indices of the candidate points.
+   * @param first Index of the first new candidate.
+   * @param minDistances Squared distance of each point to its closest
+   *     candidate.
+   * @param closest Index (in candidates) of the closest candidate of each
+   *     point.
+   * @param numThreads Number of threads to use.
+   */
+  template<typename MatType>
+  static void UpdateDistances(const MatType& data,
+                              const std::vector<size_t>& candidates,
+                              const size_t first,
+                              arma::vec& minDistances,
+                              arma::Col<size_t>& closest,
+                              const size_t numThreads);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_start_impl.hpp"
+
+#endif
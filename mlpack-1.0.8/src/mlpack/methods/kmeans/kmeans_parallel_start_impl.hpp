@@ -0,0 +1,148 @@
+/**
+ * @file kmeans_parallel_start_impl.hpp
+ *
+ * Implementation of the KMeansParallelStart initial partitioning policy.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_START_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_START_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel_start.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansParallelStart::Cluster(const MatType& data,
+                                  const size_t clusters,
+                                  arma::Col<size_t>& assignments) const
+{
+  const size_t numThreads = KMeansPlusPlus::NumThreads(threads);
+  const double expected = oversampling * clusters;
+
+  arma::vec minDistances(data.n_cols);
+  minDistances.fill(std::numeric_limits<double>::infinity());
+  arma::Col<size_t> closest(data.n_cols);
+
+  // The first candidate is chosen uniformly at random.
+  std::vector<size_t> candidates;
+  candidates.push_back((size_t) math::RandInt(data.n_cols));
+  UpdateDistances(data, candidates, 0, minDistances, closest, numThreads);
+
+  for (size_t round = 0; round < rounds; ++round)
+  {
+    const double cost = arma::accu(minDistances);
+    if (cost == 0.0)
+      break; // Every point is a candidate already.
+
+    // Every point is sampled independently.
+    arma::vec random(data.n_cols);
+    math::Random(random);
+    const size_t first = candidates.size();
+    for (size_t i = 0; i < data.n_cols; ++i)
+      if (random[i] * cost < expected * minDistances[i])
+        candidates.push_back(i);
+
+    UpdateDistances(data, candidates, first, minDistances, closest,
+        numThreads);
+  }
+
+  // With very few rounds (or very few distinct points) there may not be enough
+  // candidates; take more with k-means++ sampling then.
+  while (candidates.size() < clusters)
+  {
+    candidates.push_back(KMeansPlusPlus::SampleIndex(minDistances));
+    UpdateDistances(data, candidates, candidates.size() - 1, minDistances,
+        closest, numThreads);
+  }
+
+  Log::Info << "k-means|| chose " << candidates.size() << " candidates for "
+      << clusters << " clusters." << std::endl;
+
+  // Weight each candidate by the number of points closest to it, and recluster
+  // the candidates.
+  arma::vec weights(candidates.size());
+  weights.zeros();
+  for (size_t i = 0; i < data.n_cols; ++i)
+    weights[closest[i]] += 1.0;
+
+  MatType candidatePoints(data.n_rows, candidates.size());
+  for (size_t c = 0; c < candidates.size(); ++c)
+    candidatePoints.col(c) = data.col(candidates[c]);
+
+  MatType centroids;
+  arma::Col<size_t> candidateAssignments;
+  KMeansPlusPlus(threads).Seed(candidatePoints, weights, clusters, centroids,
+      candidateAssignments);
+
+  // Now assign each point to its closest centroid.
+  assignments.set_size(data.n_cols);
+
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (int i = 0; i < (int) data.n_cols; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCentroid = 0;
+    for (size_t c = 0; c < clusters; ++c)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centroids.col(c));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCentroid = c;
+      }
+    }
+
+    assignments[i] = closestCentroid;
+  }
+}
+
+template<typename MatType>
+void KMeansParallelStart::UpdateDistances(const MatType& data,
+                                          const std::vector<size_t>& candidates,
+                                          const size_t first,
+                                          arma::vec& minDistances,
+                                          arma::Col<size_t>& closest,
+                                          const size_t numThreads)
+{
+  if (first == candidates.size())
+    return;
+
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (int i = 0; i < (int) data.n_cols; ++i)
+  {
+    for (size_t c = first; c < candidates.size(); ++c)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), data.col(candidates[c]));
+      if (distance < minDistances[i])
+      {
+        minDistances[i] = distance;
+        closest[i] = c;
+      }
+    }
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
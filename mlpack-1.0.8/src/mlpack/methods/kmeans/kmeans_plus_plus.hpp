@@ -0,0 +1,125 @@
+/**
+ * @file kmeans_plus_plus.hpp
+ *
+ * The k-means++ initial partitioning policy for K-Means, which chooses initial
+ * centroids that are spread out over the data.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An initial partitioning policy which chooses the initial centroids with the
+ * k-means++ algorithm, and assigns each point to the closest of them.  The
+ * first centroid is a random point; each following centroid is a random point
+ * chosen with probability proportional to its squared distance to the closest
+ * centroid chosen so far.  This is described in the following paper:
+ *
+ * @code
+ * @inproceedings{arthur2007k,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, D. and Vassilvitskii, S.},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA '07)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ * @endcode
+ *
+ * This takes one pass over the data for each centroid; the distances of each
+ * pass are calculated in parallel if Threads() is not 1.  For a large number
+ * of clusters, KMeansParallelStart needs far fewer passes.  The squared
+ * Euclidean distance is always used.
+ */
+class KMeansPlusPlus
+{
+ public:
+  /**
+   * Create the k-means++ partitioner.
+   *
+   * @param threads Number of threads to use (1 is serial, 0 is all cores).
+   */
+  KMeansPlusPlus(const size_t threads = 1) : threads(threads) { }
+
+  /**
+   * Partition the given dataset into the given number of clusters, around
+   * centroids chosen with k-means++.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  /**
+   * Choose centroids from the given weighted points with k-means++; the
+   * probability of choosing a point is also proportional to its weight.  Each
+   * point is assigned to its closest centroid.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Points to choose the centroids from.
+   * @param weights Weight of each point.
+   * @param clusters Number of centroids to choose.
+   * @param centroids Matrix to store the centroids in (one per column).
+   * @param assignments Vector to store the assignment of each point in.
+   */
+  template<typename MatType>
+  void Seed(const MatType& data,
+            const arma::vec& weights,
+            const size_t clusters,
+            MatType& centroids,
+            arma::Col<size_t>& assignments) const;
+
+  //! Get the number of threads (1 is serial, 0 is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (1 is serial, 0 is all cores).
+  size_t& Threads() { return threads; }
+
+  /**
+   * Choose a random index with probability proportional to the given weights.
+   * If the weights are all zero, the index is chosen uniformly at random.
+   */
+  static size_t SampleIndex(const arma::vec& weights);
+
+  /**
+   * Return the number of threads that should be used for the given setting
+   * (this resolves a setting of 0 to the number of available cores).
+   */
+  static size_t NumThreads(const size_t threads);
+
+ private:
+  //! Number of threads to use.
+  size_t threads;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "kmeans_plus_plus_impl.hpp"
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file kmeans_plus_plus_impl.hpp
+ *
+ * Implementation of the KMeansPlusPlus initial partitioning policy.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_plus_plus.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansPlusPlus::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments) const
+{
+  MatType centroids;
+  Seed(data, arma::ones<arma::vec>(data.n_cols), clusters, centroids,
+      assignments);
+}
+
+template<typename MatType>
+void KMeansPlusPlus::Seed(const MatType& data,
+                          const arma::vec& weights,
+                          const size_t clusters,
+                          MatType& centroids,
+                          arma::Col<size_t>& assignments) const
+{
+  const size_t numThreads = NumThreads(threads);
+
+  centroids.set_size(data.n_rows, clusters);
+  assignments.zeros(data.n_cols);
+
+  // The squared distance from each point to its closest centroid so far.
+  arma::vec minDistances(data.n_cols);
+  minDistances.fill(std::numeric_limits<double>::infinity());
+
+  size_t next = SampleIndex(weights);
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    centroids.col(c) = data.col(next);
+
+    // Only the distances to the new centroid need to be calculated.
+    #pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < (int) data.n_cols; ++i)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centroids.col(c));
+
+      if (distance < minDistances[i])
+      {
+        minDistances[i] = distance;
+        assignments[i] = c;
+      }
+    }
+
+    if (c + 1 < clusters)
+      next = SampleIndex(weights % minDistances);
+  }
+}
+
+inline size_t KMeansPlusPlus::SampleIndex(const arma::vec& weights)
+{
+  const double total = arma::accu(weights);
+  if (!(total > 0.0))
+    return (size_t) math::RandInt(weights.n_elem);
+
+  const double target = math::Random() * total;
+  double sum = 0.0;
+  for (size_t i = 0; i < weights.n_elem; ++i)
+  {
+    sum += weights[i];
+    if (sum > target)
+      return i;
+  }
+
+  // Only reached because of rounding; return the last point with weight.
+  size_t last = weights.n_elem - 1;
+  while (last > 0 && weights[last] == 0.0)
+    --last;
+  return last;
+}
+
+inline size_t KMeansPlusPlus::NumThreads(const size_t threads)
+{
+  return Threads::Count(threads);
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
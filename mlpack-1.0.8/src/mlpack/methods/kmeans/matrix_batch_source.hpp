@@ -0,0 +1,74 @@
+/**
+ * @file matrix_batch_source.hpp
+ *
+ * A batch source for MiniBatchKMeans which samples points from a matrix held in
+ * memory.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MATRIX_BATCH_SOURCE_HPP
+#define __MLPACK_METHODS_KMEANS_MATRIX_BATCH_SOURCE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * A source of batches of points for MiniBatchKMeans, which samples the points
+ * of each batch uniformly at random (with replacement) from a matrix held in
+ * memory.  Any batch source must implement NextBatch() and Dimensionality()
+ * like this class does; see also FileBatchSource, which reads the points from a
+ * file instead.
+ */
+class MatrixBatchSource
+{
+ public:
+  /**
+   * Create the source for the given dataset, which must outlive the source.
+   *
+   * @param data Dataset to sample points from (one point per column).
+   */
+  MatrixBatchSource(const arma::mat& data) : data(data) { }
+
+  /**
+   * Fill the given matrix with a batch of randomly sampled points.
+   *
+   * @param batch Matrix to store the points in (one per column).
+   * @param batchSize Number of points to sample.
+   * @return The number of points in the batch (always batchSize).
+   */
+  size_t NextBatch(arma::mat& batch, const size_t batchSize)
+  {
+    batch.set_size(data.n_rows, batchSize);
+    for (size_t i = 0; i < batchSize; ++i)
+      batch.col(i) = data.col((size_t) math::RandInt(data.n_cols));
+
+    return batchSize;
+  }
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return data.n_rows; }
+
+ private:
+  //! The dataset to sample from.
+  const arma::mat& data;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
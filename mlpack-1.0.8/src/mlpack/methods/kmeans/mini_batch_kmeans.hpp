@@ -0,0 +1,179 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ *
+ * Mini-batch K-Means, which updates the centroids from small random batches of
+ * points, so that the whole dataset does not have to be held in memory.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#include "matrix_batch_source.hpp"
+#include "file_batch_source.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of mini-batch K-Means, as described in the following paper:
+ *
+ * @code
+ * @inproceedings{sculley2010web,
+ *   title={Web-scale k-means clustering},
+ *   author={Sculley, D.},
+ *   booktitle={Proceedings of the 19th International Conference on World Wide
+ *       Web (WWW '10)},
+ *   pages={1177--1178},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * Instead of going over the whole dataset in each iteration like KMeans does,
+ * each iteration takes a batch of points from a source, assigns each of them
+ * to its closest centroid, and then moves each centroid towards the points
+ * that were assigned to it.  Each centroid has its own learning rate, which is
+ * one over the number of points that have been assigned to it so far, so that
+ * every centroid is the mean of all the points it was given.  Clustering stops
+ * when no centroid moves further than the tolerance in one iteration, or when
+ * the maximum number of iterations is reached.
+ *
+ * The points come from a batch source, which only has to provide the next
+ * batch; MatrixBatchSource samples from a matrix in memory, and
+ * FileBatchSource reads the points from a file that may be too large for
+ * memory.
+ *
+ * @code
+ * // Cluster the points in a file that does not fit in memory.
+ * FileBatchSource source("points.csv");
+ * MiniBatchKMeans<> k(1000); // Batches of 1000 points.
+ * arma::mat centroids;
+ * k.Cluster(source, 100, centroids);
+ * @endcode
+ *
+ * The result is an approximation of the result of KMeans, and empty clusters
+ * are not handled specially.
+ *
+ * @tparam MetricType The distance metric to use; see metric::LMetric for an
+ *     example.
+ */
+template<typename MetricType = metric::SquaredEuclideanDistance>
+class MiniBatchKMeans
+{
+ public:
+  /**
+   * Create the mini-batch K-Means object and set the parameters it will be run
+   * with.
+   *
+   * @param batchSize Number of points in each batch.
+   * @param maxIterations Maximum number of batches (0 means no limit).
+   * @param tolerance Clustering stops when no centroid moves further than
+   *     this (as measured by the metric) in one iteration.
+   * @param metric Optional MetricType object; for when the metric has state
+   *     it needs to store.
+   */
+  MiniBatchKMeans(const size_t batchSize = 1000,
+                  const size_t maxIterations = 1000,
+                  const double tolerance = 1e-5,
+                  const MetricType metric = MetricType());
+
+  /**
+   * Find the centroids of the points given by the batch source.  If
+   * initialCentroidGuess is true, the centroids matrix must hold the initial
+   * centroids; otherwise, they are chosen at random from the first batch.
+   *
+   * @tparam SourceType Type of batch source (see MatrixBatchSource).
+   * @param source Source of batches of points.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialCentroidGuess If true, then it is assumed that centroids
+   *      contains the initial centroids of each cluster.
+   */
+  template<typename SourceType>
+  void Cluster(SourceType& source,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialCentroidGuess = false) const;
+
+  /**
+   * Cluster the given dataset (held in memory) with batches sampled from it,
+   * and when done, assign each point to its closest centroid.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialCentroidGuess If true, then it is assumed that centroids
+   *      contains the initial centroids of each cluster.
+   */
+  void Cluster(const arma::mat& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               arma::mat& centroids,
+               const bool initialCentroidGuess = false) const;
+
+  /**
+   * Assign each of the given points to its closest centroid.
+   *
+   * @param points Points to assign (one per column).
+   * @param centroids Centroids of each cluster (one per column).
+   * @param assignments Vector to store cluster assignments in.
+   */
+  void Assign(const arma::mat& points,
+              const arma::mat& centroids,
+              arma::Col<size_t>& assignments) const;
+
+  //! Get the number of points in each batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points in each batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance on centroid movement.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance on centroid movement.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  //! Number of points in each batch.
+  size_t batchSize;
+  //! Maximum number of iterations before giving up.
+  size_t maxIterations;
+  //! Tolerance on centroid movement.
+  double tolerance;
+  //! Instantiated distance metric.
+  MetricType metric;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
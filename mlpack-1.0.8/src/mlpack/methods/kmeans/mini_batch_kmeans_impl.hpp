@@ -0,0 +1,179 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of the MiniBatchKMeans class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType>
+MiniBatchKMeans<MetricType>::MiniBatchKMeans(const size_t batchSize,
+                                             const size_t maxIterations,
+                                             const double tolerance,
+                                             const MetricType metric) :
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    metric(metric)
+{ /* Nothing to do. */ }
+
+template<typename MetricType>
+template<typename SourceType>
+void MiniBatchKMeans<MetricType>::Cluster(SourceType& source,
+                                          const size_t clusters,
+                                          arma::mat& centroids,
+                                          const bool initialCentroidGuess) const
+{
+  if (batchSize == 0)
+    Log::Fatal << "MiniBatchKMeans::Cluster(): batch size must be greater "
+        << "than 0!" << std::endl;
+
+  arma::mat batch;
+  if (initialCentroidGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "MiniBatchKMeans::Cluster(): wrong number of initial "
+          << "cluster centroids (" << centroids.n_cols << ", should be "
+          << clusters << ")!" << std::endl;
+
+    if (centroids.n_rows != source.Dimensionality())
+      Log::Fatal << "MiniBatchKMeans::Cluster(): initial cluster centroids "
+          << "have wrong dimensionality (" << centroids.n_rows << ", should "
+          << "be " << source.Dimensionality() << ")!" << std::endl;
+  }
+  else
+  {
+    // Take the initial centroids from a random permutation of the first batch
+    // (which has to be big enough).
+    const size_t points = source.NextBatch(batch, std::max(batchSize,
+        clusters));
+    if (points < clusters)
+      Log::Fatal << "MiniBatchKMeans::Cluster(): only " << points << " points "
+          << "available to choose " << clusters << " initial centroids from!"
+          << std::endl;
+
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        points - 1, points));
+    centroids.set_size(batch.n_rows, clusters);
+    for (size_t i = 0; i < clusters; ++i)
+      centroids.col(i) = batch.col(order[i]);
+  }
+
+  // The number of points assigned to each centroid so far; this controls the
+  // learning rate of each centroid.
+  arma::Col<size_t> counts;
+  counts.zeros(clusters);
+
+  arma::Col<size_t> assignments;
+  arma::mat oldCentroids;
+  size_t iteration = 0;
+  double maxMovement = std::numeric_limits<double>::infinity();
+  while (maxMovement > tolerance && iteration != maxIterations)
+  {
+    const size_t points = source.NextBatch(batch, batchSize);
+    if (points == 0)
+    {
+      Log::Warn << "MiniBatchKMeans::Cluster(): batch source is exhausted."
+          << std::endl;
+      break;
+    }
+
+    // Assign every point of the batch with the centroids fixed, then move each
+    // centroid towards its points.
+    Assign(batch, centroids, assignments);
+
+    oldCentroids = centroids;
+    for (size_t i = 0; i < points; ++i)
+    {
+      const size_t cluster = assignments[i];
+      ++counts[cluster];
+
+      const double rate = 1.0 / counts[cluster];
+      centroids.col(cluster) = (1.0 - rate) * centroids.col(cluster) +
+          rate * batch.col(i);
+    }
+
+    maxMovement = 0.0;
+    for (size_t i = 0; i < clusters; ++i)
+      maxMovement = std::max(maxMovement, metric.Evaluate(oldCentroids.col(i),
+          centroids.col(i)));
+
+    ++iteration;
+  }
+
+  if (iteration != maxIterations)
+  {
+    Log::Debug << "MiniBatchKMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    Log::Debug << "MiniBatchKMeans::Cluster(): terminated after limit of "
+        << iteration << " iterations." << std::endl;
+  }
+}
+
+template<typename MetricType>
+void MiniBatchKMeans<MetricType>::Cluster(const arma::mat& data,
+                                          const size_t clusters,
+                                          arma::Col<size_t>& assignments,
+                                          arma::mat& centroids,
+                                          const bool initialCentroidGuess) const
+{
+  MatrixBatchSource source(data);
+  Cluster(source, clusters, centroids, initialCentroidGuess);
+  Assign(data, centroids, assignments);
+}
+
+template<typename MetricType>
+void MiniBatchKMeans<MetricType>::Assign(const arma::mat& points,
+                                         const arma::mat& centroids,
+                                         arma::Col<size_t>& assignments) const
+{
+  assignments.set_size(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    // Find the closest centroid to this point.
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(points.col(i), centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
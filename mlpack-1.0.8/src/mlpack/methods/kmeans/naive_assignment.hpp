@@ -0,0 +1,110 @@
+/**
+ * @file naive_assignment.hpp
+ *
+ * The simplest assignment step for K-Means, which compares every point with
+ * every centroid.  Used as the default AssignmentPolicy for KMeans.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_NAIVE_ASSIGNMENT_HPP
+#define __MLPACK_METHODS_KMEANS_NAIVE_ASSIGNMENT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The assignment step of Lloyd's algorithm, done the obvious way: to find the
+ * closest centroid to a point, the distance to every centroid is calculated.
+ * This keeps no state between iterations, and works with any metric.
+ *
+ * An AssignmentPolicy must implement the three methods below.  Initialize() is
+ * called once before clustering starts, and Update() once per iteration,
+ * before any point is assigned.  Assign() is then called once for each point,
+ * possibly from several threads at the same time (but never for the same point
+ * twice in one iteration).
+ */
+class NaiveAssignment
+{
+ public:
+  //! Empty constructor, required by the AssignmentPolicy policy.
+  NaiveAssignment() { }
+
+  /**
+   * Prepare to cluster the given dataset.  This does nothing.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to be clustered.
+   * @param clusters Number of clusters.
+   */
+  template<typename MatType>
+  void Initialize(const MatType& /* data */, const size_t /* clusters */) { }
+
+  /**
+   * Take note of the centroids of the new iteration.  This does nothing.
+   *
+   * @tparam MetricType Type of distance metric.
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param metric Distance metric.
+   * @param centroids Centroids of each cluster (one per column).
+   */
+  template<typename MetricType, typename MatType>
+  void Update(const MetricType& /* metric */, const MatType& /* centroids */)
+  { }
+
+  /**
+   * Find the closest centroid to the given point.
+   *
+   * @tparam MetricType Type of distance metric.
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param metric Distance metric.
+   * @param data Dataset being clustered.
+   * @param centroids Centroids of each cluster (one per column).
+   * @param point Index of the point to assign.
+   * @param assignment Current assignment of the point (unused).
+   * @return Index of the closest centroid.
+   */
+  template<typename MetricType, typename MatType>
+  size_t Assign(const MetricType& metric,
+                const MatType& data,
+                const MatType& centroids,
+                const size_t point,
+                const size_t /* assignment */)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; j++)
+    {
+      const double distance = metric.Evaluate(data.col(point),
+          centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    return closestCluster;
+  }
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
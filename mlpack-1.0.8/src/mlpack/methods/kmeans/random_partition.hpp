@@ -55,9 +55,13 @@ class RandomPartition
                              const size_t clusters,
                              arma::Col<size_t>& assignments)
   {
-    // Implementation is so simple we'll put it here in the header file.
-    assignments = arma::shuffle(arma::linspace<arma::Col<size_t> >(0,
-        (clusters - 1), data.n_cols));
+    // Implementation is so simple we'll put it here in the header file.  The
+    // shuffle draws from math::RandInt(), so that in a parallel region (such
+    // as the restarts of KMeans) each thread draws from its own stream.
+    assignments = arma::linspace<arma::Col<size_t> >(0, (clusters - 1),
+        data.n_cols);
+    for (size_t i = assignments.n_elem; i > 1; --i)
+      std::swap(assignments[i - 1], assignments[math::RandInt((int) i)]);
   }
 };
 
@@ -0,0 +1,219 @@
+/**
+ * @file spherical_kmeans.hpp
+ *
+ * Spherical k-means, which clusters points by cosine similarity, for dense and
+ * sparse data.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_SPHERICAL_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_SPHERICAL_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of spherical k-means, as described in the following
+ * paper:
+ *
+ * @code
+ * @article{dhillon2001concept,
+ *   title={Concept decompositions for large sparse text data using
+ *       clustering},
+ *   author={Dhillon, I.S. and Modha, D.S.},
+ *   journal={Machine Learning},
+ *   volume={42},
+ *   number={1},
+ *   pages={143--175},
+ *   year={2001}
+ * }
+ * @endcode
+ *
+ * Each centroid is a unit vector, and each point is assigned to the centroid
+ * with which it has the largest cosine similarity; each centroid is then set to
+ * the normalized sum of the normalized points assigned to it.  This suits
+ * high-dimensional data whose direction matters more than its length, such as
+ * TF-IDF vectors of documents.
+ *
+ * The data may be dense (arma::mat) or sparse (arma::sp_mat); the centroids
+ * are always dense.  The data is never copied or normalized: the norms of the
+ * points are computed once, and the similarities of a block of points to every
+ * centroid are one product of the (transposed) centroids with the block, which
+ * for sparse data visits each nonzero element once.  The update step also
+ * visits only the nonzero elements.  The blocks of points are assigned on up
+ * to Threads() threads; the update step is serial, and the results do not
+ * depend on the number of threads.
+ *
+ * @code
+ * arma::sp_mat documents; // One TF-IDF vector per column.
+ * arma::Col<size_t> assignments;
+ * arma::mat centroids;
+ * SphericalKMeans k(100, 0); // 100 iterations at most, on all cores.
+ * k.Cluster(documents, 50, assignments, centroids);
+ * @endcode
+ *
+ * Points which are zero have no direction; they are assigned to cluster 0 and
+ * do not move any centroid.  A cluster which becomes empty keeps its centroid.
+ */
+class SphericalKMeans
+{
+ public:
+  /**
+   * Create the spherical k-means object and set the parameters it will be run
+   * with.
+   *
+   * @param maxIterations Maximum number of iterations (0 means no limit).
+   * @param threads Number of threads for the assignment step (1 is serial, 0
+   *     is all cores).
+   */
+  SphericalKMeans(const size_t maxIterations = 1000,
+                  const size_t threads = 1) :
+      maxIterations(maxIterations),
+      threads(threads)
+  { /* Nothing to do. */ }
+
+  /**
+   * Cluster the given points, returning the cluster of each point.
+   *
+   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  /**
+   * Cluster the given points, returning the cluster of each point and the
+   * (unit length) centroid of each cluster.  If initialCentroidGuess is true,
+   * the centroids matrix must hold the initial centroids (which are
+   * normalized); otherwise, they are distinct points chosen at random.
+   *
+   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored (one per column).
+   * @param initialCentroidGuess If true, then it is assumed that centroids
+   *      contains the initial centroids of each cluster.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               arma::mat& centroids,
+               const bool initialCentroidGuess = false) const;
+
+  /**
+   * Assign each of the given points to the centroid with which it has the
+   * largest cosine similarity.
+   *
+   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @param points Points to assign (one per column).
+   * @param centroids Centroids of each cluster (one per column).
+   * @param assignments Vector to store cluster assignments in.
+   */
+  template<typename MatType>
+  void Assign(const MatType& points,
+              const arma::mat& centroids,
+              arma::Col<size_t>& assignments) const;
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of threads for the assignment step (1 is serial, 0 is all
+  //! cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads for the assignment step (1 is serial, 0 is
+  //! all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  /**
+   * Assign each point to the most similar of the given normalized centroids,
+   * stored one per row, and return the number of assignments that changed.
+   *
+   * @param data Dataset being clustered.
+   * @param centroidsT Normalized centroids (one per row).
+   * @param assignments Cluster assignments of each point.
+   */
+  template<typename MatType>
+  size_t AssignPoints(const MatType& data,
+                      const arma::mat& centroidsT,
+                      arma::Col<size_t>& assignments) const;
+
+  //! Compute the norm of each point of a dense matrix.
+  static void Norms(const arma::mat& data, arma::vec& norms);
+  //! Compute the norm of each point of a sparse matrix from its nonzero
+  //! elements.
+  template<typename eT>
+  static void Norms(const arma::SpMat<eT>& data, arma::vec& norms);
+
+  //! Compute the similarities (dot products) of columns begin to end - 1 of a
+  //! dense matrix with each of the centroids (one per row).
+  static void Similarities(const arma::mat& centroidsT,
+                           const arma::mat& data,
+                           const size_t begin,
+                           const size_t end,
+                           arma::mat& similarities);
+  //! Compute the similarities of columns begin to end - 1 of a sparse matrix
+  //! with each of the centroids, from the nonzero elements of the points.
+  template<typename eT>
+  static void Similarities(const arma::mat& centroidsT,
+                           const arma::SpMat<eT>& data,
+                           const size_t begin,
+                           const size_t end,
+                           arma::mat& similarities);
+
+  //! Add the given multiple of point i of a dense matrix to row j of the
+  //! transposed sums.
+  static void AddPoint(arma::mat& sumsT,
+                       const size_t j,
+                       const arma::mat& data,
+                       const size_t i,
+                       const double scale);
+  //! Add the given multiple of point i of a sparse matrix to row j of the
+  //! transposed sums, visiting only its nonzero elements.
+  template<typename eT>
+  static void AddPoint(arma::mat& sumsT,
+                       const size_t j,
+                       const arma::SpMat<eT>& data,
+                       const size_t i,
+                       const double scale);
+
+  //! Normalize each row of the given transposed sums that is not zero, and
+  //! store it in the transposed centroids.
+  static void NormalizeRows(const arma::mat& sumsT, arma::mat& centroidsT);
+
+  //! Maximum number of iterations before giving up.
+  size_t maxIterations;
+  //! Number of threads for the assignment step.
+  size_t threads;
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "spherical_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,286 @@
+/**
+ * @file spherical_kmeans_impl.hpp
+ *
+ * Implementation of spherical k-means.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_SPHERICAL_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_SPHERICAL_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "spherical_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void SphericalKMeans::Cluster(const MatType& data,
+                              const size_t clusters,
+                              arma::Col<size_t>& assignments) const
+{
+  arma::mat centroids;
+  Cluster(data, clusters, assignments, centroids, false);
+}
+
+template<typename MatType>
+void SphericalKMeans::Cluster(const MatType& data,
+                              const size_t clusters,
+                              arma::Col<size_t>& assignments,
+                              arma::mat& centroids,
+                              const bool initialCentroidGuess) const
+{
+  if (clusters == 0)
+    Log::Fatal << "SphericalKMeans::Cluster(): the number of clusters must be "
+        << "greater than 0!" << std::endl;
+
+  arma::vec norms;
+  Norms(data, norms);
+
+  // The centroids are kept one per row, so that the similarities of a block
+  // of points are the product of the centroids with the block, and the
+  // centroid elements of one dimension (which a nonzero element of a sparse
+  // point is multiplied with) are contiguous.
+  arma::mat sumsT;
+  arma::mat centroidsT;
+  if (initialCentroidGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "SphericalKMeans::Cluster(): wrong number of initial "
+          << "cluster centroids (" << centroids.n_cols << ", should be "
+          << clusters << ")!" << std::endl;
+
+    if (centroids.n_rows != data.n_rows)
+      Log::Fatal << "SphericalKMeans::Cluster(): initial cluster centroids "
+          << "have wrong dimensionality (" << centroids.n_rows << ", should "
+          << "be " << data.n_rows << ")!" << std::endl;
+
+    centroidsT.zeros(clusters, data.n_rows);
+    NormalizeRows(arma::trans(centroids), centroidsT);
+  }
+  else
+  {
+    // Take the initial centroids from a random permutation of the points.
+    if (data.n_cols < clusters)
+      Log::Fatal << "SphericalKMeans::Cluster(): only " << data.n_cols
+          << " points available to choose " << clusters << " initial "
+          << "centroids from!" << std::endl;
+
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        data.n_cols - 1, data.n_cols));
+    sumsT.zeros(clusters, data.n_rows);
+    for (size_t i = 0; i < clusters; ++i)
+      if (norms[order[i]] > 0)
+        AddPoint(sumsT, i, data, order[i], 1.0);
+
+    centroidsT.zeros(clusters, data.n_rows);
+    NormalizeRows(sumsT, centroidsT);
+  }
+
+  // No point is assigned yet.
+  assignments.set_size(data.n_cols);
+  assignments.fill(clusters);
+
+  size_t iteration = 0;
+  size_t changedAssignments = 0;
+  do
+  {
+    // Assignment step.
+    changedAssignments = AssignPoints(data, centroidsT, assignments);
+    ++iteration;
+
+    // If no assignment changed, the centroids are already those of the
+    // assignments.
+    if (changedAssignments == 0)
+      break;
+
+    // Update step: each centroid is the normalized sum of its normalized
+    // points.
+    sumsT.zeros(clusters, data.n_rows);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      if (norms[i] > 0)
+        AddPoint(sumsT, assignments[i], data, i, 1.0 / norms[i]);
+
+    NormalizeRows(sumsT, centroidsT);
+  } while (iteration != maxIterations);
+
+  if (changedAssignments == 0)
+  {
+    MLPACK_LOG_DEBUG << "SphericalKMeans::Cluster(): converged after "
+        << iteration << " iterations." << std::endl;
+  }
+  else
+  {
+    MLPACK_LOG_DEBUG << "SphericalKMeans::Cluster(): terminated after "
+        << iteration << " iterations." << std::endl;
+  }
+
+  centroids = arma::trans(centroidsT);
+}
+
+template<typename MatType>
+void SphericalKMeans::Assign(const MatType& points,
+                             const arma::mat& centroids,
+                             arma::Col<size_t>& assignments) const
+{
+  arma::mat centroidsT(centroids.n_cols, centroids.n_rows);
+  centroidsT.zeros();
+  NormalizeRows(arma::trans(centroids), centroidsT);
+
+  assignments.set_size(points.n_cols);
+  assignments.fill(centroids.n_cols);
+  AssignPoints(points, centroidsT, assignments);
+}
+
+template<typename MatType>
+size_t SphericalKMeans::AssignPoints(const MatType& data,
+                                     const arma::mat& centroidsT,
+                                     arma::Col<size_t>& assignments) const
+{
+  const size_t points = data.n_cols;
+  if (points == 0)
+    return 0;
+
+  // The points are split into blocks small enough that their similarities to
+  // every centroid are cheap to hold, and there are at least as many blocks as
+  // threads.
+  const size_t workers = std::max(std::min(Threads::Count(threads), points),
+      (size_t) 1);
+  const size_t blockPoints = 1024;
+  const size_t blocks = std::max(workers,
+      (points + blockPoints - 1) / blockPoints);
+  arma::Col<size_t> blockChanged(blocks);
+
+  #pragma omp parallel for num_threads(workers) schedule(dynamic, 1)
+  for (int b = 0; b < (int) blocks; ++b)
+  {
+    const size_t begin = (size_t) b * points / blocks;
+    const size_t end = ((size_t) b + 1) * points / blocks;
+    blockChanged[b] = 0;
+    if (end == begin)
+      continue;
+
+    arma::mat similarities;
+    Similarities(centroidsT, data, begin, end, similarities);
+
+    // Find the most similar centroid of each point; ties go to the first one.
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+      size_t best = 0;
+      for (size_t j = 1; j < similarities.n_rows; ++j)
+        if (similarities(j, i) > similarities(best, i))
+          best = j;
+
+      if (assignments[begin + i] != best)
+      {
+        assignments[begin + i] = best;
+        ++blockChanged[b];
+      }
+    }
+  }
+
+  return arma::accu(blockChanged);
+}
+
+inline void SphericalKMeans::Norms(const arma::mat& data, arma::vec& norms)
+{
+  norms = arma::trans(arma::sqrt(arma::sum(arma::square(data))));
+}
+
+template<typename eT>
+void SphericalKMeans::Norms(const arma::SpMat<eT>& data, arma::vec& norms)
+{
+  norms.zeros(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t k = data.col_ptrs[i]; k < data.col_ptrs[i + 1]; ++k)
+      norms[i] += (double) data.values[k] * (double) data.values[k];
+    norms[i] = std::sqrt(norms[i]);
+  }
+}
+
+inline void SphericalKMeans::Similarities(const arma::mat& centroidsT,
+                                          const arma::mat& data,
+                                          const size_t begin,
+                                          const size_t end,
+                                          arma::mat& similarities)
+{
+  // Alias the block of points so that we don't copy it.
+  const arma::mat block(const_cast<double*>(data.colptr(begin)), data.n_rows,
+      end - begin, false, true);
+  similarities = centroidsT * block;
+}
+
+template<typename eT>
+void SphericalKMeans::Similarities(const arma::mat& centroidsT,
+                                   const arma::SpMat<eT>& data,
+                                   const size_t begin,
+                                   const size_t end,
+                                   arma::mat& similarities)
+{
+  // Each nonzero element of a point adds its multiple of the column of the
+  // centroids for its dimension.
+  similarities.zeros(centroidsT.n_rows, end - begin);
+  for (size_t i = begin; i < end; ++i)
+  {
+    double* similarity = similarities.colptr(i - begin);
+    for (size_t k = data.col_ptrs[i]; k < data.col_ptrs[i + 1]; ++k)
+    {
+      const double* centroid = centroidsT.colptr(data.row_indices[k]);
+      const double value = (double) data.values[k];
+      for (size_t j = 0; j < centroidsT.n_rows; ++j)
+        similarity[j] += value * centroid[j];
+    }
+  }
+}
+
+inline void SphericalKMeans::AddPoint(arma::mat& sumsT,
+                                      const size_t j,
+                                      const arma::mat& data,
+                                      const size_t i,
+                                      const double scale)
+{
+  const double* point = data.colptr(i);
+  for (size_t d = 0; d < data.n_rows; ++d)
+    sumsT(j, d) += scale * point[d];
+}
+
+template<typename eT>
+void SphericalKMeans::AddPoint(arma::mat& sumsT,
+                               const size_t j,
+                               const arma::SpMat<eT>& data,
+                               const size_t i,
+                               const double scale)
+{
+  for (size_t k = data.col_ptrs[i]; k < data.col_ptrs[i + 1]; ++k)
+    sumsT(j, data.row_indices[k]) += scale * (double) data.values[k];
+}
+
+inline void SphericalKMeans::NormalizeRows(const arma::mat& sumsT,
+                                           arma::mat& centroidsT)
+{
+  // Compute every norm in one pass over the sums, then scale them in another.
+  const arma::vec norms = arma::sqrt(arma::sum(arma::square(sumsT), 1));
+  for (size_t d = 0; d < sumsT.n_cols; ++d)
+    for (size_t j = 0; j < sumsT.n_rows; ++j)
+      if (norms[j] > 0)
+        centroidsT(j, d) = sumsT(j, d) / norms[j];
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
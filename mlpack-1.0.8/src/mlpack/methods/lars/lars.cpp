@@ -21,9 +21,78 @@
  */
 #include "lars.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::regression;
 
+/**
+ * Return whether or not the regression should be timed.  The timers are
+ * global and not thread-safe, so they are not used when LARS is run inside a
+ * parallel region (for instance, by SparseCoding).
+ */
+static inline bool UseTimer()
+{
+#ifdef _OPENMP
+  return !omp_in_parallel();
+#else
+  return true;
+#endif
+}
+
+//! Return the dot product of the given column of the data with a vector.
+static inline double ColumnDot(const arma::mat& data,
+                               const size_t col,
+                               const arma::vec& v)
+{
+  return dot(data.unsafe_col(col), v);
+}
+
+//! Return the dot product of the given column of the sparse data with a
+//! vector, visiting only the nonzero elements of the column.
+static inline double ColumnDot(const arma::sp_mat& data,
+                               const size_t col,
+                               const arma::vec& v)
+{
+  double result = 0.0;
+  for (size_t k = data.col_ptrs[col]; k < data.col_ptrs[col + 1]; ++k)
+    result += data.values[k] * v[data.row_indices[k]];
+
+  return result;
+}
+
+//! Return the dot product of two columns of the data.
+static inline double ColumnDot(const arma::mat& data,
+                               const size_t col1,
+                               const size_t col2)
+{
+  return dot(data.unsafe_col(col1), data.unsafe_col(col2));
+}
+
+//! Return the dot product of two columns of the sparse data, by merging their
+//! (sorted) lists of nonzero elements.
+static inline double ColumnDot(const arma::sp_mat& data,
+                               const size_t col1,
+                               const size_t col2)
+{
+  double result = 0.0;
+  size_t k1 = data.col_ptrs[col1];
+  size_t k2 = data.col_ptrs[col2];
+  while (k1 < data.col_ptrs[col1 + 1] && k2 < data.col_ptrs[col2 + 1])
+  {
+    if (data.row_indices[k1] < data.row_indices[k2])
+      ++k1;
+    else if (data.row_indices[k2] < data.row_indices[k1])
+      ++k2;
+    else
+      result += data.values[k1++] * data.values[k2++];
+  }
+
+  return result;
+}
+
 LARS::LARS(const bool useCholesky,
            const double lambda1,
            const double lambda2,
@@ -34,7 +103,13 @@ LARS::LARS(const bool useCholesky,
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    storage(FULL_PATH),
+    threads(1),
+    pathStorage(FULL_PATH),
+    maxCorr(0),
+    lassocond(false),
+    vertexLambda(0)
 { /* Nothing left to do. */ }
 
 LARS::LARS(const bool useCholesky,
@@ -48,7 +123,13 @@ LARS::LARS(const bool useCholesky,
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    storage(FULL_PATH),
+    threads(1),
+    pathStorage(FULL_PATH),
+    maxCorr(0),
+    lassocond(false),
+    vertexLambda(0)
 { /* Nothing left to do */ }
 
 void LARS::Regress(const arma::mat& matX,
@@ -56,53 +137,199 @@ void LARS::Regress(const arma::mat& matX,
                    arma::vec& beta,
                    const bool transposeData)
 {
-  Timer::Start("lars_regression");
+  RegressData(matX, y, beta, transposeData);
+}
+
+void LARS::Regress(const arma::sp_mat& matX,
+                   const arma::vec& y,
+                   arma::vec& beta,
+                   const bool transposeData)
+{
+  RegressData(matX, y, beta, transposeData);
+}
+
+template<typename MatType>
+void LARS::RegressData(const MatType& matX,
+                       const arma::vec& y,
+                       arma::vec& beta,
+                       const bool transposeData)
+{
+  const bool timed = UseTimer();
+  if (timed)
+    Timer::Start("lars_regression");
 
   // This matrix may end up holding the transpose -- if necessary.
-  arma::mat dataTrans;
+  MatType dataTrans;
   // dataRef is row-major.
-  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  const MatType& dataRef = (transposeData ? dataTrans : matX);
   if (transposeData)
     dataTrans = trans(matX);
 
+  // The Gram matrix (if we compute it) belongs to this data.
+  if (&matGram == &matGramInternal)
+    matGramInternal.reset();
+
   // Compute X' * y.
-  arma::vec vecXTy = trans(dataRef) * y;
+  ColumnProducts(dataRef, y, vecXTy);
+
+  RegressPath(dataRef, beta);
+
+  if (timed)
+    Timer::Stop("lars_regression");
+}
 
+void LARS::Regress(const arma::mat& matX,
+                   const arma::mat& y,
+                   arma::mat& beta,
+                   const bool transposeData)
+{
+  const bool timed = UseTimer();
+  if (timed)
+    Timer::Start("lars_regression");
+
+  // The transpose, the Gram matrix and X' * Y are computed once for all of the
+  // responses.
+  arma::mat dataTrans;
+  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  if (transposeData)
+    dataTrans = trans(matX);
+
+  if (&matGram == &matGramInternal)
+    matGramInternal.reset();
+
+  const arma::mat matXTy = trans(dataRef) * y;
+
+  beta.set_size(dataRef.n_cols, y.n_cols);
+  arma::vec responseBeta;
+  for (size_t i = 0; i < y.n_cols; ++i)
+  {
+    vecXTy = matXTy.col(i);
+    RegressPath(dataRef, responseBeta);
+    beta.col(i) = responseBeta;
+  }
+
+  if (timed)
+    Timer::Stop("lars_regression");
+}
+
+void LARS::ContinuePath(const arma::mat& matX,
+                        const double newLambda1,
+                        arma::vec& beta,
+                        const bool transposeData)
+{
+  ContinuePathData(matX, newLambda1, beta, transposeData);
+}
+
+void LARS::ContinuePath(const arma::sp_mat& matX,
+                        const double newLambda1,
+                        arma::vec& beta,
+                        const bool transposeData)
+{
+  ContinuePathData(matX, newLambda1, beta, transposeData);
+}
+
+template<typename MatType>
+void LARS::ContinuePathData(const MatType& matX,
+                            const double newLambda1,
+                            arma::vec& beta,
+                            const bool transposeData)
+{
+  if (lambdaPath.size() == 0)
+    Log::Fatal << "LARS::ContinuePath(): Regress() has not been called."
+        << std::endl;
+
+  if (!lasso || newLambda1 <= 0.0 || newLambda1 > lambda1)
+    Log::Fatal << "LARS::ContinuePath(): the new lambda1 (" << newLambda1
+        << ") must be greater than 0 and at most the current lambda1 ("
+        << lambda1 << ")." << std::endl;
+
+  const bool timed = UseTimer();
+  if (timed)
+    Timer::Start("lars_regression");
+
+  lambda1 = newLambda1;
+
+  // Undo the interpolation that ended the last regression; the last vertex of
+  // the path is where the main loop stopped.
+  SetLastBeta(vertexBeta);
+  lambdaPath.back() = vertexLambda;
+  beta = vertexBeta;
+
+  if (vertexLambda <= lambda1)
+  {
+    // The new solution is still on the last segment of the path.
+    if (lambdaPath.size() == 1)
+      lambdaPath[0] = lambda1;
+    else
+      InterpolateBeta();
+  }
+  else
+  {
+    MatType dataTrans;
+    const MatType& dataRef = (transposeData ? dataTrans : matX);
+    if (transposeData)
+      dataTrans = trans(matX);
+
+    ComputeGram(dataRef);
+    Iterate(dataRef, beta);
+  }
+
+  beta = lastBeta;
+
+  if (timed)
+    Timer::Stop("lars_regression");
+}
+
+template<typename MatType>
+void LARS::RegressPath(const MatType& dataRef, arma::vec& beta)
+{
   // Set up active set variables.  In the beginning, the active set has size 0
   // (all dimensions are inactive).
-  isActive.resize(dataRef.n_cols, false);
+  activeSet.clear();
+  isActive.assign(dataRef.n_cols, false);
+  matUtriCholFactor.reset();
+  pathStorage = storage;
+  betaPath.clear();
+  betaPathIndices.clear();
+  betaPathValues.clear();
+  lambdaPath.clear();
 
   // Initialize yHat and beta.
   beta = arma::zeros(dataRef.n_cols);
-  arma::vec yHat = arma::zeros(dataRef.n_rows);
-  arma::vec yHatDirection = arma::vec(dataRef.n_rows);
+  yHat = arma::zeros(dataRef.n_rows);
 
-  bool lassocond = false;
+  lassocond = false;
 
   // Compute the initial maximum correlation among all dimensions.
-  arma::vec corr = vecXTy;
-  double maxCorr = 0;
-  size_t changeInd = 0;
+  corr = vecXTy;
+  maxCorr = 0;
   for (size_t i = 0; i < vecXTy.n_elem; ++i)
   {
     if (fabs(corr(i)) > maxCorr)
-    {
       maxCorr = fabs(corr(i));
-      changeInd = i;
-    }
   }
 
-  betaPath.push_back(beta);
+  PushBeta(beta);
   lambdaPath.push_back(maxCorr);
+  vertexBeta = beta;
+  vertexLambda = maxCorr;
 
   // If the maximum correlation is too small, there is no reason to continue.
   if (maxCorr < lambda1)
   {
     lambdaPath[0] = lambda1;
-    Timer::Stop("lars_regression");
     return;
   }
 
+  ComputeGram(dataRef);
+  Iterate(dataRef, beta);
+
+  // Unfortunate copy...
+  beta = lastBeta;
+}
+
+void LARS::ComputeGram(const arma::mat& dataRef)
+{
   // Compute the Gram matrix.  If this is the elastic net problem, we will add
   // lambda2 * I_n to the matrix.
   if (matGram.n_elem == 0)
@@ -113,6 +340,31 @@ void LARS::Regress(const arma::mat& matX,
     if (elasticNet && !useCholesky)
       matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
   }
+}
+
+template<typename MatType>
+double LARS::GramEntry(const MatType& dataRef,
+                       const size_t i,
+                       const size_t j) const
+{
+  if (matGram.n_elem > 0)
+    return matGram(i, j);
+
+  // Without a Gram matrix, the entry is computed, and the elastic net penalty
+  // is added as ComputeGram() would.
+  double entry = ColumnDot(dataRef, i, j);
+  if (i == j && elasticNet && !useCholesky)
+    entry += lambda2;
+
+  return entry;
+}
+
+template<typename MatType>
+void LARS::Iterate(const MatType& dataRef, arma::vec& beta)
+{
+  size_t changeInd = 0;
+  arma::vec yHatDirection = arma::vec(dataRef.n_rows);
+  arma::vec dirCorr = arma::vec(dataRef.n_cols);
 
   // Main loop.
   while ((activeSet.size() < dataRef.n_cols) && (maxCorr > tolerance))
@@ -132,16 +384,13 @@ void LARS::Regress(const arma::mat& matX,
     {
       if (useCholesky)
       {
-        // vec newGramCol = vec(activeSet.size());
-        // for (size_t i = 0; i < activeSet.size(); i++)
-        // {
-        //   newGramCol[i] = dot(matX.col(activeSet[i]), matX.col(changeInd));
-        // }
-        // This is equivalent to the above 5 lines.
-        arma::vec newGramCol = matGram.elem(changeInd * dataRef.n_cols +
-            arma::conv_to<arma::uvec>::from(activeSet));
-
-        CholeskyInsert(matGram(changeInd, changeInd), newGramCol);
+        // Only the Gram matrix entries of the new dimension with the active
+        // dimensions are needed.
+        arma::vec newGramCol = arma::vec(activeSet.size());
+        for (size_t i = 0; i < activeSet.size(); i++)
+          newGramCol[i] = GramEntry(dataRef, activeSet[i], changeInd);
+
+        CholeskyInsert(GramEntry(dataRef, changeInd, changeInd), newGramCol);
       }
 
       // Add variable to active set.
@@ -183,7 +432,7 @@ void LARS::Regress(const arma::mat& matX,
       arma::mat matGramActive = arma::mat(activeSet.size(), activeSet.size());
       for (size_t i = 0; i < activeSet.size(); i++)
         for (size_t j = 0; j < activeSet.size(); j++)
-          matGramActive(i, j) = matGram(activeSet[i], activeSet[j]);
+          matGramActive(i, j) = GramEntry(dataRef, activeSet[i], activeSet[j]);
 
       arma::mat matS = s * arma::ones<arma::mat>(1, activeSet.size());
       unnormalizedBetaDirection = solve(matGramActive % trans(matS) % matS,
@@ -200,15 +449,22 @@ void LARS::Regress(const arma::mat& matX,
     // If not all variables are active.
     if (activeSet.size() < dataRef.n_cols)
     {
-      // Compute correlations with direction.
+      // Compute correlations with direction.  This is the most expensive part
+      // of the step, so it is done in parallel; gamma is then found in order.
+      #pragma omp parallel for num_threads(NumThreads()) schedule(static)
+      for (int ind = 0; ind < (int) dataRef.n_cols; ind++)
+      {
+        if (!isActive[ind])
+          dirCorr[ind] = ColumnDot(dataRef, ind, yHatDirection);
+      }
+
       for (size_t ind = 0; ind < dataRef.n_cols; ind++)
       {
         if (isActive[ind])
           continue;
 
-        double dirCorr = dot(dataRef.col(ind), yHatDirection);
-        double val1 = (maxCorr - corr(ind)) / (normalization - dirCorr);
-        double val2 = (maxCorr + corr(ind)) / (normalization + dirCorr);
+        double val1 = (maxCorr - corr(ind)) / (normalization - dirCorr[ind]);
+        double val2 = (maxCorr + corr(ind)) / (normalization + dirCorr[ind]);
         if ((val1 > 0) && (val1 < gamma))
           gamma = val1;
         if ((val2 > 0) && (val2 < gamma))
@@ -257,7 +513,7 @@ void LARS::Regress(const arma::mat& matX,
         beta(activeSet[changeInd]) = 0;
     }
 
-    betaPath.push_back(beta);
+    PushBeta(beta);
 
     if (lassocond)
     {
@@ -268,9 +524,7 @@ void LARS::Regress(const arma::mat& matX,
       Deactivate(changeInd);
     }
 
-    corr = vecXTy - trans(dataRef) * yHat;
-    if (elasticNet)
-      corr -= lambda2 * beta;
+    ComputeCorrelations(dataRef, beta);
 
     double curLambda = 0;
     for (size_t i = 0; i < activeSet.size(); i++)
@@ -285,16 +539,18 @@ void LARS::Regress(const arma::mat& matX,
     {
       if (curLambda <= lambda1)
       {
+        vertexBeta = lastBeta;
+        vertexLambda = curLambda;
         InterpolateBeta();
-        break;
+        return;
       }
     }
   }
 
-  // Unfortunate copy...
-  beta = betaPath.back();
 
-  Timer::Stop("lars_regression");
+  // The path ended without reaching lambda1; its end is the last vertex.
+  vertexBeta = lastBeta;
+  vertexLambda = lambdaPath.back();
 }
 
 // Private functions.
@@ -310,18 +566,171 @@ void LARS::Activate(const size_t varInd)
   activeSet.push_back(varInd);
 }
 
+void LARS::PathBeta(const size_t step, arma::vec& beta) const
+{
+  if (step >= lambdaPath.size())
+    Log::Fatal << "LARS::PathBeta(): step " << step << " is not in the path "
+        << "(of length " << lambdaPath.size() << ")." << std::endl;
+
+  if (pathStorage == FULL_PATH)
+  {
+    beta = betaPath[step];
+  }
+  else if (pathStorage == SPARSE_PATH)
+  {
+    beta.zeros(lastBeta.n_elem);
+    for (size_t i = 0; i < betaPathIndices[step].n_elem; ++i)
+      beta[betaPathIndices[step][i]] = betaPathValues[step][i];
+  }
+  else
+  {
+    if (step != lambdaPath.size() - 1)
+      Log::Fatal << "LARS::PathBeta(): only the solution is stored, so step "
+          << step << " is not available." << std::endl;
+
+    beta = lastBeta;
+  }
+}
+
+void LARS::PushBeta(const arma::vec& beta)
+{
+  // The path is interpolated between the last two steps, so both are kept
+  // whatever the storage.
+  previousBeta = lastBeta;
+  lastBeta = beta;
+
+  if (pathStorage == FULL_PATH)
+  {
+    betaPath.push_back(beta);
+  }
+  else if (pathStorage == SPARSE_PATH)
+  {
+    // An interpolated step may also be nonzero in a dimension which was just
+    // removed from the active set, so every dimension is checked.
+    size_t nonzero = 0;
+    for (size_t i = 0; i < beta.n_elem; ++i)
+      if (beta[i] != 0.0)
+        ++nonzero;
+
+    betaPathIndices.push_back(arma::Col<size_t>(nonzero));
+    betaPathValues.push_back(arma::vec(nonzero));
+    for (size_t i = 0, j = 0; i < beta.n_elem; ++i)
+    {
+      if (beta[i] != 0.0)
+      {
+        betaPathIndices.back()[j] = i;
+        betaPathValues.back()[j++] = beta[i];
+      }
+    }
+  }
+}
+
+void LARS::SetLastBeta(const arma::vec& beta)
+{
+  // Replace the last step with a new one after the same previous step.
+  const arma::vec previous = previousBeta;
+  if (pathStorage == FULL_PATH)
+    betaPath.pop_back();
+  else if (pathStorage == SPARSE_PATH)
+  {
+    betaPathIndices.pop_back();
+    betaPathValues.pop_back();
+  }
+
+  PushBeta(beta);
+  previousBeta = previous;
+}
+
+template<typename MatType>
+void LARS::ComputeCorrelations(const MatType& dataRef, const arma::vec& beta)
+{
+  ColumnProducts(dataRef, yHat, corr);
+  corr = vecXTy - corr;
+
+  if (elasticNet)
+    corr -= lambda2 * beta;
+}
+
+void LARS::ColumnProducts(const arma::mat& dataRef,
+                          const arma::vec& v,
+                          arma::vec& products) const
+{
+  const size_t numThreads = NumThreads();
+  if (numThreads == 1)
+  {
+    products = trans(dataRef) * v;
+  }
+  else
+  {
+    products.set_size(dataRef.n_cols);
+
+    #pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < (int) dataRef.n_cols; ++i)
+      products[i] = ColumnDot(dataRef, i, v);
+  }
+}
+
+void LARS::ColumnProducts(const arma::sp_mat& dataRef,
+                          const arma::vec& v,
+                          arma::vec& products) const
+{
+  products.set_size(dataRef.n_cols);
+
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic, 256)
+  for (int i = 0; i < (int) dataRef.n_cols; ++i)
+    products[i] = ColumnDot(dataRef, i, v);
+}
+
 void LARS::ComputeYHatDirection(const arma::mat& matX,
                                 const arma::vec& betaDirection,
                                 arma::vec& yHatDirection)
 {
-  yHatDirection.fill(0);
+  // Each thread computes the direction for a contiguous range of points.
+  const size_t numThreads = std::max(std::min(NumThreads(),
+      (size_t) matX.n_rows), (size_t) 1);
+
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (int thread = 0; thread < (int) numThreads; thread++)
+  {
+    const size_t first = thread * matX.n_rows / numThreads;
+    const size_t last = (thread + 1) * matX.n_rows / numThreads;
+
+    double* direction = yHatDirection.memptr();
+    for (size_t j = first; j < last; j++)
+      direction[j] = 0.0;
+
+    for (size_t i = 0; i < activeSet.size(); i++)
+    {
+      const double* column = matX.colptr(activeSet[i]);
+      const double coefficient = betaDirection(i);
+      for (size_t j = first; j < last; j++)
+        direction[j] += coefficient * column[j];
+    }
+  }
+}
+
+void LARS::ComputeYHatDirection(const arma::sp_mat& matX,
+                                const arma::vec& betaDirection,
+                                arma::vec& yHatDirection)
+{
+  // Only the nonzero elements of the active dimensions contribute.
+  yHatDirection.zeros();
   for (size_t i = 0; i < activeSet.size(); i++)
-    yHatDirection += betaDirection(i) * matX.col(activeSet[i]);
+  {
+    const size_t col = activeSet[i];
+    for (size_t k = matX.col_ptrs[col]; k < matX.col_ptrs[col + 1]; ++k)
+      yHatDirection[matX.row_indices[k]] += betaDirection(i) * matX.values[k];
+  }
+}
+
+size_t LARS::NumThreads() const
+{
+  return mlpack::Threads::Count(threads);
 }
 
 void LARS::InterpolateBeta()
 {
-  int pathLength = betaPath.size();
+  int pathLength = lambdaPath.size();
 
   // interpolate beta and stop
   double ultimateLambda = lambdaPath[pathLength - 1];
@@ -329,8 +738,7 @@ void LARS::InterpolateBeta()
   double interp = (penultimateLambda - lambda1)
       / (penultimateLambda - ultimateLambda);
 
-  betaPath[pathLength - 1] = (1 - interp) * (betaPath[pathLength - 2])
-      + interp * betaPath[pathLength - 1];
+  SetLastBeta((1 - interp) * previousBeta + interp * lastBeta);
 
   lambdaPath[pathLength - 1] = lambda1;
 }
@@ -96,10 +96,31 @@ namespace regression {
  *   publisher={Royal Statistical Society}
  * }
  * @endcode
+ *
+ * By default, the coefficients after every step of the path are stored in
+ * BetaPath().  For many dimensions and long paths this takes a lot of memory;
+ * with Storage() set to SPARSE_PATH only the nonzero coefficients of each step
+ * are kept (see BetaPathIndices() and BetaPathValues()), and with
+ * SOLUTION_ONLY only the solution is kept.  PathBeta() gives the coefficients
+ * of any stored step, whatever the storage.  The products of the data with
+ * the residual and with the equiangular direction, which take most of the
+ * time of each step, are computed in parallel if Threads() is not 1.
  */
 class LARS
 {
  public:
+  //! The ways to store the coefficients along the path.
+  enum PathStorage
+  {
+    //! Store a dense coefficient vector for each step (in BetaPath()).
+    FULL_PATH,
+    //! Store the nonzero coefficients of each step (in BetaPathIndices() and
+    //! BetaPathValues()).
+    SPARSE_PATH,
+    //! Store only the solution.
+    SOLUTION_ONLY
+  };
+
   /**
    * Set the parameters to LARS.  Both lambda1 and lambda2 default to 0.
    *
@@ -152,21 +173,126 @@ class LARS
                arma::vec& beta,
                const bool transposeData = true);
 
+  /**
+   * Run LARS on sparse data.  This is the same as the dense Regress(), but the
+   * data is never made dense: the products with the data visit only its
+   * nonzero elements, and, unless a Gram matrix was given to the constructor,
+   * the entries of the Gram matrix are computed only for the dimensions which
+   * enter the active set.
+   *
+   * @param data Column-major sparse input data (or row-major if transposeData
+   *     = false).
+   * @param responses A vector of targets.
+   * @param beta Vector to store the solution (the coefficients) in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Regress(const arma::sp_mat& data,
+               const arma::vec& responses,
+               arma::vec& beta,
+               const bool transposeData = true);
+
+  /**
+   * Run LARS for each column of the given response matrix, against the same
+   * data.  The data is transposed (if necessary) once, the Gram matrix is
+   * computed (if it was not given) once, and X^T y is computed for all of the
+   * responses with a single matrix product.  Afterwards, BetaPath(),
+   * LambdaPath(), ActiveSet() and ContinuePath() refer to the last response.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses A matrix of targets; each column is one response vector.
+   * @param beta Matrix to store the solutions in; column i is the solution for
+   *     column i of the responses.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Regress(const arma::mat& data,
+               const arma::mat& responses,
+               arma::mat& beta,
+               const bool transposeData = true);
+
+  /**
+   * Continue the regularization path of the last regression down to a smaller
+   * value of lambda1, starting from the active set, Cholesky factor and
+   * correlations of the last vertex of the path instead of from scratch.  The
+   * data must be the same as in the last call to Regress(), and the new lambda1
+   * must be greater than 0 and no greater than the current one.  The path is
+   * extended, so BetaPath() and LambdaPath() hold the whole path down to the
+   * new lambda1.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param newLambda1 New regularization parameter for the l1-norm penalty.
+   * @param beta Vector to store the new solution in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void ContinuePath(const arma::mat& data,
+                    const double newLambda1,
+                    arma::vec& beta,
+                    const bool transposeData = true);
+
+  /**
+   * Continue the regularization path of the last regression on sparse data
+   * down to a smaller value of lambda1 (see the dense ContinuePath()).
+   *
+   * @param data Column-major sparse input data (or row-major if transposeData
+   *     = false).
+   * @param newLambda1 New regularization parameter for the l1-norm penalty.
+   * @param beta Vector to store the new solution in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void ContinuePath(const arma::sp_mat& data,
+                    const double newLambda1,
+                    arma::vec& beta,
+                    const bool transposeData = true);
+
   //! Access the set of active dimensions.
   const std::vector<size_t>& ActiveSet() const { return activeSet; }
 
   //! Access the set of coefficients after each iteration; the solution is the
-  //! last element.
+  //! last element.  This is empty unless Storage() is FULL_PATH.
   const std::vector<arma::vec>& BetaPath() const { return betaPath; }
 
+  //! Access the indices of the nonzero coefficients after each iteration (in
+  //! increasing order).  This is empty unless Storage() is SPARSE_PATH.
+  const std::vector<arma::Col<size_t> >& BetaPathIndices() const
+  { return betaPathIndices; }
+
+  //! Access the nonzero coefficients after each iteration, in the order of
+  //! BetaPathIndices().  This is empty unless Storage() is SPARSE_PATH.
+  const std::vector<arma::vec>& BetaPathValues() const
+  { return betaPathValues; }
+
+  /**
+   * Get the coefficients after the given iteration of the path (as a dense
+   * vector), from whichever storage is used.  With SOLUTION_ONLY, only the
+   * last iteration (LambdaPath().size() - 1) is available.
+   *
+   * @param step Iteration of the path, indexing LambdaPath().
+   * @param beta Vector to store the coefficients in.
+   */
+  void PathBeta(const size_t step, arma::vec& beta) const;
+
   //! Access the set of values for lambda1 after each iteration; the solution is
   //! the last element.
   const std::vector<double>& LambdaPath() const { return lambdaPath; }
 
   //! Access the upper triangular cholesky factor
   const arma::mat& MatUtriCholFactor() const { return matUtriCholFactor; }
-  
-private:
+
+  //! Get how the coefficients along the path are stored.
+  PathStorage Storage() const { return storage; }
+  //! Modify how the coefficients along the path are stored.  This takes effect
+  //! at the next call to Regress().
+  PathStorage& Storage() { return storage; }
+
+  //! Get the number of threads used for the products with the data (1 is
+  //! serial, 0 is all cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the products with the data (1 is
+  //! serial, 0 is all cores).
+  size_t& Threads() { return threads; }
+
+ private:
   //! Gram matrix.
   arma::mat matGramInternal;
 
@@ -192,9 +318,30 @@ private:
   //! Tolerance for main loop.
   double tolerance;
 
-  //! Solution path.
+  //! How the coefficients along the path are stored.
+  PathStorage storage;
+
+  //! Number of threads used for the products with the data.
+  size_t threads;
+
+  //! How the coefficients of the current path are stored.
+  PathStorage pathStorage;
+
+  //! Solution path (with FULL_PATH).
   std::vector<arma::vec> betaPath;
 
+  //! Indices of the nonzero coefficients of the solution path (with
+  //! SPARSE_PATH).
+  std::vector<arma::Col<size_t> > betaPathIndices;
+
+  //! Nonzero coefficients of the solution path (with SPARSE_PATH).
+  std::vector<arma::vec> betaPathValues;
+
+  //! The coefficients of the last step of the path.
+  arma::vec lastBeta;
+  //! The coefficients of the step before the last one.
+  arma::vec previousBeta;
+
   //! Value of lambda_1 for each solution in solution path.
   std::vector<double> lambdaPath;
 
@@ -204,6 +351,92 @@ private:
   //! Active set membership indicator (for each dimension).
   std::vector<bool> isActive;
 
+  //! X^T y for the current response.
+  arma::vec vecXTy;
+  //! Prediction of the current estimator.
+  arma::vec yHat;
+  //! Correlations of the residual with each dimension.
+  arma::vec corr;
+  //! Maximum correlation among inactive dimensions.
+  double maxCorr;
+  //! Whether or not the last step removed a dimension from the active set.
+  bool lassocond;
+  //! The last vertex of the path (before interpolation to lambda1).
+  arma::vec vertexBeta;
+  //! The value of lambda1 at the last vertex of the path.
+  double vertexLambda;
+
+  /**
+   * Run LARS on one response vector; this is the body of Regress() for dense
+   * and sparse data.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses A vector of targets.
+   * @param beta Vector to store the solution in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  template<typename MatType>
+  void RegressData(const MatType& data,
+                   const arma::vec& responses,
+                   arma::vec& beta,
+                   const bool transposeData);
+
+  /**
+   * Continue the path of the last regression; this is the body of
+   * ContinuePath() for dense and sparse data.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param newLambda1 New regularization parameter for the l1-norm penalty.
+   * @param beta Vector to store the new solution in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  template<typename MatType>
+  void ContinuePathData(const MatType& data,
+                        const double newLambda1,
+                        arma::vec& beta,
+                        const bool transposeData);
+
+  /**
+   * Run LARS on the current X^T y, from an empty active set.
+   *
+   * @param dataRef Row-major input data.
+   * @param beta Vector to store the solution in.
+   */
+  template<typename MatType>
+  void RegressPath(const MatType& dataRef, arma::vec& beta);
+
+  //! Compute the Gram matrix, if it was not given and has not been computed.
+  void ComputeGram(const arma::mat& dataRef);
+
+  //! The Gram matrix of sparse data is not computed; its entries are computed
+  //! when they are needed by GramEntry().
+  void ComputeGram(const arma::sp_mat& /* dataRef */) { }
+
+  /**
+   * Return the entry of the Gram matrix for the given pair of dimensions,
+   * including the elastic net penalty if the Gram matrix holds it.  If there is
+   * no Gram matrix (sparse data), the entry is computed from the data.
+   *
+   * @param dataRef Row-major input data.
+   * @param i First dimension.
+   * @param j Second dimension.
+   */
+  template<typename MatType>
+  double GramEntry(const MatType& dataRef, const size_t i, const size_t j)
+      const;
+
+  /**
+   * Take LARS steps from the current state until lambda1 is reached or the path
+   * ends.
+   *
+   * @param dataRef Row-major input data.
+   * @param beta The current estimator, which is updated.
+   */
+  template<typename MatType>
+  void Iterate(const MatType& dataRef, arma::vec& beta);
+
   /**
    * Remove activeVarInd'th element from active set.
    *
@@ -218,11 +451,63 @@ private:
    */
   void Activate(const size_t varInd);
 
+  /**
+   * Add the given coefficients to the end of the path, in the storage given by
+   * Storage().
+   *
+   * @param beta Coefficients of the new step.
+   */
+  void PushBeta(const arma::vec& beta);
+
+  /**
+   * Replace the coefficients of the last step of the path.
+   *
+   * @param beta New coefficients of the last step.
+   */
+  void SetLastBeta(const arma::vec& beta);
+
+  /**
+   * Compute the correlations of the residual, y - yHat, with each dimension
+   * (in parallel, and with the elastic net penalty if necessary), and store
+   * them in corr.
+   *
+   * @param dataRef Row-major input data.
+   * @param beta The current estimator.
+   */
+  template<typename MatType>
+  void ComputeCorrelations(const MatType& dataRef, const arma::vec& beta);
+
+  /**
+   * Compute the product of the transposed data with the given vector (the dot
+   * product of each dimension with the vector), in parallel.
+   *
+   * @param dataRef Row-major input data.
+   * @param v Vector with one element for each point.
+   * @param products Vector to store the products in.
+   */
+  void ColumnProducts(const arma::mat& dataRef,
+                      const arma::vec& v,
+                      arma::vec& products) const;
+
+  //! Compute the product of the transposed sparse data with the given vector,
+  //! visiting only the nonzero elements.
+  void ColumnProducts(const arma::sp_mat& dataRef,
+                      const arma::vec& v,
+                      arma::vec& products) const;
+
   // compute "equiangular" direction in output space
   void ComputeYHatDirection(const arma::mat& matX,
                             const arma::vec& betaDirection,
                             arma::vec& yHatDirection);
 
+  //! Compute the "equiangular" direction in output space for sparse data.
+  void ComputeYHatDirection(const arma::sp_mat& matX,
+                            const arma::vec& betaDirection,
+                            arma::vec& yHatDirection);
+
+  //! Return the number of threads to use for the products with the data.
+  size_t NumThreads() const;
+
   // interpolate to compute last solution vector
   void InterpolateBeta();
 
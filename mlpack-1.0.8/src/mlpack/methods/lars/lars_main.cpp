@@ -58,6 +58,9 @@ PARAM_DOUBLE("lambda2", "Regularization parameter for l2-norm penalty.", "L",
     0);
 PARAM_FLAG("use_cholesky", "Use Cholesky decomposition during computation "
     "rather than explicitly computing the full Gram matrix.", "c");
+PARAM_INT("threads", "Number of threads to use for the products of X with the "
+    "residual and the direction of each step (0 uses all available cores).  "
+    "This only has an effect if MLPACK was built with OpenMP.", "j", 1);
 
 using namespace arma;
 using namespace std;
@@ -72,6 +75,10 @@ int main(int argc, char* argv[])
   double lambda1 = CLI::GetParam<double>("lambda1");
   double lambda2 = CLI::GetParam<double>("lambda2");
   bool useCholesky = CLI::HasParam("use_cholesky");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (threads < 0)
+    Log::Fatal << "--threads (-j) must be non-negative." << endl;
 
   // Load covariates.  We can avoid LARS transposing our data by choosing to not
   // transpose this data.
@@ -96,8 +103,10 @@ int main(int argc, char* argv[])
     Log::Fatal << "Number of responses must be equal to number of rows of X!"
         << endl;
 
-  // Do LARS.
+  // Do LARS.  Only the solution is saved, so the path is not kept.
   LARS lars(useCholesky, lambda1, lambda2);
+  lars.Storage() = LARS::SOLUTION_ONLY;
+  lars.Threads() = (size_t) threads;
   vec beta;
   lars.Regress(matX, matY.unsafe_col(0), beta, false /* do not transpose */);
 
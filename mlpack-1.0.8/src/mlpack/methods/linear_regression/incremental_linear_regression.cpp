@@ -0,0 +1,149 @@
+/**
+ * @file incremental_linear_regression.cpp
+ *
+ * Implementation of the IncrementalLinearRegression class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "incremental_linear_regression.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::regression;
+
+IncrementalLinearRegression::IncrementalLinearRegression(const double lambda) :
+    lambda(lambda),
+    numPoints(0)
+{ }
+
+void IncrementalLinearRegression::Update(const arma::mat& predictors,
+                                         const arma::vec& responses)
+{
+  if (!CheckChunk(predictors.n_rows, predictors.n_cols, responses.n_elem))
+    return;
+
+  Timer::Start("incremental_linear_regression");
+
+  // The row of ones is not stored; its products are sums.
+  const size_t dims = gram.n_rows;
+  gram(0, 0) += predictors.n_cols;
+  moment[0] += accu(responses);
+  if (dims > 1)
+  {
+    const arma::vec sums = arma::sum(predictors, 1);
+    gram.submat(1, 0, dims - 1, 0) += sums;
+    gram.submat(0, 1, 0, dims - 1) += trans(sums);
+    gram.submat(1, 1, dims - 1, dims - 1) += predictors * trans(predictors);
+    moment.subvec(1, dims - 1) += predictors * responses;
+  }
+  numPoints += predictors.n_cols;
+
+  Timer::Stop("incremental_linear_regression");
+}
+
+void IncrementalLinearRegression::Update(const arma::sp_mat& predictors,
+                                         const arma::vec& responses)
+{
+  if (!CheckChunk(predictors.n_rows, predictors.n_cols, responses.n_elem))
+    return;
+
+  Timer::Start("incremental_linear_regression");
+
+  const size_t dims = gram.n_rows;
+  gram(0, 0) += predictors.n_cols;
+  moment[0] += accu(responses);
+  if (dims > 1)
+  {
+    // The sums and X^T y only need the nonzero elements.
+    arma::vec sums(dims - 1);
+    sums.zeros();
+    for (size_t i = 0; i < predictors.n_cols; ++i)
+    {
+      for (size_t k = predictors.col_ptrs[i]; k < predictors.col_ptrs[i + 1];
+          ++k)
+      {
+        sums[predictors.row_indices[k]] += predictors.values[k];
+        moment[predictors.row_indices[k] + 1] += predictors.values[k] *
+            responses[i];
+      }
+    }
+
+    gram.submat(1, 0, dims - 1, 0) += sums;
+    gram.submat(0, 1, 0, dims - 1) += trans(sums);
+
+    // The product is sparse; only the d x d result is made dense.
+    const arma::sp_mat product = predictors * trans(predictors);
+    gram.submat(1, 1, dims - 1, dims - 1) += arma::mat(product);
+  }
+  numPoints += predictors.n_cols;
+
+  Timer::Stop("incremental_linear_regression");
+}
+
+bool IncrementalLinearRegression::CheckChunk(const size_t rows,
+                                             const size_t cols,
+                                             const size_t numResponses)
+{
+  if (cols != numResponses)
+    Log::Fatal << "IncrementalLinearRegression::Update(): " << cols
+        << " observations but " << numResponses << " responses!" << endl;
+
+  if (cols == 0)
+    return false;
+
+  const size_t dims = rows + 1;
+  if (numPoints == 0)
+  {
+    gram.zeros(dims, dims);
+    moment.zeros(dims);
+  }
+  else if (dims != gram.n_rows)
+  {
+    Log::Fatal << "IncrementalLinearRegression::Update(): chunk has "
+        << rows << " dimensions, but the previous chunks have "
+        << gram.n_rows - 1 << "!" << endl;
+  }
+
+  return true;
+}
+
+void IncrementalLinearRegression::Update(const string& filename)
+{
+  arma::mat chunk;
+  data::Load(filename, chunk, true);
+
+  const arma::vec responses = trans(chunk.row(chunk.n_rows - 1));
+  chunk.shed_row(chunk.n_rows - 1);
+  Update(chunk, responses);
+}
+
+void IncrementalLinearRegression::Fit(LinearRegression& model) const
+{
+  if (numPoints == 0)
+    Log::Fatal << "IncrementalLinearRegression::Fit(): no observations were "
+        << "given!" << endl;
+
+  Timer::Start("incremental_linear_regression");
+
+  // (X^T X + lambda^2 I) B = X^T y is what LinearRegression solves by adding
+  // the rows lambda * I to X.
+  arma::mat regularized = gram;
+  regularized.diag() += lambda * lambda;
+  arma::solve(model.Parameters(), regularized, moment);
+  model.Lambda() = lambda;
+
+  Timer::Stop("incremental_linear_regression");
+}
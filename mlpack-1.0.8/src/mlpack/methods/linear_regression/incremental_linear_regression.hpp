@@ -0,0 +1,140 @@
+/**
+ * @file incremental_linear_regression.hpp
+ *
+ * Linear regression on data given one chunk of observations at a time, by
+ * accumulating the normal equations.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_LINEAR_REGRESSION_INCREMENTAL_LINEAR_REGRESSION_HPP
+#define __MLPACK_METHODS_LINEAR_REGRESSION_INCREMENTAL_LINEAR_REGRESSION_HPP
+
+#include <mlpack/core.hpp>
+#include "linear_regression.hpp"
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * Linear regression (or ridge regression) on data that is given one chunk of
+ * observations at a time, so that the whole dataset never has to be in memory.
+ * With a row of ones added to the predictors for the intercept, each chunk is
+ * folded into the sums X^T X and X^T y of the normal equations; only these are
+ * kept, so the memory used is O(d^2) no matter how many observations have been
+ * seen.  Once all the chunks are given, Fit() solves the normal equations.
+ *
+ * @code
+ * IncrementalLinearRegression ilr(lambda);
+ * for (size_t i = 0; i < chunkFiles.size(); ++i)
+ *   ilr.Update(chunkFiles[i]); // Responses in the last row of each file.
+ *
+ * LinearRegression lr;
+ * ilr.Fit(lr);
+ * lr.Predict(points, predictions);
+ * @endcode
+ *
+ * The results are those of LinearRegression on the concatenation of the
+ * chunks, up to rounding; solving the normal equations squares the condition
+ * number of the problem, so for badly conditioned data LinearRegression is more
+ * accurate.  More chunks can be given after Fit(); Fit() must be called again
+ * for them to be taken into account.
+ */
+class IncrementalLinearRegression
+{
+ public:
+  /**
+   * Create the IncrementalLinearRegression object, with the given Tikhonov
+   * regularization parameter.  As with LinearRegression, a lambda greater than
+   * 0 adds lambda^2 * I to X^T X.
+   *
+   * @param lambda Tikhonov regularization parameter for ridge regression.
+   */
+  IncrementalLinearRegression(const double lambda = 0.0);
+
+  /**
+   * Add a chunk of observations to the normal equations.  All chunks must have
+   * the same dimensionality.
+   *
+   * @param predictors Observations to add (one per column).
+   * @param responses Response of each observation.
+   */
+  void Update(const arma::mat& predictors, const arma::vec& responses);
+
+  /**
+   * Add a chunk of sparse observations to the normal equations.  Only the
+   * nonzero elements are visited, and the chunk is never made dense.
+   *
+   * @param predictors Observations to add (one per column).
+   * @param responses Response of each observation.
+   */
+  void Update(const arma::sp_mat& predictors, const arma::vec& responses);
+
+  /**
+   * Load a chunk of observations from the given file with data::Load(), and
+   * add it to the normal equations.  The responses are the last row of the
+   * file.  If the file cannot be loaded, a fatal error is given.
+   *
+   * @param filename File holding the chunk.
+   */
+  void Update(const std::string& filename);
+
+  /**
+   * Solve the normal equations of all the observations given so far, and store
+   * the parameters and lambda in the given model.
+   *
+   * @param model Model to store the parameters in.
+   */
+  void Fit(LinearRegression& model) const;
+
+  //! Get the number of observations given so far.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Get the Tikhonov regularization parameter for ridge regression.
+  double Lambda() const { return lambda; }
+  //! Modify the Tikhonov regularization parameter for ridge regression.  This
+  //! is taken into account by the next call to Fit().
+  double& Lambda() { return lambda; }
+
+ private:
+  //! The Tikhonov regularization parameter.
+  double lambda;
+
+  //! The number of observations given so far.
+  size_t numPoints;
+
+  //! X^T X of the observations given so far, with the row of ones first.
+  arma::mat gram;
+
+  //! X^T y of the observations given so far, with the row of ones first.
+  arma::vec moment;
+
+  /**
+   * Check the sizes of a chunk, and allocate the normal equations if it is the
+   * first one.  Return false if the chunk is empty.
+   *
+   * @param rows Number of dimensions of the chunk.
+   * @param cols Number of observations in the chunk.
+   * @param numResponses Number of responses given with the chunk.
+   */
+  bool CheckChunk(const size_t rows,
+                  const size_t cols,
+                  const size_t numResponses);
+};
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
@@ -20,69 +20,107 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "linear_regression.hpp"
+#include "incremental_linear_regression.hpp"
 
 using namespace mlpack;
 using namespace mlpack::regression;
 
 LinearRegression::LinearRegression(const arma::mat& predictors,
                                    const arma::colvec& responses,
-                                   const double lambda) :
+                                   const double lambda,
+                                   const size_t threads) :
     lambda(lambda)
 {
   /*
    * We want to calculate the a_i coefficients of:
    * \sum_{i=0}^n (a_i * x_i^i)
-   * In order to get the intercept value, we will add a row of ones.
+   * In order to get the intercept value, we add a row of ones.
+   *
+   * The least-squares solution comes from the QR decomposition of the n x
+   * (d + 2) matrix A = [1 X^T y].  Its R factor is [R z; 0 r], and the
+   * parameters B solve R * B = z.  We find that factor with the TSQR
+   * algorithm: the observations are split into blocks, the R factor of each
+   * block is found, and the R factors are stacked and decomposed again.  Only
+   * the Q of one block is ever formed, so the memory used does not grow with
+   * the number of observations.
    */
-
-  // We store the number of rows and columns of the predictors.
-  // Reminder: Armadillo stores the data transposed from how we think of it,
-  //           that is, columns are actually rows (see: column major order).
   const size_t nCols = predictors.n_cols;
-
-  // Here we add the row of ones to the predictors.
-  arma::mat p;
-  if (lambda == 0.0)
-  {
-    p.set_size(predictors.n_rows + 1, nCols);
-    p.submat(1, 0, p.n_rows - 1, nCols - 1) = predictors;
-    p.row(0).fill(1);
-  }
-  else
+  const size_t dims = predictors.n_rows + 1;
+
+  // Each thread handles a contiguous range of observations, a block at a
+  // time, and keeps the R factor of the observations it has seen so far.  The
+  // blocks have at least dims + 1 rows, so that each factorization removes
+  // rows.
+  const size_t numThreads = std::max(std::min(Threads::Count(threads),
+      nCols / (dims + 1)), (size_t) 1);
+  const size_t blockSize = std::max(MemoryBudget::BlockColumns(
+      MemoryBudget::MatrixBytes<double>(2 * (dims + 1), 1), nCols,
+      MemoryBudget::MatrixBytes<double>(4 * (dims + 1), dims + 1)),
+      dims + 1);
+
+  // Each thread writes its factor to its own rows, and the regularization
+  // rows (if any) go at the end.  Adding the rows lambda * I with responses of
+  // 0 is equivalent to ridge regression.  See
+  // http://math.stackexchange.com/questions/299481/ for more information.
+  arma::mat factors = arma::zeros<arma::mat>(numThreads * (dims + 1) +
+      ((lambda == 0.0) ? 0 : dims), dims + 1);
+  if (lambda != 0.0)
+    factors.submat(numThreads * (dims + 1), 0, factors.n_rows - 1, dims - 1) =
+        lambda * arma::eye<arma::mat>(dims, dims);
+
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (int thread = 0; thread < (int) numThreads; ++thread)
   {
-    // Add the identity matrix to the predictors (this is equivalent to ridge
-    // regression).  See http://math.stackexchange.com/questions/299481/ for
-    // more information.
-    p.set_size(predictors.n_rows + 1, nCols + predictors.n_rows + 1);
-    p.submat(1, 0, p.n_rows - 1, nCols - 1) = predictors;
-    p.row(0).subvec(0, nCols - 1).fill(1);
-    p.submat(0, nCols, p.n_rows - 1, nCols + predictors.n_rows) =
-        lambda * arma::eye<arma::mat>(predictors.n_rows + 1,
-                                      predictors.n_rows + 1);
+    const size_t first = thread * nCols / numThreads;
+    const size_t last = (thread + 1) * nCols / numThreads;
+
+    arma::mat r(0, dims + 1);
+    arma::mat q;
+    for (size_t begin = first; begin < last; begin += blockSize)
+    {
+      const size_t end = std::min(begin + blockSize, last) - 1;
+
+      // The block of A, below the R factor so far.
+      arma::mat block(r.n_rows + end - begin + 1, dims + 1);
+      if (r.n_rows > 0)
+        block.rows(0, r.n_rows - 1) = r;
+      block.submat(r.n_rows, 0, block.n_rows - 1, 0).fill(1);
+      if (dims > 1)
+        block.submat(r.n_rows, 1, block.n_rows - 1, dims - 1) =
+            arma::trans(predictors.cols(begin, end));
+      block.submat(r.n_rows, dims, block.n_rows - 1, dims) =
+          responses.subvec(begin, end);
+
+      arma::qr_econ(q, r, block);
+    }
+
+    if (r.n_rows > 0)
+      factors.rows(thread * (dims + 1), thread * (dims + 1) + r.n_rows - 1) =
+          r;
   }
 
-  // We compute the QR decomposition of the predictors.
-  // We transpose the predictors because they are in column major order.
-  arma::mat Q, R;
-  arma::qr(Q, R, arma::trans(p));
+  arma::mat q, r;
+  arma::qr_econ(q, r, factors);
+
+  // With fewer observations than dimensions, R has missing rows; they are 0.
+  if (r.n_rows < dims + 1)
+    r.resize(dims + 1, dims + 1);
 
   // We compute the parameters, B, like so:
-  // R * B = Q^T * responses
-  // B = Q^T * responses * R^-1
-  // If lambda > 0, then we must add a bunch of empty responses.
-  if (lambda == 0.0)
-  {
-    arma::solve(parameters, R, arma::trans(Q) * responses);
-  }
-  else
-  {
-    // Copy responses into larger vector.
-    arma::vec r(nCols + predictors.n_rows + 1);
-    r.subvec(0, nCols - 1) = responses;
-    r.subvec(nCols, nCols + predictors.n_rows).fill(0);
+  // R * B = z
+  const arma::mat R = r.submat(0, 0, dims - 1, dims - 1);
+  const arma::vec z = r.submat(0, dims, dims - 1, dims);
+  arma::solve(parameters, arma::trimatu(R), z);
+}
 
-    arma::solve(parameters, R, arma::trans(Q) * r);
-  }
+LinearRegression::LinearRegression(const arma::sp_mat& predictors,
+                                   const arma::vec& responses,
+                                   const double lambda)
+{
+  // The normal equations are accumulated from the nonzero elements only.
+  IncrementalLinearRegression normalEquations(lambda);
+  normalEquations.Update(predictors, responses);
+  normalEquations.Fit(*this);
 }
 
 LinearRegression::LinearRegression(const std::string& filename) :
@@ -110,6 +148,20 @@ void LinearRegression::Predict(const arma::mat& points, arma::vec& predictions)
   predictions += parameters(0);
 }
 
+void LinearRegression::Predict(const arma::sp_mat& points,
+                               arma::vec& predictions) const
+{
+  Log::Assert(points.n_rows == parameters.n_rows - 1);
+
+  // Start from the intercept, and add the products of the nonzero elements.
+  predictions.set_size(points.n_cols);
+  predictions.fill(parameters(0));
+  for (size_t i = 0; i < points.n_cols; ++i)
+    for (size_t k = points.col_ptrs[i]; k < points.col_ptrs[i + 1]; ++k)
+      predictions[i] += parameters(points.row_indices[k] + 1) *
+          points.values[k];
+}
+
 //! Compute the L2 squared error on the given predictors and responses.
 double LinearRegression::ComputeError(const arma::mat& predictors,
                                       const arma::vec& responses) const
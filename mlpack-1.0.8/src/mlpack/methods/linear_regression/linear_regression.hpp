@@ -31,17 +31,41 @@ namespace regression /** Regression methods. */ {
  * A simple linear regression algorithm using ordinary least squares.
  * Optionally, this class can perform ridge regression, if the lambda parameter
  * is set to a number greater than zero.
+ *
+ * The model is fit with a tall-skinny QR decomposition (TSQR), which works on
+ * blocks of observations and so needs memory proportional to the block size,
+ * not to the number of observations; the blocks are sized to fit in the
+ * MemoryBudget, and can be decomposed in parallel.  For datasets which do not
+ * fit in memory, see IncrementalLinearRegression.
  */
 class LinearRegression
 {
  public:
   /**
-   * Creates the model.
+   * Creates the model.  If threads is not 1, the blocks of observations are
+   * decomposed in parallel (this requires MLPACK to be built with OpenMP).
    *
    * @param predictors X, matrix of data points to create B with.
    * @param responses y, the measured data for each point in X
+   * @param lambda Tikhonov regularization parameter for ridge regression.
+   * @param threads Number of threads to use (0 uses all cores).
    */
   LinearRegression(const arma::mat& predictors,
+                   const arma::vec& responses,
+                   const double lambda = 0,
+                   const size_t threads = 1);
+
+  /**
+   * Creates the model from sparse predictors, without making them dense.  The
+   * normal equations X^T X B = X^T y are formed with sparse products (see
+   * IncrementalLinearRegression) and solved; this uses O(d^2) memory, but
+   * squares the condition number of the problem.
+   *
+   * @param predictors X, sparse matrix of data points to create B with.
+   * @param responses y, the measured data for each point in X
+   * @param lambda Tikhonov regularization parameter for ridge regression.
+   */
+  LinearRegression(const arma::sp_mat& predictors,
                    const arma::vec& responses,
                    const double lambda = 0);
 
@@ -72,6 +96,15 @@ class LinearRegression
    */
   void Predict(const arma::mat& points, arma::vec& predictions) const;
 
+  /**
+   * Calculate y_i for each sparse data point in points, visiting only the
+   * nonzero elements.
+   *
+   * @param points the data points to calculate with.
+   * @param predictions y, will contain calculated values on completion.
+   */
+  void Predict(const arma::sp_mat& points, arma::vec& predictions) const;
+
   /**
    * Calculate the L2 squared error on the given predictors and responses using
    * this linear regression model.  This calculation returns
@@ -57,6 +57,9 @@ PARAM_STRING("output_predictions", "If --test_file is specified, this file is "
 
 PARAM_DOUBLE("lambda", "Tikhonov regularization for ridge regression.  If 0, "
     "the method reduces to linear regression.", "l", 0.0);
+PARAM_INT("threads", "Number of threads to use to decompose blocks of the "
+    "input (0 uses all available cores).  This only has an effect if MLPACK "
+    "was built with OpenMP.", "j", 1);
 
 using namespace mlpack;
 using namespace mlpack::regression;
@@ -75,6 +78,10 @@ int main(int argc, char* argv[])
   const string testName = CLI::GetParam<string>("test_file");
   const string trainName = CLI::GetParam<string>("input_file");
   const double lambda = CLI::GetParam<double>("lambda");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (threads < 0)
+    Log::Fatal << "--threads (-j) must be non-negative." << endl;
 
   mat regressors;
   mat responses;
@@ -146,7 +153,8 @@ int main(int argc, char* argv[])
     }
 
     Timer::Start("regression");
-    lr = LinearRegression(regressors, responses.unsafe_col(0));
+    lr = LinearRegression(regressors, responses.unsafe_col(0), lambda,
+        (size_t) threads);
     Timer::Stop("regression");
 
     // Save the parameters.
@@ -31,6 +31,8 @@
 #include "../sparse_coding/data_dependent_random_initializer.hpp"
 #include "../sparse_coding/random_initializer.hpp"
 
+#include "../sparse_coding/data_operations.hpp"
+
 namespace mlpack {
 namespace lcc {
 
@@ -85,9 +87,18 @@ namespace lcc {
  *   publisher={Institute of Mathematical Statistics}
  * }
  * @endcode
+ *
+ * The data may be dense (arma::mat) or sparse (arma::sp_mat).  With sparse
+ * data, only products with the data are computed, with sparse kernels; the
+ * data is never densified, and only one point at a time is copied to a dense
+ * vector, to be coded.
+ *
+ * @tparam DictionaryInitializer The class to use to initialize the dictionary.
+ * @tparam MatType Type of the data matrix (arma::mat or arma::sp_mat).
  */
 template<typename DictionaryInitializer =
-    sparse_coding::DataDependentRandomInitializer>
+    sparse_coding::DataDependentRandomInitializer,
+    typename MatType = arma::mat>
 class LocalCoordinateCoding
 {
  public:
@@ -98,7 +109,7 @@ class LocalCoordinateCoding
    * @param atoms Number of atoms in dictionary.
    * @param lambda Regularization parameter for weighted l1-norm penalty.
    */
-  LocalCoordinateCoding(const arma::mat& data,
+  LocalCoordinateCoding(const MatType& data,
                         const size_t atoms,
                         const double lambda);
 
@@ -114,7 +125,8 @@ class LocalCoordinateCoding
               const double objTolerance = 0.01);
 
   /**
-   * Code each point via distance-weighted LARS.
+   * Code each point via distance-weighted LARS.  The points are coded in
+   * parallel with Threads() threads.
    */
   void OptimizeCode();
 
@@ -133,7 +145,7 @@ class LocalCoordinateCoding
   double Objective(arma::uvec adjacencies) const;
 
   //! Access the data.
-  const arma::mat& Data() const { return data; }
+  const MatType& Data() const { return data; }
 
   //! Accessor for dictionary.
   const arma::mat& Dictionary() const { return dictionary; }
@@ -145,12 +157,18 @@ class LocalCoordinateCoding
   //! Modify the codes.
   arma::mat& Codes() { return codes; }
 
+  //! Get the number of threads used for the coding step.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the coding step (1 is serial, 0
+  //! uses all cores).
+  size_t& Threads() { return threads; }
+
  private:
   //! Number of atoms in dictionary.
   size_t atoms;
 
   //! Data matrix (columns are points).
-  const arma::mat& data;
+  const MatType& data;
 
   //! Dictionary (columns are atoms).
   arma::mat dictionary;
@@ -160,6 +178,12 @@ class LocalCoordinateCoding
 
   //! l1 regularization term.
   double lambda;
+
+  //! The number of threads used for the coding step.
+  size_t threads;
+
+  //! Return the number of threads the coding step will use.
+  size_t NumThreads() const;
 };
 
 }; // namespace lcc
@@ -25,25 +25,34 @@
 // In case it hasn't been included yet.
 #include "lcc.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace lcc {
 
-template<typename DictionaryInitializer>
-LocalCoordinateCoding<DictionaryInitializer>::LocalCoordinateCoding(
-    const arma::mat& data,
+using sparse_coding::Column;
+using sparse_coding::ColumnSquaredNorms;
+using sparse_coding::SquaredResidualNorm;
+
+template<typename DictionaryInitializer, typename MatType>
+LocalCoordinateCoding<DictionaryInitializer, MatType>::LocalCoordinateCoding(
+    const MatType& data,
     const size_t atoms,
     const double lambda) :
     atoms(atoms),
     data(data),
     codes(atoms, data.n_cols),
-    lambda(lambda)
+    lambda(lambda),
+    threads(1)
 {
   // Initialize the dictionary.
   DictionaryInitializer::Initialize(data, atoms, dictionary);
 }
 
-template<typename DictionaryInitializer>
-void LocalCoordinateCoding<DictionaryInitializer>::Encode(
+template<typename DictionaryInitializer, typename MatType>
+void LocalCoordinateCoding<DictionaryInitializer, MatType>::Encode(
     const size_t maxIterations,
     const double objTolerance)
 {
@@ -109,83 +118,76 @@ void LocalCoordinateCoding<DictionaryInitializer>::Encode(
   Timer::Stop("local_coordinate_coding");
 }
 
-template<typename DictionaryInitializer>
-void LocalCoordinateCoding<DictionaryInitializer>::OptimizeCode()
+template<typename DictionaryInitializer, typename MatType>
+void LocalCoordinateCoding<DictionaryInitializer, MatType>::OptimizeCode()
 {
-  arma::mat invSqDists = 1.0 / (repmat(trans(sum(square(dictionary))), 1,
-      data.n_cols) + repmat(sum(square(data)), atoms, 1) - 2 * trans(dictionary)
-      * data);
+  // The inverse squared distances between every atom and every point, and the
+  // Gram matrix of the dictionary, are computed once and shared by every point
+  // (and thread).
+  const arma::mat invSqDists = 1.0 / (repmat(trans(sum(square(dictionary))), 1,
+      data.n_cols) + repmat(ColumnSquaredNorms(data), atoms, 1) - 2 *
+      trans(dictionary) * data);
 
-  arma::mat dictGram = trans(dictionary) * dictionary;
-  arma::mat dictGramTD(dictGram.n_rows, dictGram.n_cols);
+  const arma::mat dictGram = trans(dictionary) * dictionary;
 
-  for (size_t i = 0; i < data.n_cols; i++)
+  // The points are independent, so they are coded in parallel.
+  #pragma omp parallel num_threads(NumThreads())
   {
-    // report progress
-    if ((i % 100) == 0)
+    // Each thread has its own weighted dictionary and weighted Gram matrix,
+    // which are overwritten (not reallocated) for each point.
+    arma::mat dictPrime(dictionary.n_rows, atoms);
+    arma::mat dictGramTD(atoms, atoms);
+    arma::vec beta;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < (int) data.n_cols; i++)
     {
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-    }
-
-    arma::vec invW = invSqDists.unsafe_col(i);
-    arma::mat dictPrime = dictionary * diagmat(invW);
+      // report progress
+      if ((i % 100) == 0)
+      {
+        #pragma omp critical
+        Log::Debug << "Optimization at point " << i << "." << std::endl;
+      }
 
-    arma::mat dictGramTD = diagmat(invW) * dictGram * diagmat(invW);
+      const arma::vec invW = invSqDists.unsafe_col(i);
+      for (size_t j = 0; j < atoms; ++j)
+      {
+        dictPrime.col(j) = dictionary.col(j) * invW[j];
+        dictGramTD.col(j) = (dictGram.col(j) * invW[j]) % invW;
+      }
 
-    bool useCholesky = false;
-    regression::LARS lars(useCholesky, dictGramTD, 0.5 * lambda);
+      bool useCholesky = false;
+      regression::LARS lars(useCholesky, dictGramTD, 0.5 * lambda);
 
-    // Run LARS for this point, by making an alias of the point and passing
-    // that.
-    arma::vec beta = codes.unsafe_col(i);
-    lars.Regress(dictPrime, data.unsafe_col(i), beta, false);
-    beta %= invW; // Remember, beta is an alias of codes.col(i).
+      // Run LARS for this point.  The columns of the codes are disjoint, so
+      // writing the result is safe in parallel.
+      lars.Regress(dictPrime, Column(data, i), beta, false);
+      codes.col(i) = beta % invW;
+    }
   }
 }
 
-template<typename DictionaryInitializer>
-void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary(
+template<typename DictionaryInitializer, typename MatType>
+void LocalCoordinateCoding<DictionaryInitializer, MatType>::OptimizeDictionary(
     arma::uvec adjacencies)
 {
-  // Count number of atomic neighbors for each point x^i.
-  arma::uvec neighborCounts = arma::zeros<arma::uvec>(data.n_cols, 1);
-  if (adjacencies.n_elem > 0)
+  // The dictionary step is the weighted least squares problem with the data
+  // dataPrime := [X x^1 ... x^1 ... x^n ... x^n], where each x^i is repeated
+  // for the number of neighbors x^i has, and codes codesPrime := [Z e_j ...],
+  // with one indicator column e_j (weighted by lambda |z_ji|) for each
+  // adjacency.  Instead of forming dataPrime, the weights of the adjacencies
+  // are collected into a matrix W, and the normal equations are
+  //   (Z Z^T + diag(W 1)) D^T = (Z + W) X^T,
+  // so the only product with the data is (Z + W) X^T.
+  arma::mat adjacencyWeights = arma::zeros(atoms, data.n_cols);
+  for (size_t l = 0; l < adjacencies.n_elem; ++l)
   {
-    // This gets the column index.  Intentional integer division.
-    size_t curPointInd = (size_t) (adjacencies(0) / atoms);
-    ++neighborCounts(curPointInd);
-
-    size_t nextColIndex = (curPointInd + 1) * atoms;
-    for (size_t l = 1; l < adjacencies.n_elem; l++)
-    {
-      // If l no longer refers to an element in this column, advance the column
-      // number accordingly.
-      if (adjacencies(l) >= nextColIndex)
-      {
-        curPointInd = (size_t) (adjacencies(l) / atoms);
-        nextColIndex = (curPointInd + 1) * atoms;
-      }
-
-      ++neighborCounts(curPointInd);
-    }
-  }
-
-  // Build dataPrime := [X x^1 ... x^1 ... x^n ... x^n]
-  // where each x^i is repeated for the number of neighbors x^i has.
-  arma::mat dataPrime = arma::zeros(data.n_rows,
-      data.n_cols + adjacencies.n_elem);
-
-  dataPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = data;
+    // Recover the location in the codes matrix that this adjacency refers to.
+    const size_t atomInd = adjacencies(l) % atoms;
+    const size_t pointInd = (size_t) (adjacencies(l) / atoms);
 
-  size_t curCol = data.n_cols;
-  for (size_t i = 0; i < data.n_cols; i++)
-  {
-    if (neighborCounts(i) > 0)
-    {
-      dataPrime(arma::span::all, arma::span(curCol, curCol + neighborCounts(i)
-          - 1)) = repmat(data.col(i), 1, neighborCounts(i));
-    }
-    curCol += neighborCounts(i);
+    adjacencyWeights(atomInd, pointInd) += lambda *
+        std::abs(codes(atomInd, pointInd));
   }
 
   // Handle the case of inactive atoms (atoms not used in the given coding).
@@ -195,98 +197,43 @@ void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary(
       inactiveAtoms.push_back(j);
 
   const size_t nInactiveAtoms = inactiveAtoms.size();
-  const size_t nActiveAtoms = atoms - nInactiveAtoms;
-
-  // Efficient construction of codes restricted to active atoms.
-  arma::mat codesPrime = arma::zeros(nActiveAtoms, data.n_cols +
-      adjacencies.n_elem);
-  arma::vec wSquared = arma::ones(data.n_cols + adjacencies.n_elem, 1);
-
-  if (nInactiveAtoms > 0)
-  {
-    Log::Warn << "There are " << nInactiveAtoms
-        << " inactive atoms.  They will be re-initialized randomly.\n";
-
-    // Create matrix holding only active codes.
-    arma::mat activeCodes;
-    math::RemoveRows(codes, inactiveAtoms, activeCodes);
-
-    // Create reverse atom lookup for active atoms.
-    arma::uvec atomReverseLookup(atoms);
-    size_t inactiveOffset = 0;
-    for (size_t i = 0; i < atoms; ++i)
-    {
-      if (inactiveAtoms[inactiveOffset] == i)
-        ++inactiveOffset;
-      else
-        atomReverseLookup(i - inactiveOffset) = i;
-    }
-
-    codesPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = activeCodes;
-
-    // Fill the rest of codesPrime.
-    for (size_t l = 0; l < adjacencies.n_elem; ++l)
-    {
-      // Recover the location in the codes matrix that this adjacency refers to.
-      size_t atomInd = adjacencies(l) % atoms;
-      size_t pointInd = (size_t) (adjacencies(l) / atoms);
-
-      // Fill matrix.
-      codesPrime(atomReverseLookup(atomInd), data.n_cols + l) = 1.0;
-      wSquared(data.n_cols + l) = codes(atomInd, pointInd);
-    }
-  }
-  else
-  {
-    // All atoms are active.
-    codesPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = codes;
-
-    for (size_t l = 0; l < adjacencies.n_elem; ++l)
-    {
-      // Recover the location in the codes matrix that this adjacency refers to.
-      size_t atomInd = adjacencies(l) % atoms;
-      size_t pointInd = (size_t) (adjacencies(l) / atoms);
 
-      // Fill matrix.
-      codesPrime(atomInd, data.n_cols + l) = 1.0;
-      wSquared(data.n_cols + l) = codes(atomInd, pointInd);
-    }
-  }
-
-  wSquared.subvec(data.n_cols, wSquared.n_elem - 1) = lambda *
-      abs(wSquared.subvec(data.n_cols, wSquared.n_elem - 1));
-
-  // Solve system.
   if (nInactiveAtoms == 0)
   {
     // No inactive atoms.  We can solve directly.
-    arma::mat A = codesPrime * diagmat(wSquared) * trans(codesPrime);
-    arma::mat B = codesPrime * diagmat(wSquared) * trans(dataPrime);
+    arma::mat A = codes * trans(codes) + diagmat(sum(adjacencyWeights, 1));
+    arma::mat B = (codes + adjacencyWeights) * trans(data);
 
     dictionary = trans(solve(A, B));
-    /*
-    dictionary = trans(solve(codesPrime * diagmat(wSquared) * trans(codesPrime),
-        codesPrime * diagmat(wSquared) * trans(dataPrime)));
-    */
   }
   else
   {
+    Log::Warn << "There are " << nInactiveAtoms
+        << " inactive atoms.  They will be re-initialized randomly.\n";
+
+    // Restrict the codes and the weights to the active atoms.
+    arma::mat activeCodes;
+    math::RemoveRows(codes, inactiveAtoms, activeCodes);
+    arma::mat activeWeights;
+    math::RemoveRows(adjacencyWeights, inactiveAtoms, activeWeights);
+
     // Inactive atoms must be reinitialized randomly, so we cannot solve
     // directly for the entire dictionary estimate.
-    arma::mat dictionaryActive =
-      trans(solve(codesPrime * diagmat(wSquared) * trans(codesPrime),
-                  codesPrime * diagmat(wSquared) * trans(dataPrime)));
+    arma::mat dictionaryActive = trans(solve(activeCodes * trans(activeCodes) +
+        diagmat(sum(activeWeights, 1)),
+        (activeCodes + activeWeights) * trans(data)));
 
     // Update all atoms.
     size_t currentInactiveIndex = 0;
     for (size_t i = 0; i < atoms; ++i)
     {
-      if (inactiveAtoms[currentInactiveIndex] == i)
+      if ((currentInactiveIndex < nInactiveAtoms) &&
+          (inactiveAtoms[currentInactiveIndex] == i))
       {
         // This atom is inactive.  Reinitialize it randomly.
-        dictionary.col(i) = (data.col(math::RandInt(data.n_cols)) +
-                             data.col(math::RandInt(data.n_cols)) +
-                             data.col(math::RandInt(data.n_cols)));
+        dictionary.col(i) = (Column(data, math::RandInt(data.n_cols)) +
+                             Column(data, math::RandInt(data.n_cols)) +
+                             Column(data, math::RandInt(data.n_cols)));
 
         // Now normalize the atom.
         dictionary.col(i) /= norm(dictionary.col(i), 2);
@@ -303,10 +250,15 @@ void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary(
   }
 }
 
-template<typename DictionaryInitializer>
-double LocalCoordinateCoding<DictionaryInitializer>::Objective(
+template<typename DictionaryInitializer, typename MatType>
+double LocalCoordinateCoding<DictionaryInitializer, MatType>::Objective(
     arma::uvec adjacencies) const
 {
+  // Squared distances between atoms and points are expanded, so that only
+  // inner products with the data are needed.
+  const arma::rowvec dataSqNorms = ColumnSquaredNorms(data);
+  const arma::rowvec dictSqNorms = sum(square(dictionary));
+
   double weightedL1NormZ = 0;
 
   for (size_t l = 0; l < adjacencies.n_elem; l++)
@@ -315,12 +267,21 @@ double LocalCoordinateCoding<DictionaryInitializer>::Objective(
     const size_t atomInd = adjacencies(l) % atoms;
     const size_t pointInd = (size_t) (adjacencies(l) / atoms);
 
-    weightedL1NormZ += fabs(codes(atomInd, pointInd)) * arma::as_scalar(
-        arma::sum(arma::square(dictionary.col(atomInd) - data.col(pointInd))));
+    const double sqDist = dictSqNorms[atomInd] + dataSqNorms[pointInd] - 2 *
+        dot(dictionary.unsafe_col(atomInd), Column(data, pointInd));
+    weightedL1NormZ += fabs(codes(atomInd, pointInd)) * sqDist;
   }
 
-  double froNormResidual = norm(data - dictionary * codes, "fro");
-  return std::pow(froNormResidual, 2.0) + lambda * weightedL1NormZ;
+  return SquaredResidualNorm(data, dictionary, codes) +
+      lambda * weightedL1NormZ;
+}
+
+template<typename DictionaryInitializer, typename MatType>
+size_t LocalCoordinateCoding<DictionaryInitializer, MatType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
 }
 
 }; // namespace lcc
@@ -52,7 +52,8 @@ PROGRAM_INFO("Local Coordinate Coding",
     "\n\n"
     "The maximum number of iterations may be specified with the -n option. "
     "Optionally, the input data matrix X can be normalized before coding with "
-    "the -N option.");
+    "the -N option.  The points are coded in parallel with the number of "
+    "threads given by -j (0 uses all cores).");
 
 PARAM_STRING_REQ("input_file", "Filename of the input data.", "i");
 PARAM_INT_REQ("atoms", "Number of atoms in the dictionary.", "k");
@@ -78,6 +79,9 @@ PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_DOUBLE("objective_tolerance", "Tolerance for objective function.", "o",
     0.01);
 
+PARAM_INT("threads", "Number of threads to use for the coding step (0 uses all "
+    "available cores).", "j", 1);
+
 using namespace arma;
 using namespace std;
 using namespace mlpack;
@@ -109,6 +113,11 @@ int main(int argc, char* argv[])
 
   const double objTolerance = CLI::GetParam<double>("objective_tolerance");
 
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
   mat input;
   data::Load(inputFile, input, true);
 
@@ -147,6 +156,7 @@ int main(int argc, char* argv[])
     }
 
     // Run LCC.
+    lcc.Threads() = (size_t) threads;
     lcc.Encode(maxIterations, objTolerance);
 
     // Save the results.
@@ -161,6 +171,7 @@ int main(int argc, char* argv[])
     LocalCoordinateCoding<> lcc(input, atoms, lambda);
 
     // Run LCC.
+    lcc.Threads() = (size_t) threads;
     lcc.Encode(maxIterations, objTolerance);
 
     // Save the results.
@@ -28,7 +28,8 @@ LogisticRegressionFunction::LogisticRegressionFunction(
     const arma::mat& predictors,
     const arma::vec& responses,
     const double lambda) :
-    predictors(predictors),
+    predictors(&predictors),
+    sparsePredictors(NULL),
     responses(responses),
     lambda(lambda)
 {
@@ -41,7 +42,8 @@ LogisticRegressionFunction::LogisticRegressionFunction(
     const arma::mat& initialPoint,
     const double lambda) :
     initialPoint(initialPoint),
-    predictors(predictors),
+    predictors(&predictors),
+    sparsePredictors(NULL),
     responses(responses),
     lambda(lambda)
 {
@@ -51,6 +53,34 @@ LogisticRegressionFunction::LogisticRegressionFunction(
     this->initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
 }
 
+LogisticRegressionFunction::LogisticRegressionFunction(
+    const arma::sp_mat& predictors,
+    const arma::vec& responses,
+    const double lambda) :
+    predictors(NULL),
+    sparsePredictors(&predictors),
+    responses(responses),
+    lambda(lambda)
+{
+  initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
+}
+
+LogisticRegressionFunction::LogisticRegressionFunction(
+    const arma::sp_mat& predictors,
+    const arma::vec& responses,
+    const arma::mat& initialPoint,
+    const double lambda) :
+    initialPoint(initialPoint),
+    predictors(NULL),
+    sparsePredictors(&predictors),
+    responses(responses),
+    lambda(lambda)
+{
+  if (initialPoint.n_rows != (predictors.n_rows + 1) ||
+      initialPoint.n_cols != 1)
+    this->initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
+}
+
 /**
  * Evaluate the logistic regression objective function given the estimated
  * parameters.
@@ -71,27 +101,12 @@ double LogisticRegressionFunction::Evaluate(const arma::mat& parameters)
       arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
-  // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
-  // does not need to be multiplied by any of the predictors.
-  const arma::vec exponents = parameters(0, 0) + predictors.t() *
-      parameters.col(0).subvec(1, parameters.n_elem - 1);
-  const arma::vec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
-
   // Assemble full objective function.  Often the objective function and the
   // regularization as given are divided by the number of features, but this
   // doesn't actually affect the optimization result, so we'll just ignore those
   // terms for computational efficiency.
-  double result = 0.0;
-  for (size_t i = 0; i < responses.n_elem; ++i)
-  {
-    if (responses[i] == 1)
-      result += log(sigmoid[i]);
-    else
-      result += log(1.0 - sigmoid[i]);
-  }
-
-  // Invert the result, because it's a minimization.
-  return -result + regularization;
+  ComputeSigmoids(parameters, 0, NumFunctions());
+  return NegativeLogLikelihood(0, NumFunctions()) + regularization;
 }
 
 /**
@@ -104,14 +119,12 @@ double LogisticRegressionFunction::Evaluate(const arma::mat& parameters,
 {
   // Calculate the regularization term.  We must divide by the number of points,
   // so that sum(Evaluate(parameters, [1:points])) == Evaluate(parameters).
-  const double regularization = lambda * (1.0 / (2.0 * predictors.n_cols)) *
+  const double regularization = lambda * (1.0 / (2.0 * NumFunctions())) *
       arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
   // Calculate sigmoid.
-  const double exponent = parameters(0, 0) + arma::dot(predictors.col(i),
-      parameters.col(0).subvec(1, parameters.n_elem - 1));
-  const double sigmoid = 1.0 / (1.0 + std::exp(-exponent));
+  const double sigmoid = 1.0 / (1.0 + std::exp(-Exponent(parameters, i)));
 
   if (responses[i] == 1)
     return -log(sigmoid) + regularization;
@@ -123,17 +136,28 @@ double LogisticRegressionFunction::Evaluate(const arma::mat& parameters,
 void LogisticRegressionFunction::Gradient(const arma::mat& parameters,
                                           arma::mat& gradient) const
 {
-  // Regularization term.
-  arma::mat regularization;
-  regularization = lambda * parameters.col(0).subvec(1, parameters.n_elem - 1);
+  ComputeSigmoids(parameters, 0, NumFunctions());
+  GradientFromSigmoids(parameters, 0, NumFunctions(), 1.0, gradient);
+}
+
+/**
+ * Evaluate the objective function and its gradient together; the sigmoids are
+ * only computed once for both.
+ */
+double LogisticRegressionFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  const double regularization = 0.5 * lambda *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
 
-  const arma::vec sigmoids = 1 / (1 + arma::exp(-parameters(0, 0)
-      - predictors.t() * parameters.col(0).subvec(1, parameters.n_elem - 1)));
+  ComputeSigmoids(parameters, 0, NumFunctions());
+  const double objective = NegativeLogLikelihood(0, NumFunctions()) +
+      regularization;
+  GradientFromSigmoids(parameters, 0, NumFunctions(), 1.0, gradient);
 
-  gradient.set_size(parameters.n_elem);
-  gradient[0] = -arma::accu(responses - sigmoids);
-  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors * (responses -
-      sigmoids) + regularization;
+  return objective;
 }
 
 /**
@@ -145,17 +169,209 @@ void LogisticRegressionFunction::Gradient(const arma::mat& parameters,
                                           const size_t i,
                                           arma::mat& gradient) const
 {
-  // Calculate the regularization term.
-  arma::mat regularization;
-  regularization = lambda * parameters.col(0).subvec(1, parameters.n_elem - 1)
-      / predictors.n_cols;
+  const double error = responses[i] - 1.0 / (1.0 +
+      std::exp(-Exponent(parameters, i)));
 
-  const double sigmoid = 1.0 / (1.0 + std::exp(-parameters(0, 0)
-      - arma::dot(predictors.col(i), parameters.col(0).subvec(1,
-      parameters.n_elem - 1))));
+  // Each point gets its share of the regularization.
+  gradient.set_size(parameters.n_elem, 1);
+  gradient[0] = -error;
+  gradient.rows(1, parameters.n_elem - 1) = (lambda / NumFunctions()) *
+      parameters.rows(1, parameters.n_elem - 1);
+
+  if (predictors)
+  {
+    gradient.rows(1, parameters.n_elem - 1) -= error * predictors->col(i);
+  }
+  else
+  {
+    for (arma::sp_mat::const_iterator it = sparsePredictors->begin_col(i);
+        it != sparsePredictors->end_col(i); ++it)
+      gradient[it.row() + 1] -= error * (*it);
+  }
+}
 
-  gradient.set_size(parameters.n_elem);
-  gradient[0] = -(responses[i] - sigmoid);
-  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors.col(i)
-      * (responses[i] - sigmoid) + regularization;
+/**
+ * Evaluate the gradient with respect to one point as a sparse vector, holding
+ * only the intercept and the nonzero dimensions of the point.  This is what
+ * Hogwild SGD steps with.
+ */
+void LogisticRegressionFunction::Gradient(const arma::mat& parameters,
+                                          const size_t i,
+                                          arma::sp_mat& gradient) const
+{
+  // Find the nonzero dimensions of the point.
+  std::vector<size_t> dimensions;
+  std::vector<double> values;
+  if (predictors)
+  {
+    for (size_t j = 0; j < predictors->n_rows; ++j)
+    {
+      if ((*predictors)(j, i) != 0)
+      {
+        dimensions.push_back(j);
+        values.push_back((*predictors)(j, i));
+      }
+    }
+  }
+  else
+  {
+    for (arma::sp_mat::const_iterator it = sparsePredictors->begin_col(i);
+        it != sparsePredictors->end_col(i); ++it)
+    {
+      dimensions.push_back(it.row());
+      values.push_back(*it);
+    }
+  }
+
+  const double error = responses[i] - 1.0 / (1.0 +
+      std::exp(-Exponent(parameters, i)));
+
+  arma::umat locations(2, dimensions.size() + 1);
+  arma::vec entries(dimensions.size() + 1);
+
+  locations(0, 0) = 0;
+  locations(1, 0) = 0;
+  entries[0] = -error;
+  for (size_t k = 0; k < dimensions.size(); ++k)
+  {
+    const size_t row = dimensions[k] + 1;
+    locations(0, k + 1) = row;
+    locations(1, k + 1) = 0;
+    entries[k + 1] = -values[k] * error +
+        lambda * parameters(row, 0) / NumFunctions();
+  }
+
+  gradient = arma::sp_mat(locations, entries, parameters.n_elem, 1);
+}
+
+/**
+ * Evaluate the logistic regression objective function on a batch of points.
+ * This is useful for mini-batch SGD: the sigmoids of the whole batch are
+ * computed with one matrix-vector product.
+ */
+double LogisticRegressionFunction::Evaluate(const arma::mat& parameters,
+                                            const size_t begin,
+                                            const size_t batchSize) const
+{
+  // Each point gets its share of the regularization, as in the separable
+  // Evaluate().
+  const double regularization = lambda * (batchSize /
+      (2.0 * NumFunctions())) *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  ComputeSigmoids(parameters, begin, batchSize);
+  return NegativeLogLikelihood(begin, batchSize) + regularization;
+}
+
+//! Evaluate the gradient of the objective function on a batch of points.
+void LogisticRegressionFunction::Gradient(const arma::mat& parameters,
+                                          const size_t begin,
+                                          const size_t batchSize,
+                                          arma::mat& gradient) const
+{
+  // Each point gets its share of the regularization, as in the separable
+  // Gradient().
+  ComputeSigmoids(parameters, begin, batchSize);
+  GradientFromSigmoids(parameters, begin, batchSize,
+      (double) batchSize / NumFunctions(), gradient);
+}
+
+//! Compute the intercept plus the dot product of a point with the parameters.
+double LogisticRegressionFunction::Exponent(const arma::mat& parameters,
+                                            const size_t i) const
+{
+  if (predictors)
+    return parameters(0, 0) + arma::dot(predictors->col(i),
+        parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  double exponent = parameters(0, 0);
+  for (arma::sp_mat::const_iterator it = sparsePredictors->begin_col(i);
+      it != sparsePredictors->end_col(i); ++it)
+    exponent += (*it) * parameters[it.row() + 1];
+
+  return exponent;
+}
+
+/**
+ * Compute the sigmoids of a range of points into the workspace.  For dense
+ * predictors the points and parameters are aliased rather than copied, so for
+ * the same number of points this allocates nothing.
+ */
+void LogisticRegressionFunction::ComputeSigmoids(const arma::mat& parameters,
+                                                 const size_t begin,
+                                                 const size_t count) const
+{
+  sigmoids.set_size(count);
+
+  if (predictors)
+  {
+    const arma::mat points(const_cast<double*>(predictors->colptr(begin)),
+        predictors->n_rows, count, false, true);
+    const arma::vec weights(const_cast<double*>(parameters.memptr()) + 1,
+        parameters.n_elem - 1, false, true);
+
+    sigmoids = trans(points) * weights;
+    sigmoids = 1.0 / (1.0 + arma::exp(-(sigmoids + parameters(0, 0))));
+  }
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      sigmoids[i] = 1.0 / (1.0 + std::exp(-Exponent(parameters, begin + i)));
+  }
+}
+
+//! Sum the negative log-likelihoods of a range of points from the sigmoids.
+double LogisticRegressionFunction::NegativeLogLikelihood(const size_t begin,
+                                                         const size_t count)
+    const
+{
+  double result = 0.0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (responses[begin + i] == 1)
+      result -= log(sigmoids[i]);
+    else
+      result -= log(1.0 - sigmoids[i]);
+  }
+
+  return result;
+}
+
+/**
+ * Compute the gradient of a range of points from the sigmoids in the
+ * workspace, which are overwritten with the errors.  The result is accumulated
+ * directly into the gradient, so no temporaries are made.
+ */
+void LogisticRegressionFunction::GradientFromSigmoids(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t count,
+    const double regularizationScale,
+    arma::mat& gradient) const
+{
+  sigmoids = responses.subvec(begin, begin + count - 1) - sigmoids;
+
+  gradient.set_size(parameters.n_elem, 1);
+  gradient[0] = -arma::accu(sigmoids);
+
+  arma::vec gradientWeights(gradient.memptr() + 1, parameters.n_elem - 1,
+      false, true);
+  gradientWeights = (regularizationScale * lambda) *
+      parameters.col(0).subvec(1, parameters.n_elem - 1);
+
+  if (predictors)
+  {
+    const arma::mat points(const_cast<double*>(predictors->colptr(begin)),
+        predictors->n_rows, count, false, true);
+    gradientWeights -= points * sigmoids;
+  }
+  else
+  {
+    for (size_t i = 0; i < count; ++i)
+      for (arma::sp_mat::const_iterator it =
+          sparsePredictors->begin_col(begin + i);
+          it != sparsePredictors->end_col(begin + i); ++it)
+        gradientWeights[it.row()] -= (*it) * sigmoids[i];
+  }
 }
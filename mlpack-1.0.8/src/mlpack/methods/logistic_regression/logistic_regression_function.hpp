@@ -32,7 +32,13 @@ namespace regression {
 /**
  * The log-likelihood function for the logistic regression objective function.
  * This is used by various mlpack optimizers to train a logistic regression
- * model.
+ * model.  The predictors may be dense or sparse.
+ *
+ * The overloads over many points (the full objective, its gradient, and the
+ * batch overloads) keep the sigmoids in a workspace that is reused between
+ * calls, so for a fixed number of points they do not allocate; this also means
+ * that they must not be called from several threads at once on the same
+ * object.  The separable (one point) overloads have no such restriction.
  */
 class LogisticRegressionFunction
 {
@@ -46,6 +52,15 @@ class LogisticRegressionFunction
                              const arma::mat& initialPoint,
                              const double lambda = 0);
 
+  LogisticRegressionFunction(const arma::sp_mat& predictors,
+                             const arma::vec& responses,
+                             const double lambda = 0);
+
+  LogisticRegressionFunction(const arma::sp_mat& predictors,
+                             const arma::vec& responses,
+                             const arma::mat& initialPoint,
+                             const double lambda = 0);
+
   //! Return the initial point for the optimization.
   const arma::mat& InitialPoint() const { return initialPoint; }
   //! Modify the initial point for the optimization.
@@ -56,8 +71,12 @@ class LogisticRegressionFunction
   //! Modify the regularization parameter (lambda).
   double& Lambda() { return lambda; }
 
-  //! Return the matrix of predictors.
-  const arma::mat& Predictors() const { return predictors; }
+  //! Return whether or not the predictors are sparse.
+  bool IsSparse() const { return (sparsePredictors != NULL); }
+  //! Return the matrix of predictors (only valid if they are dense).
+  const arma::mat& Predictors() const { return *predictors; }
+  //! Return the sparse matrix of predictors (only valid if they are sparse).
+  const arma::sp_mat& SparsePredictors() const { return *sparsePredictors; }
   //! Return the vector of responses.
   const arma::vec& Responses() const { return responses; }
 
@@ -99,6 +118,19 @@ class LogisticRegressionFunction
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the logistic regression log-likelihood function and its gradient
+   * with the given parameters at the same time.  This is cheaper than calling
+   * Evaluate() and Gradient(), because the sigmoids are only computed once, and
+   * is used by L-BFGS.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output gradient into.
+   * @return The objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
    * with the given parameters, and with respect to only one point in the
@@ -113,21 +145,98 @@ class LogisticRegressionFunction
                 const size_t i,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with respect to only one point, as a sparse vector.  The gradient is only
+   * nonzero for the intercept and the dimensions in which the point is nonzero,
+   * so for sparse data this is much cheaper to apply than the dense gradient,
+   * and it allows Hogwild steps with SGD.  Unlike the dense separable
+   * gradient, the L2-regularization is only applied to the dimensions in which
+   * the point is nonzero; with dense data (or lambda = 0), the two are the
+   * same.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param i Index of point to use for objective function gradient evaluation.
+   * @param gradient Sparse vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient) const;
+
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters, using only the points [begin, begin + batchSize).  This is the
+   * sum of the separable objective functions of those points, and is used by
+   * mini-batch SGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to only the points [begin, begin +
+   * batchSize).  This is the sum of the separable gradients of those points,
+   * and is used by mini-batch SGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
   //! Return the number of separable functions (the number of predictor points).
-  size_t NumFunctions() const { return predictors.n_cols; }
+  size_t NumFunctions() const
+  {
+    return predictors ? predictors->n_cols : sparsePredictors->n_cols;
+  }
 
  private:
   //! The initial point, from which to start the optimization.
   arma::mat initialPoint;
-  //! The matrix of data points (predictors).
-  const arma::mat& predictors;
+  //! The matrix of data points (predictors), if they are dense.
+  const arma::mat* predictors;
+  //! The matrix of data points (predictors), if they are sparse.
+  const arma::sp_mat* sparsePredictors;
   //! The vector of responses to the input data points.
   const arma::vec& responses;
   //! The regularization parameter for L2-regularization.
   double lambda;
+
+  //! The sigmoids (or errors) of the points last computed.
+  mutable arma::vec sigmoids;
+
+  //! Return the intercept plus the dot product of point i and the parameters.
+  double Exponent(const arma::mat& parameters, const size_t i) const;
+
+  //! Compute the sigmoids of the points [begin, begin + count).
+  void ComputeSigmoids(const arma::mat& parameters,
+                       const size_t begin,
+                       const size_t count) const;
+
+  //! Return the negative log-likelihood of the points [begin, begin + count),
+  //! from the sigmoids computed last.
+  double NegativeLogLikelihood(const size_t begin, const size_t count) const;
+
+  //! Compute the gradient of the points [begin, begin + count) from the
+  //! sigmoids computed last (which are overwritten), with the regularization
+  //! scaled by regularizationScale.
+  void GradientFromSigmoids(const arma::mat& parameters,
+                            const size_t begin,
+                            const size_t count,
+                            const double regularizationScale,
+                            arma::mat& gradient) const;
 };
 
 }; // namespace regression
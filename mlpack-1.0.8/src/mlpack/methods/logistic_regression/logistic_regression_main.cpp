@@ -23,6 +23,7 @@
 #include "logistic_regression.hpp"
 
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_separable/parallel_separable_function.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -51,7 +52,13 @@ PROGRAM_INFO("L2-regularized Logistic Regression and Prediction",
     "have more options, but the C++ interface must be used for those.  For the "
     "SGD optimizer, the --step_size parameter controls the step size taken at "
     "each iteration by the optimizer.  If the objective function for your data "
-    "is oscillating between Inf and 0, the step size is probably too large.\n"
+    "is oscillating between Inf and 0, the step size is probably too large.  "
+    "SGD can also take each step with the gradient of a mini-batch of points "
+    "(--batch_size), and with momentum (--momentum).  With --hogwild, SGD "
+    "instead takes lock-free parallel steps with sparse gradients, using the "
+    "number of threads given with --threads (0 means all available cores).  "
+    "With L-BFGS, --threads instead sets the number of threads which evaluate "
+    "the objective function and its gradient.\n"
     "\n"
     "This implementation of logistic regression supports L2-regularization, "
     "which can help the parameter vector b from overfitting.  This parameter "
@@ -94,6 +101,14 @@ PARAM_DOUBLE("tolerance", "Convergence tolerance for optimizer.", "T", 1e-10);
 PARAM_INT("max_iterations", "Maximum iterations for optimizer (0 indicates no "
     "limit).", "M", 0);
 PARAM_DOUBLE("step_size", "Step size for SGD optimizer.", "s", 0.01);
+PARAM_INT("batch_size", "Number of points in each mini-batch of the SGD "
+    "optimizer.", "b", 1);
+PARAM_DOUBLE("momentum", "Momentum of the SGD optimizer (0 means no "
+    "momentum).", "u", 0.0);
+PARAM_FLAG("hogwild", "Take lock-free parallel (Hogwild) steps with the SGD "
+    "optimizer.", "H");
+PARAM_INT("threads", "Number of threads for Hogwild SGD, or for the objective "
+    "function of L-BFGS (0 means all available cores).", "j", 1);
 
 int main(int argc, char** argv)
 {
@@ -113,6 +128,10 @@ int main(int argc, char** argv)
   const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const double decisionBoundary = CLI::GetParam<double>("decision_boundary");
   const double stepSize = CLI::GetParam<double>("step_size");
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  const double momentum = CLI::GetParam<double>("momentum");
+  const bool hogwild = CLI::HasParam("hogwild");
+  const int threads = CLI::GetParam<int>("threads");
 
   // One of inputFile and modelFile must be specified.
   if (inputFile.empty() && modelFile.empty())
@@ -159,6 +178,21 @@ int main(int argc, char** argv)
     Log::Fatal << "Step size (--step_size) must be positive (received "
         << stepSize << ")." << endl;
 
+  if ((batchSize <= 0) && (optimizerType == "sgd"))
+    Log::Fatal << "Batch size (--batch_size) must be positive (received "
+        << batchSize << ")." << endl;
+
+  if ((momentum < 0.0 || momentum >= 1.0) && (optimizerType == "sgd"))
+    Log::Fatal << "Momentum (--momentum) must be in [0, 1) (received "
+        << momentum << ")." << endl;
+
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (hogwild && (optimizerType != "sgd"))
+    Log::Warn << "--hogwild ignored because the optimizer is not SGD." << endl;
+
   // These are the matrices we might use.
   arma::mat regressors;
   arma::mat responses;
@@ -208,7 +242,24 @@ int main(int argc, char** argv)
           << "for training." << endl;
     }
 
-    if (optimizerType == "lbfgs")
+    if (optimizerType == "lbfgs" && threads != 1)
+    {
+      // Evaluate the objective function and its gradient as a parallel sum
+      // over the points.
+      typedef ParallelSeparableFunction<LogisticRegressionFunction>
+          ParallelFunctionType;
+      ParallelFunctionType plrf(lrf, (size_t) threads);
+      L_BFGS<ParallelFunctionType> lbfgsOpt(plrf);
+      lbfgsOpt.MaxIterations() = maxIterations;
+      lbfgsOpt.MinGradientNorm() = tolerance;
+      Log::Info << "Training model with L-BFGS optimizer." << endl;
+
+      model = lrf.GetInitialPoint();
+      Timer::Start("logistic_regression_optimization");
+      lbfgsOpt.Optimize(model);
+      Timer::Stop("logistic_regression_optimization");
+    }
+    else if (optimizerType == "lbfgs")
     {
       L_BFGS<LogisticRegressionFunction> lbfgsOpt(lrf);
       lbfgsOpt.MaxIterations() = maxIterations;
@@ -226,6 +277,10 @@ int main(int argc, char** argv)
       sgdOpt.MaxIterations() = maxIterations;
       sgdOpt.Tolerance() = tolerance;
       sgdOpt.StepSize() = stepSize;
+      sgdOpt.BatchSize() = (size_t) batchSize;
+      sgdOpt.Momentum() = momentum;
+      sgdOpt.Hogwild() = hogwild;
+      sgdOpt.Threads() = (size_t) threads;
       Log::Info << "Training model with SGD optimizer." << endl;
 
       // This will train the model.
@@ -78,6 +78,16 @@ PARAM_INT("second_hash_size", "The size of the second level hash table.", "M",
     99901);
 PARAM_INT("bucket_size", "The size of a bucket in the second level hash.", "B",
     500);
+PARAM_STRING("index_file", "Load the hash from this file (see --save_index) "
+    "instead of building it; it must have been built on --reference_file.  "
+    "The hash parameters are taken from the file.", "I", "");
+PARAM_STRING("save_index", "If specified, save the hash to this file, for "
+    "later use with --index_file.", "x", "");
+PARAM_INT("num_probes", "Number of additional buckets to probe in each hash "
+    "table (multi-probe LSH).  Probing more buckets gives the same recall with "
+    "fewer tables.", "P", 0);
+PARAM_INT("threads", "Number of threads to build the hash with (0 means all "
+    "available cores).", "j", 1);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 int main(int argc, char *argv[])
@@ -119,6 +129,20 @@ int main(int argc, char *argv[])
   const size_t numProj = CLI::GetParam<int>("projections");
   const size_t numTables = CLI::GetParam<int>("tables");
   const double hashWidth = CLI::GetParam<double>("hash_width");
+  const int numProbes = CLI::GetParam<int>("num_probes");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (numProbes < 0)
+  {
+    Log::Fatal << "Invalid number of probes: " << numProbes << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
 
   arma::Mat<size_t> neighbors;
   arma::mat distances;
@@ -132,29 +156,56 @@ int main(int argc, char *argv[])
               << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
   }
 
-  if (hashWidth == 0.0)
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with default hash width." << endl;
-  else
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with hash width(r): " << hashWidth << endl;
-
-  Timer::Start("hash_building");
+  const string indexFile = CLI::GetParam<string>("index_file");
+  const string saveIndexFile = CLI::GetParam<string>("save_index");
 
   LSHSearch<>* allkann;
 
-  if (CLI::GetParam<string>("query_file") != "")
-    allkann = new LSHSearch<>(referenceData, queryData, numProj, numTables,
-                              hashWidth, secondHashSize, bucketSize);
+  if (indexFile != "")
+  {
+    if (CLI::HasParam("projections") || CLI::HasParam("tables") ||
+        CLI::HasParam("hash_width") || CLI::HasParam("second_hash_size") ||
+        CLI::HasParam("bucket_size"))
+      Log::Warn << "Hash parameters ignored because --index_file is given."
+          << endl;
+
+    Timer::Start("hash_loading");
+
+    if (CLI::GetParam<string>("query_file") != "")
+      allkann = new LSHSearch<>(indexFile, referenceData, queryData);
+    else
+      allkann = new LSHSearch<>(indexFile, referenceData);
+
+    Timer::Stop("hash_loading");
+  }
   else
-    allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
-                              secondHashSize, bucketSize);
+  {
+    if (hashWidth == 0.0)
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with default hash width." << endl;
+    else
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with hash width(r): " << hashWidth << endl;
+
+    Timer::Start("hash_building");
+
+    if (CLI::GetParam<string>("query_file") != "")
+      allkann = new LSHSearch<>(referenceData, queryData, numProj, numTables,
+                                hashWidth, secondHashSize, bucketSize,
+                                (size_t) threads);
+    else
+      allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
+                                secondHashSize, bucketSize, (size_t) threads);
+
+    Timer::Stop("hash_building");
+  }
 
-  Timer::Stop("hash_building");
+  if (saveIndexFile != "")
+    allkann->Save(saveIndexFile);
 
   Log::Info << "Computing " << k << " distance approximate nearest neighbors "
       << endl;
-  allkann->Search(k, neighbors, distances);
+  allkann->Search(k, neighbors, distances, 0, (size_t) numProbes);
 
   Log::Info << "Neighbors computed." << endl;
 
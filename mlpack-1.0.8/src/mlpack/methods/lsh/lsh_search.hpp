@@ -42,8 +42,11 @@
 #include <vector>
 #include <string>
 
+#include <boost/unordered_map.hpp>
+
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+#include <mlpack/methods/neighbor_search/quantized_matrix.hpp>
 
 namespace mlpack {
 namespace neighbor {
@@ -79,6 +82,8 @@ class LSHSearch
    * @param bucketSize The size of the bucket in the second hash table. This is
    *     the maximum number of points that can be hashed into single bucket.
    *     Default values are already provided here.
+   * @param threads Number of threads to build the hash with (0 uses all
+   *     cores); the hash is the same for any number of threads.
    */
   LSHSearch(const arma::mat& referenceSet,
             const arma::mat& querySet,
@@ -86,7 +91,8 @@ class LSHSearch
             const size_t numTables,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 500,
+            const size_t threads = 1);
 
   /**
    * This function initializes the LSH class. It builds the hash on the
@@ -107,13 +113,63 @@ class LSHSearch
    * @param bucketSize The size of the bucket in the second hash table. This is
    *     the maximum number of points that can be hashed into single bucket.
    *     Default values are already provided here.
+   * @param threads Number of threads to build the hash with (0 uses all
+   *     cores); the hash is the same for any number of threads.
    */
   LSHSearch(const arma::mat& referenceSet,
             const size_t numProj,
             const size_t numTables,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 500,
+            const size_t threads = 1);
+
+  /**
+   * This function initializes the LSH class with a hash which was saved with
+   * Save(), instead of building it.  The projections and the second hash are
+   * read from the file, and on POSIX systems the bucket contents (which take
+   * up most of the file) are memory-mapped read-only instead of being read.
+   * The reference set must be the one the hash was built on.  If the file
+   * cannot be opened or is not a valid hash, a fatal error is given.
+   *
+   * @param filename File to load the hash from.
+   * @param referenceSet Set of reference points the hash was built on.
+   * @param querySet Set of query points.
+   */
+  LSHSearch(const std::string& filename,
+            const arma::mat& referenceSet,
+            const arma::mat& querySet);
+
+  /**
+   * This function initializes the LSH class with a hash which was saved with
+   * Save(), using the reference set as the set of queries too.
+   *
+   * @param filename File to load the hash from.
+   * @param referenceSet Set of reference points the hash was built on, and the
+   *     set of queries.
+   */
+  LSHSearch(const std::string& filename, const arma::mat& referenceSet);
+
+  /**
+   * Unmap the file the hash was loaded from, if any, and free the quantized
+   * reference points.
+   */
+  ~LSHSearch();
+
+  /**
+   * Save the hash (projections, offsets, and the second hash table) to the
+   * given file, so it can be loaded again without being rebuilt.  The
+   * reference set is not saved.  If the file cannot be written, a fatal error
+   * is given.
+   *
+   * The file stores, in host byte order: a header, the start of each bucket
+   * of the second hash table (starting on a page boundary), the point IDs in
+   * the buckets, the projection matrices, the offsets, and the weights of the
+   * second hash.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
 
   /**
    * Compute the nearest neighbors and store the output in the given matrices.
@@ -132,11 +188,75 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes The number of additional buckets to probe in each hash
+   *     table (multi-probe LSH; see ProbeBuckets()).  Probing more buckets
+   *     finds more of the true neighbors with the same tables, so fewer tables
+   *     (and less memory) are needed for the same recall.  By default, this is
+   *     zero, in which case only the bucket each query hashes to is searched.
    */
   void Search(const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0);
+
+  /**
+   * Store the reference points as 8-bit codes (see QuantizedMatrix), with
+   * scalar quantization or product quantization.  After this, Search()
+   * approximates the distances to the candidates from their codes and the
+   * full-precision query points.  If Rerank() is nonzero, the best Rerank()
+   * candidates of each query point are then re-ranked with their exact
+   * distances; that is the only time the reference set is read, so a
+   * memory-mapped reference set stays mostly on disk.  Otherwise the
+   * distances returned are the approximate ones.
+   *
+   * @param subspaces Number of subspaces for product quantization; 0 (the
+   *     default) means scalar quantization of each dimension.
+   */
+  void Quantize(const size_t subspaces = 0);
+
+  //! Get the quantized reference points (NULL if Quantize() was not called).
+  const QuantizedMatrix* Quantized() const { return quantized; }
+
+  //! Get the number of candidates re-ranked with exact distances.
+  size_t Rerank() const { return rerank; }
+  //! Modify the number of candidates re-ranked with exact distances, for each
+  //! query point, when the reference points are quantized (0 means none).
+  size_t& Rerank() { return rerank; }
+
+  /**
+   * Add the given points to the hash, without rebuilding it: each point is
+   * hashed with the existing projections and appended to its bucket in every
+   * table.  The buckets of inserted points grow as needed (bucketSize only
+   * limits the buckets of the hash as it was built).  The new points get the
+   * indices NumPoints() to NumPoints() + newPoints.n_cols - 1, in order, and
+   * are found by the next Search().  The points are copied.
+   *
+   * @param newPoints Points to add, with the dimensionality of the reference
+   *     set.
+   */
+  void Insert(const arma::mat& newPoints);
+
+  /**
+   * Remove the point with the given index (a reference point or an inserted
+   * point) from the results of Search().  The point stays in its buckets,
+   * marked as removed, so this takes constant time.
+   *
+   * @param index Index of the point to remove.
+   */
+  void Remove(const size_t index);
+
+  //! Get the number of points in the hash: the reference points and the
+  //! inserted points (including removed ones).  Search() returns this index
+  //! for missing neighbors.
+  size_t NumPoints() const { return referenceSet.n_cols + numInserted; }
+  //! Get the number of points added with Insert().
+  size_t NumInserted() const { return numInserted; }
+  //! Get the number of points removed with Remove().
+  size_t NumRemoved() const { return numRemoved; }
+
+  //! Get the number of threads the hash was built with.
+  size_t Threads() const { return threads; }
 
  private:
   /**
@@ -154,6 +274,71 @@ class LSHSearch
    */
   void BuildHash();
 
+  /**
+   * Compute the bucket of the second hash table of each of the given points in
+   * the given table.
+   *
+   * @param points Set of points (the reference set, or inserted points).
+   * @param table Index of the table.
+   * @param begin Index of the first point.
+   * @param count Number of points.
+   * @param buckets Vector to store the bucket of each point in.
+   */
+  void HashPoints(const arma::mat& points,
+                  const size_t table,
+                  const size_t begin,
+                  const size_t count,
+                  std::vector<size_t>& buckets) const;
+
+  /**
+   * Return the set holding the point with the given index (the reference set
+   * or the inserted points), and store the column of the point in that set.
+   */
+  const arma::mat& PointSet(const size_t index, size_t& column) const
+  {
+    if (index < referenceSet.n_cols)
+    {
+      column = index;
+      return referenceSet;
+    }
+
+    column = index - referenceSet.n_cols;
+    return insertedSet;
+  }
+
+  /**
+   * Hash every reference point in every table, and apply the buckets in the
+   * order of the tables and then of the points: either count the points of
+   * each bucket (up to bucketSize), or put each point into its bucket (if the
+   * bucket is not full).  The points are hashed in chunks, one chunk per
+   * thread at a time, and each thread then applies the buckets of all the
+   * chunks in its own range of buckets, so that the result is the same as
+   * that of a serial pass.
+   *
+   * @param fill If false, count the points; if true, put them into the
+   *     buckets, whose starts must have been computed.
+   * @param bucketCount Number of points of each bucket (counted or put so
+   *     far).
+   */
+  void AssignBuckets(const bool fill, std::vector<uint64_t>& bucketCount);
+
+  /**
+   * Load a hash saved with Save(); used by the loading constructors.
+   *
+   * @param filename File to load the hash from.
+   */
+  void Load(const std::string& filename);
+
+  //! Get the ID of the point stored at the given position of the bucket
+  //! contents.
+  size_t BucketPoint(const size_t position) const
+  {
+    if (pointIdSize == sizeof(uint32_t))
+      return (size_t) ((const uint32_t*) bucketContents)[position];
+    else
+      return (size_t) ((const uint64_t*) bucketContents)[position];
+  }
+
   /**
    * This function takes a query and hashes it into each of the hash tables to
    * get keys for the query and then the key is hashed to a bucket of the second
@@ -164,10 +349,42 @@ class LSHSearch
    * @param referenceIndices The list of neighbor candidates obtained from
    *    hashing the query into all the hash tables and eventually into
    *    multiple buckets of the second hash table.
+   * @param numTablesToSearch The number of tables to search (0 means all).
+   * @param numProbes The number of additional buckets to probe in each table.
    */
   void ReturnIndicesFromTable(const size_t queryIndex,
                               arma::uvec& referenceIndices,
-                              size_t numTablesToSearch);
+                              size_t numTablesToSearch,
+                              const size_t numProbes);
+
+  /**
+   * Find the buckets of the second hash table to search for a query in one
+   * table.  The first bucket is the one the query hashes to.  The others are
+   * the buckets of the keys that differ from the key of the query by -1 or +1
+   * in a few coordinates, in the order of their score: the sum of the squared
+   * distances from the projections of the query to the slot boundaries that
+   * are crossed.  These perturbation sets are generated with a heap, as in
+   * the following paper:
+   *
+   * @inproceedings{lv2007multi,
+   *   title={{Multi-Probe LSH: Efficient Indexing for High-Dimensional
+   *       Similarity Search}},
+   *   author={{Lv, Q. and Josephson, W. and Wang, Z. and Charikar, M. and
+   *       Li, K.}},
+   *   booktitle={{Proceedings of the 33rd International Conference on Very
+   *       Large Data Bases}},
+   *   year={2007}
+   * }
+   *
+   * @param queryProjection The projections of the query in the table, with
+   *     the offsets added and divided by the hash width (so the key of the
+   *     query is the floor of this).
+   * @param numProbes The number of additional buckets to probe.
+   * @param buckets Vector to store the buckets to search in.
+   */
+  void ProbeBuckets(const arma::vec& queryProjection,
+                    const size_t numProbes,
+                    std::vector<size_t>& buckets) const;
 
   /**
    * This is a helper function that computes the distance of the query to the
@@ -178,6 +395,15 @@ class LSHSearch
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Re-rank the candidates found for each query point with their exact
+   * distances, and keep the best k; this is used when the reference points are
+   * quantized.
+   *
+   * @param k Number of neighbors to keep.
+   */
+  void RerankCandidates(const size_t k);
+
   /**
    * This is a helper function that efficiently inserts better neighbor
    * candidates into an existing set of neighbor candidates. This function is
@@ -201,10 +427,10 @@ class LSHSearch
   const arma::mat& querySet;
 
   //! The number of projections
-  const size_t numProj;
+  size_t numProj;
 
   //! The number of hash tables
-  const size_t numTables;
+  size_t numTables;
 
   //! The std::vector containing the projection matrix of each table
   std::vector<arma::mat> projections; // should be [numProj x dims] x numTables
@@ -216,27 +442,67 @@ class LSHSearch
   double hashWidth;
 
   //! The big prime representing the size of the second hash
-  const size_t secondHashSize;
+  size_t secondHashSize;
 
   //! The weights of the second hash
   arma::vec secondHashWeights;
 
   //! The bucket size of the second hash
-  const size_t bucketSize;
+  size_t bucketSize;
+
+  //! The number of threads to build the hash with.
+  size_t threads;
 
   //! Instantiation of the metric.
   metric::SquaredEuclideanDistance metric;
 
-  //! The final hash table; should be (< secondHashSize) x bucketSize.
-  arma::Mat<size_t> secondHashTable;
+  //! The start of each bucket of the second hash table in the bucket contents;
+  //! bucket i holds the points at positions [bucketStart[i], bucketStart[i +
+  //! 1]).  Should be secondHashSize + 1.
+  const uint64_t* bucketStart;
+
+  //! The size of each point ID in the bucket contents, in bytes (32-bit IDs
+  //! are used whenever the reference set is small enough).
+  size_t pointIdSize;
+
+  //! The point IDs in all buckets of the second hash table, packed together.
+  const char* bucketContents;
+
+  //! Storage for bucketStart, if the hash was built (not loaded).
+  std::vector<uint64_t> bucketStartStorage;
+
+  //! Storage for 32-bit bucket contents, if the hash was built.
+  std::vector<uint32_t> bucketContents32;
+
+  //! Storage for 64-bit bucket contents, if the hash was built.
+  std::vector<uint64_t> bucketContents64;
+
+  //! The contents of the loaded file (NULL if the hash was built).
+  char* buffer;
+  //! The size of the loaded file.
+  size_t bufferSize;
+  //! Whether or not buffer was memory-mapped (as opposed to allocated).
+  bool mapped;
 
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
-  arma::Col<size_t> bucketContentSize;
+  //! The points added with Insert(); only the first numInserted columns are
+  //! used, the rest is room to grow.
+  arma::mat insertedSet;
+  //! The number of points added with Insert().
+  size_t numInserted;
+  //! The points added to each bucket by Insert() (only buckets with inserted
+  //! points are present).
+  boost::unordered_map<size_t, std::vector<size_t> > insertedBuckets;
+  //! Whether each point has been removed (empty if none has been).
+  std::vector<bool> removed;
+  //! The number of points removed with Remove().
+  size_t numRemoved;
 
-  //! For a particular hash value, points to the row in secondHashTable
-  //! corresponding to this value.  Should be secondHashSize.
-  arma::Col<size_t> bucketRowInHashTable;
+  //! The quantized reference points (NULL unless Quantize() was called).
+  QuantizedMatrix* quantized;
+  //! The number of candidates to re-rank with exact distances.
+  size_t rerank;
+  //! The distance table of the current query for the quantized points.
+  arma::mat queryTable;
 
   //! The pointer to the nearest neighbor distances.
   arma::mat* distancePtr;
@@ -24,9 +24,44 @@
 
 #include <mlpack/core.hpp>
 
+#include <queue>
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 namespace mlpack {
 namespace neighbor {
 
+// Layout of the header of a saved hash: an 8-byte magic string followed by
+// these fields, each 64 bits wide.  The hash width is stored as a double; the
+// rest are unsigned integers.
+enum LSHIndexHeaderField
+{
+  LSH_INDEX_VERSION = 0,
+  LSH_INDEX_DIMENSIONALITY,
+  LSH_INDEX_POINTS,
+  LSH_INDEX_PROJECTIONS,
+  LSH_INDEX_TABLES,
+  LSH_INDEX_HASH_WIDTH,
+  LSH_INDEX_SECOND_HASH_SIZE,
+  LSH_INDEX_BUCKET_SIZE,
+  LSH_INDEX_POINT_ID_SIZE,
+  LSH_INDEX_ENTRIES,
+  LSH_INDEX_BUCKET_OFFSET,
+  LSH_INDEX_CONTENTS_OFFSET,
+  LSH_INDEX_PROJECTION_OFFSET,
+  LSH_INDEX_HEADER_FIELDS
+};
+
+static const char lshIndexMagic[8] = { 'M', 'L', 'P', 'K', 'L', 'S', 'H',
+    'I' };
+
 // Construct the object.
 template<typename SortPolicy>
 LSHSearch<SortPolicy>::
@@ -36,14 +71,26 @@ LSHSearch(const arma::mat& referenceSet,
           const size_t numTables,
           const double hashWidthIn,
           const size_t secondHashSize,
-          const size_t bucketSize) :
+          const size_t bucketSize,
+          const size_t threads) :
   referenceSet(referenceSet),
   querySet(querySet),
   numProj(numProj),
   numTables(numTables),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
-  bucketSize(bucketSize)
+  bucketSize(bucketSize),
+  threads(threads),
+  bucketStart(NULL),
+  pointIdSize(sizeof(uint32_t)),
+  bucketContents(NULL),
+  buffer(NULL),
+  bufferSize(0),
+  mapped(false),
+  numInserted(0),
+  numRemoved(0),
+  quantized(NULL),
+  rerank(0)
 {
   if (hashWidth == 0.0) // The user has not provided any value.
   {
@@ -72,14 +119,26 @@ LSHSearch(const arma::mat& referenceSet,
           const size_t numTables,
           const double hashWidthIn,
           const size_t secondHashSize,
-          const size_t bucketSize) :
+          const size_t bucketSize,
+          const size_t threads) :
   referenceSet(referenceSet),
   querySet(referenceSet),
   numProj(numProj),
   numTables(numTables),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
-  bucketSize(bucketSize)
+  bucketSize(bucketSize),
+  threads(threads),
+  bucketStart(NULL),
+  pointIdSize(sizeof(uint32_t)),
+  bucketContents(NULL),
+  buffer(NULL),
+  bufferSize(0),
+  mapped(false),
+  numInserted(0),
+  numRemoved(0),
+  quantized(NULL),
+  rerank(0)
 {
   if (hashWidth == 0.0) // The user has not provided any value.
   {
@@ -101,6 +160,76 @@ LSHSearch(const arma::mat& referenceSet,
   BuildHash();
 }
 
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::
+LSHSearch(const std::string& filename,
+          const arma::mat& referenceSet,
+          const arma::mat& querySet) :
+  referenceSet(referenceSet),
+  querySet(querySet),
+  numProj(0),
+  numTables(0),
+  hashWidth(0.0),
+  secondHashSize(0),
+  bucketSize(0),
+  threads(1),
+  bucketStart(NULL),
+  pointIdSize(sizeof(uint32_t)),
+  bucketContents(NULL),
+  buffer(NULL),
+  bufferSize(0),
+  mapped(false),
+  numInserted(0),
+  numRemoved(0),
+  quantized(NULL),
+  rerank(0)
+{
+  Load(filename);
+}
+
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::
+LSHSearch(const std::string& filename, const arma::mat& referenceSet) :
+  referenceSet(referenceSet),
+  querySet(referenceSet),
+  numProj(0),
+  numTables(0),
+  hashWidth(0.0),
+  secondHashSize(0),
+  bucketSize(0),
+  threads(1),
+  bucketStart(NULL),
+  pointIdSize(sizeof(uint32_t)),
+  bucketContents(NULL),
+  buffer(NULL),
+  bufferSize(0),
+  mapped(false),
+  numInserted(0),
+  numRemoved(0),
+  quantized(NULL),
+  rerank(0)
+{
+  Load(filename);
+}
+
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::~LSHSearch()
+{
+  delete quantized;
+
+  if (buffer)
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(buffer, bufferSize);
+    else
+      delete[] buffer;
+#else
+    delete[] buffer;
+#endif
+  }
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
 InsertNeighbor(const size_t queryIndex,
@@ -135,8 +264,14 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
     return 0.0;
 
-  double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-                                    referenceSet.unsafe_col(referenceIndex));
+  // Quantized points are compared with the distance table of the query;
+  // inserted points are not quantized.
+  size_t column;
+  const arma::mat& points = PointSet(referenceIndex, column);
+  double distance = (quantized != NULL && referenceIndex < referenceSet.n_cols)
+      ? quantized->Distance(queryTable, referenceIndex) :
+      metric.Evaluate(querySet.unsafe_col(queryIndex),
+                      points.unsafe_col(column));
 
   // If this distance is better than any of the current candidates, the
   // SortDistance() function will give us the position to insert it into.
@@ -150,11 +285,100 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+ProbeBuckets(const arma::vec& queryProjection,
+             const size_t numProbes,
+             std::vector<size_t>& buckets) const
+{
+  // The bucket the query hashes to.
+  const arma::vec key = arma::floor(queryProjection);
+  const double hashValue = arma::dot(secondHashWeights, key);
+
+  buckets.clear();
+  buckets.push_back((size_t) hashValue % secondHashSize);
+
+  if (numProbes == 0)
+    return;
+
+  // Score each perturbation of a single coordinate by the squared distance to
+  // the boundary it crosses, and sort them.  Perturbation 2i moves coordinate
+  // i down by one, and perturbation 2i + 1 moves it up by one.
+  std::vector<std::pair<double, size_t> > perturbations(2 * numProj);
+  for (size_t i = 0; i < numProj; i++)
+  {
+    const double frac = queryProjection[i] - key[i];
+    perturbations[2 * i] = std::make_pair(frac * frac, 2 * i);
+    perturbations[2 * i + 1] = std::make_pair((1.0 - frac) * (1.0 - frac),
+        2 * i + 1);
+  }
+  std::sort(perturbations.begin(), perturbations.end());
+
+  // A perturbation set is a list of increasing positions in 'perturbations',
+  // with its score.  Every set is reached from {0} by a unique sequence of
+  // 'shift' (increment the last position) and 'expand' (append the position
+  // after the last) operations, neither of which decreases the score, so the
+  // sets come out of the heap in the order of their scores.
+  typedef std::pair<double, std::vector<size_t> > PerturbationSet;
+  std::priority_queue<PerturbationSet, std::vector<PerturbationSet>,
+      std::greater<PerturbationSet> > heap;
+  heap.push(PerturbationSet(perturbations[0].first,
+      std::vector<size_t>(1, 0)));
+
+  while (buckets.size() <= numProbes && !heap.empty())
+  {
+    const PerturbationSet set = heap.top();
+    heap.pop();
+
+    const size_t last = set.second.back();
+    if (last + 1 < perturbations.size())
+    {
+      PerturbationSet shifted = set;
+      shifted.second.back() = last + 1;
+      shifted.first += perturbations[last + 1].first -
+          perturbations[last].first;
+      heap.push(shifted);
+
+      PerturbationSet expanded = set;
+      expanded.second.push_back(last + 1);
+      expanded.first += perturbations[last + 1].first;
+      heap.push(expanded);
+    }
+
+    // A set which moves the same coordinate twice is not a valid key.
+    bool valid = true;
+    for (size_t i = 0; i < set.second.size() && valid; i++)
+      for (size_t j = i + 1; j < set.second.size() && valid; j++)
+        if (perturbations[set.second[i]].second / 2 ==
+            perturbations[set.second[j]].second / 2)
+          valid = false;
+
+    if (!valid)
+      continue;
+
+    // The hash of the perturbed key; the keys and weights are integers, so
+    // this is exactly the value BuildHash() computes for that key.
+    double probeValue = hashValue;
+    for (size_t i = 0; i < set.second.size(); i++)
+    {
+      const size_t perturbation = perturbations[set.second[i]].second;
+      const size_t dim = perturbation / 2;
+      if (perturbation % 2 == 0)
+        probeValue -= secondHashWeights[dim];
+      else
+        probeValue += secondHashWeights[dim];
+    }
+
+    buckets.push_back((size_t) probeValue % secondHashSize);
+  }
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
 ReturnIndicesFromTable(const size_t queryIndex,
                        arma::uvec& referenceIndices,
-                       size_t numTablesToSearch)
+                       size_t numTablesToSearch,
+                       const size_t numProbes)
 {
   // Decide on the number of tables to look into.
   if (numTablesToSearch == 0) // If no user input is given, search all.
@@ -180,36 +404,46 @@ ReturnIndicesFromTable(const size_t queryIndex,
   allProjInTables += offsets.cols(0, numTablesToSearch - 1);
   allProjInTables /= hashWidth;
 
-  // Compute the hash value of each key of the query into a bucket of the
-  // 'secondHashTable' using the 'secondHashWeights'.
-  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(allProjInTables);
-
-  for (size_t i = 0; i < hashVec.n_elem; i++)
-    hashVec[i] = (double) ((size_t) hashVec[i] % secondHashSize);
-
-  Log::Assert(hashVec.n_elem == numTablesToSearch);
-
-  // For all the buckets that the query is hashed into, sequentially
-  // collect the indices in those buckets.
+  // For all the buckets that the query is hashed (or probes) into in each
+  // table, sequentially collect the indices in those buckets.
   arma::Col<size_t> refPointsConsidered;
-  refPointsConsidered.zeros(referenceSet.n_cols);
+  refPointsConsidered.zeros(NumPoints());
 
-  for (size_t i = 0; i < hashVec.n_elem; i++) // For all tables.
+  std::vector<size_t> buckets;
+  for (size_t i = 0; i < numTablesToSearch; i++) // For all tables.
   {
-    size_t hashInd = (size_t) hashVec[i];
+    // Compute the hash value of the key of the query (and of the perturbed
+    // keys) into a bucket of the 'secondHashTable' using the
+    // 'secondHashWeights'.
+    ProbeBuckets(allProjInTables.unsafe_col(i), numProbes, buckets);
 
-    if (bucketContentSize[hashInd] > 0)
+    for (size_t b = 0; b < buckets.size(); b++)
     {
-      // Pick the indices in the bucket corresponding to 'hashInd'.
-      size_t tableRow = bucketRowInHashTable[hashInd];
-      assert(tableRow < secondHashSize);
-      assert(tableRow < secondHashTable.n_rows);
+      size_t hashInd = buckets[b];
 
-      for (size_t j = 0; j < bucketContentSize[hashInd]; j++)
-        refPointsConsidered[secondHashTable(tableRow, j)]++;
+      // Pick the indices in the bucket corresponding to 'hashInd'.
+      for (size_t j = (size_t) bucketStart[hashInd];
+           j < (size_t) bucketStart[hashInd + 1]; j++)
+        refPointsConsidered[BucketPoint(j)]++;
+
+      // And the points inserted into it since the hash was built.
+      if (numInserted == 0)
+        continue;
+
+      boost::unordered_map<size_t, std::vector<size_t> >::const_iterator it =
+          insertedBuckets.find(hashInd);
+      if (it != insertedBuckets.end())
+        for (size_t j = 0; j < it->second.size(); j++)
+          refPointsConsidered[it->second[j]]++;
     }
   }
 
+  // Removed points are not candidates.
+  if (numRemoved > 0)
+    for (size_t j = 0; j < removed.size(); j++)
+      if (removed[j])
+        refPointsConsidered[j] = 0;
+
   referenceIndices = arma::find(refPointsConsidered > 0);
 }
 
@@ -219,16 +453,21 @@ void LSHSearch<SortPolicy>::
 Search(const size_t k,
        arma::Mat<size_t>& resultingNeighbors,
        arma::mat& distances,
-       const size_t numTablesToSearch)
+       const size_t numTablesToSearch,
+       const size_t numProbes)
 {
   neighborPtr = &resultingNeighbors;
   distancePtr = &distances;
 
+  // With quantized reference points, more candidates may be kept for
+  // re-ranking.
+  const size_t numCandidates = (quantized != NULL) ? std::max(k, rerank) : k;
+
   // Set the size of the neighbor and distance matrices.
-  neighborPtr->set_size(k, querySet.n_cols);
-  distancePtr->set_size(k, querySet.n_cols);
+  neighborPtr->set_size(numCandidates, querySet.n_cols);
+  distancePtr->set_size(numCandidates, querySet.n_cols);
   distancePtr->fill(SortPolicy::WorstDistance());
-  neighborPtr->fill(referenceSet.n_cols);
+  neighborPtr->fill(NumPoints());
 
   size_t avgIndicesReturned = 0;
 
@@ -240,18 +479,24 @@ Search(const size_t k,
     // Hash every query into every hash table and eventually into the
     // 'secondHashTable' to obtain the neighbor candidates.
     arma::uvec refIndices;
-    ReturnIndicesFromTable(i, refIndices, numTablesToSearch);
+    ReturnIndicesFromTable(i, refIndices, numTablesToSearch, numProbes);
 
     // An informative book-keeping for the number of neighbor candidates
     // returned on average.
     avgIndicesReturned += refIndices.n_elem;
 
+    if (quantized != NULL)
+      quantized->DistanceTable(querySet.unsafe_col(i), queryTable);
+
     // Sequentially go through all the candidates and save the best 'k'
     // candidates.
     for (size_t j = 0; j < refIndices.n_elem; j++)
       BaseCase(i, (size_t) refIndices[j]);
   }
 
+  if (quantized != NULL && rerank > 0)
+    RerankCandidates(k);
+
   Timer::Stop("computing_neighbors");
 
   avgIndicesReturned /= querySet.n_cols;
@@ -259,6 +504,52 @@ Search(const size_t k,
       std::endl;
 }
 
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Quantize(const size_t subspaces)
+{
+  Timer::Start("quantizing_references");
+
+  delete quantized;
+  quantized = new QuantizedMatrix(referenceSet, subspaces);
+
+  Timer::Stop("quantizing_references");
+
+  Log::Info << "Reference points quantized to " << quantized->Subspaces()
+      << " bytes each." << std::endl;
+}
+
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::RerankCandidates(const size_t k)
+{
+  const arma::Mat<size_t> candidates = *neighborPtr;
+
+  neighborPtr->set_size(k, querySet.n_cols);
+  distancePtr->set_size(k, querySet.n_cols);
+  distancePtr->fill(SortPolicy::WorstDistance());
+  neighborPtr->fill(NumPoints());
+
+  for (size_t i = 0; i < querySet.n_cols; i++)
+  {
+    for (size_t j = 0; j < candidates.n_rows; j++)
+    {
+      // Unfilled candidate slots hold an invalid index.
+      if (candidates(j, i) == NumPoints())
+        break;
+
+      size_t column;
+      const arma::mat& points = PointSet(candidates(j, i), column);
+      const double distance = metric.Evaluate(querySet.unsafe_col(i),
+          points.unsafe_col(column));
+
+      arma::vec queryDist = distancePtr->unsafe_col(i);
+      const size_t insertPosition = SortPolicy::SortDistance(queryDist,
+          distance);
+      if (insertPosition != (size_t() - 1))
+        InsertNeighbor(i, insertPosition, candidates(j, i), distance);
+    }
+  }
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
 BuildHash()
@@ -281,126 +572,401 @@ BuildHash()
   // Step I: Prepare the second level hash.
 
   // Obtain the weights for the second hash.
-  secondHashWeights = arma::floor(arma::randu(numProj) *
-                                  (double) secondHashSize);
-
-  // The 'secondHashTable' is initially an empty matrix of size
-  // ('secondHashSize' x 'bucketSize'). But by only filling the buckets
-  // as points land in them allows us to shrink the size of the
-  // 'secondHashTable' at the end of the hashing.
-
-  // Fill the second hash table n = referenceSet.n_cols.  This is because no
-  // point has index 'n' so the presence of this in the bucket denotes that
-  // there are no more points in this bucket.
-  secondHashTable.set_size(secondHashSize, bucketSize);
-  secondHashTable.fill(referenceSet.n_cols);
-
-  // Keep track of the size of each bucket in the hash.  At the end of hashing
-  // most buckets will be empty.
-  bucketContentSize.zeros(secondHashSize);
-
-  // Instead of putting the points in the row corresponding to the bucket, we
-  // chose the next empty row and keep track of the row in which the bucket
-  // lies. This allows us to stack together and slice out the empty buckets at
-  // the end of the hashing.
-  bucketRowInHashTable.set_size(secondHashSize);
-  bucketRowInHashTable.fill(secondHashSize);
-
-  // Keep track of number of non-empty rows in the 'secondHashTable'.
-  size_t numRowsInTable = 0;
+  secondHashWeights.set_size(numProj);
+  math::Random(secondHashWeights);
+  secondHashWeights = arma::floor(secondHashWeights * (double) secondHashSize);
 
   // Step II: The offsets for all projections in all tables.
   // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
   // as randu(numProj, numTables) * hashWidth.
-  offsets.randu(numProj, numTables);
+  offsets.set_size(numProj, numTables);
+  math::Random(offsets);
   offsets *= hashWidth;
 
-  // Step III: Create each hash table in the first level hash one by one and
-  // putting them directly into the 'secondHashTable' for memory efficiency.
+  // Step III: Obtain the 'numProj' projections for each table.
+  projections.clear();
   for (size_t i = 0; i < numTables; i++)
   {
-    // Step IV: Obtain the 'numProj' projections for each table.
-
     // For L2 metric, 2-stable distributions are used, and
     // the normal Z ~ N(0, 1) is a 2-stable distribution.
-    arma::mat projMat;
-    projMat.randn(referenceSet.n_rows, numProj);
+    arma::mat projMat(referenceSet.n_rows, numProj);
+    math::RandNormal(projMat);
 
     // Save the projection matrix for querying.
     projections.push_back(projMat);
+  }
 
-    // Step V: create the 'numProj'-dimensional key for each point in each
-    // table.
-
-    // The following code performs the task of hashing each point to a
-    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
-    // 'referenceSet.n_cols') key matrix.
-    //
-    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
-    // and the corresponding offset be 'offset_i'.  Then the key of a single
-    // point is obtained as:
-    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       referenceSet.n_cols);
-    arma::mat hashMat = projMat.t() * referenceSet;
-    hashMat += offsetMat;
-    hashMat /= hashWidth;
-
-    // Step VI: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.
-    arma::rowvec secondHashVec = secondHashWeights.t()
-      * arma::floor(hashMat);
-
-    // This gives us the bucket for the corresponding point ID.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
-      secondHashVec[j] = (double)((size_t) secondHashVec[j] % secondHashSize);
-
-    Log::Assert(secondHashVec.n_elem == referenceSet.n_cols);
-
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
-    {
-      // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVec[j];
-      // The point ID is 'j'.
+  // Step IV: Count the points in each bucket of the second hash table.  The
+  // buckets are shared by all tables, and each holds at most 'bucketSize'
+  // points; the points that arrive after that are dropped.  The points are
+  // hashed in chunks, so the keys of all the points are never held at once.
+  std::vector<uint64_t> bucketCount(secondHashSize, 0);
+  AssignBuckets(false, bucketCount);
+
+  // Step V: Lay out the buckets one after another, without padding.
+  bucketStartStorage.resize(secondHashSize + 1);
+  bucketStartStorage[0] = 0;
+  size_t numNonEmptyBuckets = 0;
+  size_t maxBucketSize = 0;
+  for (size_t i = 0; i < secondHashSize; i++)
+  {
+    bucketStartStorage[i + 1] = bucketStartStorage[i] + bucketCount[i];
+    if (bucketCount[i] > 0)
+      numNonEmptyBuckets++;
+    if (bucketCount[i] > maxBucketSize)
+      maxBucketSize = (size_t) bucketCount[i];
+  }
+  const size_t entries = (size_t) bucketStartStorage[secondHashSize];
+
+  // Point IDs are stored in 32 bits unless there are too many points.
+  pointIdSize = (referenceSet.n_cols <= 0xFFFFFFFFu) ? sizeof(uint32_t) :
+      sizeof(uint64_t);
+  bucketContents32.clear();
+  bucketContents64.clear();
+  if (pointIdSize == sizeof(uint32_t))
+    bucketContents32.resize(entries);
+  else
+    bucketContents64.resize(entries);
+
+  // Step VI: Hash the points again and put each into its bucket, in the same
+  // order as they were counted.
+  std::fill(bucketCount.begin(), bucketCount.end(), 0);
+  AssignBuckets(true, bucketCount);
+
+  bucketStart = &bucketStartStorage[0];
+  if (entries == 0)
+    bucketContents = NULL;
+  else if (pointIdSize == sizeof(uint32_t))
+    bucketContents = (const char*) &bucketContents32[0];
+  else
+    bucketContents = (const char*) &bucketContents64[0];
+
+  Log::Info << "Final hash table size: " << entries << " points in "
+      << numNonEmptyBuckets << " buckets (largest bucket: " << maxBucketSize
+      << " points)." << std::endl;
+}
 
-      // If this is currently an empty bucket, start a new row keep track of
-      // which row corresponds to the bucket.
-      if (bucketContentSize[hashInd] == 0)
-      {
-        // Start a new row for hash.
-        bucketRowInHashTable[hashInd] = numRowsInTable;
-        secondHashTable(numRowsInTable, 0) = j;
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+AssignBuckets(const bool fill, std::vector<uint64_t>& bucketCount)
+{
+  const size_t numThreads = mlpack::Threads::Count(threads);
+  const size_t chunkSize = 65536;
+  const size_t numChunks = (referenceSet.n_cols + chunkSize - 1) / chunkSize;
+  const size_t numTasks = numTables * numChunks;
+
+  // Each round hashes one chunk of one table per thread; task t is chunk
+  // (t % numChunks) of table (t / numChunks).
+  std::vector<std::vector<size_t> > taskBuckets(numThreads);
+  for (size_t first = 0; first < numTasks; first += numThreads)
+  {
+    const size_t roundTasks = std::min(numThreads, numTasks - first);
 
-        numRowsInTable++;
-      }
+    // The projections are the expensive part.
+    #pragma omp parallel for num_threads(numThreads) schedule(static, 1)
+    for (int t = 0; t < (int) roundTasks; ++t)
+    {
+      const size_t task = first + t;
+      const size_t begin = (task % numChunks) * chunkSize;
+      HashPoints(referenceSet, task / numChunks, begin, std::min(chunkSize,
+          referenceSet.n_cols - begin), taskBuckets[t]);
+    }
 
-      else
+    // Thread s applies the buckets in [s * secondHashSize / numThreads,
+    // (s + 1) * secondHashSize / numThreads), in the serial order.
+    #pragma omp parallel for num_threads(numThreads) schedule(static, 1)
+    for (int s = 0; s < (int) numThreads; ++s)
+    {
+      const size_t low = s * secondHashSize / numThreads;
+      const size_t high = (s + 1) * secondHashSize / numThreads;
+      for (size_t t = 0; t < roundTasks; ++t)
       {
-        // If bucket is already present in the 'secondHashTable', find the
-        // corresponding row and insert the point ID in this row unless the
-        // bucket is full, in which case, do nothing.
-        if (bucketContentSize[hashInd] < bucketSize)
-          secondHashTable(bucketRowInHashTable[hashInd],
-                          bucketContentSize[hashInd]) = j;
+        const size_t begin = ((first + t) % numChunks) * chunkSize;
+        const std::vector<size_t>& buckets = taskBuckets[t];
+        for (size_t j = 0; j < buckets.size(); j++)
+        {
+          const size_t hashInd = buckets[j];
+          if (hashInd < low || hashInd >= high)
+            continue;
+
+          if (!fill)
+          {
+            if (bucketCount[hashInd] < bucketSize)
+              bucketCount[hashInd]++;
+            continue;
+          }
+
+          if (bucketStartStorage[hashInd] + bucketCount[hashInd] ==
+              bucketStartStorage[hashInd + 1])
+            continue; // The bucket is full.
+
+          const size_t position = (size_t) (bucketStartStorage[hashInd] +
+              bucketCount[hashInd]++);
+          if (pointIdSize == sizeof(uint32_t))
+            bucketContents32[position] = (uint32_t) (begin + j);
+          else
+            bucketContents64[position] = (uint64_t) (begin + j);
+        }
       }
+    }
+  }
+}
+
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+HashPoints(const arma::mat& points,
+           const size_t table,
+           const size_t begin,
+           const size_t count,
+           std::vector<size_t>& buckets) const
+{
+  // The following code performs the task of hashing each point to a
+  // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x 'count')
+  // key matrix.
+  //
+  // For a single table, let the 'numProj' projections be denoted by 'proj_i'
+  // and the corresponding offset be 'offset_i'.  Then the key of a single
+  // point is obtained as:
+  // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
+  arma::mat hashMat = projections[table].t() *
+      points.cols(begin, begin + count - 1);
+  hashMat += arma::repmat(offsets.unsafe_col(table), 1, count);
+  hashMat /= hashWidth;
+
+  // Now we hash every key to its corresponding bucket.
+  arma::rowvec secondHashVec = secondHashWeights.t() * arma::floor(hashMat);
+
+  buckets.resize(count);
+  for (size_t j = 0; j < count; j++)
+    buckets[j] = (size_t) secondHashVec[j] % secondHashSize;
+}
 
-      // Increment the count of the points in this bucket.
-      if (bucketContentSize[hashInd] < bucketSize)
-        bucketContentSize[hashInd]++;
-    } // Loop over all points in the reference set.
-  } // Loop over tables.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Insert(const arma::mat& newPoints)
+{
+  if (newPoints.n_rows != referenceSet.n_rows)
+    Log::Fatal << "LSHSearch::Insert(): the points have " << newPoints.n_rows
+        << " dimensions, but the reference set has " << referenceSet.n_rows
+        << "." << std::endl;
+
+  if (newPoints.n_cols == 0)
+    return;
+
+  // Copy the points, doubling the room for them when it runs out, so that
+  // inserting one point at a time takes amortized constant time.
+  const size_t firstIndex = NumPoints();
+  if (numInserted + newPoints.n_cols > insertedSet.n_cols)
+    insertedSet.resize(referenceSet.n_rows, std::max(2 * insertedSet.n_cols,
+        numInserted + newPoints.n_cols));
+  insertedSet.cols(numInserted, numInserted + newPoints.n_cols - 1) =
+      newPoints;
+  numInserted += newPoints.n_cols;
+
+  if (!removed.empty())
+    removed.resize(NumPoints(), false);
+
+  std::vector<size_t> buckets;
+  for (size_t i = 0; i < numTables; i++)
+  {
+    HashPoints(newPoints, i, 0, newPoints.n_cols, buckets);
+    for (size_t j = 0; j < buckets.size(); j++)
+      insertedBuckets[buckets[j]].push_back(firstIndex + j);
+  }
+}
 
-  // Step VII: Condensing the 'secondHashTable'.
-  size_t maxBucketSize = 0;
-  for (size_t i = 0; i < bucketContentSize.n_elem; i++)
-    if (bucketContentSize[i] > maxBucketSize)
-      maxBucketSize = bucketContentSize[i];
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Remove(const size_t index)
+{
+  if (index >= NumPoints())
+    Log::Fatal << "LSHSearch::Remove(): there is no point " << index << "; "
+        << "there are " << NumPoints() << " points." << std::endl;
+
+  if (removed.empty())
+    removed.resize(NumPoints(), false);
+
+  if (!removed[index])
+  {
+    removed[index] = true;
+    numRemoved++;
+  }
+}
+
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Load(const std::string& filename)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    Log::Fatal << "Cannot open LSH index '" << filename << "'." << std::endl;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot read size of LSH index '" << filename << "'."
+        << std::endl;
+  }
+  bufferSize = (size_t) fileStat.st_size;
+
+  // Map the file read-only; nothing is read from disk until it is used.
+  void* map = (bufferSize == 0) ? MAP_FAILED : mmap(NULL, bufferSize,
+      PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    Log::Fatal << "Cannot map LSH index '" << filename << "'." << std::endl;
+
+  buffer = (char*) map;
+  mapped = true;
+#else
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open LSH index '" << filename << "'." << std::endl;
+
+  bufferSize = (size_t) stream.tellg();
+  buffer = new char[bufferSize];
+  stream.seekg(0);
+  stream.read(buffer, bufferSize);
+  if (!stream.good())
+    Log::Fatal << "Cannot read LSH index '" << filename << "'." << std::endl;
+#endif
+
+  // Check the header.
+  const size_t headerSize = sizeof(lshIndexMagic) + LSH_INDEX_HEADER_FIELDS *
+      sizeof(uint64_t);
+  if ((bufferSize < headerSize) ||
+      (memcmp(buffer, lshIndexMagic, sizeof(lshIndexMagic)) != 0))
+    Log::Fatal << "'" << filename << "' is not an LSH index." << std::endl;
+
+  uint64_t header[LSH_INDEX_HEADER_FIELDS];
+  memcpy(header, buffer + sizeof(lshIndexMagic), sizeof(header));
+
+  if (header[LSH_INDEX_VERSION] != 1)
+    Log::Fatal << "Unsupported LSH index version " << header[LSH_INDEX_VERSION]
+        << " in '" << filename << "'." << std::endl;
+
+  const size_t dimensionality = (size_t) header[LSH_INDEX_DIMENSIONALITY];
+  const size_t points = (size_t) header[LSH_INDEX_POINTS];
+  if ((dimensionality != referenceSet.n_rows) ||
+      (points != referenceSet.n_cols))
+    Log::Fatal << "LSH index '" << filename << "' was built on a " <<
+        dimensionality << " x " << points << " dataset, but the reference set "
+        << "is " << referenceSet.n_rows << " x " << referenceSet.n_cols << "."
+        << std::endl;
+
+  numProj = (size_t) header[LSH_INDEX_PROJECTIONS];
+  numTables = (size_t) header[LSH_INDEX_TABLES];
+  memcpy(&hashWidth, &header[LSH_INDEX_HASH_WIDTH], sizeof(double));
+  secondHashSize = (size_t) header[LSH_INDEX_SECOND_HASH_SIZE];
+  bucketSize = (size_t) header[LSH_INDEX_BUCKET_SIZE];
+  pointIdSize = (size_t) header[LSH_INDEX_POINT_ID_SIZE];
+
+  const size_t entries = (size_t) header[LSH_INDEX_ENTRIES];
+  const size_t bucketOffset = (size_t) header[LSH_INDEX_BUCKET_OFFSET];
+  const size_t contentsOffset = (size_t) header[LSH_INDEX_CONTENTS_OFFSET];
+  const size_t projectionOffset = (size_t) header[LSH_INDEX_PROJECTION_OFFSET];
+  const size_t projectionSize = (numTables * dimensionality * numProj +
+      numProj * numTables + numProj) * sizeof(double);
+
+  if ((pointIdSize != sizeof(uint32_t) && pointIdSize != sizeof(uint64_t)) ||
+      (numProj == 0) || (numTables == 0) || (secondHashSize == 0) ||
+      (bucketOffset % sizeof(uint64_t) != 0) ||
+      (contentsOffset < bucketOffset + (secondHashSize + 1) *
+          sizeof(uint64_t)) ||
+      (contentsOffset % sizeof(uint64_t) != 0) ||
+      (projectionOffset < contentsOffset + entries * pointIdSize) ||
+      (projectionOffset % sizeof(double) != 0) ||
+      (bufferSize < projectionOffset + projectionSize))
+    Log::Fatal << "LSH index '" << filename << "' is corrupt." << std::endl;
+
+  // The second hash table refers directly to the contents of the file.
+  bucketStart = (const uint64_t*) (buffer + bucketOffset);
+  bucketContents = buffer + contentsOffset;
+  if (bucketStart[secondHashSize] != entries)
+    Log::Fatal << "LSH index '" << filename << "' is corrupt." << std::endl;
+
+  // The projections are small, so they are copied.
+  const double* projectionData = (const double*) (buffer + projectionOffset);
+  projections.clear();
+  for (size_t i = 0; i < numTables; i++)
+  {
+    projections.push_back(arma::mat(projectionData, dimensionality, numProj));
+    projectionData += dimensionality * numProj;
+  }
 
-  Log::Info << "Final hash table size: (" << numRowsInTable << " x "
-            << maxBucketSize << ")" << std::endl;
-  secondHashTable.resize(numRowsInTable, maxBucketSize);
+  offsets = arma::mat(projectionData, numProj, numTables);
+  projectionData += numProj * numTables;
+
+  secondHashWeights = arma::vec(projectionData, numProj);
+
+  Log::Info << "Loaded LSH index '" << filename << "' (" << numTables
+      << " tables, " << numProj << " projections, " << entries
+      << " points in the second hash table)." << std::endl;
+}
+
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Save(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open '" << filename << "' to save LSH index."
+        << std::endl;
+
+  if (numInserted > 0 || numRemoved > 0)
+    Log::Warn << "LSHSearch::Save(): inserted and removed points are not "
+        << "saved; only the hash as it was built is." << std::endl;
+
+  const size_t entries = (size_t) bucketStart[secondHashSize];
+
+  // The second hash table starts on a page boundary, so the mapped arrays are
+  // aligned.
+  uint64_t header[LSH_INDEX_HEADER_FIELDS];
+  header[LSH_INDEX_VERSION] = 1;
+  header[LSH_INDEX_DIMENSIONALITY] = referenceSet.n_rows;
+  header[LSH_INDEX_POINTS] = referenceSet.n_cols;
+  header[LSH_INDEX_PROJECTIONS] = numProj;
+  header[LSH_INDEX_TABLES] = numTables;
+  memcpy(&header[LSH_INDEX_HASH_WIDTH], &hashWidth, sizeof(double));
+  header[LSH_INDEX_SECOND_HASH_SIZE] = secondHashSize;
+  header[LSH_INDEX_BUCKET_SIZE] = bucketSize;
+  header[LSH_INDEX_POINT_ID_SIZE] = pointIdSize;
+  header[LSH_INDEX_ENTRIES] = entries;
+  header[LSH_INDEX_BUCKET_OFFSET] = 4096;
+  header[LSH_INDEX_CONTENTS_OFFSET] = header[LSH_INDEX_BUCKET_OFFSET] +
+      (secondHashSize + 1) * sizeof(uint64_t);
+
+  // Pad the point IDs to a multiple of 8 bytes.
+  const size_t contentsSize = entries * pointIdSize;
+  const size_t contentsPadding = (sizeof(uint64_t) - contentsSize %
+      sizeof(uint64_t)) % sizeof(uint64_t);
+  header[LSH_INDEX_PROJECTION_OFFSET] = header[LSH_INDEX_CONTENTS_OFFSET] +
+      contentsSize + contentsPadding;
+
+  stream.write(lshIndexMagic, sizeof(lshIndexMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  // Pad up to the second hash table.
+  const std::vector<char> padding(header[LSH_INDEX_BUCKET_OFFSET] -
+      sizeof(lshIndexMagic) - sizeof(header), 0);
+  stream.write(&padding[0], padding.size());
+
+  stream.write((const char*) bucketStart, (secondHashSize + 1) *
+      sizeof(uint64_t));
+  if (contentsSize > 0)
+    stream.write(bucketContents, contentsSize);
+  const char zeros[sizeof(uint64_t)] = { 0 };
+  stream.write(zeros, contentsPadding);
+
+  for (size_t i = 0; i < numTables; i++)
+    stream.write((const char*) projections[i].memptr(),
+        projections[i].n_elem * sizeof(double));
+  stream.write((const char*) offsets.memptr(), offsets.n_elem *
+      sizeof(double));
+  stream.write((const char*) secondHashWeights.memptr(),
+      secondHashWeights.n_elem * sizeof(double));
+
+  if (!stream.good())
+    Log::Fatal << "Error writing LSH index to '" << filename << "'."
+        << std::endl;
 }
 
 }; // namespace neighbor
@@ -0,0 +1,253 @@
+/**
+ * @file simhash_search.cpp
+ *
+ * Implementation of SimHashSearch.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "simhash_search.hpp"
+
+#include <algorithm>
+#include <float.h>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+SimHashSearch::SimHashSearch(const arma::mat& referenceSet,
+                             const arma::mat& querySet,
+                             const size_t numBits,
+                             const size_t numTables,
+                             const size_t threads) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    numBits(numBits),
+    numTables(numTables),
+    threads(threads)
+{
+  BuildTables();
+}
+
+SimHashSearch::SimHashSearch(const arma::mat& referenceSet,
+                             const size_t numBits,
+                             const size_t numTables,
+                             const size_t threads) :
+    referenceSet(referenceSet),
+    querySet(referenceSet),
+    numBits(numBits),
+    numTables(numTables),
+    threads(threads)
+{
+  BuildTables();
+}
+
+void SimHashSearch::BuildTables()
+{
+  if (numBits == 0 || numBits > 64)
+    Log::Fatal << "SimHashSearch: the number of bits (" << numBits << ") must "
+        << "be between 1 and 64." << std::endl;
+  if (numTables == 0)
+    Log::Fatal << "SimHashSearch: there must be at least one table."
+        << std::endl;
+
+  Timer::Start("simhash_building");
+
+  // The directions only need to be uniformly distributed on the sphere, which
+  // Gaussian vectors are.
+  projections.set_size(referenceSet.n_rows, numBits * numTables);
+  math::RandNormal(projections);
+
+  const size_t n = referenceSet.n_cols;
+  referenceNorms.set_size(n);
+  referenceSignatures.resize(n * numTables);
+
+  const size_t numThreads = mlpack::Threads::Count(threads);
+
+  // The points are projected in chunks, so the projections of all the points
+  // are never held at once.
+  const size_t chunkSize = 65536;
+  const size_t numChunks = (n + chunkSize - 1) / chunkSize;
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int c = 0; c < (int) numChunks; ++c)
+  {
+    const size_t begin = c * chunkSize;
+    const size_t end = std::min(begin + chunkSize, n);
+    const arma::mat projected = trans(projections) *
+        referenceSet.cols(begin, end - 1);
+    PackSignatures(projected, &referenceSignatures[begin * numTables]);
+
+    for (size_t i = begin; i < end; ++i)
+      referenceNorms[i] = arma::norm(referenceSet.unsafe_col(i), 2);
+  }
+
+  // Each table groups the points by key, by sorting (key, point) pairs.
+  keys.assign(numTables, std::vector<uint64_t>());
+  starts.assign(numTables, std::vector<size_t>());
+  points.assign(numTables, std::vector<size_t>());
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int t = 0; t < (int) numTables; ++t)
+  {
+    std::vector<std::pair<uint64_t, size_t> > pairs(n);
+    for (size_t i = 0; i < n; ++i)
+      pairs[i] = std::make_pair(referenceSignatures[i * numTables + t], i);
+    std::sort(pairs.begin(), pairs.end());
+
+    points[t].resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (i == 0 || pairs[i].first != pairs[i - 1].first)
+      {
+        keys[t].push_back(pairs[i].first);
+        starts[t].push_back(i);
+      }
+      points[t][i] = pairs[i].second;
+    }
+    starts[t].push_back(n);
+  }
+
+  Timer::Stop("simhash_building");
+
+  size_t numBuckets = 0;
+  for (size_t t = 0; t < numTables; ++t)
+    numBuckets += keys[t].size();
+  Log::Info << "SimHash tables built: " << numBuckets << " buckets in "
+      << numTables << " tables." << std::endl;
+}
+
+void SimHashSearch::PackSignatures(const arma::mat& projected,
+                                   uint64_t* signatures) const
+{
+  for (size_t i = 0; i < projected.n_cols; ++i)
+  {
+    const double* column = projected.colptr(i);
+    for (size_t t = 0; t < numTables; ++t)
+    {
+      uint64_t word = 0;
+      for (size_t b = 0; b < numBits; ++b)
+        if (column[t * numBits + b] >= 0.0)
+          word |= ((uint64_t) 1 << b);
+
+      signatures[i * numTables + t] = word;
+    }
+  }
+}
+
+void SimHashSearch::Signature(const arma::vec& point, uint64_t* signature)
+    const
+{
+  const arma::mat projected = trans(projections) * point;
+  PackSignatures(projected, signature);
+}
+
+void SimHashSearch::Search(const size_t k,
+                           arma::Mat<size_t>& neighbors,
+                           arma::mat& similarities,
+                           const size_t rerank)
+{
+  Timer::Start("computing_neighbors");
+
+  const size_t n = referenceSet.n_cols;
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(n);
+  similarities.set_size(k, querySet.n_cols);
+  similarities.fill(-DBL_MAX);
+
+  const bool sameSet = (&querySet == &referenceSet);
+  size_t totalCandidates = 0;
+
+  #pragma omp parallel num_threads(mlpack::Threads::Count(threads)) \
+      reduction(+:totalCandidates)
+  {
+    // Each thread marks the candidates it has seen for the current query.
+    std::vector<char> seen(n, 0);
+    std::vector<uint64_t> signature(numTables);
+    std::vector<size_t> candidates;
+    std::vector<std::pair<size_t, size_t> > hamming;
+    std::vector<std::pair<double, size_t> > results;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (int q = 0; q < (int) querySet.n_cols; ++q)
+    {
+      Signature(querySet.unsafe_col(q), &signature[0]);
+
+      // Collect the points which share a key with the query.
+      candidates.clear();
+      for (size_t t = 0; t < numTables; ++t)
+      {
+        const std::vector<uint64_t>::const_iterator it = std::lower_bound(
+            keys[t].begin(), keys[t].end(), signature[t]);
+        if (it == keys[t].end() || *it != signature[t])
+          continue;
+
+        const size_t bucket = it - keys[t].begin();
+        for (size_t j = starts[t][bucket]; j < starts[t][bucket + 1]; ++j)
+        {
+          const size_t point = points[t][j];
+          if (!seen[point] && !(sameSet && point == (size_t) q))
+          {
+            seen[point] = 1;
+            candidates.push_back(point);
+          }
+        }
+      }
+
+      for (size_t j = 0; j < candidates.size(); ++j)
+        seen[candidates[j]] = 0;
+      totalCandidates += candidates.size();
+
+      // Keep the candidates with the smallest Hamming distance.
+      if (rerank > 0 && candidates.size() > rerank)
+      {
+        hamming.resize(candidates.size());
+        for (size_t j = 0; j < candidates.size(); ++j)
+          hamming[j] = std::make_pair(math::HammingDistance(&signature[0],
+              ReferenceSignature(candidates[j]), numTables), candidates[j]);
+        std::nth_element(hamming.begin(), hamming.begin() + rerank,
+            hamming.end());
+
+        candidates.resize(rerank);
+        for (size_t j = 0; j < rerank; ++j)
+          candidates[j] = hamming[j].second;
+      }
+
+      // Rank the remaining candidates by their exact cosine similarity.
+      const double queryNorm = arma::norm(querySet.unsafe_col(q), 2);
+      results.resize(candidates.size());
+      for (size_t j = 0; j < candidates.size(); ++j)
+      {
+        const double denominator = queryNorm * referenceNorms[candidates[j]];
+        const double similarity = (denominator == 0.0) ? 0.0 :
+            arma::dot(querySet.unsafe_col(q),
+            referenceSet.unsafe_col(candidates[j])) / denominator;
+        // Negated, so that the largest similarities sort first.
+        results[j] = std::make_pair(-similarity, candidates[j]);
+      }
+
+      const size_t found = std::min(k, results.size());
+      std::partial_sort(results.begin(), results.begin() + found,
+          results.end());
+      for (size_t j = 0; j < found; ++j)
+      {
+        neighbors(j, q) = results[j].second;
+        similarities(j, q) = -results[j].first;
+      }
+    }
+  }
+
+  Timer::Stop("computing_neighbors");
+
+  Log::Info << totalCandidates / std::max(querySet.n_cols, (arma::uword) 1)
+      << " candidates per query on average." << std::endl;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file simhash_search.hpp
+ *
+ * Approximate nearest-neighbor search under cosine similarity with
+ * sign-random-projection (SimHash) locality-sensitive hashing.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_LSH_SIMHASH_SEARCH_HPP
+#define __MLPACK_METHODS_LSH_SIMHASH_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * SimHashSearch finds the reference points with the largest cosine similarity
+ * to each query point, with the sign-random-projection family of
+ * locality-sensitive hash functions (Charikar, 2002).  Each of the tables
+ * draws numBits random Gaussian directions, and the key of a point in a table
+ * is the bit signature of the signs of its projections onto them, packed into
+ * a 64-bit integer; two points get the same bit with probability
+ * 1 - angle / pi.  So, unlike LSHSearch (the p-stable scheme for the
+ * Euclidean distance), there is no hash width, and the buckets of a table are
+ * looked up by integer key.
+ *
+ * The candidates of a query are the points which share its key in any table.
+ * The signatures of the reference points in all tables are kept (numTables
+ * words per point, which is far smaller than the projections), so the
+ * candidates can first be ranked by the Hamming distance between their
+ * signatures and that of the query, which is a few popcounts; only the best
+ * of them (see the rerank parameter of Search()) are then ranked by their exact
+ * cosine similarity.
+ *
+ * @code
+ * @inproceedings{charikar2002similarity,
+ *   title={Similarity Estimation Techniques from Rounding Algorithms},
+ *   author={Charikar, M.S.},
+ *   booktitle={Proceedings of the 34th Annual ACM Symposium on Theory of
+ *       Computing},
+ *   pages={380--388},
+ *   year={2002}
+ * }
+ * @endcode
+ */
+class SimHashSearch
+{
+ public:
+  /**
+   * Build the tables on the reference set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param numBits Number of bits of the key of each table (at most 64).
+   * @param numTables Number of tables.
+   * @param threads Number of threads to build the tables and search with (0
+   *     uses all cores).
+   */
+  SimHashSearch(const arma::mat& referenceSet,
+                const arma::mat& querySet,
+                const size_t numBits,
+                const size_t numTables,
+                const size_t threads = 1);
+
+  /**
+   * Build the tables on the reference set, which is also the set of queries.
+   *
+   * @param referenceSet Set of reference points and of query points.
+   * @param numBits Number of bits of the key of each table (at most 64).
+   * @param numTables Number of tables.
+   * @param threads Number of threads to build the tables and search with (0
+   *     uses all cores).
+   */
+  SimHashSearch(const arma::mat& referenceSet,
+                const size_t numBits,
+                const size_t numTables,
+                const size_t threads = 1);
+
+  /**
+   * Find the k reference points with the largest cosine similarity to each
+   * query point, among its candidates.  The results are sorted by decreasing
+   * similarity; if a query point has fewer than k candidates, the missing
+   * neighbors have the index referenceSet.n_cols and the similarity -DBL_MAX.
+   *
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the indices of the neighbors in (k x
+   *     number of query points).
+   * @param similarities Matrix to store the cosine similarities in.
+   * @param rerank Number of candidates, of smallest Hamming distance, whose
+   *     exact similarity is computed (0 means all of them).
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& similarities,
+              const size_t rerank = 0);
+
+  /**
+   * Compute the signature of the given point: one word in each table.
+   *
+   * @param point Point to compute the signature of.
+   * @param signature Memory to store the numTables words of the signature in.
+   */
+  void Signature(const arma::vec& point, uint64_t* signature) const;
+
+  //! Get the number of bits of each key.
+  size_t NumBits() const { return numBits; }
+  //! Get the number of tables.
+  size_t NumTables() const { return numTables; }
+
+  //! Get the random directions (numBits columns for each table, one after
+  //! another).
+  const arma::mat& Projections() const { return projections; }
+
+  //! Get the signature of the given reference point (NumTables() words).
+  const uint64_t* ReferenceSignature(const size_t index) const
+  { return &referenceSignatures[index * numTables]; }
+
+  //! Get the number of threads used by Search().
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used by Search() (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! Reference dataset.
+  const arma::mat& referenceSet;
+  //! Query dataset.
+  const arma::mat& querySet;
+
+  //! The number of bits of each key.
+  size_t numBits;
+  //! The number of tables.
+  size_t numTables;
+  //! The number of threads.
+  size_t threads;
+
+  //! The random directions, numBits columns per table.
+  arma::mat projections;
+  //! The norm of each reference point.
+  arma::vec referenceNorms;
+
+  //! The signatures of the reference points, numTables words per point.
+  std::vector<uint64_t> referenceSignatures;
+
+  //! The distinct keys of each table, in increasing order.
+  std::vector<std::vector<uint64_t> > keys;
+  //! The points with key keys[t][i] are points[t][starts[t][i]] to
+  //! points[t][starts[t][i + 1] - 1].
+  std::vector<std::vector<size_t> > starts;
+  //! The points of each table, grouped by key.
+  std::vector<std::vector<size_t> > points;
+
+  //! Draw the projections, compute the signatures, and build the tables.
+  void BuildTables();
+
+  /**
+   * Compute the signatures of the given points from their projections.
+   *
+   * @param projected Projections of the points, one column per point.
+   * @param signatures Memory to store the numTables words of each point in.
+   */
+  void PackSignatures(const arma::mat& projected, uint64_t* signatures) const;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
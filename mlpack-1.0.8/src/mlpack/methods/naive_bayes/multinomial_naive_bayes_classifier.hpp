@@ -0,0 +1,168 @@
+/**
+ * @file multinomial_naive_bayes_classifier.hpp
+ *
+ * A Naive Bayes classifier for count data (such as the word counts of
+ * documents), with a multinomial distribution for each class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NAIVE_BAYES_MULTINOMIAL_NAIVE_BAYES_CLASSIFIER_HPP
+#define __MLPACK_METHODS_NAIVE_BAYES_MULTINOMIAL_NAIVE_BAYES_CLASSIFIER_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace naive_bayes {
+
+/**
+ * The multinomial Naive Bayes classifier, for count data such as the word
+ * counts of documents.  Each class has a distribution over the features, and
+ * the probability of a point x under class y_j is proportional to
+ *
+ *   prod_d P(feature d | Y = y_j)^(x_d).
+ *
+ * The feature probabilities are estimated from the total counts of each feature
+ * in each class, with additive (Laplace) smoothing alpha.  In log space the
+ * log-likelihoods of all the points are one matrix product with the log
+ * feature probabilities, so when the data is sparse, the cost of
+ * classification is proportional to the number of nonzero counts.
+ *
+ * Like NaiveBayesClassifier, the model can be trained incrementally with
+ * Train(), one batch of points at a time.
+ *
+ * @code
+ * extern arma::sp_mat wordCounts; // One document per column.
+ * extern arma::Col<size_t> labels;
+ *
+ * MultinomialNaiveBayesClassifier<> nbc(wordCounts, labels, classes);
+ * arma::Col<size_t> results;
+ * nbc.Classify(testCounts, results);
+ * @endcode
+ *
+ * @tparam MatType Type of data matrix (arma::sp_mat or arma::mat).
+ */
+template<typename MatType = arma::sp_mat>
+class MultinomialNaiveBayesClassifier
+{
+ public:
+  /**
+   * Train the classifier on the given points and labels.
+   *
+   * @param data Training data points (nonnegative counts).
+   * @param labels Labels corresponding to training data points.
+   * @param classes Number of classes in this classifier.
+   * @param alpha Additive smoothing of the feature counts.
+   */
+  MultinomialNaiveBayesClassifier(const MatType& data,
+                                  const arma::Col<size_t>& labels,
+                                  const size_t classes,
+                                  const double alpha = 1.0);
+
+  /**
+   * Initialize an untrained classifier for the given dimensionality and number
+   * of classes; it can then be trained with Train().
+   *
+   * @param dimensionality Number of features.
+   * @param classes Number of classes in this classifier.
+   * @param alpha Additive smoothing of the feature counts.
+   */
+  MultinomialNaiveBayesClassifier(const size_t dimensionality = 0,
+                                  const size_t classes = 0,
+                                  const double alpha = 1.0);
+
+  /**
+   * Update the model with a batch of labeled points, as if they had been part
+   * of the training data from the start.
+   *
+   * @param data Batch of training data points (nonnegative counts).
+   * @param labels Labels corresponding to the batch.
+   */
+  void Train(const MatType& data, const arma::Col<size_t>& labels);
+
+  /**
+   * Predict the class of each of the given points.
+   *
+   * @param data List of data points.
+   * @param results Vector that class predictions will be placed into.
+   */
+  void Classify(const MatType& data, arma::Col<size_t>& results) const;
+
+  /**
+   * Compute the log of the joint probability of each class and each of the
+   * given points (up to a constant for each point), as a matrix with one row
+   * for each class and one column for each point.
+   *
+   * @param data List of data points.
+   * @param logLikelihoods Matrix (classes x points) to store results into.
+   */
+  void LogLikelihoods(const MatType& data, arma::mat& logLikelihoods) const;
+
+  //! Get the total count of each feature in each class (dimensionality x
+  //! classes).
+  const arma::mat& FeatureCounts() const { return featureCounts; }
+  //! Get the log probabilities of each feature in each class (classes x
+  //! dimensionality).
+  const arma::mat& LogFeatureProbabilities() const
+  { return logFeatureProbabilities; }
+
+  //! Get the number of training points seen in each class.
+  const arma::vec& Counts() const { return counts; }
+  //! Get the prior probabilities for each class.
+  const arma::vec& Probabilities() const { return probabilities; }
+
+  //! Get the additive smoothing of the feature counts.
+  double Alpha() const { return alpha; }
+
+ private:
+  //! Total count of each feature in each class.
+  arma::mat featureCounts;
+  //! Log probability of each feature in each class (transposed, so that the
+  //! features of a class are contiguous for sparse points).
+  arma::mat logFeatureProbabilities;
+  //! Number of training points seen in each class.
+  arma::vec counts;
+  //! Class probabilities.
+  arma::vec probabilities;
+  //! Additive smoothing of the feature counts.
+  double alpha;
+
+  //! Recompute the probabilities from the counts.
+  void UpdateProbabilities();
+
+  //! Add the counts of a dense point to the given counts.
+  static void AddPoint(const arma::mat& data,
+                       const size_t point,
+                       double* pointCounts);
+  //! Add the counts of a sparse point to the given counts.
+  static void AddPoint(const arma::sp_mat& data,
+                       const size_t point,
+                       double* pointCounts);
+
+  //! Compute the log-likelihoods of dense points.
+  void ComputeLogLikelihoods(const arma::mat& data,
+                             arma::mat& logLikelihoods) const;
+  //! Compute the log-likelihoods of sparse points, one nonzero at a time.
+  void ComputeLogLikelihoods(const arma::sp_mat& data,
+                             arma::mat& logLikelihoods) const;
+};
+
+}; // namespace naive_bayes
+}; // namespace mlpack
+
+// Include implementation.
+#include "multinomial_naive_bayes_classifier_impl.hpp"
+
+#endif
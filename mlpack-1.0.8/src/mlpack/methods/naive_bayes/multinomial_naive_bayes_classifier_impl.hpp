@@ -0,0 +1,211 @@
+/**
+ * @file multinomial_naive_bayes_classifier_impl.hpp
+ *
+ * Implementation of the MultinomialNaiveBayesClassifier class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NAIVE_BAYES_MULTINOMIAL_NAIVE_BAYES_CLASSIFIER_IMPL_HPP
+#define __MLPACK_METHODS_NAIVE_BAYES_MULTINOMIAL_NAIVE_BAYES_CLASSIFIER_IMPL_HPP
+
+// In case it hasn't been included already.
+#include "multinomial_naive_bayes_classifier.hpp"
+
+namespace mlpack {
+namespace naive_bayes {
+
+template<typename MatType>
+MultinomialNaiveBayesClassifier<MatType>::MultinomialNaiveBayesClassifier(
+    const MatType& data,
+    const arma::Col<size_t>& labels,
+    const size_t classes,
+    const double alpha) :
+    featureCounts(arma::zeros<arma::mat>(data.n_rows, classes)),
+    counts(arma::zeros<arma::vec>(classes)),
+    alpha(alpha)
+{
+  Train(data, labels);
+}
+
+template<typename MatType>
+MultinomialNaiveBayesClassifier<MatType>::MultinomialNaiveBayesClassifier(
+    const size_t dimensionality,
+    const size_t classes,
+    const double alpha) :
+    featureCounts(arma::zeros<arma::mat>(dimensionality, classes)),
+    counts(arma::zeros<arma::vec>(classes)),
+    alpha(alpha)
+{
+  UpdateProbabilities();
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::Train(
+    const MatType& data,
+    const arma::Col<size_t>& labels)
+{
+  if (data.n_rows != featureCounts.n_rows)
+    Log::Fatal << "MultinomialNaiveBayesClassifier::Train(): dimensionality "
+        << "of data (" << data.n_rows << ") does not match model ("
+        << featureCounts.n_rows << ")!" << std::endl;
+
+  if (labels.n_elem != data.n_cols)
+    Log::Fatal << "MultinomialNaiveBayesClassifier::Train(): number of labels"
+        << " (" << labels.n_elem << ") does not match number of points ("
+        << data.n_cols << ")!" << std::endl;
+
+  Log::Info << "Training multinomial Naive Bayes classifier on " << data.n_cols
+      << " examples with " << data.n_rows << " features each." << std::endl;
+
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    const size_t label = labels[j];
+    if (label >= counts.n_elem)
+      Log::Fatal << "MultinomialNaiveBayesClassifier::Train(): label " << label
+          << " of point " << j << " is not less than the number of classes ("
+          << counts.n_elem << ")!" << std::endl;
+
+    ++counts[label];
+    AddPoint(data, j, featureCounts.colptr(label));
+  }
+
+  UpdateProbabilities();
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::Classify(
+    const MatType& data,
+    arma::Col<size_t>& results) const
+{
+  results.zeros(data.n_cols);
+
+  Log::Info << "Running multinomial Naive Bayes classifier on " << data.n_cols
+      << " data points with " << data.n_rows << " features each." << std::endl;
+
+  // Work on blocks of points, so the joint probabilities of all the points are
+  // never held at once.
+  const size_t blockSize = 1024;
+  arma::mat logLikelihoods;
+  for (size_t begin = 0; begin < data.n_cols; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize, (size_t) data.n_cols) - 1;
+    const MatType block = data.cols(begin, end);
+    LogLikelihoods(block, logLikelihoods);
+
+    for (size_t n = 0; n < logLikelihoods.n_cols; ++n)
+    {
+      arma::uword maxIndex = 0;
+      logLikelihoods.col(n).max(maxIndex);
+      results[begin + n] = maxIndex;
+    }
+  }
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::LogLikelihoods(
+    const MatType& data,
+    arma::mat& logLikelihoods) const
+{
+  Log::Assert(data.n_rows == featureCounts.n_rows);
+
+  ComputeLogLikelihoods(data, logLikelihoods);
+
+  // Add the log priors; classes without points can never be predicted.
+  for (size_t i = 0; i < counts.n_elem; ++i)
+  {
+    if (probabilities[i] == 0)
+      logLikelihoods.row(i).fill(-std::numeric_limits<double>::infinity());
+    else
+      logLikelihoods.row(i) += log(probabilities[i]);
+  }
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::UpdateProbabilities()
+{
+  const double totalCount = arma::accu(counts);
+  if (totalCount > 0)
+    probabilities = counts / totalCount;
+  else
+    probabilities.zeros(counts.n_elem);
+
+  // The smoothed log probability of each feature in each class.
+  logFeatureProbabilities.set_size(featureCounts.n_cols, featureCounts.n_rows);
+  for (size_t i = 0; i < featureCounts.n_cols; ++i)
+  {
+    const double total = arma::accu(featureCounts.col(i)) +
+        alpha * featureCounts.n_rows;
+    logFeatureProbabilities.row(i) = trans(arma::log(
+        (featureCounts.col(i) + alpha) / total));
+  }
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::AddPoint(
+    const arma::mat& data,
+    const size_t point,
+    double* pointCounts)
+{
+  const double* column = data.colptr(point);
+  for (size_t d = 0; d < data.n_rows; ++d)
+    pointCounts[d] += column[d];
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::AddPoint(
+    const arma::sp_mat& data,
+    const size_t point,
+    double* pointCounts)
+{
+  for (arma::sp_mat::const_iterator it = data.begin_col(point);
+      it != data.end_col(point); ++it)
+    pointCounts[it.row()] += (*it);
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::ComputeLogLikelihoods(
+    const arma::mat& data,
+    arma::mat& logLikelihoods) const
+{
+  logLikelihoods = logFeatureProbabilities * data;
+}
+
+template<typename MatType>
+void MultinomialNaiveBayesClassifier<MatType>::ComputeLogLikelihoods(
+    const arma::sp_mat& data,
+    arma::mat& logLikelihoods) const
+{
+  // Each nonzero count adds a multiple of one column of the (transposed) log
+  // feature probabilities.
+  logLikelihoods.zeros(logFeatureProbabilities.n_rows, data.n_cols);
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    double* scores = logLikelihoods.colptr(j);
+    for (arma::sp_mat::const_iterator it = data.begin_col(j);
+        it != data.end_col(j); ++it)
+    {
+      const double* logProbabilities = logFeatureProbabilities.colptr(
+          it.row());
+      for (size_t i = 0; i < logFeatureProbabilities.n_rows; ++i)
+        scores[i] += (*it) * logProbabilities[i];
+    }
+  }
+}
+
+}; // namespace naive_bayes
+}; // namespace mlpack
+
+#endif
@@ -53,6 +53,21 @@ namespace naive_bayes /** The Naive Bayes Classifier. */ {
  *
  * nbc.Classify(testing_data, results);
  * @endcode
+ *
+ * Classification is done in log space, for blocks of points at a time (see
+ * LogLikelihoods()).  For count data (such as word counts of documents), see
+ * MultinomialNaiveBayesClassifier.
+ *
+ * The model can also be trained incrementally, one batch of points at a time,
+ * with Train(); the running means and variances of each class are updated with
+ * Welford's method, so the batches never need to be held in memory at once and
+ * the result is the same as training on all the points together.
+ *
+ * @code
+ * NaiveBayesClassifier<> nbc(dimensionality, classes);
+ * while (ReadNextChunk(batch, batchLabels)) // Read from disk, for instance.
+ *   nbc.Train(batch, batchLabels);
+ * @endcode
  */
 template<typename MatType = arma::mat>
 class NaiveBayesClassifier
@@ -67,6 +82,9 @@ class NaiveBayesClassifier
   //! Class probabilities.
   arma::vec probabilities;
 
+  //! Number of training points seen in each class.
+  arma::vec counts;
+
  public:
   /**
    * Initializes the classifier as per the input and then trains it by
@@ -89,6 +107,27 @@ class NaiveBayesClassifier
                        const arma::Col<size_t>& labels,
                        const size_t classes);
 
+  /**
+   * Initialize an untrained classifier for the given dimensionality and number
+   * of classes; it can then be trained with Train().
+   *
+   * @param dimensionality Dimensionality of the data points.
+   * @param classes Number of classes in this classifier.
+   */
+  NaiveBayesClassifier(const size_t dimensionality = 0,
+                       const size_t classes = 0);
+
+  /**
+   * Update the model with a batch of labeled points.  The means, variances and
+   * class probabilities are updated as if the batch had been part of the
+   * training data from the start; the points already trained on are not
+   * needed.  The labels must be less than the number of classes.
+   *
+   * @param data Batch of training data points.
+   * @param labels Labels corresponding to the batch.
+   */
+  void Train(const MatType& data, const arma::Col<size_t>& labels);
+
   /**
    * Given a bunch of data points, this function evaluates the class of each of
    * those data points, and puts it in the vector 'results'.
@@ -97,13 +136,25 @@ class NaiveBayesClassifier
    * arma::mat test_data; // each column is a test point
    * arma::Col<size_t> results;
    * ...
-   * nbc.Classify(test_data, &results);
+   * nbc.Classify(test_data, results);
    * @endcode
    *
    * @param data List of data points.
    * @param results Vector that class predictions will be placed into.
    */
-  void Classify(const MatType& data, arma::Col<size_t>& results);
+  void Classify(const MatType& data, arma::Col<size_t>& results) const;
+
+  /**
+   * Compute the log of the joint probability of each class and each of the
+   * given points, log P(Y = y_j) + log P(X = x | Y = y_j), as a matrix with one
+   * row for each class and one column for each point.  This is computed with a
+   * few matrix products from the inverse variances and the log normalizers of
+   * each class, so no transcendental functions are evaluated per point.
+   *
+   * @param data List of data points.
+   * @param logLikelihoods Matrix (classes x points) to store results into.
+   */
+  void LogLikelihoods(const MatType& data, arma::mat& logLikelihoods) const;
 
   //! Get the sample means for each class.
   const MatType& Means() const { return means; }
@@ -119,6 +170,9 @@ class NaiveBayesClassifier
   const arma::vec& Probabilities() const { return probabilities; }
   //! Modify the prior probabilities for each class.
   arma::vec& Probabilities() { return probabilities; }
+
+  //! Get the number of training points seen in each class.
+  const arma::vec& Counts() const { return counts; }
 };
 
 }; // namespace naive_bayes
@@ -38,84 +38,143 @@ NaiveBayesClassifier<MatType>::NaiveBayesClassifier(
     const arma::Col<size_t>& labels,
     const size_t classes)
 {
-  size_t dimensionality = data.n_rows;
-
   // Update the variables according to the number of features and classes
   // present in the data.
   probabilities.zeros(classes);
+  counts.zeros(classes);
+  means.zeros(data.n_rows, classes);
+  variances.zeros(data.n_rows, classes);
+
+  Train(data, labels);
+}
+
+template<typename MatType>
+NaiveBayesClassifier<MatType>::NaiveBayesClassifier(
+    const size_t dimensionality,
+    const size_t classes)
+{
+  probabilities.zeros(classes);
+  counts.zeros(classes);
   means.zeros(dimensionality, classes);
   variances.zeros(dimensionality, classes);
+}
+
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::Train(const MatType& data,
+                                          const arma::Col<size_t>& labels)
+{
+  if (data.n_rows != means.n_rows)
+    Log::Fatal << "NaiveBayesClassifier::Train(): dimensionality of data ("
+        << data.n_rows << ") does not match model (" << means.n_rows << ")!"
+        << std::endl;
+
+  if (labels.n_elem != data.n_cols)
+    Log::Fatal << "NaiveBayesClassifier::Train(): number of labels ("
+        << labels.n_elem << ") does not match number of points ("
+        << data.n_cols << ")!" << std::endl;
 
   Log::Info << "Training Naive Bayes classifier on " << data.n_cols
-      << " examples with " << dimensionality << " features each." << std::endl;
+      << " examples with " << data.n_rows << " features each." << std::endl;
+
+  // Hold the sums of squared differences from the means while updating.
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    variances.col(i) *= (counts[i] > 1) ? (counts[i] - 1) : 0;
 
-  // Calculate the class probabilities as well as the sample mean and variance
-  // for each of the features with respect to each of the labels.
+  // Welford's update of the running mean and variance of each class, one
+  // point at a time.
   for (size_t j = 0; j < data.n_cols; ++j)
   {
     const size_t label = labels[j];
-    ++probabilities[label];
-
-    means.col(label) += data.col(j);
-    variances.col(label) += square(data.col(j));
-  }
+    if (label >= counts.n_elem)
+      Log::Fatal << "NaiveBayesClassifier::Train(): label " << label << " of "
+          << "point " << j << " is not less than the number of classes ("
+          << counts.n_elem << ")!" << std::endl;
 
-  for (size_t i = 0; i < classes; ++i)
-  {
-    if (probabilities[i] != 0)
+    ++counts[label];
+    for (size_t d = 0; d < data.n_rows; ++d)
     {
-      variances.col(i) -= (square(means.col(i)) / probabilities[i]);
-      means.col(i) /= probabilities[i];
-      variances.col(i) /= (probabilities[i] - 1);
+      const double delta = data(d, j) - means(d, label);
+      means(d, label) += delta / counts[label];
+      variances(d, label) += delta * (data(d, j) - means(d, label));
     }
   }
 
-  probabilities /= data.n_cols;
+  // Turn the sums back into sample variances.
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    if (counts[i] > 1)
+      variances.col(i) /= (counts[i] - 1);
+
+  const double totalCount = arma::accu(counts);
+  if (totalCount > 0)
+    probabilities = counts / totalCount;
 }
 
 template<typename MatType>
 void NaiveBayesClassifier<MatType>::Classify(const MatType& data,
                                              arma::Col<size_t>& results)
+    const
 {
   // Check that the number of features in the test data is same as in the
   // training data.
   Log::Assert(data.n_rows == means.n_rows);
 
-  arma::vec probs(means.n_cols);
-
   results.zeros(data.n_cols);
 
   Log::Info << "Running Naive Bayes classifier on " << data.n_cols
       << " data points with " << data.n_rows << " features each." << std::endl;
 
-  // Calculate the joint probability for each of the data points for each of the
-  // means.n_cols.
-
-  // Loop over every test case.
-  for (size_t n = 0; n < data.n_cols; n++)
+  // Work on blocks of points, so the joint probabilities of all the points are
+  // never held at once.
+  const size_t blockSize = 1024;
+  arma::mat logLikelihoods;
+  for (size_t begin = 0; begin < data.n_cols; begin += blockSize)
   {
-    // Loop over every class.
-    for (size_t i = 0; i < means.n_cols; i++)
+    const size_t end = std::min(begin + blockSize, (size_t) data.n_cols) - 1;
+    LogLikelihoods(data.cols(begin, end), logLikelihoods);
+
+    // Find the most probable class of each point.
+    for (size_t n = 0; n < logLikelihoods.n_cols; ++n)
     {
-      // Use the log values to prevent floating point underflow.
-      probs(i) = log(probabilities(i));
-
-      // Loop over every feature, but avoid inverting empty matrices.
-      if (probabilities[i] != 0)
-      {
-        probs(i) += log(gmm::phi(data.unsafe_col(n), means.unsafe_col(i),
-            diagmat(variances.unsafe_col(i))));
-      }
+      arma::uword maxIndex = 0;
+      logLikelihoods.col(n).max(maxIndex);
+      results[begin + n] = maxIndex;
     }
+  }
+}
 
-    // Find the index of the maximum value in tmp_vals.
-    arma::uword maxIndex = 0;
-    probs.max(maxIndex);
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::LogLikelihoods(
+    const MatType& data,
+    arma::mat& logLikelihoods) const
+{
+  Log::Assert(data.n_rows == means.n_rows);
 
-    results[n] = maxIndex;
+  // With diagonal Gaussians, the log-likelihood of x under class j is
+  //   -0.5 * sum_d (log(2 pi var_dj) + (x_d - mean_dj)^2 / var_dj),
+  // and the square expands into terms with x_d^2, x_d, and a constant, so the
+  // log-likelihoods of all the points are two matrix products.
+  arma::mat inverseVariances(means.n_rows, means.n_cols);
+  arma::vec constants(means.n_cols);
+  for (size_t i = 0; i < means.n_cols; ++i)
+  {
+    if (probabilities[i] == 0)
+    {
+      // This class can never be predicted; avoid inverting empty variances.
+      inverseVariances.col(i).zeros();
+      constants[i] = -std::numeric_limits<double>::infinity();
+    }
+    else
+    {
+      inverseVariances.col(i) = 1.0 / variances.col(i);
+      constants[i] = log(probabilities[i]) - 0.5 * (means.n_rows *
+          log(2.0 * M_PI) + arma::accu(arma::log(variances.col(i))) +
+          arma::dot(arma::square(means.col(i)), inverseVariances.col(i)));
+    }
   }
 
-  return;
+  logLikelihoods = trans(means % inverseVariances) * data -
+      0.5 * trans(inverseVariances) * arma::square(data);
+  logLikelihoods.each_col() += constants;
 }
 
 }; // namespace naive_bayes
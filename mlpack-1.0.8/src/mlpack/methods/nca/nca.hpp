@@ -79,8 +79,9 @@ class NCA
   /**
    * Perform Neighborhood Components Analysis.  The output distance learning
    * matrix is written into the passed reference.  If LearnDistance() is called
-   * with an outputMatrix which has the correct size (dataset.n_rows x
-   * dataset.n_rows), that matrix will be used as the starting point for
+   * with an outputMatrix which has the correct size (OutputDimensionality() x
+   * dataset.n_rows, or dataset.n_rows x dataset.n_rows if no output
+   * dimensionality is set), that matrix will be used as the starting point for
    * optimization.
    *
    * @param output_matrix Covariance matrix of Mahalanobis distance.
@@ -92,6 +93,24 @@ class NCA
   //! Get the labels reference.
   const arma::Col<size_t>& Labels() const { return labels; }
 
+  //! Get the number of dimensions the learned matrix projects to (0 means the
+  //! dimensionality of the dataset).
+  size_t OutputDimensionality() const
+  { return errorFunction.OutputDimensionality(); }
+  //! Modify the number of dimensions the learned matrix projects to.  With d
+  //! less than the dimensionality D of the dataset, a d x D matrix is learned,
+  //! which is cheaper to optimize and gives a d-dimensional space to search in
+  //! (0 means D).
+  size_t& OutputDimensionality()
+  { return errorFunction.OutputDimensionality(); }
+
+  //! Get the objective function.
+  const SoftmaxErrorFunction<MetricType>& ErrorFunction() const
+  { return errorFunction; }
+  //! Modify the objective function (for instance, to set a cutoff or the
+  //! number of threads).
+  SoftmaxErrorFunction<MetricType>& ErrorFunction() { return errorFunction; }
+
   //! Get the optimizer.
   const OptimizerType<SoftmaxErrorFunction<MetricType> >& Optimizer() const
   { return optimizer; }
@@ -43,10 +43,17 @@ NCA<MetricType, OptimizerType>::NCA(const arma::mat& dataset,
 template<typename MetricType, template<typename> class OptimizerType>
 void NCA<MetricType, OptimizerType>::LearnDistance(arma::mat& outputMatrix)
 {
+  if (errorFunction.OutputDimensionality() > dataset.n_rows)
+    Log::Fatal << "NCA::LearnDistance(): the output dimensionality ("
+        << errorFunction.OutputDimensionality() << ") must be at most the "
+        << "dimensionality of the dataset (" << dataset.n_rows << ")!"
+        << std::endl;
+
   // See if we were passed an initialized matrix.
-  if ((outputMatrix.n_rows != dataset.n_rows) ||
-      (outputMatrix.n_cols != dataset.n_rows))
-    outputMatrix.eye(dataset.n_rows, dataset.n_rows);
+  const arma::mat initialPoint = errorFunction.GetInitialPoint();
+  if ((outputMatrix.n_rows != initialPoint.n_rows) ||
+      (outputMatrix.n_cols != initialPoint.n_cols))
+    outputMatrix = initialPoint;
 
   Timer::Start("nca_sgd_optimization");
 
@@ -61,7 +61,9 @@ PROGRAM_INFO("Neighborhood Components Analysis (NCA)",
     "the tolerance (--tolerance) to define the maximum allowed difference "
     "between objectives for SGD to terminate.  Be careful -- setting the "
     "tolerance instead of the maximum iterations can take a very long time and "
-    "may actually never converge due to the properties of the SGD optimizer.\n"
+    "may actually never converge due to the properties of the SGD optimizer.  "
+    "Each step of SGD can also use the gradient of a mini-batch of points "
+    "(--batch_size) instead of a single point.\n"
     "\n"
     "The L-BFGS optimizer, specified by --optimizer \"lbfgs\", uses a "
     "back-tracking line search algorithm to minimize a function.  The "
@@ -74,6 +76,19 @@ PROGRAM_INFO("Neighborhood Components Analysis (NCA)",
     "documentation (in lbfgs.hpp) or the vast set of published literature on "
     "L-BFGS.\n"
     "\n"
+    "L-BFGS evaluates the objective function over all pairs of points, which "
+    "takes O(n^2) time for each evaluation.  For large datasets, a cutoff "
+    "(--cutoff) can be given: only pairs of points which are at most that far "
+    "apart in the stretched space are then considered, and they are found with "
+    "a kd-tree.  The pairs can also be split between several threads "
+    "(--threads).\n"
+    "\n"
+    "By default, the learned matrix is square.  If --output_dimensionality "
+    "(-d) is given, a matrix with that many rows is learned instead, which "
+    "projects the points to that many dimensions; this is cheaper to optimize "
+    "when the number of rows is much smaller than the dimensionality of the "
+    "data.\n"
+    "\n"
     "By default, the SGD optimizer is used.");
 
 PARAM_STRING_REQ("input_file", "Input dataset to run NCA on.", "i");
@@ -95,6 +110,7 @@ PARAM_DOUBLE("step_size", "Step size for stochastic gradient descent (alpha).",
     "a", 0.01);
 PARAM_FLAG("linear_scan", "Don't shuffle the order in which data points are "
     "visited for SGD.", "L");
+PARAM_INT("batch_size", "Number of points in each mini-batch of SGD.", "b", 1);
 
 PARAM_INT("num_basis", "Number of memory points to be stored for L-BFGS.", "B",
     5);
@@ -105,6 +121,16 @@ PARAM_INT("max_line_search_trials", "Maximum number of line search trials for "
 PARAM_DOUBLE("min_step", "Minimum step of line search for L-BFGS.", "m", 1e-20);
 PARAM_DOUBLE("max_step", "Maximum step of line search for L-BFGS.", "M", 1e20);
 
+PARAM_DOUBLE("cutoff", "For L-BFGS, ignore pairs of points farther apart than "
+    "this in the stretched space (0 means all pairs are considered).", "c",
+    0.0);
+PARAM_INT("threads", "Number of threads to use for L-BFGS objective and "
+    "gradient evaluations, or for the mini-batches of SGD (0 means all "
+    "available cores).", "j", 1);
+
+PARAM_INT("output_dimensionality", "Number of rows of the learned matrix (0 "
+    "means the dimensionality of the data).", "d", 0);
+
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 
@@ -178,12 +204,30 @@ int main(int argc, char* argv[])
   const double tolerance = CLI::GetParam<double>("tolerance");
   const bool normalize = CLI::HasParam("normalize");
   const bool shuffle = !CLI::HasParam("linear_scan");
+  const int batchSize = CLI::GetParam<int>("batch_size");
   const int numBasis = CLI::GetParam<int>("num_basis");
   const double armijoConstant = CLI::GetParam<double>("armijo_constant");
   const double wolfe = CLI::GetParam<double>("wolfe");
   const int maxLineSearchTrials = CLI::GetParam<int>("max_line_search_trials");
   const double minStep = CLI::GetParam<double>("min_step");
   const double maxStep = CLI::GetParam<double>("max_step");
+  const double cutoff = CLI::GetParam<double>("cutoff");
+  const int threads = CLI::GetParam<int>("threads");
+  const int outputDimensionality =
+      CLI::GetParam<int>("output_dimensionality");
+
+  if (cutoff < 0.0)
+    Log::Fatal << "Invalid cutoff: " << cutoff << ".  Must be greater than or "
+        << "equal to 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  if (batchSize <= 0)
+    Log::Fatal << "Invalid batch size: " << batchSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (outputDimensionality < 0)
+    Log::Fatal << "Invalid output dimensionality: " << outputDimensionality
+        << ".  Must be greater than or equal to 0." << endl;
 
   // Load data.
   arma::mat data;
@@ -226,6 +270,8 @@ int main(int argc, char* argv[])
         ranges[d] = 1; // A range of 0 produces NaN later on.
 
     distance = diagmat(1.0 / ranges);
+    if (outputDimensionality > 0 && (size_t) outputDimensionality < data.n_rows)
+      distance.shed_rows(outputDimensionality, data.n_rows - 1);
     Log::Info << "Using normalized starting point for optimization."
         << std::endl;
   }
@@ -242,12 +288,17 @@ int main(int argc, char* argv[])
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().Tolerance() = tolerance;
     nca.Optimizer().Shuffle() = shuffle;
+    nca.Optimizer().BatchSize() = (size_t) batchSize;
+    nca.ErrorFunction().Threads() = (size_t) threads;
+    nca.OutputDimensionality() = (size_t) outputDimensionality;
 
     nca.LearnDistance(distance);
   }
   else if (optimizerType == "lbfgs")
   {
     NCA<LMetric<2>, L_BFGS> nca(data, labels);
+    nca.ErrorFunction().Cutoff() = cutoff;
+    nca.ErrorFunction().Threads() = (size_t) threads;
     nca.Optimizer().NumBasis() = numBasis;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().ArmijoConstant() = armijoConstant;
@@ -256,6 +307,7 @@ int main(int argc, char* argv[])
     nca.Optimizer().MaxLineSearchTrials() = maxLineSearchTrials;
     nca.Optimizer().MinStep() = minStep;
     nca.Optimizer().MaxStep() = maxStep;
+    nca.OutputDimensionality() = (size_t) outputDimensionality;
 
     nca.LearnDistance(distance);
   }
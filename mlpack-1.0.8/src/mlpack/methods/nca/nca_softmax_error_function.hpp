@@ -47,6 +47,25 @@ namespace nca {
  * optimizers use, overloads of Evaluate() and Gradient() are given which only
  * operate on one point in the dataset.  This is useful for optimizers like
  * stochastic gradient descent (see mlpack::optimization::SGD).
+ *
+ * The non-separable Evaluate() and Gradient() sum over all O(n^2) pairs of
+ * points.  Since exp(-d) is negligible for pairs which are far apart, a cutoff
+ * can be set with Cutoff(): then, a kd-tree is built on the stretched dataset
+ * and only the pairs of points whose (Euclidean) distance in the stretched
+ * space is at most the cutoff are considered.  With the squared Euclidean
+ * distance as the metric, a cutoff of r ignores terms smaller than exp(-r^2).
+ * The pairs are also split between several threads if Threads() is set.
+ *
+ * For mini-batch SGD, there are also overloads of Evaluate() and Gradient()
+ * which operate on a batch of consecutive points, with the points of the batch
+ * split between threads.  The stretched dataset is only recomputed when the
+ * coordinates change, so every point of a batch (and every point of the
+ * initial objective evaluation of SGD) shares one stretch of the dataset.
+ *
+ * The coordinates A need not be square: if OutputDimensionality() is set to
+ * d < D (the dimensionality of the dataset), A is a d x D matrix which projects
+ * the points to d dimensions.  Then, the stretched dataset has d rows, and the
+ * gradients are d x D; the cost of an evaluation falls accordingly.
  */
 template<typename MetricType = metric::SquaredEuclideanDistance>
 class SoftmaxErrorFunction
@@ -112,6 +131,34 @@ class SoftmaxErrorFunction
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the softmax objective function for the given covariance matrix on
+   * the batch of points [begin, begin + batchSize).  This is the sum of the
+   * separable objective functions of those points.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& covariance,
+                  const size_t begin,
+                  const size_t batchSize);
+
+  /**
+   * Evaluate the gradient of the softmax function for the given covariance
+   * matrix on the batch of points [begin, begin + batchSize).  This is the sum
+   * of the separable gradients of those points.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Matrix to store the calculated gradient in.
+   */
+  void Gradient(const arma::mat& covariance,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient);
+
   /**
    * Get the initial point.
    */
@@ -123,6 +170,27 @@ class SoftmaxErrorFunction
    */
   size_t NumFunctions() const { return dataset.n_cols; }
 
+  //! Get the cutoff distance (0 means all pairs of points are considered).
+  double Cutoff() const { return cutoff; }
+  //! Modify the cutoff distance in the stretched space beyond which pairs of
+  //! points are ignored by the non-separable Evaluate() and Gradient() (0
+  //! means all pairs of points are considered).
+  double& Cutoff() { return cutoff; }
+
+  //! Get the number of rows of the coordinates (0 means the dimensionality of
+  //! the dataset).
+  size_t OutputDimensionality() const { return outputDimensionality; }
+  //! Modify the number of rows of the coordinates, which is the number of
+  //! rows of GetInitialPoint() (0 means the dimensionality of the dataset).
+  size_t& OutputDimensionality() { return outputDimensionality; }
+
+  //! Get the number of threads used by the non-separable and batch
+  //! Evaluate() and Gradient().
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used by the non-separable and batch
+  //! Evaluate() and Gradient() (0 means all available cores).
+  size_t& Threads() { return threads; }
+
  private:
   //! The dataset.
   const arma::mat& dataset;
@@ -132,16 +200,35 @@ class SoftmaxErrorFunction
   //! The instantiated metric.
   MetricType metric;
 
+  //! The cutoff distance in the stretched space (0 means no cutoff).
+  double cutoff;
+  //! The number of rows of the coordinates (0 means dataset.n_rows).
+  size_t outputDimensionality;
+  //! The number of threads to use.
+  size_t threads;
+
   //! Last coordinates.  Used for the non-separable Evaluate() and Gradient().
   arma::mat lastCoordinates;
   //! Stretched dataset.  Kept internal to avoid memory reallocations.
   arma::mat stretchedDataset;
+  //! The coordinates stretchedDataset was computed with.
+  arma::mat stretchedCoordinates;
+  //! False if the dataset has never been stretched.
+  bool stretched;
   //! Holds calculated p_i, for the non-separable Evaluate() and Gradient().
   arma::vec p;
   //! Holds denominators for calculation of p_ij, for the non-separable
   //! Evaluate() and Gradient().
   arma::vec denominators;
 
+  //! If a cutoff is used, the neighbors of point i within the cutoff are
+  //! neighbors[neighborOffsets[i]] to neighbors[neighborOffsets[i + 1] - 1].
+  arma::Col<size_t> neighborOffsets;
+  //! The neighbors of each point within the cutoff, if a cutoff is used.
+  arma::Col<size_t> neighbors;
+  //! The cutoff used for the last precalculation.
+  double lastCutoff;
+
   //! False if nothing has ever been precalculated (only at construction time).
   bool precalculated;
 
@@ -151,14 +238,52 @@ class SoftmaxErrorFunction
    * the Precalculate() method was run with.  This method is only called by the
    * non-separable Evaluate() and Gradient().
    *
-   * This will update last_coordinates_ and stretched_dataset_, and also
+   * This will update lastCoordinates and stretchedDataset, and also
    * calculate the p_i and denominators_ which are used in the calculation of
    * p_i or p_ij.  The calculation will be O((n * (n + 1)) / 2), which is not
-   * great.
+   * great, unless a cutoff is used; then the neighbors of each point within the
+   * cutoff are found with range search first.
    *
    * @param coordinates Coordinates matrix to use for precalculation.
    */
   void Precalculate(const arma::mat& coordinates);
+
+  /**
+   * Compute the stretched dataset for the given coordinates, unless it was
+   * already computed with the same coordinates.
+   *
+   * @param coordinates Coordinates matrix to stretch the dataset with.
+   */
+  void Stretch(const arma::mat& coordinates);
+
+  /**
+   * Evaluate the separable objective function of point i, using the stretched
+   * dataset (see Stretch()).
+   */
+  double EvaluatePoint(const size_t i);
+
+  /**
+   * Evaluate the separable gradient of point i, using the stretched dataset
+   * (see Stretch()).
+   */
+  void GradientPoint(const arma::mat& coordinates,
+                     const size_t i,
+                     arma::mat& gradient);
+
+  /**
+   * Get the range of candidate partners of point i which Precalculate() and
+   * Gradient() loop over: the indices begin to end - 1 of neighbors if a cutoff
+   * is used, and the points i + 1 to n - 1 otherwise.  Use Partner() to get the
+   * point index of a candidate.
+   */
+  void PartnerRange(const size_t i, size_t& begin, size_t& end) const;
+
+  //! Get the point index of the given candidate partner (see PartnerRange()).
+  size_t Partner(const size_t candidate) const
+  { return (cutoff > 0.0) ? neighbors[candidate] : candidate; }
+
+  //! Return the number of threads to use.
+  size_t NumThreads() const;
 };
 
 }; // namespace nca
@@ -25,6 +25,12 @@
 // In case it hasn't been included already.
 #include "nca_softmax_error_function.hpp"
 
+#include <mlpack/methods/range_search/range_search.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace nca {
 
@@ -37,6 +43,11 @@ SoftmaxErrorFunction<MetricType>::SoftmaxErrorFunction(
     dataset(dataset),
     labels(labels),
     metric(metric),
+    cutoff(0.0),
+    outputDimensionality(0),
+    threads(1),
+    stretched(false),
+    lastCutoff(0.0),
     precalculated(false)
 { /* nothing to do */ }
 
@@ -56,41 +67,28 @@ template<typename MetricType>
 double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
                                                   const size_t i)
 {
-  // Unfortunately each evaluation will take O(N) time because it requires a
-  // scan over all points in the dataset.  Our objective is to compute p_i.
-  double denominator = 0;
-  double numerator = 0;
-
-  // It's quicker to do this now than one point at a time later.
-  stretchedDataset = coordinates * dataset;
-
-  for (size_t k = 0; k < dataset.n_cols; ++k)
-  {
-    // Don't consider the case where the points are the same.
-    if (k == i)
-      continue;
+  // Stretch the dataset, if the coordinates have changed.
+  Stretch(coordinates);
 
-    // We want to evaluate exp(-D(A x_i, A x_k)).
-    double eval = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                            stretchedDataset.unsafe_col(k)));
-
-    // If they are in the same
-    if (labels[i] == labels[k])
-      numerator += eval;
+  return EvaluatePoint(i);
+}
 
-    denominator += eval;
-  }
+//! The objective function of a batch of points.
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
+                                                  const size_t begin,
+                                                  const size_t batchSize)
+{
+  // The whole batch shares one stretch of the dataset.
+  Stretch(coordinates);
 
-  // Now the result is just a simple division, but we have to be sure that the
-  // denominator is not 0.
-  if (denominator == 0.0)
-  {
-    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
-    return 0;
-  }
+  double objective = 0;
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic, 1) \
+      reduction(+:objective)
+  for (int i = 0; i < (int) batchSize; ++i)
+    objective += EvaluatePoint(begin + i);
 
-  return -(numerator / denominator); // Negate because the optimizer is a
-                                     // minimizer.
+  return objective;
 }
 
 //! The non-separable implementation, where Precalculate() is used.
@@ -113,32 +111,59 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   //     (((p_i - (1 / p_i)) p_ik) + ((p_k - (1 / p_k)) p_ki)) x_ik x_ik^T
   //   otherwise, add
   //     (p_i p_ik + p_k p_ki) x_ik x_ik^T
+  //
+  // The gradient is -2 A times this sum, and A x_ik x_ik^T is the stretched
+  // difference times x_ik^T, so the terms are summed as the (d x D) products
+  // (A x_ik) x_ik^T instead of the (D x D) products x_ik x_ik^T.
+  //
+  // If a cutoff is used, only the pairs of neighbors within the cutoff are
+  // considered.  Each thread sums into its own matrix.
   arma::mat sum;
-  sum.zeros(stretchedDataset.n_rows, stretchedDataset.n_rows);
-  for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+  sum.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  #pragma omp parallel num_threads(NumThreads())
   {
-    for (size_t k = (i + 1); k < stretchedDataset.n_cols; k++)
+    arma::mat threadSum;
+    threadSum.zeros(coordinates.n_rows, coordinates.n_cols);
+
+    #pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < (int) stretchedDataset.n_cols; i++)
     {
-      // Calculate p_ik and p_ki first.
-      double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                         stretchedDataset.unsafe_col(k)));
-      double p_ik = 0, p_ki = 0;
-      p_ik = eval / denominators(i);
-      p_ki = eval / denominators(k);
-
-      // Subtract x_i from x_k.  We are not using stretched points here.
-      arma::vec x_ik = dataset.col(i) - dataset.col(k);
-      arma::mat secondTerm = (x_ik * trans(x_ik));
-
-      if (labels[i] == labels[k])
-        sum += ((p[i] - 1) * p_ik + (p[k] - 1) * p_ki) * secondTerm;
-      else
-        sum += (p[i] * p_ik + p[k] * p_ki) * secondTerm;
+      size_t begin, end;
+      PartnerRange(i, begin, end);
+      for (size_t c = begin; c < end; c++)
+      {
+        const size_t k = Partner(c);
+        if (k <= (size_t) i)
+          continue;
+
+        // Calculate p_ik and p_ki first.
+        double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                           stretchedDataset.unsafe_col(k)));
+        double p_ik = 0, p_ki = 0;
+        p_ik = eval / denominators(i);
+        p_ki = eval / denominators(k);
+
+        // Subtract x_i from x_k, in the original and the stretched space.
+        arma::vec x_ik = dataset.col(i) - dataset.col(k);
+        arma::vec stretched_ik = stretchedDataset.col(i) -
+            stretchedDataset.col(k);
+
+        if (labels[i] == labels[k])
+          threadSum += ((p[i] - 1) * p_ik + (p[k] - 1) * p_ki) *
+              (stretched_ik * trans(x_ik));
+        else
+          threadSum += (p[i] * p_ik + p[k] * p_ki) *
+              (stretched_ik * trans(x_ik));
+      }
     }
+
+    #pragma omp critical
+    sum += threadSum;
   }
 
   // Assemble the final gradient.
-  gradient = -2 * coordinates * sum;
+  gradient = -2 * sum;
 }
 
 //! The separable implementation.
@@ -147,74 +172,50 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
                                                 const size_t i,
                                                 arma::mat& gradient)
 {
-  // We will need to calculate p_i before this evaluation is done, so these two
-  // variables will hold the information necessary for that.
-  double numerator = 0;
-  double denominator = 0;
+  // Stretch the dataset, if the coordinates have changed.
+  Stretch(coordinates);
 
-  // The gradient involves two matrix terms which are eventually combined into
-  // one.
-  arma::mat firstTerm;
-  arma::mat secondTerm;
+  GradientPoint(coordinates, i, gradient);
+}
 
-  firstTerm.zeros(coordinates.n_rows, coordinates.n_cols);
-  secondTerm.zeros(coordinates.n_rows, coordinates.n_cols);
+//! The gradient of a batch of points.
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
+                                                const size_t begin,
+                                                const size_t batchSize,
+                                                arma::mat& gradient)
+{
+  // The whole batch shares one stretch of the dataset.
+  Stretch(coordinates);
 
-  // Compute the stretched dataset.
-  stretchedDataset = coordinates * dataset;
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
 
-  for (size_t k = 0; k < dataset.n_cols; ++k)
+  // Each thread sums the gradients of its points into its own matrix.
+  #pragma omp parallel num_threads(NumThreads())
   {
-    // Don't consider the case where the points are the same.
-    if (i == k)
-      continue;
+    arma::mat threadGradient;
+    threadGradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    arma::mat pointGradient;
 
-    // Calculate the numerator of p_ik.
-    double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                       stretchedDataset.unsafe_col(k)));
-
-    // If the points are in the same class, we must add to the second term of
-    // the gradient as well as the numerator of p_i.  We will divide by the
-    // denominator of p_ik later.  For x_ik we are not using stretched points.
-    arma::vec x_ik = dataset.col(i) - dataset.col(k);
-    if (labels[i] == labels[k])
+    #pragma omp for schedule(dynamic, 1)
+    for (int i = 0; i < (int) batchSize; ++i)
     {
-      numerator += eval;
-      secondTerm += eval * x_ik * trans(x_ik);
+      GradientPoint(coordinates, begin + i, pointGradient);
+      threadGradient += pointGradient;
     }
 
-    // We always have to add to the denominator of p_i and the first term of the
-    // gradient computation.  We will divide by the denominator of p_ik later.
-    denominator += eval;
-    firstTerm += eval * x_ik * trans(x_ik);
+    #pragma omp critical
+    gradient += threadGradient;
   }
-
-  // Calculate p_i.
-  double p = 0;
-  if (denominator == 0)
-  {
-    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
-    // If the denominator is zero, then all p_ik should be zero and there is
-    // no gradient contribution from this point.
-    gradient.zeros(coordinates.n_rows, coordinates.n_rows);
-    return;
-  }
-  else
-  {
-    p = numerator / denominator;
-    firstTerm /= denominator;
-    secondTerm /= denominator;
-  }
-
-  // Now multiply the first term by p_i, and add the two together and multiply
-  // all by 2 * A.  We negate it though, because our optimizer is a minimizer.
-  gradient = -2 * coordinates * (p * firstTerm - secondTerm);
 }
 
 template<typename MetricType>
 const arma::mat SoftmaxErrorFunction<MetricType>::GetInitialPoint() const
 {
-  return arma::eye<arma::mat>(dataset.n_rows, dataset.n_rows);
+  // A rectangular identity keeps the first dimensions.
+  const size_t rows = (outputDimensionality == 0) ? dataset.n_rows :
+      outputDimensionality;
+  return arma::eye<arma::mat>(rows, dataset.n_rows);
 }
 
 template<typename MetricType>
@@ -224,14 +225,18 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   // Ensure it is the right size.
   lastCoordinates.set_size(coordinates.n_rows, coordinates.n_cols);
 
+  // The separable functions may have stretched the dataset with other
+  // coordinates since, so this is checked separately.
+  Stretch(coordinates);
+
   // Make sure the calculation is necessary.
   if ((accu(coordinates == lastCoordinates) == coordinates.n_elem) &&
-      precalculated)
+      (cutoff == lastCutoff) && precalculated)
     return; // No need to calculate; we already have this stuff saved.
 
-  // Coordinates are different; save the new ones, and stretch the dataset.
+  // Coordinates are different; save the new ones.
   lastCoordinates = coordinates;
-  stretchedDataset = coordinates * dataset;
+  lastCutoff = cutoff;
 
   // For each point i, we must evaluate the softmax function:
   //   p_ij = exp( -K(x_i, x_j) ) / ( sum_{k != i} ( exp( -K(x_i, x_k) )))
@@ -239,27 +244,63 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   // We will do this by keeping track of the denominators for each i as well as
   // the numerators (the sum for all j in class of i).  This will be on the
   // order of O((n * (n + 1)) / 2), which really isn't all that great.
+  //
+  // If a cutoff is used, the neighbors within the cutoff are found first, and
+  // only those pairs are considered.
+  if (cutoff > 0.0)
+  {
+    range::RangeSearch<> rangeSearch(stretchedDataset);
+    rangeSearch.Threads() = threads;
+
+    arma::vec distances;
+    rangeSearch.Search(math::Range(0.0, cutoff), neighborOffsets, neighbors,
+        distances);
+  }
+
   p.zeros(stretchedDataset.n_cols);
   denominators.zeros(stretchedDataset.n_cols);
-  for (size_t i = 0; i < stretchedDataset.n_cols; i++)
-  {
-    for (size_t j = (i + 1); j < stretchedDataset.n_cols; j++)
-    {
-      // Evaluate exp(-d(x_i, x_j)).
-      double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                         stretchedDataset.unsafe_col(j)));
 
-      // Add this to the denominators of both p_i and p_j: K(i, j) = K(j, i).
-      denominators[i] += eval;
-      denominators[j] += eval;
+  // Each pair adds to the sums of both of its points, so each thread sums into
+  // its own vectors.
+  #pragma omp parallel num_threads(NumThreads())
+  {
+    arma::vec threadP, threadDenominators;
+    threadP.zeros(stretchedDataset.n_cols);
+    threadDenominators.zeros(stretchedDataset.n_cols);
 
-      // If i and j are the same class, add to numerator of both.
-      if (labels[i] == labels[j])
+    #pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < (int) stretchedDataset.n_cols; i++)
+    {
+      size_t begin, end;
+      PartnerRange(i, begin, end);
+      for (size_t c = begin; c < end; c++)
       {
-        p[i] += eval;
-        p[j] += eval;
+        const size_t j = Partner(c);
+        if (j <= (size_t) i)
+          continue;
+
+        // Evaluate exp(-d(x_i, x_j)).
+        double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                           stretchedDataset.unsafe_col(j)));
+
+        // Add this to the denominators of both p_i and p_j: K(i, j) = K(j, i).
+        threadDenominators[i] += eval;
+        threadDenominators[j] += eval;
+
+        // If i and j are the same class, add to numerator of both.
+        if (labels[i] == labels[j])
+        {
+          threadP[i] += eval;
+          threadP[j] += eval;
+        }
       }
     }
+
+    #pragma omp critical
+    {
+      p += threadP;
+      denominators += threadDenominators;
+    }
   }
 
   // Divide p_i by their denominators.
@@ -282,6 +323,153 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   precalculated = true;
 }
 
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::Stretch(const arma::mat& coordinates)
+{
+  if (stretched && (coordinates.n_rows == stretchedCoordinates.n_rows) &&
+      (coordinates.n_cols == stretchedCoordinates.n_cols) &&
+      (accu(coordinates == stretchedCoordinates) == coordinates.n_elem))
+    return; // The dataset is already stretched with these coordinates.
+
+  stretchedCoordinates = coordinates;
+  stretchedDataset = coordinates * dataset;
+  stretched = true;
+}
+
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::EvaluatePoint(const size_t i)
+{
+  // Unfortunately each evaluation will take O(N) time because it requires a
+  // scan over all points in the dataset.  Our objective is to compute p_i.
+  double denominator = 0;
+  double numerator = 0;
+
+  for (size_t k = 0; k < dataset.n_cols; ++k)
+  {
+    // Don't consider the case where the points are the same.
+    if (k == i)
+      continue;
+
+    // We want to evaluate exp(-D(A x_i, A x_k)).
+    double eval = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                            stretchedDataset.unsafe_col(k)));
+
+    // If they are in the same
+    if (labels[i] == labels[k])
+      numerator += eval;
+
+    denominator += eval;
+  }
+
+  // Now the result is just a simple division, but we have to be sure that the
+  // denominator is not 0.
+  if (denominator == 0.0)
+  {
+    #pragma omp critical
+    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
+    return 0;
+  }
+
+  return -(numerator / denominator); // Negate because the optimizer is a
+                                     // minimizer.
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::GradientPoint(
+    const arma::mat& coordinates,
+    const size_t i,
+    arma::mat& gradient)
+{
+  // We will need to calculate p_i before this evaluation is done, so these two
+  // variables will hold the information necessary for that.
+  double numerator = 0;
+  double denominator = 0;
+
+  // The gradient involves two matrix terms which are eventually combined into
+  // one.  As in the non-separable Gradient(), they sum (A x_ik) x_ik^T, so
+  // that they are only as large as the coordinates.
+  arma::mat firstTerm;
+  arma::mat secondTerm;
+
+  firstTerm.zeros(coordinates.n_rows, coordinates.n_cols);
+  secondTerm.zeros(coordinates.n_rows, coordinates.n_cols);
+
+  for (size_t k = 0; k < dataset.n_cols; ++k)
+  {
+    // Don't consider the case where the points are the same.
+    if (i == k)
+      continue;
+
+    // Calculate the numerator of p_ik.
+    double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                       stretchedDataset.unsafe_col(k)));
+
+    // If the points are in the same class, we must add to the second term of
+    // the gradient as well as the numerator of p_i.  We will divide by the
+    // denominator of p_ik later.
+    arma::vec x_ik = dataset.col(i) - dataset.col(k);
+    arma::vec stretched_ik = stretchedDataset.col(i) - stretchedDataset.col(k);
+    if (labels[i] == labels[k])
+    {
+      numerator += eval;
+      secondTerm += eval * stretched_ik * trans(x_ik);
+    }
+
+    // We always have to add to the denominator of p_i and the first term of the
+    // gradient computation.  We will divide by the denominator of p_ik later.
+    denominator += eval;
+    firstTerm += eval * stretched_ik * trans(x_ik);
+  }
+
+  // Calculate p_i.
+  double p = 0;
+  if (denominator == 0)
+  {
+    #pragma omp critical
+    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
+    // If the denominator is zero, then all p_ik should be zero and there is
+    // no gradient contribution from this point.
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    return;
+  }
+  else
+  {
+    p = numerator / denominator;
+    firstTerm /= denominator;
+    secondTerm /= denominator;
+  }
+
+  // Now multiply the first term by p_i, and add the two together and multiply
+  // all by 2 (A is already in both terms).  We negate it though, because our
+  // optimizer is a minimizer.
+  gradient = -2 * (p * firstTerm - secondTerm);
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::PartnerRange(const size_t i,
+                                                    size_t& begin,
+                                                    size_t& end) const
+{
+  if (cutoff > 0.0)
+  {
+    begin = neighborOffsets[i];
+    end = neighborOffsets[i + 1];
+  }
+  else
+  {
+    begin = i + 1;
+    end = stretchedDataset.n_cols;
+  }
+}
+
+template<typename MetricType>
+size_t SoftmaxErrorFunction<MetricType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
+
 }; // namespace nca
 }; // namespace mlpack
 
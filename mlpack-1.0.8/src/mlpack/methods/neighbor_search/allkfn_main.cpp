@@ -52,7 +52,12 @@ PROGRAM_INFO("All K-Furthest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th furthest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "CSV and text output files are formatted in parallel with the number of "
+    "threads given by --threads.  For large outputs, a binary file is much "
+    "faster to write: give the output files the extension '.bin' (Armadillo "
+    "binary) or '.mbin' (mlpack binary, which can be memory-mapped).");
 
 // Define our input parameters that this program will take.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -67,6 +72,9 @@ PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
+PARAM_INT("threads", "Number of threads to use for tree-based search (0 "
+    "uses all available cores).  This only has an effect if MLPACK was built "
+    "with OpenMP.", "j", 1);
 
 int main(int argc, char *argv[])
 {
@@ -110,6 +118,14 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // Sanity check on number of threads.
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
@@ -179,6 +195,7 @@ int main(int argc, char *argv[])
   }
 
   Log::Info << "Computing " << k << " furthest neighbors..." << endl;
+  allkfn->Threads() = (size_t) threads;
   allkfn->Search(k, neighbors, distances);
 
   Log::Info << "Neighbors computed." << endl;
@@ -205,8 +222,8 @@ int main(int argc, char *argv[])
     delete queryTree;
 
   // Save output.
-  data::Save(distancesFile, distancesOut);
-  data::Save(neighborsFile, neighborsOut);
+  data::Save(distancesFile, distancesOut, false, true, (size_t) threads);
+  data::Save(neighborsFile, neighborsOut, false, true, (size_t) threads);
 
   delete allkfn;
 }
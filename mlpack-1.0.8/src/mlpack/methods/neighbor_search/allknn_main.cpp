@@ -21,13 +21,19 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/metrics/periodic_lmetric.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/tree_index.hpp>
+#include <mlpack/core/tree/tree_tuner.hpp>
 
+#include <algorithm>
 #include <string>
+#include <sstream>
 #include <fstream>
 #include <iostream>
 
 #include "neighbor_search.hpp"
+#include "knn_graph.hpp"
 #include "unmap.hpp"
 
 using namespace std;
@@ -35,11 +41,283 @@ using namespace mlpack;
 using namespace mlpack::neighbor;
 using namespace mlpack::tree;
 
+/**
+ * Read the box given with --periodic_box: either one size, which is used for
+ * every dimension, or a comma-separated list with a size for each dimension.
+ */
+arma::vec PeriodicBox(const string& sizes, const size_t dimensionality)
+{
+  string list(sizes);
+  replace(list.begin(), list.end(), ',', ' ');
+
+  istringstream stream(list);
+  vector<double> values;
+  double value;
+  while (stream >> value)
+    values.push_back(value);
+
+  if (!stream.eof() || values.empty())
+    Log::Fatal << "Invalid periodic box '" << sizes << "'; must be a "
+        << "comma-separated list of box sizes." << endl;
+
+  if (values.size() != 1 && values.size() != dimensionality)
+    Log::Fatal << "Invalid periodic box '" << sizes << "'; must have one size "
+        << "or " << dimensionality << " sizes (one for each dimension)."
+        << endl;
+
+  arma::vec box(dimensionality);
+  for (size_t i = 0; i < dimensionality; ++i)
+  {
+    box[i] = values[(values.size() == 1) ? 0 : i];
+    if (box[i] < 0.0)
+      Log::Fatal << "Invalid periodic box '" << sizes << "'; sizes must be "
+          << "greater than or equal to 0." << endl;
+  }
+
+  return box;
+}
+
+/**
+ * Find the k nearest neighbors with binary space trees of the given type (ball
+ * trees or periodic kd-trees) and the given metric, and map the results back
+ * to the original order of the points.  If the query set is empty, the
+ * reference set is used as the query set, and the search may be symmetric (see
+ * NeighborSearch::Symmetric()).
+ */
+template<typename TreeType, typename MetricType>
+void BinarySpaceTreeSearch(arma::mat& referenceData,
+                           arma::mat& queryData,
+                           const size_t k,
+                           size_t leafSize,
+                           const bool naive,
+                           const bool singleMode,
+                           const int threads,
+                           const int medianSamples,
+                           const bool mortonOrder,
+                           const double epsilon,
+                           const bool symmetric,
+                           const MetricType& metric,
+                           arma::Mat<size_t>& neighbors,
+                           arma::mat& distances)
+{
+  typedef NeighborSearch<NearestNeighborSort, MetricType, TreeType> SearchType;
+
+  // Build trees by hand, so we can save memory: if we pass a tree to
+  // NeighborSearch, it does not copy the matrix.
+  Log::Info << "Building reference tree..." << endl;
+  Timer::Start("tree_building");
+
+  std::vector<size_t> oldFromNewRefs;
+  TreeType refTree(referenceData, oldFromNewRefs, BuildOptions(leafSize,
+      (size_t) threads, (size_t) medianSamples, mortonOrder));
+  refTree.Flatten();
+  bound::SetTreeMetric(refTree, metric);
+
+  Timer::Stop("tree_building");
+
+  TreeType* queryTree = NULL; // Empty for now.
+  std::vector<size_t> oldFromNewQueries;
+
+  SearchType* allknn = NULL;
+  if (queryData.n_cols > 0)
+  {
+    if (naive && leafSize < queryData.n_cols)
+      leafSize = queryData.n_cols;
+
+    if (!singleMode)
+    {
+      Log::Info << "Building query tree..." << endl;
+      Timer::Start("tree_building");
+
+      queryTree = new TreeType(queryData, oldFromNewQueries,
+          BuildOptions(leafSize, (size_t) threads, (size_t) medianSamples,
+          mortonOrder));
+      queryTree->Flatten();
+      bound::SetTreeMetric(*queryTree, metric);
+
+      Timer::Stop("tree_building");
+    }
+
+    allknn = new SearchType(&refTree, queryTree, referenceData, queryData,
+        singleMode, metric);
+  }
+  else
+  {
+    allknn = new SearchType(&refTree, referenceData, singleMode, metric);
+  }
+
+  Log::Info << "Trees built." << endl;
+
+  arma::mat distancesOut;
+  arma::Mat<size_t> neighborsOut;
+
+  Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+  allknn->Threads() = (size_t) threads;
+  allknn->Epsilon() = epsilon;
+  allknn->Symmetric() = symmetric;
+  allknn->Search(k, neighborsOut, distancesOut);
+
+  Log::Info << "Neighbors computed." << endl;
+
+  // Map the results back to the original indices.
+  Log::Info << "Re-mapping indices..." << endl;
+  if (queryData.n_cols > 0 && !singleMode)
+    Unmap(neighborsOut, distancesOut, oldFromNewRefs, oldFromNewQueries,
+        neighbors, distances);
+  else if (queryData.n_cols > 0 && singleMode)
+    Unmap(neighborsOut, distancesOut, oldFromNewRefs, neighbors, distances);
+  else
+    Unmap(neighborsOut, distancesOut, oldFromNewRefs, oldFromNewRefs,
+        neighbors, distances);
+
+  if (queryTree)
+    delete queryTree;
+
+  delete allknn;
+}
+
+/**
+ * The search TreeTuner times with --auto_tune: find the k nearest neighbors of
+ * every point of the sample (at most n - 1 of them), with kd-trees or cover
+ * trees.
+ */
+struct KNNProbe
+{
+  typedef BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > KDTreeType;
+  typedef CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
+      NeighborSearchStat<NearestNeighborSort, true> > CoverTreeType;
+
+  KNNProbe(const size_t k, const bool singleMode) :
+      k(k), singleMode(singleMode) { }
+
+  void operator()(arma::mat& sample, const TreeConfiguration& configuration)
+  {
+    const size_t probeK = std::min(k, (size_t) sample.n_cols - 1);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (configuration.coverTree)
+    {
+      CoverTreeType tree(sample);
+      NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
+          CoverTreeType> search(&tree, sample, singleMode);
+      search.Search(probeK, neighbors, distances);
+    }
+    else
+    {
+      std::vector<size_t> oldFromNew;
+      KDTreeType tree(sample, oldFromNew, configuration.leafSize);
+      tree.Flatten();
+      AllkNN search(&tree, sample, singleMode);
+      search.Search(probeK, neighbors, distances);
+    }
+  }
+
+  size_t k;
+  bool singleMode;
+};
+
+/**
+ * The stages of the search of a query set read in chunks (see
+ * data::ChunkReader::Pipeline()): each chunk of queries is searched against the
+ * reference tree, and its neighbors and distances are appended to the output
+ * files.
+ */
+template<typename TreeType>
+class KNNChunkSearch
+{
+ public:
+  typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+      TreeType> SearchType;
+
+  KNNChunkSearch(TreeType& referenceTree,
+                 const arma::mat& referenceData,
+                 const std::vector<size_t>& oldFromNewRefs,
+                 const size_t k,
+                 const bool singleMode,
+                 const BuildOptions& options,
+                 const double epsilon,
+                 data::ChunkWriter<size_t>* neighborsWriter,
+                 data::ChunkWriter<double>* distancesWriter) :
+      referenceTree(referenceTree),
+      referenceData(referenceData),
+      oldFromNewRefs(oldFromNewRefs),
+      k(k),
+      singleMode(singleMode),
+      options(options),
+      epsilon(epsilon),
+      neighborsWriter(neighborsWriter),
+      distancesWriter(distancesWriter)
+  { }
+
+  //! Search the given chunk of queries, keeping the results in the slot.
+  void Process(const arma::mat& chunk,
+               const size_t /* firstPoint */,
+               const size_t slot)
+  {
+    arma::Mat<size_t> neighborsOut;
+    arma::mat distancesOut;
+    if (singleMode)
+    {
+      SearchType search(&referenceTree, NULL, referenceData, chunk, true);
+      search.Threads() = options.Threads();
+      search.Epsilon() = epsilon;
+      search.Search(k, neighborsOut, distancesOut);
+      Unmap(neighborsOut, distancesOut, oldFromNewRefs, neighbors[slot],
+          distances[slot]);
+    }
+    else
+    {
+      // The query tree reorders its points, so it is built on a copy.
+      arma::mat queries(chunk);
+      std::vector<size_t> oldFromNewQueries;
+      TreeType queryTree(queries, oldFromNewQueries, options);
+      queryTree.Flatten();
+
+      SearchType search(&referenceTree, &queryTree, referenceData, queries);
+      search.Threads() = options.Threads();
+      search.Epsilon() = epsilon;
+      search.Search(k, neighborsOut, distancesOut);
+      Unmap(neighborsOut, distancesOut, oldFromNewRefs, oldFromNewQueries,
+          neighbors[slot], distances[slot]);
+    }
+  }
+
+  //! Append the results in the slot to the output files.
+  void Output(const size_t slot)
+  {
+    if (neighborsWriter)
+      neighborsWriter->Write(neighbors[slot]);
+    if (distancesWriter)
+      distancesWriter->Write(distances[slot]);
+  }
+
+ private:
+  TreeType& referenceTree;
+  const arma::mat& referenceData;
+  const std::vector<size_t>& oldFromNewRefs;
+  size_t k;
+  bool singleMode;
+  BuildOptions options;
+  double epsilon;
+  data::ChunkWriter<size_t>* neighborsWriter;
+  data::ChunkWriter<double>* distancesWriter;
+
+  //! The results of the chunk being searched and of the chunk being written.
+  arma::Mat<size_t> neighbors[2];
+  arma::mat distances[2];
+};
+
 // Information about the program itself.
 PROGRAM_INFO("All K-Nearest-Neighbors",
     "This program will calculate the all k-nearest-neighbors of a set of "
-    "points using kd-trees or cover trees (cover tree support is experimental "
-    "and may not be optimally fast). You may specify a separate set of "
+    "points using kd-trees, ball trees, or cover trees (cover tree support is "
+    "experimental and may not be optimally fast).  Ball trees (--ball_tree) "
+    "are often faster than kd-trees for high-dimensional data.  For points in "
+    "a box with periodic boundaries (such as a simulation box), give the size "
+    "of the box with --periodic_box; distances are then taken to the nearest "
+    "periodic image of each point.  You may "
+    "specify a separate set of "
     "reference points and query points, or just a reference set which will be "
     "used as both the reference and query set."
     "\n\n"
@@ -54,27 +332,104 @@ PROGRAM_INFO("All K-Nearest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "CSV and text output files are formatted in parallel with the number of "
+    "threads given by --threads.  For large outputs, a binary file is much "
+    "faster to write: give the output files the extension '.bin' (Armadillo "
+    "binary) or '.mbin' (mlpack binary, which can be memory-mapped)."
+    "\n\n"
+    "Instead of (or as well as) the neighbors and distances, the kNN graph of "
+    "the reference set can be saved as a sparse matrix to the file given with "
+    "--graph_file (-g), as a coordinate list (.csv or .txt) or in the "
+    "MatrixMarket format (.mtx).  Points i and j are joined if j is one of the "
+    "k nearest neighbors of i or i is one of the k nearest neighbors of j; with"
+    " --mutual (-m), only if both hold.  The weight of each edge is the "
+    "distance between the points or, if --bandwidth (-B) is given, the "
+    "Gaussian weight exp(-d^2 / (2 bandwidth^2)).  With kd-trees, ball trees "
+    "and periodic kd-trees, each pair of leaves is then compared only once, "
+    "which halves the number of distance calculations (the search is run with "
+    "one thread).  A query set cannot be used with --graph_file."
+    "\n\n"
+    "On Mac OS X and iOS devices, --gpu (-G) finds the neighbors by brute "
+    "force on the GPU with Metal, which for large sets of query points in many "
+    "dimensions is often faster than the trees.  The GPU computes the "
+    "distances in single precision, so it finds twice as many candidates as "
+    "needed and ranks them again with exact distances; k may be at most 64.  "
+    "If no GPU is available, the search falls back to the CPU."
+    "\n\n"
+    "With --auto_tune (-A), the tree type and leaf size are chosen from a "
+    "quick profile of the reference set: on a sample of --tune_samples points, "
+    "the intrinsic dimensionality is estimated, and short searches are timed "
+    "with kd-trees of a few leaf sizes and with cover trees; the fastest is "
+    "used for the whole search.  This overrides --leaf_size and --cover_tree."
+    "\n\n"
+    "For query sets too large for memory, --query_chunk (-C) reads the query "
+    "set in chunks of the given number of points: each chunk is searched with "
+    "kd-trees while the next is read and the results of the previous one are "
+    "written, so only two chunks of queries and results are in memory at a "
+    "time.  The output files must then be .csv, .txt or .mbin files.");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
-PARAM_STRING_REQ("distances_file", "File to output distances into.", "d");
-PARAM_STRING_REQ("neighbors_file", "File to output neighbors into.", "n");
+PARAM_STRING("reference_file", "File containing the reference dataset.  Either "
+    "this or --index_file must be given.", "r", "");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_STRING("graph_file", "File to output the symmetric kNN graph of the "
+    "reference set into, as a sparse matrix.", "g", "");
+PARAM_DOUBLE("bandwidth", "If positive, weight the edges of the kNN graph with "
+    "a Gaussian kernel of this bandwidth instead of the distance.", "B", 0.0);
+PARAM_FLAG("mutual", "Only join mutual nearest neighbors in the kNN graph.",
+    "m");
 
 PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
 
 PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_STRING("index_file", "Load the reference dataset and its tree from this "
+    "tree index (see --save_index), instead of building the tree from "
+    "--reference_file.", "I", "");
+PARAM_STRING("save_index", "If specified, save the reference dataset and its "
+    "tree to this file, for later use with --index_file.", "x", "");
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "S");
 PARAM_FLAG("cover_tree", "If true, use cover trees to perform the search "
     "(experimental, may be slow).", "c");
+PARAM_FLAG("ball_tree", "If true, use ball trees to perform the search.", "b");
+PARAM_STRING("periodic_box", "If specified, the points lie in a box with "
+    "periodic boundaries of this size: either one size for every dimension, or "
+    "a comma-separated list of sizes, one for each dimension (0 for a dimension "
+    "which is not periodic).  Periodic kd-trees are used for the search.", "P",
+    "");
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
 PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
+PARAM_INT("threads", "Number of threads to use for tree building and "
+    "tree-based search (0 uses all available cores).  This only has an effect "
+    "if MLPACK was built with OpenMP.", "j", 1);
+PARAM_INT("median_samples", "If nonzero, split each kd-tree node at the median "
+    "of this many of its points instead of at the middle of its widest "
+    "dimension; this keeps the tree balanced for skewed data.", "M", 0);
+PARAM_FLAG("morton_build", "Build the kd-trees (or ball trees) from an ordering"
+    " of the points along a Morton curve: the points are sorted once, and the "
+    "tree is built without moving them again; nearby leaves are then close in "
+    "memory.  This overrides --median_samples.", "Z");
+PARAM_DOUBLE("epsilon", "If positive, perform approximate search: each "
+    "neighbor distance found is at most (1 + epsilon) times the true distance. "
+    "Larger values prune more of the tree, making the search faster.", "e",
+    0.0);
+PARAM_FLAG("gpu", "If true, find the neighbors by brute force on the GPU "
+    "(with Metal; only if MLPACK was built with USE_METAL).", "G");
+PARAM_FLAG("auto_tune", "If true, choose the tree type (kd-tree or cover tree) "
+    "and the leaf size by timing searches on a sample of the reference set.",
+    "A");
+PARAM_INT("tune_samples", "Number of reference points the searches of "
+    "--auto_tune are timed on.", "T", 2000);
+PARAM_INT("query_chunk", "If nonzero, read and search the query set in chunks "
+    "of this many points, overlapping reading, searching and writing.", "C",
+    0);
 
 int main(int argc, char *argv[])
 {
@@ -92,6 +447,8 @@ int main(int argc, char *argv[])
 
   const string distancesFile = CLI::GetParam<string>("distances_file");
   const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const string graphFile = CLI::GetParam<string>("graph_file");
+  const double bandwidth = CLI::GetParam<double>("bandwidth");
 
   int lsInt = CLI::GetParam<int>("leaf_size");
 
@@ -100,15 +457,107 @@ int main(int argc, char *argv[])
   bool naive = CLI::HasParam("naive");
   bool singleMode = CLI::HasParam("single_mode");
   const bool randomBasis = CLI::HasParam("random_basis");
-
-  arma::mat referenceData;
+  const bool ballTree = CLI::HasParam("ball_tree");
+  const string periodicBox = CLI::GetParam<string>("periodic_box");
+  const bool gpu = CLI::HasParam("gpu");
+  bool coverTree = CLI::HasParam("cover_tree");
+  const bool autoTune = CLI::HasParam("auto_tune");
+  const int queryChunk = CLI::GetParam<int>("query_chunk");
+
+  const string indexFile = CLI::GetParam<string>("index_file");
+  const string saveIndexFile = CLI::GetParam<string>("save_index");
+
+  if ((referenceFile == "") == (indexFile == ""))
+    Log::Fatal << "Exactly one of --reference_file and --index_file must be "
+        << "given." << endl;
+
+  if (distancesFile == "" && neighborsFile == "" && graphFile == "")
+    Log::Fatal << "At least one of --distances_file, --neighbors_file and "
+        << "--graph_file must be given." << endl;
+
+  if (graphFile != "" && queryFile != "")
+    Log::Fatal << "--graph_file cannot be used with --query_file." << endl;
+
+  if (bandwidth < 0.0)
+    Log::Fatal << "Invalid bandwidth: " << bandwidth << ".  Must be greater "
+        << "than or equal to 0." << endl;
+
+  if (graphFile == "" && (bandwidth > 0.0 || CLI::HasParam("mutual")))
+    Log::Warn << "--bandwidth and --mutual ignored because --graph_file is not "
+        << "given." << endl;
+
+  // The kNN graph is built with a symmetric search.
+  const bool symmetric = (graphFile != "");
+
+  if ((indexFile != "" || saveIndexFile != "") &&
+      (naive || randomBasis || ballTree || coverTree || periodicBox != ""))
+    Log::Fatal << "Tree indices cannot be used with --naive, --random_basis, "
+        << "--ball_tree, --cover_tree, or --periodic_box." << endl;
+
+  if ((int) ballTree + (int) coverTree + (int) (periodicBox != "") > 1)
+    Log::Fatal << "Only one of --ball_tree, --cover_tree, and --periodic_box "
+        << "may be given." << endl;
+
+  if (gpu && (ballTree || coverTree || periodicBox != ""))
+    Log::Fatal << "--gpu cannot be used with --ball_tree, --cover_tree, or "
+        << "--periodic_box." << endl;
+
+  if (autoTune && (indexFile != "" || saveIndexFile != "" || naive ||
+      ballTree || periodicBox != "" || gpu))
+    Log::Fatal << "--auto_tune cannot be used with --index_file, --save_index, "
+        << "--naive, --ball_tree, --periodic_box, or --gpu." << endl;
+
+  if (CLI::GetParam<int>("tune_samples") <= 0)
+    Log::Fatal << "Invalid number of tuning samples: "
+        << CLI::GetParam<int>("tune_samples") << ".  Must be greater than 0."
+        << endl;
+
+  if (queryChunk < 0)
+    Log::Fatal << "Invalid query chunk size: " << queryChunk << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (queryChunk > 0 && queryFile == "")
+    Log::Fatal << "--query_chunk requires --query_file." << endl;
+
+  if (queryChunk > 0 && (naive || randomBasis || ballTree || coverTree ||
+      periodicBox != "" || gpu))
+    Log::Fatal << "--query_chunk cannot be used with --naive, --random_basis, "
+        << "--ball_tree, --cover_tree, --periodic_box, or --gpu." << endl;
+
+  // A rotation does not keep the box aligned with the axes.
+  if (randomBasis && periodicBox != "")
+    Log::Fatal << "--random_basis cannot be used with --periodic_box." << endl;
+
+  // The tree indexes the reference set; it is either loaded now or built
+  // later.
+  typedef BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  TreeIndex<TreeType>* index = NULL;
+
+  // A reference set in the mlpack binary format (.mbin) is memory-mapped
+  // instead of being read.
+  data::MappedMatrix<double> reference;
   arma::mat queryData; // So it doesn't go out of scope.
-  data::Load(referenceFile, referenceData, true);
+  if (indexFile != "")
+  {
+    Timer::Start("loading_index");
+    index = new TreeIndex<TreeType>(indexFile);
+    Timer::Stop("loading_index");
+  }
+  else
+  {
+    reference.Load(referenceFile, true);
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << reference.Matrix().n_rows << " x " << reference.Matrix().n_cols
+        << ")." << endl;
+  }
+  arma::mat& referenceData = reference.Matrix();
+
+  const size_t referencePoints = (index == NULL) ? referenceData.n_cols :
+      index->Dataset().n_cols;
 
-  if (queryFile != "")
+  if (queryFile != "" && queryChunk == 0)
   {
     data::Load(queryFile, queryData, true);
     Log::Info << "Loaded query data from '" << queryFile << "' ("
@@ -117,11 +566,11 @@ int main(int argc, char *argv[])
 
   // Sanity check on k value: must be greater than 0, must be less than the
   // number of reference points.
-  if (k > referenceData.n_cols)
+  if (k > referencePoints)
   {
     Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
     Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
+    Log::Fatal << referencePoints << ")." << endl;
   }
 
   // Sanity check on leaf size.
@@ -132,12 +581,49 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // Sanity check on number of threads.
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0.0)
+  {
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be greater than "
+        << "or equal to 0." << endl;
+  }
+
+  const int medianSamples = CLI::GetParam<int>("median_samples");
+  if (medianSamples < 0)
+  {
+    Log::Fatal << "Invalid number of median samples: " << medianSamples
+        << ".  Must be greater than or equal to 0." << endl;
+  }
+
+  const bool mortonOrder = CLI::HasParam("morton_build");
+  if (mortonOrder && medianSamples > 0)
+    Log::Warn << "--median_samples ignored because --morton_build is present."
+        << endl;
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
   }
 
+  if (naive && epsilon > 0.0)
+  {
+    Log::Warn << "--epsilon ignored because --naive is present." << endl;
+  }
+
+  // The GPU search does not traverse the trees, so unless a tree index is
+  // used they are built with a single leaf.
+  if (gpu && indexFile == "" && saveIndexFile == "")
+    naive = true;
+
   if (naive)
     leafSize = referenceData.n_cols;
 
@@ -178,30 +664,131 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (autoTune)
+  {
+    Log::Info << "Tuning the trees..." << endl;
+    Timer::Start("tuning");
+
+    // Only kd-trees can search the query set in chunks.
+    TreeTuner tuner((size_t) CLI::GetParam<int>("tune_samples"),
+        queryChunk == 0);
+    KNNProbe probe(k, singleMode);
+    const TreeConfiguration best = tuner.Tune(referenceData, probe);
+    coverTree = best.coverTree;
+    leafSize = best.leafSize;
+
+    Timer::Stop("tuning");
+    if (coverTree)
+      Log::Info << "Chose cover trees." << endl;
+    else
+      Log::Info << "Chose kd-trees with leaf size " << leafSize << "." << endl;
+  }
+
+  if (queryChunk > 0)
+  {
+    const BuildOptions options(leafSize, (size_t) threads,
+        (size_t) medianSamples, mortonOrder);
+    if (index == NULL)
+    {
+      Log::Info << "Building reference tree..." << endl;
+      Timer::Start("tree_building");
+      index = new TreeIndex<TreeType>(referenceData, options);
+      Timer::Stop("tree_building");
+    }
+
+    if (saveIndexFile != "")
+    {
+      Log::Info << "Saving tree index to '" << saveIndexFile << "'..." << endl;
+      index->Save(saveIndexFile);
+    }
+
+    index->Tree().Flatten();
+
+    data::ChunkWriter<size_t>* neighborsWriter = (neighborsFile == "") ? NULL :
+        new data::ChunkWriter<size_t>(neighborsFile, k);
+    data::ChunkWriter<double>* distancesWriter = (distancesFile == "") ? NULL :
+        new data::ChunkWriter<double>(distancesFile, k);
+
+    Log::Info << "Computing " << k << " nearest neighbors of the queries in "
+        << "chunks of " << queryChunk << " points..." << endl;
+    KNNChunkSearch<TreeType> stages(index->Tree(), index->Dataset(),
+        index->OldFromNew(), k, singleMode, options, epsilon, neighborsWriter,
+        distancesWriter);
+    data::ChunkReader<double> reader(queryFile, (size_t) queryChunk);
+    const size_t queries = reader.Pipeline(stages);
+    Log::Info << "Neighbors of " << queries << " queries computed." << endl;
+
+    delete neighborsWriter;
+    delete distancesWriter;
+    delete index;
+    return 0;
+  }
+
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
-  if (!CLI::HasParam("cover_tree"))
+  if (ballTree)
+  {
+    // Ball trees are binary space trees whose nodes are bounded by balls.
+    typedef BinarySpaceTree<bound::BallBound<>,
+        NeighborSearchStat<NearestNeighborSort> > BallTreeType;
+
+    Log::Info << "Using ball trees for nearest-neighbor calculation." << endl;
+
+    BinarySpaceTreeSearch<BallTreeType>(referenceData, queryData, k, leafSize,
+        naive, singleMode, threads, medianSamples, mortonOrder, epsilon,
+        symmetric,
+        metric::EuclideanDistance(), neighbors, distances);
+  }
+  else if (periodicBox != "")
+  {
+    // The bounds of periodic kd-trees and the periodic metric use the nearest
+    // periodic image of each point, so the points are not replicated.
+    typedef BinarySpaceTree<bound::PeriodicHRectBound<2>,
+        NeighborSearchStat<NearestNeighborSort> > PeriodicTreeType;
+
+    const arma::vec box = PeriodicBox(periodicBox, referenceData.n_rows);
+    Log::Info << "Using periodic kd-trees with box " << trans(box);
+
+    BinarySpaceTreeSearch<PeriodicTreeType>(referenceData, queryData, k,
+        leafSize, naive, singleMode, threads, medianSamples, mortonOrder,
+        epsilon,
+        symmetric, metric::PeriodicEuclideanDistance(box), neighbors,
+        distances);
+  }
+  else if (!coverTree)
   {
     // Because we may construct it differently, we need a pointer.
     AllkNN* allknn = NULL;
 
-    // Mappings for when we build the tree.
-    std::vector<size_t> oldFromNewRefs;
-
     // Build trees by hand, so we can save memory: if we pass a tree to
-    // NeighborSearch, it does not copy the matrix.
-    Log::Info << "Building reference tree..." << endl;
-    Timer::Start("tree_building");
+    // NeighborSearch, it does not copy the matrix.  If the reference tree was
+    // loaded from an index, it is not built again.
+    if (index == NULL)
+    {
+      Log::Info << "Building reference tree..." << endl;
+      Timer::Start("tree_building");
 
-    BinarySpaceTree<bound::HRectBound<2>,
-        NeighborSearchStat<NearestNeighborSort> >
-        refTree(referenceData, oldFromNewRefs, leafSize);
-    BinarySpaceTree<bound::HRectBound<2>,
-        NeighborSearchStat<NearestNeighborSort> >*
-        queryTree = NULL; // Empty for now.
+      index = new TreeIndex<TreeType>(referenceData, BuildOptions(leafSize,
+          (size_t) threads, (size_t) medianSamples, mortonOrder));
 
-    Timer::Stop("tree_building");
+      Timer::Stop("tree_building");
+    }
+
+    if (saveIndexFile != "")
+    {
+      Log::Info << "Saving tree index to '" << saveIndexFile << "'..." << endl;
+      index->Save(saveIndexFile);
+    }
+
+    // Keep the nodes of the tree together in memory, for faster traversal.
+    TreeType& refTree = index->Tree();
+    refTree.Flatten();
+    const arma::mat& refData = index->Dataset();
+    // Mappings for when we build the tree.
+    const std::vector<size_t>& oldFromNewRefs = index->OldFromNew();
+
+    TreeType* queryTree = NULL; // Empty for now.
 
     std::vector<size_t> oldFromNewQueries;
 
@@ -221,21 +808,21 @@ int main(int argc, char *argv[])
       {
         Timer::Start("tree_building");
 
-        queryTree = new BinarySpaceTree<bound::HRectBound<2>,
-            NeighborSearchStat<NearestNeighborSort> >(queryData,
-            oldFromNewQueries, leafSize);
+        queryTree = new TreeType(queryData, oldFromNewQueries,
+            BuildOptions(leafSize, (size_t) threads, (size_t) medianSamples,
+            mortonOrder));
+        queryTree->Flatten();
 
         Timer::Stop("tree_building");
       }
 
-      allknn = new AllkNN(&refTree, queryTree, referenceData, queryData,
-          singleMode);
+      allknn = new AllkNN(&refTree, queryTree, refData, queryData, singleMode);
 
       Log::Info << "Tree built." << endl;
     }
     else
     {
-      allknn = new AllkNN(&refTree, referenceData, singleMode);
+      allknn = new AllkNN(&refTree, refData, singleMode);
 
       Log::Info << "Trees built." << endl;
     }
@@ -244,6 +831,10 @@ int main(int argc, char *argv[])
     arma::Mat<size_t> neighborsOut;
 
     Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+    allknn->Threads() = (size_t) threads;
+    allknn->Epsilon() = epsilon;
+    allknn->Symmetric() = symmetric;
+    allknn->GPU() = gpu;
     allknn->Search(k, neighborsOut, distancesOut);
 
     Log::Info << "Neighbors computed." << endl;
@@ -267,25 +858,26 @@ int main(int argc, char *argv[])
       delete queryTree;
 
     delete allknn;
+    delete index;
   }
   else // Cover trees.
   {
     // Make sure to notify the user that they are using cover trees.
     Log::Info << "Using cover trees for nearest-neighbor calculation." << endl;
 
+    // Cover trees need the base case cache of the statistic.
+    typedef CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
+        NeighborSearchStat<NearestNeighborSort, true> > CoverTreeType;
+
     // Build our reference tree.
     Log::Info << "Building reference tree..." << endl;
     Timer::Start("tree_building");
-    CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        NeighborSearchStat<NearestNeighborSort> > referenceTree(referenceData,
-        1.3);
-    CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        NeighborSearchStat<NearestNeighborSort> >* queryTree = NULL;
+    CoverTreeType referenceTree(referenceData, 1.3, NULL, (size_t) threads);
+    CoverTreeType* queryTree = NULL;
     Timer::Stop("tree_building");
 
     NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-        CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        NeighborSearchStat<NearestNeighborSort> > >* allknn = NULL;
+        CoverTreeType>* allknn = NULL;
 
     // See if we have query data.
     if (CLI::HasParam("query_file"))
@@ -295,26 +887,23 @@ int main(int argc, char *argv[])
       {
         Log::Info << "Building query tree..." << endl;
         Timer::Start("tree_building");
-        queryTree = new CoverTree<metric::LMetric<2, true>,
-            tree::FirstPointIsRoot, NeighborSearchStat<NearestNeighborSort> >(
-            queryData, 1.3);
+        queryTree = new CoverTreeType(queryData, 1.3, NULL, (size_t) threads);
         Timer::Stop("tree_building");
       }
 
       allknn = new NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-          CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-          NeighborSearchStat<NearestNeighborSort> > >(&referenceTree, queryTree,
-          referenceData, queryData, singleMode);
+          CoverTreeType>(&referenceTree, queryTree, referenceData, queryData,
+          singleMode);
     }
     else
     {
       allknn = new NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-          CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-          NeighborSearchStat<NearestNeighborSort> > >(&referenceTree,
-          referenceData, singleMode);
+          CoverTreeType>(&referenceTree, referenceData, singleMode);
     }
 
     Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+    allknn->Threads() = (size_t) threads;
+    allknn->Epsilon() = epsilon;
     allknn->Search(k, neighbors, distances);
 
     Log::Info << "Neighbors computed." << endl;
@@ -326,6 +915,21 @@ int main(int argc, char *argv[])
   }
 
   // Save output.
-  data::Save(distancesFile, distances);
-  data::Save(neighborsFile, neighbors);
+  if (distancesFile != "")
+    data::Save(distancesFile, distances, false, true, (size_t) threads);
+  if (neighborsFile != "")
+    data::Save(neighborsFile, neighbors, false, true, (size_t) threads);
+
+  if (graphFile != "")
+  {
+    Log::Info << "Building kNN graph..." << endl;
+    Timer::Start("graph_building");
+    arma::sp_mat graph;
+    KNNGraph(neighbors, distances, graph, bandwidth, CLI::HasParam("mutual"));
+    Timer::Stop("graph_building");
+
+    Log::Info << "kNN graph has " << graph.n_nonzero << " nonzero entries."
+        << endl;
+    data::Save(graphFile, graph, true);
+  }
 }
@@ -0,0 +1,215 @@
+/**
+ * @file allknn_mpi_main.cpp
+ *
+ * Executable for exact k-nearest-neighbor search over a reference set which is
+ * partitioned between the processes of an MPI job.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <mpi.h>
+
+#include "distributed_neighbor_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::tree;
+
+PROGRAM_INFO("Distributed All K-Nearest-Neighbors", "This program finds the "
+    "exact k nearest neighbors (in Euclidean distance) in a reference set which"
+    " is partitioned between the processes (ranks) of an MPI job, such as one "
+    "started with mpirun.  Each rank loads one shard of the reference set and "
+    "builds a kd-tree on it; the bounding boxes of the shards are exchanged, so"
+    " that each query point is only searched for on the ranks which may hold "
+    "one of its neighbors."
+    "\n\n"
+    "If --reference_file contains \"{rank}\", each rank loads the file named by"
+    " replacing it with its rank (for instance, data.{rank}.csv); otherwise, "
+    "every rank loads the whole file and keeps an equal block of its points.  "
+    "The points are numbered in rank order, and the neighbor indices are these "
+    "global numbers."
+    "\n\n"
+    "Without --query_file, the neighbors of the points of each shard are found,"
+    " and each rank saves those of its own points to --neighbors_file and "
+    "--distances_file, in which \"{rank}\" is replaced in the same way (it "
+    "should be given if there is more than one rank).  If --query_file contains"
+    " \"{rank}\", each rank loads its own query points, which are routed to "
+    "the shards that may hold their neighbors, and saves their neighbors.  "
+    "Otherwise, the first rank loads the query points and sends them to every "
+    "rank; each rank searches its shard, the results are merged by a reduction"
+    " towards the first rank, and the first rank saves them."
+    "\n\n"
+    "Spatially partitioned shards (for instance, contiguous blocks of points "
+    "sorted along a space-filling curve) let most queries be answered by one "
+    "rank.");
+
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset (or "
+    "the shards, if it contains \"{rank}\").", "r");
+PARAM_STRING("query_file", "File containing query points (optional).", "q",
+    "");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_INT("threads", "Number of threads each rank uses for tree building and "
+    "search (0 uses all available cores).  This only has an effect if MLPACK "
+    "was built with OpenMP.", "j", 0);
+
+//! Replace each "{rank}" in the given file name with the given rank.
+string RankFile(const string& name, const int rank)
+{
+  ostringstream rankString;
+  rankString << rank;
+
+  string file(name);
+  size_t position;
+  while ((position = file.find("{rank}")) != string::npos)
+    file.replace(position, 6, rankString.str());
+
+  return file;
+}
+
+//! Whether the given file name names a different file for each rank.
+bool PerRank(const string& name)
+{
+  return name.find("{rank}") != string::npos;
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank, ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+  CLI::ParseCommandLine(argc, argv);
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string queryFile = CLI::GetParam<string>("query_file");
+  const string distancesFile = CLI::GetParam<string>("distances_file");
+  const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const int k = CLI::GetParam<int>("k");
+  const int leafSize = CLI::GetParam<int>("leaf_size");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (distancesFile == "" && neighborsFile == "")
+    Log::Fatal << "At least one of --distances_file and --neighbors_file must "
+        << "be given." << endl;
+  if (k <= 0)
+    Log::Fatal << "Invalid k: " << k << ".  Must be greater than 0." << endl;
+  if (leafSize <= 0)
+    Log::Fatal << "Invalid leaf size: " << leafSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be 0 "
+        << "or greater." << endl;
+
+  // Only the first rank saves the results of replicated queries; otherwise,
+  // each rank needs its own output files.
+  const bool replicated = (queryFile != "") && !PerRank(queryFile);
+  if (!replicated && ranks > 1 &&
+      ((distancesFile != "" && !PerRank(distancesFile)) ||
+       (neighborsFile != "" && !PerRank(neighborsFile))))
+    Log::Fatal << "--distances_file and --neighbors_file must contain "
+        << "\"{rank}\" when each rank saves its own results." << endl;
+
+  arma::mat referenceData;
+  if (PerRank(referenceFile))
+  {
+    data::Load(RankFile(referenceFile, rank), referenceData, true);
+  }
+  else
+  {
+    arma::mat allData;
+    data::Load(referenceFile, allData, true);
+
+    const size_t begin = allData.n_cols * rank / ranks;
+    const size_t end = allData.n_cols * (rank + 1) / ranks;
+    if (end > begin)
+      referenceData = allData.cols(begin, end - 1);
+  }
+
+  Log::Info << "Rank " << rank << " loaded " << referenceData.n_cols
+      << " reference points." << endl;
+
+  Log::Info << "Building reference trees..." << endl;
+  Timer::Start("tree_building");
+  DistributedNeighborSearch<> knn(referenceData, MPI_COMM_WORLD,
+      BuildOptions((size_t) leafSize, (size_t) threads));
+  Timer::Stop("tree_building");
+  knn.Threads() = (size_t) threads;
+
+  Log::Info << "The shards hold " << knn.TotalPoints() << " points in all."
+      << endl;
+
+  // The reference set is copied by the search object.
+  referenceData.reset();
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  if (replicated)
+  {
+    // Send the query points from the first rank to every rank.
+    arma::mat queryData;
+    if (rank == 0)
+      data::Load(queryFile, queryData, true);
+
+    unsigned long long size[2] = { queryData.n_rows, queryData.n_cols };
+    MPI_Bcast(size, 2, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    queryData.set_size((size_t) size[0], (size_t) size[1]);
+    MPI_Bcast(queryData.memptr(), (int) queryData.n_elem, MPI_DOUBLE, 0,
+        MPI_COMM_WORLD);
+
+    Log::Info << "Computing " << k << " nearest neighbors of "
+        << queryData.n_cols << " query points..." << endl;
+    knn.SearchReplicated(queryData, (size_t) k, neighbors, distances);
+  }
+  else if (queryFile != "")
+  {
+    arma::mat queryData;
+    data::Load(RankFile(queryFile, rank), queryData, true);
+
+    Log::Info << "Computing " << k << " nearest neighbors of "
+        << queryData.n_cols << " query points..." << endl;
+    knn.Search(queryData, (size_t) k, neighbors, distances);
+  }
+  else
+  {
+    Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+    knn.Search((size_t) k, neighbors, distances);
+  }
+
+  if (!replicated)
+    Log::Info << "Rank " << rank << " sent " << knn.QueriesSent()
+        << " queries to other ranks and answered " << knn.QueriesReceived()
+        << " of theirs." << endl;
+
+  if (!replicated || rank == 0)
+  {
+    if (distancesFile != "")
+      data::Save(RankFile(distancesFile, rank), distances);
+    if (neighborsFile != "")
+      data::Save(RankFile(neighborsFile, rank), neighbors);
+  }
+
+  MPI_Finalize();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file candidate_heap.hpp
+ *
+ * A bounded heap of neighbor candidates, which is used instead of a sorted
+ * list when many neighbors are searched for.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The candidates of a query point are usually kept as a sorted list (the best
+ * first), so a new candidate is inserted by shifting every worse candidate;
+ * this takes O(k) time, which is fine for small k but not when k is in the
+ * hundreds or thousands.  Instead, for k of at least MinK, the k candidates are
+ * kept as a binary heap with the worst candidate at the root, so a new
+ * candidate is inserted in O(log k) time and the k'th best distance (which is
+ * used for pruning) is still read in O(1) time.  Once the search is finished,
+ * Sort() puts each list in the usual order.
+ *
+ * The heap uses the same storage as the sorted list: a column of distances and
+ * a column of indices, filled with SortPolicy::WorstDistance() (or any other
+ * single value) at the start.  The order is given by SortPolicy::IsBetter(), so
+ * any of the sort policies of NeighborSearch (NearestNeighborSort,
+ * FurthestNeighborSort) may be used; FurthestNeighborSort also orders the
+ * kernel values of FastMKS.
+ *
+ * @tparam SortPolicy The sort policy which gives the order of the candidates.
+ */
+template<typename SortPolicy>
+class CandidateHeap
+{
+ public:
+  //! Lists of at least this many candidates are kept as heaps.
+  static const size_t MinK = 64;
+
+  //! Return whether a list of k candidates should be kept as a heap.
+  static bool Use(const size_t k) { return (k >= MinK); }
+
+  /**
+   * Return the row of the worst candidate in a list of k candidates: the root
+   * of the heap, or the last row of a sorted list.
+   */
+  static size_t WorstRow(const size_t k) { return Use(k) ? 0 : (k - 1); }
+
+  /**
+   * Insert a candidate into the given heap of k candidates, if it is at least
+   * as good as the worst candidate (which is then dropped).
+   *
+   * @param distances Distances of the candidates (k elements).
+   * @param indices Indices of the candidates (k elements).
+   * @param k Number of candidates.
+   * @param distance Distance of the new candidate.
+   * @param index Index of the new candidate.
+   * @return Whether the candidate was inserted.
+   */
+  static bool Insert(double* distances,
+                     size_t* indices,
+                     const size_t k,
+                     const double distance,
+                     const size_t index)
+  {
+    if (SortPolicy::IsBetter(distances[0], distance))
+      return false;
+
+    // The new candidate replaces the root, and moves down until it is not
+    // better than its worst child.
+    size_t i = 0;
+    while (2 * i + 1 < k)
+    {
+      size_t child = 2 * i + 1;
+      if ((child + 1 < k) &&
+          SortPolicy::IsBetter(distances[child], distances[child + 1]))
+        ++child;
+
+      if (!SortPolicy::IsBetter(distance, distances[child]))
+        break;
+
+      distances[i] = distances[child];
+      indices[i] = indices[child];
+      i = child;
+    }
+
+    distances[i] = distance;
+    indices[i] = index;
+    return true;
+  }
+
+  /**
+   * Sort the given heap of k candidates, so that the best candidate is first
+   * (this is a heapsort).  Afterwards the list is no longer a heap.
+   */
+  static void Sort(double* distances, size_t* indices, const size_t k)
+  {
+    for (size_t end = k; end > 1; --end)
+    {
+      // Move the worst remaining candidate to the end, and restore the heap
+      // with the last candidate from the root.
+      const double distance = distances[end - 1];
+      const size_t index = indices[end - 1];
+      distances[end - 1] = distances[0];
+      indices[end - 1] = indices[0];
+
+      size_t i = 0;
+      while (2 * i + 1 < end - 1)
+      {
+        size_t child = 2 * i + 1;
+        if ((child + 1 < end - 1) &&
+            SortPolicy::IsBetter(distances[child], distances[child + 1]))
+          ++child;
+
+        if (!SortPolicy::IsBetter(distance, distances[child]))
+          break;
+
+        distances[i] = distances[child];
+        indices[i] = indices[child];
+        i = child;
+      }
+
+      distances[i] = distance;
+      indices[i] = index;
+    }
+  }
+
+  /**
+   * Sort every column of the given matrices, if they hold heaps (that is, if
+   * Use() is true for their number of rows).
+   */
+  static void Sort(arma::mat& distances, arma::Mat<size_t>& indices)
+  {
+    if (!Use(distances.n_rows))
+      return;
+
+    for (size_t i = 0; i < distances.n_cols; ++i)
+      Sort(distances.colptr(i), indices.colptr(i), distances.n_rows);
+  }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * @file distributed_neighbor_search.hpp
+ *
+ * Exact k-nearest-neighbor search over a reference set which is partitioned
+ * between the processes of an MPI communicator.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+
+#include <mpi.h>
+
+#include "query_server.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * A DistributedNeighborSearch finds exact k nearest neighbors (in Euclidean
+ * distance) in a reference set which is too large for one machine, and which
+ * is split into shards, one for each process (rank) of an MPI communicator.
+ * Each rank builds a tree on its own shard only (with a QueryServer), and the
+ * ranks exchange the bounding boxes of their shards, so that every rank knows
+ * roughly where the points of the others lie.
+ *
+ * The points of the whole reference set are numbered in rank order: the
+ * points of rank r are numbered from Offset() of rank r on, in the order of
+ * its shard.  All neighbor indices returned are these global indices.
+ *
+ * There are two kinds of search:
+ *
+ *  - Search() with a query set on each rank (or with none, to search the
+ *    shards themselves) routes the queries.  Each rank first finds the k
+ *    nearest neighbors of its queries in its own shard, and then sends each
+ *    query only to the ranks whose bounding box is closer to it than its k'th
+ *    neighbor so far; those ranks search their shard and send back their k
+ *    best, which are merged with the local ones.  When the shards are
+ *    partitioned spatially (for instance, by a coarse kd-tree split or a
+ *    space-filling curve; see data::SpaceFillingCurveOrder()), most queries
+ *    never leave their rank.
+ *
+ *  - SearchReplicated(), with the same query set on every rank, searches each
+ *    shard for all the queries and merges the k best of every rank with a
+ *    reduction (MPI_Reduce() with a merging operation), which MPI performs as
+ *    a tree, so the results reach the root in a logarithmic number of steps.
+ *
+ * Every method is collective: all ranks of the communicator must call it, with
+ * the same k.  When candidates from different ranks are at equal distances,
+ * the one with the lower global index is kept.
+ *
+ * @code
+ * DistributedNeighborSearch<> knn(localShard, MPI_COMM_WORLD);
+ * knn.Search(5, neighbors, distances); // Neighbors of the points of the shard.
+ * @endcode
+ *
+ * @tparam TreeType Type of tree to build on each shard (see QueryServer).  The
+ *     points must be of type double.
+ */
+template<typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > >
+class DistributedNeighborSearch
+{
+ public:
+  /**
+   * Build the tree on a copy of the shard of the reference set held by this
+   * rank (a second copy is kept in the original order, to search the shard
+   * itself), and exchange the bounding boxes of the shards.  This is
+   * collective; every shard must have the same dimensionality, and shards may
+   * be empty.
+   *
+   * @param localReferenceSet The points of the reference set held by this rank.
+   * @param communicator Communicator of the ranks holding the shards.
+   * @param options Options for building the tree (see tree::BuildOptions).
+   */
+  DistributedNeighborSearch(
+      const arma::mat& localReferenceSet,
+      MPI_Comm communicator = MPI_COMM_WORLD,
+      const tree::BuildOptions& options = tree::BuildOptions());
+
+  /**
+   * Delete the tree.
+   */
+  ~DistributedNeighborSearch();
+
+  /**
+   * Find the k nearest neighbors in the whole reference set of each point of
+   * the shard of this rank, excluding the point itself (as NeighborSearch does
+   * when the query set is the reference set).  The queries are routed as
+   * described above.  k must be less than the total number of points.
+   *
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the global indices of the neighbors in.
+   * @param distances Matrix to store the distances to the neighbors in.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Find the k nearest neighbors in the whole reference set of each point of
+   * the given query set of this rank; each rank may give a different query
+   * set (possibly empty).  The queries are routed as described above.  k must
+   * be at most the total number of points.
+   *
+   * @param querySet Query points of this rank.
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the global indices of the neighbors in.
+   * @param distances Matrix to store the distances to the neighbors in.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Find the k nearest neighbors in the whole reference set of each point of
+   * the given query set, which must be the same on every rank (for instance,
+   * broadcast from the root with MPI_Bcast()).  Each rank searches its own
+   * shard, and the results are merged by a reduction to the root rank; the
+   * results are only stored on the root, and the matrices are emptied on the
+   * other ranks.
+   *
+   * @param querySet Query points, the same on every rank.
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the global indices of the neighbors in.
+   * @param distances Matrix to store the distances to the neighbors in.
+   * @param root Rank which receives the results.
+   */
+  void SearchReplicated(const arma::mat& querySet,
+                        const size_t k,
+                        arma::Mat<size_t>& neighbors,
+                        arma::mat& distances,
+                        const int root = 0);
+
+  //! Get the rank of this process in the communicator.
+  int Rank() const { return rank; }
+  //! Get the number of ranks in the communicator.
+  int Ranks() const { return ranks; }
+
+  //! Get the global index of the first point of the shard of this rank.
+  size_t Offset() const { return offsets[rank]; }
+  //! Get the number of points in the shard of this rank.
+  size_t LocalPoints() const { return offsets[rank + 1] - offsets[rank]; }
+  //! Get the number of points in the whole reference set.
+  size_t TotalPoints() const { return offsets[ranks]; }
+
+  //! Get the bounding boxes of the shards: column r holds the lower corner of
+  //! the box of rank r, followed by its upper corner.
+  const arma::mat& Bounds() const { return bounds; }
+
+  //! Get the number of threads used to search the shard (0 means the OpenMP
+  //! default).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to search the shard.
+  size_t& Threads() { return threads; }
+
+  //! Get the number of queries this rank sent to other ranks in the last
+  //! routed search.
+  size_t QueriesSent() const { return queriesSent; }
+  //! Get the number of queries this rank received from other ranks in the last
+  //! routed search.
+  size_t QueriesReceived() const { return queriesReceived; }
+
+ private:
+  //! The communicator of the ranks holding the shards.
+  MPI_Comm communicator;
+  //! The rank of this process.
+  int rank;
+  //! The number of ranks.
+  int ranks;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The global index of the first point of each shard, and the total number
+  //! of points (ranks + 1 elements).
+  std::vector<size_t> offsets;
+  //! The bounding box of each shard (see Bounds()).
+  arma::mat bounds;
+  //! The shard of this rank, in its original order.
+  arma::mat referenceSet;
+  //! The server searching the shard of this rank (NULL if it is empty).
+  QueryServer<TreeType>* server;
+  //! The number of threads used to search the shard.
+  size_t threads;
+
+  //! The number of queries sent to other ranks in the last routed search.
+  size_t queriesSent;
+  //! The number of queries received from other ranks in the last routed
+  //! search.
+  size_t queriesReceived;
+
+  /**
+   * Find the k nearest neighbors of the given queries in the shard of this
+   * rank, with global indices.  If fewer than k neighbors are found (because
+   * the shard is small), the rest of each column is filled with DBL_MAX and
+   * the index TotalPoints().  If self is true, the queries are the shard
+   * itself, and each point is not its own neighbor.
+   */
+  void SearchShard(const arma::mat& querySet,
+                   const size_t k,
+                   const bool self,
+                   arma::Mat<size_t>& neighbors,
+                   arma::mat& distances) const;
+
+  /**
+   * Route the queries to the shards which may hold closer neighbors than the
+   * local ones, and merge their results into the given neighbors and
+   * distances (which hold the results of the search of the local shard).
+   */
+  void Route(const arma::mat& querySet,
+             const size_t k,
+             arma::Mat<size_t>& neighbors,
+             arma::mat& distances);
+
+  //! Get the distance between the given point and the bounding box of the
+  //! shard of the given rank (DBL_MAX if the shard is empty).
+  double BoxDistance(const double* point, const int owner) const;
+
+  //! Check that k is at least 1 and at most the given limit, and that the
+  //! query points have the right dimensionality.
+  void CheckSearch(const arma::mat& querySet,
+                   const size_t k,
+                   const size_t limit) const;
+};
+
+/**
+ * Merge two lists of k candidate neighbors, each sorted by distance (ties by
+ * index), keeping the k best in the first list.
+ *
+ * @param k Number of candidates in each list.
+ * @param distances Distances of the first list; replaced by the merged list.
+ * @param indices Indices of the first list; replaced by the merged list.
+ * @param otherDistances Distances of the second list.
+ * @param otherIndices Indices of the second list.
+ */
+template<typename IndexType>
+void MergeCandidates(const size_t k,
+                     double* distances,
+                     IndexType* indices,
+                     const double* otherDistances,
+                     const IndexType* otherIndices);
+
+/**
+ * The MPI reduction operation used by SearchReplicated(): each element of the
+ * buffers holds the k candidates of one query point, as k distances followed
+ * by k indices (stored as doubles, which is exact for fewer than 2^53
+ * points), and the candidates of in are merged into those of inout.  k is
+ * found from the size of the datatype.
+ */
+inline void MergeReducedCandidates(void* in,
+                                   void* inout,
+                                   int* length,
+                                   MPI_Datatype* datatype);
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "distributed_neighbor_search_impl.hpp"
+
+#endif
@@ -0,0 +1,418 @@
+/**
+ * @file distributed_neighbor_search_impl.hpp
+ *
+ * Implementation of DistributedNeighborSearch: the exchange of the bounds of
+ * the shards, the routing of queries, and the merging of candidates.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NS_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "distributed_neighbor_search.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename TreeType>
+DistributedNeighborSearch<TreeType>::DistributedNeighborSearch(
+    const arma::mat& localReferenceSet,
+    MPI_Comm communicator,
+    const tree::BuildOptions& options) :
+    communicator(communicator),
+    referenceSet(localReferenceSet),
+    server(NULL),
+    threads(0),
+    queriesSent(0),
+    queriesReceived(0)
+{
+  MPI_Comm_rank(communicator, &rank);
+  MPI_Comm_size(communicator, &ranks);
+
+  // An empty shard may not know the dimensionality of the points.
+  const unsigned long long localDimensionality = referenceSet.n_rows;
+  unsigned long long globalDimensionality;
+  MPI_Allreduce((void*) &localDimensionality, &globalDimensionality, 1,
+      MPI_UNSIGNED_LONG_LONG, MPI_MAX, communicator);
+  dimensionality = (size_t) globalDimensionality;
+
+  if (referenceSet.n_cols > 0 && referenceSet.n_rows != dimensionality)
+    Log::Fatal << "DistributedNeighborSearch: the shard of rank " << rank
+        << " has dimensionality " << referenceSet.n_rows << ", but other "
+        << "shards have dimensionality " << dimensionality << "!" << std::endl;
+
+  // Number the points of the shards in rank order.
+  const unsigned long long localPoints = referenceSet.n_cols;
+  std::vector<unsigned long long> counts(ranks);
+  MPI_Allgather((void*) &localPoints, 1, MPI_UNSIGNED_LONG_LONG, &counts[0], 1,
+      MPI_UNSIGNED_LONG_LONG, communicator);
+
+  offsets.resize(ranks + 1, 0);
+  for (int r = 0; r < ranks; ++r)
+    offsets[r + 1] = offsets[r] + (size_t) counts[r];
+
+  // Exchange the bounding boxes; the box of an empty shard is inverted, so
+  // that no query is routed to it.
+  arma::vec box(2 * dimensionality);
+  if (referenceSet.n_cols == 0)
+  {
+    box.subvec(0, dimensionality - 1).fill(DBL_MAX);
+    box.subvec(dimensionality, 2 * dimensionality - 1).fill(-DBL_MAX);
+  }
+  else
+  {
+    box.subvec(0, dimensionality - 1) = arma::min(referenceSet, 1);
+    box.subvec(dimensionality, 2 * dimensionality - 1) =
+        arma::max(referenceSet, 1);
+  }
+
+  bounds.set_size(2 * dimensionality, ranks);
+  MPI_Allgather(box.memptr(), (int) box.n_elem, MPI_DOUBLE, bounds.memptr(),
+      (int) box.n_elem, MPI_DOUBLE, communicator);
+
+  if (referenceSet.n_cols > 0)
+    server = new QueryServer<TreeType>(referenceSet, options);
+}
+
+template<typename TreeType>
+DistributedNeighborSearch<TreeType>::~DistributedNeighborSearch()
+{
+  delete server;
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::Search(const size_t k,
+                                                 arma::Mat<size_t>& neighbors,
+                                                 arma::mat& distances)
+{
+  CheckSearch(referenceSet, k, TotalPoints() - 1);
+
+  Timer::Start("local_search");
+  SearchShard(referenceSet, k, true, neighbors, distances);
+  Timer::Stop("local_search");
+
+  Route(referenceSet, k, neighbors, distances);
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::Search(const arma::mat& querySet,
+                                                 const size_t k,
+                                                 arma::Mat<size_t>& neighbors,
+                                                 arma::mat& distances)
+{
+  CheckSearch(querySet, k, TotalPoints());
+
+  Timer::Start("local_search");
+  SearchShard(querySet, k, false, neighbors, distances);
+  Timer::Stop("local_search");
+
+  Route(querySet, k, neighbors, distances);
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::SearchReplicated(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances,
+    const int root)
+{
+  CheckSearch(querySet, k, TotalPoints());
+
+  Timer::Start("local_search");
+  arma::Mat<size_t> localNeighbors;
+  arma::mat localDistances;
+  SearchShard(querySet, k, false, localNeighbors, localDistances);
+  Timer::Stop("local_search");
+
+  // Each query point is one element of the reduction.
+  arma::mat candidates(2 * k, querySet.n_cols);
+  candidates.rows(0, k - 1) = localDistances;
+  candidates.rows(k, 2 * k - 1) =
+      arma::conv_to<arma::mat>::from(localNeighbors);
+
+  MPI_Datatype candidateType;
+  MPI_Type_contiguous((int) (2 * k), MPI_DOUBLE, &candidateType);
+  MPI_Type_commit(&candidateType);
+
+  MPI_Op merge;
+  MPI_Op_create(&MergeReducedCandidates, 1, &merge);
+
+  Timer::Start("reduction");
+  arma::mat merged;
+  if (rank == root)
+    merged.set_size(2 * k, querySet.n_cols);
+  MPI_Reduce(candidates.memptr(), merged.memptr(), (int) querySet.n_cols,
+      candidateType, merge, root, communicator);
+  Timer::Stop("reduction");
+
+  MPI_Op_free(&merge);
+  MPI_Type_free(&candidateType);
+
+  if (rank == root)
+  {
+    distances = merged.rows(0, k - 1);
+    neighbors = arma::conv_to<arma::Mat<size_t> >::from(
+        merged.rows(k, 2 * k - 1));
+  }
+  else
+  {
+    neighbors.reset();
+    distances.reset();
+  }
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::SearchShard(
+    const arma::mat& querySet,
+    const size_t k,
+    const bool self,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances) const
+{
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(TotalPoints());
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(DBL_MAX);
+
+  // When the queries are the shard itself, one more neighbor is found, so that
+  // the point itself can be dropped.
+  const size_t localK = std::min(self ? k + 1 : k, LocalPoints());
+  if (querySet.n_cols == 0 || server == NULL || (self && localK == 1))
+    return;
+
+  server->Threads() = threads;
+  arma::Mat<size_t> localNeighbors;
+  arma::mat localDistances;
+  server->Search(querySet, localK, localNeighbors, localDistances);
+
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    size_t j = 0;
+    for (size_t l = 0; (l < localK) && (j < k); ++l)
+    {
+      if (self && localNeighbors(l, i) == i)
+        continue;
+
+      neighbors(j, i) = Offset() + localNeighbors(l, i);
+      distances(j, i) = localDistances(l, i);
+      ++j;
+    }
+  }
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::Route(const arma::mat& querySet,
+                                                const size_t k,
+                                                arma::Mat<size_t>& neighbors,
+                                                arma::mat& distances)
+{
+  Timer::Start("routing");
+
+  // Send each query to the shards which may hold a closer neighbor than its
+  // k'th one so far.
+  std::vector<std::vector<size_t> > routed(ranks);
+  for (int r = 0; r < ranks; ++r)
+  {
+    if (r == rank)
+      continue;
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      if (BoxDistance(querySet.colptr(i), r) < distances(k - 1, i))
+        routed[r].push_back(i);
+  }
+
+  // The counts are in points and in lists of candidates, so that they fit in
+  // an int for large shards.
+  std::vector<int> sendCounts(ranks), sendOffsets(ranks);
+  std::vector<int> receiveCounts(ranks), receiveOffsets(ranks);
+  for (int r = 0; r < ranks; ++r)
+    sendCounts[r] = (int) routed[r].size();
+
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &receiveCounts[0], 1, MPI_INT,
+      communicator);
+
+  queriesSent = 0;
+  queriesReceived = 0;
+  for (int r = 0; r < ranks; ++r)
+  {
+    sendOffsets[r] = (int) queriesSent;
+    receiveOffsets[r] = (int) queriesReceived;
+    queriesSent += sendCounts[r];
+    queriesReceived += receiveCounts[r];
+  }
+
+  arma::mat outgoing(dimensionality, queriesSent);
+  for (int r = 0; r < ranks; ++r)
+    for (size_t j = 0; j < routed[r].size(); ++j)
+      outgoing.col(sendOffsets[r] + j) = querySet.col(routed[r][j]);
+
+  MPI_Datatype pointType, distanceType, indexType;
+  MPI_Type_contiguous((int) dimensionality, MPI_DOUBLE, &pointType);
+  MPI_Type_contiguous((int) k, MPI_DOUBLE, &distanceType);
+  MPI_Type_contiguous((int) k, MPI_UNSIGNED_LONG_LONG, &indexType);
+  MPI_Type_commit(&pointType);
+  MPI_Type_commit(&distanceType);
+  MPI_Type_commit(&indexType);
+
+  arma::mat incoming(dimensionality, queriesReceived);
+  MPI_Alltoallv(outgoing.memptr(), &sendCounts[0], &sendOffsets[0], pointType,
+      incoming.memptr(), &receiveCounts[0], &receiveOffsets[0], pointType,
+      communicator);
+  Timer::Stop("routing");
+
+  // Answer the queries of the other ranks.
+  Timer::Start("remote_search");
+  arma::Mat<size_t> remoteNeighbors;
+  arma::mat remoteDistances;
+  SearchShard(incoming, k, false, remoteNeighbors, remoteDistances);
+  Timer::Stop("remote_search");
+
+  // Send the answers back, in the order the queries were received.
+  Timer::Start("merging");
+  std::vector<unsigned long long> remoteIndices(remoteNeighbors.begin(),
+      remoteNeighbors.end());
+  std::vector<unsigned long long> answerIndices(k * queriesSent);
+  arma::mat answerDistances(k, queriesSent);
+
+  MPI_Alltoallv(remoteDistances.memptr(), &receiveCounts[0],
+      &receiveOffsets[0], distanceType, answerDistances.memptr(),
+      &sendCounts[0], &sendOffsets[0], distanceType, communicator);
+  MPI_Alltoallv(remoteIndices.empty() ? NULL : &remoteIndices[0],
+      &receiveCounts[0], &receiveOffsets[0], indexType,
+      answerIndices.empty() ? NULL : &answerIndices[0], &sendCounts[0],
+      &sendOffsets[0], indexType, communicator);
+
+  MPI_Type_free(&pointType);
+  MPI_Type_free(&distanceType);
+  MPI_Type_free(&indexType);
+
+  for (int r = 0; r < ranks; ++r)
+  {
+    for (size_t j = 0; j < routed[r].size(); ++j)
+    {
+      const size_t answer = sendOffsets[r] + j;
+      const size_t query = routed[r][j];
+
+      arma::Col<size_t> answerNeighbors(k);
+      for (size_t l = 0; l < k; ++l)
+        answerNeighbors[l] = (size_t) answerIndices[answer * k + l];
+
+      MergeCandidates(k, distances.colptr(query), neighbors.colptr(query),
+          answerDistances.colptr(answer), answerNeighbors.memptr());
+    }
+  }
+  Timer::Stop("merging");
+}
+
+template<typename TreeType>
+double DistributedNeighborSearch<TreeType>::BoxDistance(
+    const double* point,
+    const int owner) const
+{
+  if (offsets[owner + 1] == offsets[owner])
+    return DBL_MAX;
+
+  const double* lower = bounds.colptr(owner);
+  const double* upper = lower + dimensionality;
+
+  double sum = 0.0;
+  for (size_t d = 0; d < dimensionality; ++d)
+  {
+    if (point[d] < lower[d])
+      sum += (lower[d] - point[d]) * (lower[d] - point[d]);
+    else if (point[d] > upper[d])
+      sum += (point[d] - upper[d]) * (point[d] - upper[d]);
+  }
+
+  return std::sqrt(sum);
+}
+
+template<typename TreeType>
+void DistributedNeighborSearch<TreeType>::CheckSearch(
+    const arma::mat& querySet,
+    const size_t k,
+    const size_t limit) const
+{
+  if (querySet.n_cols > 0 && querySet.n_rows != dimensionality)
+    Log::Fatal << "DistributedNeighborSearch::Search(): query points have "
+        << "dimensionality " << querySet.n_rows << ", but reference points "
+        << "have dimensionality " << dimensionality << "!" << std::endl;
+  if (k == 0 || k > limit)
+    Log::Fatal << "DistributedNeighborSearch::Search(): k must be between 1 "
+        << "and " << limit << "; " << k << " given!" << std::endl;
+}
+
+template<typename IndexType>
+void MergeCandidates(const size_t k,
+                     double* distances,
+                     IndexType* indices,
+                     const double* otherDistances,
+                     const IndexType* otherIndices)
+{
+  std::vector<double> mergedDistances(k);
+  std::vector<IndexType> mergedIndices(k);
+
+  // Only k candidates are taken, so neither list runs out.
+  size_t a = 0;
+  size_t b = 0;
+  for (size_t i = 0; i < k; ++i)
+  {
+    const bool other = (otherDistances[b] < distances[a]) ||
+        (otherDistances[b] == distances[a] && otherIndices[b] < indices[a]);
+    if (other)
+    {
+      mergedDistances[i] = otherDistances[b];
+      mergedIndices[i] = otherIndices[b++];
+    }
+    else
+    {
+      mergedDistances[i] = distances[a];
+      mergedIndices[i] = indices[a++];
+    }
+  }
+
+  std::copy(mergedDistances.begin(), mergedDistances.end(), distances);
+  std::copy(mergedIndices.begin(), mergedIndices.end(), indices);
+}
+
+inline void MergeReducedCandidates(void* in,
+                                   void* inout,
+                                   int* length,
+                                   MPI_Datatype* datatype)
+{
+  int size;
+  MPI_Type_size(*datatype, &size);
+  const size_t k = size / (2 * sizeof(double));
+
+  const double* other = (const double*) in;
+  double* candidates = (double*) inout;
+  for (int i = 0; i < *length; ++i)
+  {
+    MergeCandidates(k, candidates, candidates + k, other, other + k);
+    candidates += 2 * k;
+    other += 2 * k;
+  }
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file knn_graph.cpp
+ *
+ * Implementation of KNNGraph().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "knn_graph.hpp"
+
+#include <algorithm>
+
+namespace {
+
+//! An edge of the graph, in one direction.
+struct Edge
+{
+  size_t column;
+  size_t row;
+  double weight;
+
+  //! Edges are sorted by column, then row, as a sparse matrix stores them.
+  bool operator<(const Edge& other) const
+  {
+    return (column < other.column) ||
+        (column == other.column && row < other.row);
+  }
+};
+
+}; // anonymous namespace
+
+namespace mlpack {
+namespace neighbor {
+
+void KNNGraph(const arma::Mat<size_t>& neighbors,
+              const arma::mat& distances,
+              arma::sp_mat& graph,
+              const double bandwidth,
+              const bool mutual)
+{
+  const size_t n = neighbors.n_cols;
+  if (bandwidth < 0.0)
+    Log::Fatal << "KNNGraph(): bandwidth must be nonnegative (got "
+        << bandwidth << ")." << std::endl;
+
+  // Each neighbor gives an edge in both directions.
+  std::vector<Edge> edges;
+  edges.reserve(2 * neighbors.n_elem);
+  for (size_t j = 0; j < n; ++j)
+  {
+    for (size_t i = 0; i < neighbors.n_rows; ++i)
+    {
+      const size_t neighbor = neighbors(i, j);
+      if (neighbor >= n || neighbor == j)
+        continue;
+
+      const double distance = distances(i, j);
+      Edge edge;
+      edge.weight = (bandwidth > 0.0) ?
+          std::exp(-distance * distance / (2 * bandwidth * bandwidth)) :
+          distance;
+
+      edge.column = j;
+      edge.row = neighbor;
+      edges.push_back(edge);
+      edge.column = neighbor;
+      edge.row = j;
+      edges.push_back(edge);
+    }
+  }
+
+  std::sort(edges.begin(), edges.end());
+
+  // An edge between mutual neighbors is in the list twice; keep it once.  The
+  // list is compacted in place.
+  size_t kept = 0;
+  for (size_t e = 0; e < edges.size(); )
+  {
+    size_t copies = 1;
+    while (e + copies < edges.size() &&
+        edges[e + copies].column == edges[e].column &&
+        edges[e + copies].row == edges[e].row)
+      ++copies;
+
+    if ((!mutual || copies > 1) && edges[e].weight != 0.0)
+      edges[kept++] = edges[e];
+
+    e += copies;
+  }
+
+  arma::umat locations(2, kept);
+  arma::vec weights(kept);
+  for (size_t e = 0; e < kept; ++e)
+  {
+    locations(0, e) = edges[e].row;
+    locations(1, e) = edges[e].column;
+    weights[e] = edges[e].weight;
+  }
+  edges.clear();
+
+  graph = arma::sp_mat(locations, weights, n, n);
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
@@ -0,0 +1,58 @@
+/**
+ * @file knn_graph.hpp
+ *
+ * Conversion of the results of an all-k-nearest-neighbors search into a
+ * symmetric sparse kNN graph.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Build the symmetric kNN graph of a dataset from the neighbors and distances
+ * found by a search with the dataset as both the query and the reference set.
+ * The graph is an n x n sparse matrix; points i and j are joined if j is one of
+ * the neighbors of i or i is one of the neighbors of j (or, if mutual is true,
+ * only if both hold).  The weight of each edge is the distance d between the
+ * points or, if bandwidth is positive, the Gaussian weight
+ * exp(-d^2 / (2 bandwidth^2)).  Neighbors which were not found (with an index
+ * of at least n) are skipped.
+ *
+ * An edge between two identical points with the distance as its weight has a
+ * weight of 0, so it is not stored in the sparse matrix.
+ *
+ * @param neighbors Matrix of neighbors (one column per point).
+ * @param distances Matrix of distances (one column per point).
+ * @param graph Sparse matrix to store the graph in.
+ * @param bandwidth Bandwidth of the Gaussian weights (0 for distances).
+ * @param mutual If true, only keep edges between mutual neighbors.
+ */
+void KNNGraph(const arma::Mat<size_t>& neighbors,
+              const arma::mat& distances,
+              arma::sp_mat& graph,
+              const double bandwidth = 0.0,
+              const bool mutual = false);
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file knn_server_main.cpp
+ *
+ * A server which keeps a reference tree in memory and answers batches of
+ * k-nearest-neighbor queries read from standard input or a TCP socket.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "query_server.hpp"
+
+#ifndef _WIN32
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::tree;
+using namespace std;
+
+PROGRAM_INFO("k-Nearest-Neighbors Query Server", "This program builds a kd-tree"
+    " on a reference dataset (or loads one saved with the --save_index option "
+    "of allknn) once, keeps it in memory, and answers batches of "
+    "k-nearest-neighbor queries against it, each with single-tree search "
+    "parallel over the query points.  This avoids the cost of loading the data "
+    "and building the tree for each batch."
+    "\n\n"
+    "Requests are read from standard input (and replies written to standard "
+    "output) or, if --port (-p) is given, from TCP connections on that port of "
+    "the local host, one connection at a time.  Each request is one line:"
+    "\n\n"
+    "  knn <k> <n>    followed by n lines, each with one query point (values "
+    "separated by spaces or commas)\n"
+    "  info           the number of reference points and their dimensionality"
+    "\n"
+    "  quit           end the session (close the connection)\n"
+    "  shutdown       end the session and stop the server"
+    "\n\n"
+    "The reply to a valid request starts with a line \"ok ...\"; the reply to "
+    "\"knn <k> <n>\" is \"ok <n> <k>\" followed by n lines, each with the k "
+    "neighbor indices (columns of the reference dataset) and then the k "
+    "distances of one query point.  The reply to an invalid request is one line"
+    " \"error <message>\"."
+    "\n\n"
+    "The --verbose (-v) option prints messages to standard output too, so it "
+    "should only be used with --port.");
+
+PARAM_STRING("reference_file", "File containing the reference dataset.  Either "
+    "this or --index_file must be given.", "r", "");
+PARAM_STRING("index_file", "Load the reference dataset and its tree from this "
+    "tree index (see the --save_index option of allknn).", "I", "");
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_INT("threads", "Number of threads to use for tree building and for "
+    "answering each batch of queries (0 uses all available cores).  This only "
+    "has an effect if MLPACK was built with OpenMP.", "j", 0);
+PARAM_DOUBLE("epsilon", "If positive, perform approximate search: each "
+    "neighbor distance found is at most (1 + epsilon) times the true distance.",
+    "e", 0.0);
+PARAM_FLAG("best_first", "If true, search the tree best-first: the leaves "
+    "closest to each query point are searched first.", "B");
+PARAM_INT("max_leaves", "If nonzero, search the tree best-first and stop after "
+    "this many leaves for each query point, which bounds the time of each "
+    "query; the neighbors found are then approximate.", "L", 0);
+PARAM_INT("port", "If nonzero, listen for connections on this TCP port of the "
+    "local host instead of reading standard input.", "p", 0);
+
+#ifndef _WIN32
+/**
+ * A stream buffer which reads from and writes to a socket, so that a
+ * connection can be served with QueryServer::Serve().
+ */
+class SocketStreamBuffer : public streambuf
+{
+ public:
+  SocketStreamBuffer(const int socket) : socket(socket)
+  {
+    setg(input, input, input);
+    setp(output, output + sizeof(output));
+  }
+
+  ~SocketStreamBuffer() { sync(); }
+
+ protected:
+  int_type underflow()
+  {
+    const ssize_t count = recv(socket, input, sizeof(input), 0);
+    if (count <= 0)
+      return traits_type::eof();
+
+    setg(input, input, input + count);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  int_type overflow(int_type c)
+  {
+    if (sync() != 0)
+      return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync()
+  {
+    const char* begin = pbase();
+    while (begin < pptr())
+    {
+      const ssize_t count = send(socket, begin, pptr() - begin, 0);
+      if (count <= 0)
+        return -1;
+      begin += count;
+    }
+
+    setp(output, output + sizeof(output));
+    return 0;
+  }
+
+ private:
+  //! The socket.
+  int socket;
+  //! The buffer of received data.
+  char input[65536];
+  //! The buffer of data to send.
+  char output[65536];
+};
+
+//! Answer the connections on the given port, one at a time, until one of them
+//! asks the server to stop.
+void ServePort(QueryServer<>& server, const int port)
+{
+  const int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0)
+    Log::Fatal << "Could not create socket: " << strerror(errno) << "." << endl;
+
+  const int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  // Only local connections are accepted; there is no authentication.
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons((unsigned short) port);
+
+  if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 ||
+      listen(listener, 8) != 0)
+    Log::Fatal << "Could not listen on port " << port << ": "
+        << strerror(errno) << "." << endl;
+
+  Log::Info << "Listening on port " << port << "." << endl;
+
+  bool shutdown = false;
+  while (!shutdown)
+  {
+    const int connection = accept(listener, NULL, NULL);
+    if (connection < 0)
+    {
+      Log::Warn << "Could not accept connection: " << strerror(errno) << "."
+          << endl;
+      continue;
+    }
+
+    Log::Info << "Accepted connection." << endl;
+    {
+      SocketStreamBuffer buffer(connection);
+      istream input(&buffer);
+      ostream output(&buffer);
+      shutdown = server.Serve(input, output);
+    }
+    close(connection);
+    Log::Info << "Closed connection; " << server.QueriesAnswered()
+        << " queries answered so far." << endl;
+  }
+
+  close(listener);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string indexFile = CLI::GetParam<string>("index_file");
+  const int leafSize = CLI::GetParam<int>("leaf_size");
+  const int threads = CLI::GetParam<int>("threads");
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  const int maxLeaves = CLI::GetParam<int>("max_leaves");
+  const int port = CLI::GetParam<int>("port");
+
+  if ((referenceFile == "") == (indexFile == ""))
+    Log::Fatal << "Exactly one of --reference_file and --index_file must be "
+        << "given." << endl;
+  if (leafSize <= 0)
+    Log::Fatal << "Invalid leaf size: " << leafSize << ".  Must be greater "
+        << "than 0." << endl;
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be 0 "
+        << "or greater." << endl;
+  if (epsilon < 0.0)
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be 0 or greater."
+        << endl;
+  if (maxLeaves < 0)
+    Log::Fatal << "Invalid maximum number of leaves: " << maxLeaves << ".  "
+        << "Must be 0 or greater." << endl;
+  if (port < 0 || port > 65535)
+    Log::Fatal << "Invalid port: " << port << "." << endl;
+
+  QueryServer<>* server;
+  if (indexFile != "")
+  {
+    Log::Info << "Loading tree index from '" << indexFile << "'..." << endl;
+    server = new QueryServer<>(indexFile);
+  }
+  else
+  {
+    arma::mat referenceData;
+    data::Load(referenceFile, referenceData, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
+
+    Log::Info << "Building reference tree..." << endl;
+    server = new QueryServer<>(referenceData, BuildOptions((size_t) leafSize,
+        (size_t) threads));
+  }
+
+  server->Threads() = (size_t) threads;
+  server->Epsilon() = epsilon;
+  server->BestFirst() = CLI::HasParam("best_first") || (maxLeaves > 0);
+  server->MaxLeaves() = (size_t) maxLeaves;
+
+  if (port == 0)
+  {
+    server->Serve(cin, cout);
+  }
+  else
+  {
+#ifndef _WIN32
+    ServePort(*server, port);
+#else
+    Log::Fatal << "--port is not supported on this platform." << endl;
+#endif
+  }
+
+  Log::Info << server->QueriesAnswered() << " queries answered." << endl;
+  delete server;
+}
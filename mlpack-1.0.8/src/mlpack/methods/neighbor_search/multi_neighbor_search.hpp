@@ -0,0 +1,184 @@
+/**
+ * @file multi_neighbor_search.hpp
+ *
+ * Defines the MultiNeighborSearch class, which searches one query set against
+ * several reference sets with one query tree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MULTI_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MULTI_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The MultiNeighborSearch class finds the k nearest (or furthest) neighbors of
+ * each point of one query set in each of several reference sets (different
+ * catalogs of items, for instance), with dual-tree search.  The query tree is
+ * built once, instead of once for each reference set as separate
+ * NeighborSearch objects would, and it is traversed once: it is split into
+ * small disjoint subtrees, and each subtree is searched against every
+ * reference tree in turn while its points are still in the cache.  The
+ * subtrees are split between threads, as tree::ParallelDualTreeTraverser does.
+ *
+ * @code
+ * MultiNeighborSearch<> search(queryData);
+ * search.AddReferenceSet(books);
+ * search.AddReferenceSet(films);
+ *
+ * std::vector<arma::Mat<size_t> > neighbors;
+ * std::vector<arma::mat> distances;
+ * search.Search(10, neighbors, distances); // neighbors[1] are in films.
+ * @endcode
+ *
+ * Trees whose children share points with their parents, or whose rules cache
+ * base cases in reference nodes (such as the cover tree), cannot be split, so
+ * for those the whole query tree is searched against each reference tree in
+ * turn, with one thread; only the construction of the query tree is saved.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam TreeType The tree type to use.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         typename MetricType = mlpack::metric::SquaredEuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+             NeighborSearchStat<SortPolicy> > >
+class MultiNeighborSearch
+{
+ public:
+  /**
+   * Build the query tree on a copy of the given query set.  The results are
+   * given in the original order of the query points.
+   *
+   * @param querySet Set of query points.
+   * @param leafSize Leaf size for tree construction.
+   * @param metric An optional instance of the MetricType class.
+   */
+  MultiNeighborSearch(const typename TreeType::Mat& querySet,
+                      const size_t leafSize = 20,
+                      const MetricType metric = MetricType());
+
+  /**
+   * Use the given pre-built query tree, which may be shared with NeighborSearch
+   * and RangeSearch objects (as long as they do not search at the same time).
+   * The results are given in the order of the points in the tree.
+   *
+   * @param queryTree Pre-built tree for query points.
+   * @param querySet Set of query points corresponding to queryTree.
+   * @param metric An optional instance of the MetricType class.
+   */
+  MultiNeighborSearch(TreeType* queryTree,
+                      const typename TreeType::Mat& querySet,
+                      const MetricType metric = MetricType());
+
+  /**
+   * Delete the trees built by this object.
+   */
+  ~MultiNeighborSearch();
+
+  /**
+   * Add a reference set, building a tree on a copy of it.  The neighbors
+   * found in it are indices of its original columns.
+   *
+   * @param referenceSet Set of reference points.
+   * @param leafSize Leaf size for tree construction.
+   * @return The index of the reference set in the results of Search().
+   */
+  size_t AddReferenceSet(const typename TreeType::Mat& referenceSet,
+                         const size_t leafSize = 20);
+
+  /**
+   * Add a reference set with a pre-built tree.  The neighbors found in it are
+   * indices of the points in the tree.
+   *
+   * @param referenceTree Pre-built tree for reference points.
+   * @param referenceSet Set of reference points corresponding to
+   *     referenceTree.
+   * @return The index of the reference set in the results of Search().
+   */
+  size_t AddReferenceTree(TreeType* referenceTree,
+                          const typename TreeType::Mat& referenceSet);
+
+  /**
+   * Find the k nearest neighbors of each query point in each reference set.
+   * Element i of neighbors and distances holds the results for reference set
+   * i, as NeighborSearch::Search() gives them.  Each reference set must have
+   * at least k points.
+   *
+   * @param k Number of neighbors to search for in each reference set.
+   * @param neighbors Vector to store the neighbors for each reference set in.
+   * @param distances Vector to store the distances for each reference set in.
+   */
+  void Search(const size_t k,
+              std::vector<arma::Mat<size_t> >& neighbors,
+              std::vector<arma::mat>& distances);
+
+  //! Get the number of reference sets.
+  size_t ReferenceSets() const { return referenceTrees.size(); }
+
+  //! Get the number of threads used for the search.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the search (1 is serial, 0 means
+  //! all available cores).
+  size_t& Threads() { return threads; }
+
+  //! The number of query points that each subtree of the query tree holds at
+  //! most, so that it stays in the cache while it is searched against each
+  //! reference tree.
+  static const size_t SubtreePoints = 1024;
+
+ private:
+  //! Copy of the query set, if the query tree was built by this object.
+  typename TreeType::Mat queryCopy;
+  //! The query set.
+  const typename TreeType::Mat& querySet;
+  //! The query tree.
+  TreeType* queryTree;
+  //! Whether the query tree was built by this object.
+  bool treeOwner;
+  //! Permutation of the query points by tree construction.
+  std::vector<size_t> oldFromNewQueries;
+
+  //! Copies of the reference sets (NULL where the tree was given).
+  std::vector<typename TreeType::Mat*> referenceCopies;
+  //! The reference sets.
+  std::vector<const typename TreeType::Mat*> referenceSets;
+  //! The reference trees.
+  std::vector<TreeType*> referenceTrees;
+  //! Permutations of the reference points by tree construction (empty where
+  //! the tree was given).
+  std::vector<std::vector<size_t> > oldFromNewReferences;
+
+  //! Instantiation of the metric.
+  MetricType metric;
+  //! The number of threads used for the search.
+  size_t threads;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "multi_neighbor_search_impl.hpp"
+
+#endif
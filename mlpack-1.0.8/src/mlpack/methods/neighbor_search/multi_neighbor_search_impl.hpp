@@ -0,0 +1,213 @@
+/**
+ * @file multi_neighbor_search_impl.hpp
+ *
+ * Implementation of the MultiNeighborSearch class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MULTI_NEIGHBOR_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MULTI_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "multi_neighbor_search.hpp"
+
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include "candidate_heap.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+MultiNeighborSearch<SortPolicy, MetricType, TreeType>::MultiNeighborSearch(
+    const typename TreeType::Mat& querySet,
+    const size_t leafSize,
+    const MetricType metric) :
+    queryCopy(querySet),
+    querySet(queryCopy),
+    treeOwner(true),
+    metric(metric),
+    threads(1)
+{
+  Timer::Start("tree_building");
+
+  queryTree = new TreeType(queryCopy, oldFromNewQueries, leafSize);
+  bound::SetTreeMetric(*queryTree, this->metric);
+
+  Timer::Stop("tree_building");
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+MultiNeighborSearch<SortPolicy, MetricType, TreeType>::MultiNeighborSearch(
+    TreeType* queryTree,
+    const typename TreeType::Mat& querySet,
+    const MetricType metric) :
+    querySet(querySet),
+    queryTree(queryTree),
+    treeOwner(false),
+    metric(metric),
+    threads(1)
+{ /* Nothing to do. */ }
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+MultiNeighborSearch<SortPolicy, MetricType, TreeType>::~MultiNeighborSearch()
+{
+  if (treeOwner)
+    delete queryTree;
+
+  // The trees of the copied reference sets were built by this object.
+  for (size_t i = 0; i < referenceCopies.size(); ++i)
+  {
+    if (referenceCopies[i])
+    {
+      delete referenceTrees[i];
+      delete referenceCopies[i];
+    }
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t MultiNeighborSearch<SortPolicy, MetricType, TreeType>::AddReferenceSet(
+    const typename TreeType::Mat& referenceSet,
+    const size_t leafSize)
+{
+  if (referenceSet.n_rows != querySet.n_rows)
+    Log::Fatal << "MultiNeighborSearch::AddReferenceSet(): the reference set "
+        << "has dimensionality " << referenceSet.n_rows << ", but the query "
+        << "set has dimensionality " << querySet.n_rows << "." << std::endl;
+
+  Timer::Start("tree_building");
+
+  typename TreeType::Mat* referenceCopy =
+      new typename TreeType::Mat(referenceSet);
+  oldFromNewReferences.push_back(std::vector<size_t>());
+  TreeType* referenceTree = new TreeType(*referenceCopy,
+      oldFromNewReferences.back(), leafSize);
+  bound::SetTreeMetric(*referenceTree, metric);
+
+  Timer::Stop("tree_building");
+
+  referenceCopies.push_back(referenceCopy);
+  referenceSets.push_back(referenceCopy);
+  referenceTrees.push_back(referenceTree);
+
+  return referenceTrees.size() - 1;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t MultiNeighborSearch<SortPolicy, MetricType, TreeType>::AddReferenceTree(
+    TreeType* referenceTree,
+    const typename TreeType::Mat& referenceSet)
+{
+  if (referenceSet.n_rows != querySet.n_rows)
+    Log::Fatal << "MultiNeighborSearch::AddReferenceTree(): the reference set "
+        << "has dimensionality " << referenceSet.n_rows << ", but the query "
+        << "set has dimensionality " << querySet.n_rows << "." << std::endl;
+
+  referenceCopies.push_back(NULL);
+  referenceSets.push_back(&referenceSet);
+  referenceTrees.push_back(referenceTree);
+  oldFromNewReferences.push_back(std::vector<size_t>());
+
+  return referenceTrees.size() - 1;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void MultiNeighborSearch<SortPolicy, MetricType, TreeType>::Search(
+    const size_t k,
+    std::vector<arma::Mat<size_t> >& neighbors,
+    std::vector<arma::mat>& distances)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> BaseRuleType;
+  typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+
+  const size_t sets = referenceTrees.size();
+  for (size_t i = 0; i < sets; ++i)
+    if (k > referenceSets[i]->n_cols)
+      Log::Fatal << "MultiNeighborSearch::Search(): k (" << k << ") is "
+          << "greater than the number of points in reference set " << i
+          << " (" << referenceSets[i]->n_cols << ")." << std::endl;
+
+  Timer::Start("computing_neighbors");
+
+  // The results must not move once the rules hold references to them.
+  neighbors.resize(sets);
+  distances.resize(sets);
+
+  std::vector<RuleType> rules;
+  rules.reserve(sets);
+  for (size_t i = 0; i < sets; ++i)
+  {
+    neighbors[i].set_size(k, querySet.n_cols);
+    distances[i].set_size(k, querySet.n_cols);
+    distances[i].fill(SortPolicy::WorstDistance());
+
+    referenceTrees[i]->ResetStatistics();
+    rules.push_back(RuleType(BaseRuleType(*referenceSets[i], querySet,
+        neighbors[i], distances[i], metric)));
+  }
+  queryTree->ResetStatistics();
+
+  tree::TraversalStatistics::Start();
+
+  // Split the query tree into subtrees small enough to stay in the cache, a
+  // few for each thread, unless the tree cannot be split.
+  const bool split = !tree::TreeTraits<TreeType>::HasSelfChildren &&
+      !tree::TreeTraits<TreeType>::FirstPointIsCentroid;
+  const size_t numThreads = split ? Threads::Count(threads) : 1;
+  const size_t minSubtrees = split ? std::max(8 * numThreads,
+      (size_t) querySet.n_cols / SubtreePoints) : 1;
+
+  std::vector<TreeType*> subtrees;
+  tree::ParallelDualTreeTraverser<TreeType, RuleType>::SplitQueryTree(
+      *queryTree, minSubtrees, subtrees);
+
+  Log::Info << "Searching " << subtrees.size() << " query subtrees against "
+      << sets << " reference sets." << std::endl;
+
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+  for (int s = 0; s < (int) subtrees.size(); ++s)
+  {
+    for (size_t i = 0; i < sets; ++i)
+    {
+      // The bounds in the query nodes depend on the reference set.  The
+      // subtrees are disjoint, so each thread resets only its own nodes.
+      if (i > 0)
+        subtrees[s]->ResetStatistics();
+
+      RuleType subtreeRules(rules[i]);
+      typename TreeType::template DualTreeTraverser<RuleType>
+          traverser(subtreeRules);
+      traverser.Traverse(*subtrees[s], *referenceTrees[i]);
+    }
+  }
+
+  // Sort the candidates kept as heaps, and map the results back to the
+  // original orders of the points given to this object.
+  for (size_t i = 0; i < sets; ++i)
+  {
+    CandidateHeap<SortPolicy>::Sort(distances[i], neighbors[i]);
+    UnmapInPlace(neighbors[i], distances[i], oldFromNewReferences[i],
+        oldFromNewQueries);
+  }
+
+  tree::TraversalStatistics::Stop();
+  Timer::Stop("computing_neighbors");
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -26,11 +26,18 @@
 #include <mlpack/core.hpp>
 #include <vector>
 #include <string>
+#include <set>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/best_first_traverser.hpp>
+#include <mlpack/core/tree/parallel_dual_tree_traverser.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metal/metal_engine.hpp>
 #include "neighbor_search_stat.hpp"
+#include "neighbor_search_rules.hpp"
+#include "knn_graph.hpp"
+#include "unmap.hpp"
 #include "sort_policies/nearest_neighbor_sort.hpp"
 
 namespace mlpack {
@@ -38,6 +45,33 @@ namespace neighbor /** Neighbor-search routines.  These include
                     * all-nearest-neighbors and all-furthest-neighbors
                     * searches. */ {
 
+/**
+ * Whether the neighbors for a given sort policy and metric can be found by
+ * brute force on the GPU (see NeighborSearch::GPU()).  The GPU kernel finds the
+ * nearest neighbors in Euclidean distance, so this is only the case for
+ * NearestNeighborSort with the Euclidean and squared Euclidean distances.
+ */
+template<typename SortPolicy, typename MetricType>
+struct GPUSearchTraits
+{
+  //! Whether the search can be run on the GPU.
+  static const bool Supported = false;
+};
+
+//! Nearest neighbors in Euclidean distance can be found on the GPU.
+template<>
+struct GPUSearchTraits<NearestNeighborSort, metric::EuclideanDistance>
+{
+  static const bool Supported = true;
+};
+
+//! Nearest neighbors in squared Euclidean distance can be found on the GPU.
+template<>
+struct GPUSearchTraits<NearestNeighborSort, metric::SquaredEuclideanDistance>
+{
+  static const bool Supported = true;
+};
+
 /**
  * The NeighborSearch class is a template class for performing distance-based
  * neighbor searches.  It takes a query dataset and a reference dataset (or just
@@ -52,6 +86,11 @@ namespace neighbor /** Neighbor-search routines.  These include
  * can be found in the NearestNeighborSort class and the kernel::ExampleKernel
  * class.
  *
+ * The datasets have the type TreeType::Mat, so a tree built on an arma::fmat
+ * (such as BinarySpaceTree<HRectBound<2>, NeighborSearchStat<SortPolicy>,
+ * arma::fmat>) searches single-precision data without converting it.  The
+ * distances are returned in double precision in either case.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam TreeType The tree type to use.
@@ -72,7 +111,10 @@ class NeighborSearch
    *
    * This method will copy the matrices to internal copies, which are rearranged
    * during tree-building.  You can avoid this extra copy by pre-constructing
-   * the trees and passing them using a diferent constructor.
+   * the trees and passing them using a diferent constructor (this is how the
+   * allknn program builds its trees in place), or by giving the matrices to the
+   * object with the constructor that takes pointers to them.  A warning is
+   * given if the copies do not fit in the MemoryBudget; see PeakMemory().
    *
    * @param referenceSet Set of reference points.
    * @param querySet Set of query points.
@@ -98,10 +140,8 @@ class NeighborSearch
    * where the metric has internal data (i.e. the distance::MahalanobisDistance
    * class).
    *
-   * If naive mode is being used and a pre-built tree is given, it may not work:
-   * naive mode operates by building a one-node tree (the root node holds all
-   * the points).  If that condition is not satisfied with the pre-built tree,
-   * then naive mode will not work.
+   * In naive mode the tree has one node (the root node holds all the points),
+   * and the neighbors are found by brute force (see Search()).
    *
    * @param referenceSet Set of reference points.
    * @param naive If true, O(n^2) naive search will be used (as opposed to
@@ -117,6 +157,54 @@ class NeighborSearch
                  const size_t leafSize = 20,
                  const MetricType metric = MetricType());
 
+  /**
+   * Initialize the NeighborSearch object, taking over the given query and
+   * reference datasets instead of copying them.  The memory of the matrices is
+   * moved into the object (with steal_mem()), and the given matrices are left
+   * empty; the points are rearranged during tree-building, but the results of
+   * Search() are mapped back to the original indices, as with the copying
+   * constructor.  This halves the memory needed for large datasets, without
+   * having to build the trees and map the results by hand.  (If a matrix does
+   * not own its memory, for instance because it uses auxiliary memory, it is
+   * copied.)
+   *
+   * @param referenceSet Set of reference points, which is emptied.
+   * @param querySet Set of query points, which is emptied.
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param leafSize Leaf size for tree construction.
+   * @param metric An optional instance of the MetricType class.
+   */
+  NeighborSearch(typename TreeType::Mat* referenceSet,
+                 typename TreeType::Mat* querySet,
+                 const bool naive = false,
+                 const bool singleMode = false,
+                 const size_t leafSize = 20,
+                 const MetricType metric = MetricType());
+
+  /**
+   * Initialize the NeighborSearch object, taking over the given dataset (which
+   * is used as both the query and the reference dataset) instead of copying
+   * it.  The memory of the matrix is moved into the object, and the given
+   * matrix is left empty; the results of Search() are mapped back to the
+   * original indices.
+   *
+   * @param referenceSet Set of reference points, which is emptied.
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param leafSize Leaf size for tree construction.
+   * @param metric An optional instance of the MetricType class.
+   */
+  NeighborSearch(typename TreeType::Mat* referenceSet,
+                 const bool naive = false,
+                 const bool singleMode = false,
+                 const size_t leafSize = 20,
+                 const MetricType metric = MetricType());
+
   /**
    * Initialize the NeighborSearch object with the given datasets and
    * pre-constructed trees.  It is assumed that the points in referenceSet and
@@ -198,6 +286,20 @@ class NeighborSearch
    * number of points in the query dataset and k is the number of neighbors
    * being searched for.
    *
+   * The statistics of the trees are reset with ResetStatistics() before the
+   * search, so Search() can be called any number of times, and a pre-built tree
+   * can be shared between several NeighborSearch and RangeSearch objects (as
+   * long as they do not search at the same time).
+   *
+   * In naive mode, and for the (squared) Euclidean distance on data with more
+   * than BruteForceMinDimensionality dimensions (where the trees prune
+   * little), the trees are not used: the neighbors are found by brute force
+   * (see BruteForceSearch()), with the query points split between threads.
+   *
+   * If this object built the trees, the results are mapped back to the
+   * original order of the points in place (see UnmapInPlace()), unless
+   * TreeOrder() is set.
+   *
    * @param k Number of neighbors to search for.
    * @param resultingNeighbors Matrix storing lists of neighbors for each query
    *     point.
@@ -208,17 +310,191 @@ class NeighborSearch
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances);
 
+  /**
+   * Compute the symmetric kNN graph of the dataset, which must be both the
+   * query and the reference set: points i and j are joined if j is one of the
+   * k nearest neighbors of i, or i one of the k nearest neighbors of j (or, if
+   * mutual is true, only if both hold).  The weights of the edges are the
+   * distances given by MetricType or, if bandwidth is positive, the Gaussian
+   * weights exp(-d^2 / (2 bandwidth^2)); see KNNGraph().
+   *
+   * The search is symmetric (see Symmetric()), so each distance is calculated
+   * only once.  As with Search(), the points are in the order of the tree if
+   * the tree was passed to the constructor, or if TreeOrder() is set.
+   *
+   * @param k Number of neighbors of each point.
+   * @param graph Sparse matrix to store the graph in (n x n).
+   * @param bandwidth Bandwidth of the Gaussian weights (0 for distances).
+   * @param mutual If true, only keep edges between mutual neighbors.
+   */
+  void Graph(const size_t k,
+             arma::sp_mat& graph,
+             const double bandwidth = 0.0,
+             const bool mutual = false);
+
+  /**
+   * Return the working memory (in bytes) that constructing a NeighborSearch
+   * object from datasets of the given size (copying them and building the
+   * trees) and running Search() is expected to need, including the results.
+   * If queryPoints is 0, there is no separate query set.
+   *
+   * @param referencePoints Number of reference points.
+   * @param queryPoints Number of query points (0 if there is no query set).
+   * @param dimensionality Dimensionality of the points.
+   * @param k Number of neighbors to search for.
+   * @param leafSize Leaf size for tree construction.
+   */
+  static size_t PeakMemory(const size_t referencePoints,
+                           const size_t queryPoints,
+                           const size_t dimensionality,
+                           const size_t k,
+                           const size_t leafSize = 20);
+
+  //! Data with more dimensions than this is searched by brute force, for the
+  //! (squared) Euclidean distance.
+  static const size_t BruteForceMinDimensionality = 100;
+
+  //! Get whether a dual-tree search of one dataset compares each pair of leaves
+  //! only once.
+  bool Symmetric() const { return symmetric; }
+  //! Modify whether a dual-tree search of one dataset compares each pair of
+  //! leaves only once, updating the neighbors of both points with each
+  //! distance; this halves the number of distance calculations.  It only has an
+  //! effect when there is no separate query set, in dual-tree mode, with
+  //! BinarySpaceTree, and the search is then run with one thread.
+  bool& Symmetric() { return symmetric; }
+
+  //! Get the number of threads used for tree-based search.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for tree-based search (1 is serial, 0
+  //! means all available cores).  In single-tree mode the query points are
+  //! split between threads; for dual-tree search, see
+  //! tree::ParallelDualTreeTraverser.
+  size_t& Threads() { return threads; }
+
+  //! Get the allowed relative error of the search.
+  double Epsilon() const { return epsilon; }
+  //! Modify the allowed relative error of the search (0 is exact search).  If
+  //! it is positive, each neighbor distance returned by Search() is within a
+  //! factor of (1 + epsilon) of the k'th true neighbor distance of the same
+  //! rank: at most (1 + epsilon) times it for nearest neighbors, and at least
+  //! 1 / (1 + epsilon) times it for furthest neighbors.  The error is relative
+  //! to the distances given by MetricType, so with a squared metric it applies
+  //! to the squared distances.
+  double& Epsilon() { return epsilon; }
+
+  //! Get whether the neighbors are found by brute force on the GPU.
+  bool GPU() const { return gpu; }
+  //! Modify whether the neighbors are found by brute force on the GPU (with
+  //! Metal; see metal::Available()) instead of with the trees.  The GPU finds
+  //! up to 2k candidates in single precision, which are then ranked with exact
+  //! distances, so the results are the same as those of naive search except
+  //! for near-ties.  If the GPU cannot be used (no device, k larger than
+  //! metal::MaxCandidates, or a sort policy and metric not supported by
+  //! GPUSearchTraits), Search() warns and uses the trees.
+  bool& GPU() { return gpu; }
+
+  //! Get the monitor which observes Search() (NULL if there is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes Search().  It is called after each
+  //! batch of query points (each subtree of the query tree, in dual-tree mode)
+  //! with the fraction of query points searched, and can stop the search
+  //! early; the query points which were not searched are then left with the
+  //! worst possible distance to each neighbor (see ProgressMonitor).  A
+  //! symmetric search (see Symmetric()) and a search on the GPU are not split
+  //! into batches.
+  ProgressMonitor*& Monitor() { return monitor; }
+
+  //! Get whether single-tree search expands the nodes best-first.
+  bool BestFirst() const { return bestFirst; }
+  //! Modify whether single-tree search expands the reference nodes in order of
+  //! their distance to the query point, from a priority queue (see
+  //! tree::BestFirstTraverser), instead of depth-first.  This only has an
+  //! effect in single-tree mode, with trees whose points are held by one leaf
+  //! each (such as BinarySpaceTree).
+  bool& BestFirst() { return bestFirst; }
+
+  //! Get the largest number of leaves visited by best-first search of each
+  //! query point (0 means there is no limit).
+  size_t MaxLeaves() const { return maxLeaves; }
+  //! Modify the largest number of leaves visited by best-first search of each
+  //! query point.  If it is nonzero, the search of each query point stops
+  //! after that many leaves, so its time is bounded, but the neighbors found
+  //! are approximate: the best ones in the leaves closest to the query point.
+  //! It only has an effect if BestFirst() is set.
+  size_t& MaxLeaves() { return maxLeaves; }
+
+  //! Get whether Search() leaves the results in the order of the trees.
+  bool TreeOrder() const { return treeOrder; }
+  //! Modify whether Search() (and Graph()) leave the results in the order of
+  //! the trees this object built, instead of mapping them back to the original
+  //! order of the points.  The columns are then in the order of the query tree
+  //! (the original order, if no query tree was built: in single-tree mode with
+  //! a query set), and the neighbors are indices in the reference tree; use
+  //! OldFromNewQueries() and OldFromNewReferences() to map them back.  This
+  //! saves the mapping when the results go to another stage that works in the
+  //! order of the tree.  It has no effect if the trees were given.
+  bool& TreeOrder() { return treeOrder; }
+
+  //! Get the original index of each point of the reference tree (empty if the
+  //! tree was given).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Get the original index of each point of the query tree (empty if no query
+  //! tree was built, or if there is no separate query set).
+  const std::vector<size_t>& OldFromNewQueries() const
+  { return oldFromNewQueries; }
+
  private:
+  /**
+   * Find the neighbors by brute force on the GPU, and rank the candidates with
+   * exact distances.  Return false (without changing the results) if the GPU
+   * cannot be used.
+   */
+  bool GPUSearch(const size_t k,
+                 arma::Mat<size_t>& neighbors,
+                 arma::mat& distances);
+
+  /**
+   * Find the neighbors by comparing every query point with every reference
+   * point, using the given rules to keep the candidates.  The query points are
+   * taken in blocks of BruteForceQueryBlock, which are split between threads
+   * (and after each of which the monitor, if any, is called), and the
+   * reference points in blocks of BruteForceReferenceBlock.  For the (squared)
+   * Euclidean distance on data with more than
+   * NeighborSearchRules::BlockMinDimensionality dimensions, the distances
+   * between two blocks are calculated at once as ||q||^2 + ||r||^2 - 2 q^T r,
+   * with one matrix multiplication and the squared norms of the reference
+   * points calculated once; otherwise BaseCase() is called for each pair.
+   *
+   * @tparam RuleType NeighborSearchRules, or the InstrumentedRules wrapping it.
+   */
+  template<typename RuleType>
+  void BruteForceSearch(const RuleType& rules);
+
+  //! The number of query points in each block of BruteForceSearch().
+  static const size_t BruteForceQueryBlock = 64;
+  //! The number of reference points in each block of BruteForceSearch().
+  static const size_t BruteForceReferenceBlock = 1024;
+
+  /**
+   * Build the trees on referenceCopy and (if there is a query set and dual-tree
+   * search is used) queryCopy, which are rearranged, and set the metric of
+   * their bounds.
+   */
+  void BuildTrees(const size_t leafSize);
+
   //! Copy of reference dataset (if we need it, because tree building modifies
-  //! it).
-  arma::mat referenceCopy;
-  //! Copy of query dataset (if we need it, because tree building modifies it).
-  arma::mat queryCopy;
+  //! it), or the dataset given to the object.
+  typename TreeType::Mat referenceCopy;
+  //! Copy of query dataset (if we need it, because tree building modifies it),
+  //! or the dataset given to the object.
+  typename TreeType::Mat queryCopy;
 
   //! Reference dataset.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
   //! Query dataset (may not be given).
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! Pointer to the root of the reference tree.
   TreeType* referenceTree;
@@ -245,6 +521,31 @@ class NeighborSearch
 
   //! Total number of pruned nodes during the neighbor search.
   size_t numberOfPrunes;
+
+  //! Number of threads to use for tree-based search.
+  size_t threads;
+
+  //! The allowed relative error of the search.
+  double epsilon;
+
+  //! Whether a search of one dataset compares each pair of leaves once.
+  bool symmetric;
+
+  //! Whether the neighbors are found on the GPU.
+  bool gpu;
+
+  //! Monitor of the progress of the search (may be NULL).
+  ProgressMonitor* monitor;
+
+  //! Whether single-tree search expands the nodes best-first.
+  bool bestFirst;
+
+  //! The largest number of leaves visited by best-first search of each query
+  //! point (0 means there is no limit).
+  size_t maxLeaves;
+
+  //! Whether the results of Search() are left in the order of the trees.
+  bool treeOrder;
 }; // class NeighborSearch
 
 }; // namespace neighbor
@@ -26,6 +26,13 @@
 #include <mlpack/core.hpp>
 
 #include "neighbor_search_rules.hpp"
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 using namespace mlpack::neighbor;
 
@@ -49,24 +56,28 @@ NeighborSearch(const typename TreeType::Mat& referenceSet,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
 {
   // C++11 will allow us to call out to other constructors so we can avoid this
   // copypasta problem.
 
-  // We'll time tree building, but only if we are building trees.
-  Timer::Start("tree_building");
-
-  // Construct as a naive object if we need to.
-  referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
-      (naive ? referenceCopy.n_cols : leafSize));
+  const size_t peakMemory = PeakMemory(referenceSet.n_cols, querySet.n_cols,
+      referenceSet.n_rows, 1, leafSize);
+  if (!MemoryBudget::Fits(peakMemory))
+    Log::Warn << "NeighborSearch: copying the datasets and building the trees "
+        << "needs about " << MemoryBudget::Format(peakMemory) << ", more than "
+        << "the memory budget; build the trees in place and pass them, or give "
+        << "the datasets to the object, instead." << std::endl;
 
-  if (!singleMode)
-    queryTree = new TreeType(queryCopy, oldFromNewQueries,
-        (naive ? querySet.n_cols : leafSize));
-
-  // Stop the timer we started above (if we need to).
-  Timer::Stop("tree_building");
+  BuildTrees(leafSize);
 }
 
 // Construct the object.
@@ -87,19 +98,93 @@ NeighborSearch(const typename TreeType::Mat& referenceSet,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
 {
-  // We'll time tree building, but only if we are building trees.
-  Timer::Start("tree_building");
+  const size_t peakMemory = PeakMemory(referenceSet.n_cols, 0,
+      referenceSet.n_rows, 1, leafSize);
+  if (!MemoryBudget::Fits(peakMemory))
+    Log::Warn << "NeighborSearch: copying the dataset and building the tree "
+        << "needs about " << MemoryBudget::Format(peakMemory) << ", more than "
+        << "the memory budget; build the tree in place and pass it, or give "
+        << "the dataset to the object, instead." << std::endl;
+
+  BuildTrees(leafSize);
+}
 
-  // Construct as a naive object if we need to.
-  referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
-      (naive ? referenceSet.n_cols : leafSize));
-  if (!singleMode)
-    queryTree = new TreeType(*referenceTree);
+// Construct the object, taking over the datasets.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearch<SortPolicy, MetricType, TreeType>::
+NeighborSearch(typename TreeType::Mat* referenceSet,
+               typename TreeType::Mat* querySet,
+               const bool naive,
+               const bool singleMode,
+               const size_t leafSize,
+               const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(queryCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(true),
+    hasQuerySet(true),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
+{
+  // Move the memory of the datasets; the trees rearrange it in place.
+  referenceCopy.steal_mem(*referenceSet);
+  queryCopy.steal_mem(*querySet);
 
-  // Stop the timer we started above.
-  Timer::Stop("tree_building");
+  BuildTrees(leafSize);
+}
+
+// Construct the object, taking over the dataset.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearch<SortPolicy, MetricType, TreeType>::
+NeighborSearch(typename TreeType::Mat* referenceSet,
+               const bool naive,
+               const bool singleMode,
+               const size_t leafSize,
+               const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(referenceCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(true),
+    hasQuerySet(false),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
+{
+  // Move the memory of the dataset; the tree rearranges it in place.
+  referenceCopy.steal_mem(*referenceSet);
+
+  BuildTrees(leafSize);
 }
 
 // Construct the object.
@@ -120,7 +205,15 @@ NeighborSearch<SortPolicy, MetricType, TreeType>::NeighborSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
 {
   // Nothing else to initialize.
 }
@@ -141,7 +234,15 @@ NeighborSearch<SortPolicy, MetricType, TreeType>::NeighborSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    epsilon(0.0),
+    symmetric(false),
+    gpu(false),
+    monitor(NULL),
+    bestFirst(false),
+    maxLeaves(0),
+    treeOrder(false)
 {
   Timer::Start("tree_building");
 
@@ -152,6 +253,62 @@ NeighborSearch<SortPolicy, MetricType, TreeType>::NeighborSearch(
   Timer::Stop("tree_building");
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t NeighborSearch<SortPolicy, MetricType, TreeType>::PeakMemory(
+    const size_t referencePoints,
+    const size_t queryPoints,
+    const size_t dimensionality,
+    const size_t k,
+    const size_t leafSize)
+{
+  typedef typename TreeType::Mat::elem_type ElemType;
+
+  // A tree has about two nodes for each leaf, and each node has a bound of
+  // about two points.
+  const size_t setPoints = referencePoints + queryPoints;
+  const size_t nodes = 2 * (setPoints / std::max(leafSize, (size_t) 1) + 1);
+
+  // The copies of the datasets, the mappings, the trees (built twice when the
+  // reference tree is copied for the query tree), and the results (which are
+  // unmapped in place).
+  const size_t resultPoints = (queryPoints == 0) ? referencePoints :
+      queryPoints;
+  return MemoryBudget::MatrixBytes<ElemType>(dimensionality, setPoints) +
+      setPoints * sizeof(size_t) + ((queryPoints == 0) ? 2 : 1) * nodes *
+      (sizeof(TreeType) + MemoryBudget::MatrixBytes<double>(dimensionality,
+      2)) + k * resultPoints * (sizeof(size_t) + sizeof(double));
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::BuildTrees(
+    const size_t leafSize)
+{
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("tree_building");
+
+  // Construct as a naive object if we need to.
+  referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
+      (naive ? referenceCopy.n_cols : leafSize));
+
+  // A periodic metric sets the box of the bounds of the trees.
+  bound::SetTreeMetric(*referenceTree, metric);
+
+  if (!singleMode && hasQuerySet)
+  {
+    queryTree = new TreeType(queryCopy, oldFromNewQueries,
+        (naive ? queryCopy.n_cols : leafSize));
+    bound::SetTreeMetric(*queryTree, metric);
+  }
+  else if (!singleMode)
+  {
+    // The query tree cannot be the same as the reference tree.
+    queryTree = new TreeType(*referenceTree);
+  }
+
+  // Stop the timer we started above.
+  Timer::Stop("tree_building");
+}
+
 /**
  * The tree is the only member we may be responsible for deleting.  The others
  * will take care of themselves.
@@ -183,44 +340,142 @@ void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
     arma::Mat<size_t>& resultingNeighbors,
     arma::mat& distances)
 {
+  if (epsilon < 0.0)
+    Log::Fatal << "NeighborSearch::Search(): epsilon must be nonnegative (got "
+        << epsilon << ")." << std::endl;
+  if (epsilon > 0.0)
+    Log::Info << "Approximate search: each neighbor distance will be within a "
+        << "factor of " << (1 + epsilon) << " of the true distance."
+        << std::endl;
+
   Timer::Start("computing_neighbors");
 
-  // If we have built the trees ourselves, then we will have to map all the
-  // indices back to their original indices when this computation is finished.
-  // To avoid an extra copy, we will store the neighbors and distances in a
-  // separate matrix.
-  arma::Mat<size_t>* neighborPtr = &resultingNeighbors;
-  arma::mat* distancePtr = &distances;
-
-  if (treeOwner && !(singleMode && hasQuerySet))
-    distancePtr = new arma::mat; // Query indices need to be mapped.
-  if (treeOwner)
-    neighborPtr = new arma::Mat<size_t>; // All indices need mapping.
+  // If we have built the trees ourselves, then the results are in the order
+  // of the trees, and are mapped back to the original indices in place when
+  // this computation is finished.
 
   // Set the size of the neighbor and distance matrices.
-  neighborPtr->set_size(k, querySet.n_cols);
-  distancePtr->set_size(k, querySet.n_cols);
-  distancePtr->fill(SortPolicy::WorstDistance());
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+
+  // If the monitor stops the search, some neighbors are never set; they must
+  // still be valid indices to be mapped back.
+  if (monitor)
+    resultingNeighbors.zeros();
 
   size_t numPrunes = 0;
 
+  // Clear the bounds and cached distances left in the statistics by an earlier
+  // search, which may have been run by another object sharing the trees.
+  referenceTree->ResetStatistics();
+  if (queryTree)
+    queryTree->ResetStatistics();
+
+  // A symmetric search updates the neighbors of reference points too, so it is
+  // run with one thread.
+  const bool symmetricSearch = symmetric && !hasQuerySet && !singleMode;
+  const size_t searchThreads = symmetricSearch ? 1 : threads;
+
   // Create the helper object for the tree traversal.
-  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> RuleType;
-  RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr, metric);
+  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> BaseRuleType;
+  typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+  RuleType rules(BaseRuleType(referenceSet, querySet, resultingNeighbors,
+      distances, metric, epsilon, symmetricSearch));
 
-  if (singleMode)
-  {
-    // Create the traverser.
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
+  tree::TraversalStatistics::Start();
 
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+  // In naive mode and in high dimensions, the trees are not used.
+  const bool bruteForce = naive ||
+      (BaseRuleType::template BlockMetric<MetricType>::IsEuclidean &&
+      querySet.n_rows > BruteForceMinDimensionality);
+
+  const bool searchedOnGPU = gpu && GPUSearch(k, resultingNeighbors,
+      distances);
+  if (searchedOnGPU)
+  {
+    Log::Info << "The neighbors were found on the GPU." << std::endl;
+  }
+  else if (bruteForce)
+  {
+    BruteForceSearch(rules);
+  }
+  else if (singleMode)
+  {
+    // Query points are independent, so they can be split between threads,
+    // each with its own rules and traverser.  The exception is trees whose
+    // rules cache base cases in the reference nodes.
+    size_t numThreads = Threads::Count(threads);
+    if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+      numThreads = 1;
+
+    // Best-first traversal needs each point to be held by one leaf only.
+    const bool useBestFirst = bestFirst &&
+        !tree::TreeTraits<TreeType>::HasSelfChildren;
+    if (bestFirst && !useBestFirst)
+      Log::Warn << "NeighborSearch::Search(): best-first traversal cannot be "
+          << "used with this tree type; using depth-first traversal."
+          << std::endl;
+
+    // The query points are handed out in batches, after each of which the
+    // monitor (if any) is called.
+    const size_t batchSize = 64;
+    const size_t batches = (querySet.n_cols + batchSize - 1) / batchSize;
+    size_t batchesDone = 0;
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+      // Create the traversers.
+      RuleType threadRules(rules);
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+      tree::BestFirstTraverser<TreeType, RuleType>
+          bestFirstTraverser(threadRules, maxLeaves);
+
+      // Now have it traverse for each point.
+      #pragma omp for schedule(dynamic, 1)
+      for (int b = 0; b < (int) batches; ++b)
+      {
+        // Once the monitor has stopped the search, skip the other batches.
+        if (monitor)
+        {
+          bool stopped;
+          #pragma omp critical(progress_monitor)
+          stopped = monitor->Stopped();
+          if (stopped)
+            continue;
+        }
+
+        const size_t end = std::min((b + 1) * batchSize,
+            (size_t) querySet.n_cols);
+        for (size_t i = b * batchSize; i < end; ++i)
+        {
+          if (useBestFirst)
+            bestFirstTraverser.Traverse(i, *referenceTree);
+          else
+            traverser.Traverse(i, *referenceTree);
+        }
+
+        if (monitor)
+        {
+          #pragma omp critical(progress_monitor)
+          {
+            ++batchesDone;
+            monitor->Continue("NeighborSearch::Search()", batchesDone,
+                (double) batchesDone / batches);
+          }
+        }
+      }
+    }
   }
   else // Dual-tree recursion.
   {
-    // Create the traverser.
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    // Create the traverser.  With more than one thread, disjoint subtrees of
+    // the query tree are traversed in parallel.  A symmetric search cannot be
+    // split into batches for the monitor.
+    tree::ParallelDualTreeTraverser<TreeType, RuleType> traverser(rules,
+        searchThreads, symmetricSearch ? NULL : monitor,
+        "NeighborSearch::Search()");
 
     traverser.Traverse(*queryTree, *referenceTree);
 
@@ -229,76 +484,231 @@ void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
     Log::Info << traverser.NumBaseCases() << " base cases were calculated.\n";
   }
 
+  // For large k the rules kept the candidates as heaps, which are sorted now.
+  if (!searchedOnGPU)
+    CandidateHeap<SortPolicy>::Sort(distances, resultingNeighbors);
+
+  tree::TraversalStatistics::Stop();
   Timer::Stop("computing_neighbors");
 
+  if (monitor && monitor->Stopped())
+    Log::Info << "NeighborSearch::Search(): stopped by the monitor; the "
+        << "neighbors of some query points were not searched." << std::endl;
+
   // Now, do we need to do mapping of indices?
-  if (!treeOwner)
+  if (!treeOwner || treeOrder)
   {
-    // No mapping needed.  We are done.
+    // No mapping needed (or wanted).  We are done.
     return;
   }
-  else if (treeOwner && hasQuerySet && !singleMode) // Map both sets.
+  else if (hasQuerySet && singleMode) // Map only references.
+  {
+    UnmapInPlace(resultingNeighbors, distances, oldFromNewReferences,
+        std::vector<size_t>());
+  }
+  else // Map both sets (which may be the same).
   {
-    // Set size of output matrices correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
+    UnmapInPlace(resultingNeighbors, distances, oldFromNewReferences,
+        hasQuerySet ? oldFromNewQueries : oldFromNewReferences);
+  }
+} // Search
 
-    for (size_t i = 0; i < distances.n_cols; i++)
-    {
-      // Map distances (copy a column).
-      distances.col(oldFromNewQueries[i]) = distancePtr->col(i);
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::Graph(
+    const size_t k,
+    arma::sp_mat& graph,
+    const double bandwidth,
+    const bool mutual)
+{
+  if (hasQuerySet)
+    Log::Fatal << "NeighborSearch::Graph(): a kNN graph can only be computed "
+        << "when the query set is the reference set." << std::endl;
 
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
-      {
-        resultingNeighbors(j, oldFromNewQueries[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
-    }
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
 
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
-  }
-  else if (treeOwner && !hasQuerySet)
+  const bool oldSymmetric = symmetric;
+  symmetric = true;
+  Search(k, neighbors, distances);
+  symmetric = oldSymmetric;
+
+  Timer::Start("graph_building");
+  KNNGraph(neighbors, distances, graph, bandwidth, mutual);
+  Timer::Stop("graph_building");
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+template<typename RuleType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::BruteForceSearch(
+    const RuleType& rules)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> BaseRuleType;
+  typedef typename TreeType::Mat::elem_type ElemType;
+  typedef typename BaseRuleType::template BlockMetric<MetricType>
+      BlockMetricType;
+
+  const bool block = BlockMetricType::IsEuclidean &&
+      querySet.n_rows > BaseRuleType::BlockMinDimensionality;
+  const bool sameSet = (&querySet == &referenceSet);
+
+  // The squared norms of the reference points are calculated once.
+  arma::Row<ElemType> referenceNorms;
+  if (block)
+    referenceNorms = arma::sum(arma::square(referenceSet), 0);
+
+  const size_t numThreads = Threads::Count(threads);
+
+  const size_t batches = (querySet.n_cols + BruteForceQueryBlock - 1) /
+      BruteForceQueryBlock;
+  size_t batchesDone = 0;
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
+    RuleType threadRules(rules);
+    arma::Mat<ElemType> products;
+    arma::Row<ElemType> queryNorms;
 
-    for (size_t i = 0; i < distances.n_cols; i++)
+    #pragma omp for schedule(dynamic, 1)
+    for (int b = 0; b < (int) batches; ++b)
     {
-      // Map distances (copy a column).
-      distances.col(oldFromNewReferences[i]) = distancePtr->col(i);
+      // Once the monitor has stopped the search, skip the other blocks.
+      if (monitor)
+      {
+        bool stopped;
+        #pragma omp critical(progress_monitor)
+        stopped = monitor->Stopped();
+        if (stopped)
+          continue;
+      }
 
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
+      const size_t queryBegin = b * BruteForceQueryBlock;
+      const size_t queryCount = std::min((size_t) BruteForceQueryBlock,
+          (size_t) querySet.n_cols - queryBegin);
+      const arma::Mat<ElemType> queries(const_cast<ElemType*>(
+          querySet.colptr(queryBegin)), querySet.n_rows, queryCount, false,
+          true);
+      if (block)
+        queryNorms = arma::sum(arma::square(queries), 0);
+
+      for (size_t referenceBegin = 0; referenceBegin < referenceSet.n_cols;
+           referenceBegin += BruteForceReferenceBlock)
       {
-        resultingNeighbors(j, oldFromNewReferences[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
+        const size_t referenceCount = std::min(
+            (size_t) BruteForceReferenceBlock,
+            (size_t) referenceSet.n_cols - referenceBegin);
+
+        if (!block)
+        {
+          for (size_t i = 0; i < queryCount; ++i)
+            for (size_t j = 0; j < referenceCount; ++j)
+              threadRules.BaseCase(queryBegin + i, referenceBegin + j);
+          continue;
+        }
+
+        // Each column holds the -2 q^T r terms of one query point.
+        const arma::Mat<ElemType> references(const_cast<ElemType*>(
+            referenceSet.colptr(referenceBegin)), referenceSet.n_rows,
+            referenceCount, false, true);
+        products = ElemType(-2) * trans(references) * queries;
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+          const size_t queryIndex = queryBegin + i;
+          for (size_t j = 0; j < referenceCount; ++j)
+          {
+            const size_t referenceIndex = referenceBegin + j;
+            if (sameSet && (queryIndex == referenceIndex))
+              continue;
+
+            // Rounding can make the distance of nearby points slightly
+            // negative.
+            double distance = std::max((double) (queryNorms[i] +
+                referenceNorms[referenceIndex] + products(j, i)), 0.0);
+            if (BlockMetricType::TakeRoot)
+              distance = sqrt(distance);
+
+            threadRules.AddCandidate(queryIndex, referenceIndex, distance);
+          }
+        }
+      }
+
+      if (monitor)
+      {
+        #pragma omp critical(progress_monitor)
+        {
+          ++batchesDone;
+          monitor->Continue("NeighborSearch::Search()", batchesDone,
+              (double) batchesDone / batches);
+        }
       }
     }
+  }
 
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
+  Log::Info << "The neighbors were found by brute force." << std::endl;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+bool NeighborSearch<SortPolicy, MetricType, TreeType>::GPUSearch(
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  if (!GPUSearchTraits<SortPolicy, MetricType>::Supported)
+  {
+    Log::Warn << "NeighborSearch::Search(): GPU search is only available for "
+        << "nearest neighbors in Euclidean distance; using the trees."
+        << std::endl;
+    return false;
+  }
+  if (!metal::Available())
+  {
+    Log::Warn << "NeighborSearch::Search(): no GPU is available; using the "
+        << "trees." << std::endl;
+    return false;
   }
-  else if (treeOwner && hasQuerySet && singleMode) // Map only references.
+  if (k > metal::MaxCandidates)
   {
-    // Set size of neighbor indices matrix correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
+    Log::Warn << "NeighborSearch::Search(): GPU search finds at most "
+        << metal::MaxCandidates << " neighbors (k = " << k << "); using the "
+        << "trees." << std::endl;
+    return false;
+  }
 
-    // Map indices of neighbors.
-    for (size_t i = 0; i < resultingNeighbors.n_cols; i++)
+  // Ask for twice as many candidates as needed, so that the single-precision
+  // distances of the GPU do not change the results.
+  const size_t references = referenceSet.n_cols - (hasQuerySet ? 0 : 1);
+  const size_t candidates = std::min(std::min(2 * k, metal::MaxCandidates),
+      references);
+  if (candidates == 0)
+    return false;
+
+  arma::Mat<size_t> candidateIndices;
+  metal::NearestCandidates(querySet, referenceSet, candidates, !hasQuerySet,
+      candidateIndices);
+
+  // Rank the candidates of each query point with exact distances.
+  const size_t found = std::min(k, candidates);
+  std::vector<std::pair<double, size_t> > ranked(candidates);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    for (size_t j = 0; j < candidates; ++j)
     {
-      for (size_t j = 0; j < resultingNeighbors.n_rows; j++)
-      {
-        resultingNeighbors(j, i) = oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
+      const size_t index = candidateIndices(j, i);
+      ranked[j] = std::make_pair(metric.Evaluate(querySet.unsafe_col(i),
+          referenceSet.unsafe_col(index)), index);
     }
+    std::partial_sort(ranked.begin(), ranked.begin() + found, ranked.end());
 
-    // Finished with temporary matrix.
-    delete neighborPtr;
+    for (size_t j = 0; j < found; ++j)
+    {
+      distances(j, i) = ranked[j].first;
+      neighbors(j, i) = ranked[j].second;
+    }
+    for (size_t j = found; j < k; ++j)
+      neighbors(j, i) = (size_t() - 1);
   }
-} // Search
+
+  return true;
+}
 
 #endif
@@ -23,6 +23,8 @@
 #ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 
+#include "candidate_heap.hpp"
+
 namespace mlpack {
 namespace neighbor {
 
@@ -30,14 +32,103 @@ template<typename SortPolicy, typename MetricType, typename TreeType>
 class NeighborSearchRules
 {
  public:
-  NeighborSearchRules(const arma::mat& referenceSet,
-                      const arma::mat& querySet,
+  //! The type of the datasets (arma::mat or arma::fmat, for instance).
+  typedef typename TreeType::Mat MatType;
+  //! The type of the elements of the datasets.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Construct the rules.  If epsilon is positive, nodes are also pruned when
+   * they can only improve a candidate distance by less than a factor of
+   * (1 + epsilon), so each of the distances found is within a factor of
+   * (1 + epsilon) of the true distance (see SortPolicy::Relax()).
+   *
+   * If symmetric is true (which requires the query set to be the reference
+   * set), each pair of leaves is compared only once by BaseCaseBlock(), and
+   * each distance updates the neighbors of both of its points.  This cannot be
+   * used with parallel traversals, since the neighbors of reference points are
+   * updated too.
+   *
+   * If there are at least CandidateHeap<SortPolicy>::MinK rows in the
+   * matrices, the candidates of each query point are kept as a heap, and the
+   * columns must be sorted with CandidateHeap<SortPolicy>::Sort() once the
+   * search is finished.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param neighbors Matrix to store the neighbor indices in.
+   * @param distances Matrix to store the neighbor distances in.
+   * @param metric Instantiated metric.
+   * @param epsilon Allowed relative error (0 for exact search).
+   * @param symmetric Whether pairs of leaves are compared only once.
+   */
+  NeighborSearchRules(const MatType& referenceSet,
+                      const MatType& querySet,
                       arma::Mat<size_t>& neighbors,
                       arma::mat& distances,
-                      MetricType& metric);
+                      MetricType& metric,
+                      const double epsilon = 0.0,
+                      const bool symmetric = false);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Calculate the base cases between every point of the given query leaf and
+   * every point of the given reference leaf, and update the neighbors of the
+   * query points.  This is called by the dual-tree traverser of
+   * BinarySpaceTree instead of BaseCase() for each pair of points.
+   *
+   * For the (squared) Euclidean distance on data with more than
+   * BlockMinDimensionality dimensions, the distances are calculated all at
+   * once as ||q||^2 + ||r||^2 - 2 q^T r, with one matrix multiplication and the
+   * squared norms cached in the leaves' statistics; otherwise, BaseCase() is
+   * called for each pair that Score() does not prune.
+   *
+   * In a symmetric search, a pair of leaves which was already compared the
+   * other way round is skipped, and otherwise every pair of points is
+   * compared (without pruning) and updates the neighbors of both points.
+   *
+   * @param queryNode Query leaf.
+   * @param referenceNode Reference leaf.
+   * @return The number of base cases calculated.
+   */
+  size_t BaseCaseBlock(TreeType& queryNode, TreeType& referenceNode);
+
+  //! Data with more dimensions than this uses the matrix multiplication in
+  //! BaseCaseBlock().
+  static const size_t BlockMinDimensionality = 16;
+
+  //! Whether MetricType is the squared Euclidean or Euclidean distance, for
+  //! which BaseCaseBlock() (and the brute-force search of NeighborSearch) can
+  //! use a matrix multiplication.
+  template<typename Metric>
+  struct BlockMetric
+  {
+    static const bool IsEuclidean = false;
+    static const bool TakeRoot = false;
+  };
+
+  template<bool MetricTakeRoot>
+  struct BlockMetric<metric::LMetric<2, MetricTakeRoot> >
+  {
+    static const bool IsEuclidean = true;
+    static const bool TakeRoot = MetricTakeRoot;
+  };
+
+  /**
+   * Add the given reference point to the neighbors of the given query point,
+   * if it is better than the current candidates.  This is used by BaseCase()
+   * and BaseCaseBlock(), and by searches which calculate the distances
+   * themselves.
+   *
+   * @param queryIndex Index of the query point.
+   * @param referenceIndex Index of the reference point.
+   * @param distance Distance between the two points.
+   */
+  void AddCandidate(const size_t queryIndex,
+                    const size_t referenceIndex,
+                    const double distance);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -90,10 +181,10 @@ class NeighborSearchRules
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const MatType& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const MatType& querySet;
 
   //! The matrix the resultant neighbor indices should be stored in.
   arma::Mat<size_t>& neighbors;
@@ -104,6 +195,9 @@ class NeighborSearchRules
   //! The instantiated metric.
   MetricType& metric;
 
+  //! The allowed relative error.
+  double epsilon;
+
   //! The last query point BaseCase() was called with.
   size_t lastQueryIndex;
   //! The last reference point BaseCase() was called with.
@@ -111,11 +205,32 @@ class NeighborSearchRules
   //! The last base case result.
   double lastBaseCase;
 
+  //! Whether the candidates are kept as heaps (see CandidateHeap).
+  bool heap;
+  //! The row of the worst candidate of each query point.
+  size_t worstRow;
+
+  //! Workspace for the distances calculated by BaseCaseBlock().
+  arma::Mat<ElemType> blockDistances;
+
+  //! Whether each pair of leaves is compared only once.
+  bool symmetric;
+  //! The pairs of leaves compared in a symmetric search, as the indices of
+  //! their first points (the smaller one first).
+  std::set<std::pair<size_t, size_t> > comparedLeaves;
+
   /**
    * Recalculate the bound for a given query node.
    */
   double CalculateBound(TreeType& queryNode) const;
 
+  /**
+   * Compare every pair of points of the two given leaves once, and update the
+   * neighbors of both points of each pair.  This is BaseCaseBlock() for a
+   * symmetric search.
+   */
+  size_t SymmetricBaseCaseBlock(TreeType& queryNode, TreeType& referenceNode);
+
   /**
    * Insert a point into the neighbors and distances matrices; this is a helper
    * function.
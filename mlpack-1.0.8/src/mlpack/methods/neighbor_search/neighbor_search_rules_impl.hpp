@@ -30,19 +30,29 @@ namespace neighbor {
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
 NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+    const MatType& referenceSet,
+    const MatType& querySet,
     arma::Mat<size_t>& neighbors,
     arma::mat& distances,
-    MetricType& metric) :
+    MetricType& metric,
+    const double epsilon,
+    const bool symmetric) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
     distances(distances),
     metric(metric),
+    epsilon(epsilon),
     lastQueryIndex(querySet.n_cols),
-    lastReferenceIndex(referenceSet.n_cols)
-{ /* Nothing left to do. */ }
+    lastReferenceIndex(referenceSet.n_cols),
+    heap(CandidateHeap<SortPolicy>::Use(distances.n_rows)),
+    worstRow(CandidateHeap<SortPolicy>::WorstRow(distances.n_rows)),
+    symmetric(symmetric)
+{
+  if (symmetric && (&querySet != &referenceSet))
+    Log::Fatal << "NeighborSearchRules: a symmetric search needs the query set "
+        << "to be the reference set." << std::endl;
+}
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline force_inline // Absolutely MUST be inline so optimizations can happen.
@@ -61,14 +71,9 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
                                     referenceSet.unsafe_col(referenceIndex));
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  const size_t insertPosition = SortPolicy::SortDistance(queryDist, distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // Insert the reference point if it is better than any of the current
+  // candidates.
+  AddCandidate(queryIndex, referenceIndex, distance);
 
   // Cache this information for the next time BaseCase() is called.
   lastQueryIndex = queryIndex;
@@ -78,6 +83,197 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t NeighborSearchRules<SortPolicy, MetricType, TreeType>::BaseCaseBlock(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  if (symmetric)
+    return SymmetricBaseCaseBlock(queryNode, referenceNode);
+
+  const std::vector<double>& queryNorms = queryNode.Stat().SquaredNorms();
+  const std::vector<double>& referenceNorms =
+      referenceNode.Stat().SquaredNorms();
+
+  if (!BlockMetric<MetricType>::IsEuclidean ||
+      querySet.n_rows <= BlockMinDimensionality ||
+      referenceNode.Count() == 0 ||
+      queryNorms.size() != queryNode.Count() ||
+      referenceNorms.size() != referenceNode.Count())
+  {
+    // Calculate each base case on its own.
+    size_t numBaseCases = 0;
+    for (size_t query = queryNode.Begin(); query < queryNode.End(); ++query)
+    {
+      if (Score(query, referenceNode) == DBL_MAX)
+        continue; // We can't improve this particular point.
+
+      for (size_t ref = referenceNode.Begin(); ref < referenceNode.End(); ++ref)
+        BaseCase(query, ref);
+
+      numBaseCases += referenceNode.Count();
+    }
+
+    return numBaseCases;
+  }
+
+  // Alias the points of the reference leaf.
+  const arma::Mat<ElemType> references(const_cast<ElemType*>(
+      referenceSet.colptr(referenceNode.Begin())), referenceSet.n_rows,
+      referenceNode.Count(), false, true);
+
+  // The distances are calculated for a chunk of query points at a time, so
+  // that the block stays small even for very large leaves (as in naive mode).
+  const size_t chunkSize = std::max((size_t) 1,
+      (size_t) 65536 / referenceNode.Count());
+  const bool sameSet = (&querySet == &referenceSet);
+
+  for (size_t chunkBegin = 0; chunkBegin < queryNode.Count();
+       chunkBegin += chunkSize)
+  {
+    const size_t chunkCount = std::min(chunkSize,
+        queryNode.Count() - chunkBegin);
+    const arma::Mat<ElemType> queries(const_cast<ElemType*>(querySet.colptr(
+        queryNode.Begin() + chunkBegin)), querySet.n_rows, chunkCount, false,
+        true);
+
+    // Each column holds the -2 q^T r terms of one query point.
+    blockDistances = ElemType(-2) * trans(references) * queries;
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+      const size_t queryIndex = queryNode.Begin() + chunkBegin + i;
+
+      for (size_t j = 0; j < referenceNode.Count(); ++j)
+      {
+        const size_t referenceIndex = referenceNode.Begin() + j;
+        if (sameSet && (queryIndex == referenceIndex))
+          continue;
+
+        // Rounding can make the distance of nearby points slightly negative.
+        double distance = std::max(queryNorms[chunkBegin + i] +
+            referenceNorms[j] + blockDistances(j, i), 0.0);
+        if (BlockMetric<MetricType>::TakeRoot)
+          distance = sqrt(distance);
+
+        AddCandidate(queryIndex, referenceIndex, distance);
+      }
+    }
+  }
+
+  return queryNode.Count() * referenceNode.Count();
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+SymmetricBaseCaseBlock(TreeType& queryNode, TreeType& referenceNode)
+{
+  // The query tree is a copy of the reference tree, so the same leaf of both
+  // trees has the same first point.
+  const bool sameLeaf = (queryNode.Begin() == referenceNode.Begin());
+  if (!sameLeaf)
+  {
+    // If the leaves were compared the other way round, the neighbors of the
+    // query points have seen every reference point already.
+    const std::pair<size_t, size_t> leaves(
+        std::min(queryNode.Begin(), referenceNode.Begin()),
+        std::max(queryNode.Begin(), referenceNode.Begin()));
+    if (!comparedLeaves.insert(leaves).second)
+      return 0;
+  }
+
+  if (referenceNode.Count() == 0)
+    return 0;
+
+  const std::vector<double>& queryNorms = queryNode.Stat().SquaredNorms();
+  const std::vector<double>& referenceNorms =
+      referenceNode.Stat().SquaredNorms();
+  const bool block = BlockMetric<MetricType>::IsEuclidean &&
+      querySet.n_rows > BlockMinDimensionality &&
+      queryNorms.size() == queryNode.Count() &&
+      referenceNorms.size() == referenceNode.Count();
+
+  const arma::Mat<ElemType> references(const_cast<ElemType*>(
+      referenceSet.colptr(referenceNode.Begin())), referenceSet.n_rows,
+      referenceNode.Count(), false, true);
+
+  // As in BaseCaseBlock(), the query points are taken a chunk at a time.
+  const size_t chunkSize = std::max((size_t) 1,
+      (size_t) 65536 / referenceNode.Count());
+  size_t numBaseCases = 0;
+
+  for (size_t chunkBegin = 0; chunkBegin < queryNode.Count();
+       chunkBegin += chunkSize)
+  {
+    const size_t chunkCount = std::min(chunkSize,
+        queryNode.Count() - chunkBegin);
+
+    if (block)
+    {
+      const arma::Mat<ElemType> queries(const_cast<ElemType*>(
+          querySet.colptr(queryNode.Begin() + chunkBegin)), querySet.n_rows,
+          chunkCount, false, true);
+      blockDistances = ElemType(-2) * trans(references) * queries;
+    }
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+      const size_t queryIndex = queryNode.Begin() + chunkBegin + i;
+
+      // Within one leaf, each pair is taken once, and no point is compared
+      // with itself.
+      const size_t firstReference = sameLeaf ? (chunkBegin + i + 1) : 0;
+      for (size_t j = firstReference; j < referenceNode.Count(); ++j)
+      {
+        const size_t referenceIndex = referenceNode.Begin() + j;
+
+        double distance;
+        if (block)
+        {
+          distance = std::max(queryNorms[chunkBegin + i] + referenceNorms[j] +
+              blockDistances(j, i), 0.0);
+          if (BlockMetric<MetricType>::TakeRoot)
+            distance = sqrt(distance);
+        }
+        else
+        {
+          distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+              referenceSet.unsafe_col(referenceIndex));
+        }
+
+        AddCandidate(queryIndex, referenceIndex, distance);
+        AddCandidate(referenceIndex, queryIndex, distance);
+        ++numBaseCases;
+      }
+    }
+  }
+
+  return numBaseCases;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+AddCandidate(const size_t queryIndex,
+             const size_t referenceIndex,
+             const double distance)
+{
+  // With many candidates, they are kept as a heap (see CandidateHeap).
+  if (heap)
+  {
+    CandidateHeap<SortPolicy>::Insert(distances.colptr(queryIndex),
+        neighbors.colptr(queryIndex), distances.n_rows, distance,
+        referenceIndex);
+    return;
+  }
+
+  // Otherwise SortDistance() gives the position in the sorted list, or
+  // (size_t() - 1) if the point should not be added.
+  arma::vec queryDist = distances.unsafe_col(queryIndex);
+  const size_t insertPosition = SortPolicy::SortDistance(queryDist, distance);
+  if (insertPosition != (size_t() - 1))
+    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -108,12 +304,14 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
   }
   else
   {
-    const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
+    const arma::Col<ElemType> queryPoint = querySet.unsafe_col(queryIndex);
     distance = SortPolicy::BestPointToNodeDistance(queryPoint, &referenceNode);
   }
 
-  // Compare against the best k'th distance for this query point so far.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Compare against the best k'th distance for this query point so far,
+  // allowing for the relative error.
+  const double bestDistance = SortPolicy::Relax(
+      distances(worstRow, queryIndex), epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX;
 }
@@ -129,7 +327,8 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
     return oldScore;
 
   // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = SortPolicy::Relax(
+      distances(worstRow, queryIndex), epsilon);
 
   return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
 }
@@ -226,8 +425,9 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     distance = SortPolicy::BestNodeToNodeDistance(&queryNode, &referenceNode);
   }
 
-  // Update our bound.
-  const double bestDistance = CalculateBound(queryNode);
+  // Update our bound, and allow for the relative error.
+  const double bestDistance = SortPolicy::Relax(CalculateBound(queryNode),
+      epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX;
 }
@@ -241,8 +441,9 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   if (oldScore == DBL_MAX)
     return oldScore;
 
-  // Update our bound.
-  const double bestDistance = CalculateBound(queryNode);
+  // Update our bound, and allow for the relative error.
+  const double bestDistance = SortPolicy::Relax(CalculateBound(queryNode),
+      epsilon);
 
   return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
 }
@@ -279,7 +480,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // candidates (for (1) and (2)).
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = distances(distances.n_rows - 1, queryNode.Point(i));
+    const double distance = distances(worstRow, queryNode.Point(i));
     if (SortPolicy::IsBetter(distance, bestPointDistance))
       bestPointDistance = distance;
     if (SortPolicy::IsBetter(worstPointDistance, distance))
@@ -24,16 +24,87 @@
 #define __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_STAT_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/tree_traits.hpp>
+
+#include <boost/static_assert.hpp>
 
 namespace mlpack {
 namespace neighbor {
 
+/**
+ * The base case cache of a NeighborSearchStat: the node that the last base case
+ * of this node's first point was calculated with, and its distance.  Only
+ * trees whose first point is the centroid of the node (such as the cover tree)
+ * use it, so it is only stored when CacheBaseCases is true.
+ */
+template<bool CacheBaseCases>
+class BaseCaseCache
+{
+ private:
+  //! The last distance evaluation node.
+  void* lastDistanceNode;
+  //! The last distance evaluation.
+  double lastDistance;
+
+ public:
+  //! Initialize the cache as empty.
+  BaseCaseCache() : lastDistanceNode(NULL), lastDistance(0.0) { }
+
+  //! Get the last distance evaluation node.
+  void* LastDistanceNode() const { return lastDistanceNode; }
+  //! Modify the last distance evaluation node.
+  void*& LastDistanceNode() { return lastDistanceNode; }
+  //! Get the last distance calculation.
+  double LastDistance() const { return lastDistance; }
+  //! Modify the last distance calculation.
+  double& LastDistance() { return lastDistance; }
+};
+
+/**
+ * Without the cache, the node stores nothing.  NeighborSearchRules still names
+ * the accessors (in branches for trees whose first point is the centroid), but
+ * NeighborSearchStat refuses to be built for such trees, so these are never
+ * called.
+ */
+template<>
+class BaseCaseCache<false>
+{
+ public:
+  //! There is no last distance evaluation node.
+  void* LastDistanceNode() const { return NULL; }
+  //! This is never called; see NeighborSearchStat.
+  void*& LastDistanceNode() { static void* unused = NULL; return unused; }
+  //! There is no last distance calculation.
+  double LastDistance() const { return 0.0; }
+  //! This is never called; see NeighborSearchStat.
+  double& LastDistance() { static double unused = 0.0; return unused; }
+};
+
 /**
  * Extra data for each node in the tree.  For neighbor searches, each node only
- * needs to store a bound on neighbor distances.
+ * needs to store a bound on neighbor distances.  Leaves of a BinarySpaceTree
+ * also store the squared norms of their points, for
+ * NeighborSearchRules::BaseCaseBlock().
+ *
+ * Trees whose first point is the centroid of the node (the cover tree) also
+ * need a cache of the last base case of each node, which must be asked for
+ * with CacheBaseCases; without it, building such a tree does not compile.
+ * Other trees leave it out, which keeps their nodes small:
+ *
+ * @code
+ * typedef BinarySpaceTree<HRectBound<2>,
+ *     NeighborSearchStat<NearestNeighborSort> > KDTreeType;
+ * typedef CoverTree<EuclideanDistance, FirstPointIsRoot,
+ *     NeighborSearchStat<NearestNeighborSort, true> > CoverTreeType;
+ * @endcode
+ *
+ * @tparam SortPolicy Sort policy of the search.
+ * @tparam CacheBaseCases Whether to store the base case cache (see
+ *     BaseCaseCache).
  */
-template<typename SortPolicy>
-class NeighborSearchStat
+template<typename SortPolicy, bool CacheBaseCases = false>
+class NeighborSearchStat : public BaseCaseCache<CacheBaseCases>
 {
  private:
   //! The first bound on the node's neighbor distances (B_1).  This represents
@@ -47,10 +118,32 @@ class NeighborSearchStat
   //! The better of the two bounds.
   double bound;
 
-  //! The last distance evaluation node.
-  void* lastDistanceNode;
-  //! The last distance evaluation.
-  double lastDistance;
+  //! The squared norms of the points in the node (only for leaves of a
+  //! BinarySpaceTree).  This is a std::vector and not an arma::vec, whose
+  //! preallocated local storage would be most of the size of every node.
+  std::vector<double> squaredNorms;
+
+  //! Calculate the squared norms of the points of a BinarySpaceTree leaf.
+  template<typename BoundType,
+           typename StatisticType,
+           typename MatType,
+           typename SplitType>
+  static void LeafNorms(const tree::BinarySpaceTree<BoundType, StatisticType,
+                            MatType, SplitType>& node,
+                        std::vector<double>& norms)
+  {
+    if (!node.IsLeaf() || node.Count() == 0)
+      return;
+
+    // The norms are kept in double precision, even for float data.
+    norms = arma::conv_to<std::vector<double> >::from(sum(square(
+        node.Dataset().cols(node.Begin(), node.End() - 1)), 0));
+  }
+
+  //! Other trees do not store norms.
+  template<typename TreeType>
+  static void LeafNorms(const TreeType& /* node */,
+                        std::vector<double>& /* norms */) { }
 
  public:
   /**
@@ -60,21 +153,24 @@ class NeighborSearchStat
   NeighborSearchStat() :
       firstBound(SortPolicy::WorstDistance()),
       secondBound(SortPolicy::WorstDistance()),
-      bound(SortPolicy::WorstDistance()),
-      lastDistanceNode(NULL),
-      lastDistance(0.0) { }
+      bound(SortPolicy::WorstDistance()) { }
 
   /**
    * Initialization for a fully initialized node.  In this case, we don't need
    * to worry about the node.
    */
   template<typename TreeType>
-  NeighborSearchStat(TreeType& /* node */) :
+  NeighborSearchStat(TreeType& node) :
       firstBound(SortPolicy::WorstDistance()),
       secondBound(SortPolicy::WorstDistance()),
-      bound(SortPolicy::WorstDistance()),
-      lastDistanceNode(NULL),
-      lastDistance(0.0) { }
+      bound(SortPolicy::WorstDistance())
+  {
+    // The rules use the base case cache for these trees.
+    BOOST_STATIC_ASSERT(CacheBaseCases ||
+        !tree::TreeTraits<TreeType>::FirstPointIsCentroid);
+
+    LeafNorms(node, squaredNorms);
+  }
 
   //! Get the first bound.
   double FirstBound() const { return firstBound; }
@@ -88,14 +184,9 @@ class NeighborSearchStat
   double Bound() const { return bound; }
   //! Modify the overall bound (it should be the better of the two bounds).
   double& Bound() { return bound; }
-  //! Get the last distance evaluation node.
-  void* LastDistanceNode() const { return lastDistanceNode; }
-  //! Modify the last distance evaluation node.
-  void*& LastDistanceNode() { return lastDistanceNode; }
-  //! Get the last distance calculation.
-  double LastDistance() const { return lastDistance; }
-  //! Modify the last distance calculation.
-  double& LastDistance() { return lastDistance; }
+  //! Get the squared norms of the points in the node (empty unless the node is
+  //! a leaf of a BinarySpaceTree).
+  const std::vector<double>& SquaredNorms() const { return squaredNorms; }
 };
 
 }; // namespace neighbor
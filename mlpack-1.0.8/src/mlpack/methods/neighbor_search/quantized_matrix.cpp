@@ -0,0 +1,180 @@
+/**
+ * @file quantized_matrix.cpp
+ *
+ * Implementation of the scalar and product quantization of QuantizedMatrix.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quantized_matrix.hpp"
+
+#include <mlpack/methods/kmeans/kmeans.hpp>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+QuantizedMatrix::QuantizedMatrix(const arma::mat& data,
+                                 const size_t subspaces,
+                                 const size_t maxTrainingPoints) :
+    scalar(subspaces == 0)
+{
+  if (data.n_cols == 0 || data.n_rows == 0)
+    Log::Fatal << "QuantizedMatrix::QuantizedMatrix(): cannot quantize an "
+        << "empty dataset." << std::endl;
+  if (subspaces > data.n_rows)
+    Log::Fatal << "QuantizedMatrix::QuantizedMatrix(): the number of "
+        << "subspaces (" << subspaces << ") cannot be greater than the "
+        << "dimensionality (" << data.n_rows << ")." << std::endl;
+
+  // Split the dimensions into subspaces whose sizes differ by at most one.
+  const size_t numSubspaces = scalar ? data.n_rows : subspaces;
+  subspaceBegin.resize(numSubspaces + 1);
+  for (size_t s = 0; s <= numSubspaces; ++s)
+    subspaceBegin[s] = (s * data.n_rows) / numSubspaces;
+
+  if (scalar)
+    QuantizeScalar(data);
+  else
+    QuantizeProduct(data, maxTrainingPoints);
+}
+
+void QuantizedMatrix::DistanceTable(const arma::vec& query,
+                                    arma::mat& table) const
+{
+  Log::Assert(query.n_elem == Dimensionality());
+
+  table.set_size(codebooks[0].n_cols, codebooks.size());
+  for (size_t s = 0; s < codebooks.size(); ++s)
+  {
+    const arma::mat& codebook = codebooks[s];
+    const double* q = query.memptr() + subspaceBegin[s];
+    for (size_t c = 0; c < codebook.n_cols; ++c)
+    {
+      const double* centroid = codebook.colptr(c);
+      double sum = 0;
+      for (size_t d = 0; d < codebook.n_rows; ++d)
+        sum += (q[d] - centroid[d]) * (q[d] - centroid[d]);
+
+      table(c, s) = sum;
+    }
+  }
+}
+
+void QuantizedMatrix::Decode(const size_t index, arma::vec& point) const
+{
+  point.set_size(Dimensionality());
+  for (size_t s = 0; s < codebooks.size(); ++s)
+  {
+    const double* centroid = codebooks[s].colptr(codes(s, index));
+    for (size_t d = 0; d < codebooks[s].n_rows; ++d)
+      point[subspaceBegin[s] + d] = centroid[d];
+  }
+}
+
+void QuantizedMatrix::QuantizeScalar(const arma::mat& data)
+{
+  const arma::vec mins = arma::min(data, 1);
+  const arma::vec maxs = arma::max(data, 1);
+
+  // The codebook of each dimension is 256 evenly spaced values between the
+  // minimum and maximum of the dimension.
+  codebooks.resize(data.n_rows);
+  arma::vec scales(data.n_rows);
+  for (size_t d = 0; d < data.n_rows; ++d)
+  {
+    scales[d] = (maxs[d] - mins[d]) / 255.0;
+    codebooks[d].set_size(1, 256);
+    for (size_t c = 0; c < 256; ++c)
+      codebooks[d](0, c) = mins[d] + scales[d] * c;
+  }
+
+  codes.set_size(data.n_rows, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t d = 0; d < data.n_rows; ++d)
+    {
+      if (scales[d] == 0.0)
+      {
+        codes(d, i) = 0;
+        continue;
+      }
+
+      const double level = floor((data(d, i) - mins[d]) / scales[d] + 0.5);
+      codes(d, i) = (unsigned char) std::min(std::max(level, 0.0), 255.0);
+    }
+  }
+}
+
+void QuantizedMatrix::QuantizeProduct(const arma::mat& data,
+                                      const size_t maxTrainingPoints)
+{
+  // Train on evenly spaced points, so that large datasets do not have to be
+  // clustered in full.
+  const size_t numTraining = std::max((size_t) 1,
+      std::min((size_t) data.n_cols, maxTrainingPoints));
+  arma::uvec trainingIndices(numTraining);
+  for (size_t i = 0; i < numTraining; ++i)
+    trainingIndices[i] = (arma::uword) ((i * data.n_cols) / numTraining);
+
+  const size_t numCentroids = std::min((size_t) 256, numTraining);
+  const size_t numSubspaces = subspaceBegin.size() - 1;
+
+  kmeans::KMeans<> kmeans(25);
+  codebooks.resize(numSubspaces);
+  codes.set_size(numSubspaces, data.n_cols);
+  for (size_t s = 0; s < numSubspaces; ++s)
+  {
+    const size_t begin = subspaceBegin[s];
+    const size_t end = subspaceBegin[s + 1] - 1;
+
+    arma::mat training(end - begin + 1, numTraining);
+    for (size_t i = 0; i < numTraining; ++i)
+      training.col(i) = data.submat(begin, trainingIndices[i], end,
+          trainingIndices[i]);
+
+    arma::Col<size_t> assignments;
+    kmeans.Cluster(training, numCentroids, assignments, codebooks[s]);
+
+    // Assign every point to its nearest centroid, a block of points at a time:
+    // ||x - c||^2 = ||x||^2 + ||c||^2 - 2 c^T x, and ||x||^2 does not change
+    // which centroid is nearest.
+    const arma::mat& codebook = codebooks[s];
+    const arma::rowvec centroidNorms = arma::sum(arma::square(codebook), 0);
+    const size_t blockSize = 4096;
+    for (size_t first = 0; first < data.n_cols; first += blockSize)
+    {
+      const size_t last = std::min(first + blockSize, (size_t) data.n_cols) - 1;
+      const arma::mat cross = trans(codebook) *
+          data.submat(begin, first, end, last);
+
+      for (size_t j = 0; j < cross.n_cols; ++j)
+      {
+        size_t best = 0;
+        double bestValue = DBL_MAX;
+        for (size_t c = 0; c < cross.n_rows; ++c)
+        {
+          const double value = centroidNorms[c] - 2.0 * cross(c, j);
+          if (value < bestValue)
+          {
+            bestValue = value;
+            best = c;
+          }
+        }
+
+        codes(s, first + j) = (unsigned char) best;
+      }
+    }
+  }
+}
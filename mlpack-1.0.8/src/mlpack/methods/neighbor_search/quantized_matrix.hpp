@@ -0,0 +1,172 @@
+/**
+ * @file quantized_matrix.hpp
+ *
+ * Compressed storage of a set of reference points, as 8-bit codes, for
+ * approximate neighbor search with asymmetric distances.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_MATRIX_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_MATRIX_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * A set of points stored as 8-bit codes, which are used to approximate the
+ * squared Euclidean distances between full-precision query points and the
+ * stored points (asymmetric distance computation).
+ *
+ * The dimensions are split into contiguous subspaces, and each subspace has a
+ * codebook of at most 256 centroids; each point is stored as the index of the
+ * nearest centroid in each subspace, so a point takes one byte per subspace
+ * instead of eight bytes per dimension.  Two kinds of codebooks are available:
+ *
+ *  - scalar quantization (the default): every dimension is its own subspace,
+ *    and its codebook is a uniform grid of 256 values between the minimum and
+ *    maximum of the dimension (8x smaller than arma::mat);
+ *  - product quantization: the given number of subspaces, with codebooks
+ *    trained with k-means on (a sample of) the points (8 * dimensionality /
+ *    subspaces times smaller than arma::mat).
+ *
+ * To compute distances to a query point, first build its distance table with
+ * DistanceTable() (the squared distance from the query to every centroid of
+ * every subspace), and then call Distance() with the table for each stored
+ * point; that is one table lookup per subspace.
+ *
+ * @code
+ * QuantizedMatrix codes(referenceSet, 16); // Product quantization.
+ * arma::mat table;
+ * codes.DistanceTable(query, table);
+ * double approximateDistance = codes.Distance(table, 42);
+ * @endcode
+ */
+class QuantizedMatrix
+{
+ public:
+  /**
+   * Quantize the given points.
+   *
+   * @param data Points to quantize (one per column).
+   * @param subspaces Number of subspaces for product quantization; 0 (the
+   *     default) means scalar quantization of each dimension.
+   * @param maxTrainingPoints Maximum number of points (taken at evenly spaced
+   *     positions) used to train the product quantization codebooks.
+   */
+  QuantizedMatrix(const arma::mat& data,
+                  const size_t subspaces = 0,
+                  const size_t maxTrainingPoints = 65536);
+
+  /**
+   * Compute the squared distances from the given query point to every centroid
+   * of every subspace.  Column s of the table holds the distances for subspace
+   * s.
+   *
+   * @param query Query point.
+   * @param table Matrix to store the distance table in.
+   */
+  void DistanceTable(const arma::vec& query, arma::mat& table) const;
+
+  /**
+   * Approximate the squared Euclidean distance between a query point and the
+   * given stored point, using the distance table of the query.
+   *
+   * @param table Distance table of the query, from DistanceTable().
+   * @param index Index of the stored point.
+   */
+  double Distance(const arma::mat& table, const size_t index) const
+  {
+    const unsigned char* code = codes.colptr(index);
+    double sum = 0;
+    for (size_t s = 0; s < codes.n_rows; ++s)
+      sum += table(code[s], s);
+
+    return sum;
+  }
+
+  /**
+   * Reconstruct the given stored point from its code.
+   *
+   * @param index Index of the stored point.
+   * @param point Vector to store the reconstructed point in.
+   */
+  void Decode(const size_t index, arma::vec& point) const;
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return subspaceBegin.back(); }
+  //! Get the number of points.
+  size_t NumPoints() const { return codes.n_cols; }
+  //! Get the number of subspaces (one byte of each code).
+  size_t Subspaces() const { return codes.n_rows; }
+  //! Get whether each dimension is quantized on its own (scalar quantization).
+  bool Scalar() const { return scalar; }
+
+  //! Get the codes (one column per point).
+  const arma::Mat<unsigned char>& Codes() const { return codes; }
+  //! Get the codebook of the given subspace (one centroid per column).
+  const arma::mat& Codebook(const size_t subspace) const
+  { return codebooks[subspace]; }
+
+ private:
+  //! Whether each dimension is quantized on its own.
+  bool scalar;
+  //! The first dimension of each subspace, followed by the dimensionality.
+  std::vector<size_t> subspaceBegin;
+  //! The codebook of each subspace.
+  std::vector<arma::mat> codebooks;
+  //! The code of each point.
+  arma::Mat<unsigned char> codes;
+
+  //! Build uniform codebooks for each dimension and encode the points.
+  void QuantizeScalar(const arma::mat& data);
+  //! Train codebooks for each subspace with k-means and encode the points.
+  void QuantizeProduct(const arma::mat& data, const size_t maxTrainingPoints);
+};
+
+/**
+ * Convert the squared Euclidean distances of QuantizedMatrix into distances
+ * of the given metric.  Only the L2 metrics can be approximated from the codes;
+ * for any other metric, Supported is false.
+ *
+ * @tparam MetricType Type of metric used by the search.
+ */
+template<typename MetricType>
+struct QuantizedDistance
+{
+  //! Whether QuantizedMatrix can approximate this metric.
+  static const bool Supported = false;
+
+  //! Convert a squared Euclidean distance into a distance of this metric.
+  static double FromSquared(const double squared) { return squared; }
+};
+
+//! The L2 metrics are the squared distances, or their square roots.
+template<bool TakeRoot>
+struct QuantizedDistance<metric::LMetric<2, TakeRoot> >
+{
+  static const bool Supported = true;
+
+  static double FromSquared(const double squared)
+  { return TakeRoot ? sqrt(squared) : squared; }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file query_server.hpp
+ *
+ * A k-nearest-neighbor query server, which keeps a reference tree in memory
+ * and answers batches of queries, from the library or with a simple text
+ * protocol over streams.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_QUERY_SERVER_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_QUERY_SERVER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/tree_index.hpp>
+
+#include <iostream>
+
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * A QueryServer builds (or loads) a tree on a reference set once, and then
+ * answers any number of batches of k-nearest-neighbor queries against it, with
+ * a different k for each batch if needed.  Each batch is answered with
+ * single-tree search, parallel over the query points (see
+ * NeighborSearch::Threads()), so there is no query tree to build, and the cost
+ * of building the reference tree is paid only once for the whole stream of
+ * queries.
+ *
+ * @code
+ * QueryServer<> server(referenceData);
+ * server.Search(queries, 5, neighbors, distances);
+ * server.Search(moreQueries, 10, neighbors, distances);
+ * @endcode
+ *
+ * The server can also answer queries sent as text over a pair of streams (for
+ * instance, standard input and output, or a socket); see Serve() and the
+ * knn_server program.  Neighbor indices always refer to the columns of the
+ * original reference set.
+ *
+ * @tparam TreeType Type of tree to use; currently it must be a BinarySpaceTree
+ *     with an HRectBound (see TreeIndex).
+ */
+template<typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > >
+class QueryServer
+{
+ public:
+  /**
+   * Build the tree on a copy of the given reference set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param options Options for building the tree (see tree::BuildOptions).
+   */
+  QueryServer(const typename TreeType::Mat& referenceSet,
+              const tree::BuildOptions& options = tree::BuildOptions());
+
+  /**
+   * Load the tree and the reference set from a tree index saved with
+   * tree::TreeIndex::Save().  If the file cannot be loaded, a fatal error is
+   * given.
+   *
+   * @param indexFile File containing the tree index.
+   */
+  QueryServer(const std::string& indexFile);
+
+  /**
+   * Delete the tree.
+   */
+  ~QueryServer();
+
+  /**
+   * Find the k nearest neighbors in the reference set of each point in the
+   * given batch of queries.  The query points must have the dimensionality of
+   * the reference set, and k must be at most the number of reference points;
+   * otherwise a fatal error is given.  The tree is only read, so several
+   * batches may be searched at once from different threads.
+   *
+   * @param querySet Batch of query points.
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the indices of the neighbors in.
+   * @param distances Matrix to store the distances to the neighbors in.
+   */
+  void Search(const typename TreeType::Mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Answer the requests read from the given input stream, writing the replies
+   * to the given output stream, until the input ends or a "quit" or "shutdown"
+   * request is read.  Each request is one line, and each reply starts with a
+   * line which is either "ok ..." or "error <message>".  The requests are:
+   *
+   *  - "knn <k> <n>", followed by n lines with one query point each (values
+   *    separated by spaces or commas); the reply is "ok <n> <k>" followed by n
+   *    lines, each with the k neighbor indices and then the k distances of one
+   *    query point.
+   *  - "info"; the reply is "ok <number of points> <dimensionality>".
+   *  - "quit", which ends the session; the reply is "ok".
+   *  - "shutdown", which ends the session and asks the server to stop; the
+   *    reply is "ok".
+   *
+   * Malformed requests get an error reply and do not end the session.
+   *
+   * @param input Stream to read requests from.
+   * @param output Stream to write replies to.
+   * @return Whether a "shutdown" request was read.
+   */
+  bool Serve(std::istream& input, std::ostream& output);
+
+  //! Get the reference set (reordered by tree construction).
+  const typename TreeType::Mat& Dataset() const { return index->Dataset(); }
+
+  //! Get the number of threads used to answer each batch (0 means the OpenMP
+  //! default).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used to answer each batch.
+  size_t& Threads() { return threads; }
+
+  //! Get the relative error allowed for approximate search (0 for exact).
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative error allowed for approximate search.
+  double& Epsilon() { return epsilon; }
+
+  //! Get whether each query point is searched best-first.
+  bool BestFirst() const { return bestFirst; }
+  //! Modify whether each query point is searched best-first (see
+  //! NeighborSearch::BestFirst()).
+  bool& BestFirst() { return bestFirst; }
+
+  //! Get the largest number of leaves visited for each query point in
+  //! best-first search (0 means there is no limit).
+  size_t MaxLeaves() const { return maxLeaves; }
+  //! Modify the largest number of leaves visited for each query point in
+  //! best-first search; if it is nonzero, the time taken by each query point
+  //! is bounded, and the neighbors found are approximate (see
+  //! NeighborSearch::MaxLeaves()).
+  size_t& MaxLeaves() { return maxLeaves; }
+
+  //! Get the number of query points answered so far.
+  size_t QueriesAnswered() const { return queriesAnswered; }
+
+ private:
+  //! The reference set, if the tree was built and not loaded.
+  typename TreeType::Mat referenceCopy;
+  //! The tree and the (reordered) reference set.
+  tree::TreeIndex<TreeType>* index;
+
+  //! The number of threads used to answer each batch.
+  size_t threads;
+  //! The relative error allowed for approximate search.
+  double epsilon;
+  //! Whether each query point is searched best-first.
+  bool bestFirst;
+  //! The largest number of leaves visited for each query point in best-first
+  //! search.
+  size_t maxLeaves;
+  //! The number of query points answered so far.
+  size_t queriesAnswered;
+
+  /**
+   * Read the n query points of a "knn" request from the given stream into the
+   * given matrix.  If a line is missing or does not have as many values as the
+   * reference set has dimensions, the error message is set; all n lines are
+   * still consumed, if they are there.
+   */
+  void ReadQueries(std::istream& input,
+                   const size_t n,
+                   typename TreeType::Mat& queries,
+                   std::string& error) const;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "query_server_impl.hpp"
+
+#endif
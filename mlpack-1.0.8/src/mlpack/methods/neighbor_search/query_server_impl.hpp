@@ -0,0 +1,234 @@
+/**
+ * @file query_server_impl.hpp
+ *
+ * Implementation of QueryServer.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_QUERY_SERVER_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_QUERY_SERVER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "query_server.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "unmap.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename TreeType>
+QueryServer<TreeType>::QueryServer(
+    const typename TreeType::Mat& referenceSet,
+    const tree::BuildOptions& options) :
+    referenceCopy(referenceSet),
+    index(NULL),
+    threads(0),
+    epsilon(0.0),
+    bestFirst(false),
+    maxLeaves(0),
+    queriesAnswered(0)
+{
+  Timer::Start("tree_building");
+  index = new tree::TreeIndex<TreeType>(referenceCopy, options);
+  Timer::Stop("tree_building");
+
+  // Keep the nodes of the tree together in memory, for faster traversal.
+  index->Tree().Flatten();
+}
+
+template<typename TreeType>
+QueryServer<TreeType>::QueryServer(const std::string& indexFile) :
+    index(NULL),
+    threads(0),
+    epsilon(0.0),
+    bestFirst(false),
+    maxLeaves(0),
+    queriesAnswered(0)
+{
+  Timer::Start("loading_index");
+  index = new tree::TreeIndex<TreeType>(indexFile);
+  Timer::Stop("loading_index");
+
+  index->Tree().Flatten();
+}
+
+template<typename TreeType>
+QueryServer<TreeType>::~QueryServer()
+{
+  delete index;
+}
+
+template<typename TreeType>
+void QueryServer<TreeType>::Search(const typename TreeType::Mat& querySet,
+                                   const size_t k,
+                                   arma::Mat<size_t>& neighbors,
+                                   arma::mat& distances)
+{
+  if (querySet.n_rows != Dataset().n_rows)
+    Log::Fatal << "QueryServer::Search(): query points have dimensionality "
+        << querySet.n_rows << ", but reference points have dimensionality "
+        << Dataset().n_rows << "!" << std::endl;
+  if (k == 0 || k > Dataset().n_cols)
+    Log::Fatal << "QueryServer::Search(): k must be between 1 and the number "
+        << "of reference points (" << Dataset().n_cols << "); " << k
+        << " given!" << std::endl;
+
+  // The tree is owned by the index, so the search does not copy the reference
+  // set or map the results back; only the reference indices need mapping,
+  // since there is no query tree.
+  NeighborSearch<NearestNeighborSort, metric::EuclideanDistance, TreeType>
+      knn(&index->Tree(), NULL, Dataset(), querySet, true);
+  knn.Threads() = threads;
+  knn.Epsilon() = epsilon;
+  knn.BestFirst() = bestFirst;
+  knn.MaxLeaves() = maxLeaves;
+
+  arma::Mat<size_t> treeNeighbors;
+  arma::mat treeDistances;
+  knn.Search(k, treeNeighbors, treeDistances);
+
+  Unmap(treeNeighbors, treeDistances, index->OldFromNew(), neighbors,
+      distances);
+
+  // Batches may be answered from several threads at once.
+  #pragma omp atomic
+  queriesAnswered += querySet.n_cols;
+}
+
+template<typename TreeType>
+bool QueryServer<TreeType>::Serve(std::istream& input, std::ostream& output)
+{
+  std::string line;
+  while (std::getline(input, line))
+  {
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+
+    // Each reply is written at once, so that a socket sends it in one piece.
+    std::ostringstream reply;
+    reply.precision(17);
+
+    if (command == "")
+    {
+      continue;
+    }
+    else if (command == "quit" || command == "shutdown")
+    {
+      output << "ok" << std::endl;
+      return (command == "shutdown");
+    }
+    else if (command == "info")
+    {
+      reply << "ok " << Dataset().n_cols << " " << Dataset().n_rows << "\n";
+    }
+    else if (command == "knn")
+    {
+      size_t k, n;
+      std::string error;
+      typename TreeType::Mat queries;
+      if (!(request >> k >> n))
+      {
+        error = "expected 'knn <k> <n>'";
+      }
+      else
+      {
+        // The query points are read even if k is invalid, so that the next
+        // request is read from the right line.
+        ReadQueries(input, n, queries, error);
+        if (error == "" && (k == 0 || k > Dataset().n_cols))
+          error = "k must be between 1 and the number of reference points";
+      }
+
+      if (error != "")
+      {
+        reply << "error " << error << "\n";
+      }
+      else
+      {
+        arma::Mat<size_t> neighbors;
+        arma::mat distances;
+        if (n > 0)
+          Search(queries, k, neighbors, distances);
+
+        reply << "ok " << n << " " << k << "\n";
+        for (size_t i = 0; i < n; ++i)
+        {
+          for (size_t j = 0; j < k; ++j)
+            reply << neighbors(j, i) << " ";
+          for (size_t j = 0; j < k; ++j)
+            reply << distances(j, i) << ((j == k - 1) ? "\n" : " ");
+        }
+      }
+    }
+    else
+    {
+      reply << "error unknown request '" << command << "'\n";
+    }
+
+    output << reply.str() << std::flush;
+  }
+
+  return false;
+}
+
+template<typename TreeType>
+void QueryServer<TreeType>::ReadQueries(std::istream& input,
+                                        const size_t n,
+                                        typename TreeType::Mat& queries,
+                                        std::string& error) const
+{
+  const size_t dimensionality = Dataset().n_rows;
+  queries.set_size(dimensionality, n);
+
+  std::string line;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!std::getline(input, line))
+    {
+      error = "expected more query points";
+      return;
+    }
+
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream values(line);
+    size_t d = 0;
+    double value;
+    while (d <= dimensionality && (values >> value))
+    {
+      if (d < dimensionality)
+        queries(d, i) = value;
+      ++d;
+    }
+
+    std::string rest;
+    if ((d != dimensionality || (values >> rest)) && error == "")
+    {
+      std::ostringstream message;
+      message << "query point " << i << " does not have " << dimensionality
+          << " values";
+      error = message.str();
+    }
+  }
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -75,5 +75,47 @@ void Unmap(const arma::Mat<size_t>& neighbors,
     neighborsOut[j] = referenceMap[neighbors[j]];
 }
 
+// Useful when the results should not be copied.
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const std::vector<size_t>& queryMap)
+{
+  // Map neighbors back to original locations.
+  if (!referenceMap.empty())
+    for (size_t j = 0; j < neighbors.n_elem; ++j)
+      neighbors[j] = referenceMap[neighbors[j]];
+
+  if (queryMap.empty())
+    return;
+
+  // Carry the columns around each cycle of the permutation: the column in
+  // hand is swapped with the one at its destination, which is carried next.
+  std::vector<bool> moved(queryMap.size(), false);
+  arma::Col<size_t> neighborColumn(neighbors.n_rows);
+  arma::vec distanceColumn(distances.n_rows);
+  for (size_t start = 0; start < queryMap.size(); ++start)
+  {
+    if (moved[start] || queryMap[start] == start)
+      continue;
+
+    neighborColumn = neighbors.col(start);
+    distanceColumn = distances.col(start);
+    size_t i = start;
+    do
+    {
+      const size_t destination = queryMap[i];
+      for (size_t j = 0; j < neighbors.n_rows; ++j)
+      {
+        std::swap(neighborColumn[j], neighbors(j, destination));
+        std::swap(distanceColumn[j], distances(j, destination));
+      }
+
+      moved[i] = true;
+      i = destination;
+    } while (i != start);
+  }
+}
+
 }; // namespace neighbor
 }; // namespace mlpack
@@ -70,6 +70,25 @@ void Unmap(const arma::Mat<size_t>& neighbors,
            arma::mat& distancesOut,
            const bool squareRoot = false);
 
+/**
+ * Unmap the results of a search in place: the entries of neighbors are mapped
+ * with referenceMap, and column i of neighbors and distances is moved to
+ * column queryMap[i], by following the cycles of the permutation.  Unlike
+ * Unmap(), this needs only one extra column (and one bit per column), instead
+ * of copies of both matrices.
+ *
+ * @param neighbors Matrix of neighbors resulting from neighbor search.
+ * @param distances Matrix of distances resulting from neighbor search.
+ * @param referenceMap Mapping of reference set to old points (if empty, the
+ *     neighbors are not mapped).
+ * @param queryMap Mapping of query set to old points (if empty, the columns
+ *     are not moved).
+ */
+void UnmapInPlace(arma::Mat<size_t>& neighbors,
+                  arma::mat& distances,
+                  const std::vector<size_t>& referenceMap,
+                  const std::vector<size_t>& queryMap);
+
 }; // namespace neighbor
 }; // namespace mlpack
 
@@ -28,6 +28,7 @@
 #define __MLPACK_METHODS_NMF_MULT_DIST_UPDATE_RULES_HPP
 
 #include <mlpack/core.hpp>
+#include "update_rule_products.hpp"
 
 namespace mlpack {
 namespace nmf {
@@ -41,8 +42,13 @@ namespace nmf {
 class WMultiplicativeDistanceRule
 {
  public:
-  // Empty constructor required for the WUpdateRule template.
-  WMultiplicativeDistanceRule() { }
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to use when V is sparse (0 uses all
+   *     cores).
+   */
+  WMultiplicativeDistanceRule(const size_t threads = 1) : threads(threads) { }
 
   /**
    * The update function that actually updates the W matrix. The function takes
@@ -53,12 +59,25 @@ class WMultiplicativeDistanceRule
    * @param H Encoding matrix.
    */
   template<typename MatType>
-  inline static void Update(const MatType& V,
-                            arma::mat& W,
-                            const arma::mat& H)
+  inline void Update(const MatType& V,
+                     arma::mat& W,
+                     const arma::mat& H) const
   {
-    W = (W % (V * H.t())) / (W * H * H.t());
+    // The denominator is computed as W * (H H^T), so that only n x r and r x r
+    // matrices are formed.
+    arma::mat numerator;
+    RightProduct(V, H, numerator, threads);
+    W = (W % numerator) / (W * (H * trans(H)));
   }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to use when V is sparse.
+  size_t threads;
 };
 
 /**
@@ -70,8 +89,13 @@ class WMultiplicativeDistanceRule
 class HMultiplicativeDistanceRule
 {
  public:
-  // Empty constructor required for the HUpdateRule template.
-  HMultiplicativeDistanceRule() { }
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to use when V is sparse (0 uses all
+   *     cores).
+   */
+  HMultiplicativeDistanceRule(const size_t threads = 1) : threads(threads) { }
 
   /**
    * The update function that actually updates the H matrix. The function takes
@@ -82,12 +106,25 @@ class HMultiplicativeDistanceRule
    * @param H Encoding matrix to be updated.
    */
   template<typename MatType>
-  inline static void Update(const MatType& V,
-                            const arma::mat& W,
-                            arma::mat& H)
+  inline void Update(const MatType& V,
+                     const arma::mat& W,
+                     arma::mat& H) const
   {
-    H = (H % (W.t() * V)) / (W.t() * W * H);
+    // The denominator is computed as (W^T W) * H, so that only r x m and r x r
+    // matrices are formed.
+    arma::mat numerator;
+    LeftProduct(V, W, numerator, threads);
+    H = (H % numerator) / ((trans(W) * W) * H);
   }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to use when V is sparse.
+  size_t threads;
 };
 
 }; // namespace nmf
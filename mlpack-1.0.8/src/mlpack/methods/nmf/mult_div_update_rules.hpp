@@ -29,6 +29,7 @@
 #define __MLPACK_METHODS_NMF_MULT_DIV_UPDATE_RULES_HPP
 
 #include <mlpack/core.hpp>
+#include "update_rule_products.hpp"
 
 namespace mlpack {
 namespace nmf {
@@ -43,8 +44,14 @@ namespace nmf {
 class WMultiplicativeDivergenceRule
 {
  public:
-  // Empty constructor required for the WUpdateRule template.
-  WMultiplicativeDivergenceRule() { }
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to use when V is sparse (0 uses all
+   *     cores).
+   */
+  WMultiplicativeDivergenceRule(const size_t threads = 1) :
+      threads(threads) { }
 
   /**
    * The update function that actually updates the W matrix. The function takes
@@ -55,33 +62,31 @@ class WMultiplicativeDivergenceRule
    * @param H Encoding matrix.
    */
   template<typename MatType>
-  inline static void Update(const MatType& V,
-                            arma::mat& W,
-                            const arma::mat& H)
+  inline void Update(const MatType& V,
+                     arma::mat& W,
+                     const arma::mat& H) const
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::rowvec t2;
+    // The numerator is (V / (WH)) H^T; for a sparse V, the ratio is only
+    // computed where V is nonzero, because it is zero everywhere else.
+    MatType ratio;
+    DivergenceRatio(V, W, H, ratio, threads);
+    arma::mat numerator;
+    RightProduct(ratio, H, numerator, threads);
 
-    t1 = W * H;
-    for (size_t i = 0; i < W.n_rows; ++i)
-    {
-      for (size_t j = 0; j < W.n_cols; ++j)
-      {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = H.row(j) % V.row(i) / t1.row(i);
-        t2.set_size(H.n_cols);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = H(j, k) * V(i, k) / t1(i, k);
-        }
-
-        W(i, j) = W(i, j) * sum(t2) / sum(H.row(j));
-      }
-    }
+    W %= numerator;
+    const arma::vec hSums = sum(H, 1);
+    for (size_t a = 0; a < W.n_cols; ++a)
+      W.col(a) /= hSums[a];
   }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to use when V is sparse.
+  size_t threads;
 };
 
 /**
@@ -94,8 +99,14 @@ class WMultiplicativeDivergenceRule
 class HMultiplicativeDivergenceRule
 {
  public:
-  // Empty constructor required for the HUpdateRule template.
-  HMultiplicativeDivergenceRule() { }
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to use when V is sparse (0 uses all
+   *     cores).
+   */
+  HMultiplicativeDivergenceRule(const size_t threads = 1) :
+      threads(threads) { }
 
   /**
    * The update function that actually updates the H matrix. The function takes
@@ -106,33 +117,31 @@ class HMultiplicativeDivergenceRule
    * @param H Encoding matrix to updated.
    */
   template<typename MatType>
-  inline static void Update(const MatType& V,
-                            const arma::mat& W,
-                            arma::mat& H)
+  inline void Update(const MatType& V,
+                     const arma::mat& W,
+                     arma::mat& H) const
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::colvec t2;
+    // The numerator is W^T (V / (WH)); for a sparse V, the ratio is only
+    // computed where V is nonzero, because it is zero everywhere else.
+    MatType ratio;
+    DivergenceRatio(V, W, H, ratio, threads);
+    arma::mat numerator;
+    LeftProduct(ratio, W, numerator, threads);
 
-    t1 = W * H;
-    for (size_t i = 0; i < H.n_rows; i++)
-    {
-      for (size_t j = 0; j < H.n_cols; j++)
-      {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = W.col(i) % V.col(j) / t1.col(j);
-        t2.set_size(W.n_rows);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = W(k, i) * V(k, j) / t1(k, j);
-        }
-
-        H(i,j) = H(i,j) * sum(t2) / sum(W.col(i));
-      }
-    }
+    H %= numerator;
+    const arma::rowvec wSums = sum(W, 0);
+    for (size_t a = 0; a < H.n_rows; ++a)
+      H.row(a) /= wSums[a];
   }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to use when V is sparse.
+  size_t threads;
 };
 
 }; // namespace nmf
@@ -136,6 +136,8 @@ class NMF
   WUpdateRule wUpdate;
   //! Instantiated H update rule.
   HUpdateRule hUpdate;
+  //! Monitor of the progress of the factorization (may be NULL).
+  ProgressMonitor* monitor;
 
  public:
   //! Access the maximum number of iterations.
@@ -158,6 +160,12 @@ class NMF
   const HUpdateRule& HUpdate() const { return hUpdate; }
   //! Modify the H update rule.
   HUpdateRule& HUpdate() { return hUpdate; }
+  //! Get the monitor which observes Apply() (NULL if there is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes Apply(); it is called after each
+  //! iteration with the residue, and can stop the factorization early, leaving
+  //! W and H of the last finished iteration (see ProgressMonitor).
+  ProgressMonitor*& Monitor() { return monitor; }
 
 }; // class NMF
 
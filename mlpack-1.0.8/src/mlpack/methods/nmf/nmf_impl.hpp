@@ -40,7 +40,8 @@ NMF<InitializationRule, WUpdateRule, HUpdateRule>::NMF(
     minResidue(minResidue),
     initializeRule(initializeRule),
     wUpdate(wUpdate),
-    hUpdate(hUpdate)
+    hUpdate(hUpdate),
+    monitor(NULL)
 {
   if (minResidue < 0.0)
   {
@@ -81,7 +82,6 @@ void NMF<InitializationRule, WUpdateRule, HUpdateRule>::Apply(
   double residue = minResidue;
   double normOld = 0;
   double norm = 0;
-  arma::mat WH;
 
   while (residue >= minResidue && iteration != maxIterations)
   {
@@ -90,9 +90,12 @@ void NMF<InitializationRule, WUpdateRule, HUpdateRule>::Apply(
     wUpdate.Update(V, W, H);
     hUpdate.Update(V, W, H);
 
-    // Calculate norm of WH after each iteration.
-    WH = W * H;
-    norm = sqrt(accu(WH % WH) / nm);
+    // Calculate norm of WH after each iteration.  WH itself is never formed:
+    // ||WH||_F^2 = trace((W^T W)(H H^T)), and since both factors are
+    // symmetric r x r matrices, the trace is the sum of their elementwise
+    // product.  This does not depend on V at all, so it costs the same whether
+    // V is dense or sparse.
+    norm = sqrt(accu((trans(W) * W) % (H * trans(H))) / nm);
 
     if (iteration != 0)
     {
@@ -103,6 +106,10 @@ void NMF<InitializationRule, WUpdateRule, HUpdateRule>::Apply(
     normOld = norm;
 
     iteration++;
+
+    // The monitor may stop the factorization after any iteration.
+    if (monitor && !monitor->Continue("NMF::Apply()", iteration - 1, residue))
+      break;
   }
 
   Log::Info << "NMF converged to residue of " << sqrt(residue) << " in "
@@ -26,7 +26,9 @@
 #include "random_init.hpp"
 #include "mult_dist_update_rules.hpp"
 #include "mult_div_update_rules.hpp"
+#include "online_nmf.hpp"
 #include "als_update_rules.hpp"
+#include "nnls_update_rules.hpp"
 
 using namespace mlpack;
 using namespace mlpack::nmf;
@@ -52,10 +54,21 @@ PROGRAM_INFO("Non-negative Matrix Factorization", "This program performs "
     " - multdiv: multiplicative divergence-based update rules (Lee and Seung "
     "1999)\n"
     " - als: alternating least squares update rules (Paatero and Tapper 1994)"
+    "\n"
+    " - nnls: alternating non-negative least squares update rules (Kim and "
+    "Park 2008), which solve for each row of W and each column of H exactly "
+    "and usually need far fewer iterations than 'als'"
     "\n\n"
     "The maximum number of iterations is specified with --max_iterations, and "
     "the minimum residue required for algorithm termination is specified with "
-    "--min_residue.");
+    "--min_residue."
+    "\n\n"
+    "If --batch_size (-b) is given, online NMF is used instead: one pass is "
+    "made over the columns of the input in batches of that size, W is updated "
+    "after each batch, and H holds the encoding of each column computed for "
+    "its batch.  The update rules, the maximum number of iterations and the "
+    "minimum residue are not used in this case.  Online NMF can be "
+    "warm-started from a previously computed W with --initial_w_file (-w).");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform NMF on.", "i");
@@ -70,7 +83,12 @@ PARAM_DOUBLE("min_residue", "The minimum root mean square residue allowed for "
     "each iteration, below which the program terminates.", "e", 1e-5);
 
 PARAM_STRING("update_rules", "Update rules for each iteration; ( multdist | "
-    "multdiv | als ).", "u", "multdist");
+    "multdiv | als | nnls ).", "u", "multdist");
+
+PARAM_INT("batch_size", "If nonzero, use online NMF with batches of this many "
+    "columns.", "b", 0);
+PARAM_STRING("initial_w_file", "File containing a W matrix to warm-start "
+    "online NMF from.", "w", "");
 
 int main(int argc, char** argv)
 {
@@ -101,12 +119,24 @@ int main(int argc, char** argv)
 
   if ((updateRules != "multdist") &&
       (updateRules != "multdiv") &&
-      (updateRules != "als"))
+      (updateRules != "als") &&
+      (updateRules != "nnls"))
   {
     Log::Fatal << "Invalid update rules ('" << updateRules << "'); must be '"
-        << "multdist', 'multdiv', or 'als'." << std::endl;
+        << "multdist', 'multdiv', 'als', or 'nnls'." << std::endl;
+  }
+
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  const string initialWFile = CLI::GetParam<string>("initial_w_file");
+  if (batchSize < 0)
+  {
+    Log::Fatal << "Invalid batch size: " << batchSize << ".  Must be greater "
+        << "than or equal to 0." << std::endl;
   }
 
+  if (initialWFile != "" && batchSize == 0)
+    Log::Warn << "--initial_w_file is ignored without --batch_size." << endl;
+
   // Load input dataset.
   arma::mat V;
   data::Load(inputFile, V, true);
@@ -115,7 +145,33 @@ int main(int argc, char** argv)
   arma::mat H;
 
   // Perform NMF with the specified update rules.
-  if (updateRules == "multdist")
+  if (batchSize > 0)
+  {
+    Log::Info << "Performing online NMF with batches of " << batchSize
+        << " columns." << std::endl;
+    if (initialWFile != "")
+    {
+      arma::mat initialW;
+      data::Load(initialWFile, initialW, true, false);
+      if (initialW.n_cols != r || initialW.n_rows != V.n_rows)
+      {
+        Log::Fatal << "The initial W must be " << V.n_rows << " x " << r
+            << " (" << initialW.n_rows << " x " << initialW.n_cols
+            << " given)." << std::endl;
+      }
+
+      OnlineNMF nmf(initialW);
+      nmf.Apply(V, (size_t) batchSize, H);
+      W = nmf.W();
+    }
+    else
+    {
+      OnlineNMF nmf(r);
+      nmf.Apply(V, (size_t) batchSize, H);
+      W = nmf.W();
+    }
+  }
+  else if (updateRules == "multdist")
   {
     Log::Info << "Performing NMF with multiplicative distance-based update "
         << "rules." << std::endl;
@@ -140,6 +196,15 @@ int main(int argc, char** argv)
         HAlternatingLeastSquaresRule> nmf(maxIterations, minResidue);
     nmf.Apply(V, r, W, H);
   }
+  else if (updateRules == "nnls")
+  {
+    Log::Info << "Performing NMF with alternating non-negative least squares "
+        << "update rules." << std::endl;
+    NMF<RandomInitialization,
+        WNonNegativeLeastSquaresRule,
+        HNonNegativeLeastSquaresRule> nmf(maxIterations, minResidue);
+    nmf.Apply(V, r, W, H);
+  }
 
   // Save results.
   data::Save(wOutputFile, W, false);
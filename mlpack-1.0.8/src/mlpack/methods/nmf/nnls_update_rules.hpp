@@ -0,0 +1,286 @@
+/**
+ * @file nnls_update_rules.hpp
+ *
+ * Update rules for alternating non-negative least squares (ANLS): each column
+ * of H (and each row of W) is the exact solution of a non-negative least
+ * squares problem.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NMF_NNLS_UPDATE_RULES_HPP
+#define __MLPACK_METHODS_NMF_NNLS_UPDATE_RULES_HPP
+
+#include <mlpack/core.hpp>
+#include "update_rule_products.hpp"
+
+namespace mlpack {
+namespace nmf {
+
+/**
+ * Solve the non-negative least squares problem given by its normal equations,
+ *
+ *   min_x 0.5 x^T G x - b^T x  subject to  x >= 0,
+ *
+ * with the active-set method of Lawson and Hanson.  The passive set (the
+ * variables allowed to be positive) starts as the positive elements of the
+ * given x, so when x is the solution of a similar problem, as in alternating
+ * least squares, only a few changes to the passive set are needed.  Each
+ * change solves the normal equations restricted to the passive set with a
+ * Cholesky decomposition, which is at most r x r.
+ *
+ * @param gram The matrix G (r x r, symmetric positive semi-definite).
+ * @param rhs The vector b (length r).
+ * @param x The starting point, which will be set to the solution (length r).
+ */
+inline void NonNegativeLeastSquares(const arma::mat& gram,
+                                    const double* rhs,
+                                    double* x)
+{
+  const size_t r = gram.n_rows;
+
+  double scale = 0.0;
+  for (size_t i = 0; i < r; ++i)
+    scale = std::max(scale, std::abs(rhs[i]));
+  const double tolerance = 1e-12 * std::max(scale, 1.0);
+
+  std::vector<char> passive(r, 0);
+  for (size_t i = 0; i < r; ++i)
+  {
+    if (x[i] > 0.0)
+      passive[i] = 1;
+    else
+      x[i] = 0.0;
+  }
+
+  std::vector<size_t> indices;
+  arma::mat subGram;
+  arma::vec subRhs;
+  arma::vec z;
+  for (size_t iteration = 0; iteration < 3 * r + 10; ++iteration)
+  {
+    // Solve on the passive set; while the solution has non-positive elements,
+    // step towards it as far as possible and drop the variables that reach
+    // zero.
+    while (true)
+    {
+      indices.clear();
+      for (size_t i = 0; i < r; ++i)
+        if (passive[i])
+          indices.push_back(i);
+
+      if (indices.empty())
+        break;
+
+      const size_t p = indices.size();
+      subGram.set_size(p, p);
+      subRhs.set_size(p);
+      for (size_t i = 0; i < p; ++i)
+      {
+        subRhs[i] = rhs[indices[i]];
+        for (size_t j = 0; j < p; ++j)
+          subGram(i, j) = gram(indices[i], indices[j]);
+      }
+
+      // The Cholesky decomposition fails if the restricted problem is
+      // singular; then the least-squares solution is used.
+      arma::mat R;
+      if (arma::chol(R, subGram))
+        z = arma::solve(arma::trimatu(R),
+            arma::solve(arma::trimatl(trans(R)), subRhs));
+      else
+        z = arma::solve(subGram, subRhs);
+
+      if (z.min() > 0.0)
+      {
+        for (size_t i = 0; i < p; ++i)
+          x[indices[i]] = z[i];
+        break;
+      }
+
+      // The step stops where the first variable reaches zero.
+      double alpha = DBL_MAX;
+      size_t blocking = 0;
+      for (size_t i = 0; i < p; ++i)
+      {
+        if (z[i] <= 0.0)
+        {
+          const double step = (x[indices[i]] > 0.0) ?
+              x[indices[i]] / (x[indices[i]] - z[i]) : 0.0;
+          if (step < alpha)
+          {
+            alpha = step;
+            blocking = i;
+          }
+        }
+      }
+
+      for (size_t i = 0; i < p; ++i)
+      {
+        x[indices[i]] += alpha * (z[i] - x[indices[i]]);
+        if (i == blocking || x[indices[i]] <= 0.0)
+        {
+          x[indices[i]] = 0.0;
+          passive[indices[i]] = 0;
+        }
+      }
+    }
+
+    // The solution is optimal when the gradient b - G x has no positive
+    // element outside the passive set; otherwise the largest one joins it.
+    size_t best = r;
+    double bestGradient = tolerance;
+    for (size_t i = 0; i < r; ++i)
+    {
+      if (passive[i])
+        continue;
+
+      double gradient = rhs[i];
+      for (size_t j = 0; j < r; ++j)
+        gradient -= gram(i, j) * x[j];
+
+      if (gradient > bestGradient)
+      {
+        best = i;
+        bestGradient = gradient;
+      }
+    }
+
+    if (best == r)
+      break;
+
+    passive[best] = 1;
+  }
+}
+
+/**
+ * The update rule for the basis matrix W: each row of W is set to the
+ * non-negative least squares solution of
+ * \f[
+ * \min_{w \ge 0} \| V_{i \cdot} - w H \|^2,
+ * \f]
+ * which is an r x r problem with the normal equations (HH^T) w^T = H V^T_{i
+ * \cdot}.  Unlike WAlternatingLeastSquaresRule, which clamps the unconstrained
+ * solution, this is the exact minimizer, so alternating between the two rules
+ * decreases the residue at every iteration (Kim and Park, 2008).  The rows are
+ * solved in parallel, each starting from its current value.
+ */
+class WNonNegativeLeastSquaresRule
+{
+ public:
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to solve the rows with (0 uses all
+   *     cores).
+   */
+  WNonNegativeLeastSquaresRule(const size_t threads = 1) : threads(threads) { }
+
+  /**
+   * The update function that actually updates the W matrix. The function takes
+   * in all the matrices and only changes the value of the W matrix.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void Update(const MatType& V,
+                     arma::mat& W,
+                     const arma::mat& H) const
+  {
+    const arma::mat gram = H * trans(H);
+    arma::mat rhs;
+    RightProduct(V, H, rhs, threads);
+
+    // Solve for the rows of W as the columns of its transpose.
+    arma::mat Wt = trans(W);
+    const arma::mat rhsT = trans(rhs);
+
+    #pragma omp parallel for num_threads(UpdateRuleThreads(threads)) \
+        schedule(dynamic, 16)
+    for (int i = 0; i < (int) Wt.n_cols; ++i)
+      NonNegativeLeastSquares(gram, rhsT.colptr(i), Wt.colptr(i));
+
+    W = trans(Wt);
+  }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to solve the rows with.
+  size_t threads;
+};
+
+/**
+ * The update rule for the encoding matrix H: each column of H is set to the
+ * non-negative least squares solution of
+ * \f[
+ * \min_{h \ge 0} \| V_{\cdot j} - W h \|^2,
+ * \f]
+ * with the normal equations (W^T W) h = W^T V_{\cdot j}.  The columns are
+ * solved in parallel, each starting from its current value.
+ */
+class HNonNegativeLeastSquaresRule
+{
+ public:
+  /**
+   * Create the update rule.
+   *
+   * @param threads Number of threads to solve the columns with (0 uses all
+   *     cores).
+   */
+  HNonNegativeLeastSquaresRule(const size_t threads = 1) : threads(threads) { }
+
+  /**
+   * The update function that actually updates the H matrix. The function takes
+   * in all the matrices and only changes the value of the H matrix.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void Update(const MatType& V,
+                     const arma::mat& W,
+                     arma::mat& H) const
+  {
+    const arma::mat gram = trans(W) * W;
+    arma::mat rhs;
+    LeftProduct(V, W, rhs, threads);
+
+    #pragma omp parallel for num_threads(UpdateRuleThreads(threads)) \
+        schedule(dynamic, 16)
+    for (int j = 0; j < (int) H.n_cols; ++j)
+      NonNegativeLeastSquares(gram, rhs.colptr(j), H.colptr(j));
+  }
+
+  //! Get the number of threads.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! The number of threads to solve the columns with.
+  size_t threads;
+};
+
+}; // namespace nmf
+}; // namespace mlpack
+
+#endif
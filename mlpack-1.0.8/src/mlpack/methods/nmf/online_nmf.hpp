@@ -0,0 +1,212 @@
+/**
+ * @file online_nmf.hpp
+ *
+ * Definition of the OnlineNMF class, which learns the basis matrix of a
+ * non-negative matrix factorization from mini-batches of columns.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NMF_ONLINE_NMF_HPP
+#define __MLPACK_METHODS_NMF_ONLINE_NMF_HPP
+
+#include <mlpack/core.hpp>
+#include "update_rule_products.hpp"
+
+namespace mlpack {
+namespace nmf {
+
+/**
+ * This class learns the basis matrix W of a non-negative matrix factorization
+ * V ~= WH from mini-batches of columns of V, so V never has to be in memory at
+ * once, and new columns can be added to an existing factorization without
+ * factorizing V from scratch.
+ *
+ * For each mini-batch, the encoding H of the new columns is computed with W
+ * fixed (projected least squares, refined with multiplicative distance
+ * updates).  The batch is then added to two sufficient statistics,
+ *
+ * \f[
+ * A \leftarrow \rho A + H H^T, \qquad B \leftarrow \rho B + V H^T,
+ * \f]
+ *
+ * where \f$ \rho \f$ is the forgetting factor, and every column of W is updated
+ * by block coordinate descent on
+ * \f$ \frac{1}{2} tr(W^T W A) - tr(W^T B) \f$ subject to W >= 0.  Only the
+ * n x r and r x r matrices W, A and B are kept between batches.  For more
+ * information, see the following paper:
+ *
+ * @code
+ * @article{mairal2010online,
+ *   title = {Online Learning for Matrix Factorization and Sparse Coding},
+ *   author = {Mairal, Julien and Bach, Francis and Ponce, Jean and Sapiro,
+ *       Guillermo},
+ *   journal = {Journal of Machine Learning Research},
+ *   volume = {11},
+ *   pages = {19--60},
+ *   year = {2010}
+ * }
+ * @endcode
+ *
+ * To continue a previous factorization exactly, save W(), A() and B() (for
+ * instance with data::Save()) and pass them to the constructor again later.
+ * A factorization can also be warm-started from W alone; the statistics then
+ * start at zero, so W is only the starting point.
+ *
+ * @code
+ * extern arma::sp_mat batch; // New columns of V.
+ * OnlineNMF nmf(10); // Rank 10.
+ * arma::mat H;
+ * nmf.Update(batch, H); // Learn from the batch and encode it.
+ *
+ * // Later, warm-start from the learned W and statistics.
+ * OnlineNMF resumed(nmf.W(), nmf.A(), nmf.B());
+ * @endcode
+ */
+class OnlineNMF
+{
+ public:
+  /**
+   * Create an online NMF object of the given rank.  W is initialized randomly
+   * when the first batch is given.
+   *
+   * @param rank Rank r of the factorization.
+   * @param forgetting Forgetting factor of the old batches (1 weighs all
+   *     batches equally).
+   * @param encodeIterations Number of multiplicative updates used to compute
+   *     the encoding of each batch.
+   */
+  OnlineNMF(const size_t rank,
+            const double forgetting = 1.0,
+            const size_t encodeIterations = 50);
+
+  /**
+   * Warm-start online NMF from the given basis matrix.  The sufficient
+   * statistics start at zero.
+   *
+   * @param W Initial basis matrix (n x r).
+   * @param forgetting Forgetting factor of the old batches.
+   * @param encodeIterations Number of multiplicative updates used to compute
+   *     the encoding of each batch.
+   */
+  OnlineNMF(const arma::mat& W,
+            const double forgetting = 1.0,
+            const size_t encodeIterations = 50);
+
+  /**
+   * Continue online NMF from the given basis matrix and sufficient statistics,
+   * as returned by W(), A() and B().
+   *
+   * @param W Basis matrix (n x r).
+   * @param A Sufficient statistic H H^T (r x r).
+   * @param B Sufficient statistic V H^T (n x r).
+   * @param forgetting Forgetting factor of the old batches.
+   * @param encodeIterations Number of multiplicative updates used to compute
+   *     the encoding of each batch.
+   */
+  OnlineNMF(const arma::mat& W,
+            const arma::mat& A,
+            const arma::mat& B,
+            const double forgetting = 1.0,
+            const size_t encodeIterations = 50);
+
+  /**
+   * Learn from the given batch of columns: compute their encoding, and then
+   * update W.
+   *
+   * @param batch Batch of columns of V (n x b).
+   * @param H Matrix to store the encoding of the batch in (r x b).
+   */
+  template<typename MatType>
+  void Update(const MatType& batch, arma::mat& H);
+
+  /**
+   * Compute the encoding of the given columns with the current W, without
+   * updating W.
+   *
+   * @param V Columns to encode (n x m).
+   * @param H Matrix to store the encoding in (r x m).
+   */
+  template<typename MatType>
+  void Encode(const MatType& V, arma::mat& H) const;
+
+  /**
+   * Make one pass over the columns of V in batches of the given size,
+   * updating W after each batch.  The encoding of each column is the one
+   * computed for its batch.
+   *
+   * @param V Input matrix (n x m).
+   * @param batchSize Number of columns in each batch.
+   * @param H Matrix to store the encoding of V in (r x m).
+   */
+  template<typename MatType>
+  void Apply(const MatType& V, const size_t batchSize, arma::mat& H);
+
+  //! Get the rank of the factorization.
+  size_t Rank() const { return rank; }
+
+  //! Get the basis matrix.
+  const arma::mat& W() const { return w; }
+  //! Modify the basis matrix.
+  arma::mat& W() { return w; }
+  //! Get the sufficient statistic H H^T.
+  const arma::mat& A() const { return a; }
+  //! Modify the sufficient statistic H H^T.
+  arma::mat& A() { return a; }
+  //! Get the sufficient statistic V H^T.
+  const arma::mat& B() const { return b; }
+  //! Modify the sufficient statistic V H^T.
+  arma::mat& B() { return b; }
+
+  //! Get the forgetting factor.
+  double Forgetting() const { return forgetting; }
+  //! Modify the forgetting factor.
+  double& Forgetting() { return forgetting; }
+  //! Get the number of multiplicative updates used for each encoding.
+  size_t EncodeIterations() const { return encodeIterations; }
+  //! Modify the number of multiplicative updates used for each encoding.
+  size_t& EncodeIterations() { return encodeIterations; }
+  //! Get the number of threads used for sparse batches.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for sparse batches (0 uses all cores).
+  size_t& Threads() { return threads; }
+
+ private:
+  //! Rank of the factorization.
+  size_t rank;
+  //! Forgetting factor.
+  double forgetting;
+  //! Number of multiplicative updates used for each encoding.
+  size_t encodeIterations;
+  //! Number of threads used for sparse batches.
+  size_t threads;
+  //! The basis matrix.
+  arma::mat w;
+  //! The sufficient statistic H H^T.
+  arma::mat a;
+  //! The sufficient statistic V H^T.
+  arma::mat b;
+
+  //! Update W by block coordinate descent on the sufficient statistics.
+  void UpdateW();
+};
+
+}; // namespace nmf
+}; // namespace mlpack
+
+// Include implementation.
+#include "online_nmf_impl.hpp"
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * @file online_nmf_impl.hpp
+ *
+ * Implementation of the OnlineNMF class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NMF_ONLINE_NMF_IMPL_HPP
+#define __MLPACK_METHODS_NMF_ONLINE_NMF_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_nmf.hpp"
+
+namespace mlpack {
+namespace nmf {
+
+inline OnlineNMF::OnlineNMF(const size_t rank,
+                            const double forgetting,
+                            const size_t encodeIterations) :
+    rank(rank),
+    forgetting(forgetting),
+    encodeIterations(encodeIterations),
+    threads(1)
+{
+  if (rank == 0)
+    Log::Fatal << "OnlineNMF::OnlineNMF(): the rank must be greater than 0."
+        << std::endl;
+
+  a.zeros(rank, rank);
+}
+
+inline OnlineNMF::OnlineNMF(const arma::mat& W,
+                            const double forgetting,
+                            const size_t encodeIterations) :
+    rank(W.n_cols),
+    forgetting(forgetting),
+    encodeIterations(encodeIterations),
+    threads(1),
+    w(W)
+{
+  if (rank == 0)
+    Log::Fatal << "OnlineNMF::OnlineNMF(): the rank must be greater than 0."
+        << std::endl;
+
+  a.zeros(rank, rank);
+  b.zeros(w.n_rows, rank);
+}
+
+inline OnlineNMF::OnlineNMF(const arma::mat& W,
+                            const arma::mat& A,
+                            const arma::mat& B,
+                            const double forgetting,
+                            const size_t encodeIterations) :
+    rank(W.n_cols),
+    forgetting(forgetting),
+    encodeIterations(encodeIterations),
+    threads(1),
+    w(W),
+    a(A),
+    b(B)
+{
+  if (rank == 0)
+    Log::Fatal << "OnlineNMF::OnlineNMF(): the rank must be greater than 0."
+        << std::endl;
+
+  if (a.n_rows != rank || a.n_cols != rank || b.n_rows != w.n_rows ||
+      b.n_cols != rank)
+    Log::Fatal << "OnlineNMF::OnlineNMF(): A must be " << rank << " x " << rank
+        << " and B must be " << w.n_rows << " x " << rank << "." << std::endl;
+}
+
+template<typename MatType>
+void OnlineNMF::Update(const MatType& batch, arma::mat& H)
+{
+  // The first batch determines the number of rows of W.
+  if (w.n_elem == 0)
+  {
+    w.randu(batch.n_rows, rank);
+    b.zeros(batch.n_rows, rank);
+  }
+
+  Encode(batch, H);
+
+  // Add the batch to the sufficient statistics.
+  arma::mat batchB;
+  RightProduct(batch, H, batchB, threads);
+  a = forgetting * a + H * trans(H);
+  b = forgetting * b + batchB;
+
+  UpdateW();
+}
+
+template<typename MatType>
+void OnlineNMF::Encode(const MatType& V, arma::mat& H) const
+{
+  if (V.n_rows != w.n_rows)
+    Log::Fatal << "OnlineNMF: columns have " << V.n_rows << " rows, but W has "
+        << w.n_rows << " rows." << std::endl;
+
+  arma::mat wtv;
+  LeftProduct(V, w, wtv, threads);
+  const arma::mat wtw = trans(w) * w;
+
+  // Start from the projected least squares solution.  Multiplicative updates
+  // cannot move away from zero, so it is kept slightly positive.
+  H = pinv(wtw) * wtv;
+  for (size_t i = 0; i < H.n_elem; ++i)
+    if (H[i] < 1e-10)
+      H[i] = 1e-10;
+
+  // Refine with multiplicative distance updates; W^T V is the same for every
+  // iteration, so only r x r and r x m products are formed.
+  for (size_t i = 0; i < encodeIterations; ++i)
+    H = (H % wtv) / (wtw * H + 1e-16);
+}
+
+template<typename MatType>
+void OnlineNMF::Apply(const MatType& V, const size_t batchSize, arma::mat& H)
+{
+  if (batchSize == 0)
+    Log::Fatal << "OnlineNMF::Apply(): the batch size must be greater than 0."
+        << std::endl;
+
+  H.set_size(rank, V.n_cols);
+  arma::mat batchH;
+  for (size_t begin = 0; begin < V.n_cols; begin += batchSize)
+  {
+    const size_t end = std::min(begin + batchSize, (size_t) V.n_cols) - 1;
+    const MatType batch = V.cols(begin, end);
+    Update(batch, batchH);
+    H.cols(begin, end) = batchH;
+  }
+
+  Log::Info << "Online NMF made a pass over " << V.n_cols << " columns in "
+      << (V.n_cols + batchSize - 1) / batchSize << " batches." << std::endl;
+}
+
+inline void OnlineNMF::UpdateW()
+{
+  // A few passes of block coordinate descent; each column of W is the exact
+  // minimizer given the others.
+  for (size_t pass = 0; pass < 10; ++pass)
+  {
+    double change = 0.0;
+    double norm = 0.0;
+    for (size_t j = 0; j < rank; ++j)
+    {
+      // A column that was never used has no information in the statistics.
+      if (a(j, j) <= 0.0)
+        continue;
+
+      arma::vec column = w.unsafe_col(j) + (b.unsafe_col(j) - w *
+          a.unsafe_col(j)) / a(j, j);
+      for (size_t i = 0; i < column.n_elem; ++i)
+        if (column[i] < 0.0)
+          column[i] = 0.0;
+
+      change += accu(square(column - w.unsafe_col(j)));
+      norm += accu(square(column));
+      w.col(j) = column;
+    }
+
+    if (change <= 1e-8 * norm)
+      break;
+  }
+}
+
+}; // namespace nmf
+}; // namespace mlpack
+
+#endif
@@ -44,9 +44,12 @@ class RandomInitialization
     size_t n = V.n_rows;
     size_t m = V.n_cols;
 
-    // Intialize to random values.
-    W.randu(n, r);
-    H.randu(r, m);
+    // Intialize to random values, with the generators of math::Random(), so
+    // the initialization can be reproduced with math::RandomSeed().
+    W.set_size(n, r);
+    math::Random(W);
+    H.set_size(r, m);
+    math::Random(H);
   }
 };
 
@@ -0,0 +1,198 @@
+/**
+ * @file update_rule_products.hpp
+ *
+ * Matrix products used by the multiplicative update rules.  The overloads for a
+ * sparse V only visit its nonzero elements and run in parallel.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_NMF_UPDATE_RULE_PRODUCTS_HPP
+#define __MLPACK_METHODS_NMF_UPDATE_RULE_PRODUCTS_HPP
+
+#include <mlpack/core.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace nmf {
+
+/**
+ * Return the number of threads to use for the given setting, where 0 means all
+ * available cores.
+ */
+inline size_t UpdateRuleThreads(const size_t threads)
+{
+  return Threads::Count(threads);
+}
+
+/**
+ * Compute V * H^T.  For a dense V this is a single matrix product.
+ *
+ * @param V Input matrix (n x m).
+ * @param H Encoding matrix (r x m).
+ * @param product Matrix to store V * H^T in (n x r).
+ * @param threads Number of threads to use (sparse V only).
+ */
+inline void RightProduct(const arma::mat& V,
+                         const arma::mat& H,
+                         arma::mat& product,
+                         const size_t /* threads */)
+{
+  product = V * trans(H);
+}
+
+/**
+ * Compute V * H^T, visiting only the nonzero elements of V.  The columns of V
+ * are split into one block for each thread, and each block is accumulated into
+ * its own product, because the columns of V contribute to every row of the
+ * result.
+ */
+inline void RightProduct(const arma::sp_mat& V,
+                         const arma::mat& H,
+                         arma::mat& product,
+                         const size_t threads)
+{
+  const size_t blocks = std::max(std::min(UpdateRuleThreads(threads),
+      (size_t) V.n_cols), (size_t) 1);
+
+  // The products are accumulated transposed, so each nonzero element updates
+  // a contiguous column.
+  std::vector<arma::mat> partial(blocks);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static)
+  for (int b = 0; b < (int) blocks; ++b)
+  {
+    partial[b].zeros(H.n_rows, V.n_rows);
+    const size_t begin = (b * V.n_cols) / blocks;
+    const size_t end = ((b + 1) * V.n_cols) / blocks;
+    for (size_t j = begin; j < end; ++j)
+    {
+      const double* h = H.colptr(j);
+      for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+      {
+        double* p = partial[b].colptr(V.row_indices[k]);
+        const double value = V.values[k];
+        for (size_t c = 0; c < H.n_rows; ++c)
+          p[c] += value * h[c];
+      }
+    }
+  }
+
+  for (size_t b = 1; b < blocks; ++b)
+    partial[0] += partial[b];
+
+  product = trans(partial[0]);
+}
+
+/**
+ * Compute W^T * V.  For a dense V this is a single matrix product.
+ *
+ * @param V Input matrix (n x m).
+ * @param W Basis matrix (n x r).
+ * @param product Matrix to store W^T * V in (r x m).
+ * @param threads Number of threads to use (sparse V only).
+ */
+inline void LeftProduct(const arma::mat& V,
+                        const arma::mat& W,
+                        arma::mat& product,
+                        const size_t /* threads */)
+{
+  product = trans(W) * V;
+}
+
+/**
+ * Compute W^T * V, visiting only the nonzero elements of V.  Each column of the
+ * result only depends on the same column of V, so the columns are computed in
+ * parallel.
+ */
+inline void LeftProduct(const arma::sp_mat& V,
+                        const arma::mat& W,
+                        arma::mat& product,
+                        const size_t threads)
+{
+  const arma::mat Wt = trans(W);
+  product.zeros(W.n_cols, V.n_cols);
+
+  #pragma omp parallel for num_threads(UpdateRuleThreads(threads)) \
+      schedule(dynamic, 64)
+  for (int j = 0; j < (int) V.n_cols; ++j)
+  {
+    double* p = product.colptr(j);
+    for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+    {
+      const double* w = Wt.colptr(V.row_indices[k]);
+      const double value = V.values[k];
+      for (size_t c = 0; c < Wt.n_rows; ++c)
+        p[c] += value * w[c];
+    }
+  }
+}
+
+/**
+ * Compute the elementwise ratio V / (WH).  For a dense V, WH is formed.
+ *
+ * @param V Input matrix (n x m).
+ * @param W Basis matrix (n x r).
+ * @param H Encoding matrix (r x m).
+ * @param ratio Matrix to store the ratio in.
+ * @param threads Number of threads to use (sparse V only).
+ */
+inline void DivergenceRatio(const arma::mat& V,
+                            const arma::mat& W,
+                            const arma::mat& H,
+                            arma::mat& ratio,
+                            const size_t /* threads */)
+{
+  ratio = V / (W * H);
+}
+
+/**
+ * Compute the elementwise ratio V / (WH) at the nonzero elements of V only;
+ * the ratio is zero wherever V is, so it has the same sparsity pattern as V.
+ * WH is not formed; each element needed is a dot product of length r.
+ */
+inline void DivergenceRatio(const arma::sp_mat& V,
+                            const arma::mat& W,
+                            const arma::mat& H,
+                            arma::sp_mat& ratio,
+                            const size_t threads)
+{
+  const arma::mat Wt = trans(W);
+  ratio = V;
+
+  #pragma omp parallel for num_threads(UpdateRuleThreads(threads)) \
+      schedule(dynamic, 64)
+  for (int j = 0; j < (int) V.n_cols; ++j)
+  {
+    const double* h = H.colptr(j);
+    for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+    {
+      const double* w = Wt.colptr(V.row_indices[k]);
+      double wh = 0.0;
+      for (size_t c = 0; c < Wt.n_rows; ++c)
+        wh += w[c] * h[c];
+
+      arma::access::rw(ratio.values[k]) = V.values[k] / wh;
+    }
+  }
+}
+
+}; // namespace nmf
+}; // namespace mlpack
+
+#endif
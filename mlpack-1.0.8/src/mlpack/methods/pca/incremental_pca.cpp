@@ -0,0 +1,143 @@
+/**
+ * @file incremental_pca.cpp
+ *
+ * Implementation of the IncrementalPCA class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "incremental_pca.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::pca;
+
+IncrementalPCA::IncrementalPCA(const bool scaleData) :
+    scaleData(scaleData),
+    numPoints(0)
+{ }
+
+void IncrementalPCA::Update(const arma::mat& chunk)
+{
+  if (chunk.n_cols == 0)
+    return;
+
+  if (numPoints == 0)
+  {
+    mean.zeros(chunk.n_rows);
+    scatter.zeros(chunk.n_rows, chunk.n_rows);
+  }
+  else if (chunk.n_rows != mean.n_elem)
+  {
+    Log::Fatal << "IncrementalPCA::Update(): chunk has " << chunk.n_rows
+        << " dimensions, but the previous chunks have " << mean.n_elem << "!"
+        << endl;
+  }
+
+  Timer::Start("incremental_pca");
+
+  // Statistics of the chunk by itself.
+  const arma::vec chunkMean = arma::mean(chunk, 1);
+  const arma::mat centeredChunk = chunk - arma::repmat(chunkMean, 1,
+      chunk.n_cols);
+
+  // Combine them with the statistics of the previous chunks; the scatter of
+  // the union is the sum of the two scatters plus a correction for the
+  // distance between the two means.
+  const double n = (double) numPoints;
+  const double m = (double) chunk.n_cols;
+  const arma::vec delta = chunkMean - mean;
+
+  scatter += centeredChunk * trans(centeredChunk);
+  scatter += (n * m / (n + m)) * (delta * trans(delta));
+  mean += (m / (n + m)) * delta;
+  numPoints += chunk.n_cols;
+
+  Timer::Stop("incremental_pca");
+}
+
+void IncrementalPCA::Update(const string& filename)
+{
+  arma::mat chunk;
+  data::Load(filename, chunk, true);
+  Update(chunk);
+}
+
+double IncrementalPCA::Fit(const size_t newDimension)
+{
+  if (numPoints < 2)
+    Log::Fatal << "IncrementalPCA::Fit(): at least two points are needed, but "
+        << numPoints << " were given!" << endl;
+  if (newDimension > mean.n_elem)
+    Log::Fatal << "IncrementalPCA::Fit(): newDimension (" << newDimension
+        << ") cannot be greater than the dimensionality of the data ("
+        << mean.n_elem << ")!" << endl;
+
+  Timer::Start("incremental_pca");
+
+  arma::mat covariance = scatter / (double) (numPoints - 1);
+
+  stdDev.reset();
+  if (scaleData)
+  {
+    // Scaling each dimension to unit variance turns the covariance into the
+    // correlation matrix.
+    stdDev = sqrt(covariance.diag());
+
+    // If there are any zeroes, make them very small.
+    for (size_t i = 0; i < stdDev.n_elem; ++i)
+      if (stdDev[i] == 0)
+        stdDev[i] = 1e-50;
+
+    covariance /= (stdDev * trans(stdDev));
+  }
+
+  // The eigenvalues are given in ascending order.
+  arma::vec allEigVal;
+  arma::mat allEigVec;
+  arma::eig_sym(allEigVal, allEigVec, covariance);
+
+  const size_t keep = (newDimension == 0) ? mean.n_elem : newDimension;
+  eigVal.set_size(keep);
+  eigVec.set_size(mean.n_elem, keep);
+  for (size_t i = 0; i < keep; ++i)
+  {
+    eigVal[i] = allEigVal[allEigVal.n_elem - 1 - i];
+    eigVec.col(i) = allEigVec.col(allEigVal.n_elem - 1 - i);
+  }
+
+  Timer::Stop("incremental_pca");
+
+  // The total variance is the trace of the covariance.
+  return sum(eigVal) / trace(covariance);
+}
+
+void IncrementalPCA::Transform(const arma::mat& data,
+                               arma::mat& transformedData) const
+{
+  if (eigVec.n_cols == 0)
+    Log::Fatal << "IncrementalPCA::Transform(): Fit() has not been called!"
+        << endl;
+  if (data.n_rows != mean.n_elem)
+    Log::Fatal << "IncrementalPCA::Transform(): data has " << data.n_rows
+        << " dimensions, but the fitted data has " << mean.n_elem << "!"
+        << endl;
+
+  arma::mat centeredData = data - arma::repmat(mean, 1, data.n_cols);
+  if (stdDev.n_elem > 0)
+    centeredData /= arma::repmat(stdDev, 1, data.n_cols);
+
+  transformedData = trans(eigVec) * centeredData;
+}
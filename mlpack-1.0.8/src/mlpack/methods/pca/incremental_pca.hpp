@@ -0,0 +1,146 @@
+/**
+ * @file incremental_pca.hpp
+ *
+ * Definition of the IncrementalPCA class, which performs principal components
+ * analysis on data that is given in chunks.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+#define __MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * Principal components analysis on data that is given one chunk of points at a
+ * time, so that the whole dataset never has to be in memory.  Each chunk is
+ * folded into the running mean and scatter matrix of the points seen so far,
+ * using the pairwise update of Chan, Golub and LeVeque; then only the d x d
+ * scatter matrix is kept, no matter how many points have been seen.  Once all
+ * the chunks are given, Fit() finds the principal components, and Transform()
+ * projects any data (the original chunks or new points) onto them.
+ *
+ * @code
+ * IncrementalPCA p;
+ * for (size_t i = 0; i < chunkFiles.size(); ++i)
+ *   p.Update(chunkFiles[i]); // Loads the chunk with data::Load().
+ * p.Fit(10);
+ *
+ * arma::mat transformed;
+ * p.Transform(newPoints, transformed);
+ * @endcode
+ *
+ * The results are the same (up to the sign of each component) as with the PCA
+ * class on the concatenation of the chunks.  More chunks can be given after
+ * Fit(); Fit() must be called again for them to be taken into account.
+ */
+class IncrementalPCA
+{
+ public:
+  /**
+   * Create the IncrementalPCA object, specifying if the data should be scaled
+   * in each dimension by standard deviation.
+   *
+   * @param scaleData Whether or not to scale the data.
+   */
+  IncrementalPCA(const bool scaleData = false);
+
+  /**
+   * Add a chunk of points (one per column) to the accumulated statistics.  All
+   * chunks must have the same dimensionality.
+   *
+   * @param chunk Points to add.
+   */
+  void Update(const arma::mat& chunk);
+
+  /**
+   * Load a chunk of points from the given file with data::Load(), and add it
+   * to the accumulated statistics.  If the file cannot be loaded, a fatal error
+   * is given.
+   *
+   * @param filename File holding the chunk.
+   */
+  void Update(const std::string& filename);
+
+  /**
+   * Find the principal components of all the points given so far, keeping the
+   * given number of them.  At least two points must have been given.
+   *
+   * @param newDimension Number of components to keep; 0 keeps all of them.
+   * @return Amount of the variance of the data retained (between 0 and 1).
+   */
+  double Fit(const size_t newDimension = 0);
+
+  /**
+   * Project the given points onto the principal components found by the last
+   * call to Fit().  It is safe to pass the same matrix reference for both data
+   * and transformedData.
+   *
+   * @param data Points to project (one per column).
+   * @param transformedData Matrix to store the projected points in.
+   */
+  void Transform(const arma::mat& data, arma::mat& transformedData) const;
+
+  //! Get the number of points given so far.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Get the mean of the points given so far.
+  const arma::vec& Mean() const { return mean; }
+
+  //! Get the eigenvalues of the covariance of the kept components (largest
+  //! first).
+  const arma::vec& EigenValues() const { return eigVal; }
+
+  //! Get the kept principal components (one per column).
+  const arma::mat& EigenVectors() const { return eigVec; }
+
+  //! Get whether or not the data is scaled by standard deviation.
+  bool ScaleData() const { return scaleData; }
+  //! Modify whether or not the data is scaled by standard deviation.  This is
+  //! taken into account by the next call to Fit().
+  bool& ScaleData() { return scaleData; }
+
+ private:
+  //! Whether or not the data will be scaled by standard deviation.
+  bool scaleData;
+
+  //! The number of points given so far.
+  size_t numPoints;
+
+  //! The mean of the points given so far.
+  arma::vec mean;
+
+  //! The sum of the outer products of the centered points given so far.
+  arma::mat scatter;
+
+  //! The standard deviation of each dimension, as of the last Fit() (empty if
+  //! the data was not scaled).
+  arma::vec stdDev;
+
+  //! The eigenvalues of the kept components.
+  arma::vec eigVal;
+
+  //! The kept principal components.
+  arma::mat eigVec;
+};
+
+}; // namespace pca
+}; // namespace mlpack
+
+#endif
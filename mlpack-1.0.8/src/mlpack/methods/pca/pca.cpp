@@ -22,6 +22,8 @@
  */
 #include "pca.hpp"
 #include <mlpack/core.hpp>
+#include <mlpack/core/math/lanczos_eigensolver.hpp>
+#include <mlpack/methods/quic_svd/quic_svd.hpp>
 #include <iostream>
 #include <complex>
 
@@ -29,8 +31,12 @@ using namespace std;
 using namespace mlpack;
 using namespace mlpack::pca;
 
-PCA::PCA(const bool scaleData) :
-    scaleData(scaleData)
+PCA::PCA(const bool scaleData, const DecompositionMethod method) :
+    scaleData(scaleData),
+    method(method),
+    powerIterations(2),
+    oversampling(10),
+    relativeError(0.01)
 { }
 
 /**
@@ -53,21 +59,7 @@ void PCA::Apply(const arma::mat& data,
 
   // Center the data into a temporary matrix.
   arma::mat centeredData;
-  math::Center(data, centeredData);
-
-  if (scaleData)
-  {
-    // Scaling the data is when we reduce the variance of each dimension to 1.
-    // We do this by dividing each dimension by its standard deviation.
-    arma::vec stdDev = arma::stddev(centeredData, 0, 1 /* for each dimension */);
-
-    // If there are any zeroes, make them very small.
-    for (size_t i = 0; i < stdDev.n_elem; ++i)
-      if (stdDev[i] == 0)
-        stdDev[i] = 1e-50;
-
-    centeredData /= arma::repmat(stdDev, 1, centeredData.n_cols);
-  }
+  Center(data, centeredData);
 
   // Do singular value decomposition.  Use the economical singular value
   // decomposition if the columns are much larger than the rows.
@@ -130,6 +122,37 @@ double PCA::Apply(arma::mat& data, const size_t newDimension) const
         << "be greater than the existing dimensionality of the data ("
         << data.n_rows << ")!" << endl;
 
+  const DecompositionMethod decomposition = ChooseMethod(data.n_rows,
+      data.n_cols, newDimension);
+  if (decomposition == QUIC_SVD)
+    return ApplyQUICSVD(data, newDimension, 0.0);
+  if (decomposition == COVARIANCE)
+    return ApplyCovariance(data, newDimension, 0.0);
+
+  if (decomposition == RANDOMIZED)
+  {
+    Timer::Start("pca");
+
+    // The data is overwritten anyway, so center it in place instead of keeping
+    // a centered copy.
+    Center(data, data);
+
+    arma::mat coeffs;
+    arma::vec eigVal;
+    RandomizedSVD(data, newDimension, coeffs, eigVal);
+    eigVal %= eigVal / (data.n_cols - 1);
+
+    // The total variance is the sum of all eigenvalues, which is the trace of
+    // the covariance matrix.
+    const double totalVariance = accu(square(data)) / (data.n_cols - 1);
+
+    data = trans(coeffs) * data;
+
+    Timer::Stop("pca");
+
+    return (sum(eigVal) / totalVariance);
+  }
+
   arma::mat coeffs;
   arma::vec eigVal;
 
@@ -163,6 +186,13 @@ double PCA::Apply(arma::mat& data, const double varRetained) const
     Log::Fatal << "PCA::Apply(): varRetained (" << varRetained << ") should be "
         << "less than or equal to 1." << endl;
 
+  const DecompositionMethod decomposition = ChooseMethod(data.n_rows,
+      data.n_cols, 0);
+  if (decomposition == QUIC_SVD)
+    return ApplyQUICSVD(data, 0, varRetained);
+  if (decomposition == COVARIANCE)
+    return ApplyCovariance(data, 0, varRetained);
+
   arma::mat coeffs;
   arma::vec eigVal;
 
@@ -184,3 +214,288 @@ double PCA::Apply(arma::mat& data, const double varRetained) const
 
   return varSum;
 }
+
+void PCA::Center(const arma::mat& data, arma::mat& centeredData) const
+{
+  math::Center(data, centeredData);
+
+  if (scaleData)
+  {
+    // Scaling the data is when we reduce the variance of each dimension to 1.
+    // We do this by dividing each dimension by its standard deviation.
+    arma::vec stdDev = arma::stddev(centeredData, 0, 1 /* for each dimension */);
+
+    // If there are any zeroes, make them very small.
+    for (size_t i = 0; i < stdDev.n_elem; ++i)
+      if (stdDev[i] == 0)
+        stdDev[i] = 1e-50;
+
+    centeredData /= arma::repmat(stdDev, 1, centeredData.n_cols);
+  }
+}
+
+size_t PCA::PeakMemory(const size_t dimensionality,
+                       const size_t points,
+                       const size_t newDimension) const
+{
+  return MethodMemory(ChooseMethod(dimensionality, points, newDimension),
+      dimensionality, points, newDimension);
+}
+
+bool PCA::UseRandomized(const size_t dimensionality,
+                        const size_t points,
+                        const size_t newDimension) const
+{
+  const size_t maxRank = std::min(dimensionality, points);
+
+  // Sampling the whole range would be no cheaper than the exact decomposition.
+  if (method == EXACT || newDimension + oversampling >= maxRank)
+    return false;
+
+  if (method == RANDOMIZED)
+    return true;
+
+  // The randomized decomposition costs O(d n l) for each pass over the data,
+  // with l = newDimension + oversampling; it pays off when l is a small
+  // fraction of the dimensionality.
+  return (4 * (newDimension + oversampling) <= maxRank);
+}
+
+PCA::DecompositionMethod PCA::ChooseMethod(const size_t dimensionality,
+                                           const size_t points,
+                                           const size_t newDimension) const
+{
+  if (method == QUIC_SVD || method == COVARIANCE)
+    return method;
+
+  // All components are needed to retain a fraction of the variance, so the
+  // randomized decomposition is of no use then.
+  const DecompositionMethod preferred = (newDimension != 0 &&
+      UseRandomized(dimensionality, points, newDimension)) ? RANDOMIZED : EXACT;
+  if (method != AUTOMATIC)
+    return preferred;
+
+  // Fall back to the covariance matrix when the preferred decomposition does
+  // not fit in the budget and the covariance matrix needs less memory.
+  const size_t preferredMemory = MethodMemory(preferred, dimensionality,
+      points, newDimension);
+  if (!MemoryBudget::Fits(preferredMemory) && MethodMemory(COVARIANCE,
+      dimensionality, points, newDimension) < preferredMemory)
+  {
+    Log::Info << "PCA: the " << ((preferred == RANDOMIZED) ? "randomized" :
+        "exact") << " decomposition needs about " <<
+        MemoryBudget::Format(preferredMemory) << ", more than the memory "
+        << "budget; using the covariance matrix instead." << endl;
+    return COVARIANCE;
+  }
+
+  return preferred;
+}
+
+size_t PCA::MethodMemory(const DecompositionMethod decomposition,
+                         const size_t dimensionality,
+                         const size_t points,
+                         const size_t newDimension) const
+{
+  const size_t d = dimensionality;
+  const size_t n = points;
+  const size_t rank = std::min(d, n);
+  const size_t l = std::min(newDimension + oversampling, rank);
+
+  switch (decomposition)
+  {
+    case RANDOMIZED:
+      // The samples of the range (and their bases) and the small projection.
+      return MemoryBudget::MatrixBytes<double>(2 * d + 3 * n, l);
+    case QUIC_SVD:
+      // The cosine tree and the basis.
+      return MemoryBudget::MatrixBytes<double>(d, n + rank);
+    case COVARIANCE:
+      // The covariance matrix, its eigenvectors, and one block of projected
+      // points.
+      return MemoryBudget::MatrixBytes<double>(d, 3 * d) +
+          MemoryBudget::MatrixBytes<double>(std::max(newDimension, (size_t) 1),
+          MemoryBudget::BlockColumns(d * sizeof(double), n,
+          MemoryBudget::MatrixBytes<double>(d, 3 * d)));
+    default:
+      // The centered copy, the copy LAPACK decomposes, the projection, and the
+      // singular vectors.
+      return MemoryBudget::MatrixBytes<double>(d, 3 * n + rank);
+  }
+}
+
+void PCA::RandomizedSVD(const arma::mat& centeredData,
+                        const size_t rank,
+                        arma::mat& coeff,
+                        arma::vec& singularValues) const
+{
+  const size_t samples = std::min(rank + oversampling,
+      (size_t) std::min(centeredData.n_rows, centeredData.n_cols));
+
+  // Orthonormal bases are taken from economical singular value decompositions
+  // of the (thin) sample matrices; the singular values and right singular
+  // vectors are not needed.
+  arma::vec s;
+  arma::mat v;
+
+  // Sample the range of the data.
+  arma::mat q;
+  arma::mat y = centeredData * arma::randn<arma::mat>(centeredData.n_cols,
+      samples);
+  arma::svd_econ(q, s, v, y, 'l');
+
+  // Power iterations sharpen the decay of the singular values, so that the
+  // sampled range is closer to the leading singular vectors.
+  arma::mat z;
+  for (size_t i = 0; i < powerIterations; ++i)
+  {
+    y = trans(centeredData) * q;
+    arma::svd_econ(z, s, v, y, 'l');
+    y = centeredData * z;
+    arma::svd_econ(q, s, v, y, 'l');
+  }
+
+  // Decompose the projection of the data onto the sampled range exactly.  It
+  // only has as many rows as there are samples.
+  arma::mat u;
+  arma::svd_econ(u, s, v, trans(q) * centeredData, 'l');
+
+  coeff = q * u.cols(0, rank - 1);
+  singularValues = s.subvec(0, rank - 1);
+}
+
+double PCA::ApplyQUICSVD(arma::mat& data,
+                         const size_t newDimension,
+                         const double varRetained) const
+{
+  Timer::Start("pca");
+
+  // The data is overwritten anyway, so center it in place.
+  Center(data, data);
+
+  // The total variance is the sum of all eigenvalues, which is the trace of
+  // the covariance matrix.
+  const double totalVariance = accu(square(data)) / (data.n_cols - 1);
+
+  // The relative error of the decomposition is the fraction of the variance
+  // outside the basis, so the basis must hold at least varRetained of it.
+  const double error = (newDimension == 0) ?
+      std::min(relativeError, 1.0 - varRetained) : relativeError;
+  svd::QUICSVD quicSVD(error, std::max(newDimension, (size_t) 1));
+
+  arma::mat coeffs, v;
+  arma::vec eigVal;
+  quicSVD.Apply(data, coeffs, eigVal, v);
+  eigVal %= eigVal / (data.n_cols - 1);
+
+  // Find how many components to keep.
+  size_t dimension = newDimension;
+  double varSum = 0.0;
+  if (newDimension == 0)
+  {
+    while ((dimension < eigVal.n_elem) &&
+           ((dimension == 0) || (varSum < varRetained)))
+    {
+      varSum += eigVal[dimension] / totalVariance;
+      ++dimension;
+    }
+  }
+  else
+  {
+    dimension = std::min(newDimension, (size_t) eigVal.n_elem);
+    varSum = sum(eigVal.subvec(0, dimension - 1)) / totalVariance;
+  }
+
+  data = trans(coeffs.cols(0, dimension - 1)) * data;
+
+  // If the data has lower rank than the requested dimension, the remaining
+  // components have no variance.
+  if (dimension < newDimension)
+    data.insert_rows(dimension, newDimension - dimension);
+
+  Timer::Stop("pca");
+
+  return varSum;
+}
+
+double PCA::ApplyCovariance(arma::mat& data,
+                            const size_t newDimension,
+                            const double varRetained) const
+{
+  Timer::Start("pca");
+
+  // The data is overwritten anyway, so center it in place.
+  Center(data, data);
+
+  // Only the covariance matrix is decomposed, so the working memory does not
+  // depend on the number of points.
+  const arma::mat covariance = data * trans(data) / (data.n_cols - 1);
+
+  // If only a few components are wanted, find only those.
+  arma::vec eigVal;
+  arma::mat coeffs;
+  const bool partial = (newDimension > 0 &&
+      4 * newDimension < covariance.n_rows);
+  if (partial)
+  {
+    math::LanczosEigensolver solver;
+    if (!solver.Solve(covariance, newDimension, eigVal, coeffs))
+      Log::Warn << "The principal components did not converge in "
+          << solver.Restarts() << " restarts." << std::endl;
+  }
+  else
+  {
+    // The eigenvalues are in ascending order; the largest ones come first in
+    // the result.
+    arma::eig_sym(eigVal, coeffs, covariance);
+    eigVal = arma::flipud(eigVal);
+    coeffs = arma::fliplr(coeffs);
+  }
+
+  // Rounding may make the smallest eigenvalues slightly negative.
+  for (size_t i = 0; i < eigVal.n_elem; ++i)
+    if (eigVal[i] < 0.0)
+      eigVal[i] = 0.0;
+
+  // Without all the eigenvalues, the total variance is the trace of the
+  // covariance.
+  const double totalVariance = partial ? arma::trace(covariance) :
+      sum(eigVal);
+
+  // Find how many components to keep.
+  size_t dimension = newDimension;
+  double varSum = 0.0;
+  if (newDimension == 0)
+  {
+    while ((dimension < eigVal.n_elem) &&
+           ((dimension == 0) || (varSum < varRetained)))
+    {
+      varSum += eigVal[dimension] / totalVariance;
+      ++dimension;
+    }
+  }
+  else
+  {
+    varSum = sum(eigVal.subvec(0, dimension - 1)) / totalVariance;
+  }
+
+  // Project the points onto the components a block at a time, overwriting the
+  // first rows of each block.
+  const arma::mat basis = coeffs.cols(0, dimension - 1);
+  const size_t block = MemoryBudget::BlockColumns(dimension * sizeof(double),
+      data.n_cols, MemoryBudget::MatrixBytes<double>(data.n_rows,
+      3 * data.n_rows));
+  for (size_t begin = 0; begin < data.n_cols; begin += block)
+  {
+    const size_t end = std::min(begin + block, (size_t) data.n_cols) - 1;
+    const arma::mat projected = trans(basis) * data.cols(begin, end);
+    data.submat(0, begin, dimension - 1, end) = projected;
+  }
+
+  if (dimension < data.n_rows)
+    data.shed_rows(dimension, data.n_rows - 1);
+
+  Timer::Stop("pca");
+
+  return varSum;
+}
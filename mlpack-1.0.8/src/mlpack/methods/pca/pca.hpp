@@ -34,17 +34,68 @@ namespace pca {
  * or transforming data into a better basis.  Further information on PCA can be
  * found in almost any statistics or machine learning textbook, and all over the
  * internet.
+ *
+ * When only a few principal components are kept (see Apply(data,
+ * newDimension)), they can be found with a randomized singular value
+ * decomposition instead of a full one: the range of the centered data is
+ * sampled with a few more random vectors than components (the oversampling),
+ * refined with a few power iterations, and only the small projection of the
+ * data onto that range is decomposed exactly.  By default this is done
+ * automatically when the new dimension is small compared to the data.
+ *
+ * Alternatively, the components can be found with QUIC-SVD (see svd::QUICSVD),
+ * which grows an orthonormal basis until the data outside it has at most
+ * RelativeError() of the total variance; this is the natural method for
+ * Apply(data, varRetained), since the basis then only has to hold varRetained
+ * of the variance.
+ *
+ * The components can also be found with an eigendecomposition of the
+ * covariance matrix, which is computed from the data centered in place; its
+ * working memory is only quadratic in the dimensionality.  When a
+ * MemoryBudget is set and the automatic choice of decomposition would not fit
+ * in it, this method is used instead (see PeakMemory()).
+ *
+ * @code
+ * @article{halko2011finding,
+ *   title={Finding structure with randomness: Probabilistic algorithms for
+ *       constructing approximate matrix decompositions},
+ *   author={Halko, N. and Martinsson, P.-G. and Tropp, J. A.},
+ *   journal={SIAM Review},
+ *   volume={53},
+ *   number={2},
+ *   pages={217--288},
+ *   year={2011}
+ * }
+ * @endcode
  */
 class PCA
 {
  public:
+  //! The ways to compute the decomposition when reducing dimensionality.
+  enum DecompositionMethod
+  {
+    //! Randomized if the new dimension is small, exact otherwise.
+    AUTOMATIC,
+    //! Always use a full singular value decomposition.
+    EXACT,
+    //! Always use a randomized singular value decomposition.
+    RANDOMIZED,
+    //! Use QUIC-SVD, to the relative error RelativeError().
+    QUIC_SVD,
+    //! Use an eigendecomposition of the covariance matrix.
+    COVARIANCE
+  };
+
   /**
    * Create the PCA object, specifying if the data should be scaled in each
    * dimension by standard deviation when PCA is performed.
    *
    * @param scaleData Whether or not to scale the data.
+   * @param method How to compute the decomposition in Apply(data,
+   *     newDimension).
    */
-  PCA(const bool scaleData = false);
+  PCA(const bool scaleData = false,
+      const DecompositionMethod method = AUTOMATIC);
 
   /**
    * Apply Principal Component Analysis to the provided data set.  It is safe to
@@ -79,6 +130,11 @@ class PCA
    * retained; this is a value between 0 and 1.  For instance, a value of 0.9
    * indicates that 90% of the variance present in the data was retained.
    *
+   * Depending on Method(), the components may be found with a randomized
+   * singular value decomposition; then they (and the variance retained) are
+   * approximations, which are very accurate when the remaining components
+   * hold much less variance than the kept ones.
+   *
    * @param data Data matrix.
    * @param newDimension New dimension of the data.
    * @return Amount of the variance of the data retained (between 0 and 1).
@@ -108,6 +164,20 @@ class PCA
    */
   double Apply(arma::mat& data, const double varRetained) const;
 
+  /**
+   * Return the working memory (in bytes, beyond the dataset itself) that
+   * Apply(data, newDimension) is expected to need for a dataset of the given
+   * size, with the decomposition it would choose under the current
+   * MemoryBudget.  This is an estimate; it does not include the output.
+   *
+   * @param dimensionality Dimensionality of the data.
+   * @param points Number of points in the data.
+   * @param newDimension New dimension of the data.
+   */
+  size_t PeakMemory(const size_t dimensionality,
+                    const size_t points,
+                    const size_t newDimension) const;
+
   //! Get whether or not this PCA object will scale (by standard deviation) the
   //! data when PCA is performed.
   bool ScaleData() const { return scaleData; }
@@ -115,11 +185,129 @@ class PCA
   //! the data when PCA is performed.
   bool& ScaleData() { return scaleData; }
 
+  //! Get how the decomposition is computed when reducing dimensionality.
+  DecompositionMethod Method() const { return method; }
+  //! Modify how the decomposition is computed when reducing dimensionality.
+  DecompositionMethod& Method() { return method; }
+
+  //! Get the number of power iterations of the randomized decomposition.
+  size_t PowerIterations() const { return powerIterations; }
+  //! Modify the number of power iterations of the randomized decomposition.
+  size_t& PowerIterations() { return powerIterations; }
+
+  //! Get the largest relative error (the fraction of the variance left out) of
+  //! the QUIC-SVD decomposition.
+  double RelativeError() const { return relativeError; }
+  //! Modify the largest relative error (the fraction of the variance left
+  //! out) of the QUIC-SVD decomposition.
+  double& RelativeError() { return relativeError; }
+
+  //! Get the number of extra random vectors used to sample the range of the
+  //! data in the randomized decomposition.
+  size_t Oversampling() const { return oversampling; }
+  //! Modify the number of extra random vectors used to sample the range of
+  //! the data in the randomized decomposition.
+  size_t& Oversampling() { return oversampling; }
+
  private:
   //! Whether or not the data will be scaled by standard deviation when PCA is
   //! performed.
   bool scaleData;
 
+  //! How the decomposition is computed when reducing dimensionality.
+  DecompositionMethod method;
+
+  //! The number of power iterations of the randomized decomposition.
+  size_t powerIterations;
+
+  //! The number of extra random vectors of the randomized decomposition.
+  size_t oversampling;
+
+  //! The largest relative error of the QUIC-SVD decomposition.
+  double relativeError;
+
+  /**
+   * Center the data, and scale it if ScaleData() is set.
+   *
+   * @param data Data matrix.
+   * @param centeredData Matrix to store the centered data in.
+   */
+  void Center(const arma::mat& data, arma::mat& centeredData) const;
+
+  /**
+   * Decide whether the randomized decomposition should be used to find the
+   * given number of components of data of the given size.
+   */
+  bool UseRandomized(const size_t dimensionality,
+                     const size_t points,
+                     const size_t newDimension) const;
+
+  /**
+   * Choose the decomposition used by Apply(data, newDimension) for data of the
+   * given size; this takes the MemoryBudget into account when Method() is
+   * AUTOMATIC.  A newDimension of 0 means all components are needed (as in
+   * Apply(data, varRetained)).
+   */
+  DecompositionMethod ChooseMethod(const size_t dimensionality,
+                                   const size_t points,
+                                   const size_t newDimension) const;
+
+  /**
+   * Estimate the working memory of the given decomposition (which must not be
+   * AUTOMATIC), in bytes.
+   */
+  size_t MethodMemory(const DecompositionMethod decomposition,
+                      const size_t dimensionality,
+                      const size_t points,
+                      const size_t newDimension) const;
+
+  /**
+   * Find the leading left singular vectors and singular values of the
+   * centered data with a randomized range finder.
+   *
+   * @param centeredData Centered data matrix.
+   * @param rank Number of singular vectors to find.
+   * @param coeff Matrix to store the left singular vectors in.
+   * @param singularValues Vector to store the singular values in.
+   */
+  void RandomizedSVD(const arma::mat& centeredData,
+                     const size_t rank,
+                     arma::mat& coeff,
+                     arma::vec& singularValues) const;
+
+  /**
+   * Reduce the dimensionality of the given data with QUIC-SVD, keeping either
+   * the given number of components or (if newDimension is 0) as many as are
+   * needed to retain the given amount of variance.
+   *
+   * @param data Data matrix.
+   * @param newDimension New dimension of the data, or 0.
+   * @param varRetained Lower bound on amount of variance to retain, if
+   *     newDimension is 0.
+   * @return Amount of the variance of the data retained (between 0 and 1).
+   */
+  double ApplyQUICSVD(arma::mat& data,
+                      const size_t newDimension,
+                      const double varRetained) const;
+
+  /**
+   * Reduce the dimensionality of the given data with an eigendecomposition of
+   * its covariance matrix, keeping either the given number of components or
+   * (if newDimension is 0) as many as are needed to retain the given amount of
+   * variance.  The data is centered and projected in place, a block of points
+   * at a time.  If newDimension is less than a quarter of the dimensionality,
+   * only those components are found, with math::LanczosEigensolver.
+   *
+   * @param data Data matrix.
+   * @param newDimension New dimension of the data, or 0.
+   * @param varRetained Lower bound on amount of variance to retain, if
+   *     newDimension is 0.
+   * @return Amount of the variance of the data retained (between 0 and 1).
+   */
+  double ApplyCovariance(arma::mat& data,
+                         const size_t newDimension,
+                         const double varRetained) const;
+
 }; // class PCA
 
 }; // namespace pca
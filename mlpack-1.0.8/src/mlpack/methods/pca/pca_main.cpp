@@ -32,7 +32,20 @@ PROGRAM_INFO("Principal Components Analysis", "This program performs principal "
     "components analysis on the given dataset.  It will transform the data "
     "onto its principal components, optionally performing dimensionality "
     "reduction by ignoring the principal components with the smallest "
-    "eigenvalues.");
+    "eigenvalues."
+    "\n\n"
+    "When reducing to a small dimensionality with -d, the principal "
+    "components may be found with a randomized singular value decomposition, "
+    "which is much faster than the exact one for high-dimensional data.  This "
+    "is controlled with --decomposition_method (-c): 'auto' (the default) uses "
+    "the randomized decomposition when the new dimensionality is small, "
+    "'exact' never does, and 'randomized' always does.  'quic_svd' uses "
+    "QUIC-SVD, which grows a basis of the data with a cosine tree until at "
+    "most --relative_error (-e) of the variance is left out of it (or, with "
+    "-V, until the requested variance is retained).  'covariance' uses an "
+    "eigendecomposition of the covariance matrix, which needs much less "
+    "memory when there are many points; 'auto' also uses it when the other "
+    "decompositions would not fit in --memory_budget.");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform PCA on.", "i");
@@ -45,6 +58,12 @@ PARAM_DOUBLE("var_to_retain", "Amount of variance to retain; should be between "
 PARAM_FLAG("scale", "If set, the data will be scaled before running PCA, such "
     "that the variance of each feature is 1.", "s");
 
+PARAM_STRING("decomposition_method", "Method used to find the principal "
+    "components; 'auto', 'exact', 'randomized', 'quic_svd', or 'covariance'.",
+    "c", "auto");
+PARAM_DOUBLE("relative_error", "Largest fraction of the variance left out by "
+    "the QUIC-SVD decomposition.", "e", 0.01);
+
 int main(int argc, char** argv)
 {
   // Parse commandline.
@@ -72,8 +91,24 @@ int main(int argc, char** argv)
   // Get the options for running PCA.
   const size_t scale = CLI::HasParam("scale");
 
+  const string methodString = CLI::GetParam<string>("decomposition_method");
+  PCA::DecompositionMethod method = PCA::AUTOMATIC;
+  if (methodString == "exact")
+    method = PCA::EXACT;
+  else if (methodString == "randomized")
+    method = PCA::RANDOMIZED;
+  else if (methodString == "quic_svd")
+    method = PCA::QUIC_SVD;
+  else if (methodString == "covariance")
+    method = PCA::COVARIANCE;
+  else if (methodString != "auto")
+    Log::Fatal << "Invalid decomposition method '" << methodString << "'; "
+        << "must be 'auto', 'exact', 'randomized', 'quic_svd', or "
+        << "'covariance'." << endl;
+
   // Perform PCA.
-  PCA p(scale);
+  PCA p(scale, method);
+  p.RelativeError() = CLI::GetParam<double>("relative_error");
   Log::Info << "Performing PCA on dataset..." << endl;
   double varRetained;
   if (CLI::GetParam<double>("var_to_retain") != 0)
@@ -0,0 +1,187 @@
+/**
+ * @file quic_svd.cpp
+ *
+ * Implementation of QUIC-SVD.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quic_svd.hpp"
+
+using namespace mlpack;
+using namespace mlpack::svd;
+using namespace mlpack::tree;
+
+QUICSVD::QUICSVD(const double relativeError,
+                 const size_t minRank,
+                 const size_t maxRank) :
+    relativeError(relativeError),
+    minRank(minRank),
+    maxRank(maxRank)
+{
+  if (relativeError < 0.0 || relativeError > 1.0)
+    Log::Fatal << "QUICSVD::QUICSVD(): relative error (" << relativeError
+        << ") must be between 0 and 1." << std::endl;
+}
+
+double QUICSVD::Apply(const arma::mat& dataset,
+                      arma::mat& u,
+                      arma::vec& sigma,
+                      arma::mat& v) const
+{
+  if (dataset.n_rows == 0 || dataset.n_cols == 0)
+    Log::Fatal << "QUICSVD::Apply(): cannot decompose an empty matrix."
+        << std::endl;
+
+  // The tree reorders the columns of its dataset, so it is built on one copy;
+  // the nodes only refer to ranges of columns of that copy, and oldFromNew
+  // maps them back to the columns of the original matrix.
+  arma::mat data(dataset);
+  std::vector<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    oldFromNew[i] = i;
+
+  CosineTreeBuilder builder;
+  CosineTree root(data);
+  builder.CTNode(root);
+
+  // The residual of each column (of the original matrix) is the squared norm
+  // of its part outside the basis.
+  arma::vec residuals = trans(arma::sum(arma::square(dataset), 0));
+  const double total = arma::accu(residuals);
+
+  const size_t fullRank = std::min(dataset.n_rows, dataset.n_cols);
+  const size_t rankLimit = (maxRank == 0) ? fullRank :
+      std::min(maxRank, fullRank);
+
+  arma::mat basis(dataset.n_rows, 0);
+  if (total > 0.0)
+    AddToBasis(root.Centroid(), dataset, basis, residuals);
+
+  // The leaves of the tree, and whether they may still improve the basis.
+  std::vector<CosineTree*> leaves(1, &root);
+  std::vector<bool> active(1, total > 0.0);
+
+  double residual = (total > 0.0) ? arma::accu(residuals) : 0.0;
+  while (basis.n_cols < rankLimit)
+  {
+    if (basis.n_cols >= minRank && residual <= relativeError * total)
+      break;
+
+    // Find the leaf whose points are worst approximated.
+    size_t worst = leaves.size();
+    double worstResidual = 0.0;
+    for (size_t i = 0; i < leaves.size(); ++i)
+    {
+      if (!active[i])
+        continue;
+
+      double leafResidual = 0.0;
+      for (size_t j = 0; j < leaves[i]->Count(); ++j)
+        leafResidual += residuals[oldFromNew[leaves[i]->Point(j)]];
+
+      if (worst == leaves.size() || leafResidual > worstResidual)
+      {
+        worst = i;
+        worstResidual = leafResidual;
+      }
+    }
+
+    if (worst == leaves.size() || worstResidual <= 0.0)
+      break;
+
+    CosineTree& leaf = *leaves[worst];
+    bool added = false;
+    builder.CTNodeSplit(leaf, oldFromNew);
+    if (leaf.Left() != NULL)
+    {
+      leaves[worst] = leaf.Left();
+      leaves.push_back(leaf.Right());
+      active.push_back(true);
+
+      added = AddToBasis(leaf.Left()->Centroid(), dataset, basis, residuals);
+      if (basis.n_cols < rankLimit)
+        added |= AddToBasis(leaf.Right()->Centroid(), dataset, basis,
+            residuals);
+    }
+
+    if (!added)
+    {
+      // The leaf could not be split, or its children did not add any new
+      // direction; fall back to its worst approximated column.
+      const CosineTree& node = *leaves[worst];
+      size_t column = oldFromNew[node.Begin()];
+      for (size_t j = 1; j < node.Count(); ++j)
+        if (residuals[oldFromNew[node.Point(j)]] > residuals[column])
+          column = oldFromNew[node.Point(j)];
+
+      if (!AddToBasis(dataset.col(column), dataset, basis, residuals))
+        active[worst] = false;
+    }
+
+    residual = arma::accu(residuals);
+  }
+
+  // Decompose the projection of the original matrix onto the basis exactly.
+  if (basis.n_cols == 0)
+  {
+    // The matrix is zero.
+    u = arma::eye<arma::mat>(dataset.n_rows, 1);
+    sigma.zeros(1);
+    v.zeros(dataset.n_cols, 1);
+    return 0.0;
+  }
+
+  arma::mat ub;
+  arma::svd_econ(ub, sigma, v, trans(basis) * dataset);
+  u = basis * ub;
+
+  return (total > 0.0) ? std::max(residual, 0.0) / total : 0.0;
+}
+
+bool QUICSVD::AddToBasis(const arma::vec& vector,
+                         const arma::mat& data,
+                         arma::mat& basis,
+                         arma::vec& residuals) const
+{
+  const double norm = arma::norm(vector, 2);
+  if (norm == 0.0)
+    return false;
+
+  // Classical Gram-Schmidt, twice, is as accurate as modified Gram-Schmidt.
+  arma::vec direction = vector;
+  if (basis.n_cols > 0)
+  {
+    direction -= basis * (trans(basis) * direction);
+    direction -= basis * (trans(basis) * direction);
+  }
+
+  const double remaining = arma::norm(direction, 2);
+  if (remaining <= 1e-10 * norm)
+    return false;
+
+  direction /= remaining;
+  basis.insert_cols(basis.n_cols, direction);
+
+  // The projection onto an orthonormal basis vector is removed from the
+  // residual of every column.
+  const arma::vec projections = trans(data) * direction;
+  residuals -= arma::square(projections);
+  for (size_t i = 0; i < residuals.n_elem; ++i)
+    if (residuals[i] < 0.0)
+      residuals[i] = 0.0;
+
+  return true;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file quic_svd.hpp
+ *
+ * Definition of the QUICSVD class, which computes a low-rank singular value
+ * decomposition to a given relative error with a cosine tree.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_QUIC_SVD_QUIC_SVD_HPP
+#define __MLPACK_METHODS_QUIC_SVD_QUIC_SVD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/cosine_tree/cosine_tree.hpp>
+#include <mlpack/core/tree/cosine_tree/cosine_tree_builder.hpp>
+
+namespace mlpack {
+namespace svd /** Singular value decompositions. */ {
+
+/**
+ * QUIC-SVD finds a low-rank singular value decomposition A ~= U S V^T of a
+ * dense matrix, whose rank is just large enough for the given relative error.
+ * The columns of A are organized in a cosine tree, which is grown one split at
+ * a time: the leaf whose points are worst approximated is split, and the
+ * centroids of the two new children are added to an orthonormal basis of the
+ * column space.  Once the squared Frobenius norm of the part of A outside the
+ * basis is at most the relative error times the squared Frobenius norm of A,
+ * the (small) projection of A onto the basis is decomposed exactly.
+ *
+ * This is much faster than arma::svd() when the rank needed is much smaller
+ * than the dimensions of A, since every step only costs a few passes over A.
+ * The error is computed exactly (not estimated by sampling, as in the paper),
+ * since that only costs one more pass over A for each basis vector.
+ *
+ * @code
+ * @inproceedings{holmes2008quic,
+ *   title={{QUIC-SVD}: Fast {SVD} using cosine trees},
+ *   author={Holmes, M. P. and Isbell, C. L. and Gray, A. G.},
+ *   booktitle={Advances in Neural Information Processing Systems 21},
+ *   pages={673--680},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * @code
+ * QUICSVD svd(0.01); // Keep 99% of the squared Frobenius norm.
+ * arma::mat u, v;
+ * arma::vec sigma;
+ * svd.Apply(data, u, sigma, v);
+ * @endcode
+ */
+class QUICSVD
+{
+ public:
+  /**
+   * Create the QUICSVD object with the given parameters.
+   *
+   * @param relativeError Largest allowed ||A - U S V^T||_F^2 / ||A||_F^2.
+   * @param minRank Smallest rank of the decomposition (if A has that rank).
+   * @param maxRank Largest rank of the decomposition; 0 means no limit.  If it
+   *     is reached, the relative error may not be attained.
+   */
+  QUICSVD(const double relativeError = 0.01,
+          const size_t minRank = 1,
+          const size_t maxRank = 0);
+
+  /**
+   * Decompose the given matrix.  The singular values are sorted in decreasing
+   * order, and U and V have one column for each of them.
+   *
+   * @param dataset Matrix to decompose.
+   * @param u Matrix to store the left singular vectors in.
+   * @param sigma Vector to store the singular values in.
+   * @param v Matrix to store the right singular vectors in.
+   * @return The relative error of the decomposition.
+   */
+  double Apply(const arma::mat& dataset,
+               arma::mat& u,
+               arma::vec& sigma,
+               arma::mat& v) const;
+
+  //! Get the largest allowed relative error.
+  double RelativeError() const { return relativeError; }
+  //! Modify the largest allowed relative error.
+  double& RelativeError() { return relativeError; }
+
+  //! Get the smallest rank of the decomposition.
+  size_t MinRank() const { return minRank; }
+  //! Modify the smallest rank of the decomposition.
+  size_t& MinRank() { return minRank; }
+
+  //! Get the largest rank of the decomposition (0 means no limit).
+  size_t MaxRank() const { return maxRank; }
+  //! Modify the largest rank of the decomposition (0 means no limit).
+  size_t& MaxRank() { return maxRank; }
+
+ private:
+  //! The largest allowed relative error.
+  double relativeError;
+  //! The smallest rank of the decomposition.
+  size_t minRank;
+  //! The largest rank of the decomposition.
+  size_t maxRank;
+
+  /**
+   * Orthogonalize the given vector against the basis and add it, if it is not
+   * (numerically) in the span of the basis already; then remove its part from
+   * the residual of every column.
+   *
+   * @param vector Vector to add.
+   * @param data Matrix being decomposed.
+   * @param basis Orthonormal basis to extend.
+   * @param residuals Squared norm of the part of each column outside the basis.
+   * @return Whether the vector was added.
+   */
+  bool AddToBasis(const arma::vec& vector,
+                  const arma::mat& data,
+                  arma::mat& basis,
+                  arma::vec& residuals) const;
+};
+
+}; // namespace svd
+}; // namespace mlpack
+
+#endif
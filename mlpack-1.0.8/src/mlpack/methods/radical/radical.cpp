@@ -22,6 +22,10 @@
 
 #include "radical.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 using namespace arma;
 using namespace mlpack;
@@ -32,12 +36,14 @@ Radical::Radical(const double noiseStdDev,
                  const size_t replicates,
                  const size_t angles,
                  const size_t sweeps,
-                 const size_t m) :
+                 const size_t m,
+                 const size_t threads) :
     noiseStdDev(noiseStdDev),
     replicates(replicates),
     angles(angles),
     sweeps(sweeps),
-    m(m)
+    m(m),
+    threads(threads)
 {
   // Nothing to do here.
 }
@@ -45,24 +51,86 @@ Radical::Radical(const double noiseStdDev,
 void Radical::CopyAndPerturb(mat& xNew, const mat& x) const
 {
   Timer::Start("radical_copy_and_perturb");
-  xNew = repmat(x, replicates, 1) + noiseStdDev * randn(replicates * x.n_rows,
-      x.n_cols);
+  // Draw the noise straight into xNew, then add the replicates of x.
+  xNew.randn(replicates * x.n_rows, x.n_cols);
+  xNew *= noiseStdDev;
+  for (size_t r = 0; r < replicates; ++r)
+    xNew.rows(r * x.n_rows, (r + 1) * x.n_rows - 1) += x;
   Timer::Stop("radical_copy_and_perturb");
 }
 
+/**
+ * Sort the values in place with an LSD radix sort (eleven bits at a time) on
+ * their bit patterns.  The patterns are mapped first, so that their unsigned
+ * order is the order of the values: negative values have all their bits
+ * flipped, and positive values only their sign bit.
+ */
+static void RadixSort(double* values,
+                      const size_t n,
+                      std::vector<uint64_t>& keys,
+                      std::vector<uint64_t>& buffer)
+{
+  const uint64_t signBit = ((uint64_t) 1) << 63;
+  const size_t radixBits = 11;
+  const size_t buckets = ((size_t) 1) << radixBits;
+
+  keys.resize(n);
+  buffer.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint64_t bits;
+    memcpy(&bits, &values[i], sizeof(double));
+    keys[i] = (bits & signBit) ? ~bits : (bits | signBit);
+  }
+
+  size_t counts[buckets];
+  for (size_t shift = 0; shift < 64; shift += radixBits)
+  {
+    std::fill(counts, counts + buckets, 0);
+    for (size_t i = 0; i < n; ++i)
+      ++counts[(keys[i] >> shift) & (buckets - 1)];
+
+    // Nothing to do if every key has the same digit.
+    if (counts[(keys[0] >> shift) & (buckets - 1)] == n)
+      continue;
+
+    size_t offset = 0;
+    for (size_t d = 0; d < buckets; ++d)
+    {
+      const size_t count = counts[d];
+      counts[d] = offset;
+      offset += count;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+      buffer[counts[(keys[i] >> shift) & (buckets - 1)]++] = keys[i];
+
+    keys.swap(buffer);
+  }
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    const uint64_t bits = (keys[i] & signBit) ? (keys[i] ^ signBit) :
+        ~keys[i];
+    memcpy(&values[i], &bits, sizeof(double));
+  }
+}
 
 double Radical::Vasicek(vec& z) const
 {
-  z = sort(z);
+  std::vector<uint64_t> keys, buffer;
+  return Vasicek(z, keys, buffer);
+}
+
+double Radical::Vasicek(vec& z,
+                        std::vector<uint64_t>& keys,
+                        std::vector<uint64_t>& buffer) const
+{
+  if (z.n_elem == 0)
+    return 0;
 
-  // Apparently slower.
-  /*
-  vec logs = log(z.subvec(m, z.n_elem - 1) - z.subvec(0, z.n_elem - 1 - m));
-  //vec val = sum(log(z.subvec(m, nPoints - 1) - z.subvec(0, nPoints - 1 - m)));
-  return (double) sum(logs);
-  */
+  RadixSort(z.memptr(), z.n_elem, keys, buffer);
 
-  // Apparently faster.
   double sum = 0;
   uword range = z.n_elem - m;
   for (uword i = 0; i < range; i++)
@@ -78,26 +146,42 @@ double Radical::DoRadical2D(const mat& matX)
 {
   CopyAndPerturb(perturbed, matX);
 
-  mat::fixed<2, 2> matJacobi;
+  return SearchAngles(perturbed, NumThreads());
+}
 
+double Radical::SearchAngles(const mat& perturbed,
+                             const size_t numThreads) const
+{
   vec values(angles);
 
-  for (size_t i = 0; i < angles; i++)
+  #pragma omp parallel num_threads(numThreads)
   {
-    const double theta = (i / (double) angles) * M_PI / 2.0;
-    const double cosTheta = cos(theta);
-    const double sinTheta = sin(theta);
-
-    matJacobi(0, 0) = cosTheta;
-    matJacobi(1, 0) = -sinTheta;
-    matJacobi(0, 1) = sinTheta;
-    matJacobi(1, 1) = cosTheta;
+    // Each thread rotates and sorts in its own buffers.
+    mat::fixed<2, 2> matJacobi;
+    mat candidate;
+    std::vector<uint64_t> keys, buffer;
 
-    candidate = perturbed * matJacobi;
-    vec candidateY1 = candidate.unsafe_col(0);
-    vec candidateY2 = candidate.unsafe_col(1);
-
-    values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
+    #pragma omp for schedule(static)
+    for (int i = 0; i < (int) angles; i++)
+    {
+      const double theta = (i / (double) angles) * M_PI / 2.0;
+      const double cosTheta = cos(theta);
+      const double sinTheta = sin(theta);
+
+      matJacobi(0, 0) = cosTheta;
+      matJacobi(1, 0) = -sinTheta;
+      matJacobi(0, 1) = sinTheta;
+      matJacobi(1, 1) = cosTheta;
+
+      // The columns of the candidate are sorted in place; it is overwritten
+      // for the next angle anyway.
+      candidate = perturbed * matJacobi;
+      vec candidateY1(candidate.colptr(0), candidate.n_rows, false, true);
+      vec candidateY2(candidate.colptr(1), candidate.n_rows, false, true);
+
+      values(i) = Vasicek(candidateY1, keys, buffer) +
+          Vasicek(candidateY2, keys, buffer);
+    }
   }
 
   uword indOpt;
@@ -140,42 +224,86 @@ void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
   Timer::Start("radical_do_radical");
   matW = matWhitening;
 
-  mat matYSubspace(nPoints, 2);
+  const size_t numThreads = NumThreads();
+
+  // The round-robin tournament: with an even number of players (one of which
+  // is a dummy if the number of dimensions is odd), player 0 stays in place and
+  // the others rotate after each round, so every pair meets exactly once.
+  const size_t nPlayers = nDims + (nDims % 2);
+  std::vector<size_t> players(nPlayers);
+  for (size_t i = 0; i < nPlayers; ++i)
+    players[i] = i;
 
-  mat matJ = eye(nDims, nDims);
+  std::vector<std::pair<size_t, size_t> > pairs;
+  std::vector<mat> perturbedPairs;
+  std::vector<double> thetas;
+  mat matYSubspace(nPoints, 2);
 
   for (size_t sweepNum = 0; sweepNum < sweeps; sweepNum++)
   {
     Log::Info << "RADICAL: sweep " << sweepNum << "." << std::endl;
 
-    for (size_t i = 0; i < nDims - 1; i++)
+    for (size_t round = 0; round + 1 < nPlayers; ++round)
     {
-      for (size_t j = i + 1; j < nDims; j++)
+      // Collect the (disjoint) pairs of this round.
+      pairs.clear();
+      for (size_t k = 0; k < nPlayers / 2; ++k)
       {
-        Log::Debug << "RADICAL 2D on dimensions " << i << " and " << j << "."
-            << std::endl;
-
-        matYSubspace.col(0) = matY.col(i);
-        matYSubspace.col(1) = matY.col(j);
-
-        const double thetaOpt = DoRadical2D(matYSubspace);
+        const size_t a = players[k];
+        const size_t b = players[nPlayers - 1 - k];
+        if (a < nDims && b < nDims)
+          pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+      }
 
-        const double cosThetaOpt = cos(thetaOpt);
-        const double sinThetaOpt = sin(thetaOpt);
+      // Rotate the players, keeping the first in place.
+      const size_t last = players[nPlayers - 1];
+      for (size_t k = nPlayers - 1; k > 1; --k)
+        players[k] = players[k - 1];
+      players[1] = last;
+
+      // Perturb the data of each pair in order, so the random numbers do not
+      // depend on the scheduling.
+      perturbedPairs.resize(pairs.size());
+      thetas.resize(pairs.size());
+      for (size_t p = 0; p < pairs.size(); ++p)
+      {
+        Log::Debug << "RADICAL 2D on dimensions " << pairs[p].first << " and "
+            << pairs[p].second << "." << std::endl;
 
-        // Set elements of transformation matrix.
-        matJ(i, i) = cosThetaOpt;
-        matJ(j, i) = -sinThetaOpt;
-        matJ(i, j) = sinThetaOpt;
-        matJ(j, j) = cosThetaOpt;
+        matYSubspace.col(0) = matY.col(pairs[p].first);
+        matYSubspace.col(1) = matY.col(pairs[p].second);
+        CopyAndPerturb(perturbedPairs[p], matYSubspace);
+      }
 
-        matY *= matJ;
+      // With enough pairs, give each thread whole pairs; otherwise split the
+      // angles of each pair between the threads.
+      if (pairs.size() >= numThreads)
+      {
+        #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 1)
+        for (int p = 0; p < (int) pairs.size(); ++p)
+          thetas[p] = SearchAngles(perturbedPairs[p], 1);
+      }
+      else
+      {
+        for (size_t p = 0; p < pairs.size(); ++p)
+          thetas[p] = SearchAngles(perturbedPairs[p], numThreads);
+      }
 
-        // Unset elements of transformation matrix, so matJ = eye() again.
-        matJ(i, i) = 1;
-        matJ(j, i) = 0;
-        matJ(i, j) = 0;
-        matJ(j, j) = 1;
+      // Apply the rotations; each only touches its own two columns.
+      for (size_t p = 0; p < pairs.size(); ++p)
+      {
+        const size_t i = pairs[p].first;
+        const size_t j = pairs[p].second;
+        const double cosThetaOpt = cos(thetas[p]);
+        const double sinThetaOpt = sin(thetas[p]);
+
+        const vec yI = matY.col(i);
+        matY.col(i) = cosThetaOpt * yI - sinThetaOpt * matY.col(j);
+        matY.col(j) = sinThetaOpt * yI + cosThetaOpt * matY.col(j);
+
+        const vec wI = matW.col(i);
+        matW.col(i) = cosThetaOpt * wI - sinThetaOpt * matW.col(j);
+        matW.col(j) = sinThetaOpt * wI + cosThetaOpt * matW.col(j);
       }
     }
   }
@@ -189,6 +317,13 @@ void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
   Timer::Stop("radical_transpose_data");
 }
 
+size_t Radical::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
+
 void mlpack::radical::WhitenFeatureMajorMatrix(const mat& matX,
                                                mat& matXWhitened,
                                                mat& matWhitening)
@@ -37,6 +37,14 @@ namespace radical {
  * The goal is to find a square unmixing matrix W such that Y = W X and
  * the rows of Y are independent components.
  *
+ * Each sweep rotates every pair of dimensions once.  The pairs are visited in
+ * round-robin tournament order, so that each round is a set of disjoint pairs;
+ * the pairs of a round are independent and are searched in parallel (see
+ * Threads()).  When there are fewer pairs in a round than threads, the angles
+ * of each pair are searched in parallel instead.  The random perturbations are
+ * always drawn in the same order, so the result does not depend on the number
+ * of threads.
+ *
  * For more details, see the following paper:
  *
  * @code
@@ -65,12 +73,14 @@ class Radical
    * @param sweeps Number of sweeps.  Each sweep calls Radical2D once for each
    *    pair of dimensions
    * @param m The variable m from Vasicek's m-spacing estimator of entropy.
+   * @param threads Number of threads to use (0 means all available cores).
    */
   Radical(const double noiseStdDev = 0.175,
           const size_t replicates = 30,
           const size_t angles = 150,
           const size_t sweeps = 0,
-          const size_t m = 0);
+          const size_t m = 0,
+          const size_t threads = 1);
 
   /**
    * Run RADICAL.
@@ -85,7 +95,8 @@ class Radical
 
   /**
    * Vasicek's m-spacing estimator of entropy, with overlap modification from
-   * (Learned-Miller and Fisher, 2003).
+   * (Learned-Miller and Fisher, 2003).  The sample is sorted in place (with a
+   * radix sort on the bit patterns of the values).
    *
    * @param x Empirical sample (one-dimensional) over which to estimate entropy.
    */
@@ -94,7 +105,8 @@ class Radical
   /**
    * Make replicates of each data point (the number of replicates is set in
    * either the constructor or with Replicates()) and perturb data with Gaussian
-   * noise with standard deviation noiseStdDev.
+   * noise with standard deviation noiseStdDev.  If xNew already has the right
+   * size, its memory is reused.
    */
   void CopyAndPerturb(arma::mat& xNew, const arma::mat& x) const;
 
@@ -121,6 +133,11 @@ class Radical
   //! Modify the number of sweeps.
   size_t& Sweeps() { return sweeps; }
 
+  //! Get the number of threads used (0 means all available cores).
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used (0 means all available cores).
+  size_t& Threads() { return threads; }
+
  private:
   //! Standard deviation of the Gaussian noise added to the replicates of
   //! the data points during Radical2D.
@@ -139,10 +156,30 @@ class Radical
   //! Value of m to use for Vasicek's m-spacing estimator of entropy.
   size_t m;
 
+  //! Number of threads to use.
+  size_t threads;
+
   //! Internal matrix, held as member variable to prevent memory reallocations.
   arma::mat perturbed;
-  //! Internal matrix, held as member variable to prevent memory reallocations.
-  arma::mat candidate;
+
+  /**
+   * Vasicek's m-spacing estimator of entropy, sorting with the given buffers
+   * (which are reused between calls, to prevent memory reallocations).
+   */
+  double Vasicek(arma::vec& x,
+                 std::vector<uint64_t>& keys,
+                 std::vector<uint64_t>& buffer) const;
+
+  /**
+   * Find the angle of rotation which minimizes the entropy of the given
+   * perturbed two-dimensional data, with the angles split between the given
+   * number of threads.
+   */
+  double SearchAngles(const arma::mat& perturbed,
+                      const size_t numThreads) const;
+
+  //! Get the number of threads to use.
+  size_t NumThreads() const;
 };
 
 void WhitenFeatureMajorMatrix(const arma::mat& matX,
@@ -45,6 +45,8 @@ PARAM_INT("angles", "Number of angles to consider in brute-force search "
 PARAM_INT("sweeps", "Number of sweeps; each sweep calls Radical2D once for "
     "each pair of dimensions.", "S", 0);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+PARAM_INT("threads", "Number of threads to use (0 means all available "
+    "cores).", "j", 1);
 PARAM_FLAG("objective", "If set, an estimate of the final objective function "
     "is printed.", "O");
 
@@ -75,6 +77,11 @@ int main(int argc, char* argv[])
   size_t nReplicates = CLI::GetParam<int>("replicates");
   size_t nAngles = CLI::GetParam<int>("angles");
   size_t nSweeps = CLI::GetParam<int>("sweeps");
+  const int threads = CLI::GetParam<int>("threads");
+
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
 
   if (nSweeps == 0)
   {
@@ -82,7 +89,8 @@ int main(int argc, char* argv[])
   }
 
   // Run RADICAL.
-  Radical rad(noiseStdDev, nReplicates, nAngles, nSweeps);
+  Radical rad(noiseStdDev, nReplicates, nAngles, nSweeps, 0,
+      (size_t) threads);
   mat matY;
   mat matW;
   rad.DoRadical(matX, matY, matW);
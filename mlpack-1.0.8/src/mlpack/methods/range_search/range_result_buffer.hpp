@@ -0,0 +1,95 @@
+/**
+ * @file range_result_buffer.hpp
+ *
+ * Flat storage for the results of a range search, used by the compressed
+ * sparse row output of RangeSearch::Search().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_RANGE_RESULT_BUFFER_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_RANGE_RESULT_BUFFER_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The results found by one thread during a range search, as a list of (query
+ * point, reference point, distance) triples in the order they were found.
+ * Appending a result only ever grows three arrays, so a whole search does a
+ * handful of allocations instead of several for every query point.  The
+ * buffers of all threads are gathered into compressed sparse row form once the
+ * search is done.
+ */
+class RangeResultBuffer
+{
+ public:
+  //! Add a result.
+  void Add(const size_t queryIndex,
+           const size_t referenceIndex,
+           const double distance)
+  {
+    queries.push_back(queryIndex);
+    references.push_back(referenceIndex);
+    distances.push_back(distance);
+  }
+
+  //! Make room for the given number of additional results.
+  void Reserve(const size_t extra)
+  {
+    // Growing geometrically keeps the cost of repeated calls amortized.
+    if (queries.size() + extra > queries.capacity())
+    {
+      const size_t capacity = std::max(queries.size() + extra,
+          2 * queries.capacity());
+      queries.reserve(capacity);
+      references.reserve(capacity);
+      distances.reserve(capacity);
+    }
+  }
+
+  //! Remove all results (the memory is kept).
+  void Clear()
+  {
+    queries.clear();
+    references.clear();
+    distances.clear();
+  }
+
+  //! Get the number of results.
+  size_t Size() const { return queries.size(); }
+
+  //! Get the query point of each result.
+  const std::vector<size_t>& Queries() const { return queries; }
+  //! Get the reference point of each result.
+  const std::vector<size_t>& References() const { return references; }
+  //! Get the distance of each result.
+  const std::vector<double>& Distances() const { return distances; }
+
+ private:
+  //! The query point of each result.
+  std::vector<size_t> queries;
+  //! The reference point of each result.
+  std::vector<size_t> references;
+  //! The distance of each result.
+  std::vector<double> distances;
+};
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
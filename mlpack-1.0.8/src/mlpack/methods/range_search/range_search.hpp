@@ -28,8 +28,11 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/parallel_dual_tree_traverser.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include "range_search_stat.hpp"
+#include "range_search_rules.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
@@ -191,6 +194,11 @@ class RangeSearch
    *
    * - neighbors[i] and distances[i] are not sorted in any particular order.
    *
+   * The statistics of the trees are reset with ResetStatistics() before the
+   * search, so Search() can be called any number of times, and a pre-built tree
+   * can be shared between several RangeSearch and NeighborSearch objects (as
+   * long as they do not search at the same time).
+   *
    * @param range Range of distances in which to search.
    * @param neighbors Object which will hold the list of neighbors for each
    *      point which fell into the given range, for each query point.
@@ -201,7 +209,257 @@ class RangeSearch
               std::vector<std::vector<size_t> >& neighbors,
               std::vector<std::vector<double> >& distances);
 
+  /**
+   * Search for all points in the given range, returning the results in
+   * compressed sparse row form: the neighbors of query point i are
+   * neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1], and their distances
+   * are the same entries of distances.  The results of each query point are
+   * not sorted in any particular order.
+   *
+   * Instead of growing a vector for each query point, each thread appends its
+   * results to one flat buffer, and the buffers are gathered once at the end;
+   * this avoids most of the memory allocation when there are many results.
+   * (An arma::sp_mat cannot be used here, because it cannot hold distances of
+   * zero.)
+   *
+   * @param range Range of distances in which to search.
+   * @param offsets Will be set to the start of the results of each query
+   *      point, followed by the total number of results.
+   * @param neighbors Will hold the indices of the reference points in range.
+   * @param distances Will hold the distances of the reference points in range.
+   */
+  void Search(const math::Range& range,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  /**
+   * Count the points in the given range for each query point, without storing
+   * them.  When a whole reference node is inside the range, all of its points
+   * are counted at once, so much fewer distances are calculated than by
+   * Search().
+   *
+   * @param range Range of distances in which to search.
+   * @param counts Will be set to the number of reference points in range of
+   *      each query point.
+   */
+  void Count(const math::Range& range, arma::Col<size_t>& counts);
+
+  /**
+   * Search for all points in the given range, and hand each result to the
+   * given visitor as soon as it is found instead of storing it, so the memory
+   * used does not depend on the number of results.  The visitor is called as
+   *
+   * @code
+   * visitor(queryIndex, referenceIndex, distance);
+   * @endcode
+   *
+   * in no particular order.  The indices are mapped back to the original
+   * datasets if this object built the trees.  With more than one thread (see
+   * Threads()), the visitor is called from several threads at once, so it must
+   * be safe to do so.
+   *
+   * @param range Range of distances in which to search.
+   * @param visitor Visitor to call with each result.
+   */
+  template<typename VisitorType>
+  void Search(const math::Range& range, VisitorType& visitor);
+
+  /**
+   * Count the points in each of several ranges for each query point, with one
+   * traversal of the trees for the smallest range which encloses all of them,
+   * instead of one traversal for each range.  This is much faster than calling
+   * Count() for each range when the ranges overlap, such as when a density
+   * estimate or a parameter of DBSCAN is swept over several radii; but every
+   * distance in the enclosing range is calculated, where Count() can count
+   * whole nodes at once.
+   *
+   * @param ranges Ranges of distances to count the points in.
+   * @param counts Will be set to the number of reference points in each range
+   *      (rows) of each query point (columns).
+   */
+  void Count(const std::vector<math::Range>& ranges,
+             arma::Mat<size_t>& counts);
+
+  /**
+   * Search for all points in each of several ranges, with one traversal of the
+   * trees for the smallest range which encloses all of them, and return the
+   * results binned by range, in compressed sparse row form: the neighbors of
+   * query point i in ranges[r] are neighbors[offsets[i * ranges.size() + r]]
+   * to neighbors[offsets[i * ranges.size() + r + 1] - 1].  A point in several
+   * of the ranges appears once for each of them.
+   *
+   * @param ranges Ranges of distances in which to search.
+   * @param offsets Will be set to the start of the results of each query point
+   *      and range, followed by the total number of results.
+   * @param neighbors Will hold the indices of the reference points in range.
+   * @param distances Will hold the distances of the reference points in range.
+   */
+  void Search(const std::vector<math::Range>& ranges,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  /**
+   * Count the points within a different radius of each query point: the
+   * points at a distance of at most radii[i] from query point i.  The trees are
+   * traversed once, pruned with the largest radius.
+   *
+   * @param radii Radius of each query point.
+   * @param counts Will be set to the number of reference points within the
+   *      radius of each query point.
+   */
+  void Count(const arma::vec& radii, arma::Col<size_t>& counts);
+
+  /**
+   * Search for the points within a different radius of each query point (see
+   * Count(const arma::vec&, arma::Col<size_t>&)), returning the results in the
+   * same compressed sparse row form as Search(const math::Range&,
+   * arma::Col<size_t>&, arma::Col<size_t>&, arma::vec&).
+   *
+   * @param radii Radius of each query point.
+   * @param offsets Will be set to the start of the results of each query
+   *      point, followed by the total number of results.
+   * @param neighbors Will hold the indices of the reference points in range.
+   * @param distances Will hold the distances of the reference points in range.
+   */
+  void Search(const arma::vec& radii,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  //! Get the number of threads used for tree-based search.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for tree-based search (1 is serial, 0
+  //! means all available cores).  In single-tree mode the query points are
+  //! split between threads; for dual-tree search, see
+  //! tree::ParallelDualTreeTraverser.
+  size_t& Threads() { return threads; }
+
+  //! Get the monitor which observes the searches (NULL if there is none).
+  ProgressMonitor* Monitor() const { return monitor; }
+  //! Modify the monitor which observes the searches.  It is called after each
+  //! batch of query points (each subtree of the query tree, in dual-tree mode)
+  //! with the fraction of query points searched, and can stop the search
+  //! early; the query points which were not searched then have no results
+  //! (see ProgressMonitor).
+  ProgressMonitor*& Monitor() { return monitor; }
+
  private:
+  /**
+   * A visitor which maps the indices of the trees back to the original
+   * datasets before handing each result to another visitor.
+   */
+  template<typename VisitorType>
+  class MappedVisitor
+  {
+   public:
+    //! Wrap the given visitor; NULL mappings leave the indices unchanged.
+    MappedVisitor(VisitorType& visitor,
+                  const std::vector<size_t>* queryMap,
+                  const std::vector<size_t>* referenceMap) :
+        visitor(visitor), queryMap(queryMap), referenceMap(referenceMap) { }
+
+    //! Map the indices and hand the result on.
+    void operator()(const size_t queryIndex,
+                    const size_t referenceIndex,
+                    const double distance)
+    {
+      visitor(queryMap ? (*queryMap)[queryIndex] : queryIndex,
+          referenceMap ? (*referenceMap)[referenceIndex] : referenceIndex,
+          distance);
+    }
+
+   private:
+    //! The wrapped visitor.
+    VisitorType& visitor;
+    //! The mapping of query indices (or NULL).
+    const std::vector<size_t>* queryMap;
+    //! The mapping of reference indices (or NULL).
+    const std::vector<size_t>* referenceMap;
+  };
+
+  /**
+   * A visitor which counts the results of each query point in each of several
+   * ranges.  Each query point is searched by one thread only, so several
+   * threads can use it at once.
+   */
+  class MultiRangeCounter
+  {
+   public:
+    //! Count into the given matrix (one row for each range).
+    MultiRangeCounter(const std::vector<math::Range>& ranges,
+                      arma::Mat<size_t>& counts) :
+        ranges(ranges), counts(counts) { }
+
+    //! Count the result in each range that contains it.
+    void operator()(const size_t queryIndex,
+                    const size_t /* referenceIndex */,
+                    const double distance)
+    {
+      for (size_t r = 0; r < ranges.size(); ++r)
+        if (ranges[r].Contains(distance))
+          ++counts(r, queryIndex);
+    }
+
+   private:
+    //! The ranges.
+    const std::vector<math::Range>& ranges;
+    //! The counts of each query point in each range.
+    arma::Mat<size_t>& counts;
+  };
+
+  /**
+   * A visitor which counts the results within the radius of each query point.
+   * As with MultiRangeCounter, several threads can use it at once.
+   */
+  class RadiusCounter
+  {
+   public:
+    //! Count into the given vector.
+    RadiusCounter(const arma::vec& radii, arma::Col<size_t>& counts) :
+        radii(radii), counts(counts) { }
+
+    //! Count the result if it is within the radius of its query point.
+    void operator()(const size_t queryIndex,
+                    const size_t /* referenceIndex */,
+                    const double distance)
+    {
+      if (distance <= radii[queryIndex])
+        ++counts[queryIndex];
+    }
+
+   private:
+    //! The radius of each query point.
+    const arma::vec& radii;
+    //! The count of each query point.
+    arma::Col<size_t>& counts;
+  };
+
+  //! Return the smallest range which encloses all of the given ranges.
+  static math::Range EnclosingRange(const std::vector<math::Range>& ranges);
+
+  //! Return the range from 0 to the largest of the given radii, after checking
+  //! that there is one radius for each query point.
+  math::Range RadiiRange(const arma::vec& radii) const;
+
+  /**
+   * Clear the statistics of the trees and traverse them with the given rules,
+   * using the given number of threads.
+   */
+  template<typename RuleType>
+  void Traverse(RuleType& rules, const size_t numThreads);
+
+  //! Return the number of threads the traversal will use.
+  size_t NumThreads() const;
+
+  /**
+   * Get the mappings from the indices of the trees back to the original
+   * datasets; either is NULL if no mapping is needed.
+   */
+  void Mappings(const std::vector<size_t>*& queryMap,
+                const std::vector<size_t>*& referenceMap) const;
+
   //! Copy of reference matrix; used when a tree is built internally.
   typename TreeType::Mat referenceCopy;
   //! Copy of query matrix; used when a tree is built internally.
@@ -238,6 +496,12 @@ class RangeSearch
 
   //! The number of pruned nodes during computation.
   size_t numPrunes;
+
+  //! Number of threads to use for tree-based search.
+  size_t threads;
+
+  //! Monitor of the progress of the searches (may be NULL).
+  ProgressMonitor* monitor;
 };
 
 }; // namespace range
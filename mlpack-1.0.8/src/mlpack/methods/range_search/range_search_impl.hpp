@@ -25,8 +25,11 @@
 // Just in case it hasn't been included.
 #include "range_search.hpp"
 
-// The rules for traversal.
-#include "range_search_rules.hpp"
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace range {
@@ -48,7 +51,9 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(naive),
     singleMode(!naive && singleMode), // Naive overrides single mode.
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    threads(1),
+    monitor(NULL)
 {
   // Build the trees.
   Timer::Start("range_search/tree_building");
@@ -60,6 +65,10 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
   queryTree = new TreeType(queryCopy, oldFromNewQueries,
       (naive ? queryCopy.n_cols : leafSize));
 
+  // A periodic metric sets the box of the bounds of the trees.
+  bound::SetTreeMetric(*referenceTree, metric);
+  bound::SetTreeMetric(*queryTree, metric);
+
   Timer::Stop("range_search/tree_building");
 }
 
@@ -79,7 +88,9 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(naive),
     singleMode(!naive && singleMode), // Naive overrides single mode.
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    threads(1),
+    monitor(NULL)
 {
   // Build the trees.
   Timer::Start("range_search/tree_building");
@@ -87,6 +98,7 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
   // Naive sets the leaf size such that the entire tree is one node.
   referenceTree = new TreeType(referenceCopy, oldFromNewReferences,
       (naive ? referenceCopy.n_cols : leafSize));
+  bound::SetTreeMetric(*referenceTree, metric);
 
   // If using dual-tree mode, then we need a second tree.
   if (!singleMode)
@@ -112,7 +124,9 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    threads(1),
+    monitor(NULL)
 {
   // Nothing else to initialize.
 }
@@ -132,7 +146,9 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    threads(1),
+    monitor(NULL)
 {
   // If doing dual-tree range search, we must clone the reference tree.
   if (!singleMode)
@@ -163,9 +179,6 @@ void RangeSearch<MetricType, TreeType>::Search(
 {
   Timer::Start("range_search/computing_neighbors");
 
-  // Set size of prunes to 0.
-  numPrunes = 0;
-
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
   // To avoid extra copies, we will store the unmapped neighbors and distances
@@ -184,38 +197,16 @@ void RangeSearch<MetricType, TreeType>::Search(
   distancePtr->clear();
   distancePtr->resize(querySet.n_cols);
 
-  // Create the helper object for the traversal.
-  typedef RangeSearchRules<MetricType, TreeType> RuleType;
-  RuleType rules(referenceSet, querySet, range, *neighborPtr, *distancePtr,
-      metric);
-
-  if (singleMode)
-  {
-    // Create the traverser.
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    numPrunes = traverser.NumPrunes();
-  }
-  else // Dual-tree recursion.
-  {
-    // Create the traverser.
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
-
-    numPrunes = traverser.NumPrunes();
-  }
+  // Create the helper object for the traversal.  Each query point has its own
+  // result vectors, so threads working on different query points do not
+  // interfere.
+  typedef RangeSearchRules<MetricType, TreeType> BaseRuleType;
+  typename tree::TraversalRules<BaseRuleType>::Type rules(BaseRuleType(
+      referenceSet, querySet, range, *neighborPtr, *distancePtr, metric));
+  Traverse(rules, NumThreads());
 
   Timer::Stop("range_search/computing_neighbors");
 
-  // Output number of prunes.
-  Log::Info << "Number of pruned nodes during computation: " << numPrunes
-      << "." << std::endl;
-
   // Map points back to original indices, if necessary.
   if (!treeOwner)
   {
@@ -292,6 +283,361 @@ void RangeSearch<MetricType, TreeType>::Search(
   }
 }
 
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Search(
+    const math::Range& range,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // Each thread appends its results to its own buffer.
+  const size_t numThreads = NumThreads();
+  std::vector<RangeResultBuffer> buffers(numThreads);
+  typedef RangeSearchRules<MetricType, TreeType> BaseRuleType;
+  typename tree::TraversalRules<BaseRuleType>::Type rules(BaseRuleType(
+      referenceSet, querySet, range, buffers, metric));
+  Traverse(rules, numThreads);
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  // If we built the trees ourselves, the results are mapped back to the
+  // original indices while they are gathered.
+  const std::vector<size_t>* queryMap;
+  const std::vector<size_t>* referenceMap;
+  Mappings(queryMap, referenceMap);
+
+  // Count the results of each query point, and turn the counts into offsets.
+  offsets.zeros(querySet.n_cols + 1);
+  for (size_t t = 0; t < buffers.size(); ++t)
+  {
+    const std::vector<size_t>& queries = buffers[t].Queries();
+    for (size_t j = 0; j < queries.size(); ++j)
+      ++offsets[(queryMap ? (*queryMap)[queries[j]] : queries[j]) + 1];
+  }
+
+  for (size_t i = 1; i < offsets.n_elem; ++i)
+    offsets[i] += offsets[i - 1];
+
+  // Now copy the results into place.
+  neighbors.set_size(offsets[querySet.n_cols]);
+  distances.set_size(offsets[querySet.n_cols]);
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < buffers.size(); ++t)
+  {
+    const std::vector<size_t>& queries = buffers[t].Queries();
+    const std::vector<size_t>& references = buffers[t].References();
+    const std::vector<double>& bufferDistances = buffers[t].Distances();
+    for (size_t j = 0; j < queries.size(); ++j)
+    {
+      const size_t query = (queryMap ? (*queryMap)[queries[j]] : queries[j]);
+      const size_t position = next[query]++;
+      neighbors[position] = (referenceMap ? (*referenceMap)[references[j]] :
+          references[j]);
+      distances[position] = bufferDistances[j];
+    }
+  }
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Count(const math::Range& range,
+                                              arma::Col<size_t>& counts)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // Each query point has its own count, so threads do not interfere.
+  arma::Col<size_t> treeCounts;
+  treeCounts.zeros(querySet.n_cols);
+  typedef RangeSearchRules<MetricType, TreeType> BaseRuleType;
+  typename tree::TraversalRules<BaseRuleType>::Type rules(BaseRuleType(
+      referenceSet, querySet, range, treeCounts, metric));
+  Traverse(rules, NumThreads());
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  const std::vector<size_t>* queryMap;
+  const std::vector<size_t>* referenceMap;
+  Mappings(queryMap, referenceMap);
+
+  if (queryMap == NULL)
+  {
+    counts.swap(treeCounts);
+  }
+  else
+  {
+    counts.set_size(querySet.n_cols);
+    for (size_t i = 0; i < treeCounts.n_elem; ++i)
+      counts[(*queryMap)[i]] = treeCounts[i];
+  }
+}
+
+template<typename MetricType, typename TreeType>
+template<typename VisitorType>
+void RangeSearch<MetricType, TreeType>::Search(const math::Range& range,
+                                               VisitorType& visitor)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  const std::vector<size_t>* queryMap;
+  const std::vector<size_t>* referenceMap;
+  Mappings(queryMap, referenceMap);
+
+  MappedVisitor<VisitorType> mappedVisitor(visitor, queryMap, referenceMap);
+  typedef RangeSearchRules<MetricType, TreeType, MappedVisitor<VisitorType> >
+      BaseRuleType;
+  typename tree::TraversalRules<BaseRuleType>::Type rules(BaseRuleType(
+      referenceSet, querySet, range, mappedVisitor, metric));
+  Traverse(rules, NumThreads());
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Count(
+    const std::vector<math::Range>& ranges,
+    arma::Mat<size_t>& counts)
+{
+  counts.zeros(ranges.size(), querySet.n_cols);
+  MultiRangeCounter counter(ranges, counts);
+  Search(EnclosingRange(ranges), counter);
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Search(
+    const std::vector<math::Range>& ranges,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  // Search once for the enclosing range, then bin the results.
+  arma::Col<size_t> allOffsets;
+  arma::Col<size_t> allNeighbors;
+  arma::vec allDistances;
+  Search(EnclosingRange(ranges), allOffsets, allNeighbors, allDistances);
+
+  const size_t numRanges = ranges.size();
+  offsets.zeros(querySet.n_cols * numRanges + 1);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+    for (size_t j = allOffsets[i]; j < allOffsets[i + 1]; ++j)
+      for (size_t r = 0; r < numRanges; ++r)
+        if (ranges[r].Contains(allDistances[j]))
+          ++offsets[i * numRanges + r + 1];
+
+  for (size_t i = 1; i < offsets.n_elem; ++i)
+    offsets[i] += offsets[i - 1];
+
+  neighbors.set_size(offsets[offsets.n_elem - 1]);
+  distances.set_size(offsets[offsets.n_elem - 1]);
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    for (size_t j = allOffsets[i]; j < allOffsets[i + 1]; ++j)
+    {
+      for (size_t r = 0; r < numRanges; ++r)
+      {
+        if (ranges[r].Contains(allDistances[j]))
+        {
+          const size_t position = next[i * numRanges + r]++;
+          neighbors[position] = allNeighbors[j];
+          distances[position] = allDistances[j];
+        }
+      }
+    }
+  }
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Count(const arma::vec& radii,
+                                              arma::Col<size_t>& counts)
+{
+  const math::Range range = RadiiRange(radii);
+
+  counts.zeros(querySet.n_cols);
+  RadiusCounter counter(radii, counts);
+  Search(range, counter);
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Search(const arma::vec& radii,
+                                               arma::Col<size_t>& offsets,
+                                               arma::Col<size_t>& neighbors,
+                                               arma::vec& distances)
+{
+  // Search once with the largest radius, then drop the results outside the
+  // radius of their query point, in place.
+  Search(RadiiRange(radii), offsets, neighbors, distances);
+
+  size_t kept = 0;
+  size_t start = offsets[0];
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    const size_t end = offsets[i + 1];
+    offsets[i] = kept;
+    for (size_t j = start; j < end; ++j)
+    {
+      if (distances[j] <= radii[i])
+      {
+        neighbors[kept] = neighbors[j];
+        distances[kept] = distances[j];
+        ++kept;
+      }
+    }
+    start = end;
+  }
+  offsets[querySet.n_cols] = kept;
+
+  neighbors.resize(kept);
+  distances.resize(kept);
+}
+
+template<typename MetricType, typename TreeType>
+math::Range RangeSearch<MetricType, TreeType>::EnclosingRange(
+    const std::vector<math::Range>& ranges)
+{
+  if (ranges.empty())
+    Log::Fatal << "RangeSearch: no ranges were given." << std::endl;
+
+  math::Range enclosing = ranges[0];
+  for (size_t r = 1; r < ranges.size(); ++r)
+    enclosing |= ranges[r];
+
+  return enclosing;
+}
+
+template<typename MetricType, typename TreeType>
+math::Range RangeSearch<MetricType, TreeType>::RadiiRange(
+    const arma::vec& radii) const
+{
+  if (radii.n_elem != querySet.n_cols)
+    Log::Fatal << "RangeSearch: " << radii.n_elem << " radii were given for "
+        << querySet.n_cols << " query points." << std::endl;
+
+  return math::Range(0.0, (radii.n_elem == 0) ? 0.0 : radii.max());
+}
+
+template<typename MetricType, typename TreeType>
+template<typename RuleType>
+void RangeSearch<MetricType, TreeType>::Traverse(RuleType& rules,
+                                                 const size_t numThreads)
+{
+  // Set size of prunes to 0.
+  numPrunes = 0;
+
+  // Clear the distances cached in the statistics by an earlier search, which
+  // may have been run by another object sharing the trees.
+  referenceTree->ResetStatistics();
+  if (queryTree)
+    queryTree->ResetStatistics();
+
+  tree::TraversalStatistics::Start();
+
+  if (singleMode)
+  {
+    size_t prunes = 0;
+
+    // The query points are handed out in batches, after each of which the
+    // monitor (if any) is called.
+    const size_t batchSize = 64;
+    const size_t batches = (querySet.n_cols + batchSize - 1) / batchSize;
+    size_t batchesDone = 0;
+
+    #pragma omp parallel num_threads(numThreads) reduction(+:prunes)
+    {
+      // Create the traverser.
+      RuleType threadRules(rules);
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+      // Now have it traverse for each point.
+      #pragma omp for schedule(dynamic, 1)
+      for (int b = 0; b < (int) batches; ++b)
+      {
+        // Once the monitor has stopped the search, skip the other batches.
+        if (monitor)
+        {
+          bool stopped;
+          #pragma omp critical(progress_monitor)
+          stopped = monitor->Stopped();
+          if (stopped)
+            continue;
+        }
+
+        const size_t end = std::min((b + 1) * batchSize,
+            (size_t) querySet.n_cols);
+        for (size_t i = b * batchSize; i < end; ++i)
+          traverser.Traverse(i, *referenceTree);
+
+        if (monitor)
+        {
+          #pragma omp critical(progress_monitor)
+          {
+            ++batchesDone;
+            monitor->Continue("RangeSearch::Search()", batchesDone,
+                (double) batchesDone / batches);
+          }
+        }
+      }
+
+      prunes += traverser.NumPrunes();
+    }
+
+    numPrunes = prunes;
+  }
+  else // Dual-tree recursion.
+  {
+    // Create the traverser.  With more than one thread, disjoint subtrees of
+    // the query tree are traversed in parallel.
+    tree::ParallelDualTreeTraverser<TreeType, RuleType> traverser(rules,
+        numThreads, monitor, "RangeSearch::Search()");
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    numPrunes = traverser.NumPrunes();
+  }
+
+  tree::TraversalStatistics::Stop();
+
+  // Output number of prunes.
+  Log::Info << "Number of pruned nodes during computation: " << numPrunes
+      << "." << std::endl;
+
+  if (monitor && monitor->Stopped())
+    Log::Info << "RangeSearch::Search(): stopped by the monitor; some query "
+        << "points were not searched." << std::endl;
+}
+
+template<typename MetricType, typename TreeType>
+size_t RangeSearch<MetricType, TreeType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  // Rules for trees that cache base cases in the reference nodes cannot be
+  // used by several threads at once (see tree::ParallelDualTreeTraverser).
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid ||
+      tree::TreeTraits<TreeType>::HasSelfChildren)
+    numThreads = 1;
+
+  return numThreads;
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Mappings(
+    const std::vector<size_t>*& queryMap,
+    const std::vector<size_t>*& referenceMap) const
+{
+  queryMap = NULL;
+  referenceMap = NULL;
+
+  // Building the trees reordered both datasets (a query tree is built even
+  // for single-tree search).
+  if (treeOwner)
+  {
+    referenceMap = &oldFromNewReferences;
+    queryMap = hasQuerySet ? &oldFromNewQueries : &oldFromNewReferences;
+  }
+}
+
 }; // namespace range
 }; // namespace mlpack
 
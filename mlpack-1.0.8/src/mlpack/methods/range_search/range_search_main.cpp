@@ -23,15 +23,244 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metrics/periodic_lmetric.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/tree_tuner.hpp>
+
+#include <algorithm>
+#include <sstream>
 
 #include "range_search.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::range;
 using namespace mlpack::tree;
 
+/**
+ * Write the results for each query point to the stream as one line of
+ * comma-separated values.  The lines are formatted in parallel, a block of
+ * points at a time, and each block is written with one call.
+ */
+template<typename T>
+void WriteResults(ostream& stream,
+                  const vector<vector<T> >& results,
+                  const int threads)
+{
+  const int numThreads = (int) Threads::Count((size_t) threads);
+
+  const size_t blockSize = 4096;
+  vector<string> lines(std::min(blockSize, results.size()));
+  for (size_t first = 0; first < results.size(); first += blockSize)
+  {
+    const size_t count = std::min(blockSize, results.size() - first);
+
+    #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+    for (int i = 0; i < (int) count; ++i)
+    {
+      // We may have 0 points to store, so the line may be empty.
+      const vector<T>& result = results[first + i];
+      string& line = lines[i];
+      line.clear();
+      for (size_t j = 0; j < result.size(); ++j)
+      {
+        if (j > 0)
+          line.append(", ");
+        data::AppendTextNumber(result[j], line);
+      }
+      line.push_back('\n');
+    }
+
+    string block;
+    for (size_t i = 0; i < count; ++i)
+      block.append(lines[i]);
+    stream.write(block.data(), block.size());
+  }
+}
+
+//! Save the results for each query point as one line of comma-separated values
+//! (see WriteResults()).
+template<typename T>
+void SaveResults(const string& filename,
+                 const vector<vector<T> >& results,
+                 const string& description,
+                 const int threads)
+{
+  fstream stream(filename.c_str(), fstream::out | fstream::binary);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to save output "
+        << description << " to!" << endl;
+    return;
+  }
+
+  WriteResults(stream, results, threads);
+}
+
+/**
+ * Read the box given with --periodic_box: either one size, which is used for
+ * every dimension, or a comma-separated list with a size for each dimension.
+ */
+arma::vec PeriodicBox(const string& sizes, const size_t dimensionality)
+{
+  string list(sizes);
+  replace(list.begin(), list.end(), ',', ' ');
+
+  istringstream stream(list);
+  vector<double> values;
+  double value;
+  while (stream >> value)
+    values.push_back(value);
+
+  if (!stream.eof() || values.empty())
+    Log::Fatal << "Invalid periodic box '" << sizes << "'; must be a "
+        << "comma-separated list of box sizes." << endl;
+
+  if (values.size() != 1 && values.size() != dimensionality)
+    Log::Fatal << "Invalid periodic box '" << sizes << "'; must have one size "
+        << "or " << dimensionality << " sizes (one for each dimension)."
+        << endl;
+
+  arma::vec box(dimensionality);
+  for (size_t i = 0; i < dimensionality; ++i)
+  {
+    box[i] = values[(values.size() == 1) ? 0 : i];
+    if (box[i] < 0.0)
+      Log::Fatal << "Invalid periodic box '" << sizes << "'; sizes must be "
+          << "greater than or equal to 0." << endl;
+  }
+
+  return box;
+}
+
+/**
+ * Perform range search with a binary space tree of the given type (a kd-tree,
+ * a ball tree, or a periodic kd-tree) and the given metric, and map the
+ * results back to the original order of the points.
+ */
+template<typename TreeType, typename MetricType>
+void BinarySpaceTreeSearch(arma::mat& referenceData,
+                           arma::mat& queryData,
+                           size_t leafSize,
+                           const bool naive,
+                           const bool singleMode,
+                           const int threads,
+                           const math::Range& r,
+                           const MetricType& metric,
+                           vector<vector<size_t> >& neighbors,
+                           vector<vector<double> >& distances)
+{
+  typedef RangeSearch<MetricType, TreeType> SearchType;
+
+  // Because we may construct it differently, we need a pointer.
+  SearchType* rangeSearch = NULL;
+
+  // Mappings for when we build the tree.
+  vector<size_t> oldFromNewRefs;
+
+  // Build trees by hand, so we can save memory: if we pass a tree to
+  // NeighborSearch, it does not copy the matrix.
+  Log::Info << "Building reference tree..." << endl;
+  Timer::Start("tree_building");
+
+  TreeType refTree(referenceData, oldFromNewRefs, leafSize);
+  bound::SetTreeMetric(refTree, metric);
+  TreeType* queryTree = NULL; // Empty for now.
+
+  Timer::Stop("tree_building");
+
+  vector<size_t> oldFromNewQueries;
+
+  if (queryData.n_cols > 0)
+  {
+    if (naive && leafSize < queryData.n_cols)
+      leafSize = queryData.n_cols;
+
+    Log::Info << "Building query tree..." << endl;
+
+    // Build trees by hand, so we can save memory: if we pass a tree to
+    // NeighborSearch, it does not copy the matrix.
+    Timer::Start("tree_building");
+
+    queryTree = new TreeType(queryData, oldFromNewQueries, leafSize);
+    bound::SetTreeMetric(*queryTree, metric);
+
+    Timer::Stop("tree_building");
+
+    rangeSearch = new SearchType(&refTree, queryTree, referenceData, queryData,
+        singleMode, metric);
+
+    Log::Info << "Tree built." << endl;
+  }
+  else
+  {
+    rangeSearch = new SearchType(&refTree, referenceData, singleMode, metric);
+
+    Log::Info << "Trees built." << endl;
+  }
+
+  Log::Info << "Computing neighbors within range [" << r.Lo() << ", "
+      << r.Hi() << "]." << endl;
+
+  // Collect the results in these vectors before remapping.
+  vector<vector<double> > distancesOut;
+  vector<vector<size_t> > neighborsOut;
+
+  rangeSearch->Threads() = (size_t) threads;
+  rangeSearch->Search(r, neighborsOut, distancesOut);
+
+  Log::Info << "Neighbors computed." << endl;
+
+  // We have to map back to the original indices from before the tree
+  // construction.
+  Log::Info << "Re-mapping indices..." << endl;
+
+  distances.resize(distancesOut.size());
+  neighbors.resize(neighborsOut.size());
+
+  // Do the actual remapping.
+  if (queryTree != NULL)
+  {
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+      // Map distances (copy a column).
+      distances[oldFromNewQueries[i]] = distancesOut[i];
+
+      // Map indices of neighbors.
+      neighbors[oldFromNewQueries[i]].resize(neighborsOut[i].size());
+      for (size_t j = 0; j < distancesOut[i].size(); ++j)
+      {
+        neighbors[oldFromNewQueries[i]][j] =
+            oldFromNewRefs[neighborsOut[i][j]];
+      }
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+      // Map distances (copy a column).
+      distances[oldFromNewRefs[i]] = distancesOut[i];
+
+      // Map indices of neighbors.
+      neighbors[oldFromNewRefs[i]].resize(neighborsOut[i].size());
+      for (size_t j = 0; j < distancesOut[i].size(); ++j)
+      {
+        neighbors[oldFromNewRefs[i]][j] = oldFromNewRefs[neighborsOut[i][j]];
+      }
+    }
+  }
+
+  // Clean up.
+  if (queryTree)
+    delete queryTree;
+  delete rangeSearch;
+}
+
 // Information about the program itself.
 PROGRAM_INFO("Range Search",
     "This program implements range search with a Euclidean distance metric. "
@@ -42,7 +271,10 @@ PROGRAM_INFO("Range Search",
     " points, or only a reference set -- which is then used as both the "
     "reference and query set.  The given range is taken to be inclusive (that "
     "is, points with a distance exactly equal to the minimum and maximum of the"
-    " range are included in the results)."
+    " range are included in the results).  For points in a box with periodic "
+    "boundaries (such as a simulation box), give the size of the box with "
+    "--periodic_box; distances are then taken to the nearest periodic image of "
+    "each point."
     "\n\n"
     "For example, the following will calculate the points within the range [2, "
     "5] of each point in 'input.csv' and store the distances in 'distances.csv'"
@@ -60,7 +292,20 @@ PROGRAM_INFO("Range Search",
     " resultant CSV-like files may not be loadable by many programs.  However, "
     "at this time a better way to store this non-square result is not known.  "
     "As a result, any output files will be written as CSVs in this manner, "
-    "regardless of the given extension.");
+    "regardless of the given extension."
+    "\n\n"
+    "With --auto_tune (-A), the tree type and leaf size are chosen from a "
+    "quick profile of the reference set: on a sample of --tune_samples points, "
+    "the intrinsic dimensionality is estimated, and short range searches are "
+    "timed with kd-trees of a few leaf sizes and with cover trees; the fastest "
+    "is used for the whole search.  This overrides --leaf_size and "
+    "--cover_tree."
+    "\n\n"
+    "For query sets too large for memory, --query_chunk (-C) reads the query "
+    "set in chunks of the given number of points: each chunk is searched with "
+    "kd-trees while the next is read and the results of the previous one are "
+    "written, so only two chunks of queries and results are in memory at a "
+    "time.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -79,11 +324,150 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
 PARAM_FLAG("cover_tree", "If true, use a cover tree for range searching "
     "(instead of a kd-tree).", "c");
-
-typedef RangeSearch<> RSType;
+PARAM_FLAG("ball_tree", "If true, use a ball tree for range searching "
+    "(instead of a kd-tree).", "b");
+PARAM_STRING("periodic_box", "If specified, the points lie in a box with "
+    "periodic boundaries of this size: either one size for every dimension, or "
+    "a comma-separated list of sizes, one for each dimension (0 for a dimension "
+    "which is not periodic).  Periodic kd-trees are used for the search.", "P",
+    "");
+PARAM_INT("threads", "Number of threads to use for kd-tree search (0 uses all "
+    "available cores).  This only has an effect if MLPACK was built with "
+    "OpenMP.", "j", 1);
+PARAM_FLAG("auto_tune", "If true, choose the tree type (kd-tree or cover tree) "
+    "and the leaf size by timing range searches on a sample of the reference "
+    "set.", "A");
+PARAM_INT("tune_samples", "Number of reference points the searches of "
+    "--auto_tune are timed on.", "T", 2000);
+PARAM_INT("query_chunk", "If nonzero, read and search the query set in chunks "
+    "of this many points, overlapping reading, searching and writing.", "C",
+    0);
+
+typedef BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat> KDTreeType;
 typedef CoverTree<metric::EuclideanDistance, tree::FirstPointIsRoot,
     RangeSearchStat> CoverTreeType;
 typedef RangeSearch<metric::EuclideanDistance, CoverTreeType> RSCoverType;
+typedef BinarySpaceTree<bound::BallBound<>, RangeSearchStat> BallTreeType;
+typedef BinarySpaceTree<bound::PeriodicHRectBound<2>, RangeSearchStat>
+    PeriodicTreeType;
+
+/**
+ * The stages of the search of a query set read in chunks (see
+ * data::ChunkReader::Pipeline()): a kd-tree is built on each chunk of queries
+ * and searched against the reference tree, and the results are appended to the
+ * output files.
+ */
+class RangeChunkSearch
+{
+ public:
+  RangeChunkSearch(KDTreeType& referenceTree,
+                   const arma::mat& referenceData,
+                   const vector<size_t>& oldFromNewRefs,
+                   const math::Range& range,
+                   const size_t leafSize,
+                   const bool singleMode,
+                   const int threads,
+                   ostream& neighborsStream,
+                   ostream& distancesStream) :
+      referenceTree(referenceTree),
+      referenceData(referenceData),
+      oldFromNewRefs(oldFromNewRefs),
+      range(range),
+      leafSize(leafSize),
+      singleMode(singleMode),
+      threads(threads),
+      neighborsStream(neighborsStream),
+      distancesStream(distancesStream)
+  { }
+
+  //! Search the given chunk of queries, keeping the results in the slot.
+  void Process(const arma::mat& chunk,
+               const size_t /* firstPoint */,
+               const size_t slot)
+  {
+    // The query tree reorders its points, so it is built on a copy.
+    arma::mat queries(chunk);
+    vector<size_t> oldFromNewQueries;
+    KDTreeType queryTree(queries, oldFromNewQueries, leafSize);
+
+    RangeSearch<metric::EuclideanDistance, KDTreeType> search(&referenceTree,
+        &queryTree, referenceData, queries, singleMode);
+    search.Threads() = (size_t) threads;
+
+    vector<vector<size_t> > neighborsOut;
+    vector<vector<double> > distancesOut;
+    search.Search(range, neighborsOut, distancesOut);
+
+    neighbors[slot].resize(neighborsOut.size());
+    distances[slot].resize(distancesOut.size());
+    for (size_t i = 0; i < neighborsOut.size(); ++i)
+    {
+      distances[slot][oldFromNewQueries[i]].swap(distancesOut[i]);
+
+      vector<size_t>& result = neighbors[slot][oldFromNewQueries[i]];
+      result.resize(neighborsOut[i].size());
+      for (size_t j = 0; j < neighborsOut[i].size(); ++j)
+        result[j] = oldFromNewRefs[neighborsOut[i][j]];
+    }
+  }
+
+  //! Append the results in the slot to the output files.
+  void Output(const size_t slot)
+  {
+    WriteResults(neighborsStream, neighbors[slot], threads);
+    WriteResults(distancesStream, distances[slot], threads);
+    neighbors[slot].clear();
+    distances[slot].clear();
+  }
+
+ private:
+  KDTreeType& referenceTree;
+  const arma::mat& referenceData;
+  const vector<size_t>& oldFromNewRefs;
+  math::Range range;
+  size_t leafSize;
+  bool singleMode;
+  int threads;
+  ostream& neighborsStream;
+  ostream& distancesStream;
+
+  //! The results of the chunk being searched and of the chunk being written.
+  vector<vector<size_t> > neighbors[2];
+  vector<vector<double> > distances[2];
+};
+
+/**
+ * The search TreeTuner times with --auto_tune: find the points of the sample
+ * in the range of every point of the sample, with kd-trees or cover trees.
+ */
+struct RangeProbe
+{
+  RangeProbe(const math::Range& range, const bool singleMode) :
+      range(range), singleMode(singleMode) { }
+
+  void operator()(arma::mat& sample, const TreeConfiguration& configuration)
+  {
+    vector<vector<size_t> > neighbors;
+    vector<vector<double> > distances;
+    if (configuration.coverTree)
+    {
+      CoverTreeType tree(sample);
+      RSCoverType search(&tree, sample, singleMode);
+      search.Search(range, neighbors, distances);
+    }
+    else
+    {
+      vector<size_t> oldFromNew;
+      KDTreeType tree(sample, oldFromNew, configuration.leafSize);
+      RangeSearch<metric::EuclideanDistance, KDTreeType> search(&tree, sample,
+          singleMode);
+      search.Search(range, neighbors, distances);
+    }
+  }
+
+  math::Range range;
+  bool singleMode;
+};
 
 int main(int argc, char *argv[])
 {
@@ -104,11 +488,19 @@ int main(int argc, char *argv[])
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
   bool coverTree = CLI::HasParam("cover_tree");
-
-  arma::mat referenceData;
+  bool ballTree = CLI::HasParam("ball_tree");
+  const string periodicBox = CLI::GetParam<string>("periodic_box");
+  const bool autoTune = CLI::HasParam("auto_tune");
+  const int queryChunk = CLI::GetParam<int>("query_chunk");
+  const string queryFile = CLI::GetParam<string>("query_file");
+
+  // A reference set in the mlpack binary format (.mbin) is memory-mapped
+  // instead of being read.
+  data::MappedMatrix<double> reference;
   arma::mat queryData; // So it doesn't go out of scope.
-  if (!data::Load(referenceFile, referenceData))
+  if (!reference.Load(referenceFile))
     Log::Fatal << "Reference file " << referenceFile << "not found." << endl;
+  arma::mat& referenceData = reference.Matrix();
 
   Log::Info << "Loaded reference data from '" << referenceFile << "'." << endl;
 
@@ -127,6 +519,14 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // Sanity check on number of threads.
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
@@ -142,9 +542,94 @@ int main(int argc, char *argv[])
     coverTree = false;
   }
 
+  if (ballTree && naive)
+  {
+    Log::Warn << "--ball_tree ignored because --naive is present." << endl;
+    ballTree = false;
+  }
+
+  if ((int) coverTree + (int) ballTree + (int) (periodicBox != "") > 1)
+    Log::Fatal << "Only one of --cover_tree, --ball_tree, and --periodic_box "
+        << "may be given." << endl;
+
+  if (queryChunk < 0)
+    Log::Fatal << "Invalid query chunk size: " << queryChunk << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  if (queryChunk > 0 && queryFile == "")
+    Log::Fatal << "--query_chunk requires --query_file." << endl;
+
+  if (queryChunk > 0 && (naive || coverTree || ballTree || periodicBox != ""))
+    Log::Fatal << "--query_chunk cannot be used with --naive, --cover_tree, "
+        << "--ball_tree, or --periodic_box." << endl;
+
+  if (autoTune && (naive || ballTree || periodicBox != ""))
+    Log::Fatal << "--auto_tune cannot be used with --naive, --ball_tree, or "
+        << "--periodic_box." << endl;
+
+  if (CLI::GetParam<int>("tune_samples") <= 0)
+    Log::Fatal << "Invalid number of tuning samples: "
+        << CLI::GetParam<int>("tune_samples") << ".  Must be greater than 0."
+        << endl;
+
+  if (autoTune)
+  {
+    Log::Info << "Tuning the trees..." << endl;
+    Timer::Start("tuning");
+
+    // Only kd-trees can search the query set in chunks.
+    TreeTuner tuner((size_t) CLI::GetParam<int>("tune_samples"),
+        queryChunk == 0);
+    RangeProbe probe(math::Range(min, max), singleMode);
+    const TreeConfiguration best = tuner.Tune(referenceData, probe);
+    coverTree = best.coverTree;
+    leafSize = best.leafSize;
+
+    Timer::Stop("tuning");
+    if (coverTree)
+      Log::Info << "Chose cover trees." << endl;
+    else
+      Log::Info << "Chose kd-trees with leaf size " << leafSize << "." << endl;
+  }
+
+  if (queryChunk > 0)
+  {
+    fstream neighborsStream(neighborsFile.c_str(),
+        fstream::out | fstream::binary);
+    fstream distancesStream(distancesFile.c_str(),
+        fstream::out | fstream::binary);
+    if (!neighborsStream.is_open() || !distancesStream.is_open())
+      Log::Fatal << "Cannot open files '" << neighborsFile << "' and '"
+          << distancesFile << "' to save output to." << endl;
+
+    Log::Info << "Building reference tree..." << endl;
+    Timer::Start("tree_building");
+    vector<size_t> oldFromNewRefs;
+    KDTreeType refTree(referenceData, oldFromNewRefs, leafSize);
+    Timer::Stop("tree_building");
+
+    Log::Info << "Computing neighbors within range [" << min << ", " << max
+        << "] of the queries in chunks of " << queryChunk << " points..."
+        << endl;
+    RangeChunkSearch stages(refTree, referenceData, oldFromNewRefs,
+        math::Range(min, max), leafSize, singleMode, threads, neighborsStream,
+        distancesStream);
+    data::ChunkReader<double> reader(queryFile, (size_t) queryChunk);
+    const size_t queries = reader.Pipeline(stages);
+    Log::Info << "Neighbors of " << queries << " queries computed." << endl;
+
+    return 0;
+  }
+
   vector<vector<size_t> > neighbors;
   vector<vector<double> > distances;
 
+  if (queryFile != "")
+  {
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "'." << endl;
+  }
+
   // The cover tree implies different types, so we must split this section.
   if (coverTree)
   {
@@ -156,7 +641,7 @@ int main(int argc, char *argv[])
     CoverTreeType referenceTree(referenceData);
     CoverTreeType* queryTree = NULL;
 
-    if (CLI::GetParam<string>("query_file") == "")
+    if (queryFile == "")
     {
       // Single dataset.
       rangeSearch = new RSCoverType(&referenceTree, referenceData, singleMode);
@@ -164,8 +649,6 @@ int main(int argc, char *argv[])
     else
     {
       // Two datasets.
-      const string queryFile = CLI::GetParam<string>("query_file");
-      data::Load(queryFile, queryData, true);
       queryTree = new CoverTreeType(queryData);
 
       rangeSearch = new RSCoverType(&referenceTree, queryTree, referenceData,
@@ -181,171 +664,31 @@ int main(int argc, char *argv[])
       delete queryTree;
     delete rangeSearch;
   }
-  else
+  else if (ballTree)
   {
-    // Because we may construct it differently, we need a pointer.
-    RSType* rangeSearch = NULL;
-
-    // Mappings for when we build the tree.
-    vector<size_t> oldFromNewRefs;
-
-    // Build trees by hand, so we can save memory: if we pass a tree to
-    // NeighborSearch, it does not copy the matrix.
-    Log::Info << "Building reference tree..." << endl;
-    Timer::Start("tree_building");
-
-    BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat>
-        refTree(referenceData, oldFromNewRefs, leafSize);
-    BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat>*
-        queryTree = NULL; // Empty for now.
-
-    Timer::Stop("tree_building");
-
-    vector<size_t> oldFromNewQueries;
-
-    if (CLI::GetParam<string>("query_file") != "")
-    {
-      const string queryFile = CLI::GetParam<string>("query_file");
-      data::Load(queryFile, queryData, true);
-
-      if (naive && leafSize < queryData.n_cols)
-        leafSize = queryData.n_cols;
-
-      Log::Info << "Loaded query data from '" << queryFile << "'." << endl;
-
-      Log::Info << "Building query tree..." << endl;
-
-      // Build trees by hand, so we can save memory: if we pass a tree to
-      // NeighborSearch, it does not copy the matrix.
-      Timer::Start("tree_building");
-
-      queryTree = new BinarySpaceTree<bound::HRectBound<2>,
-          RangeSearchStat>(queryData, oldFromNewQueries, leafSize);
-
-      Timer::Stop("tree_building");
-
-      rangeSearch = new RSType(&refTree, queryTree, referenceData, queryData,
-          singleMode);
-
-      Log::Info << "Tree built." << endl;
-    }
-    else
-    {
-      rangeSearch = new RSType(&refTree, referenceData, singleMode);
-
-      Log::Info << "Trees built." << endl;
-    }
-
-    Log::Info << "Computing neighbors within range [" << min << ", " << max
-        << "]." << endl;
-
-    // Collect the results in these vectors before remapping.
-    vector<vector<double> > distancesOut;
-    vector<vector<size_t> > neighborsOut;
-
-    const math::Range r(min, max);
-    rangeSearch->Search(r, neighborsOut, distancesOut);
-
-    Log::Info << "Neighbors computed." << endl;
-
-    // We have to map back to the original indices from before the tree
-    // construction.
-    Log::Info << "Re-mapping indices..." << endl;
-
-    distances.resize(distancesOut.size());
-    neighbors.resize(neighborsOut.size());
-
-    // Do the actual remapping.
-    if (CLI::GetParam<string>("query_file") != "")
-    {
-      for (size_t i = 0; i < distances.size(); ++i)
-      {
-        // Map distances (copy a column).
-        distances[oldFromNewQueries[i]] = distancesOut[i];
-
-        // Map indices of neighbors.
-        neighbors[oldFromNewQueries[i]].resize(neighborsOut[i].size());
-        for (size_t j = 0; j < distancesOut[i].size(); ++j)
-        {
-          neighbors[oldFromNewQueries[i]][j] =
-              oldFromNewRefs[neighborsOut[i][j]];
-        }
-      }
-    }
-    else
-    {
-      for (size_t i = 0; i < distances.size(); ++i)
-      {
-        // Map distances (copy a column).
-        distances[oldFromNewRefs[i]] = distancesOut[i];
-
-        // Map indices of neighbors.
-        neighbors[oldFromNewRefs[i]].resize(neighborsOut[i].size());
-        for (size_t j = 0; j < distancesOut[i].size(); ++j)
-        {
-          neighbors[oldFromNewRefs[i]][j] = oldFromNewRefs[neighborsOut[i][j]];
-        }
-      }
-    }
-
-    // Clean up.
-    if (queryTree)
-      delete queryTree;
-    delete rangeSearch;
+    Log::Info << "Using ball trees." << endl;
+    BinarySpaceTreeSearch<BallTreeType>(referenceData, queryData, leafSize,
+        naive, singleMode, threads, math::Range(min, max),
+        metric::EuclideanDistance(), neighbors, distances);
   }
-
-  // Save output.  We have to do this by hand.
-  fstream distancesStr(distancesFile.c_str(), fstream::out);
-  if (!distancesStr.is_open())
+  else if (periodicBox != "")
   {
-    Log::Warn << "Cannot open file '" << distancesFile << "' to save output "
-        << "distances to!" << endl;
+    // Naive search also needs the periodic metric, so the periodic box is used
+    // even with --naive.
+    const arma::vec box = PeriodicBox(periodicBox, referenceData.n_rows);
+    Log::Info << "Using periodic kd-trees with box " << trans(box);
+    BinarySpaceTreeSearch<PeriodicTreeType>(referenceData, queryData, leafSize,
+        naive, singleMode, threads, math::Range(min, max),
+        metric::PeriodicEuclideanDistance(box), neighbors, distances);
   }
   else
   {
-    // Loop over each point.
-    for (size_t i = 0; i < distances.size(); ++i)
-    {
-      // Store the distances of each point.  We may have 0 points to store, so
-      // we must account for that possibility.
-      for (size_t j = 0; j + 1 < distances[i].size(); ++j)
-      {
-        distancesStr << distances[i][j] << ", ";
-      }
-
-      if (distances[i].size() > 0)
-        distancesStr << distances[i][distances[i].size() - 1];
-
-      distancesStr << endl;
-    }
-
-    distancesStr.close();
-  }
-
-  fstream neighborsStr(neighborsFile.c_str(), fstream::out);
-  if (!neighborsStr.is_open())
-  {
-    Log::Warn << "Cannot open file '" << neighborsFile << "' to save output "
-        << "neighbor indices to!" << endl;
+    BinarySpaceTreeSearch<KDTreeType>(referenceData, queryData, leafSize,
+        naive, singleMode, threads, math::Range(min, max),
+        metric::EuclideanDistance(), neighbors, distances);
   }
-  else
-  {
-    // Loop over each point.
-    for (size_t i = 0; i < neighbors.size(); ++i)
-    {
-      // Store the neighbors of each point.  We may have 0 points to store, so
-      // we must account for that possibility.
-      for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
-      {
-        neighborsStr << neighbors[i][j] << ", ";
-      }
 
-      if (neighbors[i].size() > 0)
-        neighborsStr << neighbors[i][neighbors[i].size() - 1];
-
-      neighborsStr << endl;
-    }
-
-    neighborsStr.close();
-  }
+  // Save output.  We have to do this by hand.
+  SaveResults(distancesFile, distances, "distances", threads);
+  SaveResults(neighborsFile, neighbors, "neighbor indices", threads);
 }
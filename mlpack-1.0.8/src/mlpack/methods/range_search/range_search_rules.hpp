@@ -22,11 +22,37 @@
 #ifndef __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RULES_HPP
 
+#include "range_result_buffer.hpp"
+
 namespace mlpack {
 namespace range {
 
+/**
+ * A visitor which ignores every result; this is the default VisitorType of
+ * RangeSearchRules, for when the results are stored instead.
+ */
+class NullRangeVisitor
+{
+ public:
+  //! Ignore the result.
+  void operator()(const size_t /* queryIndex */,
+                  const size_t /* referenceIndex */,
+                  const double /* distance */) { }
+};
 
-template<typename MetricType, typename TreeType>
+/**
+ * The rules for range search.  The results are either stored in vectors for
+ * each query point, appended to a buffer for each thread, only counted, or
+ * handed to a visitor as they are found, depending on the constructor.
+ *
+ * @tparam MetricType Metric to use.
+ * @tparam TreeType Type of tree to search.
+ * @tparam VisitorType Type of the visitor that results can be handed to; it
+ *     must be callable as visitor(queryIndex, referenceIndex, distance).
+ */
+template<typename MetricType,
+         typename TreeType,
+         typename VisitorType = NullRangeVisitor>
 class RangeSearchRules
 {
  public:
@@ -48,6 +74,60 @@ class RangeSearchRules
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric);
 
+  /**
+   * Construct the RangeSearchRules object so that the results are only
+   * counted.  The count of each query point is increased by the number of
+   * reference points in range; when a whole reference node is in range, its
+   * points are counted at once, without calculating any distances.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param counts Counts for each query point (these are added to).
+   * @param metric Instantiated metric.
+   */
+  RangeSearchRules(const arma::mat& referenceSet,
+                   const arma::mat& querySet,
+                   const math::Range& range,
+                   arma::Col<size_t>& counts,
+                   MetricType& metric);
+
+  /**
+   * Construct the RangeSearchRules object so that each result is handed to the
+   * given visitor as soon as it is found, and not stored.  If copies of the
+   * rules are used by several threads, the visitor is called from all of them.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param visitor Visitor to call with each result.
+   * @param metric Instantiated metric.
+   */
+  RangeSearchRules(const arma::mat& referenceSet,
+                   const arma::mat& querySet,
+                   const math::Range& range,
+                   VisitorType& visitor,
+                   MetricType& metric);
+
+  /**
+   * Construct the RangeSearchRules object so that the results are appended to
+   * one buffer for each thread instead.  Each result goes to the buffer of the
+   * thread that found it, so copies of the rules can be used by the threads of
+   * one OpenMP parallel region at once, as long as the region is opened after
+   * the rules are constructed.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param buffers One buffer for each thread that will use the rules.
+   * @param metric Instantiated metric.
+   */
+  RangeSearchRules(const arma::mat& referenceSet,
+                   const arma::mat& querySet,
+                   const math::Range& range,
+                   std::vector<RangeResultBuffer>& buffers,
+                   MetricType& metric);
+
   /**
    * Compute the base case between the given query point and reference point.
    *
@@ -116,11 +196,24 @@ class RangeSearchRules
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
+  //! The vector the resultant neighbor indices should be stored in (NULL if
+  //! the buffers are used).
+  std::vector<std::vector<size_t> >* neighbors;
 
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The vector the resultant neighbor distances should be stored in (NULL if
+  //! the buffers are used).
+  std::vector<std::vector<double> >* distances;
+
+  //! The buffers for each thread to store the results in (NULL if the vectors
+  //! are used).
+  std::vector<RangeResultBuffer>* buffers;
+
+  //! The number of results for each query point (NULL if the results are
+  //! stored).
+  arma::Col<size_t>* counts;
+
+  //! The visitor to hand results to (NULL if the results are stored).
+  VisitorType* visitor;
 
   //! The instantiated metric.
   MetricType& metric;
@@ -135,6 +228,18 @@ class RangeSearchRules
   //! add that to the results twice.
   void AddResult(const size_t queryIndex,
                  TreeType& referenceNode);
+
+  //! Store a single result.
+  void Store(const size_t queryIndex,
+             const size_t referenceIndex,
+             const double distance);
+
+  //! The OpenMP nesting level the rules were created at; the buffer of a
+  //! thread is chosen by its thread number at the level below.
+  int level;
+
+  //! Return the index of the buffer of the calling thread.
+  size_t ThreadIndex() const;
 };
 
 }; // namespace range
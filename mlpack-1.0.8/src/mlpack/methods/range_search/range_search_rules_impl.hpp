@@ -25,11 +25,15 @@
 // In case it hasn't been included yet.
 #include "range_search_rules.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace range {
 
-template<typename MetricType, typename TreeType>
-RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+template<typename MetricType, typename TreeType, typename VisitorType>
+RangeSearchRules<MetricType, TreeType, VisitorType>::RangeSearchRules(
     const arma::mat& referenceSet,
     const arma::mat& querySet,
     const math::Range& range,
@@ -39,20 +43,97 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    neighbors(&neighbors),
+    distances(&distances),
+    buffers(NULL),
+    counts(NULL),
+    visitor(NULL),
     metric(metric),
     lastQueryIndex(querySet.n_cols),
-    lastReferenceIndex(referenceSet.n_cols)
+    lastReferenceIndex(referenceSet.n_cols),
+    level(0)
+{
+#ifdef _OPENMP
+  level = omp_get_level();
+#endif
+}
+
+template<typename MetricType, typename TreeType, typename VisitorType>
+RangeSearchRules<MetricType, TreeType, VisitorType>::RangeSearchRules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts,
+    MetricType& metric) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffers(NULL),
+    counts(&counts),
+    visitor(NULL),
+    metric(metric),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    level(0)
 {
   // Nothing to do.
 }
 
+template<typename MetricType, typename TreeType, typename VisitorType>
+RangeSearchRules<MetricType, TreeType, VisitorType>::RangeSearchRules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    const math::Range& range,
+    VisitorType& visitor,
+    MetricType& metric) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffers(NULL),
+    counts(NULL),
+    visitor(&visitor),
+    metric(metric),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    level(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType, typename VisitorType>
+RangeSearchRules<MetricType, TreeType, VisitorType>::RangeSearchRules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    const math::Range& range,
+    std::vector<RangeResultBuffer>& buffers,
+    MetricType& metric) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffers(&buffers),
+    counts(NULL),
+    visitor(NULL),
+    metric(metric),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    level(0)
+{
+#ifdef _OPENMP
+  level = omp_get_level();
+#endif
+}
+
 //! The base case.  Evaluate the distance between the two points and add to the
 //! results if necessary.
-template<typename MetricType, typename TreeType>
+template<typename MetricType, typename TreeType, typename VisitorType>
 inline force_inline
-double RangeSearchRules<MetricType, TreeType>::BaseCase(
+double RangeSearchRules<MetricType, TreeType, VisitorType>::BaseCase(
     const size_t queryIndex,
     const size_t referenceIndex)
 {
@@ -75,18 +156,16 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
   lastReferenceIndex = referenceIndex;
 
   if (range.Contains(distance))
-  {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
-  }
+    Store(queryIndex, referenceIndex, distance);
 
   return distance;
 }
 
 //! Single-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename VisitorType>
+double RangeSearchRules<MetricType, TreeType, VisitorType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
   // We must get the minimum and maximum distances and store them in this
   // object.
@@ -143,8 +222,8 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
 }
 
 //! Single-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
+template<typename MetricType, typename TreeType, typename VisitorType>
+double RangeSearchRules<MetricType, TreeType, VisitorType>::Rescore(
     const size_t /* queryIndex */,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -154,9 +233,10 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
 }
 
 //! Dual-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename VisitorType>
+double RangeSearchRules<MetricType, TreeType, VisitorType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
 {
   math::Range distances;
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
@@ -262,8 +342,8 @@ double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
 }
 
 //! Dual-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
+template<typename MetricType, typename TreeType, typename VisitorType>
+double RangeSearchRules<MetricType, TreeType, VisitorType>::Rescore(
     TreeType& /* queryNode */,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -274,9 +354,10 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
 
 //! Add all the points in the given node to the results for the given query
 //! point.
-template<typename MetricType, typename TreeType>
-void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
-                                                       TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename VisitorType>
+void RangeSearchRules<MetricType, TreeType, VisitorType>::AddResult(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
   // Some types of trees calculate the base case evaluation before Score() is
   // called, so if the base case has already been calculated, then we must avoid
@@ -289,14 +370,35 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     baseCaseMod = 1;
   }
 
+  const size_t newResults = referenceNode.NumDescendants() - baseCaseMod;
+  if (counts != NULL)
+  {
+    // Only the number of points is needed, so no distances are calculated.
+    size_t newCount = newResults;
+    if (&referenceSet == &querySet)
+    {
+      for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
+        if (queryIndex == referenceNode.Descendant(i))
+          --newCount;
+    }
+
+    (*counts)[queryIndex] += newCount;
+    return;
+  }
+
   // Resize distances and neighbors vectors appropriately.  We have to use
   // reserve() and not resize(), because we don't know if we will encounter the
   // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
+  if (buffers != NULL)
+  {
+    (*buffers)[ThreadIndex()].Reserve(newResults);
+  }
+  else
+  {
+    const size_t oldSize = (*neighbors)[queryIndex].size();
+    (*neighbors)[queryIndex].reserve(oldSize + newResults);
+    (*distances)[queryIndex].reserve(oldSize + newResults);
+  }
 
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
   {
@@ -307,11 +409,48 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
         referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    Store(queryIndex, referenceNode.Descendant(i), distance);
   }
 }
 
+template<typename MetricType, typename TreeType, typename VisitorType>
+inline force_inline
+void RangeSearchRules<MetricType, TreeType, VisitorType>::Store(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  if (counts != NULL)
+  {
+    ++(*counts)[queryIndex];
+  }
+  else if (visitor != NULL)
+  {
+    (*visitor)(queryIndex, referenceIndex, distance);
+  }
+  else if (buffers != NULL)
+  {
+    (*buffers)[ThreadIndex()].Add(queryIndex, referenceIndex, distance);
+  }
+  else
+  {
+    (*neighbors)[queryIndex].push_back(referenceIndex);
+    (*distances)[queryIndex].push_back(distance);
+  }
+}
+
+template<typename MetricType, typename TreeType, typename VisitorType>
+inline size_t
+RangeSearchRules<MetricType, TreeType, VisitorType>::ThreadIndex() const
+{
+#ifdef _OPENMP
+  // The buffer is picked by the thread number in the region the search opened.
+  if (omp_get_level() > level)
+    return (size_t) omp_get_ancestor_thread_num(level + 1);
+#endif
+  return 0;
+}
+
 }; // namespace range
 }; // namespace mlpack
 
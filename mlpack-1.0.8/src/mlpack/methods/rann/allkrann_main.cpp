@@ -24,6 +24,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/tree_tuner.hpp>
 
 #include <string>
 #include <fstream>
@@ -36,6 +37,45 @@ using namespace mlpack;
 using namespace mlpack::neighbor;
 using namespace mlpack::tree;
 
+/**
+ * The search TreeTuner times with --auto_tune: find k rank-approximate nearest
+ * neighbors of every point of the sample with kd-trees.  The sample is smaller
+ * than the reference set, so k is reduced to keep it below the number of
+ * points within tau.
+ */
+struct RANNProbe
+{
+  RANNProbe(const size_t k,
+            const double tau,
+            const double alpha,
+            const bool singleMode) :
+      k(k), tau(tau), alpha(alpha), singleMode(singleMode) { }
+
+  void operator()(arma::mat& sample, const TreeConfiguration& configuration)
+  {
+    const size_t rankError = (size_t) ceil(tau * (double) sample.n_cols /
+        100.0);
+    const size_t probeK = (rankError > 1) ? std::min(k, rankError - 1) : 0;
+    if (probeK == 0)
+      return;
+
+    std::vector<size_t> oldFromNew;
+    BinarySpaceTree<bound::HRectBound<2, false>,
+        RAQueryStat<NearestNeighborSort> > tree(sample, oldFromNew,
+        configuration.leafSize);
+    AllkRANN search(&tree, sample, singleMode);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search.Search(probeK, neighbors, distances, tau, alpha);
+  }
+
+  size_t k;
+  double tau;
+  double alpha;
+  bool singleMode;
+};
+
 // Information about the program itself.
 PROGRAM_INFO("All K-Rank-Approximate-Nearest-Neighbors",
     "This program will calculate the k rank-approximate-nearest-neighbors of a "
@@ -61,7 +101,13 @@ PROGRAM_INFO("All K-Rank-Approximate-Nearest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "With --auto_tune (-A), the leaf size is chosen from a quick profile of "
+    "the reference set: on a sample of --tune_samples points, the intrinsic "
+    "dimensionality is estimated, and short searches are timed with kd-trees "
+    "of a few leaf sizes; the fastest is used for the whole search.  This "
+    "overrides --leaf_size.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -85,6 +131,9 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
            "dual-tree search.", "s");
 PARAM_FLAG("cover_tree", "If true, use cover trees to perform the search.",
            "c");
+PARAM_INT("threads", "Number of threads to use for tree-based search (0 uses "
+    "all available cores).  This only has an effect if MLPACK was built with "
+    "OpenMP.", "j", 1);
 
 PARAM_FLAG("sample_at_leaves", "The flag to trigger sampling at leaves.", "L");
 PARAM_FLAG("first_leaf_exact", "The flag to trigger sampling only after "
@@ -92,6 +141,11 @@ PARAM_FLAG("first_leaf_exact", "The flag to trigger sampling only after "
 PARAM_INT("single_sample_limit", "The limit on the maximum number of "
     "samples (and hence the largest node you can approximate).", "S", 20);
 
+PARAM_FLAG("auto_tune", "If true, choose the leaf size by timing searches on a "
+    "sample of the reference set.", "A");
+PARAM_INT("tune_samples", "Number of reference points the searches of "
+    "--auto_tune are timed on.", "T", 2000);
+
 int main(int argc, char *argv[])
 {
   // Give CLI the command line parameters the user passed in.
@@ -115,6 +169,7 @@ int main(int argc, char *argv[])
   bool singleMode = CLI::HasParam("single_mode");
   bool sampleAtLeaves = CLI::HasParam("sample_at_leaves");
   bool firstLeafExact = CLI::HasParam("first_leaf_exact");
+  int threads = CLI::GetParam<int>("threads");
 
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
@@ -147,10 +202,41 @@ int main(int argc, char *argv[])
       "than or equal to 0." << endl;
   size_t leafSize = lsInt;
 
+  // Sanity check on the number of threads.
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
 
+  // There are no cover trees to try yet, so only the leaf size is tuned.
+  const bool autoTune = CLI::HasParam("auto_tune");
+  if (autoTune && (naive || CLI::HasParam("cover_tree")))
+    Log::Fatal << "--auto_tune cannot be used with --naive or --cover_tree."
+        << endl;
+
+  if (CLI::GetParam<int>("tune_samples") <= 0)
+    Log::Fatal << "Invalid number of tuning samples: "
+        << CLI::GetParam<int>("tune_samples") << ".  Must be greater than 0."
+        << endl;
+
+  if (autoTune)
+  {
+    Log::Info << "Tuning the leaf size..." << endl;
+    Timer::Start("tuning");
+
+    TreeTuner tuner((size_t) CLI::GetParam<int>("tune_samples"), false);
+    RANNProbe probe(k, tau, alpha, singleMode);
+    leafSize = tuner.Tune(referenceData, probe).leafSize;
+
+    Timer::Stop("tuning");
+    Log::Info << "Chose leaf size " << leafSize << "." << endl;
+  }
+
   // The actual output after the remapping.
   arma::Mat<size_t> neighbors;
   arma::mat distances;
@@ -246,6 +332,8 @@ int main(int argc, char *argv[])
         Log::Info << "Trees built." << endl;
       }
 
+      allkrann->Threads() = (size_t) threads;
+
       Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
         tau << "% rank approximation..." << endl;
       allkrann->Search(k, neighborsOut, distancesOut,
@@ -36,9 +36,11 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/parallel_dual_tree_traverser.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+#include <mlpack/methods/neighbor_search/quantized_matrix.hpp>
 
 namespace mlpack {
 namespace neighbor /** Neighbor-search routines.  These include
@@ -242,8 +244,9 @@ class RASearch
            const MetricType metric = MetricType());
 
   /**
-   * Delete the RASearch object. The tree is the only member we are
-   * responsible for deleting.  The others will take care of themselves.
+   * Delete the RASearch object. The tree and the quantized reference points
+   * are the only members we are responsible for deleting.  The others will
+   * take care of themselves.
    */
   ~RASearch();
 
@@ -267,6 +270,10 @@ class RASearch
    * to choose 5 nearest neighbors out of the closest 1 point -- this is
    * invalid.
    *
+   * The number of samples needed for tau and alpha is computed the first time
+   * they are used with this reference set size and k, and then taken from
+   * SampleSizeTable in every later call.
+   *
    * @param k Number of neighbors to search for.
    * @param resultingNeighbors Matrix storing lists of neighbors for each query
    *     point.
@@ -301,6 +308,38 @@ class RASearch
    */
   void ResetQueryTree();
 
+  /**
+   * Store the reference points as 8-bit codes (see QuantizedMatrix), with
+   * scalar quantization or product quantization.  After this, the base cases
+   * of Search() approximate the distances from the codes and the
+   * full-precision query points; the tree itself still uses the reference set
+   * for its bounds.  If Rerank() is true, the neighbors found are then
+   * re-ranked with their exact distances.  Only the L2 metrics can be
+   * approximated this way.
+   *
+   * @param subspaces Number of subspaces for product quantization; 0 (the
+   *     default) means scalar quantization of each dimension.
+   */
+  void Quantize(const size_t subspaces = 0);
+
+  //! Get the quantized reference points (NULL if Quantize() was not called).
+  const QuantizedMatrix* Quantized() const { return quantized; }
+
+  //! Get whether the neighbors are re-ranked with their exact distances.
+  bool Rerank() const { return rerank; }
+  //! Modify whether the neighbors are re-ranked with their exact distances,
+  //! when the reference points are quantized.
+  bool& Rerank() { return rerank; }
+
+  //! Get the number of threads used for the search.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the search (0 means all available
+  //! cores).  Single-tree search hands out query points to the threads, and
+  //! dual-tree search traverses subtrees of the query tree in parallel (see
+  //! tree::ParallelDualTreeTraverser).  With the same random seed, the results
+  //! of single-tree search do not depend on the number of threads.
+  size_t& Threads() { return threads; }
+
  private:
   //! Copy of reference dataset (if we need it, because tree building modifies
   //! it).
@@ -339,6 +378,26 @@ class RASearch
   //! Total number of pruned nodes during the neighbor search.
   size_t numberOfPrunes;
 
+  //! The number of threads to use for the search.
+  size_t threads;
+
+  //! The quantized reference points (NULL unless Quantize() was called).
+  QuantizedMatrix* quantized;
+  //! Whether to re-rank the neighbors with their exact distances.
+  bool rerank;
+
+  /**
+   * Recompute the distances to the neighbors found with the full-precision
+   * reference points, and sort each list of neighbors again.
+   *
+   * @param neighbors Neighbors found for each query point.
+   * @param distances Distances to the neighbors found.
+   */
+  void RerankNeighbors(arma::Mat<size_t>& neighbors, arma::mat& distances);
+
+  //! Get the number of threads to use, resolving 0 to all available cores.
+  size_t NumThreads() const;
+
   /**
    * @param treeNode The node of the tree whose RAQueryStat is reset
    *     and whose children are to be explored recursively.
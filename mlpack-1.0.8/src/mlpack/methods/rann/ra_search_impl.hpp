@@ -26,6 +26,11 @@
 #include <mlpack/core.hpp>
 
 #include "ra_search_rules.hpp"
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace neighbor {
@@ -50,7 +55,10 @@ RASearch(const typename TreeType::Mat& referenceSet,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    quantized(NULL),
+    rerank(false)
 {
   // We'll time tree building.
   Timer::Start("tree_building");
@@ -84,7 +92,10 @@ RASearch(const typename TreeType::Mat& referenceSet,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    quantized(NULL),
+    rerank(false)
 {
   // We'll time tree building.
   Timer::Start("tree_building");
@@ -115,7 +126,10 @@ RASearch(TreeType* referenceTree,
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    threads(1),
+    quantized(NULL),
+    rerank(false)
 // Nothing else to initialize.
 {  }
 
@@ -135,7 +149,10 @@ RASearch(TreeType* referenceTree,
   naive(false),
   singleMode(singleMode),
   metric(metric),
-  numberOfPrunes(0)
+  numberOfPrunes(0),
+  threads(1),
+  quantized(NULL),
+  rerank(false)
 // Nothing else to initialize.
 { }
 
@@ -151,6 +168,8 @@ RASearch<SortPolicy, MetricType, TreeType>::
     delete referenceTree;
   if (ownQueryTree)
     delete queryTree;
+
+  delete quantized;
 }
 
 /**
@@ -191,15 +210,17 @@ Search(const size_t k,
   distancePtr->fill(SortPolicy::WorstDistance());
 
   size_t numPrunes = 0;
+  tree::TraversalStatistics::Start();
 
   if (singleMode || naive)
   {
     // Create the helper object for the tree traversal.  Initialization of
     // RASearchRules already implicitly performs the naive tree traversal.
-    typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr,
-                   metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
-                   singleSampleLimit);
+    typedef RASearchRules<SortPolicy, MetricType, TreeType> BaseRuleType;
+    typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+    RuleType rules(BaseRuleType(referenceSet, querySet, *neighborPtr,
+        *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
+        firstLeafExact, singleSampleLimit, quantized));
 
     // If the reference root node is a leaf, then the sampling has already been
     // done in the RASearchRules constructor.  This happens when naive = true.
@@ -207,32 +228,63 @@ Search(const size_t k,
     {
       Log::Info << "Performing single-tree traversal..." << std::endl;
 
-      // Create the traverser.
-      typename TreeType::template SingleTreeTraverser<RuleType>
-        traverser(rules);
+      const size_t numThreads = NumThreads();
+      size_t numDistComputations = 0;
+      if (numThreads == 1)
+      {
+        // Create the traverser.
+        typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(rules);
 
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < querySet.n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
+        // Now have it traverse for each point.
+        for (size_t i = 0; i < querySet.n_cols; ++i)
+          traverser.Traverse(i, *referenceTree);
 
-      numPrunes = traverser.NumPrunes();
+        numPrunes = traverser.NumPrunes();
+        numDistComputations = rules.NumDistComputations();
+      }
+      else
+      {
+        #pragma omp parallel num_threads(numThreads) \
+            reduction(+:numPrunes, numDistComputations)
+        {
+          // The number of samples made for each query is kept in the rules,
+          // so every thread needs its own copy.  The copies share the results,
+          // and the samples of a query do not depend on the thread it is
+          // given to.
+          RuleType threadRules(rules);
+          typename TreeType::template SingleTreeTraverser<RuleType>
+              traverser(threadRules);
+
+          #pragma omp for schedule(dynamic, 16)
+          for (int i = 0; i < (int) querySet.n_cols; ++i)
+            traverser.Traverse(i, *referenceTree);
+
+          numPrunes += traverser.NumPrunes();
+          numDistComputations += threadRules.NumDistComputations();
+        }
+      }
 
       Log::Info << "Single-tree traversal complete." << std::endl;
       Log::Info << "Average number of distance calculations per query point: "
-          << (rules.NumDistComputations() / querySet.n_cols) << "."
-          << std::endl;
+          << (numDistComputations / querySet.n_cols) << "." << std::endl;
     }
   }
   else // Dual-tree recursion.
   {
     Log::Info << "Performing dual-tree traversal..." << std::endl;
 
-    typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr,
-                   metric, tau, alpha, sampleAtLeaves, firstLeafExact,
-                   singleSampleLimit);
+    typedef RASearchRules<SortPolicy, MetricType, TreeType> BaseRuleType;
+    typedef typename tree::TraversalRules<BaseRuleType>::Type RuleType;
+    RuleType rules(BaseRuleType(referenceSet, querySet, *neighborPtr,
+        *distancePtr, metric, tau, alpha, false, sampleAtLeaves,
+        firstLeafExact, singleSampleLimit, quantized));
 
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    // Each query subtree gets its own copy of the rules, so the distance
+    // calculations can only be counted in the serial case.
+    const size_t numThreads = NumThreads();
+    tree::ParallelDualTreeTraverser<TreeType, RuleType> traverser(rules,
+        numThreads);
 
     if (queryTree)
     {
@@ -250,10 +302,20 @@ Search(const size_t k,
     numPrunes = traverser.NumPrunes();
 
     Log::Info << "Dual-tree traversal complete." << std::endl;
-    Log::Info << "Average number of distance calculations per query point: "
-        << (rules.NumDistComputations() / querySet.n_cols) << "." << std::endl;
+    if (numThreads == 1)
+      Log::Info << "Average number of distance calculations per query point: "
+          << (rules.NumDistComputations() / querySet.n_cols) << "."
+          << std::endl;
   }
 
+  tree::TraversalStatistics::Stop();
+
+  // For large k the rules kept the candidates as heaps, which are sorted now.
+  CandidateHeap<SortPolicy>::Sort(*distancePtr, *neighborPtr);
+
+  if (quantized != NULL && rerank)
+    RerankNeighbors(*neighborPtr, *distancePtr);
+
   Timer::Stop("computing_neighbors");
   Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
 
@@ -358,6 +420,67 @@ void RASearch<SortPolicy, MetricType, TreeType>::ResetQueryTree()
   }
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearch<SortPolicy, MetricType, TreeType>::Quantize(
+    const size_t subspaces)
+{
+  if (!QuantizedDistance<MetricType>::Supported)
+    Log::Fatal << "RASearch::Quantize(): quantized reference points can only "
+        << "be used with the L2 metrics." << std::endl;
+
+  Timer::Start("quantizing_references");
+
+  delete quantized;
+  quantized = new QuantizedMatrix(referenceSet, subspaces);
+
+  Timer::Stop("quantizing_references");
+
+  Log::Info << "Reference points quantized to " << quantized->Subspaces()
+      << " bytes each." << std::endl;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearch<SortPolicy, MetricType, TreeType>::RerankNeighbors(
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    // Lists which are not full end with the worst distance.
+    size_t found = 0;
+    while (found < neighbors.n_rows &&
+        distances(found, i) != SortPolicy::WorstDistance())
+      ++found;
+
+    for (size_t j = 0; j < found; ++j)
+      distances(j, i) = metric.Evaluate(querySet.unsafe_col(i),
+          referenceSet.unsafe_col(neighbors(j, i)));
+
+    // Insertion sort; the lists are short.
+    for (size_t j = 1; j < found; ++j)
+    {
+      const double distance = distances(j, i);
+      const size_t neighbor = neighbors(j, i);
+      size_t pos = j;
+      while (pos > 0 && SortPolicy::IsBetter(distance, distances(pos - 1, i)))
+      {
+        distances(pos, i) = distances(pos - 1, i);
+        neighbors(pos, i) = neighbors(pos - 1, i);
+        --pos;
+      }
+
+      distances(pos, i) = distance;
+      neighbors(pos, i) = neighbor;
+    }
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t RASearch<SortPolicy, MetricType, TreeType>::NumThreads() const
+{
+  return Threads::Count(threads);
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 void RASearch<SortPolicy, MetricType, TreeType>::ResetRAQueryStat(
     TreeType* treeNode)
@@ -24,9 +24,27 @@
 #ifndef __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 
+#include "sample_block.hpp"
+#include "sample_size_table.hpp"
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
+#include <mlpack/methods/neighbor_search/quantized_matrix.hpp>
+
 namespace mlpack {
 namespace neighbor {
 
+/**
+ * The rules for rank-approximate search.
+ *
+ * The samples taken from a reference node for a query point are drawn from a
+ * random stream which depends only on a seed (taken from math::RandInt() when
+ * the rules are constructed), the query point, and the reference node.  So
+ * the rules do not share a random number generator between threads, and
+ * copies of the rules used for different query points (as in
+ * tree::ParallelDualTreeTraverser) draw independent samples.  The samples of a
+ * node are evaluated against the query point as one block (see SampleBlock).
+ * Naive sampling, which is done in the constructor, still uses math::RandInt()
+ * directly.
+ */
 template<typename SortPolicy, typename MetricType, typename TreeType>
 class RASearchRules
 {
@@ -41,7 +59,8 @@ class RASearchRules
                 const bool naive = false,
                 const bool sampleAtLeaves = false,
                 const bool firstLeafExact = false,
-                const size_t singleSampleLimit = 20);
+                const size_t singleSampleLimit = 20,
+                const QuantizedMatrix* quantized = NULL);
 
 
 
@@ -237,6 +256,11 @@ class RASearchRules
   //! The instantiated metric.
   MetricType& metric;
 
+  //! Whether the candidates are kept as heaps (see CandidateHeap).
+  bool heap;
+  //! The row of the worst candidate of each query point.
+  size_t worstRow;
+
   //! Whether to sample at leaves or just use all of it
   bool sampleAtLeaves;
 
@@ -255,9 +279,36 @@ class RASearchRules
   //! The sampling ratio
   double samplingRatio;
 
+  //! The quantized reference points to compute distances with, if not NULL.
+  const QuantizedMatrix* quantized;
+  //! The distance table of the query point tableQuery, for quantized points.
+  arma::mat queryTable;
+  //! The query point whose distance table is in queryTable.
+  size_t tableQuery;
+
+  //! The seed of the random streams samples are drawn from.
+  uint64_t seed;
+
   // TO REMOVE: just for testing
   size_t numDistComputations;
 
+  /**
+   * Approximate the distance between a query point and a reference point from
+   * the quantized reference points, building the distance table of the query
+   * point if it is not the one in queryTable.
+   *
+   * @param queryIndex Index of the query point.
+   * @param referenceIndex Index of the reference point.
+   */
+  double QuantizedBaseDistance(const size_t queryIndex,
+                               const size_t referenceIndex);
+
+  //! Add the given reference point to the neighbors of the given query point,
+  //! if it is better than the current candidates.
+  void AddCandidate(const size_t queryIndex,
+                    const size_t referenceIndex,
+                    const double distance);
+
   /**
    * Insert a point into the neighbors and distances matrices; this is a helper
    * function.
@@ -272,34 +323,6 @@ class RASearchRules
                       const size_t neighbor,
                       const double distance);
 
-  /**
-   * Compute the minimum number of samples required to guarantee
-   * the given rank-approximation and success probability.
-   *
-   * @param n Size of the set to be sampled from.
-   * @param k The number of neighbors required within the rank-approximation.
-   * @param tau The rank-approximation in percentile of the data.
-   * @param alpha The success probability desired.
-   */
-  size_t MinimumSamplesReqd(const size_t n,
-                            const size_t k,
-                            const double tau,
-                            const double alpha) const;
-
-  /**
-   * Compute the success probability of obtaining 'k'-neighbors from a
-   * set of size 'n' within the top 't' neighbors if 'm' samples are made.
-   *
-   * @param n Size of the set being sampled from.
-   * @param k The number of neighbors required within the rank-approximation.
-   * @param m The number of random samples.
-   * @param t The desired rank-approximation.
-   */
-  double SuccessProbability(const size_t n,
-                            const size_t k,
-                            const size_t m,
-                            const size_t t) const;
-
   /**
    * Pick up desired number of samples (with replacement) from a given range
    * of integers so that only the distinct samples are returned from
@@ -313,6 +336,56 @@ class RASearchRules
                              const size_t rangeUpperBound,
                              arma::uvec& distinctSamples) const;
 
+  /**
+   * Pick up desired number of samples (with replacement) from the range of
+   * integers [0 - specified upper bound), drawing them from the given random
+   * stream instead of math::RandInt(), and return the distinct samples in
+   * increasing order.
+   *
+   * @param numSamples Number of random samples.
+   * @param rangeUpperBound The upper bound on the range of integers.
+   * @param stream The random stream to draw from (see Stream()).
+   * @param distinctSamples The list of the distinct samples.
+   */
+  void ObtainDistinctSamples(const size_t numSamples,
+                             const size_t rangeUpperBound,
+                             const uint64_t stream,
+                             std::vector<size_t>& distinctSamples) const;
+
+  /**
+   * Get the random stream for sampling the given reference node for the given
+   * query point.
+   */
+  uint64_t Stream(const size_t queryIndex, TreeType& referenceNode) const;
+
+  //! Scramble the bits of a 64-bit integer (the SplitMix64 finalizer).
+  static uint64_t Mix(uint64_t x);
+
+  /**
+   * Approximate the given reference node for the given query point by
+   * sampling the given number of its descendants.  The samples are counted
+   * like base cases.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Reference node to sample from.
+   * @param numSamples Number of random samples (with replacement).
+   */
+  void Sample(const size_t queryIndex,
+              TreeType& referenceNode,
+              const size_t numSamples);
+
+  /**
+   * Calculate the base cases between the given query point and a block of
+   * reference points, evaluating the distances at once (see SampleBlock).
+   * Reference points equal to the query point are skipped if the query set is
+   * the reference set.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndices Indices of the reference points.
+   */
+  void BaseCases(const size_t queryIndex,
+                 const std::vector<size_t>& referenceIndices);
+
   /**
    * Perform actual scoring for single-tree case.
    */
@@ -40,15 +40,20 @@ RASearchRules(const arma::mat& referenceSet,
               const bool naive,
               const bool sampleAtLeaves,
               const bool firstLeafExact,
-              const size_t singleSampleLimit) :
+              const size_t singleSampleLimit,
+              const QuantizedMatrix* quantized) :
   referenceSet(referenceSet),
   querySet(querySet),
   neighbors(neighbors),
   distances(distances),
   metric(metric),
+  heap(CandidateHeap<SortPolicy>::Use(distances.n_rows)),
+  worstRow(CandidateHeap<SortPolicy>::WorstRow(distances.n_rows)),
   sampleAtLeaves(sampleAtLeaves),
   firstLeafExact(firstLeafExact),
-  singleSampleLimit(singleSampleLimit)
+  singleSampleLimit(singleSampleLimit),
+  quantized(quantized),
+  tableQuery(querySet.n_cols)
 {
   // Validate tau to make sure that the rank approximation is greater than the
   // number of neighbors requested.
@@ -69,8 +74,10 @@ RASearchRules(const arma::mat& referenceSet,
         << t << " points; because k = " << k << ", this is exact search!"
         << std::endl;
 
+  // The sample size is only computed the first time these parameters are
+  // used (see SampleSizeTable).
   Timer::Start("computing_number_of_samples_reqd");
-  numSamplesReqd = MinimumSamplesReqd(n, k, tau, alpha);
+  numSamplesReqd = SampleSizeTable::MinimumSamples(n, k, tau, alpha);
   Timer::Stop("computing_number_of_samples_reqd");
 
   // Initialize some statistics to be collected during the search.
@@ -83,15 +90,26 @@ RASearchRules(const arma::mat& referenceSet,
 
   if (naive) // No tree traversal; just do naive sampling here.
   {
+    seed = 0;
+
     // Sample enough points.
     for (size_t i = 0; i < querySet.n_cols; ++i)
     {
       arma::uvec distinctSamples;
       ObtainDistinctSamples(numSamplesReqd, n, distinctSamples);
-      for (size_t j = 0; j < distinctSamples.n_elem; j++)
-        BaseCase(i, (size_t) distinctSamples[j]);
+
+      std::vector<size_t> referenceIndices(distinctSamples.begin(),
+          distinctSamples.end());
+      BaseCases(i, referenceIndices);
     }
   }
+  else
+  {
+    // The streams used during the traversal are derived from this seed, so the
+    // search can still be reproduced with math::RandomSeed().
+    seed = ((uint64_t) math::RandInt(1 << 30) << 32) ^
+        (uint64_t) math::RandInt(1 << 30);
+  }
 }
 
 
@@ -113,167 +131,106 @@ ObtainDistinctSamples(const size_t numSamples,
   return;
 }
 
-
-
 template<typename SortPolicy, typename MetricType, typename TreeType>
-size_t RASearchRules<SortPolicy, MetricType, TreeType>::
-MinimumSamplesReqd(const size_t n,
-                   const size_t k,
-                   const double tau,
-                   const double alpha) const
+void RASearchRules<SortPolicy, MetricType, TreeType>::
+ObtainDistinctSamples(const size_t numSamples,
+                      const size_t rangeUpperBound,
+                      const uint64_t stream,
+                      std::vector<size_t>& distinctSamples) const
 {
-  size_t ub = n; // The upper bound on the binary search.
-  size_t lb = k; // The lower bound on the binary search.
-  size_t  m = lb; // The minimum number of random samples.
-
-  // The rank-approximation.
-  const size_t t = (size_t) std::ceil(tau * (double) n / 100.0);
+  // Only a few samples are taken from a node, so sorting them is cheaper than
+  // counting every point of the range.
+  distinctSamples.resize(numSamples);
+  uint64_t state = stream;
+  for (size_t i = 0; i < numSamples; i++)
+  {
+    // SplitMix64; the top 53 bits give a uniform double in [0, 1).
+    state += 0x9E3779B97F4A7C15ULL;
+    const double uniform = (double) (Mix(state) >> 11) / 9007199254740992.0;
+    distinctSamples[i] = (size_t) (uniform * (double) rangeUpperBound);
+  }
 
-  double prob;
-  Log::Assert(alpha <= 1.0);
+  std::sort(distinctSamples.begin(), distinctSamples.end());
+  distinctSamples.erase(std::unique(distinctSamples.begin(),
+      distinctSamples.end()), distinctSamples.end());
+}
 
-  // going through all values of sample sizes
-  // to find the minimum samples required to satisfy the
-  // desired bound
-  bool done = false;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline uint64_t RASearchRules<SortPolicy, MetricType, TreeType>::Stream(
+    const size_t queryIndex,
+    TreeType& referenceNode) const
+{
+  // The node is identified by its first descendant and its size.
+  return Mix(Mix(Mix(seed ^ (uint64_t) queryIndex) ^
+      (uint64_t) referenceNode.Descendant(0)) ^
+      (uint64_t) referenceNode.NumDescendants());
+}
 
-  // This performs a binary search on the integer values between 'lb = k'
-  // and 'ub = n' to find the minimum number of samples 'm' required to obtain
-  // the desired success probability 'alpha'.
-  do
-  {
-    prob = SuccessProbability(n, k, m, t);
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline uint64_t RASearchRules<SortPolicy, MetricType, TreeType>::Mix(
+    uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
 
-    if (prob > alpha)
-    {
-      if (prob - alpha < 0.001 || ub < lb + 2) {
-        done = true;
-        break;
-      }
-      else
-        ub = m;
-    }
-    else
-    {
-      if (prob < alpha)
-      {
-        if (m == lb)
-        {
-          m++;
-          continue;
-        }
-        else
-          lb = m;
-      }
-      else
-      {
-        done = true;
-        break;
-      }
-    }
-    m = (ub + lb) / 2;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearchRules<SortPolicy, MetricType, TreeType>::Sample(
+    const size_t queryIndex,
+    TreeType& referenceNode,
+    const size_t numSamples)
+{
+  std::vector<size_t> referenceIndices;
+  ObtainDistinctSamples(numSamples, referenceNode.NumDescendants(),
+      Stream(queryIndex, referenceNode), referenceIndices);
 
-  } while (!done);
+  for (size_t i = 0; i < referenceIndices.size(); i++)
+    referenceIndices[i] = referenceNode.Descendant(referenceIndices[i]);
 
-  return (std::min(m + 1, n));
+  BaseCases(queryIndex, referenceIndices);
 }
 
-
 template<typename SortPolicy, typename MetricType, typename TreeType>
-double RASearchRules<SortPolicy, MetricType, TreeType>::SuccessProbability(
-    const size_t n,
-    const size_t k,
-    const size_t m,
-    const size_t t) const
+void RASearchRules<SortPolicy, MetricType, TreeType>::BaseCases(
+    const size_t queryIndex,
+    const std::vector<size_t>& referenceIndices)
 {
-  if (k == 1)
+  // If the datasets are the same, do not return the query point itself (as in
+  // BaseCase()).
+  const std::vector<size_t>* indices = &referenceIndices;
+  std::vector<size_t> otherIndices;
+  if ((&querySet == &referenceSet) && (std::find(referenceIndices.begin(),
+      referenceIndices.end(), queryIndex) != referenceIndices.end()))
   {
-    if (m > n - t)
-      return 1.0;
-
-    double eps = (double) t / (double) n;
-
-    return 1.0 - std::pow(1.0 - eps, (double) m);
+    otherIndices.reserve(referenceIndices.size() - 1);
+    for (size_t i = 0; i < referenceIndices.size(); i++)
+      if (referenceIndices[i] != queryIndex)
+        otherIndices.push_back(referenceIndices[i]);
+    indices = &otherIndices;
+  }
 
-  } // Faster implementation for topK = 1.
+  arma::vec sampleDistances;
+  if (quantized != NULL)
+  {
+    sampleDistances.set_size(indices->size());
+    for (size_t i = 0; i < indices->size(); i++)
+      sampleDistances[i] = QuantizedBaseDistance(queryIndex, (*indices)[i]);
+  }
   else
   {
-    if (m < k)
-      return 0.0;
-
-    if (m > n - t + k - 1)
-      return 1.0;
-
-    double eps = (double) t / (double) n;
-    double sum = 0.0;
-
-    // The probability that 'k' of the 'm' samples lie within the top 't'
-    // of the neighbors is given by:
-    // sum_{j = k}^m Choose(m, j) (t/n)^j (1 - t/n)^{m - j}
-    // which is also equal to
-    // 1 - sum_{j = 0}^{k - 1} Choose(m, j) (t/n)^j (1 - t/n)^{m - j}
-    //
-    // So this is a m - k term summation or a k term summation. So if
-    // m > 2k, do the k term summation, otherwise do the m term summation.
-
-    size_t lb;
-    size_t ub;
-    bool topHalf;
-
-    if (2 * k < m)
-    {
-      // Compute 1 - sum_{j = 0}^{k - 1} Choose(m, j) eps^j (1 - eps)^{m - j}
-      // eps = t/n.
-      //
-      // Choosing 'lb' as 1 and 'ub' as k so as to sum from 1 to (k - 1), and
-      // add the term (1 - eps)^m term separately.
-      lb = 1;
-      ub = k;
-      topHalf = true;
-      sum = std::pow(1 - eps, (double) m);
-    }
-    else
-    {
-      // Compute sum_{j = k}^m Choose(m, j) eps^j (1 - eps)^{m - j}
-      // eps = t/n.
-      //
-      // Choosing 'lb' as k and 'ub' as m so as to sum from k to (m - 1), and
-      // add the term eps^m term separately.
-      lb = k;
-      ub = m;
-      topHalf = false;
-      sum = std::pow(eps, (double) m);
-    }
-
-    for (size_t j = lb; j < ub; j++)
-    {
-      // Compute Choose(m, j).
-      double mCj = (double) m;
-      size_t jTrans;
-
-      // If j < m - j, compute Choose(m, j).
-      // If j > m - j, compute Choose(m, m - j).
-      if (topHalf)
-        jTrans = j;
-      else
-        jTrans = m - j;
+    SampleBlock<MetricType>::Evaluate(metric, querySet.unsafe_col(queryIndex),
+        referenceSet, *indices, sampleDistances);
+  }
 
-      for(size_t i = 2; i <= jTrans; i++)
-      {
-        mCj *= (double) (m - (i - 1));
-        mCj /= (double) i;
-      }
+  for (size_t i = 0; i < indices->size(); i++)
+    AddCandidate(queryIndex, (*indices)[i], sampleDistances[i]);
 
-      sum += (mCj * std::pow(eps, (double) j)
-              * std::pow(1.0 - eps, (double) (m - j)));
-    }
+  numSamplesMade[queryIndex] += indices->size();
+  numDistComputations += indices->size();
+}
 
-    if (topHalf)
-      sum = 1.0 - sum;
 
-    return sum;
-  } // For k > 1.
-}
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline force_inline
@@ -286,17 +243,14 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
   if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
     return 0.0;
 
-  double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-                                    referenceSet.unsafe_col(referenceIndex));
+  double distance = (quantized != NULL) ?
+      QuantizedBaseDistance(queryIndex, referenceIndex) :
+      metric.Evaluate(querySet.unsafe_col(queryIndex),
+                      referenceSet.unsafe_col(referenceIndex));
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  size_t insertPosition = SortPolicy::SortDistance(queryDist, distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // Insert the reference point if it is better than any of the current
+  // candidates.
+  AddCandidate(queryIndex, referenceIndex, distance);
 
   numSamplesMade[queryIndex]++;
 
@@ -306,6 +260,21 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline double RASearchRules<SortPolicy, MetricType, TreeType>::
+QuantizedBaseDistance(const size_t queryIndex, const size_t referenceIndex)
+{
+  // The table is rebuilt only when the query point changes.
+  if (tableQuery != queryIndex)
+  {
+    quantized->DistanceTable(querySet.unsafe_col(queryIndex), queryTable);
+    tableQuery = queryIndex;
+  }
+
+  return QuantizedDistance<MetricType>::FromSquared(
+      quantized->Distance(queryTable, referenceIndex));
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -314,7 +283,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(worstRow, queryIndex);
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -328,7 +297,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode, baseCaseResult);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(worstRow, queryIndex);
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -369,13 +338,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
         {
           // Then samplesReqd <= singleSampleLimit.
           // Hence, approximate the node by sampling enough number of points.
-          arma::uvec distinctSamples;
-          ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                distinctSamples);
-          for (size_t i = 0; i < distinctSamples.n_elem; i++)
-            // The counting of the samples are done in the 'BaseCase' function
-            // so no book-keeping is required here.
-            BaseCase(queryIndex, referenceNode.Descendant(distinctSamples[i]));
+          Sample(queryIndex, referenceNode, samplesReqd);
 
           // Node approximated, so we can prune it.
           return DBL_MAX;
@@ -385,14 +348,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           if (sampleAtLeaves) // If allowed to sample at leaves.
           {
             // Approximate node by sampling enough number of points.
-            arma::uvec distinctSamples;
-            ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                  distinctSamples);
-            for (size_t i = 0; i < distinctSamples.n_elem; i++)
-              // The counting of the samples are done in the 'BaseCase' function
-              // so no book-keeping is required here.
-              BaseCase(queryIndex,
-                  referenceNode.Descendant(distinctSamples[i]));
+            Sample(queryIndex, referenceNode, samplesReqd);
 
             // (Leaf) node approximated, so we can prune it.
             return DBL_MAX;
@@ -440,7 +396,7 @@ Rescore(const size_t queryIndex,
     return oldScore;
 
   // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = distances(worstRow, queryIndex);
 
   // If this is better than the best distance we've seen so far,
   // maybe there will be something down this node.
@@ -473,13 +429,7 @@ Rescore(const size_t queryIndex,
       {
         // Then, samplesReqd <= singleSampleLimit.  Hence, approximate the node
         // by sampling enough number of points.
-        arma::uvec distinctSamples;
-        ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-            distinctSamples);
-        for (size_t i = 0; i < distinctSamples.n_elem; i++)
-          // The counting of the samples are done in the 'BaseCase' function so
-          // no book-keeping is required here.
-          BaseCase(queryIndex, referenceNode.Descendant(distinctSamples[i]));
+        Sample(queryIndex, referenceNode, samplesReqd);
 
         // Node approximated, so we can prune it.
         return DBL_MAX;
@@ -489,13 +439,7 @@ Rescore(const size_t queryIndex,
         if (sampleAtLeaves)
         {
           // Approximate node by sampling enough points.
-          arma::uvec distinctSamples;
-          ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                distinctSamples);
-          for (size_t i = 0; i < distinctSamples.n_elem; i++)
-            // The counting of the samples are done in the 'BaseCase' function
-            // so no book-keeping is required here.
-            BaseCase(queryIndex, referenceNode.Descendant(distinctSamples[i]));
+          Sample(queryIndex, referenceNode, samplesReqd);
 
           // (Leaf) node approximated, so we can prune it.
           return DBL_MAX;
@@ -540,7 +484,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(worstRow, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -579,7 +523,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(worstRow, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -674,17 +618,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           // Then samplesReqd <= singleSampleLimit.  Hence, approximate node by
           // sampling enough number of points for every query in the query node.
           for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-          {
-            const size_t queryIndex = queryNode.Descendant(i);
-            arma::uvec distinctSamples;
-            ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                  distinctSamples);
-            for (size_t j = 0; j < distinctSamples.n_elem; j++)
-              // The counting of the samples are done in the 'BaseCase' function
-              // so no book-keeping is required here.
-              BaseCase(queryIndex,
-                  referenceNode.Descendant(distinctSamples[j]));
-          }
+            Sample(queryNode.Descendant(i), referenceNode, samplesReqd);
 
           // Update the number of samples made for the queryNode and also update
           // the number of sample made for the child nodes.
@@ -704,17 +638,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             // Approximate node by sampling enough number of points for every
             // query in the query node.
             for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-            {
-              const size_t queryIndex = queryNode.Descendant(i);
-              arma::uvec distinctSamples;
-              ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                    distinctSamples);
-              for (size_t j = 0; j < distinctSamples.n_elem; j++)
-                // The counting of the samples are done in the 'BaseCase'
-                // function so no book-keeping is required here.
-                BaseCase(queryIndex,
-                    referenceNode.Descendant(distinctSamples[j]));
-            }
+              Sample(queryNode.Descendant(i), referenceNode, samplesReqd);
 
             // Update the number of samples made for the queryNode and also
             // update the number of sample made for the child nodes.
@@ -793,7 +717,7 @@ Rescore(TreeType& queryNode,
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = distances(worstRow, queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -879,16 +803,7 @@ Rescore(TreeType& queryNode,
         // then samplesReqd <= singleSampleLimit.  Hence, approximate the node
         // by sampling enough points for every query in the query node.
         for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-        {
-          const size_t queryIndex = queryNode.Descendant(i);
-          arma::uvec distinctSamples;
-          ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-              distinctSamples);
-          for (size_t j = 0; j < distinctSamples.n_elem; j++)
-            // The counting of the samples are done in the 'BaseCase'
-            // function so no book-keeping is required here.
-            BaseCase(queryIndex, referenceNode.Descendant(distinctSamples[j]));
-        }
+          Sample(queryNode.Descendant(i), referenceNode, samplesReqd);
 
         // Update the number of samples made for the query node and also update
         // the number of samples made for the child nodes.
@@ -908,17 +823,7 @@ Rescore(TreeType& queryNode,
           // Approximate node by sampling enough points for every query in the
           // query node.
           for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-          {
-            const size_t queryIndex = queryNode.Descendant(i);
-            arma::uvec distinctSamples;
-            ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                  distinctSamples);
-            for (size_t j = 0; j < distinctSamples.n_elem; j++)
-              // The counting of the samples are done in BaseCase() so no
-              // book-keeping is required here.
-              BaseCase(queryIndex,
-                  referenceNode.Descendant(distinctSamples[j]));
-          }
+            Sample(queryNode.Descendant(i), referenceNode, samplesReqd);
 
           // Update the number of samples made for the query node and also
           // update the number of samples made for the child nodes.
@@ -964,6 +869,29 @@ Rescore(TreeType& queryNode,
   }
 } // Rescore(node, node, oldScore)
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline void RASearchRules<SortPolicy, MetricType, TreeType>::AddCandidate(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  // With many candidates, they are kept as a heap (see CandidateHeap).
+  if (heap)
+  {
+    CandidateHeap<SortPolicy>::Insert(distances.colptr(queryIndex),
+        neighbors.colptr(queryIndex), distances.n_rows, distance,
+        referenceIndex);
+    return;
+  }
+
+  // Otherwise SortDistance() gives the position in the sorted list, or
+  // (size_t() - 1) if the point should not be added.
+  arma::vec queryDist = distances.unsafe_col(queryIndex);
+  const size_t insertPosition = SortPolicy::SortDistance(queryDist, distance);
+  if (insertPosition != (size_t() - 1))
+    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+}
+
 /**
  * Helper function to insert a point into the neighbors and distances matrices.
  *
@@ -0,0 +1,135 @@
+/**
+ * @file sample_block.hpp
+ *
+ * Evaluation of a metric between one query point and a block of sampled
+ * reference points at once.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_RANN_SAMPLE_BLOCK_HPP
+#define __MLPACK_METHODS_RANN_SAMPLE_BLOCK_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Copy the given reference points into the columns of a matrix, so that they
+ * can be used in vectorized operations.
+ *
+ * @param referenceSet Set of reference points.
+ * @param referenceIndices Indices of the reference points to copy.
+ * @param block Matrix to store the points in.
+ */
+inline void GatherSamples(const arma::mat& referenceSet,
+                          const std::vector<size_t>& referenceIndices,
+                          arma::mat& block)
+{
+  block.set_size(referenceSet.n_rows, referenceIndices.size());
+  for (size_t i = 0; i < referenceIndices.size(); ++i)
+    memcpy(block.colptr(i), referenceSet.colptr(referenceIndices[i]),
+        sizeof(double) * referenceSet.n_rows);
+}
+
+/**
+ * Evaluate a metric between a query point and a set of (not necessarily
+ * contiguous) reference points, as RASearchRules does for the points it
+ * samples from a node.  The general version calls MetricType::Evaluate() for
+ * each reference point.  For the L1 and L2 metrics, there are specializations
+ * which gather the sampled points into one matrix and compute all the
+ * distances with a few vectorized operations.
+ *
+ * @tparam MetricType Type of metric to evaluate.
+ */
+template<typename MetricType>
+class SampleBlock
+{
+ public:
+  /**
+   * Evaluate the metric between the query point and each of the given
+   * reference points.
+   *
+   * @param metric Metric to evaluate.
+   * @param queryPoint The query point.
+   * @param referenceSet Set of reference points.
+   * @param referenceIndices Indices of the sampled reference points.
+   * @param distances Vector to store the distances in, in the same order as
+   *     referenceIndices.
+   */
+  static void Evaluate(MetricType& metric,
+                       const arma::vec& queryPoint,
+                       const arma::mat& referenceSet,
+                       const std::vector<size_t>& referenceIndices,
+                       arma::vec& distances)
+  {
+    distances.set_size(referenceIndices.size());
+    for (size_t i = 0; i < referenceIndices.size(); ++i)
+      distances[i] = metric.Evaluate(queryPoint,
+          referenceSet.unsafe_col(referenceIndices[i]));
+  }
+};
+
+/**
+ * For the L1 metric, the distances are the column sums of the absolute
+ * differences.
+ */
+template<bool TakeRoot>
+class SampleBlock<metric::LMetric<1, TakeRoot> >
+{
+ public:
+  static void Evaluate(metric::LMetric<1, TakeRoot>& /* metric */,
+                       const arma::vec& queryPoint,
+                       const arma::mat& referenceSet,
+                       const std::vector<size_t>& referenceIndices,
+                       arma::vec& distances)
+  {
+    arma::mat block;
+    GatherSamples(referenceSet, referenceIndices, block);
+
+    distances = trans(sum(abs(block - repmat(queryPoint, 1, block.n_cols))));
+  }
+};
+
+/**
+ * For the L2 metric, the distances are the column sums of the squared
+ * differences, and their square roots if TakeRoot is true.
+ */
+template<bool TakeRoot>
+class SampleBlock<metric::LMetric<2, TakeRoot> >
+{
+ public:
+  static void Evaluate(metric::LMetric<2, TakeRoot>& /* metric */,
+                       const arma::vec& queryPoint,
+                       const arma::mat& referenceSet,
+                       const std::vector<size_t>& referenceIndices,
+                       arma::vec& distances)
+  {
+    arma::mat block;
+    GatherSamples(referenceSet, referenceIndices, block);
+
+    distances = trans(sum(square(block - repmat(queryPoint, 1,
+        block.n_cols))));
+    if (TakeRoot)
+      distances = sqrt(distances);
+  }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
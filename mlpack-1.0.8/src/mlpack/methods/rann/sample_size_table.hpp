@@ -0,0 +1,323 @@
+/**
+ * @file sample_size_table.hpp
+ *
+ * A process-wide table of the number of samples that rank-approximate search
+ * needs for a given reference set size, k, tau and alpha.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_RANN_SAMPLE_SIZE_TABLE_HPP
+#define __MLPACK_METHODS_RANN_SAMPLE_SIZE_TABLE_HPP
+
+#include <mlpack/core.hpp>
+#include <map>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The minimum number of samples that rank-approximate search needs for the
+ * (tau, alpha) guarantee depends only on the size of the reference set, k, tau
+ * and alpha, but finding it takes a binary search over sums of binomial
+ * probabilities, which can take longer than searching a small batch of
+ * queries.  So the sample sizes are kept in a table shared by the whole
+ * process: each combination is computed the first time it is needed, and
+ * every later search (with any RASearch object) reuses it.  The table can be
+ * filled ahead of time for the combinations that will be used with
+ * Precompute().
+ *
+ * @code
+ * // Fill the table for k = 1 to 10, tau = 5 and alpha = 0.95, for a
+ * // reference set of 100000 points, before queries arrive.
+ * SampleSizeTable::Precompute(100000, 10, 5.0, 0.95);
+ * @endcode
+ *
+ * All the functions may be called from several threads at once.
+ */
+class SampleSizeTable
+{
+ public:
+  /**
+   * Return the minimum number of samples required to guarantee the given
+   * rank-approximation and success probability, from the table if it has been
+   * computed before.
+   *
+   * @param n Size of the set to be sampled from.
+   * @param k The number of neighbors required within the rank-approximation.
+   * @param tau The rank-approximation in percentile of the data.
+   * @param alpha The success probability desired.
+   */
+  static size_t MinimumSamples(const size_t n,
+                               const size_t k,
+                               const double tau,
+                               const double alpha)
+  {
+    const Key key(std::make_pair(n, k), std::make_pair(tau, alpha));
+
+    bool found = false;
+    size_t samples = 0;
+    #pragma omp critical(mlpack_sample_size_table)
+    {
+      TableType::const_iterator it = Table().find(key);
+      if (it != Table().end())
+      {
+        found = true;
+        samples = it->second;
+      }
+    }
+
+    if (found)
+      return samples;
+
+    // Two threads may compute the same entry at once; they find the same
+    // value.
+    samples = Compute(n, k, tau, alpha);
+
+    #pragma omp critical(mlpack_sample_size_table)
+    Table()[key] = samples;
+
+    return samples;
+  }
+
+  /**
+   * Compute the minimum sample sizes for a reference set of size n and every k
+   * from 1 to maxK (that tau allows), so that later searches with these
+   * parameters find them in the table.
+   *
+   * @param n Size of the set to be sampled from.
+   * @param maxK The largest number of neighbors that will be searched for.
+   * @param tau The rank-approximation in percentile of the data.
+   * @param alpha The success probability desired.
+   */
+  static void Precompute(const size_t n,
+                         const size_t maxK,
+                         const double tau,
+                         const double alpha)
+  {
+    const size_t t = (size_t) std::ceil(tau * (double) n / 100.0);
+    for (size_t k = 1; k <= std::min(maxK, t); ++k)
+      MinimumSamples(n, k, tau, alpha);
+  }
+
+  //! Return the number of entries in the table.
+  static size_t Size()
+  {
+    size_t size;
+    #pragma omp critical(mlpack_sample_size_table)
+    size = Table().size();
+
+    return size;
+  }
+
+  //! Remove every entry from the table.
+  static void Clear()
+  {
+    #pragma omp critical(mlpack_sample_size_table)
+    Table().clear();
+  }
+
+  /**
+   * Compute the minimum number of samples required to guarantee
+   * the given rank-approximation and success probability, without using the
+   * table.
+   *
+   * @param n Size of the set to be sampled from.
+   * @param k The number of neighbors required within the rank-approximation.
+   * @param tau The rank-approximation in percentile of the data.
+   * @param alpha The success probability desired.
+   */
+  static size_t Compute(const size_t n,
+                        const size_t k,
+                        const double tau,
+                        const double alpha)
+  {
+    size_t ub = n; // The upper bound on the binary search.
+    size_t lb = k; // The lower bound on the binary search.
+    size_t  m = lb; // The minimum number of random samples.
+
+    // The rank-approximation.
+    const size_t t = (size_t) std::ceil(tau * (double) n / 100.0);
+
+    double prob;
+    Log::Assert(alpha <= 1.0);
+
+    // going through all values of sample sizes
+    // to find the minimum samples required to satisfy the
+    // desired bound
+    bool done = false;
+
+    // This performs a binary search on the integer values between 'lb = k'
+    // and 'ub = n' to find the minimum number of samples 'm' required to obtain
+    // the desired success probability 'alpha'.
+    do
+    {
+      prob = SuccessProbability(n, k, m, t);
+
+      if (prob > alpha)
+      {
+        if (prob - alpha < 0.001 || ub < lb + 2) {
+          done = true;
+          break;
+        }
+        else
+          ub = m;
+      }
+      else
+      {
+        if (prob < alpha)
+        {
+          if (m == lb)
+          {
+            m++;
+            continue;
+          }
+          else
+            lb = m;
+        }
+        else
+        {
+          done = true;
+          break;
+        }
+      }
+      m = (ub + lb) / 2;
+
+    } while (!done);
+
+    return (std::min(m + 1, n));
+  }
+
+  /**
+   * Compute the success probability of obtaining 'k'-neighbors from a
+   * set of size 'n' within the top 't' neighbors if 'm' samples are made.
+   *
+   * @param n Size of the set being sampled from.
+   * @param k The number of neighbors required within the rank-approximation.
+   * @param m The number of random samples.
+   * @param t The desired rank-approximation.
+   */
+  static double SuccessProbability(const size_t n,
+                                   const size_t k,
+                                   const size_t m,
+                                   const size_t t)
+  {
+    if (k == 1)
+    {
+      if (m > n - t)
+        return 1.0;
+
+      double eps = (double) t / (double) n;
+
+      return 1.0 - std::pow(1.0 - eps, (double) m);
+
+    } // Faster implementation for topK = 1.
+    else
+    {
+      if (m < k)
+        return 0.0;
+
+      if (m > n - t + k - 1)
+        return 1.0;
+
+      double eps = (double) t / (double) n;
+      double sum = 0.0;
+
+      // The probability that 'k' of the 'm' samples lie within the top 't'
+      // of the neighbors is given by:
+      // sum_{j = k}^m Choose(m, j) (t/n)^j (1 - t/n)^{m - j}
+      // which is also equal to
+      // 1 - sum_{j = 0}^{k - 1} Choose(m, j) (t/n)^j (1 - t/n)^{m - j}
+      //
+      // So this is a m - k term summation or a k term summation. So if
+      // m > 2k, do the k term summation, otherwise do the m term summation.
+
+      size_t lb;
+      size_t ub;
+      bool topHalf;
+
+      if (2 * k < m)
+      {
+        // Compute 1 - sum_{j = 0}^{k - 1} Choose(m, j) eps^j (1 - eps)^{m - j}
+        // eps = t/n.
+        //
+        // Choosing 'lb' as 1 and 'ub' as k so as to sum from 1 to (k - 1), and
+        // add the term (1 - eps)^m term separately.
+        lb = 1;
+        ub = k;
+        topHalf = true;
+        sum = std::pow(1 - eps, (double) m);
+      }
+      else
+      {
+        // Compute sum_{j = k}^m Choose(m, j) eps^j (1 - eps)^{m - j}
+        // eps = t/n.
+        //
+        // Choosing 'lb' as k and 'ub' as m so as to sum from k to (m - 1), and
+        // add the term eps^m term separately.
+        lb = k;
+        ub = m;
+        topHalf = false;
+        sum = std::pow(eps, (double) m);
+      }
+
+      for (size_t j = lb; j < ub; j++)
+      {
+        // Compute Choose(m, j).
+        double mCj = (double) m;
+        size_t jTrans;
+
+        // If j < m - j, compute Choose(m, j).
+        // If j > m - j, compute Choose(m, m - j).
+        if (topHalf)
+          jTrans = j;
+        else
+          jTrans = m - j;
+
+        for(size_t i = 2; i <= jTrans; i++)
+        {
+          mCj *= (double) (m - (i - 1));
+          mCj /= (double) i;
+        }
+
+        sum += (mCj * std::pow(eps, (double) j)
+                * std::pow(1.0 - eps, (double) (m - j)));
+      }
+
+      if (topHalf)
+        sum = 1.0 - sum;
+
+      return sum;
+    } // For k > 1.
+  }
+
+ private:
+  //! The key of an entry: (n, k) and (tau, alpha).
+  typedef std::pair<std::pair<size_t, size_t>, std::pair<double, double> > Key;
+  //! The type of the table.
+  typedef std::map<Key, size_t> TableType;
+
+  //! Return the table shared by the whole process.
+  static TableType& Table()
+  {
+    static TableType table;
+    return table;
+  }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
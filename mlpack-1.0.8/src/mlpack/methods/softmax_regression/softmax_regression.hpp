@@ -0,0 +1,140 @@
+/**
+ * @file softmax_regression.hpp
+ *
+ * The SoftmaxRegression class, which implements multi-class logistic
+ * (softmax) regression.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_HPP
+#define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+
+#include "softmax_regression_function.hpp"
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * Softmax regression (multinomial logistic regression), which generalizes
+ * LogisticRegression to any number of classes.  All classes are trained
+ * together by minimizing one SoftmaxRegressionFunction, so each step of the
+ * optimizer passes over the data once for every class at the same time, rather
+ * than once per class as with one-vs-rest logistic regression models.
+ *
+ * @code
+ * extern arma::mat data;
+ * extern arma::Col<size_t> labels; // In [0, numClasses).
+ *
+ * SoftmaxRegression<> sr(data, labels, numClasses, lambda);
+ *
+ * arma::Col<size_t> predictions;
+ * sr.Predict(testData, predictions);
+ * @endcode
+ *
+ * @tparam OptimizerType Optimizer to train the model with.
+ */
+template<
+  template<typename> class OptimizerType = mlpack::optimization::L_BFGS
+>
+class SoftmaxRegression
+{
+ public:
+  /**
+   * Construct the SoftmaxRegression class with the given labeled training
+   * data.  This will train the model.  Optionally, specify lambda, which is the
+   * penalty parameter for L2-regularization.
+   *
+   * @param predictors Input training variables.
+   * @param labels Class of each point (in [0, numClasses)).
+   * @param numClasses Number of classes.
+   * @param lambda L2-regularization parameter.
+   */
+  SoftmaxRegression(const arma::mat& predictors,
+                    const arma::Col<size_t>& labels,
+                    const size_t numClasses,
+                    const double lambda = 0);
+
+  /**
+   * Construct the SoftmaxRegression class with an already instantiated
+   * optimizer (which holds the SoftmaxRegressionFunction error function), so
+   * that the optimizer can be configured before the training is run by this
+   * constructor.  The predictors, labels and initial point are all taken from
+   * the error function contained in the optimizer.
+   *
+   * @param optimizer Instantiated optimizer with instantiated error function.
+   */
+  SoftmaxRegression(OptimizerType<SoftmaxRegressionFunction>& optimizer);
+
+  /**
+   * Construct a softmax regression model from the given parameters, without
+   * performing any training.
+   *
+   * @param parameters Parameters making up the model (numClasses x
+   *     (dimensions + 1); column 0 holds the intercepts).
+   * @param lambda L2-regularization penalty parameter.
+   */
+  SoftmaxRegression(const arma::mat& parameters, const double lambda = 0);
+
+  //! Return the parameters.
+  const arma::mat& Parameters() const { return parameters; }
+  //! Modify the parameters.
+  arma::mat& Parameters() { return parameters; }
+
+  //! Return the number of classes.
+  size_t NumClasses() const { return parameters.n_rows; }
+
+  //! Return the lambda value for L2-regularization.
+  double Lambda() const { return lambda; }
+  //! Modify the lambda value for L2-regularization.
+  double& Lambda() { return lambda; }
+
+  /**
+   * Predict the class of each of the given points.  The scores of all classes
+   * are computed for blocks of points with one matrix-matrix product each.
+   *
+   * @param predictors Input predictors.
+   * @param labels Vector to put the predicted classes into.
+   */
+  void Predict(const arma::mat& predictors, arma::Col<size_t>& labels) const;
+
+  /**
+   * Compute the accuracy of the model on the given predictors and labels: the
+   * percentage of points whose class is predicted correctly.
+   *
+   * @param predictors Input predictors.
+   * @param labels Class of each point.
+   * @return Percentage of points classified correctly.
+   */
+  double ComputeAccuracy(const arma::mat& predictors,
+                         const arma::Col<size_t>& labels) const;
+
+ private:
+  //! Matrix of trained parameters.
+  arma::mat parameters;
+  //! L2-regularization penalty parameter.
+  double lambda;
+};
+
+}; // namespace regression
+}; // namespace mlpack
+
+// Include implementation.
+#include "softmax_regression_impl.hpp"
+
+#endif // __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_HPP
@@ -0,0 +1,150 @@
+/**
+ * @file softmax_regression_function.cpp
+ *
+ * Implementation of the SoftmaxRegressionFunction class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "softmax_regression_function.hpp"
+
+using namespace mlpack;
+using namespace mlpack::regression;
+
+SoftmaxRegressionFunction::SoftmaxRegressionFunction(
+    const arma::mat& predictors,
+    const arma::Col<size_t>& labels,
+    const size_t numClasses,
+    const double lambda) :
+    predictors(predictors),
+    labels(labels),
+    numClasses(numClasses),
+    lambda(lambda)
+{
+  if (labels.n_elem != predictors.n_cols)
+    Log::Fatal << "SoftmaxRegressionFunction: number of labels ("
+        << labels.n_elem << ") does not match number of points ("
+        << predictors.n_cols << ")!" << std::endl;
+
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    if (labels[i] >= numClasses)
+      Log::Fatal << "SoftmaxRegressionFunction: label " << labels[i]
+          << " of point " << i << " is not less than the number of classes ("
+          << numClasses << ")!" << std::endl;
+
+  initialPoint = arma::zeros<arma::mat>(numClasses, predictors.n_rows + 1);
+}
+
+//! Evaluate the negative log-likelihood of the model.
+double SoftmaxRegressionFunction::Evaluate(const arma::mat& parameters) const
+{
+  return ComputeProbabilities(parameters) + Regularization(parameters);
+}
+
+//! Evaluate the gradient of the negative log-likelihood of the model.
+void SoftmaxRegressionFunction::Gradient(const arma::mat& parameters,
+                                         arma::mat& gradient) const
+{
+  ComputeProbabilities(parameters);
+  GradientFromProbabilities(parameters, gradient);
+}
+
+//! Evaluate the negative log-likelihood of the model and its gradient.
+double SoftmaxRegressionFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  const double objective = ComputeProbabilities(parameters) +
+      Regularization(parameters);
+  GradientFromProbabilities(parameters, gradient);
+
+  return objective;
+}
+
+/**
+ * The scores of all classes for all points are one matrix-matrix product; then
+ * each column is turned into probabilities.  The largest score of each point is
+ * subtracted before exponentiating, so that nothing overflows.
+ */
+double SoftmaxRegressionFunction::ComputeProbabilities(
+    const arma::mat& parameters) const
+{
+  // Alias the weights, so they are not copied.
+  const arma::mat weights(const_cast<double*>(parameters.colptr(1)),
+      numClasses, predictors.n_rows, false, true);
+  probabilities = weights * predictors;
+
+  double result = 0.0;
+  for (size_t i = 0; i < predictors.n_cols; ++i)
+  {
+    double* scores = probabilities.colptr(i);
+
+    double maxScore = -DBL_MAX;
+    for (size_t k = 0; k < numClasses; ++k)
+    {
+      scores[k] += parameters(k, 0);
+      maxScore = std::max(maxScore, scores[k]);
+    }
+
+    double sum = 0.0;
+    const double labelScore = scores[labels[i]] - maxScore;
+    for (size_t k = 0; k < numClasses; ++k)
+    {
+      scores[k] = std::exp(scores[k] - maxScore);
+      sum += scores[k];
+    }
+
+    for (size_t k = 0; k < numClasses; ++k)
+      scores[k] /= sum;
+
+    // -log(p(label | x)).
+    result += std::log(sum) - labelScore;
+  }
+
+  return result;
+}
+
+/**
+ * The gradient with respect to the weights is (P - Y) X' + lambda W, where P
+ * holds the probabilities and Y the indicators of the labels; with respect to
+ * the intercepts it is the sum of the columns of (P - Y).
+ */
+void SoftmaxRegressionFunction::GradientFromProbabilities(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // The probabilities become P - Y.
+  for (size_t i = 0; i < predictors.n_cols; ++i)
+    probabilities(labels[i], i) -= 1.0;
+
+  gradient.set_size(numClasses, predictors.n_rows + 1);
+  gradient.col(0) = arma::sum(probabilities, 1);
+
+  // Accumulate straight into the gradient of the weights.
+  arma::mat weightGradient(gradient.colptr(1), numClasses, predictors.n_rows,
+      false, true);
+  weightGradient = lambda * parameters.cols(1, predictors.n_rows);
+  weightGradient += probabilities * trans(predictors);
+}
+
+//! Return the regularization term; the intercepts are not regularized.
+double SoftmaxRegressionFunction::Regularization(const arma::mat& parameters)
+    const
+{
+  const arma::mat weights(const_cast<double*>(parameters.colptr(1)),
+      numClasses, predictors.n_rows, false, true);
+
+  return 0.5 * lambda * arma::accu(weights % weights);
+}
@@ -0,0 +1,145 @@
+/**
+ * @file softmax_regression_function.hpp
+ *
+ * The softmax regression objective function, which is optimized by a separate
+ * optimizer class (such as L_BFGS) to train a SoftmaxRegression model.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_HPP
+#define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * The negative log-likelihood of the softmax regression (multinomial logistic
+ * regression) model, with L2-regularization.  The parameters are a matrix with
+ * one row for each class: column 0 holds the intercepts, and the other columns
+ * hold the weights of each dimension.  The probability of class k for a point
+ * x is then
+ *
+ *   p(k | x) = exp(b_k + w_k' x) / sum_j exp(b_j + w_j' x).
+ *
+ * All classes are handled at once: the scores of every class for every point
+ * are computed with one matrix-matrix product, and so is the gradient.  The
+ * class probabilities are held in a workspace that is reused between calls, so
+ * the same object must not be used from several threads at once.
+ */
+class SoftmaxRegressionFunction
+{
+ public:
+  /**
+   * Construct the function with the given data and labels.
+   *
+   * @param predictors Input training variables (one point per column).
+   * @param labels Class of each point (in [0, numClasses)).
+   * @param numClasses Number of classes.
+   * @param lambda L2-regularization parameter.
+   */
+  SoftmaxRegressionFunction(const arma::mat& predictors,
+                            const arma::Col<size_t>& labels,
+                            const size_t numClasses,
+                            const double lambda = 0);
+
+  //! Return the initial point for the optimization.
+  const arma::mat& InitialPoint() const { return initialPoint; }
+  //! Modify the initial point for the optimization.
+  arma::mat& InitialPoint() { return initialPoint; }
+
+  //! Return the regularization parameter (lambda).
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter (lambda).
+  double& Lambda() { return lambda; }
+
+  //! Return the number of classes.
+  size_t NumClasses() const { return numClasses; }
+
+  //! Return the matrix of predictors.
+  const arma::mat& Predictors() const { return predictors; }
+  //! Return the labels.
+  const arma::Col<size_t>& Labels() const { return labels; }
+
+  /**
+   * Evaluate the negative log-likelihood of the softmax regression model with
+   * the given parameters.
+   *
+   * @param parameters Matrix of parameters (numClasses x (dimensions + 1)).
+   */
+  double Evaluate(const arma::mat& parameters) const;
+
+  /**
+   * Evaluate the gradient of the negative log-likelihood of the softmax
+   * regression model with the given parameters.
+   *
+   * @param parameters Matrix of parameters (numClasses x (dimensions + 1)).
+   * @param gradient Matrix to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
+
+  /**
+   * Evaluate the negative log-likelihood and its gradient at the same time;
+   * the class probabilities are only computed once.  This is used by L-BFGS.
+   *
+   * @param parameters Matrix of parameters (numClasses x (dimensions + 1)).
+   * @param gradient Matrix to output gradient into.
+   * @return The objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  //! Return the initial point for the optimization.
+  const arma::mat& GetInitialPoint() const { return initialPoint; }
+
+ private:
+  //! The initial point, from which to start the optimization.
+  arma::mat initialPoint;
+  //! The matrix of data points (predictors).
+  const arma::mat& predictors;
+  //! The class of each point.
+  const arma::Col<size_t>& labels;
+  //! The number of classes.
+  size_t numClasses;
+  //! The regularization parameter for L2-regularization.
+  double lambda;
+
+  //! The class probabilities of each point, for the last parameters.
+  mutable arma::mat probabilities;
+
+  /**
+   * Compute the class probabilities of each point into the workspace, and
+   * return the negative log-likelihood of the labels (without
+   * regularization).
+   */
+  double ComputeProbabilities(const arma::mat& parameters) const;
+
+  /**
+   * Compute the gradient from the probabilities in the workspace (which are
+   * overwritten).
+   */
+  void GradientFromProbabilities(const arma::mat& parameters,
+                                 arma::mat& gradient) const;
+
+  //! Return the regularization term of the objective.
+  double Regularization(const arma::mat& parameters) const;
+};
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_HPP
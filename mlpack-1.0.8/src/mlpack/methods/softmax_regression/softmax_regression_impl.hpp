@@ -0,0 +1,139 @@
+/**
+ * @file softmax_regression_impl.hpp
+ *
+ * Implementation of the SoftmaxRegression class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_IMPL_HPP
+#define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "softmax_regression.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<template<typename> class OptimizerType>
+SoftmaxRegression<OptimizerType>::SoftmaxRegression(
+    const arma::mat& predictors,
+    const arma::Col<size_t>& labels,
+    const size_t numClasses,
+    const double lambda) :
+    lambda(lambda)
+{
+  SoftmaxRegressionFunction errorFunction(predictors, labels, numClasses,
+      lambda);
+  OptimizerType<SoftmaxRegressionFunction> optimizer(errorFunction);
+  parameters = errorFunction.GetInitialPoint();
+
+  // Train the model.
+  Timer::Start("softmax_regression_optimization");
+  const double out = optimizer.Optimize(parameters);
+  Timer::Stop("softmax_regression_optimization");
+
+  Log::Info << "SoftmaxRegression::SoftmaxRegression(): final objective of "
+      << "trained model is " << out << "." << std::endl;
+}
+
+template<template<typename> class OptimizerType>
+SoftmaxRegression<OptimizerType>::SoftmaxRegression(
+    OptimizerType<SoftmaxRegressionFunction>& optimizer) :
+    parameters(optimizer.Function().GetInitialPoint()),
+    lambda(optimizer.Function().Lambda())
+{
+  Timer::Start("softmax_regression_optimization");
+  const double out = optimizer.Optimize(parameters);
+  Timer::Stop("softmax_regression_optimization");
+
+  Log::Info << "SoftmaxRegression::SoftmaxRegression(): final objective of "
+      << "trained model is " << out << "." << std::endl;
+}
+
+template<template<typename> class OptimizerType>
+SoftmaxRegression<OptimizerType>::SoftmaxRegression(
+    const arma::mat& parameters,
+    const double lambda) :
+    parameters(parameters),
+    lambda(lambda)
+{
+  // Nothing to do.
+}
+
+template<template<typename> class OptimizerType>
+void SoftmaxRegression<OptimizerType>::Predict(const arma::mat& predictors,
+                                               arma::Col<size_t>& labels) const
+{
+  if (predictors.n_rows + 1 != parameters.n_cols)
+    Log::Fatal << "SoftmaxRegression::Predict(): dimensionality of points ("
+        << predictors.n_rows << ") does not match model ("
+        << parameters.n_cols - 1 << ")!" << std::endl;
+
+  labels.set_size(predictors.n_cols);
+
+  // Work on blocks of points, so the scores of all the points for all the
+  // classes are never held at once.
+  const size_t blockSize = 1024;
+  const arma::mat weights = parameters.cols(1, parameters.n_cols - 1);
+  arma::mat scores;
+  for (size_t begin = 0; begin < predictors.n_cols; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize, (size_t) predictors.n_cols);
+    const arma::mat block(const_cast<double*>(predictors.colptr(begin)),
+        predictors.n_rows, end - begin, false, true);
+    scores = weights * block;
+
+    // The softmax is monotonic, so the most probable class has the highest
+    // score.
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+      size_t best = 0;
+      double bestScore = -DBL_MAX;
+      for (size_t k = 0; k < parameters.n_rows; ++k)
+      {
+        const double score = scores(k, i) + parameters(k, 0);
+        if (score > bestScore)
+        {
+          best = k;
+          bestScore = score;
+        }
+      }
+
+      labels[begin + i] = best;
+    }
+  }
+}
+
+template<template<typename> class OptimizerType>
+double SoftmaxRegression<OptimizerType>::ComputeAccuracy(
+    const arma::mat& predictors,
+    const arma::Col<size_t>& labels) const
+{
+  arma::Col<size_t> predictions;
+  Predict(predictors, predictions);
+
+  size_t count = 0;
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    if (predictions[i] == labels[i])
+      ++count;
+
+  return (double) (count * 100) / labels.n_elem;
+}
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_IMPL_HPP
@@ -0,0 +1,183 @@
+/**
+ * @file softmax_regression_main.cpp
+ *
+ * Main executable for softmax regression.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include "softmax_regression.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::regression;
+using namespace mlpack::optimization;
+
+PROGRAM_INFO("L2-regularized Softmax Regression and Prediction",
+    "An implementation of L2-regularized softmax (multinomial logistic) "
+    "regression, trained with the L-BFGS optimizer.  This generalizes logistic "
+    "regression to any number of classes: the model has one row of parameters "
+    "for each class, and the probability of each class for a point x is\n"
+    "\n"
+    "  p(k | x) = e^(b_k + w_k * x) / sum_j e^(b_j + w_j * x).\n"
+    "\n"
+    "All classes are trained at once, so this is much faster than training one "
+    "logistic regression model per class.  The matrix of predictors is given "
+    "with --input_file; the labels are either the last dimension of that "
+    "matrix, or a separate file given with --labels_file.  Labels can be any "
+    "values; each distinct value is one class.  After training, the "
+    "parameters are saved to the file given by --output_file; an initial "
+    "model can be given with --model_file.  The maximum number of iterations "
+    "of the optimizer can be set with --max_iterations, and its tolerance with"
+    " --tolerance.  L2-regularization is set with --lambda (by default 0).\n"
+    "\n"
+    "If --test_file is given, the classes of the points in it are predicted "
+    "and saved to the file given with --output_predictions.  The --test_file "
+    "option can be given without --input_file if an existing model is given "
+    "with --model_file; since the original labels are then unknown, the "
+    "predictions are class indices (starting at 0).");
+
+PARAM_STRING("input_file", "File containing the training set.", "i", "");
+PARAM_STRING("labels_file", "Optional file containing the labels of the "
+    "training set.  If not given, the last dimension of the training set is "
+    "used as the labels.", "l", "");
+PARAM_STRING("model_file", "File containing existing model (parameters).", "m",
+    "");
+PARAM_STRING("output_file", "File where parameters will be saved.", "o", "");
+PARAM_STRING("test_file", "File containing test dataset.", "t", "");
+PARAM_STRING("output_predictions", "If --test_file is specified, this file is "
+    "where the predicted classes will be saved.", "p", "predictions.csv");
+PARAM_DOUBLE("lambda", "L2-regularization parameter for training.", "r", 0.0);
+PARAM_DOUBLE("tolerance", "Convergence tolerance for the optimizer.", "T",
+    1e-10);
+PARAM_INT("max_iterations", "Maximum iterations for the optimizer (0 "
+    "indicates no limit).", "n", 0);
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string inputFile = CLI::GetParam<string>("input_file");
+  const string labelsFile = CLI::GetParam<string>("labels_file");
+  const string modelFile = CLI::GetParam<string>("model_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string testFile = CLI::GetParam<string>("test_file");
+  const string outputPredictionsFile =
+      CLI::GetParam<string>("output_predictions");
+  const double lambda = CLI::GetParam<double>("lambda");
+  const double tolerance = CLI::GetParam<double>("tolerance");
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+
+  if (inputFile.empty() && modelFile.empty())
+    Log::Fatal << "One of --model_file or --input_file must be specified."
+        << endl;
+
+  if (maxIterations < 0)
+    Log::Fatal << "Maximum number of iterations (--max_iterations) must be "
+        << "non-negative (received " << maxIterations << ")." << endl;
+
+  arma::mat model;
+  if (!modelFile.empty())
+    data::Load(modelFile, model, true);
+
+  // The mapping from class indices to the original labels, if we train.
+  arma::vec mappings;
+
+  if (!inputFile.empty())
+  {
+    arma::mat trainingData;
+    data::Load(inputFile, trainingData, true);
+
+    arma::Col<size_t> labels;
+    if (!labelsFile.empty())
+    {
+      arma::mat rawLabels;
+      data::Load(labelsFile, rawLabels, true);
+      if (rawLabels.n_rows == 1)
+        rawLabels = trans(rawLabels);
+      if (rawLabels.n_rows != trainingData.n_cols)
+        Log::Fatal << "The labels (--labels_file) must have the same number "
+            << "of points as the training set (--input_file)." << endl;
+
+      data::NormalizeLabels(rawLabels.unsafe_col(0), labels, mappings);
+    }
+    else
+    {
+      Log::Info << "Using last dimension of training data as training labels."
+          << endl;
+      arma::vec rawLabels = trans(trainingData.row(trainingData.n_rows - 1));
+      data::NormalizeLabels(rawLabels, labels, mappings);
+      trainingData.shed_row(trainingData.n_rows - 1);
+    }
+
+    SoftmaxRegressionFunction srf(trainingData, labels, mappings.n_elem,
+        lambda);
+    if (!model.empty())
+    {
+      if ((model.n_rows != mappings.n_elem) ||
+          (model.n_cols != trainingData.n_rows + 1))
+        Log::Fatal << "The model (--model_file) must have one row for each "
+            << "class and one column more than the dimensionality of the "
+            << "training set." << endl;
+
+      srf.InitialPoint() = model;
+      Log::Info << "Using model from '" << modelFile << "' as initial model "
+          << "for training." << endl;
+    }
+
+    L_BFGS<SoftmaxRegressionFunction> lbfgsOpt(srf);
+    lbfgsOpt.MaxIterations() = (size_t) maxIterations;
+    lbfgsOpt.MinGradientNorm() = tolerance;
+    Log::Info << "Training model with L-BFGS optimizer (" << mappings.n_elem
+        << " classes)." << endl;
+
+    SoftmaxRegression<L_BFGS> sr(lbfgsOpt);
+    model = sr.Parameters();
+  }
+
+  if (!testFile.empty())
+  {
+    arma::mat testSet;
+    data::Load(testFile, testSet, true);
+
+    SoftmaxRegression<> sr(model, lambda);
+
+    Log::Info << "Predicting classes of points in '" << testFile << "'."
+        << endl;
+    arma::Col<size_t> predictions;
+    sr.Predict(testSet, predictions);
+
+    if (!outputPredictionsFile.empty())
+    {
+      if (mappings.n_elem > 0)
+      {
+        arma::vec labels;
+        data::RevertLabels(predictions, mappings, labels);
+        data::Save(outputPredictionsFile, labels, false, false);
+      }
+      else
+      {
+        data::Save(outputPredictionsFile, predictions, false, false);
+      }
+    }
+  }
+
+  if (!outputFile.empty())
+  {
+    Log::Info << "Saving model to '" << outputFile << "'." << endl;
+    data::Save(outputFile, model, false);
+  }
+}
@@ -23,6 +23,7 @@
 #define __MLPACK_METHODS_SPARSE_CODING_DATA_DEPENDENT_RANDOM_INITIALIZER_HPP
 
 #include <mlpack/core.hpp>
+#include "data_operations.hpp"
 
 namespace mlpack {
 namespace sparse_coding {
@@ -40,11 +41,12 @@ class DataDependentRandomInitializer
    * the data, and then normalizing the atom.  This implementation is simple
    * enough to be included with the definition.
    *
-   * @param data Dataset to initialize the dictionary with.
+   * @param data Dataset to initialize the dictionary with (dense or sparse).
    * @param atoms Number of atoms in dictionary.
    * @param dictionary Dictionary to initialize.
    */
-  static void Initialize(const arma::mat& data,
+  template<typename MatType>
+  static void Initialize(const MatType& data,
                          const size_t atoms,
                          arma::mat& dictionary)
   {
@@ -55,9 +57,9 @@ class DataDependentRandomInitializer
     for (size_t i = 0; i < atoms; ++i)
     {
       // Add three atoms together.
-      dictionary.col(i) = (data.col(math::RandInt(data.n_cols)) +
-          data.col(math::RandInt(data.n_cols)) +
-          data.col(math::RandInt(data.n_cols)));
+      dictionary.col(i) = (Column(data, math::RandInt(data.n_cols)) +
+          Column(data, math::RandInt(data.n_cols)) +
+          Column(data, math::RandInt(data.n_cols)));
 
       // Now normalize the atom.
       dictionary.col(i) /= norm(dictionary.col(i), 2);
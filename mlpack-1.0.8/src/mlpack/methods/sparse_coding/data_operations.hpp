@@ -0,0 +1,127 @@
+/**
+ * @file data_operations.hpp
+ *
+ * Operations on the data matrix used by SparseCoding and LocalCoordinateCoding,
+ * with overloads for dense and sparse data.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SPARSE_CODING_DATA_OPERATIONS_HPP
+#define __MLPACK_METHODS_SPARSE_CODING_DATA_OPERATIONS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace sparse_coding {
+
+//! Return a dense copy of the given column of the data.
+inline arma::vec Column(const arma::mat& data, const size_t col)
+{
+  return data.col(col);
+}
+
+//! Return a dense copy of the given column of the sparse data.
+inline arma::vec Column(const arma::sp_mat& data, const size_t col)
+{
+  arma::vec point = arma::zeros<arma::vec>(data.n_rows);
+  for (size_t k = data.col_ptrs[col]; k < data.col_ptrs[col + 1]; ++k)
+    point[data.row_indices[k]] = data.values[k];
+
+  return point;
+}
+
+//! Add the given multiple of a column of the data (transposed) to a row of the
+//! matrix.
+inline void AddColumnToRow(const arma::mat& data,
+                           const size_t col,
+                           const double scale,
+                           arma::mat& m,
+                           const size_t row)
+{
+  m.row(row) += scale * trans(data.col(col));
+}
+
+//! Add the given multiple of a column of the sparse data (transposed) to a row
+//! of the matrix, looking only at the nonzero elements.
+inline void AddColumnToRow(const arma::sp_mat& data,
+                           const size_t col,
+                           const double scale,
+                           arma::mat& m,
+                           const size_t row)
+{
+  for (size_t k = data.col_ptrs[col]; k < data.col_ptrs[col + 1]; ++k)
+    m(row, data.row_indices[k]) += scale * data.values[k];
+}
+
+//! Return the squared l2-norm of each column of the data.
+inline arma::rowvec ColumnSquaredNorms(const arma::mat& data)
+{
+  return sum(square(data));
+}
+
+//! Return the squared l2-norm of each column of the sparse data, looking only
+//! at the nonzero elements.
+inline arma::rowvec ColumnSquaredNorms(const arma::sp_mat& data)
+{
+  arma::rowvec norms = arma::zeros<arma::rowvec>(data.n_cols);
+  for (size_t col = 0; col < data.n_cols; ++col)
+    for (size_t k = data.col_ptrs[col]; k < data.col_ptrs[col + 1]; ++k)
+      norms[col] += data.values[k] * data.values[k];
+
+  return norms;
+}
+
+/**
+ * Return the squared Frobenius norm of the residual X - D Z.
+ *
+ * @param data Data matrix X (columns are points).
+ * @param dictionary Dictionary D (columns are atoms).
+ * @param codes Codes Z (columns are points).
+ */
+inline double SquaredResidualNorm(const arma::mat& data,
+                                  const arma::mat& dictionary,
+                                  const arma::mat& codes)
+{
+  return std::pow(norm(data - dictionary * codes, "fro"), 2.0);
+}
+
+/**
+ * Return the squared Frobenius norm of the residual X - D Z for sparse X,
+ * without forming the dense residual, by expanding it into
+ * ||X||^2 - 2 tr(Z^T D^T X) + tr((D^T D) (Z Z^T)).  Only D^T X needs a product
+ * with the data.
+ *
+ * @param data Sparse data matrix X (columns are points).
+ * @param dictionary Dictionary D (columns are atoms).
+ * @param codes Codes Z (columns are points).
+ */
+inline double SquaredResidualNorm(const arma::sp_mat& data,
+                                  const arma::mat& dictionary,
+                                  const arma::mat& codes)
+{
+  const double dataNorm = accu(ColumnSquaredNorms(data));
+  const arma::mat dictTX = trans(dictionary) * data;
+  const double residual = dataNorm - 2.0 * accu(codes % dictTX) +
+      accu((trans(dictionary) * dictionary) % (codes * trans(codes)));
+
+  // Rounding can make the expansion slightly negative.
+  return std::max(residual, 0.0);
+}
+
+}; // namespace sparse_coding
+}; // namespace mlpack
+
+#endif
@@ -44,7 +44,8 @@ class RandomInitializer
    * @param atoms Number of atoms (columns) in the dictionary.
    * @param dictionary Dictionary to initialize.
    */
-  static void Initialize(const arma::mat& data,
+  template<typename MatType>
+  static void Initialize(const MatType& data,
                          const size_t atoms,
                          arma::mat& dictionary)
   {
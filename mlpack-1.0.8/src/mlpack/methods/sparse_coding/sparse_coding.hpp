@@ -31,6 +31,8 @@
 #include "data_dependent_random_initializer.hpp"
 #include "random_initializer.hpp"
 
+#include "data_operations.hpp"
+
 namespace mlpack {
 namespace sparse_coding {
 
@@ -57,7 +59,9 @@ namespace sparse_coding {
  * This problem is solved by an algorithm that alternates between a dictionary
  * learning step and a sparse coding step. The dictionary learning step updates
  * the dictionary D using a Newton method based on the Lagrange dual (see the
- * paper below for details). The sparse coding step involves solving a large
+ * paper below for details), or, if BlockCoordinate() is set, by the cheaper
+ * block coordinate descent of online dictionary learning (Mairal et al., 2010).
+ * The sparse coding step involves solving a large
  * number of sparse linear regression problems; this can be done efficiently
  * using LARS, an algorithm that can solve the LASSO or the Elastic Net (papers
  * below).
@@ -111,11 +115,18 @@ namespace sparse_coding {
  * does not initialize the dictionary -- instead, the user should set the
  * dictionary using the Dictionary() mutator method.
  *
+ * The data may be dense (arma::mat) or sparse (arma::sp_mat).  With sparse
+ * data, the products with the data in the coding step, the dictionary step and
+ * the objective use sparse kernels, and the data is never densified; only one
+ * point at a time is copied to a dense vector, to be coded.
+ *
  * @tparam DictionaryInitializationPolicy The class to use to initialize the
- *     dictionary; must have 'void Initialize(const arma::mat& data, arma::mat&
- *     dictionary)' function.
+ *     dictionary; must have 'void Initialize(const MatType& data, const size_t
+ *     atoms, arma::mat& dictionary)' function.
+ * @tparam MatType Type of the data matrix (arma::mat or arma::sp_mat).
  */
-template<typename DictionaryInitializer = DataDependentRandomInitializer>
+template<typename DictionaryInitializer = DataDependentRandomInitializer,
+         typename MatType = arma::mat>
 class SparseCoding
 {
  public:
@@ -127,7 +138,7 @@ class SparseCoding
    * @param lambda1 Regularization parameter for l1-norm penalty
    * @param lambda2 Regularization parameter for l2-norm penalty
    */
-  SparseCoding(const arma::mat& data,
+  SparseCoding(const MatType& data,
                const size_t atoms,
                const double lambda1,
                const double lambda2 = 0);
@@ -153,11 +164,14 @@ class SparseCoding
   void OptimizeCode();
 
   /**
-   * Learn dictionary via Newton method based on Lagrange dual.
+   * Learn dictionary via Newton method based on Lagrange dual.  The products
+   * Z Z^T and Z X^T are computed once, from the nonzero codes only, and each
+   * Newton step solves its systems with Cholesky factorizations.
    *
    * @param adjacencies Indices of entries (unrolled column by column) of
    *    the coding matrix Z that are non-zero (the adjacency matrix for the
-   *    bipartite graph of points and atoms).
+   *    bipartite graph of points and atoms), in increasing order, as given by
+   *    find(Codes()).
    * @param newtonTolerance Tolerance of the Newton's method optimizer.
    * @return the norm of the gradient of the Lagrange dual with respect to
    *    the dual variables
@@ -165,6 +179,25 @@ class SparseCoding
   double OptimizeDictionary(const arma::uvec& adjacencies,
                             const double newtonTolerance = 1e-6);
 
+  /**
+   * Learn dictionary by block coordinate descent, as in the online dictionary
+   * learning algorithm of Mairal et al. (2010): each atom in turn is set to
+   * minimize the residual with the other atoms fixed, and projected onto the
+   * unit ball.  This needs only Z Z^T and Z X^T (computed once, as for
+   * OptimizeDictionary()), and no factorization, so it is much cheaper than
+   * the Newton method for many atoms, although it does not solve the
+   * dictionary step exactly.
+   *
+   * @param adjacencies Indices of the nonzero entries of the coding matrix Z,
+   *    in increasing order (see OptimizeDictionary()).
+   * @param tolerance Stop when no atom changes by more than this in a pass.
+   * @param maxPasses Maximum number of passes over the atoms.
+   * @return the largest change of an atom in the last pass
+   */
+  double OptimizeDictionaryBlockCoordinate(const arma::uvec& adjacencies,
+                                           const double tolerance = 1e-6,
+                                           const size_t maxPasses = 100);
+
   /**
    * Project each atom of the dictionary back onto the unit ball, if necessary.
    */
@@ -176,7 +209,7 @@ class SparseCoding
   double Objective() const;
 
   //! Access the data.
-  const arma::mat& Data() const { return data; }
+  const MatType& Data() const { return data; }
 
   //! Access the dictionary.
   const arma::mat& Dictionary() const { return dictionary; }
@@ -188,12 +221,24 @@ class SparseCoding
   //! Modify the sparse codes.
   arma::mat& Codes() { return codes; }
 
+  //! Get the number of threads used for the coding step.
+  size_t Threads() const { return threads; }
+  //! Modify the number of threads used for the coding step (1 is serial, 0
+  //! uses all cores).
+  size_t& Threads() { return threads; }
+
+  //! Get whether Encode() learns the dictionary by block coordinate descent.
+  bool BlockCoordinate() const { return blockCoordinate; }
+  //! Modify whether Encode() learns the dictionary by block coordinate descent
+  //! (see OptimizeDictionaryBlockCoordinate()) instead of Newton's method.
+  bool& BlockCoordinate() { return blockCoordinate; }
+
  private:
   //! Number of atoms.
   size_t atoms;
 
   //! Data matrix (columns are points).
-  const arma::mat& data;
+  const MatType& data;
 
   //! Dictionary (columns are atoms).
   arma::mat dictionary;
@@ -206,6 +251,42 @@ class SparseCoding
 
   //! l2 regularization term.
   double lambda2;
+
+  //! The number of threads used for the coding step.
+  size_t threads;
+
+  //! Whether the dictionary is learned by block coordinate descent.
+  bool blockCoordinate;
+
+  //! Return the number of threads the coding step will use.
+  size_t NumThreads() const;
+
+  /**
+   * Find the atoms used by the nonzero codes.  activeIndices[j] is the index
+   * of atom j among the active atoms, or the number of atoms if atom j is
+   * inactive (also listed in inactiveAtoms).
+   */
+  void ActiveAtoms(const arma::uvec& adjacencies,
+                   std::vector<size_t>& activeIndices,
+                   std::vector<size_t>& inactiveAtoms) const;
+
+  /**
+   * Compute Z Z^T and Z X^T restricted to the active atoms, looking only at
+   * the nonzero codes: each point adds the outer products of its own nonzero
+   * codes.
+   */
+  void CodeProducts(const arma::uvec& adjacencies,
+                    const std::vector<size_t>& activeIndices,
+                    const size_t nActiveAtoms,
+                    arma::mat& codesZT,
+                    arma::mat& codesXT) const;
+
+  //! Reinitialize the given atom as the normalized sum of three random points.
+  void ResetAtom(const size_t atom);
+
+  //! Solve A X = B for symmetric positive definite A with its Cholesky factor,
+  //! or with a general solver if A is singular.
+  static arma::mat SolveSymmetric(const arma::mat& A, const arma::mat& B);
 };
 
 }; // namespace sparse_coding
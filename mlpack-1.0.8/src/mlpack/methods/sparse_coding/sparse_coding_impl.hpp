@@ -26,28 +26,36 @@
 // In case it hasn't already been included.
 #include "sparse_coding.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace sparse_coding {
 
-template<typename DictionaryInitializer>
-SparseCoding<DictionaryInitializer>::SparseCoding(const arma::mat& data,
-                                                  const size_t atoms,
-                                                  const double lambda1,
-                                                  const double lambda2) :
+template<typename DictionaryInitializer, typename MatType>
+SparseCoding<DictionaryInitializer, MatType>::SparseCoding(
+    const MatType& data,
+    const size_t atoms,
+    const double lambda1,
+    const double lambda2) :
     atoms(atoms),
     data(data),
     codes(atoms, data.n_cols),
     lambda1(lambda1),
-    lambda2(lambda2)
+    lambda2(lambda2),
+    threads(1),
+    blockCoordinate(false)
 {
   // Initialize the dictionary.
   DictionaryInitializer::Initialize(data, atoms, dictionary);
 }
 
-template<typename DictionaryInitializer>
-void SparseCoding<DictionaryInitializer>::Encode(const size_t maxIterations,
-                                                 const double objTolerance,
-                                                 const double newtonTolerance)
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::Encode(
+    const size_t maxIterations,
+    const double objTolerance,
+    const double newtonTolerance)
 {
   Timer::Start("sparse_coding");
 
@@ -75,7 +83,10 @@ void SparseCoding<DictionaryInitializer>::Encode(const size_t maxIterations,
 
     // First step: optimize the dictionary.
     Log::Info << "Performing dictionary step... " << std::endl;
-    OptimizeDictionary(adjacencies, newtonTolerance);
+    if (blockCoordinate)
+      OptimizeDictionaryBlockCoordinate(adjacencies, newtonTolerance);
+    else
+      OptimizeDictionary(adjacencies, newtonTolerance);
     Log::Info << "  Objective value: " << Objective() << "." << std::endl;
 
     // Second step: perform the coding.
@@ -106,136 +117,104 @@ void SparseCoding<DictionaryInitializer>::Encode(const size_t maxIterations,
   Timer::Stop("sparse_coding");
 }
 
-template<typename DictionaryInitializer>
-void SparseCoding<DictionaryInitializer>::OptimizeCode()
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::OptimizeCode()
 {
   // When using the Cholesky version of LARS, this is correct even if
   // lambda2 > 0.
-  arma::mat matGram = trans(dictionary) * dictionary;
+  // The Gram matrix is computed once and shared by every point (and thread).
+  const arma::mat matGram = trans(dictionary) * dictionary;
 
-  for (size_t i = 0; i < data.n_cols; ++i)
+  // The points are independent, so they are coded in parallel; each one gets
+  // its own LARS object.
+  #pragma omp parallel for num_threads(NumThreads()) schedule(dynamic, 16)
+  for (int i = 0; i < (int) data.n_cols; ++i)
   {
     // Report progress.
     if ((i % 100) == 0)
+    {
+      #pragma omp critical
       Log::Debug << "Optimization at point " << i << "." << std::endl;
+    }
 
     bool useCholesky = true;
     regression::LARS lars(useCholesky, matGram, lambda1, lambda2);
 
     // Create an alias of the code (using the same memory), and then LARS will
     // place the result directly into that; then we will not need to have an
-    // extra copy.
+    // extra copy.  The columns of the codes are disjoint, so this is safe in
+    // parallel.
     arma::vec code = codes.unsafe_col(i);
-    lars.Regress(dictionary, data.unsafe_col(i), code, false);
+    lars.Regress(dictionary, Column(data, i), code, false);
   }
 }
 
 // Dictionary step for optimization.
-template<typename DictionaryInitializer>
-double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
+template<typename DictionaryInitializer, typename MatType>
+double SparseCoding<DictionaryInitializer, MatType>::OptimizeDictionary(
     const arma::uvec& adjacencies,
     const double newtonTolerance)
 {
-  // Count the number of atomic neighbors for each point x^i.
-  arma::uvec neighborCounts = arma::zeros<arma::uvec>(data.n_cols, 1);
-
-  if (adjacencies.n_elem > 0)
-  {
-    // This gets the column index.  Intentional integer division.
-    size_t curPointInd = (size_t) (adjacencies(0) / atoms);
-
-    size_t nextColIndex = (curPointInd + 1) * atoms;
-    for (size_t l = 1; l < adjacencies.n_elem; ++l)
-    {
-      // If l no longer refers to an element in this column, advance the column
-      // number accordingly.
-      if (adjacencies(l) >= nextColIndex)
-      {
-        curPointInd = (size_t) (adjacencies(l) / atoms);
-        nextColIndex = (curPointInd + 1) * atoms;
-      }
-
-      ++neighborCounts(curPointInd);
-    }
-  }
-
-  // Handle the case of inactive atoms (atoms not used in the given coding).
+  // Find the atoms used in the coding (the active atoms) and give each one its
+  // index among the active atoms.
+  std::vector<size_t> activeIndices;
   std::vector<size_t> inactiveAtoms;
-
-  for (size_t j = 0; j < atoms; ++j)
-  {
-    if (accu(codes.row(j) != 0) == 0)
-      inactiveAtoms.push_back(j);
-  }
+  ActiveAtoms(adjacencies, activeIndices, inactiveAtoms);
 
   const size_t nInactiveAtoms = inactiveAtoms.size();
   const size_t nActiveAtoms = atoms - nInactiveAtoms;
 
-  // Efficient construction of Z restricted to active atoms.
-  arma::mat matActiveZ;
-  if (nInactiveAtoms > 0)
-  {
-    math::RemoveRows(codes, inactiveAtoms, matActiveZ);
-  }
-
   if (nInactiveAtoms > 0)
   {
     Log::Warn << "There are " << nInactiveAtoms
         << " inactive atoms. They will be re-initialized randomly.\n";
   }
 
+  // Z Z^T and Z X^T restricted to the active atoms, computed once from the
+  // nonzero codes.
+  arma::mat codesZT;
+  arma::mat codesXT;
+  CodeProducts(adjacencies, activeIndices, nActiveAtoms, codesZT, codesXT);
+
   Log::Debug << "Solving Dual via Newton's Method.\n";
 
-  // Solve using Newton's method in the dual - note that the final dot
-  // multiplication with inv(A) seems to be unavoidable. Although more
-  // expensive, the code written this way (we use solve()) should be more
-  // numerically stable than just using inv(A) for everything.
+  // Solve using Newton's method in the dual.  Z Z^T + diag(dualVars) is
+  // symmetric positive definite, and so is the Hessian, so both are solved
+  // with their Cholesky factors.
   arma::vec dualVars = arma::zeros<arma::vec>(nActiveAtoms);
 
-  //vec dualVars = 1e-14 * ones<vec>(nActiveAtoms);
-
-  // Method used by feature sign code - fails miserably here.  Perhaps the
-  // MATLAB optimizer fmincon does something clever?
-  //vec dualVars = 10.0 * randu(nActiveAtoms, 1);
-
-  //vec dualVars = diagvec(solve(dictionary, data * trans(codes))
-  //    - codes * trans(codes));
-  //for (size_t i = 0; i < dualVars.n_elem; i++)
-  //  if (dualVars(i) < 0)
-  //    dualVars(i) = 0;
-
   bool converged = false;
 
-  // If we have any inactive atoms, we must construct these differently.
-  arma::mat codesXT;
-  arma::mat codesZT;
-
-  if (inactiveAtoms.empty())
-  {
-    codesXT = codes * trans(data);
-    codesZT = codes * trans(codes);
-  }
-  else
-  {
-    codesXT = matActiveZ * trans(data);
-    codesZT = matActiveZ * trans(matActiveZ);
-  }
-
   double normGradient;
   double improvement;
   for (size_t t = 1; !converged; ++t)
   {
     arma::mat A = codesZT + diagmat(dualVars);
 
-    arma::mat matAInvZXT = solve(A, codesXT);
+    arma::mat matAInvZXT;
+    arma::mat AInv;
+    arma::mat R;
+    if (arma::chol(R, A))
+    {
+      const arma::mat RInv = solve(trimatu(R), arma::eye<arma::mat>(
+          nActiveAtoms, nActiveAtoms));
+      AInv = RInv * trans(RInv);
+      matAInvZXT = RInv * (trans(RInv) * codesXT);
+    }
+    else
+    {
+      // A is singular (for instance, an atom is used by a single point and
+      // its dual variable is still 0).
+      AInv = inv(A);
+      matAInvZXT = solve(A, codesXT);
+    }
 
     arma::vec gradient = -arma::sum(arma::square(matAInvZXT), 1);
     gradient += 1;
 
-    arma::mat hessian = -(-2 * (matAInvZXT * trans(matAInvZXT)) % inv(A));
+    arma::mat hessian = 2 * (matAInvZXT * trans(matAInvZXT)) % AInv;
 
-    arma::vec searchDirection = -solve(hessian, gradient);
-    //printf("%e\n", norm(searchDirection, 2));
+    arma::vec searchDirection = -SolveSymmetric(hessian, gradient);
 
     // Armijo line search.
     const double c = 1e-4;
@@ -243,14 +222,15 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
     const double rho = 0.9;
     double sufficientDecrease = c * dot(gradient, searchDirection);
 
+    // The objective is sum(dualVars) + tr(X Z^T A^-1 Z X^T).
+    const double sumDualVars = sum(dualVars);
+    const double fOld = accu(codesXT % matAInvZXT) + sumDualVars;
     while (true)
     {
-      // Calculate objective.
-      double sumDualVars = sum(dualVars);
-      double fOld = -(-trace(trans(codesXT) * matAInvZXT) - sumDualVars);
-      double fNew = -(-trace(trans(codesXT) * solve(codesZT +
-          diagmat(dualVars + alpha * searchDirection), codesXT)) -
-          (sumDualVars + alpha * sum(searchDirection)));
+      const arma::mat matNewAInvZXT = SolveSymmetric(codesZT +
+          diagmat(dualVars + alpha * searchDirection), codesXT);
+      const double fNew = accu(codesXT % matNewAInvZXT) +
+          (sumDualVars + alpha * accu(searchDirection));
 
       if (fNew <= fOld + alpha * sufficientDecrease)
       {
@@ -274,46 +254,173 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
       converged = true;
   }
 
-  if (inactiveAtoms.empty())
+  const arma::mat activeDictionary = SolveSymmetric(codesZT +
+      diagmat(dualVars), codesXT);
+
+  // Update the active atoms, and reinitialize the inactive ones.
+  for (size_t i = 0; i < atoms; ++i)
   {
-    // Directly update dictionary.
-    dictionary = trans(solve(codesZT + diagmat(dualVars), codesXT));
+    if (activeIndices[i] == atoms)
+      ResetAtom(i);
+    else
+      dictionary.col(i) = trans(activeDictionary.row(activeIndices[i]));
   }
-  else
+
+  return normGradient;
+}
+
+// Block coordinate descent dictionary step.
+template<typename DictionaryInitializer, typename MatType>
+double SparseCoding<DictionaryInitializer, MatType>::
+    OptimizeDictionaryBlockCoordinate(const arma::uvec& adjacencies,
+                                      const double tolerance,
+                                      const size_t maxPasses)
+{
+  std::vector<size_t> activeIndices;
+  std::vector<size_t> inactiveAtoms;
+  ActiveAtoms(adjacencies, activeIndices, inactiveAtoms);
+
+  if (inactiveAtoms.size() > 0)
   {
-    arma::mat activeDictionary = trans(solve(codesZT +
-        diagmat(dualVars), codesXT));
+    Log::Warn << "There are " << inactiveAtoms.size()
+        << " inactive atoms. They will be re-initialized randomly.\n";
+  }
 
-    // Update all atoms.
-    size_t currentInactiveIndex = 0;
-    for (size_t i = 0; i < atoms; ++i)
+  // The sums of the online dictionary learning algorithm: A = Z Z^T and
+  // B^T = Z X^T, restricted to the active atoms.
+  const size_t nActiveAtoms = atoms - inactiveAtoms.size();
+  arma::mat codesZT;
+  arma::mat codesXT;
+  CodeProducts(adjacencies, activeIndices, nActiveAtoms, codesZT, codesXT);
+
+  // The active atoms, in the order of codesZT.
+  arma::mat activeDictionary(dictionary.n_rows, nActiveAtoms);
+  for (size_t i = 0; i < atoms; ++i)
+    if (activeIndices[i] != atoms)
+      activeDictionary.col(activeIndices[i]) = dictionary.col(i);
+
+  // Minimize the residual over each atom in turn (within the unit ball), with
+  // the other atoms fixed; the residual of atom j is B_j - D A_j.
+  double maxChange = 0.0;
+  for (size_t pass = 0; pass < maxPasses; ++pass)
+  {
+    maxChange = 0.0;
+    for (size_t j = 0; j < nActiveAtoms; ++j)
     {
-      if (inactiveAtoms[currentInactiveIndex] == i)
-      {
-        // This atom is inactive.  Reinitialize it randomly.
-        dictionary.col(i) = (data.col(math::RandInt(data.n_cols)) +
-                             data.col(math::RandInt(data.n_cols)) +
-                             data.col(math::RandInt(data.n_cols)));
+      arma::vec atom = activeDictionary.col(j) + (trans(codesXT.row(j)) -
+          activeDictionary * codesZT.col(j)) / codesZT(j, j);
+      atom /= std::max(norm(atom, 2), 1.0);
 
-        dictionary.col(i) /= norm(dictionary.col(i), 2);
+      maxChange = std::max(maxChange, norm(atom - activeDictionary.col(j), 2));
+      activeDictionary.col(j) = atom;
+    }
 
-        // Increment inactive index counter.
-        ++currentInactiveIndex;
-      }
-      else
-      {
-        // Update estimate.
-        dictionary.col(i) = activeDictionary.col(i - currentInactiveIndex);
-      }
+    Log::Debug << "Block coordinate descent pass " << pass << ": largest atom "
+        << "change " << std::scientific << maxChange << "." << std::endl;
+
+    if (maxChange < tolerance)
+      break;
+  }
+
+  for (size_t i = 0; i < atoms; ++i)
+  {
+    if (activeIndices[i] == atoms)
+      ResetAtom(i);
+    else
+      dictionary.col(i) = activeDictionary.col(activeIndices[i]);
+  }
+
+  return maxChange;
+}
+
+// Find the active atoms of the coding.
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::ActiveAtoms(
+    const arma::uvec& adjacencies,
+    std::vector<size_t>& activeIndices,
+    std::vector<size_t>& inactiveAtoms) const
+{
+  std::vector<bool> used(atoms, false);
+  for (size_t l = 0; l < adjacencies.n_elem; ++l)
+    used[adjacencies[l] % atoms] = true;
+
+  activeIndices.assign(atoms, atoms);
+  inactiveAtoms.clear();
+  size_t nActiveAtoms = 0;
+  for (size_t j = 0; j < atoms; ++j)
+  {
+    if (used[j])
+      activeIndices[j] = nActiveAtoms++;
+    else
+      inactiveAtoms.push_back(j);
+  }
+}
+
+// Compute Z Z^T and Z X^T from the nonzero codes.
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::CodeProducts(
+    const arma::uvec& adjacencies,
+    const std::vector<size_t>& activeIndices,
+    const size_t nActiveAtoms,
+    arma::mat& codesZT,
+    arma::mat& codesXT) const
+{
+  codesZT.zeros(nActiveAtoms, nActiveAtoms);
+  codesXT.zeros(nActiveAtoms, data.n_rows);
+
+  // The adjacencies are sorted, so the nonzero codes of each point are
+  // contiguous: [begin, end) holds those of the current point.
+  size_t begin = 0;
+  while (begin < adjacencies.n_elem)
+  {
+    const size_t point = adjacencies[begin] / atoms;
+    size_t end = begin + 1;
+    while (end < adjacencies.n_elem && adjacencies[end] / atoms == point)
+      ++end;
+
+    for (size_t p = begin; p < end; ++p)
+    {
+      const size_t atomP = activeIndices[adjacencies[p] % atoms];
+      const double codeP = codes[adjacencies[p]];
+
+      for (size_t q = begin; q < end; ++q)
+        codesZT(activeIndices[adjacencies[q] % atoms], atomP) +=
+            codeP * codes[adjacencies[q]];
+
+      AddColumnToRow(data, point, codeP, codesXT, atomP);
     }
+
+    begin = end;
   }
-  //printf("final reconstruction error: %e\n", norm(data - dictionary * codes, "fro"));
-  return normGradient;
+}
+
+// Reinitialize an atom randomly.
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::ResetAtom(const size_t atom)
+{
+  dictionary.col(atom) = (Column(data, math::RandInt(data.n_cols)) +
+                          Column(data, math::RandInt(data.n_cols)) +
+                          Column(data, math::RandInt(data.n_cols)));
+
+  dictionary.col(atom) /= norm(dictionary.col(atom), 2);
+}
+
+// Solve a symmetric positive definite system with its Cholesky factor.
+template<typename DictionaryInitializer, typename MatType>
+arma::mat SparseCoding<DictionaryInitializer, MatType>::SolveSymmetric(
+    const arma::mat& A,
+    const arma::mat& B)
+{
+  arma::mat R;
+  if (arma::chol(R, A))
+    return solve(trimatu(R), solve(trimatl(trans(R)), B));
+  else
+    return solve(A, B);
 }
 
 // Project each atom of the dictionary back into the unit ball (if necessary).
-template<typename DictionaryInitializer>
-void SparseCoding<DictionaryInitializer>::ProjectDictionary()
+template<typename DictionaryInitializer, typename MatType>
+void SparseCoding<DictionaryInitializer, MatType>::ProjectDictionary()
 {
   for (size_t j = 0; j < atoms; j++)
   {
@@ -328,24 +435,32 @@ void SparseCoding<DictionaryInitializer>::ProjectDictionary()
 }
 
 // Compute the objective function.
-template<typename DictionaryInitializer>
-double SparseCoding<DictionaryInitializer>::Objective() const
+template<typename DictionaryInitializer, typename MatType>
+double SparseCoding<DictionaryInitializer, MatType>::Objective() const
 {
   double l11NormZ = sum(sum(abs(codes)));
-  double froNormResidual = norm(data - (dictionary * codes), "fro");
+  double sqNormResidual = SquaredResidualNorm(data, dictionary, codes);
 
   if (lambda2 > 0)
   {
     double froNormZ = norm(codes, "fro");
-    return 0.5 * (std::pow(froNormResidual, 2.0) + (lambda2 *
-        std::pow(froNormZ, 2.0))) + (lambda1 * l11NormZ);
+    return 0.5 * (sqNormResidual + (lambda2 * std::pow(froNormZ, 2.0))) +
+        (lambda1 * l11NormZ);
   }
   else // It can be simpler.
   {
-    return 0.5 * std::pow(froNormResidual, 2.0) + lambda1 * l11NormZ;
+    return 0.5 * sqNormResidual + lambda1 * l11NormZ;
   }
 }
 
+template<typename DictionaryInitializer, typename MatType>
+size_t SparseCoding<DictionaryInitializer, MatType>::NumThreads() const
+{
+  size_t numThreads = Threads::Count(threads);
+
+  return numThreads;
+}
+
 }; // namespace sparse_coding
 }; // namespace mlpack
 
@@ -49,7 +49,13 @@ PROGRAM_INFO("Sparse Coding", "An implementation of Sparse Coding with "
     "\n\n"
     "The maximum number of iterations may be specified with the -n option. "
     "Optionally, the input data matrix X can be normalized before coding with "
-    "the -N option.");
+    "the -N option.  The points are coded in parallel with the number of "
+    "threads given by -j (0 uses all cores)."
+    "\n\n"
+    "The dictionary is learned with Newton's method on the Lagrange dual; with "
+    "--block_coordinate (-b), it is instead learned by block coordinate "
+    "descent over the atoms, which is much faster for many atoms but does not "
+    "solve each dictionary step exactly.");
 
 PARAM_STRING_REQ("input_file", "Filename of the input data.", "i");
 PARAM_INT_REQ("atoms", "Number of atoms in the dictionary.", "k");
@@ -80,6 +86,12 @@ PARAM_DOUBLE("objective_tolerance", "Tolerance for convergence of the objective"
 PARAM_DOUBLE("newton_tolerance", "Tolerance for convergence of Newton method.",
     "w", 1e-6);
 
+PARAM_INT("threads", "Number of threads to use for the coding step (0 uses all "
+    "available cores).", "j", 1);
+
+PARAM_FLAG("block_coordinate", "If set, learn the dictionary by block "
+    "coordinate descent instead of Newton's method.", "b");
+
 using namespace arma;
 using namespace std;
 using namespace mlpack;
@@ -112,6 +124,11 @@ int main(int argc, char* argv[])
   const double objTolerance = CLI::GetParam<double>("objective_tolerance");
   const double newtonTolerance = CLI::GetParam<double>("newton_tolerance");
 
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
   mat matX;
   data::Load(inputFile, matX, true);
 
@@ -150,6 +167,8 @@ int main(int argc, char* argv[])
     }
 
     // Run sparse coding.
+    sc.Threads() = (size_t) threads;
+    sc.BlockCoordinate() = CLI::HasParam("block_coordinate");
     sc.Encode(maxIterations, objTolerance, newtonTolerance);
 
     // Save the results.
@@ -164,6 +183,8 @@ int main(int argc, char* argv[])
     SparseCoding<> sc(matX, atoms, lambda1, lambda2);
 
     // Run sparse coding.
+    sc.Threads() = (size_t) threads;
+    sc.BlockCoordinate() = CLI::HasParam("block_coordinate");
     sc.Encode(maxIterations, objTolerance, newtonTolerance);
 
     // Save the results.
@@ -0,0 +1,95 @@
+/**
+ * @file clustered_embedding_generator.cpp
+ *
+ * Implementation of the ClusteredEmbeddingGenerator class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "clustered_embedding_generator.hpp"
+
+using namespace mlpack;
+using namespace mlpack::synthetic;
+
+ClusteredEmbeddingGenerator::ClusteredEmbeddingGenerator(
+    const size_t dimensionality,
+    const size_t clusters,
+    const size_t intrinsicDimensionality,
+    const double spread,
+    const double noise,
+    const bool normalize) :
+    intrinsicDimensionality(intrinsicDimensionality),
+    spread(spread),
+    noise(noise),
+    normalize(normalize),
+    centers(dimensionality, clusters),
+    bases(clusters)
+{
+  if (dimensionality == 0 || clusters == 0)
+    Log::Fatal << "ClusteredEmbeddingGenerator::ClusteredEmbeddingGenerator(): "
+        << "the dimensionality and the number of clusters must be positive."
+        << std::endl;
+
+  if (intrinsicDimensionality > dimensionality)
+    Log::Fatal << "ClusteredEmbeddingGenerator::ClusteredEmbeddingGenerator(): "
+        << "the intrinsic dimensionality (" << intrinsicDimensionality << ") "
+        << "cannot be larger than the dimensionality (" << dimensionality
+        << ")." << std::endl;
+
+  math::RandNormal(centers);
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    centers.col(c) /= arma::norm(centers.col(c), 2);
+
+    if (intrinsicDimensionality == 0)
+      continue;
+
+    // The Q factor of a Gaussian matrix is a random orthonormal basis.
+    arma::mat gaussian(dimensionality, intrinsicDimensionality);
+    math::RandNormal(gaussian);
+    arma::mat q, r;
+    arma::qr(q, r, gaussian);
+    bases[c] = q.cols(0, intrinsicDimensionality - 1);
+  }
+}
+
+void ClusteredEmbeddingGenerator::Generate(const size_t points,
+                                           arma::mat& data,
+                                           arma::Col<size_t>& labels) const
+{
+  labels.set_size(points);
+  for (size_t i = 0; i < points; ++i)
+    labels[i] = (size_t) math::RandInt((int) Clusters());
+
+  arma::mat coordinates(intrinsicDimensionality, points);
+  math::RandNormal(coordinates);
+  data.set_size(Dimensionality(), points);
+  math::RandNormal(data);
+  data *= noise;
+
+  for (size_t i = 0; i < points; ++i)
+  {
+    data.col(i) += centers.col(labels[i]);
+    if (intrinsicDimensionality > 0)
+      data.col(i) += spread * (bases[labels[i]] * coordinates.col(i));
+
+    if (normalize)
+    {
+      const double norm = arma::norm(data.col(i), 2);
+      if (norm > 0.0)
+        data.col(i) /= norm;
+    }
+  }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file clustered_embedding_generator.hpp
+ *
+ * Definition of the ClusteredEmbeddingGenerator class, which draws
+ * high-dimensional points that lie near low-dimensional clusters.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SYNTHETIC_CLUSTERED_EMBEDDING_GENERATOR_HPP
+#define __MLPACK_METHODS_SYNTHETIC_CLUSTERED_EMBEDDING_GENERATOR_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace synthetic {
+
+/**
+ * Draws high-dimensional points which look like learned embeddings (of words,
+ * images or users): each point lies near one of a number of clusters, each
+ * cluster spans a random low-dimensional subspace around its center, and the
+ * points are normalized to unit length.  The intrinsic dimensionality of such
+ * data is much lower than its dimensionality, which is what makes trees
+ * useful on it; uniform random data of the same dimensionality is much harder
+ * than real embeddings.
+ *
+ * A point of cluster c is
+ *
+ * @f[
+ * x = \mu_c + s B_c z + \sigma e,
+ * @f]
+ *
+ * where the center @f$ \mu_c @f$ is a random unit vector, @f$ B_c @f$ is a
+ * random orthonormal basis of the cluster's subspace, @f$ z @f$ and @f$ e @f$
+ * are standard normal vectors, s is the spread of the clusters and
+ * @f$ \sigma @f$ the noise; x is then normalized, if requested.
+ *
+ * As with GaussianMixtureGenerator, the parameters are drawn when the
+ * generator is created, and the points can be drawn in any number of batches.
+ */
+class ClusteredEmbeddingGenerator
+{
+ public:
+  /**
+   * Create the clusters.
+   *
+   * @param dimensionality Dimensionality of the points.
+   * @param clusters Number of clusters.
+   * @param intrinsicDimensionality Dimensionality of the subspace of each
+   *     cluster.
+   * @param spread Standard deviation of the points in the subspace of their
+   *     cluster.
+   * @param noise Standard deviation of the noise in every dimension.
+   * @param normalize Whether the points are normalized to unit length.
+   */
+  ClusteredEmbeddingGenerator(const size_t dimensionality,
+                              const size_t clusters,
+                              const size_t intrinsicDimensionality,
+                              const double spread = 0.3,
+                              const double noise = 0.01,
+                              const bool normalize = true);
+
+  /**
+   * Draw the given number of points, with the cluster of each one.
+   *
+   * @param points Number of points to draw.
+   * @param data Matrix to store the points in (one per column).
+   * @param labels Vector to store the cluster of each point in.
+   */
+  void Generate(const size_t points,
+                arma::mat& data,
+                arma::Col<size_t>& labels) const;
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return centers.n_rows; }
+  //! Get the number of clusters.
+  size_t Clusters() const { return centers.n_cols; }
+  //! Get the dimensionality of the subspace of each cluster.
+  size_t IntrinsicDimensionality() const { return intrinsicDimensionality; }
+
+  //! Get the centers of the clusters (one per column).
+  const arma::mat& Centers() const { return centers; }
+  //! Get the bases of the subspaces of the clusters.
+  const std::vector<arma::mat>& Bases() const { return bases; }
+
+ private:
+  //! The dimensionality of the subspace of each cluster.
+  size_t intrinsicDimensionality;
+  //! The spread of the points in their subspace.
+  double spread;
+  //! The noise in every dimension.
+  double noise;
+  //! Whether the points are normalized.
+  bool normalize;
+
+  //! The centers of the clusters.
+  arma::mat centers;
+  //! The orthonormal bases of the subspaces of the clusters.
+  std::vector<arma::mat> bases;
+};
+
+}; // namespace synthetic
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file gaussian_mixture_generator.cpp
+ *
+ * Implementation of the GaussianMixtureGenerator class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gaussian_mixture_generator.hpp"
+
+#include <algorithm>
+
+using namespace mlpack;
+using namespace mlpack::synthetic;
+
+GaussianMixtureGenerator::GaussianMixtureGenerator(const size_t dimensionality,
+                                                   const size_t gaussians,
+                                                   const double separation) :
+    means(dimensionality, gaussians),
+    covariances(gaussians),
+    factors(gaussians),
+    weights(gaussians)
+{
+  if (dimensionality == 0 || gaussians == 0)
+    Log::Fatal << "GaussianMixtureGenerator::GaussianMixtureGenerator(): the "
+        << "dimensionality and the number of Gaussians must be positive."
+        << std::endl;
+
+  math::RandNormal(means);
+  means *= separation;
+
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    // A A^T / d has eigenvalues of about 1 at most; the added identity keeps
+    // the smallest away from 0.
+    arma::mat a(dimensionality, dimensionality);
+    math::RandNormal(a);
+    covariances[i] = a * trans(a) / (2.0 * dimensionality) +
+        0.1 * arma::eye<arma::mat>(dimensionality, dimensionality);
+    factors[i] = trans(arma::chol(covariances[i]));
+
+    weights[i] = 0.5 + math::Random();
+  }
+
+  weights /= arma::accu(weights);
+}
+
+void GaussianMixtureGenerator::Generate(const size_t points,
+                                        arma::mat& data,
+                                        arma::Col<size_t>& labels) const
+{
+  const arma::vec cdf = arma::cumsum(weights);
+  labels.set_size(points);
+  for (size_t i = 0; i < points; ++i)
+    labels[i] = RandomIndex(cdf);
+
+  // The standard normal draws are made in bulk, then transformed by the
+  // Gaussian of each point.
+  data.set_size(Dimensionality(), points);
+  math::RandNormal(data);
+  for (size_t i = 0; i < points; ++i)
+    data.col(i) = factors[labels[i]] * data.col(i) + means.col(labels[i]);
+}
+
+size_t mlpack::synthetic::RandomIndex(const arma::vec& cdf)
+{
+  const double value = math::Random();
+  const double* position = std::upper_bound(cdf.memptr(),
+      cdf.memptr() + cdf.n_elem, value);
+
+  // Rounding may leave the last cumulative probability just below 1.
+  return std::min((size_t) (position - cdf.memptr()), (size_t) cdf.n_elem - 1);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file gaussian_mixture_generator.hpp
+ *
+ * Definition of the GaussianMixtureGenerator class, which draws points from a
+ * random mixture of Gaussians.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SYNTHETIC_GAUSSIAN_MIXTURE_GENERATOR_HPP
+#define __MLPACK_METHODS_SYNTHETIC_GAUSSIAN_MIXTURE_GENERATOR_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace synthetic /** Synthetic datasets. */ {
+
+/**
+ * Draws points from a mixture of Gaussians with random parameters: the means
+ * are normally distributed with standard deviation 'separation' in each
+ * dimension, each covariance is a random positive definite matrix whose
+ * eigenvalues are between 0.1 and about 1, and the weights are random.  With
+ * the default separation the Gaussians overlap little, which suits k-means and
+ * GMM benchmarks; a separation near 1 gives overlapping clusters.
+ *
+ * The parameters are drawn when the generator is created, with the random
+ * number generator of mlpack (see math::RandomSeed()), and the points can then
+ * be drawn in any number of batches, so a dataset larger than memory can be
+ * written with data::ChunkWriter.
+ *
+ * @code
+ * GaussianMixtureGenerator generator(10, 5);
+ * arma::mat data;
+ * arma::Col<size_t> labels;
+ * generator.Generate(100000, data, labels);
+ * @endcode
+ */
+class GaussianMixtureGenerator
+{
+ public:
+  /**
+   * Create the mixture with random parameters.
+   *
+   * @param dimensionality Dimensionality of the points.
+   * @param gaussians Number of Gaussians.
+   * @param separation Standard deviation of the means in each dimension.
+   */
+  GaussianMixtureGenerator(const size_t dimensionality,
+                           const size_t gaussians,
+                           const double separation = 5.0);
+
+  /**
+   * Draw the given number of points from the mixture, with the index of the
+   * Gaussian each one was drawn from.
+   *
+   * @param points Number of points to draw.
+   * @param data Matrix to store the points in (one per column).
+   * @param labels Vector to store the index of the Gaussian of each point in.
+   */
+  void Generate(const size_t points,
+                arma::mat& data,
+                arma::Col<size_t>& labels) const;
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return means.n_rows; }
+  //! Get the number of Gaussians.
+  size_t Gaussians() const { return means.n_cols; }
+
+  //! Get the means of the Gaussians (one per column).
+  const arma::mat& Means() const { return means; }
+  //! Get the covariances of the Gaussians.
+  const std::vector<arma::mat>& Covariances() const { return covariances; }
+  //! Get the weights of the Gaussians.
+  const arma::vec& Weights() const { return weights; }
+
+ private:
+  //! The means of the Gaussians.
+  arma::mat means;
+  //! The covariances of the Gaussians.
+  std::vector<arma::mat> covariances;
+  //! The lower Cholesky factors of the covariances.
+  std::vector<arma::mat> factors;
+  //! The weights of the Gaussians.
+  arma::vec weights;
+};
+
+/**
+ * Draw an index from the given cumulative distribution (whose last element is
+ * 1): the first index whose cumulative probability exceeds a uniform random
+ * number.
+ *
+ * @param cdf Cumulative probabilities of the indices.
+ */
+size_t RandomIndex(const arma::vec& cdf);
+
+}; // namespace synthetic
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file hmm_sequence_generator.cpp
+ *
+ * Implementation of the HMMSequenceGenerator class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "hmm_sequence_generator.hpp"
+
+using namespace mlpack;
+using namespace mlpack::distribution;
+using namespace mlpack::synthetic;
+
+HMMSequenceGenerator::HMMSequenceGenerator(const size_t states,
+                                           const size_t dimensionality,
+                                           const double stayProbability,
+                                           const double separation) :
+    model(Transition(states, stayProbability),
+          Emissions(states, dimensionality, separation))
+{
+  // Nothing to do.
+}
+
+void HMMSequenceGenerator::Generate(const size_t length,
+                                    arma::mat& sequence,
+                                    arma::Col<size_t>& stateSequence) const
+{
+  if (length == 0)
+  {
+    sequence.set_size(model.Dimensionality(), 0);
+    stateSequence.set_size(0);
+    return;
+  }
+
+  model.Generate(length, sequence, stateSequence,
+      (size_t) math::RandInt((int) model.Transition().n_rows));
+}
+
+arma::mat HMMSequenceGenerator::Transition(const size_t states,
+                                           const double stayProbability)
+{
+  if (states == 0)
+    Log::Fatal << "HMMSequenceGenerator::HMMSequenceGenerator(): there must "
+        << "be at least one state." << std::endl;
+
+  if (stayProbability < 0.0 || stayProbability > 1.0)
+    Log::Fatal << "HMMSequenceGenerator::HMMSequenceGenerator(): the "
+        << "probability of staying in a state (" << stayProbability << ") must "
+        << "be between 0 and 1." << std::endl;
+
+  // Column i holds the probabilities of the states following state i.
+  arma::mat transition(states, states);
+  if (states == 1)
+  {
+    transition.fill(1.0);
+    return transition;
+  }
+
+  math::Random(transition);
+  for (size_t i = 0; i < states; ++i)
+  {
+    transition(i, i) = 0.0;
+    transition.col(i) *= (1.0 - stayProbability) /
+        arma::accu(transition.col(i));
+    transition(i, i) = stayProbability;
+  }
+
+  return transition;
+}
+
+std::vector<GaussianDistribution> HMMSequenceGenerator::Emissions(
+    const size_t states,
+    const size_t dimensionality,
+    const double separation)
+{
+  if (dimensionality == 0)
+    Log::Fatal << "HMMSequenceGenerator::HMMSequenceGenerator(): the "
+        << "dimensionality must be positive." << std::endl;
+
+  arma::mat means(dimensionality, states);
+  math::RandNormal(means);
+  means *= separation;
+
+  std::vector<GaussianDistribution> emissions;
+  for (size_t i = 0; i < states; ++i)
+    emissions.push_back(GaussianDistribution(means.col(i),
+        arma::eye<arma::mat>(dimensionality, dimensionality)));
+
+  return emissions;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file hmm_sequence_generator.hpp
+ *
+ * Definition of the HMMSequenceGenerator class, which draws observation
+ * sequences from a random hidden Markov model.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SYNTHETIC_HMM_SEQUENCE_GENERATOR_HPP
+#define __MLPACK_METHODS_SYNTHETIC_HMM_SEQUENCE_GENERATOR_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/hmm/hmm.hpp>
+
+namespace mlpack {
+namespace synthetic {
+
+/**
+ * Draws observation sequences from a random hidden Markov model with Gaussian
+ * emissions.  Each state stays the same from one step to the next with the
+ * given probability, and otherwise moves to another state chosen with random
+ * probabilities, so the sequences have runs of one state as real ones do; the
+ * emission of each state is a Gaussian with identity covariance and a normally
+ * distributed mean.  The first state of each sequence is uniformly random.
+ *
+ * As with GaussianMixtureGenerator, the model is drawn when the generator is
+ * created, and any number of sequences can be drawn from it.
+ */
+class HMMSequenceGenerator
+{
+ public:
+  /**
+   * Create the model with random parameters.
+   *
+   * @param states Number of hidden states.
+   * @param dimensionality Dimensionality of the observations.
+   * @param stayProbability Probability of staying in the same state.
+   * @param separation Standard deviation of the means of the emissions in
+   *     each dimension.
+   */
+  HMMSequenceGenerator(const size_t states,
+                       const size_t dimensionality,
+                       const double stayProbability = 0.9,
+                       const double separation = 3.0);
+
+  /**
+   * Draw a sequence of the given length, with its hidden states.
+   *
+   * @param length Length of the sequence.
+   * @param sequence Matrix to store the observations in (one per column).
+   * @param stateSequence Vector to store the hidden states in.
+   */
+  void Generate(const size_t length,
+                arma::mat& sequence,
+                arma::Col<size_t>& stateSequence) const;
+
+  //! Get the model the sequences are drawn from.
+  const hmm::HMM<distribution::GaussianDistribution>& Model() const
+  { return model; }
+
+ private:
+  //! The model.
+  hmm::HMM<distribution::GaussianDistribution> model;
+
+  //! Draw the transition matrix of the model.
+  static arma::mat Transition(const size_t states,
+                              const double stayProbability);
+
+  //! Draw the emissions of the model.
+  static std::vector<distribution::GaussianDistribution> Emissions(
+      const size_t states,
+      const size_t dimensionality,
+      const double separation);
+};
+
+}; // namespace synthetic
+}; // namespace mlpack
+
+#endif
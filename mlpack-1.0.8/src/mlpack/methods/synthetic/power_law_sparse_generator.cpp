@@ -0,0 +1,104 @@
+/**
+ * @file power_law_sparse_generator.cpp
+ *
+ * Implementation of the PowerLawSparseGenerator class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "power_law_sparse_generator.hpp"
+#include "gaussian_mixture_generator.hpp" // For RandomIndex().
+
+#include <set>
+
+using namespace mlpack;
+using namespace mlpack::synthetic;
+
+PowerLawSparseGenerator::PowerLawSparseGenerator(const size_t rows,
+                                                 const size_t cols,
+                                                 const double nonzerosPerColumn,
+                                                 const double exponent) :
+    cols(cols),
+    nonzerosPerColumn(nonzerosPerColumn),
+    exponent(exponent),
+    nextColumn(0),
+    rowCDF(rows)
+{
+  if (rows == 0)
+    Log::Fatal << "PowerLawSparseGenerator::PowerLawSparseGenerator(): the "
+        << "matrix must have at least one row." << std::endl;
+
+  if (nonzerosPerColumn < 1.0)
+    Log::Fatal << "PowerLawSparseGenerator::PowerLawSparseGenerator(): the "
+        << "mean number of nonzero elements in a column (" << nonzerosPerColumn
+        << ") must be at least 1." << std::endl;
+
+  if (exponent <= 0.0)
+    Log::Fatal << "PowerLawSparseGenerator::PowerLawSparseGenerator(): the "
+        << "exponent (" << exponent << ") must be positive." << std::endl;
+
+  for (size_t r = 0; r < rows; ++r)
+    rowCDF[r] = pow((double) (r + 1), -exponent);
+
+  rowCDF = arma::cumsum(rowCDF);
+  rowCDF /= rowCDF[rows - 1];
+}
+
+size_t PowerLawSparseGenerator::Generate(const size_t columns,
+                                         arma::mat& coordinates)
+{
+  const size_t count = std::min(columns, cols - nextColumn);
+
+  std::vector<double> elements;
+  for (size_t j = 0; j < count; ++j, ++nextColumn)
+  {
+    // Rejecting repeated rows is slow for columns which hold most rows, so the
+    // number of draws is limited; such a column may get fewer elements.
+    const size_t nonzeros = Nonzeros();
+    std::set<size_t> rows;
+    for (size_t draw = 0; (rows.size() < nonzeros) && (draw < 20 * nonzeros);
+         ++draw)
+      rows.insert(RandomIndex(rowCDF));
+
+    for (std::set<size_t>::const_iterator it = rows.begin(); it != rows.end();
+         ++it)
+    {
+      elements.push_back((double) *it);
+      elements.push_back((double) nextColumn);
+      elements.push_back((double) math::RandInt(1, 6));
+    }
+  }
+
+  coordinates.set_size(3, elements.size() / 3);
+  if (!elements.empty())
+    std::copy(elements.begin(), elements.end(), coordinates.memptr());
+
+  return count;
+}
+
+size_t PowerLawSparseGenerator::Nonzeros() const
+{
+  // The Pareto distribution with shape k and scale m has mean k m / (k - 1).
+  const double shape = exponent + 1.0;
+  const double scale = nonzerosPerColumn * (shape - 1.0) / shape;
+
+  // 1 - Random() is in (0, 1], so the power is defined.
+  const double nonzeros = scale / pow(1.0 - math::Random(), 1.0 / shape);
+
+  if (nonzeros >= (double) Rows())
+    return Rows();
+
+  return std::max((size_t) 1, (size_t) (nonzeros + 0.5));
+}
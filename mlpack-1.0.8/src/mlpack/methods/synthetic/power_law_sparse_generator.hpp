@@ -0,0 +1,114 @@
+/**
+ * @file power_law_sparse_generator.hpp
+ *
+ * Definition of the PowerLawSparseGenerator class, which draws sparse
+ * matrices whose row and column counts follow power laws.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_METHODS_SYNTHETIC_POWER_LAW_SPARSE_GENERATOR_HPP
+#define __MLPACK_METHODS_SYNTHETIC_POWER_LAW_SPARSE_GENERATOR_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace synthetic {
+
+/**
+ * Draws a sparse matrix like a matrix of ratings (items by users) or a
+ * document-term matrix: the number of nonzero elements of each column follows
+ * a Pareto distribution, and the nonzero elements of each column fall in rows
+ * chosen with probabilities following Zipf's law, so that a few rows and
+ * columns hold most of the elements.  Uniformly random sparse matrices have
+ * none of the skew (and none of the load imbalance) of real ones.
+ *
+ * Row r (starting at 0) is chosen with probability proportional to
+ * @f$ (r + 1)^{-a} @f$, where a is the exponent, and the number of nonzero
+ * elements of a column has a Pareto distribution with shape a + 1 and the given
+ * mean (it is rounded, and is between 1 and the number of rows).  The nonzero
+ * values are integers from 1 to 5, as ratings are.
+ *
+ * The matrix is generated as a coordinate list, a few columns at a time: each
+ * column of the list is (row, column, value) for one nonzero element, and the
+ * elements are in column-major order.  Written to a .csv or .txt file (for
+ * instance with data::ChunkWriter), the list is a sparse coordinate file which
+ * data::Load() reads.
+ *
+ * @code
+ * PowerLawSparseGenerator generator(100000, 1000000, 20);
+ * arma::mat coordinates;
+ * while (generator.Generate(10000, coordinates) > 0)
+ * {
+ *   // Use the elements of the next (at most) 10000 columns.
+ * }
+ * @endcode
+ */
+class PowerLawSparseGenerator
+{
+ public:
+  /**
+   * Create the generator for a matrix of the given size.
+   *
+   * @param rows Number of rows of the matrix.
+   * @param cols Number of columns of the matrix.
+   * @param nonzerosPerColumn Mean number of nonzero elements in a column.
+   * @param exponent Exponent of Zipf's law for the rows; larger is more skewed.
+   */
+  PowerLawSparseGenerator(const size_t rows,
+                          const size_t cols,
+                          const double nonzerosPerColumn,
+                          const double exponent = 1.0);
+
+  /**
+   * Generate the nonzero elements of the next columns of the matrix.
+   *
+   * @param columns Largest number of columns to generate.
+   * @param coordinates Matrix to store the coordinate list in (three rows: the
+   *     row, the column and the value of each element).
+   * @return The number of columns generated; 0 once every column has been.
+   */
+  size_t Generate(const size_t columns, arma::mat& coordinates);
+
+  //! Start again from the first column.
+  void Reset() { nextColumn = 0; }
+
+  //! Get the number of rows of the matrix.
+  size_t Rows() const { return rowCDF.n_elem; }
+  //! Get the number of columns of the matrix.
+  size_t Cols() const { return cols; }
+  //! Get the number of columns generated so far.
+  size_t ColumnsGenerated() const { return nextColumn; }
+
+ private:
+  //! The number of columns of the matrix.
+  size_t cols;
+  //! The mean number of nonzero elements in a column.
+  double nonzerosPerColumn;
+  //! The exponent of the power laws.
+  double exponent;
+  //! The next column to generate.
+  size_t nextColumn;
+  //! The cumulative probabilities of the rows.
+  arma::vec rowCDF;
+
+  //! Draw the number of nonzero elements of a column.
+  size_t Nonzeros() const;
+};
+
+}; // namespace synthetic
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * @file synthetic_main.cpp
+ *
+ * Executable which writes large synthetic datasets in batches.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+
+#include "gaussian_mixture_generator.hpp"
+#include "clustered_embedding_generator.hpp"
+#include "power_law_sparse_generator.hpp"
+#include "hmm_sequence_generator.hpp"
+
+using namespace mlpack;
+using namespace mlpack::data;
+using namespace mlpack::synthetic;
+using namespace std;
+
+PROGRAM_INFO("Synthetic Datasets", "This program writes synthetic datasets of "
+    "any size, for benchmarks and experiments at realistic scales.  The "
+    "dataset is generated and written in batches of --batch_size points, so it "
+    "does not have to fit in memory; it is written in the mlpack binary format "
+    "(.mbin), which can be memory-mapped when it is loaded, or as CSV (.csv) or"
+    " raw ASCII (.txt).  The random seed is given with --seed (-s)."
+    "\n\n"
+    "The --type (-t) option chooses the dataset:"
+    "\n\n"
+    "  'gaussian_mixture': --points points of dimensionality --dimensionality "
+    "drawn from a random mixture of --clusters Gaussians, whose means have "
+    "standard deviation --separation;"
+    "\n\n"
+    "  'embedding': --points points of dimensionality --dimensionality, like "
+    "learned embeddings: each lies near one of --clusters random subspaces of "
+    "dimensionality --intrinsic_dimensionality (with standard deviation "
+    "--spread in the subspace and --noise in every dimension), and is "
+    "normalized to unit length unless --no_normalize is given;"
+    "\n\n"
+    "  'power_law': a sparse matrix with --rows rows and --points columns, "
+    "written as a coordinate list (each point is the row, the column and the "
+    "value of one nonzero element); the number of nonzero elements of a column "
+    "has a Pareto distribution with mean --nonzeros, and their rows follow "
+    "Zipf's law with exponent --exponent;"
+    "\n\n"
+    "  'hmm': --points sequences of length --length, one after the other, "
+    "drawn from a random HMM with --clusters states and Gaussian emissions of "
+    "dimensionality --dimensionality; each state is kept with probability "
+    "--stay_probability."
+    "\n\n"
+    "For every type but 'power_law', the cluster, Gaussian or hidden state of "
+    "each point can be written to --labels_file (-l).");
+
+PARAM_STRING_REQ("type", "Type of dataset: 'gaussian_mixture', 'embedding', "
+    "'power_law', or 'hmm'.", "t");
+PARAM_STRING_REQ("output_file", "File to write the dataset to (.mbin, .csv or "
+    ".txt).", "o");
+PARAM_STRING("labels_file", "File to write the labels of the points to.", "l",
+    "");
+
+PARAM_INT("points", "Number of points (columns for 'power_law', sequences for "
+    "'hmm').", "n", 10000);
+PARAM_INT("dimensionality", "Dimensionality of the points.", "d", 3);
+PARAM_INT("clusters", "Number of Gaussians, clusters, or hidden states.", "c",
+    10);
+PARAM_INT("batch_size", "Number of points generated and written at a time.",
+    "b", 100000);
+PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
+PARAM_DOUBLE("separation", "Standard deviation of the means of the Gaussians "
+    "or emissions ('gaussian_mixture' and 'hmm').", "S", 5.0);
+PARAM_INT("intrinsic_dimensionality", "Dimensionality of the subspace of each "
+    "cluster ('embedding').", "k", 5);
+PARAM_DOUBLE("spread", "Standard deviation of the points in the subspace of "
+    "their cluster ('embedding').", "", 0.3);
+PARAM_DOUBLE("noise", "Standard deviation of the noise in every dimension "
+    "('embedding').", "N", 0.01);
+PARAM_FLAG("no_normalize", "Do not normalize the points to unit length "
+    "('embedding').", "");
+PARAM_INT("rows", "Number of rows of the sparse matrix ('power_law').", "r",
+    10000);
+PARAM_DOUBLE("nonzeros", "Mean number of nonzero elements in a column "
+    "('power_law').", "z", 20.0);
+PARAM_DOUBLE("exponent", "Exponent of Zipf's law for the rows ('power_law').",
+    "e", 1.0);
+PARAM_INT("length", "Length of each sequence ('hmm').", "L", 100);
+PARAM_DOUBLE("stay_probability", "Probability of staying in the same hidden "
+    "state ('hmm').", "", 0.9);
+
+//! Write the given labels to the labels file, if there is one.
+void WriteLabels(ChunkWriter<size_t>* labelsWriter,
+                 const arma::Col<size_t>& labels)
+{
+  if (labelsWriter != NULL)
+  {
+    const arma::Mat<size_t> row = trans(labels);
+    labelsWriter->Write(row);
+  }
+}
+
+/**
+ * Write the given number of points from a generator of points with labels
+ * (GaussianMixtureGenerator or ClusteredEmbeddingGenerator), in batches.
+ */
+template<typename GeneratorType>
+void WritePoints(const GeneratorType& generator,
+                 const size_t points,
+                 const size_t batchSize,
+                 ChunkWriter<double>& writer,
+                 ChunkWriter<size_t>* labelsWriter)
+{
+  arma::mat batch;
+  arma::Col<size_t> labels;
+  for (size_t done = 0; done < points; done += batch.n_cols)
+  {
+    generator.Generate(std::min(batchSize, points - done), batch, labels);
+    writer.Write(batch);
+    WriteLabels(labelsWriter, labels);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string type = CLI::GetParam<string>("type");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string labelsFile = CLI::GetParam<string>("labels_file");
+  const int points = CLI::GetParam<int>("points");
+  const int dimensionality = CLI::GetParam<int>("dimensionality");
+  const int clusters = CLI::GetParam<int>("clusters");
+  const int batchSize = CLI::GetParam<int>("batch_size");
+
+  if (type != "gaussian_mixture" && type != "embedding" &&
+      type != "power_law" && type != "hmm")
+    Log::Fatal << "Unknown type '" << type << "'; it must be "
+        << "'gaussian_mixture', 'embedding', 'power_law', or 'hmm'." << endl;
+
+  if (points < 0)
+    Log::Fatal << "Number of points (" << points << ") cannot be negative."
+        << endl;
+  if (dimensionality <= 0)
+    Log::Fatal << "Dimensionality (" << dimensionality << ") must be positive."
+        << endl;
+  if (clusters <= 0)
+    Log::Fatal << "Number of clusters (" << clusters << ") must be positive."
+        << endl;
+  if (batchSize <= 0)
+    Log::Fatal << "Batch size (" << batchSize << ") must be positive." << endl;
+
+  if (type == "power_law" && labelsFile != "")
+    Log::Warn << "'power_law' datasets have no labels; --labels_file ignored."
+        << endl;
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) std::time(NULL));
+
+  Timer::Start("generation");
+  if (type == "power_law")
+  {
+    const int rows = CLI::GetParam<int>("rows");
+    if (rows <= 0)
+      Log::Fatal << "Number of rows (" << rows << ") must be positive." << endl;
+
+    PowerLawSparseGenerator generator((size_t) rows, (size_t) points,
+        CLI::GetParam<double>("nonzeros"), CLI::GetParam<double>("exponent"));
+
+    ChunkWriter<double> writer(outputFile, 3);
+    arma::mat coordinates;
+    while (generator.Generate((size_t) batchSize, coordinates) > 0)
+      writer.Write(coordinates);
+    writer.Close();
+
+    Log::Info << "Wrote " << writer.PointsWritten() << " nonzero elements of a"
+        << " " << rows << "x" << points << " matrix to '" << outputFile << "'."
+        << endl;
+  }
+  else
+  {
+    const size_t rows = (size_t) dimensionality;
+    ChunkWriter<double> writer(outputFile, rows);
+    ChunkWriter<size_t>* labelsWriter = (labelsFile == "") ? NULL :
+        new ChunkWriter<size_t>(labelsFile, 1);
+
+    if (type == "gaussian_mixture")
+    {
+      GaussianMixtureGenerator generator(rows, (size_t) clusters,
+          CLI::GetParam<double>("separation"));
+      WritePoints(generator, (size_t) points, (size_t) batchSize, writer,
+          labelsWriter);
+    }
+    else if (type == "embedding")
+    {
+      const int intrinsic = CLI::GetParam<int>("intrinsic_dimensionality");
+      if (intrinsic < 0)
+        Log::Fatal << "Intrinsic dimensionality (" << intrinsic << ") cannot "
+            << "be negative." << endl;
+
+      ClusteredEmbeddingGenerator generator(rows, (size_t) clusters,
+          (size_t) intrinsic, CLI::GetParam<double>("spread"),
+          CLI::GetParam<double>("noise"), !CLI::HasParam("no_normalize"));
+      WritePoints(generator, (size_t) points, (size_t) batchSize, writer,
+          labelsWriter);
+    }
+    else
+    {
+      const int length = CLI::GetParam<int>("length");
+      if (length <= 0)
+        Log::Fatal << "Sequence length (" << length << ") must be positive."
+            << endl;
+
+      HMMSequenceGenerator generator((size_t) clusters, rows,
+          CLI::GetParam<double>("stay_probability"),
+          CLI::GetParam<double>("separation"));
+
+      arma::mat sequence;
+      arma::Col<size_t> states;
+      for (size_t i = 0; i < (size_t) points; ++i)
+      {
+        generator.Generate((size_t) length, sequence, states);
+        writer.Write(sequence);
+        WriteLabels(labelsWriter, states);
+      }
+    }
+
+    writer.Close();
+    delete labelsWriter;
+
+    Log::Info << "Wrote " << writer.PointsWritten() << " points to '"
+        << outputFile << "'." << endl;
+  }
+  Timer::Stop("generation");
+}
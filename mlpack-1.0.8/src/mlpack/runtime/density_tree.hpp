@@ -0,0 +1,172 @@
+/**
+ * @file density_tree.hpp
+ *
+ * The density estimation tree of the inference runtime, which reads the files
+ * written by det::FlatDTree::Save().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_DENSITY_TREE_HPP
+#define __MLPACK_RUNTIME_DENSITY_TREE_HPP
+
+#include "model_io.hpp"
+
+#include <vector>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A trained density estimation tree, loaded from a file saved by
+ * det::FlatDTree::Save() (so no conversion is needed), which computes density
+ * estimates as det::DTree::ComputeValue() does.
+ *
+ * @code
+ * // With the full library:
+ * det::FlatDTree(*tree).Save("det.bin");
+ *
+ * // With only the runtime:
+ * runtime::DensityTree tree("det.bin");
+ * double density = tree.ComputeValue(query);
+ * @endcode
+ */
+class DensityTree
+{
+ public:
+  /**
+   * Load a tree saved with det::FlatDTree::Save().  If the file cannot be
+   * read or is not a saved tree, std::runtime_error is thrown.
+   *
+   * @param filename File to load.
+   */
+  DensityTree(const std::string& filename)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("cannot open '" + filename + "'");
+
+    // The layout is that of FlatDTree: the magic string, the version, the
+    // dimensionality and the number of nodes, the bounding box, and then the
+    // nodes (value, dimension, child).
+    char magic[8];
+    uint64_t header[3];
+    stream.read(magic, sizeof(magic));
+    stream.read((char*) header, sizeof(header));
+    if (!stream.good() || (memcmp(magic, "MLPKFDET", 8) != 0) ||
+        (header[0] != 1))
+      throw std::runtime_error("'" + filename + "' is not a flat density "
+          "estimation tree");
+
+    const size_t dimensionality = (size_t) header[1];
+    const size_t numNodes = (size_t) header[2];
+
+    minVals.set_size(dimensionality);
+    maxVals.set_size(dimensionality);
+    stream.read((char*) minVals.memptr(), dimensionality * sizeof(double));
+    stream.read((char*) maxVals.memptr(), dimensionality * sizeof(double));
+
+    nodes.resize(numNodes);
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+      uint64_t fields[2];
+      stream.read((char*) &nodes[i].value, sizeof(double));
+      stream.read((char*) fields, sizeof(fields));
+      nodes[i].dim = (size_t) fields[0];
+      nodes[i].child = (size_t) fields[1];
+
+      if ((nodes[i].child != 0) && ((nodes[i].child <= i) ||
+          (nodes[i].child + 1 >= numNodes) ||
+          (nodes[i].dim >= dimensionality)))
+        throw std::runtime_error("density estimation tree '" + filename +
+            "' is corrupt");
+    }
+
+    if (!stream.good() || (numNodes == 0))
+      throw std::runtime_error("cannot read density estimation tree '" +
+          filename + "'");
+  }
+
+  /**
+   * Compute the density estimate of the given query (0 if the query is
+   * outside the bounding box of the training data).
+   */
+  double ComputeValue(const arma::vec& query) const
+  {
+    if (query.n_elem != minVals.n_elem)
+      throw std::invalid_argument("DensityTree::ComputeValue(): the query "
+          "does not have the dimensionality of the tree");
+
+    return ComputeValue(query.memptr());
+  }
+
+  /**
+   * Compute the density estimates of each of the given queries (one for each
+   * column).
+   */
+  void ComputeValue(const arma::mat& queries, arma::vec& values) const
+  {
+    if (queries.n_rows != minVals.n_elem)
+      throw std::invalid_argument("DensityTree::ComputeValue(): the queries "
+          "do not have the dimensionality of the tree");
+
+    values.set_size(queries.n_cols);
+    for (size_t i = 0; i < queries.n_cols; ++i)
+      values[i] = ComputeValue(queries.colptr(i));
+  }
+
+  //! Return the number of nodes in the tree.
+  size_t NumNodes() const { return nodes.size(); }
+  //! Return the dimensionality of the tree.
+  size_t Dimensionality() const { return minVals.n_elem; }
+
+ private:
+  //! A node of the tree, as in FlatDTree.
+  struct Node
+  {
+    //! The split value of an internal node, or the density of a leaf.
+    double value;
+    //! The split dimension of an internal node, or the tag of a leaf.
+    size_t dim;
+    //! The index of the left child (0 for a leaf).
+    size_t child;
+  };
+
+  //! The nodes, in breadth-first order.
+  std::vector<Node> nodes;
+  //! The lower bound of the bounding box of the training data.
+  arma::vec minVals;
+  //! The upper bound of the bounding box of the training data.
+  arma::vec maxVals;
+
+  //! Compute the density estimate of the given point.
+  double ComputeValue(const double* query) const
+  {
+    for (size_t i = 0; i < minVals.n_elem; ++i)
+      if ((query[i] < minVals[i]) || (query[i] > maxVals[i]))
+        return 0.0;
+
+    size_t i = 0;
+    while (nodes[i].child != 0)
+      i = nodes[i].child + (query[nodes[i].dim] > nodes[i].value ? 1 : 0);
+
+    return nodes[i].value;
+  }
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file distributions.hpp
+ *
+ * The Gaussian and discrete distributions of the inference runtime, used by
+ * its GMMs and HMMs.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_DISTRIBUTIONS_HPP
+#define __MLPACK_RUNTIME_DISTRIBUTIONS_HPP
+
+#include "model_io.hpp"
+
+#include <cmath>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A multivariate Gaussian distribution, stored with the inverse and the log
+ * determinant of its covariance so that evaluating it needs no decomposition
+ * (and so no LAPACK).  Create it from a trained
+ * distribution::GaussianDistribution with ToRuntime() (see to_runtime.hpp).
+ */
+class Gaussian
+{
+ public:
+  //! Create an empty distribution.
+  Gaussian() : logDetCov(0.0) { }
+
+  /**
+   * Create the distribution from its mean, the inverse of its covariance, and
+   * the log determinant of its covariance.
+   */
+  Gaussian(const arma::vec& mean,
+           const arma::mat& invCov,
+           const double logDetCov) :
+      mean(mean),
+      invCov(invCov),
+      logDetCov(logDetCov)
+  {
+    if (invCov.n_rows != mean.n_elem || invCov.n_cols != mean.n_elem)
+      throw std::invalid_argument("Gaussian: covariance and mean do not have "
+          "the same dimensionality");
+  }
+
+  //! Return the log probability density of the given observation.
+  double LogProbability(const arma::vec& observation) const
+  {
+    const arma::vec diff = observation - mean;
+    return -0.5 * (mean.n_elem * std::log(2 * M_PI) + logDetCov +
+        arma::dot(diff, invCov * diff));
+  }
+
+  //! Return the probability density of the given observation.
+  double Probability(const arma::vec& observation) const
+  {
+    return std::exp(LogProbability(observation));
+  }
+
+  //! Return the dimensionality of the distribution.
+  size_t Dimensionality() const { return mean.n_elem; }
+  //! Get the mean.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the inverse of the covariance.
+  const arma::mat& InvCov() const { return invCov; }
+  //! Get the log determinant of the covariance.
+  double LogDetCov() const { return logDetCov; }
+
+  //! Write the distribution to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRGAU");
+    WriteMatrix(stream, mean);
+    WriteMatrix(stream, invCov);
+    stream.write((const char*) &logDetCov, sizeof(double));
+  }
+
+  //! Read the distribution from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRGAU");
+    ReadMatrix(stream, mean);
+    ReadMatrix(stream, invCov);
+    stream.read((char*) &logDetCov, sizeof(double));
+    if (!stream.good() || invCov.n_rows != mean.n_elem ||
+        invCov.n_cols != mean.n_elem)
+      throw std::runtime_error("corrupt Gaussian distribution");
+  }
+
+ private:
+  //! The mean.
+  arma::vec mean;
+  //! The inverse of the covariance.
+  arma::mat invCov;
+  //! The log determinant of the covariance.
+  double logDetCov;
+};
+
+/**
+ * A discrete distribution over the observations 0, 1, ..., n - 1, as used by
+ * discrete HMMs.  Like distribution::DiscreteDistribution, it takes
+ * one-dimensional observations and rounds them to the nearest integer;
+ * observations out of range have probability 0.
+ */
+class Discrete
+{
+ public:
+  //! Create an empty distribution.
+  Discrete() { }
+
+  //! Create the distribution from the probabilities of each observation.
+  Discrete(const arma::vec& probabilities) : probabilities(probabilities) { }
+
+  //! Return the probability of the given observation.
+  double Probability(const arma::vec& observation) const
+  {
+    const size_t obs = size_t(observation[0] + 0.5);
+    return (obs < probabilities.n_elem) ? probabilities[obs] : 0.0;
+  }
+
+  //! Return the log probability of the given observation.
+  double LogProbability(const arma::vec& observation) const
+  {
+    return std::log(Probability(observation));
+  }
+
+  //! Return the dimensionality of the observations (always 1).
+  size_t Dimensionality() const { return 1; }
+  //! Get the probabilities of each observation.
+  const arma::vec& Probabilities() const { return probabilities; }
+
+  //! Write the distribution to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRDIS");
+    WriteMatrix(stream, probabilities);
+  }
+
+  //! Read the distribution from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRDIS");
+    ReadMatrix(stream, probabilities);
+  }
+
+ private:
+  //! The probability of each observation.
+  arma::vec probabilities;
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
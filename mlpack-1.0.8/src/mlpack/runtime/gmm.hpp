@@ -0,0 +1,166 @@
+/**
+ * @file gmm.hpp
+ *
+ * The Gaussian mixture model of the inference runtime.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_GMM_HPP
+#define __MLPACK_RUNTIME_GMM_HPP
+
+#include "distributions.hpp"
+
+#include <vector>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A trained Gaussian mixture model, which can compute the probability density
+ * of observations and classify them, as gmm::GMM::Probability() and
+ * gmm::GMM::Classify() do.  Create it from a gmm::GMM with ToRuntime() (see
+ * to_runtime.hpp) and save it with Save(); on the device, load it with the
+ * constructor taking a filename.
+ *
+ * @code
+ * // With the full library:
+ * runtime::ToRuntime(gmm).Save("gmm.model");
+ *
+ * // With only the runtime:
+ * runtime::GMM gmm("gmm.model");
+ * arma::Col<size_t> labels;
+ * gmm.Classify(observations, labels);
+ * @endcode
+ */
+class GMM
+{
+ public:
+  //! Create an empty model.
+  GMM() { }
+
+  /**
+   * Create the model from the weights and the components.
+   *
+   * @param weights Weight of each component.
+   * @param components The components.
+   */
+  GMM(const arma::vec& weights, const std::vector<Gaussian>& components) :
+      weights(weights),
+      components(components)
+  {
+    if (weights.n_elem != components.size())
+      throw std::invalid_argument("GMM: the number of weights is not the "
+          "number of components");
+  }
+
+  /**
+   * Load a model saved with Save().  If the file cannot be read,
+   * std::runtime_error is thrown.
+   */
+  GMM(const std::string& filename) { LoadModel(*this, filename); }
+
+  //! Save the model to the given file.
+  void Save(const std::string& filename) const { SaveModel(*this, filename); }
+
+  //! Return the probability density of the given observation.
+  double Probability(const arma::vec& observation) const
+  {
+    double sum = 0.0;
+    for (size_t i = 0; i < components.size(); ++i)
+      sum += weights[i] * components[i].Probability(observation);
+
+    return sum;
+  }
+
+  /**
+   * Return the probability density of the given observation under the given
+   * component, times the weight of the component.
+   */
+  double Probability(const arma::vec& observation,
+                     const size_t component) const
+  {
+    return weights[component] * components[component].Probability(
+        observation);
+  }
+
+  /**
+   * Classify each of the given observations (one per column) as coming from
+   * the component under which it is most probable.
+   *
+   * @param observations Observations to classify.
+   * @param labels Vector to store the component of each observation in.
+   */
+  void Classify(const arma::mat& observations, arma::Col<size_t>& labels) const
+  {
+    labels.zeros(observations.n_cols);
+    for (size_t i = 0; i < observations.n_cols; ++i)
+    {
+      double probability = 0.0;
+      for (size_t j = 0; j < components.size(); ++j)
+      {
+        const double newProbability = Probability(observations.unsafe_col(i),
+            j);
+        if (newProbability >= probability)
+        {
+          probability = newProbability;
+          labels[i] = j;
+        }
+      }
+    }
+  }
+
+  //! Return the number of components.
+  size_t Gaussians() const { return components.size(); }
+  //! Return the dimensionality of the model.
+  size_t Dimensionality() const
+  {
+    return components.empty() ? 0 : components[0].Dimensionality();
+  }
+  //! Get the weights of the components.
+  const arma::vec& Weights() const { return weights; }
+  //! Get the components.
+  const std::vector<Gaussian>& Components() const { return components; }
+
+  //! Write the model to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRGMM");
+    WriteMatrix(stream, weights);
+    for (size_t i = 0; i < components.size(); ++i)
+      components[i].Write(stream);
+  }
+
+  //! Read the model from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRGMM");
+    ReadMatrix(stream, weights);
+    components.resize(weights.n_elem);
+    for (size_t i = 0; i < components.size(); ++i)
+      components[i].Read(stream);
+  }
+
+ private:
+  //! The weight of each component.
+  arma::vec weights;
+  //! The components.
+  std::vector<Gaussian> components;
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
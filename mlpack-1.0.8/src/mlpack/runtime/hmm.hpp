@@ -0,0 +1,159 @@
+/**
+ * @file hmm.hpp
+ *
+ * The hidden Markov model of the inference runtime.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_HMM_HPP
+#define __MLPACK_RUNTIME_HMM_HPP
+
+#include "distributions.hpp"
+#include "gmm.hpp"
+
+#include <vector>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A trained hidden Markov model, which can find the most probable sequence of
+ * hidden states for a sequence of observations with the Viterbi algorithm, as
+ * hmm::HMM::Predict() does (the sequence starts in state 0).  Create it from an
+ * hmm::HMM with ToRuntime() (see to_runtime.hpp) and save it with Save(); on
+ * the device, load it with the constructor taking a filename.
+ *
+ * @tparam Distribution The emission distribution: Discrete, Gaussian, or GMM.
+ */
+template<typename Distribution>
+class HMM
+{
+ public:
+  //! Create an empty model.
+  HMM() { }
+
+  /**
+   * Create the model from its transition matrix and emission distributions.
+   *
+   * @param transition Transition matrix; entry (i, j) is the probability of
+   *     going to state i from state j.
+   * @param emission Emission distribution of each state.
+   */
+  HMM(const arma::mat& transition,
+      const std::vector<Distribution>& emission) :
+      transition(transition),
+      emission(emission)
+  {
+    if (transition.n_rows != transition.n_cols ||
+        transition.n_rows != emission.size())
+      throw std::invalid_argument("HMM: the transition matrix does not match "
+          "the number of emission distributions");
+  }
+
+  /**
+   * Load a model saved with Save().  If the file cannot be read,
+   * std::runtime_error is thrown.
+   */
+  HMM(const std::string& filename) { LoadModel(*this, filename); }
+
+  //! Save the model to the given file.
+  void Save(const std::string& filename) const { SaveModel(*this, filename); }
+
+  /**
+   * Compute the most probable hidden state sequence for the given sequence of
+   * observations (one per column), and return its log-likelihood.
+   *
+   * @param dataSeq Sequence of observations.
+   * @param stateSeq Vector to store the hidden states in.
+   */
+  double Predict(const arma::mat& dataSeq, arma::Col<size_t>& stateSeq) const
+  {
+    const size_t states = transition.n_rows;
+    stateSeq.set_size(dataSeq.n_cols);
+    if (dataSeq.n_cols == 0)
+      return 0.0;
+
+    arma::mat logEmissionProb(states, dataSeq.n_cols);
+    for (size_t t = 0; t < dataSeq.n_cols; ++t)
+      for (size_t state = 0; state < states; ++state)
+        logEmissionProb(state, t) = std::log(emission[state].Probability(
+            dataSeq.unsafe_col(t)));
+
+    // Column j holds the log-probabilities of the transitions into state j.
+    const arma::mat logTrans(arma::log(arma::trans(transition)));
+
+    arma::mat logStateProb(states, dataSeq.n_cols);
+    for (size_t state = 0; state < states; ++state)
+      logStateProb(state, 0) = std::log(transition(state, 0)) +
+          logEmissionProb(state, 0);
+
+    arma::uword index;
+    logStateProb.unsafe_col(0).max(index);
+    stateSeq[0] = index;
+
+    for (size_t t = 1; t < dataSeq.n_cols; ++t)
+    {
+      for (size_t j = 0; j < states; ++j)
+      {
+        const arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
+        logStateProb(j, t) = prob.max() + logEmissionProb(j, t);
+      }
+
+      logStateProb.unsafe_col(t).max(index);
+      stateSeq[t] = index;
+    }
+
+    return logStateProb(stateSeq[dataSeq.n_cols - 1], dataSeq.n_cols - 1);
+  }
+
+  //! Get the transition matrix.
+  const arma::mat& Transition() const { return transition; }
+  //! Get the emission distributions.
+  const std::vector<Distribution>& Emission() const { return emission; }
+
+  //! Write the model to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRHMM");
+    WriteMatrix(stream, transition);
+    for (size_t i = 0; i < emission.size(); ++i)
+      emission[i].Write(stream);
+  }
+
+  //! Read the model from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRHMM");
+    ReadMatrix(stream, transition);
+    if (transition.n_rows != transition.n_cols)
+      throw std::runtime_error("corrupt HMM transition matrix");
+
+    emission.resize(transition.n_rows);
+    for (size_t i = 0; i < emission.size(); ++i)
+      emission[i].Read(stream);
+  }
+
+ private:
+  //! The transition matrix.
+  arma::mat transition;
+  //! The emission distribution of each state.
+  std::vector<Distribution> emission;
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
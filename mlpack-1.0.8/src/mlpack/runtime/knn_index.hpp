@@ -0,0 +1,281 @@
+/**
+ * @file knn_index.hpp
+ *
+ * k-nearest-neighbor search in the inference runtime, over a tree index
+ * written by tree::TreeIndex::Save().
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_KNN_INDEX_HPP
+#define __MLPACK_RUNTIME_KNN_INDEX_HPP
+
+#include "model_io.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A kd-tree over a reference set, loaded from a tree index saved by
+ * tree::TreeIndex::Save() for a kd-tree (BinarySpaceTree with an HRectBound),
+ * which finds the k nearest neighbors of query points in Euclidean distance
+ * with a single-tree, depth-first search.  The results are those of AllkNN in
+ * single-tree mode on the same index, with the neighbors given as indices into
+ * the original (not reordered) reference set.
+ *
+ * @code
+ * // With the full library:
+ * tree::TreeIndex<TreeType> index(referenceData, 20);
+ * index.Save("reference.idx");
+ *
+ * // With only the runtime:
+ * runtime::KNNIndex index("reference.idx");
+ * index.Search(queries, 5, neighbors, distances);
+ * @endcode
+ */
+class KNNIndex
+{
+ public:
+  /**
+   * Load a tree index.  If the file cannot be read or is not a tree index,
+   * std::runtime_error is thrown.
+   *
+   * @param filename File to load.
+   */
+  KNNIndex(const std::string& filename)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("cannot open '" + filename + "'");
+
+    // The header of a tree index: the magic string, then the version, the
+    // dimensionality, the number of points, the number of nodes, the leaf
+    // size, the offsets of the dataset, the mapping and the nodes, and the
+    // size of a node record (see tree_index_impl.hpp).
+    char magic[8];
+    uint64_t header[9];
+    stream.read(magic, sizeof(magic));
+    stream.read((char*) header, sizeof(header));
+    if (!stream.good() || (memcmp(magic, "MLPKTIDX", 8) != 0) ||
+        (header[0] != 1))
+      throw std::runtime_error("'" + filename + "' is not a tree index");
+
+    const size_t dimensionality = (size_t) header[1];
+    const size_t points = (size_t) header[2];
+    const size_t numNodes = (size_t) header[3];
+    if ((header[8] != 4 * sizeof(uint64_t) + 2 * dimensionality *
+        sizeof(double)) || (numNodes == 0) ||
+        (header[6] < header[5] + dimensionality * points * sizeof(double)) ||
+        (header[7] < header[6] + points * sizeof(uint64_t)))
+      throw std::runtime_error("tree index '" + filename + "' is corrupt");
+
+    dataset.set_size(dimensionality, points);
+    stream.seekg((std::streamoff) header[5]);
+    stream.read((char*) dataset.memptr(), dataset.n_elem * sizeof(double));
+
+    oldFromNew.resize(points);
+    stream.seekg((std::streamoff) header[6]);
+    for (size_t i = 0; i < points; ++i)
+      oldFromNew[i] = (size_t) ReadCount(stream);
+
+    // The nodes are in depth-first order, so the left child of a node comes
+    // right after it; the right children are found with a stack.
+    nodes.resize(numNodes);
+    bounds.set_size(2, dimensionality * numNodes);
+    stream.seekg((std::streamoff) header[7]);
+    std::vector<size_t> parents;
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+      uint64_t fields[4];
+      stream.read((char*) fields, sizeof(fields));
+      stream.read((char*) bounds.colptr(i * dimensionality),
+          2 * dimensionality * sizeof(double));
+      if (!stream.good() || (fields[0] + fields[1] > points))
+        throw std::runtime_error("tree index '" + filename + "' is corrupt");
+
+      nodes[i].begin = (size_t) fields[0];
+      nodes[i].count = (size_t) fields[1];
+      nodes[i].right = 0;
+
+      // A node which follows a leaf is the right child of the deepest node
+      // still waiting for one.
+      if (i > 0 && !nodes[i - 1].internal)
+      {
+        if (parents.empty())
+          throw std::runtime_error("tree index '" + filename + "' is "
+              "corrupt");
+        nodes[parents.back()].right = i;
+        parents.pop_back();
+      }
+
+      nodes[i].internal = (fields[3] != 0);
+      if (nodes[i].internal)
+        parents.push_back(i);
+    }
+
+    if (!parents.empty() || nodes[numNodes - 1].internal)
+      throw std::runtime_error("tree index '" + filename + "' is corrupt");
+  }
+
+  /**
+   * Find the k nearest neighbors of each query point (one per column), in
+   * Euclidean distance.
+   *
+   * @param queries Query points.
+   * @param k Number of neighbors to find (at most the number of points).
+   * @param neighbors Matrix to store the indices of the neighbors in (k x
+   *     number of queries), nearest first.
+   * @param distances Matrix to store the distances to the neighbors in.
+   */
+  void Search(const arma::mat& queries,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances) const
+  {
+    if (queries.n_rows != dataset.n_rows)
+      throw std::invalid_argument("KNNIndex::Search(): the queries do not "
+          "have the dimensionality of the index");
+    if (k == 0 || k > dataset.n_cols)
+      throw std::invalid_argument("KNNIndex::Search(): invalid k");
+
+    neighbors.set_size(k, queries.n_cols);
+    distances.set_size(k, queries.n_cols);
+    for (size_t q = 0; q < queries.n_cols; ++q)
+    {
+      // The squared distances of the best candidates so far, sorted.
+      arma::vec best(k);
+      best.fill(std::numeric_limits<double>::infinity());
+      arma::Col<size_t> bestIndices(k);
+      bestIndices.fill(size_t(-1));
+
+      SearchNode(0, queries.colptr(q), best, bestIndices);
+
+      for (size_t i = 0; i < k; ++i)
+      {
+        neighbors(i, q) = oldFromNew[bestIndices[i]];
+        distances(i, q) = std::sqrt(best[i]);
+      }
+    }
+  }
+
+  //! Return the number of reference points.
+  size_t Points() const { return dataset.n_cols; }
+  //! Return the dimensionality of the reference points.
+  size_t Dimensionality() const { return dataset.n_rows; }
+  //! Get the (reordered) reference points.
+  const arma::mat& Dataset() const { return dataset; }
+
+ private:
+  //! A node of the tree.
+  struct Node
+  {
+    //! The index of the first point of the node.
+    size_t begin;
+    //! The number of points of the node.
+    size_t count;
+    //! Whether the node has children; the left child is the next node.
+    bool internal;
+    //! The index of the right child.
+    size_t right;
+  };
+
+  //! The reference points, in the order of the tree.
+  arma::mat dataset;
+  //! The original index of each reference point.
+  std::vector<size_t> oldFromNew;
+  //! The nodes, in depth-first order.
+  std::vector<Node> nodes;
+  //! The low (row 0) and high (row 1) ends of the bound of each node in each
+  //! dimension; node i uses columns [i * d, (i + 1) * d).
+  arma::mat bounds;
+
+  //! Return the squared distance from the point to the bound of the node.
+  double MinDistance(const size_t node, const double* point) const
+  {
+    const double* bound = bounds.colptr(node * dataset.n_rows);
+    double sum = 0.0;
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      double diff = 0.0;
+      if (point[d] < bound[2 * d])
+        diff = bound[2 * d] - point[d];
+      else if (point[d] > bound[2 * d + 1])
+        diff = point[d] - bound[2 * d + 1];
+      sum += diff * diff;
+    }
+
+    return sum;
+  }
+
+  //! Search the given node (which is not pruned) for neighbors of the point.
+  void SearchNode(const size_t node,
+                  const double* point,
+                  arma::vec& best,
+                  arma::Col<size_t>& bestIndices) const
+  {
+    const size_t k = best.n_elem;
+    if (!nodes[node].internal)
+    {
+      for (size_t i = nodes[node].begin;
+           i < nodes[node].begin + nodes[node].count; ++i)
+      {
+        const double* reference = dataset.colptr(i);
+        double distance = 0.0;
+        for (size_t d = 0; d < dataset.n_rows; ++d)
+          distance += (point[d] - reference[d]) * (point[d] - reference[d]);
+
+        if (distance >= best[k - 1])
+          continue;
+
+        // Insert the candidate in order.
+        size_t j = k - 1;
+        for (; j > 0 && best[j - 1] > distance; --j)
+        {
+          best[j] = best[j - 1];
+          bestIndices[j] = bestIndices[j - 1];
+        }
+        best[j] = distance;
+        bestIndices[j] = i;
+      }
+
+      return;
+    }
+
+    // Visit the closer child first.
+    const size_t left = node + 1;
+    const size_t right = nodes[node].right;
+    const double leftDistance = MinDistance(left, point);
+    const double rightDistance = MinDistance(right, point);
+    const size_t first = (leftDistance <= rightDistance) ? left : right;
+    const size_t second = (first == left) ? right : left;
+    const double secondDistance = (first == left) ? rightDistance :
+        leftDistance;
+
+    if (std::min(leftDistance, rightDistance) < best[k - 1])
+      SearchNode(first, point, best, bestIndices);
+    if (secondDistance < best[k - 1])
+      SearchNode(second, point, best, bestIndices);
+  }
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file logistic_regression.hpp
+ *
+ * The logistic regression model of the inference runtime.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_LOGISTIC_REGRESSION_HPP
+#define __MLPACK_RUNTIME_LOGISTIC_REGRESSION_HPP
+
+#include "model_io.hpp"
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A trained logistic regression model, which predicts responses as
+ * regression::LogisticRegression::Predict() does.  Create it from the
+ * parameters of a trained model (with ToRuntime(); see to_runtime.hpp).
+ */
+class LogisticRegression
+{
+ public:
+  //! Create an empty model.
+  LogisticRegression() { }
+
+  /**
+   * Create the model from its parameters: the intercept, then one coefficient
+   * for each dimension.
+   */
+  LogisticRegression(const arma::vec& parameters) : parameters(parameters)
+  {
+    if (parameters.n_elem == 0)
+      throw std::invalid_argument("LogisticRegression: no parameters");
+  }
+
+  /**
+   * Load a model saved with Save().  If the file cannot be read,
+   * std::runtime_error is thrown.
+   */
+  LogisticRegression(const std::string& filename)
+  {
+    LoadModel(*this, filename);
+  }
+
+  //! Save the model to the given file.
+  void Save(const std::string& filename) const { SaveModel(*this, filename); }
+
+  /**
+   * Predict the responses (0 or 1) of the given points (one per column).  A
+   * point gets the response 1 if the sigmoid of its linear function is at
+   * least the decision boundary.
+   *
+   * @param predictors Points to predict the responses of.
+   * @param responses Vector to store the responses in.
+   * @param decisionBoundary Decision boundary (0.5 by default).
+   */
+  void Predict(const arma::mat& predictors,
+               arma::vec& responses,
+               const double decisionBoundary = 0.5) const
+  {
+    if (predictors.n_rows + 1 != parameters.n_elem)
+      throw std::invalid_argument("LogisticRegression::Predict(): the points "
+          "do not have the dimensionality of the model");
+
+    responses = arma::floor((1.0 / (1.0 + arma::exp(-parameters(0)
+        - predictors.t() * parameters.subvec(1, parameters.n_elem - 1))))
+        + (1.0 - decisionBoundary));
+  }
+
+  //! Get the parameters (the intercept first).
+  const arma::vec& Parameters() const { return parameters; }
+
+  //! Write the model to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRLRG");
+    WriteMatrix(stream, parameters);
+  }
+
+  //! Read the model from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRLRG");
+    ReadMatrix(stream, parameters);
+    if (parameters.n_elem == 0)
+      throw std::runtime_error("corrupt logistic regression model");
+  }
+
+ private:
+  //! The intercept and the coefficients.
+  arma::vec parameters;
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file model_io.hpp
+ *
+ * Reading and writing the binary model files of the inference runtime.  This
+ * uses only the standard library and Armadillo.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_MODEL_IO_HPP
+#define __MLPACK_RUNTIME_MODEL_IO_HPP
+
+#include <armadillo>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <stdint.h>
+
+// M_PI is not standard; this is the same fallback core.hpp uses.
+#ifndef M_PI
+  #define M_PI 3.141592653589793238462643383279
+#endif
+
+namespace mlpack {
+namespace runtime /** Inference without Boost, libxml2 or CLI. */ {
+
+/**
+ * Write the 8-character tag which starts each model to the given stream.  The
+ * model files are in host byte order, like the other binary files of MLPACK.
+ *
+ * @param stream Stream to write to.
+ * @param tag Tag of the model type (exactly 8 characters).
+ */
+inline void WriteTag(std::ostream& stream, const char* tag)
+{
+  stream.write(tag, 8);
+}
+
+/**
+ * Read a tag from the given stream, and throw std::runtime_error if it is not
+ * the given one.
+ *
+ * @param stream Stream to read from.
+ * @param tag Expected tag (exactly 8 characters).
+ */
+inline void ReadTag(std::istream& stream, const char* tag)
+{
+  char found[8];
+  stream.read(found, 8);
+  if (!stream.good() || (memcmp(found, tag, 8) != 0))
+    throw std::runtime_error(std::string("expected a model of type '") +
+        std::string(tag, 8) + "'");
+}
+
+//! Write a count (as a 64-bit unsigned integer) to the given stream.
+inline void WriteCount(std::ostream& stream, const size_t count)
+{
+  const uint64_t value = count;
+  stream.write((const char*) &value, sizeof(value));
+}
+
+//! Read a count written with WriteCount() from the given stream.
+inline size_t ReadCount(std::istream& stream)
+{
+  uint64_t value = 0;
+  stream.read((char*) &value, sizeof(value));
+  if (!stream.good())
+    throw std::runtime_error("unexpected end of model");
+
+  return (size_t) value;
+}
+
+/**
+ * Write a matrix (or vector) to the given stream: its number of rows and
+ * columns, then its elements in column-major order.
+ *
+ * @param stream Stream to write to.
+ * @param matrix Matrix to write.
+ */
+template<typename eT>
+void WriteMatrix(std::ostream& stream, const arma::Mat<eT>& matrix)
+{
+  WriteCount(stream, matrix.n_rows);
+  WriteCount(stream, matrix.n_cols);
+  stream.write((const char*) matrix.memptr(), matrix.n_elem * sizeof(eT));
+}
+
+/**
+ * Read a matrix written with WriteMatrix() from the given stream.  A vector
+ * can only be read into a vector.
+ *
+ * @param stream Stream to read from.
+ * @param matrix Matrix to read into.
+ */
+template<typename eT>
+void ReadMatrix(std::istream& stream, arma::Mat<eT>& matrix)
+{
+  const size_t rows = ReadCount(stream);
+  const size_t cols = ReadCount(stream);
+
+  // Refuse sizes that cannot come from a real model before allocating.
+  if ((rows != 0) && (cols > size_t(-1) / sizeof(eT) / rows))
+    throw std::runtime_error("corrupt matrix in model");
+
+  matrix.set_size(rows, cols);
+  stream.read((char*) matrix.memptr(), matrix.n_elem * sizeof(eT));
+  if (!stream.good())
+    throw std::runtime_error("unexpected end of model");
+}
+
+/**
+ * Save a model with a Write(std::ostream&) method to the given file.  If the
+ * file cannot be written, std::runtime_error is thrown.
+ *
+ * @param model Model to save.
+ * @param filename File to save to.
+ */
+template<typename ModelType>
+void SaveModel(const ModelType& model, const std::string& filename)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "' for writing");
+
+  model.Write(stream);
+  if (!stream.good())
+    throw std::runtime_error("error writing model to '" + filename + "'");
+}
+
+/**
+ * Load a model with a Read(std::istream&) method from the given file.  If the
+ * file cannot be read or does not hold a model of the right type,
+ * std::runtime_error is thrown.
+ *
+ * @param model Model to load into.
+ * @param filename File to load.
+ */
+template<typename ModelType>
+void LoadModel(ModelType& model, const std::string& filename)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  try
+  {
+    model.Read(stream);
+  }
+  catch (std::runtime_error& e)
+  {
+    throw std::runtime_error("cannot load '" + filename + "': " + e.what());
+  }
+}
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * @file naive_bayes.hpp
+ *
+ * The Gaussian naive Bayes classifier of the inference runtime.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_NAIVE_BAYES_HPP
+#define __MLPACK_RUNTIME_NAIVE_BAYES_HPP
+
+#include "model_io.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * A trained Gaussian naive Bayes classifier, which classifies points as
+ * naive_bayes::NaiveBayesClassifier::Classify() does.  The inverse variances
+ * and the constant terms of the log-likelihoods are computed once, when the
+ * model is created or loaded.  Create it from a trained classifier with
+ * ToRuntime() (see to_runtime.hpp).
+ */
+class NaiveBayes
+{
+ public:
+  //! Create an empty model.
+  NaiveBayes() { }
+
+  /**
+   * Create the model from the means and variances of the features of each
+   * class (one class per column) and the prior probabilities of the classes.
+   */
+  NaiveBayes(const arma::mat& means,
+             const arma::mat& variances,
+             const arma::vec& probabilities) :
+      means(means),
+      variances(variances),
+      probabilities(probabilities)
+  {
+    if (variances.n_rows != means.n_rows ||
+        variances.n_cols != means.n_cols ||
+        probabilities.n_elem != means.n_cols)
+      throw std::invalid_argument("NaiveBayes: the means, variances and "
+          "probabilities do not match");
+
+    Precompute();
+  }
+
+  /**
+   * Load a model saved with Save().  If the file cannot be read,
+   * std::runtime_error is thrown.
+   */
+  NaiveBayes(const std::string& filename) { LoadModel(*this, filename); }
+
+  //! Save the model to the given file.
+  void Save(const std::string& filename) const { SaveModel(*this, filename); }
+
+  /**
+   * Classify the given points (one per column).
+   *
+   * @param data Points to classify.
+   * @param results Vector to store the class of each point in.
+   */
+  void Classify(const arma::mat& data, arma::Col<size_t>& results) const
+  {
+    if (data.n_rows != means.n_rows)
+      throw std::invalid_argument("NaiveBayes::Classify(): the points do not "
+          "have the dimensionality of the model");
+
+    results.zeros(data.n_cols);
+
+    // Work on blocks of points, as NaiveBayesClassifier does.
+    const size_t blockSize = 1024;
+    for (size_t begin = 0; begin < data.n_cols; begin += blockSize)
+    {
+      const size_t end = std::min(begin + blockSize, (size_t) data.n_cols) - 1;
+      const arma::mat block = data.cols(begin, end);
+
+      arma::mat logLikelihoods = trans(weightedMeans) * block -
+          0.5 * trans(inverseVariances) * arma::square(block);
+      logLikelihoods.each_col() += constants;
+
+      for (size_t n = 0; n < logLikelihoods.n_cols; ++n)
+      {
+        arma::uword maxIndex = 0;
+        logLikelihoods.col(n).max(maxIndex);
+        results[begin + n] = maxIndex;
+      }
+    }
+  }
+
+  //! Get the means of the features of each class.
+  const arma::mat& Means() const { return means; }
+  //! Get the variances of the features of each class.
+  const arma::mat& Variances() const { return variances; }
+  //! Get the prior probabilities of the classes.
+  const arma::vec& Probabilities() const { return probabilities; }
+
+  //! Write the model to a stream.
+  void Write(std::ostream& stream) const
+  {
+    WriteTag(stream, "MLPKRNBC");
+    WriteMatrix(stream, means);
+    WriteMatrix(stream, variances);
+    WriteMatrix(stream, probabilities);
+  }
+
+  //! Read the model from a stream.
+  void Read(std::istream& stream)
+  {
+    ReadTag(stream, "MLPKRNBC");
+    ReadMatrix(stream, means);
+    ReadMatrix(stream, variances);
+    ReadMatrix(stream, probabilities);
+    if (variances.n_rows != means.n_rows ||
+        variances.n_cols != means.n_cols ||
+        probabilities.n_elem != means.n_cols)
+      throw std::runtime_error("corrupt naive Bayes classifier");
+
+    Precompute();
+  }
+
+ private:
+  //! The means of the features of each class.
+  arma::mat means;
+  //! The variances of the features of each class.
+  arma::mat variances;
+  //! The prior probabilities of the classes.
+  arma::vec probabilities;
+
+  //! The inverse variances (0 for classes which are never predicted).
+  arma::mat inverseVariances;
+  //! The means divided by the variances.
+  arma::mat weightedMeans;
+  //! The constant term of the log-likelihood of each class.
+  arma::vec constants;
+
+  //! Compute the inverse variances and the constant terms.
+  void Precompute()
+  {
+    inverseVariances.set_size(means.n_rows, means.n_cols);
+    constants.set_size(means.n_cols);
+    for (size_t i = 0; i < means.n_cols; ++i)
+    {
+      if (probabilities[i] == 0)
+      {
+        inverseVariances.col(i).zeros();
+        constants[i] = -std::numeric_limits<double>::infinity();
+      }
+      else
+      {
+        inverseVariances.col(i) = 1.0 / variances.col(i);
+        constants[i] = std::log(probabilities[i]) - 0.5 * (means.n_rows *
+            std::log(2.0 * M_PI) + arma::accu(arma::log(variances.col(i))) +
+            arma::dot(arma::square(means.col(i)), inverseVariances.col(i)));
+      }
+    }
+
+    weightedMeans = means % inverseVariances;
+  }
+};
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
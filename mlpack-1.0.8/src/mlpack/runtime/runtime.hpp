@@ -0,0 +1,46 @@
+/**
+ * @file runtime.hpp
+ *
+ * The inference runtime: the prediction paths of some trained MLPACK models,
+ * in headers which depend only on Armadillo and the standard library.
+ *
+ * The runtime needs no Boost, no libxml2 and no CLI initialization, and does
+ * not link against libmlpack, so an app which only runs trained models
+ * (such as an iOS app) can include this header alone.  The models are trained
+ * with the full library, converted with ToRuntime() (see to_runtime.hpp) and
+ * saved with their Save() methods; density estimation trees and kNN indices
+ * are read directly from the files written by det::FlatDTree::Save() and
+ * tree::TreeIndex::Save().  Errors are reported with std::runtime_error and
+ * std::invalid_argument.
+ *
+ * The runtime does not need LAPACK: Gaussians are stored with their inverse
+ * covariances.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_RUNTIME_HPP
+#define __MLPACK_RUNTIME_RUNTIME_HPP
+
+#include "model_io.hpp"
+#include "distributions.hpp"
+#include "gmm.hpp"
+#include "hmm.hpp"
+#include "naive_bayes.hpp"
+#include "logistic_regression.hpp"
+#include "density_tree.hpp"
+#include "knn_index.hpp"
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file to_runtime.hpp
+ *
+ * Conversion of trained MLPACK models into the models of the inference
+ * runtime.  Unlike the rest of mlpack/runtime/, this uses the full library, so
+ * it is meant for the program which trains the models, not for the device.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_RUNTIME_TO_RUNTIME_HPP
+#define __MLPACK_RUNTIME_TO_RUNTIME_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
+
+#include "runtime.hpp"
+
+namespace mlpack {
+namespace runtime {
+
+/**
+ * Create a runtime Gaussian with the given mean and covariance, inverting the
+ * covariance now so the runtime does not have to.
+ */
+inline Gaussian ToRuntime(const arma::vec& mean, const arma::mat& covariance)
+{
+  return Gaussian(mean, arma::inv(covariance), std::log(arma::det(
+      covariance)));
+}
+
+//! Convert a Gaussian distribution.
+inline Gaussian ToRuntime(const distribution::GaussianDistribution& gaussian)
+{
+  return ToRuntime(gaussian.Mean(), gaussian.Covariance());
+}
+
+//! Convert a discrete distribution.
+inline Discrete ToRuntime(const distribution::DiscreteDistribution& discrete)
+{
+  return Discrete(discrete.Probabilities());
+}
+
+//! Convert a Gaussian mixture model.
+template<typename FittingType>
+GMM ToRuntime(const gmm::GMM<FittingType>& gmm)
+{
+  std::vector<Gaussian> components;
+  for (size_t i = 0; i < gmm.Gaussians(); ++i)
+    components.push_back(ToRuntime(gmm.Means()[i], gmm.Covariances()[i]));
+
+  return GMM(gmm.Weights(), components);
+}
+
+/**
+ * The runtime type of an emission distribution of an HMM.
+ */
+template<typename Distribution>
+struct RuntimeDistribution { };
+
+//! Discrete distributions become Discrete.
+template<>
+struct RuntimeDistribution<distribution::DiscreteDistribution>
+{
+  typedef Discrete Type;
+};
+
+//! Gaussian distributions become Gaussian.
+template<>
+struct RuntimeDistribution<distribution::GaussianDistribution>
+{
+  typedef Gaussian Type;
+};
+
+//! Gaussian mixture models become GMM.
+template<typename FittingType>
+struct RuntimeDistribution<gmm::GMM<FittingType> >
+{
+  typedef GMM Type;
+};
+
+//! Convert a hidden Markov model with any of the supported emissions.
+template<typename Distribution>
+HMM<typename RuntimeDistribution<Distribution>::Type> ToRuntime(
+    const hmm::HMM<Distribution>& hmm)
+{
+  std::vector<typename RuntimeDistribution<Distribution>::Type> emission;
+  for (size_t i = 0; i < hmm.Emission().size(); ++i)
+    emission.push_back(ToRuntime(hmm.Emission()[i]));
+
+  return HMM<typename RuntimeDistribution<Distribution>::Type>(
+      hmm.Transition(), emission);
+}
+
+//! Convert a Gaussian naive Bayes classifier.
+inline NaiveBayes ToRuntime(
+    const naive_bayes::NaiveBayesClassifier<arma::mat>& classifier)
+{
+  return NaiveBayes(classifier.Means(), classifier.Variances(),
+      classifier.Probabilities());
+}
+
+//! Convert a logistic regression model.
+template<template<typename> class OptimizerType>
+LogisticRegression ToRuntime(
+    const regression::LogisticRegression<OptimizerType>& model)
+{
+  return LogisticRegression(model.Parameters());
+}
+
+}; // namespace runtime
+}; // namespace mlpack
+
+#endif
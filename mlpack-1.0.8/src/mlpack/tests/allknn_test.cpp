@@ -21,7 +21,13 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 #include <mlpack/methods/neighbor_search/unmap.hpp>
+#include <mlpack/methods/neighbor_search/knn_graph.hpp>
+#include <mlpack/methods/neighbor_search/query_server.hpp>
+#include <mlpack/methods/neighbor_search/multi_neighbor_search.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/tree_index.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -602,13 +608,13 @@ BOOST_AUTO_TEST_CASE(SingleCoverTreeTest)
   arma::mat naiveQuery(data); // For naive AllkNN.
 
   tree::CoverTree<metric::LMetric<2>, tree::FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort> > tree = tree::CoverTree<
+      NeighborSearchStat<NearestNeighborSort, true> > tree = tree::CoverTree<
       metric::LMetric<2>, tree::FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort> >(data);
+      NeighborSearchStat<NearestNeighborSort, true> >(data);
 
   NeighborSearch<NearestNeighborSort, metric::LMetric<2>,
       tree::CoverTree<metric::LMetric<2>, tree::FirstPointIsRoot,
-          NeighborSearchStat<NearestNeighborSort> > >
+          NeighborSearchStat<NearestNeighborSort, true> > >
       coverTreeSearch(&tree, data, true);
 
   AllkNN naive(naiveQuery, true);
@@ -646,13 +652,13 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   tree.Search(5, kdNeighbors, kdDistances);
 
   tree::CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort> > referenceTree = tree::CoverTree<
-      metric::LMetric<2, true>, tree::FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort> >(dataset);
+      NeighborSearchStat<NearestNeighborSort, true> > referenceTree =
+      tree::CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
+      NeighborSearchStat<NearestNeighborSort, true> >(dataset);
 
   NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
       tree::CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort> > >
+      NeighborSearchStat<NearestNeighborSort, true> > >
       coverTreeSearch(&referenceTree, dataset);
 
   arma::Mat<size_t> coverNeighbors;
@@ -666,4 +672,1393 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   }
 }
 
+/**
+ * Test that a cover tree which was grown with Insert() and modified with
+ * Remove() gives the same results as the naive method.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeInsertRemoveTest)
+{
+  arma::mat dataset;
+  dataset.randu(4, 500);
+
+  typedef tree::CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
+      NeighborSearchStat<NearestNeighborSort, true> > TreeType;
+  TreeType referenceTree(dataset);
+
+  dataset.insert_cols(500, arma::randu<arma::mat>(4, 500));
+  for (size_t i = 500; i < 1000; ++i)
+    referenceTree.Insert(i);
+
+  // Take out some of the points (including the root) and put them back.
+  for (size_t i = 0; i < 1000; i += 7)
+    referenceTree.Remove(i);
+  for (size_t i = 0; i < 1000; i += 7)
+    referenceTree.Insert(i);
+
+  NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, TreeType>
+      coverTreeSearch(&referenceTree, dataset);
+
+  arma::Mat<size_t> coverNeighbors;
+  arma::mat coverDistances;
+  coverTreeSearch.Search(5, coverNeighbors, coverDistances);
+
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < coverNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(coverNeighbors(i), naiveNeighbors(i));
+    BOOST_REQUIRE_CLOSE(coverDistances(i), naiveDistances(i), 1e-5);
+  }
+}
+
+/**
+ * Test that the parallel dual-tree search gives the same results as the naive
+ * method, both with and without a separate query set.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 2000);
+  arma::mat queryData;
+  queryData.randu(5, 1500);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(10, naiveNeighbors, naiveDistances);
+
+  AllkNN allknn(referenceData, queryData);
+  allknn.Threads() = 4;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(10, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+
+  // Now with only a reference set, using all available cores.
+  AllkNN monoNaive(referenceData, true);
+  monoNaive.Search(10, naiveNeighbors, naiveDistances);
+
+  AllkNN mono(referenceData);
+  mono.Threads() = 0;
+  mono.Search(10, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Test that single-tree search with the query points split across threads
+ * gives the same results as the naive method.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(4, 1200);
+  arma::mat queryData;
+  queryData.randu(4, 1000);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  AllkNN allknn(referenceData, queryData, false, true);
+  allknn.Threads() = 3;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that a tree index which is saved and loaded again has the same
+ * structure and gives the same search results as the original tree.
+ */
+template<typename TreeType>
+void CheckSameTree(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Begin(), b.Begin());
+  BOOST_REQUIRE_EQUAL(a.Count(), b.Count());
+  BOOST_REQUIRE_EQUAL(a.IsLeaf(), b.IsLeaf());
+  BOOST_REQUIRE_CLOSE(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance(), 1e-10);
+  for (size_t d = 0; d < a.Bound().Dim(); ++d)
+  {
+    BOOST_REQUIRE_EQUAL(a.Bound()[d].Lo(), b.Bound()[d].Lo());
+    BOOST_REQUIRE_EQUAL(a.Bound()[d].Hi(), b.Bound()[d].Hi());
+  }
+
+  if (!a.IsLeaf())
+  {
+    BOOST_REQUIRE_EQUAL(a.SplitDimension(), b.SplitDimension());
+    BOOST_REQUIRE_EQUAL(b.Left()->Parent(), &b);
+    CheckSameTree(*a.Left(), *b.Left());
+    CheckSameTree(*a.Right(), *b.Right());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TreeIndexSaveLoadTest)
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+
+  arma::mat data;
+  data.randu(4, 800);
+  arma::mat reordered(data);
+
+  tree::TreeIndex<TreeType> index(reordered, 15);
+  index.Save("test-tree-index.bin");
+
+  tree::TreeIndex<TreeType> loaded("test-tree-index.bin");
+
+  BOOST_REQUIRE_EQUAL(loaded.Dataset().n_rows, data.n_rows);
+  BOOST_REQUIRE_EQUAL(loaded.Dataset().n_cols, data.n_cols);
+  for (size_t i = 0; i < data.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.Dataset()[i], reordered[i]);
+
+  BOOST_REQUIRE_EQUAL(loaded.OldFromNew().size(), data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.OldFromNew()[i], index.OldFromNew()[i]);
+
+  BOOST_REQUIRE_EQUAL(loaded.Tree().LeafSize(), 15);
+  CheckSameTree(index.Tree(), loaded.Tree());
+
+  // Now the search results must be the same as a naive search on the original
+  // dataset, once they are unmapped.
+  AllkNN allknn(&loaded.Tree(), loaded.Dataset());
+  arma::Mat<size_t> treeNeighbors;
+  arma::mat treeDistances;
+  allknn.Search(5, treeNeighbors, treeDistances);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  Unmap(treeNeighbors, treeDistances, loaded.OldFromNew(),
+      loaded.OldFromNew(), neighbors, distances);
+
+  AllkNN naive(data, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+
+  remove("test-tree-index.bin");
+}
+
+/**
+ * Test that approximate search finds distances within the allowed relative
+ * error of the true distances, in both dual-tree and single-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(10, 2000);
+  arma::mat queryData;
+  queryData.randu(10, 500);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    AllkNN allknn(referenceData, queryData, false, (mode == 1));
+    allknn.Epsilon() = 0.5;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < distances.n_elem; ++i)
+    {
+      BOOST_REQUIRE_GE(distances[i], naiveDistances[i] - 1e-10);
+      BOOST_REQUIRE_LE(distances[i], 1.5 * naiveDistances[i] + 1e-10);
+    }
+  }
+
+  // With no allowed error, the search is exact.
+  AllkNN exact(referenceData, queryData);
+  exact.Epsilon() = 0.0;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  exact.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < distances.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Build a reference tree once and use it for several searches with different
+ * query sets and different values of k, through several NeighborSearch objects
+ * and a RangeSearch object.  Each search must give the same results as the
+ * naive method, so nothing may be left over from the earlier searches.
+ */
+BOOST_AUTO_TEST_CASE(SharedReferenceTreeTest)
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  std::vector<size_t> oldFromNew;
+  TreeType referenceTree(referenceData, oldFromNew);
+
+  for (size_t batch = 0; batch < 3; ++batch)
+  {
+    // Trees built on these matrices reorder them, so the naive searches are
+    // given the reordered matrices.
+    arma::mat queryData;
+    queryData.randu(3, 200 + 100 * batch);
+    TreeType queryTree(queryData, oldFromNew);
+
+    NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, TreeType>
+        allknn(&referenceTree, &queryTree, referenceData, queryData);
+    AllkNN naive(referenceData, queryData, true);
+
+    // Bounds left over from a search with a smaller k would prune too much.
+    for (size_t k = 2; k <= 8; k += 3)
+    {
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      allknn.Search(k, neighbors, distances);
+
+      arma::Mat<size_t> naiveNeighbors;
+      arma::mat naiveDistances;
+      naive.Search(k, naiveNeighbors, naiveDistances);
+
+      for (size_t i = 0; i < neighbors.n_elem; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+        BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+      }
+    }
+
+    // The same trees can be used for range search.
+    range::RangeSearch<metric::LMetric<2, true>, TreeType> rangeSearch(
+        &referenceTree, &queryTree, referenceData, queryData);
+    range::RangeSearch<> naiveRange(referenceData, queryData, true);
+
+    std::vector<std::vector<size_t> > rangeNeighbors;
+    std::vector<std::vector<double> > rangeDistances;
+    rangeSearch.Search(math::Range(0.1, 0.2), rangeNeighbors, rangeDistances);
+
+    std::vector<std::vector<size_t> > naiveRangeNeighbors;
+    std::vector<std::vector<double> > naiveRangeDistances;
+    naiveRange.Search(math::Range(0.1, 0.2), naiveRangeNeighbors,
+        naiveRangeDistances);
+
+    BOOST_REQUIRE_EQUAL(rangeNeighbors.size(), naiveRangeNeighbors.size());
+    for (size_t i = 0; i < rangeNeighbors.size(); ++i)
+    {
+      std::sort(rangeNeighbors[i].begin(), rangeNeighbors[i].end());
+      std::sort(naiveRangeNeighbors[i].begin(), naiveRangeNeighbors[i].end());
+
+      BOOST_REQUIRE_EQUAL(rangeNeighbors[i].size(),
+          naiveRangeNeighbors[i].size());
+      for (size_t j = 0; j < rangeNeighbors[i].size(); ++j)
+        BOOST_REQUIRE_EQUAL(rangeNeighbors[i][j], naiveRangeNeighbors[i][j]);
+    }
+  }
+}
+
+/**
+ * Test that the traversal statistics count every base case of a naive search
+ * (which does not traverse the trees), and that nothing is counted if they are
+ * not enabled.
+ */
+BOOST_AUTO_TEST_CASE(TraversalStatisticsTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 200);
+  arma::mat queryData;
+  queryData.randu(3, 150);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  naive.Search(5, neighbors, distances);
+
+  const tree::TraversalCounts counts = tree::TraversalStatistics::Get();
+  if (tree::TraversalStatistics::Enabled)
+  {
+    BOOST_REQUIRE_EQUAL(counts.baseCases, 200 * 150);
+    BOOST_REQUIRE_EQUAL(counts.scores, 0);
+  }
+  else
+  {
+    BOOST_REQUIRE_EQUAL(counts.baseCases, 0);
+    BOOST_REQUIRE_EQUAL(counts.scores, 0);
+    BOOST_REQUIRE_EQUAL(counts.visitsPerLevel.size(), 0);
+  }
+}
+
+/**
+ * Test that the base cases between leaves calculated with a matrix
+ * multiplication (for high-dimensional data) give the same results as a
+ * brute-force search, for both the Euclidean and squared Euclidean distance.
+ */
+BOOST_AUTO_TEST_CASE(BaseCaseBlockTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(20, 400);
+  arma::mat queryData;
+  queryData.randu(20, 100);
+
+  const size_t k = 5;
+  arma::mat bruteDistances(k, queryData.n_cols);
+  arma::Mat<size_t> bruteNeighbors(k, queryData.n_cols);
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+  {
+    arma::vec d(referenceData.n_cols);
+    for (size_t j = 0; j < referenceData.n_cols; ++j)
+      d[j] = metric::SquaredEuclideanDistance::Evaluate(queryData.col(i),
+          referenceData.col(j));
+
+    const arma::uvec order = arma::sort_index(d);
+    for (size_t j = 0; j < k; ++j)
+    {
+      bruteNeighbors(j, i) = order[j];
+      bruteDistances(j, i) = d[order[j]];
+    }
+  }
+
+  NeighborSearch<NearestNeighborSort, metric::SquaredEuclideanDistance,
+      tree::BinarySpaceTree<bound::HRectBound<2, false>,
+          NeighborSearchStat<NearestNeighborSort> > >
+      squaredSearch(referenceData, queryData, false, false, 10);
+  AllkNN search(referenceData, queryData, false, false, 10);
+
+  arma::Mat<size_t> squaredNeighbors, neighbors;
+  arma::mat squaredDistances, distances;
+  squaredSearch.Search(k, squaredNeighbors, squaredDistances);
+  search.Search(k, neighbors, distances);
+
+  for (size_t i = 0; i < bruteNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(squaredNeighbors[i], bruteNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(squaredDistances[i], bruteDistances[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(neighbors[i], bruteNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], sqrt(bruteDistances[i]), 1e-5);
+  }
+}
+
+/**
+ * Test that a search on single-precision data, with a tree built on an
+ * arma::fmat, finds the same neighbors as the search on the same data in
+ * double precision, both for low-dimensional and high-dimensional data.
+ */
+BOOST_AUTO_TEST_CASE(FloatSearchTest)
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort>, arma::fmat> FloatTreeType;
+  typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+      FloatTreeType> FloatAllkNN;
+
+  const size_t dimensions[] = { 4, 20 };
+  for (size_t t = 0; t < 2; ++t)
+  {
+    arma::mat referenceData;
+    referenceData.randu(dimensions[t], 300);
+    arma::mat queryData;
+    queryData.randu(dimensions[t], 100);
+
+    const arma::fmat floatReferenceData =
+        arma::conv_to<arma::fmat>::from(referenceData);
+    const arma::fmat floatQueryData =
+        arma::conv_to<arma::fmat>::from(queryData);
+
+    AllkNN search(referenceData, queryData, false, false, 10);
+    FloatAllkNN floatSearch(floatReferenceData, floatQueryData, false, false,
+        10);
+
+    arma::Mat<size_t> neighbors, floatNeighbors;
+    arma::mat distances, floatDistances;
+    search.Search(3, neighbors, distances);
+    floatSearch.Search(3, floatNeighbors, floatDistances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(floatNeighbors[i], neighbors[i]);
+      BOOST_REQUIRE_CLOSE(floatDistances[i], distances[i], 1e-2);
+    }
+  }
+}
+
+/**
+ * Test that a kd-tree with a bound and metric of fixed dimensionality finds
+ * the same neighbors as the usual kd-tree, for 2-D and 3-D data.
+ */
+BOOST_AUTO_TEST_CASE(FixedDimensionSearchTest)
+{
+  typedef NeighborSearch<NearestNeighborSort, metric::LMetric<2, true, 2>,
+      tree::BinarySpaceTree<bound::HRectBound<2, true, 2>,
+      NeighborSearchStat<NearestNeighborSort> > > AllkNN2D;
+  typedef NeighborSearch<NearestNeighborSort, metric::LMetric<2, true, 3>,
+      tree::BinarySpaceTree<bound::HRectBound<2, true, 3>,
+      NeighborSearchStat<NearestNeighborSort> > > AllkNN3D;
+
+  for (size_t dimension = 2; dimension <= 3; ++dimension)
+  {
+    arma::mat referenceData;
+    referenceData.randu(dimension, 500);
+    arma::mat queryData;
+    queryData.randu(dimension, 200);
+
+    AllkNN search(referenceData, queryData);
+    arma::Mat<size_t> neighbors, fixedNeighbors;
+    arma::mat distances, fixedDistances;
+    search.Search(5, neighbors, distances);
+
+    if (dimension == 2)
+    {
+      AllkNN2D fixedSearch(referenceData, queryData);
+      fixedSearch.Search(5, fixedNeighbors, fixedDistances);
+    }
+    else
+    {
+      AllkNN3D fixedSearch(referenceData, queryData, false, true);
+      fixedSearch.Search(5, fixedNeighbors, fixedDistances);
+    }
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(fixedNeighbors[i], neighbors[i]);
+      BOOST_REQUIRE_CLOSE(fixedDistances[i], distances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that ball trees give the same results as the naive method, with
+ * dual-tree and single-tree search, with and without a query set.
+ */
+BOOST_AUTO_TEST_CASE(BallTreeVsNaive)
+{
+  typedef tree::BinarySpaceTree<bound::BallBound<>,
+      NeighborSearchStat<NearestNeighborSort> > BallTreeType;
+  typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+      BallTreeType> BallAllkNN;
+
+  arma::mat referenceData;
+  referenceData.randu(10, 1000);
+  arma::mat queryData;
+  queryData.randu(10, 300);
+
+  for (size_t mode = 0; mode < 4; ++mode)
+  {
+    const bool singleMode = (mode % 2 == 1);
+    const bool useQuery = (mode >= 2);
+
+    arma::Mat<size_t> neighbors, naiveNeighbors;
+    arma::mat distances, naiveDistances;
+    if (useQuery)
+    {
+      BallAllkNN ballSearch(referenceData, queryData, false, singleMode, 15);
+      AllkNN naive(referenceData, queryData, true);
+      ballSearch.Search(5, neighbors, distances);
+      naive.Search(5, naiveNeighbors, naiveDistances);
+    }
+    else
+    {
+      BallAllkNN ballSearch(referenceData, false, singleMode, 15);
+      AllkNN naive(referenceData, true);
+      ballSearch.Search(5, neighbors, distances);
+      naive.Search(5, naiveNeighbors, naiveDistances);
+    }
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that periodic kd-trees give the same results as the naive method
+ * with the periodic metric, with dual-tree and single-tree search.  The points
+ * near one face of the box have their nearest neighbors near the opposite face.
+ */
+BOOST_AUTO_TEST_CASE(PeriodicTreeVsNaive)
+{
+  typedef tree::BinarySpaceTree<bound::PeriodicHRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > PeriodicTreeType;
+  typedef NeighborSearch<NearestNeighborSort,
+      metric::PeriodicEuclideanDistance, PeriodicTreeType> PeriodicAllkNN;
+
+  const arma::vec box("2.0 3.0 4.0");
+  const metric::PeriodicEuclideanDistance periodic(box);
+
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+  for (size_t d = 0; d < 3; ++d)
+  {
+    referenceData.row(d) *= box[d];
+    queryData.row(d) *= box[d];
+  }
+
+  for (size_t mode = 0; mode < 4; ++mode)
+  {
+    const bool singleMode = (mode % 2 == 1);
+    const bool useQuery = (mode >= 2);
+
+    arma::Mat<size_t> neighbors, naiveNeighbors;
+    arma::mat distances, naiveDistances;
+    if (useQuery)
+    {
+      PeriodicAllkNN treeSearch(referenceData, queryData, false, singleMode,
+          15, periodic);
+      PeriodicAllkNN naive(referenceData, queryData, true, false, 20,
+          periodic);
+      treeSearch.Search(5, neighbors, distances);
+      naive.Search(5, naiveNeighbors, naiveDistances);
+    }
+    else
+    {
+      PeriodicAllkNN treeSearch(referenceData, false, singleMode, 15,
+          periodic);
+      PeriodicAllkNN naive(referenceData, true, false, 20, periodic);
+      treeSearch.Search(5, neighbors, distances);
+      naive.Search(5, naiveNeighbors, naiveDistances);
+    }
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that random projection trees give the same results as the naive
+ * method on high-dimensional data, with dual-tree and single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(RPTreeVsNaive)
+{
+  typedef tree::BinarySpaceTree<bound::BallBound<>,
+      NeighborSearchStat<NearestNeighborSort>, arma::mat, tree::RPSplit>
+      RPTreeType;
+  typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+      RPTreeType> RPAllkNN;
+
+  // 128-dimensional points near an 8-dimensional subspace.
+  const arma::mat basis = arma::randn<arma::mat>(128, 8);
+  arma::mat referenceData = basis * arma::randn<arma::mat>(8, 2000) +
+      0.05 * arma::randn<arma::mat>(128, 2000);
+  arma::mat queryData = basis * arma::randn<arma::mat>(8, 200) +
+      0.05 * arma::randn<arma::mat>(128, 200);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    RPAllkNN rpSearch(referenceData, queryData, false, (mode == 1), 20);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    rpSearch.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Test that a symmetric search, which compares each pair of leaves once, gives
+ * the same results as the naive method, both with BaseCase() (low dimensions)
+ * and with the matrix multiplication of BaseCaseBlock() (high dimensions).
+ */
+BOOST_AUTO_TEST_CASE(SymmetricSearchVsNaive)
+{
+  for (size_t d = 3; d <= 20; d += 17)
+  {
+    arma::mat referenceData;
+    referenceData.randu(d, 2000);
+
+    AllkNN naive(referenceData, true);
+    arma::Mat<size_t> naiveNeighbors;
+    arma::mat naiveDistances;
+    naive.Search(10, naiveNeighbors, naiveDistances);
+
+    AllkNN allknn(referenceData);
+    allknn.Symmetric() = true;
+    allknn.Threads() = 4; // Ignored for a symmetric search.
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(10, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+
+    // A symmetric naive search has one leaf, compared with itself.
+    AllkNN symmetricNaive(referenceData, true);
+    symmetricNaive.Symmetric() = true;
+    symmetricNaive.Search(10, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Test that the kNN graph joins exactly the points where one is a neighbor of
+ * the other (or both, for the mutual graph), with the right weights.
+ */
+BOOST_AUTO_TEST_CASE(KNNGraphTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  naive.Search(5, neighbors, distances);
+
+  arma::mat isNeighbor(1000, 1000);
+  isNeighbor.zeros();
+  for (size_t j = 0; j < 1000; ++j)
+    for (size_t i = 0; i < 5; ++i)
+      isNeighbor(neighbors(i, j), j) = 1;
+
+  AllkNN allknn(referenceData);
+  arma::sp_mat graph;
+  allknn.Graph(5, graph);
+
+  arma::sp_mat mutualGraph;
+  allknn.Graph(5, mutualGraph, 0.5, true);
+
+  for (size_t j = 0; j < 1000; ++j)
+  {
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      const bool either = (isNeighbor(i, j) + isNeighbor(j, i) > 0);
+      const bool both = (isNeighbor(i, j) + isNeighbor(j, i) == 2);
+      const double distance = arma::norm(referenceData.col(i) -
+          referenceData.col(j), 2);
+
+      if (either)
+        BOOST_REQUIRE_CLOSE((double) graph(i, j), distance, 1e-5);
+      else
+        BOOST_REQUIRE_SMALL((double) graph(i, j), 1e-10);
+
+      if (both)
+        BOOST_REQUIRE_CLOSE((double) mutualGraph(i, j),
+            exp(-distance * distance / 0.5), 1e-5);
+      else
+        BOOST_REQUIRE_SMALL((double) mutualGraph(i, j), 1e-10);
+    }
+  }
+
+  // KNNGraph() gives the same graph from the results of Search().
+  arma::sp_mat searchGraph;
+  KNNGraph(neighbors, distances, searchGraph);
+  BOOST_REQUIRE_EQUAL(searchGraph.n_nonzero, graph.n_nonzero);
+}
+
+/**
+ * Test that a QueryServer answers batches of queries with different k like the
+ * naive method, both through Search() and through the text protocol of
+ * Serve(), and that malformed requests get an error without ending the
+ * session.
+ */
+BOOST_AUTO_TEST_CASE(QueryServerTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 2000);
+  arma::mat queryData;
+  queryData.randu(3, 50);
+
+  QueryServer<> server(referenceData, 10);
+  server.Threads() = 2;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  for (size_t k = 1; k <= 10; k += 9)
+  {
+    AllkNN naive(referenceData, queryData, true);
+    arma::Mat<size_t> naiveNeighbors;
+    arma::mat naiveDistances;
+    naive.Search(k, naiveNeighbors, naiveDistances);
+
+    server.Search(queryData, k, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(server.QueriesAnswered(), 100);
+
+  // Send the first two query points (k = 10) through the protocol, with
+  // malformed requests before and after.
+  std::ostringstream requests;
+  requests.precision(17);
+  requests << "info\nfoo\nknn 10\nknn 10 1\n1 2\nknn 10 2\n";
+  for (size_t i = 0; i < 2; ++i)
+    requests << queryData(0, i) << ", " << queryData(1, i) << ", "
+        << queryData(2, i) << "\n";
+  requests << "knn 0 1\n1 2 3\nquit\ninfo\n";
+
+  std::istringstream input(requests.str());
+  std::ostringstream output;
+  BOOST_REQUIRE_EQUAL(server.Serve(input, output), false);
+
+  std::istringstream replies(output.str());
+  std::string line;
+  std::getline(replies, line);
+  BOOST_REQUIRE_EQUAL(line, "ok 2000 3");
+  for (size_t i = 0; i < 3; ++i)
+  {
+    std::getline(replies, line);
+    BOOST_REQUIRE_EQUAL(line.substr(0, 6), "error ");
+  }
+
+  std::getline(replies, line);
+  BOOST_REQUIRE_EQUAL(line, "ok 2 10");
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 10; ++j)
+    {
+      size_t neighbor;
+      replies >> neighbor;
+      BOOST_REQUIRE_EQUAL(neighbor, neighbors(j, i));
+    }
+    for (size_t j = 0; j < 10; ++j)
+    {
+      double distance;
+      replies >> distance;
+      BOOST_REQUIRE_CLOSE(distance, distances(j, i), 1e-5);
+    }
+  }
+  std::getline(replies, line); // The rest of the last line.
+
+  // The request with k = 0 fails; the session ends at "quit".
+  std::getline(replies, line);
+  BOOST_REQUIRE_EQUAL(line.substr(0, 6), "error ");
+  std::getline(replies, line);
+  BOOST_REQUIRE_EQUAL(line, "ok");
+  BOOST_REQUIRE(!std::getline(replies, line));
+
+  std::istringstream shutdown("shutdown\n");
+  BOOST_REQUIRE_EQUAL(server.Serve(shutdown, output), true);
+}
+
+/**
+ * Search with GPU() set, with and without a query set, and make sure the
+ * results are those of naive search.  Without a Metal device the search falls
+ * back to the trees, which must give the same results.
+ */
+BOOST_AUTO_TEST_CASE(GPUSearchVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 200);
+
+  for (size_t run = 0; run < 2; ++run)
+  {
+    AllkNN* naive = (run == 0) ? new AllkNN(referenceData, true) :
+        new AllkNN(referenceData, queryData, true);
+    AllkNN* gpu = (run == 0) ? new AllkNN(referenceData) :
+        new AllkNN(referenceData, queryData);
+    gpu->GPU() = true;
+
+    arma::Mat<size_t> naiveNeighbors, neighbors;
+    arma::mat naiveDistances, distances;
+    naive->Search(7, naiveNeighbors, naiveDistances);
+    gpu->Search(7, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+
+    delete naive;
+    delete gpu;
+  }
+}
+
+/**
+ * Give the datasets to NeighborSearch instead of copying them, with and
+ * without a query set and in dual-tree and single-tree mode, and make sure the
+ * given matrices are emptied and the results are those of the copying
+ * constructors, in the original order of the points.
+ */
+BOOST_AUTO_TEST_CASE(TakeOverDatasetTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  for (size_t run = 0; run < 4; ++run)
+  {
+    const bool singleMode = (run % 2 == 1);
+    arma::mat references(referenceData);
+    arma::mat queries(queryData);
+
+    AllkNN* copied = (run < 2) ?
+        new AllkNN(referenceData, false, singleMode) :
+        new AllkNN(referenceData, queryData, false, singleMode);
+    AllkNN* given = (run < 2) ?
+        new AllkNN(&references, false, singleMode) :
+        new AllkNN(&references, &queries, false, singleMode);
+
+    BOOST_REQUIRE_EQUAL(references.n_elem, 0);
+    if (run >= 2)
+      BOOST_REQUIRE_EQUAL(queries.n_elem, 0);
+
+    arma::Mat<size_t> copiedNeighbors, neighbors;
+    arma::mat copiedDistances, distances;
+    copied->Search(5, copiedNeighbors, copiedDistances);
+    given->Search(5, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, copiedNeighbors.n_cols);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], copiedNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], copiedDistances[i], 1e-5);
+    }
+
+    delete copied;
+    delete given;
+  }
+}
+
+//! A monitor which counts the steps reported, and stops methods after the given
+//! step.
+class StepMonitor : public ProgressMonitor
+{
+ public:
+  StepMonitor(const size_t lastStep) : lastStep(lastStep), steps(0) { }
+
+  size_t lastStep;
+  size_t steps;
+
+ protected:
+  bool Report(const std::string& /* task */,
+              const size_t step,
+              const double /* value */)
+  {
+    ++steps;
+    return (step < lastStep);
+  }
+};
+
+/**
+ * Search with a ProgressMonitor.  A monitor which does not stop the search is
+ * called for each batch, and does not change the results; a monitor which
+ * stops single-tree search after two batches leaves the query points after the
+ * first two batches unsearched.
+ */
+BOOST_AUTO_TEST_CASE(SearchMonitorTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 2000);
+  arma::mat queryData;
+  queryData.randu(3, 500);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(3, naiveNeighbors, naiveDistances);
+
+  for (size_t single = 0; single < 2; ++single)
+  {
+    StepMonitor monitor((size_t) -1);
+    AllkNN allknn(referenceData, queryData, false, single == 1);
+    allknn.Monitor() = &monitor;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(3, neighbors, distances);
+
+    BOOST_REQUIRE(!monitor.Stopped());
+    BOOST_REQUIRE_GT(monitor.steps, 1);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+
+  // In single-tree mode the query set is not reordered, and with one thread
+  // the batches of 64 points are searched in order.
+  StepMonitor monitor(2);
+  AllkNN allknn(referenceData, queryData, false, true);
+  allknn.Monitor() = &monitor;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(3, neighbors, distances);
+
+  BOOST_REQUIRE(monitor.Stopped());
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      if (i < 128)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), naiveNeighbors(j, i));
+        BOOST_REQUIRE_CLOSE(distances(j, i), naiveDistances(j, i), 1e-5);
+      }
+      else
+      {
+        BOOST_REQUIRE_EQUAL(distances(j, i), DBL_MAX);
+      }
+    }
+  }
+}
+
+/**
+ * Test that CandidateHeap keeps the k best of a stream of candidates, and sorts
+ * them like a sorted list would, for both sort policies.
+ */
+BOOST_AUTO_TEST_CASE(CandidateHeapTest)
+{
+  const size_t k = 100;
+  arma::vec values;
+  values.randu(2000);
+
+  arma::vec nearest(k);
+  nearest.fill(NearestNeighborSort::WorstDistance());
+  arma::Col<size_t> nearestIndices(k);
+  arma::vec furthest(k);
+  furthest.fill(FurthestNeighborSort::WorstDistance());
+  arma::Col<size_t> furthestIndices(k);
+
+  for (size_t i = 0; i < values.n_elem; ++i)
+  {
+    CandidateHeap<NearestNeighborSort>::Insert(nearest.memptr(),
+        nearestIndices.memptr(), k, values[i], i);
+    CandidateHeap<FurthestNeighborSort>::Insert(furthest.memptr(),
+        furthestIndices.memptr(), k, values[i], i);
+  }
+
+  CandidateHeap<NearestNeighborSort>::Sort(nearest.memptr(),
+      nearestIndices.memptr(), k);
+  CandidateHeap<FurthestNeighborSort>::Sort(furthest.memptr(),
+      furthestIndices.memptr(), k);
+
+  const arma::uvec order = arma::sort_index(values);
+  for (size_t i = 0; i < k; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(nearestIndices[i], order[i]);
+    BOOST_REQUIRE_EQUAL(nearest[i], values[order[i]]);
+    BOOST_REQUIRE_EQUAL(furthestIndices[i], order[values.n_elem - 1 - i]);
+    BOOST_REQUIRE_EQUAL(furthest[i], values[order[values.n_elem - 1 - i]]);
+  }
+
+  // With fewer candidates than k, the list ends with the worst distance.
+  nearest.fill(NearestNeighborSort::WorstDistance());
+  for (size_t i = 0; i < 10; ++i)
+    CandidateHeap<NearestNeighborSort>::Insert(nearest.memptr(),
+        nearestIndices.memptr(), k, values[i], i);
+  CandidateHeap<NearestNeighborSort>::Sort(nearest.memptr(),
+      nearestIndices.memptr(), k);
+
+  const arma::vec first = arma::sort(values.subvec(0, 9));
+  for (size_t i = 0; i < k; ++i)
+    BOOST_REQUIRE_EQUAL(nearest[i], (i < 10) ? first[i] : DBL_MAX);
+}
+
+/**
+ * Find the k nearest neighbors of each query point by sorting the Euclidean
+ * distances to all the reference points.
+ */
+void ExhaustiveSearch(const arma::mat& referenceData,
+                      const arma::mat& queryData,
+                      const size_t k,
+                      arma::Mat<size_t>& neighbors,
+                      arma::mat& distances)
+{
+  neighbors.set_size(k, queryData.n_cols);
+  distances.set_size(k, queryData.n_cols);
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+  {
+    arma::vec allDistances(referenceData.n_cols);
+    for (size_t j = 0; j < referenceData.n_cols; ++j)
+      allDistances[j] = metric::EuclideanDistance::Evaluate(
+          queryData.unsafe_col(i), referenceData.unsafe_col(j));
+
+    const arma::uvec order = arma::sort_index(allDistances);
+    for (size_t j = 0; j < k; ++j)
+    {
+      neighbors(j, i) = order[j];
+      distances(j, i) = allDistances[order[j]];
+    }
+  }
+}
+
+/**
+ * Test that a search for many neighbors, where the candidates are kept as
+ * heaps, gives the neighbors of an exhaustive search in the right order with
+ * the naive, single-tree and dual-tree methods.
+ */
+BOOST_AUTO_TEST_CASE(LargeKSearchTest)
+{
+  const size_t k = 2 * CandidateHeap<NearestNeighborSort>::MinK;
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 200);
+
+  arma::Mat<size_t> exactNeighbors;
+  arma::mat exactDistances;
+  ExhaustiveSearch(referenceData, queryData, k, exactNeighbors,
+      exactDistances);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    AllkNN allknn(referenceData, queryData, mode == 0, mode == 1);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(k, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], exactNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], exactDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Test the brute-force search, which is used in naive mode and for data with
+ * more than BruteForceMinDimensionality dimensions: with the matrix
+ * multiplication (high dimensions) and with BaseCase() (low dimensions), with
+ * several threads, and with a monitor, which is called after each block of
+ * query points.
+ */
+BOOST_AUTO_TEST_CASE(BruteForceSearchTest)
+{
+  const size_t d[] = { 3, AllkNN::BruteForceMinDimensionality + 20 };
+  for (size_t t = 0; t < 2; ++t)
+  {
+    arma::mat referenceData;
+    referenceData.randu(d[t], 1500);
+    arma::mat queryData;
+    queryData.randu(d[t], 300);
+
+    arma::Mat<size_t> exactNeighbors;
+    arma::mat exactDistances;
+    ExhaustiveSearch(referenceData, queryData, 10, exactNeighbors,
+        exactDistances);
+
+    // In high dimensions, the brute-force search is used even if naive mode
+    // is not asked for.
+    StepMonitor monitor((size_t) -1);
+    AllkNN allknn(referenceData, queryData, t == 0);
+    allknn.Threads() = 4;
+    allknn.Monitor() = &monitor;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(10, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(monitor.steps, 5); // 300 points in blocks of 64.
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], exactNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], exactDistances[i], 1e-5);
+    }
+  }
+
+  // Without a query set, no point is its own neighbor.
+  arma::mat data;
+  data.randu(AllkNN::BruteForceMinDimensionality + 20, 500);
+  AllkNN allknn(data);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      BOOST_REQUIRE_NE(neighbors(j, i), i);
+}
+
+/**
+ * Test that best-first single-tree search gives the same results as the naive
+ * method, and that with a limit on the number of leaves, each query point
+ * visits at most that many leaves and gets neighbors which are no better than
+ * the true ones.
+ */
+BOOST_AUTO_TEST_CASE(BestFirstSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 2000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  AllkNN allknn(referenceData, queryData, false, true);
+  allknn.BestFirst() = true;
+  allknn.Threads() = 4;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+
+  // Each leaf holds at most 20 points, so two leaves may not be enough, but
+  // the distances are still those of the neighbors found.
+  allknn.MaxLeaves() = 2;
+  allknn.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_GE(distances(j, i), naiveDistances(j, i) - 1e-10);
+      if (distances(j, i) != DBL_MAX)
+        BOOST_REQUIRE_CLOSE(distances(j, i), metric::EuclideanDistance::
+            Evaluate(queryData.unsafe_col(i), referenceData.unsafe_col(
+            neighbors(j, i))), 1e-5);
+    }
+  }
+
+  // The traverser itself stops after the given number of leaves.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  typedef NeighborSearchRules<NearestNeighborSort, metric::EuclideanDistance,
+      TreeType> RuleType;
+
+  arma::mat treeData(referenceData);
+  TreeType referenceTree(treeData, 10);
+  metric::EuclideanDistance metric;
+  neighbors.set_size(5, queryData.n_cols);
+  distances.set_size(5, queryData.n_cols);
+  distances.fill(DBL_MAX);
+  RuleType rules(treeData, queryData, neighbors, distances, metric);
+
+  tree::BestFirstTraverser<TreeType, RuleType> traverser(rules, 3);
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+  {
+    traverser.Traverse(i, referenceTree);
+    BOOST_REQUIRE_LE(traverser.LeavesVisited(), 3);
+    BOOST_REQUIRE_GE(traverser.LeavesVisited(), 1);
+  }
+}
+
+/**
+ * Make sure the statistic without the base case cache is smaller than the one
+ * with it, and that the leaves of a kd-tree hold the squared norms of their
+ * points.
+ */
+BOOST_AUTO_TEST_CASE(CompactStatisticTest)
+{
+  BOOST_REQUIRE_LT(sizeof(NeighborSearchStat<NearestNeighborSort>),
+      sizeof(NeighborSearchStat<NearestNeighborSort, true>));
+
+  arma::mat data = arma::randu<arma::mat>(5, 200);
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  TreeType tree(data, 10);
+
+  std::vector<TreeType*> nodes(1, &tree);
+  while (!nodes.empty())
+  {
+    TreeType* node = nodes.back();
+    nodes.pop_back();
+
+    const std::vector<double>& norms = node->Stat().SquaredNorms();
+    if (!node->IsLeaf())
+    {
+      BOOST_REQUIRE_EQUAL(norms.size(), 0);
+      nodes.push_back(node->Left());
+      nodes.push_back(node->Right());
+      continue;
+    }
+
+    BOOST_REQUIRE_EQUAL(norms.size(), node->Count());
+    for (size_t i = 0; i < node->Count(); ++i)
+      BOOST_REQUIRE_CLOSE(norms[i], arma::dot(data.col(node->Begin() + i),
+          data.col(node->Begin() + i)), 1e-5);
+  }
+}
+
+/**
+ * Results left in tree order, mapped back with the permutations, should be the
+ * results mapped back by Search(), in every mode.
+ */
+BOOST_AUTO_TEST_CASE(TreeOrderTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 300);
+  arma::mat queryData = arma::randu<arma::mat>(3, 120);
+
+  for (size_t mode = 0; mode < 4; ++mode)
+  {
+    const bool single = (mode % 2 == 1);
+    AllkNN* knn = (mode < 2) ?
+        new AllkNN(referenceData, queryData, false, single) :
+        new AllkNN(referenceData, false, single);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn->Search(5, neighbors, distances);
+
+    knn->TreeOrder() = true;
+    arma::Mat<size_t> treeNeighbors;
+    arma::mat treeDistances;
+    knn->Search(5, treeNeighbors, treeDistances);
+
+    std::vector<size_t> queryMap = knn->OldFromNewQueries();
+    if (mode >= 2)
+      queryMap = knn->OldFromNewReferences();
+    BOOST_REQUIRE_EQUAL(queryMap.size(), (mode == 1) ? 0 : neighbors.n_cols);
+
+    for (size_t i = 0; i < treeNeighbors.n_cols; ++i)
+    {
+      const size_t original = queryMap.empty() ? i : queryMap[i];
+      for (size_t j = 0; j < 5; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(knn->OldFromNewReferences()[treeNeighbors(j, i)],
+            neighbors(j, original));
+        BOOST_REQUIRE_CLOSE(treeDistances(j, i), distances(j, original),
+            1e-5);
+      }
+    }
+
+    delete knn;
+  }
+}
+
+/**
+ * Searching one query set against several reference sets at once, with one or
+ * more threads, should give the same results as naive search against each
+ * reference set.
+ */
+BOOST_AUTO_TEST_CASE(MultiNeighborSearchTest)
+{
+  arma::mat queryData = arma::randu<arma::mat>(3, 3000);
+  std::vector<arma::mat> referenceData;
+  referenceData.push_back(arma::randu<arma::mat>(3, 500));
+  referenceData.push_back(arma::randu<arma::mat>(3, 2000) + 0.5);
+  referenceData.push_back(arma::randu<arma::mat>(3, 10));
+
+  std::vector<arma::Mat<size_t> > naiveNeighbors(3);
+  std::vector<arma::mat> naiveDistances(3);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    AllkNN naive(referenceData[i], queryData, true);
+    naive.Search(5, naiveNeighbors[i], naiveDistances[i]);
+  }
+
+  for (size_t threads = 1; threads <= 2; ++threads)
+  {
+    MultiNeighborSearch<NearestNeighborSort, metric::EuclideanDistance>
+        search(queryData);
+    search.Threads() = threads;
+    for (size_t i = 0; i < 3; ++i)
+      BOOST_REQUIRE_EQUAL(search.AddReferenceSet(referenceData[i]), i);
+    BOOST_REQUIRE_EQUAL(search.ReferenceSets(), 3);
+
+    std::vector<arma::Mat<size_t> > neighbors;
+    std::vector<arma::mat> distances;
+    search.Search(5, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.size(), 3);
+    BOOST_REQUIRE_EQUAL(distances.size(), 3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i].n_rows, 5);
+      BOOST_REQUIRE_EQUAL(neighbors[i].n_cols, 3000);
+      for (size_t j = 0; j < neighbors[i].n_elem; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i][j], naiveNeighbors[i][j]);
+        BOOST_REQUIRE_CLOSE(distances[i][j], naiveDistances[i][j], 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * A pre-built query tree can be shared: the results, in the order of the
+ * tree, should match those of a NeighborSearch object using the same tree.
+ */
+BOOST_AUTO_TEST_CASE(MultiNeighborSearchQueryTreeTest)
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+
+  arma::mat queryData = arma::randu<arma::mat>(4, 800);
+  arma::mat referenceData = arma::randu<arma::mat>(4, 600);
+
+  std::vector<size_t> oldFromNew;
+  TreeType queryTree(queryData, oldFromNew, 10);
+  std::vector<size_t> referenceOldFromNew;
+  TreeType referenceTree(referenceData, referenceOldFromNew, 10);
+
+  MultiNeighborSearch<NearestNeighborSort, metric::EuclideanDistance>
+      search(&queryTree, queryData);
+  search.AddReferenceTree(&referenceTree, referenceData);
+  search.AddReferenceTree(&referenceTree, referenceData);
+
+  std::vector<arma::Mat<size_t> > neighbors;
+  std::vector<arma::mat> distances;
+  search.Search(3, neighbors, distances);
+
+  AllkNN knn(&referenceTree, &queryTree, referenceData, queryData);
+  arma::Mat<size_t> knnNeighbors;
+  arma::mat knnDistances;
+  knn.Search(3, knnNeighbors, knnDistances);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < knnNeighbors.n_elem; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i][j], knnNeighbors[j]);
+      BOOST_REQUIRE_CLOSE(distances[i][j], knnDistances[j], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -404,6 +404,71 @@ BOOST_AUTO_TEST_CASE(SingleCoverTreeTest)
   BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
 }
 
+// Test single-tree rank-approximate search with random projection trees.
+BOOST_AUTO_TEST_CASE(SingleRPTreeTest)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  // Search for 1 rank-approximate nearest-neighbors in the top 30% of the point
+  // (rank error of 3).
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  typedef tree::BinarySpaceTree<bound::BallBound<>,
+      RAQueryStat<NearestNeighborSort>, arma::mat, tree::RPSplit> TreeType;
+  typedef RASearch<NearestNeighborSort, metric::EuclideanDistance, TreeType>
+      RARPTreeSearch;
+
+  // The trees are built on copies of the data, and the results are mapped
+  // back to the original indices.
+  RARPTreeSearch tssRann(refData, queryData, false, true, 5);
+
+  // The relative ranks for the given query reference pair.
+  arma::Mat<size_t> qrRanks;
+  data::Load("rann_test_qr_ranks.csv", qrRanks, true, false); // No transpose.
+
+  size_t numRounds = 1000;
+  arma::Col<size_t> numSuccessRounds(queryData.n_cols);
+  numSuccessRounds.fill(0);
+
+  // 1% of 900 is 9, so the rank is expected to be less than 10.
+  size_t expectedRankErrorUB = 10;
+
+  for (size_t rounds = 0; rounds < numRounds; rounds++)
+  {
+    tssRann.Search(1, neighbors, distances, 1.0, 0.95, false, false, 5);
+
+    for (size_t i = 0; i < queryData.n_cols; i++)
+      if (qrRanks(i, neighbors(0, i)) < expectedRankErrorUB)
+        numSuccessRounds[i]++;
+
+    neighbors.reset();
+    distances.reset();
+  }
+
+  // Find the 95%-tile threshold so that 95% of the queries should pass this
+  // threshold.
+  size_t threshold = floor(numRounds *
+      (0.95 - (1.96 * sqrt(0.95 * 0.05 / numRounds))));
+  size_t numQueriesFail = 0;
+  for (size_t i = 0; i < queryData.n_cols; i++)
+    if (numSuccessRounds[i] < threshold)
+      numQueriesFail++;
+
+  Log::Warn << "RANN-TSS (RP tree): RANN guarantee fails on "
+      << numQueriesFail << " queries." << endl;
+
+  // Assert that at most 5% of the queries fall out of this threshold.
+  // 5% of 100 queries is 5.
+  size_t maxNumQueriesFail = 6;
+
+  BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
+}
+
 // Test dual-tree rank-approximate search with cover trees.
 BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
 {
@@ -471,4 +536,165 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
 }
 
+// Make sure that the block evaluation of sampled points gives the same
+// distances as the metrics themselves.
+template<typename MetricType>
+void CheckSampleBlock(const arma::mat& dataset)
+{
+  MetricType metric;
+
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < dataset.n_cols; i += 3)
+    indices.push_back(i);
+  indices.push_back(1);
+
+  arma::vec blockDistances;
+  SampleBlock<MetricType>::Evaluate(metric, dataset.unsafe_col(2), dataset,
+      indices, blockDistances);
+
+  BOOST_REQUIRE_EQUAL(blockDistances.n_elem, indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    const double distance = metric.Evaluate(dataset.unsafe_col(2),
+        dataset.unsafe_col(indices[i]));
+    BOOST_REQUIRE_CLOSE(blockDistances[i], distance, 1e-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SampleBlockTest)
+{
+  arma::mat dataset(4, 50);
+  dataset.randu();
+
+  CheckSampleBlock<metric::ManhattanDistance>(dataset);
+  CheckSampleBlock<metric::EuclideanDistance>(dataset);
+  CheckSampleBlock<metric::SquaredEuclideanDistance>(dataset);
+  CheckSampleBlock<metric::LMetric<3, true> >(dataset);
+}
+
+// With the same seed, parallel single-tree search should give exactly the
+// same results as serial single-tree search, and parallel dual-tree search
+// should still give valid neighbors.
+BOOST_AUTO_TEST_CASE(ParallelSearch)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  arma::Mat<size_t> serialNeighbors;
+  arma::mat serialDistances;
+
+  RASearch<> serial(refData, queryData, false, true, 5);
+  math::RandomSeed(42);
+  serial.Search(1, serialNeighbors, serialDistances, 1.0, 0.95, false, false,
+      5);
+
+  const size_t threads[] = { 2, 4, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+
+    RASearch<> parallel(refData, queryData, false, true, 5);
+    parallel.Threads() = threads[t];
+    math::RandomSeed(42);
+    parallel.Search(1, neighbors, distances, 1.0, 0.95, false, false, 5);
+
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors(0, i), serialNeighbors(0, i));
+      BOOST_REQUIRE_EQUAL(distances(0, i), serialDistances(0, i));
+    }
+
+    RASearch<> parallelDual(refData, queryData, false, false, 5);
+    parallelDual.Threads() = threads[t];
+    parallelDual.Search(1, neighbors, distances, 1.0, 0.95, false, false, 5);
+
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      BOOST_REQUIRE_LT(neighbors(0, i), refData.n_cols);
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          queryData.unsafe_col(i), refData.unsafe_col(neighbors(0, i)));
+      BOOST_REQUIRE_CLOSE(distances(0, i), distance, 1e-5);
+    }
+  }
+}
+
+// With quantized reference points and re-ranking, the distances returned
+// should be the exact distances to the neighbors, in order.
+BOOST_AUTO_TEST_CASE(QuantizedSearch)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RASearch<> rsRann(refData, queryData, (mode == 0), (mode == 1), 5);
+    rsRann.Quantize();
+    rsRann.Rerank() = true;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    rsRann.Search(3, neighbors, distances, 10.0, 0.95, false, false, 5);
+
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+      {
+        BOOST_REQUIRE_LT(neighbors(j, i), refData.n_cols);
+        BOOST_REQUIRE_CLOSE(distances(j, i),
+            metric::SquaredEuclideanDistance::Evaluate(
+            queryData.unsafe_col(i), refData.unsafe_col(neighbors(j, i))),
+            1e-5);
+        if (j > 0)
+          BOOST_REQUIRE_LE(distances(j - 1, i), distances(j, i));
+      }
+    }
+  }
+}
+
+/**
+ * Sample sizes should be computed once for each combination of parameters,
+ * give the success probability asked for, and be reused by later searches.
+ */
+BOOST_AUTO_TEST_CASE(SampleSizeTableTest)
+{
+  SampleSizeTable::Clear();
+  BOOST_REQUIRE_EQUAL(SampleSizeTable::Size(), 0);
+
+  const size_t samples = SampleSizeTable::MinimumSamples(1000, 5, 5.0, 0.95);
+  BOOST_REQUIRE_EQUAL(samples, SampleSizeTable::Compute(1000, 5, 5.0, 0.95));
+  BOOST_REQUIRE_GE(SampleSizeTable::SuccessProbability(1000, 5, samples, 50),
+      0.95);
+  BOOST_REQUIRE_EQUAL(SampleSizeTable::MinimumSamples(1000, 5, 5.0, 0.95),
+      samples);
+  BOOST_REQUIRE_EQUAL(SampleSizeTable::Size(), 1);
+
+  arma::mat refData;
+  arma::mat queryData;
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  // Every k up to 3 for this reference set.
+  SampleSizeTable::Precompute(refData.n_cols, 3, 10.0, 0.95);
+  BOOST_REQUIRE_EQUAL(SampleSizeTable::Size(), 4);
+
+  RASearch<> rsRann(refData, queryData);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  for (size_t i = 0; i < 2; ++i)
+  {
+    rsRann.Search(3, neighbors, distances, 10.0, 0.95);
+    BOOST_REQUIRE_EQUAL(SampleSizeTable::Size(), 4);
+  }
+
+  SampleSizeTable::Clear();
+  BOOST_REQUIRE_EQUAL(SampleSizeTable::Size(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
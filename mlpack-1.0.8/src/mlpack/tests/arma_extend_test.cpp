@@ -47,4 +47,54 @@ BOOST_AUTO_TEST_CASE(InplaceReshapeMatrixTest)
     BOOST_REQUIRE_CLOSE(X[i], oldX[i], 1e-5); // Order should be preserved.
 }
 
+/**
+ * The blocked ccov() and ccov_onepass() should match cov(trans(X)), also over
+ * several blocks and with a large mean.
+ */
+BOOST_AUTO_TEST_CASE(CcovBlockedTest)
+{
+  arma::mat X;
+  X.randu(6, 2500);
+  X.row(2) += 1e4;
+
+  const arma::mat trueCov = arma::cov(arma::trans(X));
+  const arma::mat trueBiasedCov = arma::cov(arma::trans(X), 1);
+
+  const arma::mat blocked = arma::ccov(X);
+  const arma::mat onePass = arma::ccov_onepass(X);
+  const arma::mat onePassBiased = arma::ccov_onepass(X, 1);
+
+  BOOST_REQUIRE_EQUAL(blocked.n_rows, 6);
+  BOOST_REQUIRE_EQUAL(blocked.n_cols, 6);
+  for (size_t i = 0; i < trueCov.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(blocked[i] + 1.0, trueCov[i] + 1.0, 1e-8);
+    BOOST_REQUIRE_CLOSE(onePass[i] + 1.0, trueCov[i] + 1.0, 1e-8);
+    BOOST_REQUIRE_CLOSE(onePassBiased[i] + 1.0, trueBiasedCov[i] + 1.0, 1e-8);
+  }
+}
+
+/**
+ * ccov() and ccov_onepass() of single-precision data should match the
+ * covariance of the same data computed in double precision.
+ */
+BOOST_AUTO_TEST_CASE(CcovFloatTest)
+{
+  arma::fmat X;
+  X.randu(5, 20000);
+  X.row(1) += 100.0f;
+
+  const arma::mat doubleX = arma::conv_to<arma::mat>::from(X);
+  const arma::mat trueCov = arma::cov(arma::trans(doubleX));
+
+  const arma::fmat blocked = arma::ccov(X);
+  const arma::fmat onePass = arma::ccov_onepass(X);
+
+  for (size_t i = 0; i < trueCov.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(blocked[i] + 1.0, trueCov[i] + 1.0, 1e-3);
+    BOOST_REQUIRE_CLOSE(onePass[i] + 1.0, trueCov[i] + 1.0, 1e-3);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
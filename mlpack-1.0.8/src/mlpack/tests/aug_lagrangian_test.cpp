@@ -76,4 +76,53 @@ BOOST_AUTO_TEST_CASE(GockenbachFunctionTest)
   BOOST_REQUIRE_CLOSE(coords[2], 0.015099932, 1e-3);
 }
 
+/**
+ * Tests the Augmented Lagrangian optimizer using the Gockenbach function, with
+ * the L-BFGS history kept between the outer iterations.
+ */
+BOOST_AUTO_TEST_CASE(GockenbachFunctionWarmStartTest)
+{
+  GockenbachFunction f;
+  AugLagrangian<GockenbachFunction> aug(f);
+  aug.LBFGS().WarmStart() = true;
+
+  arma::vec coords = f.GetInitialPoint();
+
+  if (!aug.Optimize(coords, 0))
+    BOOST_FAIL("Optimization reported failure.");
+
+  double finalValue = f.Evaluate(coords);
+
+  BOOST_REQUIRE_CLOSE(finalValue, 29.633926, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[0], 0.12288178, 1e-3);
+  BOOST_REQUIRE_CLOSE(coords[1], -1.10778185, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[2], 0.015099932, 1e-3);
+}
+
+/**
+ * Make sure that the fused objective and gradient of the augmented Lagrangian
+ * match the separate calls.
+ */
+BOOST_AUTO_TEST_CASE(AugLagrangianFunctionEvaluateWithGradientTest)
+{
+  GockenbachFunction f;
+  AugLagrangianFunction<GockenbachFunction> aug(f);
+  aug.Lambda() = arma::randn<arma::vec>(f.NumConstraints());
+  aug.Sigma() = 5.0;
+
+  const arma::mat coords = arma::randn<arma::mat>(3, 1);
+
+  arma::mat gradient(3, 1);
+  aug.Gradient(coords, gradient);
+  const double objective = aug.Evaluate(coords);
+
+  arma::mat fusedGradient(3, 1);
+  const double fusedObjective = aug.EvaluateWithGradient(coords,
+      fusedGradient);
+
+  BOOST_REQUIRE_CLOSE(fusedObjective, objective, 1e-8);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(fusedGradient[i], gradient[i], 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,154 @@
+/**
+ * @file batch_predict_test.cpp
+ *
+ * Tests for BatchPredict(), the common batched inference path of the
+ * classifiers and regressors.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/batch_predict.hpp>
+#include <mlpack/methods/det/dtree.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::det;
+using namespace mlpack::gmm;
+using namespace mlpack::naive_bayes;
+using namespace mlpack::regression;
+
+BOOST_AUTO_TEST_SUITE(BatchPredictTest);
+
+/**
+ * Check that BatchPredict() gives the results of the model's own Predict() or
+ * Classify(), with several threads and block sizes, and that the results on
+ * the points converted to floats are the same too (the points are small
+ * integers, which floats hold exactly).
+ */
+template<typename ModelType, typename OutputType>
+void CheckBatchPredict(const ModelType& model,
+                       const arma::mat& points,
+                       const arma::Col<OutputType>& expected)
+{
+  const arma::fmat floatPoints = arma::conv_to<arma::fmat>::from(points);
+
+  const size_t threads[] = { 1, 4, 0 };
+  const size_t blockSizes[] = { 1, 7, 1024 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    for (size_t b = 0; b < 3; ++b)
+    {
+      std::vector<OutputType> output(points.n_cols);
+      BatchPredict(model, points, &output[0], threads[t], blockSizes[b]);
+      for (size_t i = 0; i < points.n_cols; ++i)
+        BOOST_REQUIRE_EQUAL(output[i], expected[i]);
+
+      std::vector<OutputType> floatOutput(points.n_cols);
+      BatchPredict(model, floatPoints, &floatOutput[0], threads[t],
+          blockSizes[b]);
+      for (size_t i = 0; i < points.n_cols; ++i)
+        BOOST_REQUIRE_EQUAL(floatOutput[i], expected[i]);
+    }
+  }
+}
+
+//! Make a dataset of three groups of points with small integer coordinates.
+void GroupedData(arma::mat& data, arma::Col<size_t>& labels)
+{
+  data.set_size(3, 200);
+  labels.set_size(200);
+  for (size_t i = 0; i < 200; ++i)
+  {
+    labels[i] = i % 3;
+    for (size_t d = 0; d < 3; ++d)
+      data(d, i) = 10.0 * labels[i] + math::RandInt(5);
+  }
+}
+
+/**
+ * The regressions predict values with Predict().
+ */
+BOOST_AUTO_TEST_CASE(RegressionBatchPredictTest)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  GroupedData(data, labels);
+
+  const arma::vec responses = arma::conv_to<arma::vec>::from(labels);
+  LinearRegression linear(data, responses);
+  arma::vec expected;
+  linear.Predict(data, expected);
+  CheckBatchPredict(linear, data, expected);
+
+  const arma::vec binaryResponses = arma::conv_to<arma::vec>::from(
+      labels == 0);
+  LogisticRegression<> logistic(data, binaryResponses);
+  logistic.Predict(data, expected);
+  CheckBatchPredict(logistic, data, expected);
+}
+
+/**
+ * The classifiers predict labels with Classify().
+ */
+BOOST_AUTO_TEST_CASE(ClassifierBatchPredictTest)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  GroupedData(data, labels);
+
+  NaiveBayesClassifier<> nbc(data, labels, 3);
+  arma::Col<size_t> expected;
+  nbc.Classify(data, expected);
+  CheckBatchPredict(nbc, data, expected);
+
+  GMM<> gmm(3, 3);
+  gmm.Estimate(data);
+  gmm.Classify(data, expected);
+  CheckBatchPredict(gmm, data, expected);
+}
+
+/**
+ * Density estimation trees predict densities with Predict(), which must match
+ * ComputeValue().
+ */
+BOOST_AUTO_TEST_CASE(DTreeBatchPredictTest)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  GroupedData(data, labels);
+
+  arma::mat trainData = data;
+  arma::Col<size_t> oldFromNew = arma::linspace<arma::Col<size_t> >(0,
+      data.n_cols - 1, data.n_cols);
+  DTree tree(trainData);
+  tree.Grow(trainData, oldFromNew, false, 10, 5);
+
+  arma::vec expected;
+  tree.Predict(data, expected);
+  BOOST_REQUIRE_EQUAL(expected.n_elem, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(expected[i], tree.ComputeValue(data.col(i)));
+
+  CheckBatchPredict(tree, data, expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
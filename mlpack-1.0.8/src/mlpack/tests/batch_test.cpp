@@ -0,0 +1,140 @@
+/**
+ * @file batch_test.cpp
+ *
+ * Tests for the job lists and the dataset cache of the mlpack_batch program.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/batch/dataset_cache.hpp>
+#include <mlpack/methods/batch/job.hpp>
+
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+BOOST_AUTO_TEST_SUITE(BatchTest);
+
+using namespace mlpack;
+using namespace mlpack::batch;
+
+/**
+ * The method and the parameters of a job should be parsed, flags should be
+ * "true", and missing parameters should get their default values.
+ */
+BOOST_AUTO_TEST_CASE(JobParseTest)
+{
+  Job job("allknn reference_file=ref.csv k=5 leaf_size=10 eps=0.5 naive", 3);
+
+  BOOST_REQUIRE_EQUAL(job.Method(), "allknn");
+  BOOST_REQUIRE_EQUAL(job.LineNumber(), 3);
+  BOOST_REQUIRE_EQUAL(job.GetRequired("reference_file"), "ref.csv");
+  BOOST_REQUIRE_EQUAL(job.GetInt("k", 1), 5);
+  BOOST_REQUIRE_EQUAL(job.GetInt("leaf_size", 20), 10);
+  BOOST_REQUIRE_CLOSE(job.GetDouble("eps", 0.0), 0.5, 1e-5);
+  BOOST_REQUIRE_EQUAL(job.Get("naive"), "true");
+
+  BOOST_REQUIRE(!job.Has("query_file"));
+  BOOST_REQUIRE_EQUAL(job.Get("query_file", "none"), "none");
+  BOOST_REQUIRE_EQUAL(job.GetInt("threads", 4), 4);
+}
+
+/**
+ * Blank lines and comments should be skipped, and each job should know the
+ * line it came from.
+ */
+BOOST_AUTO_TEST_CASE(JobReadTest)
+{
+  std::istringstream stream("# A job list.\n"
+                            "kmeans input_file=a.csv clusters=3\n"
+                            "\n"
+                            "   \t\n"
+                            "  # Another comment.\n"
+                            "gmm input_file=b.csv output_file=b.xml\n");
+
+  std::vector<Job> jobs;
+  Job::Read(stream, jobs);
+
+  BOOST_REQUIRE_EQUAL(jobs.size(), 2);
+  BOOST_REQUIRE_EQUAL(jobs[0].Method(), "kmeans");
+  BOOST_REQUIRE_EQUAL(jobs[0].LineNumber(), 2);
+  BOOST_REQUIRE_EQUAL(jobs[0].GetInt("clusters", 0), 3);
+  BOOST_REQUIRE_EQUAL(jobs[1].Method(), "gmm");
+  BOOST_REQUIRE_EQUAL(jobs[1].LineNumber(), 6);
+  BOOST_REQUIRE_EQUAL(jobs[1].Get("output_file"), "b.xml");
+}
+
+/**
+ * The parameters which were never asked for should be reported.
+ */
+BOOST_AUTO_TEST_CASE(JobUnusedTest)
+{
+  Job job("kmeans input_file=a.csv clusters=3 clustres=4");
+
+  job.Get("input_file");
+  job.GetInt("clusters", 1);
+  job.Has("seed");
+
+  const std::vector<std::string> unused = job.Unused();
+  BOOST_REQUIRE_EQUAL(unused.size(), 1);
+  BOOST_REQUIRE_EQUAL(unused[0], "clustres");
+}
+
+/**
+ * Each file should be loaded once, and files which cannot be loaded should be
+ * left out of the cache.
+ */
+BOOST_AUTO_TEST_CASE(DatasetCacheTest)
+{
+  arma::mat data1 = arma::randu<arma::mat>(3, 20);
+  arma::mat data2 = arma::randu<arma::mat>(5, 10);
+  BOOST_REQUIRE(data::Save("batch_test_1.csv", data1));
+  BOOST_REQUIRE(data::Save("batch_test_2.csv", data2));
+
+  std::vector<std::string> files;
+  files.push_back("batch_test_1.csv");
+  files.push_back("batch_test_2.csv");
+  files.push_back("batch_test_1.csv");
+  files.push_back("batch_test_missing.csv");
+
+  DatasetCache cache;
+  BOOST_REQUIRE_EQUAL(cache.Load(files, 2), 1);
+  BOOST_REQUIRE_EQUAL(cache.Size(), 2);
+  BOOST_REQUIRE(cache.Contains("batch_test_1.csv"));
+  BOOST_REQUIRE(cache.Contains("batch_test_2.csv"));
+  BOOST_REQUIRE(!cache.Contains("batch_test_missing.csv"));
+
+  const arma::mat& loaded1 = cache.Dataset("batch_test_1.csv");
+  const arma::mat& loaded2 = cache.Dataset("batch_test_2.csv");
+  BOOST_REQUIRE_EQUAL(loaded1.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(loaded1.n_cols, 20);
+  BOOST_REQUIRE_EQUAL(loaded2.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(loaded2.n_cols, 10);
+  for (size_t i = 0; i < data1.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(loaded1[i], data1[i], 1e-5);
+
+  // Loading again should not load anything new, and should keep the datasets
+  // which are already there.
+  BOOST_REQUIRE_EQUAL(cache.Load(files), 1);
+  BOOST_REQUIRE_EQUAL(cache.Size(), 2);
+  BOOST_REQUIRE_EQUAL(&cache.Dataset("batch_test_1.csv"), &loaded1);
+
+  remove("batch_test_1.csv");
+  remove("batch_test_2.csv");
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -24,8 +24,13 @@
 #include <mlpack/methods/cf/cf.hpp>
 #include <iostream>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
+#include "thread_communicator.hpp"
 
 BOOST_AUTO_TEST_SUITE(CFTest);
 
@@ -225,4 +230,302 @@ BOOST_AUTO_TEST_CASE(RecommendationAccuracyTest)
   BOOST_REQUIRE_LT(failures, 100);
 }
 
+/**
+ * Make sure that searching for neighbors in the low-rank user space gives the
+ * same recommendations as searching in the dense rating matrix W * H.
+ */
+BOOST_AUTO_TEST_CASE(LowRankNeighborhoodTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  const size_t numUsers = 100;
+  arma::Col<size_t> users(numUsers);
+  for (size_t i = 0; i < numUsers; ++i)
+    users(i) = i + 1;
+
+  CF c(dataset);
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(recommendations, users);
+
+  // Now compute the recommendations from the dense rating matrix.
+  const arma::mat rating = c.W() * c.H();
+  arma::mat query(rating.n_rows, numUsers);
+  for (size_t i = 0; i < numUsers; ++i)
+    query.col(i) = rating.col(users(i) - 1);
+
+  arma::Mat<size_t> neighborhood;
+  arma::mat distances;
+  neighbor::AllkNN allknn(rating, query);
+  allknn.Search(c.NumUsersForSimilarity(), neighborhood, distances);
+
+  // Neighbors may come out in a different order if their distances are almost
+  // the same, so allow a few users to differ.
+  size_t differences = 0;
+  for (size_t i = 0; i < numUsers; ++i)
+  {
+    arma::vec averages = arma::zeros<arma::vec>(rating.n_rows);
+    for (size_t j = 0; j < neighborhood.n_rows; ++j)
+      averages += rating.col(neighborhood(j, i));
+    averages /= neighborhood.n_rows;
+
+    // Find the best unrated item.
+    double best = -DBL_MAX;
+    size_t bestItem = 0;
+    for (size_t j = 0; j < rating.n_rows; ++j)
+    {
+      if (c.CleanedData()(j, users(i) - 1) != 0.0)
+        continue;
+
+      if (averages[j] > best)
+      {
+        best = averages[j];
+        bestItem = j + 1;
+      }
+    }
+
+    if (recommendations(0, i) != bestItem)
+      ++differences;
+  }
+
+  BOOST_REQUIRE_LT(differences, 5);
+}
+
+/**
+ * Make sure that WeightedALS with explicit feedback recovers the missing
+ * entries of a low-rank matrix from the observed ones.
+ */
+BOOST_AUTO_TEST_CASE(WeightedALSCompletionTest)
+{
+  math::RandomSeed(42);
+
+  const arma::mat wTrue = arma::randu<arma::mat>(60, 3);
+  const arma::mat hTrue = arma::randu<arma::mat>(3, 50);
+  const arma::mat full = wTrue * hTrue;
+
+  // Observe about half of the entries.
+  arma::sp_mat v(full.n_rows, full.n_cols);
+  arma::umat observed = arma::zeros<arma::umat>(full.n_rows, full.n_cols);
+  for (size_t j = 0; j < full.n_cols; ++j)
+  {
+    for (size_t i = 0; i < full.n_rows; ++i)
+    {
+      if (math::Random() < 0.5)
+      {
+        v(i, j) = full(i, j);
+        observed(i, j) = 1;
+      }
+    }
+  }
+
+  arma::mat w, h;
+  WeightedALS als(1000, 1e-10, 1e-6);
+  als.Apply(v, 3, w, h);
+
+  BOOST_REQUIRE_EQUAL(w.n_rows, full.n_rows);
+  BOOST_REQUIRE_EQUAL(w.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(h.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(h.n_cols, full.n_cols);
+
+  const arma::mat estimate = w * h;
+  double error = 0.0;
+  size_t missing = 0;
+  for (size_t j = 0; j < full.n_cols; ++j)
+  {
+    for (size_t i = 0; i < full.n_rows; ++i)
+    {
+      if (observed(i, j) == 0)
+      {
+        error += std::pow(estimate(i, j) - full(i, j), 2.0);
+        ++missing;
+      }
+    }
+  }
+
+  BOOST_REQUIRE_LT(std::sqrt(error / missing), 0.05);
+}
+
+/**
+ * Make sure that the parallel factorization gives the same result as the
+ * serial one.
+ */
+BOOST_AUTO_TEST_CASE(WeightedALSThreadsTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+  CF c(dataset);
+
+  arma::mat w, h;
+  math::RandomSeed(7);
+  WeightedALS als(10, 1e-10, 0.1, 1.0);
+  als.Apply(c.CleanedData(), 5, w, h);
+
+  const size_t threads[] = { 2, 4, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    arma::mat parallelW, parallelH;
+    math::RandomSeed(7);
+    als.Threads() = threads[t];
+    als.Apply(c.CleanedData(), 5, parallelW, parallelH);
+
+    for (size_t i = 0; i < w.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(parallelW[i] + 1.0, w[i] + 1.0, 1e-5);
+    for (size_t i = 0; i < h.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(parallelH[i] + 1.0, h[i] + 1.0, 1e-5);
+  }
+}
+
+/**
+ * Make sure that factorizing shards of the users and items over three ranks
+ * gives the same factors on every rank as factorizing the whole matrix.
+ */
+BOOST_AUTO_TEST_CASE(WeightedALSDistributedTest)
+{
+#ifdef _OPENMP
+  math::RandomSeed(11);
+
+  const arma::mat full = arma::randu<arma::mat>(40, 3) *
+      arma::randu<arma::mat>(3, 30);
+  arma::sp_mat v(full.n_rows, full.n_cols);
+  for (size_t j = 0; j < full.n_cols; ++j)
+    for (size_t i = 0; i < full.n_rows; ++i)
+      if (math::Random() < 0.4)
+        v(i, j) = full(i, j);
+
+  const arma::mat ratings(v);
+  const arma::mat itemRatings = trans(ratings);
+
+  // Both runs are made by the first thread of a team of the same size, so that
+  // they draw the same seed.
+  const size_t ranks = 3;
+  const size_t userBounds[] = { 0, 5, 20, 30 };
+  const size_t itemBounds[] = { 0, 15, 25, 40 };
+  std::vector<std::vector<double> > buffers(ranks);
+  std::vector<arma::mat> shardW(ranks), shardH(ranks);
+  arma::mat w, h;
+  size_t threads = 0;
+
+  math::RandomSeed(5);
+  #pragma omp parallel num_threads(ranks)
+  {
+    #pragma omp single
+    threads = (size_t) omp_get_num_threads();
+
+    if (threads == ranks && omp_get_thread_num() == 0)
+    {
+      WeightedALS als(8, 0.0, 0.1);
+      als.Apply(v, arma::sp_mat(itemRatings), 3, w, h);
+    }
+  }
+
+  if (threads != ranks)
+    return;
+
+  math::RandomSeed(5);
+  #pragma omp parallel num_threads(ranks)
+  {
+    const size_t rank = (size_t) omp_get_thread_num();
+    ThreadCommunicator communicator(buffers, rank);
+    WeightedALS als(8, 0.0, 0.1);
+    als.Comm() = &communicator;
+    als.Apply(arma::sp_mat(ratings.cols(userBounds[rank],
+        userBounds[rank + 1] - 1)), arma::sp_mat(itemRatings.cols(
+        itemBounds[rank], itemBounds[rank + 1] - 1)), 3, shardW[rank],
+        shardH[rank]);
+  }
+
+  BOOST_REQUIRE_EQUAL(w.n_rows, full.n_rows);
+  BOOST_REQUIRE_EQUAL(h.n_cols, full.n_cols);
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    BOOST_REQUIRE_EQUAL(shardW[r].n_elem, w.n_elem);
+    BOOST_REQUIRE_EQUAL(shardH[r].n_elem, h.n_elem);
+    for (size_t i = 0; i < w.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(shardW[r][i] + 1.0, w[i] + 1.0, 1e-8);
+    for (size_t i = 0; i < h.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(shardH[r][i] + 1.0, h[i] + 1.0, 1e-8);
+  }
+#endif
+}
+
+/**
+ * Factorizing with QUIC-SVD should give factors of the right shape and
+ * recommendations for every queried user.
+ */
+BOOST_AUTO_TEST_CASE(CFQUICSVDTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  CF c(dataset);
+  c.Method() = CF::QUIC_SVD;
+  c.RelativeError() = 0.5;
+  c.Factorize();
+
+  BOOST_REQUIRE_EQUAL(c.W().n_rows, c.CleanedData().n_rows);
+  BOOST_REQUIRE_EQUAL(c.H().n_cols, c.CleanedData().n_cols);
+  BOOST_REQUIRE_EQUAL(c.W().n_cols, c.H().n_rows);
+  BOOST_REQUIRE_GE(c.W().n_cols, 2);
+
+  // The factors must reach the relative error on the rating matrix.
+  const arma::mat ratings(c.CleanedData());
+  BOOST_REQUIRE_LE(arma::accu(arma::square(ratings - c.W() * c.H())),
+      0.5 * arma::accu(arma::square(ratings)) * (1 + 1e-8));
+
+  arma::Col<size_t> users(20);
+  for (size_t i = 0; i < users.n_elem; ++i)
+    users(i) = 5 * i;
+
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(recommendations, users);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, users.n_elem);
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, c.NumRecs());
+}
+
+/**
+ * Make sure that a saved and loaded model gives the same recommendations, and
+ * that recommendations generated in parallel are the same as serial ones.
+ */
+BOOST_AUTO_TEST_CASE(CFSaveLoadTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  CF c(dataset);
+  c.Factorize();
+  c.Save("test-cf-model.bin");
+
+  arma::Col<size_t> users(50);
+  for (size_t i = 0; i < users.n_elem; ++i)
+    users(i) = 3 * i + 1;
+
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(recommendations, users);
+
+  CF loaded("test-cf-model.bin");
+  remove("test-cf-model.bin");
+
+  BOOST_REQUIRE_EQUAL(loaded.NumUsersForSimilarity(),
+      c.NumUsersForSimilarity());
+  BOOST_REQUIRE_EQUAL(loaded.W().n_rows, c.W().n_rows);
+  BOOST_REQUIRE_EQUAL(loaded.H().n_cols, c.H().n_cols);
+  BOOST_REQUIRE_EQUAL(loaded.CleanedData().n_nonzero,
+      c.CleanedData().n_nonzero);
+  for (size_t i = 0; i < c.Neighborhoods().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.Neighborhoods()[i], c.Neighborhoods()[i]);
+
+  const size_t threads[] = { 1, 4, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    arma::Mat<size_t> loadedRecommendations;
+    loaded.Threads() = threads[t];
+    loaded.GetRecommendations(loadedRecommendations, users);
+
+    BOOST_REQUIRE_EQUAL(loadedRecommendations.n_rows, recommendations.n_rows);
+    BOOST_REQUIRE_EQUAL(loadedRecommendations.n_cols, recommendations.n_cols);
+    for (size_t i = 0; i < recommendations.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(loadedRecommendations[i], recommendations[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
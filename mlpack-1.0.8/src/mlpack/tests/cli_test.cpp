@@ -22,6 +22,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <cstdio>
 #ifndef _WIN32
   #include <sys/time.h>
 #endif
@@ -33,6 +34,10 @@
 
 #include <mlpack/core.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #define DEFAULT_INT 42
 
 #include <boost/test/unit_test.hpp>
@@ -148,6 +153,21 @@ BOOST_AUTO_TEST_CASE(TestBooleanOption)
   delete[] argv[1];
 }
 
+/**
+ * Options are added to CLI when the singleton is first used, or right away if
+ * it already exists; either way their default values must be kept.
+ */
+BOOST_AUTO_TEST_CASE(LazyOptionTest)
+{
+  PARAM_STRING("lazy_string", "lazy string description", "", "default");
+  PARAM_DOUBLE("lazy_double", "lazy double description", "", 2.5);
+
+  BOOST_REQUIRE_EQUAL(CLI::GetParam<std::string>("lazy_string"), "default");
+  BOOST_REQUIRE_CLOSE(CLI::GetParam<double>("lazy_double"), 2.5, 1e-5);
+  BOOST_REQUIRE_EQUAL(CLI::GetDescription("lazy_double"),
+      "lazy double description");
+}
+
 /**
  * Test that we can correctly output Armadillo objects to PrefixedOutStream
  * objects.
@@ -236,6 +256,61 @@ BOOST_AUTO_TEST_CASE(TestPrefixedOutStreamModifiers)
       "I have a precise number which is 000156");
 }
 
+/**
+ * Test that lines given by several threads at once are not mixed.
+ */
+BOOST_AUTO_TEST_CASE(TestPrefixedOutStreamThreads)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, "[INFO ] ");
+
+  #pragma omp parallel for num_threads(4)
+  for (int i = 0; i < 1000; ++i)
+    pss << "line " << i << " is " << (2 * i) << std::endl;
+
+  size_t lines = 0;
+  std::string line;
+  while (std::getline(ss, line))
+  {
+    int i, j;
+    BOOST_REQUIRE_EQUAL(sscanf(line.c_str(), "[INFO ] line %d is %d", &i, &j),
+        2);
+    BOOST_REQUIRE_EQUAL(j, 2 * i);
+    ++lines;
+  }
+
+  BOOST_REQUIRE_EQUAL(lines, 1000);
+}
+
+//! Count how many times the operand of a log expression is evaluated.
+static int LogOperand(int& evaluations)
+{
+  return ++evaluations;
+}
+
+/**
+ * Test that MLPACK_LOG_INFO does not evaluate its operands if Log::Info is not
+ * shown.
+ */
+BOOST_AUTO_TEST_CASE(TestLogInfoMacro)
+{
+  const bool ignoring = Log::Info.ignoreInput;
+  Log::Info.ignoreInput = true;
+
+  int evaluations = 0;
+  MLPACK_LOG_INFO << LogOperand(evaluations) << std::endl;
+  BOOST_REQUIRE_EQUAL(evaluations, 0);
+
+  // An else after the macro still belongs to its own if ().
+  if (evaluations != 0)
+    MLPACK_LOG_INFO << LogOperand(evaluations) << std::endl;
+  else
+    ++evaluations;
+  BOOST_REQUIRE_EQUAL(evaluations, 1);
+
+  Log::Info.ignoreInput = ignoring;
+}
+
 /**
  * We should be able to start and then stop a timer multiple times and it should
  * save the value.
@@ -284,4 +359,275 @@ BOOST_AUTO_TEST_CASE(MultiRunTimerTest)
   BOOST_REQUIRE_GE(Timer::Get("test_timer").tv_usec, 40000);
 }
 
+/**
+ * A ScopedTimer should time its scope, in nanoseconds, with a clock that does
+ * not go backwards.
+ */
+BOOST_AUTO_TEST_CASE(ScopedTimerTest)
+{
+  const uint64_t before = Timer::Now();
+  {
+    ScopedTimer timer("test_scoped_timer");
+
+    #ifdef _WIN32
+    Sleep(10);
+    #else
+    usleep(10000);
+    #endif
+  }
+  const uint64_t after = Timer::Now();
+
+  const uint64_t value = Timer::GetNanoseconds("test_scoped_timer");
+  BOOST_REQUIRE_GE(value, 10000000);
+  BOOST_REQUIRE_LE(value, after - before);
+  BOOST_REQUIRE_EQUAL((uint64_t) Timer::Get("test_scoped_timer").tv_usec,
+      (value % 1000000000) / 1000);
+
+  const uint64_t cycles = Timer::Cycles();
+  BOOST_REQUIRE_GE(Timer::Cycles(), cycles);
+  BOOST_REQUIRE_GT(Timer::SecondsPerCycle(), 0.0);
+}
+
+/**
+ * Profiler timers used from several threads should be merged, with sensible
+ * statistics, and nested in their parents in the JSON output.
+ */
+BOOST_AUTO_TEST_CASE(ProfilerTest)
+{
+  const Profiler::Handle outer = Profiler::Register("test_profiler_outer");
+  const Profiler::Handle inner = Profiler::Register("test_profiler_inner",
+      outer);
+  BOOST_REQUIRE_EQUAL(Profiler::Register("test_profiler_outer"), outer);
+  BOOST_REQUIRE(inner != outer);
+
+  {
+    Profiler::Scope scope(outer);
+
+    #pragma omp parallel for
+    for (int i = 0; i < 1000; ++i)
+    {
+      Profiler::Scope innerScope(inner);
+      volatile double x = 0.0;
+      for (int j = 0; j < (i % 10) * 100; ++j)
+        x += std::sqrt((double) j);
+    }
+  }
+
+  Profiler::Statistics stats = Profiler::Get(inner);
+  BOOST_REQUIRE_EQUAL(stats.name, "test_profiler_inner");
+  BOOST_REQUIRE_EQUAL(stats.parent, outer);
+  BOOST_REQUIRE_EQUAL(stats.calls, 1000);
+  BOOST_REQUIRE_LE(stats.min, stats.mean);
+  BOOST_REQUIRE_LE(stats.mean, stats.max);
+  BOOST_REQUIRE_LE(stats.min, stats.p99);
+  BOOST_REQUIRE_LE(stats.p99, stats.max);
+  BOOST_REQUIRE_CLOSE(stats.mean * stats.calls, stats.total, 1e-5);
+  BOOST_REQUIRE_EQUAL(Profiler::Get(outer).calls, 1);
+
+  std::ostringstream json;
+  Profiler::WriteJSON(json);
+  const std::string output = json.str();
+  const size_t outerPos = output.find("\"test_profiler_outer\"");
+  const size_t innerPos = output.find("\"test_profiler_inner\"");
+  BOOST_REQUIRE(outerPos != std::string::npos);
+  BOOST_REQUIRE(innerPos != std::string::npos);
+  BOOST_REQUIRE_GT(innerPos, outerPos);
+
+  Profiler::Reset();
+  BOOST_REQUIRE_EQUAL(Profiler::Get(inner).calls, 0);
+}
+
+/**
+ * With the cycle counter, the Profiler should still give durations in seconds.
+ */
+BOOST_AUTO_TEST_CASE(ProfilerCycleCounterTest)
+{
+  const Profiler::Handle timer = Profiler::Register("test_profiler_cycles");
+
+  Profiler::UseCycleCounter(true);
+  Profiler::Reset();
+  BOOST_REQUIRE(Profiler::UsesCycleCounter());
+  {
+    Profiler::Scope scope(timer);
+
+    #ifdef _WIN32
+    Sleep(10);
+    #else
+    usleep(10000);
+    #endif
+  }
+
+  const Profiler::Statistics stats = Profiler::Get(timer);
+  Profiler::UseCycleCounter(false);
+  Profiler::Reset();
+
+  BOOST_REQUIRE_EQUAL(stats.calls, 1);
+  BOOST_REQUIRE_GT(stats.total, 0.005);
+  BOOST_REQUIRE_LT(stats.total, 10.0);
+}
+
+/**
+ * Make sure the MemoryBudget answers whether memory fits, and splits columns
+ * into blocks that fit.
+ */
+BOOST_AUTO_TEST_CASE(MemoryBudgetTest)
+{
+  BOOST_REQUIRE(!MemoryBudget::Limited());
+  BOOST_REQUIRE(MemoryBudget::Fits((size_t) -1));
+  BOOST_REQUIRE_EQUAL(MemoryBudget::BlockColumns(100, 50), 50);
+
+  MemoryBudget::SetLimit(1000);
+  BOOST_REQUIRE(MemoryBudget::Limited());
+  BOOST_REQUIRE_EQUAL(MemoryBudget::Limit(), 1000);
+  BOOST_REQUIRE(MemoryBudget::Fits(1000));
+  BOOST_REQUIRE(!MemoryBudget::Fits(1001));
+
+  BOOST_REQUIRE_EQUAL(MemoryBudget::BlockColumns(100, 50), 10);
+  BOOST_REQUIRE_EQUAL(MemoryBudget::BlockColumns(100, 50, 500), 5);
+  BOOST_REQUIRE_EQUAL(MemoryBudget::BlockColumns(100, 5), 5);
+  // At least one column is always processed.
+  BOOST_REQUIRE_EQUAL(MemoryBudget::BlockColumns(100, 50, 2000), 1);
+
+  BOOST_REQUIRE_EQUAL((MemoryBudget::MatrixBytes<double>(3, 4)), 96);
+  BOOST_REQUIRE_EQUAL(MemoryBudget::Format(512), "512B");
+  BOOST_REQUIRE_EQUAL(MemoryBudget::Format(1536), "1.5kB");
+  BOOST_REQUIRE_EQUAL(MemoryBudget::Format(3 * 1024 * 1024), "3.0MB");
+
+  MemoryBudget::SetLimit(0);
+  BOOST_REQUIRE(!MemoryBudget::Limited());
+}
+
+/**
+ * Make sure Threads resolves 0 to all available cores, keeps the number of
+ * threads under the limit, and runs nested methods with one thread.
+ */
+BOOST_AUTO_TEST_CASE(ThreadsTest)
+{
+  BOOST_REQUIRE(!Threads::Limited());
+  BOOST_REQUIRE_EQUAL(Threads::Count(0), Threads::Available());
+  BOOST_REQUIRE_EQUAL(Threads::Count(1), 1);
+#ifdef _OPENMP
+  BOOST_REQUIRE_EQUAL(Threads::Available(), (size_t) omp_get_max_threads());
+  BOOST_REQUIRE_EQUAL(Threads::Count(7), 7);
+#else
+  BOOST_REQUIRE_EQUAL(Threads::Available(), 1);
+  BOOST_REQUIRE_EQUAL(Threads::Count(7), 1);
+#endif
+
+  Threads::SetLimit(2);
+  BOOST_REQUIRE(Threads::Limited());
+  BOOST_REQUIRE_EQUAL(Threads::Limit(), 2);
+  BOOST_REQUIRE_LE(Threads::Available(), 2);
+  BOOST_REQUIRE_LE(Threads::Count(7), 2);
+  BOOST_REQUIRE_EQUAL(Threads::Count(1), 1);
+
+#ifdef _OPENMP
+  // A method called from inside a parallel region runs with one thread.
+  size_t nested = 0;
+  bool active = false;
+  #pragma omp parallel num_threads(2)
+  {
+    #pragma omp single
+    {
+      nested = Threads::Count(7);
+      active = (omp_get_num_threads() > 1);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(nested, active ? 1 : 2);
+#endif
+
+  Threads::SetLimit(0);
+  BOOST_REQUIRE(!Threads::Limited());
+}
+
+//! A monitor which records the last step reported, and stops methods after the
+//! given step.
+class StepMonitor : public ProgressMonitor
+{
+ public:
+  StepMonitor(const size_t lastStep) : lastStep(lastStep), step(0) { }
+
+  size_t lastStep;
+  size_t step;
+
+ protected:
+  bool Report(const std::string& /* task */,
+              const size_t step,
+              const double /* value */)
+  {
+    this->step = step;
+    return (step < lastStep);
+  }
+};
+
+/**
+ * Make sure ProgressMonitor stops methods when it is cancelled, when its time
+ * limit has passed, and when Report() returns false, and that it stays stopped
+ * until it is reset.
+ */
+BOOST_AUTO_TEST_CASE(ProgressMonitorTest)
+{
+  ProgressMonitor monitor;
+  BOOST_REQUIRE(monitor.Continue("test", 1, 0.0));
+  BOOST_REQUIRE(!monitor.Stopped());
+  BOOST_REQUIRE_GE(monitor.Elapsed(), 0.0);
+
+  monitor.Cancel();
+  BOOST_REQUIRE(!monitor.Continue("test", 2, 0.0));
+  BOOST_REQUIRE(monitor.Stopped());
+  BOOST_REQUIRE(!monitor.Continue("test", 3, 0.0));
+
+  monitor.Reset();
+  BOOST_REQUIRE(!monitor.Stopped());
+  BOOST_REQUIRE(monitor.Continue("test", 1, 0.0));
+
+  // A time limit which has certainly passed.
+  monitor.TimeLimit() = 1e-9;
+  BOOST_REQUIRE(!monitor.Continue("test", 2, 0.0));
+  BOOST_REQUIRE(monitor.Stopped());
+
+  StepMonitor stepMonitor(3);
+  BOOST_REQUIRE(stepMonitor.Continue("test", 1, 0.0));
+  BOOST_REQUIRE(stepMonitor.Continue("test", 2, 0.0));
+  BOOST_REQUIRE(!stepMonitor.Continue("test", 3, 0.0));
+  BOOST_REQUIRE_EQUAL(stepMonitor.step, 3);
+
+  // Report() is not called once the monitor has stopped.
+  BOOST_REQUIRE(!stepMonitor.Continue("test", 4, 0.0));
+  BOOST_REQUIRE_EQUAL(stepMonitor.step, 3);
+}
+
+/**
+ * With memory tracking enabled, a timer should record the memory its phase
+ * allocated; without it, nothing is recorded.
+ */
+BOOST_AUTO_TEST_CASE(MemoryUsageTest)
+{
+  Timer::Start("test_memory_untracked");
+  Timer::Stop("test_memory_untracked");
+  BOOST_REQUIRE_EQUAL(
+      Timer::GetTimers().GetPhaseMemory("test_memory_untracked").runs, 0);
+
+  // Allocate (and touch) 32MB, which is kept until the timer is stopped.
+  const size_t bytes = 2048 * 2048 * sizeof(double);
+  MemoryUsage::Enable();
+  Timer::Start("test_memory");
+  arma::mat matrix(2048, 2048);
+  matrix.fill(1.0);
+  Timer::Stop("test_memory");
+  MemoryUsage::Enable(false);
+
+  const PhaseMemory phase = Timer::GetTimers().GetPhaseMemory("test_memory");
+  BOOST_REQUIRE_EQUAL(phase.runs, 1);
+  BOOST_REQUIRE_GE(MemoryUsage::PeakResident(), MemoryUsage::Resident());
+#ifdef __linux__
+  BOOST_REQUIRE_GE(MemoryUsage::Resident(), bytes);
+  BOOST_REQUIRE_GE(phase.peakResident, bytes);
+#endif
+#ifdef __GLIBC__
+  BOOST_REQUIRE_GE(phase.heapGrowth, (double) bytes);
+#endif
+  BOOST_REQUIRE_CLOSE(matrix(2047, 2047), 1.0, 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
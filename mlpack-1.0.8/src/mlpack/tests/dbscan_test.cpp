@@ -0,0 +1,155 @@
+/**
+ * @file dbscan_test.cpp
+ *
+ * Tests for the DBSCAN class.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core.hpp>
+#include <mlpack/methods/dbscan/dbscan.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::dbscan;
+
+BOOST_AUTO_TEST_SUITE(DBSCANTest);
+
+/**
+ * Two well-separated blobs and a few isolated points must give two clusters
+ * and noise.
+ */
+BOOST_AUTO_TEST_CASE(SeparatedBlobsTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat data(2, 205);
+  data.cols(0, 99) = 0.1 * arma::randu<arma::mat>(2, 100);
+  data.cols(100, 199) = 0.1 * arma::randu<arma::mat>(2, 100) + 5.0;
+  for (size_t i = 200; i < 205; ++i)
+  {
+    data(0, i) = 10.0 * (i - 199);
+    data(1, i) = -10.0;
+  }
+
+  DBSCAN<> dbscan(0.05, 4);
+  arma::Col<size_t> assignments;
+  BOOST_REQUIRE_EQUAL(dbscan.Cluster(data, assignments), 2);
+
+  for (size_t i = 0; i < 100; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(assignments[i], 0);
+    BOOST_REQUIRE_EQUAL(assignments[100 + i], 1);
+  }
+  for (size_t i = 200; i < 205; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], DBSCAN<>::Noise);
+}
+
+/**
+ * The clusters of random data must match those found by brute force: the core
+ * points must be partitioned the same way, the noise points must be the same,
+ * and each border point must be in the cluster of a core point within
+ * epsilon.
+ */
+BOOST_AUTO_TEST_CASE(DBSCANVsBruteForce)
+{
+  math::RandomSeed(0);
+
+  arma::mat data = arma::randu<arma::mat>(2, 1000);
+  const double epsilon = 0.03;
+  const size_t minPoints = 5;
+
+  // Find the neighborhoods and the core points by brute force.
+  std::vector<std::vector<size_t> > neighbors(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    for (size_t j = 0; j < data.n_cols; ++j)
+      if (metric::EuclideanDistance::Evaluate(data.col(i), data.col(j)) <=
+          epsilon)
+        neighbors[i].push_back(j);
+
+  std::vector<bool> core(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    core[i] = (neighbors[i].size() >= minPoints);
+
+  // Label the core points by a search of the graph of core points.
+  std::vector<size_t> labels(data.n_cols, DBSCAN<>::Noise);
+  size_t numLabels = 0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    if (!core[i] || labels[i] != DBSCAN<>::Noise)
+      continue;
+
+    std::vector<size_t> stack(1, i);
+    labels[i] = numLabels;
+    while (!stack.empty())
+    {
+      const size_t point = stack.back();
+      stack.pop_back();
+      for (size_t j = 0; j < neighbors[point].size(); ++j)
+      {
+        const size_t neighbor = neighbors[point][j];
+        if (core[neighbor] && labels[neighbor] == DBSCAN<>::Noise)
+        {
+          labels[neighbor] = numLabels;
+          stack.push_back(neighbor);
+        }
+      }
+    }
+    ++numLabels;
+  }
+
+  for (size_t threads = 1; threads <= 4; threads += 3)
+  {
+    DBSCAN<> dbscan(epsilon, minPoints);
+    dbscan.Threads() = threads;
+    arma::Col<size_t> assignments;
+    const size_t clusters = dbscan.Cluster(data, assignments);
+    BOOST_REQUIRE_EQUAL(clusters, numLabels);
+
+    // Map the brute-force labels to the clusters.
+    std::vector<size_t> clusterOfLabel(numLabels, DBSCAN<>::Noise);
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      if (core[i])
+      {
+        if (clusterOfLabel[labels[i]] == DBSCAN<>::Noise)
+          clusterOfLabel[labels[i]] = assignments[i];
+        BOOST_REQUIRE_EQUAL(assignments[i], clusterOfLabel[labels[i]]);
+        continue;
+      }
+
+      bool nearCore = false;
+      bool inNearCluster = false;
+      for (size_t j = 0; j < neighbors[i].size(); ++j)
+      {
+        if (core[neighbors[i][j]])
+        {
+          nearCore = true;
+          if (assignments[neighbors[i][j]] == assignments[i])
+            inNearCluster = true;
+        }
+      }
+
+      if (nearCore)
+        BOOST_REQUIRE(inNearCluster);
+      else
+        BOOST_REQUIRE_EQUAL(assignments[i], DBSCAN<>::Noise);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
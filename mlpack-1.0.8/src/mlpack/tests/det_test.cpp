@@ -22,6 +22,7 @@
  */
 #include <mlpack/core.hpp>
 #include <boost/test/unit_test.hpp>
+#include <stack>
 #include "old_boost_test_definitions.hpp"
 
 // This trick does not work on Windows.  We will have to comment out the tests
@@ -33,6 +34,7 @@
 
 #include <mlpack/methods/det/dtree.hpp>
 #include <mlpack/methods/det/dt_utils.hpp>
+#include <mlpack/methods/det/flat_dtree.hpp>
 
 #ifndef _WIN32
   #undef protected
@@ -325,6 +327,190 @@ BOOST_AUTO_TEST_CASE(TestVariableImportance)
   BOOST_REQUIRE_CLOSE((double) (rootError - (lError + rError)), imps[2], 1e-10);
 }
 
+/**
+ * Make sure that growing the tree with several threads (where the children of
+ * large nodes are grown as separate tasks) gives the same tree as growing it
+ * serially.
+ */
+BOOST_AUTO_TEST_CASE(TestGrowThreads)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 30000);
+  arma::mat serialData(data);
+  arma::mat parallelData(data);
+
+  arma::Col<size_t> serialOldFromNew(data.n_cols);
+  arma::Col<size_t> parallelOldFromNew(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    serialOldFromNew[i] = i;
+    parallelOldFromNew[i] = i;
+  }
+
+  DTree serialTree(serialData);
+  DTree parallelTree(parallelData);
+  const double serialAlpha = serialTree.Grow(serialData, serialOldFromNew,
+      false, 10, 5, 1);
+  const double parallelAlpha = parallelTree.Grow(parallelData,
+      parallelOldFromNew, false, 10, 5, 0);
+
+  BOOST_REQUIRE_EQUAL(serialAlpha, parallelAlpha);
+  BOOST_REQUIRE_EQUAL(serialTree.SubtreeLeaves(),
+      parallelTree.SubtreeLeaves());
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(serialOldFromNew[i], parallelOldFromNew[i]);
+    BOOST_REQUIRE_EQUAL(serialTree.ComputeValue(data.unsafe_col(i)),
+        parallelTree.ComputeValue(data.unsafe_col(i)));
+  }
+}
+
+/**
+ * Make sure that the splits found with the values sorted once at the root are
+ * the same as the splits found by sorting the points of each node.
+ */
+BOOST_AUTO_TEST_CASE(TestGrowPresorted)
+{
+  arma::mat data = arma::randn<arma::mat>(3, 2000);
+  arma::Col<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    oldFromNew[i] = i;
+
+  DTree tree(data);
+  tree.Grow(data, oldFromNew, false, 10, 5);
+  BOOST_REQUIRE_GT(tree.SubtreeLeaves(), 1);
+
+  // The points of each node are still in its range of the dataset, so sorting
+  // them again must give the same split.
+  std::stack<DTree*> nodes;
+  nodes.push(&tree);
+  while (!nodes.empty())
+  {
+    DTree* node = nodes.top();
+    nodes.pop();
+    if (node->Left() == NULL)
+      continue;
+
+    size_t dim;
+    double split, leftError, rightError;
+    BOOST_REQUIRE(node->FindSplit(data, dim, split, leftError, rightError, 10,
+        5));
+    BOOST_REQUIRE_EQUAL(dim, node->SplitDim());
+    BOOST_REQUIRE_EQUAL(split, node->SplitValue());
+    BOOST_REQUIRE_EQUAL(node->Left()->End(), node->Right()->Start());
+
+    nodes.push(node->Left());
+    nodes.push(node->Right());
+  }
+}
+
+/**
+ * Make sure that the approximate histogram splits give a valid tree.
+ */
+BOOST_AUTO_TEST_CASE(TestGrowHistogram)
+{
+  arma::mat data = arma::randu<arma::mat>(2, 5000);
+  arma::mat original(data);
+  arma::Col<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    oldFromNew[i] = i;
+
+  DTree tree(data);
+  tree.Grow(data, oldFromNew, false, 10, 5, 1, 32);
+  BOOST_REQUIRE_GT(tree.SubtreeLeaves(), 1);
+
+  // The points are only reordered.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    for (size_t d = 0; d < data.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(data(d, i), original(d, oldFromNew[i]));
+
+  // Every node is split inside its bounds, every leaf is large enough, and
+  // every training point has a positive density.
+  std::stack<DTree*> nodes;
+  nodes.push(&tree);
+  while (!nodes.empty())
+  {
+    DTree* node = nodes.top();
+    nodes.pop();
+    if (node->Left() == NULL)
+    {
+      BOOST_REQUIRE_GE(node->End() - node->Start(), 5);
+      continue;
+    }
+
+    BOOST_REQUIRE_GT(node->SplitValue(), node->MinVals()[node->SplitDim()]);
+    BOOST_REQUIRE_LT(node->SplitValue(), node->MaxVals()[node->SplitDim()]);
+
+    nodes.push(node->Left());
+    nodes.push(node->Right());
+  }
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_GT(tree.ComputeValue(data.unsafe_col(i)), 0.0);
+}
+
+/**
+ * Make sure that cross-validating the folds in parallel gives the same tree as
+ * cross-validating them serially.
+ */
+BOOST_AUTO_TEST_CASE(TestTrainerThreads)
+{
+  arma::mat data = arma::randn<arma::mat>(2, 1000);
+
+  DTree* serialTree = Trainer(data, 5, false, 10, 5, "", 1);
+  DTree* parallelTree = Trainer(data, 5, false, 10, 5, "", 0);
+
+  BOOST_REQUIRE_EQUAL(serialTree->SubtreeLeaves(),
+      parallelTree->SubtreeLeaves());
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(serialTree->ComputeValue(data.unsafe_col(i)),
+        parallelTree->ComputeValue(data.unsafe_col(i)));
+
+  delete serialTree;
+  delete parallelTree;
+}
+
+/**
+ * Make sure the flattened tree gives the same densities and buckets as the
+ * tree it was made from, both inside and outside of the bounding box, and
+ * that it survives saving and loading.
+ */
+BOOST_AUTO_TEST_CASE(TestFlatDTree)
+{
+  arma::mat data = arma::randn<arma::mat>(3, 1000);
+  DTree* tree = Trainer(data, 5, false, 10, 5);
+  tree->TagTree();
+
+  FlatDTree flatTree(*tree);
+  BOOST_REQUIRE_EQUAL(flatTree.NumLeaves(), tree->SubtreeLeaves());
+  BOOST_REQUIRE_EQUAL(flatTree.Dimensionality(), 3);
+
+  arma::mat queries = 1.5 * arma::randn<arma::mat>(3, 500);
+  arma::vec densities;
+  flatTree.ComputeValue(queries, densities);
+  BOOST_REQUIRE_EQUAL(densities.n_elem, queries.n_cols);
+
+  flatTree.Save("test_flat_dtree.bin");
+  FlatDTree loadedTree("test_flat_dtree.bin");
+  remove("test_flat_dtree.bin");
+  BOOST_REQUIRE_EQUAL(loadedTree.NumNodes(), flatTree.NumNodes());
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const arma::vec query = queries.col(i);
+    const double density = tree->ComputeValue(query);
+
+    BOOST_REQUIRE_EQUAL(densities[i], density);
+    BOOST_REQUIRE_EQUAL(flatTree.ComputeValue(query), density);
+    BOOST_REQUIRE_EQUAL(loadedTree.ComputeValue(query), density);
+    BOOST_REQUIRE_EQUAL(flatTree.FindBucket(query), tree->FindBucket(query));
+    BOOST_REQUIRE_EQUAL(loadedTree.FindBucket(query), tree->FindBucket(query));
+  }
+
+  delete tree;
+}
+
 /**
  * These are not yet implemented.
  *
@@ -187,6 +187,119 @@ BOOST_AUTO_TEST_CASE(GaussianDistributionProbabilityTest)
   BOOST_REQUIRE_CLOSE(d.Probability("4 0 6 1 0"), 4.57951032485297e-7, 1e-5);
 }
 
+/**
+ * Make sure the batched log-probability agrees with the single-point
+ * probability and with phi().
+ */
+BOOST_AUTO_TEST_CASE(GaussianDistributionLogProbabilityTest)
+{
+  arma::vec mean("1.0 -2.0 0.5");
+  arma::mat cov("2.0 0.3 0.1;"
+                "0.3 1.5 0.2;"
+                "0.1 0.2 0.8");
+
+  GaussianDistribution d(mean, cov);
+
+  arma::mat observations;
+  observations.randn(3, 50);
+
+  arma::vec logProbabilities;
+  d.LogProbability(observations, logProbabilities);
+
+  arma::vec probabilities;
+  d.Probability(observations, probabilities);
+
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, 50);
+  BOOST_REQUIRE_EQUAL(probabilities.n_elem, 50);
+
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const double p = gmm::phi(observations.unsafe_col(i), mean, cov);
+
+    BOOST_REQUIRE_CLOSE(d.Probability(observations.unsafe_col(i)), p, 1e-5);
+    BOOST_REQUIRE_CLOSE(d.LogProbability(observations.unsafe_col(i)), log(p),
+        1e-5);
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], log(p), 1e-5);
+    BOOST_REQUIRE_CLOSE(probabilities[i], p, 1e-5);
+  }
+}
+
+/**
+ * Make sure that modifying the covariance invalidates the cached
+ * factorization.
+ */
+BOOST_AUTO_TEST_CASE(GaussianDistributionCovarianceChangeTest)
+{
+  arma::vec mean("0.0 0.0");
+  arma::mat cov("1.0 0.0;"
+                "0.0 1.0");
+
+  GaussianDistribution d(mean, cov);
+
+  const arma::vec x("0.5 -1.0");
+  BOOST_REQUIRE_CLOSE(d.Probability(x), gmm::phi(x, mean, cov), 1e-5);
+
+  // Change the covariance; the next call must use the new factorization.
+  cov(0, 0) = 4.0;
+  cov(0, 1) = cov(1, 0) = 0.5;
+  d.Covariance() = cov;
+
+  BOOST_REQUIRE_CLOSE(d.Probability(x), gmm::phi(x, mean, cov), 1e-5);
+
+  // Estimate() should also invalidate it.
+  arma::mat observations;
+  observations.randn(2, 500);
+  d.Estimate(observations);
+
+  BOOST_REQUIRE_CLOSE(d.Probability(x), gmm::phi(x, d.Mean(), d.Covariance()),
+      1e-5);
+}
+
+/**
+ * Make sure that a diagonal covariance, which is evaluated without a
+ * factorization, gives the right probabilities and random observations.
+ */
+BOOST_AUTO_TEST_CASE(GaussianDistributionDiagonalTest)
+{
+  arma::vec mean("1.0 -2.0 0.5 3.0");
+  arma::vec variances("2.0 0.5 1.5 0.25");
+  arma::mat cov = arma::diagmat(variances);
+
+  GaussianDistribution d(mean, cov);
+
+  arma::mat observations;
+  observations.randn(4, 50);
+
+  arma::vec logProbabilities;
+  d.LogProbability(observations, logProbabilities);
+
+  for (size_t i = 0; i < 50; ++i)
+  {
+    const double p = gmm::phi(observations.unsafe_col(i), mean, cov);
+
+    BOOST_REQUIRE_CLOSE(d.LogProbability(observations.unsafe_col(i)), log(p),
+        1e-5);
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], log(p), 1e-5);
+  }
+
+  arma::mat obs(4, 5000);
+  for (size_t i = 0; i < 5000; i++)
+    obs.col(i) = d.Random();
+
+  // 10% tolerance because this can be noisy.
+  const arma::mat obsCov = ccov(obs);
+  for (size_t i = 0; i < 4; ++i)
+    BOOST_REQUIRE_CLOSE(obsCov(i, i), variances[i], 10.0);
+
+  // Once the covariance is no longer diagonal, the full factorization must be
+  // used.
+  cov(0, 1) = cov(1, 0) = 0.3;
+  d.Covariance() = cov;
+
+  const arma::vec x("0.5 -1.0 0.0 2.5");
+  BOOST_REQUIRE_CLOSE(d.Probability(x), gmm::phi(x, mean, cov), 1e-5);
+}
+
 /**
  * Make sure random observations follow the probability distribution correctly.
  */
@@ -20,6 +20,8 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/emst/dtb.hpp>
+#include <mlpack/methods/emst/approximate_mst.hpp>
+#include <mlpack/methods/emst/single_linkage.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -140,4 +142,187 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive)
   }
 }
 
+/**
+ * Make sure that splitting each Boruvka round over several threads gives the
+ * same spanning tree as the serial computation.  The second dataset is a grid,
+ * so there are many candidate edges of equal length.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat gridData(2, 400);
+  for (size_t i = 0; i < 400; i++)
+  {
+    gridData(0, i) = (double) (i % 20);
+    gridData(1, i) = (double) (i / 20);
+  }
+
+  for (size_t d = 0; d < 2; d++)
+  {
+    const arma::mat& dataset = (d == 0) ? inputData : gridData;
+
+    DualTreeBoruvka<> serial(dataset);
+    arma::mat serialResults;
+    serial.ComputeMST(serialResults);
+
+    // 0 means all available cores.
+    const size_t threads[] = { 2, 4, 0 };
+    for (size_t t = 0; t < 3; t++)
+    {
+      DualTreeBoruvka<> parallel(dataset);
+      parallel.Threads() = threads[t];
+
+      arma::mat parallelResults;
+      parallel.ComputeMST(parallelResults);
+
+      BOOST_REQUIRE_EQUAL(parallelResults.n_cols, serialResults.n_cols);
+      BOOST_REQUIRE_EQUAL(parallelResults.n_rows, serialResults.n_rows);
+
+      for (size_t i = 0; i < serialResults.n_cols; i++)
+      {
+        BOOST_REQUIRE_EQUAL(parallelResults(0, i), serialResults(0, i));
+        BOOST_REQUIRE_EQUAL(parallelResults(1, i), serialResults(1, i));
+        BOOST_REQUIRE_EQUAL(parallelResults(2, i), serialResults(2, i));
+      }
+    }
+  }
+}
+
+/**
+ * Build the single-linkage dendrogram and flat clusters of a few points on a
+ * line, where the merge order is easy to see.
+ */
+BOOST_AUTO_TEST_CASE(SingleLinkageTest)
+{
+  arma::mat data(1, 5);
+  data[0] = 3.0;
+  data[1] = 0.0;
+  data[2] = 7.0;
+  data[3] = 1.0;
+  data[4] = 15.0;
+
+  DualTreeBoruvka<> dtb(data);
+  arma::mat mst;
+  dtb.ComputeMST(mst);
+
+  arma::mat dendrogram;
+  SingleLinkage(mst, dendrogram);
+
+  BOOST_REQUIRE_EQUAL(dendrogram.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(dendrogram.n_cols, 4);
+
+  // Points 1 and 3 are merged first, into cluster 5.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 0), 1);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 0), 3);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 0), 2);
+
+  // Then point 0 joins them, making cluster 6.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 1), 0);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 1), 5);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 1), 2.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 1), 3);
+
+  // Then point 2, making cluster 7.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 2), 2);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 2), 6);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 2), 4.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 2), 4);
+
+  // And finally point 4.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 3), 4);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 3), 7);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 3), 8.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 3), 5);
+
+  arma::Col<size_t> assignments;
+  BOOST_REQUIRE_EQUAL(FlatClusters(mst, 0.5, assignments), 5);
+  for (size_t i = 0; i < 5; i++)
+    BOOST_REQUIRE_EQUAL(assignments[i], i);
+
+  BOOST_REQUIRE_EQUAL(FlatClusters(mst, 3.0, assignments), 3);
+  BOOST_REQUIRE_EQUAL(assignments[0], 0);
+  BOOST_REQUIRE_EQUAL(assignments[1], 0);
+  BOOST_REQUIRE_EQUAL(assignments[2], 1);
+  BOOST_REQUIRE_EQUAL(assignments[3], 0);
+  BOOST_REQUIRE_EQUAL(assignments[4], 2);
+
+  BOOST_REQUIRE_EQUAL(FlatClusters(mst, 8.0, assignments), 1);
+  for (size_t i = 0; i < 5; i++)
+    BOOST_REQUIRE_EQUAL(assignments[i], 0);
+}
+
+/**
+ * When every point is a neighbor of every other point, the approximate
+ * spanning tree is the exact one.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateMSTCompleteGraphTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 200);
+
+  DualTreeBoruvka<> dtb(dataset);
+  arma::mat exactResults;
+  dtb.ComputeMST(exactResults);
+
+  ApproximateMST mst(dataset, 199);
+  arma::mat results;
+  mst.ComputeMST(results);
+
+  BOOST_REQUIRE_EQUAL(mst.GraphComponents(), 1);
+  BOOST_REQUIRE_EQUAL(results.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(results.n_cols, 199);
+  BOOST_REQUIRE_CLOSE(arma::accu(results.row(2)),
+      arma::accu(exactResults.row(2)), 1e-5);
+  for (size_t i = 0; i < 199; i++)
+    BOOST_REQUIRE_CLOSE(results(2, i), exactResults(2, i), 1e-5);
+}
+
+/**
+ * Two distant clusters give a kNN graph with several components, which must be
+ * joined; the graph is large enough that Filter-Kruskal splits the edges.  The
+ * result must be a spanning tree, in order of length, no shorter than the
+ * exact one and (for such uniform data) very close to it.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateMSTComponentsTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 8000);
+  dataset.cols(4000, 7999) += 10.0;
+
+  DualTreeBoruvka<> dtb(dataset, false, 20);
+  arma::mat exactResults;
+  dtb.ComputeMST(exactResults);
+
+  ApproximateMST mst(dataset, 20);
+  mst.Threads() = 2;
+  arma::mat results;
+  mst.ComputeMST(results);
+
+  BOOST_REQUIRE_GE(mst.GraphComponents(), 2);
+  BOOST_REQUIRE_EQUAL(results.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(results.n_cols, 7999);
+
+  UnionFind components(8000);
+  for (size_t i = 0; i < results.n_cols; i++)
+  {
+    const size_t a = (size_t) results(0, i);
+    const size_t b = (size_t) results(1, i);
+    BOOST_REQUIRE_LT(a, b);
+    BOOST_REQUIRE_NE(components.Find(a), components.Find(b));
+    components.Union(a, b);
+
+    BOOST_REQUIRE_CLOSE(results(2, i), arma::norm(dataset.col(a) -
+        dataset.col(b), 2), 1e-5);
+    if (i > 0)
+      BOOST_REQUIRE_LE(results(2, i - 1), results(2, i));
+  }
+
+  const double exactLength = arma::accu(exactResults.row(2));
+  const double length = arma::accu(results.row(2));
+  BOOST_REQUIRE_GE(length, exactLength * (1 - 1e-10));
+  BOOST_REQUIRE_LE(length, exactLength * 1.01);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
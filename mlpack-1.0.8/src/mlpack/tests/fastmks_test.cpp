@@ -23,6 +23,12 @@
 #include <mlpack/methods/fastmks/fastmks.hpp>
 #include <mlpack/core/kernels/linear_kernel.hpp>
 #include <mlpack/core/kernels/polynomial_kernel.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
+#include <mlpack/core/kernels/cached_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/kernel_block.hpp>
+#include <mlpack/methods/fastmks/fastmks_index.hpp>
+#include <mlpack/methods/fastmks/recall.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -136,4 +142,235 @@ BOOST_AUTO_TEST_CASE(DualTreeVsSingleTree)
   }
 }
 
+/**
+ * Make sure the block evaluations match the kernels evaluated pair by pair.
+ */
+template<typename KernelType>
+void CheckKernelBlock(KernelType& kernel)
+{
+  arma::mat queries(4, 30);
+  queries.randn();
+  arma::mat references(4, 50);
+  references.randn();
+  references.col(7).zeros(); // For the cosine distance.
+
+  arma::mat kernels;
+  KernelBlock<KernelType>::Evaluate(kernel, queries, 3, 20, references, 5, 40,
+      kernels);
+
+  BOOST_REQUIRE_EQUAL(kernels.n_rows, 40);
+  BOOST_REQUIRE_EQUAL(kernels.n_cols, 20);
+  for (size_t q = 0; q < 20; ++q)
+  {
+    for (size_t r = 0; r < 40; ++r)
+    {
+      const double eval = kernel.Evaluate(queries.unsafe_col(q + 3),
+          references.unsafe_col(r + 5));
+      if (std::abs(eval) < 1e-10)
+        BOOST_REQUIRE_SMALL(kernels(r, q), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(kernels(r, q), eval, 1e-8);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(KernelBlockTest)
+{
+  LinearKernel lk;
+  CheckKernelBlock(lk);
+
+  PolynomialKernel pk(3.0, 1.5);
+  CheckKernelBlock(pk);
+
+  CosineDistance cd;
+  CheckKernelBlock(cd);
+}
+
+/**
+ * Naive and single-tree search with several threads should give the same
+ * results as serial single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  arma::mat queryData;
+  queryData.randn(5, 300);
+  PolynomialKernel pk(2.0, 1.0);
+
+  for (size_t d = 0; d < 2; ++d)
+  {
+    const arma::mat& querySet = (d == 0) ? data : queryData;
+
+    FastMKS<PolynomialKernel> serial(data, querySet, pk, true);
+    arma::Mat<size_t> serialIndices;
+    arma::mat serialProducts;
+    serial.Search(10, serialIndices, serialProducts);
+
+    for (size_t mode = 0; mode < 2; ++mode)
+    {
+      // Mode 0 is naive, mode 1 is single-tree.
+      FastMKS<PolynomialKernel> parallel(data, querySet, pk, (mode == 1),
+          (mode == 0));
+      parallel.Threads() = 4;
+
+      arma::Mat<size_t> indices;
+      arma::mat products;
+      parallel.Search(10, indices, products);
+
+      BOOST_REQUIRE_EQUAL(indices.n_cols, serialIndices.n_cols);
+      for (size_t q = 0; q < indices.n_cols; ++q)
+      {
+        for (size_t r = 0; r < indices.n_rows; ++r)
+        {
+          BOOST_REQUIRE_EQUAL(indices(r, q), serialIndices(r, q));
+          BOOST_REQUIRE_CLOSE(products(r, q), serialProducts(r, q), 1e-5);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Make sure two cover trees have the same structure and self-kernels.
+ */
+template<typename TreeType>
+void CheckSameCoverTree(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Point(), b.Point());
+  BOOST_REQUIRE_EQUAL(a.Scale(), b.Scale());
+  BOOST_REQUIRE_EQUAL(a.NumChildren(), b.NumChildren());
+  BOOST_REQUIRE_EQUAL(a.NumDescendants(), b.NumDescendants());
+  BOOST_REQUIRE_EQUAL(a.ParentDistance(), b.ParentDistance());
+  BOOST_REQUIRE_EQUAL(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance());
+  BOOST_REQUIRE_EQUAL(a.Stat().SelfKernel(), b.Stat().SelfKernel());
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(b.Child(i).Parent(), &b);
+    CheckSameCoverTree(a.Child(i), b.Child(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FastMKSIndexSaveLoadTest)
+{
+  arma::mat data;
+  data.randn(5, 600);
+  PolynomialKernel pk(2.0, 1.0);
+
+  FastMKSIndex<PolynomialKernel> index(data, pk, 1.5);
+  index.Save("test-fastmks-index.bin");
+
+  FastMKSIndex<PolynomialKernel> loaded("test-fastmks-index.bin", pk);
+
+  BOOST_REQUIRE_EQUAL(loaded.Dataset().n_rows, data.n_rows);
+  BOOST_REQUIRE_EQUAL(loaded.Dataset().n_cols, data.n_cols);
+  for (size_t i = 0; i < data.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.Dataset()[i], data[i]);
+
+  BOOST_REQUIRE_EQUAL(loaded.Tree().Base(), 1.5);
+  CheckSameCoverTree(index.Tree(), loaded.Tree());
+
+  // Search with the loaded tree, and compare with naive search.
+  FastMKS<PolynomialKernel> single(loaded.Dataset(), &loaded.Tree(), true);
+  arma::Mat<size_t> indices;
+  arma::mat products;
+  single.Search(10, indices, products);
+
+  FastMKS<PolynomialKernel> naive(data, pk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  for (size_t i = 0; i < indices.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(indices[i], naiveIndices[i]);
+    BOOST_REQUIRE_CLOSE(products[i], naiveProducts[i], 1e-5);
+  }
+
+  remove("test-fastmks-index.bin");
+}
+
+/**
+ * FastMKS with a cached kernel must give the same results as with the kernel
+ * itself, and a second search must be answered from the cache.
+ */
+BOOST_AUTO_TEST_CASE(CachedKernelVsUncached)
+{
+  arma::mat data;
+  data.randu(5, 500);
+  GaussianKernel gk(0.5);
+
+  FastMKS<GaussianKernel> plain(data, gk);
+  arma::Mat<size_t> plainIndices;
+  arma::mat plainKernels;
+  plain.Search(5, plainIndices, plainKernels);
+
+  CachedKernel<GaussianKernel> ck(data, 1000000, gk);
+  FastMKS<CachedKernel<GaussianKernel> > cached(data, ck);
+  arma::Mat<size_t> cachedIndices;
+  arma::mat cachedKernels;
+  cached.Search(5, cachedIndices, cachedKernels);
+
+  for (size_t q = 0; q < cachedIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < cachedIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(cachedIndices(r, q), plainIndices(r, q));
+      BOOST_REQUIRE_CLOSE(cachedKernels(r, q), plainKernels(r, q), 1e-5);
+    }
+  }
+
+  // Every pair the second search evaluates was evaluated by the first one.
+  const size_t misses = ck.Misses();
+  BOOST_REQUIRE_GT(misses, 0);
+  cached.Search(5, cachedIndices, cachedKernels);
+  BOOST_REQUIRE_EQUAL(ck.Misses(), misses);
+  BOOST_REQUIRE_GT(ck.Hits(), 0);
+}
+
+/**
+ * Approximate search with epsilon = 0 is exact, and with epsilon > 0 every
+ * kernel found is within a factor (1 + epsilon) of the true one.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateVsExact)
+{
+  // Positive data, so that all the linear kernels are positive.
+  arma::mat data;
+  data.randu(20, 2000);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  arma::Mat<size_t> exactIndices;
+  arma::mat exactProducts;
+  naive.Search(5, exactIndices, exactProducts);
+
+  for (size_t single = 0; single < 2; ++single)
+  {
+    FastMKS<LinearKernel> exact(data, lk, (single == 1));
+    exact.Epsilon() = 0.0;
+    arma::Mat<size_t> indices;
+    arma::mat products;
+    exact.Search(5, indices, products);
+
+    BOOST_REQUIRE_CLOSE(Recall(indices, exactIndices), 1.0, 1e-10);
+
+    FastMKS<LinearKernel> approx(data, lk, (single == 1));
+    approx.Epsilon() = 0.5;
+    approx.Search(5, indices, products);
+
+    const double recall = Recall(indices, exactIndices);
+    BOOST_REQUIRE_GT(recall, 0.0);
+    BOOST_REQUIRE_LE(recall, 1.0);
+    for (size_t q = 0; q < products.n_cols; ++q)
+      for (size_t r = 0; r < products.n_rows; ++r)
+        BOOST_REQUIRE_GE(1.5 * products(r, q), exactProducts(r, q) - 1e-10);
+  }
+
+  // A permutation of each column does not change the recall.
+  arma::Mat<size_t> reversed = arma::flipud(exactIndices);
+  BOOST_REQUIRE_CLOSE(Recall(reversed, exactIndices), 1.0, 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -29,8 +29,13 @@
 #include <mlpack/methods/gmm/diagonal_constraint.hpp>
 #include <mlpack/methods/gmm/eigenvalue_ratio_constraint.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
+#include "thread_communicator.hpp"
 
 using namespace mlpack;
 using namespace mlpack::gmm;
@@ -599,6 +604,66 @@ BOOST_AUTO_TEST_CASE(GMMClassifyTest)
   BOOST_REQUIRE_EQUAL(classes[12], 2);
 }
 
+/**
+ * Make sure that scoring many observations at once, in blocks and in parallel,
+ * agrees with scoring them one at a time.
+ */
+BOOST_AUTO_TEST_CASE(GMMBatchScoringTest)
+{
+  GMM<> gmm(3, 2);
+  gmm.Means()[0] = "0 0";
+  gmm.Means()[1] = "1 3";
+  gmm.Means()[2] = "-2 -2";
+  gmm.Covariances()[0] = "1 0; 0 1";
+  gmm.Covariances()[1] = "3 2; 2 3";
+  gmm.Covariances()[2] = "2.2 1.4; 1.4 5.1";
+  gmm.Weights() = "0.6 0.25 0.15";
+
+  arma::mat observations;
+  observations.randn(2, 1000);
+  observations *= 3.0;
+
+  arma::vec probabilities;
+  gmm.Probability(observations, probabilities);
+  const double logLikelihood = gmm.LogLikelihood(observations);
+
+  arma::Col<size_t> labels;
+  gmm.Classify(observations, labels);
+
+  BOOST_REQUIRE_EQUAL(probabilities.n_elem, 1000);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 1000);
+
+  double sum = 0.0;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    const arma::vec x = observations.col(i);
+    BOOST_REQUIRE_CLOSE(probabilities[i], gmm.Probability(x), 1e-5);
+    sum += log(gmm.Probability(x));
+
+    // The label is the component of largest weighted probability.
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_LE(gmm.Probability(x, j),
+          gmm.Probability(x, labels[i]) * (1 + 1e-10));
+  }
+  BOOST_REQUIRE_CLOSE(logLikelihood, sum, 1e-5);
+
+  // Blocks scored in parallel, and small blocks, give the same results.
+  gmm.Threads() = 4;
+  MemoryBudget::SetLimit(4096);
+  arma::vec blockProbabilities;
+  gmm.Probability(observations, blockProbabilities);
+  arma::Col<size_t> blockLabels;
+  gmm.Classify(observations, blockLabels);
+  BOOST_REQUIRE_CLOSE(gmm.LogLikelihood(observations), logLikelihood, 1e-10);
+  MemoryBudget::SetLimit(0);
+
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(blockProbabilities[i], probabilities[i], 1e-10);
+    BOOST_REQUIRE_EQUAL(blockLabels[i], labels[i]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(GMMLoadSaveTest)
 {
   // Create a GMM, save it, and load it.
@@ -692,6 +757,68 @@ BOOST_AUTO_TEST_CASE(DiagonalConstraintTest)
   }
 }
 
+/**
+ * EM with the DiagonalConstraint only computes the variances; make sure they
+ * are right, serially and blockwise.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalEMFitTest)
+{
+  // Two well-separated Gaussians in 20 dimensions, with different variances
+  // in each dimension.
+  const size_t dims = 20;
+  const arma::vec variances = arma::linspace<arma::vec>(0.5, 2.0, dims);
+  arma::mat data;
+  data.randn(dims, 2000);
+  for (size_t j = 0; j < dims; ++j)
+    data.row(j) *= sqrt(variances[j]);
+  data.cols(1000, 1999) += 10.0;
+
+  std::vector<arma::vec> means(2);
+  means[0] = arma::ones<arma::vec>(dims);
+  means[1] = 9.0 * arma::ones<arma::vec>(dims);
+  std::vector<arma::mat> covars(2, arma::eye<arma::mat>(dims, dims));
+  arma::vec weights("0.5 0.5");
+
+  std::vector<arma::vec> blockMeans(means);
+  std::vector<arma::mat> blockCovars(covars);
+  arma::vec blockWeights(weights);
+
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> fit;
+  fit.Estimate(data, means, covars, weights, true);
+
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> blockFit;
+  blockFit.Threads() = 4;
+  blockFit.Estimate(data, blockMeans, blockCovars, blockWeights, true);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    // The Gaussians are far enough apart that each one holds one half of the
+    // points, so its variances are those of that half.
+    const arma::mat half = data.cols(1000 * i, 1000 * i + 999);
+
+    BOOST_REQUIRE_CLOSE(weights[i], 0.5, 1e-5);
+    BOOST_REQUIRE_CLOSE(blockWeights[i], weights[i], 1e-5);
+
+    for (size_t j = 0; j < dims; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(blockMeans[i][j], means[i][j], 1e-5);
+
+      BOOST_REQUIRE_CLOSE(covars[i](j, j), (double) arma::var(half.row(j), 1),
+          1e-3);
+      BOOST_REQUIRE_CLOSE(blockCovars[i](j, j), covars[i](j, j), 1e-5);
+
+      for (size_t k = 0; k < dims; ++k)
+      {
+        if (j != k)
+        {
+          BOOST_REQUIRE_SMALL(covars[i](j, k), 1e-50);
+          BOOST_REQUIRE_SMALL(blockCovars[i](j, k), 1e-50);
+        }
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(EigenvalueRatioConstraintTest)
 {
   // Generate a list of eigenvalue ratios.
@@ -871,4 +998,441 @@ BOOST_AUTO_TEST_CASE(UseExistingModelTest)
   }
 }
 
+/**
+ * Make sure that EM works in high dimensions when the initial model is far
+ * enough from the data that the probability of every point underflows in
+ * linear space.  The log-space E-step should still assign each point to the
+ * right component.
+ */
+BOOST_AUTO_TEST_CASE(EMFitHighDimensionalUnderflowTest)
+{
+  const size_t dims = 60;
+
+  // Two well-separated clusters.
+  arma::mat data;
+  data.randn(dims, 1000);
+  data.cols(500, 999) += 20.0;
+
+  const arma::vec actualMean0 = arma::mean(data.cols(0, 499), 1);
+  const arma::vec actualMean1 = arma::mean(data.cols(500, 999), 1);
+
+  // Each initial mean is far from its cluster, so that in linear space
+  // exp(-0.5 * mahalanobis) is zero for every point and every component.
+  std::vector<arma::vec> means(2);
+  means[0] = 6.0 * arma::ones<arma::vec>(dims);
+  means[1] = 14.0 * arma::ones<arma::vec>(dims);
+  std::vector<arma::mat> covars(2, arma::eye<arma::mat>(dims, dims));
+  arma::vec weights("0.5 0.5");
+
+  EMFit<> emFit;
+  emFit.Estimate(data, means, covars, weights, true /* use initial model */);
+
+  BOOST_REQUIRE_CLOSE(weights[0], 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(weights[1], 0.5, 1e-5);
+
+  for (size_t i = 0; i < dims; ++i)
+  {
+    BOOST_REQUIRE_SMALL(means[0][i] - actualMean0[i], 1e-5);
+    BOOST_REQUIRE_SMALL(means[1][i] - actualMean1[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that the parallel (block-partitioned) EM gives the same model as
+ * the serial EM when started from the same initial model.
+ */
+BOOST_AUTO_TEST_CASE(EMFitParallelTest)
+{
+  // Three Gaussians in 4 dimensions.
+  arma::mat data;
+  data.randn(4, 900);
+  data.cols(300, 599) += 8.0;
+  data.cols(600, 899) -= 8.0;
+
+  std::vector<arma::vec> means(3);
+  means[0] = 0.5 * arma::ones<arma::vec>(4);
+  means[1] = 7.0 * arma::ones<arma::vec>(4);
+  means[2] = -7.0 * arma::ones<arma::vec>(4);
+  std::vector<arma::mat> covars(3, arma::eye<arma::mat>(4, 4));
+  arma::vec weights("0.3 0.3 0.4");
+
+  std::vector<arma::vec> parallelMeans(means);
+  std::vector<arma::mat> parallelCovars(covars);
+  arma::vec parallelWeights(weights);
+
+  EMFit<> serialFit;
+  serialFit.Estimate(data, means, covars, weights, true);
+
+  EMFit<> parallelFit;
+  parallelFit.Threads() = 4;
+  parallelFit.Estimate(data, parallelMeans, parallelCovars, parallelWeights,
+      true);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(parallelWeights[i], weights[i], 1e-5);
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(parallelMeans[i][j], means[i][j], 1e-5);
+
+      for (size_t k = 0; k < 4; ++k)
+        BOOST_REQUIRE_SMALL(parallelCovars[i](j, k) - covars[i](j, k), 1e-5);
+    }
+  }
+
+  // The weighted overload should agree with the unweighted one when every
+  // probability is 1.
+  std::vector<arma::vec> weightedMeans(3);
+  weightedMeans[0] = 0.5 * arma::ones<arma::vec>(4);
+  weightedMeans[1] = 7.0 * arma::ones<arma::vec>(4);
+  weightedMeans[2] = -7.0 * arma::ones<arma::vec>(4);
+  std::vector<arma::mat> weightedCovars(3, arma::eye<arma::mat>(4, 4));
+  arma::vec weightedWeights("0.3 0.3 0.4");
+
+  parallelFit.Estimate(data, arma::ones<arma::vec>(data.n_cols),
+      weightedMeans, weightedCovars, weightedWeights, true);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(weightedWeights[i], weights[i], 1e-5);
+
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(weightedMeans[i][j], means[i][j], 1e-5);
+  }
+}
+
+/**
+ * The tree E-step should give the exact E-step with a tolerance of 0, and a
+ * close model with a small tolerance.
+ */
+BOOST_AUTO_TEST_CASE(EMFitTreeTest)
+{
+  // Three Gaussians in 2 dimensions, two of which overlap.
+  arma::mat data;
+  data.randn(2, 6000);
+  data.cols(2000, 3999) += 2.0;
+  data.cols(4000, 5999) *= 0.5;
+  data.cols(4000, 5999) -= 6.0;
+
+  std::vector<arma::vec> initialMeans(3);
+  initialMeans[0] = "0.5 0.0";
+  initialMeans[1] = "1.5 2.5";
+  initialMeans[2] = "-5.0 -5.0";
+  std::vector<arma::mat> initialCovars(3, arma::eye<arma::mat>(2, 2));
+  arma::vec initialWeights("0.3 0.3 0.4");
+
+  std::vector<arma::vec> means(initialMeans);
+  std::vector<arma::mat> covars(initialCovars);
+  arma::vec weights(initialWeights);
+
+  EMFit<> exactFit;
+  exactFit.Estimate(data, means, covars, weights, true);
+
+  std::vector<arma::vec> treeMeans(initialMeans);
+  std::vector<arma::mat> treeCovars(initialCovars);
+  arma::vec treeWeights(initialWeights);
+
+  EMFit<> treeFit;
+  treeFit.UseTree() = true;
+  treeFit.TreeTolerance() = 0.0;
+  treeFit.Estimate(data, treeMeans, treeCovars, treeWeights, true);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(treeWeights[i], weights[i], 1e-4);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      BOOST_REQUIRE_SMALL(treeMeans[i][j] - means[i][j], 1e-6);
+      for (size_t k = 0; k < 2; ++k)
+        BOOST_REQUIRE_SMALL(treeCovars[i](j, k) - covars[i](j, k), 1e-6);
+    }
+  }
+
+  // With a tolerance, the model is approximate.
+  treeMeans = initialMeans;
+  treeCovars = initialCovars;
+  treeWeights = initialWeights;
+  treeFit.TreeTolerance() = 1e-3;
+  treeFit.Estimate(data, treeMeans, treeCovars, treeWeights, true);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_SMALL(treeWeights[i] - weights[i], 0.01);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      BOOST_REQUIRE_SMALL(treeMeans[i][j] - means[i][j], 0.05);
+      for (size_t k = 0; k < 2; ++k)
+        BOOST_REQUIRE_SMALL(treeCovars[i](j, k) - covars[i](j, k), 0.05);
+    }
+  }
+
+  // The same goes for diagonal covariances.
+  std::vector<arma::vec> diagonalMeans(initialMeans);
+  std::vector<arma::mat> diagonalCovars(initialCovars);
+  arma::vec diagonalWeights(initialWeights);
+
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> diagonalFit;
+  diagonalFit.Estimate(data, diagonalMeans, diagonalCovars, diagonalWeights,
+      true);
+
+  treeMeans = initialMeans;
+  treeCovars = initialCovars;
+  treeWeights = initialWeights;
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> diagonalTreeFit;
+  diagonalTreeFit.UseTree() = true;
+  diagonalTreeFit.TreeTolerance() = 0.0;
+  diagonalTreeFit.Estimate(data, treeMeans, treeCovars, treeWeights, true);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(treeWeights[i], diagonalWeights[i], 1e-4);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      BOOST_REQUIRE_SMALL(treeMeans[i][j] - diagonalMeans[i][j], 1e-6);
+      BOOST_REQUIRE_SMALL(treeCovars[i](j, j) - diagonalCovars[i](j, j),
+          1e-6);
+    }
+  }
+}
+
+/**
+ * Trials run at once should give the same model after the same seed, and find
+ * the three Gaussians.
+ */
+BOOST_AUTO_TEST_CASE(GMMParallelTrialsTest)
+{
+  // Three Gaussians in 4 dimensions.
+  arma::mat data;
+  data.randn(4, 900);
+  data.cols(300, 599) += 8.0;
+  data.cols(600, 899) -= 8.0;
+
+  GMM<> gmm(3, 4);
+  BOOST_REQUIRE_EQUAL(gmm.Threads(), 1);
+  gmm.Threads() = 4;
+
+  math::RandomSeed(7);
+  const double likelihood = gmm.Estimate(data, 6);
+
+  GMM<> other(3, 4);
+  other.Threads() = 4;
+  math::RandomSeed(7);
+  const double otherLikelihood = other.Estimate(data, 6);
+
+  BOOST_REQUIRE(likelihood == likelihood); // Not NaN.
+  BOOST_REQUIRE_GT(likelihood, -DBL_MAX);
+  BOOST_REQUIRE_CLOSE(otherLikelihood, likelihood, 1e-10);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(other.Weights()[i], gmm.Weights()[i], 1e-10);
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(other.Means()[i][j], gmm.Means()[i][j], 1e-10);
+  }
+
+  // Each of the true means should be close to one of the fitted means.
+  const double trueMeans[] = { 0.0, 8.0, -8.0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    double closest = DBL_MAX;
+    for (size_t i = 0; i < 3; ++i)
+      closest = std::min(closest, arma::norm(gmm.Means()[i] -
+          trueMeans[t] * arma::ones<arma::vec>(4), 2));
+    BOOST_REQUIRE_LT(closest, 0.5);
+  }
+}
+
+/**
+ * When the serial E-step does not fit in the memory budget, EM should run
+ * blockwise and give the same model.
+ */
+BOOST_AUTO_TEST_CASE(EMFitMemoryBudgetTest)
+{
+  arma::mat data;
+  data.randn(4, 900);
+  data.cols(300, 599) += 8.0;
+  data.cols(600, 899) -= 8.0;
+
+  std::vector<arma::vec> means(3);
+  means[0] = 0.5 * arma::ones<arma::vec>(4);
+  means[1] = 7.0 * arma::ones<arma::vec>(4);
+  means[2] = -7.0 * arma::ones<arma::vec>(4);
+  std::vector<arma::mat> covars(3, arma::eye<arma::mat>(4, 4));
+  arma::vec weights("0.3 0.3 0.4");
+
+  std::vector<arma::vec> budgetMeans(means);
+  std::vector<arma::mat> budgetCovars(covars);
+  arma::vec budgetWeights(weights);
+
+  EMFit<> fit;
+  const size_t serialMemory = fit.PeakMemory(900, 4, 3);
+  fit.Estimate(data, means, covars, weights, true);
+
+  // The blocks of 8kB hold about 50 points each.
+  MemoryBudget::SetLimit(8192);
+  BOOST_REQUIRE_LT(fit.PeakMemory(900, 4, 3), serialMemory);
+  BOOST_REQUIRE_LE(fit.PeakMemory(900, 4, 3), 8192);
+  fit.Estimate(data, budgetMeans, budgetCovars, budgetWeights, true);
+  MemoryBudget::SetLimit(0);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(budgetWeights[i], weights[i], 1e-5);
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(budgetMeans[i][j], means[i][j], 1e-5);
+
+      for (size_t k = 0; k < 4; ++k)
+        BOOST_REQUIRE_SMALL(budgetCovars[i](j, k) - covars[i](j, k), 1e-5);
+    }
+  }
+}
+
+//! A monitor which stops methods after the given step.
+class StepMonitor : public ProgressMonitor
+{
+ public:
+  StepMonitor(const size_t lastStep) : lastStep(lastStep) { }
+
+ protected:
+  bool Report(const std::string& /* task */,
+              const size_t step,
+              const double /* value */)
+  {
+    return (step < lastStep);
+  }
+
+ private:
+  size_t lastStep;
+};
+
+/**
+ * Stop EMFit::Estimate() with a ProgressMonitor after three iterations, and
+ * make sure the model is that of three iterations, in serial and blockwise
+ * mode.  GMM::Estimate() must then run no further trials.
+ */
+BOOST_AUTO_TEST_CASE(EMFitMonitorTest)
+{
+  arma::mat data(2, 1000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = arma::randn<arma::vec>(2) + 5.0 * (i % 3);
+
+  std::vector<arma::vec> initialMeans(3, arma::vec(2));
+  std::vector<arma::mat> initialCovariances(3, arma::eye<arma::mat>(2, 2));
+  arma::vec initialWeights = arma::ones<arma::vec>(3) / 3.0;
+  for (size_t i = 0; i < 3; ++i)
+    initialMeans[i].fill(4.0 * i + 1.0);
+
+  for (size_t threads = 1; threads <= 2; ++threads)
+  {
+    // With maxIterations = 4, EM runs three iterations.
+    EMFit<> limited(4);
+    limited.Threads() = threads;
+    std::vector<arma::vec> limitedMeans(initialMeans);
+    std::vector<arma::mat> limitedCovariances(initialCovariances);
+    arma::vec limitedWeights(initialWeights);
+    limited.Estimate(data, limitedMeans, limitedCovariances, limitedWeights,
+        true);
+
+    StepMonitor monitor(3);
+    EMFit<> em(1000, 1e-20);
+    em.Threads() = threads;
+    em.Monitor() = &monitor;
+    std::vector<arma::vec> means(initialMeans);
+    std::vector<arma::mat> covariances(initialCovariances);
+    arma::vec weights(initialWeights);
+    em.Estimate(data, means, covariances, weights, true);
+
+    BOOST_REQUIRE(monitor.Stopped());
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(weights[i], limitedWeights[i], 1e-8);
+      for (size_t j = 0; j < 2; ++j)
+        BOOST_REQUIRE_CLOSE(means[i][j], limitedMeans[i][j], 1e-8);
+    }
+  }
+
+  // A monitor which is already stopped stops the first trial after its first
+  // iteration, and no other trial is run.
+  ProgressMonitor monitor;
+  monitor.Cancel();
+  EMFit<> em;
+  em.Monitor() = &monitor;
+  GMM<> gmm(3, 2, em);
+  const double likelihood = gmm.Estimate(data, 5);
+  BOOST_REQUIRE(monitor.Stopped());
+  BOOST_REQUIRE(likelihood > -DBL_MAX);
+}
+
+/**
+ * Make sure that EM on a dataset split into shards, one for each rank of a
+ * communicator (here, threads), fits the same model as EM on the whole dataset
+ * in one process.
+ */
+BOOST_AUTO_TEST_CASE(EMFitDistributedTest)
+{
+#ifdef _OPENMP
+  arma::mat data(2, 900);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = arma::randn<arma::vec>(2) + 5.0 * (i % 3);
+
+  std::vector<arma::vec> initialMeans(3, arma::vec(2));
+  std::vector<arma::mat> initialCovariances(3, arma::eye<arma::mat>(2, 2));
+  arma::vec initialWeights = arma::ones<arma::vec>(3) / 3.0;
+  for (size_t i = 0; i < 3; ++i)
+    initialMeans[i].fill(4.0 * i + 1.0);
+
+  // Both run the same number of iterations.
+  EMFit<> em(10, 1e-20);
+  std::vector<arma::vec> means(initialMeans);
+  std::vector<arma::mat> covariances(initialCovariances);
+  arma::vec weights(initialWeights);
+  em.Estimate(data, means, covariances, weights, true);
+
+  const size_t ranks = 3;
+  const size_t bounds[] = { 0, 150, 500, 900 };
+  std::vector<std::vector<double> > buffers(ranks);
+  std::vector<std::vector<arma::vec> > shardMeans(ranks, initialMeans);
+  std::vector<std::vector<arma::mat> > shardCovariances(ranks,
+      initialCovariances);
+  std::vector<arma::vec> shardWeights(ranks, initialWeights);
+  size_t threads = 0;
+
+  #pragma omp parallel num_threads(ranks)
+  {
+    const size_t rank = (size_t) omp_get_thread_num();
+    #pragma omp single
+    threads = (size_t) omp_get_num_threads();
+
+    if (threads == ranks)
+    {
+      ThreadCommunicator communicator(buffers, rank);
+      EMFit<> shardEM(10, 1e-20);
+      shardEM.Comm() = &communicator;
+      shardEM.Estimate(arma::mat(data.cols(bounds[rank], bounds[rank + 1] -
+          1)), shardMeans[rank], shardCovariances[rank], shardWeights[rank],
+          true);
+    }
+  }
+
+  if (threads != ranks)
+    return;
+
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(shardWeights[r][i], weights[i], 1e-6);
+      for (size_t j = 0; j < 2; ++j)
+        BOOST_REQUIRE_CLOSE(shardMeans[r][i][j], means[i][j], 1e-6);
+      for (size_t j = 0; j < 4; ++j)
+        BOOST_REQUIRE_CLOSE(shardCovariances[r][i][j], covariances[i][j],
+            1e-6);
+    }
+  }
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END();
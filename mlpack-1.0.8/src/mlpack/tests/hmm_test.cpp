@@ -20,6 +20,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/hmm/hmm_filter.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
 
 #include <boost/test/unit_test.hpp>
@@ -108,6 +109,86 @@ BOOST_AUTO_TEST_CASE(BorodovskyHMMTestViterbi)
   BOOST_REQUIRE_EQUAL(states[8], 2);
 }
 
+/**
+ * Viterbi decoding must find the most probable state sequence, which we check
+ * against an exhaustive search.  A beam as wide as the number of states must
+ * give the same result, and a narrower beam must return the log-likelihood of
+ * the (possibly worse) sequence it finds.
+ */
+BOOST_AUTO_TEST_CASE(HMMViterbiBeamTest)
+{
+  arma::mat transition("0.5 0.2 0.3; 0.3 0.6 0.2; 0.2 0.2 0.5");
+  std::vector<DiscreteDistribution> emission(3);
+  emission[0] = DiscreteDistribution("0.6 0.3 0.1");
+  emission[1] = DiscreteDistribution("0.2 0.5 0.3");
+  emission[2] = DiscreteDistribution("0.1 0.2 0.7");
+
+  HMM<DiscreteDistribution> hmm(transition, emission);
+
+  arma::mat observations("0 1 2 2 1 0 2 1");
+  const size_t length = observations.n_cols;
+
+  // Exhaustive search over all 3^8 state sequences.
+  arma::Col<size_t> best(length);
+  double bestProb = -1.0;
+  arma::Col<size_t> candidate(length);
+  size_t combinations = 1;
+  for (size_t t = 0; t < length; ++t)
+    combinations *= 3;
+  for (size_t c = 0; c < combinations; ++c)
+  {
+    size_t code = c;
+    for (size_t t = 0; t < length; ++t)
+    {
+      candidate[t] = code % 3;
+      code /= 3;
+    }
+
+    double prob = 1.0;
+    for (size_t t = 0; t < length; ++t)
+    {
+      const size_t previous = (t == 0) ? 0 : candidate[t - 1];
+      prob *= transition(candidate[t], previous) *
+          emission[candidate[t]].Probability(observations.col(t));
+    }
+
+    if (prob > bestProb)
+    {
+      bestProb = prob;
+      best = candidate;
+    }
+  }
+
+  for (size_t beamWidth = 0; beamWidth <= 3; ++beamWidth)
+  {
+    hmm.BeamWidth() = beamWidth;
+
+    arma::Col<size_t> states;
+    const double logLikelihood = hmm.Predict(observations, states);
+    BOOST_REQUIRE_EQUAL(states.n_elem, length);
+
+    double prob = 1.0;
+    for (size_t t = 0; t < length; ++t)
+    {
+      const size_t previous = (t == 0) ? 0 : states[t - 1];
+      prob *= transition(states[t], previous) *
+          emission[states[t]].Probability(observations.col(t));
+    }
+    BOOST_REQUIRE_CLOSE(logLikelihood, log(prob), 1e-5);
+
+    if (beamWidth == 0 || beamWidth == 3)
+    {
+      BOOST_REQUIRE_CLOSE(logLikelihood, log(bestProb), 1e-5);
+      for (size_t t = 0; t < length; ++t)
+        BOOST_REQUIRE_EQUAL(states[t], best[t]);
+    }
+    else
+    {
+      BOOST_REQUIRE_LE(logLikelihood, log(bestProb) + 1e-10);
+    }
+  }
+}
+
 /**
  * Ensure that the forward-backward algorithm is correct.
  */
@@ -510,6 +591,66 @@ BOOST_AUTO_TEST_CASE(DiscreteHMMLogLikelihoodTest)
       -24.51556128368, 1e-5);
 }
 
+/**
+ * Discrete HMMs look emission probabilities up in a table, and count symbols
+ * directly in the Baum-Welch update.  Check one iteration of Baum-Welch against
+ * the weighted symbol counts given by the Forward-Backward state
+ * probabilities.
+ */
+BOOST_AUTO_TEST_CASE(DiscreteHMMEmissionTableTest)
+{
+  arma::mat transition("0.5 0.0 0.1;"
+                       "0.2 0.6 0.2;"
+                       "0.3 0.4 0.7");
+  std::vector<DiscreteDistribution> emission(3);
+  emission[0].Probabilities() = "0.60 0.25 0.10 0.05";
+  emission[1].Probabilities() = "0.10 0.25 0.25 0.40";
+  emission[2].Probabilities() = "0.10 0.40 0.40 0.10";
+
+  HMM<DiscreteDistribution> hmm(transition, emission);
+
+  std::vector<arma::mat> observations;
+  observations.push_back("0 2 2 1 2 3 0 0 1 3 1 0 0 3 1 2 2");
+  observations.push_back("3 3 1 0 2");
+
+  // The expected emissions are the weighted counts of each symbol.
+  arma::mat stateProb;
+  arma::mat expected = arma::zeros<arma::mat>(4, 3);
+  for (size_t seq = 0; seq < observations.size(); ++seq)
+  {
+    hmm.Estimate(observations[seq], stateProb);
+    for (size_t t = 0; t < observations[seq].n_cols; ++t)
+      expected.row((size_t) observations[seq](0, t)) +=
+          trans(stateProb.col(t));
+  }
+
+  // Stop after the first iteration.
+  ProgressMonitor monitor;
+  monitor.Cancel();
+  hmm.Monitor() = &monitor;
+  hmm.Train(observations);
+
+  for (size_t state = 0; state < 3; ++state)
+  {
+    expected.col(state) /= accu(expected.col(state));
+    for (size_t s = 0; s < 4; ++s)
+      BOOST_REQUIRE_CLOSE(hmm.Emission()[state].Probabilities()[s],
+          expected(s, state), 1e-5);
+  }
+
+  // The emission probabilities used by the forward algorithm are those of the
+  // new distributions.
+  double prob = 0.0;
+  const arma::mat sequence("1 3");
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 3; ++j)
+      prob += hmm.Transition()(i, 0) *
+          hmm.Emission()[i].Probability(sequence.col(0)) *
+          hmm.Transition()(j, i) *
+          hmm.Emission()[j].Probability(sequence.col(1));
+  BOOST_REQUIRE_CLOSE(hmm.LogLikelihood(sequence), log(prob), 1e-5);
+}
+
 /**
  * A simple test to make sure HMMs with Gaussian output distributions work.
  */
@@ -952,5 +1093,250 @@ BOOST_AUTO_TEST_CASE(GMMHMMLabeledTrainingTest)
       gmms[1].Covariances()[1](1, 1), 0.3);
 }
 
+/**
+ * Make sure that multithreaded Baum-Welch training and the batched scoring
+ * functions give the same results as their single-threaded counterparts.
+ */
+BOOST_AUTO_TEST_CASE(GaussianHMMParallelTrainTest)
+{
+  HMM<GaussianDistribution> hmm(3, GaussianDistribution(2));
+  hmm.Transition() = arma::mat("0.4 0.6 0.8; 0.2 0.2 0.1; 0.4 0.2 0.1");
+  hmm.Emission()[0] = GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0");
+  hmm.Emission()[1] = GaussianDistribution("2.0 2.0", "1.0 0.5; 0.5 1.2");
+  hmm.Emission()[2] = GaussianDistribution("-2.0 1.0", "2.0 0.1; 0.1 1.0");
+
+  // Generate some sequences of differing lengths.
+  std::vector<arma::mat> observations(12);
+  std::vector<arma::Col<size_t> > states(12);
+  for (size_t i = 0; i < observations.size(); ++i)
+    hmm.Generate(100 + 37 * i, observations[i], states[i]);
+
+  HMM<GaussianDistribution> serial(3, GaussianDistribution(2));
+  HMM<GaussianDistribution> parallel(3, GaussianDistribution(2));
+  for (size_t i = 0; i < 3; ++i)
+  {
+    serial.Emission()[i] = hmm.Emission()[i];
+    parallel.Emission()[i] = hmm.Emission()[i];
+  }
+  parallel.Threads() = 4;
+
+  serial.Train(observations);
+  parallel.Train(observations);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_CLOSE(serial.Transition()(i, j),
+          parallel.Transition()(i, j), 1e-5);
+
+    for (size_t j = 0; j < 2; ++j)
+      BOOST_REQUIRE_CLOSE(serial.Emission()[i].Mean()[j],
+          parallel.Emission()[i].Mean()[j], 1e-5);
+  }
+
+  // Now check the batched scoring functions.
+  arma::vec logLikelihoods;
+  std::vector<arma::Col<size_t> > predictions;
+  arma::vec predictionLogLikelihoods;
+  parallel.LogLikelihood(observations, logLikelihoods);
+  parallel.Predict(observations, predictions, predictionLogLikelihoods);
+
+  BOOST_REQUIRE_EQUAL(logLikelihoods.n_elem, observations.size());
+  BOOST_REQUIRE_EQUAL(predictions.size(), observations.size());
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logLikelihoods[i],
+        serial.LogLikelihood(observations[i]), 1e-5);
+
+    arma::Col<size_t> prediction;
+    const double predictionLogLikelihood = serial.Predict(observations[i],
+        prediction);
+    BOOST_REQUIRE_CLOSE(predictionLogLikelihoods[i], predictionLogLikelihood,
+        1e-5);
+    BOOST_REQUIRE_EQUAL(predictions[i].n_elem, prediction.n_elem);
+    for (size_t j = 0; j < prediction.n_elem; ++j)
+      BOOST_REQUIRE_EQUAL(predictions[i][j], prediction[j]);
+  }
+}
+
+/**
+ * Train an HMM with GMM emissions, whose states are fit in parallel, twice
+ * from the same seed; both the single-sequence and multiple-sequence cases
+ * must give the same model each time.
+ */
+BOOST_AUTO_TEST_CASE(GMMHMMParallelEmissionTest)
+{
+  GMM<> gmm(2, 2);
+  gmm.Weights() = arma::vec("0.5 0.5");
+  gmm.Means()[0] = arma::vec("0.0 0.0");
+  gmm.Means()[1] = arma::vec("5.0 5.0");
+  gmm.Covariances()[0] = arma::eye<arma::mat>(2, 2);
+  gmm.Covariances()[1] = arma::eye<arma::mat>(2, 2);
+
+  HMM<GMM<> > hmm(3, gmm);
+  std::vector<arma::mat> observations(4);
+  std::vector<arma::Col<size_t> > states(4);
+  for (size_t i = 0; i < observations.size(); ++i)
+    hmm.Generate(200, observations[i], states[i]);
+
+  for (size_t sequences = 1; sequences <= 4; sequences += 3)
+  {
+    const std::vector<arma::mat> train(observations.begin(),
+        observations.begin() + sequences);
+
+    HMM<GMM<> > first(3, GMM<>(2, 2));
+    HMM<GMM<> > second(3, GMM<>(2, 2));
+    first.Threads() = 4;
+    second.Threads() = 4;
+
+    math::RandomSeed(7);
+    first.Train(train);
+    math::RandomSeed(7);
+    second.Train(train);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_EQUAL(first.Transition()(i, j),
+            second.Transition()(i, j));
+
+      for (size_t g = 0; g < 2; ++g)
+        for (size_t d = 0; d < 2; ++d)
+          BOOST_REQUIRE_EQUAL(first.Emission()[i].Means()[g][d],
+              second.Emission()[i].Means()[g][d]);
+    }
+  }
+}
+
+/**
+ * Make sure that the streaming filter gives the same log-likelihood and state
+ * probabilities as the batch forward algorithm.
+ */
+BOOST_AUTO_TEST_CASE(HMMFilterForwardTest)
+{
+  HMM<GaussianDistribution> hmm(3, GaussianDistribution(2));
+  hmm.Transition() = arma::mat("0.4 0.6 0.8; 0.2 0.2 0.1; 0.4 0.2 0.1");
+  hmm.Emission()[0] = GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0");
+  hmm.Emission()[1] = GaussianDistribution("2.0 2.0", "1.0 0.5; 0.5 1.2");
+  hmm.Emission()[2] = GaussianDistribution("-2.0 1.0", "2.0 0.1; 0.1 1.0");
+
+  arma::mat observations;
+  arma::Col<size_t> states;
+  hmm.Generate(500, observations, states);
+
+  HMMFilter<GaussianDistribution> filter(hmm);
+  for (size_t t = 0; t < observations.n_cols; ++t)
+  {
+    // With no lag, a state is decoded for every observation.
+    BOOST_REQUIRE(filter.Update(observations.col(t)));
+    BOOST_REQUIRE_EQUAL(filter.DecodedTime(), t);
+
+    // Check against the batch algorithm every so often.
+    if (t % 50 == 49)
+    {
+      const arma::mat prefix = observations.cols(0, t);
+      BOOST_REQUIRE_CLOSE(filter.LogLikelihood(), hmm.LogLikelihood(prefix),
+          1e-5);
+
+      // The last column of the state probabilities only depends on the
+      // forward probabilities.
+      arma::mat stateProb;
+      hmm.Estimate(prefix, stateProb);
+      for (size_t i = 0; i < 3; ++i)
+        BOOST_REQUIRE_CLOSE(filter.Posterior()[i], stateProb(i, t), 1e-5);
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(filter.Steps(), observations.n_cols);
+
+  filter.Reset();
+  BOOST_REQUIRE_EQUAL(filter.Steps(), 0);
+  BOOST_REQUIRE_EQUAL(filter.LogLikelihood(), 0.0);
+}
+
+/**
+ * With a lag at least as long as the sequence, the fixed-lag Viterbi decoder
+ * must find the most probable state sequence; check that against an exhaustive
+ * search over every possible sequence.  Shorter lags must decode each state
+ * exactly once, in order.
+ */
+BOOST_AUTO_TEST_CASE(HMMFilterFixedLagViterbiTest)
+{
+  arma::mat transition("0.5 0.2 0.3; 0.3 0.6 0.2; 0.2 0.2 0.5");
+  std::vector<DiscreteDistribution> emission(3);
+  emission[0] = DiscreteDistribution("0.6 0.3 0.1");
+  emission[1] = DiscreteDistribution("0.2 0.5 0.3");
+  emission[2] = DiscreteDistribution("0.1 0.2 0.7");
+
+  HMM<DiscreteDistribution> hmm(transition, emission);
+
+  arma::mat observations("0 1 2 2 1 0 2");
+  const size_t length = observations.n_cols;
+
+  // Exhaustive search over all 3^7 state sequences.
+  arma::Col<size_t> best(length);
+  double bestProb = -1.0;
+  arma::Col<size_t> candidate(length);
+  size_t combinations = 1;
+  for (size_t t = 0; t < length; ++t)
+    combinations *= 3;
+  for (size_t c = 0; c < combinations; ++c)
+  {
+    size_t code = c;
+    for (size_t t = 0; t < length; ++t)
+    {
+      candidate[t] = code % 3;
+      code /= 3;
+    }
+
+    double prob = 1.0;
+    for (size_t t = 0; t < length; ++t)
+    {
+      const size_t previous = (t == 0) ? 0 : candidate[t - 1];
+      prob *= transition(candidate[t], previous) *
+          emission[candidate[t]].Probability(observations.col(t));
+    }
+
+    if (prob > bestProb)
+    {
+      bestProb = prob;
+      best = candidate;
+    }
+  }
+
+  HMMFilter<DiscreteDistribution> filter(hmm, length);
+  for (size_t t = 0; t < length; ++t)
+    BOOST_REQUIRE(!filter.Update(observations.col(t)));
+
+  arma::Col<size_t> decoded;
+  filter.Flush(decoded);
+  BOOST_REQUIRE_EQUAL(decoded.n_elem, length);
+  for (size_t t = 0; t < length; ++t)
+    BOOST_REQUIRE_EQUAL(decoded[t], best[t]);
+
+  // A lag of 3: the first three updates decode nothing, then one state per
+  // update, then Flush() gives the last three.
+  HMMFilter<DiscreteDistribution> lagFilter(hmm, 3);
+  size_t decodedStates = 0;
+  for (size_t t = 0; t < length; ++t)
+  {
+    if (lagFilter.Update(observations.col(t)))
+    {
+      BOOST_REQUIRE_EQUAL(lagFilter.DecodedTime(), decodedStates);
+      BOOST_REQUIRE_LT(lagFilter.DecodedState(), 3);
+      ++decodedStates;
+    }
+  }
+  BOOST_REQUIRE_EQUAL(decodedStates, length - 3);
+
+  lagFilter.Flush(decoded);
+  BOOST_REQUIRE_EQUAL(decoded.n_elem, 3);
+
+  // The pending states are decoded from the most probable path through the
+  // last observation, so they must match the end of the full Viterbi path.
+  for (size_t t = 0; t < 3; ++t)
+    BOOST_REQUIRE_EQUAL(decoded[t], best[length - 3 + t]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
@@ -0,0 +1,115 @@
+/**
+ * @file kde_test.cpp
+ *
+ * Tests for the KDE class (kernel density estimation).
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/methods/kde/kde.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+
+BOOST_AUTO_TEST_SUITE(KDETest);
+
+// Compute the estimates by brute force.
+template<typename KernelType>
+arma::vec BruteForceKDE(const arma::mat& referenceData,
+                        const arma::mat& queryData,
+                        const KernelType& kernel)
+{
+  arma::vec estimates(queryData.n_cols);
+  for (size_t i = 0; i < queryData.n_cols; ++i)
+  {
+    double sum = 0.0;
+    for (size_t j = 0; j < referenceData.n_cols; ++j)
+      sum += kernel.Evaluate(metric::EuclideanDistance::Evaluate(
+          queryData.col(i), referenceData.col(j)));
+    estimates[i] = sum / referenceData.n_cols;
+  }
+
+  return estimates;
+}
+
+/**
+ * The tree-based estimates must be within the relative error of the exact
+ * estimates, in dual-tree and single-tree mode, with one or several threads;
+ * and naive mode must be exact.
+ */
+BOOST_AUTO_TEST_CASE(GaussianKDEVsBruteForce)
+{
+  math::RandomSeed(0);
+
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 500);
+  GaussianKernel kernel(0.1);
+
+  const arma::vec exact = BruteForceKDE(referenceData, queryData, kernel);
+
+  KDE<> naive(referenceData, queryData, kernel, true);
+  arma::vec estimates;
+  naive.Evaluate(estimates);
+  for (size_t i = 0; i < exact.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(estimates[i], exact[i], 1e-8);
+
+  for (size_t run = 0; run < 4; ++run)
+  {
+    KDE<> kde(referenceData, queryData, kernel, false, (run % 2 == 1));
+    kde.RelativeError() = 0.01;
+    kde.Threads() = (run < 2) ? 1 : 4;
+    kde.Evaluate(estimates);
+
+    BOOST_REQUIRE_EQUAL(estimates.n_elem, queryData.n_cols);
+    for (size_t i = 0; i < exact.n_elem; ++i)
+      BOOST_REQUIRE_LE(std::abs(estimates[i] - exact[i]), 0.01 * exact[i] +
+          1e-12);
+  }
+}
+
+/**
+ * With one dataset, each point contributes to its own estimate; with no error
+ * allowed, the Epanechnikov kernel (which is zero beyond the bandwidth) is
+ * estimated exactly, while nodes further than the bandwidth are still pruned.
+ */
+BOOST_AUTO_TEST_CASE(MonochromaticEpanechnikovKDE)
+{
+  math::RandomSeed(0);
+
+  arma::mat data = arma::randu<arma::mat>(2, 1500);
+  EpanechnikovKernel kernel(0.05);
+
+  const arma::vec exact = BruteForceKDE(data, data, kernel);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    KDE<EpanechnikovKernel> kde(data, kernel, false, (mode == 1));
+    kde.RelativeError() = 0.0;
+    arma::vec estimates;
+    kde.Evaluate(estimates);
+
+    for (size_t i = 0; i < exact.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(estimates[i], exact[i], 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -100,4 +100,188 @@ BOOST_AUTO_TEST_CASE(CircleTransformationTest)
   BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
 }
 
+/**
+ * When every point is a landmark, the Nystroem approximation is exact, so it
+ * should give the same results as the exact kernel matrix.
+ */
+BOOST_AUTO_TEST_CASE(NystroemAllLandmarksTest)
+{
+  arma::mat dataset = arma::randn<arma::mat>(3, 100);
+
+  KernelPCA<GaussianKernel> exact(GaussianKernel(2.0));
+  arma::mat exactData;
+  arma::vec exactEigval;
+  exact.Apply(dataset, exactData, exactEigval);
+
+  KernelPCA<GaussianKernel, NystroemKernelRule> nystroem(GaussianKernel(2.0),
+      false, NystroemKernelRule(100));
+  arma::mat nystroemData;
+  arma::vec nystroemEigval;
+  nystroem.Apply(dataset, nystroemData, nystroemEigval);
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(nystroemEigval[i], exactEigval[i], 1e-4);
+
+    // The components may point in opposite directions.
+    const double sign = (dot(nystroemData.row(i), exactData.row(i)) < 0) ?
+        -1.0 : 1.0;
+    for (size_t j = 0; j < 100; ++j)
+      BOOST_REQUIRE_SMALL(sign * nystroemData(i, j) - exactData(i, j), 1e-6);
+  }
+}
+
+/**
+ * With many random Fourier features, the leading eigenvalues should be close to
+ * those of the exact kernel matrix.
+ */
+BOOST_AUTO_TEST_CASE(RandomFourierEigenvaluesTest)
+{
+  arma::mat dataset = arma::randn<arma::mat>(2, 200);
+
+  KernelPCA<GaussianKernel> exact(GaussianKernel(1.0));
+  arma::mat exactData;
+  arma::vec exactEigval;
+  exact.Apply(dataset, exactData, exactEigval);
+
+  KernelPCA<GaussianKernel, RandomFourierKernelRule> fourier(
+      GaussianKernel(1.0), false, RandomFourierKernelRule(5000));
+  arma::mat fourierData;
+  arma::vec fourierEigval;
+  fourier.Apply(dataset, fourierData, fourierEigval);
+
+  BOOST_REQUIRE_EQUAL(fourierData.n_rows, 5000);
+  BOOST_REQUIRE_EQUAL(fourierData.n_cols, 200);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(fourierEigval[i], exactEigval[i], 10.0);
+}
+
+/**
+ * The Nystroem approximation with a subset of the points as landmarks should
+ * still separate the circles of CircleTransformationTest.
+ */
+BOOST_AUTO_TEST_CASE(NystroemCircleTransformationTest)
+{
+  arma::mat dataset;
+  dataset.randn(3, 750);
+  dataset *= 0.05;
+
+  // Spread the second and third sets of 250 points out to radii 2 and 5.
+  for (size_t i = 250; i < 750; ++i)
+  {
+    const double radius = (i < 500) ? 2.0 : 5.0;
+    dataset.col(i) += radius * dataset.col(i) / norm(dataset.col(i), 2);
+  }
+
+  KernelPCA<GaussianKernel, NystroemKernelRule> p(GaussianKernel(), false,
+      NystroemKernelRule(200));
+  p.Apply(dataset, 1);
+
+  BOOST_REQUIRE_EQUAL(dataset.n_rows, 1);
+
+  Range ranges[3];
+  for (size_t i = 0; i < 750; ++i)
+    ranges[i / 250] |= dataset(0, i);
+
+  BOOST_REQUIRE_EQUAL(ranges[0].Contains(ranges[1]), false);
+  BOOST_REQUIRE_EQUAL(ranges[0].Contains(ranges[2]), false);
+  BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
+}
+
+//! Fit the given KernelPCA object on the dataset, and make sure that
+//! transforming the dataset afterwards gives the same result.
+template<typename KPCAType>
+void CheckTransform(KPCAType& kpca, const arma::mat& dataset)
+{
+  arma::mat transformedData;
+  arma::vec eigval;
+  kpca.Fit(dataset, transformedData, eigval, 3);
+  BOOST_REQUIRE_EQUAL(transformedData.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(transformedData.n_cols, dataset.n_cols);
+
+  arma::mat transformedPoints;
+  kpca.Transform(dataset, transformedPoints);
+  BOOST_REQUIRE_EQUAL(transformedPoints.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(transformedPoints.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < transformedData.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(transformedPoints[i] - transformedData[i], 1e-6);
+}
+
+/**
+ * After Fit(), Transform() on the training points should give the transformed
+ * data, for each kernel rule, with and without centering; and Fit() should
+ * transform the data as Apply() does.
+ */
+BOOST_AUTO_TEST_CASE(FitTransformTest)
+{
+  arma::mat dataset = arma::randn<arma::mat>(3, 150);
+
+  for (size_t center = 0; center < 2; ++center)
+  {
+    KernelPCA<GaussianKernel> naive(GaussianKernel(2.0), center == 1);
+    CheckTransform(naive, dataset);
+
+    KernelPCA<GaussianKernel, NystroemKernelRule> nystroem(GaussianKernel(2.0),
+        center == 1, NystroemKernelRule(50));
+    CheckTransform(nystroem, dataset);
+    BOOST_REQUIRE_EQUAL(nystroem.Rule().LandmarkPoints().n_cols, 50);
+    BOOST_REQUIRE_EQUAL(nystroem.Rule().Projection().n_cols, 50);
+
+    KernelPCA<GaussianKernel, RandomFourierKernelRule> fourier(
+        GaussianKernel(2.0), center == 1, RandomFourierKernelRule(200));
+    CheckTransform(fourier, dataset);
+  }
+
+  KernelPCA<GaussianKernel> kpca(GaussianKernel(2.0), true);
+  arma::mat fitData;
+  arma::vec fitEigval;
+  kpca.Fit(dataset, fitData, fitEigval, 2);
+
+  arma::mat applyData(dataset);
+  kpca.Apply(applyData, 2);
+  for (size_t i = 0; i < fitData.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(fitData[i] - applyData[i], 1e-6);
+
+  // Points very close to training points are projected very close to them.
+  arma::mat newPoints = dataset.cols(0, 9) + 1e-8;
+  arma::mat transformedPoints;
+  kpca.Transform(newPoints, transformedPoints);
+  for (size_t i = 0; i < transformedPoints.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(transformedPoints[i] - fitData[i], 1e-5);
+}
+
+/**
+ * Make sure that finding only the first components of the kernel matrix gives
+ * the same transformed data as the full eigendecomposition, up to sign.
+ */
+BOOST_AUTO_TEST_CASE(PartialEigendecompositionTest)
+{
+  arma::mat dataset = arma::randn<arma::mat>(3, 200);
+
+  KernelPCA<GaussianKernel> full(GaussianKernel(2.0));
+  arma::mat fullData;
+  arma::vec fullEigval;
+  arma::mat fullEigvec;
+  full.Apply(dataset, fullData, fullEigval, fullEigvec);
+
+  KernelPCA<GaussianKernel> partial(GaussianKernel(2.0), false,
+      NaiveKernelRule(1, false, 3));
+  arma::mat partialData;
+  arma::vec partialEigval;
+  arma::mat partialEigvec;
+  partial.Apply(dataset, partialData, partialEigval, partialEigvec);
+
+  BOOST_REQUIRE_EQUAL(partialData.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(partialData.n_cols, 200);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(partialEigval[i], fullEigval[i], 1e-5);
+
+    const double sign = (dot(partialData.row(i), fullData.row(i)) < 0) ?
+        -1.0 : 1.0;
+    for (size_t j = 0; j < 200; ++j)
+      BOOST_REQUIRE_SMALL(sign * partialData(i, j) - fullData(i, j), 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
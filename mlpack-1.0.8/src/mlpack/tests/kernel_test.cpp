@@ -20,6 +20,7 @@
  * You should have received a copy of the GNU General Public License along with
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <mlpack/core/kernels/cached_kernel.hpp>
 #include <mlpack/core/kernels/cosine_distance.hpp>
 #include <mlpack/core/kernels/epanechnikov_kernel.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
@@ -30,6 +31,7 @@
 #include <mlpack/core/kernels/polynomial_kernel.hpp>
 #include <mlpack/core/kernels/spherical_kernel.hpp>
 #include <mlpack/core/kernels/pspectrum_string_kernel.hpp>
+#include <mlpack/core/kernels/kernel_matrix.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/metrics/mahalanobis_distance.hpp>
 
@@ -605,4 +607,176 @@ BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
   BOOST_REQUIRE_CLOSE(p.Evaluate(b, a), 11.0, 1e-5);
 }
 
+// The spectra should give the same kernel values as counting the substrings
+// in maps, both for substrings which are numbered exactly and for long
+// substrings which are hashed.
+BOOST_AUTO_TEST_CASE(PSpectrumStringSpectraTest)
+{
+  std::vector<std::vector<std::string> > dataset;
+  dataset.push_back(std::vector<std::string>());
+  dataset[0].push_back("flippydopflip");
+  dataset[0].push_back("Stupid fricking cat, stupid fricking dog");
+  dataset[0].push_back("obloblobloblobloblobloblob");
+  dataset[0].push_back("leave me alone until 6:00 stupidfricking cat");
+
+  const size_t ps[] = { 1, 3, 12, 14 };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    PSpectrumStringKernel p(dataset, ps[i]);
+
+    for (size_t a = 0; a < dataset[0].size(); ++a)
+    {
+      for (size_t b = 0; b < dataset[0].size(); ++b)
+      {
+        const std::map<std::string, int>& aMap = p.Counts()[0][a];
+        const std::map<std::string, int>& bMap = p.Counts()[0][b];
+
+        double expected = 0.0;
+        std::map<std::string, int>::const_iterator it;
+        for (it = aMap.begin(); it != aMap.end(); ++it)
+          if (bMap.count(it->first))
+            expected += it->second * bMap.find(it->first)->second;
+
+        arma::vec x(2), y(2);
+        x[0] = 0;
+        x[1] = a;
+        y[0] = 0;
+        y[1] = b;
+        BOOST_REQUIRE_CLOSE(p.Evaluate(x, y) + 1.0, expected + 1.0, 1e-5);
+        BOOST_REQUIRE_EQUAL(p.Spectra()[0][a].size(), aMap.size());
+      }
+    }
+  }
+}
+
+/**
+ * Make sure the kernel matrices built in blocks match the kernels evaluated
+ * pair by pair, both for one dataset (which spans several blocks) and between
+ * two datasets.
+ */
+template<typename KernelType>
+void CheckKernelMatrix(KernelType& kernel, const size_t threads)
+{
+  arma::mat a(3, 600);
+  a.randn();
+  a.col(17).zeros(); // For the cosine distance.
+  arma::mat b(3, 300);
+  b.randn();
+
+  arma::mat kernelMatrix;
+  KernelMatrix(kernel, a, kernelMatrix, threads);
+  BOOST_REQUIRE_EQUAL(kernelMatrix.n_rows, 600);
+  BOOST_REQUIRE_EQUAL(kernelMatrix.n_cols, 600);
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    for (size_t j = i; j < a.n_cols; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(kernelMatrix(i, j), kernelMatrix(j, i));
+
+      const double eval = kernel.Evaluate(a.unsafe_col(i), a.unsafe_col(j));
+      if (std::abs(eval) < 1e-10)
+        BOOST_REQUIRE_SMALL(kernelMatrix(i, j), 1e-7);
+      else
+        BOOST_REQUIRE_CLOSE(kernelMatrix(i, j), eval, 1e-5);
+    }
+  }
+
+  KernelMatrix(kernel, a, b, kernelMatrix, threads);
+  BOOST_REQUIRE_EQUAL(kernelMatrix.n_rows, 600);
+  BOOST_REQUIRE_EQUAL(kernelMatrix.n_cols, 300);
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    for (size_t j = 0; j < b.n_cols; ++j)
+    {
+      const double eval = kernel.Evaluate(a.unsafe_col(i), b.unsafe_col(j));
+      if (std::abs(eval) < 1e-10)
+        BOOST_REQUIRE_SMALL(kernelMatrix(i, j), 1e-7);
+      else
+        BOOST_REQUIRE_CLOSE(kernelMatrix(i, j), eval, 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(KernelMatrixTest)
+{
+  LinearKernel lk;
+  CheckKernelMatrix(lk, 1);
+
+  PolynomialKernel pk(2.0, 1.0);
+  CheckKernelMatrix(pk, 2);
+
+  HyperbolicTangentKernel hk(0.5, 0.1);
+  CheckKernelMatrix(hk, 1);
+
+  GaussianKernel gk(1.5);
+  CheckKernelMatrix(gk, 2);
+
+  LaplacianKernel lpk(2.0);
+  CheckKernelMatrix(lpk, 0);
+
+  CosineDistance cd;
+  CheckKernelMatrix(cd, 2);
+
+  // Kernels without a specialized block are evaluated pair by pair.
+  EpanechnikovKernel ek(2.5);
+  CheckKernelMatrix(ek, 2);
+}
+
+/**
+ * The cached kernel must return the values of the wrapped kernel, count its
+ * hits and misses, stay within its capacity, and not cache points which are not
+ * in its datasets.
+ */
+BOOST_AUTO_TEST_CASE(CachedKernelTest)
+{
+  arma::mat data = arma::randu<arma::mat>(10, 50);
+  arma::mat queries = arma::randu<arma::mat>(10, 5);
+  GaussianKernel gk(0.7);
+
+  CachedKernel<GaussianKernel> ck(data, 100, gk, 4);
+  ck.AddDataset(queries);
+  BOOST_REQUIRE_EQUAL(ck.Shards(), 4);
+  BOOST_REQUIRE_EQUAL(KernelTraits<CachedKernel<GaussianKernel> >::IsNormalized,
+      true);
+
+  // The first evaluation of each pair is a miss, and the second (in either
+  // order) is a hit.
+  for (size_t i = 0; i < 5; ++i)
+  {
+    for (size_t j = 0; j < 5; ++j)
+    {
+      const double expected = gk.Evaluate(queries.unsafe_col(i),
+          data.unsafe_col(j));
+      BOOST_REQUIRE_CLOSE(ck.Evaluate(queries.unsafe_col(i),
+          data.unsafe_col(j)), expected, 1e-10);
+      BOOST_REQUIRE_CLOSE(ck.Evaluate(data.unsafe_col(j),
+          queries.unsafe_col(i)), expected, 1e-10);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(ck.Misses(), 25);
+  BOOST_REQUIRE_EQUAL(ck.Hits(), 25);
+  BOOST_REQUIRE_EQUAL(ck.Size(), 25);
+
+  // Points which are not columns of the datasets are not cached.
+  const arma::vec copy = data.col(0);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(copy, data.unsafe_col(1)),
+      gk.Evaluate(copy, data.unsafe_col(1)), 1e-10);
+  BOOST_REQUIRE_EQUAL(ck.Misses() + ck.Hits(), 50);
+
+  // Many more pairs than the capacity must not grow the cache beyond it.
+  for (size_t i = 0; i < 50; ++i)
+    for (size_t j = 0; j < 50; ++j)
+      ck.Evaluate(data.unsafe_col(i), data.unsafe_col(j));
+  BOOST_REQUIRE_LE(ck.Size(), 100);
+
+  // A copy has an empty cache.
+  CachedKernel<GaussianKernel> copyKernel(ck);
+  BOOST_REQUIRE_EQUAL(copyKernel.Size(), 0);
+  BOOST_REQUIRE_EQUAL(copyKernel.Hits(), 0);
+
+  ck.Clear();
+  BOOST_REQUIRE_EQUAL(ck.Size(), 0);
+  BOOST_REQUIRE_EQUAL(ck.Misses(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -22,9 +22,20 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 #include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel_start.hpp>
+#include <mlpack/methods/kmeans/hamerly_assignment.hpp>
+#include <mlpack/methods/kmeans/dual_tree_assignment.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/spherical_kmeans.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
+#include "thread_communicator.hpp"
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -133,6 +144,319 @@ BOOST_AUTO_TEST_CASE(KMeansOverclusteringTest)
     BOOST_REQUIRE_EQUAL(assignments(i), thirdClass);
 }
 
+/**
+ * Make sure that clustering with several threads gives the same result as
+ * clustering with one thread, when started from the same assignments.
+ */
+BOOST_AUTO_TEST_CASE(KMeansThreadsTest)
+{
+  arma::mat data(3, 2000);
+  data.randu();
+
+  arma::Col<size_t> assignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 8;
+  arma::Col<size_t> threadedAssignments(assignments);
+
+  KMeans<> kmeans;
+  arma::mat centroids;
+  kmeans.Cluster(data, 8, assignments, centroids, true);
+
+  KMeans<> threadedKMeans;
+  threadedKMeans.Threads() = 4;
+  BOOST_REQUIRE_EQUAL(threadedKMeans.Threads(), 4);
+  arma::mat threadedCentroids;
+  threadedKMeans.Cluster(data, 8, threadedAssignments, threadedCentroids,
+      true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], threadedAssignments[i]);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], threadedCentroids[i], 1e-5);
+}
+
+/**
+ * Restarts run at once should give the same clustering after the same seed,
+ * and find the clusters of the test dataset.
+ */
+BOOST_AUTO_TEST_CASE(KMeansRestartsTest)
+{
+  KMeans<> kmeans;
+  BOOST_REQUIRE_EQUAL(kmeans.Restarts(), 1);
+  kmeans.Restarts() = 8;
+  kmeans.Threads() = 4;
+
+  arma::mat data = arma::randu<arma::mat>(3, 2000);
+  arma::Col<size_t> first;
+  arma::mat firstCentroids;
+  math::RandomSeed(5);
+  kmeans.Cluster(data, 8, first, firstCentroids);
+
+  arma::Col<size_t> second;
+  arma::mat secondCentroids;
+  math::RandomSeed(5);
+  kmeans.Cluster(data, 8, second, secondCentroids);
+
+  BOOST_REQUIRE_EQUAL(first.n_elem, data.n_cols);
+  for (size_t i = 0; i < first.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(first[i], second[i]);
+  for (size_t i = 0; i < firstCentroids.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(firstCentroids[i], secondCentroids[i]);
+
+  // The same goes for the restarts of FastCluster().
+  math::RandomSeed(5);
+  kmeans.FastCluster(data, 8, first, firstCentroids);
+  math::RandomSeed(5);
+  kmeans.FastCluster(data, 8, second, secondCentroids);
+  for (size_t i = 0; i < first.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(first[i], second[i]);
+
+  arma::Col<size_t> assignments;
+  kmeans.Cluster((arma::mat) trans(kMeansData), 3, assignments);
+
+  // The first 13 points should be in one cluster, the next 7 in another, and
+  // the last 10 in the third.
+  for (size_t i = 1; i < 13; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[0]);
+  for (size_t i = 14; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[13]);
+  for (size_t i = 21; i < 30; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[20]);
+  BOOST_REQUIRE_NE(assignments[0], assignments[13]);
+  BOOST_REQUIRE_NE(assignments[0], assignments[20]);
+  BOOST_REQUIRE_NE(assignments[13], assignments[20]);
+}
+
+/**
+ * Make sure that Hamerly's assignment step gives the same clustering as the
+ * naive assignment step, when started from the same assignments.
+ */
+BOOST_AUTO_TEST_CASE(HamerlyAssignmentTest)
+{
+  arma::mat data(4, 3000);
+  data.randu();
+
+  arma::Col<size_t> assignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 20;
+  arma::Col<size_t> hamerlyAssignments(assignments);
+
+  KMeans<> kmeans;
+  arma::mat centroids;
+  kmeans.Cluster(data, 20, assignments, centroids, true);
+
+  KMeans<metric::SquaredEuclideanDistance, RandomPartition,
+      MaxVarianceNewCluster, HamerlyAssignment> hamerly;
+  arma::mat hamerlyCentroids;
+  hamerly.Cluster(data, 20, hamerlyAssignments, hamerlyCentroids, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], hamerlyAssignments[i]);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], hamerlyCentroids[i], 1e-5);
+
+  // The Manhattan distance is a true metric, so it is used directly.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 20;
+  hamerlyAssignments = assignments;
+
+  KMeans<metric::ManhattanDistance> manhattan;
+  manhattan.Cluster(data, 20, assignments, centroids, true);
+
+  KMeans<metric::ManhattanDistance, RandomPartition, MaxVarianceNewCluster,
+      HamerlyAssignment> manhattanHamerly;
+  manhattanHamerly.Cluster(data, 20, hamerlyAssignments, hamerlyCentroids,
+      true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], hamerlyAssignments[i]);
+}
+
+/**
+ * Make sure that the dual-tree assignment step gives the same clustering as the
+ * naive assignment step, with many clusters, when started from the same
+ * assignments.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeAssignmentTest)
+{
+  arma::mat data(2, 5000);
+  data.randu();
+
+  arma::Col<size_t> assignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 200;
+  arma::Col<size_t> dualTreeAssignments(assignments);
+
+  KMeans<> kmeans(20);
+  arma::mat centroids;
+  kmeans.Cluster(data, 200, assignments, centroids, true);
+
+  KMeans<metric::SquaredEuclideanDistance, RandomPartition,
+      MaxVarianceNewCluster, DualTreeAssignment> dualTree(20);
+  arma::mat dualTreeCentroids;
+  dualTree.Cluster(data, 200, dualTreeAssignments, dualTreeCentroids, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], dualTreeAssignments[i]);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], dualTreeCentroids[i], 1e-5);
+
+  // The Euclidean distance gives the same nearest centroids; a single cluster
+  // owns every point.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 20;
+  dualTreeAssignments = assignments;
+
+  KMeans<metric::EuclideanDistance> euclidean(20);
+  euclidean.Cluster(data, 20, assignments, centroids, true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      DualTreeAssignment> euclideanDualTree(20);
+  euclideanDualTree.Cluster(data, 20, dualTreeAssignments, dualTreeCentroids,
+      true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], dualTreeAssignments[i]);
+
+  dualTreeAssignments.zeros();
+  euclideanDualTree.Cluster(data, 1, dualTreeAssignments, dualTreeCentroids,
+      true);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(dualTreeAssignments[i], (size_t) 0);
+}
+
+/**
+ * Make sure that the Pelleg-Moore algorithm gives the same clustering as the
+ * naive algorithm, when started from the same assignments.
+ */
+BOOST_AUTO_TEST_CASE(PellegMooreKMeansTest)
+{
+  arma::mat data(2, 5000);
+  data.randu();
+
+  arma::Col<size_t> assignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 15;
+  arma::Col<size_t> fastAssignments(assignments);
+
+  KMeans<> kmeans;
+  arma::mat centroids;
+  kmeans.Cluster(data, 15, assignments, centroids, true);
+
+  arma::mat fastCentroids;
+  kmeans.FastCluster(data, 15, fastAssignments, fastCentroids, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], fastAssignments[i]);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], fastCentroids[i], 1e-5);
+
+  // The 30-point dataset should also be clustered correctly.
+  arma::mat points = trans(kMeansData);
+  kmeans.FastCluster(points, 3, fastAssignments);
+
+  for (size_t i = 1; i < 13; i++)
+    BOOST_REQUIRE_EQUAL(fastAssignments(i), fastAssignments(0));
+  for (size_t i = 14; i < 20; i++)
+    BOOST_REQUIRE_EQUAL(fastAssignments(i), fastAssignments(13));
+  for (size_t i = 21; i < 30; i++)
+    BOOST_REQUIRE_EQUAL(fastAssignments(i), fastAssignments(20));
+
+  BOOST_REQUIRE_NE(fastAssignments(0), fastAssignments(13));
+  BOOST_REQUIRE_NE(fastAssignments(0), fastAssignments(20));
+  BOOST_REQUIRE_NE(fastAssignments(13), fastAssignments(20));
+}
+
+/**
+ * Make sure mini-batch K-Means finds three well-separated clusters.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchKMeansTest)
+{
+  // Three clusters around (0, 0), (10, 10) and (-10, 5).
+  arma::mat data(2, 3000);
+  data.randn();
+  data *= 0.5;
+  data.cols(1000, 1999).each_col() += arma::vec("10 10");
+  data.cols(2000, 2999).each_col() += arma::vec("-10 5");
+
+  // Start with one point from each cluster.
+  arma::mat centroids(2, 3);
+  centroids.col(0) = data.col(0);
+  centroids.col(1) = data.col(1000);
+  centroids.col(2) = data.col(2000);
+
+  MiniBatchKMeans<> kmeans(100, 500);
+  BOOST_REQUIRE_EQUAL(kmeans.BatchSize(), 100);
+  BOOST_REQUIRE_EQUAL(kmeans.MaxIterations(), 500);
+
+  arma::Col<size_t> assignments;
+  kmeans.Cluster(data, 3, assignments, centroids, true);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], i / 1000);
+
+  BOOST_REQUIRE_SMALL(centroids(0, 0), 0.1);
+  BOOST_REQUIRE_SMALL(centroids(1, 0), 0.1);
+  BOOST_REQUIRE_CLOSE(centroids(0, 1), 10.0, 1.0);
+  BOOST_REQUIRE_CLOSE(centroids(1, 1), 10.0, 1.0);
+  BOOST_REQUIRE_CLOSE(centroids(0, 2), -10.0, 1.0);
+  BOOST_REQUIRE_CLOSE(centroids(1, 2), 5.0, 2.0);
+}
+
+/**
+ * Make sure FileBatchSource reads points in order, and wraps around (or not)
+ * at the end of the file.
+ */
+BOOST_AUTO_TEST_CASE(FileBatchSourceTest)
+{
+  std::fstream f;
+  f.open("test_batch_source.csv", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f << std::endl;
+  f << "4\t5\t6" << std::endl;
+  f << "7 8 9" << std::endl;
+  f.close();
+
+  FileBatchSource source("test_batch_source.csv");
+  BOOST_REQUIRE_EQUAL(source.Dimensionality(), 3);
+
+  arma::mat batch;
+  BOOST_REQUIRE_EQUAL(source.NextBatch(batch, 2), 2);
+  BOOST_REQUIRE_EQUAL(batch.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(batch.n_cols, 2);
+  BOOST_REQUIRE_CLOSE(batch(0, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(batch(2, 0), 3.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(batch(1, 1), 5.0, 1e-5);
+
+  // This batch wraps around to the beginning of the file.
+  BOOST_REQUIRE_EQUAL(source.NextBatch(batch, 2), 2);
+  BOOST_REQUIRE_CLOSE(batch(0, 0), 7.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(batch(0, 1), 1.0, 1e-5);
+
+  // Without wrapping, the last batch is short, and then there are no more.
+  source.Wrap() = false;
+  source.Reset();
+  BOOST_REQUIRE_EQUAL(source.NextBatch(batch, 2), 2);
+  BOOST_REQUIRE_EQUAL(source.NextBatch(batch, 2), 1);
+  BOOST_REQUIRE_EQUAL(batch.n_cols, 1);
+  BOOST_REQUIRE_CLOSE(batch(2, 0), 9.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(source.NextBatch(batch, 2), 0);
+
+  // Mini-batch K-Means can use the file directly.
+  source.Wrap() = true;
+  MiniBatchKMeans<> kmeans(2, 10);
+  arma::mat centroids;
+  kmeans.Cluster(source, 3, centroids);
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 3);
+
+  remove("test_batch_source.csv");
+}
+
 /**
  * Make sure the empty cluster policy class does nothing.
  */
@@ -459,6 +783,158 @@ BOOST_AUTO_TEST_CASE(RefinedStartTest)
   BOOST_REQUIRE_LT(distortion, 14000.0);
 }
 
+/**
+ * Make sure that K-Means started with k-means++ and with k-means|| finds the
+ * three classes of the 30-point test case.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusTest)
+{
+  const arma::mat data = trans(kMeansData);
+
+  KMeans<metric::SquaredEuclideanDistance, KMeansPlusPlus> plusPlus;
+  KMeans<metric::SquaredEuclideanDistance, KMeansParallelStart> parallel(1000,
+      1.0, metric::SquaredEuclideanDistance(), KMeansParallelStart(2.0, 5, 2));
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    arma::Col<size_t> assignments;
+    if (trial == 0)
+      plusPlus.Cluster(data, 3, assignments);
+    else
+      parallel.Cluster(data, 3, assignments);
+
+    BOOST_REQUIRE_EQUAL(assignments.n_elem, 30);
+
+    for (size_t i = 1; i < 13; i++)
+      BOOST_REQUIRE_EQUAL(assignments(i), assignments(0));
+    for (size_t i = 14; i < 20; i++)
+      BOOST_REQUIRE_EQUAL(assignments(i), assignments(13));
+    for (size_t i = 21; i < 30; i++)
+      BOOST_REQUIRE_EQUAL(assignments(i), assignments(20));
+
+    BOOST_REQUIRE_NE(assignments(0), assignments(13));
+    BOOST_REQUIRE_NE(assignments(0), assignments(20));
+    BOOST_REQUIRE_NE(assignments(13), assignments(20));
+  }
+}
+
+/**
+ * Make sure that weighted k-means++ never chooses points with zero weight, and
+ * that the k-means|| partition is valid and uses every cluster on
+ * well-separated data.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelStartTest)
+{
+  const arma::mat data = trans(kMeansData);
+
+  // Only the points of the second class have weight.
+  arma::vec weights(30);
+  weights.zeros();
+  weights.subvec(13, 19).ones();
+
+  KMeansPlusPlus plusPlus;
+  arma::mat centroids;
+  arma::Col<size_t> assignments;
+  plusPlus.Seed(data, weights, 3, centroids, assignments);
+
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 3);
+  for (size_t c = 0; c < 3; ++c)
+  {
+    bool found = false;
+    for (size_t i = 13; i < 20; ++i)
+      if (arma::accu(arma::abs(centroids.col(c) - data.col(i))) == 0.0)
+        found = true;
+    BOOST_REQUIRE(found);
+  }
+
+  // Three Gaussians far apart from each other.
+  arma::mat points(2, 3000);
+  points.randn();
+  points.cols(1000, 1999).row(0) += 50.0;
+  points.cols(2000, 2999).row(1) += 50.0;
+
+  KMeansParallelStart parallel(2.0, 5, 0);
+  BOOST_REQUIRE_EQUAL(parallel.Threads(), 0);
+  parallel.Cluster(points, 3, assignments);
+
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, 3000);
+  arma::Col<size_t> counts(3);
+  counts.zeros();
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(assignments[i], 3);
+    ++counts[assignments[i]];
+  }
+
+  for (size_t c = 0; c < 3; ++c)
+    BOOST_REQUIRE_EQUAL(counts[c], 1000);
+}
+
+//! Make points in three directions, of random lengths and with a little noise,
+//! in 50 dimensions (each direction has its own 5 nonzero dimensions).
+void DirectionalData(arma::mat& data)
+{
+  data.zeros(50, 300);
+  for (size_t i = 0; i < 300; ++i)
+  {
+    const size_t direction = i / 100;
+    const double length = 1.0 + 99.0 * math::Random();
+    for (size_t d = 0; d < 5; ++d)
+      data(10 * direction + d, i) = length * (1.0 + 0.1 * math::Random());
+  }
+}
+
+/**
+ * Spherical k-means should find the three directions of the points, whatever
+ * their lengths, with unit length centroids, and with any number of threads.
+ */
+BOOST_AUTO_TEST_CASE(SphericalKMeansTest)
+{
+  arma::mat data;
+  DirectionalData(data);
+
+  // One point of each direction starts the clustering.
+  arma::mat initialCentroids(50, 3);
+  for (size_t c = 0; c < 3; ++c)
+    initialCentroids.col(c) = data.col(100 * c);
+
+  arma::Col<size_t> assignments;
+  arma::mat centroids = initialCentroids;
+  SphericalKMeans k;
+  k.Cluster(data, 3, assignments, centroids, true);
+
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, 300);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], i / 100);
+
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 50);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 3);
+  for (size_t c = 0; c < 3; ++c)
+    BOOST_REQUIRE_CLOSE(arma::norm(centroids.col(c), 2), 1.0, 1e-8);
+
+  // Assign() agrees with the clustering.
+  arma::Col<size_t> assigned;
+  k.Assign(data, centroids, assigned);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(assigned[i], assignments[i]);
+
+  // The clustering does not depend on the number of threads.
+  k.Threads() = 4;
+  arma::Col<size_t> threadedAssignments;
+  arma::mat threadedCentroids = initialCentroids;
+  k.Cluster(data, 3, threadedAssignments, threadedCentroids, true);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(threadedAssignments[i], assignments[i]);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(threadedCentroids[i] + 1.0, centroids[i] + 1.0, 1e-8);
+
+  // Random initial centroids give a valid clustering.
+  k.Cluster(data, 3, assignments);
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, 300);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_LT(assignments[i], 3);
+}
+
 #ifdef ARMA_HAS_SPMAT
 // Can't do this test on Armadillo 3.4; var(SpBase) is not implemented.
 #if !((ARMA_VERSION_MAJOR == 3) && (ARMA_VERSION_MINOR == 4))
@@ -506,7 +982,212 @@ BOOST_AUTO_TEST_CASE(SparseKMeansTest)
   BOOST_REQUIRE_EQUAL(assignments[11], clusterTwo);
 }
 
+/**
+ * KMeans on a sparse matrix should give the same clustering as on the same
+ * points in a dense matrix.
+ */
+BOOST_AUTO_TEST_CASE(SparseDenseKMeansTest)
+{
+  arma::mat dense;
+  DirectionalData(dense);
+  const arma::sp_mat data(dense);
+
+  arma::Col<size_t> initialAssignments(300);
+  for (size_t i = 0; i < 300; ++i)
+    initialAssignments[i] = i % 3;
+
+  KMeans<> kmeans;
+  arma::Col<size_t> assignments = initialAssignments;
+  arma::sp_mat centroids;
+  kmeans.Cluster(data, 3, assignments, centroids, true);
+
+  arma::Col<size_t> denseAssignments = initialAssignments;
+  arma::mat denseCentroids;
+  kmeans.Cluster(dense, 3, denseAssignments, denseCentroids, true);
+
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], denseAssignments[i]);
+
+  const arma::mat sparseCentroids(centroids);
+  for (size_t i = 0; i < denseCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(sparseCentroids[i] + 1.0, denseCentroids[i] + 1.0,
+        1e-8);
+}
+
+/**
+ * Spherical k-means on a sparse matrix should give the same clustering as on
+ * the same points in a dense matrix.
+ */
+BOOST_AUTO_TEST_CASE(SparseSphericalKMeansTest)
+{
+  arma::mat dense;
+  DirectionalData(dense);
+  const arma::sp_mat data(dense);
+
+  arma::mat initialCentroids(50, 3);
+  for (size_t c = 0; c < 3; ++c)
+    initialCentroids.col(c) = dense.col(100 * c + 1);
+
+  SphericalKMeans k(1000, 4);
+  arma::Col<size_t> assignments;
+  arma::mat centroids = initialCentroids;
+  k.Cluster(data, 3, assignments, centroids, true);
+
+  arma::Col<size_t> denseAssignments;
+  arma::mat denseCentroids = initialCentroids;
+  k.Cluster(dense, 3, denseAssignments, denseCentroids, true);
+
+  for (size_t i = 0; i < 300; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(assignments[i], i / 100);
+    BOOST_REQUIRE_EQUAL(assignments[i], denseAssignments[i]);
+  }
+
+  for (size_t i = 0; i < denseCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i] + 1.0, denseCentroids[i] + 1.0, 1e-8);
+}
+
 #endif // Exclude Armadillo 3.4.
 #endif // ARMA_HAS_SPMAT
 
+/**
+ * When the mrkd-tree does not fit in the memory budget, FastCluster() should
+ * fall back to Cluster(), with the same results.
+ */
+BOOST_AUTO_TEST_CASE(FastClusterMemoryBudgetTest)
+{
+  arma::mat data(2, 5000);
+  data.randu();
+
+  arma::Col<size_t> assignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    assignments[i] = i % 15;
+  arma::Col<size_t> budgetAssignments(assignments);
+
+  KMeans<> kmeans;
+  BOOST_REQUIRE_GT(kmeans.PeakMemory(5000, 2, 15, true),
+      kmeans.PeakMemory(5000, 2, 15));
+
+  arma::mat centroids;
+  kmeans.Cluster(data, 15, assignments, centroids, true);
+
+  MemoryBudget::SetLimit(kmeans.PeakMemory(5000, 2, 15));
+  arma::mat budgetCentroids;
+  kmeans.FastCluster(data, 15, budgetAssignments, budgetCentroids, true);
+  MemoryBudget::SetLimit(0);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], budgetAssignments[i]);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(centroids[i], budgetCentroids[i]);
+}
+
+//! A monitor which stops methods after the given step.
+class StepMonitor : public ProgressMonitor
+{
+ public:
+  StepMonitor(const size_t lastStep) : lastStep(lastStep) { }
+
+ protected:
+  bool Report(const std::string& /* task */,
+              const size_t step,
+              const double /* value */)
+  {
+    return (step < lastStep);
+  }
+
+ private:
+  size_t lastStep;
+};
+
+/**
+ * Stop Cluster() with a ProgressMonitor after three iterations, and make sure
+ * the result is that of three iterations.
+ */
+BOOST_AUTO_TEST_CASE(ClusterMonitorTest)
+{
+  arma::mat data = arma::randu<arma::mat>(2, 3000);
+  arma::Col<size_t> initialAssignments(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    initialAssignments[i] = i % 10;
+
+  KMeans<> limited(3);
+  arma::Col<size_t> limitedAssignments(initialAssignments);
+  arma::mat limitedCentroids;
+  limited.Cluster(data, 10, limitedAssignments, limitedCentroids, true);
+
+  StepMonitor monitor(3);
+  KMeans<> kmeans;
+  kmeans.Monitor() = &monitor;
+  arma::Col<size_t> assignments(initialAssignments);
+  arma::mat centroids;
+  kmeans.Cluster(data, 10, assignments, centroids, true);
+
+  BOOST_REQUIRE(monitor.Stopped());
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], limitedAssignments[i]);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], limitedCentroids[i], 1e-10);
+}
+
+/**
+ * Make sure that clustering a dataset split into shards, one for each rank of
+ * a communicator (here, threads), finds the same centroids and assignments as
+ * clustering the whole dataset in one process.
+ */
+BOOST_AUTO_TEST_CASE(DistributedClusterTest)
+{
+#ifdef _OPENMP
+  arma::mat data = arma::randn<arma::mat>(3, 600);
+  data.cols(200, 399) += 8.0;
+  data.cols(400, 599) -= 8.0;
+
+  const arma::mat initialCentroids("-1.0 0.0 1.0;"
+                                   "-1.0 0.0 1.0;"
+                                   "-1.0 0.0 1.0");
+
+  KMeans<> kmeans;
+  arma::Col<size_t> assignments;
+  arma::mat centroids(initialCentroids);
+  kmeans.Cluster(data, 3, assignments, centroids, false, true);
+
+  // Three shards of different sizes.
+  const size_t ranks = 3;
+  const size_t bounds[] = { 0, 100, 350, 600 };
+  std::vector<std::vector<double> > buffers(ranks);
+  std::vector<arma::Col<size_t> > shardAssignments(ranks);
+  std::vector<arma::mat> shardCentroids(ranks, initialCentroids);
+  size_t threads = 0;
+
+  #pragma omp parallel num_threads(ranks)
+  {
+    const size_t rank = (size_t) omp_get_thread_num();
+    #pragma omp single
+    threads = (size_t) omp_get_num_threads();
+
+    if (threads == ranks)
+    {
+      ThreadCommunicator communicator(buffers, rank);
+      KMeans<> shardKMeans;
+      shardKMeans.Comm() = &communicator;
+      shardKMeans.Cluster(arma::mat(data.cols(bounds[rank],
+          bounds[rank + 1] - 1)), 3, shardAssignments[rank],
+          shardCentroids[rank], false, true);
+    }
+  }
+
+  if (threads != ranks)
+    return;
+
+  for (size_t r = 0; r < ranks; ++r)
+  {
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(shardCentroids[r][i], centroids[i], 1e-8);
+
+    for (size_t i = bounds[r]; i < bounds[r + 1]; ++i)
+      BOOST_REQUIRE_EQUAL(shardAssignments[r][i - bounds[r]], assignments[i]);
+  }
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END();
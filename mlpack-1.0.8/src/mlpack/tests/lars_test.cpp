@@ -121,4 +121,221 @@ BOOST_AUTO_TEST_CASE(LARSTestElasticNetGram)
   LassoTest(100, 10, true, false);
 }
 
+/**
+ * Regressing several responses at once should give the same solutions as
+ * regressing each of them separately.
+ */
+BOOST_AUTO_TEST_CASE(LARSMultipleResponsesTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 100, 10);
+
+  arma::mat responses(100, 3);
+  responses.col(0) = y;
+  responses.col(1) = trans(X) * arma::randn<arma::vec>(10);
+  responses.col(2) = arma::randn<arma::vec>(100);
+
+  const double lambda1 = 0.5;
+  LARS lars(true, lambda1, 0.1);
+  arma::mat betas;
+  lars.Regress(X, responses, betas);
+
+  BOOST_REQUIRE_EQUAL(betas.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(betas.n_cols, 3);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    LARS single(true, lambda1, 0.1);
+    arma::vec beta;
+    const arma::vec response = responses.col(i);
+    single.Regress(X, response, beta);
+
+    for (size_t j = 0; j < 10; ++j)
+      BOOST_REQUIRE_SMALL(betas(j, i) - beta[j], 1e-10);
+  }
+}
+
+/**
+ * Running the same LARS object twice should give the same solution as running
+ * it once.
+ */
+BOOST_AUTO_TEST_CASE(LARSRepeatedRegressTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 100, 10);
+  const arma::vec y2 = arma::randn<arma::vec>(100);
+
+  LARS lars(true, 1.0);
+  arma::vec first, second, third;
+  lars.Regress(X, y, first);
+  lars.Regress(X, y2, second);
+  lars.Regress(X, y, third);
+
+  LARS fresh(true, 1.0);
+  arma::vec beta;
+  fresh.Regress(X, y2, beta);
+
+  for (size_t j = 0; j < 10; ++j)
+  {
+    BOOST_REQUIRE_SMALL(first[j] - third[j], 1e-10);
+    BOOST_REQUIRE_SMALL(second[j] - beta[j], 1e-10);
+  }
+}
+
+/**
+ * Continuing the path to a smaller lambda1 should give the same solution as
+ * solving for that lambda1 from scratch.
+ */
+BOOST_AUTO_TEST_CASE(LARSContinuePathTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 100, 10);
+
+  arma::vec sortedAbsCorr = sort(abs(X * y));
+  const double largeLambda = sortedAbsCorr(8);
+  const double smallLambda = sortedAbsCorr(2);
+
+  for (size_t c = 0; c < 2; ++c)
+  {
+    const bool useCholesky = (c == 0);
+
+    LARS lars(useCholesky, largeLambda);
+    arma::vec beta;
+    lars.Regress(X, y, beta);
+
+    // Continuing to the same lambda1 changes nothing.
+    arma::vec same;
+    lars.ContinuePath(X, largeLambda, same);
+    for (size_t j = 0; j < 10; ++j)
+      BOOST_REQUIRE_SMALL(same[j] - beta[j], 1e-10);
+
+    arma::vec continued;
+    lars.ContinuePath(X, smallLambda, continued);
+
+    LARS fresh(useCholesky, smallLambda);
+    arma::vec betaOpt;
+    fresh.Regress(X, y, betaOpt);
+
+    for (size_t j = 0; j < 10; ++j)
+      BOOST_REQUIRE_SMALL(continued[j] - betaOpt[j], 1e-8);
+
+    BOOST_REQUIRE_EQUAL(lars.BetaPath().size(), fresh.BetaPath().size());
+    BOOST_REQUIRE_SMALL(lars.LambdaPath().back() - smallLambda, 1e-10);
+
+    arma::vec errCorr = X * trans(X) * continued - X * y;
+    LARSVerifyCorrectness(continued, errCorr, smallLambda);
+  }
+}
+
+/**
+ * The path stored sparsely, or not stored at all, and computed with several
+ * threads, must give the same coefficients as the full path stored densely;
+ * continuing the path must also work with each storage.
+ */
+BOOST_AUTO_TEST_CASE(LARSPathStorageTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 100, 20);
+
+  arma::vec sortedAbsCorr = sort(abs(X * y));
+  const double largeLambda = sortedAbsCorr(15);
+  const double smallLambda = sortedAbsCorr(3);
+
+  for (size_t c = 0; c < 2; ++c)
+  {
+    const bool useCholesky = (c == 0);
+
+    LARS full(useCholesky, largeLambda, 0.1);
+    arma::vec fullBeta;
+    full.Regress(X, y, fullBeta);
+    full.ContinuePath(X, smallLambda, fullBeta);
+
+    for (size_t s = 0; s < 2; ++s)
+    {
+      LARS lars(useCholesky, largeLambda, 0.1);
+      lars.Storage() = (s == 0) ? LARS::SPARSE_PATH : LARS::SOLUTION_ONLY;
+      lars.Threads() = 3;
+
+      arma::vec beta;
+      lars.Regress(X, y, beta);
+      lars.ContinuePath(X, smallLambda, beta);
+
+      BOOST_REQUIRE_EQUAL(lars.BetaPath().size(), 0);
+      BOOST_REQUIRE_EQUAL(lars.LambdaPath().size(), full.LambdaPath().size());
+      for (size_t j = 0; j < 20; ++j)
+        BOOST_REQUIRE_SMALL(beta[j] - fullBeta[j], 1e-10);
+
+      // With a sparse path, every step is available, and only holds the
+      // nonzero coefficients.
+      const size_t steps = (s == 0) ? lars.LambdaPath().size() : 1;
+      for (size_t step = lars.LambdaPath().size() - steps;
+           step < lars.LambdaPath().size(); ++step)
+      {
+        arma::vec stepBeta;
+        lars.PathBeta(step, stepBeta);
+        for (size_t j = 0; j < 20; ++j)
+          BOOST_REQUIRE_SMALL(stepBeta[j] - full.BetaPath()[step][j], 1e-10);
+
+        if (s == 0)
+        {
+          BOOST_REQUIRE_EQUAL(lars.BetaPathIndices()[step].n_elem,
+              arma::accu(full.BetaPath()[step] != 0.0));
+          for (size_t i = 0; i < lars.BetaPathValues()[step].n_elem; ++i)
+            BOOST_REQUIRE(lars.BetaPathValues()[step][i] != 0.0);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * On sparse data, LARS must find the same path as on the same data made dense,
+ * with and without the Cholesky factorization, for the lasso and the elastic
+ * net.
+ */
+BOOST_AUTO_TEST_CASE(LARSSparseTest)
+{
+  arma::mat X;
+  arma::vec y;
+  GenerateProblem(X, y, 100, 20);
+
+  // Zero most of the data.
+  X %= arma::conv_to<arma::mat>::from(arma::randu<arma::mat>(20, 100) < 0.2);
+  y = trans(X) * arma::randn<arma::vec>(20);
+  const arma::sp_mat sparseX(X);
+
+  arma::vec sortedAbsCorr = sort(abs(X * y));
+  const double largeLambda = sortedAbsCorr(15);
+  const double smallLambda = sortedAbsCorr(5);
+
+  for (size_t c = 0; c < 4; ++c)
+  {
+    const bool useCholesky = (c % 2 == 0);
+    const double lambda2 = (c < 2) ? 0.0 : 0.1;
+
+    LARS dense(useCholesky, largeLambda, lambda2);
+    arma::vec denseBeta;
+    dense.Regress(X, y, denseBeta);
+
+    LARS sparse(useCholesky, largeLambda, lambda2);
+    arma::vec sparseBeta;
+    sparse.Regress(sparseX, y, sparseBeta);
+
+    BOOST_REQUIRE_EQUAL(sparse.ActiveSet().size(), dense.ActiveSet().size());
+    for (size_t j = 0; j < 20; ++j)
+      BOOST_REQUIRE_SMALL(sparseBeta[j] - denseBeta[j], 1e-10);
+
+    dense.ContinuePath(X, smallLambda, denseBeta);
+    sparse.ContinuePath(sparseX, smallLambda, sparseBeta);
+
+    BOOST_REQUIRE_EQUAL(sparse.LambdaPath().size(), dense.LambdaPath().size());
+    for (size_t j = 0; j < 20; ++j)
+      BOOST_REQUIRE_SMALL(sparseBeta[j] - denseBeta[j], 1e-10);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
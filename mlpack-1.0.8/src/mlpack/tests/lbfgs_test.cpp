@@ -127,4 +127,47 @@ BOOST_AUTO_TEST_CASE(RosenbrockWoodFunctionTest)
   }
 }
 
+/**
+ * Make sure that an L-BFGS object can be used for several optimizations; its
+ * workspace is reused, and must not leak state from one run to the next.
+ */
+BOOST_AUTO_TEST_CASE(ReusedWorkspaceTest)
+{
+  RosenbrockFunction f;
+  L_BFGS<RosenbrockFunction> lbfgs(f);
+  lbfgs.MaxIterations() = 10000;
+
+  arma::mat first = f.GetInitialPoint();
+  const double firstValue = lbfgs.Optimize(first);
+
+  arma::mat second = f.GetInitialPoint();
+  const double secondValue = lbfgs.Optimize(second);
+
+  BOOST_REQUIRE_EQUAL(firstValue, secondValue);
+  BOOST_REQUIRE_EQUAL(first[0], second[0]);
+  BOOST_REQUIRE_EQUAL(first[1], second[1]);
+
+  // The returned objective is the objective at the final point.
+  BOOST_REQUIRE_CLOSE(secondValue + 1.0, f.Evaluate(second) + 1.0, 1e-10);
+}
+
+/**
+ * Make sure that L-BFGS with a warm start can be stopped and restarted many
+ * times and still find the minimum of the Rosenbrock function.
+ */
+BOOST_AUTO_TEST_CASE(WarmStartTest)
+{
+  RosenbrockFunction f;
+  L_BFGS<RosenbrockFunction> lbfgs(f);
+  lbfgs.WarmStart() = true;
+
+  arma::mat coords = f.GetInitialPoint();
+  for (size_t i = 0; i < 2000; ++i)
+    lbfgs.Optimize(coords, 3);
+
+  BOOST_REQUIRE_SMALL(f.Evaluate(coords), 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[0], 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[1], 1.0, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -23,6 +23,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/math/lin_alg.hpp>
+#include <mlpack/core/math/lanczos_eigensolver.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -88,6 +89,91 @@ BOOST_AUTO_TEST_CASE(TestCenterB)
       BOOST_REQUIRE_CLOSE(tmp_out(row, col), (double) (col - 2.5) * row, 1e-5);
 }
 
+/**
+ * Centering in place should give the same result as centering into another
+ * matrix.
+ */
+BOOST_AUTO_TEST_CASE(TestCenterInPlace)
+{
+  mat tmp(5, 6);
+  for (int row = 0; row < 5; row++)
+    for (int col = 0; col < 6; col++)
+      tmp(row, col) = row * (col + 1);
+
+  Center(tmp);
+  for (int row = 0; row < 5; row++)
+    for (int col = 0; col < 6; col++)
+      BOOST_REQUIRE_CLOSE(tmp(row, col) + 1.0, (double) (col - 2.5) * row + 1.0,
+          1e-5);
+}
+
+/**
+ * The covariance accumulated a block at a time, and merged from several
+ * accumulators, should be the covariance of the whole matrix.
+ */
+BOOST_AUTO_TEST_CASE(TestCovarianceAccumulator)
+{
+  mat data(7, 1000);
+  data.randu();
+  data.row(3) += 1000.0; // A large mean should not hurt the accuracy.
+
+  const mat trueCov = ccov(data);
+  const vec trueMean = sum(data, 1) / data.n_cols;
+
+  CovarianceAccumulator blocked(0, 64);
+  blocked.Add(data);
+
+  CovarianceAccumulator first, second;
+  first.Add(data.cols(0, 299));
+  second.Add(data.cols(300, 999));
+  first.Merge(second);
+
+  BOOST_REQUIRE_EQUAL(blocked.Count(), 1000);
+  BOOST_REQUIRE_EQUAL(first.Count(), 1000);
+
+  mat blockedCov, mergedCov;
+  blocked.Covariance(blockedCov);
+  first.Covariance(mergedCov);
+
+  for (size_t i = 0; i < trueCov.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(blockedCov[i] + 1.0, trueCov[i] + 1.0, 1e-8);
+    BOOST_REQUIRE_CLOSE(mergedCov[i] + 1.0, trueCov[i] + 1.0, 1e-8);
+  }
+
+  for (size_t i = 0; i < trueMean.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(blocked.Mean()[i], trueMean[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(first.Mean()[i], trueMean[i], 1e-8);
+  }
+}
+
+/**
+ * Whitening in place, and applying the whitening matrix a block at a time,
+ * should give the same result as whitening into another matrix.
+ */
+BOOST_AUTO_TEST_CASE(TestWhitenInPlace)
+{
+  mat data(5, 500);
+  data.randu();
+
+  mat whitened, whiteningMatrix;
+  WhitenUsingSVD(data, whitened, whiteningMatrix);
+
+  mat inPlace(data);
+  mat inPlaceMatrix;
+  WhitenUsingSVD(inPlace, inPlace, inPlaceMatrix);
+
+  mat applied(data);
+  ApplyWhitening(whiteningMatrix, applied, 32);
+
+  for (size_t i = 0; i < whitened.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(inPlace[i] + 1.0, whitened[i] + 1.0, 1e-8);
+    BOOST_REQUIRE_CLOSE(applied[i] + 1.0, whitened[i] + 1.0, 1e-8);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(TestWhitenUsingEig)
 {
   // After whitening using eigendecomposition, the covariance of
@@ -200,4 +286,71 @@ BOOST_AUTO_TEST_CASE(TestRemoveRows)
   }
 }
 
+// Make sure the Lanczos eigensolver finds the largest eigenpairs of a random
+// symmetric matrix, as eig_sym() does.
+BOOST_AUTO_TEST_CASE(LanczosEigensolverTest)
+{
+  arma::mat data = arma::randn<arma::mat>(200, 40);
+  arma::mat matrix = data * trans(data) + 0.1 * arma::randu<arma::mat>(200,
+      200);
+  matrix = (matrix + trans(matrix)) / 2;
+
+  arma::vec exactEigval;
+  arma::mat exactEigvec;
+  arma::eig_sym(exactEigval, exactEigvec, matrix);
+
+  LanczosEigensolver solver;
+  arma::vec eigval;
+  arma::mat eigvec;
+  BOOST_REQUIRE(solver.Solve(matrix, 6, eigval, eigvec));
+  BOOST_REQUIRE_EQUAL(eigval.n_elem, 6);
+  BOOST_REQUIRE_EQUAL(eigvec.n_rows, 200);
+  BOOST_REQUIRE_EQUAL(eigvec.n_cols, 6);
+  BOOST_REQUIRE_LT(solver.Products(), 200);
+
+  for (size_t i = 0; i < 6; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(eigval[i], exactEigval[199 - i], 1e-6);
+
+    // The eigenvectors are the same up to sign.
+    const double product = dot(eigvec.col(i), exactEigvec.col(199 - i));
+    BOOST_REQUIRE_CLOSE(std::abs(product), 1.0, 1e-4);
+  }
+}
+
+// An operator that is only known by its products: a diagonal matrix with
+// 1, 2, ..., n on the diagonal.
+class DiagonalOperator
+{
+ public:
+  DiagonalOperator(const size_t n) : n(n) { }
+
+  size_t Size() const { return n; }
+
+  void Apply(const arma::vec& x, arma::vec& y) const
+  {
+    y = x % arma::linspace<arma::vec>(1, n, n);
+  }
+
+ private:
+  size_t n;
+};
+
+// Make sure the Lanczos eigensolver works with an operator that is not a
+// matrix, with a small subspace that needs many restarts.
+BOOST_AUTO_TEST_CASE(LanczosEigensolverOperatorTest)
+{
+  LanczosEigensolver solver(1e-10, 1000, 10);
+  arma::vec eigval;
+  arma::mat eigvec;
+  BOOST_REQUIRE(solver.Solve(DiagonalOperator(500), 3, eigval, eigvec));
+  BOOST_REQUIRE_GT(solver.Restarts(), 0);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(eigval[i], 500.0 - i, 1e-6);
+    BOOST_REQUIRE_CLOSE(std::abs(eigvec(499 - i, i)), 1.0, 1e-4);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -20,6 +20,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/linear_regression/incremental_linear_regression.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -188,4 +189,108 @@ BOOST_AUTO_TEST_CASE(RidgeRegressionTestCase)
     BOOST_REQUIRE_SMALL(predictions(i) - responses(i), .05);
 }
 
+/**
+ * The TSQR fit must not depend on how the observations are split into blocks:
+ * compare the parameters found with one thread and no memory budget against
+ * those found with several threads and a budget which forces small blocks, and
+ * against the solution of the normal equations.
+ */
+BOOST_AUTO_TEST_CASE(LinearRegressionBlockTest)
+{
+  arma::mat predictors = arma::randu<arma::mat>(5, 2000);
+  arma::vec responses = trans(predictors) * arma::randu<arma::vec>(5) + 3.0 +
+      0.01 * arma::randn<arma::vec>(2000);
+
+  for (size_t l = 0; l < 2; ++l)
+  {
+    const double lambda = (l == 0) ? 0.0 : 0.5;
+
+    LinearRegression lr(predictors, responses, lambda);
+
+    MemoryBudget::SetLimit(4096);
+    LinearRegression blocked(predictors, responses, lambda, 4);
+    MemoryBudget::SetLimit(0);
+
+    arma::mat x(6, 2000);
+    x.row(0).ones();
+    x.rows(1, 5) = predictors;
+    const arma::vec normal = arma::solve(x * trans(x) + lambda * lambda *
+        arma::eye<arma::mat>(6, 6), x * responses);
+
+    BOOST_REQUIRE_EQUAL(blocked.Parameters().n_elem, 6);
+    for (size_t i = 0; i < 6; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(blocked.Parameters()[i], lr.Parameters()[i], 1e-5);
+      BOOST_REQUIRE_CLOSE(normal[i], lr.Parameters()[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * IncrementalLinearRegression, given the observations in chunks, must find the
+ * same parameters as LinearRegression on all of them.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalLinearRegressionTest)
+{
+  arma::mat predictors = arma::randu<arma::mat>(4, 1000);
+  arma::vec responses = trans(predictors) * arma::randu<arma::vec>(4) - 1.0 +
+      0.01 * arma::randn<arma::vec>(1000);
+
+  for (size_t l = 0; l < 2; ++l)
+  {
+    const double lambda = (l == 0) ? 0.0 : 0.5;
+
+    IncrementalLinearRegression ilr(lambda);
+    ilr.Update(predictors.cols(0, 99), responses.subvec(0, 99));
+    ilr.Update(predictors.cols(100, 699), responses.subvec(100, 699));
+    ilr.Update(predictors.cols(700, 999), responses.subvec(700, 999));
+    BOOST_REQUIRE_EQUAL(ilr.NumPoints(), 1000);
+
+    LinearRegression incremental;
+    ilr.Fit(incremental);
+    BOOST_REQUIRE_EQUAL(incremental.Lambda(), lambda);
+
+    LinearRegression lr(predictors, responses, lambda);
+
+    BOOST_REQUIRE_EQUAL(incremental.Parameters().n_elem, 5);
+    for (size_t i = 0; i < 5; ++i)
+      BOOST_REQUIRE_CLOSE(incremental.Parameters()[i], lr.Parameters()[i],
+          1e-5);
+  }
+}
+
+/**
+ * LinearRegression on sparse predictors must find the same parameters, and the
+ * same predictions, as on the same predictors made dense.
+ */
+BOOST_AUTO_TEST_CASE(SparseLinearRegressionTest)
+{
+  arma::mat predictors = arma::randu<arma::mat>(10, 500);
+  predictors %= arma::conv_to<arma::mat>::from(
+      arma::randu<arma::mat>(10, 500) < 0.3);
+  arma::vec responses = trans(predictors) * arma::randu<arma::vec>(10) + 2.0 +
+      0.01 * arma::randn<arma::vec>(500);
+  const arma::sp_mat sparsePredictors(predictors);
+
+  for (size_t l = 0; l < 2; ++l)
+  {
+    const double lambda = (l == 0) ? 0.0 : 0.5;
+
+    LinearRegression dense(predictors, responses, lambda);
+    LinearRegression sparse(sparsePredictors, responses, lambda);
+    BOOST_REQUIRE_EQUAL(sparse.Lambda(), lambda);
+
+    BOOST_REQUIRE_EQUAL(sparse.Parameters().n_elem, 11);
+    for (size_t i = 0; i < 11; ++i)
+      BOOST_REQUIRE_CLOSE(sparse.Parameters()[i], dense.Parameters()[i],
+          1e-5);
+
+    arma::vec densePredictions, sparsePredictions;
+    dense.Predict(predictors, densePredictions);
+    sparse.Predict(sparsePredictors, sparsePredictions);
+    for (size_t i = 0; i < 500; ++i)
+      BOOST_REQUIRE_CLOSE(sparsePredictions[i], densePredictions[i], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -161,6 +161,162 @@ BOOST_AUTO_TEST_CASE(SaveNonTransposedCSVTest)
   remove("test_file.csv");
 }
 
+/**
+ * Make sure a large CSV is loaded the same way with many threads as with one,
+ * and the same way as Armadillo loads it.
+ */
+BOOST_AUTO_TEST_CASE(LoadCSVThreadsTest)
+{
+  arma::mat data;
+  data.randn(5, 50000);
+  data *= 1000.0;
+
+  BOOST_REQUIRE(data::Save("test_file.csv", data) == true);
+
+  arma::mat serial;
+  BOOST_REQUIRE(data::Load("test_file.csv", serial, false, true, 1) == true);
+  arma::mat parallel;
+  BOOST_REQUIRE(data::Load("test_file.csv", parallel, false, true, 0) == true);
+  arma::mat notTransposed;
+  BOOST_REQUIRE(data::Load("test_file.csv", notTransposed, false, false, 0) ==
+      true);
+
+  arma::mat armadillo;
+  BOOST_REQUIRE(armadillo.load("test_file.csv", arma::csv_ascii) == true);
+
+  BOOST_REQUIRE_EQUAL(serial.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(serial.n_cols, 50000);
+  BOOST_REQUIRE_EQUAL(parallel.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(parallel.n_cols, 50000);
+  BOOST_REQUIRE_EQUAL(notTransposed.n_rows, 50000);
+  BOOST_REQUIRE_EQUAL(notTransposed.n_cols, 5);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < data.n_rows; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(parallel(j, i), serial(j, i));
+      BOOST_REQUIRE_EQUAL(notTransposed(i, j), serial(j, i));
+      BOOST_REQUIRE_CLOSE(serial(j, i), armadillo(i, j), 1e-10);
+    }
+  }
+
+  // Remove the file.
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure that CSV and raw ASCII files saved in parallel are the same as
+ * those saved with one thread, and are loaded back exactly.
+ */
+BOOST_AUTO_TEST_CASE(SaveTextThreadsTest)
+{
+  arma::mat data;
+  data.randn(7, 30000);
+  data.col(3).fill(12.0);
+  data(2, 5) = -1e-300;
+
+  BOOST_REQUIRE(data::Save("test_file.csv", data, false, true, 1) == true);
+  BOOST_REQUIRE(data::Save("test_threads.csv", data, false, true, 0) == true);
+  BOOST_REQUIRE(data::Save("test_threads.txt", data, false, false, 0) ==
+      true);
+
+  arma::mat serial, parallel, notTransposed;
+  BOOST_REQUIRE(data::Load("test_file.csv", serial) == true);
+  BOOST_REQUIRE(data::Load("test_threads.csv", parallel) == true);
+  BOOST_REQUIRE(data::Load("test_threads.txt", notTransposed, false, false) ==
+      true);
+
+  BOOST_REQUIRE_EQUAL(parallel.n_rows, data.n_rows);
+  BOOST_REQUIRE_EQUAL(parallel.n_cols, data.n_cols);
+  BOOST_REQUIRE_EQUAL(serial.n_rows, data.n_rows);
+  BOOST_REQUIRE_EQUAL(serial.n_cols, data.n_cols);
+  BOOST_REQUIRE_EQUAL(notTransposed.n_rows, data.n_rows);
+  BOOST_REQUIRE_EQUAL(notTransposed.n_cols, data.n_cols);
+  for (size_t i = 0; i < data.n_elem; ++i)
+  {
+    BOOST_REQUIRE(serial[i] == data[i]);
+    BOOST_REQUIRE(parallel[i] == data[i]);
+    BOOST_REQUIRE(notTransposed[i] == data[i]);
+  }
+
+  // Indices are written as integers.
+  arma::Mat<size_t> neighbors(3, 1000);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    neighbors[i] = i * 1000003;
+
+  BOOST_REQUIRE(data::Save("test_threads.csv", neighbors, false, true, 0) ==
+      true);
+  arma::Mat<size_t> neighborsLoaded;
+  BOOST_REQUIRE(data::Load("test_threads.csv", neighborsLoaded) == true);
+  BOOST_REQUIRE_EQUAL(neighborsLoaded.n_rows, neighbors.n_rows);
+  BOOST_REQUIRE_EQUAL(neighborsLoaded.n_cols, neighbors.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(neighborsLoaded[i], neighbors[i]);
+
+  std::string line;
+  data::AppendTextNumber((size_t) 1234567, line);
+  data::AppendTextNumber(-3.0, line);
+  data::AppendTextNumber(0.1, line);
+  BOOST_REQUIRE_EQUAL(line, "1234567-30.1");
+
+  // Remove the files.
+  remove("test_file.csv");
+  remove("test_threads.csv");
+  remove("test_threads.txt");
+}
+
+/**
+ * Make sure missing CSV values are zero and that the data ends at the first
+ * empty line, as with Armadillo.
+ */
+BOOST_AUTO_TEST_CASE(LoadIncompleteCSVTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+
+  f << "1, 2, 3" << std::endl;
+  f << "4,,6" << std::endl;
+  f << "7, 8" << std::endl;
+  f << std::endl;
+  f << "10, 11, 12" << std::endl;
+
+  f.close();
+
+  arma::mat test;
+  BOOST_REQUIRE(data::Load("test_file.csv", test) == true);
+
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 3);
+
+  const double values[] = { 1, 2, 3, 4, 0, 6, 7, 8, 0 };
+  for (size_t i = 0; i < 9; ++i)
+    BOOST_REQUIRE_CLOSE(test[i] + 1.0, values[i] + 1.0, 1e-5);
+
+  // Remove the file.
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure a raw ASCII file with lines of different lengths does not load.
+ */
+BOOST_AUTO_TEST_CASE(LoadInconsistentRawASCIITest)
+{
+  std::fstream f;
+  f.open("test_file.txt", std::fstream::out);
+
+  f << "1 2 3 4" << std::endl;
+  f << "5 6 7" << std::endl;
+
+  f.close();
+
+  arma::mat test;
+  BOOST_REQUIRE(data::Load("test_file.txt", test) == false);
+
+  // Remove the file.
+  remove("test_file.txt");
+}
+
 /**
  * Make sure arma_ascii is loaded correctly.
  */
@@ -576,4 +732,485 @@ BOOST_AUTO_TEST_CASE(NormalizeLabelTest)
     BOOST_REQUIRE_EQUAL(randLabels[i], revertedLabels[i]);
 }
 
+/**
+ * Make sure a LabelMapping gives the same labels to later batches, numbers new
+ * labels after the old ones, and handles many different labels.
+ */
+BOOST_AUTO_TEST_CASE(LabelMappingTest)
+{
+  // Every label is different.
+  arma::Col<size_t> rawLabels(200000);
+  for (size_t i = 0; i < rawLabels.n_elem; ++i)
+    rawLabels[i] = 3 * (rawLabels.n_elem - i);
+
+  arma::Col<size_t> labels;
+  arma::Col<size_t> mappings;
+  data::NormalizeLabels(rawLabels, labels, mappings);
+
+  BOOST_REQUIRE_EQUAL(mappings.n_elem, rawLabels.n_elem);
+  for (size_t i = 0; i < rawLabels.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(labels[i], i);
+    BOOST_REQUIRE_EQUAL(mappings[i], rawLabels[i]);
+  }
+
+  arma::Col<int> firstBatch("4 -2 4 7");
+  arma::Col<int> secondBatch("7 9 -2 11 9");
+
+  data::LabelMapping<int> mapping;
+  arma::Col<size_t> firstLabels, secondLabels;
+  mapping.Normalize(firstBatch, firstLabels);
+  mapping.Normalize(secondBatch, secondLabels);
+
+  BOOST_REQUIRE_EQUAL(mapping.NumLabels(), 5);
+  BOOST_REQUIRE_EQUAL(firstLabels[0], 0);
+  BOOST_REQUIRE_EQUAL(firstLabels[1], 1);
+  BOOST_REQUIRE_EQUAL(firstLabels[2], 0);
+  BOOST_REQUIRE_EQUAL(firstLabels[3], 2);
+  BOOST_REQUIRE_EQUAL(secondLabels[0], 2);
+  BOOST_REQUIRE_EQUAL(secondLabels[1], 3);
+  BOOST_REQUIRE_EQUAL(secondLabels[2], 1);
+  BOOST_REQUIRE_EQUAL(secondLabels[3], 4);
+  BOOST_REQUIRE_EQUAL(secondLabels[4], 3);
+
+  arma::Col<int> reverted;
+  mapping.Revert(secondLabels, reverted);
+  for (size_t i = 0; i < secondBatch.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(reverted[i], secondBatch[i]);
+
+  // A mapping rebuilt from the reverse mapping gives the same labels.
+  arma::Col<int> reverseMapping;
+  mapping.Mapping(reverseMapping);
+  data::LabelMapping<int> rebuilt(reverseMapping);
+  arma::Col<size_t> rebuiltLabels;
+  rebuilt.Normalize(secondBatch, rebuiltLabels);
+  BOOST_REQUIRE_EQUAL(rebuilt.NumLabels(), 5);
+  for (size_t i = 0; i < secondBatch.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(rebuiltLabels[i], secondLabels[i]);
+}
+
+/**
+ * Make sure a matrix saved in the mlpack binary format is loaded correctly,
+ * transposed or not.
+ */
+BOOST_AUTO_TEST_CASE(SaveLoadMlpackBinaryTest)
+{
+  arma::mat test;
+  test.randu(7, 13);
+
+  BOOST_REQUIRE(data::Save("test_file.mbin", test) == true);
+
+  arma::mat test2;
+  BOOST_REQUIRE(data::Load("test_file.mbin", test2) == true);
+
+  BOOST_REQUIRE_EQUAL(test2.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(test2.n_cols, 13);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(test2[i], test[i]);
+
+  arma::mat test3;
+  BOOST_REQUIRE(data::Load("test_file.mbin", test3, false, false) == true);
+
+  BOOST_REQUIRE_EQUAL(test3.n_rows, 13);
+  BOOST_REQUIRE_EQUAL(test3.n_cols, 7);
+  for (size_t i = 0; i < test.n_rows; ++i)
+    for (size_t j = 0; j < test.n_cols; ++j)
+      BOOST_REQUIRE_EQUAL(test3(j, i), test(i, j));
+
+  // Loading it with elements of another type fails.
+  arma::Mat<size_t> wrongType;
+  BOOST_REQUIRE(data::Load("test_file.mbin", wrongType) == false);
+
+  // Remove the file.
+  remove("test_file.mbin");
+}
+
+/**
+ * Make sure a MappedMatrix maps files in the mlpack binary format, that it
+ * can be modified without changing the file, and that it loads other formats.
+ */
+BOOST_AUTO_TEST_CASE(MappedMatrixTest)
+{
+  arma::mat test;
+  test.randu(5, 20);
+
+  BOOST_REQUIRE(data::Save("test_file.mbin", test) == true);
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+
+  data::MappedMatrix<double> mapped("test_file.mbin");
+#ifndef _WIN32
+  BOOST_REQUIRE(mapped.Mapped());
+#endif
+  BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 20);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+
+  // The changes are private.
+  mapped.Matrix() *= 2.0;
+  data::MappedMatrix<double> mapped2("test_file.mbin");
+  for (size_t i = 0; i < test.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(mapped2.Matrix()[i], test[i]);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], 2.0 * test[i]);
+  }
+
+  data::MappedMatrix<double> loaded;
+  BOOST_REQUIRE(loaded.Load("test_file.csv") == true);
+  BOOST_REQUIRE(!loaded.Mapped());
+  BOOST_REQUIRE_EQUAL(loaded.Matrix().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(loaded.Matrix().n_cols, 20);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(loaded.Matrix()[i], test[i], 1e-5);
+
+  // A file that is not in the mlpack binary format cannot be mapped.
+  rename("test_file.csv", "test_file_csv.mbin");
+  BOOST_REQUIRE(loaded.Load("test_file_csv.mbin") == false);
+  BOOST_REQUIRE_EQUAL(loaded.Matrix().n_elem, 0);
+
+  // Remove the files.
+  remove("test_file.mbin");
+  remove("test_file_csv.mbin");
+}
+
+/**
+ * A function for ChunkReader::ForEach() which sums the points it is given.
+ */
+class ChunkSum
+{
+ public:
+  ChunkSum(const size_t dimensionality) : sum(dimensionality), points(0)
+  {
+    sum.zeros();
+  }
+
+  void operator()(const arma::mat& chunk, const size_t firstPoint)
+  {
+    BOOST_REQUIRE_EQUAL(firstPoint, points);
+    sum += arma::sum(chunk, 1);
+    points += chunk.n_cols;
+  }
+
+  arma::vec sum;
+  size_t points;
+};
+
+/**
+ * Make sure the chunks of a ChunkReader are the same as the columns of the
+ * loaded matrix, for each of the file types it reads incrementally.
+ */
+BOOST_AUTO_TEST_CASE(ChunkReaderTest)
+{
+  arma::mat data;
+  data.randu(4, 103);
+
+  const char* filenames[] = { "test_file.csv", "test_file.txt",
+      "test_file.bin", "test_file.mbin" };
+  for (size_t f = 0; f < 4; ++f)
+  {
+    BOOST_REQUIRE(data::Save(filenames[f], data) == true);
+
+    arma::mat loaded;
+    BOOST_REQUIRE(data::Load(filenames[f], loaded) == true);
+
+    data::ChunkReader<double> reader(filenames[f], 10);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 4);
+
+    // Read it twice, to make sure Reset() works.
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+      reader.Reset();
+
+      arma::mat chunk;
+      size_t point = 0;
+      while (reader.NextChunk(chunk))
+      {
+        BOOST_REQUIRE_EQUAL(chunk.n_rows, 4);
+        BOOST_REQUIRE_EQUAL(chunk.n_cols, std::min((size_t) 10, 103 - point));
+
+        for (size_t i = 0; i < chunk.n_cols; ++i)
+          for (size_t j = 0; j < 4; ++j)
+            BOOST_REQUIRE_EQUAL(chunk(j, i), loaded(j, point + i));
+
+        point += chunk.n_cols;
+      }
+
+      BOOST_REQUIRE_EQUAL(point, 103);
+      BOOST_REQUIRE_EQUAL(reader.PointsRead(), 103);
+      BOOST_REQUIRE_EQUAL(chunk.n_elem, 0);
+    }
+
+    // Process it with and without prefetching.
+    const arma::vec sum = arma::sum(loaded, 1);
+    for (size_t prefetch = 0; prefetch < 2; ++prefetch)
+    {
+      ChunkSum chunkSum(4);
+      BOOST_REQUIRE_EQUAL(reader.ForEach(chunkSum, prefetch == 1), 103);
+      BOOST_REQUIRE_EQUAL(chunkSum.points, 103);
+      for (size_t j = 0; j < 4; ++j)
+        BOOST_REQUIRE_CLOSE(chunkSum.sum[j], sum[j], 1e-10);
+    }
+
+    remove(filenames[f]);
+  }
+}
+
+/**
+ * Stages for ChunkReader::Pipeline() which compute the sum of each point and
+ * output the sums in order.  Nothing is checked in the stages, since they may
+ * run on several threads.
+ */
+class ChunkPointSums
+{
+ public:
+  ChunkPointSums() : processedPoints(0), firstPointsMatch(true) { }
+
+  void Process(const arma::mat& chunk, const size_t firstPoint,
+               const size_t slot)
+  {
+    if (firstPoint != processedPoints)
+      firstPointsMatch = false;
+    processedPoints += chunk.n_cols;
+    sums[slot] = arma::sum(chunk, 0);
+  }
+
+  void Output(const size_t slot)
+  {
+    for (size_t i = 0; i < sums[slot].n_elem; ++i)
+      output.push_back(sums[slot][i]);
+    sums[slot].reset();
+  }
+
+  arma::rowvec sums[2];
+  std::vector<double> output;
+  size_t processedPoints;
+  bool firstPointsMatch;
+};
+
+/**
+ * Make sure ChunkReader::Pipeline() processes and outputs every chunk once, in
+ * order, with and without overlapping the stages.
+ */
+BOOST_AUTO_TEST_CASE(ChunkPipelineTest)
+{
+  arma::mat data;
+  data.randu(3, 95);
+  BOOST_REQUIRE(data::Save("test_file.csv", data) == true);
+
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded) == true);
+  const arma::rowvec sums = arma::sum(loaded, 0);
+
+  data::ChunkReader<double> reader("test_file.csv", 10);
+  for (size_t overlap = 0; overlap < 2; ++overlap)
+  {
+    ChunkPointSums stages;
+    BOOST_REQUIRE_EQUAL(reader.Pipeline(stages, overlap == 1), 95);
+
+    BOOST_REQUIRE(stages.firstPointsMatch);
+    BOOST_REQUIRE_EQUAL(stages.output.size(), 95);
+    for (size_t i = 0; i < 95; ++i)
+      BOOST_REQUIRE_CLOSE(stages.output[i], sums[i], 1e-10);
+  }
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure a dataset written in chunks by a ChunkWriter is loaded back as the
+ * concatenation of the chunks, for each of the file types it writes.
+ */
+BOOST_AUTO_TEST_CASE(ChunkWriterTest)
+{
+  arma::mat data;
+  data.randu(4, 103);
+
+  const char* filenames[] = { "test_file.csv", "test_file.txt",
+      "test_file.mbin" };
+  for (size_t f = 0; f < 3; ++f)
+  {
+    {
+      data::ChunkWriter<double> writer(filenames[f], 4);
+      for (size_t point = 0; point < 103; point += 10)
+        writer.Write(data.cols(point, std::min((size_t) 102, point + 9)));
+
+      BOOST_REQUIRE_EQUAL(writer.PointsWritten(), 103);
+      // The destructor closes the file.
+    }
+
+    arma::mat loaded;
+    BOOST_REQUIRE(data::Load(filenames[f], loaded) == true);
+
+    BOOST_REQUIRE_EQUAL(loaded.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(loaded.n_cols, 103);
+    for (size_t i = 0; i < data.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(loaded[i], data[i]);
+
+    remove(filenames[f]);
+  }
+
+  // Labels can be written too.
+  arma::Mat<size_t> labels(1, 20);
+  for (size_t i = 0; i < 20; ++i)
+    labels[i] = 3 * i;
+
+  data::ChunkWriter<size_t> writer("test_file.mbin", 1);
+  writer.Write(labels.cols(0, 4));
+  writer.Write(labels.cols(5, 19));
+  writer.Close();
+
+  arma::Mat<size_t> loadedLabels;
+  BOOST_REQUIRE(data::Load("test_file.mbin", loadedLabels) == true);
+  BOOST_REQUIRE_EQUAL(loadedLabels.n_rows, 1);
+  BOOST_REQUIRE_EQUAL(loadedLabels.n_cols, 20);
+  for (size_t i = 0; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL(loadedLabels[i], 3 * i);
+
+  remove("test_file.mbin");
+}
+
+/**
+ * Make sure sparse matrices survive being saved and loaded in each of the
+ * sparse formats, transposed or not.
+ */
+BOOST_AUTO_TEST_CASE(SparseSaveLoadTest)
+{
+  arma::mat dense;
+  dense.randu(20, 30);
+  dense.elem(arma::find(dense < 0.9)).zeros();
+  const arma::sp_mat test(dense);
+
+  const char* filenames[] = { "test_file.csv", "test_file.txt",
+      "test_file.mtx", "test_file.svm" };
+  for (size_t f = 0; f < 4; ++f)
+  {
+    for (size_t transpose = 0; transpose < 2; ++transpose)
+    {
+      BOOST_REQUIRE(data::Save(filenames[f], test, false, transpose == 1) ==
+          true);
+
+      arma::sp_mat loaded;
+      BOOST_REQUIRE(data::Load(filenames[f], loaded, false, transpose == 1) ==
+          true);
+
+      // The coordinate and svmlight formats only know the largest nonzero row
+      // and column.
+      BOOST_REQUIRE_LE(loaded.n_rows, 20);
+      BOOST_REQUIRE_LE(loaded.n_cols, 30);
+      BOOST_REQUIRE_EQUAL(loaded.n_nonzero, test.n_nonzero);
+      for (size_t i = 0; i < 20; ++i)
+        for (size_t j = 0; j < 30; ++j)
+          BOOST_REQUIRE_EQUAL((i < loaded.n_rows && j < loaded.n_cols) ?
+              (double) loaded(i, j) : 0.0, (double) test(i, j));
+
+      remove(filenames[f]);
+    }
+  }
+}
+
+/**
+ * Make sure MatrixMarket files with a symmetric, pattern, or duplicated
+ * entries are loaded correctly.
+ */
+BOOST_AUTO_TEST_CASE(SparseMatrixMarketTest)
+{
+  std::fstream f;
+  f.open("test_file.mtx", std::fstream::out);
+
+  f << "%%MatrixMarket matrix coordinate real symmetric" << std::endl;
+  f << "% A comment." << std::endl;
+  f << "3 3 4" << std::endl;
+  f << "1 1 2.5" << std::endl;
+  f << "3 1 -1" << std::endl;
+  f << "2 2 1" << std::endl;
+  f << "2 2 3" << std::endl;
+
+  f.close();
+
+  arma::sp_mat test;
+  BOOST_REQUIRE(data::Load("test_file.mtx", test, false, false) == true);
+
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(test.n_nonzero, 4);
+  BOOST_REQUIRE_CLOSE((double) test(0, 0), 2.5, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(2, 0), -1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(0, 2), -1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(1, 1), 4.0, 1e-5);
+
+  f.open("test_file.mtx", std::fstream::out);
+
+  f << "%%MatrixMarket matrix coordinate pattern general" << std::endl;
+  f << "2 4 2" << std::endl;
+  f << "1 4" << std::endl;
+  f << "2 1" << std::endl;
+
+  f.close();
+
+  BOOST_REQUIRE(data::Load("test_file.mtx", test) == true);
+
+  BOOST_REQUIRE_EQUAL(test.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(test.n_nonzero, 2);
+  BOOST_REQUIRE_CLOSE((double) test(3, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(0, 1), 1.0, 1e-5);
+
+  // An index out of range is an error.
+  f.open("test_file.mtx", std::fstream::out);
+
+  f << "%%MatrixMarket matrix coordinate real general" << std::endl;
+  f << "2 2 1" << std::endl;
+  f << "3 1 1.0" << std::endl;
+
+  f.close();
+
+  BOOST_REQUIRE(data::Load("test_file.mtx", test) == false);
+
+  remove("test_file.mtx");
+}
+
+/**
+ * Make sure the labels of an svmlight file are loaded and saved.
+ */
+BOOST_AUTO_TEST_CASE(SparseSVMLightLabelsTest)
+{
+  std::fstream f;
+  f.open("test_file.svm", std::fstream::out);
+
+  f << "1 1:0.5 3:2 # A comment." << std::endl;
+  f << "-1 qid:3 2:1.5" << std::endl;
+  f << "2" << std::endl;
+
+  f.close();
+
+  arma::sp_mat test;
+  arma::vec labels;
+  BOOST_REQUIRE(data::Load("test_file.svm", test, labels) == true);
+
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(test.n_nonzero, 3);
+  BOOST_REQUIRE_CLOSE((double) test(0, 0), 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(2, 0), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE((double) test(1, 1), 1.5, 1e-5);
+
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 3);
+  BOOST_REQUIRE_CLOSE(labels[0], 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(labels[1], -1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(labels[2], 2.0, 1e-5);
+
+  BOOST_REQUIRE(data::Save("test_file.svm", test, labels) == true);
+
+  arma::sp_mat test2;
+  arma::vec labels2;
+  BOOST_REQUIRE(data::Load("test_file.svm", test2, labels2) == true);
+
+  BOOST_REQUIRE_EQUAL(test2.n_nonzero, 3);
+  BOOST_REQUIRE_CLOSE((double) test2(1, 1), 1.5, 1e-5);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(labels2[i], labels[i], 1e-5);
+
+  remove("test_file.svm");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -94,6 +94,34 @@ BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestCodingStep)
   }
 }
 
+BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestParallelCodingStep)
+{
+  double lambda1 = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  LocalCoordinateCoding<> lcc(X, nAtoms, lambda1);
+  lcc.OptimizeCode();
+  const mat Z = lcc.Codes();
+
+  const size_t threads[] = { 2, 4, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    lcc.Codes().zeros();
+    lcc.Threads() = threads[t];
+    lcc.OptimizeCode();
+
+    for (uword i = 0; i < Z.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(lcc.Codes()[i], Z[i]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestDictionaryStep)
 {
   const double tol = 1e-12;
@@ -131,6 +159,56 @@ BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestDictionaryStep)
 
 }
 
+/**
+ * Local coordinate coding on sparse data should give the same results as on the
+ * same data stored densely.
+ */
+BOOST_AUTO_TEST_CASE(LocalCoordinateCodingSparseDataTest)
+{
+  double lambda1 = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  // Most of the pixels are zero.
+  const sp_mat sparseX(X);
+
+  LocalCoordinateCoding<> lcc(X, nAtoms, lambda1);
+  LocalCoordinateCoding<sparse_coding::NothingInitializer, sp_mat>
+      sparseLCC(sparseX, nAtoms, lambda1);
+  sparseLCC.Dictionary() = lcc.Dictionary();
+
+  // The distances are computed with sparse products, so the codes can differ
+  // slightly.
+  lcc.OptimizeCode();
+  sparseLCC.OptimizeCode();
+  for (uword i = 0; i < lcc.Codes().n_elem; ++i)
+    BOOST_REQUIRE_SMALL(sparseLCC.Codes()[i] - lcc.Codes()[i], 1e-8);
+
+  // Use the same codes for the rest of the test.
+  sparseLCC.Codes() = lcc.Codes();
+
+  uvec adjacencies = find(lcc.Codes());
+  BOOST_REQUIRE_CLOSE(sparseLCC.Objective(adjacencies),
+      lcc.Objective(adjacencies), 1e-5);
+
+  lcc.OptimizeDictionary(adjacencies);
+  sparseLCC.OptimizeDictionary(adjacencies);
+  for (uword i = 0; i < lcc.Dictionary().n_elem; ++i)
+  {
+    if (std::abs(lcc.Dictionary()[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sparseLCC.Dictionary()[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(sparseLCC.Dictionary()[i], lcc.Dictionary()[i],
+          1e-4);
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestWhole)
 {
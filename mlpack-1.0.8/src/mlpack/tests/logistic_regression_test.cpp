@@ -22,6 +22,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/logistic_regression/logistic_regression.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_separable/parallel_separable_function.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -480,6 +481,179 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRegularizationSeparableGradient)
   }
 }
 
+/**
+ * Test that the sparse separable gradient is the same as the dense separable
+ * gradient, and that it only holds the intercept and the nonzero dimensions of
+ * the point.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSparseGradient)
+{
+  arma::mat data("1 0 3 0;"
+                 "0 0 2 1;"
+                 "2 0 0 4");
+  arma::vec responses("1 0 1 0");
+  arma::mat parameters("0.5; -1.2; 0.3; 2.0");
+
+  // Without regularization, the gradients are the same for every point.
+  LogisticRegressionFunction lrf(data, responses, 0.0);
+  arma::mat dense;
+  arma::sp_mat sparse;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    lrf.Gradient(parameters, i, dense);
+    lrf.Gradient(parameters, i, sparse);
+
+    BOOST_REQUIRE_EQUAL(sparse.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(sparse.n_cols, 1);
+    BOOST_REQUIRE_LE(sparse.n_nonzero, 1 + arma::accu(data.col(i) != 0));
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+      if (std::abs(dense[j]) < 1e-10)
+        BOOST_REQUIRE_SMALL((double) sparse(j, 0), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE((double) sparse(j, 0), dense[j], 1e-5);
+    }
+  }
+
+  // With regularization, the gradients are the same for a dense point.
+  LogisticRegressionFunction regLrf(data, responses, 0.7);
+  regLrf.Gradient(parameters, 2, dense);
+  regLrf.Gradient(parameters, 2, sparse);
+  for (size_t j = 0; j < 4; ++j)
+    BOOST_REQUIRE_CLOSE((double) sparse(j, 0), dense[j], 1e-5);
+}
+
+/**
+ * Test that EvaluateWithGradient() gives the same objective and gradient as
+ * Evaluate() and Gradient().
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionEvaluateWithGradient)
+{
+  arma::mat data;
+  data.randu(5, 100);
+  arma::vec responses(100);
+  for (size_t i = 0; i < 100; ++i)
+    responses[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  LogisticRegressionFunction lrf(data, responses, 0.4);
+
+  for (size_t trial = 0; trial < 5; ++trial)
+  {
+    arma::mat parameters;
+    parameters.randn(6, 1);
+
+    arma::mat gradient;
+    lrf.Gradient(parameters, gradient);
+    const double objective = lrf.Evaluate(parameters);
+
+    arma::mat combinedGradient;
+    const double combinedObjective = lrf.EvaluateWithGradient(parameters,
+        combinedGradient);
+
+    BOOST_REQUIRE_CLOSE(combinedObjective, objective, 1e-5);
+    for (size_t j = 0; j < 6; ++j)
+      BOOST_REQUIRE_CLOSE(combinedGradient[j], gradient[j], 1e-5);
+  }
+}
+
+/**
+ * Test that the function gives the same results with sparse predictors as with
+ * the same predictors stored dense.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSparsePredictors)
+{
+  arma::mat data("1 0 3 0 0 2;"
+                 "0 0 2 1 0 0;"
+                 "2 0 0 4 1 0");
+  arma::sp_mat sparseData(data);
+  arma::vec responses("1 0 1 0 0 1");
+  arma::mat parameters("0.5; -1.2; 0.3; 2.0");
+
+  LogisticRegressionFunction lrf(data, responses, 0.3);
+  LogisticRegressionFunction sparseLrf(sparseData, responses, 0.3);
+  BOOST_REQUIRE(sparseLrf.IsSparse());
+  BOOST_REQUIRE_EQUAL(sparseLrf.NumFunctions(), 6);
+
+  BOOST_REQUIRE_CLOSE(sparseLrf.Evaluate(parameters), lrf.Evaluate(parameters),
+      1e-5);
+  BOOST_REQUIRE_CLOSE(sparseLrf.Evaluate(parameters, 1, 4),
+      lrf.Evaluate(parameters, 1, 4), 1e-5);
+
+  arma::mat gradient, sparseGradient;
+  lrf.Gradient(parameters, gradient);
+  sparseLrf.Gradient(parameters, sparseGradient);
+  for (size_t j = 0; j < 4; ++j)
+    BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+
+  lrf.Gradient(parameters, 1, 4, gradient);
+  sparseLrf.Gradient(parameters, 1, 4, sparseGradient);
+  for (size_t j = 0; j < 4; ++j)
+    BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+
+  for (size_t i = 0; i < 6; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(sparseLrf.Evaluate(parameters, i),
+        lrf.Evaluate(parameters, i), 1e-5);
+
+    lrf.Gradient(parameters, i, gradient);
+    sparseLrf.Gradient(parameters, i, sparseGradient);
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+  }
+
+  // Train on the sparse predictors with L-BFGS, and make sure the model is the
+  // same as with the dense predictors.
+  L_BFGS<LogisticRegressionFunction> lbfgsOpt(lrf);
+  LogisticRegression<L_BFGS> lr(lbfgsOpt);
+  L_BFGS<LogisticRegressionFunction> sparseLbfgsOpt(sparseLrf);
+  LogisticRegression<L_BFGS> sparseLr(sparseLbfgsOpt);
+
+  for (size_t j = 0; j < 4; ++j)
+    BOOST_REQUIRE_CLOSE(sparseLr.Parameters()[j], lr.Parameters()[j], 1e-3);
+}
+
+/**
+ * The batch Evaluate() and Gradient() should be the sums of the separable ones
+ * over the batch.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionBatchEvaluateAndGradient)
+{
+  arma::mat data;
+  data.randu(5, 100);
+  arma::vec responses(100);
+  for (size_t i = 0; i < 100; ++i)
+    responses[i] = (math::Random() > 0.5) ? 1 : 0;
+
+  LogisticRegressionFunction lrf(data, responses, 0.3);
+
+  arma::vec parameters;
+  parameters.randn(6);
+
+  double objective = 0.0;
+  arma::mat gradient;
+  gradient.zeros(6, 1);
+  arma::mat pointGradient;
+  for (size_t i = 30; i < 70; ++i)
+  {
+    objective += lrf.Evaluate(parameters, i);
+    lrf.Gradient(parameters, i, pointGradient);
+    gradient += pointGradient;
+  }
+
+  BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters, 30, 40), objective, 1e-8);
+
+  arma::mat batchGradient;
+  lrf.Gradient(parameters, 30, 40, batchGradient);
+  BOOST_REQUIRE_EQUAL(batchGradient.n_elem, 6);
+  for (size_t i = 0; i < 6; ++i)
+    BOOST_REQUIRE_CLOSE(batchGradient[i], gradient[i], 1e-8);
+
+  // The whole dataset as one batch is the full objective.
+  BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters, 0, 100),
+      lrf.Evaluate(parameters), 1e-8);
+}
+
 // Test training of logistic regression on a simple dataset.
 BOOST_AUTO_TEST_CASE(LogisticRegressionLBFGSSimpleTest)
 {
@@ -665,6 +839,122 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSGDGaussianTest)
   BOOST_REQUIRE_CLOSE(testAcc, 100.0, 0.6); // 0.6% error tolerance.
 }
 
+/**
+ * Train on two Gaussians with mini-batch SGD with momentum.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSGDBatchMomentumGaussianTest)
+{
+  // Generate a two-Gaussian dataset.
+  GaussianDistribution g1(arma::vec("1.0 1.0 1.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g2(arma::vec("9.0 9.0 9.0"), arma::eye<arma::mat>(3, 3));
+
+  arma::mat data(3, 1000);
+  arma::vec responses(1000);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    data.col(i) = g1.Random();
+    responses[i] = 0;
+  }
+  for (size_t i = 500; i < 1000; ++i)
+  {
+    data.col(i) = g2.Random();
+    responses[i] = 1;
+  }
+
+  LogisticRegressionFunction lrf(data, responses, 0.5);
+  SGD<LogisticRegressionFunction> sgdOpt(lrf);
+  sgdOpt.StepSize() = 0.001;
+  sgdOpt.BatchSize() = 25;
+  sgdOpt.Momentum() = 0.9;
+  LogisticRegression<SGD> lr(sgdOpt);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses);
+  BOOST_REQUIRE_CLOSE(acc, 100.0, 0.3); // 0.3% error tolerance.
+}
+
+/**
+ * Test logistic regression trained with Hogwild SGD steps on a two-Gaussian
+ * dataset.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionHogwildGaussianTest)
+{
+  // Generate a two-Gaussian dataset.
+  GaussianDistribution g1(arma::vec("1.0 1.0 1.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g2(arma::vec("9.0 9.0 9.0"), arma::eye<arma::mat>(3, 3));
+
+  arma::mat data(3, 1000);
+  arma::vec responses(1000);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    data.col(i) = g1.Random();
+    responses[i] = 0;
+  }
+  for (size_t i = 500; i < 1000; ++i)
+  {
+    data.col(i) = g2.Random();
+    responses[i] = 1;
+  }
+
+  LogisticRegressionFunction lrf(data, responses, 0.5);
+  SGD<LogisticRegressionFunction> sgdOpt(lrf);
+  sgdOpt.StepSize() = 0.005;
+  sgdOpt.Hogwild() = true;
+  sgdOpt.Threads() = 4;
+  LogisticRegression<SGD> lr(sgdOpt);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses);
+  BOOST_REQUIRE_CLOSE(acc, 100.0, 0.3); // 0.3% error tolerance.
+}
+
+/**
+ * Test logistic regression trained with SGD steps whose points (or batches of
+ * points) are sampled with replacement, with and without Hogwild steps.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSGDWithReplacementGaussianTest)
+{
+  // Generate a two-Gaussian dataset.
+  GaussianDistribution g1(arma::vec("1.0 1.0 1.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g2(arma::vec("9.0 9.0 9.0"), arma::eye<arma::mat>(3, 3));
+
+  arma::mat data(3, 1000);
+  arma::vec responses(1000);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    data.col(i) = g1.Random();
+    responses[i] = 0;
+  }
+  for (size_t i = 500; i < 1000; ++i)
+  {
+    data.col(i) = g2.Random();
+    responses[i] = 1;
+  }
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    LogisticRegressionFunction lrf(data, responses, 0.5);
+    SGD<LogisticRegressionFunction> sgdOpt(lrf);
+    sgdOpt.StepSize() = 0.005;
+    sgdOpt.SampleWithReplacement() = true;
+    if (mode == 1)
+    {
+      sgdOpt.StepSize() = 0.001;
+      sgdOpt.BatchSize() = 25;
+    }
+    else if (mode == 2)
+    {
+      sgdOpt.Hogwild() = true;
+      sgdOpt.Threads() = 4;
+    }
+    LogisticRegression<SGD> lr(sgdOpt);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses);
+    BOOST_REQUIRE_CLOSE(acc, 100.0, 0.3); // 0.3% error tolerance.
+  }
+}
+
 /**
  * Test constructor that takes an already-instantiated optimizer.
  */
@@ -706,4 +996,42 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionInstantiatedOptimizer)
   BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
 }
 
+/**
+ * The parallel sum of the separable objectives and gradients of the logistic
+ * regression function should match its full objective and gradient, and
+ * L-BFGS should train the same model with it.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionParallelSeparableTest)
+{
+  arma::mat data = arma::randn<arma::mat>(4, 1003);
+  arma::vec responses(1003);
+  for (size_t i = 0; i < 1003; ++i)
+    responses[i] = (data(0, i) + 0.5 * data(2, i) > 0.2) ? 1 : 0;
+
+  LogisticRegressionFunction lrf(data, responses, 0.3);
+  ParallelSeparableFunction<LogisticRegressionFunction> plrf(lrf, 4);
+
+  const arma::mat parameters = arma::randn<arma::mat>(5, 1);
+  arma::mat gradient, parallelGradient;
+  lrf.Gradient(parameters, gradient);
+  const double objective = lrf.Evaluate(parameters);
+  const double parallelObjective = plrf.EvaluateWithGradient(parameters,
+      parallelGradient);
+
+  BOOST_REQUIRE_CLOSE(parallelObjective, objective, 1e-8);
+  BOOST_REQUIRE_CLOSE(plrf.Evaluate(parameters), objective, 1e-8);
+  BOOST_REQUIRE_EQUAL(parallelGradient.n_rows, 5);
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_CLOSE(parallelGradient[i], gradient[i], 1e-6);
+
+  // Train with L-BFGS, with and without the adapter.
+  LogisticRegression<> lr(data, responses, 0.3);
+  L_BFGS<ParallelSeparableFunction<LogisticRegressionFunction> > lbfgs(plrf);
+  arma::mat parallelParameters(lrf.GetInitialPoint());
+  lbfgs.Optimize(parallelParameters);
+
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_SMALL(parallelParameters[i] - lr.Parameters()[i], 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -146,6 +146,114 @@ BOOST_AUTO_TEST_CASE(Johnson844LovaszThetaSDP)
   }
 }
 
+/**
+ * Make sure that each way of storing a constraint (dense, entries, sparse, and
+ * low-rank) gives the same constraint value and gradient, and that the
+ * augmented Lagrangian and its gradient match the dense formulas.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPConstraintModes)
+{
+  const size_t n = 20;
+  const size_t r = 3;
+
+  // A symmetric rank-one constraint matrix with some zeros.
+  arma::vec w = arma::randn<arma::vec>(n);
+  w.subvec(0, 4).zeros();
+  const arma::mat m = w * trans(w);
+
+  arma::mat coordinates = arma::randn<arma::mat>(n, r);
+  LRSDP sdp(4, coordinates);
+
+  sdp.SparseC() = arma::sp_mat(arma::mat(-m));
+  sdp.B().ones();
+
+  sdp.AModes()[0] = 0;
+  sdp.A()[0] = m;
+
+  size_t nonzero = 0;
+  sdp.AModes()[1] = 1;
+  sdp.A()[1].set_size(3, arma::accu(m != 0.0));
+  for (size_t j = 0; j < n; ++j)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (m(i, j) != 0.0)
+      {
+        sdp.A()[1](0, nonzero) = i;
+        sdp.A()[1](1, nonzero) = j;
+        sdp.A()[1](2, nonzero) = m(i, j);
+        ++nonzero;
+      }
+    }
+  }
+
+  sdp.AModes()[2] = 2;
+  sdp.SparseA()[2] = arma::sp_mat(m);
+
+  sdp.AModes()[3] = 3;
+  sdp.U()[3] = w;
+  sdp.V()[3] = w;
+
+  const arma::mat rrt = coordinates * trans(coordinates);
+  const double expected = arma::trace(m * rrt);
+  const arma::mat gradient = 2 * m * coordinates;
+
+  BOOST_REQUIRE_CLOSE(sdp.Evaluate(coordinates), -expected, 1e-5);
+
+  arma::vec constraints;
+  sdp.EvaluateConstraints(coordinates, constraints);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(sdp.EvaluateConstraint(i, coordinates), expected - 1.0,
+        1e-5);
+    BOOST_REQUIRE_CLOSE(constraints[i], expected - 1.0, 1e-5);
+
+    arma::mat constraintGradient;
+    sdp.GradientConstraint(i, coordinates, constraintGradient);
+    for (size_t j = 0; j < gradient.n_elem; ++j)
+    {
+      if (std::abs(gradient[j]) < 1e-10)
+        BOOST_REQUIRE_SMALL(constraintGradient[j], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(constraintGradient[j], gradient[j], 1e-5);
+    }
+  }
+
+  // Evaluating the constraints in parallel gives the same values.
+  sdp.Threads() = 0;
+  arma::vec parallelConstraints;
+  sdp.EvaluateConstraints(coordinates, parallelConstraints);
+  for (size_t i = 0; i < 4; ++i)
+    BOOST_REQUIRE_EQUAL(parallelConstraints[i], constraints[i]);
+
+  // The augmented Lagrangian.
+  AugLagrangianFunction<LRSDP> f(sdp);
+  f.Lambda() = arma::randn<arma::vec>(4);
+  f.Sigma() = 3.0;
+
+  double objective = -expected;
+  arma::mat s = -m;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    objective += -f.Lambda()[i] * (expected - 1.0) +
+        (f.Sigma() / 2) * std::pow(expected - 1.0, 2.0);
+    s -= (f.Lambda()[i] - f.Sigma() * (expected - 1.0)) * m;
+  }
+  const arma::mat lagrangianGradient = 2 * s * coordinates;
+
+  BOOST_REQUIRE_CLOSE(f.Evaluate(coordinates), objective, 1e-5);
+
+  arma::mat fGradient;
+  f.Gradient(coordinates, fGradient);
+  for (size_t j = 0; j < lagrangianGradient.n_elem; ++j)
+  {
+    if (std::abs(lagrangianGradient[j]) < 1e-10)
+      BOOST_REQUIRE_SMALL(fGradient[j], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(fGradient[j], lagrangianGradient[j], 1e-5);
+  }
+}
+
 /**
  * keller4.co test case for Lovasz-Theta LRSDP.
  * This is commented out because it takes a long time to run.
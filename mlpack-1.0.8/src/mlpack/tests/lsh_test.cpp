@@ -1,7 +1,7 @@
 /**
  * @file lsh_test.cpp
  *
- * Unit tests for the 'LSHSearch' class.
+ * Unit tests for the 'LSHSearch' and 'SimHashSearch' classes.
  *
  * This file is part of MLPACK 1.0.8.
  *
@@ -24,6 +24,7 @@
 #include "old_boost_test_definitions.hpp"
 
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/lsh/simhash_search.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -76,16 +77,14 @@ BOOST_AUTO_TEST_CASE(LSHSearchTest)
   LSHSearch<> lsh_test(rdata, qdata, 3, 2, hashWidth, 11, 3);
 //   LSHSearch<> lsh_test(rdata, qdata, 3, 2, 0.0, 11, 3);
 
-  // Given this, the 'LSHSearch::bucketRowInHashTable' should be:
-  // COR.SOL.: [2 11 4 7 6 3 11 0 5 1 8]
-  //
-  // The 'LSHSearch::bucketContentSize' should be:
+  // Given this, the number of points in each bucket should be:
   // COR.SOL.: [2 0 1 1 3 1 0 3 3 3 1]
   //
-  // The final hash table 'LSHSearch::secondHashTable' should be
-  // of size (3 x 9) with the following content:
-  // COR.SOL.:
-  // [0 2 4; 1 7 8; 3 9 10; 5 10 10; 6 10 10; 0 5 6; 1 2 8; 3 10 10; 4 10 10]
+  // So the 'LSHSearch::bucketStart' should be:
+  // COR.SOL.: [0 2 2 3 4 7 8 8 11 14 17 18]
+  //
+  // The final hash table contents 'LSHSearch::bucketContents' should be:
+  // COR.SOL.: [3 9 | 6 | 3 | 1 2 8 | 5 | 0 2 4 | 0 5 6 | 1 7 8 | 4]
 
   arma::Mat<size_t> neighbors;
   arma::mat distances;
@@ -123,4 +122,316 @@ BOOST_AUTO_TEST_CASE(LSHSearchTest)
   }
 }
 
+// Multi-probe search always searches the bucket each query hashes to, so its
+// candidates are a superset of those of the plain search, and the neighbors
+// it finds can only be closer.  Probing more buckets should find more of the
+// true nearest neighbors.
+BOOST_AUTO_TEST_CASE(MultiProbeTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata(4, 1000);
+  rdata.randu();
+  arma::mat qdata(4, 100);
+  qdata.randu();
+
+  LSHSearch<> lsh(rdata, qdata, 10, 2);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(3, neighbors, distances);
+
+  arma::Mat<size_t> probeNeighbors;
+  arma::mat probeDistances;
+  lsh.Search(3, probeNeighbors, probeDistances, 0, 20);
+
+  // Find the true nearest neighbors.
+  arma::Col<size_t> trueNeighbors(qdata.n_cols);
+  for (size_t i = 0; i < qdata.n_cols; ++i)
+  {
+    double best = DBL_MAX;
+    for (size_t j = 0; j < rdata.n_cols; ++j)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          qdata.unsafe_col(i), rdata.unsafe_col(j));
+      if (distance < best)
+      {
+        best = distance;
+        trueNeighbors[i] = j;
+      }
+    }
+  }
+
+  size_t found = 0;
+  size_t probeFound = 0;
+  for (size_t i = 0; i < qdata.n_cols; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_LE(probeDistances(j, i), distances(j, i));
+
+    if (neighbors(0, i) == trueNeighbors[i])
+      ++found;
+    if (probeNeighbors(0, i) == trueNeighbors[i])
+      ++probeFound;
+  }
+
+  BOOST_REQUIRE_GE(probeFound, found);
+  BOOST_REQUIRE_GT(probeFound, 0);
+}
+
+// A saved and loaded hash should give exactly the same results as the hash it
+// was saved from.
+BOOST_AUTO_TEST_CASE(LSHSaveLoadTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata(4, 1000);
+  rdata.randu();
+  arma::mat qdata(4, 100);
+  qdata.randu();
+
+  LSHSearch<> lsh(rdata, qdata, 10, 4, 0.0, 99901, 20);
+  lsh.Save("test-lsh-index.bin");
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(3, neighbors, distances, 0, 5);
+
+  LSHSearch<> loaded("test-lsh-index.bin", rdata, qdata);
+
+  arma::Mat<size_t> loadedNeighbors;
+  arma::mat loadedDistances;
+  loaded.Search(3, loadedNeighbors, loadedDistances, 0, 5);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(loadedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_EQUAL(loadedDistances[i], distances[i]);
+  }
+
+  remove("test-lsh-index.bin");
+}
+
+// The distances approximated from the codes should be the distances to the
+// decoded points, and scalar quantization should decode each value to within
+// half a step of the grid.
+BOOST_AUTO_TEST_CASE(QuantizedMatrixTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat data(4, 500);
+  data.randu();
+  arma::vec query(4);
+  query.randu();
+
+  QuantizedMatrix scalar(data);
+  BOOST_REQUIRE_EQUAL(scalar.Subspaces(), 4);
+  BOOST_REQUIRE(scalar.Scalar());
+
+  QuantizedMatrix product(data, 2);
+  BOOST_REQUIRE_EQUAL(product.Subspaces(), 2);
+  BOOST_REQUIRE(!product.Scalar());
+
+  const arma::vec mins = arma::min(data, 1);
+  const arma::vec maxs = arma::max(data, 1);
+
+  arma::mat scalarTable, productTable;
+  scalar.DistanceTable(query, scalarTable);
+  product.DistanceTable(query, productTable);
+
+  arma::vec decoded;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    scalar.Decode(i, decoded);
+    for (size_t d = 0; d < data.n_rows; ++d)
+      BOOST_REQUIRE_LE(std::abs(decoded[d] - data(d, i)),
+          (maxs[d] - mins[d]) / 510.0 + 1e-10);
+
+    BOOST_REQUIRE_CLOSE(scalar.Distance(scalarTable, i),
+        metric::SquaredEuclideanDistance::Evaluate(query, decoded), 1e-5);
+
+    product.Decode(i, decoded);
+    BOOST_REQUIRE_CLOSE(product.Distance(productTable, i),
+        metric::SquaredEuclideanDistance::Evaluate(query, decoded), 1e-5);
+  }
+}
+
+// With quantized reference points and re-ranking, the distances returned
+// should be the exact distances to the neighbors, in order.
+BOOST_AUTO_TEST_CASE(LSHQuantizedSearchTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata(4, 1000);
+  rdata.randu();
+  arma::mat qdata(4, 100);
+  qdata.randu();
+
+  for (size_t subspaces = 0; subspaces <= 2; subspaces += 2)
+  {
+    LSHSearch<> lsh(rdata, qdata, 10, 4);
+    lsh.Quantize(subspaces);
+    lsh.Rerank() = 20;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    lsh.Search(3, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, 3);
+    BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
+    for (size_t i = 0; i < qdata.n_cols; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+      {
+        if (neighbors(j, i) == rdata.n_cols)
+          break;
+
+        BOOST_REQUIRE_CLOSE(distances(j, i),
+            metric::SquaredEuclideanDistance::Evaluate(qdata.unsafe_col(i),
+            rdata.unsafe_col(neighbors(j, i))), 1e-5);
+        if (j > 0)
+          BOOST_REQUIRE_LE(distances(j - 1, i), distances(j, i));
+      }
+    }
+  }
+}
+
+// Building the hash with several threads must give the same hash as building
+// it with one, even when the buckets fill up (so that the order the points are
+// put in matters) and there are several chunks of points.
+BOOST_AUTO_TEST_CASE(LSHParallelBuildTest)
+{
+  arma::mat rdata(3, 70000);
+  rdata.randu();
+  arma::mat qdata(3, 100);
+  qdata.randu();
+
+  math::RandomSeed(5);
+  LSHSearch<> serial(rdata, qdata, 4, 3, 0.5, 101, 50, 1);
+  math::RandomSeed(5);
+  LSHSearch<> parallel(rdata, qdata, 4, 3, 0.5, 101, 50, 4);
+
+  arma::Mat<size_t> serialNeighbors, parallelNeighbors;
+  arma::mat serialDistances, parallelDistances;
+  serial.Search(5, serialNeighbors, serialDistances);
+  parallel.Search(5, parallelNeighbors, parallelDistances);
+
+  for (size_t i = 0; i < serialNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelNeighbors[i], serialNeighbors[i]);
+    BOOST_REQUIRE_EQUAL(parallelDistances[i], serialDistances[i]);
+  }
+}
+
+// Inserted points must be found by the next search, and removed points must
+// not be returned.
+BOOST_AUTO_TEST_CASE(LSHInsertRemoveTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata(4, 1000);
+  rdata.randu();
+  arma::mat newPoints(4, 50);
+  newPoints.randu();
+
+  // Query with copies of the new points and of some reference points, which
+  // hash to the same buckets as the originals.
+  arma::mat qdata = arma::join_rows(newPoints, rdata.cols(0, 49));
+
+  LSHSearch<> lsh(rdata, qdata, 10, 4);
+  lsh.Insert(newPoints.cols(0, 19));
+  lsh.Insert(newPoints.cols(20, 49));
+  BOOST_REQUIRE_EQUAL(lsh.NumInserted(), 50);
+  BOOST_REQUIRE_EQUAL(lsh.NumPoints(), 1050);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(1, neighbors, distances);
+
+  for (size_t i = 0; i < 50; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(0, i), 1000 + i);
+    BOOST_REQUIRE_SMALL(distances(0, i), 1e-10);
+    BOOST_REQUIRE_EQUAL(neighbors(0, 50 + i), i);
+  }
+
+  // Remove half of the new points and half of the reference points.
+  for (size_t i = 0; i < 50; i += 2)
+  {
+    lsh.Remove(1000 + i);
+    lsh.Remove(i);
+  }
+  BOOST_REQUIRE_EQUAL(lsh.NumRemoved(), 50);
+
+  lsh.Search(1, neighbors, distances);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    if (i % 2 == 0)
+    {
+      BOOST_REQUIRE_NE(neighbors(0, i), 1000 + i);
+      BOOST_REQUIRE_NE(neighbors(0, 50 + i), i);
+    }
+    else
+    {
+      BOOST_REQUIRE_EQUAL(neighbors(0, i), 1000 + i);
+      BOOST_REQUIRE_EQUAL(neighbors(0, 50 + i), i);
+    }
+  }
+}
+
+// SimHash search must find a scaled copy of a reference point with similarity
+// 1, and its results must be exact cosine similarities, sorted, among all the
+// candidates when every candidate is reranked.
+BOOST_AUTO_TEST_CASE(SimHashSearchTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata(10, 1000);
+  rdata.randn();
+  // The queries are scaled copies of the first 100 reference points, which
+  // have the same signatures as the originals.
+  arma::mat qdata = 3.0 * rdata.cols(0, 99);
+
+  SimHashSearch simhash(rdata, qdata, 12, 8);
+  BOOST_REQUIRE_EQUAL(simhash.NumBits(), 12);
+  BOOST_REQUIRE_EQUAL(simhash.NumTables(), 8);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat similarities;
+  simhash.Search(3, neighbors, similarities);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, 100);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(0, i), i);
+    BOOST_REQUIRE_CLOSE(similarities(0, i), 1.0, 1e-8);
+
+    for (size_t j = 1; j < 3; ++j)
+    {
+      BOOST_REQUIRE_LE(similarities(j, i), similarities(j - 1, i));
+      if (neighbors(j, i) == rdata.n_cols)
+        continue;
+
+      const double similarity = arma::dot(qdata.col(i),
+          rdata.col(neighbors(j, i))) / (arma::norm(qdata.col(i), 2) *
+          arma::norm(rdata.col(neighbors(j, i)), 2));
+      BOOST_REQUIRE_CLOSE(similarities(j, i), similarity, 1e-8);
+    }
+  }
+
+  // With reranking by Hamming distance, the copy (at distance 0) must still be
+  // found first.
+  simhash.Search(1, neighbors, similarities, 5);
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_REQUIRE_EQUAL(neighbors(0, i), i);
+
+  // When the reference set is the query set, the points are not their own
+  // neighbors.
+  SimHashSearch monochromatic(rdata, 12, 8, 2);
+  monochromatic.Search(1, neighbors, similarities);
+  for (size_t i = 0; i < rdata.n_cols; ++i)
+    BOOST_REQUIRE_NE(neighbors(0, i), i);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -593,4 +593,81 @@ BOOST_AUTO_TEST_CASE(RangeContainsRange)
   BOOST_REQUIRE_EQUAL(b.Contains(a), true);
 }
 
+/**
+ * Streams with the same seed and index give the same numbers, and split
+ * streams depend only on the seed and the index they are split with.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamTest)
+{
+  RandomStream a(42, 3);
+  RandomStream b(42, 3);
+  RandomStream c(42, 4);
+
+  size_t same = 0;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const double x = a.Random();
+    BOOST_REQUIRE_EQUAL(x, b.Random());
+    BOOST_REQUIRE_GE(x, 0.0);
+    BOOST_REQUIRE_LT(x, 1.0);
+    if (x == c.Random())
+      ++same;
+  }
+  BOOST_REQUIRE_LT(same, 5);
+
+  // a has drawn numbers, and b has not.
+  RandomStream splitA = a.Split(7);
+  RandomStream splitB = RandomStream(42, 3).Split(7);
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_REQUIRE_EQUAL(splitA.RandNormal(), splitB.RandNormal());
+}
+
+/**
+ * Each thread of a parallel region draws the same numbers after the same call
+ * to RandomSeed().
+ */
+BOOST_AUTO_TEST_CASE(ThreadStreamTest)
+{
+  arma::mat first(100, 4);
+  arma::mat second(100, 4);
+  for (size_t run = 0; run < 2; ++run)
+  {
+    arma::mat& numbers = (run == 0) ? first : second;
+    RandomSeed(7);
+
+    #pragma omp parallel for num_threads(4) schedule(static, 1)
+    for (int t = 0; t < 4; ++t)
+      for (size_t i = 0; i < numbers.n_rows; ++i)
+        numbers(i, t) = Random();
+  }
+
+  for (size_t i = 0; i < first.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(first[i], second[i]);
+}
+
+/**
+ * Filling a matrix should be reproducible with RandomSeed(), and the numbers
+ * should have the right distribution.
+ */
+BOOST_AUTO_TEST_CASE(RandomFillTest)
+{
+  arma::mat a(50, 2000);
+  arma::mat b(50, 2000);
+
+  RandomSeed(3);
+  RandNormal(a);
+  RandomSeed(3);
+  RandNormal(b);
+
+  for (size_t i = 0; i < a.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(a[i], b[i]);
+  BOOST_REQUIRE_SMALL(arma::accu(a) / a.n_elem, 0.01);
+  BOOST_REQUIRE_CLOSE(arma::accu(arma::square(a)) / a.n_elem, 1.0, 2.0);
+
+  Random(a);
+  BOOST_REQUIRE_GE(a.min(), 0.0);
+  BOOST_REQUIRE_LT(a.max(), 1.0);
+  BOOST_REQUIRE_CLOSE(arma::accu(a) / a.n_elem, 0.5, 1.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -20,6 +20,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -97,4 +98,165 @@ BOOST_AUTO_TEST_CASE(LINFMetricTest)
                       lMetric.Evaluate(a2, b2), 1e-5);
 }
 
+/**
+ * Make sure the kernels for single-precision vectors and the point-to-block
+ * variant give the same results as the Armadillo expressions.
+ */
+BOOST_AUTO_TEST_CASE(LMetricKernelTest)
+{
+  // An odd dimensionality, so that the tail of the kernel loops is used.
+  arma::mat points(13, 20);
+  points.randn();
+  arma::fmat fpoints = arma::conv_to<arma::fmat>::from(points);
+
+  const arma::vec a = points.col(0);
+  const arma::fvec fa = fpoints.col(0);
+
+  arma::vec distances;
+  EuclideanDistance::Evaluate(a, points, 5, 10, distances);
+  BOOST_REQUIRE_EQUAL(distances.n_elem, 10);
+
+  for (size_t i = 1; i < points.n_cols; ++i)
+  {
+    const arma::vec b = points.col(i);
+    const arma::fvec fb = fpoints.col(i);
+
+    BOOST_REQUIRE_CLOSE(ManhattanDistance::Evaluate(fa, fb),
+        (double) arma::accu(arma::abs(a - b)), 1e-3);
+    BOOST_REQUIRE_CLOSE(SquaredEuclideanDistance::Evaluate(fa, fb),
+        (double) arma::accu(arma::square(a - b)), 1e-3);
+    BOOST_REQUIRE_CLOSE(ChebyshevDistance::Evaluate(fa, fb),
+        (double) arma::as_scalar(arma::max(arma::abs(a - b))), 1e-3);
+    BOOST_REQUIRE_CLOSE(LMetric<3>::Evaluate(a, b),
+        pow(arma::accu(arma::pow(arma::abs(a - b), 3.0)), 1.0 / 3.0), 1e-5);
+
+    if (i >= 5 && i < 15)
+      BOOST_REQUIRE_CLOSE(distances[i - 5],
+          sqrt(arma::accu(arma::square(a - b))), 1e-5);
+  }
+}
+
+/**
+ * Make sure the kernels of simd_kernels.hpp (which use NEON on ARM targets)
+ * give the same results as simple loops, for every dimensionality up to 17 so
+ * that each tail length is used.
+ */
+BOOST_AUTO_TEST_CASE(SIMDKernelTest)
+{
+  for (size_t n = 0; n <= 17; ++n)
+  {
+    arma::mat points(n, 4);
+    points.randn();
+    arma::fmat fpoints = arma::conv_to<arma::fmat>::from(points);
+
+    double squared = 0, dot = 0, minSquared = 0, maxSquared = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      squared += pow(points(i, 0) - points(i, 1), 2.0);
+      dot += points(i, 0) * points(i, 1);
+
+      // Boxes from columns 0 and 1 and from columns 2 and 3.
+      const double lo = std::min(points(i, 0), points(i, 1));
+      const double hi = std::max(points(i, 0), points(i, 1));
+      const double otherLo = std::min(points(i, 2), points(i, 3));
+      const double otherHi = std::max(points(i, 2), points(i, 3));
+      const double gap = std::max(0.0, std::max(otherLo - hi, lo - otherHi));
+      const double span = std::max(otherHi - lo, hi - otherLo);
+      minSquared += gap * gap;
+      maxSquared += span * span;
+    }
+
+    BOOST_REQUIRE_SMALL(mlpack::math::SquaredDistance(points.colptr(0),
+        points.colptr(1), n) - squared, 1e-10);
+    BOOST_REQUIRE_SMALL(mlpack::math::SquaredDistance(fpoints.colptr(0),
+        fpoints.colptr(1), n) - squared, 1e-3);
+    BOOST_REQUIRE_SMALL(mlpack::math::Dot(points.colptr(0), points.colptr(1),
+        n) - dot, 1e-10);
+    BOOST_REQUIRE_SMALL(mlpack::math::Dot(fpoints.colptr(0),
+        fpoints.colptr(1), n) - dot, 1e-3);
+
+    const arma::mat lo = arma::min(points.cols(0, 1), 1);
+    const arma::mat hi = arma::max(points.cols(0, 1), 1);
+    const arma::mat otherLo = arma::min(points.cols(2, 3), 1);
+    const arma::mat otherHi = arma::max(points.cols(2, 3), 1);
+    BOOST_REQUIRE_SMALL(mlpack::math::BoxMinSquaredDistance(lo.memptr(),
+        hi.memptr(), otherLo.memptr(), otherHi.memptr(), n) - minSquared,
+        1e-10);
+    BOOST_REQUIRE_SMALL(mlpack::math::BoxMaxSquaredDistance(lo.memptr(),
+        hi.memptr(), otherLo.memptr(), otherHi.memptr(), n) - maxSquared,
+        1e-10);
+  }
+}
+
+/**
+ * Single-precision distances and dot products over long vectors should be as
+ * accurate as the double-precision ones computed on the same (rounded) data.
+ */
+BOOST_AUTO_TEST_CASE(FloatAccumulationTest)
+{
+  const size_t n = 100000;
+  arma::fmat fpoints(n, 2);
+  fpoints.randu();
+  const arma::mat points = arma::conv_to<arma::mat>::from(fpoints);
+
+  const double squared = mlpack::math::SquaredDistance(points.colptr(0),
+      points.colptr(1), n);
+  const double dot = mlpack::math::Dot(points.colptr(0), points.colptr(1), n);
+  const double manhattan = ManhattanDistance::Evaluate(points.colptr(0),
+      points.colptr(1), n);
+
+  BOOST_REQUIRE_CLOSE(mlpack::math::SquaredDistance(fpoints.colptr(0),
+      fpoints.colptr(1), n), squared, 1e-4);
+  BOOST_REQUIRE_CLOSE(mlpack::math::Dot(fpoints.colptr(0), fpoints.colptr(1),
+      n), dot, 1e-4);
+  BOOST_REQUIRE_CLOSE(ManhattanDistance::Evaluate(fpoints.colptr(0),
+      fpoints.colptr(1), n), manhattan, 1e-4);
+}
+
+/**
+ * Make sure the batched evaluation of MahalanobisDistance and the Euclidean
+ * distances between transformed points match the pairwise evaluation.
+ */
+BOOST_AUTO_TEST_CASE(MahalanobisTransformTest)
+{
+  arma::mat points(5, 30);
+  points.randn();
+
+  // A positive definite covariance.
+  arma::mat l(5, 5);
+  l.randn();
+  arma::mat covariance = trans(l) * l + 0.5 * arma::eye<arma::mat>(5, 5);
+
+  MahalanobisDistance<> squared(covariance);
+  MahalanobisDistance<true> rooted(covariance);
+
+  arma::mat transformed;
+  rooted.Transform(points, transformed);
+  BOOST_REQUIRE_EQUAL(rooted.Factor().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(transformed.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(transformed.n_cols, 30);
+
+  const arma::vec a = points.col(0);
+  arma::vec squaredDistances, rootedDistances;
+  squared.Evaluate(a, points, squaredDistances);
+  rooted.Evaluate(a, points, rootedDistances);
+  BOOST_REQUIRE_EQUAL(squaredDistances.n_elem, 30);
+
+  for (size_t i = 1; i < points.n_cols; ++i)
+  {
+    const arma::vec b = points.col(i);
+    const double distance = squared.Evaluate(a, b);
+
+    BOOST_REQUIRE_CLOSE(squaredDistances[i], distance, 1e-5);
+    BOOST_REQUIRE_CLOSE(rootedDistances[i], sqrt(distance), 1e-5);
+    BOOST_REQUIRE_CLOSE(EuclideanDistance::Evaluate(transformed.col(0),
+        transformed.col(i)), sqrt(distance), 1e-5);
+  }
+  BOOST_REQUIRE_SMALL(squaredDistances[0], 1e-10);
+
+  // Modifying the covariance must forget the factor.
+  rooted.Covariance() *= 2.0;
+  BOOST_REQUIRE_EQUAL(rooted.Factor().n_elem, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -20,6 +20,8 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
+#include <mlpack/methods/naive_bayes/multinomial_naive_bayes_classifier.hpp>
+#include <mlpack/methods/gmm/phi.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -82,4 +84,162 @@ BOOST_AUTO_TEST_CASE(NaiveBayesClassifierTest)
     BOOST_REQUIRE_EQUAL(testRes(i), calcVec(i));
 }
 
+/**
+ * Training in several batches gives the same model as training on all the
+ * points at once.
+ */
+BOOST_AUTO_TEST_CASE(NaiveBayesClassifierIncrementalTest)
+{
+  arma::mat data;
+  data.randn(4, 300);
+  arma::Col<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+  {
+    labels[i] = math::RandInt(3);
+    data.col(i) += 3.0 * labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, 3);
+
+  NaiveBayesClassifier<> incremental(4, 3);
+  const size_t batchBounds[] = { 0, 1, 70, 71, 200, 300 };
+  for (size_t b = 0; b < 5; ++b)
+  {
+    const arma::mat batch = data.cols(batchBounds[b], batchBounds[b + 1] - 1);
+    const arma::Col<size_t> batchLabels = labels.subvec(batchBounds[b],
+        batchBounds[b + 1] - 1);
+    incremental.Train(batch, batchLabels);
+  }
+
+  for (size_t c = 0; c < 3; ++c)
+  {
+    BOOST_REQUIRE_CLOSE(incremental.Probabilities()[c],
+        nbc.Probabilities()[c], 1e-5);
+    BOOST_REQUIRE_CLOSE(incremental.Counts()[c], nbc.Counts()[c], 1e-5);
+    for (size_t d = 0; d < 4; ++d)
+    {
+      BOOST_REQUIRE_CLOSE(incremental.Means()(d, c), nbc.Means()(d, c), 1e-5);
+      BOOST_REQUIRE_CLOSE(incremental.Variances()(d, c),
+          nbc.Variances()(d, c), 1e-5);
+
+      // Compare against the sample moments computed directly, too.
+      const arma::uvec points = arma::find(labels == c);
+      arma::rowvec values(points.n_elem);
+      for (size_t i = 0; i < points.n_elem; ++i)
+        values[i] = data(d, points[i]);
+
+      BOOST_REQUIRE_CLOSE(nbc.Means()(d, c), arma::mean(values), 1e-5);
+      BOOST_REQUIRE_CLOSE(nbc.Variances()(d, c), arma::var(values), 1e-5);
+    }
+  }
+}
+
+/**
+ * The log-space joint probabilities are the same as computing the Gaussian
+ * densities of each point and class directly.
+ */
+BOOST_AUTO_TEST_CASE(NaiveBayesClassifierLogLikelihoodsTest)
+{
+  arma::mat data;
+  data.randn(3, 200);
+  arma::Col<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+  {
+    labels[i] = i % 2;
+    data.col(i) += 2.0 * labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, 2);
+
+  arma::mat testData;
+  testData.randn(3, 50);
+  arma::mat logLikelihoods;
+  nbc.LogLikelihoods(testData, logLikelihoods);
+
+  BOOST_REQUIRE_EQUAL(logLikelihoods.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(logLikelihoods.n_cols, 50);
+  for (size_t n = 0; n < 50; ++n)
+  {
+    for (size_t i = 0; i < 2; ++i)
+    {
+      const double expected = log(nbc.Probabilities()[i]) +
+          log(gmm::phi(testData.unsafe_col(n), nbc.Means().unsafe_col(i),
+          diagmat(nbc.Variances().unsafe_col(i))));
+      BOOST_REQUIRE_CLOSE(logLikelihoods(i, n), expected, 1e-5);
+    }
+  }
+}
+
+/**
+ * Train the multinomial classifier on counts drawn from two very different
+ * feature distributions, with both sparse and dense storage.
+ */
+BOOST_AUTO_TEST_CASE(MultinomialNaiveBayesClassifierTest)
+{
+  // Class 0 mostly uses features 0-4, and class 1 mostly uses features 5-9.
+  arma::mat data = arma::zeros<arma::mat>(10, 400);
+  arma::Col<size_t> labels(400);
+  for (size_t i = 0; i < 400; ++i)
+  {
+    labels[i] = i % 2;
+    for (size_t w = 0; w < 8; ++w)
+    {
+      const size_t feature = (math::Random() < 0.9) ?
+          (5 * labels[i] + math::RandInt(5)) : math::RandInt(10);
+      data(feature, i) += 1;
+    }
+  }
+  arma::sp_mat sparseData(data);
+
+  MultinomialNaiveBayesClassifier<> nbc(sparseData, labels, 2);
+  MultinomialNaiveBayesClassifier<arma::mat> denseNbc(data, labels, 2);
+
+  // The counts are exactly the feature counts of each class.
+  for (size_t d = 0; d < 10; ++d)
+  {
+    double count0 = 0.0, count1 = 0.0;
+    for (size_t i = 0; i < 400; ++i)
+      ((labels[i] == 0) ? count0 : count1) += data(d, i);
+
+    BOOST_REQUIRE_CLOSE(nbc.FeatureCounts()(d, 0) + 1.0, count0 + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(nbc.FeatureCounts()(d, 1) + 1.0, count1 + 1.0, 1e-5);
+  }
+
+  // The feature probabilities of each class sum to one.
+  for (size_t i = 0; i < 2; ++i)
+    BOOST_REQUIRE_CLOSE(arma::accu(arma::exp(
+        nbc.LogFeatureProbabilities().row(i))), 1.0, 1e-5);
+
+  arma::mat logLikelihoods, denseLogLikelihoods;
+  nbc.LogLikelihoods(sparseData, logLikelihoods);
+  denseNbc.LogLikelihoods(data, denseLogLikelihoods);
+  for (size_t i = 0; i < logLikelihoods.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(logLikelihoods[i], denseLogLikelihoods[i], 1e-5);
+
+  arma::Col<size_t> results, denseResults;
+  nbc.Classify(sparseData, results);
+  denseNbc.Classify(data, denseResults);
+
+  size_t correct = 0;
+  for (size_t i = 0; i < 400; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(results[i], denseResults[i]);
+    if (results[i] == labels[i])
+      ++correct;
+  }
+  BOOST_REQUIRE_GT(correct, 390);
+
+  // Training in two batches gives the same model.
+  MultinomialNaiveBayesClassifier<> incremental(10, 2);
+  const arma::sp_mat firstBatch = sparseData.cols(0, 149);
+  const arma::sp_mat secondBatch = sparseData.cols(150, 399);
+  const arma::Col<size_t> firstLabels = labels.subvec(0, 149);
+  const arma::Col<size_t> secondLabels = labels.subvec(150, 399);
+  incremental.Train(firstBatch, firstLabels);
+  incremental.Train(secondBatch, secondLabels);
+  for (size_t i = 0; i < nbc.LogFeatureProbabilities().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(incremental.LogFeatureProbabilities()[i],
+        nbc.LogFeatureProbabilities()[i], 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -259,10 +259,156 @@ BOOST_AUTO_TEST_CASE(SoftmaxSeparableGradient)
   BOOST_REQUIRE_CLOSE(gradient(1, 1), -2.0 * -0.1435886, 0.01);
 }
 
+/**
+ * With a cutoff larger than any distance, or with several threads, the
+ * non-separable objective and gradient should be the same as with all pairs;
+ * with a cutoff beyond which the kernel is negligible, they should be very
+ * close.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxCutoffAndThreads)
+{
+  arma::mat data;
+  data.randn(3, 300);
+  arma::Col<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+    labels[i] = (data(0, i) > 0.0) ? 1 : 0;
+
+  arma::mat coordinates = arma::eye<arma::mat>(3, 3);
+  coordinates(1, 0) = 0.3;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  const double objective = sef.Evaluate(coordinates);
+  arma::mat gradient;
+  sef.Gradient(coordinates, gradient);
+
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    SoftmaxErrorFunction<SquaredEuclideanDistance> sefCutoff(data, labels);
+    if (trial == 0)
+      sefCutoff.Cutoff() = 1e10;
+    else if (trial == 1)
+      sefCutoff.Threads() = 2;
+    else
+      sefCutoff.Cutoff() = 6.0; // exp(-36) is negligible.
+
+    const double tolerance = (trial == 2) ? 1e-5 : 1e-8;
+
+    BOOST_REQUIRE_CLOSE(sefCutoff.Evaluate(coordinates), objective,
+        tolerance);
+
+    arma::mat cutoffGradient;
+    sefCutoff.Gradient(coordinates, cutoffGradient);
+    BOOST_REQUIRE_EQUAL(cutoffGradient.n_rows, gradient.n_rows);
+    BOOST_REQUIRE_EQUAL(cutoffGradient.n_cols, gradient.n_cols);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+    {
+      if (std::abs(gradient[i]) < 1e-8)
+        BOOST_REQUIRE_SMALL(cutoffGradient[i], 1e-8);
+      else
+        BOOST_REQUIRE_CLOSE(cutoffGradient[i], gradient[i], tolerance);
+    }
+  }
+}
+
+/**
+ * The batch objective and gradient should be the sums of the separable
+ * objectives and gradients of the points in the batch, with any number of
+ * threads.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxBatchObjectiveAndGradient)
+{
+  arma::mat data;
+  data.randn(3, 100);
+  arma::Col<size_t> labels(100);
+  for (size_t i = 0; i < 100; ++i)
+    labels[i] = (data(1, i) > 0.0) ? 1 : 0;
+
+  arma::mat coordinates = arma::eye<arma::mat>(3, 3);
+  coordinates(2, 1) = -0.5;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+
+  double objective = 0;
+  arma::mat gradient;
+  gradient.zeros(3, 3);
+  arma::mat pointGradient;
+  for (size_t i = 20; i < 45; ++i)
+  {
+    objective += sef.Evaluate(coordinates, i);
+    sef.Gradient(coordinates, i, pointGradient);
+    gradient += pointGradient;
+  }
+
+  for (size_t threads = 1; threads <= 2; ++threads)
+  {
+    SoftmaxErrorFunction<SquaredEuclideanDistance> sefBatch(data, labels);
+    sefBatch.Threads() = threads;
+
+    BOOST_REQUIRE_CLOSE(sefBatch.Evaluate(coordinates, 20, 25), objective,
+        1e-8);
+
+    arma::mat batchGradient;
+    sefBatch.Gradient(coordinates, 20, 25, batchGradient);
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(batchGradient[i], gradient[i], 1e-8);
+  }
+}
+
 //
 // Tests for the NCA algorithm.
 //
 
+/**
+ * With an output dimensionality smaller than the dimensionality of the data,
+ * the coordinates are rectangular; the non-separable gradient must match finite
+ * differences of the objective, and the separable gradients must sum to it.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRectangularGradient)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 30);
+  arma::Col<size_t> labels(30);
+  for (size_t i = 0; i < 30; ++i)
+    labels[i] = i % 3;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  sef.OutputDimensionality() = 2;
+
+  const arma::mat initialPoint = sef.GetInitialPoint();
+  BOOST_REQUIRE_EQUAL(initialPoint.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(initialPoint.n_cols, 5);
+
+  arma::mat coordinates = arma::randu<arma::mat>(2, 5);
+  arma::mat gradient;
+  sef.Gradient(coordinates, gradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, 5);
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+  {
+    arma::mat plus = coordinates;
+    arma::mat minus = coordinates;
+    plus[i] += h;
+    minus[i] -= h;
+
+    const double estimate = (sef.Evaluate(plus) - sef.Evaluate(minus)) /
+        (2 * h);
+    BOOST_REQUIRE_SMALL(gradient[i] - estimate, 1e-5);
+  }
+
+  arma::mat separableSum;
+  separableSum.zeros(2, 5);
+  arma::mat pointGradient;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    sef.Gradient(coordinates, i, pointGradient);
+    separableSum += pointGradient;
+  }
+
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(separableSum[i] - gradient[i], 1e-8);
+}
+
 /**
  * On our simple dataset, ensure that the NCA algorithm fully separates the
  * points.
@@ -301,6 +447,36 @@ BOOST_AUTO_TEST_CASE(NCASGDSimpleDataset)
   BOOST_REQUIRE_LT(arma::norm(finalGradient, 2), 1e-4);
 }
 
+/**
+ * On our simple dataset, ensure that NCA with mini-batch SGD also separates the
+ * points.
+ */
+BOOST_AUTO_TEST_CASE(NCASGDBatchSimpleDataset)
+{
+  // Useful but simple dataset with six points and two classes.
+  arma::mat data           = "-0.1 -0.1 -0.1  0.1  0.1  0.1;"
+                             " 1.0  0.0 -1.0  1.0  0.0 -1.0 ";
+  arma::Col<size_t> labels = " 0    0    0    1    1    1   ";
+
+  // The gradients of a batch are summed, so the step size is smaller.
+  NCA<SquaredEuclideanDistance> nca(data, labels);
+  nca.Optimizer().StepSize() = 0.6;
+  nca.Optimizer().MaxIterations() = 150000;
+  nca.Optimizer().Tolerance() = 0;
+  nca.Optimizer().BatchSize() = 2;
+
+  arma::mat outputMatrix;
+  nca.LearnDistance(outputMatrix);
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+
+  double initObj = sef.Evaluate(arma::eye<arma::mat>(2, 2));
+  double finalObj = sef.Evaluate(outputMatrix);
+
+  BOOST_REQUIRE_LT(finalObj, initObj);
+  BOOST_REQUIRE_CLOSE(finalObj, -6.0, 0.01);
+}
+
 BOOST_AUTO_TEST_CASE(NCALBFGSSimpleDataset)
 {
   // Useful but simple dataset with six points and two classes.
@@ -333,4 +509,34 @@ BOOST_AUTO_TEST_CASE(NCALBFGSSimpleDataset)
 
 }
 
+/**
+ * With an output dimensionality of 1, NCA should learn a 1 x 2 projection of
+ * the simple dataset which separates the classes.
+ */
+BOOST_AUTO_TEST_CASE(NCALBFGSLowRankSimpleDataset)
+{
+  arma::mat data           = "-0.1 -0.1 -0.1  0.1  0.1  0.1;"
+                             " 1.0  0.0 -1.0  1.0  0.0 -1.0 ";
+  arma::Col<size_t> labels = " 0    0    0    1    1    1   ";
+
+  NCA<SquaredEuclideanDistance, L_BFGS> nca(data, labels);
+  nca.OutputDimensionality() = 1;
+  nca.Optimizer().NumBasis() = 5;
+
+  arma::mat outputMatrix;
+  nca.LearnDistance(outputMatrix);
+
+  BOOST_REQUIRE_EQUAL(outputMatrix.n_rows, 1);
+  BOOST_REQUIRE_EQUAL(outputMatrix.n_cols, 2);
+
+  // Projecting to the first dimension separates the classes, so the optimal
+  // objective is the same as for the square matrix.
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  const double initObj = sef.Evaluate(arma::eye<arma::mat>(1, 2));
+  const double finalObj = sef.Evaluate(outputMatrix);
+
+  BOOST_REQUIRE_LT(finalObj, initObj);
+  BOOST_REQUIRE_CLOSE(finalObj, -6.0, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
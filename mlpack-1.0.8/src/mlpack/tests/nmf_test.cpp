@@ -24,6 +24,8 @@
 #include <mlpack/methods/nmf/random_acol_init.hpp>
 #include <mlpack/methods/nmf/mult_div_update_rules.hpp>
 #include <mlpack/methods/nmf/als_update_rules.hpp>
+#include <mlpack/methods/nmf/nnls_update_rules.hpp>
+#include <mlpack/methods/nmf/online_nmf.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -124,6 +126,80 @@ BOOST_AUTO_TEST_CASE(NMFALSTest)
       BOOST_REQUIRE_CLOSE(v(row, col), wh(row, col), 15.0);
 }
 
+/**
+ * Check that the non-negative least squares solver satisfies the optimality
+ * conditions: the solution is non-negative, and the gradient is zero where
+ * the solution is positive and non-positive where it is zero.
+ */
+BOOST_AUTO_TEST_CASE(NonNegativeLeastSquaresTest)
+{
+  mlpack::math::RandomSeed(7);
+  for (size_t trial = 0; trial < 20; ++trial)
+  {
+    const mat a = randn<mat>(30, 8);
+    const vec y = randn<vec>(30);
+    const mat gram = trans(a) * a;
+    const vec rhs = trans(a) * y;
+
+    // Start from an arbitrary point; it should not change the solution.
+    vec x = randu<vec>(8) - 0.5;
+    NonNegativeLeastSquares(gram, rhs.memptr(), x.memptr());
+
+    const vec gradient = rhs - gram * x;
+    for (size_t i = 0; i < x.n_elem; ++i)
+    {
+      BOOST_REQUIRE_GE(x[i], 0.0);
+      if (x[i] > 0.0)
+        BOOST_REQUIRE_SMALL(gradient[i], 1e-8);
+      else
+        BOOST_REQUIRE_LE(gradient[i], 1e-8);
+    }
+  }
+}
+
+/**
+ * Check that the product of the calculated factorization is close to the
+ * input matrix with the alternating non-negative least squares update rules,
+ * in far fewer iterations than NMFALSTest, with several threads, and that the
+ * residue never increases.
+ */
+BOOST_AUTO_TEST_CASE(NMFNNLSTest)
+{
+  mlpack::math::RandomSeed(3);
+  mat w = randu<mat>(20, 16);
+  mat h = randu<mat>(16, 20);
+  mat v = w * h;
+  size_t r = 16;
+
+  NMF<RandomInitialization,
+      WNonNegativeLeastSquaresRule,
+      HNonNegativeLeastSquaresRule> nmf(2000, 1e-15,
+      RandomInitialization(), WNonNegativeLeastSquaresRule(2),
+      HNonNegativeLeastSquaresRule(2));
+  nmf.Apply(v, r, w, h);
+
+  BOOST_REQUIRE_GE(w.min(), 0.0);
+  BOOST_REQUIRE_GE(h.min(), 0.0);
+
+  mat wh = w * h;
+  for (size_t row = 0; row < 20; row++)
+    for (size_t col = 0; col < 20; col++)
+      BOOST_REQUIRE_CLOSE(v(row, col), wh(row, col), 15.0);
+
+  // Each update is an exact minimization, so the residue cannot increase.
+  w = randu<mat>(20, 5);
+  h = randu<mat>(5, 20);
+  double lastResidue = norm(v - w * h, "fro");
+  for (size_t i = 0; i < 20; ++i)
+  {
+    WNonNegativeLeastSquaresRule().Update(v, w, h);
+    HNonNegativeLeastSquaresRule().Update(v, w, h);
+    const double residue = norm(v - w * h, "fro");
+    BOOST_REQUIRE_LE(residue, lastResidue * (1.0 + 1e-10));
+    lastResidue = residue;
+  }
+}
+
 /**
  * Check the if the product of the calculated factorization is close to the
  * input matrix, with a sparse input matrix.. Default case.
@@ -280,4 +356,117 @@ BOOST_AUTO_TEST_CASE(SparseNMFALSTest)
   }
 }
 
+/**
+ * Check that one step of each multiplicative update rule gives the same result
+ * for a sparse input matrix, with any number of threads, as for its dense copy.
+ */
+BOOST_AUTO_TEST_CASE(SparseParallelUpdateRulesTest)
+{
+  mlpack::math::RandomSeed(12);
+  sp_mat v;
+  v.sprandu(40, 30, 0.1);
+  const mat dv(v);
+  const mat w0 = randu<mat>(40, 4) + 0.1;
+  const mat h0 = randu<mat>(4, 30) + 0.1;
+
+  mat dw = w0;
+  mat dh = h0;
+  WMultiplicativeDistanceRule().Update(dv, dw, h0);
+  HMultiplicativeDistanceRule().Update(dv, w0, dh);
+  mat divw = w0;
+  mat divh = h0;
+  WMultiplicativeDivergenceRule().Update(dv, divw, h0);
+  HMultiplicativeDivergenceRule().Update(dv, w0, divh);
+
+  const size_t threads[] = { 1, 3, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    mat w = w0;
+    mat h = h0;
+    WMultiplicativeDistanceRule(threads[t]).Update(v, w, h0);
+    HMultiplicativeDistanceRule(threads[t]).Update(v, w0, h);
+    for (size_t i = 0; i < w.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(w[i] + 1.0, dw[i] + 1.0, 1e-8);
+    for (size_t i = 0; i < h.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(h[i] + 1.0, dh[i] + 1.0, 1e-8);
+
+    w = w0;
+    h = h0;
+    WMultiplicativeDivergenceRule(threads[t]).Update(v, w, h0);
+    HMultiplicativeDivergenceRule(threads[t]).Update(v, w0, h);
+    for (size_t i = 0; i < w.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(w[i] + 1.0, divw[i] + 1.0, 1e-8);
+    for (size_t i = 0; i < h.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(h[i] + 1.0, divh[i] + 1.0, 1e-8);
+  }
+}
+
+/**
+ * Check that online NMF approximates a low-rank matrix after a few passes, and
+ * that the error goes down with more passes.
+ */
+BOOST_AUTO_TEST_CASE(OnlineNMFTest)
+{
+  mlpack::math::RandomSeed(3);
+  const mat v = randu<mat>(20, 4) * randu<mat>(4, 300);
+
+  OnlineNMF nmf(4);
+  mat h;
+  nmf.Apply(v, 25, h);
+  BOOST_REQUIRE_EQUAL(nmf.W().n_rows, 20);
+  BOOST_REQUIRE_EQUAL(nmf.W().n_cols, 4);
+  BOOST_REQUIRE_EQUAL(h.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(h.n_cols, 300);
+
+  nmf.Encode(v, h);
+  const double firstError = norm(v - nmf.W() * h, "fro") / norm(v, "fro");
+
+  for (size_t pass = 0; pass < 20; ++pass)
+    nmf.Apply(v, 25, h);
+
+  nmf.Encode(v, h);
+  const double error = norm(v - nmf.W() * h, "fro") / norm(v, "fro");
+
+  BOOST_REQUIRE_LE(error, firstError);
+  BOOST_REQUIRE_LT(error, 0.1);
+
+  // W and H must stay non-negative.
+  BOOST_REQUIRE_GE(nmf.W().min(), 0.0);
+  BOOST_REQUIRE_GE(h.min(), 0.0);
+}
+
+/**
+ * Check that continuing online NMF from a saved W and statistics gives the
+ * same result as not stopping, and that sparse batches give the same result as
+ * dense ones.
+ */
+BOOST_AUTO_TEST_CASE(OnlineNMFResumeTest)
+{
+  mlpack::math::RandomSeed(5);
+  sp_mat v;
+  v.sprandu(30, 100, 0.2);
+  const mat dv(v);
+
+  const mat first = dv.cols(0, 49);
+  const mat second = dv.cols(50, 99);
+
+  mlpack::math::RandomSeed(6);
+  OnlineNMF nmf(3);
+  mat h;
+  nmf.Apply(first, 10, h);
+
+  OnlineNMF resumed(nmf.W(), nmf.A(), nmf.B());
+  nmf.Apply(second, 10, h);
+
+  mat sparseH;
+  const sp_mat rest = v.cols(50, 99);
+  resumed.Threads() = 2;
+  resumed.Apply(rest, 10, sparseH);
+
+  for (size_t i = 0; i < nmf.W().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(resumed.W()[i] + 1.0, nmf.W()[i] + 1.0, 1e-6);
+  for (size_t i = 0; i < h.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(sparseH[i] + 1.0, h[i] + 1.0, 1e-6);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -21,6 +21,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/pca/incremental_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -213,4 +214,202 @@ BOOST_AUTO_TEST_CASE(PCAScalingTest)
 }
 
 
+/**
+ * The randomized decomposition should find the same leading components as the
+ * exact one when the data is nearly low-rank.
+ */
+BOOST_AUTO_TEST_CASE(PCARandomizedTest)
+{
+  // Rank 5 data in 200 dimensions, plus a little noise.
+  mat data = 10 * randn<mat>(200, 5) * randn<mat>(5, 1000) +
+      0.01 * randn<mat>(200, 1000);
+  mat exactData(data);
+
+  PCA exact(false, PCA::EXACT);
+  const double exactVar = exact.Apply(exactData, 5);
+
+  PCA randomized(false, PCA::RANDOMIZED);
+  const double randomizedVar = randomized.Apply(data, 5);
+
+  BOOST_REQUIRE_EQUAL(data.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(data.n_cols, 1000);
+  BOOST_REQUIRE_CLOSE(randomizedVar, exactVar, 1e-5);
+
+  // The components may point in opposite directions.
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const double sign = (dot(data.row(i), exactData.row(i)) < 0) ? -1.0 : 1.0;
+    BOOST_REQUIRE_SMALL(norm(sign * data.row(i) - exactData.row(i), 2) /
+        norm(exactData.row(i), 2), 1e-4);
+  }
+
+  // With 200 dimensions and 5 components, the automatic choice is the
+  // randomized decomposition; it should also agree with the exact one.
+  PCA automatic;
+  mat autoData = 10 * randn<mat>(200, 5) * randn<mat>(5, 400);
+  mat autoExactData(autoData);
+  BOOST_REQUIRE_CLOSE(automatic.Apply(autoData, 5),
+      exact.Apply(autoExactData, 5), 1e-5);
+}
+
+/**
+ * QUIC-SVD should find nearly the same leading components as the exact
+ * decomposition, and retain the requested variance.
+ */
+BOOST_AUTO_TEST_CASE(PCAQUICSVDTest)
+{
+  // Rank 5 data in 100 dimensions, plus a little noise.
+  mat data = 10 * randn<mat>(100, 5) * randn<mat>(5, 500) +
+      0.01 * randn<mat>(100, 500);
+  mat exactData(data);
+  mat varData(data);
+
+  PCA exact(false, PCA::EXACT);
+  const double exactVar = exact.Apply(exactData, 5);
+
+  PCA quic(false, PCA::QUIC_SVD);
+  const double quicVar = quic.Apply(data, 5);
+
+  BOOST_REQUIRE_EQUAL(data.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(data.n_cols, 500);
+  BOOST_REQUIRE_CLOSE(quicVar, exactVar, 1.0);
+
+  const double retained = quic.Apply(varData, 0.9);
+  BOOST_REQUIRE_GE(retained, 0.9);
+  BOOST_REQUIRE_LE(varData.n_rows, 5);
+}
+
+/**
+ * Incremental PCA on chunks of a dataset should give the same components as
+ * PCA on the whole dataset, with and without scaling.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCATest)
+{
+  mat data = randn<mat>(8, 8) * randn<mat>(8, 300);
+  data.row(2) += 5.0;
+
+  for (size_t s = 0; s < 2; ++s)
+  {
+    const bool scale = (s == 1);
+
+    PCA p(scale);
+    mat transformed;
+    vec eigVal;
+    mat eigVec;
+    p.Apply(data, transformed, eigVal, eigVec);
+
+    // Chunks of uneven sizes.
+    IncrementalPCA ipca(scale);
+    ipca.Update(data.cols(0, 99));
+    ipca.Update(data.cols(100, 109));
+    ipca.Update(data.cols(110, 299));
+    BOOST_REQUIRE_EQUAL(ipca.NumPoints(), 300);
+
+    const double varRetained = ipca.Fit(3);
+    BOOST_REQUIRE_CLOSE(varRetained, sum(eigVal.subvec(0, 2)) / sum(eigVal),
+        1e-5);
+
+    mat ipcaTransformed;
+    ipca.Transform(data, ipcaTransformed);
+    BOOST_REQUIRE_EQUAL(ipcaTransformed.n_rows, 3);
+    BOOST_REQUIRE_EQUAL(ipcaTransformed.n_cols, 300);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(ipca.EigenValues()[i], eigVal[i], 1e-5);
+
+      // The components may point in opposite directions.
+      const double sign = (dot(ipcaTransformed.row(i), transformed.row(i)) < 0)
+          ? -1.0 : 1.0;
+      for (size_t j = 0; j < 300; ++j)
+        BOOST_REQUIRE_SMALL(sign * ipcaTransformed(i, j) - transformed(i, j),
+            1e-6);
+    }
+  }
+}
+
+/**
+ * Chunks loaded from files should give the same results as chunks in memory.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCAFileTest)
+{
+  const mat data = randn<mat>(5, 5) * randn<mat>(5, 200);
+
+  data::Save("test-ipca-chunk-0.bin", mat(data.cols(0, 119)));
+  data::Save("test-ipca-chunk-1.bin", mat(data.cols(120, 199)));
+
+  IncrementalPCA fromFiles;
+  fromFiles.Update("test-ipca-chunk-0.bin");
+  fromFiles.Update("test-ipca-chunk-1.bin");
+  fromFiles.Fit();
+
+  remove("test-ipca-chunk-0.bin");
+  remove("test-ipca-chunk-1.bin");
+
+  IncrementalPCA inMemory;
+  inMemory.Update(data);
+  inMemory.Fit();
+
+  BOOST_REQUIRE_EQUAL(fromFiles.NumPoints(), 200);
+  BOOST_REQUIRE_EQUAL(fromFiles.EigenValues().n_elem, 5);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(fromFiles.Mean()[i], inMemory.Mean()[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(fromFiles.EigenValues()[i], inMemory.EigenValues()[i],
+        1e-5);
+  }
+}
+
+/**
+ * The covariance method should find the same components as the exact
+ * decomposition, and the automatic choice should use it when the exact
+ * decomposition does not fit in the memory budget.
+ */
+BOOST_AUTO_TEST_CASE(PCACovarianceTest)
+{
+  mat data = randn<mat>(10, 10) * randn<mat>(10, 2000);
+  data.row(3) += 4.0;
+  mat exactData(data);
+  mat varData(data);
+  mat varExactData(data);
+  mat budgetData(data);
+
+  PCA exact(false, PCA::EXACT);
+  const double exactVar = exact.Apply(exactData, 4);
+
+  PCA covariance(false, PCA::COVARIANCE);
+  const double covarianceVar = covariance.Apply(data, 4);
+
+  BOOST_REQUIRE_EQUAL(data.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(data.n_cols, 2000);
+  BOOST_REQUIRE_CLOSE(covarianceVar, exactVar, 1e-5);
+
+  // The components may point in opposite directions.
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const double sign = (dot(data.row(i), exactData.row(i)) < 0) ? -1.0 : 1.0;
+    BOOST_REQUIRE_SMALL(norm(sign * data.row(i) - exactData.row(i), 2) /
+        norm(exactData.row(i), 2), 1e-6);
+  }
+
+  BOOST_REQUIRE_CLOSE(covariance.Apply(varData, 0.9),
+      exact.Apply(varExactData, 0.9), 1e-5);
+  BOOST_REQUIRE_EQUAL(varData.n_rows, varExactData.n_rows);
+
+  // With a budget much smaller than the data, the automatic choice is the
+  // covariance matrix, which is projected in several blocks.
+  PCA automatic;
+  BOOST_REQUIRE_GT(automatic.PeakMemory(10, 2000, 4),
+      automatic.PeakMemory(10, 100, 4));
+  MemoryBudget::SetLimit(20000);
+  BOOST_REQUIRE_LT(automatic.PeakMemory(10, 2000, 4),
+      exact.PeakMemory(10, 2000, 4));
+  const double budgetVar = automatic.Apply(budgetData, 4);
+  MemoryBudget::SetLimit(0);
+
+  BOOST_REQUIRE_CLOSE(budgetVar, exactVar, 1e-5);
+  for (size_t i = 0; i < budgetData.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(std::abs(budgetData[i]) - std::abs(data[i]), 1e-6);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,204 @@
+/**
+ * @file performance_test.cpp
+ *
+ * Performance regression tests.  Instead of timing, these assert on counters of
+ * the work done, which are deterministic: the base cases of tree searches, the
+ * iterations of EM, and the bytes allocated by tree construction.  A change
+ * that breaks pruning leaves every result correct, but fails here.  These are
+ * only built with the PERFORMANCE_TESTS CMake option, which also turns on the
+ * traversal statistics (see tree::TraversalStatistics).
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/gmm/em_fit.hpp>
+
+#include <cstdlib>
+#include <new>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::tree;
+using namespace mlpack::gmm;
+
+namespace {
+
+//! If true, the bytes requested from operator new are counted.
+bool countAllocations = false;
+//! The number of bytes requested from operator new while counting.
+size_t allocatedBytes = 0;
+
+//! Allocate with malloc(), counting the bytes if requested.
+void* CountedAllocate(const size_t size)
+{
+  if (countAllocations)
+    allocatedBytes += size;
+
+  void* memory = std::malloc((size == 0) ? 1 : size);
+  if (memory == NULL)
+    throw std::bad_alloc();
+  return memory;
+}
+
+typedef BinarySpaceTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > KDTree;
+
+//! Return the number of bytes operator new was asked for while building a
+//! kd-tree on the given data.
+size_t TreeBytes(arma::mat data, const size_t leafSize, size_t& nodes)
+{
+  allocatedBytes = 0;
+  countAllocations = true;
+  KDTree* tree = new KDTree(data, leafSize);
+  countAllocations = false;
+
+  nodes = tree->TreeSize();
+  delete tree;
+  return allocatedBytes;
+}
+
+//! Load the fixed dataset the tests run on.
+void LoadData(arma::mat& data)
+{
+  if (!data::Load("test_data_3_1000.csv", data))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+}
+
+}; // anonymous namespace
+
+// Replace the global allocation functions, so allocations can be counted.  This
+// only works because the tests are run one at a time.
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+  return CountedAllocate(size);
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+  return CountedAllocate(size);
+}
+
+void operator delete(void* memory) throw()
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+  std::free(memory);
+}
+
+BOOST_AUTO_TEST_SUITE(PerformanceTest);
+
+/**
+ * Dual-tree AllkNN on a fixed 3-dimensional dataset must prune most of the
+ * n^2 base cases naive search calculates.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeAllkNNBaseCases)
+{
+  BOOST_REQUIRE(TraversalStatistics::Enabled);
+
+  arma::mat data;
+  LoadData(data);
+  const size_t n = data.n_cols;
+
+  AllkNN allknn(data, false, false, 10);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(3, neighbors, distances);
+
+  const TraversalCounts counts = TraversalStatistics::Get();
+  BOOST_REQUIRE_GT(counts.baseCases, 0);
+  BOOST_REQUIRE_LT(counts.baseCases, n * n / 4);
+  BOOST_REQUIRE_GT(counts.prunes, 0);
+}
+
+/**
+ * Single-tree AllkNN on the same dataset must also prune most base cases.
+ */
+BOOST_AUTO_TEST_CASE(SingleTreeAllkNNBaseCases)
+{
+  BOOST_REQUIRE(TraversalStatistics::Enabled);
+
+  arma::mat data;
+  LoadData(data);
+  const size_t n = data.n_cols;
+
+  AllkNN allknn(data, false, true, 10);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(3, neighbors, distances);
+
+  const TraversalCounts counts = TraversalStatistics::Get();
+  BOOST_REQUIRE_GT(counts.baseCases, 0);
+  BOOST_REQUIRE_LT(counts.baseCases, n * n / 4);
+  BOOST_REQUIRE_GT(counts.prunes, 0);
+}
+
+/**
+ * EM on three well-separated Gaussians, started from k-means, must converge in
+ * a handful of iterations.
+ */
+BOOST_AUTO_TEST_CASE(EMIterations)
+{
+  math::RandomSeed(42);
+  arma::mat data;
+  data.randn(4, 900);
+  data.cols(300, 599) += 20.0;
+  data.cols(600, 899) -= 20.0;
+
+  std::vector<arma::vec> means(3, arma::vec(4));
+  std::vector<arma::mat> covariances(3, arma::mat(4, 4));
+  arma::vec weights(3);
+
+  EMFit<> em;
+  em.Estimate(data, means, covariances, weights);
+
+  BOOST_REQUIRE_GT(em.Iterations(), 0);
+  BOOST_REQUIRE_LE(em.Iterations(), 10);
+}
+
+/**
+ * Building a kd-tree must allocate a bounded number of bytes per node, and
+ * twice the points must take at most about twice the memory.
+ */
+BOOST_AUTO_TEST_CASE(TreeBuildBytes)
+{
+  arma::mat data;
+  LoadData(data);
+  const arma::mat doubled = arma::join_rows(data, data + 1.0);
+
+  size_t nodes;
+  const size_t bytes = TreeBytes(data, 20, nodes);
+  size_t doubledNodes;
+  const size_t doubledBytes = TreeBytes(doubled, 20, doubledNodes);
+
+  // Each node holds the bounds of each dimension; allow some slack for the
+  // statistic and the allocator bookkeeping of the containers.
+  const size_t nodeBytes = sizeof(KDTree) + data.n_rows * sizeof(math::Range) +
+      256;
+  BOOST_REQUIRE_GT(bytes, 0);
+  BOOST_REQUIRE_LE(bytes, nodes * nodeBytes);
+  BOOST_REQUIRE_LE(doubledBytes, doubledNodes * nodeBytes);
+  BOOST_REQUIRE_LE(doubledBytes, 5 * bytes / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
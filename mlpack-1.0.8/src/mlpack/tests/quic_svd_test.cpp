@@ -0,0 +1,118 @@
+/**
+ * @file quic_svd_test.cpp
+ *
+ * Tests for QUIC-SVD.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/quic_svd/quic_svd.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+BOOST_AUTO_TEST_SUITE(QUICSVDTest);
+
+using namespace mlpack;
+using namespace mlpack::svd;
+
+/**
+ * A matrix of low rank should be reconstructed exactly, with the same singular
+ * values as the exact decomposition.
+ */
+BOOST_AUTO_TEST_CASE(QUICSVDLowRankTest)
+{
+  const arma::mat data = arma::randn<arma::mat>(50, 5) *
+      arma::randn<arma::mat>(5, 300);
+
+  QUICSVD quicSVD(1e-10);
+  arma::mat u, v;
+  arma::vec sigma;
+  const double error = quicSVD.Apply(data, u, sigma, v);
+
+  BOOST_REQUIRE_SMALL(error, 1e-10);
+  BOOST_REQUIRE_GE(sigma.n_elem, 5);
+  BOOST_REQUIRE_EQUAL(u.n_rows, 50);
+  BOOST_REQUIRE_EQUAL(v.n_rows, 300);
+  BOOST_REQUIRE_EQUAL(u.n_cols, sigma.n_elem);
+  BOOST_REQUIRE_EQUAL(v.n_cols, sigma.n_elem);
+
+  const arma::mat reconstruction = u * arma::diagmat(sigma) * trans(v);
+  BOOST_REQUIRE_SMALL(arma::norm(reconstruction - data, "fro") /
+      arma::norm(data, "fro"), 1e-5);
+
+  arma::vec exactSigma = arma::svd(data);
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_CLOSE(sigma[i], exactSigma[i], 1e-5);
+}
+
+/**
+ * The decomposition should reach the requested relative error, report it
+ * correctly, and have orthonormal singular vectors.
+ */
+BOOST_AUTO_TEST_CASE(QUICSVDRelativeErrorTest)
+{
+  const arma::mat data = arma::randu<arma::mat>(30, 200);
+  const double totalNorm = arma::accu(arma::square(data));
+
+  QUICSVD quicSVD(0.2);
+  arma::mat u, v;
+  arma::vec sigma;
+  const double error = quicSVD.Apply(data, u, sigma, v);
+
+  BOOST_REQUIRE_LE(error, 0.2);
+  BOOST_REQUIRE_LT(sigma.n_elem, 30);
+
+  const arma::mat residual = data - u * arma::diagmat(sigma) * trans(v);
+  BOOST_REQUIRE_CLOSE(arma::accu(arma::square(residual)) / totalNorm, error,
+      1e-3);
+
+  const arma::mat uu = trans(u) * u;
+  const arma::mat vv = trans(v) * v;
+  for (size_t i = 0; i < uu.n_rows; ++i)
+  {
+    for (size_t j = 0; j < uu.n_cols; ++j)
+    {
+      BOOST_REQUIRE_SMALL(uu(i, j) - ((i == j) ? 1.0 : 0.0), 1e-8);
+      BOOST_REQUIRE_SMALL(vv(i, j) - ((i == j) ? 1.0 : 0.0), 1e-8);
+    }
+  }
+
+  // The singular values must be sorted.
+  for (size_t i = 1; i < sigma.n_elem; ++i)
+    BOOST_REQUIRE_LE(sigma[i], sigma[i - 1]);
+}
+
+/**
+ * The rank limits should be respected.
+ */
+BOOST_AUTO_TEST_CASE(QUICSVDRankLimitTest)
+{
+  const arma::mat data = arma::randu<arma::mat>(20, 100);
+
+  arma::mat u, v;
+  arma::vec sigma;
+
+  QUICSVD minimum(0.9, 7);
+  minimum.Apply(data, u, sigma, v);
+  BOOST_REQUIRE_GE(sigma.n_elem, 7);
+
+  QUICSVD maximum(0.0, 1, 4);
+  maximum.Apply(data, u, sigma, v);
+  BOOST_REQUIRE_LE(sigma.n_elem, 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
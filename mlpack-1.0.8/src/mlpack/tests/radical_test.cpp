@@ -68,4 +68,61 @@ BOOST_AUTO_TEST_CASE(Radical_Test_Radical3D)
   BOOST_REQUIRE_CLOSE(valBest, valEst, 0.2);
 }
 
+/**
+ * The radix sort in Vasicek() sorts positive and negative values correctly, so
+ * the estimate is the same as with a comparison sort.
+ */
+BOOST_AUTO_TEST_CASE(Radical_Test_Vasicek)
+{
+  Radical rad(0.175, 5, 100, 2, 4);
+
+  vec x = 10.0 * randn<vec>(1000);
+  x[0] = 0.0;
+  x[1] = -0.0;
+  x[2] = 1e-300;
+  x[3] = -1e300;
+
+  vec sorted = sort(x);
+  double expected = 0;
+  for (uword i = 0; i < sorted.n_elem - 4; i++)
+    expected += log(sorted[i + 4] - sorted[i]);
+
+  const double estimate = rad.Vasicek(x);
+
+  // The sample is sorted in place.
+  for (uword i = 0; i < x.n_elem; i++)
+    BOOST_REQUIRE_EQUAL(x[i], sorted[i]);
+
+  BOOST_REQUIRE_CLOSE(estimate, expected, 1e-10);
+}
+
+/**
+ * The result does not depend on the number of threads, and the unmixing matrix
+ * gives the independent components.
+ */
+BOOST_AUTO_TEST_CASE(Radical_Test_Threads)
+{
+  mat matX;
+  data::Load("data_3d_mixed.txt", matX);
+
+  mat matY, matW;
+  math::RandomSeed(42);
+  Radical rad(0.175, 5, 100, matX.n_rows - 1);
+  rad.DoRadical(matX, matY, matW);
+
+  mat matYThreads, matWThreads;
+  math::RandomSeed(42);
+  Radical radThreads(0.175, 5, 100, matX.n_rows - 1, 0, 4);
+  BOOST_REQUIRE_EQUAL(radThreads.Threads(), 4);
+  radThreads.DoRadical(matX, matYThreads, matWThreads);
+
+  for (uword i = 0; i < matY.n_elem; i++)
+    BOOST_REQUIRE_SMALL(matYThreads[i] - matY[i], 1e-8);
+
+  // Y = W X.
+  mat matYFromW = matW * matX;
+  for (uword i = 0; i < matY.n_elem; i++)
+    BOOST_REQUIRE_SMALL(matYFromW[i] - matY[i], 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
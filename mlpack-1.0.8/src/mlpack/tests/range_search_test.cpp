@@ -593,6 +593,249 @@ BOOST_AUTO_TEST_CASE(SingleTreeVsNaive)
   }
 }
 
+// Turn results in compressed sparse row form into sorted results.
+void SortFlatResults(const arma::Col<size_t>& offsets,
+                     const arma::Col<size_t>& neighbors,
+                     const arma::vec& distances,
+                     vector<vector<pair<double, size_t> > >& output)
+{
+  output.resize(offsets.n_elem - 1);
+  for (size_t i = 0; i + 1 < offsets.n_elem; i++)
+  {
+    output[i].clear();
+    for (size_t j = offsets[i]; j < offsets[i + 1]; j++)
+      output[i].push_back(make_pair(distances[j], neighbors[j]));
+
+    sort(output[i].begin(), output[i].end());
+  }
+}
+
+/**
+ * Make sure that the compressed sparse row output gives the same results as the
+ * naive method, with one and with several threads, in single-tree and
+ * dual-tree mode, and with and without a separate query set.
+ */
+BOOST_AUTO_TEST_CASE(FlatResultsVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  for (size_t run = 0; run < 8; ++run)
+  {
+    const bool singleMode = (run % 2 == 1);
+    const bool twoSets = ((run / 2) % 2 == 1);
+    const size_t threads = (run / 4 == 0) ? 1 : 4;
+
+    RangeSearch<>* rs = twoSets ?
+        new RangeSearch<>(referenceData, queryData, false, singleMode) :
+        new RangeSearch<>(referenceData, false, singleMode);
+    RangeSearch<>* naive = twoSets ?
+        new RangeSearch<>(referenceData, queryData, true) :
+        new RangeSearch<>(referenceData, true);
+    rs->Threads() = threads;
+
+    arma::Col<size_t> offsets;
+    arma::Col<size_t> neighbors;
+    arma::vec distances;
+    rs->Search(Range(0.1, 0.3), offsets, neighbors, distances);
+    vector<vector<pair<double, size_t> > > sortedTree;
+    SortFlatResults(offsets, neighbors, distances, sortedTree);
+
+    vector<vector<size_t> > neighborsNaive;
+    vector<vector<double> > distancesNaive;
+    naive->Search(Range(0.1, 0.3), neighborsNaive, distancesNaive);
+    vector<vector<pair<double, size_t> > > sortedNaive;
+    SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+    BOOST_REQUIRE_EQUAL(sortedTree.size(), sortedNaive.size());
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(sortedTree[i].size(), sortedNaive[i].size());
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE_EQUAL(sortedTree[i][j].second, sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+
+    delete rs;
+    delete naive;
+  }
+}
+
+// A visitor which stores every result it is given.
+class StoringVisitor
+{
+ public:
+  StoringVisitor(const size_t queries) : neighbors(queries), distances(queries)
+  { }
+
+  void operator()(const size_t queryIndex,
+                  const size_t referenceIndex,
+                  const double distance)
+  {
+    neighbors[queryIndex].push_back(referenceIndex);
+    distances[queryIndex].push_back(distance);
+  }
+
+  vector<vector<size_t> > neighbors;
+  vector<vector<double> > distances;
+};
+
+/**
+ * Make sure that Count() and the visitor mode of Search() agree with the naive
+ * method, for kd-trees and cover trees.
+ */
+BOOST_AUTO_TEST_CASE(CountAndVisitorVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  RangeSearch<> naive(referenceData, queryData, true);
+  vector<vector<size_t> > neighborsNaive;
+  vector<vector<double> > distancesNaive;
+  naive.Search(Range(0.0, 0.3), neighborsNaive, distancesNaive);
+  vector<vector<pair<double, size_t> > > sortedNaive;
+  SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+  for (size_t run = 0; run < 4; ++run)
+  {
+    RangeSearch<> rs(referenceData, queryData, false, (run % 2 == 1));
+    rs.Threads() = (run < 2) ? 1 : 4;
+
+    arma::Col<size_t> counts;
+    rs.Count(Range(0.0, 0.3), counts);
+    BOOST_REQUIRE_EQUAL(counts.n_elem, queryData.n_cols);
+    for (size_t i = 0; i < counts.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(counts[i], neighborsNaive[i].size());
+
+    // The visitor is not thread-safe.
+    if (run >= 2)
+      continue;
+
+    StoringVisitor visitor(queryData.n_cols);
+    rs.Search(Range(0.0, 0.3), visitor);
+    vector<vector<pair<double, size_t> > > sortedTree;
+    SortResults(visitor.neighbors, visitor.distances, sortedTree);
+
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(sortedTree[i].size(), sortedNaive[i].size());
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE_EQUAL(sortedTree[i][j].second, sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+  }
+
+  // Now counts with a single dataset and a cover tree, where base cases are
+  // calculated in Score().
+  typedef tree::CoverTree<metric::EuclideanDistance, tree::FirstPointIsRoot,
+      RangeSearchStat> CoverTreeType;
+  CoverTreeType tree(referenceData);
+  RangeSearch<metric::EuclideanDistance, CoverTreeType> coverSearch(&tree,
+      referenceData);
+  RangeSearch<> monoNaive(referenceData, true);
+  monoNaive.Search(Range(0.0, 0.3), neighborsNaive, distancesNaive);
+
+  arma::Col<size_t> counts;
+  coverSearch.Count(Range(0.0, 0.3), counts);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], neighborsNaive[i].size());
+}
+
+/**
+ * Counting and searching several ranges at once, and a different radius for
+ * each query point, must give the same results as one search for each range.
+ */
+BOOST_AUTO_TEST_CASE(MultiRangeAndRadiiVsNaive)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  vector<Range> ranges;
+  ranges.push_back(Range(0.0, 0.1));
+  ranges.push_back(Range(0.0, 0.2));
+  ranges.push_back(Range(0.15, 0.3));
+
+  arma::vec radii(queryData.n_cols);
+  for (size_t i = 0; i < radii.n_elem; ++i)
+    radii[i] = 0.05 + 0.25 * (i % 7) / 6.0;
+
+  RangeSearch<> naive(referenceData, queryData, true);
+  vector<vector<vector<pair<double, size_t> > > > sortedNaive(ranges.size());
+  for (size_t r = 0; r < ranges.size(); ++r)
+  {
+    vector<vector<size_t> > neighborsNaive;
+    vector<vector<double> > distancesNaive;
+    naive.Search(ranges[r], neighborsNaive, distancesNaive);
+    SortResults(neighborsNaive, distancesNaive, sortedNaive[r]);
+  }
+
+  for (size_t run = 0; run < 4; ++run)
+  {
+    RangeSearch<> rs(referenceData, queryData, false, (run % 2 == 1));
+    rs.Threads() = (run < 2) ? 1 : 4;
+
+    arma::Mat<size_t> counts;
+    rs.Count(ranges, counts);
+    BOOST_REQUIRE_EQUAL(counts.n_rows, ranges.size());
+    BOOST_REQUIRE_EQUAL(counts.n_cols, queryData.n_cols);
+
+    arma::Col<size_t> offsets;
+    arma::Col<size_t> neighbors;
+    arma::vec distances;
+    rs.Search(ranges, offsets, neighbors, distances);
+    BOOST_REQUIRE_EQUAL(offsets.n_elem, queryData.n_cols * ranges.size() + 1);
+
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      for (size_t r = 0; r < ranges.size(); ++r)
+      {
+        const size_t bin = i * ranges.size() + r;
+        BOOST_REQUIRE_EQUAL(counts(r, i), sortedNaive[r][i].size());
+        BOOST_REQUIRE_EQUAL(offsets[bin + 1] - offsets[bin],
+            sortedNaive[r][i].size());
+
+        vector<pair<double, size_t> > sorted;
+        for (size_t j = offsets[bin]; j < offsets[bin + 1]; ++j)
+          sorted.push_back(make_pair(distances[j], neighbors[j]));
+        sort(sorted.begin(), sorted.end());
+        for (size_t j = 0; j < sorted.size(); ++j)
+          BOOST_REQUIRE_EQUAL(sorted[j].second, sortedNaive[r][i][j].second);
+      }
+    }
+
+    // Now a radius for each query point.
+    arma::Col<size_t> radiusCounts;
+    rs.Count(radii, radiusCounts);
+    rs.Search(radii, offsets, neighbors, distances);
+    BOOST_REQUIRE_EQUAL(offsets.n_elem, queryData.n_cols + 1);
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      size_t expected = 0;
+      for (size_t j = 0; j < referenceData.n_cols; ++j)
+        if (metric::EuclideanDistance::Evaluate(queryData.col(i),
+            referenceData.col(j)) <= radii[i])
+          ++expected;
+
+      BOOST_REQUIRE_EQUAL(radiusCounts[i], expected);
+      BOOST_REQUIRE_EQUAL(offsets[i + 1] - offsets[i], expected);
+      for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        BOOST_REQUIRE_LE(distances[j], radii[i]);
+    }
+  }
+}
+
 /**
  * Ensure that range search with cover trees works by comparing with the kd-tree
  * implementation.
@@ -830,4 +1073,109 @@ BOOST_AUTO_TEST_CASE(CoverTreeSingleTreeTest)
   }
 }
 
+/**
+ * Make sure that ball trees give the same results as the naive method, with
+ * dual-tree and single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(BallTreeVsNaive)
+{
+  typedef tree::BinarySpaceTree<bound::BallBound<>, RangeSearchStat>
+      BallTreeType;
+  typedef RangeSearch<metric::EuclideanDistance, BallTreeType> BallRangeSearch;
+
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 200);
+
+  RangeSearch<> naive(referenceData, queryData, true);
+  vector<vector<size_t> > neighborsNaive;
+  vector<vector<double> > distancesNaive;
+  naive.Search(Range(0.3, 0.6), neighborsNaive, distancesNaive);
+  vector<vector<pair<double, size_t> > > sortedNaive;
+  SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    BallRangeSearch rs(referenceData, queryData, false, (mode == 1), 10);
+
+    vector<vector<size_t> > neighborsTree;
+    vector<vector<double> > distancesTree;
+    rs.Search(Range(0.3, 0.6), neighborsTree, distancesTree);
+    vector<vector<pair<double, size_t> > > sortedTree;
+    SortResults(neighborsTree, distancesTree, sortedTree);
+
+    BOOST_REQUIRE_EQUAL(sortedTree.size(), sortedNaive.size());
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(sortedTree[i].size(), sortedNaive[i].size());
+
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE_EQUAL(sortedTree[i][j].second, sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that periodic kd-trees give the same results as the naive method
+ * with the periodic metric, with dual-tree and single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(PeriodicTreeVsNaive)
+{
+  typedef tree::BinarySpaceTree<bound::PeriodicHRectBound<2>, RangeSearchStat>
+      PeriodicTreeType;
+  typedef RangeSearch<metric::PeriodicEuclideanDistance, PeriodicTreeType>
+      PeriodicRangeSearch;
+
+  const arma::vec box("1.0 2.0 1.0");
+  const metric::PeriodicEuclideanDistance periodic(box);
+
+  arma::mat referenceData;
+  referenceData.randu(3, 1000);
+  arma::mat queryData;
+  queryData.randu(3, 200);
+  for (size_t d = 0; d < 3; ++d)
+  {
+    referenceData.row(d) *= box[d];
+    queryData.row(d) *= box[d];
+  }
+
+  PeriodicRangeSearch naive(referenceData, queryData, true, false, 20,
+      periodic);
+  vector<vector<size_t> > neighborsNaive;
+  vector<vector<double> > distancesNaive;
+  naive.Search(Range(0.2, 0.4), neighborsNaive, distancesNaive);
+  vector<vector<pair<double, size_t> > > sortedNaive;
+  SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    PeriodicRangeSearch rs(referenceData, queryData, false, (mode == 1), 10,
+        periodic);
+
+    vector<vector<size_t> > neighborsTree;
+    vector<vector<double> > distancesTree;
+    rs.Search(Range(0.2, 0.4), neighborsTree, distancesTree);
+    vector<vector<pair<double, size_t> > > sortedTree;
+    SortResults(neighborsTree, distancesTree, sortedTree);
+
+    BOOST_REQUIRE_EQUAL(sortedTree.size(), sortedNaive.size());
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(sortedTree[i].size(), sortedNaive[i].size());
+
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE_EQUAL(sortedTree[i][j].second, sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,260 @@
+/**
+ * @file runtime_test.cpp
+ *
+ * Tests of the inference runtime (mlpack/runtime/): each runtime model must
+ * give the same predictions as the model of the full library it was converted
+ * from, before and after saving and loading.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/tree_index.hpp>
+#include <mlpack/methods/det/dt_utils.hpp>
+#include <mlpack/methods/det/flat_dtree.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/runtime/to_runtime.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::distribution;
+
+BOOST_AUTO_TEST_SUITE(RuntimeTest);
+
+/**
+ * Make sure a converted GMM gives the same probabilities and labels.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeGMMTest)
+{
+  std::vector<arma::vec> means(3);
+  std::vector<arma::mat> covariances(3);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    means[i] = 5.0 * arma::randu<arma::vec>(4);
+    const arma::mat a = arma::randu<arma::mat>(4, 4);
+    covariances[i] = a * trans(a) + 0.5 * arma::eye<arma::mat>(4, 4);
+  }
+  arma::vec weights("0.2 0.5 0.3");
+  gmm::GMM<> gmm(means, covariances, weights);
+
+  runtime::GMM model = runtime::ToRuntime(gmm);
+  model.Save("test_runtime_gmm.bin");
+  runtime::GMM loaded("test_runtime_gmm.bin");
+  remove("test_runtime_gmm.bin");
+
+  const arma::mat observations = 5.0 * arma::randu<arma::mat>(4, 200);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    const double p = gmm.Probability(observations.unsafe_col(i));
+    BOOST_REQUIRE_CLOSE(model.Probability(observations.unsafe_col(i)), p,
+        1e-5);
+    BOOST_REQUIRE_CLOSE(loaded.Probability(observations.unsafe_col(i)), p,
+        1e-5);
+  }
+
+  arma::Col<size_t> labels, modelLabels, loadedLabels;
+  gmm.Classify(observations, labels);
+  model.Classify(observations, modelLabels);
+  loaded.Classify(observations, loadedLabels);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(modelLabels[i], labels[i]);
+    BOOST_REQUIRE_EQUAL(loadedLabels[i], labels[i]);
+  }
+}
+
+/**
+ * Make sure a converted HMM with discrete emissions predicts the same states.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeDiscreteHMMTest)
+{
+  arma::mat transition("0.7 0.3 0.1; 0.2 0.5 0.3; 0.1 0.2 0.6");
+  std::vector<DiscreteDistribution> emission(3);
+  emission[0].Probabilities() = "0.6 0.3 0.1";
+  emission[1].Probabilities() = "0.1 0.8 0.1";
+  emission[2].Probabilities() = "0.2 0.2 0.6";
+  hmm::HMM<DiscreteDistribution> hmm(transition, emission);
+
+  runtime::HMM<runtime::Discrete> model = runtime::ToRuntime(hmm);
+  model.Save("test_runtime_hmm.bin");
+  runtime::HMM<runtime::Discrete> loaded("test_runtime_hmm.bin");
+  remove("test_runtime_hmm.bin");
+
+  arma::mat sequence(1, 100);
+  for (size_t i = 0; i < sequence.n_cols; ++i)
+    sequence[i] = math::RandInt(3);
+
+  arma::Col<size_t> states, modelStates, loadedStates;
+  const double logLikelihood = hmm.Predict(sequence, states);
+  BOOST_REQUIRE_CLOSE(model.Predict(sequence, modelStates), logLikelihood,
+      1e-5);
+  BOOST_REQUIRE_CLOSE(loaded.Predict(sequence, loadedStates), logLikelihood,
+      1e-5);
+
+  for (size_t i = 0; i < states.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(modelStates[i], states[i]);
+    BOOST_REQUIRE_EQUAL(loadedStates[i], states[i]);
+  }
+}
+
+/**
+ * Make sure a converted HMM with Gaussian emissions predicts the same states.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeGaussianHMMTest)
+{
+  arma::mat transition("0.8 0.3; 0.2 0.7");
+  std::vector<GaussianDistribution> emission(2);
+  emission[0] = GaussianDistribution("0.0 0.0", "1.0 0.2; 0.2 1.0");
+  emission[1] = GaussianDistribution("3.0 1.0", "0.8 0.0; 0.0 1.5");
+  hmm::HMM<GaussianDistribution> hmm(transition, emission);
+
+  runtime::HMM<runtime::Gaussian> model = runtime::ToRuntime(hmm);
+
+  const arma::mat sequence = 3.0 * arma::randu<arma::mat>(2, 100);
+  arma::Col<size_t> states, modelStates;
+  const double logLikelihood = hmm.Predict(sequence, states);
+  BOOST_REQUIRE_CLOSE(model.Predict(sequence, modelStates), logLikelihood,
+      1e-5);
+
+  for (size_t i = 0; i < states.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(modelStates[i], states[i]);
+}
+
+/**
+ * Make sure a converted naive Bayes classifier gives the same labels.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeNaiveBayesTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 300);
+  arma::Col<size_t> labels(300);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    labels[i] = i % 3;
+    data.col(i) += 0.5 * labels[i];
+  }
+  naive_bayes::NaiveBayesClassifier<> nbc(data, labels, 3);
+
+  runtime::NaiveBayes model = runtime::ToRuntime(nbc);
+  model.Save("test_runtime_nbc.bin");
+  runtime::NaiveBayes loaded("test_runtime_nbc.bin");
+  remove("test_runtime_nbc.bin");
+
+  const arma::mat points = 2.0 * arma::randu<arma::mat>(5, 200);
+  arma::Col<size_t> results, modelResults, loadedResults;
+  nbc.Classify(points, results);
+  model.Classify(points, modelResults);
+  loaded.Classify(points, loadedResults);
+
+  for (size_t i = 0; i < results.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(modelResults[i], results[i]);
+    BOOST_REQUIRE_EQUAL(loadedResults[i], results[i]);
+  }
+}
+
+/**
+ * Make sure a converted logistic regression model gives the same predictions.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeLogisticRegressionTest)
+{
+  const arma::vec parameters("0.5 -1.0 2.0 0.3");
+  regression::LogisticRegression<> lr(parameters);
+
+  runtime::LogisticRegression model = runtime::ToRuntime(lr);
+  model.Save("test_runtime_lr.bin");
+  runtime::LogisticRegression loaded("test_runtime_lr.bin");
+  remove("test_runtime_lr.bin");
+
+  const arma::mat predictors = arma::randn<arma::mat>(3, 200);
+  arma::vec responses, modelResponses, loadedResponses;
+  lr.Predict(predictors, responses);
+  model.Predict(predictors, modelResponses);
+  loaded.Predict(predictors, loadedResponses);
+
+  for (size_t i = 0; i < responses.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(modelResponses[i], responses[i]);
+    BOOST_REQUIRE_EQUAL(loadedResponses[i], responses[i]);
+  }
+}
+
+/**
+ * Make sure a DensityTree read from a FlatDTree file gives the same densities
+ * as the tree it was made from.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeDensityTreeTest)
+{
+  arma::mat data = arma::randn<arma::mat>(3, 1000);
+  det::DTree* tree = det::Trainer(data, 5, false, 10, 5);
+
+  det::FlatDTree flatTree(*tree);
+  flatTree.Save("test_runtime_dtree.bin");
+  runtime::DensityTree densityTree("test_runtime_dtree.bin");
+  remove("test_runtime_dtree.bin");
+
+  const arma::mat queries = 1.5 * arma::randn<arma::mat>(3, 500);
+  arma::vec densities;
+  densityTree.ComputeValue(queries, densities);
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const arma::vec query = queries.col(i);
+    const double density = tree->ComputeValue(query);
+    BOOST_REQUIRE_EQUAL(densities[i], density);
+    BOOST_REQUIRE_EQUAL(densityTree.ComputeValue(query), density);
+  }
+
+  delete tree;
+}
+
+/**
+ * Make sure a KNNIndex read from a TreeIndex file finds the same neighbors as
+ * a naive search.
+ */
+BOOST_AUTO_TEST_CASE(RuntimeKNNIndexTest)
+{
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      neighbor::NeighborSearchStat<neighbor::NearestNeighborSort> > TreeType;
+
+  const arma::mat data = arma::randu<arma::mat>(4, 800);
+  arma::mat reordered(data);
+  tree::TreeIndex<TreeType> index(reordered, 15);
+  index.Save("test_runtime_index.bin");
+  runtime::KNNIndex knn("test_runtime_index.bin");
+  remove("test_runtime_index.bin");
+
+  const arma::mat queries = arma::randu<arma::mat>(4, 100);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(queries, 5, neighbors, distances);
+
+  neighbor::AllkNN naive(data, queries, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, queries.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -164,6 +164,81 @@ BOOST_AUTO_TEST_CASE(SaveArmaMat)
   delete sRM;
 }
 
+/**
+ * Test that the binary archive restores every parameter, that matrices are
+ * restored exactly, and that a copy of the utility can load the matrices after
+ * the original is gone.
+ */
+BOOST_AUTO_TEST_CASE(SaveRestoreBinaryArchive)
+{
+  size_t s = 12;
+  double d = 3.14159;
+  std::string cc = "Hello world!";
+  size_t numbers[] = {0,3,6,2,6};
+  std::vector<size_t> vec (numbers,
+                           numbers + sizeof (numbers) / sizeof (size_t));
+  arma::mat matrix = arma::randu<arma::mat>(13, 7);
+  arma::vec vector = arma::randu<arma::vec>(5);
+
+  SaveRestoreUtility* sRM = new SaveRestoreUtility();
+  sRM->SaveParameter(ARGSTR(s));
+  sRM->SaveParameter(ARGSTR(d));
+  sRM->SaveParameter(ARGSTR(cc));
+  sRM->SaveParameter(ARGSTR(vec));
+  sRM->SaveParameter(ARGSTR(matrix));
+  sRM->SaveParameter(ARGSTR(vector));
+  BOOST_REQUIRE(sRM->WriteFile("test_binary_archive.bin"));
+
+  // The file is not XML.
+  std::ifstream stream("test_binary_archive.bin", std::ios::binary);
+  char magic[8];
+  stream.read(magic, 8);
+  BOOST_REQUIRE(std::string(magic, 8) == "MLPKPARM");
+  stream.close();
+
+  SaveRestoreUtility* loader = new SaveRestoreUtility();
+  BOOST_REQUIRE(loader->ReadFile("test_binary_archive.bin"));
+  SaveRestoreUtility copy(*loader);
+  delete loader;
+  delete sRM;
+
+  size_t s2 = copy.LoadParameter(ARGSTR(s));
+  double d2 = copy.LoadParameter(ARGSTR(d));
+  std::string cc2 = copy.LoadParameter(ARGSTR(cc));
+  std::vector<size_t> vec2 = copy.LoadParameter(ARGSTR(vec));
+  arma::mat matrix2 = copy.LoadParameter(ARGSTR(matrix));
+  arma::vec vector2 = copy.LoadParameter(ARGSTR(vector));
+
+  BOOST_REQUIRE(s == s2);
+  BOOST_REQUIRE_CLOSE(d, d2, 1e-5);
+  BOOST_REQUIRE(cc == cc2);
+  BOOST_REQUIRE_EQUAL(vec2.size(), vec.size());
+  for (size_t index = 0; index < vec.size(); ++index)
+    BOOST_REQUIRE_EQUAL(vec[index], vec2[index]);
+
+  BOOST_REQUIRE_EQUAL(matrix2.n_rows, matrix.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix2.n_cols, matrix.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE(matrix[i] == matrix2[i]);
+
+  BOOST_REQUIRE_EQUAL(vector2.n_elem, vector.n_elem);
+  for (size_t i = 0; i < vector.n_elem; ++i)
+    BOOST_REQUIRE(vector[i] == vector2[i]);
+
+  // Writing the loaded archive to XML and back gives the same parameters.
+  BOOST_REQUIRE(copy.WriteFile("test_binary_archive.xml"));
+  SaveRestoreUtility xml;
+  BOOST_REQUIRE(xml.ReadFile("test_binary_archive.xml"));
+  arma::mat matrix3 = xml.LoadParameter(ARGSTR(matrix));
+  std::string cc3 = xml.LoadParameter(ARGSTR(cc));
+  BOOST_REQUIRE(cc == cc3);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(matrix[i], matrix3[i], 1e-3);
+
+  remove("test_binary_archive.bin");
+  remove("test_binary_archive.xml");
+}
+
 /**
  * Test SaveRestoreModel proper usage in child classes and loading from
  *   separately defined objects
@@ -49,6 +49,43 @@ BOOST_AUTO_TEST_CASE(SimpleSGDTestFunction)
   BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
 }
 
+/**
+ * With a batch size of 2, the test function (which has no batch overloads) is
+ * evaluated one function at a time; the minimum should be the same.
+ */
+BOOST_AUTO_TEST_CASE(SimpleSGDTestFunctionBatch)
+{
+  SGDTestFunction f;
+  SGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true, 2);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(coordinates);
+
+  BOOST_REQUIRE_CLOSE(result, -1.0, 0.05);
+  BOOST_REQUIRE_SMALL(coordinates[0], 1e-3);
+  BOOST_REQUIRE_SMALL(coordinates[1], 1e-7);
+  BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
+}
+
+/**
+ * Full-batch steps with momentum, with the gradients of the batch summed by two
+ * threads, should find the same minimum.
+ */
+BOOST_AUTO_TEST_CASE(SimpleSGDTestFunctionMomentum)
+{
+  SGDTestFunction f;
+  SGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true, 3, 0.9);
+  s.Threads() = 2;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(coordinates);
+
+  BOOST_REQUIRE_CLOSE(result, -1.0, 0.05);
+  BOOST_REQUIRE_SMALL(coordinates[0], 1e-3);
+  BOOST_REQUIRE_SMALL(coordinates[1], 1e-7);
+  BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
+}
+
 BOOST_AUTO_TEST_CASE(GeneralizedRosenbrockTest)
 {
   // Loop over several variants.
@@ -0,0 +1,147 @@
+/**
+ * @file softmax_regression_test.cpp
+ *
+ * Tests for SoftmaxRegressionFunction and SoftmaxRegression.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/softmax_regression/softmax_regression.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::regression;
+using namespace mlpack::optimization;
+using namespace mlpack::distribution;
+
+BOOST_AUTO_TEST_SUITE(SoftmaxRegressionTest);
+
+/**
+ * Test that with all parameters zero, each class has the same probability, so
+ * the objective is n log(k).
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionZeroEvaluate)
+{
+  arma::mat data;
+  data.randu(4, 50);
+  arma::Col<size_t> labels(50);
+  for (size_t i = 0; i < 50; ++i)
+    labels[i] = i % 3;
+
+  SoftmaxRegressionFunction srf(data, labels, 3, 0.5);
+  const arma::mat parameters = arma::zeros<arma::mat>(3, 5);
+
+  BOOST_REQUIRE_CLOSE(srf.Evaluate(parameters), 50 * std::log(3.0), 1e-5);
+}
+
+/**
+ * Compare the gradient with a finite-difference approximation, and make sure
+ * EvaluateWithGradient() gives the same results as Evaluate() and Gradient().
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionGradient)
+{
+  arma::mat data;
+  data.randu(4, 30);
+  arma::Col<size_t> labels(30);
+  for (size_t i = 0; i < 30; ++i)
+    labels[i] = math::RandInt(4);
+
+  SoftmaxRegressionFunction srf(data, labels, 4, 0.3);
+
+  arma::mat parameters;
+  parameters.randn(4, 5);
+
+  arma::mat gradient;
+  srf.Gradient(parameters, gradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, 5);
+
+  const double epsilon = 1e-6;
+  for (size_t j = 0; j < parameters.n_elem; ++j)
+  {
+    arma::mat plus(parameters), minus(parameters);
+    plus[j] += epsilon;
+    minus[j] -= epsilon;
+
+    const double estimate = (srf.Evaluate(plus) - srf.Evaluate(minus)) /
+        (2 * epsilon);
+    BOOST_REQUIRE_CLOSE(gradient[j], estimate, 1e-3);
+  }
+
+  arma::mat combinedGradient;
+  const double objective = srf.EvaluateWithGradient(parameters,
+      combinedGradient);
+  BOOST_REQUIRE_CLOSE(objective, srf.Evaluate(parameters), 1e-5);
+  for (size_t j = 0; j < parameters.n_elem; ++j)
+    BOOST_REQUIRE_CLOSE(combinedGradient[j], gradient[j], 1e-5);
+}
+
+/**
+ * Train a softmax regression model on three well-separated Gaussians, with
+ * enough points that Predict() works on more than one block.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionGaussianTest)
+{
+  GaussianDistribution g1(arma::vec("1.0 1.0 1.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g2(arma::vec("9.0 9.0 9.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g3(arma::vec("1.0 9.0 1.0"), arma::eye<arma::mat>(3, 3));
+
+  arma::mat data(3, 1500);
+  arma::Col<size_t> labels(1500);
+  for (size_t i = 0; i < 1500; ++i)
+  {
+    labels[i] = i % 3;
+    data.col(i) = (labels[i] == 0) ? g1.Random() :
+        (labels[i] == 1) ? g2.Random() : g3.Random();
+  }
+
+  SoftmaxRegression<> sr(data, labels, 3, 0.5);
+  BOOST_REQUIRE_EQUAL(sr.NumClasses(), 3);
+  BOOST_REQUIRE_EQUAL(sr.Parameters().n_cols, 4);
+
+  const double acc = sr.ComputeAccuracy(data, labels);
+  BOOST_REQUIRE_CLOSE(acc, 100.0, 0.5); // 0.5% error tolerance.
+
+  // A model built from the parameters predicts the same classes.
+  SoftmaxRegression<> sr2(sr.Parameters());
+  arma::Col<size_t> predictions, predictions2;
+  sr.Predict(data, predictions);
+  sr2.Predict(data, predictions2);
+  for (size_t i = 0; i < 1500; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], predictions2[i]);
+}
+
+/**
+ * With two classes, softmax regression classifies an easy problem like logistic
+ * regression would.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionTwoClasses)
+{
+  arma::mat data("1 2 3 7 8 9;"
+                 "1 1 2 8 9 9");
+  arma::Col<size_t> labels("0 0 0 1 1 1");
+
+  SoftmaxRegression<> sr(data, labels, 2, 0.1);
+
+  arma::Col<size_t> predictions;
+  sr.Predict(data, predictions);
+  for (size_t i = 0; i < 6; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], labels[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -116,6 +116,38 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestCodingStepElasticNet)
   }
 }
 
+/**
+ * Make sure that the coding step gives the same codes in parallel.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingTestParallelCodingStep)
+{
+  double lambda1 = 0.1;
+  double lambda2 = 0.2;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  SparseCoding<> sc(X, nAtoms, lambda1, lambda2);
+  sc.OptimizeCode();
+  const mat Z = sc.Codes();
+
+  const size_t threads[] = { 2, 4, 0 };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    sc.Codes().zeros();
+    sc.Threads() = threads[t];
+    sc.OptimizeCode();
+
+    for (uword i = 0; i < Z.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(sc.Codes()[i], Z[i]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(SparseCodingTestDictionaryStep)
 {
   const double tol = 2e-7;
@@ -143,6 +175,91 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestDictionaryStep)
   BOOST_REQUIRE_SMALL(normGradient, tol);
 }
 
+/**
+ * Sparse coding on sparse data should give the same results as on the same
+ * data stored densely.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingSparseDataTest)
+{
+  double lambda1 = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  // Most of the pixels are zero.
+  const sp_mat sparseX(X);
+
+  SparseCoding<> sc(X, nAtoms, lambda1);
+  SparseCoding<NothingInitializer, sp_mat> sparseSC(sparseX, nAtoms, lambda1);
+  sparseSC.Dictionary() = sc.Dictionary();
+
+  // The coding step sees the same points.
+  sc.OptimizeCode();
+  sparseSC.OptimizeCode();
+  for (uword i = 0; i < sc.Codes().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(sparseSC.Codes()[i], sc.Codes()[i]);
+
+  BOOST_REQUIRE_CLOSE(sparseSC.Objective(), sc.Objective(), 1e-5);
+
+  uvec adjacencies = find(sc.Codes());
+  sc.OptimizeDictionary(adjacencies, 1e-12);
+  sparseSC.OptimizeDictionary(adjacencies, 1e-12);
+  for (uword i = 0; i < sc.Dictionary().n_elem; ++i)
+  {
+    if (std::abs(sc.Dictionary()[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sparseSC.Dictionary()[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(sparseSC.Dictionary()[i], sc.Dictionary()[i], 1e-4);
+  }
+}
+
+/**
+ * The block coordinate descent dictionary step must not increase the
+ * objective, and must keep every atom in the unit ball.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingBlockCoordinateTest)
+{
+  double lambda1 = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  SparseCoding<> sc(X, nAtoms, lambda1);
+  sc.OptimizeCode();
+
+  uvec adjacencies = find(sc.Codes());
+  const double objective = sc.Objective();
+  const double change = sc.OptimizeDictionaryBlockCoordinate(adjacencies,
+      1e-10, 1000);
+
+  BOOST_REQUIRE_SMALL(change, 1e-10);
+  for (uword j = 0; j < nAtoms; ++j)
+    BOOST_REQUIRE_LE(norm(sc.Dictionary().col(j), 2), 1.0 + 1e-10);
+
+  // The codes do not use the reinitialized inactive atoms, so they do not
+  // change the objective.
+  BOOST_REQUIRE_LE(sc.Objective(), objective + 1e-10);
+
+  // Encode() with block coordinate descent does not increase the objective
+  // either.
+  SparseCoding<> bcdSC(X, nAtoms, lambda1);
+  bcdSC.BlockCoordinate() = true;
+  bcdSC.OptimizeCode();
+  const double initialObjective = bcdSC.Objective();
+  bcdSC.Encode(3);
+  BOOST_REQUIRE_LE(bcdSC.Objective(), initialObjective + 1e-10);
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SparseCodingTestWhole)
 {
@@ -0,0 +1,200 @@
+/**
+ * @file synthetic_test.cpp
+ *
+ * Tests for the synthetic dataset generators.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/synthetic/gaussian_mixture_generator.hpp>
+#include <mlpack/methods/synthetic/clustered_embedding_generator.hpp>
+#include <mlpack/methods/synthetic/power_law_sparse_generator.hpp>
+#include <mlpack/methods/synthetic/hmm_sequence_generator.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+BOOST_AUTO_TEST_SUITE(SyntheticTest);
+
+using namespace mlpack;
+using namespace mlpack::synthetic;
+
+/**
+ * The points of each Gaussian should have the mean and covariance of that
+ * Gaussian, and the Gaussians should be chosen with their weights.
+ */
+BOOST_AUTO_TEST_CASE(GaussianMixtureGeneratorTest)
+{
+  math::RandomSeed(10);
+  GaussianMixtureGenerator generator(3, 4);
+
+  // Draw the points in two batches.
+  arma::mat data1, data2;
+  arma::Col<size_t> labels1, labels2;
+  generator.Generate(30000, data1, labels1);
+  generator.Generate(20000, data2, labels2);
+
+  const arma::mat data = arma::join_rows(data1, data2);
+  const arma::Col<size_t> labels = arma::join_cols(labels1, labels2);
+  BOOST_REQUIRE_EQUAL(data.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(data.n_cols, 50000);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 50000);
+
+  for (size_t g = 0; g < 4; ++g)
+  {
+    const arma::uvec points = arma::find(labels == g);
+    BOOST_REQUIRE_CLOSE((double) points.n_elem / 50000.0,
+        generator.Weights()[g], 5.0);
+
+    arma::mat gaussianData(3, points.n_elem);
+    for (size_t i = 0; i < points.n_elem; ++i)
+      gaussianData.col(i) = data.col(points[i]);
+
+    const arma::vec mean = arma::mean(gaussianData, 1);
+    const arma::mat covariance = ccov(gaussianData);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_SMALL(mean[i] - generator.Means()(i, g), 0.05);
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_SMALL(covariance(i, j) -
+            generator.Covariances()[g](i, j), 0.05);
+    }
+  }
+
+  BOOST_REQUIRE(arma::max(labels) < 4);
+}
+
+/**
+ * The points should be normalized, and near the subspace of their cluster.
+ */
+BOOST_AUTO_TEST_CASE(ClusteredEmbeddingGeneratorTest)
+{
+  math::RandomSeed(10);
+  ClusteredEmbeddingGenerator generator(50, 5, 3, 0.3, 0.0);
+
+  arma::mat data;
+  arma::Col<size_t> labels;
+  generator.Generate(1000, data, labels);
+  BOOST_REQUIRE_EQUAL(data.n_rows, 50);
+  BOOST_REQUIRE_EQUAL(data.n_cols, 1000);
+
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BOOST_REQUIRE_LT(labels[i], 5);
+    BOOST_REQUIRE_CLOSE(arma::norm(data.col(i), 2), 1.0, 1e-8);
+
+    // Without noise, the point (before normalization) is the center plus a
+    // vector of the subspace; so the part of the point outside the span of the
+    // center and the subspace is zero.
+    const size_t c = labels[i];
+    arma::mat span = arma::join_rows(generator.Centers().col(c),
+        generator.Bases()[c]);
+    const arma::vec coefficients = arma::solve(span, data.col(i));
+    BOOST_REQUIRE_SMALL(arma::norm(span * coefficients - data.col(i), 2),
+        1e-8);
+  }
+}
+
+/**
+ * The coordinate list should hold distinct elements in column-major order,
+ * with about the requested number in each column, and the first rows should
+ * hold many more elements than the last ones.
+ */
+BOOST_AUTO_TEST_CASE(PowerLawSparseGeneratorTest)
+{
+  math::RandomSeed(10);
+  PowerLawSparseGenerator generator(1000, 2000, 10.0);
+
+  arma::Col<size_t> rowCounts(1000);
+  rowCounts.zeros();
+  size_t elements = 0;
+  size_t lastRow = 0;
+  size_t lastColumn = 0;
+
+  arma::mat coordinates;
+  size_t columns;
+  while ((columns = generator.Generate(300, coordinates)) > 0)
+  {
+    BOOST_REQUIRE_EQUAL(coordinates.n_rows, 3);
+    for (size_t i = 0; i < coordinates.n_cols; ++i)
+    {
+      const size_t row = (size_t) coordinates(0, i);
+      const size_t column = (size_t) coordinates(1, i);
+      BOOST_REQUIRE_LT(row, 1000);
+      BOOST_REQUIRE_LT(column, generator.ColumnsGenerated());
+      BOOST_REQUIRE_GE(coordinates(2, i), 1.0);
+      BOOST_REQUIRE_LE(coordinates(2, i), 5.0);
+
+      // Elements are sorted by column, then row, with no repeats.
+      if (elements > 0)
+        BOOST_REQUIRE((column > lastColumn) ||
+            (column == lastColumn && row > lastRow));
+
+      ++rowCounts[row];
+      ++elements;
+      lastRow = row;
+      lastColumn = column;
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(generator.ColumnsGenerated(), 2000);
+  // The number of elements of a column has infinite variance (and is limited
+  // by the number of rows), so the mean is only checked loosely.
+  BOOST_REQUIRE_GT(elements, 2000 * 6);
+  BOOST_REQUIRE_LT(elements, 2000 * 14);
+  BOOST_REQUIRE_GT(rowCounts[0], 10 * rowCounts[999] + 10);
+}
+
+/**
+ * The sequences should mostly stay in the same state, and the observations of
+ * each state should be near the mean of its emission.
+ */
+BOOST_AUTO_TEST_CASE(HMMSequenceGeneratorTest)
+{
+  math::RandomSeed(10);
+  HMMSequenceGenerator generator(3, 2, 0.9);
+
+  arma::mat sequence;
+  arma::Col<size_t> states;
+  generator.Generate(20000, sequence, states);
+  BOOST_REQUIRE_EQUAL(sequence.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(sequence.n_cols, 20000);
+  BOOST_REQUIRE_EQUAL(states.n_elem, 20000);
+
+  size_t stays = 0;
+  for (size_t t = 1; t < 20000; ++t)
+    if (states[t] == states[t - 1])
+      ++stays;
+  BOOST_REQUIRE_CLOSE((double) stays / 19999.0, 0.9, 2.0);
+
+  for (size_t s = 0; s < 3; ++s)
+  {
+    const arma::uvec steps = arma::find(states == s);
+    BOOST_REQUIRE_GT(steps.n_elem, 0);
+
+    arma::vec mean(2);
+    mean.zeros();
+    for (size_t i = 0; i < steps.n_elem; ++i)
+      mean += sequence.col(steps[i]);
+    mean /= steps.n_elem;
+
+    for (size_t i = 0; i < 2; ++i)
+      BOOST_REQUIRE_SMALL(mean[i] - generator.Model().Emission()[s].Mean()[i],
+          0.1);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,67 @@
+/**
+ * @file thread_communicator.hpp
+ *
+ * A Communicator whose ranks are the threads of an OpenMP parallel region, for
+ * testing distributed methods in one process.
+ *
+ * This file is part of MLPACK 1.0.8.
+ *
+ * MLPACK is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * MLPACK is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details (LICENSE.txt).
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __MLPACK_TESTS_THREAD_COMMUNICATOR_HPP
+#define __MLPACK_TESTS_THREAD_COMMUNICATOR_HPP
+
+#include <mlpack/core.hpp>
+
+#include <vector>
+
+/**
+ * A communicator for one thread of a parallel region with as many threads as
+ * there are ranks.  Every thread has its own ThreadCommunicator, and they all
+ * share the given buffers (one for each rank).  Sum() adds the buffers in rank
+ * order, so every rank gets the same sums.
+ */
+class ThreadCommunicator : public mlpack::Communicator
+{
+ public:
+  ThreadCommunicator(std::vector<std::vector<double> >& buffers,
+                     const size_t rank) :
+      buffers(buffers),
+      rank(rank)
+  { }
+
+  size_t Rank() const { return rank; }
+
+  size_t Ranks() const { return buffers.size(); }
+
+  void Sum(double* values, const size_t count)
+  {
+    buffers[rank].assign(values, values + count);
+    #pragma omp barrier
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      values[i] = 0.0;
+      for (size_t r = 0; r < buffers.size(); ++r)
+        values[i] += buffers[r][i];
+    }
+    #pragma omp barrier
+  }
+
+ private:
+  std::vector<std::vector<double> >& buffers;
+  size_t rank;
+};
+
+#endif
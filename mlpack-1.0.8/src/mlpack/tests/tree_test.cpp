@@ -21,6 +21,8 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/bounds.hpp>
 #include <mlpack/core/tree/binary_space_tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/prefetch.hpp>
+#include <mlpack/core/tree/tree_tuner.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/core/tree/cosine_tree/cosine_tree.hpp>
@@ -126,6 +128,38 @@ BOOST_AUTO_TEST_CASE(HRectBoundClear)
   BOOST_REQUIRE_SMALL(b[1].Width(), 1e-5);
 }
 
+/**
+ * Test that the dimensions can be modified in place, and that the limits are
+ * stored in the arrays given by Lo() and Hi().
+ */
+BOOST_AUTO_TEST_CASE(HRectBoundLimits)
+{
+  HRectBound<2> b(3);
+
+  b[0] = Range(0.0, 2.0);
+  b[1].Lo() = -1.0;
+  b[1].Hi() = 1.0;
+  b[2] = b[0];
+  b[2] |= Range(3.0, 4.0);
+
+  const double lo[] = { 0.0, -1.0, 0.0 };
+  const double hi[] = { 2.0, 1.0, 4.0 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(b.Lo()[i], lo[i]);
+    BOOST_REQUIRE_EQUAL(b.Hi()[i], hi[i]);
+
+    const Range range = b[i];
+    BOOST_REQUIRE_EQUAL(range.Lo(), lo[i]);
+    BOOST_REQUIRE_EQUAL(range.Hi(), hi[i]);
+  }
+
+  BOOST_REQUIRE_CLOSE(b[2].Width(), 4.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b[2].Mid(), 2.0, 1e-5);
+  BOOST_REQUIRE(b[1].Contains(0.5));
+  BOOST_REQUIRE(!b[1].Contains(1.5));
+}
+
 /**
  * Ensure that we get the correct centroid for our bound.
  */
@@ -985,6 +1019,63 @@ BOOST_AUTO_TEST_CASE(HRectBoundDiameter)
   BOOST_REQUIRE_SMALL(d.Diameter(), 1e-5);
 }
 
+/**
+ * Ensure that a bound of fixed dimensionality gives the same distances as one
+ * whose dimensionality is known only at run time, and that it copies
+ * correctly.
+ */
+BOOST_AUTO_TEST_CASE(HRectBoundFixedDimension)
+{
+  HRectBound<2, true, 3> empty;
+  BOOST_REQUIRE_EQUAL(empty.Dim(), 3);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE(empty[i].Lo() > empty[i].Hi());
+
+  for (size_t trial = 0; trial < 50; ++trial)
+  {
+    const arma::mat aPoints = arma::randu<arma::mat>(3, 5);
+    const arma::mat bPoints = arma::randu<arma::mat>(3, 5) + 0.5;
+    const arma::vec point = arma::randu<arma::vec>(3) * 2.0;
+
+    HRectBound<2, true> a(3), b(3);
+    a |= aPoints;
+    b |= bPoints;
+    HRectBound<2, true, 3> fixedA(3), fixedB;
+    fixedA |= aPoints;
+    fixedB |= bPoints;
+
+    // Copies must not share the limits.
+    HRectBound<2, true, 3> copyA(fixedA);
+    HRectBound<2, true, 3> assignedA;
+    assignedA = fixedA;
+    fixedA |= arma::vec(arma::zeros<arma::vec>(3));
+    fixedA = copyA;
+
+    BOOST_REQUIRE_CLOSE(fixedA.MinDistance(point), a.MinDistance(point), 1e-5);
+    BOOST_REQUIRE_CLOSE(fixedA.MaxDistance(point), a.MaxDistance(point), 1e-5);
+    BOOST_REQUIRE_CLOSE(assignedA.MaxDistance(fixedB), a.MaxDistance(b),
+        1e-5);
+    BOOST_REQUIRE_CLOSE(copyA.Diameter(), a.Diameter(), 1e-5);
+
+    const double minDistance = a.MinDistance(b);
+    if (minDistance == 0.0)
+      BOOST_REQUIRE_SMALL(fixedA.MinDistance(fixedB), 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(fixedA.MinDistance(fixedB), minDistance, 1e-5);
+
+    const math::Range r = fixedA.RangeDistance(fixedB);
+    BOOST_REQUIRE_CLOSE(r.Hi(), a.RangeDistance(b).Hi(), 1e-5);
+
+    // The fixed-dimension metric agrees with the usual one.
+    BOOST_REQUIRE_CLOSE((metric::LMetric<2, true, 3>::Evaluate(point,
+        aPoints.unsafe_col(0))), metric::EuclideanDistance::Evaluate(point,
+        aPoints.unsafe_col(0)), 1e-5);
+    BOOST_REQUIRE_CLOSE((metric::LMetric<1, false, 3>::Evaluate(point,
+        aPoints.unsafe_col(1))), metric::ManhattanDistance::Evaluate(point,
+        aPoints.unsafe_col(1)), 1e-5);
+  }
+}
+
 /**
  * Ensure that a bound, by default, is empty and has no dimensionality, and the
  * box size vector is empty.
@@ -1051,7 +1142,7 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundCopyConstructor)
 
 /**
  * Test the assignment operator.
- *
+ */
 BOOST_AUTO_TEST_CASE(PeriodicHRectBoundAssignmentOperator)
 {
   PeriodicHRectBound<2> b(arma::vec("3 4"));
@@ -1070,11 +1161,11 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundAssignmentOperator)
   BOOST_REQUIRE_EQUAL(c.Box().n_elem, 2);
   BOOST_REQUIRE_CLOSE(c.Box()[0], 3.0, 1e-5);
   BOOST_REQUIRE_CLOSE(c.Box()[1], 4.0, 1e-5);
-}*/
+}
 
 /**
  * Ensure that we can set the box size correctly.
- *
+ */
 BOOST_AUTO_TEST_CASE(PeriodicHRectBoundSetBoxSize)
 {
   PeriodicHRectBound<2> b(arma::vec("1 2"));
@@ -1084,12 +1175,12 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundSetBoxSize)
   BOOST_REQUIRE_EQUAL(b.Box().n_elem, 2);
   BOOST_REQUIRE_CLOSE(b.Box()[0], 10.0, 1e-5);
   BOOST_REQUIRE_CLOSE(b.Box()[1], 12.0, 1e-5);
-}*/
+}
 
 /**
  * Ensure that we can clear the dimensions correctly.  This does not involve the
  * box size at all, so the test can be identical to the HRectBound test.
- *
+ */
 BOOST_AUTO_TEST_CASE(PeriodicHRectBoundClear)
 {
   // We'll do this with two dimensions only.
@@ -1103,12 +1194,13 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundClear)
 
   BOOST_REQUIRE_SMALL(b[0].Width(), 1e-5);
   BOOST_REQUIRE_SMALL(b[1].Width(), 1e-5);
-}*/
+}
 
 /**
  * Ensure that we get the correct centroid for our bound.
- *
-BOOST_AUTO_TEST_CASE(PeriodicHRectBoundCentroid) {
+ */
+BOOST_AUTO_TEST_CASE(PeriodicHRectBoundCentroid)
+{
   // Create a simple 3-dimensional bound.  The centroid is not affected by the
   // periodic coordinates.
   PeriodicHRectBound<2> b(arma::vec("100 100 100"));
@@ -1125,7 +1217,7 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundCentroid) {
   BOOST_REQUIRE_CLOSE(centroid[0], 2.5, 1e-5);
   BOOST_REQUIRE_CLOSE(centroid[1], -1.5, 1e-5);
   BOOST_REQUIRE_CLOSE(centroid[2], 20.0, 1e-5);
-}*/
+}
 
 /**
  * Correctly calculate the minimum distance between the bound and a point in
@@ -1509,6 +1601,73 @@ BOOST_AUTO_TEST_CASE(PeriodicHRectBoundMaxDistanceBound)
   BOOST_REQUIRE_CLOSE(a.MaxDistance(d), 24.01, 1e-5);
 }*/
 
+/**
+ * Make sure that the distances of a periodic bound are the distances to the
+ * nearest periodic image, across the faces of the box and in a dimension which
+ * is not periodic, and that they bound the distances of the periodic metric
+ * between the points in bounds.
+ */
+BOOST_AUTO_TEST_CASE(PeriodicHRectBoundDistances)
+{
+  const arma::vec box("10.0 4.0 0.0");
+  PeriodicLMetric<2, true> metric(box);
+
+  // The point is near the opposite faces of the box in the periodic
+  // dimensions.
+  PeriodicHRectBound<2> b(box);
+  b[0] = Range(1.0, 2.0);
+  b[1] = Range(0.5, 1.0);
+  b[2] = Range(0.0, 1.0);
+
+  arma::vec point("9.5 3.5 0.5");
+  BOOST_REQUIRE_CLOSE(b.MinDistance(point), sqrt(1.5 * 1.5 + 1.0 * 1.0),
+      1e-5);
+  BOOST_REQUIRE_CLOSE(b.MaxDistance(point), sqrt(2.5 * 2.5 + 1.5 * 1.5 +
+      0.5 * 0.5), 1e-5);
+
+  // No point is further than half the box in a periodic dimension.
+  PeriodicHRectBound<2> c(box);
+  c[0] = Range(0.0, 9.0);
+  c[1] = Range(0.0, 1.0);
+  c[2] = Range(-1.0, 1.0);
+  BOOST_REQUIRE_CLOSE(c.MaxDistance(c), sqrt(5.0 * 5.0 + 1.0 * 1.0 +
+      2.0 * 2.0), 1e-5);
+
+  // Now bounds of random points, which are not all inside the box.
+  for (size_t trial = 0; trial < 50; ++trial)
+  {
+    arma::mat first = arma::randu<arma::mat>(3, 10) * 8.0 - 2.0;
+    arma::mat second = arma::randu<arma::mat>(3, 10) * 8.0 - 2.0;
+    arma::vec query = arma::randu<arma::vec>(3) * 8.0 - 2.0;
+
+    PeriodicHRectBound<2> firstBound(3);
+    PeriodicHRectBound<2> secondBound(3);
+    firstBound |= first;
+    secondBound |= second;
+    firstBound.SetBoxSize(box);
+    secondBound.SetBoxSize(box);
+
+    const Range pointRange = firstBound.RangeDistance(query);
+    const Range boundRange = firstBound.RangeDistance(secondBound);
+    BOOST_REQUIRE_CLOSE(pointRange.Lo(), firstBound.MinDistance(query), 1e-5);
+    BOOST_REQUIRE_CLOSE(boundRange.Hi(), firstBound.MaxDistance(secondBound),
+        1e-5);
+
+    for (size_t i = 0; i < first.n_cols; ++i)
+    {
+      const double d = metric.Evaluate(first.col(i), query);
+      BOOST_REQUIRE_LE(pointRange.Lo(), d + 1e-10);
+      BOOST_REQUIRE_GE(pointRange.Hi(), d - 1e-10);
+
+      for (size_t j = 0; j < second.n_cols; ++j)
+      {
+        const double e = metric.Evaluate(first.col(i), second.col(j));
+        BOOST_REQUIRE_LE(boundRange.Lo(), e + 1e-10);
+        BOOST_REQUIRE_GE(boundRange.Hi(), e - 1e-10);
+      }
+    }
+  }
+}
 
 /**
  * It seems as though Bill has stumbled across a bug where
@@ -2106,6 +2265,212 @@ BOOST_AUTO_TEST_CASE(CoverTreeConstructionTest)
   CheckSeparation<CoverTree<>, LMetric<2, true> >(tree, tree);
 }
 
+//! Make sure that the two cover trees are the same.
+template<typename TreeType>
+void CheckSameCoverTree(const TreeType& node, const TreeType& other)
+{
+  BOOST_REQUIRE_EQUAL(node.Point(), other.Point());
+  BOOST_REQUIRE_EQUAL(node.Scale(), other.Scale());
+  BOOST_REQUIRE_EQUAL(node.NumChildren(), other.NumChildren());
+  BOOST_REQUIRE_EQUAL(node.NumDescendants(), other.NumDescendants());
+  BOOST_REQUIRE_EQUAL(node.ParentDistance(), other.ParentDistance());
+  BOOST_REQUIRE_EQUAL(node.FurthestDescendantDistance(),
+      other.FurthestDescendantDistance());
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(other.Child(i).Parent(), &other);
+    CheckSameCoverTree(node.Child(i), other.Child(i));
+  }
+}
+
+/**
+ * Make sure that building a cover tree with several threads gives the same
+ * tree as building it with one.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeParallelConstructionTest)
+{
+  arma::mat dataset;
+  // Enough points that the distances are computed in parallel.
+  dataset.randu(20, 3000);
+
+  CoverTree<> tree(dataset);
+  CoverTree<> parallelTree(dataset, 2.0, NULL, 4);
+  CheckSameCoverTree(tree, parallelTree);
+  BOOST_REQUIRE_EQUAL(tree.DistanceComps(), parallelTree.DistanceComps());
+
+  LMetric<2, true> metric;
+  CoverTree<> allCoresTree(dataset, metric, 1.3, 0);
+  CoverTree<> serialTree(dataset, metric, 1.3);
+  CheckSameCoverTree(serialTree, allCoresTree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(allCoresTree);
+  CheckSeparation<CoverTree<>, LMetric<2, true> >(allCoresTree, allCoresTree);
+}
+
+/**
+ * Make sure that the build pool reuses its memory, and never hands out
+ * overlapping arrays.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeBuildPoolTest)
+{
+  BuildPool pool(2);
+#ifdef _OPENMP
+  BOOST_REQUIRE_EQUAL(pool.Threads(), 2);
+#else
+  BOOST_REQUIRE_EQUAL(pool.Threads(), 1);
+#endif
+
+  size_t* a = pool.AllocateIndices(100);
+  size_t* b = pool.AllocateIndices(50000);
+  // Too large for the first block.
+  size_t* c = pool.AllocateIndices(100000);
+  BOOST_REQUIRE(b >= a + 100);
+  BOOST_REQUIRE((c >= b + 50000) || (c + 100000 <= a));
+
+  for (size_t i = 0; i < 100000; ++i)
+    c[i] = i;
+  for (size_t i = 0; i < 100; ++i)
+    a[i] = 2;
+
+  pool.FreeIndices();
+  size_t* d = pool.AllocateIndices(100000);
+  BOOST_REQUIRE_EQUAL(c, d);
+  BOOST_REQUIRE_EQUAL(d[99999], 99999);
+
+  pool.FreeIndices();
+  pool.FreeIndices();
+  BOOST_REQUIRE_EQUAL(pool.AllocateIndices(10), b);
+  BOOST_REQUIRE_EQUAL(a[99], 2);
+
+  double* e = pool.AllocateDistances(10);
+  e[9] = 1.5;
+  pool.FreeDistances();
+  BOOST_REQUIRE_EQUAL(pool.AllocateDistances(10), e);
+}
+
+template<typename TreeType, typename MetricType>
+void CheckFurthestDescendant(const TreeType& node, const TreeType& root)
+{
+  // Every leaf below the root must be within the furthest descendant distance.
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    if (node.Child(i).NumChildren() == 0)
+    {
+      const double distance = MetricType::Evaluate(
+          root.Dataset().col(root.Point()),
+          root.Dataset().col(node.Child(i).Point()));
+      BOOST_REQUIRE_LE(distance, root.FurthestDescendantDistance() + 1e-10);
+    }
+    else
+    {
+      CheckFurthestDescendant<TreeType, MetricType>(node.Child(i), root);
+      CheckFurthestDescendant<TreeType, MetricType>(node.Child(i),
+          node.Child(i));
+    }
+  }
+}
+
+/**
+ * Insert points into a built cover tree and remove them again, and make sure
+ * that the tree is still valid.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeInsertRemoveTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 300);
+  CoverTree<> tree(dataset);
+
+  dataset.insert_cols(300, arma::randu<arma::mat>(8, 300));
+  for (size_t i = 300; i < 600; ++i)
+    tree.Insert(i);
+
+  arma::vec counts;
+  counts.zeros(600);
+  RecurseTreeCountLeaves(tree, counts);
+  for (size_t i = 0; i < 600; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 600);
+  CheckSelfChild<CoverTree<> >(tree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(tree);
+  CheckFurthestDescendant<CoverTree<>, LMetric<2, true> >(tree, tree);
+
+  // Remove the root point and every third point.
+  std::vector<bool> removed(600, false);
+  for (size_t i = 0; i < 600; i += 3)
+  {
+    tree.Remove(i);
+    removed[i] = true;
+  }
+
+  counts.zeros(600);
+  RecurseTreeCountLeaves(tree, counts);
+  for (size_t i = 0; i < 600; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], (removed[i] ? 0 : 1));
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 400);
+  CheckSelfChild<CoverTree<> >(tree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(tree);
+  CheckFurthestDescendant<CoverTree<>, LMetric<2, true> >(tree, tree);
+}
+
+//! Check that every non-leaf node below the given one has at least two
+//! children, which are adjacent in memory and point back to it, and return the
+//! number of nodes.
+template<typename TreeType>
+size_t CheckCompactTree(const TreeType& node)
+{
+  BOOST_REQUIRE_NE(node.NumChildren(), 1);
+
+  size_t count = 1;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(&node.Child(i), &node.Child(0) + i);
+    BOOST_REQUIRE_EQUAL(node.Child(i).Parent(), &node);
+    count += CheckCompactTree(node.Child(i));
+  }
+
+  return count;
+}
+
+/**
+ * A built cover tree should only hold explicit nodes, laid out so that the
+ * children of each node are adjacent, and Compact() should restore that layout
+ * after points are inserted.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeCompactTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 1000);
+  CoverTree<> tree(dataset);
+
+  // Each node with children has at least two, so there are fewer than two
+  // nodes per point.
+  BOOST_REQUIRE_LT(CheckCompactTree(tree), 2 * dataset.n_cols);
+
+  dataset.insert_cols(1000, arma::randu<arma::mat>(5, 200));
+  for (size_t i = 1000; i < 1200; ++i)
+    tree.Insert(i);
+  tree.Remove(3);
+  tree.Compact();
+
+  BOOST_REQUIRE_LT(CheckCompactTree(tree), 2 * dataset.n_cols);
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1199);
+  CheckSelfChild<CoverTree<> >(tree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(tree);
+  CheckFurthestDescendant<CoverTree<>, LMetric<2, true> >(tree, tree);
+
+  arma::vec counts;
+  counts.zeros(1200);
+  RecurseTreeCountLeaves(tree, counts);
+  for (size_t i = 0; i < 1200; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], (i == 3) ? 0 : 1);
+
+  // A copy is a separate (uncompacted) tree with the same structure.
+  CoverTree<> copy(tree);
+  CheckSameCoverTree(tree, copy);
+}
+
 /**
  * Test the manual constructor.
  */
@@ -2253,6 +2618,342 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeCopyConstructor)
   BOOST_REQUIRE_EQUAL(b.Right()->Right(), c.Right()->Right());
 }
 
+//! Check that two binary space trees have the same structure and bounds, and
+//! that every node of the second tree is flattened and has the right parent.
+template<typename TreeType>
+void CheckFlattenedTree(const TreeType* node, const TreeType* flatNode)
+{
+  BOOST_REQUIRE(flatNode->IsFlat());
+  BOOST_REQUIRE_EQUAL(node->Begin(), flatNode->Begin());
+  BOOST_REQUIRE_EQUAL(node->Count(), flatNode->Count());
+  BOOST_REQUIRE_EQUAL(node->SplitDimension(), flatNode->SplitDimension());
+  BOOST_REQUIRE_EQUAL(node->NumChildren(), flatNode->NumChildren());
+  BOOST_REQUIRE_CLOSE(node->FurthestDescendantDistance(),
+                      flatNode->FurthestDescendantDistance(), 1e-5);
+
+  for (size_t i = 0; i < node->Bound().Dim(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(node->Bound()[i].Lo(), flatNode->Bound()[i].Lo());
+    BOOST_REQUIRE_EQUAL(node->Bound()[i].Hi(), flatNode->Bound()[i].Hi());
+  }
+
+  if (node->Left() != NULL)
+  {
+    BOOST_REQUIRE_EQUAL(flatNode->Left()->Parent(), flatNode);
+    BOOST_REQUIRE_EQUAL(flatNode->Right()->Parent(), flatNode);
+
+    // Below the root, nodes are stored in depth-first order.
+    if (flatNode->Parent() != NULL)
+      BOOST_REQUIRE_EQUAL(flatNode->Left(), flatNode + 1);
+    BOOST_REQUIRE_EQUAL(flatNode->Right(),
+        flatNode->Left() + flatNode->Left()->TreeSize());
+
+    CheckFlattenedTree(node->Left(), flatNode->Left());
+    CheckFlattenedTree(node->Right(), flatNode->Right());
+  }
+}
+
+/**
+ * Make sure that flattening a binary space tree does not change it.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeFlattenTest)
+{
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+
+  arma::mat dataset(5, 1000);
+  dataset.randu();
+  arma::mat flatDataset(dataset);
+
+  TreeType root(dataset);
+  TreeType flatRoot(flatDataset);
+  BOOST_REQUIRE(!flatRoot.IsFlat());
+
+  flatRoot.Flatten();
+  BOOST_REQUIRE_EQUAL(root.TreeSize(), flatRoot.TreeSize());
+  BOOST_REQUIRE_EQUAL(flatRoot.Parent(), (TreeType*) NULL);
+  CheckFlattenedTree(&root, &flatRoot);
+
+  // Flattening again does nothing.
+  TreeType* left = flatRoot.Left();
+  flatRoot.Flatten();
+  BOOST_REQUIRE_EQUAL(flatRoot.Left(), left);
+
+  // A copy of a flattened tree is an ordinary tree.
+  TreeType copy(flatRoot);
+  BOOST_REQUIRE(!copy.IsFlat());
+  BOOST_REQUIRE(!copy.Left()->IsFlat());
+  BOOST_REQUIRE_EQUAL(copy.TreeSize(), root.TreeSize());
+}
+
+//! Make sure that the two trees have the same structure and bounds.
+template<typename TreeType>
+void CheckSameTree(const TreeType* node, const TreeType* other)
+{
+  BOOST_REQUIRE_EQUAL(node->Begin(), other->Begin());
+  BOOST_REQUIRE_EQUAL(node->Count(), other->Count());
+  BOOST_REQUIRE_EQUAL(node->NumChildren(), other->NumChildren());
+
+  for (size_t i = 0; i < node->Bound().Dim(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(node->Bound()[i].Lo(), other->Bound()[i].Lo());
+    BOOST_REQUIRE_EQUAL(node->Bound()[i].Hi(), other->Bound()[i].Hi());
+  }
+
+  if (node->Left() != NULL)
+  {
+    BOOST_REQUIRE_EQUAL(other->Left()->Parent(), other);
+    BOOST_REQUIRE_EQUAL(other->Right()->Parent(), other);
+    CheckSameTree(node->Left(), other->Left());
+    CheckSameTree(node->Right(), other->Right());
+  }
+}
+
+//! Make sure that no node is empty and that leaves are small enough (unless
+//! all of their points are the same).
+template<typename TreeType>
+void CheckNodeSizes(const TreeType* node, const size_t leafSize)
+{
+  BOOST_REQUIRE_GT(node->Count(), 0);
+
+  if (node->Left() == NULL)
+  {
+    if (node->Count() > leafSize)
+      for (size_t i = 0; i < node->Bound().Dim(); ++i)
+        BOOST_REQUIRE_EQUAL(node->Bound()[i].Width(), 0.0);
+    return;
+  }
+
+  BOOST_REQUIRE_EQUAL(node->Left()->Count() + node->Right()->Count(),
+      node->Count());
+  CheckNodeSizes(node->Left(), leafSize);
+  CheckNodeSizes(node->Right(), leafSize);
+}
+
+/**
+ * Make sure that a parallel build gives the same tree as a serial build.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeParallelBuildTest)
+{
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+
+  // Enough points that the upper levels are built as tasks.
+  arma::mat dataset(5, 40000);
+  dataset.randu();
+  arma::mat parallelDataset(dataset);
+
+  std::vector<size_t> oldFromNew;
+  std::vector<size_t> parallelOldFromNew;
+  TreeType root(dataset, oldFromNew, 20);
+  TreeType parallelRoot(parallelDataset, parallelOldFromNew,
+      BuildOptions(20, 4));
+
+  CheckSameTree(&root, &parallelRoot);
+
+  BOOST_REQUIRE_EQUAL(oldFromNew.size(), parallelOldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(oldFromNew[i], parallelOldFromNew[i]);
+
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(dataset[i], parallelDataset[i]);
+}
+
+/**
+ * Make sure that median splits give a valid, balanced tree, even when many
+ * points have the same value.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeMedianSplitTest)
+{
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+
+  // Very skewed data, where most points are in a corner.
+  arma::mat dataset(3, 20000);
+  dataset.randu();
+  dataset = arma::pow(dataset, 8.0);
+
+  // Many points share a value in the first dimension, so that the median of
+  // some nodes does not split them.
+  for (size_t i = 0; i < dataset.n_cols; i += 3)
+    dataset(0, i) = 0.0;
+
+  arma::mat original(dataset);
+  std::vector<size_t> oldFromNew;
+  TreeType root(dataset, oldFromNew, BuildOptions(10, 4, 101));
+
+  BOOST_REQUIRE_EQUAL(root.LeafSize(), 10);
+  CheckNodeSizes(&root, 10);
+  BOOST_REQUIRE(CheckPointBounds(&root, dataset));
+
+  // The points are only reordered.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(dataset(d, i), original(d, oldFromNew[i]));
+
+  // The root is split close to its median.
+  BOOST_REQUIRE_GT(root.Left()->Count(), 8000);
+  BOOST_REQUIRE_GT(root.Right()->Count(), 8000);
+}
+
+/**
+ * Build a kd-tree from the Morton order of the points, and make sure that the
+ * points are only reordered, that they are sorted along the Morton curve of
+ * the root bound, and that the tree is valid.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeMortonOrderTest)
+{
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+
+  arma::mat dataset(3, 5000);
+  dataset.randu();
+  dataset.row(1) *= 100.0;
+  arma::mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  TreeType root(dataset, oldFromNew, BuildOptions(10, 1, 0, true));
+
+  BOOST_REQUIRE_EQUAL(root.LeafSize(), 10);
+  CheckNodeSizes(&root, 10);
+  BOOST_REQUIRE(CheckPointBounds(&root, dataset));
+
+  // The points are only reordered.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(dataset(d, i), original(d, oldFromNew[i]));
+
+  // The points are in Morton order.
+  arma::vec lo(3), hi(3);
+  for (size_t d = 0; d < 3; ++d)
+  {
+    lo[d] = root.Bound()[d].Lo();
+    hi[d] = root.Bound()[d].Hi();
+  }
+  data::SpaceFillingCurve curve(lo, hi, data::MortonCurve);
+  for (size_t i = 1; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_LE(curve.Key(dataset.col(i - 1)), curve.Key(dataset.col(i)));
+}
+
+/**
+ * Sort the points of a grid along the Hilbert curve; consecutive points must
+ * be neighbors in the grid, and restoring the columns must give back the
+ * original dataset.
+ */
+BOOST_AUTO_TEST_CASE(HilbertCurveOrderTest)
+{
+  arma::mat dataset(2, 64);
+  for (size_t i = 0; i < 64; ++i)
+  {
+    dataset(0, i) = (double) (i % 8);
+    dataset(1, i) = (double) (i / 8);
+  }
+  arma::mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  data::SpaceFillingCurveOrder(dataset, oldFromNew, data::HilbertCurve);
+  data::ReorderColumns(dataset, oldFromNew);
+
+  for (size_t i = 1; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(ManhattanDistance::Evaluate(dataset.col(i - 1),
+        dataset.col(i)), 1.0, 1e-5);
+
+  data::RestoreColumns(dataset, oldFromNew);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(dataset[i], original[i]);
+}
+
+//! Check that every point under the given node is in its ball, and return the
+//! number of points under it.
+template<typename TreeType>
+size_t CheckBallContainment(const TreeType& node, const arma::mat& data)
+{
+  const BallBound<>& ball = node.Bound();
+  for (size_t i = node.Begin(); i < node.End(); ++i)
+    BOOST_REQUIRE_LE(EuclideanDistance::Evaluate(ball.Center(), data.col(i)),
+        ball.Radius() * (1 + 1e-10));
+
+  if (node.IsLeaf())
+    return node.Count();
+
+  // The points of the children are the points of the node.
+  BOOST_REQUIRE_EQUAL(node.Left()->Begin(), node.Begin());
+  BOOST_REQUIRE_EQUAL(node.Right()->Begin(), node.Left()->End());
+  return CheckBallContainment(*node.Left(), data) +
+      CheckBallContainment(*node.Right(), data);
+}
+
+/**
+ * Build a ball tree, and make sure that each ball holds all the points under
+ * its node, and that each node is split.
+ */
+BOOST_AUTO_TEST_CASE(BallTreeTest)
+{
+  typedef BinarySpaceTree<BallBound<> > TreeType;
+
+  arma::mat dataset;
+  dataset.randn(8, 2000);
+  arma::mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  TreeType root(dataset, oldFromNew, 10);
+
+  BOOST_REQUIRE_EQUAL(CheckBallContainment(root, dataset), dataset.n_cols);
+  CheckNodeSizes(&root, 10);
+  BOOST_REQUIRE(!root.IsLeaf());
+
+  // An empty ball is centered on the mean of its points.
+  const arma::vec mean = arma::mean(dataset, 1);
+  for (size_t d = 0; d < dataset.n_rows; ++d)
+    BOOST_REQUIRE_CLOSE(root.Bound().Center()[d], mean[d], 1e-5);
+
+  // The furthest descendant distance is the radius of the ball.
+  BOOST_REQUIRE_CLOSE(root.FurthestDescendantDistance(),
+      root.Bound().Radius(), 1e-5);
+
+  // The points are only reordered.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(dataset(d, i), original(d, oldFromNew[i]));
+}
+
+/**
+ * Build a random projection tree on high-dimensional data, and make sure that
+ * each ball holds all the points under its node, and that the splits are
+ * balanced.
+ */
+BOOST_AUTO_TEST_CASE(RPTreeTest)
+{
+  typedef BinarySpaceTree<BallBound<>, EmptyStatistic, arma::mat, RPSplit>
+      TreeType;
+
+  // 128-dimensional points near a 5-dimensional subspace.
+  arma::mat dataset = arma::randn<arma::mat>(128, 5) *
+      arma::randn<arma::mat>(5, 3000);
+  dataset += 0.01 * arma::randn<arma::mat>(128, 3000);
+  arma::mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  TreeType root(dataset, oldFromNew, 20);
+
+  BOOST_REQUIRE_EQUAL(CheckBallContainment(root, dataset), dataset.n_cols);
+  CheckNodeSizes(&root, 20);
+
+  // The root is split at the median of the projections.
+  BOOST_REQUIRE_EQUAL(root.Left()->Count(), dataset.n_cols / 2);
+  BOOST_REQUIRE_EQUAL(root.Right()->Count(), dataset.n_cols / 2);
+
+  // The points are only reordered.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(dataset(d, i), original(d, oldFromNew[i]));
+
+  // A parallel build gives a tree of the same size.
+  arma::mat parallelDataset(original);
+  std::vector<size_t> parallelOldFromNew;
+  TreeType parallelRoot(parallelDataset, parallelOldFromNew,
+      BuildOptions(20, 4));
+  BOOST_REQUIRE_EQUAL(CheckBallContainment(parallelRoot, parallelDataset),
+      dataset.n_cols);
+  CheckNodeSizes(&parallelRoot, 20);
+}
+
 //! Count the number of leaves under this node.
 template<typename TreeType>
 size_t NumLeaves(TreeType* node)
@@ -2369,111 +3070,68 @@ BOOST_AUTO_TEST_CASE(CoverTreeDescendantTest)
   CheckDescendants(&tree);
 }
 
-/*
+/**
  * Make sure that constructor for cosine tree is working.
  */
 BOOST_AUTO_TEST_CASE(CosineTreeConstructorTest)
 {
   // Create test data.
-  arma::mat data = arma::randu<arma::mat>(5, 5);
-  arma::rowvec centroid = arma::randu<arma::rowvec>(1, 5);
-  arma::vec probabilities = arma::randu<arma::vec>(5, 1);
-
-  // Creating a cosine tree.
-  CosineTree ct(data, centroid, probabilities);
+  arma::mat data = arma::randu<arma::mat>(5, 7);
 
-  const arma::mat& dataRet = ct.Data();
-  const arma::rowvec& centroidRet = ct.Centroid();
-  const arma::vec& probabilitiesRet = ct.Probabilities();
+  // Creating a cosine tree root, and a node on part of the data.
+  CosineTree ct(data);
+  CosineTree node(data, 2, 3, &ct);
 
-  // Check correctness of dimensionality of data matrix.
-  BOOST_REQUIRE_EQUAL(data.n_cols, dataRet.n_rows);
-  BOOST_REQUIRE_EQUAL(data.n_rows, dataRet.n_cols);
-
-  // Check the data matrix.
-  for (size_t i = 0; i < data.n_cols; i++)
-    for (size_t j = 0; j < data.n_rows; j++)
-      BOOST_REQUIRE_CLOSE((double) dataRet(j, i), (double) data(i, j), 1e-5);
+  // The nodes must refer to the dataset without copying it.
+  BOOST_REQUIRE_EQUAL(&ct.Dataset(), &data);
+  BOOST_REQUIRE_EQUAL(&node.Dataset(), &data);
 
-  // Check correctness of dimensionality of centroid.
-  BOOST_REQUIRE_EQUAL(centroid.n_cols, centroidRet.n_cols);
-  BOOST_REQUIRE_EQUAL(centroid.n_rows, centroidRet.n_rows);
-
-  // Check centroid.
-  for (size_t i = 0; i < centroid.n_cols; i++)
-    BOOST_REQUIRE_CLOSE((double) centroidRet(0, i), (double) centroid(0,i),
-        1e-5);
-
-  // Check correctness of dimentionality of sampling probabilities.
-  BOOST_REQUIRE_EQUAL(probabilities.n_cols, probabilitiesRet.n_cols);
-  BOOST_REQUIRE_EQUAL(probabilities.n_rows, probabilitiesRet.n_rows);
-
-  // Check sampling probabilities.
-  for (size_t i = 0; i < probabilities.n_rows; i++)
-    BOOST_REQUIRE_CLOSE((double) probabilitiesRet(i, 0), (double)
-        probabilities(i, 0), 1e-5);
+  BOOST_REQUIRE_EQUAL(ct.Begin(), 0);
+  BOOST_REQUIRE_EQUAL(ct.NumPoints(), 7);
+  BOOST_REQUIRE(ct.Parent() == NULL);
+  BOOST_REQUIRE_EQUAL(node.Begin(), 2);
+  BOOST_REQUIRE_EQUAL(node.NumPoints(), 3);
+  BOOST_REQUIRE_EQUAL(node.Point(1), 3);
+  BOOST_REQUIRE(node.Parent() == &ct);
 
   // Check pointers of children nodes.
   BOOST_REQUIRE(ct.Right() == NULL);
   BOOST_REQUIRE(ct.Left() == NULL);
-}
-
-/**
- * Make sure that CTNode function in Cosine tree builder is working.
- */
-BOOST_AUTO_TEST_CASE(CosineTreeEmptyConstructorTest)
-{
-  // Create a tree through the empty constructor.
-  CosineTree ct;
-
-  // Check to make sure it has no children.
-  BOOST_REQUIRE(ct.Right() == NULL);
-  BOOST_REQUIRE(ct.Left() == NULL);
+  BOOST_REQUIRE(ct.IsLeaf());
 }
 
 /**
  * Make sure that CTNode function in CosineTreeBuilder is working.
- * This test just validates the dimentionality and data.
+ * This test just validates the dimentionality of the statistics.
  */
 BOOST_AUTO_TEST_CASE(CosineTreeBuilderCTNodeTest)
 {
   // Create dummy test data.
-  arma::mat data = arma::randu<arma::mat>(5, 5);
+  arma::mat data = arma::randu<arma::mat>(5, 6);
+  const arma::mat original = data;
 
   // Create a cosine tree builder object.
   CosineTreeBuilder builder;
 
-  // Create a cosine tree object.
-  CosineTree ct;
-
-  // Use the builder to create the tree.
-  builder.CTNode(data, ct);
+  // Create a cosine tree object, and use the builder to compute its
+  // statistics.
+  CosineTree ct(data);
+  builder.CTNode(ct);
 
-  const arma::mat& dataRet = ct.Data();
-  const arma::rowvec& centroidRet = ct.Centroid();
-  const arma::vec& probabilitiesRet = ct.Probabilities();
+  // The data must not have changed.
+  for (size_t i = 0; i < data.n_elem; i++)
+    BOOST_REQUIRE_EQUAL(data[i], original[i]);
 
-  // Check correctness of dimentionality of data.
-  BOOST_REQUIRE_EQUAL(data.n_cols, dataRet.n_cols);
-  BOOST_REQUIRE_EQUAL(data.n_rows, dataRet.n_rows);
-
-  // Check data.
-  for (size_t i = 0; i < data.n_cols; i++)
-    for (size_t j = 0; j < data.n_rows; j++)
-      BOOST_REQUIRE_CLOSE((double) dataRet(j, i), (double) data(i, j), 1e-5);
+  // Check correctness of dimensionality of centroid and sampling
+  // probabilities.
+  BOOST_REQUIRE_EQUAL(ct.Centroid().n_elem, data.n_rows);
+  BOOST_REQUIRE_EQUAL(ct.Probabilities().n_elem, data.n_cols);
 
-  // Check correctness of dimensionality of centroid.
-  BOOST_REQUIRE_EQUAL(data.n_rows, centroidRet.n_cols);
-  BOOST_REQUIRE_EQUAL(1, centroidRet.n_rows);
-
-  // Check correctness of dimensionality of sampling probabilities.
-  BOOST_REQUIRE_EQUAL(1, probabilitiesRet.n_cols);
-  BOOST_REQUIRE_EQUAL(data.n_rows, probabilitiesRet.n_rows);
+  BOOST_REQUIRE_CLOSE(ct.FrobNormSquared(), arma::accu(data % data), 1e-5);
 
   // Check pointers of children nodes.
   BOOST_REQUIRE(ct.Right() == NULL);
   BOOST_REQUIRE(ct.Left() == NULL);
-
 }
 
 /**
@@ -2482,7 +3140,7 @@ BOOST_AUTO_TEST_CASE(CosineTreeBuilderCTNodeTest)
  */
 BOOST_AUTO_TEST_CASE(CosineTreeBuilderCentroidTest)
 {
-  // Create dummy test data.
+  // Create dummy test data (one point per column).
   arma::mat data;
   data << 1.0 << 2.0 << 3.0 << arma::endr
        << 4.0 << 2.0 << 3.0 << arma::endr
@@ -2494,16 +3152,16 @@ BOOST_AUTO_TEST_CASE(CosineTreeBuilderCentroidTest)
 
   // Build the cosine tree.
   CosineTreeBuilder builder;
-  CosineTree ct;
-  builder.CTNode(data, ct);
+  CosineTree ct(data);
+  builder.CTNode(ct);
 
   // Get the centroid.
-  arma::rowvec centroid = ct.Centroid();
+  const arma::vec& centroid = ct.Centroid();
 
   // Check correctness of the centroid.
-  BOOST_REQUIRE_CLOSE((double) c(0, 0), (double) centroid(0, 0), 1e-5);
-  BOOST_REQUIRE_CLOSE((double) c(1, 0), (double) centroid(0, 1), 1e-5);
-  BOOST_REQUIRE_CLOSE((double) c(2, 0), (double) centroid(0, 2), 1e-5);
+  BOOST_REQUIRE_CLOSE((double) c[0], (double) centroid[0], 1e-5);
+  BOOST_REQUIRE_CLOSE((double) c[1], (double) centroid[1], 1e-5);
+  BOOST_REQUIRE_CLOSE((double) c[2], (double) centroid[2], 1e-5);
 }
 
 /**
@@ -2512,7 +3170,7 @@ BOOST_AUTO_TEST_CASE(CosineTreeBuilderCentroidTest)
  */
 BOOST_AUTO_TEST_CASE(CosineTreeBuilderProbabilitiesTest)
 {
-  // Create dummy test data.
+  // Create dummy test data (one point per column).
   arma::mat data;
   data << 100.0 <<   2.0 <<   3.0 << arma::endr
        << 400.0 <<   2.0 <<   3.0 << arma::endr
@@ -2524,41 +3182,203 @@ BOOST_AUTO_TEST_CASE(CosineTreeBuilderProbabilitiesTest)
 
   // Create the cosine tree.
   CosineTreeBuilder builder;
-  CosineTree ct;
-  builder.CTNode(data, ct);
+  CosineTree ct(data);
+  builder.CTNode(ct);
 
   // Get the probabilities.
   const arma::vec& probabilities = ct.Probabilities();
 
   // Check correctness of sampling probabilities.
-  BOOST_REQUIRE_CLOSE((double) p(0, 0), (double) probabilities(0, 0), 1e-4);
-  BOOST_REQUIRE_CLOSE((double) p(1, 0), (double) probabilities(1, 0), 1e-4);
-  BOOST_REQUIRE_CLOSE((double) p(2, 0), (double) probabilities(2, 0), 1e-4);
+  BOOST_REQUIRE_CLOSE((double) p[0], (double) probabilities[0], 1e-4);
+  BOOST_REQUIRE_CLOSE((double) p[1], (double) probabilities[1], 1e-4);
+  BOOST_REQUIRE_CLOSE((double) p[2], (double) probabilities[2], 1e-4);
 }
 
 /**
- * Make sure that the cosine tree builder is splitting nodes.
+ * Make sure that the cosine tree builder is splitting nodes into contiguous
+ * ranges of the permuted dataset, without losing points.
  */
 BOOST_AUTO_TEST_CASE(CosineTreeBuilderCTNodeSplitTest)
 {
-  // Create dummy test data.
-  arma::mat data;
-  data << 100.0 <<   2.0 <<   3.0 << arma::endr
-       << 400.0 <<   2.0 <<   3.0 << arma::endr
-       << 200.5 <<   3.0 <<   2.0 << arma::endr;
+  // Two groups of points in different directions.
+  arma::mat data(4, 40);
+  data.randu();
+  data *= 0.05;
+  data.submat(2, 0, 3, 19) += 1.0;
+  data.submat(0, 20, 1, 39) += 1.0;
+  const arma::mat original = data;
+
+  std::vector<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; i++)
+    oldFromNew[i] = i;
 
   // Build a cosine tree root node, and then split it.
   CosineTreeBuilder builder;
-  CosineTree root, left, right;
-  builder.CTNode(data, root);
-  builder.CTNodeSplit(root, left, right);
+  CosineTree root(data);
+  builder.CTNode(root);
+  builder.CTNodeSplit(root, oldFromNew);
+
+  BOOST_REQUIRE(root.Left() != NULL);
+  BOOST_REQUIRE(root.Right() != NULL);
+  const CosineTree& left = *root.Left();
+  const CosineTree& right = *root.Right();
 
-  // Ensure that there is no data loss.
+  // Ensure that there is no data loss, and that the children are the two
+  // halves of the range of the root.
   BOOST_REQUIRE_EQUAL((left.NumPoints() + right.NumPoints()), root.NumPoints());
+  BOOST_REQUIRE_EQUAL(left.Begin(), 0);
+  BOOST_REQUIRE_EQUAL(right.Begin(), left.NumPoints());
+  BOOST_REQUIRE(left.Parent() == &root);
+
+  // The two groups must be separated.
+  BOOST_REQUIRE_EQUAL(left.NumPoints(), 20);
+  for (size_t i = 1; i < left.NumPoints(); i++)
+    BOOST_REQUIRE_EQUAL(oldFromNew[i] / 20, oldFromNew[0] / 20);
+  for (size_t i = 1; i < right.NumPoints(); i++)
+    BOOST_REQUIRE_EQUAL(oldFromNew[right.Point(i)] / 20,
+        oldFromNew[right.Point(0)] / 20);
+
+  // The mapping must follow the points.
+  for (size_t i = 0; i < data.n_cols; i++)
+    for (size_t d = 0; d < data.n_rows; d++)
+      BOOST_REQUIRE_EQUAL(data(d, i), original(d, oldFromNew[i]));
+
+  // The statistics of the children must be computed on their own points.
+  BOOST_REQUIRE_EQUAL(left.Probabilities().n_elem, left.NumPoints());
+  BOOST_REQUIRE_CLOSE(left.FrobNormSquared() + right.FrobNormSquared(),
+      root.FrobNormSquared(), 1e-5);
+}
+
+//! Prefetch every node of the given tree.
+template<typename TreeType>
+void PrefetchTree(const TreeType& node)
+{
+  PrefetchNode(node);
+  if (!node.IsLeaf())
+  {
+    PrefetchTree(*node.Left());
+    PrefetchTree(*node.Right());
+  }
+}
+
+/**
+ * Prefetching the nodes of trees with each kind of bound and dataset is only a
+ * hint, so it must leave the trees and the data unchanged.
+ */
+BOOST_AUTO_TEST_CASE(PrefetchNodeTest)
+{
+  arma::mat data = arma::randu<arma::mat>(5, 500);
+  BinarySpaceTree<HRectBound<2> > kdTree(data, 10);
+  BinarySpaceTree<BallBound<> > ballTree(data, 10);
+  const arma::mat permuted = data;
+
+  PrefetchTree(kdTree);
+  PrefetchTree(ballTree);
+
+  arma::mat fixedData = arma::randu<arma::mat>(3, 500);
+  BinarySpaceTree<HRectBound<2, true, 3> > fixedTree(fixedData, 10);
+  fixedTree.Flatten();
+  PrefetchTree(fixedTree);
+
+  arma::SpMat<double> sparseData;
+  sparseData.sprandu(20, 200, 0.1);
+  BinarySpaceTree<HRectBound<2>, EmptyStatistic, arma::SpMat<double> >
+      sparseTree(sparseData, 10);
+  PrefetchTree(sparseTree);
+
+  BOOST_REQUIRE_EQUAL(kdTree.NumDescendants(), 500);
+  BOOST_REQUIRE_EQUAL(ballTree.NumDescendants(), 500);
+  BOOST_REQUIRE_EQUAL(fixedTree.NumDescendants(), 500);
+  BOOST_REQUIRE_EQUAL(sparseTree.NumDescendants(), 200);
+  for (size_t i = 0; i < data.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(data[i], permuted[i]);
+}
+
+/**
+ * Points on a plane in 10 dimensions have intrinsic dimensionality 2, and
+ * uniform points in 6 dimensions have intrinsic dimensionality 6 (which the
+ * estimator underestimates a little).
+ */
+BOOST_AUTO_TEST_CASE(IntrinsicDimensionTest)
+{
+  arma::mat basis;
+  arma::mat r;
+  arma::qr(basis, r, arma::randn<arma::mat>(10, 10));
+  const arma::mat plane = basis.cols(0, 1) * arma::randu<arma::mat>(2, 1000);
+
+  const double planeDimension = TreeTuner::IntrinsicDimension(plane);
+  BOOST_REQUIRE_GT(planeDimension, 1.5);
+  BOOST_REQUIRE_LT(planeDimension, 2.5);
+
+  const double cubeDimension = TreeTuner::IntrinsicDimension(
+      arma::randu<arma::mat>(6, 1000));
+  BOOST_REQUIRE_GT(cubeDimension, 4.0);
+  BOOST_REQUIRE_LT(cubeDimension, 7.5);
+
+  // Too few points to estimate anything.
+  BOOST_REQUIRE_EQUAL(TreeTuner::IntrinsicDimension(
+      arma::randu<arma::mat>(3, 5)), 0.0);
+}
 
-  // Ensure that the dimensionality is correct.
-  BOOST_REQUIRE_EQUAL(left.Data().n_cols, data.n_cols);
-  BOOST_REQUIRE_EQUAL(right.Data().n_cols, data.n_cols);
+/**
+ * A probe which records the configurations it is run with and the size of the
+ * samples it is given.
+ */
+struct RecordingProbe
+{
+  void operator()(arma::mat& sample, const TreeConfiguration& configuration)
+  {
+    samples.push_back(sample.n_cols);
+    configurations.push_back(configuration);
+  }
+
+  std::vector<size_t> samples;
+  std::vector<TreeConfiguration> configurations;
+};
+
+/**
+ * Make sure Tune() times each configuration twice on a sample of the requested
+ * size, tries the larger leaf sizes and cover trees only when asked to, and
+ * returns the fastest configuration.
+ */
+BOOST_AUTO_TEST_CASE(TreeTunerTest)
+{
+  // Low intrinsic dimensionality: four leaf sizes and cover trees.
+  arma::mat data = arma::randu<arma::mat>(2, 3000);
+  TreeTuner tuner(500);
+  RecordingProbe probe;
+  const TreeConfiguration best = tuner.Tune(data, probe);
+
+  BOOST_REQUIRE_LT(tuner.Dimension(), 10.0);
+  BOOST_REQUIRE_EQUAL(tuner.Configurations().size(), 5);
+  BOOST_REQUIRE_EQUAL(tuner.Times().size(), 5);
+  BOOST_REQUIRE_EQUAL(probe.configurations.size(), 10);
+  for (size_t i = 0; i < probe.samples.size(); ++i)
+    BOOST_REQUIRE_EQUAL(probe.samples[i], 500);
+  BOOST_REQUIRE(!tuner.Configurations()[0].coverTree);
+  BOOST_REQUIRE_EQUAL(tuner.Configurations()[0].leafSize, 10);
+  BOOST_REQUIRE_EQUAL(tuner.Configurations()[3].leafSize, 80);
+  BOOST_REQUIRE(tuner.Configurations()[4].coverTree);
+
+  size_t fastest = 0;
+  for (size_t i = 1; i < tuner.Times().size(); ++i)
+    if (tuner.Times()[i] < tuner.Times()[fastest])
+      fastest = i;
+  BOOST_REQUIRE_EQUAL(best.coverTree,
+      tuner.Configurations()[fastest].coverTree);
+  BOOST_REQUIRE_EQUAL(best.leafSize, tuner.Configurations()[fastest].leafSize);
+
+  // High intrinsic dimensionality, without cover trees: six leaf sizes.
+  arma::mat highData = arma::randu<arma::mat>(30, 1000);
+  tuner.CoverTrees() = false;
+  RecordingProbe highProbe;
+  tuner.Tune(highData, highProbe);
+
+  BOOST_REQUIRE_GT(tuner.Dimension(), 10.0);
+  BOOST_REQUIRE_EQUAL(tuner.Configurations().size(), 6);
+  BOOST_REQUIRE_EQUAL(tuner.Configurations()[5].leafSize, 320);
+  for (size_t i = 0; i < tuner.Configurations().size(); ++i)
+    BOOST_REQUIRE(!tuner.Configurations()[i].coverTree);
 }
 
 BOOST_AUTO_TEST_SUITE_END();
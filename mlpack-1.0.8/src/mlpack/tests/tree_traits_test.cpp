@@ -86,4 +86,41 @@ BOOST_AUTO_TEST_CASE(CoverTreeTraitsTest)
   BOOST_REQUIRE_EQUAL(b, true);
 }
 
+// Test the ball tree traits.
+BOOST_AUTO_TEST_CASE(BallTreeTraitsTest)
+{
+  typedef BinarySpaceTree<bound::BallBound<> > BallTreeType;
+
+  // ParentDistance() is not available.
+  bool b = TreeTraits<BallTreeType>::HasParentDistance;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // Children may be overlapping.
+  b = TreeTraits<BallTreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<BallTreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+}
+
+// Test the random projection tree traits.
+BOOST_AUTO_TEST_CASE(RPTreeTraitsTest)
+{
+  typedef BinarySpaceTree<bound::HRectBound<2>, EmptyStatistic, arma::mat,
+      RPSplit> RPTreeType;
+
+  // ParentDistance() is not available.
+  bool b = TreeTraits<RPTreeType>::HasParentDistance;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The splits are not along one dimension, so children may overlap.
+  b = TreeTraits<RPTreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<RPTreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
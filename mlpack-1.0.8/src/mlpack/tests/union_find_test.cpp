@@ -20,6 +20,7 @@
  * MLPACK.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <mlpack/methods/emst/union_find.hpp>
+#include <mlpack/methods/emst/concurrent_union_find.hpp>
 
 #include <mlpack/core.hpp>
 #include <boost/test/unit_test.hpp>
@@ -61,4 +62,70 @@ BOOST_AUTO_TEST_CASE(TestUnion)
   BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
 }
 
+BOOST_AUTO_TEST_CASE(TestConcurrentUnion)
+{
+  static const size_t testSize_ = 10;
+  ConcurrentUnionFind testUnionFind_(testSize_);
+
+  for (size_t i = 0; i < testSize_; i++)
+    BOOST_REQUIRE(testUnionFind_.Find(i) == i);
+
+  BOOST_REQUIRE(testUnionFind_.Union(0, 1));
+  BOOST_REQUIRE(testUnionFind_.Union(2, 3));
+  BOOST_REQUIRE(testUnionFind_.Union(0, 2));
+  BOOST_REQUIRE(testUnionFind_.Union(5, 0));
+  BOOST_REQUIRE(testUnionFind_.Union(0, 6));
+  BOOST_REQUIRE(!testUnionFind_.Union(3, 5));
+
+  BOOST_REQUIRE(testUnionFind_.Find(0) == testUnionFind_.Find(1));
+  BOOST_REQUIRE(testUnionFind_.Find(2) == testUnionFind_.Find(3));
+  BOOST_REQUIRE(testUnionFind_.Find(1) == testUnionFind_.Find(5));
+  BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
+  BOOST_REQUIRE(testUnionFind_.Find(4) == 4);
+}
+
+/**
+ * Merge random edges from several threads and make sure the components, and
+ * the number of successful unions, match the serial UnionFind.
+ */
+BOOST_AUTO_TEST_CASE(TestConcurrentVsSerial)
+{
+  static const size_t testSize_ = 5000;
+  static const size_t numEdges_ = 6000;
+  arma::Mat<size_t> edges(2, numEdges_);
+  for (size_t i = 0; i < numEdges_; i++)
+  {
+    edges(0, i) = (size_t) math::RandInt(testSize_);
+    edges(1, i) = (size_t) math::RandInt(testSize_);
+  }
+
+  UnionFind serial(testSize_);
+  size_t serialMerges = 0;
+  for (size_t i = 0; i < numEdges_; i++)
+  {
+    if (serial.Find(edges(0, i)) != serial.Find(edges(1, i)))
+    {
+      serial.Union(edges(0, i), edges(1, i));
+      ++serialMerges;
+    }
+  }
+
+  ConcurrentUnionFind concurrent(testSize_);
+  size_t merges = 0;
+  #pragma omp parallel for schedule(dynamic, 16) reduction(+:merges)
+  for (int i = 0; i < (int) numEdges_; i++)
+  {
+    if (concurrent.Union(edges(0, i), edges(1, i)))
+      ++merges;
+  }
+
+  BOOST_REQUIRE_EQUAL(merges, serialMerges);
+  for (size_t i = 0; i < testSize_; i++)
+  {
+    const size_t j = (i * 7919) % testSize_;
+    BOOST_REQUIRE_EQUAL(concurrent.Find(i) == concurrent.Find(j),
+        serial.Find(i) == serial.Find(j));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,202 @@
+#===============================================================================
+# Filename:  build_framework.sh
+#===============================================================================
+#
+# Builds an mlpack framework for iOS, in the same layout as the Boost framework
+# made by boostmake/boost.sh.  The mlpack-ios target is built with the Release
+# configuration (-O3, link-time optimization, ARMA_NO_DEBUG) for the device and
+# simulator architectures; the libraries are combined with lipo into one fat
+# static library, which is put with the mlpack headers into mlpack.framework.
+# If the installed Xcode can make XCFrameworks, mlpack.xcframework is made too.
+#
+# Run "pod install" in the parent directory first.  To configure the script,
+# define:
+#    IPHONE_SDKVERSION: iPhone SDK version (e.g. 7.1)
+#    CONFIGURATION:     Xcode configuration to build (default Release)
+#===============================================================================
+
+: ${IPHONE_SDKVERSION:=`xcodebuild -showsdks | grep iphoneos | egrep "[[:digit:]]+\.[[:digit:]]+" -o | tail -1`}
+: ${CONFIGURATION:=Release}
+: ${ARM_ARCHS:="armv7 armv7s arm64"}
+: ${SIM_ARCHS:="i386 x86_64"}
+
+: ${ROOTDIR:=`cd \`dirname $0\`/..; pwd`}
+: ${BUILDDIR:=$ROOTDIR/mlpack-ios/build}
+: ${FRAMEWORKDIR:=$ROOTDIR/mlpack-ios/framework}
+: ${MLPACK_SRC:=$ROOTDIR/mlpack-1.0.8/src/mlpack}
+
+: ${MLPACK_VERSION:=1.0.8}
+
+#===============================================================================
+ARM_DEV_CMD="xcrun --sdk iphoneos"
+
+FRAMEWORK_NAME=mlpack
+FRAMEWORK_VERSION=A
+LIBRARY=libmlpack-ios.a
+
+#===============================================================================
+
+
+#===============================================================================
+# Functions
+#===============================================================================
+
+abort()
+{
+    echo
+    echo "Aborted: $@"
+    exit 1
+}
+
+doneSection()
+{
+    echo
+    echo "================================================================="
+    echo "Done"
+    echo
+}
+
+#===============================================================================
+
+cleanEverythingReadyToStart()
+{
+    echo Cleaning everything before we start to build...
+
+    rm -rf $BUILDDIR
+    rm -rf $FRAMEWORKDIR/$FRAMEWORK_NAME.framework
+    rm -rf $FRAMEWORKDIR/$FRAMEWORK_NAME.xcframework
+
+    doneSection
+}
+
+#===============================================================================
+
+# Build the library for one platform: buildLibrary <platform> <archs>.  The
+# library is put in $BUILDDIR/<platform>.
+buildLibrary()
+{
+    : ${1:?}
+    echo Building the mlpack-ios library for $1 \($2\)...
+
+    xcodebuild -workspace $ROOTDIR/mlpack-ios.xcworkspace \
+        -scheme mlpack-ios \
+        -configuration $CONFIGURATION \
+        -sdk $1$IPHONE_SDKVERSION \
+        ARCHS="$2" \
+        ONLY_ACTIVE_ARCH=NO \
+        CONFIGURATION_BUILD_DIR=$BUILDDIR/$1 \
+        build || abort "Building for $1 failed"
+
+    doneSection
+}
+
+#===============================================================================
+
+buildFramework()
+{
+    FRAMEWORK_BUNDLE=$FRAMEWORKDIR/$FRAMEWORK_NAME.framework
+    echo "Framework: Building $FRAMEWORK_BUNDLE from $BUILDDIR..."
+
+    rm -rf $FRAMEWORK_BUNDLE
+
+    echo "Framework: Setting up directories..."
+    mkdir -p $FRAMEWORK_BUNDLE
+    mkdir -p $FRAMEWORK_BUNDLE/Versions
+    mkdir -p $FRAMEWORK_BUNDLE/Versions/$FRAMEWORK_VERSION
+    mkdir -p $FRAMEWORK_BUNDLE/Versions/$FRAMEWORK_VERSION/Resources
+    mkdir -p $FRAMEWORK_BUNDLE/Versions/$FRAMEWORK_VERSION/Headers
+
+    echo "Framework: Creating symlinks..."
+    ln -s $FRAMEWORK_VERSION               $FRAMEWORK_BUNDLE/Versions/Current
+    ln -s Versions/Current/Headers         $FRAMEWORK_BUNDLE/Headers
+    ln -s Versions/Current/Resources       $FRAMEWORK_BUNDLE/Resources
+    ln -s Versions/Current/$FRAMEWORK_NAME $FRAMEWORK_BUNDLE/$FRAMEWORK_NAME
+
+    FRAMEWORK_INSTALL_NAME=$FRAMEWORK_BUNDLE/Versions/$FRAMEWORK_VERSION/$FRAMEWORK_NAME
+
+    echo "Lipoing library into $FRAMEWORK_INSTALL_NAME..."
+    $ARM_DEV_CMD lipo -create $BUILDDIR/iphoneos/$LIBRARY \
+        $BUILDDIR/iphonesimulator/$LIBRARY \
+        -o "$FRAMEWORK_INSTALL_NAME" || abort "Lipo failed"
+
+    echo "Framework: Copying includes..."
+    (cd $MLPACK_SRC; find . -name "*.hpp" | \
+        cpio -pdm $FRAMEWORK_BUNDLE/Headers 2> /dev/null) || \
+        abort "Copying the headers failed"
+
+    echo "Framework: Creating plist..."
+    cat > $FRAMEWORK_BUNDLE/Resources/Info.plist <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE plist PUBLIC "-//Apple//DTD PLIST 1.0//EN" "http://www.apple.com/DTDs/PropertyList-1.0.dtd">
+<plist version="1.0">
+<dict>
+<key>CFBundleDevelopmentRegion</key>
+<string>English</string>
+<key>CFBundleExecutable</key>
+<string>${FRAMEWORK_NAME}</string>
+<key>CFBundleIdentifier</key>
+<string>org.mlpack</string>
+<key>CFBundleInfoDictionaryVersion</key>
+<string>6.0</string>
+<key>CFBundlePackageType</key>
+<string>FMWK</string>
+<key>CFBundleSignature</key>
+<string>????</string>
+<key>CFBundleVersion</key>
+<string>${MLPACK_VERSION}</string>
+</dict>
+</plist>
+EOF
+
+    doneSection
+}
+
+#===============================================================================
+
+# XCFrameworks keep the device and simulator libraries apart, which newer
+# versions of Xcode require once the simulator has arm64 too.
+buildXCFramework()
+{
+    if ! xcodebuild -help 2>&1 | grep -q create-xcframework; then
+        echo "This Xcode cannot make XCFrameworks; skipping $FRAMEWORK_NAME.xcframework."
+        return
+    fi
+
+    echo "Building $FRAMEWORKDIR/$FRAMEWORK_NAME.xcframework..."
+    xcodebuild -create-xcframework \
+        -library $BUILDDIR/iphoneos/$LIBRARY \
+        -headers $FRAMEWORKDIR/$FRAMEWORK_NAME.framework/Headers \
+        -library $BUILDDIR/iphonesimulator/$LIBRARY \
+        -headers $FRAMEWORKDIR/$FRAMEWORK_NAME.framework/Headers \
+        -output $FRAMEWORKDIR/$FRAMEWORK_NAME.xcframework || \
+        abort "Building the XCFramework failed"
+
+    doneSection
+}
+
+#===============================================================================
+# Execution starts here
+#===============================================================================
+
+cleanEverythingReadyToStart
+mkdir -p $BUILDDIR
+mkdir -p $FRAMEWORKDIR
+
+echo "MLPACK_VERSION:    $MLPACK_VERSION"
+echo "MLPACK_SRC:        $MLPACK_SRC"
+echo "CONFIGURATION:     $CONFIGURATION"
+echo "BUILDDIR:          $BUILDDIR"
+echo "FRAMEWORKDIR:      $FRAMEWORKDIR"
+echo "IPHONE_SDKVERSION: $IPHONE_SDKVERSION"
+echo "ARM_ARCHS:         $ARM_ARCHS"
+echo "SIM_ARCHS:         $SIM_ARCHS"
+echo
+
+buildLibrary iphoneos "$ARM_ARCHS"
+buildLibrary iphonesimulator "$SIM_ARCHS"
+buildFramework
+buildXCFramework
+
+echo "Completed successfully"
+
+#===============================================================================